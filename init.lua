@@ -9,6 +9,7 @@ g_logger.info(os.date("== application started at %b %d %Y %X"))
 g_logger.info(g_app.getName() .. ' ' .. g_app.getVersion() .. ' rev ' .. g_app.getBuildRevision() .. ' (' .. g_app.getBuildCommit() .. ') built on ' .. g_app.getBuildDate() .. ' for arch ' .. g_app.getBuildArch())
 
 -- add data directory to the search path
+g_app.beginStartupPhase('search paths')
 if not g_resources.addSearchPath(g_resources.getWorkDir() .. "data", true) then
   g_logger.fatal("Unable to add data directory to the search path.")
 end
@@ -27,25 +28,50 @@ g_resources.setupUserWriteDir(('%s/'):format(g_app.getCompactName()))
 -- search all packages
 g_resources.searchAndAddPackages('/', '.otpkg', true)
 
+-- compile scripts and styles into the write dir caches and quit, meant for installers and packaging scripts
+local prebuildLua = g_app.getStartupOptions():find('-prebuild-lua-cache', 1, true)
+local prebuildUi = g_app.getStartupOptions():find('-prebuild-ui-cache', 1, true)
+if prebuildLua or prebuildUi then
+  if prebuildLua then
+    g_logger.info(('Precompiled %d scripts into the bytecode cache'):format(g_lua.prebuildBytecodeCache('/')))
+  end
+  if prebuildUi then
+    g_logger.info(('Precompiled %d style files'):format(g_ui.precompileStyles('/')))
+  end
+  g_app.exit()
+  return
+end
+
 -- load settings
+g_app.beginStartupPhase('settings')
 g_configs.loadSettings("/config.otml")
 
+g_app.beginStartupPhase('discover modules')
 g_modules.discoverModules()
 
+-- parse styles and decode font textures on the thread pool while the first modules load
+g_app.beginStartupPhase('prefetch')
+g_fonts.prefetchFonts('/fonts')
+g_ui.prefetchStyles('/')
+
 -- libraries modules 0-99
+g_app.beginStartupPhase('library modules')
 g_modules.autoLoadModules(99)
 g_modules.ensureModuleLoaded("corelib")
 g_modules.ensureModuleLoaded("gamelib")
 
 -- client modules 100-499
+g_app.beginStartupPhase('client modules')
 g_modules.autoLoadModules(499)
 g_modules.ensureModuleLoaded("client")
 
 -- game modules 500-999
+g_app.beginStartupPhase('game modules')
 g_modules.autoLoadModules(999)
 g_modules.ensureModuleLoaded("game_interface")
 
 -- mods 1000-9999
+g_app.beginStartupPhase('mods')
 g_modules.autoLoadModules(9999)
 
 local script = '/' .. g_app.getCompactName() .. 'rc.lua'
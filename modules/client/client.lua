@@ -1,7 +1,12 @@
 local musicFilename = "/sounds/startup"
+-- built with g_sounds.buildSoundBank('/sounds', soundBankFilename, false)
+local soundBankFilename = "/sounds.otsb"
 local musicChannel = nil
 if g_sounds then
   musicChannel = g_sounds.getChannel(SoundChannels.Music)
+  if g_resources.fileExists(soundBankFilename) then
+    g_sounds.loadSoundBank(soundBankFilename)
+  end
 end
 
 function setMusic(filename)
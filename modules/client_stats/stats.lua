@@ -4,8 +4,12 @@ PORT = 80
 FIRST_REPORT_DELAY = 15
 REPORT_DELAY = 60
 
+PROFILER_REFRESH_DELAY = 1000
+
 sendReportEvent = nil
 firstReportEvent = nil
+profilerOverlay = nil
+profilerEvent = nil
 
 function initUUID()
     UUID = g_settings.getString('report-uuid')
@@ -19,12 +23,17 @@ function init()
     connect(g_game, {onGameStart = onGameStart, onGameEnd = onGameEnd})
 
     initUUID()
+
+    g_keyboard.bindKeyDown('Ctrl+Alt+P', toggleProfilerOverlay)
 end
 
 function terminate()
     disconnect(g_game, {onGameStart = onGameStart, onGameEnd = onGameEnd})
     removeEvent(firstReportEvent)
     removeEvent(sendReportEvent)
+
+    g_keyboard.unbindKeyDown('Ctrl+Alt+P')
+    hideProfilerOverlay()
 end
 
 function configure(host, port, delay)
@@ -92,6 +101,7 @@ function onConnect(protocol)
     post = post .. '&cpu=' .. urlencode(g_platform.getCPUName())
     post = post .. '&mem=' .. g_platform.getTotalSystemMemory()
     post = post .. '&os_name=' .. urlencode(g_platform.getOSName())
+    post = post .. getOpcodeStatsData()
     post = post .. getAdditionalData()
 
     local message = ''
@@ -109,6 +119,131 @@ end
 
 function getAdditionalData() return '' end
 
+function getOpcodeStatsData()
+    if not g_opcodeProfiler.isEnabled() then return '' end
+    local data = ''
+    for _, stats in ipairs(g_opcodeProfiler.getStats()) do
+        data = data .. string.format('%d:%d:%d:%d:%d;', stats.opcode, stats.count,
+                                     stats.bytes, stats.totalMicros, stats.p99)
+    end
+    return '&opcode_stats=' .. urlencode(data)
+end
+
+function getProfilerSummaryText()
+    local frame = g_frameProfiler.getFrameStats()
+    local text = string.format('frame avg %.2f ms, max %.2f ms (%d frames)',
+                               frame.avgMicros / 1000, frame.maxMicros / 1000,
+                               frame.frames)
+    text = text .. string.format('\nlua gc %.2f ms, heap %.1f MB, %d cycles',
+                                 g_lua.getGcMicros() / 1000,
+                                 g_lua.getHeapSize() / (1024 * 1024),
+                                 g_lua.getGcCycles())
+    local layout = g_ui.getLayoutStatistics()
+    text = text .. string.format('\nlayout %d passes, %d widgets updated, %d skipped',
+                                 layout.passes, layout.updatedWidgets,
+                                 layout.skippedWidgets)
+    local pool = g_ui.getWidgetPoolStatistics()
+    if pool.hits + pool.misses > 0 then
+        text = text .. string.format('\nwidget pool %d hits, %d misses, %d pooled, %d rejected',
+                                     pool.hits, pool.misses, pool.pooled, pool.rejected)
+    end
+    local textures = g_thingTextureCache.getStatistics()
+    if textures.hits + textures.misses > 0 then
+        text = text .. string.format('\nthing textures %d cached, %d composed, %d entries',
+                                     textures.hits, textures.misses, textures.entries)
+    end
+    if g_game.isOnline() then
+        local net = g_game.getNetworkStats()
+        text = text .. string.format('\nping %d ms, p50 %d p95 %d p99 %d, jitter %.1f ms',
+                                     net.ping, net.pingP50, net.pingP95,
+                                     net.pingP99, net.jitter)
+        text = text .. string.format('\nrecv gap p50 %.1f ms, p99 %.1f ms, max %.1f ms',
+                                     (net.arrivalP50 or 0) / 1000,
+                                     (net.arrivalP99 or 0) / 1000,
+                                     (net.arrivalMaxMicros or 0) / 1000)
+        text = text .. string.format('\nin %.1f KB/s, out %.1f KB/s, queued %d B',
+                                     (net.readRate or 0) / 1024,
+                                     (net.writeRate or 0) / 1024,
+                                     net.queuedBytes or 0)
+    end
+
+    local actions = g_actionTracer.getSummary()
+    for _, name in ipairs({'walk', 'turn', 'use'}) do
+        local action = actions[name]
+        if action then
+            text = text .. string.format('\n%-5s input %5.1f ms, confirm %5.1f ms, shown %5.1f ms (p95)',
+                                         name, (action.inputToSendP95 or 0) / 1000,
+                                         (action.sendToConfirmP95 or 0) / 1000,
+                                         (action.inputToShownP95 or 0) / 1000)
+        end
+    end
+
+    local names = {}
+    local summary = g_frameProfiler.getSummary()
+    for name in pairs(summary) do table.insert(names, name) end
+    table.sort(names, function(a, b)
+        return summary[a].avgMicros > summary[b].avgMicros
+    end)
+
+    for _, name in ipairs(names) do
+        local scope = summary[name]
+        text = text .. string.format('\n%-18s %6.2f ms %6.2f ms %5.1f%% %6.1f', name,
+                                     scope.avgMicros / 1000,
+                                     scope.maxMicros / 1000, scope.percent,
+                                     scope.calls)
+    end
+    return text
+end
+
+function updateProfilerOverlay()
+    if not profilerOverlay then return end
+    profilerOverlay:setText(getProfilerSummaryText())
+end
+
+function showProfilerOverlay()
+    if profilerOverlay then return end
+    if not g_frameProfiler.isAvailable() then
+        pwarning('Frame profiler scopes were not compiled, rebuild with FRAME_PROFILER')
+    end
+
+    g_frameProfiler.reset()
+    g_frameProfiler.setEnabled(true)
+    g_actionTracer.reset()
+    g_actionTracer.setEnabled(true)
+
+    profilerOverlay = g_ui.createWidget('Label', rootWidget)
+    profilerOverlay:setFont('terminus-10px')
+    profilerOverlay:setPhantom(true)
+    profilerOverlay:setTextAutoResize(true)
+    profilerOverlay:setBackgroundColor('#00000099')
+    profilerOverlay:addAnchor(AnchorTop, 'parent', AnchorTop)
+    profilerOverlay:addAnchor(AnchorLeft, 'parent', AnchorLeft)
+    profilerOverlay:setMarginTop(40)
+    profilerOverlay:setMarginLeft(10)
+    updateProfilerOverlay()
+
+    profilerEvent = cycleEvent(updateProfilerOverlay, PROFILER_REFRESH_DELAY)
+end
+
+function hideProfilerOverlay()
+    removeEvent(profilerEvent)
+    profilerEvent = nil
+    if profilerOverlay then
+        profilerOverlay:destroy()
+        profilerOverlay = nil
+        g_frameProfiler.setEnabled(false)
+        g_actionTracer.setEnabled(false)
+    end
+end
+
+function toggleProfilerOverlay()
+    if profilerOverlay then
+        hideProfilerOverlay()
+    else
+        showProfilerOverlay()
+    end
+end
+
 function onRecv(protocol, message)
     if string.find(message, 'HTTP/1.1 200 OK') then
         -- pinfo('Stats sent to server successfully!')
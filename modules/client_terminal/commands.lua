@@ -71,6 +71,14 @@ function live_module_reload(name)
     end, 1000)
 end
 
+-- reloads every module whose files changed, together with the modules depending on it
+local liveModulesReload = false
+function live_modules_reload(interval)
+    liveModulesReload = not liveModulesReload
+    g_modules.setAutoReloadInterval(liveModulesReload and (tonumber(interval) or 1000) or 0)
+    pcolored('Live modules reload ' .. (liveModulesReload and 'enabled' or 'disabled'), 'green')
+end
+
 function live_sprites_reload()
     local files = {}
     for _, file in pairs(g_resources.listDirectoryFiles('/things')) do
@@ -174,3 +182,96 @@ function about_modules()
         end
     end
 end
+
+function bench_lua_calls(iterations)
+    iterations = iterations or 100000
+    local widget = g_ui.createWidget('UIWidget')
+    local fieldWidget = g_ui.createWidget('UIWidget')
+    fieldWidget.customField = true
+
+    local function measure(name, f)
+        local start = os.clock()
+        for i = 1, iterations do f() end
+        local elapsed = os.clock() - start
+        pcolored(string.format('%-24s %8.3f ms  %6.3f us/call', name,
+                               elapsed * 1000, elapsed * 1000000 / iterations))
+    end
+
+    local function plain() end
+    measure('lua function', plain)
+    measure('method, no fields', function() widget:getId() end)
+    measure('method, with fields', function() fieldWidget:getId() end)
+    measure('field read', function() return fieldWidget.customField end)
+    measure('missing field read', function() return widget.missingField end)
+
+    widget:destroy()
+    fieldWidget:destroy()
+end
+
+function bench_format(iterations)
+    iterations = iterations or 100000
+    local sprintfMicros, fmtMicros = benchmarkFormat(iterations)
+    pcolored(string.format('%-24s %8.3f ms', 'stdext::format', sprintfMicros / 1000))
+    pcolored(string.format('%-24s %8.3f ms  %.2fx', 'stdext::fmt', fmtMicros / 1000, sprintfMicros / math.max(fmtMicros, 1)))
+end
+
+function bench_storage(iterations)
+    iterations = iterations or 100000
+    local anyMicros, smallMicros = benchmarkStorage(iterations)
+    pcolored(string.format('%-24s %8.3f ms', 'stdext::any', anyMicros / 1000))
+    pcolored(string.format('%-24s %8.3f ms  %.2fx', 'stdext::small_any', smallMicros / 1000, anyMicros / math.max(smallMicros, 1)))
+end
+
+function bench_base64(size)
+    local encodeSpeed, decodeSpeed = g_crypt.benchmarkBase64(size or 65536)
+    pcolored(string.format('%-24s %8.1f MB/s', 'base64 encode', encodeSpeed))
+    pcolored(string.format('%-24s %8.1f MB/s', 'base64 decode', decodeSpeed))
+end
+
+function bench_rsa(iterations)
+    iterations = iterations or 1000
+    local libraryMicros, cachedMicros = g_crypt.benchmarkRsa(iterations)
+    pcolored(string.format('%-24s %8.2f us', 'RSA library call', libraryMicros / iterations))
+    pcolored(string.format('%-24s %8.2f us  %.2fx', 'RSA cached context', cachedMicros / iterations, libraryMicros / math.max(cachedMicros, 1)))
+end
+
+-- toggles the lua sampling profiler, stopping it prints the heaviest modules and
+-- writes the collapsed stacks to fileName for flamegraph.pl or speedscope
+local profilerEnabledFrameProfiler = false
+function lua_profile(intervalMicros, fileName)
+    if not g_lua.isProfiling() then
+        -- samples are prefixed by the open frame profiler scopes when it is recording
+        profilerEnabledFrameProfiler = g_frameProfiler.isAvailable() and not g_frameProfiler.isEnabled()
+        if profilerEnabledFrameProfiler then
+            g_frameProfiler.setEnabled(true)
+        end
+        g_lua.resetProfiler()
+        g_lua.startProfiler(tonumber(intervalMicros) or 1000)
+        pcolored('Lua profiler started, run lua_profile() again to stop it', 'green')
+        return
+    end
+
+    g_lua.stopProfiler()
+    if profilerEnabledFrameProfiler then
+        g_frameProfiler.setEnabled(false)
+        profilerEnabledFrameProfiler = false
+    end
+
+    local modules = {}
+    for name, percent in pairs(g_lua.getProfilerModules()) do
+        table.insert(modules, { name = name, percent = percent })
+    end
+    table.sort(modules, function(a, b) return a.percent > b.percent end)
+
+    pcolored(string.format('Profiled %.1f ms of lua', g_lua.getProfiledMicros() / 1000))
+    for i = 1, math.min(#modules, 10) do
+        pcolored(string.format('%-32s %6.2f%%', modules[i].name, modules[i].percent))
+    end
+
+    fileName = fileName or '/lua_profile.folded'
+    if g_lua.exportProfile(fileName) then
+        pcolored('Collapsed stacks written to ' .. fileName, 'green')
+    else
+        pcolored('ERROR: unable to write ' .. fileName, 'red')
+    end
+end
@@ -0,0 +1,78 @@
+-- @docfuncs @{
+
+-- coroutines suspended in await, the callbacks given to C++ are only weak references
+-- so they are anchored here until they report back
+local suspended = {}
+
+local function resume(co, ...)
+    local ok, err = coroutine.resume(co, ...)
+    if not ok then
+        perror(debug.traceback(co, err))
+    end
+end
+
+-- runs fn as a coroutine, inside it await() suspends until an asynchronous call reports back
+function async(fn, ...)
+    local co = coroutine.create(fn)
+    resume(co, ...)
+    return co
+end
+
+-- calls starter with its arguments and a callback, then returns what that callback receives;
+-- the coroutine is resumed from the dispatcher, never from inside the call that completed it
+-- usage: local path, result = await(g_map.findPathAsync, fromPos, toPos, 10000, 0)
+function await(starter, ...)
+    local co = coroutine.running()
+    if not co then
+        error('await must be called from inside async')
+    end
+
+    local callback = function(...)
+        local results = {...}
+        local count = select('#', ...)
+        addEvent(function()
+            suspended[co] = nil
+            resume(co, unpack(results, 1, count))
+        end)
+    end
+    suspended[co] = callback
+
+    local args = {...}
+    local count = select('#', ...)
+    args[count + 1] = callback
+    starter(unpack(args, 1, count + 1))
+    return coroutine.yield()
+end
+
+-- waits for the next time object fires signal and returns its arguments
+-- usage: g_map.loadOtbmAsync(file) local success = awaitSignal(g_map, 'onLoadFinish')
+function awaitSignal(object, signal)
+    return await(function(callback)
+        local slot
+        slot = function(...)
+            if not slot then return end
+            -- the signal may still be walking its slots, they are only changed once it is done
+            local connected = slot
+            addEvent(function() disconnect(object, signal, connected) end)
+            slot = nil
+            callback(...)
+        end
+        connect(object, signal, slot)
+    end)
+end
+
+-- suspends the calling coroutine for delay milliseconds
+function sleep(delay)
+    return await(function(callback) scheduleEvent(callback, delay) end)
+end
+
+-- returns the contents of a file read on the async pool, or nil and the error message
+function readFileAsync(fileName)
+    local contents, err = await(g_resources.readFileContentsAsync, fileName)
+    if err ~= '' then
+        return nil, err
+    end
+    return contents
+end
+
+-- @}
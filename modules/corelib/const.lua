@@ -314,3 +314,5 @@ NetworkMessageTypes = {
 }
 
 SoundChannels = {Music = 1, Ambient = 2, Effect = 3}
+
+FramePacing = {Default = 0, LowLatency = 1, PowerSave = 2, VariableRefresh = 3}
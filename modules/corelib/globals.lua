@@ -3,6 +3,16 @@
 rootWidget = g_ui.getRootWidget()
 modules = package.loaded
 
+-- lazy modules are loaded the first time another module reaches for them
+setmetatable(package.loaded, {
+    __index = function(loaded, name)
+        local module = g_modules.getModule(name)
+        if module and module:isLazy() and not module:isLoaded() and module:load() then
+            return rawget(loaded, name)
+        end
+    end
+})
+
 -- G is used as a global table to save variables in memory between reloads
 G = G or {}
 
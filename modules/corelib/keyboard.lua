@@ -186,6 +186,14 @@ function g_keyboard.unbindKeyPress(keyComboDesc, arg1, arg2)
     disconnect(widget.boundKeyPressCombos, keyComboDesc, callback)
 end
 
+-- runs the callbacks bound to a key combo as if it had been pressed
+function g_keyboard.triggerKeyDown(keyComboDesc, widget)
+    widget = widget or rootWidget
+    if widget.boundKeyDownCombos == nil then return false end
+    local keyComboDesc = retranslateKeyComboDesc(keyComboDesc)
+    return signalcall(widget.boundKeyDownCombos[keyComboDesc], widget)
+end
+
 function g_keyboard.getModifiers() return g_window.getKeyboardModifiers() end
 
 function g_keyboard.isKeyPressed(key)
@@ -271,6 +271,12 @@ end
 function UITable:sort()
     if self.sortColumn <= 0 then return end
 
+    -- tables filled from an outside source sort that source and refill themselves
+    if self.onSort then
+        signalcall(self.onSort, self, self.sortColumn, self.sortType)
+        return
+    end
+
     if self.sortType == TABLE_SORTING_ASC then
         table.sort(self.rows, function(rowA, b)
             return rowA:getChildByIndex(self.sortColumn).sortvalue <
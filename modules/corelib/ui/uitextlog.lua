@@ -0,0 +1,45 @@
+-- @docclass
+UITextLog = extends(UIWidget, "UITextLog")
+
+-- public functions
+function UITextLog.create()
+    local log = UITextLog.internalCreate()
+    return log
+end
+
+function UITextLog:onStyleApply(styleName, styleNode)
+    for name, value in pairs(styleNode) do
+        if name == 'vertical-scrollbar' then
+            addEvent(function()
+                local parent = self:getParent()
+                if parent then
+                    self:setVerticalScrollBar(parent:getChildById(value))
+                end
+            end)
+        end
+    end
+end
+
+-- the log scrolls up from its newest line, the scrollbar goes down from the oldest one
+function UITextLog:setVerticalScrollBar(scrollbar)
+    self.verticalScrollBar = scrollbar
+    if not scrollbar then return end
+    connect(scrollbar, 'onValueChange', function(scrollbar, value)
+        self:setScrollOffset(self:getMaxScrollOffset() - value)
+    end)
+    self:updateScrollBar()
+end
+
+function UITextLog:updateScrollBar()
+    local scrollbar = self.verticalScrollBar
+    if scrollbar then
+        local maxOffset = self:getMaxScrollOffset()
+        scrollbar:setMinimum(0)
+        scrollbar:setMaximum(maxOffset)
+        scrollbar:setValue(maxOffset - self:getScrollOffset())
+    end
+end
+
+function UITextLog:onScrollChange(offset, maxOffset)
+    self:updateScrollBar()
+end
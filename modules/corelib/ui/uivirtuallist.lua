@@ -0,0 +1,43 @@
+-- @docclass
+UIVirtualList = extends(UIWidget, "UIVirtualList")
+
+-- public functions
+function UIVirtualList.create()
+    local list = UIVirtualList.internalCreate()
+    return list
+end
+
+function UIVirtualList:onStyleApply(styleName, styleNode)
+    for name, value in pairs(styleNode) do
+        if name == 'vertical-scrollbar' then
+            addEvent(function()
+                local parent = self:getParent()
+                if parent then
+                    self:setVerticalScrollBar(parent:getChildById(value))
+                end
+            end)
+        end
+    end
+end
+
+function UIVirtualList:setVerticalScrollBar(scrollbar)
+    self.verticalScrollBar = scrollbar
+    if not scrollbar then return end
+    connect(scrollbar, 'onValueChange', function(scrollbar, value)
+        self:setScrollOffset(value)
+    end)
+    self:updateScrollBar()
+end
+
+function UIVirtualList:updateScrollBar()
+    local scrollbar = self.verticalScrollBar
+    if scrollbar then
+        scrollbar:setMinimum(0)
+        scrollbar:setMaximum(self:getMaxScrollOffset())
+        scrollbar:setValue(self:getScrollOffset())
+    end
+end
+
+function UIVirtualList:onScrollChange(offset, maxOffset)
+    self:updateScrollBar()
+end
@@ -98,6 +98,17 @@ function disconnect(object, arg1, arg2)
     end
 end
 
+-- batched connect, each slot gets one array per frame holding the arguments of every event
+function connectBatch(signalsAndSlots)
+    for signal in pairs(signalsAndSlots) do g_eventBatch.subscribe(signal) end
+    connect(g_eventBatch, signalsAndSlots)
+end
+
+function disconnectBatch(signalsAndSlots)
+    disconnect(g_eventBatch, signalsAndSlots)
+    for signal in pairs(signalsAndSlots) do g_eventBatch.unsubscribe(signal) end
+end
+
 function newclass(name)
     if not name then perror(debug.traceback('new class has no name.')) end
 
@@ -109,6 +109,9 @@ function init()
     onChannelEvent = onChannelEvent,
   })
 
+  -- a label is created and one destroyed for every message once the buffer is full
+  g_ui.setWidgetRecycling('ConsoleLabel', MAX_LINES)
+
   consolePanel = g_ui.loadUI('console', modules.game_interface.getBottomPanel())
   consoleTextEdit = consolePanel:getChildById('consoleTextEdit')
   consoleContentPanel = consolePanel:getChildById('consoleContentPanel')
@@ -290,6 +293,7 @@ function terminate()
 
   consolePanel:destroy()
   consolePanel = nil
+  g_ui.setWidgetRecycling('ConsoleLabel', 0)
   ownPrivateName = nil
 
   Console = nil
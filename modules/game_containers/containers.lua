@@ -5,7 +5,8 @@ function init()
         onOpen = onContainerOpen,
         onClose = onContainerClose,
         onSizeChange = onContainerChangeSize,
-        onUpdateItem = onContainerUpdateItem
+        onUpdateItem = onContainerUpdateItem,
+        onContainerDelta = onContainerDelta
     })
     connect(Game, {onGameEnd = clean()})
 
@@ -17,7 +18,8 @@ function terminate()
         onOpen = onContainerOpen,
         onClose = onContainerClose,
         onSizeChange = onContainerChangeSize,
-        onUpdateItem = onContainerUpdateItem
+        onUpdateItem = onContainerUpdateItem,
+        onContainerDelta = onContainerDelta
     })
     disconnect(Game, {onGameEnd = clean()})
 end
@@ -111,6 +113,7 @@ function onContainerOpen(container, previousContainer)
     else
         containerWindow = g_ui.createWidget('ContainerWindow')
     end
+    container:setDeltaMode(true)
     containerWindow:setId('container' .. container:getId())
     local containerPanel = containerWindow:getChildById('contentsPanel')
     local containerItemWidget = containerWindow:getChildById(
@@ -189,3 +192,29 @@ function onContainerUpdateItem(container, slot, item, oldItem)
     local itemWidget = container.itemsPanel:getChildById('item' .. slot)
     itemWidget:setItem(item)
 end
+
+function onContainerDelta(container, deltas, size)
+    if not container.window then return end
+
+    -- slots before the first insert or remove keep their items in place,
+    -- everything from there on may have shifted
+    local firstShifted
+    for _, delta in ipairs(deltas) do
+        local type, slot = delta[1], delta[2]
+        if type == ContainerDeltaUpdate then
+            local itemWidget = container.itemsPanel:getChildById('item' .. slot)
+            if itemWidget then itemWidget:setItem(container:getItem(slot)) end
+        elseif slot >= 0 and (not firstShifted or slot < firstShifted) then
+            firstShifted = slot
+        end
+    end
+
+    if firstShifted then
+        for slot = firstShifted, container:getCapacity() - 1 do
+            local itemWidget = container.itemsPanel:getChildById('item' .. slot)
+            if itemWidget then itemWidget:setItem(container:getItem(slot)) end
+        end
+    end
+
+    if container:hasPages() then refreshContainerPages(container) end
+end
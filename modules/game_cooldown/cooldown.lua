@@ -1,4 +1,3 @@
-local ProgressCallback = {update = 1, finish = 2}
 
 cooldownWindow = nil
 cooldownButton = nil
@@ -108,7 +107,7 @@ end
 function refresh() cooldownPanel:destroyChildren() end
 
 function removeCooldown(progressRect)
-    removeEvent(progressRect.event)
+    progressRect.onProgressFinish = nil
     if progressRect.icon then
         progressRect.icon:destroy()
         progressRect.icon = nil
@@ -117,7 +116,7 @@ function removeCooldown(progressRect)
 end
 
 function turnOffCooldown(progressRect)
-    removeEvent(progressRect.event)
+    progressRect.onProgressFinish = nil
     if progressRect.icon then
         progressRect.icon:setOn(false)
         progressRect.icon = nil
@@ -131,28 +130,10 @@ function turnOffCooldown(progressRect)
     progressRect = nil
 end
 
-function initCooldown(progressRect, updateCallback, finishCallback)
-    progressRect:setPercent(0)
-
-    progressRect.callback = {}
-    progressRect.callback[ProgressCallback.update] = updateCallback
-    progressRect.callback[ProgressCallback.finish] = finishCallback
-
-    updateCallback()
-end
-
-function updateCooldown(progressRect, duration)
-    progressRect:setPercent(progressRect:getPercent() + 10000 / duration)
-
-    if progressRect:getPercent() < 100 then
-        removeEvent(progressRect.event)
-
-        progressRect.event = scheduleEvent(function()
-            progressRect.callback[ProgressCallback.update]()
-        end, 100)
-    else
-        progressRect.callback[ProgressCallback.finish]()
-    end
+-- the widget sweeps itself from the clock, lua only hears back once it is full
+function initCooldown(progressRect, duration, finishCallback)
+    progressRect.onProgressFinish = function() finishCallback() end
+    progressRect:setTimedProgress(g_clock.millis(), duration)
 end
 
 function isGroupCooldownIconActive(groupId) return groupCooldown[groupId] end
@@ -175,12 +156,11 @@ function onSpellCooldown(iconId, duration)
     end
     progressRect:setTooltip(spellName)
 
-    local updateFunc = function() updateCooldown(progressRect, duration) end
     local finishFunc = function()
         removeCooldown(progressRect)
         cooldown[iconId] = false
     end
-    initCooldown(progressRect, updateFunc, finishFunc)
+    initCooldown(progressRect, duration, finishFunc)
     cooldown[iconId] = true
 end
 
@@ -197,15 +177,11 @@ function onSpellGroupCooldown(groupId, duration)
 
     progressRect.icon = icon
     if progressRect then
-        removeEvent(progressRect.event)
-        local updateFunc = function()
-            updateCooldown(progressRect, duration)
-        end
         local finishFunc = function()
             turnOffCooldown(progressRect)
             groupCooldown[groupId] = false
         end
-        initCooldown(progressRect, updateFunc, finishFunc)
+        initCooldown(progressRect, duration, finishFunc)
         groupCooldown[groupId] = true
     end
 end
@@ -70,6 +70,7 @@ sellMyOfferTable = nil
 
 offerExhaust = {}
 marketOffers = {}
+offerStores = {}
 marketItems = {}
 information = {}
 currentItems = {}
@@ -79,6 +80,15 @@ averagePrice = 0
 
 loaded = false
 
+-- rows added to an item offer table at once, the next page follows when it is scrolled near its end
+local OFFER_PAGE_SIZE = 50
+
+-- store order behind each column of the item offer tables
+local offerSortColumns = {
+    MarketOfferSort.Player, MarketOfferSort.Amount, MarketOfferSort.TotalPrice,
+    MarketOfferSort.Price, MarketOfferSort.Timestamp
+}
+
 local function isItemValid(item, category, searchFilter)
     if not item or not item.marketData then return false end
 
@@ -128,6 +138,7 @@ end
 local function clearOffers()
     marketOffers[MarketAction.Buy] = {}
     marketOffers[MarketAction.Sell] = {}
+    offerStores = {}
     buyOfferTable:clearData()
     sellOfferTable:clearData()
 end
@@ -326,6 +337,117 @@ local function updateOffers(offers)
     end
 end
 
+local function getOfferTable(offerType)
+    if offerType == MarketAction.Buy then return buyOfferTable end
+    return sellOfferTable
+end
+
+local function addStoreOffer(offerTable, offerType, offer)
+    local price = offer.price
+    local amount = offer.amount
+
+    local warn = false
+    if averagePrice > 0 then
+        if offerType == MarketAction.Buy then
+            warn = price <= averagePrice - math.floor(averagePrice / 4)
+        else
+            warn = price >= averagePrice + math.floor(averagePrice / 4)
+        end
+    end
+
+    if warn then offerTable:setColumnStyle('OfferTableWarningColumn', true) end
+
+    local row = offerTable:addRow({
+        {text = offer.player}, {text = amount}, {text = price * amount},
+        {text = price},
+        {text = string.gsub(os.date('%c', offer.timestamp), " ", "  ")}
+    })
+    row.ref = {offer.timestamp, offer.counter}
+
+    if warn then
+        if offerType == MarketAction.Buy then
+            row:setTooltip(tr('This offer is 25%% below the average market price'))
+        else
+            row:setTooltip(tr('This offer is 25%% above the average market price'))
+        end
+        offerTable:setColumnStyle('OfferTableColumn', true)
+    end
+end
+
+-- appends the next page of the store to its table
+local function showMoreOffers(offerType)
+    local store = offerStores[offerType]
+    local offerTable = getOfferTable(offerType)
+    if not store or not offerTable then return end
+
+    local first = #offerTable.rows + 1
+    if first > store:getOfferCount() then return end
+
+    offerTable:toggleSorting(false)
+    for _, offer in ipairs(store:getPage(first, OFFER_PAGE_SIZE)) do
+        addStoreOffer(offerTable, offerType, offer)
+    end
+end
+
+local function showOffers(offerType)
+    -- the buy table selects offers to sell to and the other way around
+    if offerType == MarketAction.Buy then
+        selectedOffer[MarketAction.Sell] = nil
+        sellButton:setEnabled(false)
+    else
+        selectedOffer[MarketAction.Buy] = nil
+        buyButton:setEnabled(false)
+    end
+
+    getOfferTable(offerType):clearData()
+    showMoreOffers(offerType)
+end
+
+local function sortOffers(offerTable, column, sortType)
+    local offerType = MarketAction.Sell
+    if offerTable == buyOfferTable then offerType = MarketAction.Buy end
+
+    local store = offerStores[offerType]
+    if not store or not offerSortColumns[column] then return end
+
+    store:setSorting(offerSortColumns[column], sortType == TABLE_SORTING_DESC)
+    showOffers(offerType)
+end
+
+local function onOffersScroll(offerType, scrollbar, value)
+    local maximum = scrollbar:getMaximum()
+    if maximum > 0 and value >= maximum - scrollbar:getStep() * 2 then
+        showMoreOffers(offerType)
+    end
+end
+
+local function updateItemOffers(buyStore, sellStore)
+    if not buyOfferTable or not sellOfferTable then return end
+
+    balanceLabel:setColor('#bbbbbb')
+    offerStores[MarketAction.Buy] = buyStore
+    offerStores[MarketAction.Sell] = sellStore
+
+    -- keep the order the player picked on the tables
+    for offerType, store in pairs(offerStores) do
+        local offerTable = getOfferTable(offerType)
+        store:setSorting(offerSortColumns[offerTable.sortColumn] or MarketOfferSort.Price,
+                         offerTable.sortType == TABLE_SORTING_DESC)
+        showOffers(offerType)
+    end
+end
+
+-- builds the offer behind an item offer table row
+local function getStoreOffer(offerType, id)
+    local store = offerStores[offerType]
+    if not store or not store:hasOffer(id[1], id[2]) then return nil end
+
+    local offer = store:getOffer(id[1], id[2])
+    return MarketOffer.new(id, offerType, Item.create(offer.itemId),
+                           offer.amount, offer.price, offer.player,
+                           offer.state, offer.itemId)
+end
+
 local function updateDetails(itemId, descriptions, purchaseStats, saleStats)
     if not selectedItem then return end
 
@@ -473,6 +595,11 @@ local function cancelMyOffer(actionType)
     local offer = selectedMyOffer[actionType]
     MarketProtocol.sendMarketCancelOffer(offer:getTimeStamp(),
                                          offer:getCounter())
+    for offerType, store in pairs(offerStores) do
+        if store:removeOffer(offer:getTimeStamp(), offer:getCounter()) then
+            showOffers(offerType)
+        end
+    end
     Market.refreshMyOffers()
 end
 
@@ -536,11 +663,8 @@ end
 
 local function onSelectSellOffer(table, selectedRow, previousSelectedRow)
     updateBalance()
-    for _, offer in pairs(marketOffers[MarketAction.Sell]) do
-        if offer:isEqual(selectedRow.ref) then
-            selectedOffer[MarketAction.Buy] = offer
-        end
-    end
+    local selected = getStoreOffer(MarketAction.Sell, selectedRow.ref)
+    if selected then selectedOffer[MarketAction.Buy] = selected end
 
     local offer = selectedOffer[MarketAction.Buy]
     if offer then
@@ -565,14 +689,13 @@ end
 
 local function onSelectBuyOffer(table, selectedRow, previousSelectedRow)
     updateBalance()
-    for _, offer in pairs(marketOffers[MarketAction.Buy]) do
-        if offer:isEqual(selectedRow.ref) then
-            selectedOffer[MarketAction.Sell] = offer
-            if Market.getDepotCount(offer:getItem():getId()) > 0 then
-                sellButton:setEnabled(true)
-            else
-                sellButton:setEnabled(false)
-            end
+    local offer = getStoreOffer(MarketAction.Buy, selectedRow.ref)
+    if offer then
+        selectedOffer[MarketAction.Sell] = offer
+        if Market.getDepotCount(offer:getItem():getId()) > 0 then
+            sellButton:setEnabled(true)
+        else
+            sellButton:setEnabled(false)
         end
     end
 end
@@ -836,6 +959,16 @@ local function initInterface()
     sellStatsTable = itemStatsPanel:recursiveGetChildById('sellStatsTable')
     buyOfferTable.onSelectionChange = onSelectBuyOffer
     sellOfferTable.onSelectionChange = onSelectSellOffer
+    buyOfferTable.onSort = sortOffers
+    sellOfferTable.onSort = sortOffers
+    connect(itemOffersPanel:recursiveGetChildById('buyingTableScrollBar'),
+            'onValueChange', function(scrollbar, value)
+        onOffersScroll(MarketAction.Buy, scrollbar, value)
+    end)
+    connect(itemOffersPanel:recursiveGetChildById('sellingTableScrollBar'),
+            'onValueChange', function(scrollbar, value)
+        onOffersScroll(MarketAction.Sell, scrollbar, value)
+    end)
 
     -- setup my offers
     buyMyOfferTable = currentOffersPanel:recursiveGetChildById('myBuyingTable')
@@ -1162,6 +1295,16 @@ end
 function Market.acceptMarketOffer(amount, timestamp, counter)
     if timestamp > 0 and amount > 0 then
         MarketProtocol.sendMarketAcceptOffer(timestamp, counter, amount)
+
+        -- offers of the browsed item are updated in place instead of browsing it again
+        for offerType, store in pairs(offerStores) do
+            if store:hasOffer(timestamp, counter) then
+                local offer = store:getOffer(timestamp, counter)
+                store:setOfferAmount(timestamp, counter, math.max(offer.amount - amount, 0))
+                showOffers(offerType)
+                return
+            end
+        end
         Market.refreshOffers()
     end
 end
@@ -1221,3 +1364,7 @@ function Market.onMarketDetail(itemId, descriptions, purchaseStats, saleStats)
 end
 
 function Market.onMarketBrowse(offers) updateOffers(offers) end
+
+function Market.onMarketBrowseItem(itemId, buyOffers, sellOffers)
+    updateItemOffers(buyOffers, sellOffers)
+end
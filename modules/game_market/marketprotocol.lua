@@ -115,6 +115,18 @@ end
 
 local function parseMarketBrowse(protocol, msg)
     local var = msg:getU16()
+
+    -- item browses can hold thousands of offers, they are kept natively and only shown a page at a time
+    if var ~= MarketRequest.MyOffers and var ~= MarketRequest.MyHistory then
+        local buyOffers = MarketOfferStore.create()
+        buyOffers:readOffers(msg, var)
+        local sellOffers = MarketOfferStore.create()
+        sellOffers:readOffers(msg, var)
+
+        signalcall(Market.onMarketBrowseItem, var, buyOffers, sellOffers)
+        return true
+    end
+
     local offers = {}
 
     local buyOfferCount = msg:getU32()
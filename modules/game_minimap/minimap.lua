@@ -111,6 +111,11 @@ controller:onGameStart(function()
 
     if g_resources.fileExists(minimapFile) then loadFnc(minimapFile) end
 
+    -- only the blocks changed since the last save are appended, in background
+    if otmm then
+        g_minimap.setAutoSave(minimapFile, 5 * 60 * 1000)
+    end
+
     local minimapWidget = controller.widgets.minimapWidget
     minimapWidget:load()
 end)
@@ -120,6 +125,7 @@ controller:onGameEnd(function()
 
     -- Save Map
     if otmm then
+        g_minimap.setAutoSave('', 0)
         g_minimap.saveOtmm('/minimap.otmm')
     else
         g_map.saveOtcm('/minimap_' .. g_game.getClientVersion() .. '.otcm')
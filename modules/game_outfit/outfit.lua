@@ -23,6 +23,9 @@ local currentMount = 1
 
 local colorBoxes = {}
 
+-- outfits reached by the next and previous buttons, their previews are composed ahead
+local PREFETCH_RANGE = 3
+
 localPlayerEvent = EventController:new(LocalPlayer, {
     onOutfitChange = function(creature)
         creature = creature or g_game.getLocalPlayer()
@@ -69,6 +72,26 @@ localPlayerEvent = EventController:new(LocalPlayer, {
     end
 })
 
+local function prefetchPreviews(list, current, template)
+    if not list or not template or #list < 2 then return end
+
+    local previews = {}
+    for i = -PREFETCH_RANGE, PREFETCH_RANGE do
+        if i ~= 0 then
+            local preview = table.copy(template)
+            preview.type = list[(current - 1 + i) % #list + 1][1]
+            preview.addons = 0
+            previews[#previews + 1] = preview
+        end
+    end
+    g_outfitPreviews.prefetch(previews)
+end
+
+local function prefetchNeighbours()
+    prefetchPreviews(outfits, currentOutfit, outfit)
+    prefetchPreviews(mounts, currentMount, mount)
+end
+
 controller = Controller:new()
 
 controller:onGameEnd(function() destroy() end)
@@ -172,6 +195,7 @@ controller:gameEvent('onOpenOutfitWindow',
     end
 
     localPlayerEvent:execute('onOutfitChange')
+    prefetchNeighbours()
 end)
 
 function destroy()
@@ -217,6 +241,7 @@ function nextOutfitType()
     if currentOutfit > #outfits then currentOutfit = 1 end
 
     localPlayerEvent:execute('onOutfitChange')
+    prefetchNeighbours()
 end
 
 function previousOutfitType()
@@ -226,6 +251,7 @@ function previousOutfitType()
     if currentOutfit <= 0 then currentOutfit = #outfits end
 
     localPlayerEvent:execute('onOutfitChange')
+    prefetchNeighbours()
 end
 
 function nextMountType()
@@ -234,6 +260,7 @@ function nextMountType()
     currentMount = currentMount + 1
     if currentMount > #mounts then currentMount = 1 end
     localPlayerEvent:execute('onOutfitChange')
+    prefetchNeighbours()
 end
 
 function previousMountType()
@@ -245,6 +272,7 @@ function previousMountType()
     print(#mounts)
 
     localPlayerEvent:execute('onOutfitChange')
+    prefetchNeighbours()
 end
 
 function onAddonCheckChange(addon, value)
@@ -33,6 +33,25 @@ EmblemOther = 5
 VipIconFirst = 0
 VipIconLast = 10
 
+ContainerDeltaInsert = 0
+ContainerDeltaRemove = 1
+ContainerDeltaUpdate = 2
+
+SpectatorHidePlayers = 1
+SpectatorHideNpcs = 2
+SpectatorHideMonsters = 4
+SpectatorHideUnskulled = 8
+SpectatorHideParty = 16
+
+SpectatorSortByName = 0
+SpectatorSortByDistance = 1
+SpectatorSortByHealth = 2
+SpectatorSortByAge = 3
+
+SpectatorDeltaAdd = 0
+SpectatorDeltaRemove = 1
+SpectatorDeltaMove = 2
+
 Directions = {
     North = 0,
     East = 1,
@@ -152,6 +171,7 @@ GameIngameStore = 73
 GameIngameStoreHighlights = 74
 GameIngameStoreServiceType = 75
 GameAdditionalSkills = 76
+GamePacketCompression = 77
 
 TextColors = {
     red = '#f55e5e', -- '#c83200'
@@ -304,4 +324,14 @@ SubscriptionStatus = {Free = 0, Premium = 1}
 
 ChannelEvent = {Join = 0, Leave = 1, Invite = 2, Exclude = 3}
 
+-- detail a map view leaves out while its tiles are drawn smaller than the rule threshold, see UIMap:setLodThreshold
+MapLodRule = {
+    Decorations = 0,
+    Effects = 1,
+    AnimatedTexts = 2,
+    CreatureInformation = 3,
+    SimpleCreatures = 4,
+    MinimapFloors = 5
+}
+
 -- @}
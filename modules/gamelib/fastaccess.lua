@@ -0,0 +1,93 @@
+-- Hot read-only accessors for bot and hud scripts.
+-- Under LuaJIT they call plain C functions through the ffi, which the jit can
+-- compile, instead of going through the C++ object __index metamethod.
+-- Without LuaJIT they fall back to the regular bound methods.
+FastAccess = {}
+
+local hasFfi, ffi = false, nil
+if jit then hasFfi, ffi = pcall(require, 'ffi') end
+
+if hasFfi then
+    -- must match src/client/luaffi.h
+    ffi.cdef [[
+        typedef struct { uint16_t x; uint16_t y; uint8_t z; } otc_position;
+        int otc_thing_get_position(void* object, otc_position* position);
+        uint32_t otc_creature_get_id(void* object);
+        int otc_creature_get_health_percent(void* object);
+        uint32_t otc_item_get_id(void* object);
+        int otc_item_get_count(void* object);
+        int otc_tile_get_flags(void* object, uint32_t* flags);
+        int otc_map_get_tile_flags(uint16_t x, uint16_t y, uint8_t z, uint32_t* flags);
+        int otc_map_is_walkable(uint16_t x, uint16_t y, uint8_t z, int ignoreCreatures);
+    ]]
+
+    local C = ffi.C
+    local position = ffi.new('otc_position')
+    local flags = ffi.new('uint32_t[1]')
+
+    -- the object userdata holds a single pointer to the C++ object
+    local function object(userdata) return ffi.cast('void**', userdata)[0] end
+
+    function FastAccess.getPositionXYZ(thing)
+        if C.otc_thing_get_position(object(thing), position) == 0 then return nil end
+        return position.x, position.y, position.z
+    end
+
+    function FastAccess.getCreatureId(creature) return C.otc_creature_get_id(object(creature)) end
+
+    function FastAccess.getHealthPercent(creature)
+        return C.otc_creature_get_health_percent(object(creature))
+    end
+
+    function FastAccess.getItemId(item) return C.otc_item_get_id(object(item)) end
+
+    function FastAccess.getItemCount(item) return C.otc_item_get_count(object(item)) end
+
+    function FastAccess.getTileFlags(tile)
+        if C.otc_tile_get_flags(object(tile), flags) == 0 then return nil end
+        return tonumber(flags[0])
+    end
+
+    function FastAccess.getMapTileFlags(pos)
+        if C.otc_map_get_tile_flags(pos.x, pos.y, pos.z, flags) == 0 then return nil end
+        return tonumber(flags[0])
+    end
+
+    function FastAccess.isWalkable(pos, ignoreCreatures)
+        return C.otc_map_is_walkable(pos.x, pos.y, pos.z, ignoreCreatures and 1 or 0) ~= 0
+    end
+else
+    function FastAccess.getPositionXYZ(thing)
+        local pos = thing:getPosition()
+        if not pos or pos.x == 65535 then return nil end
+        return pos.x, pos.y, pos.z
+    end
+
+    function FastAccess.getCreatureId(creature) return creature:getId() end
+
+    function FastAccess.getHealthPercent(creature) return creature:getHealthPercent() end
+
+    function FastAccess.getItemId(item) return item:getId() end
+
+    function FastAccess.getItemCount(item) return item:getCount() end
+
+    function FastAccess.getTileFlags(tile) return tile:getFlags() end
+
+    function FastAccess.getMapTileFlags(pos)
+        local tile = g_map.getTile(pos)
+        return tile and tile:getFlags() or nil
+    end
+
+    function FastAccess.isWalkable(pos, ignoreCreatures)
+        local tile = g_map.getTile(pos)
+        return tile ~= nil and tile:isWalkable(ignoreCreatures or false)
+    end
+end
+
+function FastAccess.getPosition(thing)
+    local x, y, z = FastAccess.getPositionXYZ(thing)
+    if not x then return nil end
+    return {x = x, y = y, z = z}
+end
+
+function FastAccess.isUsingFfi() return hasFfi end
@@ -0,0 +1,71 @@
+-- loads the modules declared lazy in their otmod when one of their load-on triggers fires
+LazyModules = {}
+
+local opcodeModules = {}
+local extendedOpcodeModules = {}
+local hotkeyTriggers = {}
+
+local function removeTriggers(module)
+    for opcode, lazyModule in pairs(opcodeModules) do
+        if lazyModule == module then opcodeModules[opcode] = nil end
+    end
+    for opcode, lazyModule in pairs(extendedOpcodeModules) do
+        if lazyModule == module then extendedOpcodeModules[opcode] = nil end
+    end
+    local triggers = hotkeyTriggers[module:getName()]
+    if triggers then
+        for hotkey, callback in pairs(triggers) do
+            g_keyboard.unbindKeyDown(hotkey, callback)
+        end
+        hotkeyTriggers[module:getName()] = nil
+    end
+end
+
+local function activate(module, trigger)
+    removeTriggers(module)
+    if module:isLoaded() then return true end
+    g_logger.debug(('Loading lazy module %s on %s'):format(module:getName(), trigger))
+    return module:load()
+end
+
+function LazyModules.install()
+    for _, module in pairs(g_modules.getModules()) do
+        if module:isLazy() and not module:isLoaded() then
+            removeTriggers(module)
+            for _, opcode in ipairs(module:getLoadOnOpcodes()) do
+                opcodeModules[opcode] = module
+            end
+            for _, opcode in ipairs(module:getLoadOnExtendedOpcodes()) do
+                extendedOpcodeModules[opcode] = module
+            end
+
+            local triggers = {}
+            for _, hotkey in ipairs(module:getLoadOnHotkeys()) do
+                -- the module binds the same combo while loading, the press that woke it up is handed over afterwards
+                triggers[hotkey] = function()
+                    addEvent(function()
+                        if activate(module, hotkey) then
+                            g_keyboard.triggerKeyDown(hotkey)
+                        end
+                    end)
+                    return true
+                end
+                g_keyboard.bindKeyDown(hotkey, triggers[hotkey])
+            end
+            hotkeyTriggers[module:getName()] = triggers
+        end
+    end
+end
+
+-- called for every server opcode before it is parsed, the module registers its own handlers while loading
+function LazyModules.onOpcode(opcode)
+    local module = opcodeModules[opcode]
+    if module then activate(module, 'opcode ' .. opcode) end
+end
+
+function LazyModules.onExtendedOpcode(opcode)
+    local module = extendedOpcodeModules[opcode]
+    if module then activate(module, 'extended opcode ' .. opcode) end
+end
+
+LazyModules.install()
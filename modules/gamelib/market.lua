@@ -15,6 +15,14 @@ MarketOfferState = {
     AcceptedEx = 255
 }
 
+MarketOfferSort = {
+    Price = 0,
+    Amount = 1,
+    TotalPrice = 2,
+    Timestamp = 3,
+    Player = 4
+}
+
 MarketCategory = {
     All = 0,
     Armors = 1,
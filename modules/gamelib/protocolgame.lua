@@ -2,6 +2,7 @@ local opcodeCallbacks = {}
 local extendedCallbacks = {}
 
 function ProtocolGame:onOpcode(opcode, msg)
+    LazyModules.onOpcode(opcode)
     for i, callback in pairs(opcodeCallbacks) do
         if i == opcode then
             callback(self, msg)
@@ -12,6 +13,7 @@ function ProtocolGame:onOpcode(opcode, msg)
 end
 
 function ProtocolGame:onExtendedOpcode(opcode, buffer)
+    LazyModules.onExtendedOpcode(opcode)
     local callback = extendedCallbacks[opcode]
     if callback then callback(self, opcode, buffer) end
 end
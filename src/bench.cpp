@@ -0,0 +1,512 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <framework/core/application.h>
+#include <framework/core/resourcemanager.h>
+#include <framework/core/stats.h>
+#include <framework/graphics/drawpool.h>
+#include <framework/luaengine/luainterface.h>
+#include <framework/net/protocol.h>
+#include <framework/otml/otml.h>
+#include <client/client.h>
+#include <client/creature.h>
+#include <client/game.h>
+#include <client/item.h>
+#include <client/map.h>
+#include <client/mapview.h>
+#include <client/spritemanager.h>
+#include <client/thingtypemanager.h>
+#include <client/tile.h>
+
+#include <fstream>
+#include <random>
+
+// runs the benchmark suite over the headless client and writes the results as json, the
+// data dependent benchmarks are skipped when their files are not given
+//
+// usage: otclient_bench [-data dir] [-version 1098] [-spr file] [-dat file] [-otb file] [-otbm file]
+//                       [-filter prefix] [-output bench.json]
+
+namespace {
+    // every random input derives from it, so two runs over the same data do the same work
+    const uint32 SEED = 1;
+
+    struct BenchResult {
+        std::string name;
+        std::string skipReason;
+        // set by benchmarks that also check a budget, the suite exits with an error when any is set
+        std::string failReason;
+        std::vector<std::pair<std::string, double>> metrics;
+    };
+
+    struct BenchOptions {
+        std::string dataDir = ".";
+        int clientVersion = 1098;
+        std::string spr, dat, otb, otbm, filter;
+        std::string output = "bench.json";
+    };
+
+    std::string escapeJson(const std::string& text)
+    {
+        std::string ret;
+        for(const char c : text) {
+            if(c == '"' || c == '\\') {
+                ret += '\\';
+                ret += c;
+            } else if(static_cast<uint8>(c) < 0x20)
+                ret += stdext::format("\\u%04x", static_cast<int>(c));
+            else
+                ret += c;
+        }
+        return ret;
+    }
+
+    std::string toJson(const std::vector<BenchResult>& results)
+    {
+        std::string json = "{\n";
+        json += stdext::format("  \"version\": \"%s\",\n", escapeJson(VERSION));
+        json += stdext::format("  \"build_type\": \"%s\",\n", escapeJson(BUILD_TYPE));
+        json += stdext::format("  \"seed\": %d,\n", SEED);
+        json += "  \"benchmarks\": [";
+        for(size_t i = 0; i < results.size(); ++i) {
+            const BenchResult& result = results[i];
+            json += i == 0 ? "\n" : ",\n";
+            json += stdext::format("    { \"name\": \"%s\", ", escapeJson(result.name));
+            if(!result.skipReason.empty()) {
+                json += stdext::format("\"status\": \"skipped\", \"reason\": \"%s\" }", escapeJson(result.skipReason));
+                continue;
+            }
+
+            if(!result.failReason.empty())
+                json += stdext::format("\"status\": \"failed\", \"reason\": \"%s\", \"metrics\": {", escapeJson(result.failReason));
+            else
+                json += "\"status\": \"ok\", \"metrics\": {";
+            for(size_t j = 0; j < result.metrics.size(); ++j)
+                json += stdext::format("%s \"%s\": %.6g", j == 0 ? "" : ",", escapeJson(result.metrics[j].first), result.metrics[j].second);
+            json += " } }";
+        }
+        json += "\n  ]\n}\n";
+        return json;
+    }
+
+    std::string toVirtualPath(const std::string& file)
+    {
+        return stdext::starts_with(file, "/") ? file : "/" + file;
+    }
+
+    class BenchSuite
+    {
+    public:
+        BenchSuite(const BenchOptions& options) : m_options(options) {}
+
+        void run()
+        {
+            loadData();
+
+            runBench("sprites.decode", &BenchSuite::benchSpriteDecode);
+            runBench("things.texture", &BenchSuite::benchThingTextures);
+            runBench("map.findPath", &BenchSuite::benchFindPath);
+
+            // the synthetic crowd replaces the loaded map, so the benchmarks of real maps come first
+            runBench("map.spectators", &BenchSuite::benchSpectators);
+            runBench("mapview.visibleTiles", &BenchSuite::benchVisibleTiles);
+            runBench("mapview.drawAllocations", &BenchSuite::benchDrawAllocations);
+            runBench("drawpool", &BenchSuite::benchDrawPool);
+            runBench("xtea", &BenchSuite::benchXtea);
+            runBench("otml.parse", &BenchSuite::benchOtmlParse);
+            runBench("lua.objectGetEvent", &BenchSuite::benchLuaObjectEvents);
+        }
+
+        const std::vector<BenchResult>& getResults() { return m_results; }
+        bool hasFailures()
+        {
+            return std::any_of(m_results.begin(), m_results.end(), [](const BenchResult& result) { return !result.failReason.empty(); });
+        }
+
+    private:
+        typedef void (BenchSuite::*BenchFunction)(BenchResult& result);
+
+        void loadData()
+        {
+            g_game.setClientVersion(m_options.clientVersion);
+            if(!m_options.spr.empty() && !g_sprites.loadSpr(toVirtualPath(m_options.spr)))
+                g_logger.error(stdext::format("Unable to load sprites '%s'", m_options.spr));
+            if(!m_options.dat.empty() && !g_things.loadDat(toVirtualPath(m_options.dat)))
+                g_logger.error(stdext::format("Unable to load things '%s'", m_options.dat));
+            if(!m_options.otb.empty())
+                g_things.loadOtb(toVirtualPath(m_options.otb));
+        }
+
+        void runBench(const std::string& name, BenchFunction function)
+        {
+            if(!m_options.filter.empty() && !stdext::starts_with(name, m_options.filter))
+                return;
+
+            BenchResult result;
+            result.name = name;
+            try {
+                (this->*function)(result);
+            } catch(stdext::exception& e) {
+                result.metrics.clear();
+                result.skipReason = e.what();
+            }
+
+            if(!result.failReason.empty())
+                g_logger.error(stdext::format("%s failed: %s", name, result.failReason));
+            else if(result.skipReason.empty())
+                g_logger.info(stdext::format("%s done", name));
+            else
+                g_logger.info(stdext::format("%s skipped: %s", name, result.skipReason));
+            m_results.push_back(result);
+        }
+
+        void benchSpriteDecode(BenchResult& result)
+        {
+            if(!g_sprites.isLoaded())
+                stdext::throw_exception("no sprites loaded, use -spr");
+
+            result.metrics.emplace_back("sprites", g_sprites.getSpritesCount());
+            result.metrics.emplace_back("sprites_per_second", g_sprites.benchmarkDecoding());
+        }
+
+        void benchThingTextures(BenchResult& result)
+        {
+            if(!g_sprites.isLoaded() || !g_things.isDatLoaded())
+                stdext::throw_exception("no sprites or things loaded, use -spr and -dat");
+
+            // the first call composes the phase image, the following ones hit the cached region
+            std::vector<ThingTypePtr> thingTypes;
+            for(const ThingCategory category : { ThingCategoryItem, ThingCategoryCreature }) {
+                const ThingTypeList& list = g_things.getThingTypes(category);
+                for(size_t i = 1; i < list.size() && i <= 2000; ++i) {
+                    if(list[i] && !list[i]->isNull())
+                        thingTypes.push_back(list[i]);
+                }
+            }
+
+            stdext::timer timer;
+            for(const ThingTypePtr& thingType : thingTypes)
+                thingType->getTexture(0);
+            const ticks_t coldElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+            const int rounds = 20;
+            timer.restart();
+            for(int i = 0; i < rounds; ++i)
+                for(const ThingTypePtr& thingType : thingTypes)
+                    thingType->getTexture(0);
+            const ticks_t warmElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+            result.metrics.emplace_back("thing_types", thingTypes.size());
+            result.metrics.emplace_back("compose_us", static_cast<double>(coldElapsed) / std::max<size_t>(1, thingTypes.size()));
+            result.metrics.emplace_back("cached_ns", warmElapsed * 1000.0 / std::max<size_t>(1, thingTypes.size() * rounds));
+        }
+
+        void benchFindPath(BenchResult& result)
+        {
+            if(m_options.otbm.empty() || !g_things.isOtbLoaded())
+                stdext::throw_exception("no map loaded, use -otb and -otbm");
+
+            g_map.loadOtbm(toVirtualPath(m_options.otbm));
+
+            std::vector<Position> walkable;
+            for(const TilePtr& tile : g_map.getTiles(Otc::SEA_FLOOR)) {
+                if(tile->isWalkable())
+                    walkable.push_back(tile->getPosition());
+            }
+            if(walkable.size() < 2)
+                stdext::throw_exception("the map has no walkable tiles on the ground floor");
+            std::sort(walkable.begin(), walkable.end(), [](const Position& a, const Position& b) {
+                return a.y != b.y ? a.y < b.y : a.x < b.x;
+            });
+
+            // pairs of walkable tiles not too far apart, a route across the whole map is always too far
+            std::mt19937 gen(SEED);
+            std::vector<std::pair<Position, Position>> routes;
+            for(int attempts = 0; routes.size() < 500 && attempts < 100000; ++attempts) {
+                const Position& start = walkable[gen() % walkable.size()];
+                const Position& goal = walkable[gen() % walkable.size()];
+                if(start != goal && start.distance(goal) <= 40)
+                    routes.emplace_back(start, goal);
+            }
+            if(routes.empty())
+                stdext::throw_exception("no walkable tiles close enough to route between");
+
+            int found = 0;
+            stdext::timer timer;
+            for(const auto& route : routes) {
+                if(std::get<1>(g_map.findPath(route.first, route.second, 10000)) == Otc::PathFindResultOk)
+                    ++found;
+            }
+            const ticks_t elapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+            result.metrics.emplace_back("routes", routes.size());
+            result.metrics.emplace_back("found", found);
+            result.metrics.emplace_back("us_per_path", static_cast<double>(elapsed) / routes.size());
+        }
+
+        // a fully grounded area with a crowd walking on it, built once for the map benchmarks
+        void buildCrowdedMap()
+        {
+            if(m_crowdCenter.isValid())
+                return;
+            if(!g_things.isDatLoaded())
+                stdext::throw_exception("no things loaded, use -dat");
+
+            uint16 groundId = 0;
+            const ThingTypeList& items = g_things.getThingTypes(ThingCategoryItem);
+            for(size_t i = 100; i < items.size() && !groundId; ++i) {
+                if(items[i] && items[i]->isGround() && !items[i]->isNotWalkable())
+                    groundId = i;
+            }
+            if(!groundId)
+                stdext::throw_exception("the things have no walkable ground");
+
+            g_map.clean();
+            m_crowdCenter = Position(1000, 1000, Otc::SEA_FLOOR);
+            g_map.setCentralPosition(m_crowdCenter);
+
+            const int radius = 64;
+            for(int x = -radius; x <= radius; ++x)
+                for(int y = -radius; y <= radius; ++y)
+                    g_map.addThing(Item::create(groundId), m_crowdCenter.translated(x, y));
+
+            std::mt19937 gen(SEED);
+            for(uint32 i = 0; i < 1000; ++i) {
+                CreaturePtr creature(new Creature);
+                creature->setId(0x40000000 + i);
+                creature->setName(stdext::format("Creature %d", i));
+                g_map.addCreature(creature);
+                g_map.addThing(creature, m_crowdCenter.translated(static_cast<int>(gen() % (radius * 2 + 1)) - radius,
+                                                                 static_cast<int>(gen() % (radius * 2 + 1)) - radius));
+            }
+        }
+
+        void benchSpectators(BenchResult& result)
+        {
+            buildCrowdedMap();
+
+            const int iterations = 10000;
+            std::mt19937 gen(SEED);
+            size_t spectators = 0;
+            stdext::timer timer;
+            for(int i = 0; i < iterations; ++i) {
+                const Position center = m_crowdCenter.translated(static_cast<int>(gen() % 64) - 32, static_cast<int>(gen() % 64) - 32);
+                spectators += g_map.getSpectatorsInRangeEx(center, false, 8, 9, 6, 7).size();
+            }
+            const ticks_t elapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+            result.metrics.emplace_back("calls", iterations);
+            result.metrics.emplace_back("average_spectators", static_cast<double>(spectators) / iterations);
+            result.metrics.emplace_back("us_per_call", static_cast<double>(elapsed) / iterations);
+        }
+
+        void benchVisibleTiles(BenchResult& result)
+        {
+            buildCrowdedMap();
+
+            const MapViewPtr mapView(new MapView);
+            g_map.addMapView(mapView);
+            mapView->setCameraPosition(m_crowdCenter);
+
+            double rebuildMicros, shiftMicros;
+            try {
+                std::tie(rebuildMicros, shiftMicros) = mapView->benchmarkVisibleTilesCache(1000);
+            } catch(stdext::exception&) {
+                g_map.removeMapView(mapView);
+                throw;
+            }
+            g_map.removeMapView(mapView);
+
+            result.metrics.emplace_back("rebuild_us", rebuildMicros);
+            result.metrics.emplace_back("shift_us", shiftMicros);
+        }
+
+        void benchDrawAllocations(BenchResult& result)
+        {
+            if(!g_stats.isAllocationTrackerEnabled())
+                stdext::throw_exception("built without ALLOCATION_TRACKER");
+
+            buildCrowdedMap();
+
+            const MapViewPtr mapView(new MapView);
+            g_map.addMapView(mapView);
+            mapView->setCameraPosition(m_crowdCenter);
+
+            // the first frames fill the caches, after them a static scene must not allocate
+            const int warmupFrames = 10, frames = 100;
+            const Rect rect(0, 0, mapView->getVisibleDimension() * Otc::TILE_PIXELS);
+            int64 allocations = 0, worstFrame = 0;
+            for(int frame = 0; frame < warmupFrames + frames; ++frame) {
+                const int64 start = g_stats.getThreadAllocations();
+                mapView->draw(rect);
+                g_drawPool.discardFrame();
+                if(frame < warmupFrames)
+                    continue;
+
+                const int64 frameAllocations = g_stats.getThreadAllocations() - start;
+                allocations += frameAllocations;
+                worstFrame = std::max<int64>(worstFrame, frameAllocations);
+            }
+            g_map.removeMapView(mapView);
+
+            result.metrics.emplace_back("frames", frames);
+            result.metrics.emplace_back("allocations_per_frame", static_cast<double>(allocations) / frames);
+            result.metrics.emplace_back("worst_frame_allocations", worstFrame);
+            if(allocations > 0)
+                result.failReason = stdext::format("the static scene allocated %d times in %d frames", allocations, frames);
+        }
+
+        void benchDrawPool(BenchResult& result)
+        {
+            const auto [addMicros, repeatedMicros, drawMicros] = g_drawPool.benchmark(5000, 200);
+            result.metrics.emplace_back("objects", 5000);
+            result.metrics.emplace_back("add_us", addMicros);
+            result.metrics.emplace_back("add_repeated_us", repeatedMicros);
+            result.metrics.emplace_back("draw_us", drawMicros);
+        }
+
+        void benchXtea(BenchResult& result)
+        {
+            for(const uint32 size : { 64, 1024, 65536 }) {
+                const auto [encryptSpeed, decryptSpeed] = Protocol::benchmarkXtea(size);
+                result.metrics.emplace_back(stdext::format("encrypt_%d_mb_per_second", size), encryptSpeed);
+                result.metrics.emplace_back(stdext::format("decrypt_%d_mb_per_second", size), decryptSpeed);
+            }
+        }
+
+        void benchOtmlParse(BenchResult& result)
+        {
+            // styles of the size a big module ships
+            std::mt19937 gen(SEED);
+            std::string text;
+            for(int i = 0; i < 2000; ++i) {
+                text += stdext::format("Widget%d < UIWidget\n", i);
+                text += stdext::format("  id: widget%d\n", i);
+                text += stdext::format("  size: %d %d\n", gen() % 400, gen() % 300);
+                text += "  anchors.top: parent.top\n  anchors.left: prev.right\n";
+                text += stdext::format("  margin: %d %d %d %d\n", gen() % 10, gen() % 10, gen() % 10, gen() % 10);
+                text += "  text-align: center\n  image-source: /images/ui/button\n";
+                text += "  $hover:\n    image-clip: 0 20 22 20\n    color: #ffffff\n";
+                text += stdext::format("  Label\n    id: label%d\n    text: Some label text %d\n", i, gen());
+            }
+
+            const int iterations = 10;
+            stdext::timer timer;
+            for(int i = 0; i < iterations; ++i) {
+                std::istringstream in(text);
+                OTMLDocument::parse(in, "bench.otui");
+            }
+            const ticks_t elapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+            result.metrics.emplace_back("bytes", text.size());
+            result.metrics.emplace_back("ms_per_parse", elapsed / 1000.0 / iterations);
+            result.metrics.emplace_back("mb_per_second", static_cast<double>(text.size()) * iterations / elapsed);
+        }
+
+        void benchLuaObjectEvents(BenchResult& result)
+        {
+            // every access to a field or method of a bound object goes through luaObjectGetEvent
+            const int iterations = 1000000;
+            const std::vector<std::pair<std::string, std::string>> cases = {
+                { "method_ns", "widget:getId()" },
+                { "method_with_fields_ns", "fieldWidget:getId()" },
+                { "field_ns", "local v = fieldWidget.customField" },
+                { "missing_field_ns", "local v = widget.missingField" }
+            };
+
+            for(const auto& entry : cases) {
+                g_lua.loadBuffer(stdext::format("local iterations = ... "
+                                                "local widget = UIWidget.create() "
+                                                "local fieldWidget = UIWidget.create() "
+                                                "fieldWidget.customField = true "
+                                                "local start = os.clock() "
+                                                "for i = 1, iterations do %s end "
+                                                "local elapsed = os.clock() - start "
+                                                "widget:destroy() fieldWidget:destroy() "
+                                                "return elapsed", entry.second), "@bench");
+                g_lua.pushInteger(iterations);
+                g_lua.call(1, 1);
+                const double elapsed = g_lua.popNumber();
+                result.metrics.emplace_back(entry.first, elapsed * 1000000000.0 / iterations);
+            }
+        }
+
+        BenchOptions m_options;
+        std::vector<BenchResult> m_results;
+        Position m_crowdCenter;
+    };
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    BenchOptions options;
+    for(size_t i = 1; i + 1 < args.size(); i += 2) {
+        const std::string& option = args[i];
+        const std::string& value = args[i + 1];
+        if(option == "-data")
+            options.dataDir = value;
+        else if(option == "-version")
+            options.clientVersion = stdext::safe_cast<int>(value);
+        else if(option == "-spr")
+            options.spr = value;
+        else if(option == "-dat")
+            options.dat = value;
+        else if(option == "-otb")
+            options.otb = value;
+        else if(option == "-otbm")
+            options.otbm = value;
+        else if(option == "-filter")
+            options.filter = value;
+        else if(option == "-output")
+            options.output = value;
+        else {
+            std::cerr << "Unrecognized option '" << option << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    g_app.setName("OTClient Bench");
+    g_app.setCompactName("otclient_bench");
+
+    g_app.init(args);
+    g_client.init(args);
+
+    if(!g_resources.addSearchPath(options.dataDir))
+        g_logger.fatal(stdext::format("Unable to add data directory '%s'", options.dataDir));
+
+    BenchSuite suite(options);
+    suite.run();
+
+    std::ofstream out(options.output, std::ios::binary);
+    out << toJson(suite.getResults());
+    if(!out)
+        g_logger.error(stdext::format("Unable to write '%s'", options.output));
+    else
+        g_logger.info(stdext::format("Results written to '%s'", options.output));
+
+    g_app.deinit();
+    g_client.terminate();
+    g_app.terminate();
+    return out && !suite.hasFailures() ? 0 : 1;
+}
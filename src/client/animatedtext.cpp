@@ -83,6 +83,14 @@ void AnimatedText::setText(const std::string& text)
     m_cachedText.setText(text);
 }
 
+void AnimatedText::reset()
+{
+    m_color = Color::white;
+    m_offset = Point();
+    m_cachedText.setText(std::string());
+    m_position = Position();
+}
+
 bool AnimatedText::merge(const AnimatedTextPtr& other)
 {
     if(other->getColor() != m_color)
@@ -98,7 +106,7 @@ bool AnimatedText::merge(const AnimatedTextPtr& other)
         const int number = stdext::safe_cast<int>(m_cachedText.getText());
         const int otherNumber = stdext::safe_cast<int>(other->getCachedText().getText());
 
-        const std::string text = stdext::format("%d", number + otherNumber);
+        const std::string text = stdext::to_string(number + otherNumber);
         m_cachedText.setText(text);
         return true;
     } catch(...) {
@@ -27,9 +27,10 @@
 #include <framework/graphics/cachedtext.h>
 #include <framework/graphics/fontmanager.h>
 #include "thing.h"
+#include <framework/core/stats.h>
 
  // @bindclass
-class AnimatedText : public Thing
+class AnimatedText : public Thing, private StatsCounted<AnimatedText>
 {
 public:
     AnimatedText();
@@ -46,6 +47,8 @@ public:
     Timer getTimer() { return m_animationTimer; }
 
     bool merge(const AnimatedTextPtr& other);
+    // back to a freshly created text, see Map::createAnimatedText
+    void reset();
 
     AnimatedTextPtr asAnimatedText() { return static_self_cast<AnimatedText>(); }
     bool isAnimatedText() override { return true; }
@@ -54,6 +54,7 @@ void Animator::unserialize(int animationPhases, const FileStreamPtr& fin)
     }
 
     m_phase = getStartPhase();
+    updatePhaseEnds();
 
     assert(m_animationPhases == static_cast<int>(m_phaseDurations.size()));
     assert(m_startPhase >= -1 && m_startPhase < m_animationPhases);
@@ -95,8 +96,12 @@ void Animator::setPhase(int phase)
 
 int Animator::getPhase()
 {
+    // animators are shared by every thing of the same type, only the first call of a frame does any work
     const ticks_t ticks = g_clock.millis();
-    if(ticks != m_lastPhaseTicks && !m_isComplete) {
+    if(ticks == m_lastPhaseTicks)
+        return m_phase;
+
+    if(!m_isComplete) {
         const int elapsedTicks = static_cast<int>(ticks - m_lastPhaseTicks);
         if(elapsedTicks >= m_currentDuration) {
             int phase;
@@ -125,19 +130,7 @@ int Animator::getPhase()
 
 int Animator::getPhaseAt(ticks_t time)
 {
-    int index = 0;
-    ticks_t total = 0;
-
-    for(const auto& pair : m_phaseDurations) {
-        total += std::get<1>(pair);
-
-        if(time < total) {
-            return index;
-        }
-
-        ++index;
-    }
-
+    const int index = std::upper_bound(m_phaseEnds.begin(), m_phaseEnds.end(), time) - m_phaseEnds.begin();
     return std::min<int>(index, m_animationPhases - 1);
 }
 
@@ -197,31 +190,23 @@ int Animator::getPhaseDuration(int phase)
 
 void Animator::calculateSynchronous()
 {
-    int totalDuration = 0;
-    for(int i = 0; i < m_animationPhases; ++i)
-        totalDuration += getPhaseDuration(i);
-
+    // the phase only depends on the clock, so every instance shows the same phase at the same time
     const ticks_t ticks = g_clock.millis();
-    const int elapsedTicks = static_cast<int>(ticks % totalDuration);
-    int totalTime = 0;
-    for(int i = 0; i < m_animationPhases; ++i) {
-        const int duration = getPhaseDuration(i);
-        if(elapsedTicks >= totalTime && elapsedTicks < totalTime + duration) {
-            m_phase = i;
-            m_currentDuration = duration - (elapsedTicks - totalTime);
-            break;
-        }
-        totalTime += duration;
+    const ticks_t totalDuration = getTotalDuration();
+    if(totalDuration > 0) {
+        const ticks_t elapsedTicks = ticks % totalDuration;
+        m_phase = getPhaseAt(elapsedTicks);
+        m_currentDuration = static_cast<int>(m_phaseEnds[m_phase] - elapsedTicks);
     }
     m_lastPhaseTicks = ticks;
 }
 
-ticks_t Animator::getTotalDuration()
+void Animator::updatePhaseEnds()
 {
-    ticks_t time = 0;
+    m_phaseEnds.clear();
+    ticks_t total = 0;
     for(const auto& pair : m_phaseDurations) {
-        time += std::get<1>(pair);
+        total += std::get<1>(pair);
+        m_phaseEnds.push_back(total);
     }
-
-    return time;
 }
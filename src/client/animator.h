@@ -59,7 +59,7 @@ public:
     bool isAsync() { return m_async; }
     bool isComplete() { return m_isComplete; }
 
-    ticks_t getTotalDuration();
+    ticks_t getTotalDuration() { return m_phaseEnds.empty() ? 0 : m_phaseEnds.back(); }
 
 private:
     int getPingPongPhase();
@@ -67,6 +67,7 @@ private:
     int getPhaseDuration(int phase);
 
     void calculateSynchronous();
+    void updatePhaseEnds();
 
     int m_currentDuration;
     int m_animationPhases;
@@ -79,6 +80,8 @@ private:
     bool m_async;
 
     std::vector<std::tuple<int, int>> m_phaseDurations;
+    // time at which each phase ends when every phase runs its maximum duration
+    std::vector<ticks_t> m_phaseEnds;
     AnimationDirection m_currentDirection;
     ticks_t m_lastPhaseTicks;
 };
@@ -25,11 +25,16 @@
 #include <framework/core/modulemanager.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/graphics.h>
+#include "creatureoverlay.h"
 #include "game.h"
+#include "gamestateexport.h"
 #include "map.h"
 #include "minimap.h"
+#include "outfitpreview.h"
 #include "shadermanager.h"
 #include "spritemanager.h"
+#include "spectatortracker.h"
+#include "thingtexturecache.h"
 
 Client g_client;
 
@@ -84,9 +89,14 @@ void Client::init(std::vector<std::string>& /*args*/)
 void Client::terminate()
 {
     g_creatures.terminate();
+    g_creatureOverlay.terminate();
+    g_spectatorTracker.terminate();
+    g_gameStateExport.terminate();
     g_game.terminate();
     g_map.terminate();
     g_minimap.terminate();
+    g_outfitPreviews.terminate();
+    g_thingTextureCache.terminate();
     g_things.terminate();
     g_sprites.terminate();
     g_shaders.terminate();
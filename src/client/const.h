@@ -60,7 +60,12 @@ namespace Otc
         FupdateCreature = FUpdateThing | FUpdateCreatureInformation,
         FUpdateTextInformation = FUpdateStaticText | FUpdateCreatureInformation,
 
-        FUpdateAll = FUpdateThing | FUpdateLight | FUpdateStaticText | FUpdateCreatureInformation
+        FUpdateAll = FUpdateThing | FUpdateLight | FUpdateStaticText | FUpdateCreatureInformation,
+
+        // detail left out by map views zoomed far out, lights are still cast
+        FSkipDecoration = 1 << 4,
+        FSkipEffect = 1 << 5,
+        FSimplifyCreature = 1 << 6
     };
 
     enum DrawFlags : uint32 {
@@ -436,6 +441,7 @@ namespace Otc
         GameIngameStoreHighlights = 74,
         GameIngameStoreServiceType = 75,
         GameAdditionalSkills = 76,
+        GamePacketCompression = 77,
 
         LastGameFeature = 101
     };
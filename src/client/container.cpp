@@ -23,6 +23,8 @@
 #include "container.h"
 #include "item.h"
 
+#include <framework/core/eventdispatcher.h>
+
 Container::Container(int id, int capacity, const std::string& name, const ItemPtr& containerItem, bool hasParent, bool isUnlocked, bool hasPages, int containerSize, int firstIndex)
 {
     m_id = id;
@@ -62,7 +64,10 @@ void Container::onAddItem(const ItemPtr& item, int slot)
     ++m_size;
     // indicates that there is a new item on next page
     if(m_hasPages && slot > m_capacity) {
-        callLuaField("onSizeChange", m_size);
+        if(m_deltaMode)
+            pushDelta(DeltaInsert, -1, item);
+        else
+            callLuaField("onSizeChange", m_size);
         return;
     }
 
@@ -72,6 +77,11 @@ void Container::onAddItem(const ItemPtr& item, int slot)
         m_items.push_back(item);
     updateItemsPositions();
 
+    if(m_deltaMode) {
+        pushDelta(DeltaInsert, slot == 0 ? 0 : m_items.size() - 1, item);
+        return;
+    }
+
     callLuaField("onSizeChange", m_size);
     callLuaField("onAddItem", slot, item);
 }
@@ -103,6 +113,11 @@ void Container::onUpdateItem(int slot, const ItemPtr& item)
     m_items[slot] = item;
     item->setPosition(getSlotPosition(slot));
 
+    if(m_deltaMode) {
+        pushDelta(DeltaUpdate, slot, item);
+        return;
+    }
+
     callLuaField("onUpdateItem", slot, item, oldItem);
 }
 
@@ -111,7 +126,10 @@ void Container::onRemoveItem(int slot, const ItemPtr& lastItem)
     slot -= m_firstIndex;
     if(m_hasPages && slot >= static_cast<int>(m_items.size())) {
         --m_size;
-        callLuaField("onSizeChange", m_size);
+        if(m_deltaMode)
+            pushDelta(DeltaRemove, -1, nullptr);
+        else
+            callLuaField("onSizeChange", m_size);
         return;
     }
 
@@ -123,6 +141,9 @@ void Container::onRemoveItem(int slot, const ItemPtr& lastItem)
     const ItemPtr item = m_items[slot];
     m_items.erase(m_items.begin() + slot);
 
+    if(m_deltaMode)
+        pushDelta(DeltaRemove, slot, item);
+
     if(lastItem) {
         onAddItem(lastItem, m_firstIndex + m_capacity - 1);
         --m_size;
@@ -132,10 +153,45 @@ void Container::onRemoveItem(int slot, const ItemPtr& lastItem)
 
     updateItemsPositions();
 
+    if(m_deltaMode)
+        return;
+
     callLuaField("onSizeChange", m_size);
     callLuaField("onRemoveItem", slot, item);
 }
 
+void Container::pushDelta(DeltaType type, int slot, const ItemPtr& item)
+{
+    // an update replacing the previous one at the same slot is the only change worth folding
+    if(type == DeltaUpdate && !m_deltas.empty()) {
+        auto& last = m_deltas.back();
+        if(std::get<0>(last) == DeltaUpdate && std::get<1>(last) == slot) {
+            std::get<2>(last) = item;
+            return;
+        }
+    }
+    m_deltas.emplace_back(type, slot, item);
+
+    if(m_deltaFlushPending)
+        return;
+
+    m_deltaFlushPending = true;
+    const ContainerPtr self = static_self_cast<Container>();
+    g_dispatcher.addEvent([self] { self->flushDeltas(); });
+}
+
+void Container::flushDeltas()
+{
+    m_deltaFlushPending = false;
+
+    std::vector<std::tuple<uint8, int, ItemPtr>> deltas;
+    deltas.swap(m_deltas);
+    if(m_closed || deltas.empty())
+        return;
+
+    callLuaField("onContainerDelta", deltas, m_size);
+}
+
 void Container::updateItemsPositions()
 {
     for(int slot = 0; slot < static_cast<int>(m_items.size()); ++slot)
@@ -35,6 +35,17 @@ protected:
     Container(int id, int capacity, const std::string& name, const ItemPtr& containerItem, bool hasParent, bool isUnlocked, bool hasPages, int containerSize, int firstIndex);
 
 public:
+    enum DeltaType : uint8 {
+        DeltaInsert = 0,
+        DeltaRemove,
+        DeltaUpdate
+    };
+
+    // item changes are reported by one onContainerDelta(deltas, size) per frame instead of the per item callbacks,
+    // each delta is {type, slot, item} with the slot as it was right after that change
+    void setDeltaMode(bool enable) { m_deltaMode = enable; }
+    bool isDeltaMode() { return m_deltaMode; }
+
     ItemPtr getItem(int slot);
     std::deque<ItemPtr> getItems() { return m_items; }
     int getItemsCount() { return m_items.size(); }
@@ -63,6 +74,8 @@ protected:
 
 private:
     void updateItemsPositions();
+    void pushDelta(DeltaType type, int slot, const ItemPtr& item);
+    void flushDeltas();
 
     int m_id;
     int m_capacity;
@@ -75,6 +88,10 @@ private:
     int m_size;
     int m_firstIndex;
     std::deque<ItemPtr> m_items;
+
+    bool m_deltaMode{ false };
+    bool m_deltaFlushPending{ false };
+    std::vector<std::tuple<uint8, int, ItemPtr>> m_deltas;
 };
 
 #endif
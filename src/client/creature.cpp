@@ -21,23 +21,28 @@
  */
 
 #include "creature.h"
+#include "creatureoverlay.h"
 #include "effect.h"
 #include "game.h"
+#include "gamestateexport.h"
 #include "item.h"
 #include "lightview.h"
 #include "localplayer.h"
 #include "luavaluecasts.h"
 #include "map.h"
+#include "spectatortracker.h"
 #include "thingtypemanager.h"
 #include "tile.h"
 
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/luaengine/luaeventbatch.h>
 #include <framework/graphics/graphics.h>
 #include <framework/graphics/drawpool.h>
 
 #include <framework/graphics/framebuffermanager.h>
 #include <framework/graphics/paintershaderprogram.h>
+#include <framework/graphics/textureatlas.h>
 #include <framework/graphics/texturemanager.h>
 #include <framework/graphics/ogl/painterogl2_shadersources.h>
 #include "spritemanager.h"
@@ -76,7 +81,9 @@ void Creature::draw(const Point& dest, float scaleFactor, bool animate, const Hi
     if(!canBeSeen())
         return;
 
-    if(frameFlags & Otc::FUpdateThing) {
+    if(frameFlags & Otc::FUpdateThing && frameFlags & Otc::FSimplifyCreature) {
+        internalDrawOutfit(dest + m_walkOffset * scaleFactor, scaleFactor, false, textureType, m_direction, color, true);
+    } else if(frameFlags & Otc::FUpdateThing) {
         if(m_showTimedSquare) {
             g_drawPool.addBoundingRect(Rect(dest + (m_walkOffset - getDisplacement() + 2) * scaleFactor, Size(28 * scaleFactor)), m_timedSquareColor, std::max<int>(static_cast<int>(2 * scaleFactor), 1));
         }
@@ -110,14 +117,14 @@ void Creature::draw(const Point& dest, float scaleFactor, bool animate, const Hi
     }
 }
 
-void Creature::internalDrawOutfit(Point dest, float scaleFactor, bool animateWalk, TextureType textureType, Otc::Direction direction, Color color)
+void Creature::internalDrawOutfit(Point dest, float scaleFactor, bool animateWalk, TextureType textureType, Otc::Direction direction, Color color, bool simplified)
 {
     if(m_outfitColor != Color::white)
         color = m_outfitColor;
 
     const bool isNotBlank = textureType != TextureType::ALL_BLANK;
 
-    const auto& canDrawShader = isNotBlank && g_painter->hasShaders() && g_graphics.shouldUseShaders();
+    const auto& canDrawShader = isNotBlank && !simplified && g_painter->hasShaders() && g_graphics.shouldUseShaders();
     // outfit is a real creature
     if(m_outfit.getCategory() == ThingCategoryCreature) {
         int animationPhase = 0;
@@ -132,7 +139,7 @@ void Creature::internalDrawOutfit(Point dest, float scaleFactor, bool animateWal
             xPattern = direction;
 
         int zPattern = 0;
-        if(m_outfit.hasMount()) {
+        if(m_outfit.hasMount() && !simplified) {
             if(animateWalk) animationPhase = getCurrentAnimationPhase(true);
 
             const auto& datType = rawGetMountThingType();
@@ -157,12 +164,26 @@ void Creature::internalDrawOutfit(Point dest, float scaleFactor, bool animateWal
 
         auto* datType = rawGetThingType();
 
+        // the painter tints the base frame with the packed mask in the same quad, custom outfit shaders
+        // only know the base texture so they keep the multiplied mask quads
+        const bool drawOutfitColor = m_drawOutfitColor && isNotBlank && !simplified && getLayers() > 1;
+        const bool drawMasked = drawOutfitColor && g_painter->canDrawOutfitMasks() && !(canDrawShader && m_outfitShader);
+        const std::array<uint32, 4> maskColors{
+            PackedOutfitVertex::packColor(m_outfit.getHeadColor()), PackedOutfitVertex::packColor(m_outfit.getBodyColor()),
+            PackedOutfitVertex::packColor(m_outfit.getLegsColor()), PackedOutfitVertex::packColor(m_outfit.getFeetColor())
+        };
+
         // yPattern => creature addon
         for(int yPattern = 0; yPattern < getNumPatternY(); ++yPattern) {
             // continue if we dont have this addon
-            if(yPattern > 0 && !(m_outfit.getAddons() & (1 << (yPattern - 1))))
+            if(yPattern > 0 && (simplified || !(m_outfit.getAddons() & (1 << (yPattern - 1)))))
                 continue;
 
+            if(drawMasked) {
+                datType->drawMasked(dest, scaleFactor, xPattern, yPattern, zPattern, animationPhase, textureType, maskColors, color);
+                continue;
+            }
+
             datType->draw(dest, scaleFactor, 0, xPattern, yPattern, zPattern, animationPhase, textureType, color);
             if(canDrawShader && m_outfitShader) {
                 m_outfitShader->bind();
@@ -170,7 +191,7 @@ void Creature::internalDrawOutfit(Point dest, float scaleFactor, bool animateWal
                 g_drawPool.setShaderProgram(m_outfitShader, g_drawPool.size());
             }
 
-            if(m_drawOutfitColor && isNotBlank && getLayers() > 1) {
+            if(drawOutfitColor) {
                 g_drawPool.setCompositionMode(Painter::CompositionMode_Multiply);
                 datType->draw(dest, scaleFactor, SpriteMaskYellow, xPattern, yPattern, zPattern, animationPhase, textureType, m_outfit.getHeadColor());
                 datType->draw(dest, scaleFactor, SpriteMaskRed, xPattern, yPattern, zPattern, animationPhase, textureType, m_outfit.getBodyColor());
@@ -277,16 +298,17 @@ void Creature::drawInformation(const Rect& parentRect, const Point& dest, float
     Rect healthRect = backgroundRect.expanded(-1);
     healthRect.setWidth((m_healthPercent / 100.0) * 25);
 
+    // collected here and drawn by kind for all creatures at once, see CreatureOverlay
     if(drawFlags & Otc::DrawBars) {
-        g_drawPool.addRepeatedFilledRect(backgroundRect, Color::black);
-        g_drawPool.addRepeatedFilledRect(healthRect, fillColor);
+        g_creatureOverlay.addBar(backgroundRect, Color::black);
+        g_creatureOverlay.addBar(healthRect, fillColor);
 
         if(drawFlags & Otc::DrawManaBar && isLocalPlayer()) {
             LocalPlayerPtr player = g_game.getLocalPlayer();
             if(player) {
                 backgroundRect.moveTop(backgroundRect.bottom());
 
-                g_drawPool.addRepeatedFilledRect(backgroundRect, Color::black);
+                g_creatureOverlay.addBar(backgroundRect, Color::black);
 
                 Rect manaRect = backgroundRect.expanded(-1);
                 const double maxMana = player->getMaxMana();
@@ -296,34 +318,34 @@ void Creature::drawInformation(const Rect& parentRect, const Point& dest, float
                     manaRect.setWidth(player->getMana() / (maxMana * 1.0) * 25);
                 }
 
-                g_drawPool.addRepeatedFilledRect(manaRect, Color::blue);
+                g_creatureOverlay.addBar(manaRect, Color::blue);
             }
         }
     }
 
     if(drawFlags & Otc::DrawNames) {
-        m_nameCache.draw(textRect, fillColor);
+        g_creatureOverlay.addName(&m_nameCache, textRect, fillColor);
     }
 
-    if(m_skull != Otc::SkullNone && m_skullTexture) {
-        const auto skullRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 5, m_skullTexture->getSize());
-        g_drawPool.addRepeatedTexturedRect(skullRect, m_skullTexture);
+    if(m_skull != Otc::SkullNone && m_skullIcon) {
+        const auto skullRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 5, m_skullIcon->getRect().size());
+        g_creatureOverlay.addIcon(skullRect, m_skullIcon);
     }
-    if(m_shield != Otc::ShieldNone && m_shieldTexture && m_showShieldTexture) {
-        const auto shieldRect = Rect(backgroundRect.x() + 13.5, backgroundRect.y() + 5, m_shieldTexture->getSize());
-        g_drawPool.addRepeatedTexturedRect(shieldRect, m_shieldTexture);
+    if(m_shield != Otc::ShieldNone && m_shieldIcon && m_showShieldTexture) {
+        const auto shieldRect = Rect(backgroundRect.x() + 13.5, backgroundRect.y() + 5, m_shieldIcon->getRect().size());
+        g_creatureOverlay.addIcon(shieldRect, m_shieldIcon);
     }
-    if(m_emblem != Otc::EmblemNone && m_emblemTexture) {
-        const auto emblemRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 16, m_emblemTexture->getSize());
-        g_drawPool.addRepeatedTexturedRect(emblemRect, m_emblemTexture);
+    if(m_emblem != Otc::EmblemNone && m_emblemIcon) {
+        const auto emblemRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 16, m_emblemIcon->getRect().size());
+        g_creatureOverlay.addIcon(emblemRect, m_emblemIcon);
     }
-    if(m_type != Proto::CreatureTypeUnknown && m_typeTexture) {
-        const auto typeRect = Rect(backgroundRect.x() + 13.5 + 12 + 12, backgroundRect.y() + 16, m_typeTexture->getSize());
-        g_drawPool.addRepeatedTexturedRect(typeRect, m_typeTexture);
+    if(m_type != Proto::CreatureTypeUnknown && m_typeIcon) {
+        const auto typeRect = Rect(backgroundRect.x() + 13.5 + 12 + 12, backgroundRect.y() + 16, m_typeIcon->getRect().size());
+        g_creatureOverlay.addIcon(typeRect, m_typeIcon);
     }
-    if(m_icon != Otc::NpcIconNone && m_iconTexture) {
-        const auto iconRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 5, m_iconTexture->getSize());
-        g_drawPool.addRepeatedTexturedRect(iconRect, m_iconTexture);
+    if(m_icon != Otc::NpcIconNone && m_npcIcon) {
+        const auto iconRect = Rect(backgroundRect.x() + 13.5 + 12, backgroundRect.y() + 5, m_npcIcon->getRect().size());
+        g_creatureOverlay.addIcon(iconRect, m_npcIcon);
     }
 }
 
@@ -358,10 +380,7 @@ void Creature::walk(const Position& oldPos, const Position& newPos)
     // no direction need to be changed when the walk ends
     m_walkTurnDirection = Otc::InvalidDirection;
 
-    if(m_walkFinishAnimEvent) {
-        m_walkFinishAnimEvent->cancel();
-        m_walkFinishAnimEvent = nullptr;
-    }
+    stopAnimation(AnimationWalkFinish);
 
     // starts updating walk
     nextWalkUpdate();
@@ -385,14 +404,15 @@ void Creature::jump(int height, int duration)
     m_jumpHeight = height;
     m_jumpDuration = duration;
 
-    updateJump();
+    if(updateJump())
+        startAnimation(AnimationJump);
 }
 
-void Creature::updateJump()
+bool Creature::updateJump()
 {
     if(m_jumpTimer.ticksElapsed() >= m_jumpDuration) {
         m_jumpOffset = PointF(0, 0);
-        return;
+        return false;
     }
 
     const int t = m_jumpTimer.ticksElapsed();
@@ -400,42 +420,63 @@ void Creature::updateJump()
     const double b = +4 * m_jumpHeight / m_jumpDuration;
 
     const double height = a * t * t + b * t;
-    const int roundHeight = stdext::round(height);
-    const int halfJumpDuration = m_jumpDuration / 2;
-
     m_jumpOffset = PointF(height, height);
 
     if(isLocalPlayer()) {
         g_map.notificateCameraMove(m_walkOffset);
     }
+    return true;
+}
+
+void Creature::startAnimation(uint8 animation)
+{
+    m_animations |= animation;
+    if(m_animationSlot < 0)
+        g_map.addAnimatedCreature(static_self_cast<Creature>());
+}
 
-    int diff = 0;
-    if(m_jumpTimer.ticksElapsed() < halfJumpDuration)
-        diff = 1;
-    else if(m_jumpTimer.ticksElapsed() > halfJumpDuration)
-        diff = -1;
+void Creature::updateAnimations()
+{
+    if(m_animations & AnimationWalk) {
+        updateWalk();
+        if(isLocalPlayer())
+            g_map.notificateCameraMove(m_walkOffset);
+        if(!m_walking)
+            stopAnimation(AnimationWalk);
+    }
 
-    int nextT, i = 1;
-    do {
-        nextT = stdext::round((-b + std::sqrt(std::max<double>(b * b + 4 * a * (roundHeight + diff * i), 0.0)) * diff) / (2 * a));
-        ++i;
+    if((m_animations & AnimationWalkFinish) && g_clock.millis() >= m_walkFinishTicks) {
+        m_walkAnimationPhase = 0;
+        stopAnimation(AnimationWalkFinish);
+    }
 
-        if(nextT < halfJumpDuration)
-            diff = 1;
-        else if(nextT > halfJumpDuration)
-            diff = -1;
-    } while(nextT - m_jumpTimer.ticksElapsed() == 0 && i < 3);
+    if((m_animations & AnimationJump) && !updateJump())
+        stopAnimation(AnimationJump);
 
-    // schedules next update
-    const auto self = static_self_cast<Creature>();
-    g_dispatcher.scheduleEvent([self] {
-        self->updateJump();
-    }, nextT - m_jumpTimer.ticksElapsed());
+    if((m_animations & AnimationOutfitColor) && !updateOutfitColor())
+        stopAnimation(AnimationOutfitColor);
 }
 
 void Creature::onPositionChange(const Position& newPos, const Position& oldPos)
 {
     callLuaField("onPositionChange", newPos, oldPos);
+    g_spectatorTracker.onCreatureMove(static_self_cast<Creature>(), newPos, oldPos);
+    g_gameStateExport.onCreatureChange(static_self_cast<Creature>());
+
+    static const int batchChannel = g_eventBatch.registerChannel("onCreaturePositionChange");
+    if(g_eventBatch.isSubscribed(batchChannel))
+        g_eventBatch.push(batchChannel, static_self_cast<Creature>(), newPos, oldPos);
+}
+
+void Creature::notifyAppear()
+{
+    callLuaField("onAppear");
+    g_spectatorTracker.onCreatureChange(static_self_cast<Creature>());
+    g_gameStateExport.onCreatureChange(static_self_cast<Creature>());
+
+    static const int batchChannel = g_eventBatch.registerChannel("onCreatureAppear");
+    if(g_eventBatch.isSubscribed(batchChannel))
+        g_eventBatch.push(batchChannel, static_self_cast<Creature>());
 }
 
 void Creature::onAppear()
@@ -454,7 +495,7 @@ void Creature::onAppear()
     if(m_removed) {
         stopWalk();
         m_removed = false;
-        callLuaField("onAppear");
+        notifyAppear();
     } // walk
     else if(m_oldPosition != m_position && m_oldPosition.isInRange(m_position, 1, 1) && m_allowAppearWalk) {
         m_allowAppearWalk = false;
@@ -464,7 +505,7 @@ void Creature::onAppear()
     else if(m_oldPosition != m_position) {
         stopWalk();
         callLuaField("onDisappear");
-        callLuaField("onAppear");
+        notifyAppear();
     } // else turn
 }
 
@@ -483,6 +524,8 @@ void Creature::onDisappear()
         self->stopWalk();
 
         self->callLuaField("onDisappear");
+        g_spectatorTracker.onCreatureRemove(self);
+        g_gameStateExport.onCreatureRemove(self);
 
         // invalidate this creature position
         if(!self->isLocalPlayer())
@@ -568,24 +611,15 @@ void Creature::updateWalkingTile()
 
 void Creature::nextWalkUpdate()
 {
-    // remove any previous scheduled walk updates
-    if(m_walkUpdateEvent)
-        m_walkUpdateEvent->cancel();
-
     // do the update
     updateWalk();
     if(isLocalPlayer()) {
         g_map.notificateCameraMove(m_walkOffset);
     }
 
-    if(!m_walking) return;
-
-    // schedules next update
-    auto self = static_self_cast<Creature>();
-    m_walkUpdateEvent = g_dispatcher.scheduleEvent([self] {
-        self->m_walkUpdateEvent = nullptr;
-        self->nextWalkUpdate();
-    }, m_stepCache.duration / Otc::TILE_PIXELS);
+    // following updates come from the animation ticker
+    if(m_walking)
+        startAnimation(AnimationWalk);
 }
 
 void Creature::updateWalk(const bool isPreWalking)
@@ -616,11 +650,8 @@ void Creature::updateWalk(const bool isPreWalking)
 
 void Creature::terminateWalk()
 {
-    // remove any scheduled walk update
-    if(m_walkUpdateEvent) {
-        m_walkUpdateEvent->cancel();
-        m_walkUpdateEvent = nullptr;
-    }
+    // stop the walk updates
+    stopAnimation(AnimationWalk);
 
     // now the walk has ended, do any scheduled turn
     if(m_walkTurnDirection != Otc::InvalidDirection) {
@@ -637,17 +668,20 @@ void Creature::terminateWalk()
     m_walkOffset = Point();
     m_walking = false;
 
-    const auto self = static_self_cast<Creature>();
-    m_walkFinishAnimEvent = g_dispatcher.scheduleEvent([self] {
-        self->m_walkAnimationPhase = 0;
-        self->m_walkFinishAnimEvent = nullptr;
-    }, g_game.getServerBeat());
+    // the walk animation phase is reset one server beat later, unless another step starts first
+    m_walkFinishTicks = g_clock.millis() + g_game.getServerBeat();
+    startAnimation(AnimationWalkFinish);
 }
 
 void Creature::setName(const std::string& name)
 {
+    if(name == m_name)
+        return;
+
     m_nameCache.setText(name);
     m_name = name;
+    g_spectatorTracker.onCreatureChange(static_self_cast<Creature>());
+    g_gameStateExport.onCreatureChange(static_self_cast<Creature>());
 }
 
 void Creature::setHealthPercent(uint8 healthPercent)
@@ -670,6 +704,12 @@ void Creature::setHealthPercent(uint8 healthPercent)
     const uint8 oldHealthPercent = m_healthPercent;
     m_healthPercent = healthPercent;
     callLuaField("onHealthPercentChange", healthPercent, oldHealthPercent);
+    g_spectatorTracker.onCreatureChange(static_self_cast<Creature>());
+    g_gameStateExport.onCreatureChange(static_self_cast<Creature>());
+
+    static const int batchChannel = g_eventBatch.registerChannel("onCreatureHealthPercentChange");
+    if(g_eventBatch.isSubscribed(batchChannel))
+        g_eventBatch.push(batchChannel, static_self_cast<Creature>(), healthPercent, oldHealthPercent);
 
     if(healthPercent <= 0)
         onDeath();
@@ -684,6 +724,7 @@ void Creature::setDirection(Otc::Direction direction)
 void Creature::setOutfit(const Outfit& outfit)
 {
     const Outfit oldOutfit = m_outfit;
+    const bool wasInvisible = isInvisible();
     if(outfit.getCategory() != ThingCategoryCreature) {
         if(!g_things.isValidDatId(outfit.getAuxId(), outfit.getCategory()))
             return;
@@ -698,6 +739,12 @@ void Creature::setOutfit(const Outfit& outfit)
     }
 
     callLuaField("onOutfitChange", m_outfit, oldOutfit);
+    if(isInvisible() != wasInvisible)
+        g_spectatorTracker.onCreatureChange(static_self_cast<Creature>());
+
+    // a cached creature sent again usually keeps its outfit
+    if(m_outfit == oldOutfit && m_drawCache.exactSize > 0)
+        return;
 
     // Cache
     {
@@ -712,34 +759,31 @@ void Creature::setOutfit(const Outfit& outfit)
 
 void Creature::setOutfitColor(const Color& color, int duration)
 {
-    if(m_outfitColorUpdateEvent) {
-        m_outfitColorUpdateEvent->cancel();
-        m_outfitColorUpdateEvent = nullptr;
-    }
+    stopAnimation(AnimationOutfitColor);
 
     if(duration <= 0) {
         m_outfitColor = color;
         return;
     }
 
-    const Color delta = (color - m_outfitColor) / static_cast<float>(duration);
+    m_outfitColorFrom = m_outfitColor;
+    m_outfitColorTo = color;
+    m_outfitColorDelta = (color - m_outfitColor) / static_cast<float>(duration);
+    m_outfitColorDuration = duration;
     m_outfitColorTimer.restart();
-    updateOutfitColor(m_outfitColor, color, delta, duration);
+    if(updateOutfitColor())
+        startAnimation(AnimationOutfitColor);
 }
 
-void Creature::updateOutfitColor(Color color, Color finalColor, Color delta, int duration)
+bool Creature::updateOutfitColor()
 {
-    if(m_outfitColorTimer.ticksElapsed() >= duration) {
-        m_outfitColor = finalColor;
-        return;
+    if(m_outfitColorTimer.ticksElapsed() >= m_outfitColorDuration) {
+        m_outfitColor = m_outfitColorTo;
+        return false;
     }
 
-    m_outfitColor = color + delta * m_outfitColorTimer.ticksElapsed();
-
-    const auto self = static_self_cast<Creature>();
-    m_outfitColorUpdateEvent = g_dispatcher.scheduleEvent([=] {
-        self->updateOutfitColor(color, finalColor, delta, duration);
-    }, 100);
+    m_outfitColor = m_outfitColorFrom + m_outfitColorDelta * m_outfitColorTimer.ticksElapsed();
+    return true;
 }
 
 void Creature::setSpeed(uint16 speed)
@@ -778,12 +822,15 @@ void Creature::setSkull(uint8 skull)
 {
     m_skull = skull;
     callLuaField("onSkullChange", m_skull);
+    g_spectatorTracker.onCreatureChange(static_self_cast<Creature>());
+    g_gameStateExport.onCreatureChange(static_self_cast<Creature>());
 }
 
 void Creature::setShield(uint8 shield)
 {
     m_shield = shield;
     callLuaField("onShieldChange", m_shield);
+    g_spectatorTracker.onCreatureChange(static_self_cast<Creature>());
 }
 
 void Creature::setEmblem(uint8 emblem)
@@ -806,12 +853,12 @@ void Creature::setIcon(uint8 icon)
 
 void Creature::setSkullTexture(const std::string& filename)
 {
-    m_skullTexture = g_textures.getTexture(filename);
+    m_skullIcon = g_creatureOverlay.getIcon(filename);
 }
 
 void Creature::setShieldTexture(const std::string& filename, bool blink)
 {
-    m_shieldTexture = g_textures.getTexture(filename);
+    m_shieldIcon = g_creatureOverlay.getIcon(filename);
     m_showShieldTexture = true;
 
     if(blink && !m_shieldBlink) {
@@ -826,17 +873,17 @@ void Creature::setShieldTexture(const std::string& filename, bool blink)
 
 void Creature::setEmblemTexture(const std::string& filename)
 {
-    m_emblemTexture = g_textures.getTexture(filename);
+    m_emblemIcon = g_creatureOverlay.getIcon(filename);
 }
 
 void Creature::setTypeTexture(const std::string& filename)
 {
-    m_typeTexture = g_textures.getTexture(filename);
+    m_typeIcon = g_creatureOverlay.getIcon(filename);
 }
 
 void Creature::setIconTexture(const std::string& filename)
 {
-    m_iconTexture = g_textures.getTexture(filename);
+    m_npcIcon = g_creatureOverlay.getIcon(filename);
 }
 
 void Creature::addTimedSquare(uint8 color)
@@ -32,9 +32,10 @@
 #include "outfit.h"
 #include "thing.h"
 #include "tile.h"
+#include <framework/core/stats.h>
 
  // @bindclass
-class Creature : public Thing
+class Creature : public Thing, private StatsCounted<Creature>
 {
 public:
     enum {
@@ -50,7 +51,8 @@ public:
 
     virtual void draw(const Point& dest, float scaleFactor, bool animate, const Highlight& highLight, TextureType textureType, Color color, int frameFlags, LightView* lightView = nullptr) override;
 
-    void internalDrawOutfit(Point dest, float scaleFactor, bool animateWalk, TextureType textureType, Otc::Direction direction, Color color);
+    // simplified outfits are one standing frame of the base outfit, without addons, mount, colors or shader
+    void internalDrawOutfit(Point dest, float scaleFactor, bool animateWalk, TextureType textureType, Otc::Direction direction, Color color, bool simplified = false);
 
     void drawOutfit(const Rect& destRect, bool resize, const Color color = Color::white);
     void drawInformation(const Rect& parentRect, const Point& dest, float scaleFactor, Point drawOffset, const float horizontalStretchFactor, const float verticalStretchFactor, int drawFlags);
@@ -104,6 +106,8 @@ public:
     uint64 getStepDuration(bool ignoreDiagonal = false, Otc::Direction dir = Otc::InvalidDirection);
     Point getDrawOffset();
     Point getWalkOffset() { return m_walkOffset; }
+    // offset of the camera following this creature
+    virtual Point getCameraOffset() { return m_walkOffset; }
     PointF getJumpOffset() { return m_jumpOffset; }
     Position getLastStepFromPosition() { return m_lastStepFromPosition; }
     Position getLastStepToPosition() { return m_lastStepToPosition; }
@@ -147,7 +151,24 @@ public:
 
     int getWalkedPixel() const { return m_walkedPixels; }
 
+    // running animations are advanced by Map::updateAnimatedCreatures once per frame
+    virtual void updateAnimations();
+    bool isAnimating() { return m_animations != 0; }
+    int getAnimationSlot() { return m_animationSlot; }
+    void setAnimationSlot(int slot) { m_animationSlot = slot; }
+
 protected:
+    enum AnimationFlag : uint8 {
+        AnimationWalk = 1 << 0,
+        AnimationWalkFinish = 1 << 1,
+        AnimationJump = 1 << 2,
+        AnimationOutfitColor = 1 << 3,
+        AnimationCameraCorrection = 1 << 4
+    };
+
+    void startAnimation(uint8 animation);
+    void stopAnimation(uint8 animation) { m_animations &= ~animation; }
+
     void updateWalkingTile();
     virtual void updateWalkAnimation();
     virtual void updateWalkOffset(int totalPixelsWalked);
@@ -155,8 +176,9 @@ protected:
     virtual void nextWalkUpdate();
     virtual void terminateWalk();
 
-    void updateOutfitColor(Color color, Color finalColor, Color delta, int duration);
-    void updateJump();
+    bool updateOutfitColor();
+    bool updateJump();
+    void notifyAppear();
 
     uint32 m_id;
     std::string m_name;
@@ -174,11 +196,11 @@ protected:
     uint8 m_emblem;
     uint8 m_type;
     uint8 m_icon;
-    TexturePtr m_skullTexture;
-    TexturePtr m_shieldTexture;
-    TexturePtr m_emblemTexture;
-    TexturePtr m_typeTexture;
-    TexturePtr m_iconTexture;
+    AtlasRegionPtr m_skullIcon;
+    AtlasRegionPtr m_shieldIcon;
+    AtlasRegionPtr m_emblemIcon;
+    AtlasRegionPtr m_typeIcon;
+    AtlasRegionPtr m_npcIcon;
     stdext::boolean<true> m_showShieldTexture;
     stdext::boolean<false> m_shieldBlink;
     stdext::boolean<false> m_passable;
@@ -191,7 +213,10 @@ protected:
     Color m_informationColor;
     Color m_outfitColor;
     CachedText m_nameCache;
-    ScheduledEventPtr m_outfitColorUpdateEvent;
+    Color m_outfitColorFrom;
+    Color m_outfitColorTo;
+    Color m_outfitColorDelta;
+    int m_outfitColorDuration;
     Timer m_outfitColorTimer;
 
     std::array<double, Otc::LastSpeedFormula> m_speedFormula;
@@ -205,8 +230,7 @@ protected:
     TilePtr m_walkingTile;
     stdext::boolean<false> m_walking;
     stdext::boolean<false> m_allowAppearWalk;
-    ScheduledEventPtr m_walkUpdateEvent;
-    ScheduledEventPtr m_walkFinishAnimEvent;
+    ticks_t m_walkFinishTicks;
     EventPtr m_disappearEvent;
     Point m_walkOffset;
     Otc::Direction m_walkTurnDirection;
@@ -221,9 +245,12 @@ protected:
     PointF m_jumpOffset;
     Timer m_jumpTimer;
 
+    uint8 m_animations{ 0 };
+    int m_animationSlot{ -1 };
+
 private:
     struct DrawCache {
-        int exactSize, frameSizeNotResized;
+        int exactSize = 0, frameSizeNotResized = 0;
     };
 
     struct StepCache {
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "creatureoverlay.h"
+#include <framework/core/resourcemanager.h>
+#include <framework/graphics/cachedtext.h>
+#include <framework/graphics/drawpool.h>
+#include <framework/graphics/image.h>
+#include <framework/graphics/textureatlas.h>
+#include <framework/graphics/texturemanager.h>
+
+CreatureOverlay g_creatureOverlay;
+
+void CreatureOverlay::terminate()
+{
+    m_bars.clear();
+    m_icons.clear();
+    m_names.clear();
+    m_iconRegions.clear();
+}
+
+void CreatureOverlay::draw()
+{
+    for(const auto& bar : m_bars)
+        g_drawPool.addRepeatedFilledRect(bar.first, bar.second);
+
+    for(const auto& icon : m_icons)
+        g_drawPool.addTexturedRect(icon.first, icon.second->getTexture(), icon.second->getRect());
+
+    for(const Name& name : m_names)
+        name.text->draw(name.rect, name.color);
+
+    m_bars.clear();
+    m_icons.clear();
+    m_names.clear();
+}
+
+const AtlasRegionPtr& CreatureOverlay::getIcon(const std::string& fileName)
+{
+    const std::string filePath = g_resources.resolvePath(fileName);
+    AtlasRegionPtr& region = m_iconRegions[filePath];
+    if(region)
+        return region;
+
+    const ImagePtr image = Image::load(filePath);
+    if(image && image->getBpp() == 4)
+        region = g_atlas.allocate(image);
+
+    // animated or oversized icons keep a texture of their own
+    if(!region) {
+        const TexturePtr texture = g_textures.getTexture(filePath);
+        region = g_atlas.createStandalone(texture ? texture : g_textures.getEmptyTexture());
+    }
+
+    region->setPinned(true);
+    return region;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef CREATUREOVERLAY_H
+#define CREATUREOVERLAY_H
+
+#include "declarations.h"
+#include <framework/graphics/declarations.h>
+#include <framework/util/color.h>
+
+// names, bars and icons of the creatures on screen, collected while the creatures are walked and then added
+// one kind at a time. Bars are untextured, icons live on the atlas pages and names use fonts that are already
+// there, so each pass is a single batch however many creatures are shown
+class CreatureOverlay
+{
+public:
+    void terminate();
+
+    void addBar(const Rect& rect, const Color& color) { m_bars.push_back({ rect, color }); }
+    void addIcon(const Rect& rect, const AtlasRegionPtr& icon) { m_icons.push_back({ rect, icon }); }
+    // the text must live until draw, the creatures are held by the map view until then
+    void addName(CachedText* text, const Rect& rect, const Color& color) { m_names.push_back({ text, rect, color }); }
+
+    // adds everything collected to the current draw pool and starts over
+    void draw();
+
+    // icons are kept for the whole session, there are only a few dozen of them
+    const AtlasRegionPtr& getIcon(const std::string& fileName);
+
+private:
+    struct Name {
+        CachedText* text;
+        Rect rect;
+        Color color;
+    };
+
+    std::vector<std::pair<Rect, Color>> m_bars;
+    std::vector<std::pair<Rect, AtlasRegionPtr>> m_icons;
+    std::vector<Name> m_names;
+    std::unordered_map<std::string, AtlasRegionPtr> m_iconRegions;
+};
+
+extern CreatureOverlay g_creatureOverlay;
+
+#endif
@@ -24,6 +24,7 @@
 #include "creature.h"
 #include "map.h"
 
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/xml/tinyxml.h>
 
@@ -40,6 +41,11 @@ static bool isInZone(const Position& pos/* placePos*/,
             (pos.y >= centerPos.y - radius) && (pos.y <= centerPos.y + radius));
 }
 
+static uint32 getSpawnBlockKey(int x, int y)
+{
+    return (static_cast<uint32>(x / BLOCK_SIZE) << 16) | static_cast<uint32>(y / BLOCK_SIZE);
+}
+
 void CreatureManager::terminate()
 {
     clearSpawns();
@@ -47,22 +53,36 @@ void CreatureManager::terminate()
     m_nullCreature = nullptr;
 }
 
-void Spawn::load(TiXmlElement* node)
+void Spawn::setRadius(int32 r)
+{
+    m_attribs.set(SpawnAttrRadius, r);
+    g_creatures.invalidateSpawnIndex(getCenterPos(), this);
+}
+
+void Spawn::setCenterPos(const Position& pos)
+{
+    g_creatures.invalidateSpawnIndex(getCenterPos(), this);
+    m_attribs.set(SpawnAttrCenter, pos);
+}
+
+void Spawn::load(XmlReader& reader)
 {
     Position centerPos;
-    centerPos.x = node->readType<int>("centerx");
-    centerPos.y = node->readType<int>("centery");
-    centerPos.z = node->readType<int>("centerz");
+    centerPos.x = reader.readAttribute<int>("centerx");
+    centerPos.y = reader.readAttribute<int>("centery");
+    centerPos.z = reader.readAttribute<int>("centerz");
 
     setCenterPos(centerPos);
-    setRadius(node->readType<int32>("radius"));
+    setRadius(reader.readAttribute<int32>("radius"));
 
     CreatureTypePtr cType(nullptr);
-    for(TiXmlElement* cNode = node->FirstChildElement(); cNode; cNode = cNode->NextSiblingElement()) {
-        if(cNode->ValueStr() != "monster" && cNode->ValueStr() != "npc")
-            stdext::throw_exception(stdext::format("invalid spawn-subnode %s", cNode->ValueStr()));
+    const int depth = reader.getDepth();
+    while(reader.nextChild(depth)) {
+        const bool npc = reader.isName("npc");
+        if(!npc && !reader.isName("monster"))
+            stdext::throw_exception(stdext::format("invalid spawn-subnode %s", std::string(reader.getName())));
 
-        std::string cName = cNode->Attribute("name");
+        std::string cName = reader.getAttribute("name");
         stdext::tolower(cName);
         stdext::trim(cName);
         stdext::ucwords(cName);
@@ -70,19 +90,19 @@ void Spawn::load(TiXmlElement* node)
         if(!(cType = g_creatures.getCreatureByName(cName)))
             continue;
 
-        cType->setSpawnTime(cNode->readType<int>("spawntime"));
+        cType->setSpawnTime(reader.readAttribute<int>("spawntime"));
         Otc::Direction dir = Otc::North;
-        int16 dir_ = cNode->readType<int16>("direction");
+        int16 dir_ = reader.readAttribute<int16>("direction");
         if(dir_ >= Otc::East && dir_ <= Otc::West)
             dir = static_cast<Otc::Direction>(dir_);
         cType->setDirection(dir);
 
         Position placePos;
-        placePos.x = centerPos.x + cNode->readType<int>("x");
-        placePos.y = centerPos.y + cNode->readType<int>("y");
-        placePos.z = cNode->readType<int>("z");
+        placePos.x = centerPos.x + reader.readAttribute<int>("x");
+        placePos.y = centerPos.y + reader.readAttribute<int>("y");
+        placePos.z = reader.readAttribute<int>("z");
 
-        cType->setRace(cNode->ValueStr() == "npc" ? CreatureRaceNpc : CreatureRaceMonster);
+        cType->setRace(npc ? CreatureRaceNpc : CreatureRaceMonster);
         addCreature(placePos, cType);
     }
 }
@@ -177,34 +197,33 @@ void CreatureManager::clearSpawns()
     for(const auto& pair : m_spawns)
         pair.second->clear();
     m_spawns.clear();
+    m_spawnBlocks.clear();
+    m_unboundedSpawns.clear();
+    m_spawnIndexDirty = false;
 }
 
 void CreatureManager::loadMonsters(const std::string& file)
 {
-    TiXmlDocument doc;
-    doc.Parse(g_resources.readFileContents(file).c_str());
-    if(doc.Error())
-        stdext::throw_exception(stdext::format("cannot open monsters file '%s': '%s'", file, doc.ErrorDesc()));
-
-    TiXmlElement* root = doc.FirstChildElement();
-    if(!root || root->ValueStr() != "monsters")
+    XmlReader reader(g_resources.readFileContents(file), file);
+    if(reader.next() != XmlReader::StartElement || !reader.isName("monsters"))
         stdext::throw_exception("malformed monsters xml file");
 
-    for(TiXmlElement* monster = root->FirstChildElement(); monster; monster = monster->NextSiblingElement()) {
-        std::string fname = file.substr(0, file.find_last_of('/')) + '/' + monster->Attribute("file");
+    std::vector<std::string> files;
+    while(reader.nextChild(1)) {
+        std::string fname = file.substr(0, file.find_last_of('/')) + '/' + reader.getAttribute("file");
         if(fname.substr(fname.length() - 4) != ".xml")
             fname += ".xml";
 
-        loadSingleCreature(fname);
+        files.push_back(fname);
     }
 
-    doc.Clear();
+    loadCreatureFiles(files);
     m_loaded = true;
 }
 
 void CreatureManager::loadSingleCreature(const std::string& file)
 {
-    loadCreatureBuffer(g_resources.readFileContents(file));
+    addCreatureType(parseCreatureBuffer(g_resources.readFileContents(file), file));
 }
 
 void CreatureManager::loadNpcs(const std::string& folder)
@@ -216,9 +235,28 @@ void CreatureManager::loadNpcs(const std::string& folder)
     if(!g_resources.directoryExists(tmp))
         stdext::throw_exception(stdext::format("NPCs folder '%s' was not found.", folder));
 
-    const auto& fileList = g_resources.listDirectoryFiles(tmp);
-    for(const std::string& file : fileList)
-        loadCreatureBuffer(g_resources.readFileContents(tmp + file));
+    std::vector<std::string> files;
+    for(const std::string& file : g_resources.listDirectoryFiles(tmp))
+        files.push_back(tmp + file);
+
+    loadCreatureFiles(files);
+}
+
+void CreatureManager::loadCreatureFiles(const std::vector<std::string>& files)
+{
+    // paths are resolved here since relative ones depend on the running script
+    std::vector<std::pair<std::string, AsyncTask<CreatureLook>>> looks;
+    looks.reserve(files.size());
+    for(const std::string& file : files) {
+        const std::string path = g_resources.resolvePath(file);
+        looks.emplace_back(path, g_asyncDispatcher.schedule([path] {
+            return parseCreatureBuffer(g_resources.readFileContents(path), path);
+        }));
+    }
+
+    // added in file order, as if they were parsed one after another
+    for(const auto& look : looks)
+        addCreatureType(look.second.get());
 }
 
 void CreatureManager::loadSpawns(const std::string& fileName)
@@ -234,24 +272,19 @@ void CreatureManager::loadSpawns(const std::string& fileName)
     }
 
     try {
-        TiXmlDocument doc;
-        doc.Parse(g_resources.readFileContents(fileName).c_str());
-        if(doc.Error())
-            stdext::throw_exception(stdext::format("cannot load spawns xml file '%s: '%s'", fileName, doc.ErrorDesc()));
-
-        TiXmlElement* root = doc.FirstChildElement();
-        if(!root || root->ValueStr() != "spawns")
+        XmlReader reader(g_resources.readFileContents(fileName), fileName);
+        if(reader.next() != XmlReader::StartElement || !reader.isName("spawns"))
             stdext::throw_exception("malformed spawns file");
 
-        for(TiXmlElement* node = root->FirstChildElement(); node; node = node->NextSiblingElement()) {
-            if(node->ValueTStr() != "spawn")
+        while(reader.nextChild(1)) {
+            if(!reader.isName("spawn"))
                 stdext::throw_exception("invalid spawn node");
 
             SpawnPtr spawn(new Spawn);
-            spawn->load(node);
-            m_spawns.insert(std::make_pair(spawn->getCenterPos(), spawn));
+            spawn->load(reader);
+            if(m_spawns.insert(std::make_pair(spawn->getCenterPos(), spawn)).second)
+                indexSpawn(spawn);
         }
-        doc.Clear();
         m_spawnLoaded = true;
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to load '%s': %s", fileName, e.what()));
@@ -285,59 +318,56 @@ void CreatureManager::saveSpawns(const std::string& fileName)
 
 void CreatureManager::loadCreatureBuffer(const std::string& buffer)
 {
-    TiXmlDocument doc;
-    doc.Parse(buffer.c_str());
-    if(doc.Error())
-        stdext::throw_exception(stdext::format("cannot load creature buffer: %s", doc.ErrorDesc()));
+    addCreatureType(parseCreatureBuffer(buffer));
+}
 
-    TiXmlElement* root = doc.FirstChildElement();
-    if(!root || (root->ValueStr() != "monster" && root->ValueStr() != "npc"))
+CreatureManager::CreatureLook CreatureManager::parseCreatureBuffer(std::string buffer, const std::string& source)
+{
+    XmlReader reader(std::move(buffer), source);
+    if(reader.next() != XmlReader::StartElement || (!reader.isName("monster") && !reader.isName("npc")))
         stdext::throw_exception("invalid root tag name");
 
-    std::string cName = root->Attribute("name");
-    stdext::tolower(cName);
-    stdext::trim(cName);
-    stdext::ucwords(cName);
+    CreatureLook look;
+    look.name = reader.getAttribute("name");
+    stdext::tolower(look.name);
+    stdext::trim(look.name);
+    stdext::ucwords(look.name);
 
-    const CreatureTypePtr newType(new CreatureType(cName));
-    for(TiXmlElement* attrib = root->FirstChildElement(); attrib; attrib = attrib->NextSiblingElement()) {
-        if(attrib->ValueStr() != "look")
+    while(reader.nextChild(1)) {
+        if(!reader.isName("look"))
             continue;
 
-        internalLoadCreatureBuffer(attrib, newType);
+        Outfit& out = look.outfit;
+        const int32 type = reader.readAttribute<int32>("type");
+        if(type > 0) {
+            out.setCategory(ThingCategoryCreature);
+            out.setId(type);
+        } else {
+            out.setCategory(ThingCategoryItem);
+            out.setAuxId(reader.readAttribute<int32>("typeex"));
+        }
+
+        out.setHead(reader.readAttribute<int>("head"));
+        out.setBody(reader.readAttribute<int>("body"));
+        out.setLegs(reader.readAttribute<int>("legs"));
+        out.setFeet(reader.readAttribute<int>("feet"));
+        out.setAddons(reader.readAttribute<int>("addons"));
+        out.setMount(reader.readAttribute<int>("mount"));
+        look.valid = true;
         break;
     }
 
-    doc.Clear();
+    return look;
 }
 
-void CreatureManager::internalLoadCreatureBuffer(TiXmlElement* attrib, const CreatureTypePtr& m)
+void CreatureManager::addCreatureType(const CreatureLook& look)
 {
-    if(std::find(m_creatures.begin(), m_creatures.end(), m) != m_creatures.end())
+    if(!look.valid)
         return;
 
-    Outfit out;
-
-    const int32 type = attrib->readType<int32>("type");
-    if(type > 0) {
-        out.setCategory(ThingCategoryCreature);
-        out.setId(type);
-    } else {
-        out.setCategory(ThingCategoryItem);
-        out.setAuxId(attrib->readType<int32>("typeex"));
-    }
-
-    {
-        out.setHead(attrib->readType<int>("head"));
-        out.setBody(attrib->readType<int>("body"));
-        out.setLegs(attrib->readType<int>("legs"));
-        out.setFeet(attrib->readType<int>("feet"));
-        out.setAddons(attrib->readType<int>("addons"));
-        out.setMount(attrib->readType<int>("mount"));
-    }
-
-    m->setOutfit(out);
-    m_creatures.push_back(m);
+    const CreatureTypePtr creatureType(new CreatureType(look.name));
+    creatureType->setOutfit(look.outfit);
+    m_creatures.push_back(creatureType);
 }
 
 const CreatureTypePtr& CreatureManager::getCreatureByName(std::string name)
@@ -378,14 +408,18 @@ SpawnPtr CreatureManager::getSpawn(const Position& centerPos)
 
 SpawnPtr CreatureManager::getSpawnForPlacePos(const Position& pos)
 {
-    for(const auto& pair : m_spawns) {
-        const Position& centerPos = pair.first;
-        const SpawnPtr& spawn = pair.second;
+    updateSpawnIndex();
 
-        if(isInZone(pos, centerPos, spawn->getRadius()))
-            return spawn;
+    const auto it = m_spawnBlocks.find(getSpawnBlockKey(pos.x, pos.y));
+    if(it != m_spawnBlocks.end()) {
+        for(const SpawnPtr& spawn : it->second) {
+            if(isInZone(pos, spawn->getCenterPos(), spawn->getRadius()))
+                return spawn;
+        }
     }
 
+    if(!m_unboundedSpawns.empty())
+        return m_unboundedSpawns.front();
     return nullptr;
 }
 
@@ -404,6 +438,7 @@ SpawnPtr CreatureManager::addSpawn(const Position& centerPos, int radius)
     ret->setCenterPos(centerPos);
 
     m_spawns.insert(std::make_pair(centerPos, ret));
+    indexSpawn(ret);
     return ret;
 }
 
@@ -411,8 +446,11 @@ void CreatureManager::deleteSpawn(const SpawnPtr& spawn)
 {
     const Position& centerPos = spawn->getCenterPos();
     const auto it = m_spawns.find(centerPos);
-    if(it != m_spawns.end())
+    if(it != m_spawns.end()) {
+        // the one stored at that center, the argument may only share its position
+        unindexSpawn(it->second);
         m_spawns.erase(it);
+    }
 }
 
 std::vector<SpawnPtr> CreatureManager::getSpawns()
@@ -423,4 +461,75 @@ std::vector<SpawnPtr> CreatureManager::getSpawns()
     return spawns;
 }
 
+void CreatureManager::indexSpawn(const SpawnPtr& spawn)
+{
+    if(m_spawnIndexDirty)
+        return;
+
+    const int radius = spawn->getRadius();
+    if(radius == -1) {
+        m_unboundedSpawns.push_back(spawn);
+        return;
+    }
+    if(radius < 0)
+        return;
+
+    const Position centerPos = spawn->getCenterPos();
+    const int left = std::max<int>(centerPos.x - radius, 0), right = std::min<int>(centerPos.x + radius, 65535);
+    const int top = std::max<int>(centerPos.y - radius, 0), bottom = std::min<int>(centerPos.y + radius, 65535);
+    for(int x = left / BLOCK_SIZE; x <= right / BLOCK_SIZE; ++x)
+        for(int y = top / BLOCK_SIZE; y <= bottom / BLOCK_SIZE; ++y)
+            m_spawnBlocks[getSpawnBlockKey(x * BLOCK_SIZE, y * BLOCK_SIZE)].push_back(spawn);
+}
+
+void CreatureManager::unindexSpawn(const SpawnPtr& spawn)
+{
+    if(m_spawnIndexDirty)
+        return;
+
+    const int radius = spawn->getRadius();
+    if(radius == -1) {
+        m_unboundedSpawns.erase(std::remove(m_unboundedSpawns.begin(), m_unboundedSpawns.end(), spawn), m_unboundedSpawns.end());
+        return;
+    }
+    if(radius < 0)
+        return;
+
+    const Position centerPos = spawn->getCenterPos();
+    const int left = std::max<int>(centerPos.x - radius, 0), right = std::min<int>(centerPos.x + radius, 65535);
+    const int top = std::max<int>(centerPos.y - radius, 0), bottom = std::min<int>(centerPos.y + radius, 65535);
+    for(int x = left / BLOCK_SIZE; x <= right / BLOCK_SIZE; ++x) {
+        for(int y = top / BLOCK_SIZE; y <= bottom / BLOCK_SIZE; ++y) {
+            const auto it = m_spawnBlocks.find(getSpawnBlockKey(x * BLOCK_SIZE, y * BLOCK_SIZE));
+            if(it == m_spawnBlocks.end())
+                continue;
+
+            std::vector<SpawnPtr>& spawns = it->second;
+            spawns.erase(std::remove(spawns.begin(), spawns.end(), spawn), spawns.end());
+            if(spawns.empty())
+                m_spawnBlocks.erase(it);
+        }
+    }
+}
+
+void CreatureManager::invalidateSpawnIndex(const Position& centerPos, const Spawn* spawn)
+{
+    // only stored spawns are indexed, the others are free to change until they are added
+    const auto it = m_spawns.find(centerPos);
+    if(it != m_spawns.end() && it->second.get() == spawn)
+        m_spawnIndexDirty = true;
+}
+
+void CreatureManager::updateSpawnIndex()
+{
+    if(!m_spawnIndexDirty)
+        return;
+    m_spawnIndexDirty = false;
+
+    m_spawnBlocks.clear();
+    m_unboundedSpawns.clear();
+    for(const auto& pair : m_spawns)
+        indexSpawn(pair.second);
+}
+
 /* vim: set ts=4 sw=4 et: */
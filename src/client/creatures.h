@@ -24,6 +24,7 @@
 #define CREATURES_H
 
 #include <framework/luaengine/luaobject.h>
+#include <framework/xml/xmlreader.h>
 #include "declarations.h"
 #include "outfit.h"
 
@@ -55,10 +56,10 @@ public:
     Spawn() = default;
     Spawn(int32 radius) { setRadius(radius); }
 
-    void setRadius(int32 r) { m_attribs.set(SpawnAttrRadius, r); }
+    void setRadius(int32 r);
     int32 getRadius() { return m_attribs.get<int32>(SpawnAttrRadius); }
 
-    void setCenterPos(const Position& pos) { m_attribs.set(SpawnAttrCenter, pos); }
+    void setCenterPos(const Position& pos);
     Position getCenterPos() { return m_attribs.get<Position>(SpawnAttrCenter); }
 
     std::vector<CreatureTypePtr> getCreatures();
@@ -67,7 +68,7 @@ public:
     void clear() { m_creatures.clear(); }
 
 protected:
-    void load(TiXmlElement* node);
+    void load(XmlReader& reader);
     void save(TiXmlElement* node);
 
 private:
@@ -133,13 +134,32 @@ public:
     const std::vector<CreatureTypePtr>& getCreatures() { return m_creatures; }
 
 protected:
-    void internalLoadCreatureBuffer(TiXmlElement* attrib, const CreatureTypePtr& m);
+    // what a monster or npc file describes, parsed on the workers since creature types are only created on the main thread
+    struct CreatureLook {
+        std::string name;
+        Outfit outfit;
+        bool valid = false;
+    };
+
+    static CreatureLook parseCreatureBuffer(std::string buffer, const std::string& source = std::string());
+    void loadCreatureFiles(const std::vector<std::string>& files);
+    void addCreatureType(const CreatureLook& look);
+
+    // spawns are indexed by the tile blocks their zone overlaps, floors aside like isInZone
+    void indexSpawn(const SpawnPtr& spawn);
+    void unindexSpawn(const SpawnPtr& spawn);
+    void invalidateSpawnIndex(const Position& centerPos, const Spawn* spawn);
+    void updateSpawnIndex();
 
 private:
     std::vector<CreatureTypePtr> m_creatures;
     std::unordered_map<Position, SpawnPtr, Position::Hasher> m_spawns;
-    stdext::boolean<false> m_loaded, m_spawnLoaded;
+    std::unordered_map<uint32, std::vector<SpawnPtr>> m_spawnBlocks;
+    std::vector<SpawnPtr> m_unboundedSpawns;
+    stdext::boolean<false> m_loaded, m_spawnLoaded, m_spawnIndexDirty;
     CreatureTypePtr m_nullCreature;
+
+    friend class Spawn;
 };
 
 extern CreatureManager g_creatures;
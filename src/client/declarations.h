@@ -53,6 +53,7 @@ class Town;
 class CreatureType;
 class Spawn;
 class TileBlock;
+class MarketOfferStore;
 
 typedef stdext::shared_object_ptr<MapView> MapViewPtr;
 typedef stdext::shared_object_ptr<LightView> LightViewPtr;
@@ -76,6 +77,7 @@ typedef stdext::shared_object_ptr<House> HousePtr;
 typedef stdext::shared_object_ptr<Town> TownPtr;
 typedef stdext::shared_object_ptr<CreatureType> CreatureTypePtr;
 typedef stdext::shared_object_ptr<Spawn> SpawnPtr;
+typedef stdext::shared_object_ptr<MarketOfferStore> MarketOfferStorePtr;
 
 typedef std::vector<ThingPtr> ThingList;
 typedef std::vector<ThingTypePtr> ThingTypeList;
@@ -92,8 +94,10 @@ typedef std::unordered_map<Position, SpawnPtr, Position::Hasher> SpawnMap;
 // net
 class ProtocolLogin;
 class ProtocolGame;
+class ProtocolGameReplay;
 
 typedef stdext::shared_object_ptr<ProtocolGame> ProtocolGamePtr;
+typedef stdext::shared_object_ptr<ProtocolGameReplay> ProtocolGameReplayPtr;
 typedef stdext::shared_object_ptr<ProtocolLogin> ProtocolLoginPtr;
 
 // ui
@@ -21,11 +21,10 @@
  */
 
 #include "effect.h"
-#include <framework/core/eventdispatcher.h>
 #include "game.h"
 #include "map.h"
 
-Effect::Effect() : m_timeToStartDrawing(0) {}
+Effect::Effect() : m_duration(0), m_timeToStartDrawing(0) {}
 
 void Effect::drawEffect(const Point& dest, float scaleFactor, int frameFlag, LightView* lightView)
 {
@@ -72,9 +71,7 @@ void Effect::onAppear()
         m_duration *= getAnimationPhases();
     }
 
-    // schedule removal
-    const auto self = asEffect();
-    g_dispatcher.scheduleEvent([self]() { g_map.removeThing(self); }, m_duration);
+    // removed by Map::removeExpiredEffects once the duration is over
 }
 
 void Effect::waitFor(const EffectPtr& firstEffect)
@@ -26,9 +26,10 @@
 #include <framework/global.h>
 #include <framework/core/timer.h>
 #include "thing.h"
+#include <framework/core/stats.h>
 
  // @bindclass
-class Effect : public Thing
+class Effect : public Thing, private StatsCounted<Effect>
 {
 public:
     Effect();
@@ -45,6 +46,7 @@ public:
     ThingType* rawGetThingType() override;
 
     void waitFor(const EffectPtr& firstEffect);
+    bool isExpired() { return m_animationTimer.ticksElapsed() >= m_duration; }
 
 protected:
     void onAppear() override;
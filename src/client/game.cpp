@@ -21,16 +21,20 @@
  */
 
 #include "game.h"
+#include <framework/core/actiontracer.h>
 #include <framework/core/application.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/luaengine/luaeventbatch.h>
 #include <framework/ui/uimanager.h>
 #include "container.h"
 #include "creature.h"
+#include "gamestateexport.h"
 #include "localplayer.h"
 #include "luavaluecasts.h"
 #include "map.h"
 #include "protocolcodes.h"
 #include "protocolgame.h"
+#include "protocolgamereplay.h"
 #include "statictext.h"
 #include "tile.h"
 
@@ -85,6 +89,14 @@ void Game::resetGameStates()
     m_localPlayer = nullptr;
     m_pingSent = 0;
     m_pingReceived = 0;
+    m_pingWindow.clear();
+    m_walkTraces.clear();
+    m_pingJitter = 0;
+    m_rateReadBytes = 0;
+    m_rateWrittenBytes = 0;
+    m_rateTime = 0;
+    m_readRate = 0;
+    m_writeRate = 0;
     m_unjustifiedPoints = UnjustifiedPoints();
     m_nextScheduledDir = Otc::InvalidDirection;
 
@@ -274,9 +286,13 @@ void Game::processPingBack()
 {
     ++m_pingReceived;
 
-    if(m_pingReceived == m_pingSent)
+    if(m_pingReceived == m_pingSent) {
         m_ping = m_pingTimer.elapsed_millis();
-    else
+        // smoothed like the rtp interarrival jitter, each new difference moves it by a sixteenth
+        if(!m_pingWindow.empty())
+            m_pingJitter += (std::abs(m_ping - (ticks_t)m_pingWindow.last()) - m_pingJitter) / 16.0;
+        m_pingWindow.push(m_ping);
+    } else
         g_logger.error("got an invalid ping from server");
 
     g_lua.callGlobalField("g_game", "onPingBack", m_ping);
@@ -289,6 +305,10 @@ void Game::processPingBack()
 void Game::processTextMessage(Otc::MessageMode mode, const std::string& text)
 {
     g_lua.callGlobalField("g_game", "onTextMessage", mode, text);
+
+    static const int batchChannel = g_eventBatch.registerChannel("onTextMessage");
+    if(g_eventBatch.isSubscribed(batchChannel))
+        g_eventBatch.push(batchChannel, mode, text);
 }
 
 void Game::processTalk(const std::string& name, int level, Otc::MessageMode mode, const std::string& text, int channelId, const Position& pos)
@@ -310,6 +330,7 @@ void Game::processOpenContainer(int containerId, const ItemPtr& containerItem, c
 
     if(previousContainer)
         previousContainer->onClose();
+    g_gameStateExport.invalidate();
 }
 
 void Game::processCloseContainer(int containerId)
@@ -321,6 +342,7 @@ void Game::processCloseContainer(int containerId)
 
     m_containers[containerId] = nullptr;
     container->onClose();
+    g_gameStateExport.invalidate();
 }
 
 void Game::processContainerAddItem(int containerId, const ItemPtr& item, int slot)
@@ -331,6 +353,7 @@ void Game::processContainerAddItem(int containerId, const ItemPtr& item, int slo
     }
 
     container->onAddItem(item, slot);
+    g_gameStateExport.invalidate();
 }
 
 void Game::processContainerUpdateItem(int containerId, int slot, const ItemPtr& item)
@@ -341,6 +364,7 @@ void Game::processContainerUpdateItem(int containerId, int slot, const ItemPtr&
     }
 
     container->onUpdateItem(slot, item);
+    g_gameStateExport.invalidate();
 }
 
 void Game::processContainerRemoveItem(int containerId, int slot, const ItemPtr& lastItem)
@@ -351,6 +375,7 @@ void Game::processContainerRemoveItem(int containerId, int slot, const ItemPtr&
     }
 
     container->onRemoveItem(slot, lastItem);
+    g_gameStateExport.invalidate();
 }
 
 void Game::processInventoryChange(int slot, const ItemPtr& item)
@@ -529,9 +554,23 @@ void Game::processAttackCancel(uint seq)
 
 void Game::processWalkCancel(Otc::Direction direction)
 {
+    // the server drops every step still unconfirmed
+    for(const uint32 id : m_walkTraces)
+        g_actionTracer.cancel(id);
+    m_walkTraces.clear();
+
     m_localPlayer->cancelWalk(direction);
 }
 
+void Game::processWalkConfirm()
+{
+    if(m_walkTraces.empty())
+        return;
+
+    g_actionTracer.confirm(m_walkTraces.front());
+    m_walkTraces.pop_front();
+}
+
 void Game::loginWorld(const std::string& account, const std::string& password, const std::string& worldName, const std::string& worldHost, int worldPort, const std::string& characterName, const std::string& authenticatorToken, const std::string& sessionKey)
 {
     if(m_protocolGame || isOnline())
@@ -552,6 +591,31 @@ void Game::loginWorld(const std::string& account, const std::string& password, c
     m_worldName = worldName;
 }
 
+bool Game::playRecording(const std::string& fileName, const std::string& characterName, bool realTime)
+{
+    if(m_protocolGame || isOnline())
+        stdext::throw_exception("Unable to replay a recording while already online or logging.");
+
+    if(m_protocolVersion == 0)
+        stdext::throw_exception("Must set the recorded game protocol version before replaying.");
+
+    resetGameStates();
+
+    m_localPlayer = LocalPlayerPtr(new LocalPlayer);
+    m_localPlayer->setName(characterName);
+
+    ProtocolGameReplayPtr replay(new ProtocolGameReplay);
+    m_protocolGame = replay;
+    m_characterName = characterName;
+    m_worldName = std::string();
+
+    if(!replay->play(fileName, realTime)) {
+        m_protocolGame = nullptr;
+        return false;
+    }
+    return true;
+}
+
 void Game::cancelLogin()
 {
     // send logout even if the game has not started yet, to make sure that the player doesn't stay logged there
@@ -605,7 +669,11 @@ bool Game::walk(const Otc::Direction direction, bool isKeyDown /*= false*/)
                     m_walkEvent = nullptr;
                 }
 
-                m_walkEvent = g_dispatcher.scheduleEvent([=] { walk(direction); }, ticks);
+                // the step keeps the input event that asked for it
+                m_walkEvent = g_dispatcher.scheduleEvent([=, inputTime = g_actionTracer.getInputTime()] {
+                    ActionTracer::InputScope inputScope(inputTime);
+                    walk(direction);
+                }, ticks);
                 m_nextScheduledDir = direction;
             }
         }
@@ -619,11 +687,20 @@ bool Game::walk(const Otc::Direction direction, bool isKeyDown /*= false*/)
         }
     }
 
-    Position toPos = m_localPlayer->getPosition().translatedToDirection(direction);
+    // with steps still unconfirmed this one is predicted from where they lead
+    const bool predicting = m_localPlayer->isPreWalking() || m_localPlayer->hasPredictedSteps();
+    Position toPos = m_localPlayer->getPredictedPosition().translatedToDirection(direction);
     TilePtr toTile = g_map.getTile(toPos);
 
+    if(predicting) {
+        // floor changes and anything else not plainly walkable wait for the server
+        if(!toTile || !toTile->isPredictedWalkable())
+            return false;
+
+        m_localPlayer->queueWalk(direction);
+    }
     // only do prewalks to walkable tiles (like grounds and not walls)
-    if(toTile && toTile->isWalkable()) {
+    else if(toTile && toTile->isWalkable()) {
         m_localPlayer->preWalk(direction);
     } else {
         // check if can walk to a lower floor
@@ -713,6 +790,20 @@ void Game::autoWalk(std::vector<Otc::Direction> dirs)
 }
 
 void Game::forceWalk(Otc::Direction direction)
+{
+    if(!canPerformGameAction())
+        return;
+
+    // the packet is held back as if the connection was that much slower
+    if(m_simulatedWalkLatency > 0)
+        g_dispatcher.scheduleEvent([this, direction] { sendWalk(direction); }, m_simulatedWalkLatency);
+    else
+        sendWalk(direction);
+
+    g_lua.callGlobalField("g_game", "onForceWalk", direction);
+}
+
+void Game::sendWalk(Otc::Direction direction)
 {
     if(!canPerformGameAction())
         return;
@@ -743,10 +834,12 @@ void Game::forceWalk(Otc::Direction direction)
         m_protocolGame->sendWalkNorthWest();
         break;
     default:
-        break;
+        return;
     }
 
-    g_lua.callGlobalField("g_game", "onForceWalk", direction);
+    static const uint16 walkTrace = g_actionTracer.registerType("walk");
+    if(const uint32 id = g_actionTracer.begin(walkTrace, true))
+        m_walkTraces.push_back(id);
 }
 
 void Game::turn(Otc::Direction direction)
@@ -768,8 +861,11 @@ void Game::turn(Otc::Direction direction)
         m_protocolGame->sendTurnWest();
         break;
     default:
-        break;
+        return;
     }
+
+    static const uint16 turnTrace = g_actionTracer.registerType("turn");
+    g_actionTracer.begin(turnTrace, false);
 }
 
 void Game::stop()
@@ -850,6 +946,9 @@ void Game::useInventoryItem(int itemId)
     const Position pos = Position(0xFFFF, 0, 0); // means that is a item in inventory
 
     m_protocolGame->sendUseItem(pos, itemId, 0, 0);
+
+    static const uint16 useTrace = g_actionTracer.registerType("use");
+    g_actionTracer.begin(useTrace, false);
 }
 
 void Game::useWith(const ItemPtr& item, const ThingPtr& toThing)
@@ -878,6 +977,9 @@ void Game::useInventoryItemWith(int itemId, const ThingPtr& toThing)
         m_protocolGame->sendUseOnCreature(pos, itemId, 0, toThing->getId());
     else
         m_protocolGame->sendUseItemWith(pos, itemId, 0, toThing->getPosition(), toThing->getId(), toThing->getStackPos());
+
+    static const uint16 useTrace = g_actionTracer.registerType("use");
+    g_actionTracer.begin(useTrace, false);
 }
 
 ItemPtr Game::findItemInContainers(uint itemId, int subType)
@@ -1460,6 +1562,50 @@ void Game::ping()
     m_pingTimer.restart();
 }
 
+std::map<std::string, double> Game::getNetworkStats()
+{
+    std::map<std::string, double> stats;
+    stats["ping"] = m_ping;
+    stats["pingSamples"] = m_pingWindow.size();
+    stats["pingMax"] = m_pingWindow.max();
+    stats["pingP50"] = m_pingWindow.percentile(0.5);
+    stats["pingP95"] = m_pingWindow.percentile(0.95);
+    stats["pingP99"] = m_pingWindow.percentile(0.99);
+    stats["jitter"] = m_pingJitter;
+    if(!m_protocolGame)
+        return stats;
+
+    for(const auto& it : m_protocolGame->getArrivalStats()) {
+        std::string key = it.first;
+        stdext::ucwords(key);
+        stats["arrival" + key] = it.second;
+    }
+
+    const uint64 readBytes = m_protocolGame->getReadBytes();
+    const uint64 writtenBytes = m_protocolGame->getWrittenBytes();
+    const ticks_t now = stdext::millis();
+    // a new connection starts its counters over, the first sample only sets the base
+    if(m_rateTime == 0 || readBytes < m_rateReadBytes || writtenBytes < m_rateWrittenBytes) {
+        m_rateReadBytes = readBytes;
+        m_rateWrittenBytes = writtenBytes;
+        m_rateTime = now;
+    } else if(now - m_rateTime >= 1000) {
+        const double seconds = (now - m_rateTime) / 1000.0;
+        m_readRate = (readBytes - m_rateReadBytes) / seconds;
+        m_writeRate = (writtenBytes - m_rateWrittenBytes) / seconds;
+        m_rateReadBytes = readBytes;
+        m_rateWrittenBytes = writtenBytes;
+        m_rateTime = now;
+    }
+
+    stats["readBytes"] = readBytes;
+    stats["writtenBytes"] = writtenBytes;
+    stats["readRate"] = m_readRate;
+    stats["writeRate"] = m_writeRate;
+    stats["queuedBytes"] = m_protocolGame->getQueuedBytes();
+    return stats;
+}
+
 void Game::changeMapAwareRange(int xrange, int yrange)
 {
     if(!canPerformGameAction())
@@ -1710,6 +1856,16 @@ void Game::setFollowingCreature(const CreaturePtr& creature)
     g_lua.callGlobalField("g_game", "onFollowingCreatureChange", creature, oldCreature);
 }
 
+std::map<std::string, int> Game::getMergedCreatureUpdates()
+{
+    return {
+        { "health", m_mergedCreatureUpdates[ProtocolGame::CreatureUpdateHealth] },
+        { "speed", m_mergedCreatureUpdates[ProtocolGame::CreatureUpdateSpeed] },
+        { "light", m_mergedCreatureUpdates[ProtocolGame::CreatureUpdateLight] },
+        { "outfit", m_mergedCreatureUpdates[ProtocolGame::CreatureUpdateOutfit] }
+    };
+}
+
 std::string Game::formatCreatureName(const std::string& name)
 {
     std::string formatedName = name;
@@ -93,6 +93,7 @@ protected:
     void processInventoryChange(int slot, const ItemPtr& item);
     void processAttackCancel(uint seq);
     void processWalkCancel(Otc::Direction direction);
+    void processWalkConfirm();
 
     static void processPlayerHelpers(int helpers);
     void processPlayerModes(Otc::FightModes fightMode, Otc::ChaseModes chaseMode, bool safeMode, Otc::PVPModes pvpMode);
@@ -163,6 +164,8 @@ protected:
 public:
     // login related
     void loginWorld(const std::string& account, const std::string& password, const std::string& worldName, const std::string& worldHost, int worldPort, const std::string& characterName, const std::string& authenticatorToken, const std::string& sessionKey);
+    // enters the game from a protocol recording instead of a server, see Protocol::startRecording
+    bool playRecording(const std::string& fileName, const std::string& characterName, bool realTime);
     void cancelLogin();
     void forceLogout();
     void safeLogout();
@@ -174,6 +177,9 @@ public:
     void turn(Otc::Direction direction);
     void stop();
     void setScheduleLastWalk(bool scheduleLastWalk) { m_scheduleLastWalk = scheduleLastWalk; }
+    // delays outgoing walks to test walk prediction against a slow connection
+    void setSimulatedWalkLatency(int millis) { m_simulatedWalkLatency = std::max<int>(millis, 0); }
+    int getSimulatedWalkLatency() { return m_simulatedWalkLatency; }
 
     // item related
     void look(const ThingPtr& thing, bool isBattleList = false);
@@ -332,6 +338,9 @@ public:
     bool isConnectionOk() { return m_protocolGame && m_protocolGame->getElapsedTicksSinceLastRead() < 5000; }
 
     int getPing() { return m_ping; }
+    // ping percentiles and jitter over the last 128 pings, message inter-arrival times,
+    // traffic rates and the send queue; the rates are averaged since the previous call at least a second ago
+    std::map<std::string, double> getNetworkStats();
     ContainerPtr getContainer(int index) { return m_containers[index]; }
     std::map<int, ContainerPtr> getContainers() { return m_containers; }
     std::map<int, Vip> getVips() { return m_vips; }
@@ -345,6 +354,12 @@ public:
     bool getExpertPvpMode() { return m_expertPvpMode; }
     LocalPlayerPtr getLocalPlayer() { return m_localPlayer; }
     ProtocolGamePtr getProtocolGame() { return m_protocolGame; }
+    // health, speed, light and outfit updates of a creature received together only apply the last value,
+    // the counters tell how many updates were dropped that way, by attribute name
+    void setCoalesceCreatureUpdates(bool enable) { m_coalesceCreatureUpdates = enable; }
+    bool isCoalescingCreatureUpdates() { return m_coalesceCreatureUpdates; }
+    std::map<std::string, int> getMergedCreatureUpdates();
+    void resetMergedCreatureUpdates() { m_mergedCreatureUpdates.fill(0); }
     std::string getCharacterName() { return m_characterName; }
     std::string getWorldName() { return m_worldName; }
     std::vector<uint8> getGMActions() { return m_gmActions; }
@@ -361,6 +376,7 @@ protected:
 private:
     void setAttackingCreature(const CreaturePtr& creature);
     void setFollowingCreature(const CreaturePtr& creature);
+    void sendWalk(Otc::Direction direction);
 
     LocalPlayerPtr m_localPlayer;
     CreaturePtr m_attackingCreature;
@@ -378,6 +394,14 @@ private:
     uint m_pingSent;
     uint m_pingReceived;
     stdext::timer m_pingTimer;
+    stdext::rolling_window<uint32, 128> m_pingWindow;
+    double m_pingJitter;
+    std::deque<uint32> m_walkTraces;
+    uint64 m_rateReadBytes;
+    uint64 m_rateWrittenBytes;
+    ticks_t m_rateTime;
+    double m_readRate;
+    double m_writeRate;
     Timer m_dashTimer;
     uint m_seq;
     int m_pingDelay;
@@ -387,6 +411,9 @@ private:
     Otc::Direction m_lastWalkDir;
     Otc::Direction m_nextScheduledDir;
     bool m_scheduleLastWalk;
+    int m_simulatedWalkLatency{ 0 };
+    bool m_coalesceCreatureUpdates{ false };
+    std::array<int, ProtocolGame::CREATURE_UPDATE_ATTRIBUTES> m_mergedCreatureUpdates{};
     UnjustifiedPoints m_unjustifiedPoints;
     int m_openPvpSituations;
     bool m_safeFight;
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "gamestateexport.h"
+#include "container.h"
+#include "creature.h"
+#include "game.h"
+#include "item.h"
+#include "localplayer.h"
+#include "map.h"
+
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+
+#include <cstring>
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+GameStateExport g_gameStateExport;
+
+static_assert(std::atomic<uint32>::is_always_lock_free && std::atomic<uint64>::is_always_lock_free,
+              "atomics shared between processes must be lock free");
+
+namespace {
+    void copyName(char* out, const std::string& name)
+    {
+        const size_t length = std::min<size_t>(name.length(), GameStateExport::NAME_LENGTH - 1);
+        std::memcpy(out, name.data(), length);
+        std::memset(out + length, 0, GameStateExport::NAME_LENGTH - length);
+    }
+}
+
+bool GameStateExport::start(const std::string& name)
+{
+    stop();
+
+    const std::string segmentName = "otclient-state-" + name;
+    const size_t size = sizeof(Header) + sizeof(Slot) * SLOT_COUNT;
+
+    void* data = nullptr;
+#ifdef WIN32
+    const std::wstring mappingName = stdext::utf8_to_utf16("Local\\" + segmentName);
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64>(size) >> 32), static_cast<DWORD>(size), mappingName.c_str());
+    if(!mapping)
+        return false;
+
+    // the view keeps the mapping alive, readers keep it after the client is gone
+    data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    CloseHandle(mapping);
+    if(!data)
+        return false;
+#else
+    const std::string shmName = "/" + segmentName;
+    const int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT, 0600);
+    if(fd == -1)
+        return false;
+
+    if(ftruncate(fd, size) == -1) {
+        ::close(fd);
+        return false;
+    }
+
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        return false;
+#endif
+
+    // readers that kept the segment of an older client see no snapshot until the first one is written
+    m_header = static_cast<Header*>(data);
+    m_header->magic.store(0, std::memory_order_relaxed);
+    m_header->latest.store(0, std::memory_order_relaxed);
+    m_header->version = VERSION;
+    m_header->slotCount = SLOT_COUNT;
+    m_header->slotSize = sizeof(Slot);
+    for(int i = 0; i < SLOT_COUNT; ++i)
+        getSlots()[i].sequence.store(0, std::memory_order_relaxed);
+    m_header->magic.store(MAGIC, std::memory_order_release);
+
+    m_size = size;
+    m_segmentName = segmentName;
+    m_snapshot.reset(new Snapshot);
+
+    // creatures that appeared before the start sent no notification
+    m_creatures.clear();
+    const LocalPlayerPtr& localPlayer = g_game.getLocalPlayer();
+    if(localPlayer && localPlayer->getPosition().isValid()) {
+        for(const CreaturePtr& creature : g_map.getSpectators(localPlayer->getPosition(), true))
+            m_creatures[creature->getId()] = creature;
+    }
+
+    invalidate();
+    return true;
+}
+
+void GameStateExport::stop()
+{
+    if(!m_header)
+        return;
+
+#ifdef WIN32
+    UnmapViewOfFile(m_header);
+#else
+    munmap(m_header, m_size);
+    shm_unlink(("/" + m_segmentName).c_str());
+#endif
+    m_header = nullptr;
+    m_size = 0;
+    m_segmentName.clear();
+    m_creatures.clear();
+    m_snapshot.reset();
+}
+
+void GameStateExport::invalidate()
+{
+    if(!m_header || m_publishPending)
+        return;
+
+    // every change of a frame ends up in one snapshot
+    m_publishPending = true;
+    g_dispatcher.addEvent([] { g_gameStateExport.publish(); });
+}
+
+void GameStateExport::clear()
+{
+    m_creatures.clear();
+    invalidate();
+}
+
+void GameStateExport::onCreatureChange(const CreaturePtr& creature)
+{
+    if(!m_header)
+        return;
+
+    m_creatures[creature->getId()] = creature;
+    invalidate();
+}
+
+void GameStateExport::onCreatureRemove(const CreaturePtr& creature)
+{
+    if(!m_header)
+        return;
+
+    m_creatures.erase(creature->getId());
+    invalidate();
+}
+
+void GameStateExport::fillSnapshot(Snapshot& snapshot)
+{
+    snapshot.time = g_clock.millis();
+
+    ExportPlayer& player = snapshot.player;
+    std::memset(&player, 0, sizeof(player));
+    const LocalPlayerPtr& localPlayer = g_game.getLocalPlayer();
+    if(localPlayer) {
+        const Position& position = localPlayer->getPosition();
+        player.id = localPlayer->getId();
+        player.x = position.x;
+        player.y = position.y;
+        player.z = position.z;
+        player.online = g_game.isOnline() ? 1 : 0;
+        player.states = localPlayer->getStates();
+        player.health = localPlayer->getHealth();
+        player.maxHealth = localPlayer->getMaxHealth();
+        player.mana = localPlayer->getMana();
+        player.maxMana = localPlayer->getMaxMana();
+        player.level = localPlayer->getLevel();
+        player.soul = localPlayer->getSoul();
+        player.experience = localPlayer->getExperience();
+        player.freeCapacity = localPlayer->getFreeCapacity() * 100;
+        copyName(player.name, localPlayer->getName());
+    }
+
+    uint32 creatureCount = 0;
+    for(const auto& it : m_creatures) {
+        if(creatureCount >= MAX_CREATURES)
+            break;
+
+        const CreaturePtr& creature = it.second;
+        if(creature->isLocalPlayer() || !creature->getPosition().isValid())
+            continue;
+
+        ExportCreature& entry = snapshot.creatures[creatureCount++];
+        const Position& position = creature->getPosition();
+        entry.id = creature->getId();
+        entry.x = position.x;
+        entry.y = position.y;
+        entry.z = position.z;
+        entry.kind = creature->isPlayer() ? KindPlayer : (creature->isMonster() ? KindMonster : (creature->isNpc() ? KindNpc : KindOther));
+        entry.healthPercent = creature->getHealthPercent();
+        entry.skull = creature->getSkull();
+        copyName(entry.name, creature->getName());
+    }
+    snapshot.creatureCount = creatureCount;
+
+    uint32 containerCount = 0;
+    for(const auto& it : g_game.getContainers()) {
+        const ContainerPtr& container = it.second;
+        if(!container || container->isClosed())
+            continue;
+        if(containerCount >= MAX_CONTAINERS)
+            break;
+
+        ExportContainer& entry = snapshot.containers[containerCount++];
+        const ItemPtr& item = container->getContainerItem();
+        entry.id = container->getId();
+        entry.itemId = item ? item->getId() : 0;
+        entry.capacity = container->getCapacity();
+        entry.itemCount = container->getItemsCount();
+        entry.padding = 0;
+        copyName(entry.name, container->getName());
+    }
+    snapshot.containerCount = containerCount;
+}
+
+void GameStateExport::publish()
+{
+    m_publishPending = false;
+    if(!m_header)
+        return;
+
+    // built outside the segment, so the slot is only held for the copy
+    const uint64 next = m_header->latest.load(std::memory_order_relaxed) + 1;
+    m_snapshot->frame = next;
+    fillSnapshot(*m_snapshot);
+    const size_t usedSize = offsetof(Snapshot, creatures) + sizeof(ExportCreature) * m_snapshot->creatureCount;
+
+    Slot& slot = getSlots()[next % SLOT_COUNT];
+    const uint32 sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // the containers follow the creature array, whose unused tail is not copied
+    std::memcpy(&slot.snapshot, m_snapshot.get(), usedSize);
+    std::memcpy(slot.snapshot.containers, m_snapshot->containers, sizeof(ExportContainer) * m_snapshot->containerCount);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    m_header->latest.store(next, std::memory_order_release);
+}
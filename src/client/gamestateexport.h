@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef GAMESTATEEXPORT_H
+#define GAMESTATEEXPORT_H
+
+#include "declarations.h"
+
+// Snapshots of the local player, the creatures the client knows and the open containers, written to a
+// shared memory segment named otclient-state-<name> for overlays and tools running next to the client.
+// The creatures come from the appear, move, change and disappear notifications, a snapshot is only
+// written in the frames after one of them or a player or container change.
+//
+// The segment is a Header followed by SLOT_COUNT Slots. Readers never block the client:
+//   1. n = header.latest, stop when it's 0 or the same as the last snapshot read
+//   2. slot = slots[n % slotCount], s1 = slot.sequence, start over when it's odd
+//   3. copy slot.snapshot, then s2 = slot.sequence, start over when s1 != s2
+// The writer fills the oldest slot, so a reader only starts over after SLOT_COUNT - 1 newer snapshots.
+class GameStateExport
+{
+public:
+    enum {
+        MAGIC = 0x45535443, // "CTSE"
+        VERSION = 1,
+        SLOT_COUNT = 4,
+        NAME_LENGTH = 32,
+        MAX_CREATURES = 256,
+        MAX_CONTAINERS = 32
+    };
+
+    enum CreatureKind : uint8 {
+        KindOther = 0,
+        KindPlayer,
+        KindMonster,
+        KindNpc
+    };
+
+    struct ExportPlayer {
+        uint32 id;
+        uint16 x, y;
+        uint8 z, online, padding[2];
+        uint32 states;
+        uint32 health, maxHealth;
+        uint32 mana, maxMana;
+        uint32 level, soul;
+        uint64 experience;
+        uint32 freeCapacity; // hundredths of an oz
+        char name[NAME_LENGTH];
+    };
+
+    struct ExportCreature {
+        uint32 id;
+        uint16 x, y;
+        uint8 z, kind, healthPercent, skull;
+        char name[NAME_LENGTH];
+    };
+
+    struct ExportContainer {
+        uint32 id;
+        uint16 itemId, capacity, itemCount, padding;
+        char name[NAME_LENGTH];
+    };
+
+    struct Snapshot {
+        uint64 frame; // counts the snapshots written since start
+        int64 time; // client clock in milliseconds
+        ExportPlayer player;
+        uint32 creatureCount, containerCount;
+        ExportCreature creatures[MAX_CREATURES];
+        ExportContainer containers[MAX_CONTAINERS];
+    };
+
+    struct Slot {
+        std::atomic<uint32> sequence; // odd while the snapshot is written
+        uint32 padding;
+        Snapshot snapshot;
+    };
+
+    struct Header {
+        std::atomic<uint32> magic;
+        uint32 version;
+        uint32 slotCount;
+        uint32 slotSize;
+        std::atomic<uint64> latest; // number of the newest complete snapshot, 0 before the first
+    };
+
+    void terminate() { stop(); }
+
+    // one client per name, a segment left by a client that crashed is taken over
+    bool start(const std::string& name);
+    void stop();
+    bool isRunning() { return m_header != nullptr; }
+    std::string getSegmentName() { return m_segmentName; }
+    uint64 getSnapshotCount() { return m_header ? m_header->latest.load(std::memory_order_relaxed) : 0; }
+
+    void invalidate();
+    void clear();
+
+    void onCreatureChange(const CreaturePtr& creature);
+    void onCreatureRemove(const CreaturePtr& creature);
+
+private:
+    Slot* getSlots() { return reinterpret_cast<Slot*>(reinterpret_cast<uint8*>(m_header) + sizeof(Header)); }
+    void fillSnapshot(Snapshot& snapshot);
+    void publish();
+
+    Header* m_header{ nullptr };
+    size_t m_size{ 0 };
+    std::string m_segmentName;
+    std::unordered_map<uint32, CreaturePtr> m_creatures;
+    std::unique_ptr<Snapshot> m_snapshot;
+    bool m_publishPending{ false };
+};
+
+extern GameStateExport g_gameStateExport;
+
+#endif
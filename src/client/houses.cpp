@@ -26,6 +26,11 @@
 
 HouseManager g_houses;
 
+static uint64 getHouseBlockKey(const Position& pos)
+{
+    return (static_cast<uint64>(pos.z) << 32) | (static_cast<uint64>(pos.x / BLOCK_SIZE) << 16) | static_cast<uint64>(pos.y / BLOCK_SIZE);
+}
+
 House::House()
 {
 }
@@ -38,11 +43,24 @@ House::House(uint32 hId, const std::string& name, const Position& pos)
         setEntry(pos);
 }
 
+void House::setName(const std::string& name)
+{
+    m_attribs.set(HouseAttrName, name);
+    g_houses.invalidateIndex(this);
+}
+
+void House::setTownId(uint32 tid)
+{
+    m_attribs.set(HouseAttrTown, tid);
+    g_houses.invalidateIndex(this);
+}
+
 void House::setTile(const TilePtr& tile)
 {
     tile->setFlag(TILESTATE_HOUSE);
     tile->setHouseId(getId());
     m_tiles.insert(std::make_pair(tile->getPosition(), tile));
+    g_houses.indexHouseTile(this, tile->getPosition());
 }
 
 TilePtr House::getTile(const Position& position)
@@ -68,22 +86,22 @@ void House::removeDoorById(uint32 doorId)
     m_doors[doorId] = nullptr;
 }
 
-void House::load(const TiXmlElement* elem)
+void House::load(const XmlReader& reader)
 {
-    std::string name = elem->Attribute("name");
+    std::string name = reader.getAttribute("name");
     if(name.empty())
         name = stdext::format("Unnamed house #%lu", getId());
 
     setName(name);
-    setRent(elem->readType<uint32>("rent"));
-    setSize(elem->readType<uint32>("size"));
-    setTownId(elem->readType<uint32>("townid"));
-    m_isGuildHall = elem->readType<bool>("guildhall");
+    setRent(reader.readAttribute<uint32>("rent"));
+    setSize(reader.readAttribute<uint32>("size"));
+    setTownId(reader.readAttribute<uint32>("townid"));
+    m_isGuildHall = reader.readAttribute<bool>("guildhall");
 
     Position entryPos;
-    entryPos.x = elem->readType<int>("entryx");
-    entryPos.y = elem->readType<int>("entryy");
-    entryPos.z = elem->readType<int>("entryz");
+    entryPos.x = reader.readAttribute<int>("entryx");
+    entryPos.y = reader.readAttribute<int>("entryy");
+    entryPos.z = reader.readAttribute<int>("entryz");
     setEntry(entryPos);
 }
 
@@ -109,52 +127,86 @@ HouseManager::HouseManager()
 
 void HouseManager::addHouse(const HousePtr& house)
 {
-    if(findHouse(house->getId()) == m_houses.end())
-        m_houses.push_back(house);
+    if(!m_housesById.emplace(house->getId(), house).second)
+        return;
+
+    m_houses.push_back(house);
+    if(!m_indexDirty) {
+        m_housesByName.emplace(house->getName(), house);
+        m_housesByTown[house->getTownId()].push_back(house);
+    }
+    for(const auto& pair : house->m_tiles)
+        indexHouseTile(house.get(), pair.first);
 }
 
 void HouseManager::removeHouse(uint32 houseId)
 {
-    const auto it = findHouse(houseId);
-    if(it != m_houses.end())
-        m_houses.erase(it);
+    const auto it = m_housesById.find(houseId);
+    if(it == m_housesById.end())
+        return;
+
+    const HousePtr house = it->second;
+    m_housesById.erase(it);
+    m_houses.erase(findHouse(houseId));
+
+    // another house of the same name may take its place, the lists are simply rebuilt
+    m_indexDirty = true;
+    for(const auto& pair : house->m_tiles) {
+        const auto blockIt = m_houseBlocks.find(getHouseBlockKey(pair.first));
+        if(blockIt == m_houseBlocks.end())
+            continue;
+
+        std::vector<HousePtr>& houses = blockIt->second;
+        houses.erase(std::remove(houses.begin(), houses.end(), house), houses.end());
+        if(houses.empty())
+            m_houseBlocks.erase(blockIt);
+    }
 }
 
 HousePtr HouseManager::getHouse(uint32 houseId)
 {
-    const auto it = findHouse(houseId);
-    return it != m_houses.end() ? *it : nullptr;
+    const auto it = m_housesById.find(houseId);
+    return it != m_housesById.end() ? it->second : nullptr;
 }
 
 HousePtr HouseManager::getHouseByName(const std::string& name)
 {
-    const auto it = std::find_if(m_houses.begin(), m_houses.end(),
-                                 [=](const HousePtr& house) -> bool { return house->getName() == name; });
-    return it != m_houses.end() ? *it : nullptr;
+    updateIndex();
+    const auto it = m_housesByName.find(name);
+    return it != m_housesByName.end() ? it->second : nullptr;
+}
+
+HousePtr HouseManager::getHouseAt(const Position& pos)
+{
+    const auto it = m_houseBlocks.find(getHouseBlockKey(pos));
+    if(it == m_houseBlocks.end())
+        return nullptr;
+
+    for(const HousePtr& house : it->second) {
+        // a tile handed over to another house stays in the tiles of the former one
+        const TilePtr tile = house->getTile(pos);
+        if(tile && tile->getHouseId() == house->getId())
+            return house;
+    }
+    return nullptr;
 }
 
 void HouseManager::load(const std::string& fileName)
 {
     try {
-        TiXmlDocument doc;
-        doc.Parse(g_resources.readFileContents(fileName).c_str());
-        if(doc.Error())
-            stdext::throw_exception(stdext::format("failed to load '%s': %s (House XML)", fileName, doc.ErrorDesc()));
-
-        TiXmlElement* root = doc.FirstChildElement();
-        if(!root || root->ValueTStr() != "houses")
-            stdext::throw_exception("invalid root tag name");
+        XmlReader reader(g_resources.readFileContents(fileName), fileName);
+        reader.readRoot("houses");
 
-        for(TiXmlElement* elem = root->FirstChildElement(); elem; elem = elem->NextSiblingElement()) {
-            if(elem->ValueTStr() != "house")
+        while(reader.nextChild(1)) {
+            if(!reader.isName("house"))
                 stdext::throw_exception("invalid house tag.");
 
-            const uint32 houseId = elem->readType<uint32>("houseid");
+            const uint32 houseId = reader.readAttribute<uint32>("houseid");
             HousePtr house = getHouse(houseId);
             if(!house)
                 house = HousePtr(new House(houseId)), addHouse(house);
 
-            house->load(elem);
+            house->load(reader);
         }
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to load '%s': %s", fileName, e.what()));
@@ -189,11 +241,9 @@ void HouseManager::save(const std::string& fileName)
 
 HouseList HouseManager::filterHouses(uint32 townId)
 {
-    HouseList ret;
-    for(const HousePtr& house : m_houses)
-        if(house->getTownId() == townId)
-            ret.push_back(house);
-    return ret;
+    updateIndex();
+    const auto it = m_housesByTown.find(townId);
+    return it != m_housesByTown.end() ? it->second : HouseList();
 }
 
 HouseList::iterator HouseManager::findHouse(uint32 houseId)
@@ -205,6 +255,49 @@ HouseList::iterator HouseManager::findHouse(uint32 houseId)
 void HouseManager::sort()
 {
     m_houses.sort([](const HousePtr& lhs, const HousePtr& rhs) { return lhs->getName() < rhs->getName(); });
+    m_indexDirty = true;
+}
+
+void HouseManager::clear()
+{
+    m_houses.clear();
+    m_housesById.clear();
+    m_housesByName.clear();
+    m_housesByTown.clear();
+    m_houseBlocks.clear();
+    m_indexDirty = false;
+}
+
+void HouseManager::indexHouseTile(House* house, const Position& pos)
+{
+    const auto it = m_housesById.find(house->getId());
+    if(it == m_housesById.end() || it->second.get() != house)
+        return;
+
+    std::vector<HousePtr>& houses = m_houseBlocks[getHouseBlockKey(pos)];
+    if(std::find(houses.begin(), houses.end(), it->second) == houses.end())
+        houses.push_back(it->second);
+}
+
+void HouseManager::invalidateIndex(House* house)
+{
+    const auto it = m_housesById.find(house->getId());
+    if(it != m_housesById.end() && it->second.get() == house)
+        m_indexDirty = true;
+}
+
+void HouseManager::updateIndex()
+{
+    if(!m_indexDirty)
+        return;
+    m_indexDirty = false;
+
+    m_housesByName.clear();
+    m_housesByTown.clear();
+    for(const HousePtr& house : m_houses) {
+        m_housesByName.emplace(house->getName(), house);
+        m_housesByTown[house->getTownId()].push_back(house);
+    }
 }
 
 /* vim: set ts=4 sw=4 et: */
@@ -27,6 +27,7 @@
 #include "tile.h"
 
 #include <framework/luaengine/luaobject.h>
+#include <framework/xml/xmlreader.h>
 
 enum HouseAttr : uint8
 {
@@ -48,13 +49,13 @@ public:
     void setTile(const TilePtr& tile);
     TilePtr getTile(const Position& pos);
 
-    void setName(const std::string& name) { m_attribs.set(HouseAttrName, name); }
+    void setName(const std::string& name);
     std::string getName() { return m_attribs.get<std::string>(HouseAttrName); }
 
     void setId(uint32 hId) { m_attribs.set(HouseAttrId, hId); }
     uint32 getId() { return m_attribs.get<uint32>(HouseAttrId); }
 
-    void setTownId(uint32 tid) { m_attribs.set(HouseAttrTown, tid); }
+    void setTownId(uint32 tid);
     uint32 getTownId() { return m_attribs.get<uint32>(HouseAttrTown); }
 
     void setSize(uint32 s) { m_attribs.set(HouseAttrSize, s); }
@@ -71,7 +72,7 @@ public:
     void removeDoorById(uint32 doorId);
 
 protected:
-    void load(const TiXmlElement* elem);
+    void load(const XmlReader& reader);
     void save(TiXmlElement* elem);
 
 private:
@@ -92,20 +93,33 @@ public:
     void removeHouse(uint32 houseId);
     HousePtr getHouse(uint32 houseId);
     HousePtr getHouseByName(const std::string& name);
+    HousePtr getHouseAt(const Position& pos);
 
     void load(const std::string& fileName);
     void save(const std::string& fileName);
 
     void sort();
-    void clear() { m_houses.clear(); }
+    void clear();
     HouseList getHouseList() { return m_houses; }
     HouseList filterHouses(uint32 townId);
 
 private:
     HouseList m_houses;
+    std::unordered_map<uint32, HousePtr> m_housesById;
+    // the name and town indexes follow the list order, a sort or a renamed house has them rebuilt on the next lookup
+    std::unordered_map<std::string, HousePtr> m_housesByName;
+    std::unordered_map<uint32, HouseList> m_housesByTown;
+    // houses having tiles in each tile block
+    std::unordered_map<uint64, std::vector<HousePtr>> m_houseBlocks;
+    stdext::boolean<false> m_indexDirty;
 
 protected:
     HouseList::iterator findHouse(uint32 houseId);
+    void indexHouseTile(House* house, const Position& pos);
+    void invalidateIndex(House* house);
+    void updateIndex();
+
+    friend class House;
 };
 
 extern HouseManager g_houses;
@@ -66,8 +66,9 @@ void Item::draw(const Point& dest, float scaleFactor, bool animate, const Highli
     const int animationPhase = calculateAnimationPhase(animate);
 
     // determine x,y,z patterns
-    int xPattern = 0, yPattern = 0, zPattern = 0;
-    calculatePatterns(xPattern, yPattern, zPattern);
+    if(m_patternsLoadCount != g_things.getDatLoadCount())
+        updatePatterns();
+    const int xPattern = m_patternX, yPattern = m_patternY, zPattern = m_patternZ;
 
     if(m_color != Color::alpha)
         color = m_color;
@@ -84,7 +85,7 @@ void Item::setId(uint32 id)
     if(!g_things.isValidDatId(id, ThingCategoryItem))
         id = 0;
     m_serverId = g_things.findItemTypeByClientId(id)->getServerId();
-    m_clientId = id;
+    setClientId(id);
 }
 
 void Item::setOtbId(uint16 id)
@@ -97,7 +98,25 @@ void Item::setOtbId(uint16 id)
     id = itemType->getClientId();
     if(!g_things.isValidDatId(id, ThingCategoryItem))
         id = 0;
+    setClientId(id);
+}
+
+void Item::setClientId(uint16 id)
+{
+    const TilePtr& tile = getTile();
+
+    // the map item index is keyed by client id, items kept elsewhere keep a stale position
+    const bool indexed = g_map.isItemIndexEnabled() && tile && m_clientId != id && tile->hasThing(static_self_cast<Item>());
+    if(indexed)
+        g_map.unindexItem(m_clientId, m_position);
+
     m_clientId = id;
+    if(indexed)
+        g_map.indexItem(m_clientId, m_position);
+
+    invalidatePatterns();
+    if(tile)
+        tile->invalidateDrawCommands();
 }
 
 bool Item::isValid()
@@ -105,32 +124,32 @@ bool Item::isValid()
     return g_things.isValidDatId(m_clientId, ThingCategoryItem);
 }
 
-void Item::unserializeItem(const BinaryTreePtr& in)
+void Item::unserializeItem(BinaryTreeView& in)
 {
     try {
-        while(in->canRead()) {
-            int attrib = in->getU8();
+        while(in.canRead()) {
+            int attrib = in.getU8();
             if(attrib == 0)
                 break;
 
             switch(attrib) {
             case ATTR_COUNT:
             case ATTR_RUNE_CHARGES:
-                setCount(in->getU8());
+                setCount(in.getU8());
                 break;
             case ATTR_CHARGES:
-                setCount(in->getU16());
+                setCount(in.getU16());
                 break;
             case ATTR_HOUSEDOORID:
             case ATTR_SCRIPTPROTECTED:
             case ATTR_DUALWIELD:
             case ATTR_DECAYING_STATE:
-                m_attribs.set(attrib, in->getU8());
+                m_attribs.set(attrib, in.getU8());
                 break;
             case ATTR_ACTION_ID:
             case ATTR_UNIQUE_ID:
             case ATTR_DEPOT_ID:
-                m_attribs.set(attrib, in->getU16());
+                m_attribs.set(attrib, in.getU16());
                 break;
             case ATTR_CONTAINER_ITEMS:
             case ATTR_ATTACK:
@@ -145,14 +164,14 @@ void Item::unserializeItem(const BinaryTreePtr& in)
             case ATTR_SLEEPERGUID:
             case ATTR_SLEEPSTART:
             case ATTR_ATTRIBUTE_MAP:
-                m_attribs.set(attrib, in->getU32());
+                m_attribs.set(attrib, in.getU32());
                 break;
             case ATTR_TELE_DEST:
             {
                 Position pos;
-                pos.x = in->getU16();
-                pos.y = in->getU16();
-                pos.z = in->getU8();
+                pos.x = in.getU16();
+                pos.y = in.getU16();
+                pos.z = in.getU8();
                 m_attribs.set(attrib, pos);
                 break;
             }
@@ -161,7 +180,7 @@ void Item::unserializeItem(const BinaryTreePtr& in)
             case ATTR_DESC:
             case ATTR_ARTICLE:
             case ATTR_WRITTENBY:
-                m_attribs.set(attrib, in->getString());
+                m_attribs.set(attrib, in.getString());
                 break;
             default:
                 stdext::throw_exception(stdext::format("invalid item attribute %d", attrib));
@@ -358,13 +377,23 @@ void Item::calculatePatterns(int& xPattern, int& yPattern, int& zPattern)
     }
 }
 
+void Item::updatePatterns()
+{
+    int xPattern = 0, yPattern = 0, zPattern = 0;
+    calculatePatterns(xPattern, yPattern, zPattern);
+    m_patternX = xPattern;
+    m_patternY = yPattern;
+    m_patternZ = zPattern;
+    m_patternsLoadCount = g_things.getDatLoadCount();
+}
+
 int Item::calculateAnimationPhase(bool animate)
 {
     if(!hasAnimationPhases()) return 0;
 
     if(!animate) return getAnimationPhases() - 1;
 
-    if(getAnimator() != nullptr) return getAnimator()->getPhase();
+    if(const AnimatorPtr& animator = getAnimator()) return animator->getPhase();
 
     if(m_async) {
         return (g_clock.millis() % (Otc::ITEM_TICKS_PER_FRAME * getAnimationPhases())) / Otc::ITEM_TICKS_PER_FRAME;
@@ -27,6 +27,7 @@
 #include "effect.h"
 #include "itemtype.h"
 #include "thing.h"
+#include <framework/core/stats.h>
 
 enum ItemAttr : uint8
 {
@@ -72,7 +73,7 @@ enum ItemAttr : uint8
 
 // @bindclass
 #pragma pack(push,1) // disable memory alignment
-class Item : public Thing
+class Item : public Thing, private StatsCounted<Item>
 {
 public:
     Item() = default;
@@ -85,9 +86,9 @@ public:
 
     void setId(uint32 id) override;
     void setOtbId(uint16 id);
-    void setCountOrSubType(int value) { m_countOrSubType = value; }
-    void setCount(int count) { m_countOrSubType = count; }
-    void setSubType(int subType) { m_countOrSubType = subType; }
+    void setCountOrSubType(int value) { m_countOrSubType = value; invalidatePatterns(); }
+    void setCount(int count) { m_countOrSubType = count; invalidatePatterns(); }
+    void setSubType(int subType) { m_countOrSubType = subType; invalidatePatterns(); }
     void setColor(const Color& c) { m_color = c; }
 
     int getCountOrSubType() { return m_countOrSubType; }
@@ -99,7 +100,7 @@ public:
     std::string getName();
     bool isValid();
 
-    void unserializeItem(const BinaryTreePtr& in);
+    void unserializeItem(BinaryTreeView& in);
     void serializeItem(const OutputBinaryTreePtr& out);
 
     void setDepotId(uint16 depotId) { m_attribs.set(ATTR_DEPOT_ID, depotId); }
@@ -141,13 +142,20 @@ public:
     void clearContainerItems() { m_containerItems.clear(); }
 
     void calculatePatterns(int& xPattern, int& yPattern, int& zPattern);
+    // hangable items also depend on the hooks of their tile, which invalidates them when those change
+    void invalidatePatterns() { m_patternsLoadCount = 0; }
     int calculateAnimationPhase(bool animate);
     int getExactSize(int layer = 0, int xPattern = 0, int yPattern = 0, int zPattern = 0, int animationPhase = 0) override;
 
     const ThingTypePtr& getThingType() override;
     ThingType* rawGetThingType() override;
 
+    void onPositionChange(const Position& /*newPos*/, const Position& /*oldPos*/) override { invalidatePatterns(); }
+
 private:
+    void updatePatterns();
+    void setClientId(uint16 id);
+
     uint16 m_clientId{ 0 };
     uint16 m_serverId{ 0 };
     uint8 m_countOrSubType{ 1 };
@@ -159,6 +167,10 @@ private:
     uint8 m_phase{ 0 };
     ticks_t m_lastPhase{ 0 };
 
+    // patterns drawn with, valid while m_patternsLoadCount matches the loaded thing types
+    uint8 m_patternX{ 0 }, m_patternY{ 0 }, m_patternZ{ 0 };
+    uint16 m_patternsLoadCount{ 0 };
+
     bool m_async{ true };
 };
 
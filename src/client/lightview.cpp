@@ -29,10 +29,16 @@
 #include "mapview.h"
 #include "map.h"
 
+// nearby lights of the same color are merged while the circle covering them grows at most this much
+const static float LIGHT_CLUSTER_TOLERANCE = 0.2f;
+const static int LIGHT_CLUSTER_TILES = 4;
+
 LightView::LightView(const MapViewPtr& mapView)
 {
     m_mapView = mapView;
     m_pool = g_drawPool.createPoolF(PoolType::LIGHT);
+    m_staticPool = g_drawPool.createPoolF(PoolType::STATIC_LIGHT);
+    m_staticPool->setOffscreen(true);
 
     generateLightTexture();
     generateShadeTexture();
@@ -85,13 +91,21 @@ void LightView::generateShadeTexture()
     m_shadeTexture->setSmooth(true);
 }
 
-void LightView::addLightSource(const Point& pos, const Light& light)
+void LightView::addLightSource(const Point& pos, const Light& light, const bool isStatic)
 {
+    if(m_recordedLights) {
+        m_recordedLights->push_back(RecordedLight{ pos - m_recordingOrigin, light, isStatic });
+        return;
+    }
+
     if(!isDark()) return;
 
+    // static lights are still in the framebuffer from the last rebuild
+    if(isStatic && !m_mustUpdateStaticLights) return;
+
     const uint16 radius = light.intensity * Otc::TILE_PIXELS * m_mapView->m_scaleFactor;
 
-    auto& lights = m_lights[m_currentFloor];
+    auto& lights = isStatic ? m_staticLights[m_currentFloor] : m_lights[m_currentFloor];
     if(!lights.empty()) {
         auto& prevLight = lights.back();
         if(prevLight.pos == pos && prevLight.color == light.color) {
@@ -103,7 +117,18 @@ void LightView::addLightSource(const Point& pos, const Light& light)
     lights.push_back(LightSource{ pos , light.color, radius, light.brightness });
 }
 
-void LightView::setShade(const Point& point, const std::vector<Otc::Direction> dirs)
+void LightView::setShade(const Point& point)
+{
+    size_t index = (m_mapView->m_drawDimension.width() * (point.y / m_mapView->m_tileSize)) + (point.x / m_mapView->m_tileSize);
+    if(index >= m_shades.size()) return;
+    auto& shade = m_shades[index];
+    shade.floor = m_currentFloor;
+    shade.pos = point;
+    // clearing keeps the capacity, shades are set for every ground on each static light update
+    shade.dirs.clear();
+}
+
+void LightView::setShade(const Point& point, const std::vector<Otc::Direction>& dirs)
 {
     size_t index = (m_mapView->m_drawDimension.width() * (point.y / m_mapView->m_tileSize)) + (point.x / m_mapView->m_tileSize);
     if(index >= m_shades.size()) return;
@@ -124,48 +149,233 @@ void LightView::clearShade(const Point& point)
 void LightView::resize()
 {
     m_pool->resize(m_mapView->m_rectDimension.size());
+    m_staticPool->resize(m_mapView->m_rectDimension.size());
     m_shades.resize(m_mapView->m_drawDimension.area());
+    requestStaticLightUpdate();
+
+    if(g_painter->hasShaders() && (!m_shadeGridTexture || m_shadeGridTexture->getSize() != m_mapView->m_drawDimension)) {
+        m_shadeGridTexture = TexturePtr(new Texture(m_mapView->m_drawDimension));
+        m_shadeGridTexture->setSmooth(true);
+    }
 }
 
 void LightView::draw(const Rect& dest, const Rect& src)
 {
     // draw light, only if there is darkness
     m_pool->setEnable(isDark());
+    m_staticPool->setEnable(isDark());
     if(!isDark()) return;
 
     const float intensity = m_globalLight.intensity / static_cast<float>(UINT8_MAX);
 
+    // painters without shaders can't draw per vertex colors, they draw every shade and light on its own
+    const bool batched = m_shadeGridTexture && g_painter->hasShaders();
+
+    if(m_mustUpdateStaticLights)
+        drawStaticLights(batched, intensity);
+
     g_drawPool.use(m_pool, dest, src);
+
+    // the static layer already holds the global light, replace the whole buffer with it
+    const auto& self = static_self_cast<LightView>();
+    g_drawPool.addAction([self] {
+        const auto& texture = self->m_staticPool->getTexture();
+        g_painter->setCompositionMode(Painter::CompositionMode_Replace);
+        g_painter->drawTexturedRect(self->m_mapView->m_rectDimension, texture, Rect(Point(), texture->getSize()));
+        g_painter->resetCompositionMode();
+    }, m_staticLightsVersion);
+
+    // creatures, missiles and effects move every frame, they are composited over the static layer
+    for(int_fast8_t z = m_mapView->m_floorMax; z >= m_mapView->m_floorMin; --z) {
+        auto& lights = m_lights[z];
+        if(lights.empty()) continue;
+
+        g_drawPool.startPosition();
+        clusterLights(lights);
+        std::sort(lights.begin(), lights.end(), orderLightComparator);
+        if(batched) addLightBatch(lights, m_lightBatches[z], intensity);
+        else drawLights(lights, intensity);
+        lights.clear();
+    }
+}
+
+void LightView::drawStaticLights(const bool batched, const float intensity)
+{
+    m_mustUpdateStaticLights = false;
+    ++m_staticLightsVersion;
+
+    g_drawPool.use(m_staticPool, Rect(), Rect());
     g_drawPool.addFilledRect(m_mapView->m_rectDimension, m_globalLightColor);
-    const auto& shadeBase = std::make_pair<Point, Size>(Point(m_mapView->getTileSize() / 2.8), Size(m_mapView->getTileSize() * 1.6));
     for(int_fast8_t z = m_mapView->m_floorMax; z >= m_mapView->m_floorMin; --z) {
         g_drawPool.startPosition();
-        {
-            if(z < m_mapView->m_floorMax) {
-                for(auto& shade : m_shades) {
-                    if(shade.floor != z) continue;
-                    shade.floor = -1;
-
-                    auto newPos = shade.pos;
-
-                    for(auto dir : shade.dirs) {
-                        if(dir == Otc::South)
-                            newPos.y -= Otc::TILE_PIXELS / 1.6;
-                        else if(dir == Otc::East)
-                            newPos.x -= Otc::TILE_PIXELS / 1.6;
-                    }
-
-                    g_drawPool.addRepeatedTexturedRect(Rect(newPos - shadeBase.first, shadeBase.second), m_shadeTexture, m_globalLightColor);
-                }
-            }
+        if(z < m_mapView->m_floorMax) {
+            if(batched) addShadeGrid(z);
+            else drawShades(z);
         }
 
-        auto& lights = m_lights[z];
+        auto& lights = m_staticLights[z];
+        clusterLights(lights);
         std::sort(lights.begin(), lights.end(), orderLightComparator);
-        for(LightSource& light : lights) {
-            if(light.brightness < 1.f) light.brightness = std::min<float>(light.brightness + intensity, 1.f);
-            g_drawPool.addTexturedRect(Rect(light.pos - Point(light.radius), Size(light.radius * 2)), m_lightTexture, Color::from8bit(light.color, light.brightness));
-        }
+        if(batched) addLightBatch(lights, m_staticLightBatches[z], intensity);
+        else drawLights(lights, intensity);
         lights.clear();
     }
 }
+
+void LightView::clusterLights(std::vector<LightSource>& lights)
+{
+    if(lights.size() < 2) return;
+
+    const int cellSize = std::max<int>(1, m_mapView->m_tileSize * LIGHT_CLUSTER_TILES);
+    const auto cellOf = [cellSize](int v) { return v >= 0 ? v / cellSize : (v + 1) / cellSize - 1; };
+
+    // the covering circle of two lights, none if it would be too much larger than the biggest of them
+    const auto merge = [](LightSource& into, const LightSource& light) {
+        const float dx = light.pos.x - into.pos.x,
+            dy = light.pos.y - into.pos.y,
+            distance = std::sqrt(dx * dx + dy * dy);
+
+        if(distance + light.radius <= into.radius)
+            return true;
+
+        if(distance + into.radius <= light.radius) {
+            into.pos = light.pos;
+            into.radius = light.radius;
+            return true;
+        }
+
+        const float radius = (distance + into.radius + light.radius) / 2.f;
+        if(radius > std::max<uint16>(into.radius, light.radius) * (1.f + LIGHT_CLUSTER_TOLERANCE))
+            return false;
+
+        const float shift = (radius - into.radius) / distance;
+        into.pos += Point(dx * shift, dy * shift);
+        into.radius = std::ceil(radius);
+        return true;
+    };
+
+    m_clusterCells.clear();
+    size_t count = 0;
+    for(const LightSource& light : lights) {
+        size_t key = 0;
+        boost::hash_combine(key, cellOf(light.pos.x));
+        boost::hash_combine(key, cellOf(light.pos.y));
+        boost::hash_combine(key, light.color);
+        boost::hash_combine(key, light.brightness);
+
+        const auto it = m_clusterCells.find(key);
+        if(it != m_clusterCells.end()) {
+            LightSource& cluster = lights[it->second];
+            if(cluster.color == light.color && cluster.brightness == light.brightness && merge(cluster, light))
+                continue;
+            it->second = count;
+        } else
+            m_clusterCells.emplace(key, count);
+
+        lights[count++] = light;
+    }
+    lights.resize(count);
+}
+
+void LightView::drawShades(const int8 z)
+{
+    const auto& shadeBase = std::make_pair<Point, Size>(Point(m_mapView->getTileSize() / 2.8), Size(m_mapView->getTileSize() * 1.6));
+    for(auto& shade : m_shades) {
+        if(shade.floor != z) continue;
+        shade.floor = -1;
+
+        auto newPos = shade.pos;
+
+        for(auto dir : shade.dirs) {
+            if(dir == Otc::South)
+                newPos.y -= Otc::TILE_PIXELS / 1.6;
+            else if(dir == Otc::East)
+                newPos.x -= Otc::TILE_PIXELS / 1.6;
+        }
+
+        g_drawPool.addRepeatedTexturedRect(Rect(newPos - shadeBase.first, shadeBase.second), m_shadeTexture, m_globalLightColor);
+    }
+}
+
+void LightView::drawLights(std::vector<LightSource>& lights, const float intensity)
+{
+    for(LightSource& light : lights) {
+        if(light.brightness < 1.f) light.brightness = std::min<float>(light.brightness + intensity, 1.f);
+        g_drawPool.addTexturedRect(Rect(light.pos - Point(light.radius), Size(light.radius * 2)), m_lightTexture, Color::from8bit(light.color, light.brightness));
+    }
+}
+
+void LightView::addShadeGrid(const int8 z)
+{
+    const Size& gridSize = m_shadeGridTexture->getGlSize();
+    const uint16 tileSize = m_mapView->m_tileSize;
+
+    auto& grid = m_shadeGrids[z];
+    grid.assign(static_cast<size_t>(gridSize.area()) * 4, 0);
+
+    size_t hash = 0;
+    for(auto& shade : m_shades) {
+        if(shade.floor != z) continue;
+        shade.floor = -1;
+
+        // the shade texel is the tile under the center of the shade block
+        Point center = shade.pos + Point(tileSize / 2);
+        for(auto dir : shade.dirs) {
+            if(dir == Otc::South)
+                center.y -= Otc::TILE_PIXELS / 1.6;
+            else if(dir == Otc::East)
+                center.x -= Otc::TILE_PIXELS / 1.6;
+        }
+
+        if(center.x < 0 || center.y < 0) continue;
+
+        const int x = center.x / tileSize, y = center.y / tileSize;
+        if(x >= m_mapView->m_drawDimension.width() || y >= m_mapView->m_drawDimension.height()) continue;
+
+        const size_t index = static_cast<size_t>(y * gridSize.width() + x);
+        grid[index * 4] = grid[index * 4 + 1] = grid[index * 4 + 2] = grid[index * 4 + 3] = 0xff;
+        boost::hash_combine(hash, index);
+    }
+
+    if(hash == 0) return;
+
+    const auto& self = static_self_cast<LightView>();
+    g_drawPool.addAction([self, z] {
+        self->m_shadeGridTexture->uploadSubPixels(Point(), self->m_shadeGridTexture->getGlSize(), self->m_shadeGrids[z].data());
+    }, hash);
+    g_drawPool.addTexturedRect(m_mapView->m_rectDimension, m_shadeGridTexture, Rect(Point(), m_mapView->m_drawDimension), m_globalLightColor);
+}
+
+void LightView::addLightBatch(std::vector<LightSource>& lights, LightBatch& batch, const float intensity)
+{
+    if(lights.empty()) return;
+
+    batch.coords.clear();
+    batch.colors.clear();
+    batch.colors.reserve(lights.size() * 6 * 4);
+
+    const Rect src(Point(), m_lightTexture->getSize());
+
+    size_t hash = 0;
+    for(LightSource& light : lights) {
+        if(light.brightness < 1.f) light.brightness = std::min<float>(light.brightness + intensity, 1.f);
+
+        const Rect dest(light.pos - Point(light.radius), Size(light.radius * 2));
+        const Color color = Color::from8bit(light.color, light.brightness);
+
+        // addRect emits two triangles, every vertex carries the light color
+        batch.coords.addRect(dest, src);
+        for(int i = -1; ++i < 6;)
+            batch.colors.insert(batch.colors.end(), { color.rF(), color.gF(), color.bF(), color.aF() });
+
+        boost::hash_combine(hash, dest.hash());
+        boost::hash_combine(hash, color.rgba());
+    }
+
+    // the batch lives in this view, which the closure keeps alive until the pool is drawn
+    const auto& self = static_self_cast<LightView>();
+    g_drawPool.addAction([self, &batch] {
+        g_painter->setTexture(self->m_lightTexture.get());
+        g_painter->drawColoredCoords(batch.coords, batch.colors.data());
+    }, hash);
+}
@@ -23,6 +23,7 @@
 #ifndef LIGHTVIEW_H
 #define LIGHTVIEW_H
 
+#include <framework/graphics/coordsbuffer.h>
 #include <framework/graphics/framebuffer.h>
 #include <framework/graphics/declarations.h>
 #include <framework/graphics/painter.h>
@@ -42,6 +43,19 @@ struct LightSource {
     float brightness;
 };
 
+// a light of a tile stack, relative to where the tile is drawn
+struct RecordedLight {
+    Point offset;
+    Light light;
+    bool isStatic;
+};
+
+// every light of a floor as one vertex array, drawn with a single call
+struct LightBatch {
+    CoordsBuffer coords;
+    std::vector<float> colors;
+};
+
 class LightView : public LuaObject
 {
 public:
@@ -49,13 +63,22 @@ public:
 
     void resize();
     void draw(const Rect& dest, const Rect& src);
-    void addLightSource(const Point& mainCenter, const Light& light);
+    void addLightSource(const Point& mainCenter, const Light& light, bool isStatic = false);
 
-    void setGlobalLight(const Light& light) { m_globalLight = light; m_globalLightColor = Color::from8bit(m_globalLight.color, m_globalLight.intensity / static_cast<float>(UINT8_MAX)); }
+    void setGlobalLight(const Light& light) { m_globalLight = light; m_globalLightColor = Color::from8bit(m_globalLight.color, m_globalLight.intensity / static_cast<float>(UINT8_MAX)); requestStaticLightUpdate(); }
     void setFloor(const uint8 floor) { m_currentFloor = floor; }
-    void setShade(const Point& point, const std::vector<Otc::Direction> dirs = std::vector<Otc::Direction>());
+    void setShade(const Point& point);
+    void setShade(const Point& point, const std::vector<Otc::Direction>& dirs);
     void clearShade(const Point& point);
 
+    // shades and item lights are kept in their own framebuffer, rebuilt only after tile, camera or global light changes
+    void requestStaticLightUpdate() { m_mustUpdateStaticLights = true; }
+    bool mustUpdateStaticLights() const { return m_mustUpdateStaticLights; }
+
+    // lights added in between go to the list, relative to origin, instead of being drawn
+    void startRecording(std::vector<RecordedLight>* lights, const Point& origin) { m_recordedLights = lights; m_recordingOrigin = origin; }
+    void stopRecording() { m_recordedLights = nullptr; }
+
     const Light& getGlobalLight() const { return m_globalLight; }
     bool isDark() const { return m_globalLight.intensity < 250; }
 
@@ -65,19 +88,44 @@ private:
     void generateLightTexture(),
         generateShadeTexture();
 
+    void drawStaticLights(bool batched, float intensity);
+    void drawShades(int8 z);
+    void drawLights(std::vector<LightSource>& lights, float intensity);
+
+    void clusterLights(std::vector<LightSource>& lights);
+    void addShadeGrid(int8 z);
+    void addLightBatch(std::vector<LightSource>& lights, LightBatch& batch, float intensity);
+
     TexturePtr m_lightTexture,
-        m_shadeTexture;
+        m_shadeTexture,
+        m_shadeGridTexture;
 
     Light m_globalLight;
     Color m_globalLightColor;
 
-    PoolFramedPtr m_pool;
+    PoolFramedPtr m_pool,
+        m_staticPool;
     MapViewPtr m_mapView;
 
     int8 m_currentFloor;
 
+    bool m_mustUpdateStaticLights{ true };
+    uint32 m_staticLightsVersion{ 0 };
+
+    std::vector<RecordedLight>* m_recordedLights{ nullptr };
+    Point m_recordingOrigin;
+
+    // last light kept in each grid cell, by cell, color and brightness
+    std::unordered_map<size_t, size_t> m_clusterCells;
+
     std::vector<ShadeBlock> m_shades;
-    std::array<std::vector<LightSource>, Otc::MAX_Z + 1> m_lights;
+    std::array<std::vector<LightSource>, Otc::MAX_Z + 1> m_lights,
+        m_staticLights;
+
+    // one texel per tile, uploaded right before the floor is drawn
+    std::array<std::vector<uint8>, Otc::MAX_Z + 1> m_shadeGrids;
+    std::array<LightBatch, Otc::MAX_Z + 1> m_lightBatches,
+        m_staticLightBatches;
 };
 
 #endif
@@ -24,6 +24,7 @@
 #include <framework/core/eventdispatcher.h>
 #include <framework/graphics/graphics.h>
 #include "game.h"
+#include "gamestateexport.h"
 #include "map.h"
 #include "tile.h"
 
@@ -73,7 +74,9 @@ bool LocalPlayer::canWalk(Otc::Direction)
         return false;
 
     if(!isAutoWalking()) {
-        if(isPreWalking() && g_game.getClientVersion() >= 860) return false;
+        // while pre-walking, further steps are predicted one step duration apart up to the prediction depth
+        if(isPreWalking() || m_walkPredictor.hasSteps())
+            return m_walkPredictor.canPredict() && g_clock.millis() - m_walkPredictor.getLastStepTime() >= getStepDuration();
 
         if(m_forceWalk) m_forceWalk = false;
         else {
@@ -88,6 +91,8 @@ bool LocalPlayer::canWalk(Otc::Direction)
 
 void LocalPlayer::walk(const Position& oldPos, const Position& newPos)
 {
+    const bool predicted = m_walkPredictor.confirm(oldPos, newPos);
+
     // a prewalk was going on
     if(m_preWalking) {
         // switch to normal walking
@@ -101,10 +106,13 @@ void LocalPlayer::walk(const Position& oldPos, const Position& newPos)
         }
     }
     // no prewalk was going on, this must be an server side automated walk
+    // or a predicted step confirmed before its animation started
     else {
-        m_serverWalking = true;
-        if(m_serverWalkEndEvent)
-            m_serverWalkEndEvent->cancel();
+        if(!predicted) {
+            m_serverWalking = true;
+            if(m_serverWalkEndEvent)
+                m_serverWalkEndEvent->cancel();
+        }
 
         Creature::walk(oldPos, newPos);
     }
@@ -122,17 +130,34 @@ void LocalPlayer::preWalk(Otc::Direction direction)
     if(m_serverWalkEndEvent)
         m_serverWalkEndEvent->cancel();
 
+    // queued steps were predicted when they were sent
+    WalkPredictor::Step* step = m_walkPredictor.getNextStep(m_position);
+    if(step && step->direction == direction)
+        step->animated = true;
+    else
+        m_walkPredictor.predict(direction, m_position, true);
+
     // start walking to direction
     const Position newPos = m_position.translatedToDirection(direction);
     m_lastPrewalkDestination = newPos;
     Creature::walk(m_position, newPos);
 }
 
+void LocalPlayer::queueWalk(Otc::Direction direction)
+{
+    m_walkPredictor.predict(direction, getPredictedPosition(), false);
+}
+
 void LocalPlayer::cancelWalk(Otc::Direction direction)
 {
     // only cancel client side walks
-    if(m_walking && m_preWalking)
+    if(m_walking && m_preWalking) {
+        startCameraCorrection();
         stopWalk();
+    }
+
+    // the server refused the oldest step, the ones sent after it are refused as well
+    m_walkPredictor.rollback();
 
     lockWalk();
 
@@ -179,7 +204,7 @@ bool LocalPlayer::autoWalk(const Position& destination)
 
     // try to find a path that we know
     if(tryKnownPath || m_knownCompletePath) {
-        result = g_map.findPath(m_position, destination, 25000, 0);
+        result = m_autoWalkPlan.find(m_position, destination, 25000, 0);
         if(std::get<1>(result) == Otc::PathFindResultOk) {
             limitedPath = std::get<0>(result);
             // limit to 127 steps
@@ -191,7 +216,7 @@ bool LocalPlayer::autoWalk(const Position& destination)
 
     // no known path found, try to discover one
     if(limitedPath.empty()) {
-        result = g_map.findPath(m_position, destination, 25000, Otc::PathFindAllowNotSeenTiles);
+        result = m_autoWalkPlan.find(m_position, destination, 25000, Otc::PathFindAllowNotSeenTiles);
         if(std::get<1>(result) != Otc::PathFindResultOk) {
             callLuaField("onAutoWalkFail", std::get<1>(result));
             stopAutoWalk();
@@ -219,6 +244,7 @@ void LocalPlayer::stopAutoWalk()
     m_autoWalkDestination = Position();
     m_lastAutoWalkPosition = Position();
     m_knownCompletePath = false;
+    m_autoWalkPlan.clear();
 
     if(m_autoWalkContinueEvent)
         m_autoWalkContinueEvent->cancel();
@@ -226,6 +252,9 @@ void LocalPlayer::stopAutoWalk()
 
 void LocalPlayer::stopWalk()
 {
+    // nothing predicted survives a stop, it must not be animated by terminateWalk
+    m_walkPredictor.rollback();
+
     Creature::stopWalk(); // will call terminateWalk
 
     m_lastPrewalkDestination = Position();
@@ -266,6 +295,47 @@ void LocalPlayer::terminateWalk()
             self->m_serverWalking = false;
         }, 100);
     }
+
+    // the next predicted step is already on its way to the server, animate it without waiting for the confirmation
+    if(const WalkPredictor::Step* step = m_walkPredictor.getNextStep(m_position))
+        preWalk(step->direction);
+}
+
+Point LocalPlayer::getCameraOffset()
+{
+    if(m_cameraCorrectionDirection == Otc::InvalidDirection)
+        return m_walkOffset;
+
+    const float remaining = 1.f - std::min<float>(m_cameraCorrectionTimer.ticksElapsed() / static_cast<float>(WalkPredictor::CORRECTION_DURATION), 1.f);
+    return m_walkOffset + m_cameraCorrection * remaining;
+}
+
+void LocalPlayer::updateAnimations()
+{
+    Creature::updateAnimations();
+
+    if(!(m_animations & AnimationCameraCorrection))
+        return;
+
+    if(m_cameraCorrectionTimer.ticksElapsed() >= WalkPredictor::CORRECTION_DURATION) {
+        m_cameraCorrection = Point();
+        m_cameraCorrectionDirection = Otc::InvalidDirection;
+        stopAnimation(AnimationCameraCorrection);
+    }
+
+    g_map.notificateCameraMove(getCameraOffset());
+}
+
+void LocalPlayer::startCameraCorrection()
+{
+    const Point offset = getCameraOffset();
+    if(offset.isNull())
+        return;
+
+    m_cameraCorrection = offset;
+    m_cameraCorrectionDirection = m_direction;
+    m_cameraCorrectionTimer.restart();
+    startAnimation(AnimationCameraCorrection);
 }
 
 void LocalPlayer::onPositionChange(const Position& newPos, const Position& oldPos)
@@ -289,6 +359,7 @@ void LocalPlayer::setStates(int states)
         m_states = states;
 
         callLuaField("onStatesChange", states, oldStates);
+        g_gameStateExport.invalidate();
     }
 }
 
@@ -334,6 +405,7 @@ void LocalPlayer::setHealth(double health, double maxHealth)
         m_maxHealth = maxHealth;
 
         callLuaField("onHealthChange", health, maxHealth, oldHealth, oldMaxHealth);
+        g_gameStateExport.invalidate();
 
         // cannot walk while dying
         if(health == 0) {
@@ -351,6 +423,7 @@ void LocalPlayer::setFreeCapacity(double freeCapacity)
         m_freeCapacity = freeCapacity;
 
         callLuaField("onFreeCapacityChange", freeCapacity, oldFreeCapacity);
+        g_gameStateExport.invalidate();
     }
 }
 
@@ -371,6 +444,7 @@ void LocalPlayer::setExperience(double experience)
         m_experience = experience;
 
         callLuaField("onExperienceChange", experience, oldExperience);
+        g_gameStateExport.invalidate();
     }
 }
 
@@ -383,6 +457,7 @@ void LocalPlayer::setLevel(double level, double levelPercent)
         m_levelPercent = levelPercent;
 
         callLuaField("onLevelChange", level, levelPercent, oldLevel, oldLevelPercent);
+        g_gameStateExport.invalidate();
     }
 }
 
@@ -395,6 +470,7 @@ void LocalPlayer::setMana(double mana, double maxMana)
         m_maxMana = maxMana;
 
         callLuaField("onManaChange", mana, maxMana, oldMana, oldMaxMana);
+        g_gameStateExport.invalidate();
     }
 }
 
@@ -427,6 +503,7 @@ void LocalPlayer::setSoul(double soul)
         m_soul = soul;
 
         callLuaField("onSoulChange", soul, oldSoul);
+        g_gameStateExport.invalidate();
     }
 }
 
@@ -23,7 +23,9 @@
 #ifndef LOCALPLAYER_H
 #define LOCALPLAYER_H
 
+#include "pathfinder.h"
 #include "player.h"
+#include "walkpredictor.h"
 
  // @bindclass
 class LocalPlayer : public Player
@@ -41,6 +43,16 @@ public:
     bool autoWalk(const Position& destination);
     bool canWalk(Otc::Direction direction);
 
+    // steps sent ahead of the server confirmation, 1 only pre-walks the step being animated
+    void setWalkPredictionDepth(int depth) { m_walkPredictor.setDepth(depth); }
+    int getWalkPredictionDepth() { return m_walkPredictor.getDepth(); }
+    int getPredictedStepCount() { return m_walkPredictor.getStepCount(); }
+    bool hasPredictedSteps() { return m_walkPredictor.hasSteps(); }
+    // smoothed time between sending a step and its confirmation
+    int getWalkLatency() { return m_walkPredictor.getLatency(); }
+    int getWalkRollbackCount() { return m_walkPredictor.getRollbackCount(); }
+    Position getPredictedPosition() { return m_walkPredictor.getPredictedPosition(m_position); }
+
     void setStates(int states);
     void setSkill(Otc::Skill skill, int level, int levelPercent);
     void setBaseSkill(Otc::Skill skill, int baseLevel);
@@ -94,6 +106,8 @@ public:
     bool isPreWalking() { return m_preWalking; }
     bool isAutoWalking() { return m_autoWalkDestination.isValid(); }
     bool isServerWalking() { return m_serverWalking; }
+    bool isCorrectingCamera() { return m_cameraCorrectionDirection != Otc::InvalidDirection; }
+    Otc::Direction getCameraCorrectionDirection() { return m_cameraCorrectionDirection; }
     bool isPremium() { return m_premium; }
     bool isPendingGame() { return m_pending; }
 
@@ -102,9 +116,14 @@ public:
 
     void onPositionChange(const Position& newPos, const Position& oldPos) override;
 
+    Point getCameraOffset() override;
+    void updateAnimations() override;
+
 protected:
     void walk(const Position& oldPos, const Position& newPos) override;
     void preWalk(Otc::Direction direction);
+    // sends a step after the predicted ones, it is animated once the steps before it are done
+    void queueWalk(Otc::Direction direction);
     void cancelWalk(Otc::Direction direction = Otc::InvalidDirection);
     void stopWalk() override;
     void updateWalk(const bool /*isPreWalking*/ = false) override { Creature::updateWalk(m_preWalking); }
@@ -116,6 +135,8 @@ protected:
     void terminateWalk() override;
 
 private:
+    void startCameraCorrection();
+
     // walk related
     Position m_lastPrewalkDestination;
     Position m_autoWalkDestination;
@@ -126,6 +147,14 @@ private:
     stdext::boolean<false> m_preWalking;
     stdext::boolean<false> m_serverWalking;
     stdext::boolean<false> m_knownCompletePath;
+    // repeated requests towards the same destination only search around the steps blocked since
+    PathPlan m_autoWalkPlan;
+    WalkPredictor m_walkPredictor;
+
+    // the camera eases back from a cancelled pre-walk instead of jumping
+    Point m_cameraCorrection;
+    Otc::Direction m_cameraCorrectionDirection{ Otc::InvalidDirection };
+    Timer m_cameraCorrectionTimer;
 
     stdext::boolean<false> m_premium;
     stdext::boolean<false> m_known;
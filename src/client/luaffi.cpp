@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "luaffi.h"
+#include "creature.h"
+#include "item.h"
+#include "map.h"
+#include "tile.h"
+
+int otc_thing_get_position(LuaObject* object, otc_position* position)
+{
+    Thing* thing = dynamic_cast<Thing*>(object);
+    if(!thing)
+        return 0;
+
+    const Position pos = thing->getPosition();
+    if(!pos.isValid())
+        return 0;
+
+    position->x = pos.x;
+    position->y = pos.y;
+    position->z = pos.z;
+    return 1;
+}
+
+uint32 otc_creature_get_id(LuaObject* object)
+{
+    Creature* creature = dynamic_cast<Creature*>(object);
+    return creature ? creature->getId() : 0;
+}
+
+int otc_creature_get_health_percent(LuaObject* object)
+{
+    Creature* creature = dynamic_cast<Creature*>(object);
+    return creature ? creature->getHealthPercent() : -1;
+}
+
+uint32 otc_item_get_id(LuaObject* object)
+{
+    Item* item = dynamic_cast<Item*>(object);
+    return item ? item->getId() : 0;
+}
+
+int otc_item_get_count(LuaObject* object)
+{
+    Item* item = dynamic_cast<Item*>(object);
+    return item ? item->getCount() : -1;
+}
+
+int otc_tile_get_flags(LuaObject* object, uint32* flags)
+{
+    Tile* tile = dynamic_cast<Tile*>(object);
+    if(!tile)
+        return 0;
+
+    *flags = tile->getFlags();
+    return 1;
+}
+
+int otc_map_get_tile_flags(uint16 x, uint16 y, uint8 z, uint32* flags)
+{
+    const TilePtr& tile = g_map.getTile(Position(x, y, z));
+    if(!tile)
+        return 0;
+
+    *flags = tile->getFlags();
+    return 1;
+}
+
+int otc_map_is_walkable(uint16 x, uint16 y, uint8 z, int ignoreCreatures)
+{
+    const TilePtr& tile = g_map.getTile(Position(x, y, z));
+    return tile && tile->isWalkable(ignoreCreatures != 0);
+}
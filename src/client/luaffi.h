@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LUAFFI_H
+#define LUAFFI_H
+
+#include "declarations.h"
+#include <framework/luaengine/declarations.h>
+
+// plain C accessors for LuaJIT's ffi.C, see modules/gamelib/fastaccess.lua for the matching cdef
+// objects are passed as the LuaObject* stored in their userdata, a wrong class reads as a failure
+#ifdef _WIN32
+#define OTC_FFI_EXPORT extern "C" __declspec(dllexport)
+#else
+#define OTC_FFI_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+struct otc_position {
+    uint16 x;
+    uint16 y;
+    uint8 z;
+};
+
+OTC_FFI_EXPORT int otc_thing_get_position(LuaObject* object, otc_position* position);
+OTC_FFI_EXPORT uint32 otc_creature_get_id(LuaObject* object);
+OTC_FFI_EXPORT int otc_creature_get_health_percent(LuaObject* object);
+OTC_FFI_EXPORT uint32 otc_item_get_id(LuaObject* object);
+OTC_FFI_EXPORT int otc_item_get_count(LuaObject* object);
+OTC_FFI_EXPORT int otc_tile_get_flags(LuaObject* object, uint32* flags);
+OTC_FFI_EXPORT int otc_map_get_tile_flags(uint16 x, uint16 y, uint8 z, uint32* flags);
+OTC_FFI_EXPORT int otc_map_is_walkable(uint16 x, uint16 y, uint8 z, int ignoreCreatures);
+
+#endif
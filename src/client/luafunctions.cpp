@@ -26,19 +26,25 @@
 #include "creature.h"
 #include "effect.h"
 #include "game.h"
+#include "gamestateexport.h"
 #include "houses.h"
 #include "item.h"
 #include "localplayer.h"
 #include "luavaluecasts.h"
 #include "map.h"
+#include "marketofferstore.h"
 #include "minimap.h"
 #include "missile.h"
+#include "opcodeprofiler.h"
 #include "outfit.h"
+#include "outfitpreview.h"
 #include "player.h"
 #include "protocolgame.h"
 #include "shadermanager.h"
+#include "spectatortracker.h"
 #include "spritemanager.h"
 #include "statictext.h"
+#include "thingtexturecache.h"
 #include "thingtypemanager.h"
 #include "tile.h"
 #include "towns.h"
@@ -54,6 +60,8 @@
 
 void Client::registerLuaFunctions()
 {
+    register_client_luavaluetypes();
+
     g_lua.registerSingletonClass("g_things");
     g_lua.bindSingletonFunction("g_things", "loadDat", &ThingTypeManager::loadDat, &g_things);
     g_lua.bindSingletonFunction("g_things", "saveDat", &ThingTypeManager::saveDat, &g_things);
@@ -71,8 +79,11 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_things", "findItemTypeByName", &ThingTypeManager::findItemTypeByName, &g_things);
     g_lua.bindSingletonFunction("g_things", "findItemTypesByName", &ThingTypeManager::findItemTypesByName, &g_things);
     g_lua.bindSingletonFunction("g_things", "findItemTypesByString", &ThingTypeManager::findItemTypesByString, &g_things);
+    g_lua.bindSingletonFunction("g_things", "searchItemTypes", &ThingTypeManager::searchItemTypes, &g_things);
     g_lua.bindSingletonFunction("g_things", "findItemTypeByCategory", &ThingTypeManager::findItemTypeByCategory, &g_things);
     g_lua.bindSingletonFunction("g_things", "findThingTypeByAttr", &ThingTypeManager::findThingTypeByAttr, &g_things);
+    g_lua.bindSingletonFunction("g_things", "getTexturePrewarmProgress", &ThingTypeManager::getTexturePrewarmProgress, &g_things);
+    g_lua.bindSingletonFunction("g_things", "isPrewarmingTextures", &ThingTypeManager::isPrewarmingTextures, &g_things);
 
     g_lua.registerSingletonClass("g_houses");
     g_lua.bindSingletonFunction("g_houses", "clear", &HouseManager::clear, &g_houses);
@@ -80,6 +91,7 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_houses", "save", &HouseManager::save, &g_houses);
     g_lua.bindSingletonFunction("g_houses", "getHouse", &HouseManager::getHouse, &g_houses);
     g_lua.bindSingletonFunction("g_houses", "getHouseByName", &HouseManager::getHouseByName, &g_houses);
+    g_lua.bindSingletonFunction("g_houses", "getHouseAt", &HouseManager::getHouseAt, &g_houses);
     g_lua.bindSingletonFunction("g_houses", "addHouse", &HouseManager::addHouse, &g_houses);
     g_lua.bindSingletonFunction("g_houses", "removeHouse", &HouseManager::removeHouse, &g_houses);
     g_lua.bindSingletonFunction("g_houses", "getHouseList", &HouseManager::getHouseList, &g_houses);
@@ -94,6 +106,37 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_towns", "getTowns", &TownManager::getTowns, &g_towns);
     g_lua.bindSingletonFunction("g_towns", "sort", &TownManager::sort, &g_towns);
 
+    g_lua.registerSingletonClass("g_opcodeProfiler");
+    g_lua.bindSingletonFunction("g_opcodeProfiler", "setEnabled", &OpcodeProfiler::setEnabled, &g_opcodeProfiler);
+    g_lua.bindSingletonFunction("g_opcodeProfiler", "isEnabled", &OpcodeProfiler::isEnabled, &g_opcodeProfiler);
+    g_lua.bindSingletonFunction("g_opcodeProfiler", "reset", &OpcodeProfiler::reset, &g_opcodeProfiler);
+    g_lua.bindSingletonFunction("g_opcodeProfiler", "getStats", &OpcodeProfiler::getStats, &g_opcodeProfiler);
+    g_lua.bindSingletonFunction("g_opcodeProfiler", "dumpCsv", &OpcodeProfiler::dumpCsv, &g_opcodeProfiler);
+
+    g_lua.registerSingletonClass("g_gameStateExport");
+    g_lua.bindSingletonFunction("g_gameStateExport", "start", &GameStateExport::start, &g_gameStateExport);
+    g_lua.bindSingletonFunction("g_gameStateExport", "stop", &GameStateExport::stop, &g_gameStateExport);
+    g_lua.bindSingletonFunction("g_gameStateExport", "isRunning", &GameStateExport::isRunning, &g_gameStateExport);
+    g_lua.bindSingletonFunction("g_gameStateExport", "getSegmentName", &GameStateExport::getSegmentName, &g_gameStateExport);
+    g_lua.bindSingletonFunction("g_gameStateExport", "getSnapshotCount", &GameStateExport::getSnapshotCount, &g_gameStateExport);
+
+    g_lua.registerSingletonClass("g_spectatorTracker");
+    g_lua.bindSingletonFunction("g_spectatorTracker", "setEnabled", &SpectatorTracker::setEnabled, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "isEnabled", &SpectatorTracker::isEnabled, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "setFilters", &SpectatorTracker::setFilters, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "getFilters", &SpectatorTracker::getFilters, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "setSortType", &SpectatorTracker::setSortType, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "getSortType", &SpectatorTracker::getSortType, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "setSortDescending", &SpectatorTracker::setSortDescending, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "isSortDescending", &SpectatorTracker::isSortDescending, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "setRange", &SpectatorTracker::setRange, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "setFloorRange", &SpectatorTracker::setFloorRange, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "getFloorRange", &SpectatorTracker::getFloorRange, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "getSpectators", &SpectatorTracker::getSpectators, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "getSpectatorIndex", &SpectatorTracker::getSpectatorIndex, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "refresh", &SpectatorTracker::refresh, &g_spectatorTracker);
+    g_lua.bindSingletonFunction("g_spectatorTracker", "clear", &SpectatorTracker::clear, &g_spectatorTracker);
+
     g_lua.registerSingletonClass("g_sprites");
     g_lua.bindSingletonFunction("g_sprites", "loadSpr", &SpriteManager::loadSpr, &g_sprites);
     g_lua.bindSingletonFunction("g_sprites", "saveSpr", &SpriteManager::saveSpr, &g_sprites);
@@ -101,6 +144,24 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_sprites", "isLoaded", &SpriteManager::isLoaded, &g_sprites);
     g_lua.bindSingletonFunction("g_sprites", "getSprSignature", &SpriteManager::getSignature, &g_sprites);
     g_lua.bindSingletonFunction("g_sprites", "getSpritesCount", &SpriteManager::getSpritesCount, &g_sprites);
+    g_lua.bindSingletonFunction("g_sprites", "setAsyncDecoding", &SpriteManager::setAsyncDecoding, &g_sprites);
+    g_lua.bindSingletonFunction("g_sprites", "isAsyncDecoding", &SpriteManager::isAsyncDecoding, &g_sprites);
+    g_lua.bindSingletonFunction("g_sprites", "setSharedCache", &SpriteManager::setSharedCache, &g_sprites);
+    g_lua.bindSingletonFunction("g_sprites", "isSharedCache", &SpriteManager::isSharedCache, &g_sprites);
+    g_lua.bindSingletonFunction("g_sprites", "getSharedCacheStatistics", &SpriteManager::getSharedCacheStatistics, &g_sprites);
+    g_lua.bindSingletonFunction("g_sprites", "benchmarkDecoding", &SpriteManager::benchmarkDecoding, &g_sprites);
+
+    g_lua.registerSingletonClass("g_thingTextureCache");
+    g_lua.bindSingletonFunction("g_thingTextureCache", "setEnabled", &ThingTextureCache::setEnabled, &g_thingTextureCache);
+    g_lua.bindSingletonFunction("g_thingTextureCache", "isEnabled", &ThingTextureCache::isEnabled, &g_thingTextureCache);
+    g_lua.bindSingletonFunction("g_thingTextureCache", "flush", &ThingTextureCache::flush, &g_thingTextureCache);
+    g_lua.bindSingletonFunction("g_thingTextureCache", "clear", &ThingTextureCache::clear, &g_thingTextureCache);
+    g_lua.bindSingletonFunction("g_thingTextureCache", "getStatistics", &ThingTextureCache::getStatistics, &g_thingTextureCache);
+
+    g_lua.registerSingletonClass("g_outfitPreviews");
+    g_lua.bindSingletonFunction("g_outfitPreviews", "prefetch", &OutfitPreviews::prefetch, &g_outfitPreviews);
+    g_lua.bindSingletonFunction("g_outfitPreviews", "clear", &OutfitPreviews::clear, &g_outfitPreviews);
+    g_lua.bindSingletonFunction("g_outfitPreviews", "getStatistics", &OutfitPreviews::getStatistics, &g_outfitPreviews);
 
     g_lua.registerSingletonClass("g_map");
     g_lua.bindSingletonFunction("g_map", "isLookPossible", &Map::isLookPossible, &g_map);
@@ -117,14 +178,28 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_map", "cleanTexts", &Map::cleanTexts, &g_map);
     g_lua.bindSingletonFunction("g_map", "getTile", &Map::getTile, &g_map);
     g_lua.bindSingletonFunction("g_map", "getTiles", &Map::getTiles, &g_map);
+    g_lua.bindSingletonFunction("g_map", "getTileMemoryUsage", &Map::getTileMemoryUsage, &g_map);
+    g_lua.bindSingletonFunction("g_map", "prewarmTextures", &Map::prewarmTextures, &g_map);
     g_lua.bindSingletonFunction("g_map", "setCentralPosition", &Map::setCentralPosition, &g_map);
     g_lua.bindSingletonFunction("g_map", "getCentralPosition", &Map::getCentralPosition, &g_map);
     g_lua.bindSingletonFunction("g_map", "getCreatureById", &Map::getCreatureById, &g_map);
     g_lua.bindSingletonFunction("g_map", "removeCreatureById", &Map::removeCreatureById, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setCreatureCacheTime", &Map::setCreatureCacheTime, &g_map);
+    g_lua.bindSingletonFunction("g_map", "getCreatureCacheTime", &Map::getCreatureCacheTime, &g_map);
     g_lua.bindSingletonFunction("g_map", "getSpectators", &Map::getSpectators, &g_map);
+    g_lua.bindSingletonFunction("g_map", "getSpectatorsInRange", &Map::getSpectatorsInRange, &g_map);
+    g_lua.bindSingletonFunction("g_map", "getSpectatorsInRangeEx", &Map::getSpectatorsInRangeEx, &g_map);
     g_lua.bindSingletonFunction("g_map", "findPath", &Map::findPath, &g_map);
+    g_lua.bindSingletonFunction("g_map", "findPathAsync", &Map::findPathAsync, &g_map);
+    g_lua.bindSingletonFunction("g_map", "findRoute", &Map::findRoute, &g_map);
     g_lua.bindSingletonFunction("g_map", "loadOtbm", &Map::loadOtbm, &g_map);
+    g_lua.bindSingletonFunction("g_map", "loadOtbmAsync", &Map::loadOtbmAsync, &g_map);
+    g_lua.bindSingletonFunction("g_map", "loadOtbmRegion", &Map::loadOtbmRegion, &g_map);
+    g_lua.bindSingletonFunction("g_map", "cancelOtbmLoad", &Map::cancelOtbmLoad, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isLoadingOtbm", &Map::isLoadingOtbm, &g_map);
     g_lua.bindSingletonFunction("g_map", "saveOtbm", &Map::saveOtbm, &g_map);
+    g_lua.bindSingletonFunction("g_map", "saveOtbmAsync", &Map::saveOtbmAsync, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isSavingOtbm", &Map::isSavingOtbm, &g_map);
     g_lua.bindSingletonFunction("g_map", "loadOtcm", &Map::loadOtcm, &g_map);
     g_lua.bindSingletonFunction("g_map", "saveOtcm", &Map::saveOtcm, &g_map);
     g_lua.bindSingletonFunction("g_map", "getHouseFile", &Map::getHouseFile, &g_map);
@@ -153,6 +228,9 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_map", "beginGhostMode", &Map::beginGhostMode, &g_map);
     g_lua.bindSingletonFunction("g_map", "endGhostMode", &Map::endGhostMode, &g_map);
     g_lua.bindSingletonFunction("g_map", "findItemsById", &Map::findItemsById, &g_map);
+    g_lua.bindSingletonFunction("g_map", "findItemsByIdInArea", &Map::findItemsByIdInArea, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setItemIndexEnabled", &Map::setItemIndexEnabled, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isItemIndexEnabled", &Map::isItemIndexEnabled, &g_map);
     g_lua.bindSingletonFunction("g_map", "setFloatingEffect", &Map::setFloatingEffect, &g_map);
     g_lua.bindSingletonFunction("g_map", "isDrawingFloatingEffects", &Map::isDrawingFloatingEffects, &g_map);
 
@@ -162,6 +240,8 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_minimap", "saveImage", &Minimap::saveImage, &g_minimap);
     g_lua.bindSingletonFunction("g_minimap", "loadOtmm", &Minimap::loadOtmm, &g_minimap);
     g_lua.bindSingletonFunction("g_minimap", "saveOtmm", &Minimap::saveOtmm, &g_minimap);
+    g_lua.bindSingletonFunction("g_minimap", "setAutoSave", &Minimap::setAutoSave, &g_minimap);
+    g_lua.bindSingletonFunction("g_minimap", "isSavingOtmm", &Minimap::isSavingOtmm, &g_minimap);
 
     g_lua.registerSingletonClass("g_creatures");
     g_lua.bindSingletonFunction("g_creatures", "getCreatures", &CreatureManager::getCreatures, &g_creatures);
@@ -184,6 +264,7 @@ void Client::registerLuaFunctions()
 
     g_lua.registerSingletonClass("g_game");
     g_lua.bindSingletonFunction("g_game", "loginWorld", &Game::loginWorld, &g_game);
+    g_lua.bindSingletonFunction("g_game", "playRecording", &Game::playRecording, &g_game);
     g_lua.bindSingletonFunction("g_game", "cancelLogin", &Game::cancelLogin, &g_game);
     g_lua.bindSingletonFunction("g_game", "forceLogout", &Game::forceLogout, &g_game);
     g_lua.bindSingletonFunction("g_game", "safeLogout", &Game::safeLogout, &g_game);
@@ -191,6 +272,8 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_game", "setScheduleLastWalk", &Game::setScheduleLastWalk, &g_game);
     g_lua.bindSingletonFunction("g_game", "autoWalk", &Game::autoWalk, &g_game);
     g_lua.bindSingletonFunction("g_game", "forceWalk", &Game::forceWalk, &g_game);
+    g_lua.bindSingletonFunction("g_game", "setSimulatedWalkLatency", &Game::setSimulatedWalkLatency, &g_game);
+    g_lua.bindSingletonFunction("g_game", "getSimulatedWalkLatency", &Game::getSimulatedWalkLatency, &g_game);
     g_lua.bindSingletonFunction("g_game", "turn", &Game::turn, &g_game);
     g_lua.bindSingletonFunction("g_game", "stop", &Game::stop, &g_game);
     g_lua.bindSingletonFunction("g_game", "look", &Game::look, &g_game);
@@ -277,6 +360,7 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_game", "isFollowing", &Game::isFollowing, &g_game);
     g_lua.bindSingletonFunction("g_game", "isConnectionOk", &Game::isConnectionOk, &g_game);
     g_lua.bindSingletonFunction("g_game", "getPing", &Game::getPing, &g_game);
+    g_lua.bindSingletonFunction("g_game", "getNetworkStats", &Game::getNetworkStats, &g_game);
     g_lua.bindSingletonFunction("g_game", "getContainer", &Game::getContainer, &g_game);
     g_lua.bindSingletonFunction("g_game", "getContainers", &Game::getContainers, &g_game);
     g_lua.bindSingletonFunction("g_game", "getVips", &Game::getVips, &g_game);
@@ -285,6 +369,10 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_game", "getServerBeat", &Game::getServerBeat, &g_game);
     g_lua.bindSingletonFunction("g_game", "getLocalPlayer", &Game::getLocalPlayer, &g_game);
     g_lua.bindSingletonFunction("g_game", "getProtocolGame", &Game::getProtocolGame, &g_game);
+    g_lua.bindSingletonFunction("g_game", "setCoalesceCreatureUpdates", &Game::setCoalesceCreatureUpdates, &g_game);
+    g_lua.bindSingletonFunction("g_game", "isCoalescingCreatureUpdates", &Game::isCoalescingCreatureUpdates, &g_game);
+    g_lua.bindSingletonFunction("g_game", "getMergedCreatureUpdates", &Game::getMergedCreatureUpdates, &g_game);
+    g_lua.bindSingletonFunction("g_game", "resetMergedCreatureUpdates", &Game::resetMergedCreatureUpdates, &g_game);
     g_lua.bindSingletonFunction("g_game", "getProtocolVersion", &Game::getProtocolVersion, &g_game);
     g_lua.bindSingletonFunction("g_game", "setProtocolVersion", &Game::setProtocolVersion, &g_game);
     g_lua.bindSingletonFunction("g_game", "getClientVersion", &Game::getClientVersion, &g_game);
@@ -362,49 +450,51 @@ void Client::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Container>("hasPages", &Container::hasPages);
     g_lua.bindClassMemberFunction<Container>("getSize", &Container::getSize);
     g_lua.bindClassMemberFunction<Container>("getFirstIndex", &Container::getFirstIndex);
+    g_lua.bindClassMemberFunction<Container>("setDeltaMode", &Container::setDeltaMode);
+    g_lua.bindClassMemberFunction<Container>("isDeltaMode", &Container::isDeltaMode);
 
     g_lua.registerClass<Thing>();
-    g_lua.bindClassMemberFunction<Thing>("setId", &Thing::setId);
-    g_lua.bindClassMemberFunction<Thing>("setPosition", &Thing::setPosition);
-    g_lua.bindClassMemberFunction<Thing>("getId", &Thing::getId);
-    g_lua.bindClassMemberFunction<Thing>("getPosition", &Thing::getPosition);
-    g_lua.bindClassMemberFunction<Thing>("getStackPriority", &Thing::getStackPriority);
-    g_lua.bindClassMemberFunction<Thing>("getStackPos", &Thing::getStackPos);
-    g_lua.bindClassMemberFunction<Thing>("getAnimationPhases", &Thing::getAnimationPhases);
-    g_lua.bindClassMemberFunction<Thing>("getTile", &Thing::getTile);
-    g_lua.bindClassMemberFunction<Thing>("isItem", &Thing::isItem);
-    g_lua.bindClassMemberFunction<Thing>("isMonster", &Thing::isMonster);
-    g_lua.bindClassMemberFunction<Thing>("isNpc", &Thing::isNpc);
-    g_lua.bindClassMemberFunction<Thing>("isCreature", &Thing::isCreature);
-    g_lua.bindClassMemberFunction<Thing>("isEffect", &Thing::isEffect);
-    g_lua.bindClassMemberFunction<Thing>("isMissile", &Thing::isMissile);
-    g_lua.bindClassMemberFunction<Thing>("isPlayer", &Thing::isPlayer);
-    g_lua.bindClassMemberFunction<Thing>("isLocalPlayer", &Thing::isLocalPlayer);
-    g_lua.bindClassMemberFunction<Thing>("isAnimatedText", &Thing::isAnimatedText);
-    g_lua.bindClassMemberFunction<Thing>("isStaticText", &Thing::isStaticText);
-    g_lua.bindClassMemberFunction<Thing>("isGround", &Thing::isGround);
-    g_lua.bindClassMemberFunction<Thing>("isGroundBorder", &Thing::isGroundBorder);
-    g_lua.bindClassMemberFunction<Thing>("isOnBottom", &Thing::isOnBottom);
-    g_lua.bindClassMemberFunction<Thing>("isOnTop", &Thing::isOnTop);
-    g_lua.bindClassMemberFunction<Thing>("isContainer", &Thing::isContainer);
-    g_lua.bindClassMemberFunction<Thing>("isForceUse", &Thing::isForceUse);
-    g_lua.bindClassMemberFunction<Thing>("isMultiUse", &Thing::isMultiUse);
-    g_lua.bindClassMemberFunction<Thing>("isRotateable", &Thing::isRotateable);
-    g_lua.bindClassMemberFunction<Thing>("isNotMoveable", &Thing::isNotMoveable);
-    g_lua.bindClassMemberFunction<Thing>("isPickupable", &Thing::isPickupable);
-    g_lua.bindClassMemberFunction<Thing>("isIgnoreLook", &Thing::isIgnoreLook);
-    g_lua.bindClassMemberFunction<Thing>("isStackable", &Thing::isStackable);
-    g_lua.bindClassMemberFunction<Thing>("isHookSouth", &Thing::isHookSouth);
-    g_lua.bindClassMemberFunction<Thing>("isTranslucent", &Thing::isTranslucent);
-    g_lua.bindClassMemberFunction<Thing>("isFullGround", &Thing::isFullGround);
-    g_lua.bindClassMemberFunction<Thing>("isMarketable", &Thing::isMarketable);
-    g_lua.bindClassMemberFunction<Thing>("getMarketData", &Thing::getMarketData);
-    g_lua.bindClassMemberFunction<Thing>("isUsable", &Thing::isUsable);
-    g_lua.bindClassMemberFunction<Thing>("isWrapable", &Thing::isWrapable);
-    g_lua.bindClassMemberFunction<Thing>("isUnwrapable", &Thing::isUnwrapable);
-    g_lua.bindClassMemberFunction<Thing>("isTopEffect", &Thing::isTopEffect);
-    g_lua.bindClassMemberFunction<Thing>("isLyingCorpse", &Thing::isLyingCorpse);
-    g_lua.bindClassMemberFunction<Thing>("getParentContainer", &Thing::getParentContainer);
+    g_lua.bindClassMemberFunction<Thing, &Thing::setId>("setId");
+    g_lua.bindClassMemberFunction<Thing, &Thing::setPosition>("setPosition");
+    g_lua.bindClassMemberFunction<Thing, &Thing::getId>("getId");
+    g_lua.bindClassMemberFunction<Thing, &Thing::getPosition>("getPosition");
+    g_lua.bindClassMemberFunction<Thing, &Thing::getStackPriority>("getStackPriority");
+    g_lua.bindClassMemberFunction<Thing, &Thing::getStackPos>("getStackPos");
+    g_lua.bindClassMemberFunction<Thing, &Thing::getAnimationPhases>("getAnimationPhases");
+    g_lua.bindClassMemberFunction<Thing, &Thing::getTile>("getTile");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isItem>("isItem");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isMonster>("isMonster");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isNpc>("isNpc");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isCreature>("isCreature");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isEffect>("isEffect");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isMissile>("isMissile");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isPlayer>("isPlayer");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isLocalPlayer>("isLocalPlayer");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isAnimatedText>("isAnimatedText");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isStaticText>("isStaticText");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isGround>("isGround");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isGroundBorder>("isGroundBorder");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isOnBottom>("isOnBottom");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isOnTop>("isOnTop");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isContainer>("isContainer");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isForceUse>("isForceUse");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isMultiUse>("isMultiUse");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isRotateable>("isRotateable");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isNotMoveable>("isNotMoveable");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isPickupable>("isPickupable");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isIgnoreLook>("isIgnoreLook");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isStackable>("isStackable");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isHookSouth>("isHookSouth");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isTranslucent>("isTranslucent");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isFullGround>("isFullGround");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isMarketable>("isMarketable");
+    g_lua.bindClassMemberFunction<Thing, &Thing::getMarketData>("getMarketData");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isUsable>("isUsable");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isWrapable>("isWrapable");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isUnwrapable>("isUnwrapable");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isTopEffect>("isTopEffect");
+    g_lua.bindClassMemberFunction<Thing, &Thing::isLyingCorpse>("isLyingCorpse");
+    g_lua.bindClassMemberFunction<Thing, &Thing::getParentContainer>("getParentContainer");
 
     g_lua.registerClass<House>();
     g_lua.bindClassStaticFunction<House>("create", [] { return HousePtr(new House); });
@@ -459,41 +549,41 @@ void Client::registerLuaFunctions()
 
     g_lua.registerClass<Creature, Thing>();
     g_lua.bindClassStaticFunction<Creature>("create", [] { return CreaturePtr(new Creature); });
-    g_lua.bindClassMemberFunction<Creature>("getId", &Creature::getId);
-    g_lua.bindClassMemberFunction<Creature>("getName", &Creature::getName);
-    g_lua.bindClassMemberFunction<Creature>("getHealthPercent", &Creature::getHealthPercent);
-    g_lua.bindClassMemberFunction<Creature>("getSpeed", &Creature::getSpeed);
-    g_lua.bindClassMemberFunction<Creature>("getBaseSpeed", &Creature::getBaseSpeed);
-    g_lua.bindClassMemberFunction<Creature>("getSkull", &Creature::getSkull);
-    g_lua.bindClassMemberFunction<Creature>("getShield", &Creature::getShield);
-    g_lua.bindClassMemberFunction<Creature>("getEmblem", &Creature::getEmblem);
-    g_lua.bindClassMemberFunction<Creature>("getType", &Creature::getType);
-    g_lua.bindClassMemberFunction<Creature>("getIcon", &Creature::getIcon);
-    g_lua.bindClassMemberFunction<Creature>("setOutfit", &Creature::setOutfit);
-    g_lua.bindClassMemberFunction<Creature>("getOutfit", &Creature::getOutfit);
-    g_lua.bindClassMemberFunction<Creature>("setOutfitColor", &Creature::setOutfitColor);
-    g_lua.bindClassMemberFunction<Creature>("getDirection", &Creature::getDirection);
-    g_lua.bindClassMemberFunction<Creature>("getStepDuration", &Creature::getStepDuration);
-    g_lua.bindClassMemberFunction<Creature>("getStepProgress", &Creature::getStepProgress);
-    g_lua.bindClassMemberFunction<Creature>("getWalkTicksElapsed", &Creature::getWalkTicksElapsed);
-    g_lua.bindClassMemberFunction<Creature>("getStepTicksLeft", &Creature::getStepTicksLeft);
-    g_lua.bindClassMemberFunction<Creature>("setDirection", &Creature::setDirection);
-    g_lua.bindClassMemberFunction<Creature>("setSkullTexture", &Creature::setSkullTexture);
-    g_lua.bindClassMemberFunction<Creature>("setShieldTexture", &Creature::setShieldTexture);
-    g_lua.bindClassMemberFunction<Creature>("setEmblemTexture", &Creature::setEmblemTexture);
-    g_lua.bindClassMemberFunction<Creature>("setTypeTexture", &Creature::setTypeTexture);
-    g_lua.bindClassMemberFunction<Creature>("setIconTexture", &Creature::setIconTexture);
-    g_lua.bindClassMemberFunction<Creature>("showStaticSquare", &Creature::showStaticSquare);
-    g_lua.bindClassMemberFunction<Creature>("hideStaticSquare", &Creature::hideStaticSquare);
-    g_lua.bindClassMemberFunction<Creature>("isWalking", &Creature::isWalking);
-    g_lua.bindClassMemberFunction<Creature>("isInvisible", &Creature::isInvisible);
-    g_lua.bindClassMemberFunction<Creature>("isDead", &Creature::isDead);
-    g_lua.bindClassMemberFunction<Creature>("isRemoved", &Creature::isRemoved);
-    g_lua.bindClassMemberFunction<Creature>("canBeSeen", &Creature::canBeSeen);
-    g_lua.bindClassMemberFunction<Creature>("jump", &Creature::jump);
-    g_lua.bindClassMemberFunction<Creature>("setOutfitShader", &Creature::setOutfitShader);
-    g_lua.bindClassMemberFunction<Creature>("setMountShader", &Creature::setMountShader);
-    g_lua.bindClassMemberFunction<Creature>("setDrawOutfitColor", &Creature::setDrawOutfitColor);
+    g_lua.bindClassMemberFunction<Creature, &Creature::getId>("getId");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getName>("getName");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getHealthPercent>("getHealthPercent");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getSpeed>("getSpeed");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getBaseSpeed>("getBaseSpeed");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getSkull>("getSkull");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getShield>("getShield");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getEmblem>("getEmblem");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getType>("getType");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getIcon>("getIcon");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setOutfit>("setOutfit");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getOutfit>("getOutfit");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setOutfitColor>("setOutfitColor");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getDirection>("getDirection");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getStepDuration>("getStepDuration");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getStepProgress>("getStepProgress");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getWalkTicksElapsed>("getWalkTicksElapsed");
+    g_lua.bindClassMemberFunction<Creature, &Creature::getStepTicksLeft>("getStepTicksLeft");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setDirection>("setDirection");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setSkullTexture>("setSkullTexture");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setShieldTexture>("setShieldTexture");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setEmblemTexture>("setEmblemTexture");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setTypeTexture>("setTypeTexture");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setIconTexture>("setIconTexture");
+    g_lua.bindClassMemberFunction<Creature, &Creature::showStaticSquare>("showStaticSquare");
+    g_lua.bindClassMemberFunction<Creature, &Creature::hideStaticSquare>("hideStaticSquare");
+    g_lua.bindClassMemberFunction<Creature, &Creature::isWalking>("isWalking");
+    g_lua.bindClassMemberFunction<Creature, &Creature::isInvisible>("isInvisible");
+    g_lua.bindClassMemberFunction<Creature, &Creature::isDead>("isDead");
+    g_lua.bindClassMemberFunction<Creature, &Creature::isRemoved>("isRemoved");
+    g_lua.bindClassMemberFunction<Creature, &Creature::canBeSeen>("canBeSeen");
+    g_lua.bindClassMemberFunction<Creature, &Creature::jump>("jump");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setOutfitShader>("setOutfitShader");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setMountShader>("setMountShader");
+    g_lua.bindClassMemberFunction<Creature, &Creature::setDrawOutfitColor>("setDrawOutfitColor");
 
     g_lua.registerClass<ItemType>();
     g_lua.bindClassMemberFunction<ItemType>("getServerId", &ItemType::getServerId);
@@ -573,47 +663,47 @@ void Client::registerLuaFunctions()
     g_lua.registerClass<Item, Thing>();
     g_lua.bindClassStaticFunction<Item>("create", &Item::create);
     g_lua.bindClassStaticFunction<Item>("createOtb", &Item::createFromOtb);
-    g_lua.bindClassMemberFunction<Item>("clone", &Item::clone);
-    g_lua.bindClassMemberFunction<Item>("getContainerItems", &Item::getContainerItems);
-    g_lua.bindClassMemberFunction<Item>("getContainerItem", &Item::getContainerItem);
-    g_lua.bindClassMemberFunction<Item>("addContainerItem", &Item::addContainerItem);
-    g_lua.bindClassMemberFunction<Item>("addContainerItemIndexed", &Item::addContainerItemIndexed);
-    g_lua.bindClassMemberFunction<Item>("removeContainerItem", &Item::removeContainerItem);
-    g_lua.bindClassMemberFunction<Item>("clearContainerItems", &Item::clearContainerItems);
-    g_lua.bindClassMemberFunction<Item>("getContainerItem", &Item::getContainerItem);
-    g_lua.bindClassMemberFunction<Item>("setCount", &Item::setCount);
-    g_lua.bindClassMemberFunction<Item>("getCount", &Item::getCount);
-    g_lua.bindClassMemberFunction<Item>("getSubType", &Item::getSubType);
-    g_lua.bindClassMemberFunction<Item>("getId", &Item::getId);
-    g_lua.bindClassMemberFunction<Item>("getServerId", &Item::getServerId);
-    g_lua.bindClassMemberFunction<Item>("getName", &Item::getName);
-    g_lua.bindClassMemberFunction<Item>("getDescription", &Item::getDescription);
-    g_lua.bindClassMemberFunction<Item>("getText", &Item::getText);
-    g_lua.bindClassMemberFunction<Item>("setDescription", &Item::setDescription);
-    g_lua.bindClassMemberFunction<Item>("setText", &Item::setText);
-    g_lua.bindClassMemberFunction<Item>("getUniqueId", &Item::getUniqueId);
-    g_lua.bindClassMemberFunction<Item>("getActionId", &Item::getActionId);
-    g_lua.bindClassMemberFunction<Item>("setUniqueId", &Item::setUniqueId);
-    g_lua.bindClassMemberFunction<Item>("setActionId", &Item::setActionId);
-    g_lua.bindClassMemberFunction<Item>("getTeleportDestination", &Item::getTeleportDestination);
-    g_lua.bindClassMemberFunction<Item>("setTeleportDestination", &Item::setTeleportDestination);
-    g_lua.bindClassMemberFunction<Item>("isStackable", &Item::isStackable);
-    g_lua.bindClassMemberFunction<Item>("isMarketable", &Item::isMarketable);
-    g_lua.bindClassMemberFunction<Item>("isFluidContainer", &Item::isFluidContainer);
-    g_lua.bindClassMemberFunction<Item>("getMarketData", &Item::getMarketData);
-    g_lua.bindClassMemberFunction<Item>("getClothSlot", &Item::getClothSlot);
+    g_lua.bindClassMemberFunction<Item, &Item::clone>("clone");
+    g_lua.bindClassMemberFunction<Item, &Item::getContainerItems>("getContainerItems");
+    g_lua.bindClassMemberFunction<Item, &Item::getContainerItem>("getContainerItem");
+    g_lua.bindClassMemberFunction<Item, &Item::addContainerItem>("addContainerItem");
+    g_lua.bindClassMemberFunction<Item, &Item::addContainerItemIndexed>("addContainerItemIndexed");
+    g_lua.bindClassMemberFunction<Item, &Item::removeContainerItem>("removeContainerItem");
+    g_lua.bindClassMemberFunction<Item, &Item::clearContainerItems>("clearContainerItems");
+    g_lua.bindClassMemberFunction<Item, &Item::getContainerItem>("getContainerItem");
+    g_lua.bindClassMemberFunction<Item, &Item::setCount>("setCount");
+    g_lua.bindClassMemberFunction<Item, &Item::getCount>("getCount");
+    g_lua.bindClassMemberFunction<Item, &Item::getSubType>("getSubType");
+    g_lua.bindClassMemberFunction<Item, &Item::getId>("getId");
+    g_lua.bindClassMemberFunction<Item, &Item::getServerId>("getServerId");
+    g_lua.bindClassMemberFunction<Item, &Item::getName>("getName");
+    g_lua.bindClassMemberFunction<Item, &Item::getDescription>("getDescription");
+    g_lua.bindClassMemberFunction<Item, &Item::getText>("getText");
+    g_lua.bindClassMemberFunction<Item, &Item::setDescription>("setDescription");
+    g_lua.bindClassMemberFunction<Item, &Item::setText>("setText");
+    g_lua.bindClassMemberFunction<Item, &Item::getUniqueId>("getUniqueId");
+    g_lua.bindClassMemberFunction<Item, &Item::getActionId>("getActionId");
+    g_lua.bindClassMemberFunction<Item, &Item::setUniqueId>("setUniqueId");
+    g_lua.bindClassMemberFunction<Item, &Item::setActionId>("setActionId");
+    g_lua.bindClassMemberFunction<Item, &Item::getTeleportDestination>("getTeleportDestination");
+    g_lua.bindClassMemberFunction<Item, &Item::setTeleportDestination>("setTeleportDestination");
+    g_lua.bindClassMemberFunction<Item, &Item::isStackable>("isStackable");
+    g_lua.bindClassMemberFunction<Item, &Item::isMarketable>("isMarketable");
+    g_lua.bindClassMemberFunction<Item, &Item::isFluidContainer>("isFluidContainer");
+    g_lua.bindClassMemberFunction<Item, &Item::getMarketData>("getMarketData");
+    g_lua.bindClassMemberFunction<Item, &Item::getClothSlot>("getClothSlot");
 
     g_lua.registerClass<Effect, Thing>();
     g_lua.bindClassStaticFunction<Effect>("create", [] { return EffectPtr(new Effect); });
-    g_lua.bindClassMemberFunction<Effect>("setId", &Effect::setId);
+    g_lua.bindClassMemberFunction<Effect, &Effect::setId>("setId");
 
     g_lua.registerClass<Missile, Thing>();
     g_lua.bindClassStaticFunction<Missile>("create", [] { return MissilePtr(new Missile); });
-    g_lua.bindClassMemberFunction<Missile>("setId", &Missile::setId);
-    g_lua.bindClassMemberFunction<Missile>("setPath", &Missile::setPath);
+    g_lua.bindClassMemberFunction<Missile, &Missile::setId>("setId");
+    g_lua.bindClassMemberFunction<Missile, &Missile::setPath>("setPath");
 
     g_lua.registerClass<StaticText, Thing>();
-    g_lua.bindClassStaticFunction<StaticText>("create", [] { return StaticTextPtr(new StaticText); });
+    g_lua.bindClassStaticFunction<StaticText>("create", [] { return g_map.createStaticText(); });
     g_lua.bindClassMemberFunction<StaticText>("addMessage", &StaticText::addMessage);
     g_lua.bindClassMemberFunction<StaticText>("setText", &StaticText::setText);
     g_lua.bindClassMemberFunction<StaticText>("setFont", &StaticText::setFont);
@@ -627,107 +717,136 @@ void Client::registerLuaFunctions()
     g_lua.registerClass<Monster, Creature>();
 
     g_lua.registerClass<LocalPlayer, Player>();
-    g_lua.bindClassMemberFunction<LocalPlayer>("unlockWalk", &LocalPlayer::unlockWalk);
-    g_lua.bindClassMemberFunction<LocalPlayer>("lockWalk", &LocalPlayer::lockWalk);
-    g_lua.bindClassMemberFunction<LocalPlayer>("canWalk", &LocalPlayer::canWalk);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setStates", &LocalPlayer::setStates);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setSkill", &LocalPlayer::setSkill);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setHealth", &LocalPlayer::setHealth);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setTotalCapacity", &LocalPlayer::setTotalCapacity);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setFreeCapacity", &LocalPlayer::setFreeCapacity);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setExperience", &LocalPlayer::setExperience);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setLevel", &LocalPlayer::setLevel);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setMana", &LocalPlayer::setMana);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setMagicLevel", &LocalPlayer::setMagicLevel);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setSoul", &LocalPlayer::setSoul);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setStamina", &LocalPlayer::setStamina);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setKnown", &LocalPlayer::setKnown);
-    g_lua.bindClassMemberFunction<LocalPlayer>("setInventoryItem", &LocalPlayer::setInventoryItem);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getStates", &LocalPlayer::getStates);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getSkillLevel", &LocalPlayer::getSkillLevel);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getSkillBaseLevel", &LocalPlayer::getSkillBaseLevel);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getSkillLevelPercent", &LocalPlayer::getSkillLevelPercent);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getHealth", &LocalPlayer::getHealth);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getMaxHealth", &LocalPlayer::getMaxHealth);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getFreeCapacity", &LocalPlayer::getFreeCapacity);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getExperience", &LocalPlayer::getExperience);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getLevel", &LocalPlayer::getLevel);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getLevelPercent", &LocalPlayer::getLevelPercent);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getMana", &LocalPlayer::getMana);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getMaxMana", &LocalPlayer::getMaxMana);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getMagicLevel", &LocalPlayer::getMagicLevel);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getMagicLevelPercent", &LocalPlayer::getMagicLevelPercent);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getSoul", &LocalPlayer::getSoul);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getStamina", &LocalPlayer::getStamina);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getOfflineTrainingTime", &LocalPlayer::getOfflineTrainingTime);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getRegenerationTime", &LocalPlayer::getRegenerationTime);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getBaseMagicLevel", &LocalPlayer::getBaseMagicLevel);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getTotalCapacity", &LocalPlayer::getTotalCapacity);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getInventoryItem", &LocalPlayer::getInventoryItem);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getVocation", &LocalPlayer::getVocation);
-    g_lua.bindClassMemberFunction<LocalPlayer>("getBlessings", &LocalPlayer::getBlessings);
-    g_lua.bindClassMemberFunction<LocalPlayer>("isPremium", &LocalPlayer::isPremium);
-    g_lua.bindClassMemberFunction<LocalPlayer>("isKnown", &LocalPlayer::isKnown);
-    g_lua.bindClassMemberFunction<LocalPlayer>("isPreWalking", &LocalPlayer::isPreWalking);
-    g_lua.bindClassMemberFunction<LocalPlayer>("hasSight", &LocalPlayer::hasSight);
-    g_lua.bindClassMemberFunction<LocalPlayer>("isAutoWalking", &LocalPlayer::isAutoWalking);
-    g_lua.bindClassMemberFunction<LocalPlayer>("isServerWalking", &LocalPlayer::isServerWalking);
-    g_lua.bindClassMemberFunction<LocalPlayer>("stopAutoWalk", &LocalPlayer::stopAutoWalk);
-    g_lua.bindClassMemberFunction<LocalPlayer>("autoWalk", &LocalPlayer::autoWalk);
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::unlockWalk>("unlockWalk");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::lockWalk>("lockWalk");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::canWalk>("canWalk");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setStates>("setStates");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setSkill>("setSkill");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setHealth>("setHealth");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setTotalCapacity>("setTotalCapacity");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setFreeCapacity>("setFreeCapacity");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setExperience>("setExperience");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setLevel>("setLevel");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setMana>("setMana");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setMagicLevel>("setMagicLevel");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setSoul>("setSoul");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setStamina>("setStamina");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setKnown>("setKnown");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setInventoryItem>("setInventoryItem");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getStates>("getStates");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getSkillLevel>("getSkillLevel");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getSkillBaseLevel>("getSkillBaseLevel");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getSkillLevelPercent>("getSkillLevelPercent");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getHealth>("getHealth");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getMaxHealth>("getMaxHealth");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getFreeCapacity>("getFreeCapacity");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getExperience>("getExperience");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getLevel>("getLevel");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getLevelPercent>("getLevelPercent");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getMana>("getMana");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getMaxMana>("getMaxMana");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getMagicLevel>("getMagicLevel");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getMagicLevelPercent>("getMagicLevelPercent");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getSoul>("getSoul");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getStamina>("getStamina");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getOfflineTrainingTime>("getOfflineTrainingTime");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getRegenerationTime>("getRegenerationTime");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getBaseMagicLevel>("getBaseMagicLevel");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getTotalCapacity>("getTotalCapacity");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getInventoryItem>("getInventoryItem");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getVocation>("getVocation");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getBlessings>("getBlessings");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::isPremium>("isPremium");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::isKnown>("isKnown");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::isPreWalking>("isPreWalking");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::setWalkPredictionDepth>("setWalkPredictionDepth");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getWalkPredictionDepth>("getWalkPredictionDepth");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getPredictedStepCount>("getPredictedStepCount");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getPredictedPosition>("getPredictedPosition");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getWalkLatency>("getWalkLatency");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::getWalkRollbackCount>("getWalkRollbackCount");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::hasSight>("hasSight");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::isAutoWalking>("isAutoWalking");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::isServerWalking>("isServerWalking");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::stopAutoWalk>("stopAutoWalk");
+    g_lua.bindClassMemberFunction<LocalPlayer, &LocalPlayer::autoWalk>("autoWalk");
 
     g_lua.registerClass<Tile>();
-    g_lua.bindClassMemberFunction<Tile>("clean", &Tile::clean);
-    g_lua.bindClassMemberFunction<Tile>("addThing", &Tile::addThing);
-    g_lua.bindClassMemberFunction<Tile>("getThing", &Tile::getThing);
-    g_lua.bindClassMemberFunction<Tile>("getThings", &Tile::getThings);
-    g_lua.bindClassMemberFunction<Tile>("getItems", &Tile::getItems);
-    g_lua.bindClassMemberFunction<Tile>("getThingStackPos", &Tile::getThingStackPos);
-    g_lua.bindClassMemberFunction<Tile>("getThingCount", &Tile::getThingCount);
-    g_lua.bindClassMemberFunction<Tile>("getTopThing", &Tile::getTopThing);
-    g_lua.bindClassMemberFunction<Tile>("removeThing", &Tile::removeThing);
-    g_lua.bindClassMemberFunction<Tile>("getTopLookThing", &Tile::getTopLookThing);
-    g_lua.bindClassMemberFunction<Tile>("getTopUseThing", &Tile::getTopUseThing);
-    g_lua.bindClassMemberFunction<Tile>("getTopCreature", &Tile::getTopCreature);
-    g_lua.bindClassMemberFunction<Tile>("getTopMoveThing", &Tile::getTopMoveThing);
-    g_lua.bindClassMemberFunction<Tile>("getTopMultiUseThing", &Tile::getTopMultiUseThing);
-    g_lua.bindClassMemberFunction<Tile>("getPosition", &Tile::getPosition);
-    g_lua.bindClassMemberFunction<Tile>("getDrawElevation", &Tile::getDrawElevation);
-    g_lua.bindClassMemberFunction<Tile>("getCreatures", &Tile::getCreatures);
-    g_lua.bindClassMemberFunction<Tile>("getGround", &Tile::getGround);
-    g_lua.bindClassMemberFunction<Tile>("isWalkable", &Tile::isWalkable);
-    g_lua.bindClassMemberFunction<Tile>("isHouseTile", &Tile::isHouseTile);
-    g_lua.bindClassMemberFunction<Tile>("isFullGround", &Tile::isFullGround);
-    g_lua.bindClassMemberFunction<Tile>("isFullyOpaque", &Tile::isFullyOpaque);
-    g_lua.bindClassMemberFunction<Tile>("isLookPossible", &Tile::isLookPossible);
-    g_lua.bindClassMemberFunction<Tile>("hasCreature", &Tile::hasCreature);
-    g_lua.bindClassMemberFunction<Tile>("isEmpty", &Tile::isEmpty);
-    g_lua.bindClassMemberFunction<Tile>("isClickable", &Tile::isClickable);
-    g_lua.bindClassMemberFunction<Tile>("isPathable", &Tile::isPathable);
-    g_lua.bindClassMemberFunction<Tile>("overwriteMinimapColor", &Tile::overwriteMinimapColor);
-    g_lua.bindClassMemberFunction<Tile>("select", &Tile::select);
-    g_lua.bindClassMemberFunction<Tile>("unselect", &Tile::unselect);
-    g_lua.bindClassMemberFunction<Tile>("isSelected", &Tile::isSelected);
-    g_lua.bindClassMemberFunction<Tile>("remFlag", &Tile::remFlag);
-    g_lua.bindClassMemberFunction<Tile>("setFlag", &Tile::setFlag);
-    g_lua.bindClassMemberFunction<Tile>("setFlags", &Tile::setFlags);
-    g_lua.bindClassMemberFunction<Tile>("getFlags", &Tile::getFlags);
-    g_lua.bindClassMemberFunction<Tile>("hasFlag", &Tile::hasFlag);
+    g_lua.bindClassMemberFunction<Tile, &Tile::clean>("clean");
+    g_lua.bindClassMemberFunction<Tile, &Tile::addThing>("addThing");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getThing>("getThing");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getThings>("getThings");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getItems>("getItems");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getThingStackPos>("getThingStackPos");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getThingCount>("getThingCount");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getTopThing>("getTopThing");
+    g_lua.bindClassMemberFunction<Tile, &Tile::removeThing>("removeThing");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getTopLookThing>("getTopLookThing");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getTopUseThing>("getTopUseThing");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getTopCreature>("getTopCreature");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getTopMoveThing>("getTopMoveThing");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getTopMultiUseThing>("getTopMultiUseThing");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getPosition>("getPosition");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getDrawElevation>("getDrawElevation");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getCreatures>("getCreatures");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getGround>("getGround");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isWalkable>("isWalkable");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isHouseTile>("isHouseTile");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isFullGround>("isFullGround");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isFullyOpaque>("isFullyOpaque");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isLookPossible>("isLookPossible");
+    g_lua.bindClassMemberFunction<Tile, &Tile::hasCreature>("hasCreature");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isEmpty>("isEmpty");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isClickable>("isClickable");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isPathable>("isPathable");
+    g_lua.bindClassMemberFunction<Tile, &Tile::overwriteMinimapColor>("overwriteMinimapColor");
+    g_lua.bindClassMemberFunction<Tile, &Tile::select>("select");
+    g_lua.bindClassMemberFunction<Tile, &Tile::unselect>("unselect");
+    g_lua.bindClassMemberFunction<Tile, &Tile::isSelected>("isSelected");
+    g_lua.bindClassMemberFunction<Tile, &Tile::remFlag>("remFlag");
+    g_lua.bindClassMemberFunction<Tile, &Tile::setFlag>("setFlag");
+    g_lua.bindClassMemberFunction<Tile, &Tile::setFlags>("setFlags");
+    g_lua.bindClassMemberFunction<Tile, &Tile::getFlags>("getFlags");
+    g_lua.bindClassMemberFunction<Tile, &Tile::hasFlag>("hasFlag");
+
+    g_lua.registerClass<MarketOfferStore>();
+    g_lua.bindClassStaticFunction<MarketOfferStore>("create", [] { return MarketOfferStorePtr(new MarketOfferStore); });
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::readOffers>("readOffers");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::addOffer>("addOffer");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::removeOffer>("removeOffer");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::setOfferAmount>("setOfferAmount");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::clear>("clear");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::setSorting>("setSorting");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::setPriceRange>("setPriceRange");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::setAmountRange>("setAmountRange");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::setItemFilter>("setItemFilter");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::getSortColumn>("getSortColumn");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::isSortDescending>("isSortDescending");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::getOfferCount>("getOfferCount");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::getTotalCount>("getTotalCount");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::getPage>("getPage");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::hasOffer>("hasOffer");
+    g_lua.bindClassMemberFunction<MarketOfferStore, &MarketOfferStore::getOffer>("getOffer");
 
     g_lua.registerClass<UIItem, UIWidget>();
     g_lua.bindClassStaticFunction<UIItem>("create", [] { return UIItemPtr(new UIItem); });
-    g_lua.bindClassMemberFunction<UIItem>("setItemId", &UIItem::setItemId);
-    g_lua.bindClassMemberFunction<UIItem>("setItemCount", &UIItem::setItemCount);
-    g_lua.bindClassMemberFunction<UIItem>("setItemSubType", &UIItem::setItemSubType);
-    g_lua.bindClassMemberFunction<UIItem>("setItemVisible", &UIItem::setItemVisible);
-    g_lua.bindClassMemberFunction<UIItem>("setItem", &UIItem::setItem);
-    g_lua.bindClassMemberFunction<UIItem>("setVirtual", &UIItem::setVirtual);
-    g_lua.bindClassMemberFunction<UIItem>("clearItem", &UIItem::clearItem);
-    g_lua.bindClassMemberFunction<UIItem>("getItemId", &UIItem::getItemId);
-    g_lua.bindClassMemberFunction<UIItem>("getItemCount", &UIItem::getItemCount);
-    g_lua.bindClassMemberFunction<UIItem>("getItemSubType", &UIItem::getItemSubType);
-    g_lua.bindClassMemberFunction<UIItem>("getItem", &UIItem::getItem);
-    g_lua.bindClassMemberFunction<UIItem>("isVirtual", &UIItem::isVirtual);
-    g_lua.bindClassMemberFunction<UIItem>("isItemVisible", &UIItem::isItemVisible);
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::setItemId>("setItemId");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::setItemCount>("setItemCount");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::setItemSubType>("setItemSubType");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::setItemVisible>("setItemVisible");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::setItem>("setItem");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::setVirtual>("setVirtual");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::clearItem>("clearItem");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::getItemId>("getItemId");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::getItemCount>("getItemCount");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::getItemSubType>("getItemSubType");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::getItem>("getItem");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::isVirtual>("isVirtual");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::isItemVisible>("isItemVisible");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::setRenderCached>("setRenderCached");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::setRenderCacheInterval>("setRenderCacheInterval");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::isRenderCached>("isRenderCached");
+    g_lua.bindClassMemberFunction<UIItem, &UIItem::getRenderCacheInterval>("getRenderCacheInterval");
 
     g_lua.registerClass<UISprite, UIWidget>();
     g_lua.bindClassStaticFunction<UISprite>("create", [] { return UISpritePtr(new UISprite); });
@@ -739,69 +858,89 @@ void Client::registerLuaFunctions()
 
     g_lua.registerClass<UICreature, UIWidget>();
     g_lua.bindClassStaticFunction<UICreature>("create", [] { return UICreaturePtr(new UICreature); });
-    g_lua.bindClassMemberFunction<UICreature>("setCreature", &UICreature::setCreature);
-    g_lua.bindClassMemberFunction<UICreature>("setOutfit", &UICreature::setOutfit);
-    g_lua.bindClassMemberFunction<UICreature>("setFixedCreatureSize", &UICreature::setFixedCreatureSize);
-    g_lua.bindClassMemberFunction<UICreature>("getCreature", &UICreature::getCreature);
-    g_lua.bindClassMemberFunction<UICreature>("isFixedCreatureSize", &UICreature::isFixedCreatureSize);
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::setCreature>("setCreature");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::setOutfit>("setOutfit");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::setFixedCreatureSize>("setFixedCreatureSize");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::getCreature>("getCreature");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::isFixedCreatureSize>("isFixedCreatureSize");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::setRenderCached>("setRenderCached");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::setRenderCacheInterval>("setRenderCacheInterval");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::isRenderCached>("isRenderCached");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::getRenderCacheInterval>("getRenderCacheInterval");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::setOutfitPreview>("setOutfitPreview");
+    g_lua.bindClassMemberFunction<UICreature, &UICreature::isOutfitPreview>("isOutfitPreview");
 
     g_lua.registerClass<UIMap, UIWidget>();
     g_lua.bindClassStaticFunction<UIMap>("create", [] { return UIMapPtr(new UIMap); });
-    g_lua.bindClassMemberFunction<UIMap>("drawSelf", &UIMap::drawSelf);
-    g_lua.bindClassMemberFunction<UIMap>("movePixels", &UIMap::movePixels);
-    g_lua.bindClassMemberFunction<UIMap>("setZoom", &UIMap::setZoom);
-    g_lua.bindClassMemberFunction<UIMap>("zoomIn", &UIMap::zoomIn);
-    g_lua.bindClassMemberFunction<UIMap>("zoomOut", &UIMap::zoomOut);
-    g_lua.bindClassMemberFunction<UIMap>("followCreature", &UIMap::followCreature);
-    g_lua.bindClassMemberFunction<UIMap>("setCameraPosition", &UIMap::setCameraPosition);
-    g_lua.bindClassMemberFunction<UIMap>("setMaxZoomIn", &UIMap::setMaxZoomIn);
-    g_lua.bindClassMemberFunction<UIMap>("setMaxZoomOut", &UIMap::setMaxZoomOut);
-    g_lua.bindClassMemberFunction<UIMap>("setMultifloor", &UIMap::setMultifloor);
-    g_lua.bindClassMemberFunction<UIMap>("lockVisibleFloor", &UIMap::lockVisibleFloor);
-    g_lua.bindClassMemberFunction<UIMap>("unlockVisibleFloor", &UIMap::unlockVisibleFloor);
-    g_lua.bindClassMemberFunction<UIMap>("setVisibleDimension", &UIMap::setVisibleDimension);
-    g_lua.bindClassMemberFunction<UIMap>("setViewMode", &UIMap::setViewMode);
-    g_lua.bindClassMemberFunction<UIMap>("setAutoViewMode", &UIMap::setAutoViewMode);
-    g_lua.bindClassMemberFunction<UIMap>("setDrawTexts", &UIMap::setDrawTexts);
-    g_lua.bindClassMemberFunction<UIMap>("setDrawNames", &UIMap::setDrawNames);
-    g_lua.bindClassMemberFunction<UIMap>("setDrawHealthBars", &UIMap::setDrawHealthBars);
-    g_lua.bindClassMemberFunction<UIMap>("setDrawLights", &UIMap::setDrawLights);
-    g_lua.bindClassMemberFunction<UIMap>("setDrawViewportEdge", &UIMap::setDrawViewportEdge);
-    g_lua.bindClassMemberFunction<UIMap>("setDrawManaBar", &UIMap::setDrawManaBar);
-    g_lua.bindClassMemberFunction<UIMap>("setKeepAspectRatio", &UIMap::setKeepAspectRatio);
-    g_lua.bindClassMemberFunction<UIMap>("setMapShader", &UIMap::setMapShader);
-    g_lua.bindClassMemberFunction<UIMap>("setMinimumAmbientLight", &UIMap::setMinimumAmbientLight);
-    g_lua.bindClassMemberFunction<UIMap>("setShadowFloorIntensity", &UIMap::setShadowFloorIntensity);
-    g_lua.bindClassMemberFunction<UIMap>("setLimitVisibleRange", &UIMap::setLimitVisibleRange);
-    g_lua.bindClassMemberFunction<UIMap>("isMultifloor", &UIMap::isMultifloor);
-    g_lua.bindClassMemberFunction<UIMap>("isAutoViewModeEnabled", &UIMap::isAutoViewModeEnabled);
-    g_lua.bindClassMemberFunction<UIMap>("isDrawingTexts", &UIMap::isDrawingTexts);
-    g_lua.bindClassMemberFunction<UIMap>("isDrawingNames", &UIMap::isDrawingNames);
-    g_lua.bindClassMemberFunction<UIMap>("isDrawingHealthBars", &UIMap::isDrawingHealthBars);
-    g_lua.bindClassMemberFunction<UIMap>("isDrawingLights", &UIMap::isDrawingLights);
-    g_lua.bindClassMemberFunction<UIMap>("isDrawingViewportEdge", &UIMap::isDrawingViewportEdge);
-    g_lua.bindClassMemberFunction<UIMap>("isDrawingManaBar", &UIMap::isDrawingManaBar);
-    g_lua.bindClassMemberFunction<UIMap>("isLimitVisibleRangeEnabled", &UIMap::isLimitVisibleRangeEnabled);
-    g_lua.bindClassMemberFunction<UIMap>("isKeepAspectRatioEnabled", &UIMap::isKeepAspectRatioEnabled);
-    g_lua.bindClassMemberFunction<UIMap>("isInRange", &UIMap::isInRange);
-    g_lua.bindClassMemberFunction<UIMap>("getVisibleDimension", &UIMap::getVisibleDimension);
-    g_lua.bindClassMemberFunction<UIMap>("getViewMode", &UIMap::getViewMode);
-    g_lua.bindClassMemberFunction<UIMap>("getFollowingCreature", &UIMap::getFollowingCreature);
-    g_lua.bindClassMemberFunction<UIMap>("getCameraPosition", &UIMap::getCameraPosition);
-    g_lua.bindClassMemberFunction<UIMap>("getPosition", &UIMap::getPosition);
-    g_lua.bindClassMemberFunction<UIMap>("getTile", &UIMap::getTile);
-    g_lua.bindClassMemberFunction<UIMap>("getMaxZoomIn", &UIMap::getMaxZoomIn);
-    g_lua.bindClassMemberFunction<UIMap>("getMaxZoomOut", &UIMap::getMaxZoomOut);
-    g_lua.bindClassMemberFunction<UIMap>("getZoom", &UIMap::getZoom);
-    g_lua.bindClassMemberFunction<UIMap>("getMapShader", &UIMap::getMapShader);
-    g_lua.bindClassMemberFunction<UIMap>("getMinimumAmbientLight", &UIMap::getMinimumAmbientLight);
-    g_lua.bindClassMemberFunction<UIMap>("getVisibleCreatures", &UIMap::getVisibleCreatures);
-    g_lua.bindClassMemberFunction<UIMap>("getSpectators", &UIMap::getSpectators);
-    g_lua.bindClassMemberFunction<UIMap>("getSightSpectators", &UIMap::getSightSpectators);
-    g_lua.bindClassMemberFunction<UIMap>("setCrosshairTexture", &UIMap::setCrosshairTexture);
-    g_lua.bindClassMemberFunction<UIMap>("setDrawHighlightTarget", &UIMap::setDrawHighlightTarget);
-    g_lua.bindClassMemberFunction<UIMap>("setAntiAliasing", &UIMap::setAntiAliasing);
-    g_lua.bindClassMemberFunction<UIMap>("setRenderScale", &UIMap::setRenderScale);
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::drawSelf>("drawSelf");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::movePixels>("movePixels");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setZoom>("setZoom");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::zoomIn>("zoomIn");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::zoomOut>("zoomOut");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::followCreature>("followCreature");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setCameraPosition>("setCameraPosition");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setMaxZoomIn>("setMaxZoomIn");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setMaxZoomOut>("setMaxZoomOut");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setMultifloor>("setMultifloor");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::lockVisibleFloor>("lockVisibleFloor");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::unlockVisibleFloor>("unlockVisibleFloor");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setVisibleDimension>("setVisibleDimension");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setViewMode>("setViewMode");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setAutoViewMode>("setAutoViewMode");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setDrawTexts>("setDrawTexts");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setDrawNames>("setDrawNames");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setDrawHealthBars>("setDrawHealthBars");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setDrawLights>("setDrawLights");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setDrawViewportEdge>("setDrawViewportEdge");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setDrawManaBar>("setDrawManaBar");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setStaticFloorsCache>("setStaticFloorsCache");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setKeepAspectRatio>("setKeepAspectRatio");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setMapShader>("setMapShader");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setMinimumAmbientLight>("setMinimumAmbientLight");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setShadowFloorIntensity>("setShadowFloorIntensity");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setLimitVisibleRange>("setLimitVisibleRange");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isMultifloor>("isMultifloor");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isAutoViewModeEnabled>("isAutoViewModeEnabled");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isDrawingTexts>("isDrawingTexts");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isDrawingNames>("isDrawingNames");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isDrawingHealthBars>("isDrawingHealthBars");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isDrawingLights>("isDrawingLights");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isDrawingViewportEdge>("isDrawingViewportEdge");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isDrawingManaBar>("isDrawingManaBar");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isStaticFloorsCacheEnabled>("isStaticFloorsCacheEnabled");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isLimitVisibleRangeEnabled>("isLimitVisibleRangeEnabled");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isKeepAspectRatioEnabled>("isKeepAspectRatioEnabled");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isInRange>("isInRange");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getVisibleDimension>("getVisibleDimension");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getViewMode>("getViewMode");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getFollowingCreature>("getFollowingCreature");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getCameraPosition>("getCameraPosition");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getPosition>("getPosition");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getTile>("getTile");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getMaxZoomIn>("getMaxZoomIn");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getMaxZoomOut>("getMaxZoomOut");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getZoom>("getZoom");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getMapShader>("getMapShader");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getMinimumAmbientLight>("getMinimumAmbientLight");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getVisibleCreatures>("getVisibleCreatures");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getSpectators>("getSpectators");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getSightSpectators>("getSightSpectators");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setCrosshairTexture>("setCrosshairTexture");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setDrawHighlightTarget>("setDrawHighlightTarget");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setAntiAliasing>("setAntiAliasing");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setRenderScale>("setRenderScale");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setAdaptiveQuality>("setAdaptiveQuality");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isAdaptiveQualityEnabled>("isAdaptiveQualityEnabled");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setQualityBudget>("setQualityBudget");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setMaxQualityLevel>("setMaxQualityLevel");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getQualityLevel>("getQualityLevel");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setLodThreshold>("setLodThreshold");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getLodThreshold>("getLodThreshold");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getEffectiveTileSize>("getEffectiveTileSize");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setSmoothZoom>("setSmoothZoom");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::isSmoothZoomEnabled>("isSmoothZoomEnabled");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::setSmoothZoomRange>("setSmoothZoomRange");
+    g_lua.bindClassMemberFunction<UIMap, &UIMap::getSmoothZoomRange>("getSmoothZoomRange");
 
     g_lua.registerClass<UIMinimap, UIWidget>();
     g_lua.bindClassStaticFunction<UIMinimap>("create", [] { return UIMinimapPtr(new UIMinimap); });
@@ -829,6 +968,9 @@ void Client::registerLuaFunctions()
     g_lua.bindClassStaticFunction<UIProgressRect>("create", [] { return UIProgressRectPtr(new UIProgressRect); });
     g_lua.bindClassMemberFunction<UIProgressRect>("setPercent", &UIProgressRect::setPercent);
     g_lua.bindClassMemberFunction<UIProgressRect>("getPercent", &UIProgressRect::getPercent);
+    g_lua.bindClassMemberFunction<UIProgressRect>("setTimedProgress", &UIProgressRect::setTimedProgress);
+    g_lua.bindClassMemberFunction<UIProgressRect>("stopTimedProgress", &UIProgressRect::stopTimedProgress);
+    g_lua.bindClassMemberFunction<UIProgressRect>("isTimedProgress", &UIProgressRect::isTimedProgress);
 
     g_lua.registerClass<UIMapAnchorLayout, UIAnchorLayout>();
 }
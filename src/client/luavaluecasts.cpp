@@ -79,7 +79,9 @@ bool luavalue_cast(int index, Outfit& outfit)
 
 int push_luavalue(const Position& pos)
 {
-    if(pos.isValid()) {
+    if(pos.isValid() && g_lua.isCompactValueTypesEnabled())
+        LuaValueType<Position>::push(pos);
+    else if(pos.isValid()) {
         g_lua.createTable(0, 3);
         g_lua.pushInteger(pos.x);
         g_lua.setField("x");
@@ -94,7 +96,10 @@ int push_luavalue(const Position& pos)
 
 bool luavalue_cast(int index, Position& pos)
 {
-    if(g_lua.isTable(index)) {
+    if(const Position* value = LuaValueType<Position>::cast(index)) {
+        pos = *value;
+        return true;
+    } else if(g_lua.isTable(index)) {
         g_lua.getField("x", index);
         pos.x = g_lua.popInteger();
         g_lua.getField("y", index);
@@ -144,6 +149,26 @@ bool luavalue_cast(int index, MarketData& data)
     return false;
 }
 
+int push_luavalue(const MarketOfferRow& offer)
+{
+    g_lua.createTable(0, 7);
+    g_lua.pushInteger(offer.timestamp);
+    g_lua.setField("timestamp");
+    g_lua.pushInteger(offer.counter);
+    g_lua.setField("counter");
+    g_lua.pushInteger(offer.itemId);
+    g_lua.setField("itemId");
+    g_lua.pushInteger(offer.amount);
+    g_lua.setField("amount");
+    g_lua.pushInteger(offer.price);
+    g_lua.setField("price");
+    g_lua.pushInteger(offer.state);
+    g_lua.setField("state");
+    g_lua.pushString(offer.player);
+    g_lua.setField("player");
+    return 1;
+}
+
 int push_luavalue(const Light& light)
 {
     g_lua.createTable(0, 2);
@@ -207,3 +232,72 @@ bool luavalue_cast(int index, UnjustifiedPoints& unjustifiedPoints)
     }
     return false;
 }
+
+namespace {
+
+int luaPositionIndex(lua_State*)
+{
+    const Position* pos = LuaValueType<Position>::cast(1);
+    const char* key = g_lua.toCString(2);
+    if(!pos || !key)
+        g_lua.pushNil();
+    else if(strcmp(key, "x") == 0)
+        g_lua.pushInteger(pos->x);
+    else if(strcmp(key, "y") == 0)
+        g_lua.pushInteger(pos->y);
+    else if(strcmp(key, "z") == 0)
+        g_lua.pushInteger(pos->z);
+    else
+        g_lua.pushNil();
+    return 1;
+}
+
+int luaPositionNewIndex(lua_State*)
+{
+    Position* pos = LuaValueType<Position>::cast(1);
+    const char* key = g_lua.toCString(2);
+    const int value = g_lua.toInteger(3);
+    if(pos && key && strcmp(key, "x") == 0)
+        pos->x = value;
+    else if(pos && key && strcmp(key, "y") == 0)
+        pos->y = value;
+    else if(pos && key && strcmp(key, "z") == 0)
+        pos->z = value;
+    else {
+        g_lua.pushCString("attempt to set an unknown field of a position");
+        g_lua.error();
+    }
+    return 0;
+}
+
+int luaPositionAdd(lua_State*)
+{
+    Position a, b;
+    luavalue_cast(1, a);
+    luavalue_cast(2, b);
+    LuaValueType<Position>::push(a + b);
+    return 1;
+}
+
+int luaPositionSub(lua_State*)
+{
+    Position a, b;
+    luavalue_cast(1, a);
+    luavalue_cast(2, b);
+    LuaValueType<Position>::push(a - b);
+    return 1;
+}
+
+}
+
+void register_client_luavaluetypes()
+{
+    LuaValueType<Position>::typeId = g_lua.registerValueType({
+        { "__index", &luaPositionIndex },
+        { "__newindex", &luaPositionNewIndex },
+        { "__eq", &LuaValueType<Position>::luaEquals },
+        { "__add", &luaPositionAdd },
+        { "__sub", &luaPositionSub },
+        { "__tostring", &LuaValueType<Position>::luaToString }
+    });
+}
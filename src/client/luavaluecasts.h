@@ -26,6 +26,7 @@
 #include <framework/luaengine/declarations.h>
 #include "game.h"
 #include "global.h"
+#include "marketofferstore.h"
 #include "outfit.h"
 
  // outfit
@@ -36,9 +37,13 @@ bool luavalue_cast(int index, Outfit& outfit);
 int push_luavalue(const Position& pos);
 bool luavalue_cast(int index, Position& pos);
 
+// userdata value types of the client
+void register_client_luavaluetypes();
+
 // market
 int push_luavalue(const MarketData& data);
 bool luavalue_cast(int index, MarketData& data);
+int push_luavalue(const MarketOfferRow& offer);
 
 // light
 int push_luavalue(const Light& light);
@@ -21,17 +21,22 @@
  */
 
 #include "map.h"
+#include "effect.h"
 #include "game.h"
+#include "gamestateexport.h"
 #include "item.h"
 #include "localplayer.h"
 #include "mapview.h"
 #include "minimap.h"
 #include "missile.h"
+#include "spectatortracker.h"
 #include "statictext.h"
 #include "tile.h"
 
 #include <framework/core/application.h>
+#include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/graphics/texture.h>
 
 Map g_map;
 TilePtr Map::m_nulltile;
@@ -45,6 +50,14 @@ void Map::init()
 void Map::terminate()
 {
     clean();
+
+    if(m_animatedCreaturesEvent) {
+        m_animatedCreaturesEvent->cancel();
+        m_animatedCreaturesEvent = nullptr;
+    }
+    for(const CreaturePtr& creature : m_animatedCreatures)
+        creature->setAnimationSlot(-1);
+    m_animatedCreatures.clear();
 }
 
 void Map::addMapView(const MapViewPtr& mapView)
@@ -88,6 +101,11 @@ void Map::notificateTileUpdate(const Position& pos, const ThingPtr& thing, const
     if(!pos.isMapPosition())
         return;
 
+    if(m_tileUpdateDepth > 0) {
+        m_pendingTileUpdates[pos] |= thing && thing->isCreature() ? TileUpdateCreature : TileUpdateThing;
+        return;
+    }
+
     for(const MapViewPtr& mapView : m_mapViews) {
         mapView->onTileUpdate(pos, thing, operation);
     }
@@ -95,15 +113,52 @@ void Map::notificateTileUpdate(const Position& pos, const ThingPtr& thing, const
     g_minimap.updateTile(pos, getTile(pos));
 }
 
+void Map::commitTileUpdates()
+{
+    if(m_tileUpdateDepth == 0 || --m_tileUpdateDepth > 0 || m_pendingTileUpdates.empty())
+        return;
+
+    std::vector<Position> positions;
+    positions.reserve(m_pendingTileUpdates.size());
+    uint8 flags = 0;
+    for(const auto& it : m_pendingTileUpdates) {
+        // the minimap sees the final state of the tile, whatever happened to it during the batch
+        g_minimap.updateTile(it.first, getTile(it.first));
+        if(it.second != TileUpdateMinimap)
+            positions.push_back(it.first);
+        flags |= it.second;
+    }
+    m_pendingTileUpdates.clear();
+
+    if(positions.empty())
+        return;
+
+    for(const MapViewPtr& mapView : m_mapViews)
+        mapView->onTileBatchUpdate(positions, flags & TileUpdateCreature, flags & TileUpdateThing);
+}
+
 void Map::clean()
 {
     cleanDynamicThings();
 
-    for(int_fast8_t i = -1; ++i <= Otc::MAX_Z;)
+    for(int_fast8_t i = -1; ++i <= Otc::MAX_Z;) {
         m_tileBlocks[i].clear();
+        m_creatureBlocks[i].clear();
+        m_otcmBlocks[i].clear();
+    }
+    m_otcmData = nullptr;
+    m_itemIndex.clear();
 
     m_waypoints.clear();
 
+    m_pathRequests.clear();
+    if(m_pathRequestsEvent) {
+        m_pathRequestsEvent->cancel();
+        m_pathRequestsEvent = nullptr;
+    }
+
+    cancelOtbmLoad();
+
     g_towns.clear();
     g_houses.clear();
     g_creatures.clearSpawns();
@@ -117,9 +172,15 @@ void Map::cleanDynamicThings()
         removeThing(creature);
     }
     m_knownCreatures.clear();
+    m_cachedCreatures.clear();
+    g_spectatorTracker.clear();
+    g_gameStateExport.clear();
+    m_cachedCreatureExpirations.clear();
 
-    for(int_fast8_t i = -1; ++i <= Otc::MAX_Z;)
+    for(int_fast8_t i = -1; ++i <= Otc::MAX_Z;) {
         m_floorMissiles[i].clear();
+        m_floorEffects[i].clear();
+    }
 
     cleanTexts();
 }
@@ -128,6 +189,8 @@ void Map::cleanTexts()
 {
     m_animatedTexts.clear();
     m_staticTexts.clear();
+    m_animatedTextPool.clear();
+    m_staticTextPool.clear();
 }
 
 void Map::addThing(const ThingPtr& thing, const Position& pos, int16 stackPos)
@@ -139,10 +202,19 @@ void Map::addThing(const ThingPtr& thing, const Position& pos, int16 stackPos)
         const TilePtr& tile = getOrCreateTile(pos);
         if(tile && (m_floatingEffect || !thing->isEffect() || tile->getGround())) {
             tile->addThing(thing, stackPos);
+            if(thing->isEffect()) {
+                m_floorEffects[pos.z].push_back(thing->static_self_cast<Effect>());
+                if(g_clock.millis() - m_lastEffectSweep > MAX_EFFECT_SWEEP_DELAY)
+                    removeExpiredEffects();
+            }
         }
     } else {
         if(thing->isMissile()) {
-            m_floorMissiles[pos.z].push_back(thing->static_self_cast<Missile>());
+            // grouped by id, so missiles of the same type are drawn one after another
+            const MissilePtr missile = thing->static_self_cast<Missile>();
+            auto& missiles = m_floorMissiles[pos.z];
+            missiles.insert(std::upper_bound(missiles.begin(), missiles.end(), missile,
+                                             [](const MissilePtr& a, const MissilePtr& b) { return a->getId() < b->getId(); }), missile);
         } else if(thing->isAnimatedText()) {
             // this code will stack animated texts of the same color
             const AnimatedTextPtr animatedText = thing->static_self_cast<AnimatedText>();
@@ -210,6 +282,8 @@ bool Map::removeThing(const ThingPtr& thing)
         const auto it = std::find(m_animatedTexts.begin(), m_animatedTexts.end(), animatedText);
         if(it != m_animatedTexts.end()) {
             m_animatedTexts.erase(it);
+            if(m_animatedTextPool.size() < MAX_POOLED_TEXTS)
+                m_animatedTextPool.push_back(animatedText);
             ret = true;
         }
     } else if(thing->isStaticText()) {
@@ -217,6 +291,8 @@ bool Map::removeThing(const ThingPtr& thing)
         const auto it = std::find(m_staticTexts.begin(), m_staticTexts.end(), staticText);
         if(it != m_staticTexts.end()) {
             m_staticTexts.erase(it);
+            if(m_staticTextPool.size() < MAX_POOLED_TEXTS)
+                m_staticTextPool.push_back(staticText);
             ret = true;
         }
     } else {
@@ -282,9 +358,70 @@ void Map::removeThingColor(const ThingPtr& thing)
     }
 }
 
+void Map::removeExpiredEffects()
+{
+    const ticks_t now = g_clock.millis();
+    if(now == m_lastEffectSweep)
+        return;
+
+    m_lastEffectSweep = now;
+
+    TileUpdateBatch batch;
+    for(int_fast8_t z = -1; ++z <= Otc::MAX_Z;) {
+        auto& effects = m_floorEffects[z];
+        for(size_t i = 0; i < effects.size();) {
+            if(!effects[i]->isExpired()) {
+                ++i;
+                continue;
+            }
+
+            const EffectPtr effect = std::move(effects[i]);
+            effects[i] = std::move(effects.back());
+            effects.pop_back();
+            removeThing(effect);
+        }
+
+        auto& missiles = m_floorMissiles[z];
+        if(missiles.empty())
+            continue;
+
+        const auto it = std::stable_partition(missiles.begin(), missiles.end(), [](const MissilePtr& missile) { return !missile->isExpired(); });
+        for(auto expired = it; expired != missiles.end(); ++expired)
+            notificateTileUpdate((*expired)->getPosition(), *expired, Otc::OPERATION_REMOVE);
+        missiles.erase(it, missiles.end());
+    }
+}
+
+AnimatedTextPtr Map::createAnimatedText()
+{
+    // texts still referenced somewhere (a pending removal, lua) are dropped from the pool instead
+    while(!m_animatedTextPool.empty()) {
+        AnimatedTextPtr animatedText = std::move(m_animatedTextPool.back());
+        m_animatedTextPool.pop_back();
+        if(animatedText->ref_count() == 1) {
+            animatedText->reset();
+            return animatedText;
+        }
+    }
+    return AnimatedTextPtr(new AnimatedText);
+}
+
+StaticTextPtr Map::createStaticText()
+{
+    while(!m_staticTextPool.empty()) {
+        StaticTextPtr staticText = std::move(m_staticTextPool.back());
+        m_staticTextPool.pop_back();
+        if(staticText->ref_count() == 1) {
+            staticText->reset();
+            return staticText;
+        }
+    }
+    return StaticTextPtr(new StaticText);
+}
+
 StaticTextPtr Map::getStaticText(const Position& pos)
 {
-    for(auto staticText : m_staticTexts) {
+    for(const StaticTextPtr& staticText : m_staticTexts) {
         // try to combine messages
         if(staticText->getPosition() == pos)
             return staticText;
@@ -310,8 +447,7 @@ const TilePtr& Map::createTile(const Position& pos)
     if(pos.y > m_tilesRect.bottom())
         m_tilesRect.setBottom(pos.y);
 
-    TileBlock& block = m_tileBlocks[pos.z][getBlockIndex(pos)];
-    return block.create(pos);
+    return getOrCreateTileBlock(pos).create(pos);
 }
 
 template <typename... Items>
@@ -322,7 +458,7 @@ const TilePtr& Map::createTileEx(const Position& pos, const Items&... items)
 
     const TilePtr& tile = getOrCreateTile(pos);
     auto vec = { items... };
-    for(auto it : vec)
+    for(const auto& it : vec)
         addThing(it, pos);
 
     return tile;
@@ -345,8 +481,89 @@ const TilePtr& Map::getOrCreateTile(const Position& pos)
     if(pos.y > m_tilesRect.bottom())
         m_tilesRect.setBottom(pos.y);
 
-    TileBlock& block = m_tileBlocks[pos.z][getBlockIndex(pos)];
-    return block.getOrCreate(pos);
+    return getOrCreateTileBlock(pos).getOrCreate(pos);
+}
+
+TileBlock& Map::getOrCreateTileBlock(const Position& pos)
+{
+    std::unordered_map<uint, TileBlock>& tileBlocks = m_tileBlocks[pos.z];
+    const uint index = getBlockIndex(pos);
+    auto it = tileBlocks.find(index);
+    if(it != tileBlocks.end())
+        return it->second;
+
+    if(m_freeTileBlocks.empty())
+        return tileBlocks[index];
+
+    // released blocks are emptied before they are kept, only the key changes
+    auto node = std::move(m_freeTileBlocks.back());
+    m_freeTileBlocks.pop_back();
+    node.key() = index;
+    node.mapped().mustUpdateZones();
+    return tileBlocks.insert(std::move(node)).position->second;
+}
+
+std::map<std::string, uint> Map::getTileMemoryUsage()
+{
+    uint blocks = 0;
+    for(const auto& tileBlocks : m_tileBlocks)
+        blocks += tileBlocks.size();
+
+    std::map<std::string, uint> usage;
+    usage["tiles"] = Tile::getLiveTileCount();
+    usage["tileBytes"] = Tile::getReservedTileBytes();
+    usage["blocks"] = blocks;
+    usage["freeBlocks"] = m_freeTileBlocks.size();
+    usage["blockBytes"] = (blocks + m_freeTileBlocks.size()) * sizeof(TileBlock);
+    return usage;
+}
+
+void Map::prewarmTextures()
+{
+    if(!m_centralPosition.isValid())
+        return;
+
+    // (floor distance, tile distance) for every thing type, the smallest key wins
+    std::unordered_map<ThingType*, std::pair<int, ThingTypePtr>> nearest;
+    const int cz = m_centralPosition.z;
+    for(int z = getFirstAwareFloor(); z <= getLastAwareFloor(); ++z) {
+        // other floors are sent shifted by their distance to the central one
+        const int offset = cz - z;
+        for(int y = -m_awareRange.top; y <= m_awareRange.bottom; ++y) {
+            for(int x = -m_awareRange.left; x <= m_awareRange.right; ++x) {
+                const TilePtr& tile = getTile(Position(m_centralPosition.x + x + offset, m_centralPosition.y + y + offset, z));
+                if(!tile)
+                    continue;
+
+                const int key = std::abs(offset) * 256 + std::max<int>(std::abs(x), std::abs(y));
+                for(const ThingPtr& thing : tile->getThings()) {
+                    const ThingTypePtr& thingType = thing->getThingType();
+                    if(!thingType || thingType->isNull())
+                        continue;
+
+                    auto it = nearest.find(thingType.get());
+                    if(it == nearest.end())
+                        nearest.emplace(thingType.get(), std::make_pair(key, thingType));
+                    else if(key < it->second.first)
+                        it->second.first = key;
+                }
+            }
+        }
+    }
+
+    std::vector<std::pair<int, ThingTypePtr>> sorted;
+    sorted.reserve(nearest.size());
+    for(const auto& it : nearest)
+        sorted.push_back(it.second);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<int, ThingTypePtr>& a, const std::pair<int, ThingTypePtr>& b) {
+        return a.first < b.first;
+    });
+
+    ThingTypeList thingTypes;
+    thingTypes.reserve(sorted.size());
+    for(const auto& it : sorted)
+        thingTypes.push_back(it.second);
+    g_things.prewarmTextures(thingTypes);
 }
 
 const TilePtr& Map::getTile(const Position& pos)
@@ -404,6 +621,8 @@ void Map::cleanTile(const Position& pos)
                 block.remove(pos);
 
             notificateTileUpdate(pos, nullptr, Otc::OPERATION_CLEAN);
+        } else if(m_tileUpdateDepth > 0) {
+            m_pendingTileUpdates[pos] |= TileUpdateMinimap;
         } else {
             g_minimap.updateTile(pos, nullptr);
         }
@@ -424,6 +643,7 @@ void Map::setShowZone(tileflags_t zone, bool show)
         m_zoneFlags |= static_cast<uint32>(zone);
     else
         m_zoneFlags &= ~static_cast<uint32>(zone);
+    ++m_zoneRevision;
 }
 
 void Map::setShowZones(bool show)
@@ -432,12 +652,74 @@ void Map::setShowZones(bool show)
         m_zoneFlags = 0;
     else if(m_zoneFlags == 0)
         m_zoneFlags = TILESTATE_HOUSE | TILESTATE_PROTECTIONZONE;
+    ++m_zoneRevision;
 }
 
 void Map::setZoneColor(tileflags_t zone, const Color& color)
 {
-    if((m_zoneFlags & zone) == zone)
+    if((m_zoneFlags & zone) == zone) {
         m_zoneColors[zone] = color;
+        ++m_zoneRevision;
+    }
+}
+
+const TexturePtr& Map::getZoneTexture(const Position& pos)
+{
+    static const TexturePtr nullTexture;
+    if(!pos.isMapPosition() || m_zoneFlags == 0)
+        return nullTexture;
+
+    const auto it = m_tileBlocks[pos.z].find(getBlockIndex(pos));
+    if(it == m_tileBlocks[pos.z].end())
+        return nullTexture;
+
+    TileBlock& block = it->second;
+    TexturePtr& texture = block.getZoneTexture();
+    if(block.getZoneRevision() == m_zoneRevision)
+        return texture;
+    block.setZoneRevision(m_zoneRevision);
+
+    // the first shown zone with a color tints the tile, zones are checked in flag order
+    static std::array<uint32, BLOCK_SIZE * BLOCK_SIZE> pixels;
+    bool tinted = false;
+    const auto& tiles = block.getTiles();
+    for(uint i = 0; i < tiles.size(); ++i) {
+        pixels[i] = Color::alpha.rgba();
+        if(!tiles[i])
+            continue;
+
+        const uint32 flags = tiles[i]->getFlags() & m_zoneFlags;
+        if(flags == 0)
+            continue;
+
+        for(const auto& zone : m_zoneColors) {
+            if((flags & zone.first) == zone.first && (m_zoneFlags & zone.first) == zone.first) {
+                pixels[i] = zone.second.rgba();
+                tinted = true;
+                break;
+            }
+        }
+    }
+
+    if(!tinted) {
+        texture = nullptr;
+        return texture;
+    }
+
+    // a new texture rather than a new upload, draw pools tell their frames apart by texture ids
+    texture = TexturePtr(new Texture(Size(BLOCK_SIZE, BLOCK_SIZE)));
+    texture->uploadSubPixels(Point(0, 0), Size(BLOCK_SIZE, BLOCK_SIZE), reinterpret_cast<uchar*>(pixels.data()));
+    return texture;
+}
+
+void Map::notifyZoneChange(const Position& pos)
+{
+    if(!pos.isMapPosition())
+        return;
+
+    const auto it = m_tileBlocks[pos.z].find(getBlockIndex(pos));
+    if(it != m_tileBlocks[pos.z].end())
+        it->second.mustUpdateZones();
 }
 
 Color Map::getZoneColor(tileflags_t flag)
@@ -489,23 +771,59 @@ void Map::endGhostMode()
     g_painter->resetOpacity();
 }
 
-std::map<Position, ItemPtr> Map::findItemsById(uint16 clientId, uint32 max)
+std::map<Position, ItemPtr> Map::findItemsByIdInArea(uint16 clientId, uint32 max, const Position& from, const Position& to)
 {
     std::map<Position, ItemPtr> ret;
-    uint32 count = 0;
+    const auto inArea = [&from, &to](const Position& pos) {
+        return !from.isValid() || (pos.x >= from.x && pos.x <= to.x && pos.y >= from.y && pos.y <= to.y && pos.z >= from.z && pos.z <= to.z);
+    };
+    const auto findOnTile = [&ret, clientId](const TilePtr& tile) {
+        for(const ItemPtr& item : tile->getItems()) {
+            if(item->getId() == clientId) {
+                ret.emplace(tile->getPosition(), item);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if(m_itemIndexEnabled) {
+        const auto it = m_itemIndex.find(clientId);
+        if(it == m_itemIndex.end())
+            return ret;
+
+        // tiles dropped along with their blocks leave their entries behind, they are purged here
+        std::vector<Position> stale;
+        for(const auto& entry : it->second) {
+            if(max > 0 && ret.size() >= max)
+                break;
+            if(!inArea(entry.first))
+                continue;
+
+            const TilePtr& tile = getTile(entry.first);
+            if(!tile || !findOnTile(tile))
+                stale.push_back(entry.first);
+        }
+
+        for(const Position& pos : stale)
+            it->second.erase(pos);
+        if(it->second.empty())
+            m_itemIndex.erase(it);
+        return ret;
+    }
+
     for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
+        if(from.isValid() && (z < from.z || z > to.z))
+            continue;
+
         for(const auto& pair : m_tileBlocks[z]) {
             const TileBlock& block = pair.second;
             for(const TilePtr& tile : block.getTiles()) {
-                if(unlikely(!tile || tile->isEmpty()))
+                if(unlikely(!tile || tile->isEmpty()) || !inArea(tile->getPosition()))
                     continue;
-                for(const ItemPtr& item : tile->getItems()) {
-                    if(item->getId() == clientId) {
-                        ret.insert(std::make_pair(tile->getPosition(), item));
-                        if(++count >= max)
-                            break;
-                    }
-                }
+
+                if(findOnTile(tile) && max > 0 && ret.size() >= max)
+                    return ret;
             }
         }
     }
@@ -513,6 +831,47 @@ std::map<Position, ItemPtr> Map::findItemsById(uint16 clientId, uint32 max)
     return ret;
 }
 
+void Map::setItemIndexEnabled(bool enabled)
+{
+    if(m_itemIndexEnabled == enabled)
+        return;
+
+    m_itemIndexEnabled = enabled;
+    m_itemIndex = {};
+    if(!enabled)
+        return;
+
+    for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
+        for(const auto& pair : m_tileBlocks[z]) {
+            for(const TilePtr& tile : pair.second.getTiles()) {
+                if(!tile)
+                    continue;
+                for(const ItemPtr& item : tile->getItems())
+                    indexItem(item->getId(), tile->getPosition());
+            }
+        }
+    }
+}
+
+void Map::indexItem(uint16 clientId, const Position& pos)
+{
+    ++m_itemIndex[clientId][pos];
+}
+
+void Map::unindexItem(uint16 clientId, const Position& pos)
+{
+    const auto it = m_itemIndex.find(clientId);
+    if(it == m_itemIndex.end())
+        return;
+
+    const auto posIt = it->second.find(pos);
+    if(posIt != it->second.end() && --posIt->second == 0)
+        it->second.erase(pos);
+
+    if(it->second.empty())
+        m_itemIndex.erase(it);
+}
+
 void Map::addCreature(const CreaturePtr& creature)
 {
     m_knownCreatures[creature->getId()] = creature;
@@ -532,8 +891,86 @@ void Map::removeCreatureById(uint32 id)
         return;
 
     const auto it = m_knownCreatures.find(id);
-    if(it != m_knownCreatures.end())
-        m_knownCreatures.erase(it);
+    if(it == m_knownCreatures.end())
+        return;
+
+    const CreaturePtr creature = it->second;
+    m_knownCreatures.erase(it);
+
+    const ticks_t now = g_clock.millis();
+    while(!m_cachedCreatureExpirations.empty()) {
+        const auto& front = m_cachedCreatureExpirations.front();
+        if(front.second > now && m_cachedCreatures.size() < MAX_CACHED_CREATURES)
+            break;
+
+        const auto cached = m_cachedCreatures.find(front.first);
+        if(cached != m_cachedCreatures.end() && cached->second.second == front.second)
+            m_cachedCreatures.erase(cached);
+        m_cachedCreatureExpirations.pop_front();
+    }
+
+    // the outfit, name text and sizes stay warm in case the server sends the creature again
+    if(m_creatureCacheTime > 0 && !creature->isLocalPlayer()) {
+        const ticks_t expiration = now + m_creatureCacheTime;
+        m_cachedCreatures[id] = std::make_pair(creature, expiration);
+        m_cachedCreatureExpirations.emplace_back(id, expiration);
+    }
+}
+
+CreaturePtr Map::takeCachedCreature(uint32 id)
+{
+    const auto it = m_cachedCreatures.find(id);
+    if(it == m_cachedCreatures.end())
+        return nullptr;
+
+    CreaturePtr creature;
+    if(it->second.second > g_clock.millis())
+        creature = it->second.first;
+    m_cachedCreatures.erase(it);
+    return creature;
+}
+
+void Map::addAnimatedCreature(const CreaturePtr& creature)
+{
+    if(creature->getAnimationSlot() >= 0)
+        return;
+
+    creature->setAnimationSlot(m_animatedCreatures.size());
+    m_animatedCreatures.push_back(creature);
+
+    if(!m_animatedCreaturesEvent)
+        m_animatedCreaturesEvent = g_dispatcher.cycleEvent([this] { updateAnimatedCreatures(); }, 1);
+}
+
+void Map::removeAnimatedCreature(const CreaturePtr& creature)
+{
+    const int slot = creature->getAnimationSlot();
+    if(slot < 0)
+        return;
+
+    // the last creature takes the freed slot
+    if(slot != static_cast<int>(m_animatedCreatures.size()) - 1) {
+        m_animatedCreatures[slot] = m_animatedCreatures.back();
+        m_animatedCreatures[slot]->setAnimationSlot(slot);
+    }
+    m_animatedCreatures.pop_back();
+    creature->setAnimationSlot(-1);
+}
+
+void Map::updateAnimatedCreatures()
+{
+    m_updatingCreatures = m_animatedCreatures;
+    for(const CreaturePtr& creature : m_updatingCreatures) {
+        creature->updateAnimations();
+        if(!creature->isAnimating())
+            removeAnimatedCreature(creature);
+    }
+    m_updatingCreatures.clear();
+
+    if(m_animatedCreatures.empty() && m_animatedCreaturesEvent) {
+        m_animatedCreaturesEvent->cancel();
+        m_animatedCreaturesEvent = nullptr;
+    }
 }
 
 void Map::removeUnawareThings()
@@ -545,14 +982,7 @@ void Map::removeUnawareThings()
             removeThing(creature);
     }
 
-    // remove static texts from tiles that we are not aware anymore
-    for(auto it = m_staticTexts.begin(); it != m_staticTexts.end();) {
-        const StaticTextPtr& staticText = *it;
-        if(staticText->getMessageMode() == Otc::MessageNone && !isAwareOfPosition(staticText->getPosition()))
-            it = m_staticTexts.erase(it);
-        else
-            ++it;
-    }
+    removeUnawareStaticTexts();
 
     if(!g_game.getFeature(Otc::GameKeepUnawareTiles)) {
         // remove tiles that we are not aware anymore
@@ -573,23 +1003,155 @@ void Map::removeUnawareThings()
                     block.remove(pos);
                 }
 
-                if(blockEmpty)
-                    it = tileBlocks.erase(it);
-                else
+                if(!blockEmpty) {
                     ++it;
+                    continue;
+                }
+
+                it = releaseTileBlock(z, it);
             }
         }
     }
 }
 
+void Map::removeUnawareThings(const Position& oldCentralPosition)
+{
+    const int dx = m_centralPosition.x - oldCentralPosition.x;
+    const int dy = m_centralPosition.y - oldCentralPosition.y;
+    const int width = m_awareRange.left + m_awareRange.right + 1;
+    const int height = m_awareRange.top + m_awareRange.bottom + 1;
+
+    for(int z = getFirstAwareFloor(); z <= getLastAwareFloor(); ++z) {
+        // other floors are aware of an area shifted diagonally, as in isAwareOfPosition
+        const int offset = oldCentralPosition.z - z;
+        const Rect oldArea(oldCentralPosition.x - m_awareRange.left + offset, oldCentralPosition.y - m_awareRange.top + offset, width, height);
+        const Rect newArea = oldArea.translated(dx, dy);
+
+        // columns left behind, over every row of the old area
+        const int columns = std::min(std::abs(dx), width);
+        if(dx > 0)
+            removeUnawareThingsInArea(z, Rect(oldArea.left(), oldArea.top(), columns, height));
+        else if(dx < 0)
+            removeUnawareThingsInArea(z, Rect(oldArea.right() - columns + 1, oldArea.top(), columns, height));
+
+        // rows left behind, over the columns both areas still share
+        const int sharedLeft = std::max(oldArea.left(), newArea.left());
+        const int sharedRight = std::min(oldArea.right(), newArea.right());
+        const int rows = std::min(std::abs(dy), height);
+        if(sharedLeft > sharedRight)
+            continue;
+        if(dy > 0)
+            removeUnawareThingsInArea(z, Rect(sharedLeft, oldArea.top(), sharedRight - sharedLeft + 1, rows));
+        else if(dy < 0)
+            removeUnawareThingsInArea(z, Rect(sharedLeft, oldArea.bottom() - rows + 1, sharedRight - sharedLeft + 1, rows));
+    }
+
+    removeUnawareStaticTexts();
+}
+
+void Map::removeUnawareThingsInArea(uint8 z, const Rect& area)
+{
+    const int fromX = std::max<int>(area.left(), 0), toX = std::min<int>(area.right(), UINT16_MAX),
+        fromY = std::max<int>(area.top(), 0), toY = std::min<int>(area.bottom(), UINT16_MAX);
+    if(fromX > toX || fromY > toY)
+        return;
+
+    const int fromBlockX = fromX / BLOCK_SIZE, toBlockX = toX / BLOCK_SIZE,
+        fromBlockY = fromY / BLOCK_SIZE, toBlockY = toY / BLOCK_SIZE;
+
+    // removing a creature unindexes it, so the positions are collected before anything is removed
+    std::vector<Position> positions;
+    const auto& creatureBlocks = m_creatureBlocks[z];
+    for(int by = fromBlockY; by <= toBlockY && !creatureBlocks.empty(); ++by) {
+        for(int bx = fromBlockX; bx <= toBlockX; ++bx) {
+            const auto it = creatureBlocks.find(getCreatureBlockIndex(bx * BLOCK_SIZE, by * BLOCK_SIZE));
+            if(it == creatureBlocks.end())
+                continue;
+
+            for(const Position& pos : it->second) {
+                if(pos.x >= fromX && pos.x <= toX && pos.y >= fromY && pos.y <= toY)
+                    positions.push_back(pos);
+            }
+        }
+    }
+
+    for(const Position& pos : positions) {
+        const TilePtr& tile = getTile(pos);
+        if(!tile)
+            continue;
+
+        const std::vector<CreaturePtr> creatures = tile->getCreatures();
+        for(const CreaturePtr& creature : creatures) {
+            if(!isAwareOfPosition(creature->getPosition()))
+                removeThing(creature);
+        }
+    }
+
+    if(g_game.getFeature(Otc::GameKeepUnawareTiles))
+        return;
+
+    std::unordered_map<uint, TileBlock>& tileBlocks = m_tileBlocks[z];
+    for(int by = fromBlockY; by <= toBlockY; ++by) {
+        for(int bx = fromBlockX; bx <= toBlockX; ++bx) {
+            const auto it = tileBlocks.find(getBlockIndex(Position(bx * BLOCK_SIZE, by * BLOCK_SIZE, z)));
+            if(it == tileBlocks.end())
+                continue;
+
+            TileBlock& block = it->second;
+            for(int y = std::max(fromY, by * BLOCK_SIZE); y <= std::min(toY, by * BLOCK_SIZE + BLOCK_SIZE - 1); ++y) {
+                for(int x = std::max(fromX, bx * BLOCK_SIZE); x <= std::min(toX, bx * BLOCK_SIZE + BLOCK_SIZE - 1); ++x) {
+                    const Position pos(x, y, z);
+                    if(block.get(pos) && !isAwareOfPosition(pos))
+                        block.remove(pos);
+                }
+            }
+
+            const auto& tiles = block.getTiles();
+            if(std::none_of(tiles.begin(), tiles.end(), [](const TilePtr& tile) { return tile != nullptr; }))
+                releaseTileBlock(z, it);
+        }
+    }
+}
+
+void Map::removeUnawareStaticTexts()
+{
+    // remove static texts from tiles that we are not aware anymore
+    for(auto it = m_staticTexts.begin(); it != m_staticTexts.end();) {
+        const StaticTextPtr& staticText = *it;
+        if(staticText->getMessageMode() == Otc::MessageNone && !isAwareOfPosition(staticText->getPosition()))
+            it = m_staticTexts.erase(it);
+        else
+            ++it;
+    }
+}
+
+std::unordered_map<uint, TileBlock>::iterator Map::releaseTileBlock(uint8 z, std::unordered_map<uint, TileBlock>::iterator it)
+{
+    std::unordered_map<uint, TileBlock>& tileBlocks = m_tileBlocks[z];
+    if(m_freeTileBlocks.size() >= MAX_FREE_TILE_BLOCKS)
+        return tileBlocks.erase(it);
+
+    const auto next = std::next(it);
+    m_freeTileBlocks.push_back(tileBlocks.extract(it));
+    return next;
+}
+
 void Map::setCentralPosition(const Position& centralPosition)
 {
     if(m_centralPosition == centralPosition)
         return;
 
+    const Position oldCentralPosition = m_centralPosition;
     m_centralPosition = centralPosition;
 
-    removeUnawareThings();
+    // a step only sweeps the strips that left the aware area, floor changes and teleports sweep the whole map
+    if(oldCentralPosition.isValid() && oldCentralPosition.z == centralPosition.z &&
+       std::abs(centralPosition.x - oldCentralPosition.x) <= 1 && std::abs(centralPosition.y - oldCentralPosition.y) <= 1)
+        removeUnawareThings(oldCentralPosition);
+    else
+        removeUnawareThings();
+    if(m_otcmData)
+        loadOtcmBlocks(centralPosition);
 
     // this fixes local player position when the local player is removed from the map,
     // the local player is removed from the map when there are too many creatures on his tile,
@@ -639,7 +1201,7 @@ std::vector<CreaturePtr> Map::getSpectatorsInRange(const Position& centerPos, bo
     return getSpectatorsInRangeEx(centerPos, multiFloor, xRange, xRange, yRange, yRange);
 }
 
-std::vector<CreaturePtr> Map::getSpectatorsInRangeEx(const Position& centerPos, bool multiFloor, int32 minXRange, int32 maxXRange, int32 minYRange, int32 maxYRange)
+std::vector<CreaturePtr> Map::getSpectatorsInRangeEx(const Position& centerPos, bool multiFloor, int32 minXRange, int32 maxXRange, int32 minYRange, int32 maxYRange, bool sortByDistance)
 {
     std::vector<CreaturePtr> creatures;
     uint8 minZRange = 0, maxZRange = 0;
@@ -649,25 +1211,102 @@ std::vector<CreaturePtr> Map::getSpectatorsInRangeEx(const Position& centerPos,
         maxZRange = getLastAwareFloor() - centerPos.z;
     }
 
-    //TODO: optimize
-    //TODO: delivery creatures in distance order
+    const int fromX = std::max<int>(0, centerPos.x - minXRange), toX = std::min<int>(UINT16_MAX, centerPos.x + maxXRange),
+        fromY = std::max<int>(0, centerPos.y - minYRange), toY = std::min<int>(UINT16_MAX, centerPos.y + maxYRange);
+    if(fromX > toX || fromY > toY)
+        return creatures;
+
+    const int fromBlockX = fromX / BLOCK_SIZE, toBlockX = toX / BLOCK_SIZE,
+        fromBlockY = fromY / BLOCK_SIZE, toBlockY = toY / BLOCK_SIZE;
+    const size_t rangeBlocks = static_cast<size_t>(toBlockX - fromBlockX + 1) * (toBlockY - fromBlockY + 1);
+
+    // only blocks holding creatures are visited, the range is walked by block unless it has more blocks than the floor
+    std::vector<Position> positions;
+    const auto collect = [&](const std::vector<Position>& blockPositions) {
+        for(const Position& pos : blockPositions) {
+            if(pos.x >= fromX && pos.x <= toX && pos.y >= fromY && pos.y <= toY)
+                positions.push_back(pos);
+        }
+    };
+
     for(int_fast8_t iz = -minZRange; iz <= maxZRange; ++iz) {
-        for(int_fast32_t iy = -minYRange; iy <= maxYRange; ++iy) {
-            for(int_fast32_t ix = -minXRange; ix <= maxXRange; ++ix) {
-                if(const TilePtr& tile = getTile(centerPos.translated(ix, iy, iz))) {
-                    auto tileCreatures = tile->getCreatures();
-                    creatures.insert(creatures.end(), tileCreatures.rbegin(), tileCreatures.rend());
+        const int z = centerPos.z + iz;
+        if(z < 0 || z > Otc::MAX_Z)
+            continue;
+
+        const auto& blocks = m_creatureBlocks[z];
+        if(blocks.empty())
+            continue;
+
+        if(rangeBlocks > blocks.size()) {
+            for(const auto& it : blocks)
+                collect(it.second);
+        } else {
+            for(int by = fromBlockY; by <= toBlockY; ++by) {
+                for(int bx = fromBlockX; bx <= toBlockX; ++bx) {
+                    const auto it = blocks.find(getCreatureBlockIndex(bx * BLOCK_SIZE, by * BLOCK_SIZE));
+                    if(it != blocks.end())
+                        collect(it->second);
                 }
             }
         }
     }
 
+    // same order as walking the range tile by tile: floor, row, column
+    std::sort(positions.begin(), positions.end(), [](const Position& a, const Position& b) {
+        return a.z < b.z || (a.z == b.z && (a.y < b.y || (a.y == b.y && a.x < b.x)));
+    });
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+    for(const Position& pos : positions) {
+        if(const TilePtr& tile = getTile(pos)) {
+            const auto& tileCreatures = tile->getCreatures();
+            creatures.insert(creatures.end(), tileCreatures.rbegin(), tileCreatures.rend());
+        }
+    }
+
+    if(sortByDistance) {
+        std::stable_sort(creatures.begin(), creatures.end(), [&centerPos](const CreaturePtr& a, const CreaturePtr& b) {
+            const Position& posA = a->getPosition();
+            const Position& posB = b->getPosition();
+            const int distanceA = std::max<int>(std::abs(posA.x - centerPos.x), std::abs(posA.y - centerPos.y));
+            const int distanceB = std::max<int>(std::abs(posB.x - centerPos.x), std::abs(posB.y - centerPos.y));
+            if(distanceA != distanceB)
+                return distanceA < distanceB;
+            return std::abs(posA.z - centerPos.z) < std::abs(posB.z - centerPos.z);
+        });
+    }
+
     return creatures;
 }
 
+void Map::indexCreature(const Position& pos)
+{
+    m_creatureBlocks[pos.z][getCreatureBlockIndex(pos.x, pos.y)].push_back(pos);
+}
+
+void Map::unindexCreature(const Position& pos)
+{
+    auto& blocks = m_creatureBlocks[pos.z];
+    const auto it = blocks.find(getCreatureBlockIndex(pos.x, pos.y));
+    if(it == blocks.end())
+        return;
+
+    // one entry per creature, several creatures may share a tile
+    auto& positions = it->second;
+    const auto posIt = std::find(positions.begin(), positions.end(), pos);
+    if(posIt != positions.end()) {
+        *posIt = positions.back();
+        positions.pop_back();
+    }
+
+    if(positions.empty())
+        blocks.erase(it);
+}
+
 bool Map::isLookPossible(const Position& pos)
 {
-    TilePtr tile = getTile(pos);
+    const TilePtr& tile = getTile(pos);
     return tile && tile->isLookPossible();
 }
 
@@ -676,13 +1315,13 @@ bool Map::isCovered(const Position& pos, uint8 firstFloor)
     // check for tiles on top of the postion
     Position tilePos = pos;
     while(tilePos.coveredUp() && tilePos.z >= firstFloor) {
-        TilePtr tile = getTile(tilePos);
         // the below tile is covered when the above tile has a full opaque
+        const TilePtr& tile = getTile(tilePos);
         if(tile && tile->isFullyOpaque())
             return true;
 
-        tile = getTile(tilePos.translated(1, 1));
-        if(tile && tile->isTopGround())
+        const TilePtr& nextTile = getTile(tilePos.translated(1, 1));
+        if(nextTile && nextTile->isTopGround())
             return true;
     }
     return false;
@@ -782,179 +1421,48 @@ uint8 Map::getLastAwareFloor()
 
 std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> Map::findPath(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags)
 {
-    // pathfinding using A* search algorithm
-    // as described in http://en.wikipedia.org/wiki/A*_search_algorithm
-
-    struct Node {
-        using Pair = std::pair<Node*, float>; // node, totalCost
-
-        Node(const Position& pos) : cost(0), pos(pos), prev(nullptr), dir(Otc::InvalidDirection) {}
-        float cost;
-        Position pos;
-        Node* prev;
-        Otc::Direction dir;
-
-        struct Compare {
-            bool operator() (const Pair& a, const Pair& b) const
-            {
-                return b.second < a.second;
-            }
-        };
-    };
-
-    std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> ret;
-    std::vector<Otc::Direction>& dirs = std::get<0>(ret);
-    Otc::PathFindResult& result = std::get<1>(ret);
-
-    result = Otc::PathFindResultNoWay;
-
-    if(startPos == goalPos) {
-        result = Otc::PathFindResultSamePosition;
-        return ret;
-    }
-
-    if(startPos.z != goalPos.z) {
-        result = Otc::PathFindResultImpossible;
-        return ret;
-    }
-
-    // check the goal pos is walkable
-    if(g_map.isAwareOfPosition(goalPos)) {
-        const TilePtr goalTile = getTile(goalPos);
-        if(!goalTile || !goalTile->isWalkable((flags & Otc::PathFindAllowCreatures))) {
-            return ret;
-        }
-    } else {
-        const MinimapTile& goalTile = g_minimap.getTile(goalPos);
-        if(goalTile.hasFlag(MinimapTileNotWalkable)) {
-            return ret;
-        }
-    }
-
-    std::unordered_map<Position, Node*, Position::Hasher> nodes;
-    std::priority_queue<Node::Pair, std::deque<Node::Pair>, Node::Compare> searchList;
-
-    Node* currentNode = new Node(startPos);
-    nodes[startPos] = currentNode;
-    Node* foundNode = nullptr;
-    float totalCost = 0;
-    while(currentNode) {
-        if(static_cast<uint16>(nodes.size()) > maxComplexity) {
-            foundNode = nullptr;
-            result = Otc::PathFindResultTooFar;
-            break;
-        }
-
-        // path found
-        if(currentNode->pos == goalPos && (!foundNode || currentNode->cost < foundNode->cost)) {
-            foundNode = currentNode;
-
-        // cost too high, and the priority_queue is sorted by "totalCost", so the rest of nodes won't be better
-        } else if(foundNode && totalCost >= foundNode->cost) {
-            break;
-
-        } else {
-            for(int_fast32_t i = -1; i <= 1; ++i) {
-                for(int_fast32_t j = -1; j <= 1; ++j) {
-                    if(i == 0 && j == 0)
-                        continue;
-
-                    bool wasSeen = false;
-                    bool hasCreature = false;
-                    bool isNotWalkable = true;
-                    bool isNotPathable = true;
-                    uint16 speed = 100;
-
-                    Position neighborPos = currentNode->pos.translated(i, j);
-                    if(g_map.isAwareOfPosition(neighborPos)) {
-                        wasSeen = true;
-                        if(const TilePtr& tile = getTile(neighborPos)) {
-                            hasCreature = tile->getCreatures().size() > 0;
-                            isNotWalkable = !tile->isWalkable(flags & Otc::PathFindAllowCreatures);
-                            isNotPathable = !tile->isPathable();
-                            speed = tile->getGroundSpeed();
-                        }
-                    } else {
-                        const MinimapTile& mtile = g_minimap.getTile(neighborPos);
-                        wasSeen = mtile.hasFlag(MinimapTileWasSeen);
-                        isNotWalkable = mtile.hasFlag(MinimapTileNotWalkable);
-                        isNotPathable = mtile.hasFlag(MinimapTileNotPathable);
-                        if(isNotWalkable || isNotPathable)
-                            wasSeen = true;
-                        speed = mtile.getSpeed();
-                    }
+    return m_pathFinder.find(startPos, goalPos, maxComplexity, flags);
+}
 
-                    if(neighborPos != goalPos) {
-                        if(!(flags & Otc::PathFindAllowNotSeenTiles) && !wasSeen)
-                            continue;
-                        if(wasSeen) {
-                            if(!(flags & Otc::PathFindAllowCreatures) && hasCreature)
-                                continue;
-                            if(!(flags & Otc::PathFindAllowNonPathable) && isNotPathable)
-                                continue;
-                            if(!(flags & Otc::PathFindAllowNonWalkable) && isNotWalkable)
-                                continue;
-                        }
-                    } else {
-                        if(!(flags & Otc::PathFindAllowNotSeenTiles) && !wasSeen)
-                            continue;
-                        if(wasSeen) {
-                            if(!(flags & Otc::PathFindAllowNonWalkable) && isNotWalkable)
-                                continue;
-                        }
-                    }
+std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> Map::findRoute(const Position& startPos, const Position& goalPos)
+{
+    return m_routeFinder.find(startPos, goalPos);
+}
 
-                    float walkFactor;
-                    const Otc::Direction walkDir = currentNode->pos.getDirectionFromPosition(neighborPos);
-                    if(walkDir >= Otc::NorthEast)
-                        walkFactor = 3.0f;
-                    else
-                        walkFactor = 1.0f;
-
-                    const float cost = currentNode->cost + (speed * walkFactor) / 100.0f;
-
-                    Node* neighborNode;
-                    if(nodes.find(neighborPos) == nodes.end()) {
-                        neighborNode = new Node(neighborPos);
-                        nodes[neighborPos] = neighborNode;
-                    } else {
-                        neighborNode = nodes[neighborPos];
-                        if(neighborNode->cost <= cost)
-                            continue;
-                    }
+void Map::findPathAsync(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags, const std::function<void(std::vector<Otc::Direction>, Otc::PathFindResult)>& callback)
+{
+    m_pathRequests.push_back({ startPos, goalPos, maxComplexity, flags, callback, false });
+    if(!m_pathRequestsEvent)
+        m_pathRequestsEvent = g_dispatcher.scheduleEvent([this] { processPathRequests(); }, 0);
+}
 
-                    neighborNode->prev = currentNode;
-                    neighborNode->cost = cost;
-                    neighborNode->dir = walkDir;
-                    searchList.emplace(neighborNode, neighborNode->cost + neighborPos.distance(goalPos));
-                }
-            }
-        }
+void Map::processPathRequests()
+{
+    // nodes expanded per frame, enough for most paths to finish in a single slice
+    const int PATH_EXPANSIONS_PER_FRAME = 4096;
 
-        if(!searchList.empty()) {
-            const auto &top = searchList.top();
-            currentNode = top.first;
-            totalCost = top.second;
-            searchList.pop();
-        } else
-            currentNode = nullptr;
-    }
+    m_pathRequestsEvent = nullptr;
+    if(m_pathRequests.empty())
+        return;
 
-    if(foundNode) {
-        currentNode = foundNode;
-        while(currentNode) {
-            dirs.push_back(currentNode->dir);
-            currentNode = currentNode->prev;
-        }
-        dirs.pop_back();
-        std::reverse(dirs.begin(), dirs.end());
-        result = Otc::PathFindResultOk;
+    PathRequest& request = m_pathRequests.front();
+    bool finished;
+    if(!request.started) {
+        request.started = true;
+        finished = !m_asyncPathFinder.start(request.start, request.goal, request.maxComplexity, request.flags) || m_asyncPathFinder.step(PATH_EXPANSIONS_PER_FRAME);
+    } else
+        finished = m_asyncPathFinder.step(PATH_EXPANSIONS_PER_FRAME);
+
+    if(finished) {
+        const auto result = m_asyncPathFinder.getResult();
+        const auto callback = request.callback;
+        m_pathRequests.pop_front();
+        if(callback)
+            callback(std::get<0>(result), std::get<1>(result));
     }
 
-    for(auto it : nodes)
-        delete it.second;
-
-    return ret;
+    if(!m_pathRequests.empty() && !m_pathRequestsEvent)
+        m_pathRequestsEvent = g_dispatcher.scheduleEvent([this] { processPathRequests(); }, 1);
 }
 
 void  Map::resetLastCamera()
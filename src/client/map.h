@@ -27,6 +27,7 @@
 #include "creature.h"
 #include "creatures.h"
 #include "houses.h"
+#include "pathfinder.h"
 #include "statictext.h"
 #include "tile.h"
 #include "towns.h"
@@ -34,6 +35,8 @@
 #include <framework/core/clock.h>
 #include <framework/graphics/framebuffer.h>
 
+#include <future>
+
 enum OTBM_ItemAttr
 {
     OTBM_ATTR_DESCRIPTION = 1,
@@ -87,11 +90,24 @@ enum OTBM_NodeTypes_t
 
 enum {
     OTCM_SIGNATURE = 0x4D43544F,
-    OTCM_VERSION = 1
+    OTCM_VERSION = 2
+};
+
+enum {
+    // tile blocks are stored as zlib streams listed by an index at the end of the file
+    OTCM_FLAG_COMPRESSED_BLOCKS = 1
 };
 
 enum {
-    BLOCK_SIZE = 32
+    BLOCK_SIZE = 32,
+    // emptied tile blocks kept for reuse, enough for the aware area on every floor
+    MAX_FREE_TILE_BLOCKS = 128,
+    // creatures the server stopped knowing, kept to be reused if they are sent again
+    MAX_CACHED_CREATURES = 256,
+    // removed animated and static texts kept for reuse, damage floods create hundreds per second
+    MAX_POOLED_TEXTS = 128,
+    // longest time expired effects and missiles wait to be swept while no map view is drawn
+    MAX_EFFECT_SWEEP_DELAY = 1000
 };
 
 enum : uint8 {
@@ -99,6 +115,12 @@ enum : uint8 {
     Animation_Show
 };
 
+enum : uint8 {
+    TileUpdateThing = 1 << 0,
+    TileUpdateCreature = 1 << 1,
+    TileUpdateMinimap = 1 << 2
+};
+
 class TileBlock {
 public:
     TileBlock() { m_tiles.fill(nullptr); }
@@ -107,6 +129,7 @@ public:
     {
         TilePtr& tile = m_tiles[getTileIndex(pos)];
         tile = TilePtr(new Tile(pos));
+        mustUpdateZones();
         return tile;
     }
     const TilePtr& getOrCreate(const Position& pos)
@@ -117,14 +140,58 @@ public:
         return tile;
     }
     const TilePtr& get(const Position& pos) { return m_tiles[getTileIndex(pos)]; }
-    void remove(const Position& pos) { m_tiles[getTileIndex(pos)] = nullptr; }
+    void remove(const Position& pos) { m_tiles[getTileIndex(pos)] = nullptr; mustUpdateZones(); }
 
     uint getTileIndex(const Position& pos) { return ((pos.y % BLOCK_SIZE) * BLOCK_SIZE) + (pos.x % BLOCK_SIZE); }
 
     const std::array<TilePtr, BLOCK_SIZE* BLOCK_SIZE>& getTiles() const { return m_tiles; }
 
+    // one texel per tile tinted by its shown zones, the map rebuilds it when it was made for an older zone revision
+    TexturePtr& getZoneTexture() { return m_zoneTexture; }
+    uint32 getZoneRevision() { return m_zoneRevision; }
+    void setZoneRevision(uint32 revision) { m_zoneRevision = revision; }
+    void mustUpdateZones() { m_zoneRevision = 0; }
+
 private:
     std::array<TilePtr, BLOCK_SIZE* BLOCK_SIZE> m_tiles;
+    TexturePtr m_zoneTexture;
+    uint32 m_zoneRevision{ 0 };
+};
+
+// plain data decoded from OTBM nodes by worker threads, turned into tiles and items on the main thread
+struct OtbmItemRecord
+{
+    uint16 id;
+    // items stored as a tile attribute have no attributes of their own
+    bool inlined;
+    // offset of the item node in the map data, its attributes are read in place when the item is created
+    uint node;
+    std::vector<OtbmItemRecord> contents;
+};
+
+struct OtbmTileRecord
+{
+    Position pos;
+    uint32 houseId;
+    uint32 flags;
+    bool house;
+    std::vector<OtbmItemRecord> items;
+};
+
+struct OtbmBatch
+{
+    std::vector<OtbmTileRecord> tiles;
+    uint areas{ 0 };
+    std::string error;
+};
+
+struct OtbmScan
+{
+    std::vector<std::shared_future<OtbmBatch>> batches;
+    std::vector<std::tuple<uint32, std::string, Position>> towns;
+    std::vector<std::pair<Position, std::string>> waypoints;
+    uint areas{ 0 };
+    std::string error;
 };
 
 //@bindsingleton g_map
@@ -136,7 +203,11 @@ public:
 
     void addMapView(const MapViewPtr& mapView);
     void removeMapView(const MapViewPtr& mapView);
+    const std::vector<MapViewPtr>& getMapViews() { return m_mapViews; }
     void notificateTileUpdate(const Position& pos, const ThingPtr& thing, const Otc::Operation operation);
+    // tile updates between these calls reach the map views and the minimap once per tile at the outermost commit
+    void beginTileUpdates() { ++m_tileUpdateDepth; }
+    void commitTileUpdates();
     void notificateCameraMove(const Point& offset);
     void notificateKeyRelease(const InputEvent& inputEvent);
 
@@ -144,7 +215,16 @@ public:
     void saveOtcm(const std::string& fileName);
 
     void loadOtbm(const std::string& fileName);
+    // loads in background, reporting g_map.onLoadProgress(areas, totalAreas) and g_map.onLoadFinish(success)
+    bool loadOtbmAsync(const std::string& fileName) { return startOtbmLoad(fileName, Position(), Position(), true); }
+    // like loadOtbmAsync, but only tiles inside the box from..to are created
+    bool loadOtbmRegion(const std::string& fileName, const Position& from, const Position& to) { return startOtbmLoad(fileName, from, to, true); }
+    void cancelOtbmLoad();
+    bool isLoadingOtbm() { return m_otbmLoad != nullptr; }
     void saveOtbm(const std::string& fileName);
+    // snapshots the map and writes it in background, reporting g_map.onSaveProgress(areas, totalAreas) and g_map.onSaveFinish(success)
+    bool saveOtbmAsync(const std::string& fileName) { return startOtbmSave(fileName, true); }
+    bool isSavingOtbm() { return m_otbmSave != nullptr; }
 
     // otbm attributes (description, size, etc.)
     void setHouseFile(const std::string& file) { m_attribs.set(OTBM_ATTR_HOUSE_FILE, file); }
@@ -173,6 +253,9 @@ public:
     void removeThingColor(const ThingPtr& thing);
 
     StaticTextPtr getStaticText(const Position& pos);
+    // reuse a removed text when nothing else holds it anymore
+    AnimatedTextPtr createAnimatedText();
+    StaticTextPtr createStaticText();
 
     // tile related
     const TilePtr& createTile(const Position& pos);
@@ -182,6 +265,10 @@ public:
     const TilePtr& getTile(const Position& pos);
     const TileList getTiles(int8 floor = -1);
     void cleanTile(const Position& pos);
+    // tile count and bytes held by tiles and tile blocks, including the ones kept for reuse
+    std::map<std::string, uint> getTileMemoryUsage();
+    // hands the thing types of the aware area to g_things.prewarmTextures, the central floor nearest first
+    void prewarmTextures();
 
     // tile zone related
     void setShowZone(tileflags_t zone, bool show);
@@ -194,6 +281,9 @@ public:
     tileflags_t getZoneFlags() { return static_cast<tileflags_t>(m_zoneFlags); }
     bool showZones() { return m_zoneFlags != 0; }
     bool showZone(tileflags_t zone) { return (m_zoneFlags & zone) == zone; }
+    // the zone overlay of the block holding pos, null when none of its tiles has a shown zone with a color
+    const TexturePtr& getZoneTexture(const Position& pos);
+    void notifyZoneChange(const Position& pos);
 
     void setForceShowAnimations(bool force);
     bool isForcingAnimations();
@@ -203,16 +293,34 @@ public:
     void beginGhostMode(float opacity);
     void endGhostMode();
 
-    std::map<Position, ItemPtr> findItemsById(uint16 clientId, uint32 max);
+    std::map<Position, ItemPtr> findItemsById(uint16 clientId, uint32 max) { return findItemsByIdInArea(clientId, max, Position(), Position()); }
+    // like findItemsById, but only tiles inside the box from..to are looked at, max 0 finds them all
+    std::map<Position, ItemPtr> findItemsByIdInArea(uint16 clientId, uint32 max, const Position& from, const Position& to);
+    // positions of the items of every client id, kept by Tile for the find queries of editor tools,
+    // games leave it disabled and the queries walk the tiles
+    void setItemIndexEnabled(bool enabled);
+    bool isItemIndexEnabled() { return m_itemIndexEnabled; }
+    void indexItem(uint16 clientId, const Position& pos);
+    void unindexItem(uint16 clientId, const Position& pos);
 
     // known creature related
     void addCreature(const CreaturePtr& creature);
     CreaturePtr getCreatureById(uint32 id);
     void removeCreatureById(uint32 id);
+    // the creature dropped by removeCreatureById, if it is still cached
+    CreaturePtr takeCachedCreature(uint32 id);
+    void setCreatureCacheTime(int time) { m_creatureCacheTime = std::max<int>(time, 0); }
+    int getCreatureCacheTime() { return m_creatureCacheTime; }
+    // keeps the creature updated every frame until it has no running animations, see Creature::startAnimation
+    void addAnimatedCreature(const CreaturePtr& creature);
     std::vector<CreaturePtr> getSightSpectators(const Position& centerPos, bool multiFloor);
     std::vector<CreaturePtr> getSpectators(const Position& centerPos, bool multiFloor);
     std::vector<CreaturePtr> getSpectatorsInRange(const Position& centerPos, bool multiFloor, int32 xRange, int32 yRange);
-    std::vector<CreaturePtr> getSpectatorsInRangeEx(const Position& centerPos, bool multiFloor, int32 minXRange, int32 maxXRange, int32 minYRange, int32 maxYRange);
+    std::vector<CreaturePtr> getSpectatorsInRangeEx(const Position& centerPos, bool multiFloor, int32 minXRange, int32 maxXRange, int32 minYRange, int32 maxYRange, bool sortByDistance = false);
+
+    // positions of creatures standing on tiles, kept by Tile to answer spectator queries
+    void indexCreature(const Position& pos);
+    void unindexCreature(const Position& pos);
 
     void setLight(const Light& light);
 
@@ -234,29 +342,122 @@ public:
     uint8 getFirstAwareFloor();
     uint8 getLastAwareFloor();
     const std::vector<MissilePtr>& getFloorMissiles(uint8 z) { return m_floorMissiles[z]; }
+    // effects and missiles are not removed by events of their own, the map views sweep the expired ones
+    // before drawing a frame
+    void removeExpiredEffects();
 
-    std::vector<AnimatedTextPtr> getAnimatedTexts() { return m_animatedTexts; }
-    std::vector<StaticTextPtr> getStaticTexts() { return m_staticTexts; }
+    const std::vector<AnimatedTextPtr>& getAnimatedTexts() { return m_animatedTexts; }
+    const std::vector<StaticTextPtr>& getStaticTexts() { return m_staticTexts; }
 
     std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> findPath(const Position& start, const Position& goal, uint16 maxComplexity, uint32 flags = 0);
+    // searches are spread over frames and run one after another, the callback gets the same result as findPath
+    void findPathAsync(const Position& start, const Position& goal, uint16 maxComplexity, uint32 flags, const std::function<void(std::vector<Otc::Direction>, Otc::PathFindResult)>& callback);
+    // long distance routes over the tiles known by the minimap, not limited by the path finder radius
+    std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> findRoute(const Position& start, const Position& goal);
 
     void setFloatingEffect(bool enable) { m_floatingEffect = enable; }
     bool isDrawingFloatingEffects() { return m_floatingEffect; }
 
 private:
+    struct PathRequest {
+        Position start, goal;
+        uint16 maxComplexity;
+        uint32 flags;
+        std::function<void(std::vector<Otc::Direction>, Otc::PathFindResult)> callback;
+        bool started;
+    };
+
+    // a tile block of the loaded OTCM cache, created only once the player gets close to it
+    struct OtcmBlock {
+        uint32 offset;
+        uint32 compressedSize;
+        uint32 size;
+        bool loaded;
+    };
+
+    struct OtbmLoad {
+        std::string fileName;
+        // records point into this buffer
+        std::shared_ptr<const std::string> data;
+        std::shared_future<OtbmScan> scan;
+        bool scanned;
+        std::vector<std::shared_future<OtbmBatch>> batches;
+        uint nextBatch, nextTile;
+        uint loadedAreas, totalAreas;
+    };
+
+    struct OtbmSave {
+        std::string fileName;
+        FileStreamPtr file;
+        // file version and map header nodes, then the tile areas in file order, then towns, waypoints and closing nodes
+        std::string header, footer;
+        std::vector<std::shared_future<std::string>> chunks;
+        std::vector<uint> chunkAreas;
+        std::shared_future<void> write;
+        uint encodedChunks, savedAreas, totalAreas;
+    };
+
     void removeUnawareThings();
+    void removeUnawareThings(const Position& oldCentralPosition);
+    void removeUnawareThingsInArea(uint8 z, const Rect& area);
+    void removeUnawareStaticTexts();
+    std::unordered_map<uint, TileBlock>::iterator releaseTileBlock(uint8 z, std::unordered_map<uint, TileBlock>::iterator it);
+    void removeAnimatedCreature(const CreaturePtr& creature);
+    void updateAnimatedCreatures();
+    TileBlock& getOrCreateTileBlock(const Position& pos);
+    void processPathRequests();
+    bool startOtbmLoad(const std::string& fileName, const Position& regionFrom, const Position& regionTo, bool async);
+    bool commitOtbmLoad(bool wait);
+    void commitOtbmTile(const OtbmTileRecord& record, const std::string& data);
+    void processOtbmLoad();
+    bool startOtbmSave(const std::string& fileName, bool async);
+    bool commitOtbmSave(bool wait);
+    void processOtbmSave();
+    void loadOtcmBlocks(const Position& centralPosition);
+    void loadOtcmBlock(uint8 z, uint index, OtcmBlock& block);
 
     uint16 getBlockIndex(const Position& pos) { return ((pos.y / BLOCK_SIZE) * (65536 / BLOCK_SIZE)) + (pos.x / BLOCK_SIZE); }
+    uint getCreatureBlockIndex(int x, int y) { return ((y / BLOCK_SIZE) * (65536 / BLOCK_SIZE)) + (x / BLOCK_SIZE); }
 
     std::array<std::vector<MissilePtr>, Otc::MAX_Z + 1> m_floorMissiles;
+    // every effect added to a tile, in no order
+    std::array<std::vector<EffectPtr>, Otc::MAX_Z + 1> m_floorEffects;
+    ticks_t m_lastEffectSweep{ 0 };
 
     std::vector<AnimatedTextPtr> m_animatedTexts;
     std::vector<StaticTextPtr> m_staticTexts;
+    std::vector<AnimatedTextPtr> m_animatedTextPool;
+    std::vector<StaticTextPtr> m_staticTextPool;
     std::vector<MapViewPtr> m_mapViews;
 
     std::unordered_map<uint, TileBlock> m_tileBlocks[Otc::MAX_Z + 1];
+    std::vector<std::unordered_map<uint, TileBlock>::node_type> m_freeTileBlocks;
+    std::unordered_map<uint, std::vector<Position>> m_creatureBlocks[Otc::MAX_Z + 1];
+    // items with that client id on each position
+    std::unordered_map<uint16, stdext::flat_hash_map<Position, uint16, Position::Hasher>> m_itemIndex;
+    bool m_itemIndexEnabled{ false };
     std::unordered_map<uint32, CreaturePtr> m_knownCreatures;
-    std::unordered_map<Position, std::string, Position::Hasher> m_waypoints;
+    std::unordered_map<uint32, std::pair<CreaturePtr, ticks_t>> m_cachedCreatures;
+    // expiration order, entries taken back from the cache are skipped when they come up
+    std::deque<std::pair<uint32, ticks_t>> m_cachedCreatureExpirations;
+    int m_creatureCacheTime{ 10000 };
+
+    PathFinder m_pathFinder, m_asyncPathFinder;
+    RouteFinder m_routeFinder;
+    // indexed by Creature::getAnimationSlot, updates iterate a copy since animations may add or remove creatures
+    std::vector<CreaturePtr> m_animatedCreatures;
+    std::vector<CreaturePtr> m_updatingCreatures;
+    ScheduledEventPtr m_animatedCreaturesEvent;
+    std::deque<PathRequest> m_pathRequests;
+    ScheduledEventPtr m_pathRequestsEvent;
+    std::shared_ptr<OtbmLoad> m_otbmLoad;
+    ScheduledEventPtr m_otbmLoadEvent;
+    std::shared_ptr<OtbmSave> m_otbmSave;
+    std::shared_ptr<const std::string> m_otcmData;
+    std::unordered_map<uint, OtcmBlock> m_otcmBlocks[Otc::MAX_Z + 1];
+    stdext::flat_hash_map<Position, std::string, Position::Hasher> m_waypoints;
+    stdext::flat_hash_map<Position, uint8, Position::Hasher> m_pendingTileUpdates;
+    int m_tileUpdateDepth{ 0 };
 
     std::map<uint32, Color> m_zoneColors;
 
@@ -264,6 +465,8 @@ private:
 
     uint8 m_animationFlags;
     uint32 m_zoneFlags;
+    // bumped when the shown zones or their colors change, block overlays made for another revision are rebuilt
+    uint32 m_zoneRevision{ 1 };
 
     float m_zoneOpacity;
 
@@ -279,4 +482,12 @@ private:
 
 extern Map g_map;
 
+// batches the tile updates of its scope, see Map::beginTileUpdates
+class TileUpdateBatch
+{
+public:
+    TileUpdateBatch() { g_map.beginTileUpdates(); }
+    ~TileUpdateBatch() { g_map.commitTileUpdates(); }
+};
+
 #endif
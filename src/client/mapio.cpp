@@ -24,64 +24,309 @@
 #include "map.h"
 #include "tile.h"
 
+#include <zlib.h>
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/binarytree.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
+#include <framework/luaengine/luainterface.h>
 #include <framework/ui/uiwidget.h>
 #include <framework/xml/tinyxml.h>
 
+namespace {
+    // areas handed to one worker, big enough to keep workers busy and small enough to commit early
+    const uint OTBM_BATCH_BYTES = 1024 * 1024;
+    // main thread time spent committing tiles per frame while loading in background
+    const ticks_t OTBM_COMMIT_MILLIS = 8;
+
+    bool inRegion(const Position& pos, const Position& from, const Position& to)
+    {
+        return !from.isValid() || (pos.x >= from.x && pos.x <= to.x && pos.y >= from.y && pos.y <= to.y && pos.z >= from.z && pos.z <= to.z);
+    }
+
+    OtbmItemRecord decodeOtbmItem(BinaryTreeView& node, const char* invalidError)
+    {
+        if(node.getU8() != OTBM_ITEM)
+            stdext::throw_exception(invalidError);
+
+        OtbmItemRecord item;
+        item.node = node.getStart();
+        item.id = node.getU16();
+        item.inlined = false;
+        return item;
+    }
+
+    const int OTCM_COMPRESS_LEVEL = 3;
+
+    // tiles of one block in the OTCM v1 tile layout, without the end of file marker
+    void serializeOtcmTiles(const TileBlock& block, std::vector<uint8>& out)
+    {
+        out.clear();
+        uint8 buffer[5];
+        for(const TilePtr& tile : block.getTiles()) {
+            if(!tile || tile->isEmpty())
+                continue;
+
+            const Position pos = tile->getPosition();
+            stdext::writeULE16(buffer, pos.x);
+            stdext::writeULE16(buffer + 2, pos.y);
+            buffer[4] = pos.z;
+            out.insert(out.end(), buffer, buffer + 5);
+
+            for(const ThingPtr& thing : tile->getThings()) {
+                if(thing->isItem()) {
+                    ItemPtr item = thing->static_self_cast<Item>();
+                    stdext::writeULE16(buffer, item->getId());
+                    buffer[2] = item->getCountOrSubType();
+                    out.insert(out.end(), buffer, buffer + 3);
+                }
+            }
+
+            // end of tile
+            stdext::writeULE16(buffer, 0xFFFF);
+            out.insert(out.end(), buffer, buffer + 2);
+        }
+    }
+
+    // the attributes of a decoded item node, read in place from the map data
+    BinaryTreeView getItemAttributes(const std::string& data, const OtbmItemRecord& record)
+    {
+        BinaryTreeView node(reinterpret_cast<const uint8*>(data.data()), data.size(), record.node);
+        node.skip(3); // node type and item id, already decoded
+        return node;
+    }
+
+    // runs on workers, everything it produces is plain data
+    OtbmBatch decodeOtbmAreas(const std::string& data, const std::vector<uint>& areas, const Position& from, const Position& to)
+    {
+        OtbmBatch batch;
+        try {
+            for(uint start : areas) {
+                BinaryTreeView area(reinterpret_cast<const uint8*>(data.data()), data.size(), start);
+                area.getU8();
+                Position basePos;
+                basePos.x = area.getU16();
+                basePos.y = area.getU16();
+                basePos.z = area.getU8();
+                ++batch.areas;
+
+                for(BinaryTreeView node : area.getChildren()) {
+                    const uint8 type = node.getU8();
+                    if(unlikely(type != OTBM_TILE && type != OTBM_HOUSETILE))
+                        stdext::throw_exception(stdext::format("invalid node tile type %d", static_cast<int>(type)));
+
+                    OtbmTileRecord tile;
+                    tile.pos.x = basePos.x + node.getU8();
+                    tile.pos.y = basePos.y + node.getU8();
+                    tile.pos.z = basePos.z;
+                    tile.house = type == OTBM_HOUSETILE;
+                    tile.houseId = tile.house ? node.getU32() : 0;
+                    tile.flags = TILESTATE_NONE;
+
+                    if(!inRegion(tile.pos, from, to))
+                        continue;
+
+                    while(node.canRead()) {
+                        const uint8 tileAttr = node.getU8();
+                        switch(tileAttr) {
+                        case OTBM_ATTR_TILE_FLAGS:
+                        {
+                            const uint32 _flags = node.getU32();
+                            if((_flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
+                                tile.flags |= TILESTATE_PROTECTIONZONE;
+                            else if((_flags & TILESTATE_OPTIONALZONE) == TILESTATE_OPTIONALZONE)
+                                tile.flags |= TILESTATE_OPTIONALZONE;
+                            else if((_flags & TILESTATE_HARDCOREZONE) == TILESTATE_HARDCOREZONE)
+                                tile.flags |= TILESTATE_HARDCOREZONE;
+
+                            if((_flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
+                                tile.flags |= TILESTATE_NOLOGOUT;
+
+                            if((_flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
+                                tile.flags |= TILESTATE_REFRESH;
+                            break;
+                        }
+                        case OTBM_ATTR_ITEM:
+                        {
+                            OtbmItemRecord item;
+                            item.id = node.getU16();
+                            item.node = 0;
+                            item.inlined = true;
+                            tile.items.push_back(std::move(item));
+                            break;
+                        }
+                        default:
+                        {
+                            stdext::throw_exception(stdext::format("invalid tile attribute %d at pos %s",
+                                                                   static_cast<int>(tileAttr), stdext::to_string(tile.pos)));
+                        }
+                        }
+                    }
+
+                    for(BinaryTreeView itemNode : node.getChildren()) {
+                        OtbmItemRecord item = decodeOtbmItem(itemNode, "invalid item node");
+                        for(BinaryTreeView containerNode : itemNode.getChildren())
+                            item.contents.push_back(decodeOtbmItem(containerNode, "invalid container item node"));
+                        tile.items.push_back(std::move(item));
+                    }
+
+                    batch.tiles.push_back(std::move(tile));
+                }
+            }
+        } catch(std::exception& e) {
+            batch.error = e.what();
+        }
+        return batch;
+    }
+
+    // runs on a worker: splits the map data children into area batches for other workers and reads towns and waypoints
+    OtbmScan scanOtbm(const std::shared_ptr<const std::string>& data, uint mapDataStart, uint32 headerVersion, const Position& from, const Position& to)
+    {
+        OtbmScan scan;
+        try {
+            std::vector<uint> areas;
+            uint batchStart = 0;
+            const auto flush = [&] {
+                if(areas.empty())
+                    return;
+                scan.batches.push_back(g_asyncDispatcher.schedule([data, areas, from, to] { return decodeOtbmAreas(*data, areas, from, to); }));
+                areas.clear();
+            };
+
+            BinaryTreeView mapData(reinterpret_cast<const uint8*>(data->data()), data->size(), mapDataStart);
+            for(BinaryTreeView node : mapData.getChildren()) {
+                const uint8 mapDataType = node.getU8();
+                if(mapDataType == OTBM_TILE_AREA) {
+                    Position basePos;
+                    basePos.x = node.getU16();
+                    basePos.y = node.getU16();
+                    basePos.z = node.getU8();
+
+                    // an area spans 256x256 tiles from its base position
+                    if(from.isValid() && (basePos.x > to.x || basePos.x + 255 < from.x || basePos.y > to.y || basePos.y + 255 < from.y || basePos.z < from.z || basePos.z > to.z))
+                        continue;
+
+                    // batches are sized by the distance between their first and last area, skipped areas included
+                    if(!areas.empty() && node.getStart() - batchStart >= OTBM_BATCH_BYTES)
+                        flush();
+                    if(areas.empty())
+                        batchStart = node.getStart();
+                    areas.push_back(node.getStart());
+                    ++scan.areas;
+                } else if(mapDataType == OTBM_TOWNS) {
+                    for(BinaryTreeView town : node.getChildren()) {
+                        if(town.getU8() != OTBM_TOWN)
+                            stdext::throw_exception("invalid town node.");
+
+                        const uint32 townId = town.getU32();
+                        std::string townName = town.getString();
+
+                        Position townCoords;
+                        townCoords.x = town.getU16();
+                        townCoords.y = town.getU16();
+                        townCoords.z = town.getU8();
+                        scan.towns.emplace_back(townId, townName, townCoords);
+                    }
+                } else if(mapDataType == OTBM_WAYPOINTS && headerVersion > 1) {
+                    for(BinaryTreeView waypoint : node.getChildren()) {
+                        if(waypoint.getU8() != OTBM_WAYPOINT)
+                            stdext::throw_exception("invalid waypoint node.");
+
+                        std::string name = waypoint.getString();
+
+                        Position waypointPos;
+                        waypointPos.x = waypoint.getU16();
+                        waypointPos.y = waypoint.getU16();
+                        waypointPos.z = waypoint.getU8();
+                        scan.waypoints.emplace_back(waypointPos, name);
+                    }
+                } else
+                    stdext::throw_exception(stdext::format("Unknown map data node %d", static_cast<int>(mapDataType)));
+            }
+            flush();
+        } catch(std::exception& e) {
+            scan.error = e.what();
+        }
+        return scan;
+    }
+}
+
 void Map::loadOtbm(const std::string& fileName)
 {
+    if(!startOtbmLoad(fileName, Position(), Position(), false))
+        return;
+
+    const std::shared_ptr<OtbmLoad> load = m_otbmLoad;
+    try {
+        commitOtbmLoad(true);
+    } catch(std::exception& e) {
+        g_logger.error(stdext::format("Failed to load '%s': %s", fileName, e.what()));
+    }
+
+    if(m_otbmLoad == load)
+        m_otbmLoad = nullptr;
+}
+
+bool Map::startOtbmLoad(const std::string& fileName, const Position& regionFrom, const Position& regionTo, bool async)
+{
+    cancelOtbmLoad();
+
     try {
         if(!g_things.isOtbLoaded())
             stdext::throw_exception("OTB isn't loaded yet to load a map.");
 
-        FileStreamPtr fin = g_resources.openFile(fileName);
-        if(!fin)
+        if(!g_resources.fileExists(fileName))
             stdext::throw_exception(stdext::format("Unable to load map '%s'", fileName));
 
-        fin->cache();
-
-        char identifier[4];
-        if(fin->read(identifier, 1, 4) < 4)
+        // workers read from this copy, the resource manager is not touched outside the main thread
+        const std::shared_ptr<const std::string> data = std::make_shared<const std::string>(g_resources.readFileContents(fileName));
+        if(data->size() < 4)
             stdext::throw_exception("Could not read file identifier");
 
-        if(memcmp(identifier, "OTBM", 4) != 0 && memcmp(identifier, "\0\0\0\0", 4) != 0)
-            stdext::throw_exception(stdext::format("Invalid file identifier detected: %s", identifier));
+        if(memcmp(data->data(), "OTBM", 4) != 0 && memcmp(data->data(), "\0\0\0\0", 4) != 0)
+            stdext::throw_exception(stdext::format("Invalid file identifier detected: %s", data->substr(0, 4)));
+
+        if(data->size() < 5 || static_cast<uint8>((*data)[4]) != BINARYTREE_NODE_START)
+            stdext::throw_exception("could not read root node");
 
-        BinaryTreePtr root = fin->getBinaryTree();
-        if(root->getU8())
+        BinaryTreeView root(reinterpret_cast<const uint8*>(data->data()), data->size(), 5);
+        if(root.getU8())
             stdext::throw_exception("could not read root property!");
 
-        const uint32 headerVersion = root->getU32();
+        const uint32 headerVersion = root.getU32();
         if(headerVersion > 3)
             stdext::throw_exception(stdext::format("Unknown OTBM version detected: %u.", headerVersion));
 
-        setWidth(root->getU16());
-        setHeight(root->getU16());
+        setWidth(root.getU16());
+        setHeight(root.getU16());
 
-        const uint32 headerMajorItems = root->getU8();
+        const uint32 headerMajorItems = root.getU8();
         if(headerMajorItems > g_things.getOtbMajorVersion()) {
             stdext::throw_exception(stdext::format("This map was saved with different OTB version. read %d what it's supposed to be: %d",
                                                    headerMajorItems, g_things.getOtbMajorVersion()));
         }
 
-        root->skip(3);
-        const uint32 headerMinorItems = root->getU32();
+        root.getU8();
+        root.getU16();
+        const uint32 headerMinorItems = root.getU32();
         if(headerMinorItems > g_things.getOtbMinorVersion()) {
             g_logger.warning(stdext::format("This map needs an updated OTB. read %d what it's supposed to be: %d or less",
                                             headerMinorItems, g_things.getOtbMinorVersion()));
         }
 
-        BinaryTreePtr node = root->getChildren()[0];
-        if(node->getU8() != OTBM_MAP_DATA)
+        BinaryTreeView::ChildRange rootChildren = root.getChildren();
+        if(!(rootChildren.begin() != rootChildren.end()))
+            stdext::throw_exception("Could not read root data node");
+
+        BinaryTreeView node = *rootChildren.begin();
+        if(node.getU8() != OTBM_MAP_DATA)
             stdext::throw_exception("Could not read root data node");
 
-        while(node->canRead()) {
-            const uint8 attribute = node->getU8();
-            std::string tmp = node->getString();
+        while(node.canRead()) {
+            const uint8 attribute = node.getU8();
+            std::string tmp = node.getString();
             switch(attribute) {
             case OTBM_ATTR_DESCRIPTION:
                 setDescription(tmp);
@@ -97,154 +342,205 @@ void Map::loadOtbm(const std::string& fileName)
             }
         }
 
-        for(const BinaryTreePtr& nodeMapData : node->getChildren()) {
-            const uint8 mapDataType = nodeMapData->getU8();
-            if(mapDataType == OTBM_TILE_AREA) {
-                Position basePos;
-                basePos.x = nodeMapData->getU16();
-                basePos.y = nodeMapData->getU16();
-                basePos.z = nodeMapData->getU8();
+        m_otbmLoad = std::make_shared<OtbmLoad>();
+        m_otbmLoad->fileName = fileName;
+        m_otbmLoad->data = data;
+        m_otbmLoad->scanned = false;
+        m_otbmLoad->nextBatch = m_otbmLoad->nextTile = 0;
+        m_otbmLoad->loadedAreas = m_otbmLoad->totalAreas = 0;
+        const uint mapDataStart = node.getStart();
+        m_otbmLoad->scan = g_asyncDispatcher.schedule([data, mapDataStart, headerVersion, regionFrom, regionTo] {
+            return scanOtbm(data, mapDataStart, headerVersion, regionFrom, regionTo);
+        });
+    } catch(std::exception& e) {
+        g_logger.error(stdext::format("Failed to load '%s': %s", fileName, e.what()));
+        return false;
+    }
 
-                for(const BinaryTreePtr& nodeTile : nodeMapData->getChildren()) {
-                    const uint8 type = nodeTile->getU8();
-                    if(unlikely(type != OTBM_TILE && type != OTBM_HOUSETILE))
-                        stdext::throw_exception(stdext::format("invalid node tile type %d", static_cast<int>(type)));
+    if(async)
+        m_otbmLoadEvent = g_dispatcher.scheduleEvent([this] { processOtbmLoad(); }, 0);
+    return true;
+}
 
-                    HousePtr house = nullptr;
-                    uint32 flags = TILESTATE_NONE;
-                    Position pos = basePos + nodeTile->getPoint();
+void Map::cancelOtbmLoad()
+{
+    m_otbmLoad = nullptr;
+    if(m_otbmLoadEvent) {
+        m_otbmLoadEvent->cancel();
+        m_otbmLoadEvent = nullptr;
+    }
+}
 
-                    if(type == OTBM_HOUSETILE) {
-                        const uint32 hId = nodeTile->getU32();
-                        TilePtr tile = getOrCreateTile(pos);
-                        if(!(house = g_houses.getHouse(hId))) {
-                            house = HousePtr(new House(hId));
-                            g_houses.addHouse(house);
-                        }
-                        house->setTile(tile);
-                    }
+void Map::processOtbmLoad()
+{
+    m_otbmLoadEvent = nullptr;
+    const std::shared_ptr<OtbmLoad> load = m_otbmLoad;
+    if(!load)
+        return;
 
-                    while(nodeTile->canRead()) {
-                        const uint8 tileAttr = nodeTile->getU8();
-                        switch(tileAttr) {
-                        case OTBM_ATTR_TILE_FLAGS:
-                        {
-                            const uint32 _flags = nodeTile->getU32();
-                            if((_flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
-                                flags |= TILESTATE_PROTECTIONZONE;
-                            else if((_flags & TILESTATE_OPTIONALZONE) == TILESTATE_OPTIONALZONE)
-                                flags |= TILESTATE_OPTIONALZONE;
-                            else if((_flags & TILESTATE_HARDCOREZONE) == TILESTATE_HARDCOREZONE)
-                                flags |= TILESTATE_HARDCOREZONE;
+    bool finished, success = true;
+    try {
+        finished = commitOtbmLoad(false);
+    } catch(std::exception& e) {
+        g_logger.error(stdext::format("Failed to load '%s': %s", load->fileName, e.what()));
+        finished = true;
+        success = false;
+    }
 
-                            if((_flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
-                                flags |= TILESTATE_NOLOGOUT;
+    // lua may have cancelled or restarted the load from a callback
+    if(load != m_otbmLoad)
+        return;
 
-                            if((_flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
-                                flags |= TILESTATE_REFRESH;
-                            break;
-                        }
-                        case OTBM_ATTR_ITEM:
-                        {
-                            addThing(Item::createFromOtb(nodeTile->getU16()), pos);
-                            break;
-                        }
-                        default:
-                        {
-                            stdext::throw_exception(stdext::format("invalid tile attribute %d at pos %s",
-                                                                   static_cast<int>(tileAttr), stdext::to_string(pos)));
-                        }
-                        }
-                    }
+    g_lua.callGlobalField("g_map", "onLoadProgress", load->loadedAreas, load->totalAreas);
+    if(load != m_otbmLoad)
+        return;
 
-                    for(const BinaryTreePtr& nodeItem : nodeTile->getChildren()) {
-                        if(unlikely(nodeItem->getU8() != OTBM_ITEM))
-                            stdext::throw_exception("invalid item node");
+    if(finished) {
+        m_otbmLoad = nullptr;
+        g_lua.callGlobalField("g_map", "onLoadFinish", success);
+        return;
+    }
 
-                        ItemPtr item = Item::createFromOtb(nodeItem->getU16());
-                        item->unserializeItem(nodeItem);
+    m_otbmLoadEvent = g_dispatcher.scheduleEvent([this] { processOtbmLoad(); }, 1);
+}
 
-                        if(item->isContainer()) {
-                            for(const BinaryTreePtr& containerItem : nodeItem->getChildren()) {
-                                if(containerItem->getU8() != OTBM_ITEM)
-                                    stdext::throw_exception("invalid container item node");
+bool Map::commitOtbmLoad(bool wait)
+{
+    const std::shared_ptr<OtbmLoad> load = m_otbmLoad;
+    const auto isReady = [wait](const auto& future) { return wait || future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+    stdext::timer timer;
 
-                                ItemPtr cItem = Item::createFromOtb(containerItem->getU16());
-                                cItem->unserializeItem(containerItem);
-                                item->addContainerItem(cItem);
-                            }
-                        }
+    if(!load->scanned) {
+        if(!isReady(load->scan))
+            return false;
 
-                        if(house && item->isMoveable()) {
-                            g_logger.warning(stdext::format("Moveable item found in house: %d at pos %s - escaping...", item->getId(), stdext::to_string(pos)));
-                            item.reset();
-                        }
+        const OtbmScan& scan = load->scan.get();
+        if(!scan.error.empty())
+            stdext::throw_exception(scan.error);
 
-                        addThing(item, pos);
-                    }
+        for(const auto& town : scan.towns) {
+            if(!g_towns.getTown(std::get<0>(town)))
+                g_towns.addTown(TownPtr(new Town(std::get<0>(town), std::get<1>(town), std::get<2>(town))));
+        }
+        g_towns.sort();
 
-                    if(const TilePtr& tile = getTile(pos)) {
-                        if(house)
-                            tile->setFlag(TILESTATE_HOUSE);
-                        tile->setFlag(flags);
-                    }
-                }
-            } else if(mapDataType == OTBM_TOWNS) {
-                TownPtr town = nullptr;
-                for(const BinaryTreePtr& nodeTown : nodeMapData->getChildren()) {
-                    if(nodeTown->getU8() != OTBM_TOWN)
-                        stdext::throw_exception("invalid town node.");
-
-                    const uint32 townId = nodeTown->getU32();
-                    std::string townName = nodeTown->getString();
-
-                    Position townCoords;
-                    townCoords.x = nodeTown->getU16();
-                    townCoords.y = nodeTown->getU16();
-                    townCoords.z = nodeTown->getU8();
-
-                    if(!(town = g_towns.getTown(townId)))
-                        g_towns.addTown(TownPtr(new Town(townId, townName, townCoords)));
-                }
-                g_towns.sort();
-            } else if(mapDataType == OTBM_WAYPOINTS && headerVersion > 1) {
-                for(const BinaryTreePtr& nodeWaypoint : nodeMapData->getChildren()) {
-                    if(nodeWaypoint->getU8() != OTBM_WAYPOINT)
-                        stdext::throw_exception("invalid waypoint node.");
+        for(const auto& waypoint : scan.waypoints) {
+            if(waypoint.first.isValid() && !waypoint.second.empty() && m_waypoints.find(waypoint.first) == m_waypoints.end())
+                m_waypoints.insert(waypoint);
+        }
 
-                    std::string name = nodeWaypoint->getString();
+        load->batches = scan.batches;
+        load->totalAreas = scan.areas;
+        load->scanned = true;
+        load->scan = std::shared_future<OtbmScan>();
+    }
 
-                    Position waypointPos;
-                    waypointPos.x = nodeWaypoint->getU16();
-                    waypointPos.y = nodeWaypoint->getU16();
-                    waypointPos.z = nodeWaypoint->getU8();
+    while(load->nextBatch < load->batches.size()) {
+        std::shared_future<OtbmBatch>& future = load->batches[load->nextBatch];
+        if(!isReady(future))
+            return false;
+
+        const OtbmBatch& batch = future.get();
+        if(!batch.error.empty())
+            stdext::throw_exception(batch.error);
+
+        while(load->nextTile < batch.tiles.size()) {
+            commitOtbmTile(batch.tiles[load->nextTile++], *load->data);
+            if(load != m_otbmLoad)
+                return true;
+            if(!wait && timer.elapsed_millis() >= OTBM_COMMIT_MILLIS)
+                return false;
+        }
 
-                    if(waypointPos.isValid() && !name.empty() && m_waypoints.find(waypointPos) == m_waypoints.end())
-                        m_waypoints.insert(std::make_pair(waypointPos, name));
-                }
-            } else
-                stdext::throw_exception(stdext::format("Unknown map data node %d", static_cast<int>(mapDataType)));
+        load->loadedAreas += batch.areas;
+        load->nextTile = 0;
+        future = std::shared_future<OtbmBatch>();
+        ++load->nextBatch;
+    }
+
+    return true;
+}
+
+void Map::commitOtbmTile(const OtbmTileRecord& record, const std::string& data)
+{
+    const Position& pos = record.pos;
+
+    HousePtr house = nullptr;
+    if(record.house) {
+        TilePtr tile = getOrCreateTile(pos);
+        if(!(house = g_houses.getHouse(record.houseId))) {
+            house = HousePtr(new House(record.houseId));
+            g_houses.addHouse(house);
         }
+        house->setTile(tile);
+    }
 
-        fin->close();
-    } catch(std::exception& e) {
-        g_logger.error(stdext::format("Failed to load '%s': %s", fileName, e.what()));
+    for(const OtbmItemRecord& itemRecord : record.items) {
+        ItemPtr item = Item::createFromOtb(itemRecord.id);
+        if(itemRecord.inlined) {
+            addThing(item, pos);
+            continue;
+        }
+
+        BinaryTreeView itemNode = getItemAttributes(data, itemRecord);
+        item->unserializeItem(itemNode);
+
+        if(item->isContainer()) {
+            for(const OtbmItemRecord& containerRecord : itemRecord.contents) {
+                ItemPtr cItem = Item::createFromOtb(containerRecord.id);
+                BinaryTreeView containerNode = getItemAttributes(data, containerRecord);
+                cItem->unserializeItem(containerNode);
+                item->addContainerItem(cItem);
+            }
+        }
+
+        if(house && item->isMoveable()) {
+            g_logger.warning(stdext::format("Moveable item found in house: %d at pos %s - escaping...", item->getId(), stdext::to_string(pos)));
+            item.reset();
+        }
+
+        addThing(item, pos);
+    }
+
+    if(const TilePtr& tile = getTile(pos)) {
+        if(house)
+            tile->setFlag(TILESTATE_HOUSE);
+        tile->setFlag(record.flags);
     }
 }
 
 void Map::saveOtbm(const std::string& fileName)
 {
+    if(!startOtbmSave(fileName, false))
+        return;
+
+    const std::shared_ptr<OtbmSave> save = m_otbmSave;
     try {
-        FileStreamPtr fin = g_resources.createFile(fileName);
-        if(!fin)
-            stdext::throw_exception(stdext::format("failed to open file '%s' for write", fileName));
+        commitOtbmSave(true);
+    } catch(std::exception& e) {
+        g_logger.error(stdext::format("Failed to save '%s': %s", fileName, e.what()));
+    }
 
-        fin->cache();
-        std::string dir;
-        if(fileName.find_last_of('/') == std::string::npos)
-            dir = g_resources.getWorkDir();
-        else
-            dir = fileName.substr(0, fileName.find_last_of('/'));
+    if(m_otbmSave == save)
+        m_otbmSave = nullptr;
+}
+
+bool Map::startOtbmSave(const std::string& fileName, bool async)
+{
+    if(m_otbmSave) {
+        g_logger.error(stdext::format("Failed to save '%s': '%s' is still being saved", fileName, m_otbmSave->fileName));
+        return false;
+    }
+
+    // tiles and items belong to the main thread, they are recorded here in one pass without escaping,
+    // workers escape the recorded areas and the file is written by a worker once all of them are done
+    const std::shared_ptr<OtbmSave> save = std::make_shared<OtbmSave>();
+    save->fileName = fileName;
+    save->encodedChunks = save->savedAreas = save->totalAreas = 0;
+    try {
+        save->file = g_resources.createFile(fileName);
+        if(!save->file)
+            stdext::throw_exception(stdext::format("failed to open file '%s' for write", fileName));
 
         uint32 version = 0;
         if(g_things.getOtbMajorVersion() < ClientVersion820)
@@ -275,127 +571,212 @@ void Map::saveOtbm(const std::string& fileName)
         if((sep_pos = houseFile.rfind('/')) != std::string::npos)
             houseFile = houseFile.substr(sep_pos + 1);
 
-        fin->addU32(0); // file version
-        OutputBinaryTreePtr root(new OutputBinaryTree(fin));
+        OutputBinaryTreePtr header(new OutputBinaryTree);
+        header->startNode(0);
         {
-            root->addU32(version);
+            header->addU32(version);
 
             const Size mapSize = getSize();
-            root->addU16(mapSize.width());
-            root->addU16(mapSize.height());
-
-            root->addU32(g_things.getOtbMajorVersion());
-            root->addU32(g_things.getOtbMinorVersion());
-
-            root->startNode(OTBM_MAP_DATA);
-            {
-                root->addU8(OTBM_ATTR_DESCRIPTION);
-                root->addString(m_attribs.get<std::string>(OTBM_ATTR_DESCRIPTION));
-
-                root->addU8(OTBM_ATTR_SPAWN_FILE);
-                root->addString(spawnFile);
-
-                root->addU8(OTBM_ATTR_HOUSE_FILE);
-                root->addString(houseFile);
-
-                int px = -1, py = -1, pz = -1;
-                bool firstNode = true;
-
-                for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
-                    for(const auto& it : m_tileBlocks[z]) {
-                        const TileBlock& block = it.second;
-                        for(const TilePtr& tile : block.getTiles()) {
-                            if(unlikely(!tile || tile->isEmpty()))
-                                continue;
-
-                            const Position& pos = tile->getPosition();
-                            if(unlikely(!pos.isValid()))
-                                continue;
-
-                            if(pos.x < px || pos.x >= px + 256
-                               || pos.y < py || pos.y >= py + 256
-                               || pos.z != pz) {
-                                if(!firstNode)
-                                    root->endNode(); /// OTBM_TILE_AREA
-
-                                firstNode = false;
-                                root->startNode(OTBM_TILE_AREA);
-
-                                px = pos.x & 0xFF00;
-                                py = pos.y & 0xFF00;
-                                pz = pos.z;
-                                root->addPos(px, py, pz);
-                            }
-
-                            root->startNode(tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
-                            root->addPoint(Point(pos.x, pos.y) & 0xFF);
-                            if(tile->isHouseTile())
-                                root->addU32(tile->getHouseId());
-
-                            if(tile->getFlags()) {
-                                root->addU8(OTBM_ATTR_TILE_FLAGS);
-                                root->addU32(tile->getFlags());
-                            }
-
-                            const auto& itemList = tile->getItems();
-                            const ItemPtr& ground = tile->getGround();
-                            if(ground) {
-                                // Those types are called "complex" needs other stuff to be written.
-                                // For containers, there is container items, for depot, depot it and so on.
-                                if(!ground->isContainer() && !ground->isDepot()
-                                   && !ground->isDoor() && !ground->isTeleport()) {
-                                    root->addU8(OTBM_ATTR_ITEM);
-                                    root->addU16(ground->getServerId());
-                                } else
-                                    ground->serializeItem(root);
-                            }
-                            for(const ItemPtr& item : itemList)
-                                if(!item->isGround())
-                                    item->serializeItem(root);
-
-                            root->endNode(); // OTBM_TILE
-                        }
-                    }
-                }
+            header->addU16(mapSize.width());
+            header->addU16(mapSize.height());
 
-                if(!firstNode)
-                    root->endNode();  // OTBM_TILE_AREA
+            header->addU32(g_things.getOtbMajorVersion());
+            header->addU32(g_things.getOtbMinorVersion());
 
-                root->startNode(OTBM_TOWNS);
-                for(const TownPtr& town : g_towns.getTowns()) {
-                    root->startNode(OTBM_TOWN);
+            header->startNode(OTBM_MAP_DATA);
+            header->addU8(OTBM_ATTR_DESCRIPTION);
+            header->addString(m_attribs.get<std::string>(OTBM_ATTR_DESCRIPTION));
 
-                    root->addU32(town->getId());
-                    root->addString(town->getName());
+            header->addU8(OTBM_ATTR_SPAWN_FILE);
+            header->addString(spawnFile);
 
-                    const Position townPos = town->getPos();
-                    root->addPos(townPos.x, townPos.y, townPos.z);
-                    root->endNode();
-                }
-                root->endNode();
+            header->addU8(OTBM_ATTR_HOUSE_FILE);
+            header->addString(houseFile);
+        }
+        save->header.assign(4, '\0'); // file version
+        header->takeRecord().encode(save->header);
+
+        OutputBinaryTreePtr root(new OutputBinaryTree);
+        uint areas = 0;
+        const auto scheduleChunk = [&] {
+            const auto record = std::make_shared<BinaryTreeRecord>(root->takeRecord());
+            save->chunks.push_back(g_asyncDispatcher.schedule([record] {
+                std::string encoded;
+                record->encode(encoded);
+                return encoded;
+            }));
+            save->chunkAreas.push_back(areas);
+            save->totalAreas += areas;
+            areas = 0;
+        };
+
+        int px = -1, py = -1, pz = -1;
+        bool firstNode = true;
+
+        for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
+            for(const auto& it : m_tileBlocks[z]) {
+                const TileBlock& block = it.second;
+                for(const TilePtr& tile : block.getTiles()) {
+                    if(unlikely(!tile || tile->isEmpty()))
+                        continue;
+
+                    const Position& pos = tile->getPosition();
+                    if(unlikely(!pos.isValid()))
+                        continue;
+
+                    if(pos.x < px || pos.x >= px + 256
+                       || pos.y < py || pos.y >= py + 256
+                       || pos.z != pz) {
+                        if(!firstNode) {
+                            root->endNode(); /// OTBM_TILE_AREA
+                            if(root->getRecordedSize() >= OTBM_BATCH_BYTES)
+                                scheduleChunk();
+                        }
 
-                if(version > 1) {
-                    root->startNode(OTBM_WAYPOINTS);
-                    for(const auto& it : m_waypoints) {
-                        root->startNode(OTBM_WAYPOINT);
-                        root->addString(it.second);
+                        firstNode = false;
+                        root->startNode(OTBM_TILE_AREA);
+                        ++areas;
 
-                        const Position pos = it.first;
-                        root->addPos(pos.x, pos.y, pos.z);
-                        root->endNode();
+                        px = pos.x & 0xFF00;
+                        py = pos.y & 0xFF00;
+                        pz = pos.z;
+                        root->addPos(px, py, pz);
                     }
-                    root->endNode();
+
+                    root->startNode(tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
+                    root->addPoint(Point(pos.x, pos.y) & 0xFF);
+                    if(tile->isHouseTile())
+                        root->addU32(tile->getHouseId());
+
+                    if(tile->getFlags()) {
+                        root->addU8(OTBM_ATTR_TILE_FLAGS);
+                        root->addU32(tile->getFlags());
+                    }
+
+                    const auto& itemList = tile->getItems();
+                    const ItemPtr& ground = tile->getGround();
+                    if(ground) {
+                        // Those types are called "complex" needs other stuff to be written.
+                        // For containers, there is container items, for depot, depot it and so on.
+                        if(!ground->isContainer() && !ground->isDepot()
+                           && !ground->isDoor() && !ground->isTeleport()) {
+                            root->addU8(OTBM_ATTR_ITEM);
+                            root->addU16(ground->getServerId());
+                        } else
+                            ground->serializeItem(root);
+                    }
+                    for(const ItemPtr& item : itemList)
+                        if(!item->isGround())
+                            item->serializeItem(root);
+
+                    root->endNode(); // OTBM_TILE
                 }
             }
-            root->endNode(); // OTBM_MAP_DATA
         }
-        root->endNode();
 
-        fin->flush();
-        fin->close();
+        if(!firstNode) {
+            root->endNode();  // OTBM_TILE_AREA
+            scheduleChunk();
+        }
+
+        OutputBinaryTreePtr footer(new OutputBinaryTree);
+        footer->startNode(OTBM_TOWNS);
+        for(const TownPtr& town : g_towns.getTowns()) {
+            footer->startNode(OTBM_TOWN);
+
+            footer->addU32(town->getId());
+            footer->addString(town->getName());
+
+            const Position townPos = town->getPos();
+            footer->addPos(townPos.x, townPos.y, townPos.z);
+            footer->endNode();
+        }
+        footer->endNode();
+
+        if(version > 1) {
+            footer->startNode(OTBM_WAYPOINTS);
+            for(const auto& it : m_waypoints) {
+                footer->startNode(OTBM_WAYPOINT);
+                footer->addString(it.second);
+
+                const Position pos = it.first;
+                footer->addPos(pos.x, pos.y, pos.z);
+                footer->endNode();
+            }
+            footer->endNode();
+        }
+        footer->endNode(); // OTBM_MAP_DATA
+        footer->endNode();
+        footer->takeRecord().encode(save->footer);
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to save '%s': %s", fileName, e.what()));
+        return false;
+    }
+
+    m_otbmSave = save;
+    if(async)
+        g_dispatcher.scheduleEvent([this] { processOtbmSave(); }, 0);
+    return true;
+}
+
+bool Map::commitOtbmSave(bool wait)
+{
+    const std::shared_ptr<OtbmSave> save = m_otbmSave;
+    const auto isReady = [wait](const auto& future) { return wait || future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+
+    while(save->encodedChunks < save->chunks.size()) {
+        if(!isReady(save->chunks[save->encodedChunks]))
+            return false;
+        save->savedAreas += save->chunkAreas[save->encodedChunks++];
+    }
+
+    if(!save->write.valid()) {
+        // the file stream stays referenced by the save, the worker only borrows it
+        FileStream* file = save->file.get();
+        const std::string* header = &save->header;
+        const std::string* footer = &save->footer;
+        std::vector<std::shared_future<std::string>> chunks = save->chunks;
+        save->write = g_asyncDispatcher.schedule([file, header, footer, chunks] {
+            file->write(header->data(), header->size());
+            for(const auto& chunk : chunks)
+                file->write(chunk.get().data(), chunk.get().size());
+            file->write(footer->data(), footer->size());
+            file->close();
+        });
     }
+
+    if(!isReady(save->write))
+        return false;
+
+    save->write.get();
+    return true;
+}
+
+void Map::processOtbmSave()
+{
+    const std::shared_ptr<OtbmSave> save = m_otbmSave;
+    if(!save)
+        return;
+
+    bool finished, success = true;
+    try {
+        finished = commitOtbmSave(false);
+    } catch(std::exception& e) {
+        g_logger.error(stdext::format("Failed to save '%s': %s", save->fileName, e.what()));
+        finished = true;
+        success = false;
+    }
+
+    if(finished)
+        m_otbmSave = nullptr;
+
+    g_lua.callGlobalField("g_map", "onSaveProgress", save->savedAreas, save->totalAreas);
+    if(finished) {
+        g_lua.callGlobalField("g_map", "onSaveFinish", success);
+        return;
+    }
+
+    g_dispatcher.scheduleEvent([this] { processOtbmSave(); }, 1);
 }
 
 bool Map::loadOtcm(const std::string& fileName)
@@ -413,15 +794,19 @@ bool Map::loadOtcm(const std::string& fileName)
 
         const uint16 start = fin->getU16();
         const uint16 version = fin->getU16();
-        fin->getU32(); // flags
+        const uint32 flags = fin->getU32();
 
+        uint32 indexOffset = 0;
         switch(version) {
         case 1:
+        case 2:
         {
             fin->getString(); // description
             const uint32 datSignature = fin->getU32();
             fin->getU16(); // protocol version
             fin->getString(); // world name
+            if(version >= 2)
+                indexOffset = fin->getU32();
 
             if(datSignature != g_things.getDatSignature())
                 g_logger.warning("otcm map loaded was created with a different dat signature");
@@ -432,6 +817,37 @@ bool Map::loadOtcm(const std::string& fileName)
             stdext::throw_exception("otcm version not supported");
         }
 
+        if(version >= 2) {
+            if(!(flags & OTCM_FLAG_COMPRESSED_BLOCKS))
+                stdext::throw_exception("otcm block layout not supported");
+
+            // blocks are only decompressed once the player gets close to them, so they keep pointing into one copy of the file
+            for(auto& blocks : m_otcmBlocks)
+                blocks.clear();
+
+            fin->seek(indexOffset);
+            const uint32 blockCount = fin->getU32();
+            for(uint32 i = 0; i < blockCount; ++i) {
+                const uint8 z = fin->getU8();
+                const uint index = fin->getU32();
+                OtcmBlock block;
+                block.offset = fin->getU32();
+                block.compressedSize = fin->getU32();
+                block.size = fin->getU32();
+                block.loaded = false;
+                if(z > Otc::MAX_Z || block.offset + block.compressedSize > fin->size())
+                    stdext::throw_exception("invalid otcm block index");
+                m_otcmBlocks[z][index] = block;
+            }
+            fin->close();
+
+            m_otcmData = std::make_shared<const std::string>(g_resources.readFileContents(fileName));
+            if(m_centralPosition.isValid())
+                loadOtcmBlocks(m_centralPosition);
+            return true;
+        }
+
+        // version 1 files are a single list of tiles, they are loaded whole and saved again as version 2
         fin->seek(start);
 
         while(true) {
@@ -472,20 +888,112 @@ bool Map::loadOtcm(const std::string& fileName)
         return true;
     } catch(stdext::exception& e) {
         g_logger.error(stdext::format("failed to load OTCM map: %s", e.what()));
+        for(auto& blocks : m_otcmBlocks)
+            blocks.clear();
+        m_otcmData = nullptr;
         return false;
     }
 }
 
+void Map::loadOtcmBlocks(const Position& centralPosition)
+{
+    // one block of margin around the aware area, floors are few enough to load them all
+    const int minX = std::max<int>(centralPosition.x - m_awareRange.left - BLOCK_SIZE, 0) / BLOCK_SIZE;
+    const int maxX = std::min<int>(centralPosition.x + m_awareRange.right + BLOCK_SIZE, 65535) / BLOCK_SIZE;
+    const int minY = std::max<int>(centralPosition.y - m_awareRange.top - BLOCK_SIZE, 0) / BLOCK_SIZE;
+    const int maxY = std::min<int>(centralPosition.y + m_awareRange.bottom + BLOCK_SIZE, 65535) / BLOCK_SIZE;
+
+    for(uint8 z = 0; z <= Otc::MAX_Z; ++z) {
+        if(m_otcmBlocks[z].empty())
+            continue;
+
+        for(int y = minY; y <= maxY; ++y) {
+            for(int x = minX; x <= maxX; ++x) {
+                const uint index = getBlockIndex(Position(x * BLOCK_SIZE, y * BLOCK_SIZE, z));
+                auto it = m_otcmBlocks[z].find(index);
+                if(it != m_otcmBlocks[z].end() && !it->second.loaded)
+                    loadOtcmBlock(z, index, it->second);
+            }
+        }
+    }
+}
+
+void Map::loadOtcmBlock(uint8 z, uint index, OtcmBlock& block)
+{
+    block.loaded = true;
+
+    std::vector<uint8> tiles(block.size);
+    ulong destLen = block.size;
+    const int ret = uncompress(tiles.data(), &destLen, reinterpret_cast<const uint8*>(m_otcmData->data()) + block.offset, block.compressedSize);
+    if(ret != Z_OK || destLen != block.size) {
+        g_logger.error(stdext::format("failed to decompress OTCM block %d at floor %d", index, static_cast<int>(z)));
+        return;
+    }
+
+    uint pos = 0;
+    const auto require = [&](uint len) {
+        if(pos + len > tiles.size())
+            stdext::throw_exception("otcm block ended unexpectedly");
+    };
+
+    try {
+        while(pos < tiles.size()) {
+            require(5);
+            const Position tilePos(stdext::readULE16(&tiles[pos]), stdext::readULE16(&tiles[pos + 2]), tiles[pos + 4]);
+            pos += 5;
+
+            // tiles the server already described are newer than the cache
+            const TilePtr& existing = getTile(tilePos);
+            const bool skip = existing && !existing->isEmpty();
+            const TilePtr& tile = skip ? existing : createTile(tilePos);
+
+            int stackPos = 0;
+            while(true) {
+                require(2);
+                const int id = stdext::readULE16(&tiles[pos]);
+                pos += 2;
+
+                // end of tile
+                if(id == 0xFFFF)
+                    break;
+
+                require(1);
+                const int countOrSubType = tiles[pos++];
+                if(skip)
+                    continue;
+
+                ItemPtr item = Item::create(id);
+                item->setCountOrSubType(countOrSubType);
+
+                if(item->isValid())
+                    tile->addThing(item, ++stackPos);
+            }
+
+            if(!skip)
+                notificateTileUpdate(tilePos, nullptr, Otc::OPERATION_ADD);
+        }
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("failed to load OTCM block %d at floor %d: %s", index, static_cast<int>(z), e.what()));
+    }
+}
+
 void Map::saveOtcm(const std::string& fileName)
 {
     try {
         stdext::timer saveTimer;
 
+        // cached blocks that also hold live tiles are merged before the live block replaces them
+        for(uint8 z = 0; z <= Otc::MAX_Z; ++z) {
+            for(auto& it : m_otcmBlocks[z]) {
+                if(!it.second.loaded && m_tileBlocks[z].find(it.first) != m_tileBlocks[z].end())
+                    loadOtcmBlock(z, it.first, it.second);
+            }
+        }
+
         FileStreamPtr fin = g_resources.createFile(fileName);
         fin->cache();
 
-        //TODO: compression flag with zlib
-        const uint32 flags = 0;
+        const uint32 flags = OTCM_FLAG_COMPRESSED_BLOCKS;
 
         // header
         fin->addU32(OTCM_SIGNATURE);
@@ -494,48 +1002,69 @@ void Map::saveOtcm(const std::string& fileName)
         fin->addU32(flags);
 
         // version 1 header
-        fin->addString("OTCM 1.0"); // map description
+        fin->addString("OTCM 2.0"); // map description
         fin->addU32(g_things.getDatSignature());
         fin->addU16(g_game.getClientVersion());
         fin->addString(g_game.getWorldName());
 
+        // version 2 header
+        const uint32 indexOffsetPos = fin->tell();
+        fin->addU32(0); // block index offset, will be overwritten later
+
         // go back and rewrite where the map data starts
         const uint32 start = fin->tell();
         fin->seek(4);
         fin->addU16(start);
         fin->seek(start);
 
-        for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
-            for(const auto& it : m_tileBlocks[z]) {
-                const TileBlock& block = it.second;
-                for(const TilePtr& tile : block.getTiles()) {
-                    if(!tile || tile->isEmpty())
-                        continue;
+        struct IndexEntry {
+            uint8 z;
+            uint index;
+            OtcmBlock block;
+        };
+        std::vector<IndexEntry> entries;
 
-                    const Position pos = tile->getPosition();
-                    fin->addU16(pos.x);
-                    fin->addU16(pos.y);
-                    fin->addU8(pos.z);
+        std::vector<uint8> tiles;
+        std::vector<uint8> compressBuffer;
+        for(uint8 z = 0; z <= Otc::MAX_Z; ++z) {
+            for(const auto& it : m_tileBlocks[z]) {
+                serializeOtcmTiles(it.second, tiles);
+                if(tiles.empty())
+                    continue;
+
+                compressBuffer.resize(compressBound(tiles.size()));
+                ulong len = compressBuffer.size();
+                const int ret = compress2(compressBuffer.data(), &len, tiles.data(), tiles.size(), OTCM_COMPRESS_LEVEL);
+                if(ret != Z_OK)
+                    stdext::throw_exception("failed to compress tile block");
+
+                entries.push_back({ z, it.first, { fin->tell(), static_cast<uint32>(len), static_cast<uint32>(tiles.size()), true } });
+                fin->write(compressBuffer.data(), len);
+            }
 
-                    for(const ThingPtr& thing : tile->getThings()) {
-                        if(thing->isItem()) {
-                            ItemPtr item = thing->static_self_cast<Item>();
-                            fin->addU16(item->getId());
-                            fin->addU8(item->getCountOrSubType());
-                        }
-                    }
+            // blocks the player never got close to are written back as they were loaded
+            for(const auto& it : m_otcmBlocks[z]) {
+                if(it.second.loaded)
+                    continue;
 
-                    // end of tile
-                    fin->addU16(0xFFFF);
-                }
+                entries.push_back({ z, it.first, { fin->tell(), it.second.compressedSize, it.second.size, true } });
+                fin->write(m_otcmData->data() + it.second.offset, it.second.compressedSize);
             }
         }
 
-        // end of file
-        const Position invalidPos;
-        fin->addU16(invalidPos.x);
-        fin->addU16(invalidPos.y);
-        fin->addU8(invalidPos.z);
+        // block index
+        const uint32 indexOffset = fin->tell();
+        fin->addU32(entries.size());
+        for(const IndexEntry& entry : entries) {
+            fin->addU8(entry.z);
+            fin->addU32(entry.index);
+            fin->addU32(entry.block.offset);
+            fin->addU32(entry.block.compressedSize);
+            fin->addU32(entry.block.size);
+        }
+
+        fin->seek(indexOffsetPos);
+        fin->addU32(indexOffset);
 
         fin->flush();
 
@@ -24,6 +24,7 @@
 
 #include "animatedtext.h"
 #include "creature.h"
+#include "creatureoverlay.h"
 #include "game.h"
 #include "lightview.h"
 #include "map.h"
@@ -33,7 +34,10 @@
 #include "tile.h"
 
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/frameprofiler.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/framebuffermanager.h>
 #include <framework/graphics/graphics.h>
@@ -47,7 +51,10 @@ enum {
 
     NEAR_VIEW_AREA = 32 * 32,
     MID_VIEW_AREA = 64 * 64,
-    FAR_VIEW_AREA = 128 * 128
+    FAR_VIEW_AREA = 128 * 128,
+
+    // milliseconds without a zoom step before the geometry is fitted to the visible dimension
+    SMOOTH_ZOOM_SETTLE_DELAY = 300
 };
 
 MapView::MapView()
@@ -55,6 +62,8 @@ MapView::MapView()
     m_optimizedSize = Size(g_map.getAwareRange().horizontal(), g_map.getAwareRange().vertical()) * Otc::TILE_PIXELS;
 
     m_pools.map = g_drawPool.createPoolF(PoolType::MAP);
+    m_pools.staticFloors = g_drawPool.createPoolF(PoolType::STATIC_FLOORS);
+    m_pools.staticFloors->setOffscreen(true);
     m_pools.creatureInformation = g_drawPool.createPool(PoolType::CREATURE_INFORMATION);
     m_pools.text = g_drawPool.createPool(PoolType::TEXT);
 
@@ -115,6 +124,14 @@ MapView::~MapView()
 
 void MapView::draw(const Rect& rect)
 {
+    PROFILE_SCOPE("map.draw");
+
+    // the tile updates of the sweep have to land before the visible tiles are used
+    g_map.removeExpiredEffects();
+
+    if(m_smoothZoomSettleTime > 0 && g_clock.millis() >= m_smoothZoomSettleTime)
+        settleSmoothZoom();
+
     // update visible tiles cache when needed
     if(m_mustUpdateVisibleTilesCache)
         updateVisibleTilesCache();
@@ -141,14 +158,34 @@ void MapView::draw(const Rect& rect)
 
 void MapView::drawFloor()
 {
+    updateStaticFloors(getCameraPosition());
+    const uint8 firstStaticFloor = m_staticFloors.firstFloor;
+
     g_drawPool.use(m_pools.map, m_rectCache.rect, m_rectCache.srcRect);
     {
         const Position cameraPosition = getCameraPosition();
         const auto& lightView = m_drawLights ? m_lightView.get() : nullptr;
+        const int lodFlags = getLodFrameFlags();
+        const bool minimapFloors = isLodActive(LOD_MINIMAP_FLOORS);
+
+        if(m_pools.staticFloors->isEnabled()) {
+            const auto& self = asMapView();
+            g_drawPool.addAction([self] {
+                const auto& texture = self->m_pools.staticFloors->getTexture();
+                g_painter->setCompositionMode(Painter::CompositionMode_Replace);
+                g_painter->drawTexturedRect(self->m_rectDimension, texture, Rect(Point(), texture->getSize()));
+                g_painter->resetCompositionMode();
+            }, m_staticFloors.version);
+        } else
+            g_drawPool.addFilledRect(m_rectDimension, Color::black);
 
-        g_drawPool.addFilledRect(m_rectDimension, Color::black);
         for(int_fast8_t z = m_floorMax; z >= m_floorMin; --z) {
-            if(isDrawingLights()) {
+            // cached floors are only walked for the lights they cast
+            const bool cached = z >= firstStaticFloor;
+            if(cached && !isDrawingLights())
+                continue;
+
+            if(isDrawingLights() && lightView->mustUpdateStaticLights()) {
                 const int8 nextFloor = z - 1;
                 if(nextFloor >= m_floorMin) {
                     lightView->setFloor(nextFloor);
@@ -158,8 +195,8 @@ void MapView::drawFloor()
                             auto pos2D = transformPositionTo2D(tile->getPosition(), cameraPosition);
                             if(ground->isTopGround()) {
                                 const auto currentPos = tile->getPosition();
-                                for(const auto& pos : currentPos.translatedToDirections({ Otc::South, Otc::East })) {
-                                    const auto& nextDownTile = g_map.getTile(pos);
+                                for(const Otc::Direction direction : { Otc::South, Otc::East }) {
+                                    const auto& nextDownTile = g_map.getTile(currentPos.translatedToDirection(direction));
                                     if(nextDownTile && nextDownTile->hasGround() && !nextDownTile->isTopGround()) {
                                         lightView->setShade(pos2D);
                                         break;
@@ -174,7 +211,7 @@ void MapView::drawFloor()
                                 continue;
                             }*/
 
-                            lightView->setShade(pos2D, std::vector<Otc::Direction>() /*tile->hasTallItems() || tile->hasWideItems() ? tile->getBorderDirections() : std::vector<Otc::Direction>()*/);
+                            lightView->setShade(pos2D /*, tile->hasTallItems() || tile->hasWideItems() ? tile->getBorderDirections() : std::vector<Otc::Direction>()*/);
                         }
                     }
                 }
@@ -187,26 +224,57 @@ void MapView::drawFloor()
             const auto& map = m_cachedVisibleTiles[z];
 
             g_drawPool.startPosition();
+            if(cached) {
+                for(const auto& tile : map.lights)
+                    tile->drawLights(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, lightView);
+
+                drawZones(z, cameraPosition);
+                onFloorDrawingEnd(z);
+                continue;
+            }
+
+            if(minimapFloors && z > cameraPosition.z) {
+                if(lightView) {
+                    for(const auto& tile : map.lights)
+                        tile->drawLights(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, lightView);
+                }
+
+                // a cached ground layer already holds the colors of the floor
+                if(z != m_staticFloors.groundFloor)
+                    drawMinimapFloor(z, cameraPosition);
+
+                drawZones(z, cameraPosition);
+                onFloorDrawingEnd(z);
+                continue;
+            }
+
+            const int frameFlags = Otc::FUpdateAll | lodFlags;
+            // a cached ground layer is still walked for the elevation it leaves to the items above, and its lights
+            const int groundFrameFlags = z == m_staticFloors.groundFloor ? frameFlags & Otc::FUpdateLight : frameFlags;
+
             {
                 for(const auto& tile : map.grounds)
-                    tile->drawGround(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateAll, lightView);
+                    tile->drawGround(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, groundFrameFlags, lightView);
 
                 for(const auto& tile : map.borders)
-                    tile->drawGroundBorder(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateAll, lightView);
+                    tile->drawGroundBorder(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, groundFrameFlags, lightView);
 
                 for(const auto& tile : map.bottomTops)
-                    tile->draw(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateAll, lightView);
+                    tile->draw(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, frameFlags, lightView);
             }
 
+            drawZones(z, cameraPosition);
+
             g_drawPool.startPosition();
             {
+                const int missileFlags = lodFlags & Otc::FSkipEffect ? Otc::FUpdateLight : Otc::FUpdateAll;
                 for(const MissilePtr& missile : g_map.getFloorMissiles(z))
-                    missile->draw(transformPositionTo2D(missile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateAll, lightView);
+                    missile->draw(transformPositionTo2D(missile->getPosition(), cameraPosition), m_scaleFactor, missileFlags, lightView);
             }
 
-            if(m_shadowFloorIntensity > 0 && z == cameraPosition.z + 1) {
+            if(getDrawShadowFloorIntensity() > 0 && z == cameraPosition.z + 1) {
                 g_drawPool.addFilledRect(m_rectDimension, Color::black);
-                g_drawPool.setOpacity(m_shadowFloorIntensity, g_drawPool.size());
+                g_drawPool.setOpacity(getDrawShadowFloorIntensity(), g_drawPool.size());
             }
 
             onFloorDrawingEnd(z);
@@ -220,9 +288,197 @@ void MapView::drawFloor()
     }
 }
 
+void MapView::drawZones(int z, const Position& cameraPosition)
+{
+    if(!g_map.showZones())
+        return;
+
+    const int offset = cameraPosition.z - z;
+    const int left = std::max<int>(0, cameraPosition.x - m_virtualCenterOffset.x + offset);
+    const int top = std::max<int>(0, cameraPosition.y - m_virtualCenterOffset.y + offset);
+    const int right = std::min<int>(65535, cameraPosition.x - m_virtualCenterOffset.x + offset + m_drawDimension.width());
+    const int bottom = std::min<int>(65535, cameraPosition.y - m_virtualCenterOffset.y + offset + m_drawDimension.height());
+
+    for(int y = top / BLOCK_SIZE; y <= bottom / BLOCK_SIZE; ++y) {
+        for(int x = left / BLOCK_SIZE; x <= right / BLOCK_SIZE; ++x) {
+            const Position blockPos(x * BLOCK_SIZE, y * BLOCK_SIZE, z);
+            const TexturePtr& texture = g_map.getZoneTexture(blockPos);
+            if(!texture)
+                continue;
+
+            // textures are not smoothed, each texel scales up to a whole tile
+            g_drawPool.addTexturedRect(Rect(transformPositionTo2D(blockPos, cameraPosition), Size(BLOCK_SIZE * m_tileSize)), texture);
+        }
+    }
+}
+
+void MapView::drawMinimapFloor(int z, const Position& cameraPosition)
+{
+    for(const auto& tile : m_cachedVisibleTiles[z].tiles) {
+        const uint8 color = tile->getMinimapColorByte();
+        if(color == 255)
+            continue;
+
+        g_drawPool.addFilledRect(Rect(transformPositionTo2D(tile->getPosition(), cameraPosition), Size(m_tileSize)), Color::from8bit(color));
+    }
+}
+
+void MapView::updateStaticFloors(const Position& cameraPosition)
+{
+    if(!m_staticFloorsCache || !g_graphics.canUseFBO() || !cameraPosition.isValid()) {
+        m_staticFloors.firstFloor = m_staticFloors.groundFloor = UINT8_MAX;
+        m_staticFloors.animatedItems.clear();
+        m_pools.staticFloors->setEnable(false);
+        return;
+    }
+
+    size_t key = 0;
+    boost::hash_combine(key, cameraPosition.x);
+    boost::hash_combine(key, cameraPosition.y);
+    boost::hash_combine(key, cameraPosition.z);
+    boost::hash_combine(key, m_floorMin);
+    boost::hash_combine(key, m_floorMax);
+    boost::hash_combine(key, m_tileSize);
+    boost::hash_combine(key, m_rectDimension.width());
+    boost::hash_combine(key, m_rectDimension.height());
+    boost::hash_combine(key, getDrawShadowFloorIntensity());
+    boost::hash_combine(key, g_things.getDatLoadCount());
+    const int lodFlags = getLodFrameFlags() & Otc::FSkipDecoration;
+    const bool minimapFloors = isLodActive(LOD_MINIMAP_FLOORS);
+    boost::hash_combine(key, lodFlags);
+    boost::hash_combine(key, minimapFloors);
+
+    bool outdated = m_staticFloors.dirty || m_staticFloors.key != key;
+    for(auto it = m_staticFloors.animatedItems.begin(); !outdated && it != m_staticFloors.animatedItems.end(); ++it)
+        outdated = it->first->calculateAnimationPhase(true) != it->second;
+
+    // missiles fly without updating tiles and partial ranges may grow once creatures leave, both are checked every frame
+    uint8 firstFloor = m_staticFloors.firstFloor;
+    if(outdated || (firstFloor != cameraPosition.z + 1 && cameraPosition.z < m_floorMax))
+        firstFloor = calcFirstStaticFloor(cameraPosition);
+    else {
+        for(int z = firstFloor; z <= m_floorMax; ++z) {
+            if(!g_map.getFloorMissiles(z).empty()) {
+                firstFloor = calcFirstStaticFloor(cameraPosition);
+                break;
+            }
+        }
+    }
+
+    // the ground layer of the deepest floor drawn live lies right above the cached floors
+    uint8 groundFloor = firstFloor <= m_floorMax ? firstFloor - 1 : m_floorMax;
+    if(groundFloor < m_floorMin) {
+        groundFloor = UINT8_MAX;
+    } else {
+        const auto& tiles = m_cachedVisibleTiles[groundFloor].tiles;
+        if(std::any_of(tiles.begin(), tiles.end(), [](const TilePtr& tile) { return tile->isSelected(); }))
+            groundFloor = UINT8_MAX;
+    }
+
+    m_pools.staticFloors->setEnable(firstFloor <= m_floorMax || groundFloor != UINT8_MAX);
+    if(!outdated && firstFloor == m_staticFloors.firstFloor && groundFloor == m_staticFloors.groundFloor)
+        return;
+
+    m_staticFloors.firstFloor = firstFloor;
+    m_staticFloors.groundFloor = groundFloor;
+    m_staticFloors.key = key;
+    m_staticFloors.dirty = false;
+    m_staticFloors.animatedItems.clear();
+    if(firstFloor > m_floorMax && groundFloor == UINT8_MAX)
+        return;
+
+    PROFILE_SCOPE("map.staticFloors");
+
+    const uint32 placeholders = ThingType::getPlaceholderCount();
+    const auto addAnimatedItem = [this](const ItemPtr& item) {
+        if(item && item->hasAnimationPhases())
+            m_staticFloors.animatedItems.emplace_back(item, item->calculateAnimationPhase(true));
+    };
+
+    g_drawPool.use(m_pools.staticFloors, Rect(), Rect());
+    g_drawPool.addFilledRect(m_rectDimension, Color::black);
+    for(int z = m_floorMax; z >= firstFloor; --z) {
+        const auto& map = m_cachedVisibleTiles[z];
+
+        g_drawPool.startPosition();
+        if(minimapFloors) {
+            drawMinimapFloor(z, cameraPosition);
+        } else {
+            for(const auto& tile : map.grounds)
+                tile->drawGround(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateThing);
+
+            for(const auto& tile : map.borders)
+                tile->drawGroundBorder(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateThing);
+
+            for(const auto& tile : map.bottomTops)
+                tile->draw(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateThing | lodFlags);
+
+            for(const auto& tile : map.tiles) {
+                for(const ItemPtr& item : tile->getItems())
+                    addAnimatedItem(item);
+            }
+        }
+
+        if(getDrawShadowFloorIntensity() > 0 && z == cameraPosition.z + 1) {
+            g_drawPool.addFilledRect(m_rectDimension, Color::black);
+            g_drawPool.setOpacity(getDrawShadowFloorIntensity(), g_drawPool.size());
+        }
+    }
+
+    if(groundFloor != UINT8_MAX && minimapFloors && groundFloor > cameraPosition.z) {
+        g_drawPool.startPosition();
+        drawMinimapFloor(groundFloor, cameraPosition);
+    } else if(groundFloor != UINT8_MAX) {
+        const auto& map = m_cachedVisibleTiles[groundFloor];
+
+        g_drawPool.startPosition();
+        for(const auto& tile : map.grounds) {
+            tile->drawGround(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateThing);
+            addAnimatedItem(tile->getGround());
+        }
+
+        for(const auto& tile : map.borders) {
+            tile->drawGroundBorder(transformPositionTo2D(tile->getPosition(), cameraPosition), m_scaleFactor, Otc::FUpdateThing);
+            for(const ItemPtr& item : tile->getItems()) {
+                if(item->isGroundBorder())
+                    addAnimatedItem(item);
+            }
+        }
+    }
+
+    // sprites still being composed were drawn as placeholders, the floors are drawn again next frame
+    m_staticFloors.dirty = ThingType::getPlaceholderCount() != placeholders;
+    ++m_staticFloors.version;
+}
+
+uint8 MapView::calcFirstStaticFloor(const Position& cameraPosition)
+{
+    uint8 firstFloor = UINT8_MAX;
+    for(int z = m_floorMax; z > cameraPosition.z; --z) {
+        if(!g_map.getFloorMissiles(z).empty())
+            break;
+
+        const auto& tiles = m_cachedVisibleTiles[z].tiles;
+        if(std::any_of(tiles.begin(), tiles.end(), [](const TilePtr& tile) { return tile->hasDynamicThings(); }))
+            break;
+
+        firstFloor = z;
+    }
+    return firstFloor;
+}
+
+void MapView::invalidateStaticFloors(const Position& pos, bool thingsChanged)
+{
+    // the changed tile is either cached or may let its floor join the cached range,
+    // creatures are drawn over the ground layer and only matter below it
+    if(pos.z > getCameraPosition().z || (thingsChanged && pos.z == m_staticFloors.groundFloor))
+        m_staticFloors.dirty = true;
+}
+
 void MapView::drawCreatureInformation()
 {
     if(!m_drawNames && !m_drawHealthBars && !m_drawManaBar) return;
+    if(isLodActive(LOD_CREATURE_INFORMATION)) return;
 
     g_drawPool.use(m_pools.creatureInformation);
     const Position cameraPosition = getCameraPosition();
@@ -238,6 +494,9 @@ void MapView::drawCreatureInformation()
                                   m_scaleFactor, m_rectCache.drawOffset,
                                   m_rectCache.horizontalStretchFactor, m_rectCache.verticalStretchFactor, flags);
     }
+
+    // bars, icons and names of all creatures, one batch each
+    g_creatureOverlay.draw();
 }
 
 void MapView::drawText()
@@ -261,6 +520,9 @@ void MapView::drawText()
         staticText->drawText(p, m_rectCache.rect);
     }
 
+    if(isLodActive(LOD_ANIMATED_TEXTS))
+        return;
+
     for(const AnimatedTextPtr& animatedText : g_map.getAnimatedTexts()) {
         const Position pos = animatedText->getPosition();
 
@@ -278,6 +540,8 @@ void MapView::drawText()
 
 void MapView::updateVisibleTilesCache()
 {
+    PROFILE_SCOPE("map.visibleTiles");
+
     // there is no tile to render on invalid positions
     const Position cameraPosition = getCameraPosition();
     if(!cameraPosition.isValid())
@@ -285,6 +549,7 @@ void MapView::updateVisibleTilesCache()
 
     m_mustUpdateVisibleTilesCache = false;
 
+    const Position lastCameraPosition = m_lastCameraPosition;
     if(m_lastCameraPosition != cameraPosition) {
         if(m_mousePosition.isValid()) {
             if(cameraPosition.z == m_lastCameraPosition.z) {
@@ -311,10 +576,29 @@ void MapView::updateVisibleTilesCache()
     if(cachedLastVisibleFloor < cachedFirstVisibleFloor)
         cachedLastVisibleFloor = cachedFirstVisibleFloor;
 
+    const bool floorsChanged = m_cachedFirstVisibleFloor != cachedFirstVisibleFloor || m_cachedLastVisibleFloor != cachedLastVisibleFloor;
+    if(m_mustRebuildVisibleTiles || floorsChanged)
+        m_staticFloors.dirty = true;
+
+    // ground shades and item lights are laid out relative to the camera
+    if(m_drawLights && (m_mustRebuildVisibleTiles || floorsChanged || lastCameraPosition != cameraPosition))
+        m_lightView->requestStaticLightUpdate();
+
     m_lastCameraPosition = cameraPosition;
     m_cachedFirstVisibleFloor = cachedFirstVisibleFloor;
     m_cachedLastVisibleFloor = cachedLastVisibleFloor;
 
+    if(const MapViewPtr& source = findVisibleTilesSource(cameraPosition)) {
+        copyVisibleTiles(source, cameraPosition);
+        return;
+    }
+
+    if(m_mustRebuildVisibleTiles || floorsChanged || !shiftVisibleTiles(lastCameraPosition, cameraPosition))
+        rebuildVisibleTiles(cameraPosition);
+
+    m_mustRebuildVisibleTiles = false;
+    m_changedTilePositions.clear();
+
     // clear current visible tiles cache
     do {
         m_cachedVisibleTiles[m_floorMin].clear();
@@ -326,70 +610,388 @@ void MapView::updateVisibleTilesCache()
         m_visibleCreatures.clear();
     }
 
-    // cache visible tiles in draw order
+    // floors are drawn bottom up, so an opaque ground or top of a higher floor hides the cell in every lower one
+    m_occluderFloors.assign(m_drawDimension.width() * (m_drawDimension.height() + 1), UINT8_MAX);
+    for(int_fast32_t iz = m_cachedFirstVisibleFloor; iz <= m_cachedLastVisibleFloor; ++iz) {
+        for(const TilePtr& tile : m_cachedVisibleTiles[iz].tiles) {
+            if(!tile->isCellOccluder())
+                continue;
+
+            const int cell = getOcclusionCell(getVisibleTilesLocalPosition(tile->getPosition(), cameraPosition));
+            if(cell >= 0 && m_occluderFloors[cell] == UINT8_MAX)
+                m_occluderFloors[cell] = iz;
+        }
+    }
+
+    // split the drawable tiles in draw order
     // draw from last floor (the lower) to first floor (the higher)
-    const uint32 numDiagonals = m_drawDimension.width() + m_drawDimension.height() - 1;
     for(int_fast32_t iz = m_cachedLastVisibleFloor; iz >= m_cachedFirstVisibleFloor; --iz) {
         auto& floor = m_cachedVisibleTiles[iz];
 
-        // loop through / diagonals beginning at top left and going to top right
-        for(uint_fast32_t diagonal = 0; diagonal < numDiagonals; ++diagonal) {
-            // loop current diagonal tiles
-            const uint32 advance = std::max<uint32>(diagonal - m_drawDimension.height(), 0);
-            for(int iy = diagonal - advance, ix = advance; iy >= 0 && ix < m_drawDimension.width(); --iy, ++ix) {
-                // position on current floor
-                //TODO: check position limits
-                Position tilePos = cameraPosition.translated(ix - m_virtualCenterOffset.x, iy - m_virtualCenterOffset.y);
-                // adjust tilePos to the wanted floor
-                tilePos.coveredUp(cameraPosition.z - iz);
-                if(const TilePtr& tile = g_map.getTile(tilePos)) {
-                    // skip tiles that have nothing
-                    if(!tile->isDrawable())
-                        continue;
-
-                    if(m_mustUpdateVisibleCreaturesCache) {
-                        const auto& tileCreatures = tile->getCreatures();
-                        if(isInRange(tilePos) && !tileCreatures.empty()) {
-                            m_visibleCreatures.insert(m_visibleCreatures.end(), tileCreatures.rbegin(), tileCreatures.rend());
-                        }
-                    }
+        for(const TilePtr& tile : floor.tiles) {
+            if(m_mustUpdateVisibleCreaturesCache) {
+                const auto& tileCreatures = tile->getCreatures();
+                if(isInRange(tile->getPosition()) && !tileCreatures.empty()) {
+                    m_visibleCreatures.insert(m_visibleCreatures.end(), tileCreatures.rbegin(), tileCreatures.rend());
+                }
+            }
 
-                    // skip tiles that are completely behind another tile
-                    if(tile->isCompletelyCovered(m_cachedFirstVisibleFloor) && !tile->hasLight())
-                        continue;
+            // skip tiles that are completely behind another tile
+            if((tile->isCompletelyCovered(m_cachedFirstVisibleFloor) || isOccluded(tile, getVisibleTilesLocalPosition(tile->getPosition(), cameraPosition), iz)) && !tile->hasLight())
+                continue;
 
-                    if(tile->hasGround())
-                        floor.grounds.push_back(tile);
+            if(tile->hasGround())
+                floor.grounds.push_back(tile);
 
-                    if(isDrawingLights() && tile->hasAnyGround()) {
-                        floor.allGrounds.push_back(tile);
-                    }
+            if(isDrawingLights() && tile->hasAnyGround()) {
+                floor.allGrounds.push_back(tile);
+            }
 
-                    if(tile->hasGroundBorderToDraw())
-                        floor.borders.push_back(tile);
+            if(tile->hasGroundBorderToDraw())
+                floor.borders.push_back(tile);
 
-                    if(tile->hasBottomOrTopToDraw())
-                        floor.bottomTops.push_back(tile);
+            if(tile->hasBottomOrTopToDraw())
+                floor.bottomTops.push_back(tile);
 
-                    tile->onAddVisibleTileList(this);
+            if(isDrawingLights() && (tile->hasLight() || tile->hasDynamicThings()) && (tile->hasAnyGround() || tile->hasGroundBorderToDraw() || tile->hasBottomOrTopToDraw()))
+                floor.lights.push_back(tile);
 
-                    if(iz < m_floorMin)
-                        m_floorMin = iz;
-                    else if(iz > m_floorMax)
-                        m_floorMax = iz;
-                }
+            tile->onAddVisibleTileList(this);
+
+            if(iz < m_floorMin)
+                m_floorMin = iz;
+            else if(iz > m_floorMax)
+                m_floorMax = iz;
+        }
+    }
+
+    m_mustUpdateVisibleCreaturesCache = false;
+    m_mustUpdateVisibleTilesCache = false;
+}
+
+MapViewPtr MapView::findVisibleTilesSource(const Position& cameraPosition)
+{
+    for(const MapViewPtr& source : g_map.getMapViews()) {
+        if(source.get() == this || source->m_mustUpdateVisibleTilesCache || source->m_lastCameraPosition != cameraPosition ||
+           source->m_cachedFirstVisibleFloor != m_cachedFirstVisibleFloor || source->m_cachedLastVisibleFloor != m_cachedLastVisibleFloor ||
+           source->isDrawingLights() != isDrawingLights())
+            continue;
+
+        // every cell of this view must be one the source walked
+        const Point offset = source->m_virtualCenterOffset - m_virtualCenterOffset;
+        const int width = m_drawDimension.width(),
+            height = m_drawDimension.height();
+        bool contained = true;
+        for(int iy = 0; iy <= height && contained; ++iy) {
+            for(int ix = -iy, maxX = std::min<int>(width - 1, width + height - 2 - iy); ix <= maxX && contained; ++ix)
+                contained = source->isInVisibleTilesArea(Point(ix, iy) + offset);
+        }
+
+        if(contained)
+            return source;
+    }
+    return nullptr;
+}
+
+void MapView::copyVisibleTiles(const MapViewPtr& source, const Position& cameraPosition)
+{
+    // occlusion only hides a tile behind the tiles of its own cell and the ones up left of it,
+    // a tile the source skipped can only differ here in the margin around the visible area
+    const auto inArea = [&](const TilePtr& tile) { return isInVisibleTilesArea(getVisibleTilesLocalPosition(tile->getPosition(), cameraPosition)); };
+    const auto filter = [&](const std::vector<TilePtr>& from, std::vector<TilePtr>& to) {
+        to.clear();
+        for(const TilePtr& tile : from) {
+            if(inArea(tile))
+                to.push_back(tile);
+        }
+    };
+
+    for(auto& floor : m_cachedVisibleTiles) {
+        floor.tiles.clear();
+        floor.clear();
+    }
+
+    m_floorMin = m_floorMax = cameraPosition.z;
+    if(m_mustUpdateVisibleCreaturesCache)
+        m_visibleCreatures.clear();
+
+    for(int_fast32_t iz = m_cachedLastVisibleFloor; iz >= m_cachedFirstVisibleFloor; --iz) {
+        const auto& from = source->m_cachedVisibleTiles[iz];
+        auto& floor = m_cachedVisibleTiles[iz];
+
+        filter(from.tiles, floor.tiles);
+        filter(from.grounds, floor.grounds);
+        filter(from.allGrounds, floor.allGrounds);
+        filter(from.borders, floor.borders);
+        filter(from.bottomTops, floor.bottomTops);
+        filter(from.lights, floor.lights);
+
+        if(m_mustUpdateVisibleCreaturesCache) {
+            for(const TilePtr& tile : floor.tiles) {
+                const auto& tileCreatures = tile->getCreatures();
+                if(!tileCreatures.empty() && isInRange(tile->getPosition()))
+                    m_visibleCreatures.insert(m_visibleCreatures.end(), tileCreatures.rbegin(), tileCreatures.rend());
             }
         }
+
+        if(!floor.grounds.empty() || !floor.allGrounds.empty() || !floor.borders.empty() || !floor.bottomTops.empty()) {
+            m_floorMin = std::min<int>(m_floorMin, iz);
+            m_floorMax = std::max<int>(m_floorMax, iz);
+        }
     }
 
+    m_mustRebuildVisibleTiles = false;
+    m_changedTilePositions.clear();
     m_mustUpdateVisibleCreaturesCache = false;
     m_mustUpdateVisibleTilesCache = false;
 }
 
-void MapView::updateGeometry(const Size& visibleDimension, const Size& optimizedSize)
+bool MapView::isOccluded(const TilePtr& tile, const Point& local, uint8 z)
+{
+    // walking creatures are drawn between two cells
+    if(!tile->getWalkingCreatures().empty())
+        return false;
+
+    // larger, displaced or elevated things reach into the cells above and left of the tile
+    int reach = tile->isSingleDimension() ? 0 : 1;
+    if(tile->hasDisplacement() || tile->hasElevation())
+        ++reach;
+
+    for(int y = local.y - reach; y <= local.y; ++y) {
+        for(int x = local.x - reach; x <= local.x; ++x) {
+            const int cell = getOcclusionCell(Point(x, y));
+            if(cell < 0 || m_occluderFloors[cell] >= z)
+                return false;
+        }
+    }
+    return true;
+}
+
+// walks the / diagonals of one floor in draw order, beginning at top left and going to top right;
+// tiles are gathered as raw pointers so worker threads never touch their reference counts
+static void collectFloorTiles(std::vector<Tile*>& tiles, const Position& cameraPosition, const Size& drawDimension, const Point& virtualCenterOffset, int z)
+{
+    const uint32 numDiagonals = drawDimension.width() + drawDimension.height() - 1;
+    for(uint_fast32_t diagonal = 0; diagonal < numDiagonals; ++diagonal) {
+        // loop current diagonal tiles
+        const uint32 advance = std::max<uint32>(diagonal - drawDimension.height(), 0);
+        for(int iy = diagonal - advance, ix = advance; iy >= 0 && ix < drawDimension.width(); --iy, ++ix) {
+            // position on current floor
+            //TODO: check position limits
+            Position tilePos = cameraPosition.translated(ix - virtualCenterOffset.x, iy - virtualCenterOffset.y);
+            // adjust tilePos to the wanted floor
+            tilePos.coveredUp(cameraPosition.z - z);
+            if(const TilePtr& tile = g_map.getTile(tilePos)) {
+                // skip tiles that have nothing
+                if(tile->isDrawable())
+                    tiles.push_back(tile.get());
+            }
+        }
+    }
+}
+
+void MapView::rebuildVisibleTiles(const Position& cameraPosition)
+{
+    // below this many cells per floor scheduling costs more than the walk
+    constexpr int PARALLEL_MIN_AREA = 512;
+
+    for(auto& floor : m_cachedVisibleTiles)
+        floor.tiles.clear();
+
+    // cache visible tiles in draw order
+    const int floors = m_cachedLastVisibleFloor - m_cachedFirstVisibleFloor + 1;
+    const int workers = std::min<int>(g_asyncDispatcher.getThreadCount(), floors - 1);
+    if(workers <= 0 || m_drawDimension.area() < PARALLEL_MIN_AREA) {
+        std::vector<Tile*> tiles;
+        for(int_fast32_t iz = m_cachedLastVisibleFloor; iz >= m_cachedFirstVisibleFloor; --iz) {
+            tiles.clear();
+            collectFloorTiles(tiles, cameraPosition, m_drawDimension, m_virtualCenterOffset, iz);
+            m_cachedVisibleTiles[iz].tiles.assign(tiles.begin(), tiles.end());
+        }
+        return;
+    }
+
+    // the floors are independent, workers and the main thread claim them one at a time.
+    // the map is only changed from the main thread, which does not leave before every claimed floor is done,
+    // a worker that starts late finds nothing left to claim and never reads the map
+    struct Pass {
+        std::atomic<int> next{ 0 }, done{ 0 };
+        std::array<std::vector<Tile*>, Otc::MAX_Z + 1> tiles;
+        Position cameraPosition;
+        Size drawDimension;
+        Point virtualCenterOffset;
+        int lastFloor, floors;
+    };
+
+    const auto pass = std::make_shared<Pass>();
+    pass->cameraPosition = cameraPosition;
+    pass->drawDimension = m_drawDimension;
+    pass->virtualCenterOffset = m_virtualCenterOffset;
+    pass->lastFloor = m_cachedLastVisibleFloor;
+    pass->floors = floors;
+
+    const auto run = [pass] {
+        for(int i; (i = pass->next++) < pass->floors;) {
+            const int z = pass->lastFloor - i;
+            collectFloorTiles(pass->tiles[z], pass->cameraPosition, pass->drawDimension, pass->virtualCenterOffset, z);
+            ++pass->done;
+        }
+    };
+
+    for(int i = 0; i < workers; ++i)
+        g_asyncDispatcher.schedule(run, AsyncDispatcher::PriorityHigh);
+
+    run();
+    while(pass->done < floors)
+        std::this_thread::yield();
+
+    // references are only taken here, on the main thread
+    for(int_fast32_t iz = m_cachedLastVisibleFloor; iz >= m_cachedFirstVisibleFloor; --iz)
+        m_cachedVisibleTiles[iz].tiles.assign(pass->tiles[iz].begin(), pass->tiles[iz].end());
+}
+
+void MapView::requestVisibleTilesCacheShift(const Position& changedPos)
+{
+    m_mustUpdateVisibleTilesCache = true;
+    if(m_mustRebuildVisibleTiles)
+        return;
+
+    // views that are not drawn keep collecting changes, past this point a rebuild is cheaper anyway
+    if(static_cast<int>(m_changedTilePositions.size()) >= m_drawDimension.area()) {
+        m_mustRebuildVisibleTiles = true;
+        m_changedTilePositions.clear();
+        return;
+    }
+
+    m_changedTilePositions.push_back(changedPos);
+}
+
+bool MapView::shiftVisibleTiles(const Position& lastCameraPosition, const Position& cameraPosition)
+{
+    if(!lastCameraPosition.isValid() || lastCameraPosition.z != cameraPosition.z)
+        return false;
+
+    const int dx = cameraPosition.x - lastCameraPosition.x,
+        dy = cameraPosition.y - lastCameraPosition.y;
+    if(std::abs(dx) > 1 || std::abs(dy) > 1)
+        return false;
+
+    const int width = m_drawDimension.width(),
+        height = m_drawDimension.height();
+
+    // near the map limits coveredUp() stops moving positions, the local coordinates would not match
+    const int margin = width + height + Otc::MAX_Z;
+    if(cameraPosition.x < margin || cameraPosition.y < margin || cameraPosition.x > UINT16_MAX - margin || cameraPosition.y > UINT16_MAX - margin)
+        return false;
+
+    // a changed tile covers the same local coordinates on every floor below it,
+    // its neighbours are refreshed too because their borders and covering depend on it
+    struct ChangedArea {
+        Point center;
+        uint8 z;
+    };
+    std::vector<ChangedArea> changedAreas;
+    for(const Position& pos : m_changedTilePositions) {
+        const Point center = getVisibleTilesLocalPosition(pos, cameraPosition);
+        if(center.y < -1 || center.y > height + 1 || center.x > width || center.x + center.y < -2 || center.x + center.y > width + height)
+            continue;
+
+        changedAreas.push_back({ center, pos.z });
+    }
+
+    // too many changes at once, like a floor being received, are cheaper to rebuild
+    if(static_cast<int>(changedAreas.size()) * 9 > width * height)
+        return false;
+
+    // positions are sorted in draw order: diagonal first, then from bottom to top
+    const auto drawOrderLess = [](const Point& a, const Point& b) {
+        return a.x + a.y < b.x + b.y || (a.x + a.y == b.x + b.y && a.x < b.x);
+    };
+
+    std::vector<Point> refreshPositions;
+    std::vector<TilePtr> tiles;
+    for(int_fast32_t iz = m_cachedLastVisibleFloor; iz >= m_cachedFirstVisibleFloor; --iz) {
+        refreshPositions.clear();
+
+        // positions exposed by the camera move, the area of one row is the difference of two ranges
+        if(dx != 0 || dy != 0) {
+            for(int iy = 0; iy <= height; ++iy) {
+                const int minX = -iy, maxX = std::min<int>(width - 1, width + height - 2 - iy);
+                const int lastY = iy + dy;
+                if(lastY < 0 || lastY > height) {
+                    for(int ix = minX; ix <= maxX; ++ix)
+                        refreshPositions.emplace_back(ix, iy);
+                    continue;
+                }
+
+                const int lastMinX = -lastY - dx, lastMaxX = std::min<int>(width - 1, width + height - 2 - lastY) - dx;
+                for(int ix = minX; ix <= std::min<int>(maxX, lastMinX - 1); ++ix)
+                    refreshPositions.emplace_back(ix, iy);
+                for(int ix = std::max<int>(minX, lastMaxX + 1); ix <= maxX; ++ix)
+                    refreshPositions.emplace_back(ix, iy);
+            }
+        }
+
+        for(const ChangedArea& area : changedAreas) {
+            if(area.z > iz)
+                continue;
+
+            for(int ox = -1; ox <= 1; ++ox) {
+                for(int oy = -1; oy <= 1; ++oy) {
+                    const Point local = area.center + Point(ox, oy);
+                    if(isInVisibleTilesArea(local))
+                        refreshPositions.push_back(local);
+                }
+            }
+        }
+
+        std::sort(refreshPositions.begin(), refreshPositions.end(), drawOrderLess);
+        refreshPositions.erase(std::unique(refreshPositions.begin(), refreshPositions.end()), refreshPositions.end());
+
+        const auto addTile = [&](const Point& local) {
+            Position tilePos = cameraPosition.translated(local.x - m_virtualCenterOffset.x, local.y - m_virtualCenterOffset.y);
+            tilePos.coveredUp(cameraPosition.z - iz);
+            if(const TilePtr& tile = g_map.getTile(tilePos)) {
+                if(tile->isDrawable())
+                    tiles.push_back(tile);
+            }
+        };
+
+        // merge the still visible tiles with the refreshed positions, both are in draw order
+        auto& floor = m_cachedVisibleTiles[iz];
+        tiles.clear();
+        tiles.reserve(floor.tiles.size() + refreshPositions.size());
+
+        auto it = refreshPositions.begin();
+        for(const TilePtr& tile : floor.tiles) {
+            const Point local = getVisibleTilesLocalPosition(tile->getPosition(), cameraPosition);
+            if(!isInVisibleTilesArea(local))
+                continue;
+
+            while(it != refreshPositions.end() && drawOrderLess(*it, local))
+                addTile(*it++);
+
+            if(it != refreshPositions.end() && *it == local) {
+                addTile(*it++);
+                continue;
+            }
+
+            tiles.push_back(tile);
+        }
+
+        while(it != refreshPositions.end())
+            addTile(*it++);
+
+        floor.tiles.swap(tiles);
+    }
+
+    return true;
+}
+
+void MapView::updateGeometry(const Size& visibleDimension, const Size& optimizedSize, const Size& coveredDimension)
 {
-    const uint8 tileSize = Otc::TILE_PIXELS * (static_cast<float>(m_renderScale) / 100);
-    const Size drawDimension = visibleDimension + Size(3),
+    const uint8 tileSize = Otc::TILE_PIXELS * (static_cast<float>(getDrawRenderScale()) / 100);
+    const Size drawDimension = (coveredDimension.isEmpty() ? visibleDimension : coveredDimension) + Size(3),
         bufferSize = drawDimension * tileSize;
 
     if(bufferSize.width() > g_graphics.getMaxTextureSize() || bufferSize.height() > g_graphics.getMaxTextureSize()) {
@@ -434,6 +1036,8 @@ void MapView::updateGeometry(const Size& visibleDimension, const Size& optimized
     m_scaleFactor = m_tileSize / static_cast<float>(Otc::TILE_PIXELS);
 
     m_pools.map->resize(bufferSize);
+    m_pools.staticFloors->resize(bufferSize);
+    m_staticFloors.dirty = true;
     if(m_drawLights) m_lightView->resize();
 
     m_awareRange.left = std::min<uint16>(g_map.getAwareRange().left, (m_drawDimension.width() / 2) - 1);
@@ -453,6 +1057,8 @@ void MapView::onCameraMove(const Point& /*offset*/)
     if(isFollowingCreature()) {
         if(m_followingCreature->isWalking()) {
             m_viewport = m_viewPortDirection[m_followingCreature->getDirection()];
+        } else if(m_followingCreature->isLocalPlayer() && m_followingCreature->static_self_cast<LocalPlayer>()->isCorrectingCamera()) {
+            m_viewport = m_viewPortDirection[m_followingCreature->static_self_cast<LocalPlayer>()->getCameraCorrectionDirection()];
         } else {
             m_viewport = m_viewPortDirection[Otc::InvalidDirection];
         }
@@ -485,12 +1091,32 @@ void MapView::onFloorChange(const uint8 /*floor*/, const uint8 /*previousFloor*/
 void MapView::onFloorDrawingStart(const uint8 /*floor*/) {}
 void MapView::onFloorDrawingEnd(const uint8 /*floor*/) {}
 
-void MapView::onTileUpdate(const Position&, const ThingPtr& thing, const Otc::Operation)
+void MapView::onTileUpdate(const Position& pos, const ThingPtr& thing, const Otc::Operation)
 {
     if(thing && thing->isCreature())
         m_mustUpdateVisibleCreaturesCache = true;
+    else if(m_drawLights)
+        m_lightView->requestStaticLightUpdate();
 
-    requestVisibleTilesCacheUpdate();
+    requestVisibleTilesCacheShift(pos);
+    invalidateStaticFloors(pos, !thing || !thing->isCreature());
+}
+
+void MapView::onTileBatchUpdate(const std::vector<Position>& positions, bool creaturesChanged, bool thingsChanged)
+{
+    if(creaturesChanged)
+        m_mustUpdateVisibleCreaturesCache = true;
+    if(thingsChanged && m_drawLights)
+        m_lightView->requestStaticLightUpdate();
+
+    for(const Position& pos : positions)
+        invalidateStaticFloors(pos, thingsChanged);
+
+    for(const Position& pos : positions) {
+        requestVisibleTilesCacheShift(pos);
+        if(m_mustRebuildVisibleTiles)
+            break;
+    }
 }
 
 void MapView::onPositionChange(const Position& /*newPos*/, const Position& /*oldPos*/) {}
@@ -523,7 +1149,7 @@ void MapView::onKeyRelease(const InputEvent& inputEvent)
 
 void MapView::onMapCenterChange(const Position&)
 {
-    requestVisibleTilesCacheUpdate();
+    requestVisibleTilesCacheShift();
 }
 
 void MapView::lockFirstVisibleFloor(uint8 firstVisibleFloor)
@@ -553,7 +1179,38 @@ void MapView::setVisibleDimension(const Size& visibleDimension)
         return;
     }
 
-    updateGeometry(visibleDimension, m_optimizedSize);
+    if(!m_smoothZoom || m_drawDimension.isEmpty()) {
+        updateGeometry(visibleDimension, m_optimizedSize);
+        return;
+    }
+
+    // the framebuffer only grows when the step leaves the range it was sized for, with room for the next steps
+    const Size coveredDimension = m_drawDimension - Size(3);
+    if(visibleDimension.width() > coveredDimension.width() || visibleDimension.height() > coveredDimension.height()) {
+        Size rangeDimension = visibleDimension + Size(m_smoothZoomRange * 2);
+        if(std::max<int>(rangeDimension.width(), rangeDimension.height()) + 3 > g_graphics.getMaxTextureSize() / m_tileSize)
+            rangeDimension = visibleDimension;
+        updateGeometry(visibleDimension, m_optimizedSize, rangeDimension);
+    } else {
+        m_visibleDimension = visibleDimension;
+        m_rectCache.rect = Rect();
+    }
+
+    m_smoothZoomSettleTime = g_clock.millis() + SMOOTH_ZOOM_SETTLE_DELAY;
+}
+
+void MapView::setSmoothZoom(bool enable)
+{
+    m_smoothZoom = enable;
+    if(!enable && isSmoothZooming())
+        settleSmoothZoom();
+}
+
+void MapView::settleSmoothZoom()
+{
+    m_smoothZoomSettleTime = 0;
+    if(m_drawDimension != m_visibleDimension + Size(3))
+        updateGeometry(m_visibleDimension, m_optimizedSize);
 }
 
 void MapView::setViewMode(ViewMode viewMode)
@@ -571,12 +1228,18 @@ void MapView::setAutoViewMode(bool enable)
 
 void MapView::optimizeForSize(const Size& visibleSize)
 {
+    // the geometry doesn't depend on the widget size, zoom steps resize the widget and mustn't rebuild it
+    if(visibleSize == m_optimizedSize || isSmoothZooming()) {
+        m_optimizedSize = visibleSize;
+        return;
+    }
     updateGeometry(m_visibleDimension, visibleSize);
 }
 
 void MapView::setAntiAliasing(const bool enable)
 {
-    m_pools.map->setSmooth(enable);
+    m_antiAliasing = enable;
+    m_pools.map->setSmooth(enable && m_qualityLevel < QUALITY_NO_SMOOTHING);
 
     updateGeometry(m_visibleDimension, m_optimizedSize);
 }
@@ -588,6 +1251,56 @@ void MapView::setRenderScale(const uint8 scale)
     updateLight();
 }
 
+void MapView::setQualityLevel(uint8 level)
+{
+    level = std::min<uint8>(level, QUALITY_LOWEST);
+    if(m_qualityLevel == level)
+        return;
+
+    m_qualityLevel = level;
+    m_pools.map->setSmooth(m_antiAliasing && m_qualityLevel < QUALITY_NO_SMOOTHING);
+    m_staticFloors.dirty = true;
+
+    updateGeometry(m_visibleDimension, m_optimizedSize);
+    updateLight();
+}
+
+uint8 MapView::getDrawRenderScale()
+{
+    if(m_qualityLevel >= QUALITY_HALF_SCALE)
+        return std::max<uint8>(m_renderScale / 2, 25);
+    if(m_qualityLevel >= QUALITY_REDUCED_SCALE)
+        return std::max<uint8>(m_renderScale * 3 / 4, 25);
+    return m_renderScale;
+}
+
+void MapView::setLodThreshold(uint8 rule, uint8 pixels)
+{
+    if(rule >= LOD_LAST || m_lodThresholds[rule] == pixels)
+        return;
+
+    m_lodThresholds[rule] = pixels;
+    m_staticFloors.dirty = true;
+}
+
+float MapView::getEffectiveTileSize()
+{
+    // the stretch factors are only known once the view was drawn somewhere
+    if(!m_rectCache.rect.isValid())
+        return m_tileSize;
+
+    return m_tileSize * std::min<float>(m_rectCache.horizontalStretchFactor, m_rectCache.verticalStretchFactor);
+}
+
+int MapView::getLodFrameFlags()
+{
+    int flags = 0;
+    if(isLodActive(LOD_DECORATIONS)) flags |= Otc::FSkipDecoration;
+    if(isLodActive(LOD_EFFECTS)) flags |= Otc::FSkipEffect;
+    if(isLodActive(LOD_SIMPLE_CREATURES)) flags |= Otc::FSimplifyCreature;
+    return flags;
+}
+
 void MapView::followCreature(const CreaturePtr& creature)
 {
     m_follow = true;
@@ -604,6 +1317,41 @@ void MapView::setCameraPosition(const Position& pos)
     requestVisibleTilesCacheUpdate();
 }
 
+std::tuple<double, double> MapView::benchmarkVisibleTilesCache(int iterations)
+{
+    iterations = std::max<int>(1, iterations);
+    const Position cameraPosition = getCameraPosition();
+    if(!cameraPosition.isValid())
+        stdext::throw_exception("failed to benchmark, the map view has no camera position");
+
+    const bool follow = m_follow;
+    const Position customCameraPosition = m_customCameraPosition;
+    m_follow = false;
+    m_customCameraPosition = cameraPosition;
+
+    stdext::timer timer;
+    for(int i = 0; i < iterations; ++i) {
+        requestVisibleTilesCacheUpdate();
+        updateVisibleTilesCache();
+    }
+    const double rebuildMicros = static_cast<double>(timer.elapsed_micros()) / iterations;
+
+    timer.restart();
+    for(int i = 0; i < iterations; ++i) {
+        m_customCameraPosition = cameraPosition.translated(i % 2 == 0 ? 1 : 0, 0);
+        requestVisibleTilesCacheShift();
+        updateVisibleTilesCache();
+    }
+    const double shiftMicros = static_cast<double>(timer.elapsed_micros()) / iterations;
+
+    m_follow = follow;
+    m_customCameraPosition = customCameraPosition;
+    requestVisibleTilesCacheUpdate();
+
+    g_logger.info(stdext::format("Visible tiles of %dx%d tiles: rebuild %.1f us, shift %.1f us", m_visibleDimension.width(), m_visibleDimension.height(), rebuildMicros, shiftMicros));
+    return std::make_tuple(rebuildMicros, shiftMicros);
+}
+
 Position MapView::getPosition(const Point& point, const Size& mapSize)
 {
     const Position cameraPosition = getCameraPosition();
@@ -654,7 +1402,7 @@ void MapView::move(int32 x, int32 y)
     m_rectCache.rect = Rect();
 
     if(requestTilesUpdate)
-        requestVisibleTilesCacheUpdate();
+        requestVisibleTilesCacheShift();
 
     onCameraMove(m_moveOffset);
 }
@@ -663,7 +1411,7 @@ Rect MapView::calcFramebufferSource(const Size& destSize)
 {
     Point drawOffset = ((m_drawDimension - m_visibleDimension - Size(1)).toPoint() / 2) * m_tileSize;
     if(isFollowingCreature())
-        drawOffset += m_followingCreature->getWalkOffset() * m_scaleFactor;
+        drawOffset += m_followingCreature->getCameraOffset() * m_scaleFactor;
     else if(!m_moveOffset.isNull())
         drawOffset += m_moveOffset * m_scaleFactor;
 
@@ -711,15 +1459,15 @@ uint8 MapView::calcFirstVisibleFloor()
                             const auto isLookPossible = g_map.isLookPossible(pos);
                             while(coveredPos.coveredUp() && upperPos.up() && upperPos.z >= firstFloor) {
                                 // check tiles physically above
-                                TilePtr tile = g_map.getTile(upperPos);
-                                if(tile && tile->limitsFloorsView(!isLookPossible)) {
+                                const TilePtr& upperTile = g_map.getTile(upperPos);
+                                if(upperTile && upperTile->limitsFloorsView(!isLookPossible)) {
                                     firstFloor = upperPos.z + 1;
                                     break;
                                 }
 
                                 // check tiles geometrically above
-                                tile = g_map.getTile(coveredPos);
-                                if(tile && tile->limitsFloorsView(isLookPossible)) {
+                                const TilePtr& coveredTile = g_map.getTile(coveredPos);
+                                if(coveredTile && coveredTile->limitsFloorsView(isLookPossible)) {
                                     firstFloor = coveredPos.z + 1;
                                     break;
                                 }
@@ -59,6 +59,7 @@ protected:
     void onFloorDrawingEnd(const uint8 floor);
     void onFloorChange(const uint8 floor, const uint8 previousFloor);
     void onTileUpdate(const Position& pos, const ThingPtr& thing, const Otc::Operation operation);
+    void onTileBatchUpdate(const std::vector<Position>& positions, bool creaturesChanged, bool thingsChanged);
     void onMapCenterChange(const Position& pos);
     void onCameraMove(const Point& offset);
 
@@ -84,6 +85,14 @@ public:
     Size getVisibleDimension() { return m_visibleDimension; }
     void setVisibleDimension(const Size& visibleDimension);
 
+    // zoom steps draw into the framebuffer of the widest dimension within range tiles, only the source rect
+    // follows them and the geometry is fitted once no step came for a while
+    void setSmoothZoom(bool enable);
+    bool isSmoothZoomEnabled() { return m_smoothZoom; }
+    void setSmoothZoomRange(int range) { m_smoothZoomRange = std::max<int>(range, 0); }
+    int getSmoothZoomRange() { return m_smoothZoomRange; }
+    bool isSmoothZooming() { return m_smoothZoomSettleTime > 0; }
+
     // view mode related
     ViewMode getViewMode() { return m_viewMode; }
     void setViewMode(ViewMode viewMode);
@@ -125,6 +134,9 @@ public:
     void setDrawManaBar(bool enable) { m_drawManaBar = enable; }
     bool isDrawingManaBar() { return m_drawManaBar; }
 
+    void setStaticFloorsCache(bool enable) { m_staticFloorsCache = enable; m_staticFloors.dirty = true; }
+    bool isStaticFloorsCacheEnabled() { return m_staticFloorsCache; }
+
     void move(int32 x, int32 y);
 
     void setShader(const PainterShaderProgramPtr& shader, float fadein, float fadeout);
@@ -158,17 +170,65 @@ public:
     void setAntiAliasing(const bool enable);
     void setRenderScale(const uint8 scale);
 
+    // steps taken by the adaptive quality governor, each one includes the previous ones
+    enum QualityLevel : uint8 {
+        QUALITY_FULL = 0,
+        QUALITY_NO_FLOOR_SHADOW,
+        QUALITY_NO_SMOOTHING,
+        QUALITY_REDUCED_SCALE,
+        QUALITY_HALF_SCALE,
+        QUALITY_LOWEST = QUALITY_HALF_SCALE
+    };
+
+    void setQualityLevel(uint8 level);
+    uint8 getQualityLevel() { return m_qualityLevel; }
+
+    // detail left out while tiles are drawn smaller than the threshold of its rule, in screen pixels
+    enum LodRule : uint8 {
+        LOD_DECORATIONS = 0, // common items that neither block nor raise what lies on them
+        LOD_EFFECTS, // effects and missiles
+        LOD_ANIMATED_TEXTS,
+        LOD_CREATURE_INFORMATION,
+        LOD_SIMPLE_CREATURES, // one frame of the base outfit, without addons, mount or colors
+        LOD_MINIMAP_FLOORS, // floors below the camera filled with their minimap colors
+        LOD_LAST
+    };
+
+    void setLodThreshold(uint8 rule, uint8 pixels);
+    uint8 getLodThreshold(uint8 rule) { return rule < LOD_LAST ? m_lodThresholds[rule] : 0; }
+    // screen pixels per tile once the framebuffer is stretched over the widget
+    float getEffectiveTileSize();
+
+    // microseconds per visible tiles update around the camera, rebuilding from scratch and shifting one tile east or west
+    std::tuple<double, double> benchmarkVisibleTilesCache(int iterations);
+
 private:
     struct MapList {
+        // every drawable tile of the floor in draw order, the lists below are filtered from it
+        std::vector<TilePtr> tiles;
         std::vector<TilePtr> grounds, allGrounds, borders, bottomTops;
-        void clear() { grounds.clear(); allGrounds.clear(); borders.clear(); bottomTops.clear(); }
+        // tiles that may cast light, the only ones a cached floor is walked for
+        std::vector<TilePtr> lights;
+        void clear() { grounds.clear(); allGrounds.clear(); borders.clear(); bottomTops.clear(); lights.clear(); }
     };
 
     struct Pools {
-        PoolFramedPtr map;
+        PoolFramedPtr map, staticFloors;
         PoolPtr creatureInformation, text;
     };
 
+    // floors below the camera without creatures, effects or missiles, and the ground layer above them,
+    // drawn once into their own framebuffer
+    struct StaticFloors {
+        uint8 firstFloor{ UINT8_MAX }; // the cached range goes from here down to m_floorMax
+        uint8 groundFloor{ UINT8_MAX }; // floor whose grounds and borders are cached, the rest of it is drawn live
+        uint32 version{ 0 };
+        size_t key{ 0 };
+        bool dirty{ true };
+        // animated items of the range and the phase they were drawn with
+        std::vector<std::pair<ItemPtr, int>> animatedItems;
+    };
+
     struct Crosshair {
         bool positionChanged = false;
         Position position;
@@ -181,9 +241,40 @@ private:
         float horizontalStretchFactor, verticalStretchFactor;
     };
 
-    void updateGeometry(const Size& visibleDimension, const Size& optimizedSize);
+    // coveredDimension is what the framebuffer holds, the visible dimension when empty
+    void updateGeometry(const Size& visibleDimension, const Size& optimizedSize, const Size& coveredDimension = Size());
+    void settleSmoothZoom();
     void updateVisibleTilesCache();
-    void requestVisibleTilesCacheUpdate() { m_mustUpdateVisibleTilesCache = true; }
+    void rebuildVisibleTiles(const Position& cameraPosition);
+    bool shiftVisibleTiles(const Position& lastCameraPosition, const Position& cameraPosition);
+    // another view that already extracted the same scene this frame and whose area holds ours
+    MapViewPtr findVisibleTilesSource(const Position& cameraPosition);
+    void copyVisibleTiles(const MapViewPtr& source, const Position& cameraPosition);
+    void requestVisibleTilesCacheUpdate() { m_mustUpdateVisibleTilesCache = true; m_mustRebuildVisibleTiles = true; }
+    // the camera moved or a single tile changed, the cached tiles can be shifted instead of rebuilt
+    void requestVisibleTilesCacheShift() { m_mustUpdateVisibleTilesCache = true; }
+    void requestVisibleTilesCacheShift(const Position& changedPos);
+
+    Point getVisibleTilesLocalPosition(const Position& pos, const Position& cameraPosition)
+    {
+        return Point(pos.x - cameraPosition.x + m_virtualCenterOffset.x - (cameraPosition.z - pos.z),
+                     pos.y - cameraPosition.y + m_virtualCenterOffset.y - (cameraPosition.z - pos.z));
+    }
+
+    // tiles walked by the visible tiles scan, diagonals begin below the left bottom corner of the draw dimension
+    bool isInVisibleTilesArea(const Point& local)
+    {
+        return local.y >= 0 && local.y <= m_drawDimension.height() && local.x < m_drawDimension.width() &&
+            local.x + local.y >= 0 && local.x + local.y <= m_drawDimension.width() + m_drawDimension.height() - 2;
+    }
+
+    int getOcclusionCell(const Point& local)
+    {
+        if(local.x < 0 || local.y < 0 || local.x >= m_drawDimension.width() || local.y > m_drawDimension.height())
+            return -1;
+        return local.y * m_drawDimension.width() + local.x;
+    }
+    bool isOccluded(const TilePtr& tile, const Point& local, uint8 z);
 
     uint8 calcFirstVisibleFloor();
     uint8 calcLastVisibleFloor();
@@ -191,6 +282,12 @@ private:
     void updateLight();
     void updateViewportDirectionCache();
     void drawFloor();
+    // tints the visible tiles of floor z with the overlay of each map block, one textured rect per block
+    void drawZones(int z, const Position& cameraPosition);
+    void updateStaticFloors(const Position& cameraPosition);
+    // UINT8_MAX when every floor below the camera has something moving
+    uint8 calcFirstStaticFloor(const Position& cameraPosition);
+    void invalidateStaticFloors(const Position& pos, bool thingsChanged);
     void drawCreatureInformation();
     void drawText();
 
@@ -204,10 +301,20 @@ private:
 
     bool canRenderTile(const TilePtr& tile, LightView* lightView);
 
+    // render scale and floor shadow after the quality level is applied
+    uint8 getDrawRenderScale();
+    float getDrawShadowFloorIntensity() { return m_qualityLevel >= QUALITY_NO_FLOOR_SHADOW ? 0.f : m_shadowFloorIntensity; }
+
+    bool isLodActive(LodRule rule) { return getEffectiveTileSize() < m_lodThresholds[rule]; }
+    // the frame flags of the lod rules that apply to things drawn on the map
+    int getLodFrameFlags();
+    void drawMinimapFloor(int z, const Position& cameraPosition);
+
     uint8 m_lockedFirstVisibleFloor{ UINT8_MAX },
         m_cachedFirstVisibleFloor{ Otc::SEA_FLOOR },
         m_cachedLastVisibleFloor{ Otc::SEA_FLOOR },
         m_renderScale{ 100 },
+        m_qualityLevel{ QUALITY_FULL },
         m_tileSize,
         m_floorMin{ 0 },
         m_floorMax{ 0 };
@@ -232,11 +339,17 @@ private:
         m_lastCameraPosition,
         m_mousePosition;
 
+    std::array<uint8, LOD_LAST> m_lodThresholds{ 8, 6, 10, 12, 8, 6 };
+
+    int m_smoothZoomRange{ 8 };
+    ticks_t m_smoothZoomSettleTime{ 0 };
+
     std::array<AwareRange, Otc::InvalidDirection + 1> m_viewPortDirection;
     AwareRange m_viewport;
 
     stdext::boolean<true>
         m_mustUpdateVisibleTilesCache,
+        m_mustRebuildVisibleTiles,
         m_mustUpdateVisibleCreaturesCache,
         m_shaderSwitchDone,
         m_drawHealthBars,
@@ -246,23 +359,29 @@ private:
         m_drawNames,
         m_smooth,
         m_follow,
-        m_antiAliasing;
+        m_antiAliasing,
+        m_staticFloorsCache;
 
     stdext::boolean<false> m_drawLights,
         m_autoViewMode,
         m_drawViewportEdge,
         m_drawHighlightTarget;
 
-    bool m_shiftPressed{ false };
+    bool m_shiftPressed{ false },
+        m_smoothZoom{ false };
 
     std::vector<CreaturePtr> m_visibleCreatures;
 
     std::array<MapList, Otc::MAX_Z + 1> m_cachedVisibleTiles;
+    // highest floor with an occluder in each screen cell, UINT8_MAX when the cell is open
+    std::vector<uint8> m_occluderFloors;
+    std::vector<Position> m_changedTilePositions;
 
     PainterShaderProgramPtr m_shader, m_nextShader;
     LightViewPtr m_lightView;
     CreaturePtr m_followingCreature;
     Pools m_pools;
+    StaticFloors m_staticFloors;
 
     RectCache m_rectCache;
     ViewMode m_viewMode{ NEAR_VIEW };
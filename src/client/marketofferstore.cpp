@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "marketofferstore.h"
+#include <framework/net/inputmessage.h>
+
+namespace {
+    // the browse values that do not name an item
+    const uint16 MarketRequestMyOffers = 0xFFFE;
+    const uint16 MarketRequestMyHistory = 0xFFFF;
+}
+
+uint MarketOfferStore::readOffers(const InputMessagePtr& msg, uint16 var)
+{
+    const uint count = msg->getU32();
+    m_rows.reserve(m_rows.size() + count);
+
+    for(uint i = 0; i < count; ++i) {
+        const uint32 timestamp = msg->getU32();
+        const uint16 counter = msg->getU16();
+        uint16 itemId = var;
+        if(var == MarketRequestMyOffers || var == MarketRequestMyHistory)
+            itemId = msg->getU16();
+        const uint16 amount = msg->getU16();
+        const uint32 price = msg->getU32();
+
+        std::string player;
+        uint8 state = 0;
+        if(var == MarketRequestMyHistory)
+            state = msg->getU8();
+        else if(var != MarketRequestMyOffers)
+            player = msg->getString();
+
+        // an offer sent again replaces the row it had
+        m_rows[makeId(timestamp, counter)] = appendRow(timestamp, counter, itemId, amount, price, player, state);
+    }
+
+    // sorting a whole browse once is cheaper than inserting offer by offer
+    m_validOrders.fill(false);
+    m_validView = false;
+    return count;
+}
+
+void MarketOfferStore::addOffer(uint32 timestamp, uint16 counter, uint16 itemId, uint16 amount, uint32 price, const std::string& player, uint8 state)
+{
+    removeOffer(timestamp, counter);
+
+    const uint32 row = appendRow(timestamp, counter, itemId, amount, price, player, state);
+    m_rows[makeId(timestamp, counter)] = row;
+    for(int column = 0; column < SORT_COLUMNS; ++column)
+        insertOrdered(column, row);
+    m_validView = false;
+}
+
+bool MarketOfferStore::removeOffer(uint32 timestamp, uint16 counter)
+{
+    const auto it = m_rows.find(makeId(timestamp, counter));
+    if(it == m_rows.end())
+        return false;
+
+    const uint32 row = it->second;
+    for(int column = 0; column < SORT_COLUMNS; ++column)
+        eraseOrdered(column, row);
+    m_rows.erase(makeId(timestamp, counter));
+    m_validView = false;
+    return true;
+}
+
+bool MarketOfferStore::setOfferAmount(uint32 timestamp, uint16 counter, uint16 amount)
+{
+    if(amount == 0)
+        return removeOffer(timestamp, counter);
+
+    const auto it = m_rows.find(makeId(timestamp, counter));
+    if(it == m_rows.end())
+        return false;
+
+    // only the orders that depend on the amount move
+    const uint32 row = it->second;
+    eraseOrdered(SortAmount, row);
+    eraseOrdered(SortTotalPrice, row);
+    m_amounts[row] = amount;
+    insertOrdered(SortAmount, row);
+    insertOrdered(SortTotalPrice, row);
+    m_validView = false;
+    return true;
+}
+
+void MarketOfferStore::clear()
+{
+    m_timestamps.clear();
+    m_prices.clear();
+    m_counters.clear();
+    m_itemIds.clear();
+    m_amounts.clear();
+    m_states.clear();
+    m_players.clear();
+    m_rows.clear();
+    for(auto& order : m_orders)
+        order.clear();
+    m_validOrders.fill(true);
+    m_view.clear();
+    m_validView = true;
+}
+
+void MarketOfferStore::setSorting(int column, bool descending)
+{
+    if(column < 0 || column >= SORT_COLUMNS)
+        return;
+
+    if(column != m_sortColumn || descending != m_descending)
+        m_validView = false;
+    m_sortColumn = column;
+    m_descending = descending;
+}
+
+void MarketOfferStore::setPriceRange(uint32 minPrice, uint32 maxPrice)
+{
+    m_minPrice = minPrice;
+    m_maxPrice = maxPrice;
+    m_validView = false;
+}
+
+void MarketOfferStore::setAmountRange(uint16 minAmount, uint16 maxAmount)
+{
+    m_minAmount = minAmount;
+    m_maxAmount = maxAmount;
+    m_validView = false;
+}
+
+void MarketOfferStore::setItemFilter(uint16 itemId)
+{
+    m_itemFilter = itemId;
+    m_validView = false;
+}
+
+int MarketOfferStore::getOfferCount()
+{
+    return getView().size();
+}
+
+std::vector<MarketOfferRow> MarketOfferStore::getPage(int first, int count)
+{
+    const auto& view = getView();
+
+    std::vector<MarketOfferRow> page;
+    const int begin = std::max<int>(first - 1, 0);
+    const int end = std::min<int>(begin + std::max<int>(count, 0), view.size());
+    if(begin >= end)
+        return page;
+
+    page.reserve(end - begin);
+    for(int i = begin; i < end; ++i)
+        page.push_back(getRow(view[i]));
+    return page;
+}
+
+MarketOfferRow MarketOfferStore::getOffer(uint32 timestamp, uint16 counter)
+{
+    const auto it = m_rows.find(makeId(timestamp, counter));
+    if(it == m_rows.end())
+        return MarketOfferRow();
+    return getRow(it->second);
+}
+
+uint32 MarketOfferStore::appendRow(uint32 timestamp, uint16 counter, uint16 itemId, uint16 amount, uint32 price, const std::string& player, uint8 state)
+{
+    m_timestamps.push_back(timestamp);
+    m_prices.push_back(price);
+    m_counters.push_back(counter);
+    m_itemIds.push_back(itemId);
+    m_amounts.push_back(amount);
+    m_states.push_back(state);
+    m_players.push_back(player);
+    return m_timestamps.size() - 1;
+}
+
+bool MarketOfferStore::less(int column, uint32 a, uint32 b) const
+{
+    // ties fall back to the row so every order is strict and stable across updates
+    switch(column) {
+        case SortPrice:
+            if(m_prices[a] != m_prices[b])
+                return m_prices[a] < m_prices[b];
+            break;
+        case SortAmount:
+            if(m_amounts[a] != m_amounts[b])
+                return m_amounts[a] < m_amounts[b];
+            break;
+        case SortTotalPrice: {
+            const uint64 totalA = static_cast<uint64>(m_prices[a]) * m_amounts[a];
+            const uint64 totalB = static_cast<uint64>(m_prices[b]) * m_amounts[b];
+            if(totalA != totalB)
+                return totalA < totalB;
+            break;
+        }
+        case SortTimestamp:
+            if(m_timestamps[a] != m_timestamps[b])
+                return m_timestamps[a] < m_timestamps[b];
+            if(m_counters[a] != m_counters[b])
+                return m_counters[a] < m_counters[b];
+            break;
+        case SortPlayer: {
+            const int result = m_players[a].compare(m_players[b]);
+            if(result != 0)
+                return result < 0;
+            break;
+        }
+        default:
+            break;
+    }
+    return a < b;
+}
+
+bool MarketOfferStore::matches(uint32 row) const
+{
+    return m_prices[row] >= m_minPrice && m_prices[row] <= m_maxPrice &&
+        m_amounts[row] >= m_minAmount && m_amounts[row] <= m_maxAmount &&
+        (m_itemFilter == 0 || m_itemIds[row] == m_itemFilter);
+}
+
+MarketOfferRow MarketOfferStore::getRow(uint32 row) const
+{
+    MarketOfferRow offer;
+    offer.timestamp = m_timestamps[row];
+    offer.counter = m_counters[row];
+    offer.itemId = m_itemIds[row];
+    offer.amount = m_amounts[row];
+    offer.price = m_prices[row];
+    offer.state = m_states[row];
+    offer.player = m_players[row];
+    return offer;
+}
+
+void MarketOfferStore::insertOrdered(int column, uint32 row)
+{
+    // an invalid order is rebuilt from the live rows when it is needed
+    if(!m_validOrders[column])
+        return;
+
+    auto& order = m_orders[column];
+    order.insert(std::lower_bound(order.begin(), order.end(), row, [&](uint32 a, uint32 b) { return less(column, a, b); }), row);
+}
+
+void MarketOfferStore::eraseOrdered(int column, uint32 row)
+{
+    if(!m_validOrders[column])
+        return;
+
+    auto& order = m_orders[column];
+    const auto it = std::lower_bound(order.begin(), order.end(), row, [&](uint32 a, uint32 b) { return less(column, a, b); });
+    if(it != order.end() && *it == row)
+        order.erase(it);
+}
+
+const std::vector<uint32>& MarketOfferStore::getOrder(int column)
+{
+    auto& order = m_orders[column];
+    if(m_validOrders[column])
+        return order;
+
+    order.clear();
+    order.reserve(m_rows.size());
+    for(const auto& it : m_rows)
+        order.push_back(it.second);
+    std::sort(order.begin(), order.end(), [&](uint32 a, uint32 b) { return less(column, a, b); });
+    m_validOrders[column] = true;
+    return order;
+}
+
+const std::vector<uint32>& MarketOfferStore::getView()
+{
+    if(m_validView)
+        return m_view;
+
+    const auto& order = getOrder(m_sortColumn);
+    m_view.clear();
+    m_view.reserve(order.size());
+    if(m_descending) {
+        for(auto it = order.rbegin(); it != order.rend(); ++it) {
+            if(matches(*it))
+                m_view.push_back(*it);
+        }
+    } else {
+        for(uint32 row : order) {
+            if(matches(row))
+                m_view.push_back(row);
+        }
+    }
+    m_validView = true;
+    return m_view;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef MARKETOFFERSTORE_H
+#define MARKETOFFERSTORE_H
+
+#include "declarations.h"
+#include <framework/luaengine/luaobject.h>
+#include <framework/net/declarations.h>
+
+// an offer as handed to lua
+struct MarketOfferRow {
+    uint32 timestamp;
+    uint16 counter;
+    uint16 itemId;
+    uint16 amount;
+    uint32 price;
+    uint8 state;
+    std::string player;
+};
+
+// The offers of one side of a market browse, kept column by column. The order of each sort column is built once
+// and kept up to date through accepted and cancelled offers, filters are applied over the active order and lua
+// only receives the rows of the page it shows
+class MarketOfferStore : public LuaObject
+{
+public:
+    enum SortColumn {
+        SortPrice,
+        SortAmount,
+        SortTotalPrice,
+        SortTimestamp,
+        SortPlayer,
+        SORT_COLUMNS
+    };
+
+    // reads a count and that many offers as the server sends them in a browse of var
+    uint readOffers(const InputMessagePtr& msg, uint16 var);
+    // replaces an offer with the same timestamp and counter
+    void addOffer(uint32 timestamp, uint16 counter, uint16 itemId, uint16 amount, uint32 price, const std::string& player, uint8 state);
+    bool removeOffer(uint32 timestamp, uint16 counter);
+    // offers left without amount are removed
+    bool setOfferAmount(uint32 timestamp, uint16 counter, uint16 amount);
+    void clear();
+
+    void setSorting(int column, bool descending);
+    void setPriceRange(uint32 minPrice, uint32 maxPrice);
+    void setAmountRange(uint16 minAmount, uint16 maxAmount);
+    // 0 shows every item
+    void setItemFilter(uint16 itemId);
+
+    int getSortColumn() { return m_sortColumn; }
+    bool isSortDescending() { return m_descending; }
+
+    // offers that pass the filters, in the current order
+    int getOfferCount();
+    int getTotalCount() { return m_rows.size(); }
+    // the offers from position first, 1 based as lua lists are
+    std::vector<MarketOfferRow> getPage(int first, int count);
+    bool hasOffer(uint32 timestamp, uint16 counter) { return m_rows.find(makeId(timestamp, counter)) != m_rows.end(); }
+    MarketOfferRow getOffer(uint32 timestamp, uint16 counter);
+
+private:
+    static uint64 makeId(uint32 timestamp, uint16 counter) { return static_cast<uint64>(timestamp) << 16 | counter; }
+
+    uint32 appendRow(uint32 timestamp, uint16 counter, uint16 itemId, uint16 amount, uint32 price, const std::string& player, uint8 state);
+    bool less(int column, uint32 a, uint32 b) const;
+    bool matches(uint32 row) const;
+    MarketOfferRow getRow(uint32 row) const;
+
+    void insertOrdered(int column, uint32 row);
+    void eraseOrdered(int column, uint32 row);
+    const std::vector<uint32>& getOrder(int column);
+    const std::vector<uint32>& getView();
+
+    // one entry per row, rows of removed offers are left unreferenced until the store is cleared
+    std::vector<uint32> m_timestamps, m_prices;
+    std::vector<uint16> m_counters, m_itemIds, m_amounts;
+    std::vector<uint8> m_states;
+    std::vector<std::string> m_players;
+    stdext::flat_hash_map<uint64, uint32> m_rows;
+
+    // live rows in ascending order of each column, rebuilt only when a whole browse was read
+    std::array<std::vector<uint32>, SORT_COLUMNS> m_orders;
+    std::array<bool, SORT_COLUMNS> m_validOrders{};
+    std::vector<uint32> m_view;
+    bool m_validView{ false };
+
+    int m_sortColumn{ SortPrice };
+    bool m_descending{ false };
+    uint32 m_minPrice{ 0 }, m_maxPrice{ UINT32_MAX };
+    uint16 m_minAmount{ 0 }, m_maxAmount{ UINT16_MAX };
+    uint16 m_itemFilter{ 0 };
+};
+
+#endif
@@ -24,6 +24,8 @@
 #include "tile.h"
 
 #include <zlib.h>
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/eventdispatcher.h>
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/framebuffermanager.h>
@@ -35,11 +37,54 @@
 
 Minimap g_minimap;
 
+namespace {
+    uint32 g_pathRevisions = 0;
+
+    bool isPathFlagsChange(const MinimapTile& a, const MinimapTile& b)
+    {
+        const uint8 pathFlags = MinimapTileWasSeen | MinimapTileNotPathable | MinimapTileNotWalkable;
+        return (a.flags & pathFlags) != (b.flags & pathFlags) || a.speed != b.speed || (a.color == 255) != (b.color == 255);
+    }
+
+    // runs on worker threads too, so it only touches its arguments
+    MinimapBlock::TileArrayPtr decompressTiles(const MinimapBlock::DataPtr& data, uint offset, uint size)
+    {
+        MinimapBlock::TileArrayPtr tiles = std::make_shared<MinimapBlock::TileArray>();
+        ulong destLen = sizeof(MinimapBlock::TileArray);
+        const int ret = uncompress(reinterpret_cast<uchar*>(tiles->data()), &destLen, data->data() + offset, size);
+        if(ret != Z_OK || destLen != sizeof(MinimapBlock::TileArray))
+            return nullptr;
+        return tiles;
+    }
+
+    // position, position and compressed size before the tiles of every block in the OTMM file
+    const uint OTMM_RECORD_HEADER_SIZE = 7;
+    // block data is copied in chunks of this size instead of one file write per field
+    const uint OTMM_WRITE_BUFFER_SIZE = 256 * 1024;
+
+    // tiles are uploaded from here, one buffer does for all blocks since uploads happen one at a time
+    std::array<uint32, MMBLOCK_SIZE * MMBLOCK_SIZE> g_stagingPixels;
+
+    const std::array<uint32, 256>& getPalette()
+    {
+        static const std::array<uint32, 256> palette = [] {
+            std::array<uint32, 256> colors;
+            for(int c = 0; c < 256; ++c)
+                colors[c] = c != UINT8_MAX ? Color::from8bit(c).rgba() : Color::alpha.rgba();
+            return colors;
+        }();
+        return palette;
+    }
+}
+
 void MinimapBlock::clean()
 {
-    m_tiles.fill(MinimapTile());
+    m_tiles.reset();
+    m_compressedData.reset();
+    m_prefetch = std::shared_future<TileArrayPtr>();
     m_texture.reset();
     m_mustUpdate = false;
+    mustUpdatePaths();
 }
 
 void MinimapBlock::update()
@@ -47,40 +92,98 @@ void MinimapBlock::update()
     if(!m_mustUpdate)
         return;
 
-    ImagePtr image(new Image(Size(MMBLOCK_SIZE, MMBLOCK_SIZE)));
-
-    bool shouldDraw = false;
-    for(int x = 0; x < MMBLOCK_SIZE; ++x) {
-        for(int y = 0; y < MMBLOCK_SIZE; ++y) {
-            const uint8 c = getTile(x, y).color;
-            uint32 col;
-            if(c != UINT8_MAX) {
-                col = Color::from8bit(c).rgba();
-                shouldDraw = true;
-            } else
-                col = Color::alpha.rgba();
-            image->setPixel(x, y, col);
-        }
+    const std::array<uint32, 256>& palette = getPalette();
+    const TileArray& tiles = getTiles();
+
+    // an existing texture only gets the changed rows, a new one is only made if something shows
+    const int top = m_texture ? m_dirtyTop : 0;
+    const int bottom = m_texture ? m_dirtyBottom : MMBLOCK_SIZE - 1;
+    bool shouldDraw = m_texture != nullptr;
+    uint32* pixels = g_stagingPixels.data();
+    for(int i = top * MMBLOCK_SIZE, end = (bottom + 1) * MMBLOCK_SIZE; i < end; ++i) {
+        const uint8 c = tiles[i].color;
+        shouldDraw |= c != UINT8_MAX;
+        *pixels++ = palette[c];
     }
 
     if(shouldDraw) {
-        if(!m_texture) {
-            m_texture = TexturePtr(new Texture(image, true));
-        } else {
-            m_texture->uploadPixels(image, true);
-        }
-    } else
-        m_texture.reset();
+        if(!m_texture)
+            m_texture = TexturePtr(new Texture(Size(MMBLOCK_SIZE, MMBLOCK_SIZE)));
+        m_texture->uploadSubPixels(Point(0, top), Size(MMBLOCK_SIZE, bottom - top + 1), reinterpret_cast<uchar*>(g_stagingPixels.data()));
+    }
 
     m_mustUpdate = false;
 }
 
-void MinimapBlock::updateTile(int x, int y, const MinimapTile& tile)
+void MinimapBlock::mustUpdate(int top, int bottom)
 {
-    if(m_tiles[getTileIndex(x, y)].color != tile.color)
-        m_mustUpdate = true;
+    if(m_mustUpdate) {
+        m_dirtyTop = std::min<int>(m_dirtyTop, top);
+        m_dirtyBottom = std::max<int>(m_dirtyBottom, bottom);
+    } else {
+        m_dirtyTop = top;
+        m_dirtyBottom = bottom;
+    }
+    m_mustUpdate = true;
+}
 
-    m_tiles[getTileIndex(x, y)] = tile;
+bool MinimapBlock::updateTile(int x, int y, const MinimapTile& tile)
+{
+    MinimapTile& current = getTile(x, y);
+    const bool colorChange = current.color != tile.color;
+    if(colorChange)
+        mustUpdate(y % MMBLOCK_SIZE, y % MMBLOCK_SIZE);
+
+    if(isPathFlagsChange(current, tile))
+        mustUpdatePaths();
+
+    if(current != tile)
+        mustSave();
+    current = tile;
+    return colorChange;
+}
+
+void MinimapBlock::mustUpdatePaths()
+{
+    m_pathRevision = ++g_pathRevisions;
+}
+
+void MinimapBlock::setCompressedTiles(const DataPtr& data, uint offset, uint size)
+{
+    m_tiles.reset();
+    m_prefetch = std::shared_future<TileArrayPtr>();
+    m_compressedData = data;
+    m_compressedOffset = offset;
+    m_compressedSize = size;
+    mustUpdate();
+}
+
+void MinimapBlock::prefetch()
+{
+    if(!isCompressed() || m_prefetch.valid())
+        return;
+
+    const DataPtr data = m_compressedData;
+    const uint offset = m_compressedOffset, size = m_compressedSize;
+    m_prefetch = g_asyncDispatcher.schedule([data, offset, size] { return decompressTiles(data, offset, size); }, AsyncDispatcher::PriorityLow);
+}
+
+void MinimapBlock::load()
+{
+    if(m_prefetch.valid()) {
+        m_tiles = m_prefetch.get();
+        m_prefetch = std::shared_future<TileArrayPtr>();
+    } else if(m_compressedData)
+        m_tiles = decompressTiles(m_compressedData, m_compressedOffset, m_compressedSize);
+
+    if(!m_tiles) {
+        if(m_compressedData)
+            g_logger.error("failed to decompress OTMM minimap block");
+        m_tiles = std::make_shared<TileArray>();
+    }
+
+    m_compressedData.reset();
+    mustUpdate();
 }
 
 void Minimap::init()
@@ -89,13 +192,29 @@ void Minimap::init()
 
 void Minimap::terminate()
 {
+    setAutoSave(std::string(), 0);
     clean();
 }
 
 void Minimap::clean()
 {
-    for(int i = 0; i <= Otc::MAX_Z; ++i)
+    // a save in progress still reads the blocks it snapshotted and updates the saved sizes
+    if(m_otmmSave) {
+        try {
+            commitOtmmSave(true);
+        } catch(std::exception& e) {
+            g_logger.error(stdext::format("failed to save OTMM minimap: %s", e.what()));
+        }
+        m_otmmSave = nullptr;
+    }
+    m_otmmFile.clear();
+    m_otmmFileBytes = m_otmmLiveBytes = 0;
+
+    for(int i = 0; i <= Otc::MAX_Z; ++i) {
         m_tileBlocks[i].clear();
+        for(auto& nodes : m_pyramid[i])
+            nodes.clear();
+    }
 }
 
 void Minimap::draw(const Rect& screenRect, const Position& mapCenter, float scale, const Color& color)
@@ -110,30 +229,38 @@ void Minimap::draw(const Rect& screenRect, const Position& mapCenter, float scal
         return;
     }
 
-    const Point blockOff = getBlockOffset(mapRect.topLeft());
+    // zoomed out views draw merged nodes, so the draw count only depends on the screen size
+    const int level = getPyramidLevel(scale);
+    const int nodeSize = MMBLOCK_SIZE << level;
+    const Point blockOff(mapRect.left() - mapRect.left() % nodeSize, mapRect.top() - mapRect.top() % nodeSize);
     const Point off = Point((mapRect.size() * scale).toPoint() - screenRect.size().toPoint()) / 2;
     const Point start = screenRect.topLeft() - (mapRect.topLeft() - blockOff) * scale - off;
 
     g_drawPool.setClipRect(screenRect);
-    for(int y = blockOff.y, ys = start.y; ys < screenRect.bottom(); y += MMBLOCK_SIZE, ys += MMBLOCK_SIZE * scale) {
+    for(int y = blockOff.y, ys = start.y; ys < screenRect.bottom(); y += nodeSize, ys += nodeSize * scale) {
         if(y < 0 || y >= 65536)
             continue;
 
-        for(int x = blockOff.x, xs = start.x; xs < screenRect.right(); x += MMBLOCK_SIZE, xs += MMBLOCK_SIZE * scale) {
+        for(int x = blockOff.x, xs = start.x; xs < screenRect.right(); x += nodeSize, xs += nodeSize * scale) {
             if(x < 0 || x >= 65536)
                 continue;
 
-            Position blockPos(x, y, mapCenter.z);
-            if(!hasBlock(blockPos))
-                continue;
+            TexturePtr tex;
+            if(level > 0)
+                tex = getPyramidTexture(x, y, mapCenter.z, level);
+            else {
+                Position blockPos(x, y, mapCenter.z);
+                if(!hasBlock(blockPos))
+                    continue;
 
-            MinimapBlock& block = getBlock(Position(x, y, mapCenter.z));
-            block.update();
+                MinimapBlock& block = getBlock(blockPos);
+                block.update();
+                tex = block.getTexture();
+            }
 
-            const TexturePtr& tex = block.getTexture();
             if(tex) {
                 Rect src(0, 0, MMBLOCK_SIZE, MMBLOCK_SIZE);
-                Rect dest(Point(xs, ys), src.size() * scale);
+                Rect dest(Point(xs, ys), Size(nodeSize, nodeSize) * scale);
 
                 tex->setSmooth(scale < 1.0f);
                 g_drawPool.addTexturedRect(dest, tex, src);
@@ -141,6 +268,123 @@ void Minimap::draw(const Rect& screenRect, const Position& mapCenter, float scal
         }
     }
     g_drawPool.resetClipRect();
+
+    if(level == 0)
+        prefetchBlocks(mapRect, mapCenter.z);
+}
+
+void Minimap::prefetchBlocks(const Rect& mapRect, int z)
+{
+    // blocks one step outside the view are decompressed in background, so panning does not stall
+    const Point topLeft = getBlockOffset(Point(std::max<int>(mapRect.left() - MMBLOCK_SIZE, 0), std::max<int>(mapRect.top() - MMBLOCK_SIZE, 0)));
+    const Point bottomRight(std::min<int>(mapRect.right() + MMBLOCK_SIZE, 65535), std::min<int>(mapRect.bottom() + MMBLOCK_SIZE, 65535));
+    for(int y = topLeft.y; y <= bottomRight.y; y += MMBLOCK_SIZE) {
+        for(int x = topLeft.x; x <= bottomRight.x; x += MMBLOCK_SIZE) {
+            const auto it = m_tileBlocks[z].find(getBlockIndex(Position(x, y, z)));
+            if(it != m_tileBlocks[z].end())
+                it->second.prefetch();
+        }
+    }
+}
+
+void Minimap::invalidatePyramid(const Position& pos)
+{
+    // nodes are rebuilt when drawn, creating them here also records which ones have content
+    for(int level = 1; level <= MMPYRAMID_LEVELS; ++level) {
+        MinimapPyramidNode& node = m_pyramid[pos.z][level - 1][getPyramidIndex(pos.x, pos.y, level)];
+        node.imageDirty = true;
+        node.textureDirty = true;
+    }
+}
+
+ImagePtr Minimap::getPyramidImage(int x, int y, int z, int level)
+{
+    const auto it = m_pyramid[z][level - 1].find(getPyramidIndex(x, y, level));
+    if(it == m_pyramid[z][level - 1].end())
+        return nullptr;
+
+    // level 1 images are cheap to make from the blocks and would be the most memory, they are not kept
+    MinimapPyramidNode& node = it->second;
+    if(!node.imageDirty && level > 1)
+        return node.image;
+
+    ImagePtr image(new Image(Size(MMBLOCK_SIZE, MMBLOCK_SIZE)));
+    bool shouldDraw = false;
+    const int half = MMBLOCK_SIZE / 2;
+    const int childSize = (MMBLOCK_SIZE << level) / 2;
+    for(int quadrant = 0; quadrant < 4; ++quadrant) {
+        const int childX = x - x % (MMBLOCK_SIZE << level) + (quadrant % 2) * childSize;
+        const int childY = y - y % (MMBLOCK_SIZE << level) + (quadrant / 2) * childSize;
+
+        const MinimapTile* tiles = nullptr;
+        ImagePtr childImage;
+        if(level == 1) {
+            const Position blockPos(childX, childY, z);
+            if(!hasBlock(blockPos))
+                continue;
+            tiles = getBlock(blockPos).getTiles().data();
+        } else {
+            childImage = getPyramidImage(childX, childY, z, level - 1);
+            if(!childImage)
+                continue;
+        }
+
+        // each pixel averages the 2x2 visible pixels below it
+        for(int py = 0; py < half; ++py) {
+            for(int px = 0; px < half; ++px) {
+                int r = 0, g = 0, b = 0, count = 0;
+                for(int i = 0; i < 4; ++i) {
+                    const int sx = px * 2 + i % 2, sy = py * 2 + i / 2;
+                    if(tiles && tiles[sy * MMBLOCK_SIZE + sx].color == UINT8_MAX)
+                        continue;
+
+                    const Color color(tiles ? getPalette()[tiles[sy * MMBLOCK_SIZE + sx].color] : *reinterpret_cast<uint32*>(childImage->getPixel(sx, sy)));
+                    if(color.aF() == 0.0f)
+                        continue;
+                    r += color.r();
+                    g += color.g();
+                    b += color.b();
+                    ++count;
+                }
+
+                if(count == 0)
+                    continue;
+
+                image->setPixel((quadrant % 2) * half + px, (quadrant / 2) * half + py, Color(r / count, g / count, b / count).rgba());
+                shouldDraw = true;
+            }
+        }
+    }
+
+    if(!shouldDraw)
+        image = nullptr;
+
+    node.imageDirty = false;
+    if(level > 1)
+        node.image = image;
+    return image;
+}
+
+const TexturePtr& Minimap::getPyramidTexture(int x, int y, int z, int level)
+{
+    static TexturePtr nullTexture;
+    const auto it = m_pyramid[z][level - 1].find(getPyramidIndex(x, y, level));
+    if(it == m_pyramid[z][level - 1].end())
+        return nullTexture;
+
+    MinimapPyramidNode& node = it->second;
+    if(node.textureDirty) {
+        const ImagePtr image = getPyramidImage(x, y, z, level);
+        if(!image)
+            node.texture.reset();
+        else if(!node.texture)
+            node.texture = TexturePtr(new Texture(image, true));
+        else
+            node.texture->uploadPixels(image, true);
+        node.textureDirty = false;
+    }
+
+    return node.texture;
 }
 
 Point Minimap::getTilePoint(const Position& pos, const Rect& screenRect, const Position& mapCenter, float scale)
@@ -202,7 +446,8 @@ void Minimap::updateTile(const Position& pos, const TilePtr& tile)
     if(minimapTile != MinimapTile()) {
         MinimapBlock& block = getBlock(pos);
         const Point offsetPos = getBlockOffset(Point(pos.x, pos.y));
-        block.updateTile(pos.x - offsetPos.x, pos.y - offsetPos.y, minimapTile);
+        if(block.updateTile(pos.x - offsetPos.x, pos.y - offsetPos.y, minimapTile))
+            invalidatePyramid(pos);
         block.justSaw();
     }
 }
@@ -284,6 +529,9 @@ bool Minimap::loadImage(const std::string& fileName, const Position& topLeft, fl
                     tile.color = c;
                     tile.flags = flags;
                     block.mustUpdate();
+                    block.mustUpdatePaths();
+                    block.mustSave();
+                    invalidatePyramid(pos);
                 }
             }
         }
@@ -308,6 +556,9 @@ bool Minimap::loadOtmm(const std::string& fileName)
 
         fin->cache();
 
+        // blocks keep pointing into one copy of the file and are decompressed when touched
+        const MinimapBlock::DataPtr data = std::make_shared<std::vector<uchar>>(fin->cachedData(), fin->cachedData() + fin->cachedSize());
+
         const uint32 signature = fin->getU32();
         if(signature != OTMM_SIGNATURE)
             stdext::throw_exception("invalid OTMM file");
@@ -328,34 +579,45 @@ bool Minimap::loadOtmm(const std::string& fileName)
 
         fin->seek(start);
 
-        const uint blockSize = MMBLOCK_SIZE * MMBLOCK_SIZE * sizeof(MinimapTile);
-        std::vector<uchar> compressBuffer(compressBound(blockSize));
-        std::vector<uchar> decompressBuffer(blockSize);
-
-        while(true) {
+        // later records of a block replace earlier ones, saves append the blocks that changed
+        uint fileBytes = 0;
+        while(fin->tell() + OTMM_RECORD_HEADER_SIZE <= data->size()) {
             Position pos;
             pos.x = fin->getU16();
             pos.y = fin->getU16();
             pos.z = fin->getU8();
 
+            // full saves end with an invalid position, records appended after it are still read
+            if(!pos.isValid() && fin->tell() + OTMM_RECORD_HEADER_SIZE <= data->size())
+                continue;
+
             // end of file or file is corrupted
             if(!pos.isValid() || pos.z >= Otc::MAX_Z + 1)
                 break;
 
-            MinimapBlock& block = getBlock(pos);
-            const ulong len = fin->getU16();
-            ulong destLen = blockSize;
-            fin->read(compressBuffer.data(), len);
-            const int ret = uncompress(decompressBuffer.data(), &destLen, compressBuffer.data(), len);
-            if(ret != Z_OK || destLen != blockSize)
+            const uint len = fin->getU16();
+            const uint offset = fin->tell();
+            if(offset + len > data->size())
                 break;
+            fin->skip(len);
 
-            memcpy((uchar*)&block.getTiles(), decompressBuffer.data(), blockSize);
-            block.mustUpdate();
+            MinimapBlock& block = getBlock(pos);
+            block.setCompressedTiles(data, offset, len);
+            block.markSaved();
+            setBlockSavedSize(block, OTMM_RECORD_HEADER_SIZE + len);
+            fileBytes += OTMM_RECORD_HEADER_SIZE + len;
+            block.mustUpdatePaths();
+            invalidatePyramid(pos);
             block.justSaw();
         }
 
         fin->close();
+
+        if(m_otmmFile != fileName) {
+            m_otmmFile = fileName;
+            m_otmmFileBytes = 0;
+        }
+        m_otmmFileBytes += fileBytes;
         return true;
     } catch(stdext::exception& e) {
         g_logger.error(stdext::format("failed to load OTMM minimap: %s", e.what()));
@@ -366,63 +628,221 @@ bool Minimap::loadOtmm(const std::string& fileName)
 void Minimap::saveOtmm(const std::string& fileName)
 {
     try {
-        stdext::timer saveTimer;
+        // an autosave in progress may not hold the latest changes, they go in another append
+        if(m_otmmSave) {
+            const std::shared_ptr<OtmmSave> save = m_otmmSave;
+            commitOtmmSave(true);
+            if(m_otmmSave == save)
+                m_otmmSave = nullptr;
+        }
 
-        FileStreamPtr fin = g_resources.createFile(fileName);
-        fin->cache();
+        if(!startOtmmSave(fileName, false))
+            return;
+
+        const std::shared_ptr<OtmmSave> save = m_otmmSave;
+        commitOtmmSave(true);
+        if(m_otmmSave == save)
+            m_otmmSave = nullptr;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("failed to save OTMM minimap: %s", e.what()));
+        m_otmmSave = nullptr;
+    }
+}
+
+void Minimap::setAutoSave(const std::string& fileName, int interval)
+{
+    if(m_autoSaveEvent) {
+        m_autoSaveEvent->cancel();
+        m_autoSaveEvent = nullptr;
+    }
+
+    if(interval <= 0)
+        return;
+
+    m_autoSaveEvent = g_dispatcher.cycleEvent([this, fileName] {
+        if(!m_otmmSave)
+            startOtmmSave(fileName, true);
+    }, interval);
+}
+
+bool Minimap::startOtmmSave(const std::string& fileName, bool async)
+{
+    // blocks are snapshotted here, the main thread only copies the tiles of the changed ones,
+    // workers compress them and write the file
+    const std::shared_ptr<OtmmSave> save = std::make_shared<OtmmSave>();
+    save->fileName = fileName;
+    save->append = fileName == m_otmmFile && m_otmmFileBytes <= 2 * m_otmmLiveBytes && g_resources.fileExists(fileName);
+
+    try {
+        save->file = save->append ? g_resources.appendFile(fileName) : g_resources.createFile(fileName);
+        if(!save->file)
+            stdext::throw_exception(stdext::format("failed to open file '%s' for write", fileName));
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("failed to save OTMM minimap: %s", e.what()));
+        return false;
+    }
 
+    if(!save->append) {
         //TODO: compression flag with zlib
         const uint32 flags = 0;
+        const std::string description = "OTMM 1.0";
+        const uint16 start = 4 + 2 + 2 + 4 + 2 + description.size();
+
+        // header, then the version 1 header
+        save->header.resize(start);
+        uchar* header = save->header.data();
+        stdext::writeULE32(header, OTMM_SIGNATURE);
+        stdext::writeULE16(header + 4, start);
+        stdext::writeULE16(header + 6, OTMM_VERSION);
+        stdext::writeULE32(header + 8, flags);
+        stdext::writeULE16(header + 12, description.size());
+        memcpy(header + 14, description.data(), description.size());
+    }
 
-        // header
-        fin->addU32(OTMM_SIGNATURE);
-        fin->addU16(0); // data start, will be overwritten later
-        fin->addU16(OTMM_VERSION);
-        fin->addU32(flags);
+    for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
+        for(auto& it : m_tileBlocks[z]) {
+            MinimapBlock& block = it.second;
+            if(!block.wasSeen() || (save->append && !block.isUnsaved()))
+                continue;
 
-        // version 1 header
-        fin->addString("OTMM 1.0"); // description
+            OtmmRecord record;
+            record.pos = getIndexPosition(it.first, z);
+
+            // untouched blocks are written back as they were loaded
+            if(block.isCompressed()) {
+                record.data = block.getCompressedData();
+                record.offset = block.getCompressedOffset();
+                record.size = block.getCompressedSize();
+            } else {
+                const auto tiles = std::make_shared<const MinimapBlock::TileArray>(block.getTiles());
+                record.compressed = g_asyncDispatcher.schedule([tiles] {
+                    const int COMPRESS_LEVEL = 3;
+                    ulong len = compressBound(sizeof(MinimapBlock::TileArray));
+                    std::vector<uchar> compressed(len);
+                    const int ret = compress2(compressed.data(), &len, reinterpret_cast<const uchar*>(tiles->data()), sizeof(MinimapBlock::TileArray), COMPRESS_LEVEL);
+                    if(ret != Z_OK)
+                        stdext::throw_exception("failed to compress minimap block");
+                    compressed.resize(len);
+                    return compressed;
+                }, AsyncDispatcher::PriorityLow);
+            }
 
-        // go back and rewrite where the map data starts
-        const uint32 start = fin->tell();
-        fin->seek(4);
-        fin->addU16(start);
-        fin->seek(start);
+            block.markSaved();
+            save->records.push_back(std::move(record));
+        }
+    }
 
-        const uint blockSize = MMBLOCK_SIZE * MMBLOCK_SIZE * sizeof(MinimapTile);
-        std::vector<uchar> compressBuffer(compressBound(blockSize));
-        const int COMPRESS_LEVEL = 3;
+    m_otmmSave = save;
+    if(async)
+        g_dispatcher.scheduleEvent([this] { processOtmmSave(); }, 0);
+    return true;
+}
 
-        for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
-            for(auto& it : m_tileBlocks[z]) {
-                const int index = it.first;
-                MinimapBlock& block = it.second;
-                if(!block.wasSeen())
-                    continue;
+bool Minimap::commitOtmmSave(bool wait)
+{
+    const std::shared_ptr<OtmmSave> save = m_otmmSave;
+    const auto isReady = [wait](const auto& future) { return wait || future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
 
-                const Position pos = getIndexPosition(index, z);
-                fin->addU16(pos.x);
-                fin->addU16(pos.y);
-                fin->addU8(pos.z);
+    if(!save->write.valid()) {
+        for(const OtmmRecord& record : save->records) {
+            if(record.compressed.valid() && !isReady(record.compressed))
+                return false;
+        }
 
-                ulong len = blockSize;
-                const int ret = compress2(compressBuffer.data(), &len, (uchar*)&block.getTiles(), blockSize, COMPRESS_LEVEL);
-                assert(ret == Z_OK);
-                fin->addU16(len);
-                fin->write(compressBuffer.data(), len);
+        // the save stays referenced until the write is done, the worker only borrows it
+        FileStream* file = save->file.get();
+        const OtmmSave* job = save.get();
+        save->write = g_asyncDispatcher.schedule([file, job] {
+            std::vector<uchar> buffer;
+            buffer.reserve(OTMM_WRITE_BUFFER_SIZE);
+            const auto append = [&](const uchar* bytes, uint count) {
+                if(buffer.size() + count > OTMM_WRITE_BUFFER_SIZE) {
+                    file->write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+                buffer.insert(buffer.end(), bytes, bytes + count);
+            };
+
+            append(job->header.data(), job->header.size());
+            for(const OtmmRecord& record : job->records) {
+                const uchar* tiles = record.data ? record.data->data() + record.offset : record.compressed.get().data();
+                const uint size = record.data ? record.size : record.compressed.get().size();
+
+                uchar header[OTMM_RECORD_HEADER_SIZE];
+                stdext::writeULE16(header, record.pos.x);
+                stdext::writeULE16(header + 2, record.pos.y);
+                header[4] = record.pos.z;
+                stdext::writeULE16(header + 5, size);
+                append(header, OTMM_RECORD_HEADER_SIZE);
+                append(tiles, size);
             }
+
+            // end of file, appends come after it
+            if(!job->append) {
+                const uchar end[5] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+                append(end, sizeof(end));
+            }
+
+            file->write(buffer.data(), buffer.size());
+            file->flush();
+            file->close();
+        }, AsyncDispatcher::PriorityLow);
+    }
+
+    if(!isReady(save->write))
+        return false;
+
+    try {
+        save->write.get();
+    } catch(...) {
+        // the snapshotted blocks were marked as saved, the next save writes every block again
+        m_otmmFile.clear();
+        throw;
+    }
+
+    if(!save->append || m_otmmFile != save->fileName) {
+        m_otmmFile = save->fileName;
+        m_otmmFileBytes = m_otmmLiveBytes = 0;
+        for(auto& blocks : m_tileBlocks) {
+            for(auto& it : blocks)
+                it.second.setSavedSize(0);
         }
+    }
 
-        // end of file
-        const Position invalidPos;
-        fin->addU16(invalidPos.x);
-        fin->addU16(invalidPos.y);
-        fin->addU8(invalidPos.z);
+    for(const OtmmRecord& record : save->records) {
+        const uint size = OTMM_RECORD_HEADER_SIZE + (record.data ? record.size : record.compressed.get().size());
+        m_otmmFileBytes += size;
+        if(hasBlock(record.pos))
+            setBlockSavedSize(getBlock(record.pos), size);
+    }
+    return true;
+}
 
-        fin->flush();
+void Minimap::processOtmmSave()
+{
+    const std::shared_ptr<OtmmSave> save = m_otmmSave;
+    if(!save)
+        return;
 
-        fin->close();
-    } catch(stdext::exception& e) {
+    bool finished;
+    try {
+        finished = commitOtmmSave(false);
+    } catch(std::exception& e) {
         g_logger.error(stdext::format("failed to save OTMM minimap: %s", e.what()));
+        finished = true;
+    }
+
+    if(finished) {
+        if(m_otmmSave == save)
+            m_otmmSave = nullptr;
+        return;
     }
+
+    g_dispatcher.scheduleEvent([this] { processOtmmSave(); }, 1);
+}
+
+void Minimap::setBlockSavedSize(MinimapBlock& block, uint size)
+{
+    m_otmmLiveBytes += size - block.getSavedSize();
+    block.setSavedSize(size);
 }
@@ -23,11 +23,15 @@
 #ifndef MINIMAP_H
 #define MINIMAP_H
 
+#include <framework/core/declarations.h>
 #include <framework/graphics/declarations.h>
 #include "declarations.h"
 
+#include <future>
+
 enum {
     MMBLOCK_SIZE = 64,
+    MMPYRAMID_LEVELS = 5,
     OTMM_SIGNATURE = 0x4D4d544F,
     OTMM_VERSION = 1
 };
@@ -51,28 +55,77 @@ struct MinimapTile
     bool operator!=(const MinimapTile& other) const { return !(*this == other); }
 };
 
+#pragma pack(pop)
+
 class MinimapBlock
 {
 public:
+    using TileArray = std::array<MinimapTile, MMBLOCK_SIZE* MMBLOCK_SIZE>;
+    using TileArrayPtr = std::shared_ptr<TileArray>;
+    using DataPtr = std::shared_ptr<const std::vector<uchar>>;
+
     void clean();
     void update();
-    void updateTile(int x, int y, const MinimapTile& tile);
-    MinimapTile& getTile(int x, int y) { return m_tiles[getTileIndex(x, y)]; }
-    void resetTile(int x, int y) { m_tiles[getTileIndex(x, y)] = MinimapTile(); }
+    // returns whether the tile color changed
+    bool updateTile(int x, int y, const MinimapTile& tile);
+    MinimapTile& getTile(int x, int y) { return getTiles()[getTileIndex(x, y)]; }
+    void resetTile(int x, int y) { getTiles()[getTileIndex(x, y)] = MinimapTile(); mustSave(); }
     uint getTileIndex(int x, int y) { return ((y % MMBLOCK_SIZE) * MMBLOCK_SIZE) + (x % MMBLOCK_SIZE); }
     const TexturePtr& getTexture() { return m_texture; }
-    std::array<MinimapTile, MMBLOCK_SIZE* MMBLOCK_SIZE>& getTiles() { return m_tiles; }
-    void mustUpdate() { m_mustUpdate = true; }
+    // decompresses the block on first use
+    TileArray& getTiles() { if(!m_tiles) load(); return *m_tiles; }
+    void mustUpdate() { mustUpdate(0, MMBLOCK_SIZE - 1); }
+    // only the tile rows from top to bottom get uploaded again
+    void mustUpdate(int top, int bottom);
     void justSaw() { m_wasSeen = true; }
     bool wasSeen() { return m_wasSeen; }
+    // blocks changed since they were loaded from or written to the OTMM file are appended on the next save
+    void mustSave() { m_unsaved = true; }
+    void markSaved() { m_unsaved = false; }
+    bool isUnsaved() { return m_unsaved; }
+    // bytes taken by the latest record of this block in the OTMM file
+    void setSavedSize(uint size) { m_savedSize = size; }
+    uint getSavedSize() { return m_savedSize; }
+    // bumped whenever the walkability of any tile changes, never repeats between blocks
+    void mustUpdatePaths();
+    uint32 getPathRevision() const { return m_pathRevision; }
+
+    // tiles stay zlib compressed inside data until the block is touched
+    void setCompressedTiles(const DataPtr& data, uint offset, uint size);
+    bool isCompressed() { return !m_tiles && m_compressedData; }
+    const uchar* getCompressedTiles() { return m_compressedData->data() + m_compressedOffset; }
+    const DataPtr& getCompressedData() { return m_compressedData; }
+    uint getCompressedOffset() { return m_compressedOffset; }
+    uint getCompressedSize() { return m_compressedSize; }
+    // decompresses on a worker thread, the result is picked up when the tiles are needed
+    void prefetch();
+
 private:
+    void load();
+
     TexturePtr m_texture;
-    std::array<MinimapTile, MMBLOCK_SIZE* MMBLOCK_SIZE> m_tiles;
+    TileArrayPtr m_tiles;
+    DataPtr m_compressedData;
+    uint m_compressedOffset{ 0 };
+    uint m_compressedSize{ 0 };
+    std::shared_future<TileArrayPtr> m_prefetch;
     stdext::boolean<true> m_mustUpdate;
     stdext::boolean<false> m_wasSeen;
+    stdext::boolean<true> m_unsaved;
+    uint m_savedSize{ 0 };
+    int m_dirtyTop{ 0 };
+    int m_dirtyBottom{ MMBLOCK_SIZE - 1 };
+    uint32 m_pathRevision{ 0 };
 };
 
-#pragma pack(pop)
+// one texture downsampled from 2x2 nodes of the level below, level 1 merges 2x2 blocks
+struct MinimapPyramidNode
+{
+    ImagePtr image;
+    TexturePtr texture;
+    bool imageDirty{ true };
+    bool textureDirty{ true };
+};
 
 class Minimap
 {
@@ -89,14 +142,54 @@ public:
 
     void updateTile(const Position& pos, const TilePtr& tile);
     const MinimapTile& getTile(const Position& pos);
+    // revision of the block holding pos, 0 when the block does not exist
+    uint32 getPathRevision(const Position& pos) { return pos.z <= Otc::MAX_Z && hasBlock(pos) ? getBlock(pos).getPathRevision() : 0; }
 
     bool loadImage(const std::string& fileName, const Position& topLeft, float colorFactor);
     void saveImage(const std::string& fileName, const Rect& mapRect);
     bool loadOtmm(const std::string& fileName);
+    // appends the blocks changed since the file was last loaded or saved, the file is rewritten
+    // when it is another file or when superseded records take more space than the current ones
     void saveOtmm(const std::string& fileName);
+    // saves like saveOtmm every interval milliseconds without waiting for it, 0 disables it
+    void setAutoSave(const std::string& fileName, int interval);
+    bool isSavingOtmm() { return m_otmmSave != nullptr; }
 
 private:
+    struct OtmmRecord {
+        Position pos;
+        // blocks never touched since loading are written back from the loaded data
+        MinimapBlock::DataPtr data;
+        uint offset, size;
+        std::shared_future<std::vector<uchar>> compressed;
+    };
+
+    struct OtmmSave {
+        std::string fileName;
+        FileStreamPtr file;
+        bool append;
+        std::vector<uchar> header;
+        std::vector<OtmmRecord> records;
+        std::shared_future<void> write;
+    };
+
+    bool startOtmmSave(const std::string& fileName, bool async);
+    bool commitOtmmSave(bool wait);
+    void processOtmmSave();
+    void setBlockSavedSize(MinimapBlock& block, uint size);
+
     Rect calcMapRect(const Rect& screenRect, const Position& mapCenter, float scale);
+    void prefetchBlocks(const Rect& mapRect, int z);
+    // level whose nodes are drawn at about their own texture size
+    int getPyramidLevel(float scale) { return scale >= 1.0f ? 0 : std::min<int>(std::log2(1.0f / scale), MMPYRAMID_LEVELS); }
+    uint getPyramidIndex(int x, int y, int level)
+    {
+        const int nodeSize = MMBLOCK_SIZE << level;
+        return ((y / nodeSize) * (65536 / nodeSize)) + (x / nodeSize);
+    }
+    void invalidatePyramid(const Position& pos);
+    ImagePtr getPyramidImage(int x, int y, int z, int level);
+    const TexturePtr& getPyramidTexture(int x, int y, int z, int level);
     bool hasBlock(const Position& pos) { return m_tileBlocks[pos.z].find(getBlockIndex(pos)) != m_tileBlocks[pos.z].end(); }
     MinimapBlock& getBlock(const Position& pos) { return m_tileBlocks[pos.z][getBlockIndex(pos)]; }
     Point getBlockOffset(const Point& pos)
@@ -111,6 +204,14 @@ private:
     }
     uint getBlockIndex(const Position& pos) { return ((pos.y / MMBLOCK_SIZE) * (65536 / MMBLOCK_SIZE)) + (pos.x / MMBLOCK_SIZE); }
     std::unordered_map<uint, MinimapBlock> m_tileBlocks[Otc::MAX_Z + 1];
+    std::unordered_map<uint, MinimapPyramidNode> m_pyramid[Otc::MAX_Z + 1][MMPYRAMID_LEVELS];
+
+    std::shared_ptr<OtmmSave> m_otmmSave;
+    ScheduledEventPtr m_autoSaveEvent;
+    // file the saved block sizes refer to, with the bytes of all its records and of the latest record of each block
+    std::string m_otmmFile;
+    uint m_otmmFileBytes{ 0 };
+    uint m_otmmLiveBytes{ 0 };
 };
 
 extern Minimap g_minimap;
@@ -22,7 +22,6 @@
 
 #include "missile.h"
 #include <framework/core/clock.h>
-#include <framework/core/eventdispatcher.h>
 #include "map.h"
 #include "thingtypemanager.h"
 #include "tile.h"
@@ -73,6 +72,7 @@ void Missile::setPath(const Position& fromPosition, const Position& toPosition)
 
     const float deltaLength = m_delta.length();
     if(deltaLength == 0) {
+        m_duration = 0;
         g_map.removeThing(this);
         return;
     }
@@ -84,9 +84,7 @@ void Missile::setPath(const Position& fromPosition, const Position& toPosition)
     m_animationTimer.restart();
     m_distance = fromPosition.distance(toPosition);
 
-    // schedule removal
-    const auto self = asMissile();
-    g_dispatcher.scheduleEvent([self]() { g_map.removeThing(self); }, m_duration);
+    // removed by Map::removeExpiredEffects once the duration is over
 }
 
 void Missile::setId(uint32 id)
@@ -26,9 +26,10 @@
 #include <framework/global.h>
 #include <framework/core/timer.h>
 #include "thing.h"
+#include <framework/core/stats.h>
 
  // @bindclass
-class Missile : public Thing
+class Missile : public Thing, private StatsCounted<Missile>
 {
 public:
     void draw(const Point& dest, float scaleFactor, int frameFlag, LightView* lightView = nullptr);
@@ -37,6 +38,7 @@ public:
     void setPath(const Position& fromPosition, const Position& toPosition);
 
     uint32 getId() override { return m_id; }
+    bool isExpired() { return m_animationTimer.ticksElapsed() >= m_duration; }
 
     MissilePtr asMissile() { return static_self_cast<Missile>(); }
     bool isMissile() override { return true; }
@@ -48,7 +50,7 @@ private:
     Timer m_animationTimer;
     Point m_delta;
     uint8 m_distance;
-    float m_duration;
+    float m_duration{ 0 };
     uint16 m_id;
     Otc::Direction m_direction;
 };
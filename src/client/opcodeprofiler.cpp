@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "opcodeprofiler.h"
+#include <framework/core/resourcemanager.h>
+
+OpcodeProfiler g_opcodeProfiler;
+
+namespace {
+    int getBucket(ticks_t micros)
+    {
+        if(micros <= 0)
+            return 0;
+        const int bucket = static_cast<int>(std::log2(static_cast<double>(micros)) * 4) + 1;
+        return std::min<int>(bucket, OpcodeProfiler::HISTOGRAM_BUCKETS - 1);
+    }
+
+    double getBucketLimit(int bucket)
+    {
+        if(bucket == 0)
+            return 0;
+        return std::pow(2.0, bucket / 4.0);
+    }
+}
+
+void OpcodeProfiler::reset()
+{
+    m_stats.fill(OpcodeStats());
+}
+
+void OpcodeProfiler::record(int opcode, int bytes, ticks_t micros)
+{
+    if(opcode < 0 || opcode >= (int)m_stats.size())
+        return;
+
+    OpcodeStats& stats = m_stats[opcode];
+    stats.count++;
+    stats.bytes += std::max<int>(bytes, 0);
+    stats.totalMicros += micros;
+    stats.maxMicros = std::max<uint64>(stats.maxMicros, micros);
+    stats.histogram[getBucket(micros)]++;
+}
+
+double OpcodeProfiler::getPercentile(const OpcodeStats& stats, double fraction)
+{
+    // upper limit of the bucket holding the percentile, never above the real maximum
+    const uint64 target = std::max<uint64>(1, std::ceil(stats.count * fraction));
+    uint64 seen = 0;
+    for(int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += stats.histogram[i];
+        if(seen >= target)
+            return std::min<double>(getBucketLimit(i), stats.maxMicros);
+    }
+    return stats.maxMicros;
+}
+
+std::vector<std::map<std::string, double>> OpcodeProfiler::getStats()
+{
+    std::vector<std::map<std::string, double>> ret;
+    for(int opcode = 0; opcode < (int)m_stats.size(); ++opcode) {
+        const OpcodeStats& stats = m_stats[opcode];
+        if(stats.count == 0)
+            continue;
+
+        std::map<std::string, double> entry;
+        entry["opcode"] = opcode;
+        entry["count"] = stats.count;
+        entry["bytes"] = stats.bytes;
+        entry["totalMicros"] = stats.totalMicros;
+        entry["maxMicros"] = stats.maxMicros;
+        entry["p50"] = getPercentile(stats, 0.5);
+        entry["p90"] = getPercentile(stats, 0.9);
+        entry["p99"] = getPercentile(stats, 0.99);
+        ret.push_back(entry);
+    }
+    return ret;
+}
+
+bool OpcodeProfiler::dumpCsv(const std::string& fileName)
+{
+    std::stringstream ss;
+    ss << "opcode,count,bytes,total_us,avg_us,max_us,p50_us,p90_us,p99_us\n";
+    for(int opcode = 0; opcode < (int)m_stats.size(); ++opcode) {
+        const OpcodeStats& stats = m_stats[opcode];
+        if(stats.count == 0)
+            continue;
+
+        ss << opcode << ',' << stats.count << ',' << stats.bytes << ',' << stats.totalMicros << ','
+           << stats.totalMicros / (double)stats.count << ',' << stats.maxMicros << ','
+           << getPercentile(stats, 0.5) << ',' << getPercentile(stats, 0.9) << ',' << getPercentile(stats, 0.99) << '\n';
+    }
+    return g_resources.writeFileContents(fileName, ss.str());
+}
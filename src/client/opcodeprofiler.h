@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef OPCODEPROFILER_H
+#define OPCODEPROFILER_H
+
+#include "declarations.h"
+#include <framework/net/inputmessage.h>
+
+// per opcode parse costs of ProtocolGame::parseMessage, lua handlers included
+class OpcodeProfiler
+{
+public:
+    enum {
+        HISTOGRAM_BUCKETS = 64 // quarter octaves of microseconds
+    };
+
+    struct OpcodeStats {
+        uint64 count = 0;
+        uint64 bytes = 0;
+        uint64 totalMicros = 0;
+        uint64 maxMicros = 0;
+        uint32 histogram[HISTOGRAM_BUCKETS] = {};
+    };
+
+    // measures one opcode from its first byte until the scope ends
+    class Scope
+    {
+    public:
+        Scope(int opcode, const InputMessagePtr& msg);
+        ~Scope();
+
+    private:
+        bool m_active;
+        int m_opcode;
+        int m_readPos;
+        ticks_t m_start;
+        const InputMessagePtr& m_msg;
+    };
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() { return m_enabled; }
+    void reset();
+
+    void record(int opcode, int bytes, ticks_t micros);
+
+    // one table per seen opcode with count, bytes, total, max and the 50/90/99 percentiles in microseconds
+    std::vector<std::map<std::string, double>> getStats();
+    bool dumpCsv(const std::string& fileName);
+
+private:
+    static double getPercentile(const OpcodeStats& stats, double fraction);
+
+    bool m_enabled = false;
+    std::array<OpcodeStats, 256> m_stats;
+};
+
+extern OpcodeProfiler g_opcodeProfiler;
+
+inline OpcodeProfiler::Scope::Scope(int opcode, const InputMessagePtr& msg) :
+    m_active(g_opcodeProfiler.isEnabled()), m_opcode(opcode), m_readPos(0), m_start(0), m_msg(msg)
+{
+    if(m_active) {
+        m_readPos = msg->getReadPos() - 1;
+        m_start = stdext::micros();
+    }
+}
+
+inline OpcodeProfiler::Scope::~Scope()
+{
+    if(m_active)
+        g_opcodeProfiler.record(m_opcode, m_msg->getReadPos() - m_readPos, stdext::micros() - m_start);
+}
+
+#endif
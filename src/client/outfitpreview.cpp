@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "outfitpreview.h"
+#include "thingtype.h"
+#include "thingtypemanager.h"
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/clock.h>
+#include <framework/graphics/image.h>
+#include <framework/graphics/textureatlas.h>
+
+OutfitPreviews g_outfitPreviews;
+
+namespace {
+    struct PreviewFrame {
+        const ThingType* type;
+        Point dest;
+        int xPattern, yPattern, zPattern, animationPhase;
+        bool tinted;
+    };
+}
+
+void OutfitPreviews::terminate()
+{
+    clear();
+}
+
+AtlasRegionPtr OutfitPreviews::getPreview(const Outfit& outfit, Otc::Direction direction)
+{
+    Preview& preview = request(outfit, direction);
+    if(preview.pending.valid()) {
+        if(preview.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return nullptr;
+
+        const ImagePtr image = preview.pending.get();
+        preview.pending = std::shared_future<ImagePtr>();
+        preview.type = preview.mountType = nullptr;
+        preview.region = image ? g_atlas.allocate(image, true) : nullptr;
+        preview.composed = true;
+        ++m_composedCount;
+    }
+
+    if(!preview.region || !preview.region->isValid())
+        return nullptr;
+
+    preview.region->touch(g_clock.millis());
+    return preview.region;
+}
+
+void OutfitPreviews::prefetch(const std::vector<Outfit>& outfits, Otc::Direction direction)
+{
+    for(const Outfit& outfit : outfits)
+        request(outfit, direction);
+}
+
+void OutfitPreviews::clear()
+{
+    for(const auto& it : m_previews) {
+        if(it.second.pending.valid())
+            it.second.pending.wait();
+    }
+    m_previews.clear();
+}
+
+std::map<std::string, int> OutfitPreviews::getStatistics()
+{
+    int pending = 0;
+    for(const auto& it : m_previews) {
+        if(it.second.pending.valid())
+            ++pending;
+    }
+
+    std::map<std::string, int> stats;
+    stats["previews"] = m_previews.size();
+    stats["pending"] = pending;
+    stats["composed"] = m_composedCount;
+    return stats;
+}
+
+OutfitPreviews::Preview& OutfitPreviews::request(const Outfit& outfit, Otc::Direction direction)
+{
+    const size_t key = makeKey(outfit, direction);
+    auto it = m_previews.find(key);
+    if(it == m_previews.end()) {
+        trim();
+        it = m_previews.emplace(key, Preview()).first;
+    }
+
+    Preview& preview = it->second;
+    preview.lastUse = g_clock.millis();
+
+    // being composed, or composed unless the atlas evicted it since
+    if(preview.pending.valid() || (preview.composed && (!preview.region || preview.region->isValid())))
+        return preview;
+    preview.composed = false;
+
+    // the frames are resolved here, the workers only decode sprites
+    std::vector<PreviewFrame> frames;
+    Rect bounds;
+    const auto addFrame = [&](ThingType* type, const Point& dest, int xPattern, int yPattern, int zPattern, int animationPhase, bool tinted) {
+        if(type->isNull())
+            return;
+
+        const Rect rect(dest - type->getDisplacement() - (type->getSize().toPoint() - Point(1)) * Otc::TILE_PIXELS, type->getSize() * Otc::TILE_PIXELS);
+        bounds = frames.empty() ? rect : bounds.united(rect);
+        frames.push_back({ type, dest, xPattern, yPattern, zPattern, animationPhase, tinted });
+    };
+
+    if(outfit.getCategory() == ThingCategoryCreature) {
+        preview.type = g_things.getThingType(outfit.getId(), ThingCategoryCreature);
+        ThingType* type = preview.type.get();
+
+        int xPattern;
+        if(direction == Otc::NorthEast || direction == Otc::SouthEast)
+            xPattern = Otc::East;
+        else if(direction == Otc::NorthWest || direction == Otc::SouthWest)
+            xPattern = Otc::West;
+        else
+            xPattern = direction;
+
+        // placed as Creature::internalDrawOutfit does
+        Point dest = type->getDisplacement();
+        int zPattern = 0;
+        if(outfit.hasMount()) {
+            preview.mountType = g_things.getThingType(outfit.getMount(), ThingCategoryCreature);
+            ThingType* mountType = preview.mountType.get();
+
+            dest -= mountType->getDisplacement();
+            addFrame(mountType, dest, xPattern, 0, 0, 0, false);
+            dest += type->getDisplacement();
+            zPattern = std::min<int>(1, type->getNumPatternZ() - 1);
+        }
+
+        for(int yPattern = 0; yPattern < type->getNumPatternY(); ++yPattern) {
+            if(yPattern > 0 && !(outfit.getAddons() & (1 << (yPattern - 1))))
+                continue;
+            addFrame(type, dest, xPattern, yPattern, zPattern, 0, true);
+        }
+    } else {
+        preview.type = g_things.getThingType(outfit.getAuxId(), outfit.getCategory());
+        ThingType* type = preview.type.get();
+
+        // effects skip their first phase, as creatures imitating them do
+        const int animationPhase = outfit.getCategory() == ThingCategoryEffect && type->getAnimationPhases() > 1 ? 1 : 0;
+        addFrame(type, Point(), 0, 0, 0, animationPhase, false);
+    }
+
+    if(frames.empty()) {
+        preview.type = preview.mountType = nullptr;
+        preview.region = nullptr;
+        preview.composed = true;
+        return preview;
+    }
+
+    for(PreviewFrame& frame : frames)
+        frame.dest -= bounds.topLeft();
+
+    const Size size = bounds.size();
+    const std::array<Color, 4> colors{ outfit.getHeadColor(), outfit.getBodyColor(), outfit.getLegsColor(), outfit.getFeetColor() };
+    preview.pending = g_asyncDispatcher.schedule([frames, size, colors] {
+        const ImagePtr image(new Image(size));
+        for(const PreviewFrame& frame : frames)
+            frame.type->composeFrame(image, frame.dest, frame.xPattern, frame.yPattern, frame.zPattern, frame.animationPhase, frame.tinted ? &colors : nullptr);
+        return image;
+    });
+    return preview;
+}
+
+void OutfitPreviews::trim()
+{
+    while(m_previews.size() >= MAX_PREVIEWS) {
+        auto oldest = m_previews.end();
+        for(auto it = m_previews.begin(); it != m_previews.end(); ++it) {
+            if(!it->second.pending.valid() && (oldest == m_previews.end() || it->second.lastUse < oldest->second.lastUse))
+                oldest = it;
+        }
+
+        // every preview is still being composed
+        if(oldest == m_previews.end())
+            break;
+        m_previews.erase(oldest);
+    }
+}
+
+size_t OutfitPreviews::makeKey(const Outfit& outfit, Otc::Direction direction)
+{
+    size_t key = 0;
+    for(const int value : { outfit.getId(), outfit.getAuxId(), outfit.getHead(), outfit.getBody(), outfit.getLegs(), outfit.getFeet(), outfit.getAddons(), outfit.getMount() })
+        boost::hash_combine(key, value);
+    boost::hash_combine(key, static_cast<int>(outfit.getCategory()));
+    boost::hash_combine(key, static_cast<int>(direction));
+    return key;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef OUTFITPREVIEW_H
+#define OUTFITPREVIEW_H
+
+#include "declarations.h"
+#include "outfit.h"
+#include <framework/graphics/declarations.h>
+#include <future>
+
+// Still thumbnails of outfits for windows that list many of them. Only the frame a thumbnail shows is decoded,
+// on the async dispatcher, instead of the full textures a creature composes for every direction and addon
+class OutfitPreviews
+{
+public:
+    enum {
+        MAX_PREVIEWS = 256 // least recently shown previews are dropped past this
+    };
+
+    void terminate();
+
+    // the thumbnail facing direction, nothing until it is composed, callers keep drawing their placeholder meanwhile
+    AtlasRegionPtr getPreview(const Outfit& outfit, Otc::Direction direction = Otc::South);
+    // starts composing the thumbnails of the page a list is about to show
+    void prefetch(const std::vector<Outfit>& outfits, Otc::Direction direction = Otc::South);
+
+    void clear();
+    std::map<std::string, int> getStatistics();
+
+private:
+    struct Preview {
+        AtlasRegionPtr region;
+        std::shared_future<ImagePtr> pending;
+        // kept alive here while the async dispatcher reads their sprites
+        ThingTypePtr type, mountType;
+        ticks_t lastUse{ 0 };
+        bool composed{ false };
+    };
+
+    Preview& request(const Outfit& outfit, Otc::Direction direction);
+    void trim();
+
+    static size_t makeKey(const Outfit& outfit, Otc::Direction direction);
+
+    std::unordered_map<size_t, Preview> m_previews;
+    uint m_composedCount{ 0 };
+};
+
+extern OutfitPreviews g_outfitPreviews;
+
+#endif
@@ -0,0 +1,798 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pathfinder.h"
+#include "map.h"
+#include "minimap.h"
+
+#include <algorithm>
+#include <limits>
+
+bool PathFinder::start(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags)
+{
+    m_startPos = startPos;
+    m_goalPos = goalPos;
+    m_maxComplexity = maxComplexity;
+    m_flags = flags;
+    m_createdNodes = 0;
+    m_goalIndex = -1;
+    m_finished = true;
+    m_heap.clear();
+    m_result = Otc::PathFindResultNoWay;
+
+    if(startPos == goalPos) {
+        m_result = Otc::PathFindResultSamePosition;
+        return false;
+    }
+
+    if(startPos.z != goalPos.z) {
+        m_result = Otc::PathFindResultImpossible;
+        return false;
+    }
+
+    // check the goal pos is walkable
+    if(g_map.isAwareOfPosition(goalPos)) {
+        const TilePtr goalTile = g_map.getTile(goalPos);
+        if(!goalTile || !goalTile->isWalkable((flags & Otc::PathFindAllowCreatures)))
+            return false;
+    } else {
+        const MinimapTile& goalTile = g_minimap.getTile(goalPos);
+        if(goalTile.hasFlag(MinimapTileNotWalkable))
+            return false;
+    }
+
+    // the grid only grows, smaller searches reuse the front of it
+    const int distance = std::max<int>(std::abs(goalPos.x - startPos.x), std::abs(goalPos.y - startPos.y));
+    if(distance >= MAX_RADIUS) {
+        m_result = Otc::PathFindResultTooFar;
+        return false;
+    }
+
+    int radius = 32;
+    while(radius < std::min<int>(distance * 2, MAX_RADIUS))
+        radius <<= 1;
+
+    m_side = radius * 2 + 1;
+    m_originX = startPos.x - radius;
+    m_originY = startPos.y - radius;
+    if(m_nodes.size() < static_cast<size_t>(m_side * m_side))
+        m_nodes.resize(m_side * m_side, Node{ 0, 0, -1, -1, 0, Otc::InvalidDirection });
+
+    if(++m_generation == 0) {
+        for(Node& node : m_nodes)
+            node.generation = 0;
+        m_generation = 1;
+    }
+
+    const int startIndex = getNodeIndex(startPos);
+    Node& startNode = getNode(startIndex);
+    startNode.cost = 0;
+    startNode.totalCost = getHeuristic(startPos);
+    pushHeap(startIndex);
+
+    m_finished = false;
+    return true;
+}
+
+bool PathFinder::step(int maxExpansions)
+{
+    while(!m_finished && maxExpansions-- > 0) {
+        if(m_heap.empty()) {
+            m_finished = true;
+            break;
+        }
+
+        if(m_createdNodes > m_maxComplexity) {
+            m_result = Otc::PathFindResultTooFar;
+            m_finished = true;
+            break;
+        }
+
+        const int currentIndex = popHeap();
+        const Position currentPos = getNodePosition(currentIndex);
+        if(currentPos == m_goalPos) {
+            m_goalIndex = currentIndex;
+            m_result = Otc::PathFindResultOk;
+            m_finished = true;
+            break;
+        }
+
+        const float currentCost = m_nodes[currentIndex].cost;
+        for(int_fast32_t i = -1; i <= 1; ++i) {
+            for(int_fast32_t j = -1; j <= 1; ++j) {
+                if(i == 0 && j == 0)
+                    continue;
+
+                const Position neighborPos = currentPos.translated(i, j);
+                const int neighborIndex = getNodeIndex(neighborPos);
+                if(neighborIndex < 0 || !isWalkable(neighborPos, m_flags, neighborPos == m_goalPos))
+                    continue;
+
+                const Otc::Direction walkDir = currentPos.getDirectionFromPosition(neighborPos);
+                const float walkFactor = walkDir >= Otc::NorthEast ? 3.0f : 1.0f;
+                const float cost = currentCost + getStepCost(neighborPos) * walkFactor;
+
+                Node& neighborNode = getNode(neighborIndex);
+                if(neighborNode.cost <= cost)
+                    continue;
+
+                neighborNode.prev = currentIndex;
+                neighborNode.cost = cost;
+                neighborNode.dir = walkDir;
+                neighborNode.totalCost = cost + getHeuristic(neighborPos);
+
+                if(neighborNode.heapIndex >= 0)
+                    siftUp(neighborNode.heapIndex);
+                else
+                    pushHeap(neighborIndex);
+            }
+        }
+    }
+
+    return m_finished;
+}
+
+PathFinder::Result PathFinder::getResult()
+{
+    Result ret;
+    std::vector<Otc::Direction>& dirs = std::get<0>(ret);
+    std::get<1>(ret) = m_result;
+
+    if(m_result == Otc::PathFindResultOk) {
+        const int startIndex = getNodeIndex(m_startPos);
+        for(int index = m_goalIndex; index != startIndex; index = m_nodes[index].prev)
+            dirs.push_back(m_nodes[index].dir);
+        std::reverse(dirs.begin(), dirs.end());
+    }
+
+    return ret;
+}
+
+PathFinder::Result PathFinder::find(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags)
+{
+    if(start(startPos, goalPos, maxComplexity, flags))
+        step(std::numeric_limits<int>::max());
+    return getResult();
+}
+
+bool PathFinder::isWalkable(const Position& pos, uint32 flags, bool isGoal)
+{
+    bool wasSeen = false;
+    bool hasCreature = false;
+    bool isNotWalkable = true;
+    bool isNotPathable = true;
+
+    if(g_map.isAwareOfPosition(pos)) {
+        wasSeen = true;
+        if(const TilePtr& tile = g_map.getTile(pos)) {
+            hasCreature = tile->hasCreature() && !tile->getCreatures().empty();
+            isNotWalkable = !tile->isWalkable(flags & Otc::PathFindAllowCreatures);
+            isNotPathable = !tile->isPathable();
+        }
+    } else {
+        const MinimapTile& mtile = g_minimap.getTile(pos);
+        wasSeen = mtile.hasFlag(MinimapTileWasSeen);
+        isNotWalkable = mtile.hasFlag(MinimapTileNotWalkable);
+        isNotPathable = mtile.hasFlag(MinimapTileNotPathable);
+        if(isNotWalkable || isNotPathable)
+            wasSeen = true;
+    }
+
+    if(!(flags & Otc::PathFindAllowNotSeenTiles) && !wasSeen)
+        return false;
+
+    if(wasSeen) {
+        if(!isGoal) {
+            if(!(flags & Otc::PathFindAllowCreatures) && hasCreature)
+                return false;
+            if(!(flags & Otc::PathFindAllowNonPathable) && isNotPathable)
+                return false;
+        }
+        if(!(flags & Otc::PathFindAllowNonWalkable) && isNotWalkable)
+            return false;
+    }
+
+    return true;
+}
+
+float PathFinder::getStepCost(const Position& pos)
+{
+    uint16 speed = 100;
+    if(g_map.isAwareOfPosition(pos)) {
+        if(const TilePtr& tile = g_map.getTile(pos))
+            speed = tile->getGroundSpeed();
+    } else
+        speed = g_minimap.getTile(pos).getSpeed();
+
+    return speed / 100.0f;
+}
+
+int PathFinder::getNodeIndex(const Position& pos) const
+{
+    const int x = pos.x - m_originX, y = pos.y - m_originY;
+    if(x < 0 || y < 0 || x >= m_side || y >= m_side)
+        return -1;
+    return y * m_side + x;
+}
+
+Position PathFinder::getNodePosition(int index) const
+{
+    return Position(m_originX + index % m_side, m_originY + index / m_side, m_startPos.z);
+}
+
+PathFinder::Node& PathFinder::getNode(int index)
+{
+    Node& node = m_nodes[index];
+    if(node.generation != m_generation) {
+        node.cost = std::numeric_limits<float>::max();
+        node.totalCost = std::numeric_limits<float>::max();
+        node.prev = -1;
+        node.heapIndex = -1;
+        node.generation = m_generation;
+        node.dir = Otc::InvalidDirection;
+        ++m_createdNodes;
+    }
+    return node;
+}
+
+void PathFinder::pushHeap(int index)
+{
+    m_heap.push_back(index);
+    m_nodes[index].heapIndex = m_heap.size() - 1;
+    siftUp(m_heap.size() - 1);
+}
+
+int PathFinder::popHeap()
+{
+    const int index = m_heap.front();
+    m_nodes[index].heapIndex = -1;
+
+    const int last = m_heap.back();
+    m_heap.pop_back();
+    if(!m_heap.empty()) {
+        m_heap.front() = last;
+        m_nodes[last].heapIndex = 0;
+        siftDown(0);
+    }
+    return index;
+}
+
+void PathFinder::siftUp(int heapPos)
+{
+    const int index = m_heap[heapPos];
+    const float totalCost = m_nodes[index].totalCost;
+    while(heapPos > 0) {
+        const int parentPos = (heapPos - 1) / 2;
+        const int parent = m_heap[parentPos];
+        if(m_nodes[parent].totalCost <= totalCost)
+            break;
+
+        m_heap[heapPos] = parent;
+        m_nodes[parent].heapIndex = heapPos;
+        heapPos = parentPos;
+    }
+    m_heap[heapPos] = index;
+    m_nodes[index].heapIndex = heapPos;
+}
+
+void PathFinder::siftDown(int heapPos)
+{
+    const int size = m_heap.size();
+    const int index = m_heap[heapPos];
+    const float totalCost = m_nodes[index].totalCost;
+    while(true) {
+        int childPos = heapPos * 2 + 1;
+        if(childPos >= size)
+            break;
+
+        if(childPos + 1 < size && m_nodes[m_heap[childPos + 1]].totalCost < m_nodes[m_heap[childPos]].totalCost)
+            ++childPos;
+
+        const int child = m_heap[childPos];
+        if(totalCost <= m_nodes[child].totalCost)
+            break;
+
+        m_heap[heapPos] = child;
+        m_nodes[child].heapIndex = heapPos;
+        heapPos = childPos;
+    }
+    m_heap[heapPos] = index;
+    m_nodes[index].heapIndex = heapPos;
+}
+
+PathPlan::Result PathPlan::find(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags)
+{
+    if(goalPos != m_goalPos || flags != m_flags || m_steps.empty())
+        return search(startPos, goalPos, maxComplexity, flags);
+
+    // the walker is expected somewhere along the path, anywhere else it is planned again
+    const auto it = std::find(m_steps.begin(), m_steps.end(), startPos);
+    if(it == m_steps.end() || !repair(it - m_steps.begin()))
+        return search(startPos, goalPos, maxComplexity, flags);
+
+    return getResult(it - m_steps.begin());
+}
+
+PathPlan::Result PathPlan::search(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags)
+{
+    m_steps.clear();
+    m_goalPos = goalPos;
+    m_flags = flags;
+
+    Result ret = g_map.findPath(startPos, goalPos, maxComplexity, flags);
+    if(std::get<1>(ret) == Otc::PathFindResultOk) {
+        Position pos = startPos;
+        m_steps.push_back(pos);
+        for(const Otc::Direction dir : std::get<0>(ret)) {
+            pos = pos.translatedToDirection(dir);
+            m_steps.push_back(pos);
+        }
+    }
+    return ret;
+}
+
+bool PathPlan::repair(size_t current)
+{
+    for(size_t i = current + 1; i < m_steps.size(); ++i) {
+        const bool isGoal = i == m_steps.size() - 1;
+        if(PathFinder::isWalkable(m_steps[i], m_flags, isGoal))
+            continue;
+
+        // a blocked goal can't be joined, leave it to a full search to tell why
+        size_t rejoin = i + 1;
+        while(rejoin < m_steps.size() && !PathFinder::isWalkable(m_steps[rejoin], m_flags, rejoin == m_steps.size() - 1))
+            ++rejoin;
+        if(rejoin >= m_steps.size())
+            return false;
+
+        const Position& from = m_steps[i - 1];
+        const auto detour = g_map.findPath(from, m_steps[rejoin], MAX_REPAIR_COMPLEXITY, m_flags);
+        if(std::get<1>(detour) != Otc::PathFindResultOk)
+            return false;
+
+        std::vector<Position> steps;
+        Position pos = from;
+        for(const Otc::Direction dir : std::get<0>(detour)) {
+            pos = pos.translatedToDirection(dir);
+            steps.push_back(pos);
+        }
+
+        // the detour ends on the rejoin step itself
+        m_steps.erase(m_steps.begin() + i, m_steps.begin() + rejoin + 1);
+        m_steps.insert(m_steps.begin() + i, steps.begin(), steps.end());
+        i += steps.size() - 1;
+    }
+    return true;
+}
+
+PathPlan::Result PathPlan::getResult(size_t current)
+{
+    Result ret;
+    std::vector<Otc::Direction>& dirs = std::get<0>(ret);
+    std::get<1>(ret) = Otc::PathFindResultOk;
+
+    for(size_t i = current + 1; i < m_steps.size(); ++i)
+        dirs.push_back(m_steps[i - 1].getDirectionFromPosition(m_steps[i]));
+
+    if(dirs.empty())
+        std::get<1>(ret) = Otc::PathFindResultSamePosition;
+    return ret;
+}
+
+namespace {
+    // walkable runs at least this long get a portal on each end instead of a single one in the middle
+    const int LONG_PORTAL_RUN = 8;
+    // abstract nodes expanded before a route is given up
+    const int MAX_ROUTE_EXPANSIONS = 200000;
+
+    bool getClusterNeighbor(const Position& origin, int dx, int dy, Position& neighbor)
+    {
+        const int x = origin.x + dx * MMBLOCK_SIZE, y = origin.y + dy * MMBLOCK_SIZE;
+        if(x < 0 || y < 0 || x > 65535 - MMBLOCK_SIZE + 1 || y > 65535 - MMBLOCK_SIZE + 1)
+            return false;
+        neighbor = Position(x, y, origin.z);
+        return true;
+    }
+}
+
+RouteFinder::Result RouteFinder::find(const Position& startPos, const Position& goalPos)
+{
+    Result ret;
+    std::vector<Otc::Direction>& dirs = std::get<0>(ret);
+    Otc::PathFindResult& result = std::get<1>(ret);
+    result = Otc::PathFindResultNoWay;
+
+    if(startPos == goalPos) {
+        result = Otc::PathFindResultSamePosition;
+        return ret;
+    }
+
+    if(startPos.z != goalPos.z || startPos.z > Otc::MAX_Z) {
+        result = Otc::PathFindResultImpossible;
+        return ret;
+    }
+
+    if(!isWalkable(goalPos))
+        return ret;
+
+    // start and goal join the abstract graph through the portals of their own clusters,
+    // the clusters must be built before the searches below reuse the local grid
+    const Cluster& startCluster = getCluster(startPos);
+    const bool sameCluster = getClusterIndex(startPos) == getClusterIndex(goalPos);
+
+    std::vector<Link> startLinks;
+    searchCluster(startPos, false);
+    for(const auto& it : startCluster.links) {
+        const float cost = getLocalCost(it.first);
+        if(cost < std::numeric_limits<float>::max())
+            startLinks.push_back({ it.first, cost });
+    }
+    if(sameCluster && getLocalCost(goalPos) < std::numeric_limits<float>::max())
+        startLinks.push_back({ goalPos, getLocalCost(goalPos) });
+
+    const Cluster& goalCluster = getCluster(goalPos);
+    stdext::flat_hash_map<Position, float, Position::Hasher> goalCosts;
+    searchCluster(goalPos, true);
+    for(const auto& it : goalCluster.links) {
+        const float cost = getLocalCost(it.first);
+        if(cost < std::numeric_limits<float>::max())
+            goalCosts[it.first] = cost;
+    }
+
+    struct Node {
+        Position pos;
+        float cost;
+        int prev;
+        bool closed;
+    };
+
+    std::vector<Node> nodes;
+    stdext::flat_hash_map<Position, int, Position::Hasher> nodeIds;
+    std::vector<std::pair<float, int>> heap;
+
+    const auto getHeuristic = [&](const Position& pos) { return static_cast<float>(std::abs(pos.x - goalPos.x) + std::abs(pos.y - goalPos.y)); };
+    const auto relax = [&](int from, const Position& to, float cost) {
+        const auto it = nodeIds.find(to);
+        int id;
+        if(it == nodeIds.end()) {
+            id = nodes.size();
+            nodeIds.emplace(to, id);
+            nodes.push_back({ to, std::numeric_limits<float>::max(), -1, false });
+        } else
+            id = it->second;
+
+        Node& node = nodes[id];
+        if(node.closed || node.cost <= cost)
+            return;
+
+        node.cost = cost;
+        node.prev = from;
+        heap.emplace_back(cost + getHeuristic(to), id);
+        std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<float, int>>());
+    };
+
+    nodes.push_back({ startPos, 0, -1, false });
+    nodeIds.emplace(startPos, 0);
+    heap.emplace_back(getHeuristic(startPos), 0);
+
+    int goalId = -1;
+    int expansions = 0;
+    while(!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<float, int>>());
+        const int id = heap.back().second;
+        heap.pop_back();
+
+        if(nodes[id].closed)
+            continue;
+        nodes[id].closed = true;
+
+        const Position pos = nodes[id].pos;
+        const float cost = nodes[id].cost;
+        if(pos == goalPos) {
+            goalId = id;
+            break;
+        }
+
+        if(++expansions > MAX_ROUTE_EXPANSIONS) {
+            result = Otc::PathFindResultTooFar;
+            return ret;
+        }
+
+        if(id == 0) {
+            for(const Link& link : startLinks)
+                relax(id, link.to, cost + link.cost);
+        }
+
+        const Cluster& cluster = getCluster(pos);
+        const auto linksIt = cluster.links.find(pos);
+        if(linksIt != cluster.links.end()) {
+            for(const Link& link : linksIt->second)
+                relax(id, link.to, cost + link.cost);
+        }
+
+        const auto goalIt = goalCosts.find(pos);
+        if(goalIt != goalCosts.end())
+            relax(id, goalPos, cost + goalIt->second);
+    }
+
+    if(goalId < 0)
+        return ret;
+
+    std::vector<Position> route;
+    for(int id = goalId; id >= 0; id = nodes[id].prev)
+        route.push_back(nodes[id].pos);
+    std::reverse(route.begin(), route.end());
+
+    // portal crossings are single steps, everything else is walked inside one cluster
+    for(uint i = 1; i < route.size(); ++i) {
+        const Position& from = route[i - 1];
+        const Position& to = route[i];
+        if(getClusterIndex(from) != getClusterIndex(to))
+            dirs.push_back(from.getDirectionFromPosition(to));
+        else if(!appendLocalPath(from, to, dirs)) {
+            dirs.clear();
+            return ret;
+        }
+    }
+
+    result = Otc::PathFindResultOk;
+    return ret;
+}
+
+void RouteFinder::clear()
+{
+    for(int z = 0; z <= Otc::MAX_Z; ++z) {
+        m_edges[z].clear();
+        m_clusters[z].clear();
+    }
+}
+
+bool RouteFinder::isWalkable(const Position& pos)
+{
+    const MinimapTile& tile = g_minimap.getTile(pos);
+    if(!tile.hasFlag(MinimapTileWasSeen) && tile.color == 255)
+        return false;
+    return !tile.hasFlag(MinimapTileNotWalkable) && !tile.hasFlag(MinimapTileNotPathable);
+}
+
+float RouteFinder::getStepCost(const Position& pos)
+{
+    return g_minimap.getTile(pos).getSpeed() / 100.0f;
+}
+
+const std::vector<RouteFinder::Portal>& RouteFinder::getEdge(const Position& pos, bool south)
+{
+    static const std::vector<Portal> noPortals;
+
+    const Position origin = getClusterOrigin(pos);
+    Position neighbor;
+    if(!getClusterNeighbor(origin, south ? 0 : 1, south ? 1 : 0, neighbor))
+        return noPortals;
+
+    const uint32 revisions[2] = { g_minimap.getPathRevision(origin), g_minimap.getPathRevision(neighbor) };
+    Edge& edge = m_edges[pos.z][getClusterIndex(origin) * 2 + (south ? 1 : 0)];
+    // fresh edges start with both revisions at 0, which is only a match while both blocks are missing
+    if(edge.revisions[0] == revisions[0] && edge.revisions[1] == revisions[1])
+        return edge.portals;
+
+    edge.portals.clear();
+    edge.revisions[0] = revisions[0];
+    edge.revisions[1] = revisions[1];
+    if(revisions[0] == 0 || revisions[1] == 0)
+        return edge.portals;
+
+    const auto getInside = [&](int i) {
+        return south ? Position(origin.x + i, origin.y + MMBLOCK_SIZE - 1, origin.z) : Position(origin.x + MMBLOCK_SIZE - 1, origin.y + i, origin.z);
+    };
+    const auto addPortal = [&](int i) {
+        const Position inside = getInside(i);
+        const Position outside = south ? Position(inside.x, inside.y + 1, inside.z) : Position(inside.x + 1, inside.y, inside.z);
+        edge.portals.push_back({ inside, outside });
+    };
+
+    int runStart = -1;
+    for(int i = 0; i <= MMBLOCK_SIZE; ++i) {
+        bool open = false;
+        if(i < MMBLOCK_SIZE) {
+            const Position inside = getInside(i);
+            open = isWalkable(inside) && isWalkable(south ? Position(inside.x, inside.y + 1, inside.z) : Position(inside.x + 1, inside.y, inside.z));
+        }
+
+        if(open) {
+            if(runStart < 0)
+                runStart = i;
+            continue;
+        }
+
+        if(runStart < 0)
+            continue;
+
+        const int runEnd = i - 1;
+        if(runEnd - runStart + 1 >= LONG_PORTAL_RUN) {
+            addPortal(runStart);
+            addPortal(runEnd);
+        } else
+            addPortal((runStart + runEnd) / 2);
+        runStart = -1;
+    }
+
+    return edge.portals;
+}
+
+const RouteFinder::Cluster& RouteFinder::getCluster(const Position& pos)
+{
+    const Position origin = getClusterOrigin(pos);
+
+    // the cluster depends on its own tiles and on the edges shared with the four neighbors
+    Position neighbors[4];
+    const bool hasNeighbor[4] = {
+        getClusterNeighbor(origin, -1, 0, neighbors[0]),
+        getClusterNeighbor(origin, 0, -1, neighbors[1]),
+        getClusterNeighbor(origin, 1, 0, neighbors[2]),
+        getClusterNeighbor(origin, 0, 1, neighbors[3])
+    };
+
+    uint32 revisions[5] = { g_minimap.getPathRevision(origin), 0, 0, 0, 0 };
+    for(int i = 0; i < 4; ++i) {
+        if(hasNeighbor[i])
+            revisions[i + 1] = g_minimap.getPathRevision(neighbors[i]);
+    }
+
+    const auto it = m_clusters[pos.z].find(getClusterIndex(origin));
+    if(it != m_clusters[pos.z].end() && std::equal(revisions, revisions + 5, it->second.revisions))
+        return it->second;
+
+    Cluster& cluster = m_clusters[pos.z][getClusterIndex(origin)];
+    cluster.links.clear();
+    std::copy(revisions, revisions + 5, cluster.revisions);
+
+    // crossing a portal costs a single step onto the other side
+    for(const Portal& portal : getEdge(origin, false))
+        cluster.links[portal.inside].push_back({ portal.outside, getStepCost(portal.outside) });
+    for(const Portal& portal : getEdge(origin, true))
+        cluster.links[portal.inside].push_back({ portal.outside, getStepCost(portal.outside) });
+    if(hasNeighbor[0]) {
+        for(const Portal& portal : getEdge(neighbors[0], false))
+            cluster.links[portal.outside].push_back({ portal.inside, getStepCost(portal.inside) });
+    }
+    if(hasNeighbor[1]) {
+        for(const Portal& portal : getEdge(neighbors[1], true))
+            cluster.links[portal.outside].push_back({ portal.inside, getStepCost(portal.inside) });
+    }
+
+    std::vector<Position> portals;
+    portals.reserve(cluster.links.size());
+    for(const auto& link : cluster.links)
+        portals.push_back(link.first);
+
+    for(const Position& from : portals) {
+        searchCluster(from, false);
+        std::vector<Link>& links = cluster.links[from];
+        for(const Position& to : portals) {
+            if(to == from)
+                continue;
+            const float cost = getLocalCost(to);
+            if(cost < std::numeric_limits<float>::max())
+                links.push_back({ to, cost });
+        }
+    }
+
+    return cluster;
+}
+
+void RouteFinder::searchCluster(const Position& source, bool reverse, const Position* target)
+{
+    m_localOrigin = getClusterOrigin(source);
+    if(++m_localGeneration == 0) {
+        for(LocalNode& node : m_localNodes)
+            node.generation = 0;
+        m_localGeneration = 1;
+    }
+
+    const auto getNode = [this](int index) -> LocalNode& {
+        LocalNode& node = m_localNodes[index];
+        if(node.generation != m_localGeneration) {
+            node.cost = std::numeric_limits<float>::max();
+            node.generation = m_localGeneration;
+            node.dir = Otc::InvalidDirection;
+        }
+        return node;
+    };
+
+    const int sourceIndex = (source.y - m_localOrigin.y) * MMBLOCK_SIZE + (source.x - m_localOrigin.x);
+    getNode(sourceIndex).cost = 0;
+    m_localHeap.clear();
+    m_localHeap.emplace_back(0.0f, sourceIndex);
+
+    while(!m_localHeap.empty()) {
+        std::pop_heap(m_localHeap.begin(), m_localHeap.end(), std::greater<std::pair<float, int>>());
+        const float currentCost = m_localHeap.back().first;
+        const int currentIndex = m_localHeap.back().second;
+        m_localHeap.pop_back();
+
+        if(currentCost > m_localNodes[currentIndex].cost)
+            continue;
+
+        const int cx = currentIndex % MMBLOCK_SIZE, cy = currentIndex / MMBLOCK_SIZE;
+        const Position currentPos(m_localOrigin.x + cx, m_localOrigin.y + cy, m_localOrigin.z);
+        if(target && currentPos == *target)
+            break;
+
+        // a reverse search walks the steps backwards, so the cost is the one of the tile being left
+        const float currentStepCost = reverse ? getStepCost(currentPos) : 0;
+        for(int i = -1; i <= 1; ++i) {
+            for(int j = -1; j <= 1; ++j) {
+                if(i == 0 && j == 0)
+                    continue;
+
+                const int nx = cx + i, ny = cy + j;
+                if(nx < 0 || ny < 0 || nx >= MMBLOCK_SIZE || ny >= MMBLOCK_SIZE)
+                    continue;
+
+                const Position neighborPos(m_localOrigin.x + nx, m_localOrigin.y + ny, m_localOrigin.z);
+                if(!isWalkable(neighborPos))
+                    continue;
+
+                const Otc::Direction walkDir = currentPos.getDirectionFromPosition(neighborPos);
+                const float walkFactor = walkDir >= Otc::NorthEast ? 3.0f : 1.0f;
+                const float cost = currentCost + (reverse ? currentStepCost : getStepCost(neighborPos)) * walkFactor;
+
+                const int neighborIndex = ny * MMBLOCK_SIZE + nx;
+                LocalNode& neighborNode = getNode(neighborIndex);
+                if(neighborNode.cost <= cost)
+                    continue;
+
+                neighborNode.cost = cost;
+                neighborNode.dir = walkDir;
+                m_localHeap.emplace_back(cost, neighborIndex);
+                std::push_heap(m_localHeap.begin(), m_localHeap.end(), std::greater<std::pair<float, int>>());
+            }
+        }
+    }
+}
+
+float RouteFinder::getLocalCost(const Position& pos)
+{
+    const int x = pos.x - m_localOrigin.x, y = pos.y - m_localOrigin.y;
+    if(pos.z != m_localOrigin.z || x < 0 || y < 0 || x >= MMBLOCK_SIZE || y >= MMBLOCK_SIZE)
+        return std::numeric_limits<float>::max();
+
+    const LocalNode& node = m_localNodes[y * MMBLOCK_SIZE + x];
+    return node.generation == m_localGeneration ? node.cost : std::numeric_limits<float>::max();
+}
+
+bool RouteFinder::appendLocalPath(const Position& from, const Position& to, std::vector<Otc::Direction>& dirs)
+{
+    searchCluster(from, false, &to);
+    if(getLocalCost(to) == std::numeric_limits<float>::max())
+        return false;
+
+    const size_t first = dirs.size();
+    Position pos = to;
+    while(pos != from) {
+        const Otc::Direction dir = m_localNodes[(pos.y - m_localOrigin.y) * MMBLOCK_SIZE + (pos.x - m_localOrigin.x)].dir;
+        dirs.push_back(dir);
+        pos = pos.translatedToReverseDirection(dir);
+    }
+    std::reverse(dirs.begin() + first, dirs.end());
+    return true;
+}
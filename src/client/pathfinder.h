@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PATHFINDER_H
+#define PATHFINDER_H
+
+#include "declarations.h"
+#include "position.h"
+#include "minimap.h"
+
+#include <tuple>
+#include <unordered_map>
+
+// A* search over a flat grid of nodes centered on the start position,
+// the grid is kept between searches and stale nodes are told apart by a generation counter
+class PathFinder
+{
+public:
+    using Result = std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult>;
+
+    // the grid covers this many tiles around the start position in every direction
+    static constexpr int MAX_RADIUS = 256;
+
+    // prepares a new search, returns false when the result is already known
+    bool start(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags);
+    // expands up to maxExpansions nodes, returns true when the search is over
+    bool step(int maxExpansions);
+    Result getResult();
+
+    Result find(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags);
+
+    // whether a search with these flags may step on pos, the goal may hold creatures and non pathable items
+    static bool isWalkable(const Position& pos, uint32 flags, bool isGoal);
+
+private:
+    struct Node {
+        float cost;
+        float totalCost;
+        int prev;
+        int heapIndex;
+        uint32 generation;
+        Otc::Direction dir;
+    };
+
+    float getStepCost(const Position& pos);
+    float getHeuristic(const Position& pos) const { return std::abs(pos.x - m_goalPos.x) + std::abs(pos.y - m_goalPos.y); }
+
+    int getNodeIndex(const Position& pos) const;
+    Position getNodePosition(int index) const;
+    Node& getNode(int index);
+
+    void pushHeap(int index);
+    int popHeap();
+    void siftUp(int heapPos);
+    void siftDown(int heapPos);
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_heap;
+    uint32 m_generation{ 0 };
+    int m_side{ 0 };
+    int m_originX{ 0 }, m_originY{ 0 };
+
+    Position m_startPos, m_goalPos;
+    uint16 m_maxComplexity{ 0 };
+    uint32 m_flags{ 0 };
+    uint32 m_createdNodes{ 0 };
+    int m_goalIndex{ -1 };
+    bool m_finished{ true };
+    Otc::PathFindResult m_result{ Otc::PathFindResultNoWay };
+};
+
+// The last path found towards a goal, kept so that asking again from a position along it only searches
+// around the steps that got blocked since, a detour joins the first walkable step after them
+class PathPlan
+{
+public:
+    using Result = PathFinder::Result;
+
+    // detours are given up for a full search once they expand this many nodes
+    static constexpr uint16 MAX_REPAIR_COMPLEXITY = 2000;
+
+    Result find(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags);
+    void clear() { m_steps.clear(); }
+
+private:
+    Result search(const Position& startPos, const Position& goalPos, uint16 maxComplexity, uint32 flags);
+    bool repair(size_t current);
+    Result getResult(size_t current);
+
+    // every position of the path from where it was planned, the last one is the goal
+    std::vector<Position> m_steps;
+    Position m_goalPos;
+    uint32 m_flags{ 0 };
+};
+
+// Hierarchical search over the minimap for routes far beyond the PathFinder grid.
+// Every minimap block is a cluster, portals sit on the walkable runs shared by neighbor blocks
+// and the costs between portals of the same block are cached until the block path revision changes.
+class RouteFinder
+{
+public:
+    using Result = PathFinder::Result;
+
+    Result find(const Position& startPos, const Position& goalPos);
+    void clear();
+
+private:
+    struct Portal {
+        Position inside;
+        Position outside;
+    };
+
+    struct Link {
+        Position to;
+        float cost;
+    };
+
+    struct Edge {
+        std::vector<Portal> portals;
+        uint32 revisions[2];
+    };
+
+    struct Cluster {
+        stdext::flat_hash_map<Position, std::vector<Link>, Position::Hasher> links;
+        uint32 revisions[5];
+    };
+
+    struct LocalNode {
+        float cost;
+        uint32 generation;
+        Otc::Direction dir;
+    };
+
+    bool isWalkable(const Position& pos);
+    float getStepCost(const Position& pos);
+
+    static uint getClusterIndex(const Position& pos) { return ((pos.y / MMBLOCK_SIZE) * (65536 / MMBLOCK_SIZE)) + (pos.x / MMBLOCK_SIZE); }
+    static Position getClusterOrigin(const Position& pos) { return Position(pos.x - pos.x % MMBLOCK_SIZE, pos.y - pos.y % MMBLOCK_SIZE, pos.z); }
+
+    // east (south = false) or south edge between the cluster holding pos and its neighbor
+    const std::vector<Portal>& getEdge(const Position& pos, bool south);
+    const Cluster& getCluster(const Position& pos);
+
+    // dijkstra restricted to the cluster holding source, reverse searches collect the costs towards source
+    void searchCluster(const Position& source, bool reverse, const Position* target = nullptr);
+    float getLocalCost(const Position& pos);
+    bool appendLocalPath(const Position& from, const Position& to, std::vector<Otc::Direction>& dirs);
+
+    std::unordered_map<uint, Edge> m_edges[Otc::MAX_Z + 1];
+    std::unordered_map<uint, Cluster> m_clusters[Otc::MAX_Z + 1];
+
+    std::array<LocalNode, MMBLOCK_SIZE * MMBLOCK_SIZE> m_localNodes{};
+    std::vector<std::pair<float, int>> m_localHeap;
+    Position m_localOrigin;
+    uint32 m_localGeneration{ 0 };
+};
+
+#endif
@@ -38,7 +38,7 @@ public:
 
     Position(const Position& position) = default;
 
-    Position translatedToDirection(Otc::Direction direction)
+    Position translatedToDirection(Otc::Direction direction) const
     {
         Position pos = *this;
         switch(direction) {
@@ -290,12 +290,24 @@ public:
     int32 y;
     uint8 z;
 
+    // map positions fit in 40 bits, x and y in 16 bits each and z in the byte above them
+    uint64 pack() const { return static_cast<uint64>(static_cast<uint16>(x)) | static_cast<uint64>(static_cast<uint16>(y)) << 16 | static_cast<uint64>(z) << 32; }
+    static Position unpack(uint64 key) { return Position(static_cast<uint16>(key), static_cast<uint16>(key >> 16), static_cast<uint8>(key >> 32)); }
+
     // NOTE: This does not increase the size of the struct.
     struct Hasher
     {
+        // the packed key mixed with the murmur3 finalizer, nearby positions end up far apart,
+        // which open addressing tables need
         std::size_t operator() (const Position& pos) const
         {
-            return (((pos.x * 8192) + pos.y) * 16) + pos.z;
+            uint64 key = pos.pack();
+            key ^= key >> 33;
+            key *= 0xFF51AFD7ED558CCDULL;
+            key ^= key >> 33;
+            key *= 0xC4CEB9FE1A85EC53ULL;
+            key ^= key >> 33;
+            return static_cast<std::size_t>(key);
         }
     };
 };
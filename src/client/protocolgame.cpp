@@ -34,19 +34,39 @@ void ProtocolGame::login(const std::string& accountName, const std::string& acco
     m_sessionKey = sessionKey;
     m_characterName = characterName;
 
+    // movement and combat input is flushed right away, everything else may wait for the batch window
+    static const uint8 urgentOpcodes[] = {
+        Proto::ClientPing, Proto::ClientPingBack, Proto::ClientAutoWalk,
+        Proto::ClientWalkNorth, Proto::ClientWalkEast, Proto::ClientWalkSouth, Proto::ClientWalkWest,
+        Proto::ClientWalkNorthEast, Proto::ClientWalkSouthEast, Proto::ClientWalkSouthWest, Proto::ClientWalkNorthWest,
+        Proto::ClientStop, Proto::ClientTurnNorth, Proto::ClientTurnEast, Proto::ClientTurnSouth, Proto::ClientTurnWest,
+        Proto::ClientUseItem, Proto::ClientUseItemWith, Proto::ClientUseOnCreature,
+        Proto::ClientAttack, Proto::ClientFollow, Proto::ClientCancelAttackAndFollow
+    };
+    for(uint8 opcode : urgentOpcodes)
+        setUrgentOpcode(opcode, true);
+    setWriteBatchDelay(WRITE_BATCH_DELAY);
+
     connect(host, port);
 }
 
-void ProtocolGame::onConnect()
+void ProtocolGame::resetSession()
 {
     m_firstRecv = true;
-    Protocol::onConnect();
-
     m_localPlayer = g_game.getLocalPlayer();
+}
+
+void ProtocolGame::onConnect()
+{
+    resetSession();
+    Protocol::onConnect();
 
     if(g_game.getFeature(Otc::GameProtocolChecksum))
         enableChecksum();
 
+    if(g_game.getFeature(Otc::GamePacketCompression))
+        enableCompression();
+
     if(!g_game.getFeature(Otc::GameChallengeOnLogin))
         sendLoginPacket(0, 0);
 
@@ -30,6 +30,10 @@
 
 class ProtocolGame : public Protocol
 {
+    enum {
+        WRITE_BATCH_DELAY = 2000 // microseconds
+    };
+
 public:
     void login(const std::string& accountName, const std::string& accountPassword, const std::string& host, uint16 port, const std::string& characterName, const std::string& authenticatorToken, const std::string& sessionKey);
     void send(const OutputMessagePtr& outputMessage) override;
@@ -127,6 +131,8 @@ protected:
     void onConnect() override;
     void onRecv(const InputMessagePtr& inputMessage) override;
     void onError(const boost::system::error_code& error) override;
+    // session state that would otherwise be set up when the connection is made
+    void resetSession();
 
     friend class Game;
 
@@ -256,7 +262,28 @@ public:
     ItemPtr getItem(const InputMessagePtr& msg, int id = 0);
     Position getPosition(const InputMessagePtr& msg);
 
+    enum CreatureUpdateAttribute : uint8 {
+        CreatureUpdateHealth = 0,
+        CreatureUpdateSpeed,
+        CreatureUpdateLight,
+        CreatureUpdateOutfit,
+        CREATURE_UPDATE_ATTRIBUTES
+    };
+
 private:
+    struct PendingCreatureUpdate {
+        Outfit outfit;
+        Light light;
+        int speed = 0;
+        int baseSpeed = -1;
+        uint8 healthPercent = 0;
+        uint8 attributes = 0;
+    };
+
+    // null when creature updates are applied right away, see Game::setCoalesceCreatureUpdates
+    PendingCreatureUpdate* queueCreatureUpdate(uint32 id, CreatureUpdateAttribute attribute);
+    void flushCreatureUpdates();
+
     stdext::boolean<false> m_enableSendExtendedOpcode;
     stdext::boolean<false> m_gameInitialized;
     stdext::boolean<false> m_mapKnown;
@@ -266,6 +293,9 @@ private:
     std::string m_authenticatorToken;
     std::string m_sessionKey;
     std::string m_characterName;
+    std::unordered_map<uint32, PendingCreatureUpdate> m_pendingCreatureUpdates;
+    std::vector<uint32> m_pendingCreatureOrder;
+    stdext::boolean<false> m_creatureUpdateFlushPending;
     LocalPlayerPtr m_localPlayer;
 };
 
@@ -30,6 +30,7 @@
 #include "luavaluecasts.h"
 #include "map.h"
 #include "missile.h"
+#include "opcodeprofiler.h"
 #include "thingtypemanager.h"
 #include "tile.h"
 
@@ -41,6 +42,7 @@ void ProtocolGame::parseMessage(const InputMessagePtr& msg)
     try {
         while(!msg->eof()) {
             opcode = msg->getU8();
+            OpcodeProfiler::Scope profile(opcode, msg);
 
             // must be > so extended will be enabled before GameStart.
             if(!g_game.getFeature(Otc::GameLoginPending)) {
@@ -50,6 +52,24 @@ void ProtocolGame::parseMessage(const InputMessagePtr& msg)
                 }
             }
 
+            // queued creature updates go in before anything that could look at those creatures
+            if(!m_pendingCreatureUpdates.empty()) {
+                switch(opcode) {
+                case Proto::GameServerCreatureHealth:
+                case Proto::GameServerCreatureLight:
+                case Proto::GameServerCreatureOutfit:
+                case Proto::GameServerCreatureSpeed:
+                case Proto::GameServerGraphicalEffect:
+                case Proto::GameServerMissleEffect:
+                case Proto::GameServerTextEffect:
+                case Proto::GameServerTextMessage:
+                    break;
+                default:
+                    flushCreatureUpdates();
+                    break;
+                }
+            }
+
             // try to parse in lua first
             const int readPos = msg->getReadPos();
             if(callLuaField<bool>("onOpcode", opcode, msg))
@@ -430,7 +450,7 @@ void ProtocolGame::parseLogin(const InputMessagePtr& msg)
 
     if(g_game.getFeature(Otc::GameIngameStore)) {
         // URL to ingame store images
-        msg->getString();
+        msg->getStringView();
 
         // premium coin package size
         // e.g you can only buy packs of 25, 50, 75, .. coins in the market
@@ -511,7 +531,7 @@ void ProtocolGame::parseStore(const InputMessagePtr& msg)
 
         // If this is a valid category name then
         // the category we just parsed is a child of that
-        msg->getString();
+        msg->getStringView();
     }
 }
 
@@ -572,13 +592,13 @@ void ProtocolGame::parseStoreTransactionHistory(const InputMessagePtr& msg)
 
 void ProtocolGame::parseStoreOffers(const InputMessagePtr& msg)
 {
-    msg->getString(); // categoryName
+    msg->getStringView(); // categoryName
 
     const int offers = msg->getU16();
     for(int i = 0; i < offers; ++i) {
         msg->getU32(); // offerId
-        msg->getString(); // offerName
-        msg->getString(); // offerDescription
+        msg->getStringView(); // offerName
+        msg->getStringView(); // offerDescription
 
         msg->getU32(); // price
         const int highlightState = msg->getU8();
@@ -589,7 +609,7 @@ void ProtocolGame::parseStoreOffers(const InputMessagePtr& msg)
 
         const int disabledState = msg->getU8();
         if(g_game.getFeature(Otc::GameIngameStoreHighlights) && disabledState == 1) {
-            msg->getString(); // disabledReason
+            msg->getStringView(); // disabledReason
         }
 
         std::vector<std::string> icons;
@@ -601,14 +621,14 @@ void ProtocolGame::parseStoreOffers(const InputMessagePtr& msg)
 
         const int subOffers = msg->getU16();
         for(int j = 0; j < subOffers; ++j) {
-            msg->getString(); // name
-            msg->getString(); // description
+            msg->getStringView(); // name
+            msg->getStringView(); // description
 
             const int subIcons = msg->getU8();
             for(int k = 0; k < subIcons; k++) {
-                msg->getString(); // icon
+                msg->getStringView(); // icon
             }
-            msg->getString(); // serviceType
+            msg->getStringView(); // serviceType
         }
     }
 }
@@ -650,7 +670,7 @@ void ProtocolGame::parsePlayerHelpers(const InputMessagePtr& msg)
     if(creature)
         g_game.processPlayerHelpers(helpers);
     else
-        g_logger.traceError(stdext::format("could not get creature with id %d", id));
+        g_logger.traceError(stdext::fmt("could not get creature with id {}", id));
 }
 
 void ProtocolGame::parseGMActions(const InputMessagePtr& msg)
@@ -755,6 +775,9 @@ void ProtocolGame::parseMapDescription(const InputMessagePtr& msg)
     }
 
     g_dispatcher.addEvent([] { g_lua.callGlobalField("g_game", "onMapDescription"); });
+
+    // build what is on screen ahead of the first frames instead of lazily while drawing them
+    g_map.prewarmTextures();
 }
 
 void ProtocolGame::parseMapMoveNorth(const InputMessagePtr& msg)
@@ -884,6 +907,9 @@ void ProtocolGame::parseCreatureMove(const InputMessagePtr& msg)
     creature->allowAppearWalk();
 
     g_map.addThing(thing, newPos, -1);
+
+    if(creature->isLocalPlayer())
+        g_game.processWalkConfirm();
 }
 
 void ProtocolGame::parseOpenContainer(const InputMessagePtr& msg)
@@ -1085,7 +1111,7 @@ void ProtocolGame::parseMagicEffect(const InputMessagePtr& msg)
         effectId = msg->getU8();
 
     if(!g_things.isValidDatId(effectId, ThingCategoryEffect)) {
-        g_logger.traceError(stdext::format("invalid effect id %d", effectId));
+        g_logger.traceError(stdext::fmt("invalid effect id {}", effectId));
         return;
     }
 
@@ -1100,7 +1126,7 @@ void ProtocolGame::parseAnimatedText(const InputMessagePtr& msg)
     const int color = msg->getU8();
     const std::string text = msg->getString();
 
-    AnimatedTextPtr animatedText = AnimatedTextPtr(new AnimatedText);
+    AnimatedTextPtr animatedText = g_map.createAnimatedText();
     animatedText->setColor(color);
     animatedText->setText(text);
     g_map.addThing(animatedText, position);
@@ -1113,7 +1139,7 @@ void ProtocolGame::parseDistanceMissile(const InputMessagePtr& msg)
     const int shotId = msg->getU8();
 
     if(!g_things.isValidDatId(shotId, ThingCategoryMissile)) {
-        g_logger.traceError(stdext::format("invalid missile id %d", shotId));
+        g_logger.traceError(stdext::fmt("invalid missile id {}", shotId));
         return;
     }
 
@@ -1157,6 +1183,11 @@ void ProtocolGame::parseCreatureHealth(const InputMessagePtr& msg)
     const uint id = msg->getU32();
     const int healthPercent = msg->getU8();
 
+    if(PendingCreatureUpdate* update = queueCreatureUpdate(id, CreatureUpdateHealth)) {
+        update->healthPercent = healthPercent;
+        return;
+    }
+
     CreaturePtr creature = g_map.getCreatureById(id);
     if(creature) creature->setHealthPercent(healthPercent);
 }
@@ -1169,6 +1200,11 @@ void ProtocolGame::parseCreatureLight(const InputMessagePtr& msg)
     light.intensity = msg->getU8();
     light.color = msg->getU8();
 
+    if(PendingCreatureUpdate* update = queueCreatureUpdate(id, CreatureUpdateLight)) {
+        update->light = light;
+        return;
+    }
+
     CreaturePtr creature = g_map.getCreatureById(id);
     if(!creature) {
         g_logger.traceError("could not get creature");
@@ -1183,6 +1219,11 @@ void ProtocolGame::parseCreatureOutfit(const InputMessagePtr& msg)
     const uint id = msg->getU32();
     const Outfit outfit = getOutfit(msg);
 
+    if(PendingCreatureUpdate* update = queueCreatureUpdate(id, CreatureUpdateOutfit)) {
+        update->outfit = outfit;
+        return;
+    }
+
     CreaturePtr creature = g_map.getCreatureById(id);
     if(!creature) {
         g_logger.traceError("could not get creature");
@@ -1202,6 +1243,12 @@ void ProtocolGame::parseCreatureSpeed(const InputMessagePtr& msg)
 
     const int speed = msg->getU16();
 
+    if(PendingCreatureUpdate* update = queueCreatureUpdate(id, CreatureUpdateSpeed)) {
+        update->speed = speed;
+        update->baseSpeed = baseSpeed;
+        return;
+    }
+
     CreaturePtr creature = g_map.getCreatureById(id);
     if(!creature) return;
 
@@ -1210,6 +1257,61 @@ void ProtocolGame::parseCreatureSpeed(const InputMessagePtr& msg)
         creature->setBaseSpeed(baseSpeed);
 }
 
+ProtocolGame::PendingCreatureUpdate* ProtocolGame::queueCreatureUpdate(uint32 id, CreatureUpdateAttribute attribute)
+{
+    if(!g_game.isCoalescingCreatureUpdates())
+        return nullptr;
+
+    PendingCreatureUpdate& update = m_pendingCreatureUpdates[id];
+    if(update.attributes == 0)
+        m_pendingCreatureOrder.push_back(id);
+    else if(update.attributes & (1 << attribute))
+        ++g_game.m_mergedCreatureUpdates[attribute];
+    update.attributes |= 1 << attribute;
+
+    // frames already received are parsed before the queued event runs
+    if(!m_creatureUpdateFlushPending) {
+        m_creatureUpdateFlushPending = true;
+        const auto self = static_self_cast<ProtocolGame>();
+        g_dispatcher.addEvent([self] { self->flushCreatureUpdates(); });
+    }
+    return &update;
+}
+
+void ProtocolGame::flushCreatureUpdates()
+{
+    m_creatureUpdateFlushPending = false;
+
+    // the callbacks may parse lua opcodes, so the queue is emptied first
+    std::unordered_map<uint32, PendingCreatureUpdate> updates;
+    std::vector<uint32> order;
+    updates.swap(m_pendingCreatureUpdates);
+    order.swap(m_pendingCreatureOrder);
+
+    for(const uint32 id : order) {
+        const PendingCreatureUpdate& update = updates[id];
+        CreaturePtr creature = g_map.getCreatureById(id);
+        if(!creature) {
+            if(update.attributes & ((1 << CreatureUpdateLight) | (1 << CreatureUpdateOutfit)))
+                g_logger.traceError("could not get creature");
+            continue;
+        }
+
+        if(update.attributes & (1 << CreatureUpdateOutfit))
+            creature->setOutfit(update.outfit);
+        if(update.attributes & (1 << CreatureUpdateLight))
+            creature->setLight(update.light);
+        if(update.attributes & (1 << CreatureUpdateSpeed)) {
+            creature->setSpeed(update.speed);
+            if(update.baseSpeed != -1)
+                creature->setBaseSpeed(update.baseSpeed);
+        }
+        // last, it may kill the creature
+        if(update.attributes & (1 << CreatureUpdateHealth))
+            creature->setHealthPercent(update.healthPercent);
+    }
+}
+
 void ProtocolGame::parseCreatureSkulls(const InputMessagePtr& msg)
 {
     const uint id = msg->getU32();
@@ -1677,7 +1779,7 @@ void ProtocolGame::parseTextMessage(const InputMessagePtr& msg)
         for(int i = 0; i < 2; ++i) {
             if(value[i] == 0)
                 continue;
-            AnimatedTextPtr animatedText = AnimatedTextPtr(new AnimatedText);
+            AnimatedTextPtr animatedText = g_map.createAnimatedText();
             animatedText->setColor(color[i]);
             animatedText->setText(stdext::to_string(value[i]));
             g_map.addThing(animatedText, pos);
@@ -1695,7 +1797,7 @@ void ProtocolGame::parseTextMessage(const InputMessagePtr& msg)
         const int color = msg->getU8();
         text = msg->getString();
 
-        AnimatedTextPtr animatedText = AnimatedTextPtr(new AnimatedText);
+        AnimatedTextPtr animatedText = g_map.createAnimatedText();
         animatedText->setColor(color);
         animatedText->setText(stdext::to_string(value));
         g_map.addThing(animatedText, pos);
@@ -2050,6 +2152,7 @@ void ProtocolGame::setMapDescription(const InputMessagePtr& msg, int x, int y, i
         zstep = -1;
     }
 
+    TileUpdateBatch batch;
     int skip = 0;
     for(int nz = startz; nz != endz + zstep; nz += zstep)
         skip = setFloorDescription(msg, x, y, nz, width, height, z - nz, skip);
@@ -2057,6 +2160,7 @@ void ProtocolGame::setMapDescription(const InputMessagePtr& msg, int x, int y, i
 
 int ProtocolGame::setFloorDescription(const InputMessagePtr& msg, int x, int y, int z, int width, int height, int offset, int skip)
 {
+    TileUpdateBatch batch;
     for(int nx = 0; nx < width; ++nx) {
         for(int ny = 0; ny < height; ++ny) {
             Position tilePos(x + nx + offset, y + ny + offset, z);
@@ -2087,7 +2191,7 @@ int ProtocolGame::setTileDescription(const InputMessagePtr& msg, Position positi
         }
 
         if(stackPos > 10)
-            g_logger.traceError(stdext::format("too many things, pos=%s, stackpos=%d", stdext::to_string(position), stackPos));
+            g_logger.traceError(stdext::fmt("too many things, pos={}, stackpos={}", position, stackPos));
 
         ThingPtr thing = getThing(msg);
         g_map.addThing(thing, position, stackPos);
@@ -2116,7 +2220,7 @@ Outfit ProtocolGame::getOutfit(const InputMessagePtr& msg)
             addons = msg->getU8();
 
         if(!g_things.isValidDatId(lookType, ThingCategoryCreature)) {
-            g_logger.traceError(stdext::format("invalid outfit looktype %d", lookType));
+            g_logger.traceError(stdext::fmt("invalid outfit looktype {}", lookType));
             lookType = 0;
         }
 
@@ -2133,7 +2237,7 @@ Outfit ProtocolGame::getOutfit(const InputMessagePtr& msg)
             outfit.setAuxId(13); // invisible effect id
         } else {
             if(!g_things.isValidDatId(lookTypeEx, ThingCategoryItem)) {
-                g_logger.traceError(stdext::format("invalid outfit looktypeex %d", lookTypeEx));
+                g_logger.traceError(stdext::fmt("invalid outfit looktypeex {}", lookTypeEx));
                 lookTypeEx = 0;
             }
             outfit.setCategory(ThingCategoryItem);
@@ -2181,12 +2285,12 @@ ThingPtr ProtocolGame::getMappedThing(const InputMessagePtr& msg)
         assert(stackpos != UINT8_MAX);
         thing = g_map.getThing(pos, stackpos);
         if(!thing)
-            g_logger.traceError(stdext::format("no thing at pos:%s, stackpos:%d", stdext::to_string(pos), stackpos));
+            g_logger.traceError(stdext::fmt("no thing at pos:{}, stackpos:{}", pos, stackpos));
     } else {
         const uint32 id = msg->getU32();
         thing = g_map.getCreatureById(id);
         if(!thing)
-            g_logger.traceError(stdext::format("no creature with id %u", id));
+            g_logger.traceError(stdext::fmt("no creature with id {}", id));
     }
 
     return thing;
@@ -2228,18 +2332,23 @@ CreaturePtr ProtocolGame::getCreature(const InputMessagePtr& msg, int type)
 
             const std::string name = g_game.formatCreatureName(msg->getString());
 
+            // a creature that went out of the server's known list comes back as the same object
+            const CreaturePtr cached = g_map.takeCachedCreature(id);
+
             if(id == m_localPlayer->getId())
                 creature = m_localPlayer;
             else if(creatureType == Proto::CreatureTypePlayer) {
                 // fixes a bug server side bug where GameInit is not sent and local player id is unknown
                 if(m_localPlayer->getId() == 0 && name == m_localPlayer->getName())
                     creature = m_localPlayer;
+                else if(cached && cached->isPlayer())
+                    creature = cached;
                 else
                     creature = PlayerPtr(new Player);
             } else if(creatureType == Proto::CreatureTypeMonster)
-                creature = MonsterPtr(new Monster);
+                creature = cached && cached->isMonster() ? cached : MonsterPtr(new Monster);
             else if(creatureType == Proto::CreatureTypeNpc)
-                creature = NpcPtr(new Npc);
+                creature = cached && cached->isNpc() ? cached : NpcPtr(new Npc);
             else
                 g_logger.traceError("creature type is invalid");
 
@@ -2376,7 +2485,7 @@ StaticTextPtr ProtocolGame::getStaticText(const InputMessagePtr& msg, int)
     const Color color = Color::from8bit(colorByte);
     const std::string fontName = msg->getString();
     const std::string text = msg->getString();
-    StaticTextPtr staticText = StaticTextPtr(new StaticText);
+    StaticTextPtr staticText = g_map.createStaticText();
     staticText->setText(text);
     staticText->setFont(fontName);
     staticText->setColor(color);
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "protocolgamereplay.h"
+#include "game.h"
+
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+bool ProtocolGameReplay::play(const std::string& fileName, bool realTime)
+{
+    stop();
+
+    try {
+        m_file = g_resources.openFile(fileName);
+        m_file->cache();
+        if(m_file->getU32() != RECORD_SIGNATURE)
+            stdext::throw_exception("not a protocol recording");
+        if(m_file->getU16() != RECORD_VERSION)
+            stdext::throw_exception("unsupported recording version");
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to replay '%s': %s", fileName, e.what()));
+        m_file = nullptr;
+        return false;
+    }
+
+    m_message = InputMessagePtr(new InputMessage);
+    m_realTime = realTime;
+    m_playedMessages = 0;
+    m_startTicks = g_clock.millis();
+    resetSession();
+
+    if(!readNext()) {
+        finish();
+        return true;
+    }
+
+    m_playEvent = g_dispatcher.scheduleEvent(std::bind(&ProtocolGameReplay::playNext, static_self_cast<ProtocolGameReplay>()), 0);
+    return true;
+}
+
+void ProtocolGameReplay::stop()
+{
+    if(m_playEvent) {
+        m_playEvent->cancel();
+        m_playEvent = nullptr;
+    }
+    m_file = nullptr;
+}
+
+void ProtocolGameReplay::playNext()
+{
+    m_playEvent = nullptr;
+
+    stdext::timer budget;
+    while(m_file) {
+        if(m_realTime) {
+            const ticks_t delay = m_startTicks + m_nextTime - g_clock.millis();
+            if(delay > 0) {
+                m_playEvent = g_dispatcher.scheduleEvent(std::bind(&ProtocolGameReplay::playNext, static_self_cast<ProtocolGameReplay>()), delay);
+                return;
+            }
+        } else if(budget.elapsed_millis() >= FAST_REPLAY_BUDGET) {
+            // let a frame render between batches, otherwise the replay measures nothing but parsing
+            m_playEvent = g_dispatcher.scheduleEvent(std::bind(&ProtocolGameReplay::playNext, static_self_cast<ProtocolGameReplay>()), 0);
+            return;
+        }
+
+        m_message->setBuffer(m_nextData);
+        m_playedMessages++;
+        onRecv(m_message);
+
+        if(m_file && !readNext())
+            finish();
+    }
+}
+
+bool ProtocolGameReplay::readNext()
+{
+    try {
+        if(m_file->tell() + 6 > m_file->size())
+            return false;
+
+        m_nextTime = m_file->getU32();
+        m_nextData.resize(m_file->getU16());
+        if(!m_nextData.empty())
+            m_file->read(&m_nextData[0], m_nextData.size());
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Replay stopped on a corrupt record: %s", e.what()));
+        return false;
+    }
+}
+
+void ProtocolGameReplay::finish()
+{
+    stop();
+    g_lua.callGlobalField("g_game", "onReplayEnd", m_playedMessages);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PROTOCOLGAMEREPLAY_H
+#define PROTOCOLGAMEREPLAY_H
+
+#include "protocolgame.h"
+
+// feeds messages recorded by Protocol::startRecording to the game parser instead of a server,
+// either at their recorded pace or as fast as the client can take them
+class ProtocolGameReplay : public ProtocolGame
+{
+    enum {
+        FAST_REPLAY_BUDGET = 10 // milliseconds of parsing before yielding a frame
+    };
+
+public:
+    bool play(const std::string& fileName, bool realTime);
+    void stop();
+
+    bool isPlaying() { return m_file != nullptr; }
+    uint32 getPlayedMessages() { return m_playedMessages; }
+
+    // nothing goes back to a recorded session
+    void send(const OutputMessagePtr&) override {}
+
+private:
+    void playNext();
+    bool readNext();
+    void finish();
+
+    FileStreamPtr m_file;
+    InputMessagePtr m_message;
+    ScheduledEventPtr m_playEvent;
+    std::string m_nextData;
+    uint32 m_nextTime = 0;
+    uint32 m_playedMessages = 0;
+    ticks_t m_startTicks = 0;
+    bool m_realTime = false;
+};
+
+#endif
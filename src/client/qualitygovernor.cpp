@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "qualitygovernor.h"
+#include <framework/core/clock.h>
+
+bool QualityGovernor::update(ticks_t frameMicros)
+{
+    const int level = m_level;
+    if(!m_enabled) {
+        m_level = 0;
+        m_frames = 0;
+        m_frameMicrosSum = 0;
+        m_intervalStart = 0;
+        return level != m_level;
+    }
+
+    const ticks_t now = g_clock.millis();
+    if(m_intervalStart == 0)
+        m_intervalStart = now;
+
+    m_frameMicrosSum += frameMicros;
+    ++m_frames;
+    if(now - m_intervalStart < EVALUATE_INTERVAL)
+        return false;
+
+    m_averageMicros = m_frameMicrosSum / m_frames;
+    m_frames = 0;
+    m_frameMicrosSum = 0;
+    m_intervalStart = now;
+
+    // a level is given back well below the budget, otherwise it would be taken again right away
+    if(m_averageMicros > m_budget) {
+        m_headroomIntervals = 0;
+        m_level = std::min<int>(m_level + 1, m_maxLevel);
+    } else if(m_averageMicros < m_budget * 6 / 10 && m_level > 0) {
+        if(++m_headroomIntervals >= RESTORE_INTERVALS) {
+            m_headroomIntervals = 0;
+            --m_level;
+        }
+    } else
+        m_headroomIntervals = 0;
+
+    m_level = std::min<int>(m_level, m_maxLevel);
+    return level != m_level;
+}
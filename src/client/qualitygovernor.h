@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef QUALITYGOVERNOR_H
+#define QUALITYGOVERNOR_H
+
+#include "declarations.h"
+
+// lowers the map quality while frames take longer than the budget and gives it back once there is headroom
+class QualityGovernor
+{
+public:
+    enum {
+        EVALUATE_INTERVAL = 1000, // milliseconds of frames averaged for each decision
+        RESTORE_INTERVALS = 3 // intervals below the restore threshold before a level is given back
+    };
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() { return m_enabled; }
+    void setBudget(int micros) { m_budget = std::max<int>(micros, 1000); }
+    int getBudget() { return m_budget; }
+    void setMaxLevel(int level) { m_maxLevel = std::max<int>(level, 0); }
+    int getMaxLevel() { return m_maxLevel; }
+
+    // feeds the work time of a frame, true when the level changed
+    bool update(ticks_t frameMicros);
+    int getLevel() { return m_level; }
+    int getAverageMicros() { return m_averageMicros; }
+
+private:
+    bool m_enabled = false;
+    int m_budget = 16666;
+    int m_maxLevel = 0;
+    int m_level = 0;
+    int m_averageMicros = 0;
+    int m_headroomIntervals = 0;
+    int m_frames = 0;
+    ticks_t m_frameMicrosSum = 0;
+    ticks_t m_intervalStart = 0;
+};
+
+#endif
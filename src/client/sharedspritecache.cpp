@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "sharedspritecache.h"
+#include <cstring>
+#include <thread>
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const uint32 SEGMENT_MAGIC = 0x43535443; // "CTSC"
+    const uint32 SEGMENT_VERSION = 1;
+    // a client that finds the segment waits this long for the one that created it to write the header
+    const int HEADER_WAIT_MS = 500;
+
+    struct SegmentHeader {
+        std::atomic<uint32> magic;
+        uint32 version;
+        uint32 signature;
+        uint32 spritesCount;
+        uint32 alpha;
+    };
+
+    static_assert(std::atomic<uint8>::is_always_lock_free && std::atomic<uint32>::is_always_lock_free,
+                  "atomics shared between processes must be lock free");
+}
+
+bool SharedSpriteCache::open(uint32 signature, int spritesCount, bool alpha)
+{
+    close();
+    if(spritesCount <= 0)
+        return false;
+
+    // one state byte per sprite, pixel slots start on a page so each slot is a whole number of pages
+    m_statesOffset = sizeof(SegmentHeader);
+    m_pixelsOffset = (m_statesOffset + spritesCount + 4095) & ~static_cast<size_t>(4095);
+    const size_t size = m_pixelsOffset + static_cast<size_t>(spritesCount) * SLOT_SIZE;
+    const std::string name = stdext::format("otclient-spr-%08x-%d-%d", signature, spritesCount, alpha ? 1 : 0);
+
+    void* data = nullptr;
+#ifdef WIN32
+    const std::wstring mappingName = stdext::utf8_to_utf16("Local\\" + name);
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64>(size) >> 32), static_cast<DWORD>(size), mappingName.c_str());
+    if(!mapping)
+        return false;
+    m_created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+    // the view keeps the mapping alive, the segment goes away with the last client
+    data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    CloseHandle(mapping);
+    if(!data)
+        return false;
+#else
+    const std::string shmName = "/" + name;
+    int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    m_created = fd != -1;
+    if(m_created) {
+        // pages are only backed once a slot is written
+        if(ftruncate(fd, size) == -1) {
+            ::close(fd);
+            shm_unlink(shmName.c_str());
+            return false;
+        }
+    } else {
+        fd = shm_open(shmName.c_str(), O_RDWR, 0600);
+        if(fd == -1)
+            return false;
+
+        struct stat st;
+        if(fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) != size) {
+            ::close(fd);
+            return false;
+        }
+    }
+
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        return false;
+#endif
+
+    m_data = static_cast<uint8*>(data);
+    m_size = size;
+    m_spritesCount = spritesCount;
+
+    SegmentHeader* header = reinterpret_cast<SegmentHeader*>(m_data);
+    if(m_created) {
+        header->version = SEGMENT_VERSION;
+        header->signature = signature;
+        header->spritesCount = spritesCount;
+        header->alpha = alpha ? 1 : 0;
+        header->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    for(int waited = 0; header->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC && waited < HEADER_WAIT_MS; ++waited)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    if(header->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC || header->version != SEGMENT_VERSION ||
+       header->signature != signature || header->spritesCount != static_cast<uint32>(spritesCount) || header->alpha != (alpha ? 1u : 0u)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SharedSpriteCache::close()
+{
+    if(!m_data)
+        return;
+
+#ifdef WIN32
+    UnmapViewOfFile(m_data);
+#else
+    munmap(m_data, m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_spritesCount = 0;
+    m_created = false;
+    m_hits = m_misses = m_stores = 0;
+}
+
+bool SharedSpriteCache::read(int id, uint8* pixels, bool& decoded, bool& transparent)
+{
+    if(!m_data || id <= 0 || id > m_spritesCount)
+        return false;
+
+    const uint8 state = getStates()[id - 1].load(std::memory_order_acquire);
+    if(state == SlotEmpty) {
+        ++m_misses;
+        return false;
+    }
+
+    ++m_hits;
+    decoded = state != SlotMissing;
+    transparent = state == SlotTransparent;
+    if(decoded)
+        std::memcpy(pixels, getPixels(id), SLOT_SIZE);
+    return true;
+}
+
+void SharedSpriteCache::write(int id, const uint8* pixels, bool decoded, bool transparent)
+{
+    if(!m_data || id <= 0 || id > m_spritesCount)
+        return;
+
+    // clients racing on a slot write the same pixels, the state is published after them
+    std::atomic<uint8>& state = getStates()[id - 1];
+    if(state.load(std::memory_order_acquire) != SlotEmpty)
+        return;
+
+    if(decoded)
+        std::memcpy(getPixels(id), pixels, SLOT_SIZE);
+    state.store(!decoded ? SlotMissing : (transparent ? SlotTransparent : SlotOpaque), std::memory_order_release);
+    ++m_stores;
+}
+
+std::map<std::string, int> SharedSpriteCache::getStatistics()
+{
+    std::map<std::string, int> stats;
+    stats["open"] = m_data ? 1 : 0;
+    stats["created"] = m_created ? 1 : 0;
+    stats["sprites"] = m_spritesCount;
+    stats["hits"] = m_hits;
+    stats["misses"] = m_misses;
+    stats["stores"] = m_stores;
+    return stats;
+}
+
+uint8* SharedSpriteCache::getPixels(int id)
+{
+    return m_data + m_pixelsOffset + static_cast<size_t>(id - 1) * SLOT_SIZE;
+}
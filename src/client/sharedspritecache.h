@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef SHAREDSPRITECACHE_H
+#define SHAREDSPRITECACHE_H
+
+#include "declarations.h"
+
+// Decoded sprite pixels in a shared memory segment named after the spr signature, so the clients of a host
+// running the same spr decode each sprite once. Slots are filled by whichever client decodes a sprite first
+// and are read by the others. POSIX segments outlive the clients until the host restarts, windows ones go
+// away with the last client.
+class SharedSpriteCache
+{
+public:
+    enum {
+        // decoded RGBA pixels of a 32x32 sprite
+        SLOT_SIZE = 32 * 32 * 4
+    };
+
+    ~SharedSpriteCache() { close(); }
+
+    // creates the segment when this is the first client, otherwise maps the one of the running clients
+    bool open(uint32 signature, int spritesCount, bool alpha);
+    void close();
+    bool isOpen() { return m_data != nullptr; }
+
+    // returns false when no client decoded the sprite yet, decoded is false for sprites the spr does not have
+    bool read(int id, uint8* pixels, bool& decoded, bool& transparent);
+    void write(int id, const uint8* pixels, bool decoded, bool transparent);
+
+    // safe to call from async dispatcher threads
+    std::map<std::string, int> getStatistics();
+
+private:
+    enum SlotState : uint8 {
+        SlotEmpty,
+        SlotOpaque,
+        SlotTransparent,
+        SlotMissing
+    };
+
+    std::atomic<uint8>* getStates() { return reinterpret_cast<std::atomic<uint8>*>(m_data + m_statesOffset); }
+    uint8* getPixels(int id);
+
+    uint8* m_data{ nullptr };
+    size_t m_size{ 0 };
+    size_t m_statesOffset{ 0 };
+    size_t m_pixelsOffset{ 0 };
+    int m_spritesCount{ 0 };
+    bool m_created{ false };
+    std::atomic<int> m_hits{ 0 }, m_misses{ 0 }, m_stores{ 0 };
+};
+
+#endif
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "spectatortracker.h"
+#include "creature.h"
+#include "game.h"
+#include "localplayer.h"
+#include "map.h"
+#include <framework/core/eventdispatcher.h>
+#include <framework/luaengine/luainterface.h>
+
+SpectatorTracker g_spectatorTracker;
+
+void SpectatorTracker::terminate()
+{
+    m_enabled = false;
+    m_entries.clear();
+    m_order.clear();
+    m_deltas.clear();
+}
+
+void SpectatorTracker::setEnabled(bool enabled)
+{
+    if(m_enabled == enabled)
+        return;
+
+    m_enabled = enabled;
+    if(m_enabled)
+        refresh();
+    else
+        clear();
+}
+
+void SpectatorTracker::setFilters(int filters)
+{
+    if(m_filters == filters)
+        return;
+
+    m_filters = filters;
+    refresh();
+}
+
+void SpectatorTracker::setSortType(int sortType)
+{
+    if(m_sortType == sortType)
+        return;
+
+    m_sortType = sortType;
+    sortEntries();
+}
+
+void SpectatorTracker::setSortDescending(bool descending)
+{
+    if(m_sortDescending == descending)
+        return;
+
+    m_sortDescending = descending;
+    sortEntries();
+}
+
+void SpectatorTracker::setRange(int xRange, int yRange)
+{
+    xRange = std::max<int>(xRange, 0);
+    yRange = std::max<int>(yRange, 0);
+    if(m_xRange == xRange && m_yRange == yRange)
+        return;
+
+    m_xRange = xRange;
+    m_yRange = yRange;
+    refresh();
+}
+
+void SpectatorTracker::setFloorRange(int floors)
+{
+    floors = stdext::clamp<int>(floors, 0, Otc::MAX_Z);
+    if(m_floorRange == floors)
+        return;
+
+    m_floorRange = floors;
+    refresh();
+}
+
+std::vector<CreaturePtr> SpectatorTracker::getSpectators()
+{
+    std::vector<CreaturePtr> spectators;
+    spectators.reserve(m_order.size());
+    for(const Entry* entry : m_order)
+        spectators.push_back(entry->creature);
+    return spectators;
+}
+
+int SpectatorTracker::getSpectatorIndex(const CreaturePtr& creature)
+{
+    if(!creature)
+        return 0;
+
+    const auto it = m_entries.find(creature->getId());
+    if(it == m_entries.end())
+        return 0;
+    return findIndex(&it->second) + 1;
+}
+
+void SpectatorTracker::refresh()
+{
+    if(!m_enabled)
+        return;
+
+    const Position center = getCenter();
+    if(!center.isValid()) {
+        clear();
+        return;
+    }
+
+    // drop the creatures that left while the order still matches the stored keys,
+    // then the distances of the others change with the center
+    std::vector<uint32> leaving;
+    for(const auto& it : m_entries) {
+        if(!fits(it.second.creature, center))
+            leaving.push_back(it.first);
+    }
+    for(const uint32 id : leaving)
+        removeEntry(id);
+
+    for(auto& it : m_entries)
+        fill(it.second, center);
+    sortEntries();
+
+    const bool multiFloor = m_floorRange > 0;
+    for(const CreaturePtr& creature : g_map.getSpectatorsInRangeEx(center, multiFloor, m_xRange, m_xRange, m_yRange, m_yRange)) {
+        if(m_entries.find(creature->getId()) == m_entries.end())
+            onCreatureChange(creature);
+    }
+}
+
+void SpectatorTracker::clear()
+{
+    // the removals are reported from the back so the indexes stay valid
+    while(!m_order.empty())
+        removeEntry(m_order.back()->id);
+}
+
+void SpectatorTracker::onCreatureChange(const CreaturePtr& creature)
+{
+    if(!m_enabled || !creature || creature->isLocalPlayer())
+        return;
+
+    const Position center = getCenter();
+    const uint32 id = creature->getId();
+    auto it = m_entries.find(id);
+    if(!center.isValid() || !fits(creature, center)) {
+        if(it != m_entries.end())
+            removeEntry(id);
+        return;
+    }
+
+    if(it == m_entries.end()) {
+        Entry& entry = m_entries[id];
+        entry.creature = creature;
+        entry.id = id;
+        entry.age = ++m_lastAge;
+        fill(entry, center);
+        pushDelta(SpectatorAdd, creature, insertEntry(&entry) + 1);
+        return;
+    }
+
+    Entry& entry = it->second;
+    const int oldIndex = findIndex(&entry);
+    m_order.erase(m_order.begin() + oldIndex);
+    fill(entry, center);
+    const int newIndex = insertEntry(&entry);
+    if(newIndex != oldIndex)
+        pushDelta(SpectatorMove, creature, newIndex + 1);
+}
+
+void SpectatorTracker::onCreatureMove(const CreaturePtr& creature, const Position& newPos, const Position& oldPos)
+{
+    if(!m_enabled || !creature)
+        return;
+
+    if(creature->isLocalPlayer()) {
+        if(newPos != oldPos)
+            refresh();
+        return;
+    }
+
+    onCreatureChange(creature);
+}
+
+void SpectatorTracker::onCreatureRemove(const CreaturePtr& creature)
+{
+    if(m_enabled && creature && m_entries.find(creature->getId()) != m_entries.end())
+        removeEntry(creature->getId());
+}
+
+bool SpectatorTracker::fits(const CreaturePtr& creature, const Position& center)
+{
+    const Position& pos = creature->getPosition();
+    if(!pos.isValid() || std::abs(pos.z - center.z) > m_floorRange || !center.isInRange(pos, m_xRange, m_yRange, true))
+        return false;
+
+    if(!creature->canBeSeen())
+        return false;
+
+    if(creature->isPlayer()) {
+        if(m_filters & HidePlayers)
+            return false;
+        if((m_filters & HideUnskulled) && creature->getSkull() == Otc::SkullNone)
+            return false;
+    } else if(creature->isNpc()) {
+        if(m_filters & HideNpcs)
+            return false;
+    } else if(creature->isMonster()) {
+        if(m_filters & HideMonsters)
+            return false;
+    }
+
+    if((m_filters & HideParty) && creature->getShield() > Otc::ShieldWhiteBlue)
+        return false;
+
+    return true;
+}
+
+void SpectatorTracker::fill(Entry& entry, const Position& center)
+{
+    const CreaturePtr& creature = entry.creature;
+    const Position& pos = creature->getPosition();
+    entry.distance = std::max<int>(std::abs(pos.x - center.x), std::abs(pos.y - center.y));
+    entry.health = creature->getHealthPercent();
+    entry.name = creature->getName();
+    stdext::tolower(entry.name);
+}
+
+bool SpectatorTracker::isBefore(const Entry* a, const Entry* b)
+{
+    // ids break the ties, so every creature has a single place
+    const Entry* first = m_sortDescending ? b : a;
+    const Entry* second = m_sortDescending ? a : b;
+    switch(m_sortType) {
+        case SortByDistance:
+            if(first->distance != second->distance)
+                return first->distance < second->distance;
+            break;
+        case SortByHealth:
+            if(first->health != second->health)
+                return first->health < second->health;
+            break;
+        case SortByAge:
+            if(first->age != second->age)
+                return first->age < second->age;
+            break;
+        default:
+            if(first->name != second->name)
+                return first->name < second->name;
+            break;
+    }
+    return first->id < second->id;
+}
+
+int SpectatorTracker::findIndex(const Entry* entry)
+{
+    const auto it = std::lower_bound(m_order.begin(), m_order.end(), entry,
+                                     [this](const Entry* a, const Entry* b) { return isBefore(a, b); });
+    assert(it != m_order.end() && *it == entry);
+    return it - m_order.begin();
+}
+
+int SpectatorTracker::insertEntry(Entry* entry)
+{
+    const auto it = std::lower_bound(m_order.begin(), m_order.end(), entry,
+                                     [this](const Entry* a, const Entry* b) { return isBefore(a, b); });
+    const int index = it - m_order.begin();
+    m_order.insert(it, entry);
+    return index;
+}
+
+void SpectatorTracker::removeEntry(uint32 id)
+{
+    const auto it = m_entries.find(id);
+    if(it == m_entries.end())
+        return;
+
+    const CreaturePtr creature = it->second.creature;
+    const int index = findIndex(&it->second);
+    m_order.erase(m_order.begin() + index);
+    m_entries.erase(it);
+    pushDelta(SpectatorRemove, creature, index + 1);
+}
+
+void SpectatorTracker::sortEntries()
+{
+    // an insertion sort, after a step or a single change only a few creatures move
+    for(size_t i = 1; i < m_order.size(); ++i) {
+        Entry* entry = m_order[i];
+        size_t j = i;
+        while(j > 0 && isBefore(entry, m_order[j - 1])) {
+            m_order[j] = m_order[j - 1];
+            --j;
+        }
+        if(j != i) {
+            m_order[j] = entry;
+            pushDelta(SpectatorMove, entry->creature, j + 1);
+        }
+    }
+}
+
+void SpectatorTracker::pushDelta(DeltaType type, const CreaturePtr& creature, int index)
+{
+    m_deltas.emplace_back(type, creature, index);
+
+    if(m_deltaFlushPending)
+        return;
+
+    m_deltaFlushPending = true;
+    g_dispatcher.addEvent([] { g_spectatorTracker.flushDeltas(); });
+}
+
+void SpectatorTracker::flushDeltas()
+{
+    m_deltaFlushPending = false;
+
+    std::vector<std::tuple<uint8, CreaturePtr, int>> deltas;
+    deltas.swap(m_deltas);
+    if(deltas.empty())
+        return;
+
+    g_lua.callGlobalField("g_spectatorTracker", "onSpectatorsChange", deltas);
+}
+
+Position SpectatorTracker::getCenter()
+{
+    const LocalPlayerPtr& player = g_game.getLocalPlayer();
+    if(!player)
+        return Position();
+    return player->getPosition();
+}
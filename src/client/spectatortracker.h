@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SPECTATORTRACKER_H
+#define SPECTATORTRACKER_H
+
+#include "declarations.h"
+
+// creatures around the local player that pass the battle list filters, kept sorted as creatures
+// appear, move or change and reported to g_spectatorTracker.onSpectatorsChange(deltas) once per frame,
+// nothing is done while it is disabled or nothing changes
+class SpectatorTracker
+{
+public:
+    enum Filter : uint8 {
+        HidePlayers = 1 << 0,
+        HideNpcs = 1 << 1,
+        HideMonsters = 1 << 2,
+        HideUnskulled = 1 << 3, // players without a skull
+        HideParty = 1 << 4
+    };
+
+    enum SortType : uint8 {
+        SortByName = 0,
+        SortByDistance,
+        SortByHealth,
+        SortByAge
+    };
+
+    // every delta is { type, creature, index } with 1 based indexes valid right after the previous
+    // deltas were applied, the removed index is where the creature was, the others where it is now
+    enum DeltaType : uint8 {
+        SpectatorAdd = 0,
+        SpectatorRemove,
+        SpectatorMove
+    };
+
+    void terminate();
+
+    void setEnabled(bool enabled);
+    void setFilters(int filters);
+    void setSortType(int sortType);
+    void setSortDescending(bool descending);
+    void setRange(int xRange, int yRange);
+    // floors above and below the local player that are still tracked
+    void setFloorRange(int floors);
+
+    bool isEnabled() { return m_enabled; }
+    int getFilters() { return m_filters; }
+    int getSortType() { return m_sortType; }
+    bool isSortDescending() { return m_sortDescending; }
+    int getFloorRange() { return m_floorRange; }
+    std::vector<CreaturePtr> getSpectators();
+    int getSpectatorIndex(const CreaturePtr& creature);
+
+    // checks every tracked creature again and scans the map for new ones
+    void refresh();
+    void clear();
+
+    void onCreatureChange(const CreaturePtr& creature);
+    void onCreatureMove(const CreaturePtr& creature, const Position& newPos, const Position& oldPos);
+    void onCreatureRemove(const CreaturePtr& creature);
+
+private:
+    struct Entry {
+        CreaturePtr creature;
+        std::string name;
+        uint32 id;
+        uint32 age;
+        int distance;
+        uint8 health;
+    };
+
+    bool fits(const CreaturePtr& creature, const Position& center);
+    void fill(Entry& entry, const Position& center);
+    bool isBefore(const Entry* a, const Entry* b);
+    int findIndex(const Entry* entry);
+    int insertEntry(Entry* entry);
+    void removeEntry(uint32 id);
+    void sortEntries();
+    void pushDelta(DeltaType type, const CreaturePtr& creature, int index);
+    void flushDeltas();
+    Position getCenter();
+
+    std::unordered_map<uint32, Entry> m_entries;
+    std::vector<Entry*> m_order;
+    std::vector<std::tuple<uint8, CreaturePtr, int>> m_deltas;
+    uint32 m_lastAge = 0;
+    int m_xRange = 7;
+    int m_yRange = 5;
+    int m_floorRange = 0;
+    uint8 m_filters = 0;
+    uint8 m_sortType = SortByName;
+    bool m_sortDescending = false;
+    bool m_enabled = false;
+    bool m_deltaFlushPending = false;
+};
+
+extern SpectatorTracker g_spectatorTracker;
+
+#endif
@@ -21,10 +21,19 @@
  */
 
 #include "spritemanager.h"
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/image.h>
 #include "game.h"
+#include <cstring>
+#include <thread>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
 
 SpriteManager g_sprites;
 
@@ -41,9 +50,13 @@ void SpriteManager::terminate()
 
 bool SpriteManager::loadSpr(std::string file)
 {
+    m_loaded = false;
+    waitReaders();
+
     m_spritesCount = 0;
     m_signature = 0;
-    m_loaded = false;
+    m_spritesData = nullptr;
+    m_spritesDataSize = 0;
     try {
         file = g_resources.guessFilePath(file, "spr");
 
@@ -54,6 +67,12 @@ bool SpriteManager::loadSpr(std::string file)
         m_signature = m_spritesFile->getU32();
         m_spritesCount = g_game.getFeature(Otc::GameSpritesU32) ? m_spritesFile->getU32() : m_spritesFile->getU16();
         m_spritesOffset = m_spritesFile->tell();
+        m_spritesAlpha = g_game.getFeature(Otc::GameSpritesAlphaChannel);
+        m_spritesData = m_spritesFile->cachedData();
+        m_spritesDataSize = m_spritesFile->cachedSize();
+        m_sharedCache.close();
+        if(m_useSharedCache && !m_sharedCache.open(m_signature, m_spritesCount, m_spritesAlpha))
+            g_logger.warning(stdext::format("Unable to share the decoded sprites of '%s'", file));
         m_loaded = true;
         g_lua.callGlobalField("g_sprites", "onLoadSpr", file);
         return true;
@@ -68,50 +87,143 @@ void SpriteManager::saveSpr(const std::string& fileName)
     if(!m_loaded)
         stdext::throw_exception("failed to save, spr is not loaded");
 
+    // sprite data is copied in chunks of this size instead of one file write per field
+    constexpr uint WRITE_BUFFER_SIZE = 256 * 1024;
+    constexpr int HASH_CHUNK_SPRITES = 4096;
+
     try {
+        stdext::timer timer;
+
+        // color key, data size and pixels of every sprite are located and hashed in parallel,
+        // chunks are claimed by the workers and the main thread, which waits for all of them
+        struct Record {
+            uint32 address{ 0 };
+            uint32 size{ 0 };
+            uint64 hash{ 0 };
+        };
+        struct Pass {
+            std::atomic<int> next{ 0 }, done{ 0 };
+            std::vector<Record> records;
+            const uint8* data;
+            uint dataSize;
+            int spritesOffset;
+            int chunks;
+        };
+
+        const auto pass = std::make_shared<Pass>();
+        pass->records.resize(m_spritesCount);
+        pass->data = m_spritesData;
+        pass->dataSize = m_spritesDataSize;
+        pass->spritesOffset = m_spritesOffset;
+        pass->chunks = (m_spritesCount + HASH_CHUNK_SPRITES - 1) / HASH_CHUNK_SPRITES;
+
+        const auto hashChunks = [](Pass& pass) {
+            for(int chunk; (chunk = pass.next++) < pass.chunks; ++pass.done) {
+                const int last = std::min<int>((chunk + 1) * HASH_CHUNK_SPRITES, pass.records.size());
+                for(int i = chunk * HASH_CHUNK_SPRITES; i < last; ++i) {
+                    const uint addressPos = i * 4 + pass.spritesOffset;
+                    if(addressPos + 4 > pass.dataSize)
+                        continue;
+
+                    const uint32 address = stdext::readULE32(pass.data + addressPos);
+                    if(address == 0 || address + 5 > pass.dataSize)
+                        continue;
+
+                    const uint32 size = 5 + stdext::readULE16(pass.data + address + 3);
+                    if(address + size > pass.dataSize)
+                        continue;
+
+                    pass.records[i] = { address, size, stdext::fnv1a64(pass.data + address, size) };
+                }
+            }
+        };
+
+        const int workers = std::min<int>(g_asyncDispatcher.getThreadCount(), pass->chunks - 1);
+        for(int i = 0; i < workers; ++i)
+            g_asyncDispatcher.schedule([pass, hashChunks] { hashChunks(*pass); });
+        hashChunks(*pass);
+        while(pass->done < pass->chunks)
+            std::this_thread::yield();
+
+        // identical sprites point to the first copy, hashes only pick the candidates that are compared
+        const bool u32Count = g_game.getFeature(Otc::GameSpritesU32);
+        const uint32 tableOffset = 4 + (u32Count ? 4 : 2);
+        uint32 spriteAddress = tableOffset + 4 * m_spritesCount;
+
+        std::vector<uint32> addresses(m_spritesCount, 0);
+        std::vector<int> uniqueSprites;
+        std::unordered_map<uint64, std::vector<int>> written;
+        uint64 inputBytes = 0;
+        int sharedSprites = 0;
+        for(int i = 0; i < m_spritesCount; ++i) {
+            const Record& record = pass->records[i];
+            if(record.size == 0)
+                continue;
+
+            inputBytes += record.size;
+            std::vector<int>& candidates = written[record.hash];
+            const auto it = std::find_if(candidates.begin(), candidates.end(), [&](int other) {
+                const Record& otherRecord = pass->records[other];
+                return otherRecord.size == record.size && std::memcmp(pass->data + otherRecord.address, pass->data + record.address, record.size) == 0;
+            });
+            if(it != candidates.end()) {
+                addresses[i] = addresses[*it];
+                ++sharedSprites;
+                continue;
+            }
+
+            candidates.push_back(i);
+            uniqueSprites.push_back(i);
+            addresses[i] = spriteAddress;
+            spriteAddress += record.size;
+        }
+
         FileStreamPtr fin = g_resources.createFile(fileName);
         if(!fin)
             stdext::throw_exception(stdext::format("failed to open file '%s' for write", fileName));
 
-        fin->cache();
-
-        fin->addU32(m_signature);
-        if(g_game.getFeature(Otc::GameSpritesU32))
-            fin->addU32(m_spritesCount);
-        else
-            fin->addU16(m_spritesCount);
-
-        const uint32 offset = fin->tell();
-        uint32 spriteAddress = offset + 4 * m_spritesCount;
-        for(int i = 1; i <= m_spritesCount; ++i)
-            fin->addU32(0);
-
-        for(int i = 1; i <= m_spritesCount; ++i) {
-            m_spritesFile->seek((i - 1) * 4 + m_spritesOffset);
-            const uint32 fromAdress = m_spritesFile->getU32();
-            if(fromAdress != 0) {
-                fin->seek(offset + (i - 1) * 4);
-                fin->addU32(spriteAddress);
-                fin->seek(spriteAddress);
-
-                m_spritesFile->seek(fromAdress);
-                fin->addU8(m_spritesFile->getU8());
-                fin->addU8(m_spritesFile->getU8());
-                fin->addU8(m_spritesFile->getU8());
-
-                const uint16 dataSize = m_spritesFile->getU16();
-                fin->addU16(dataSize);
-                char spriteData[SPRITE_DATA_SIZE];
-                m_spritesFile->read(spriteData, dataSize);
-                fin->write(spriteData, dataSize);
-
-                spriteAddress = fin->tell();
+        // every address is known up front, so the file is written front to back without seeking
+        std::vector<uint8> buffer;
+        buffer.reserve(WRITE_BUFFER_SIZE);
+        const auto append = [&](const uint8* bytes, uint count) {
+            if(buffer.size() + count > WRITE_BUFFER_SIZE) {
+                fin->write(buffer.data(), buffer.size());
+                buffer.clear();
             }
-            //TODO: Check for overwritten sprites.
+            if(count > WRITE_BUFFER_SIZE)
+                fin->write(bytes, count);
+            else
+                buffer.insert(buffer.end(), bytes, bytes + count);
+        };
+
+        uint8 field[4];
+        stdext::writeULE32(field, m_signature);
+        append(field, 4);
+        if(u32Count) {
+            stdext::writeULE32(field, m_spritesCount);
+            append(field, 4);
+        } else {
+            stdext::writeULE16(field, m_spritesCount);
+            append(field, 2);
+        }
+
+        for(const uint32 address : addresses) {
+            stdext::writeULE32(field, address);
+            append(field, 4);
         }
 
+        for(const int i : uniqueSprites)
+            append(pass->data + pass->records[i].address, pass->records[i].size);
+
+        fin->write(buffer.data(), buffer.size());
         fin->flush();
         fin->close();
+
+        const uint64 outputBytes = spriteAddress - tableOffset - 4 * m_spritesCount;
+        const ticks_t elapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+        g_logger.info(stdext::format("Saved %d sprites to '%s' in %.2f ms (%.1f MB/s), %d identical sprites share data, %.1f KB saved",
+                                     m_spritesCount, fileName, elapsed / 1000.0, inputBytes / (double)elapsed,
+                                     sharedSprites, (inputBytes - outputBytes) / 1024.0));
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to save '%s': %s", fileName, e.what()));
     }
@@ -119,99 +231,238 @@ void SpriteManager::saveSpr(const std::string& fileName)
 
 void SpriteManager::unload()
 {
+    m_loaded = false;
+    waitReaders();
+
     m_spritesCount = 0;
     m_signature = 0;
+    m_spritesData = nullptr;
+    m_spritesDataSize = 0;
     m_spritesFile = nullptr;
+    m_sharedCache.close();
+}
+
+void SpriteManager::setSharedCache(bool enable)
+{
+    static_assert(static_cast<int>(SharedSpriteCache::SLOT_SIZE) == static_cast<int>(SPRITE_DATA_SIZE), "shared slots must hold a decoded sprite");
+
+    if(enable == m_useSharedCache)
+        return;
+
+    m_useSharedCache = enable;
+    if(!m_loaded)
+        return;
+
+    // decoders may be reading the segment, they are kept out while it is mapped or unmapped
+    m_loaded = false;
+    waitReaders();
+    if(!enable)
+        m_sharedCache.close();
+    else if(!m_sharedCache.open(m_signature, m_spritesCount, m_spritesAlpha))
+        g_logger.warning("Unable to share the decoded sprites");
+    m_loaded = true;
+}
+
+void SpriteManager::waitReaders()
+{
+    // decoders running in the async dispatcher must leave the buffer before it is released
+    while(m_readers > 0)
+        std::this_thread::yield();
 }
 
 ImagePtr SpriteManager::getSpriteImage(int id)
 {
-    try {
-        if(id == 0 || !m_spritesFile)
-            return nullptr;
+    alignas(16) uint8 pixels[SPRITE_DATA_SIZE];
+    bool transparent;
+    if(!readSprite(id, pixels, transparent))
+        return nullptr;
 
-        m_spritesFile->seek(((id - 1) * 4) + m_spritesOffset);
+    ImagePtr image(new Image(Size(SPRITE_SIZE, SPRITE_SIZE), 4, pixels));
+    image->setTransparentPixel(transparent);
+    return image;
+}
 
-        const uint32 spriteAddress = m_spritesFile->getU32();
+bool SpriteManager::decodeSpriteInto(int id, uint8* dest, uint stride, SpriteFilter filter, const Color& filterColor, bool* transparent)
+{
+    // decoded on the stack because runs of pixels wrap around rows, the filter and the copy share one pass over it
+    alignas(16) uint8 pixels[SPRITE_DATA_SIZE];
+    bool spriteTransparent = true;
+    const bool decoded = readSprite(id, pixels, spriteTransparent);
+    if(transparent)
+        *transparent = !decoded || spriteTransparent;
+    if(!decoded)
+        return false;
+
+    static const Color maskColors[] = { Color::red, Color::green, Color::blue, Color::yellow };
+    for(int y = 0; y < SPRITE_SIZE; ++y) {
+        uint8* row = pixels + y * SPRITE_SIZE * 4;
+        if(filter == FilterOverwrite)
+            Image::overwritePixels(row, SPRITE_SIZE, filterColor);
+        else if(filter == FilterMask)
+            Image::maskPixels(row, SPRITE_SIZE, filterColor);
+        else if(filter == FilterKeepMasks) {
+            uint8* pixel = row;
+            for(int x = 0; x < SPRITE_SIZE; ++x, pixel += 4) {
+                if(std::find(std::begin(maskColors), std::end(maskColors), Color(pixel[0], pixel[1], pixel[2], pixel[3])) == std::end(maskColors))
+                    std::memset(pixel, 0, 4);
+            }
+        }
+        Image::blitPixels(dest + y * stride, row, SPRITE_SIZE);
+    }
+    return true;
+}
 
-        // no sprite? return an empty texture
-        if(spriteAddress == 0)
-            return nullptr;
+bool SpriteManager::readSprite(int id, uint8* pixels, bool& transparent)
+{
+    if(id <= 0)
+        return false;
 
-        m_spritesFile->seek(spriteAddress);
+    // readers are counted before looking at the loaded flag, so unload() can wait for them to finish
+    ++m_readers;
+    bool decoded = false;
+    if(m_loaded && id <= m_spritesCount && !m_sharedCache.read(id, pixels, decoded, transparent)) {
+        decoded = decodeSprite(id, pixels, transparent);
+        m_sharedCache.write(id, pixels, decoded, transparent);
+    }
+    --m_readers;
+    return decoded;
+}
 
-        // skip color key
-        m_spritesFile->getU8();
-        m_spritesFile->getU8();
-        m_spritesFile->getU8();
+bool SpriteManager::decodeSprite(int id, uint8* pixels, bool& transparent)
+{
+    // reads straight from the cached buffer with local offsets, the stream position is never touched,
+    // corrupted sprites are skipped silently because the logger can't be used from dispatcher threads
+    const uint8* data = m_spritesData;
+    const uint dataSize = m_spritesDataSize;
 
-        const uint16 pixelDataSize = m_spritesFile->getU16();
+    const uint addressPos = ((id - 1) * 4) + m_spritesOffset;
+    if(!data || addressPos + 4 > dataSize)
+        return false;
 
-        ImagePtr image(new Image(Size(SPRITE_SIZE, SPRITE_SIZE)));
+    const uint32 spriteAddress = stdext::readULE32(data + addressPos);
 
-        uint8* pixels = image->getPixelData();
-        int writePos = 0;
-        int read = 0;
-        const bool useAlpha = g_game.getFeature(Otc::GameSpritesAlphaChannel);
-        const uint8 channels = useAlpha ? 4 : 3;
-        // decompress pixels
-        while(read < pixelDataSize && writePos < SPRITE_DATA_SIZE) {
-            const uint16 transparentPixels = m_spritesFile->getU16();
-            const uint16 coloredPixels = m_spritesFile->getU16();
+    // no sprite? return an empty texture
+    if(spriteAddress == 0 || spriteAddress + 5 > dataSize)
+        return false;
 
-            for(int i = 0; i < transparentPixels && writePos < SPRITE_DATA_SIZE; ++i) {
-                pixels[writePos + 0] = 0x00;
-                pixels[writePos + 1] = 0x00;
-                pixels[writePos + 2] = 0x00;
-                pixels[writePos + 3] = 0x00;
-                writePos += 4;
-            }
+    // skip color key
+    const uint pos = spriteAddress + 3;
+    const uint16 pixelDataSize = stdext::readULE16(data + pos);
 
-            for(int i = 0; i < coloredPixels && writePos < SPRITE_DATA_SIZE; ++i) {
-                pixels[writePos + 0] = m_spritesFile->getU8();
-                pixels[writePos + 1] = m_spritesFile->getU8();
-                pixels[writePos + 2] = m_spritesFile->getU8();
+    if(pos + 2 + pixelDataSize > dataSize)
+        return false;
 
-                const uint8 alphaColor = useAlpha ? m_spritesFile->getU8() : 0xFF;
-                if(alphaColor != 0xFF)
-                    image->setTransparentPixel(true);
+    return decodePixels(data + pos + 2, pixelDataSize, dataSize - pos - 2, m_spritesAlpha, pixels, transparent);
+}
 
-                pixels[writePos + 3] = alphaColor;
+bool SpriteManager::decodePixels(const uint8* data, uint size, uint readable, bool useAlpha, uint8* pixels, bool& transparent)
+{
+    const uint channels = useAlpha ? 4 : 3;
+    const uint maxPixels = SPRITE_DATA_SIZE / 4;
+
+    uint pos = 0;
+    uint writePixel = 0;
+    uint transparentWritten = 0;
+    uint8 alphaMask = 0xFF;
+
+    // decompress pixels
+    while(pos + 4 <= size && writePixel < maxPixels) {
+        const uint transparentPixels = std::min<uint>(stdext::readULE16(data + pos), maxPixels - writePixel);
+        const uint coloredPixels = stdext::readULE16(data + pos + 2);
+        pos += 4;
+
+        if(pos + channels * coloredPixels > size)
+            return false;
+
+        std::memset(pixels + writePixel * 4, 0x00, transparentPixels * 4);
+        writePixel += transparentPixels;
+        transparentWritten += transparentPixels;
+
+        const uint count = std::min<uint>(coloredPixels, maxPixels - writePixel);
+        if(useAlpha)
+            alphaMask &= copyRgba(data + pos, pixels + writePixel * 4, count);
+        else
+            expandRgb(data + pos, readable - pos, pixels + writePixel * 4, count);
 
-                writePos += 4;
-            }
+        writePixel += count;
+        pos += channels * coloredPixels;
+    }
 
-            read += 4 + (channels * coloredPixels);
-        }
+    // a single missing pixel is the margin allowed before the sprite counts as transparent
+    transparent = alphaMask != 0xFF || transparentWritten > 1 || writePixel + 1 < maxPixels;
 
-        // Error margin for 4 pixel transparent
-        if(!image->hasTransparentPixel() && writePos + 4 < SPRITE_DATA_SIZE)
-            image->setTransparentPixel(true);
-
-        // fill remaining pixels with alpha
-        while(writePos < SPRITE_DATA_SIZE) {
-            pixels[writePos + 0] = 0x00;
-            pixels[writePos + 1] = 0x00;
-            pixels[writePos + 2] = 0x00;
-            pixels[writePos + 3] = 0x00;
-            writePos += 4;
-        }
+    // fill remaining pixels with alpha
+    std::memset(pixels + writePixel * 4, 0x00, (maxPixels - writePixel) * 4);
 
-        if(!image->hasTransparentPixel())
-        {
-            // The image must be more than 4 pixels transparent to be considered transparent.
-            uint8 cntTrans = 0;
-            for(uint8 pixel : image->getPixels()) {
-                if(pixel == 0x00 && ++cntTrans > 4) {
-                    image->setTransparentPixel(true);
-                    break;
-                }
+    if(!transparent) {
+        // The image must be more than 4 bytes zeroed to be considered transparent.
+        uint cntTrans = 0;
+        for(uint i = 0; i < SPRITE_DATA_SIZE; ++i) {
+            if(pixels[i] == 0x00 && ++cntTrans > 4) {
+                transparent = true;
+                break;
             }
         }
+    }
 
-        return image;
-    } catch(stdext::exception& e) {
-        g_logger.error(stdext::format("Failed to get sprite id %d: %s", id, e.what()));
-        return nullptr;
+    return true;
+}
+
+uint8 SpriteManager::copyRgba(const uint8* src, uint8* dst, uint count)
+{
+    std::memcpy(dst, src, count * 4);
+
+    // and-ing every alpha byte keeps 0xFF only when the whole run is opaque
+    uint8 alphaMask = 0xFF;
+    for(uint i = 0; i < count; ++i)
+        alphaMask &= src[i * 4 + 3];
+    return alphaMask;
+}
+
+void SpriteManager::expandRgb(const uint8* src, uint readable, uint8* dst, uint count)
+{
+    uint i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for(; i + 16 <= count; i += 16) {
+        const uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+        uint8x16x4_t rgba;
+        rgba.val[0] = rgb.val[0];
+        rgba.val[1] = rgb.val[1];
+        rgba.val[2] = rgb.val[2];
+        rgba.val[3] = vdupq_n_u8(0xFF);
+        vst4q_u8(dst + i * 4, rgba);
     }
+#elif defined(__SSSE3__)
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    // each step loads 16 bytes but only uses 12 of them, the extra ones must still be inside the buffer
+    for(; i + 4 <= count && i * 3 + 16 <= readable; i += 4) {
+        const __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+    }
+#endif
+    for(; i < count; ++i) {
+        dst[i * 4 + 0] = src[i * 3 + 0];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3 + 2];
+        dst[i * 4 + 3] = 0xFF;
+    }
+}
+
+double SpriteManager::benchmarkDecoding()
+{
+    if(!m_loaded)
+        stdext::throw_exception("failed to benchmark, spr is not loaded");
+
+    stdext::timer timer;
+    int decoded = 0;
+    for(int id = 1; id <= m_spritesCount; ++id) {
+        if(getSpriteImage(id))
+            ++decoded;
+    }
+    const ticks_t elapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+    const double spritesPerSecond = decoded * 1000000.0 / elapsed;
+    g_logger.info(stdext::format("Decoded %d of %d sprites in %.2f ms (%.0f sprites/s)", decoded, m_spritesCount, elapsed / 1000.0, spritesPerSecond));
+    return spritesPerSecond;
 }
@@ -25,6 +25,9 @@
 
 #include <framework/core/declarations.h>
 #include <framework/graphics/declarations.h>
+#include <framework/util/color.h>
+#include <atomic>
+#include "sharedspritecache.h"
 
  //@bindsingleton g_sprites
 class SpriteManager
@@ -35,6 +38,14 @@ class SpriteManager
     };
 
 public:
+    // pixel transforms applied while a sprite is copied into its destination
+    enum SpriteFilter {
+        FilterNone,
+        FilterOverwrite, // visible pixels take the filter color, like Image::overwrite
+        FilterMask, // pixels of the filter color become white and the others transparent, like Image::overwriteMask
+        FilterKeepMasks // pixels that are not one of the four outfit mask colors become transparent
+    };
+
     SpriteManager();
 
     void terminate();
@@ -47,15 +58,45 @@ public:
     uint32 getSignature() { return m_signature; }
     int getSpritesCount() { return m_spritesCount; }
 
+    // safe to call from async dispatcher threads, it only reads the cached spr buffer
     ImagePtr getSpriteImage(int id);
+    // decodes into a SPRITE_SIZE block of a caller's RGBA buffer, stride is the byte length of its rows;
+    // fully transparent pixels leave the destination as it was, like Image::blit. transparent is set for
+    // missing sprites too. Returns false when there is nothing to copy, also safe from dispatcher threads
+    bool decodeSpriteInto(int id, uint8* dest, uint stride, SpriteFilter filter = FilterNone, const Color& filterColor = Color::white, bool* transparent = nullptr);
     bool isLoaded() { return m_loaded; }
 
+    void setAsyncDecoding(bool enable) { m_asyncDecoding = enable; }
+    bool isAsyncDecoding() { return m_asyncDecoding; }
+
+    // decoded sprites are kept in memory shared with the other clients of the host that load the same spr
+    void setSharedCache(bool enable);
+    bool isSharedCache() { return m_useSharedCache; }
+    std::map<std::string, int> getSharedCacheStatistics() { return m_sharedCache.getStatistics(); }
+
+    // decodes every sprite of the loaded spr, returns sprites per second
+    double benchmarkDecoding();
+
 private:
-    stdext::boolean<false> m_loaded;
+    bool readSprite(int id, uint8* pixels, bool& transparent);
+    bool decodeSprite(int id, uint8* pixels, bool& transparent);
+    static bool decodePixels(const uint8* data, uint size, uint readable, bool useAlpha, uint8* pixels, bool& transparent);
+    static uint8 copyRgba(const uint8* src, uint8* dst, uint count);
+    static void expandRgb(const uint8* src, uint readable, uint8* dst, uint count);
+    void waitReaders();
+
+    std::atomic<bool> m_loaded{ false };
+    std::atomic<bool> m_asyncDecoding{ true };
+    std::atomic<int> m_readers{ 0 };
     uint32 m_signature;
     int m_spritesCount;
     int m_spritesOffset;
+    bool m_spritesAlpha{ false };
+    const uint8* m_spritesData{ nullptr };
+    uint m_spritesDataSize{ 0 };
     FileStreamPtr m_spritesFile;
+    bool m_useSharedCache{ false };
+    SharedSpriteCache m_sharedCache;
 };
 
 extern SpriteManager g_sprites;
@@ -90,6 +90,23 @@ bool StaticText::addMessage(const std::string& name, Otc::MessageMode mode, cons
     return true;
 }
 
+void StaticText::reset()
+{
+    if(m_updateEvent) {
+        m_updateEvent->cancel();
+        m_updateEvent = nullptr;
+    }
+
+    m_messages.clear();
+    m_name.clear();
+    m_mode = Otc::MessageNone;
+    m_color = Color::white;
+    m_yell = false;
+    m_cachedText.setFont(g_fonts.getFont("verdana-11px-rounded"));
+    m_cachedText.setText(std::string());
+    m_position = Position();
+}
+
 void StaticText::update()
 {
     m_messages.pop_front();
@@ -26,9 +26,10 @@
 #include <framework/core/timer.h>
 #include <framework/graphics/cachedtext.h>
 #include "thing.h"
+#include <framework/core/stats.h>
 
  // @bindclass
-class StaticText : public Thing
+class StaticText : public Thing, private StatsCounted<StaticText>
 {
 public:
     StaticText();
@@ -44,6 +45,8 @@ public:
     void setText(const std::string& text);
     void setFont(const std::string& fontName);
     bool addMessage(const std::string& name, Otc::MessageMode mode, const std::string& text);
+    // back to a freshly created text, see Map::createStaticText
+    void reset();
 
     StaticTextPtr asStaticText() { return static_self_cast<StaticText>(); }
     bool isStaticText() override { return true; }
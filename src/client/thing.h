@@ -86,8 +86,8 @@ public:
     int getNumPatternZ() { return rawGetThingType()->getNumPatternZ(); }
     int getAnimationPhases() { return rawGetThingType()->getAnimationPhases(); }
     bool hasAnimationPhases() { return rawGetThingType()->getAnimationPhases() > 1; }
-    AnimatorPtr getAnimator() { return rawGetThingType()->getAnimator(); }
-    AnimatorPtr getIdleAnimator() { return rawGetThingType()->getIdleAnimator(); }
+    const AnimatorPtr& getAnimator() { return rawGetThingType()->getAnimator(); }
+    const AnimatorPtr& getIdleAnimator() { return rawGetThingType()->getIdleAnimator(); }
     int getGroundSpeed() { return rawGetThingType()->getGroundSpeed(); }
     int getMaxTextLength() { return rawGetThingType()->getMaxTextLength(); }
     virtual Light getLight() { return rawGetThingType()->getLight(); }
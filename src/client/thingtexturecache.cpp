@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "thingtexturecache.h"
+#include "game.h"
+#include "spritemanager.h"
+#include "thingtypemanager.h"
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+#include <framework/stdext/math.h>
+#include <zlib.h>
+
+ThingTextureCache g_thingTextureCache;
+
+static const char* TEXTURE_CACHE_DIR = "/thingtexturecache";
+static const uint32 TEXTURE_CACHE_MAGIC = 0x43545447; // GTTC
+// magic, format, dat and spr signatures, client version and features
+static const uint PACK_HEADER_SIZE = 4 + 1 + 4 + 4 + 2 + 4;
+// key, compressed size, uncompressed size and checksum of the compressed data
+static const uint ENTRY_HEADER_SIZE = 8 + 4 + 4 + 4;
+// fresh entries are appended once they add up to this many bytes, the rest when the client closes
+static const uint FLUSH_BYTES = 4 * 1024 * 1024;
+
+void ThingTextureCache::terminate()
+{
+    flush();
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    close();
+}
+
+bool ThingTextureCache::isEnabled()
+{
+    return m_enabled && !g_resources.getWriteDir().empty();
+}
+
+bool ThingTextureCache::load(uint64 key, std::vector<uint8>& data)
+{
+    ensureOpen();
+
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    bool found = false;
+    const auto it = m_entries.find(key);
+    if(it != m_entries.end() && m_pack)
+        found = readEntry(it->second, m_pack->cachedData() + it->second.offset, data);
+    else {
+        const auto freshIt = m_fresh.find(key);
+        if(freshIt != m_fresh.end())
+            found = readEntry(freshIt->second.first, freshIt->second.second.data(), data);
+    }
+
+    if(found)
+        m_hits++;
+    else
+        m_misses++;
+    return found;
+}
+
+void ThingTextureCache::store(uint64 key, const std::vector<uint8>& data)
+{
+    // speed over ratio, entries are compressed by the threads composing the images while the map is walked
+    uLongf size = compressBound(data.size());
+    std::vector<uint8> compressed(size);
+    if(compress2(compressed.data(), &size, data.data(), data.size(), Z_BEST_SPEED) != Z_OK)
+        return;
+    compressed.resize(size);
+
+    Entry entry;
+    entry.offset = 0;
+    entry.size = size;
+    entry.rawSize = data.size();
+    entry.checksum = stdext::adler32(compressed.data(), compressed.size());
+
+    ensureOpen();
+
+    bool scheduleFlush;
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        auto& fresh = m_fresh[key];
+        m_freshBytes += entry.size - fresh.second.size();
+        fresh = { entry, std::move(compressed) };
+        scheduleFlush = m_freshBytes >= FLUSH_BYTES && !m_flushScheduled.exchange(true);
+    }
+    m_stored++;
+
+    if(scheduleFlush)
+        g_dispatcher.addEvent([this] { flush(); });
+}
+
+void ThingTextureCache::flush()
+{
+    m_flushScheduled = false;
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    appendFresh();
+}
+
+void ThingTextureCache::clear()
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        close();
+        // reopened on the next lookup
+        m_datSignature = 0;
+        m_sprSignature = 0;
+    }
+
+    if(g_resources.getWriteDir().empty() || !g_resources.directoryExists(TEXTURE_CACHE_DIR))
+        return;
+
+    for(const std::string& fileName : g_resources.listDirectoryFiles(TEXTURE_CACHE_DIR))
+        g_resources.deleteFile(std::string(TEXTURE_CACHE_DIR) + "/" + fileName);
+}
+
+std::map<std::string, int> ThingTextureCache::getStatistics()
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    std::map<std::string, int> stats;
+    stats["hits"] = m_hits;
+    stats["misses"] = m_misses;
+    stats["stored"] = m_stored;
+    stats["entries"] = m_entries.size() + m_fresh.size();
+    stats["packBytes"] = m_packSize;
+    stats["pendingBytes"] = m_freshBytes;
+    return stats;
+}
+
+void ThingTextureCache::ensureOpen()
+{
+    const uint32 datSignature = g_things.getDatSignature();
+    const uint32 sprSignature = g_sprites.getSignature();
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        if(datSignature == m_datSignature && sprSignature == m_sprSignature)
+            return;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if(datSignature == m_datSignature && sprSignature == m_sprSignature)
+        return;
+
+    // the entries of the previous files still go to their own pack
+    appendFresh();
+    close();
+    open(datSignature, sprSignature);
+}
+
+void ThingTextureCache::open(uint32 datSignature, uint32 sprSignature)
+{
+    m_datSignature = datSignature;
+    m_sprSignature = sprSignature;
+
+    const std::string path = getPackPath(datSignature, sprSignature);
+    if(!g_resources.fileExists(path))
+        return;
+
+    try {
+        FileStreamPtr pack = g_resources.openFile(path);
+        pack->cache();
+
+        const uint8* data = pack->cachedData();
+        const uint size = pack->cachedSize();
+        if(size < PACK_HEADER_SIZE || stdext::readULE32(data) != TEXTURE_CACHE_MAGIC || data[4] != FORMAT)
+            stdext::throw_exception("unknown pack format");
+        if(stdext::readULE32(data + 5) != datSignature || stdext::readULE32(data + 9) != sprSignature ||
+           stdext::readULE16(data + 13) != g_game.getClientVersion() || stdext::readULE32(data + 15) != getFeatures())
+            stdext::throw_exception("pack made for other game files");
+
+        // later entries of a key replace the earlier ones, they were stored after the earlier ones failed to load
+        uint pos = PACK_HEADER_SIZE;
+        while(pos + ENTRY_HEADER_SIZE <= size) {
+            const uint64 key = stdext::readULE64(data + pos);
+            Entry entry;
+            entry.size = stdext::readULE32(data + pos + 8);
+            entry.rawSize = stdext::readULE32(data + pos + 12);
+            entry.checksum = stdext::readULE32(data + pos + 16);
+            entry.offset = pos + ENTRY_HEADER_SIZE;
+            if(entry.size > size - entry.offset)
+                break;
+            m_entries[key] = entry;
+            pos = entry.offset + entry.size;
+        }
+
+        // an append cut short leaves a partial entry, the ones appended after it would be misread
+        if(pos != size)
+            stdext::throw_exception("truncated entry");
+
+        m_pack = pack;
+        m_packSize = size;
+    } catch(stdext::exception& e) {
+        g_logger.warning(stdext::format("Discarding thing texture cache '%s': %s", path, e.what()));
+        m_entries.clear();
+        g_resources.deleteFile(path);
+    }
+}
+
+void ThingTextureCache::appendFresh()
+{
+    if(m_fresh.empty() || !m_enabled)
+        return;
+
+    const std::string path = getPackPath(m_datSignature, m_sprSignature);
+    try {
+        // the mapping is released first, not every system lets a mapped file grow
+        m_pack = nullptr;
+
+        if(!g_resources.directoryExists(TEXTURE_CACHE_DIR))
+            g_resources.makeDir(TEXTURE_CACHE_DIR);
+
+        FileStreamPtr fout;
+        uint pos = m_packSize;
+        if(pos == 0) {
+            fout = g_resources.createFile(path);
+            uint8 header[PACK_HEADER_SIZE];
+            stdext::writeULE32(header, TEXTURE_CACHE_MAGIC);
+            header[4] = FORMAT;
+            stdext::writeULE32(header + 5, m_datSignature);
+            stdext::writeULE32(header + 9, m_sprSignature);
+            stdext::writeULE16(header + 13, g_game.getClientVersion());
+            stdext::writeULE32(header + 15, getFeatures());
+            fout->write(header, PACK_HEADER_SIZE);
+            pos = PACK_HEADER_SIZE;
+        } else
+            fout = g_resources.appendFile(path);
+
+        for(auto& it : m_fresh) {
+            Entry entry = it.second.first;
+            const std::vector<uint8>& compressed = it.second.second;
+
+            uint8 header[ENTRY_HEADER_SIZE];
+            stdext::writeULE64(header, it.first);
+            stdext::writeULE32(header + 8, entry.size);
+            stdext::writeULE32(header + 12, entry.rawSize);
+            stdext::writeULE32(header + 16, entry.checksum);
+            fout->write(header, ENTRY_HEADER_SIZE);
+            fout->write(compressed.data(), compressed.size());
+
+            entry.offset = pos + ENTRY_HEADER_SIZE;
+            pos = entry.offset + entry.size;
+            m_entries[it.first] = entry;
+        }
+        fout->close();
+
+        m_fresh.clear();
+        m_freshBytes = 0;
+        m_packSize = pos;
+
+        m_pack = g_resources.openFile(path);
+        m_pack->cache();
+        if(m_pack->cachedSize() != m_packSize)
+            stdext::throw_exception("pack changed while appending");
+    } catch(stdext::exception& e) {
+        // most likely a read only write dir, don't retry for every image
+        g_logger.warning(stdext::format("Unable to write thing texture cache, disabling it: %s", e.what()));
+        m_enabled = false;
+        close();
+    }
+}
+
+void ThingTextureCache::close()
+{
+    m_pack = nullptr;
+    m_packSize = 0;
+    m_entries.clear();
+    m_fresh.clear();
+    m_freshBytes = 0;
+}
+
+bool ThingTextureCache::readEntry(const Entry& entry, const uint8* data, std::vector<uint8>& out)
+{
+    if(stdext::adler32(data, entry.size) != entry.checksum)
+        return false;
+
+    out.resize(entry.rawSize);
+    uLongf rawSize = entry.rawSize;
+    return uncompress(out.data(), &rawSize, data, entry.size) == Z_OK && rawSize == entry.rawSize;
+}
+
+std::string ThingTextureCache::getPackPath(uint32 datSignature, uint32 sprSignature)
+{
+    return stdext::format("%s/%08x_%08x.pack", TEXTURE_CACHE_DIR, datSignature, sprSignature);
+}
+
+uint32 ThingTextureCache::getFeatures()
+{
+    // features changing how the dat and spr files are read, and so what the images are composed from
+    uint32 features = 0;
+    for(const Otc::GameFeature feature : { Otc::GameIdleAnimations, Otc::GameEnhancedAnimations, Otc::GameSpritesU32, Otc::GameSpritesAlphaChannel })
+        features = (features << 1) | (g_game.getFeature(feature) ? 1 : 0);
+    return features;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef THINGTEXTURECACHE_H
+#define THINGTEXTURECACHE_H
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+#include <atomic>
+#include <shared_mutex>
+
+// composed phase images of thing types kept in the write dir, so later sessions upload them to the atlas without
+// decoding and blitting sprites again. There is one pack per dat and spr pair, entries are compressed and appended
+// as they get composed, the pack is indexed when it is first read
+//@bindsingleton g_thingTextureCache
+class ThingTextureCache
+{
+public:
+    enum {
+        FORMAT = 1 // bump whenever the entry layout changes
+    };
+
+    void terminate();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled();
+
+    // safe to call from async dispatcher threads, data receives the uncompressed entry
+    bool load(uint64 key, std::vector<uint8>& data);
+    void store(uint64 key, const std::vector<uint8>& data);
+
+    // appends the entries stored since the last flush to the pack
+    void flush();
+    void clear();
+
+    std::map<std::string, int> getStatistics();
+
+    static uint64 makeKey(int category, uint16 id, int animationPhase, int textureType) {
+        return static_cast<uint64>(category) << 40 | static_cast<uint64>(id) << 24 | static_cast<uint64>(animationPhase & 0xFFFF) << 8 | static_cast<uint64>(textureType & 0xFF);
+    }
+
+private:
+    struct Entry {
+        uint offset;
+        uint size;
+        uint rawSize;
+        uint32 checksum;
+    };
+
+    void ensureOpen();
+    void open(uint32 datSignature, uint32 sprSignature);
+    void appendFresh();
+    void close();
+    bool readEntry(const Entry& entry, const uint8* data, std::vector<uint8>& out);
+    static std::string getPackPath(uint32 datSignature, uint32 sprSignature);
+    static uint32 getFeatures();
+
+    std::atomic<bool> m_enabled{ true };
+    std::shared_mutex m_mutex;
+    uint32 m_datSignature{ 0 };
+    uint32 m_sprSignature{ 0 };
+    FileStreamPtr m_pack;
+    uint m_packSize{ 0 };
+    std::unordered_map<uint64, Entry> m_entries;
+    // entries of this session not yet appended to the pack, they are compressed already
+    std::unordered_map<uint64, std::pair<Entry, std::vector<uint8>>> m_fresh;
+    uint m_freshBytes{ 0 };
+    std::atomic<bool> m_flushScheduled{ false };
+
+    std::atomic<int> m_hits{ 0 };
+    std::atomic<int> m_misses{ 0 };
+    std::atomic<int> m_stored{ 0 };
+};
+
+extern ThingTextureCache g_thingTextureCache;
+
+#endif
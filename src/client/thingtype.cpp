@@ -25,16 +25,22 @@
 #include "lightview.h"
 #include "map.h"
 #include "spritemanager.h"
+#include "thingtexturecache.h"
 
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/filestream.h>
 #include <framework/graphics/graphics.h>
 #include <framework/graphics/image.h>
+#include <framework/graphics/painter.h>
 #include <framework/graphics/texture.h>
 #include <framework/graphics/texturemanager.h>
 #include <framework/graphics/drawpool.h>
 #include <framework/otml/otml.h>
 
+uint32 ThingType::s_placeholderCount = 0;
+
 ThingType::ThingType()
 {
     m_category = ThingInvalidCategory;
@@ -51,6 +57,15 @@ ThingType::ThingType()
     m_countPainterListeningRef = 0;
 }
 
+ThingType::~ThingType()
+{
+    // composition tasks read this thing type, they must be done before it goes away
+    for(const auto& it : m_pendingImages)
+        it.second.wait();
+    for(const auto& it : m_pendingMips)
+        it.second.wait();
+}
+
 void ThingType::serialize(const FileStreamPtr& fin)
 {
     for(int i = 0; i < ThingLastAttr; ++i) {
@@ -378,12 +393,182 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
         }
     }
 
+    updateAttrCache();
+}
+
+namespace {
+    // type of an attribute value in thing type snapshots
+    enum SnapshotValue : uint8 {
+        SnapshotValueBool,
+        SnapshotValueU16,
+        SnapshotValueInt,
+        SnapshotValueLight,
+        SnapshotValueMarket
+    };
+}
+
+void ThingType::unserializeSnapshot(uint16 clientId, ThingCategory category, const FileStreamPtr& fin)
+{
+    m_null = false;
+    m_id = clientId;
+    m_category = category;
+
+    const uint8 attrCount = fin->getU8();
+    for(int i = 0; i < attrCount; ++i) {
+        const uint8 attr = fin->getU8();
+        switch(fin->getU8()) {
+        case SnapshotValueBool:
+            m_attribs.set(attr, fin->getU8() != 0);
+            break;
+        case SnapshotValueU16:
+            m_attribs.set(attr, fin->getU16());
+            break;
+        case SnapshotValueInt:
+            m_attribs.set(attr, static_cast<int>(fin->get32()));
+            break;
+        case SnapshotValueLight:
+        {
+            Light light;
+            light.intensity = fin->getU8();
+            light.color = fin->getU8();
+            m_attribs.set(attr, light);
+            break;
+        }
+        case SnapshotValueMarket:
+        {
+            MarketData market;
+            market.category = fin->getU16();
+            market.tradeAs = fin->getU16();
+            market.showAs = fin->getU16();
+            market.name = fin->getString();
+            market.restrictVocation = fin->getU16();
+            market.requiredLevel = fin->getU16();
+            m_attribs.set(attr, market);
+            break;
+        }
+        default:
+            stdext::throw_exception(stdext::format("invalid snapshot value (id: %d, category: %d, attr: %d)", m_id, m_category, static_cast<int>(attr)));
+        }
+    }
+
+    m_displacement.x = fin->get32();
+    m_displacement.y = fin->get32();
+    const uint8 width = fin->getU8();
+    const uint8 height = fin->getU8();
+    m_size = Size(width, height);
+    m_realSize = fin->getU16();
+    m_exactSize = fin->getU16();
+    m_layers = fin->getU8();
+    m_numPatternX = fin->getU8();
+    m_numPatternY = fin->getU8();
+    m_numPatternZ = fin->getU8();
+    m_animationPhases = fin->getU16();
+    m_elevation = fin->getU16();
+
+    for(AnimatorPtr* animator : { &m_animator, &m_idleAnimator }) {
+        const uint8 phases = fin->getU8();
+        if(phases == 0)
+            continue;
+        *animator = AnimatorPtr(new Animator);
+        (*animator)->unserialize(phases, fin);
+    }
+
+    const uint16 spriteCount = fin->getU16();
+    m_spritesIndex.resize(spriteCount);
+    for(int& sprite : m_spritesIndex)
+        sprite = fin->getU32();
+
+    updateAttrCache();
+}
+
+void ThingType::serializeSnapshot(const FileStreamPtr& fin)
+{
+    uint8 attrCount = 0;
+    for(int i = 0; i < ThingLastAttr; ++i) {
+        if(m_attribs.has(i))
+            ++attrCount;
+    }
+
+    fin->addU8(attrCount);
+    for(int i = 0; i < ThingLastAttr; ++i) {
+        const std::type_info& type = m_attribs.type(i);
+        if(type == typeid(void))
+            continue;
+
+        fin->addU8(i);
+        if(type == typeid(bool)) {
+            fin->addU8(SnapshotValueBool);
+            fin->addU8(m_attribs.get<bool>(i) ? 1 : 0);
+        } else if(type == typeid(uint16)) {
+            fin->addU8(SnapshotValueU16);
+            fin->addU16(m_attribs.get<uint16>(i));
+        } else if(type == typeid(int)) {
+            fin->addU8(SnapshotValueInt);
+            fin->add32(m_attribs.get<int>(i));
+        } else if(type == typeid(Light)) {
+            const Light light = m_attribs.get<Light>(i);
+            fin->addU8(SnapshotValueLight);
+            fin->addU8(light.intensity);
+            fin->addU8(light.color);
+        } else if(type == typeid(MarketData)) {
+            const MarketData market = m_attribs.get<MarketData>(i);
+            fin->addU8(SnapshotValueMarket);
+            fin->addU16(market.category);
+            fin->addU16(market.tradeAs);
+            fin->addU16(market.showAs);
+            fin->addString(market.name);
+            fin->addU16(market.restrictVocation);
+            fin->addU16(market.requiredLevel);
+        } else
+            stdext::throw_exception(stdext::format("attribute %d of thing %d has no snapshot value", i, m_id));
+    }
+
+    fin->add32(m_displacement.x);
+    fin->add32(m_displacement.y);
+    fin->addU8(m_size.width());
+    fin->addU8(m_size.height());
+    fin->addU16(m_realSize);
+    fin->addU16(m_exactSize);
+    fin->addU8(m_layers);
+    fin->addU8(m_numPatternX);
+    fin->addU8(m_numPatternY);
+    fin->addU8(m_numPatternZ);
+    fin->addU16(m_animationPhases);
+    fin->addU16(m_elevation);
+
+    for(const AnimatorPtr& animator : { m_animator, m_idleAnimator }) {
+        fin->addU8(animator ? animator->getAnimationPhases() : 0);
+        if(animator)
+            animator->serialize(fin);
+    }
+
+    fin->addU16(m_spritesIndex.size());
+    for(int sprite : m_spritesIndex)
+        fin->addU32(sprite);
+}
+
+void ThingType::updateAttrCache()
+{
+    for(int i = 0; i < ThingLastAttr; ++i)
+        m_flags.set(i, m_attribs.has(i));
+
+    m_groundSpeed = m_attribs.get<uint16>(ThingAttrGround);
+    m_minimapColor = m_attribs.get<uint16>(ThingAttrMinimapColor);
+    m_light = m_attribs.get<Light>(ThingAttrLight);
+}
+
+void ThingType::resizeTextureCache()
+{
+    if(m_textures.size() == static_cast<size_t>(m_animationPhases))
+        return;
+
     m_textures.resize(m_animationPhases);
     m_blankTextures.resize(m_animationPhases);
-    m_smoothTextures.resize(m_animationPhases);
     m_texturesFramesRects.resize(m_animationPhases);
     m_texturesFramesOriginRects.resize(m_animationPhases);
     m_texturesFramesOffsets.resize(m_animationPhases);
+    for(auto& mipTextures : m_mipTextures)
+        mipTextures.resize(m_animationPhases);
 }
 
 void ThingType::exportImage(const std::string& fileName)
@@ -402,9 +587,9 @@ void ThingType::exportImage(const std::string& fileName)
                     for(int a = 0; a < m_animationPhases; ++a) {
                         for(int w = 0; w < m_size.width(); ++w) {
                             for(int h = 0; h < m_size.height(); ++h) {
-                                image->blit(Point(Otc::TILE_PIXELS * (m_size.width() - w - 1 + m_size.width() * x + m_size.width() * m_numPatternX * l),
-                                                  Otc::TILE_PIXELS * (m_size.height() - h - 1 + m_size.height() * y + m_size.height() * m_numPatternY * a + m_size.height() * m_numPatternY * m_animationPhases * z)),
-                                            g_sprites.getSpriteImage(m_spritesIndex[getSpriteIndex(w, h, l, x, y, z, a)]));
+                                const Point pos(Otc::TILE_PIXELS * (m_size.width() - w - 1 + m_size.width() * x + m_size.width() * m_numPatternX * l),
+                                                Otc::TILE_PIXELS * (m_size.height() - h - 1 + m_size.height() * y + m_size.height() * m_numPatternY * a + m_size.height() * m_numPatternY * m_animationPhases * z));
+                                g_sprites.decodeSpriteInto(m_spritesIndex[getSpriteIndex(w, h, l, x, y, z, a)], image->getPixel(pos.x, pos.y), image->getWidth() * 4);
                             }
                         }
                     }
@@ -432,6 +617,7 @@ void ThingType::unserializeOtml(const OTMLNodePtr& node)
                 m_attribs.remove(ThingAttrFullGround);
         }
     }
+    updateAttrCache();
 }
 
 void ThingType::draw(const Point& dest, float scaleFactor, int layer, int xPattern, int yPattern, int zPattern, int animationPhase, TextureType textureType, Color color, int frameFlags, LightView* lightView)
@@ -442,7 +628,8 @@ void ThingType::draw(const Point& dest, float scaleFactor, int layer, int xPatte
     if(animationPhase >= m_animationPhases)
         return;
 
-    const TexturePtr& texture = getTexture(animationPhase, textureType); // texture might not exists, neither its rects.
+    const AtlasRegionPtr& region = getTextureRegion(animationPhase, textureType, g_sprites.isAsyncDecoding()); // texture might not exists, neither its rects.
+    const TexturePtr& texture = region->getTexture();
     if(!texture)
         return;
 
@@ -464,28 +651,141 @@ void ThingType::draw(const Point& dest, float scaleFactor, int layer, int xPatte
                           textureRect.size() * scaleFactor);
 
     if(frameFlags & Otc::FUpdateThing) {
+        // zoomed out views sample a downscaled copy of the phase image once it is ready, the full one meanwhile
+        AtlasRegion* drawRegion = region.get();
+        const int mipLevel = getMipLevel(scaleFactor, animationPhase, textureType);
+        if(mipLevel > 0) {
+            const AtlasRegionPtr& mipRegion = getMipRegion(animationPhase, mipLevel);
+            if(mipRegion->isValid()) {
+                drawRegion = mipRegion.get();
+                textureRect = Rect(textureRect.topLeft() / (1 << mipLevel), textureRect.size() / (1 << mipLevel));
+            }
+        }
+
+        // frame rects are relative to the animation phase image, move them to its place in the atlas page
+        drawRegion->touch(g_clock.millis());
+        textureRect.translate(drawRegion->getOffset());
+
         const bool useOpacity = m_opacity < 1.0f;
 
         if(useOpacity)
             color = Color(1.0f, 1.0f, 1.0f, m_opacity);
 
+        setDrawSampling(textureType, true);
         if(getCategory() == ThingCategoryMissile || (isGround() && !isTopGround()))
-            g_drawPool.addRepeatedTexturedRect(screenRect, texture, textureRect, color);
+            g_drawPool.addRepeatedTexturedRect(screenRect, drawRegion->getTexture(), textureRect, color, drawRegion->getLayer());
         else
-            g_drawPool.addTexturedRect(screenRect, texture, textureRect, color, dest);
+            g_drawPool.addTexturedRect(screenRect, drawRegion->getTexture(), textureRect, color, dest, drawRegion->getLayer());
+        setDrawSampling(textureType, false);
     }
 
     if(lightView && hasLight() && frameFlags & Otc::FUpdateLight) {
         const Light light = getLight();
         if(light.intensity > 0) {
-            lightView->addLightSource(screenRect.center(), light);
+            lightView->addLightSource(screenRect.center(), light, m_category == ThingCategoryItem);
         }
     }
 }
 
+void ThingType::composeFrame(const ImagePtr& image, const Point& dest, int xPattern, int yPattern, int zPattern, int animationPhase, const std::array<Color, 4>* maskColors) const
+{
+    if(m_null || animationPhase >= m_animationPhases)
+        return;
+
+    // mask sprite colors in the order of maskColors
+    static const Color spriteMaskColors[] = { Color::yellow, Color::red, Color::green, Color::blue };
+    const bool tinted = maskColors && m_category == ThingCategoryCreature && m_layers > 1;
+
+    const int stride = Otc::TILE_PIXELS * 4;
+    std::vector<uint8> pixels(Otc::TILE_PIXELS * stride), mask(tinted ? pixels.size() : 0);
+
+    const Point topLeft = dest - m_displacement - (m_size.toPoint() - Point(1)) * Otc::TILE_PIXELS;
+    for(int h = 0; h < m_size.height(); ++h) {
+        for(int w = 0; w < m_size.width(); ++w) {
+            std::fill(pixels.begin(), pixels.end(), 0);
+            g_sprites.decodeSpriteInto(m_spritesIndex[getSpriteIndex(w, h, 0, xPattern, yPattern, zPattern, animationPhase)], pixels.data(), stride);
+
+            if(tinted) {
+                std::fill(mask.begin(), mask.end(), 0);
+                g_sprites.decodeSpriteInto(m_spritesIndex[getSpriteIndex(w, h, 1, xPattern, yPattern, zPattern, animationPhase)], mask.data(), stride);
+                for(size_t p = 0; p < pixels.size(); p += 4) {
+                    if(mask[p + 3] == 0)
+                        continue;
+
+                    const Color maskColor(mask[p], mask[p + 1], mask[p + 2]);
+                    for(int i = 0; i < 4; ++i) {
+                        if(maskColor != spriteMaskColors[i])
+                            continue;
+
+                        const Color& color = (*maskColors)[i];
+                        pixels[p] = pixels[p] * color.r() / 255;
+                        pixels[p + 1] = pixels[p + 1] * color.g() / 255;
+                        pixels[p + 2] = pixels[p + 2] * color.b() / 255;
+                        break;
+                    }
+                }
+            }
+
+            const Point spritePos = topLeft + Point(m_size.width() - w - 1, m_size.height() - h - 1) * Otc::TILE_PIXELS;
+            const int left = std::max<int>(spritePos.x, 0),
+                right = std::min<int>(spritePos.x + Otc::TILE_PIXELS, image->getWidth());
+            if(left >= right)
+                continue;
+
+            for(int y = 0; y < Otc::TILE_PIXELS; ++y) {
+                const int imageY = spritePos.y + y;
+                if(imageY < 0 || imageY >= image->getHeight())
+                    continue;
+                Image::blitPixels(image->getPixel(left, imageY), &pixels[y * stride + (left - spritePos.x) * 4], right - left);
+            }
+        }
+    }
+}
+
+void ThingType::drawMasked(const Point& dest, float scaleFactor, int xPattern, int yPattern, int zPattern, int animationPhase, TextureType textureType, const std::array<uint32, 4>& maskColors, Color color)
+{
+    if(m_null || animationPhase >= m_animationPhases)
+        return;
+
+    const AtlasRegionPtr& region = getTextureRegion(animationPhase, textureType, g_sprites.isAsyncDecoding());
+    const TexturePtr& texture = region->getTexture();
+    if(!texture)
+        return;
+
+    const uint frameIndex = getTextureIndex(0, xPattern, yPattern, zPattern);
+    const uint maskIndex = getTextureIndex(SpriteMaskPacked, xPattern, yPattern, zPattern);
+    if(maskIndex >= m_texturesFramesRects[animationPhase].size())
+        return;
+
+    Point textureOffset;
+    Rect textureRect;
+
+    if(scaleFactor != 1.0f) {
+        textureRect = m_texturesFramesOriginRects[animationPhase][frameIndex];
+    } else {
+        textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
+        textureRect = m_texturesFramesRects[animationPhase][frameIndex];
+    }
+
+    const Rect screenRect(dest + (textureOffset - m_displacement - (m_size.toPoint() - Point(1)) * Otc::TILE_PIXELS) * scaleFactor,
+                          textureRect.size() * scaleFactor);
+
+    region->touch(g_clock.millis());
+    textureRect.translate(region->getOffset());
+
+    const Point maskOffset = m_texturesFramesOriginRects[animationPhase][maskIndex].topLeft() - m_texturesFramesOriginRects[animationPhase][frameIndex].topLeft();
+
+    if(m_opacity < 1.0f)
+        color = Color(1.0f, 1.0f, 1.0f, m_opacity);
+
+    setDrawSampling(textureType, true);
+    g_drawPool.addOutfitRect(screenRect, texture, textureRect, maskOffset, maskColors, color, dest);
+    setDrawSampling(textureType, false);
+}
+
 void ThingType::generateTextureCache()
 {
-    for(size_t i = m_textures.size(); --i <= 0;)
+    for(int i = 0; i < m_animationPhases; ++i)
     {
         getTexture(i, TextureType::ALL_BLANK);
         getTexture(i, TextureType::NONE);
@@ -493,34 +793,237 @@ void ThingType::generateTextureCache()
     }
 }
 
+int ThingType::requestPhaseImages(TextureType txtType)
+{
+    if(m_null || m_spritesIndex.empty())
+        return 0;
+
+    resizeTextureCache();
+    txtType = getStoredTextureType(txtType);
+    const std::vector<AtlasRegionPtr>& textures = txtType == TextureType::ALL_BLANK ? m_blankTextures : m_textures;
+
+    int requested = 0;
+    for(int animationPhase = 0; animationPhase < m_animationPhases; ++animationPhase) {
+        // custom images are loaded through the resource manager, which is bound to the main thread
+        if(animationPhase == 0 && !m_customImage.empty())
+            continue;
+
+        const AtlasRegionPtr& region = textures[animationPhase];
+        const uint requestId = animationPhase * 3 + static_cast<uint>(txtType);
+        if((region && region->isValid()) || m_pendingImages.find(requestId) != m_pendingImages.end())
+            continue;
+
+        // below the images requested by draws, which wait for them with a placeholder on screen
+        m_pendingImages.emplace(requestId, g_asyncDispatcher.schedule([this, animationPhase, txtType] {
+            return composePhaseImage(animationPhase, txtType);
+        }, AsyncDispatcher::PriorityNormal));
+        ++requested;
+    }
+    return requested;
+}
+
+int ThingType::commitPhaseImages(int max)
+{
+    int committed = 0;
+    for(auto it = m_pendingImages.begin(); it != m_pendingImages.end() && committed < max;) {
+        if(it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+
+        // the draws waiting for their images with a placeholder go first
+        if(!g_textures.canUpload(static_cast<uint64>(it->second.get().image->getPixelCount()) * 4, false))
+            break;
+
+        const int animationPhase = it->first / 3;
+        const TextureType txtType = static_cast<TextureType>(it->first % 3);
+        PhaseImage phaseImage = it->second.get();
+        it = m_pendingImages.erase(it);
+        commitPhaseImage(phaseImage, animationPhase, txtType);
+        ++committed;
+    }
+    return committed;
+}
+
 const TexturePtr& ThingType::getTexture(int animationPhase, const TextureType txtType)
 {
-    const bool allBlank = txtType == TextureType::ALL_BLANK,
-        smoth = txtType == TextureType::SMOOTH;
+    return getTextureRegion(animationPhase, txtType)->getTexture();
+}
+
+const AtlasRegionPtr& ThingType::getTextureRegion(int animationPhase, TextureType txtType, bool async)
+{
+    resizeTextureCache();
+    txtType = getStoredTextureType(txtType);
+    AtlasRegionPtr& animationPhaseTexture = (txtType == TextureType::ALL_BLANK ? m_blankTextures : m_textures)[animationPhase];
+
+    // regions not drawn for a while are evicted by the atlas, rebuild them on demand
+    if(animationPhaseTexture && animationPhaseTexture->isValid()) return animationPhaseTexture;
+
+    const uint requestId = animationPhase * 3 + static_cast<uint>(txtType);
+    const auto it = m_pendingImages.find(requestId);
+    if(it != m_pendingImages.end()) {
+        if(async && it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return getPlaceholderRegion(animationPhase, txtType);
+
+        // composed images past the frame's upload budget keep their placeholder until a later frame
+        if(async && !g_textures.canUpload(static_cast<uint64>(it->second.get().image->getPixelCount()) * 4))
+            return getPlaceholderRegion(animationPhase, txtType);
+
+        PhaseImage phaseImage = it->second.get();
+        m_pendingImages.erase(it);
+        return commitPhaseImage(phaseImage, animationPhase, txtType);
+    }
+
+    // a region that exists but holds no texture was evicted
+    if(animationPhaseTexture)
+        g_atlas.countRebuild();
+
+    // custom images are loaded through the resource manager, which is bound to the main thread
+    if(async && (animationPhase != 0 || m_customImage.empty())) {
+        m_pendingImages.emplace(requestId, g_asyncDispatcher.schedule([this, animationPhase, txtType] {
+            return composePhaseImage(animationPhase, txtType);
+        }, AsyncDispatcher::PriorityHigh));
+        return getPlaceholderRegion(animationPhase, txtType);
+    }
+
+    PhaseImage phaseImage = composePhaseImage(animationPhase, txtType);
+    return commitPhaseImage(phaseImage, animationPhase, txtType);
+}
+
+int ThingType::getMipLevel(float scaleFactor, int animationPhase, const TextureType txtType) const
+{
+    // blank copies are rare, custom images have any size, and the outfit masks of creatures
+    // would blend into colors the outfit shader takes for other masks
+    if(scaleFactor > 0.5f || getStoredTextureType(txtType) != TextureType::NONE ||
+       (animationPhase == 0 && !m_customImage.empty()) || (m_category == ThingCategoryCreature && m_layers >= 2))
+        return 0;
+
+    int level = 0;
+    while(level < MIP_LEVELS && scaleFactor <= 0.5f) {
+        scaleFactor *= 2;
+        ++level;
+    }
+    return level;
+}
+
+const AtlasRegionPtr& ThingType::getMipRegion(int animationPhase, int level)
+{
+    static const AtlasRegionPtr emptyRegion = std::make_shared<AtlasRegion>();
+
+    resizeTextureCache();
+    AtlasRegionPtr& mipTexture = m_mipTextures[level - 1][animationPhase];
+    if(mipTexture && mipTexture->isValid())
+        return mipTexture;
+
+    // built only for the phases drawn zoomed out, from the disk cache when the phase image is in it
+    const uint requestId = animationPhase * MIP_LEVELS + level - 1;
+    const auto it = m_pendingMips.find(requestId);
+    if(it == m_pendingMips.end()) {
+        m_pendingMips.emplace(requestId, g_asyncDispatcher.schedule([this, animationPhase, level] {
+            const ImagePtr image = composePhaseImage(animationPhase, TextureType::NONE).image;
+            for(int i = 0; i < level; ++i)
+                image->nextMipmap();
+            return image;
+        }, AsyncDispatcher::PriorityNormal));
+        return emptyRegion;
+    }
+
+    // the full size phase is drawn meanwhile, so the mip is the first upload to wait for the next frame
+    if(it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready ||
+       !g_textures.canUpload(static_cast<uint64>(it->second.get()->getPixelCount()) * 4, false))
+        return emptyRegion;
+
+    const ImagePtr image = it->second.get();
+    m_pendingMips.erase(it);
+
+    mipTexture = g_atlas.allocate(image, false, m_category == ThingCategoryItem);
+    if(!mipTexture)
+        mipTexture = g_atlas.createStandalone(TexturePtr(new Texture(image, false, false, m_size.area() == 1, false)));
+    return mipTexture;
+}
+
+const AtlasRegionPtr& ThingType::getPlaceholderRegion(int /*animationPhase*/, const TextureType /*txtType*/)
+{
+    static const AtlasRegionPtr emptyRegion = std::make_shared<AtlasRegion>();
+    ++s_placeholderCount;
+    return emptyRegion;
+}
+
+const AtlasRegionPtr& ThingType::commitPhaseImage(PhaseImage& phaseImage, int animationPhase, const TextureType txtType)
+{
+    resizeTextureCache();
+    AtlasRegionPtr& animationPhaseTexture = (txtType == TextureType::ALL_BLANK ? m_blankTextures : m_textures)[animationPhase];
+
+    const ImagePtr& fullImage = phaseImage.image;
 
-    TexturePtr& animationPhaseTexture = (
-        allBlank ? m_blankTextures :
-        smoth ? m_smoothTextures : m_textures)[animationPhase];
+    m_texturesFramesRects[animationPhase] = std::move(phaseImage.framesRects);
+    m_texturesFramesOriginRects[animationPhase] = std::move(phaseImage.framesOriginRects);
+    m_texturesFramesOffsets[animationPhase] = std::move(phaseImage.framesOffsets);
 
-    if(animationPhaseTexture) return animationPhaseTexture;
+    m_opaque = !fullImage->hasTransparentPixel();
+
+    // things sharing an atlas page are batched in the same draw call, items share all layered pages,
+    // creatures stay on 2D pages because their outfit shaders can't sample array textures
+    animationPhaseTexture = g_atlas.allocate(fullImage, false, m_category == ThingCategoryItem);
+    if(!animationPhaseTexture) {
+        const TexturePtr texture(new Texture(fullImage, true, false, m_size.area() == 1, false));
+        animationPhaseTexture = g_atlas.createStandalone(texture);
+    }
+
+    return animationPhaseTexture;
+}
+
+void ThingType::setDrawSampling(const TextureType txtType, bool enabled)
+{
+    if(txtType == TextureType::SMOOTH)
+        g_drawPool.setSmoothSampling(enabled);
+    else if(txtType == TextureType::ALL_BLANK && getStoredTextureType(txtType) == TextureType::NONE)
+        g_drawPool.setSilhouette(enabled);
+}
+
+TextureType ThingType::getStoredTextureType(const TextureType txtType)
+{
+    // filtering is sampler state and blank images are silhouettes drawn by a shader,
+    // both sample the normal image, only painters without shaders need a blank copy
+    if(txtType == TextureType::SMOOTH || (txtType == TextureType::ALL_BLANK && g_painter->canDrawSilhouettes()))
+        return TextureType::NONE;
+    return txtType;
+}
+
+ThingType::PhaseImage ThingType::composePhaseImage(int animationPhase, const TextureType txtType) const
+{
+    const bool allBlank = txtType == TextureType::ALL_BLANK;
 
     // we don't need layers in common items, they will be pre-drawn
     int textureLayers = 1;
     int numLayers = m_layers;
     if(m_category == ThingCategoryCreature && numLayers >= 2) {
-        // 5 layers: outfit base, red mask, green mask, blue mask, yellow mask
-        textureLayers = 5;
-        numLayers = 5;
+        // 6 layers: outfit base, red mask, green mask, blue mask, yellow mask and all masks in their colors
+        textureLayers = 6;
+        numLayers = 6;
     }
 
     const bool useCustomImage = animationPhase == 0 && !m_customImage.empty();
     const int indexSize = textureLayers * m_numPatternX * m_numPatternY * m_numPatternZ;
     const Size textureSize = getBestTextureDimension(m_size.width(), m_size.height(), indexSize);
-    const ImagePtr fullImage = useCustomImage ? Image::load(m_customImage) : ImagePtr(new Image(textureSize * Otc::TILE_PIXELS));
 
-    m_texturesFramesRects[animationPhase].resize(indexSize);
-    m_texturesFramesOriginRects[animationPhase].resize(indexSize);
-    m_texturesFramesOffsets[animationPhase].resize(indexSize);
+    PhaseImage phaseImage;
+
+    // images composed by earlier sessions are read back from the disk cache, custom images may have changed since
+    const bool cacheable = !useCustomImage && g_thingTextureCache.isEnabled();
+    const uint64 cacheKey = ThingTextureCache::makeKey(m_category, m_id, animationPhase, static_cast<int>(txtType));
+    if(cacheable && loadCachedPhaseImage(cacheKey, indexSize, phaseImage)) {
+        if(m_opacity < 1.0f)
+            phaseImage.image->setTransparentPixel(true);
+        return phaseImage;
+    }
+
+    phaseImage.image = useCustomImage ? Image::load(m_customImage) : ImagePtr(new Image(textureSize * Otc::TILE_PIXELS));
+    const ImagePtr& fullImage = phaseImage.image;
+
+    phaseImage.framesRects.resize(indexSize);
+    phaseImage.framesOriginRects.resize(indexSize);
+    phaseImage.framesOffsets.resize(indexSize);
     for(int z = 0; z < m_numPatternZ; ++z) {
         for(int y = 0; y < m_numPatternY; ++y) {
             for(int x = 0; x < m_numPatternX; ++x) {
@@ -535,25 +1038,30 @@ const TexturePtr& ThingType::getTexture(int animationPhase, const TextureType tx
                         for(int h = 0; h < m_size.height(); ++h) {
                             for(int w = 0; w < m_size.width(); ++w) {
                                 const uint spriteIndex = getSpriteIndex(w, h, spriteMask ? 1 : l, x, y, z, animationPhase);
-                                ImagePtr spriteImage = g_sprites.getSpriteImage(m_spritesIndex[spriteIndex]);
+                                const Point spritePos = framePos + Point(m_size.width() - w - 1,
+                                                                         m_size.height() - h - 1) * Otc::TILE_PIXELS;
+
+                                // pixels of other colors in the packed mask would be read as a mask by the outfit shader
+                                static const Color maskColors[] = { Color::red, Color::green, Color::blue, Color::yellow };
+                                SpriteManager::SpriteFilter filter = SpriteManager::FilterNone;
+                                Color filterColor = Color::white;
+                                if(allBlank)
+                                    filter = SpriteManager::FilterOverwrite;
+                                else if(l == SpriteMaskPacked)
+                                    filter = SpriteManager::FilterKeepMasks;
+                                else if(spriteMask) {
+                                    filter = SpriteManager::FilterMask;
+                                    filterColor = maskColors[l - 1];
+                                }
+
+                                // sprites are decoded straight into the composed image
+                                bool transparent;
+                                g_sprites.decodeSpriteInto(m_spritesIndex[spriteIndex], fullImage->getPixel(spritePos.x, spritePos.y),
+                                                           fullImage->getWidth() * 4, filter, filterColor, &transparent);
 
                                 // verifies that the first block in the lower right corner is transparent.
-                                if(h == 0 && w == 0 && (!spriteImage || spriteImage->hasTransparentPixel())) {
+                                if(h == 0 && w == 0 && transparent)
                                     fullImage->setTransparentPixel(true);
-                                }
-
-                                if(spriteImage) {
-                                    if(allBlank) {
-                                        spriteImage->overwrite(Color::white);
-                                    } else if(spriteMask) {
-                                        static Color maskColors[] = { Color::red, Color::green, Color::blue, Color::yellow };
-                                        spriteImage->overwriteMask(maskColors[l - 1]);
-                                    }
-                                    Point spritePos = Point(m_size.width() - w - 1,
-                                                            m_size.height() - h - 1) * Otc::TILE_PIXELS;
-
-                                    fullImage->blit(framePos + spritePos, spriteImage);
-                                }
                             }
                         }
                     }
@@ -571,24 +1079,93 @@ const TexturePtr& ThingType::getTexture(int animationPhase, const TextureType tx
                         }
                     }
 
-                    m_texturesFramesRects[animationPhase][frameIndex] = drawRect;
-                    m_texturesFramesOriginRects[animationPhase][frameIndex] = Rect(framePos, Size(m_size.width(), m_size.height()) * Otc::TILE_PIXELS);
-                    m_texturesFramesOffsets[animationPhase][frameIndex] = drawRect.topLeft() - framePos;
+                    phaseImage.framesRects[frameIndex] = drawRect;
+                    phaseImage.framesOriginRects[frameIndex] = Rect(framePos, Size(m_size.width(), m_size.height()) * Otc::TILE_PIXELS);
+                    phaseImage.framesOffsets[frameIndex] = drawRect.topLeft() - framePos;
                 }
             }
         }
     }
 
+    if(cacheable)
+        storeCachedPhaseImage(cacheKey, phaseImage);
+
     if(m_opacity < 1.0f)
         fullImage->setTransparentPixel(true);
 
-    m_opaque = !fullImage->hasTransparentPixel();
+    return phaseImage;
+}
+
+bool ThingType::loadCachedPhaseImage(uint64 key, int frameCount, PhaseImage& phaseImage)
+{
+    std::vector<uint8> data;
+    if(!g_thingTextureCache.load(key, data))
+        return false;
+
+    // width, height, transparency and frame count, then the rects and offsets of each frame and the pixels
+    if(data.size() < PHASE_IMAGE_HEADER_SIZE)
+        return false;
+
+    uint8* p = data.data();
+    const Size size(stdext::readULE16(p), stdext::readULE16(p + 2));
+    const bool transparent = p[4] != 0;
+    if(static_cast<int>(stdext::readULE32(p + 5)) != frameCount ||
+       data.size() != PHASE_IMAGE_HEADER_SIZE + frameCount * PHASE_IMAGE_FRAME_SIZE + size.area() * 4)
+        return false;
+    p += PHASE_IMAGE_HEADER_SIZE;
+
+    const auto readPoint = [&p]() {
+        const Point point(static_cast<int32>(stdext::readULE32(p)), static_cast<int32>(stdext::readULE32(p + 4)));
+        p += 8;
+        return point;
+    };
+
+    phaseImage.framesRects.resize(frameCount);
+    phaseImage.framesOriginRects.resize(frameCount);
+    phaseImage.framesOffsets.resize(frameCount);
+    for(int i = 0; i < frameCount; ++i) {
+        const Point topLeft = readPoint();
+        phaseImage.framesRects[i] = Rect(topLeft, readPoint());
+        const Point originTopLeft = readPoint();
+        phaseImage.framesOriginRects[i] = Rect(originTopLeft, readPoint());
+        phaseImage.framesOffsets[i] = readPoint();
+    }
 
-    animationPhaseTexture = TexturePtr(new Texture(fullImage, true, false, m_size.area() == 1, false));
-    if(smoth)
-        animationPhaseTexture->setSmooth(true);
+    phaseImage.image = ImagePtr(new Image(size, 4, p));
+    phaseImage.image->setTransparentPixel(transparent);
+    return true;
+}
 
-    return animationPhaseTexture;
+void ThingType::storeCachedPhaseImage(uint64 key, const PhaseImage& phaseImage)
+{
+    const ImagePtr& image = phaseImage.image;
+    const int frameCount = phaseImage.framesRects.size();
+    const std::vector<uint8>& pixels = image->getPixels();
+
+    std::vector<uint8> data(PHASE_IMAGE_HEADER_SIZE + frameCount * PHASE_IMAGE_FRAME_SIZE + pixels.size());
+    uint8* p = data.data();
+    stdext::writeULE16(p, image->getWidth());
+    stdext::writeULE16(p + 2, image->getHeight());
+    p[4] = image->hasTransparentPixel() ? 1 : 0;
+    stdext::writeULE32(p + 5, frameCount);
+    p += PHASE_IMAGE_HEADER_SIZE;
+
+    const auto writePoint = [&p](const Point& point) {
+        stdext::writeULE32(p, static_cast<uint32>(point.x));
+        stdext::writeULE32(p + 4, static_cast<uint32>(point.y));
+        p += 8;
+    };
+
+    for(int i = 0; i < frameCount; ++i) {
+        writePoint(phaseImage.framesRects[i].topLeft());
+        writePoint(phaseImage.framesRects[i].bottomRight());
+        writePoint(phaseImage.framesOriginRects[i].topLeft());
+        writePoint(phaseImage.framesOriginRects[i].bottomRight());
+        writePoint(phaseImage.framesOffsets[i]);
+    }
+    memcpy(p, pixels.data(), pixels.size());
+
+    g_thingTextureCache.store(key, data);
 }
 
 Size ThingType::getBestTextureDimension(int w, int h, int count)
@@ -625,7 +1202,7 @@ Size ThingType::getBestTextureDimension(int w, int h, int count)
     return bestDimension;
 }
 
-uint ThingType::getSpriteIndex(int w, int h, int l, int x, int y, int z, int a)
+uint ThingType::getSpriteIndex(int w, int h, int l, int x, int y, int z, int a) const
 {
     const uint index =
         ((((((a % m_animationPhases)
@@ -639,7 +1216,7 @@ uint ThingType::getSpriteIndex(int w, int h, int l, int x, int y, int z, int a)
     return index;
 }
 
-uint ThingType::getTextureIndex(int l, int x, int y, int z)
+uint ThingType::getTextureIndex(int l, int x, int y, int z) const
 {
     return ((l * m_numPatternZ + z)
             * m_numPatternY + y)
@@ -663,6 +1240,7 @@ void ThingType::setPathable(bool var)
         m_attribs.remove(ThingAttrNotPathable);
     else
         m_attribs.set(ThingAttrNotPathable, true);
+    updateAttrCache();
 }
 
 int ThingType::getAnimationPhases()
@@ -34,10 +34,14 @@ enum class TextureType {
 
 #include <framework/core/declarations.h>
 #include <framework/graphics/texture.h>
+#include <framework/graphics/textureatlas.h>
 #include <framework/luaengine/luaobject.h>
 #include <framework/net/server.h>
 #include <framework/otml/declarations.h>
 
+#include <bitset>
+#include <future>
+
 #include <framework/core/declarations.h>
 #include <framework/core/scheduledevent.h>
 
@@ -112,7 +116,8 @@ enum SpriteMask {
     SpriteMaskRed = 1,
     SpriteMaskGreen,
     SpriteMaskBlue,
-    SpriteMaskYellow
+    SpriteMaskYellow,
+    SpriteMaskPacked // the four masks in their own colors, read by the outfit shader
 };
 
 struct MarketData {
@@ -135,19 +140,28 @@ class ThingType : public LuaObject
 {
 public:
     ThingType();
+    ~ThingType();
 
     void unserialize(uint16 clientId, ThingCategory category, const FileStreamPtr& fin);
     void unserializeOtml(const OTMLNodePtr& node);
 
     void serialize(const FileStreamPtr& fin);
+    // parsed state without any client version translation, see ThingTypeManager::loadDat
+    void unserializeSnapshot(uint16 clientId, ThingCategory category, const FileStreamPtr& fin);
+    void serializeSnapshot(const FileStreamPtr& fin);
     void exportImage(const std::string& fileName);
 
     void draw(const Point& dest, float scaleFactor, int layer, int xPattern, int yPattern, int zPattern, int animationPhase, TextureType textureType, Color color = Color::white, int frameFlags = Otc::FUpdateThing, LightView* lightView = nullptr);
+    // base frame tinted by the packed mask in a single quad, maskColors are head, body, legs and feet
+    void drawMasked(const Point& dest, float scaleFactor, int xPattern, int yPattern, int zPattern, int animationPhase, TextureType textureType, const std::array<uint32, 4>& maskColors, Color color = Color::white);
+    // decodes a single frame over image, placed as draw would at scale 1. Only reads sprites, so it may run on the
+    // async dispatcher, maskColors are head, body, legs and feet and tint the frame as the outfit masks do
+    void composeFrame(const ImagePtr& image, const Point& dest, int xPattern, int yPattern, int zPattern, int animationPhase, const std::array<Color, 4>* maskColors = nullptr) const;
 
     uint16 getId() { return m_id; }
     ThingCategory getCategory() { return m_category; }
     bool isNull() { return m_null; }
-    bool hasAttr(ThingAttr attr) { return m_attribs.has(attr); }
+    bool hasAttr(ThingAttr attr) { return m_flags.test(attr); }
 
     Size getSize() { return m_size; }
     int getWidth() { return m_size.width(); }
@@ -159,61 +173,61 @@ public:
     int getNumPatternY() { return m_numPatternY; }
     int getNumPatternZ() { return m_numPatternZ; }
     int getAnimationPhases();
-    AnimatorPtr getAnimator() { return m_animator; }
-    AnimatorPtr getIdleAnimator() { return m_idleAnimator; }
+    const AnimatorPtr& getAnimator() { return m_animator; }
+    const AnimatorPtr& getIdleAnimator() { return m_idleAnimator; }
 
     Point getDisplacement() { return m_displacement; }
     int getDisplacementX() { return getDisplacement().x; }
     int getDisplacementY() { return getDisplacement().y; }
     int getElevation() { return m_elevation; }
 
-    int getGroundSpeed() { return m_attribs.get<uint16>(ThingAttrGround); }
+    int getGroundSpeed() { return m_groundSpeed; }
     int getMaxTextLength() { return m_attribs.has(ThingAttrWritableOnce) ? m_attribs.get<uint16>(ThingAttrWritableOnce) : m_attribs.get<uint16>(ThingAttrWritable); }
-    Light getLight() { return m_attribs.get<Light>(ThingAttrLight); }
-    int getMinimapColor() { return m_attribs.get<uint16>(ThingAttrMinimapColor); }
+    Light getLight() { return m_light; }
+    int getMinimapColor() { return m_minimapColor; }
     int getLensHelp() { return m_attribs.get<uint16>(ThingAttrLensHelp); }
     int getClothSlot() { return m_attribs.get<uint16>(ThingAttrCloth); }
     MarketData getMarketData() { return m_attribs.get<MarketData>(ThingAttrMarket); }
-    bool isGround() { return m_attribs.has(ThingAttrGround); }
-    bool isGroundBorder() { return m_attribs.has(ThingAttrGroundBorder); }
-    bool isOnBottom() { return m_attribs.has(ThingAttrOnBottom); }
-    bool isOnTop() { return m_attribs.has(ThingAttrOnTop); }
-    bool isContainer() { return m_attribs.has(ThingAttrContainer); }
-    bool isStackable() { return m_attribs.has(ThingAttrStackable); }
-    bool isForceUse() { return m_attribs.has(ThingAttrForceUse); }
-    bool isMultiUse() { return m_attribs.has(ThingAttrMultiUse); }
-    bool isWritable() { return m_attribs.has(ThingAttrWritable); }
-    bool isChargeable() { return m_attribs.has(ThingAttrChargeable); }
-    bool isWritableOnce() { return m_attribs.has(ThingAttrWritableOnce); }
-    bool isFluidContainer() { return m_attribs.has(ThingAttrFluidContainer); }
-    bool isSplash() { return m_attribs.has(ThingAttrSplash); }
-    bool isNotWalkable() { return m_attribs.has(ThingAttrNotWalkable); }
-    bool isNotMoveable() { return m_attribs.has(ThingAttrNotMoveable); }
-    bool blockProjectile() { return m_attribs.has(ThingAttrBlockProjectile); }
-    bool isNotPathable() { return m_attribs.has(ThingAttrNotPathable); }
-    bool isPickupable() { return m_attribs.has(ThingAttrPickupable); }
-    bool isHangable() { return m_attribs.has(ThingAttrHangable); }
-    bool isHookSouth() { return m_attribs.has(ThingAttrHookSouth); }
-    bool isHookEast() { return m_attribs.has(ThingAttrHookEast); }
-    bool isRotateable() { return m_attribs.has(ThingAttrRotateable); }
-    bool hasLight() { return m_attribs.has(ThingAttrLight); }
-    bool isDontHide() { return m_attribs.has(ThingAttrDontHide); }
-    bool isTranslucent() { return m_attribs.has(ThingAttrTranslucent); }
-    bool hasDisplacement() { return m_attribs.has(ThingAttrDisplacement); }
-    bool hasElevation() { return m_attribs.has(ThingAttrElevation); }
-    bool isLyingCorpse() { return m_attribs.has(ThingAttrLyingCorpse); }
-    bool isAnimateAlways() { return m_attribs.has(ThingAttrAnimateAlways); }
-    bool hasMiniMapColor() { return m_attribs.has(ThingAttrMinimapColor); }
-    bool hasLensHelp() { return m_attribs.has(ThingAttrLensHelp); }
-    bool isFullGround() { return m_attribs.has(ThingAttrFullGround); }
-    bool isIgnoreLook() { return m_attribs.has(ThingAttrLook); }
-    bool isCloth() { return m_attribs.has(ThingAttrCloth); }
-    bool isMarketable() { return m_attribs.has(ThingAttrMarket); }
-    bool isUsable() { return m_attribs.has(ThingAttrUsable); }
-    bool isWrapable() { return m_attribs.has(ThingAttrWrapable); }
-    bool isUnwrapable() { return m_attribs.has(ThingAttrUnwrapable); }
-    bool isTopEffect() { return m_attribs.has(ThingAttrTopEffect); }
-    bool hasAction() { return m_attribs.has(ThingAttrDefaultAction); }
+    bool isGround() { return m_flags.test(ThingAttrGround); }
+    bool isGroundBorder() { return m_flags.test(ThingAttrGroundBorder); }
+    bool isOnBottom() { return m_flags.test(ThingAttrOnBottom); }
+    bool isOnTop() { return m_flags.test(ThingAttrOnTop); }
+    bool isContainer() { return m_flags.test(ThingAttrContainer); }
+    bool isStackable() { return m_flags.test(ThingAttrStackable); }
+    bool isForceUse() { return m_flags.test(ThingAttrForceUse); }
+    bool isMultiUse() { return m_flags.test(ThingAttrMultiUse); }
+    bool isWritable() { return m_flags.test(ThingAttrWritable); }
+    bool isChargeable() { return m_flags.test(ThingAttrChargeable); }
+    bool isWritableOnce() { return m_flags.test(ThingAttrWritableOnce); }
+    bool isFluidContainer() { return m_flags.test(ThingAttrFluidContainer); }
+    bool isSplash() { return m_flags.test(ThingAttrSplash); }
+    bool isNotWalkable() { return m_flags.test(ThingAttrNotWalkable); }
+    bool isNotMoveable() { return m_flags.test(ThingAttrNotMoveable); }
+    bool blockProjectile() { return m_flags.test(ThingAttrBlockProjectile); }
+    bool isNotPathable() { return m_flags.test(ThingAttrNotPathable); }
+    bool isPickupable() { return m_flags.test(ThingAttrPickupable); }
+    bool isHangable() { return m_flags.test(ThingAttrHangable); }
+    bool isHookSouth() { return m_flags.test(ThingAttrHookSouth); }
+    bool isHookEast() { return m_flags.test(ThingAttrHookEast); }
+    bool isRotateable() { return m_flags.test(ThingAttrRotateable); }
+    bool hasLight() { return m_flags.test(ThingAttrLight); }
+    bool isDontHide() { return m_flags.test(ThingAttrDontHide); }
+    bool isTranslucent() { return m_flags.test(ThingAttrTranslucent); }
+    bool hasDisplacement() { return m_flags.test(ThingAttrDisplacement); }
+    bool hasElevation() { return m_flags.test(ThingAttrElevation); }
+    bool isLyingCorpse() { return m_flags.test(ThingAttrLyingCorpse); }
+    bool isAnimateAlways() { return m_flags.test(ThingAttrAnimateAlways); }
+    bool hasMiniMapColor() { return m_flags.test(ThingAttrMinimapColor); }
+    bool hasLensHelp() { return m_flags.test(ThingAttrLensHelp); }
+    bool isFullGround() { return m_flags.test(ThingAttrFullGround); }
+    bool isIgnoreLook() { return m_flags.test(ThingAttrLook); }
+    bool isCloth() { return m_flags.test(ThingAttrCloth); }
+    bool isMarketable() { return m_flags.test(ThingAttrMarket); }
+    bool isUsable() { return m_flags.test(ThingAttrUsable); }
+    bool isWrapable() { return m_flags.test(ThingAttrWrapable); }
+    bool isUnwrapable() { return m_flags.test(ThingAttrUnwrapable); }
+    bool isTopEffect() { return m_flags.test(ThingAttrTopEffect); }
+    bool hasAction() { return m_flags.test(ThingAttrDefaultAction); }
     bool isOpaque() { return m_opaque; }
     bool isTall(const bool useRealSize = false) { return useRealSize ? getRealSize() > Otc::TILE_PIXELS : getHeight() > 1; }
     bool isTopGround() { return isGround() && !isFullGround() && blockProjectile() && !isSingleDimension(); }
@@ -222,25 +236,70 @@ public:
 
     // additional
     float getOpacity() { return m_opacity; }
-    bool isNotPreWalkable() { return m_attribs.has(ThingAttrNotPreWalkable); }
+    bool isNotPreWalkable() { return m_flags.test(ThingAttrNotPreWalkable); }
     void setPathable(bool var);
     int getExactHeight();
     const TexturePtr& getTexture(int animationPhase, const TextureType txtType = TextureType::NONE);
 
     void generateTextureCache();
 
+    // prewarming composes the missing phase images on worker threads and uploads the finished ones later,
+    // draws that reach a phase first simply take its pending image
+    int requestPhaseImages(TextureType txtType = TextureType::NONE);
+    int commitPhaseImages(int max);
+    bool hasPendingPhaseImages() { return !m_pendingImages.empty(); }
+    // placeholders handed out while phase images were still being composed, caches of drawn frames compare it
+    static uint32 getPlaceholderCount() { return s_placeholderCount; }
+
 private:
-    bool hasTexture() const { return !m_textures.empty(); }
+    enum {
+        MIP_LEVELS = 2, // each halves the previous image, down to 8 pixels per tile
+        PHASE_IMAGE_HEADER_SIZE = 2 + 2 + 1 + 4,
+        PHASE_IMAGE_FRAME_SIZE = 5 * 8 // rect corners, origin rect corners and offset
+    };
+
+    // animation phase image composed from sprites, built on async dispatcher threads
+    struct PhaseImage {
+        ImagePtr image;
+        std::vector<Rect> framesRects;
+        std::vector<Rect> framesOriginRects;
+        std::vector<Point> framesOffsets;
+    };
+
+    bool hasTexture() const { return m_animationPhases > 0; }
+    // the per phase caches are only allocated once the thing is drawn, most of the dat never is
+    void resizeTextureCache();
+    void updateAttrCache();
+    const AtlasRegionPtr& getTextureRegion(int animationPhase, TextureType txtType, bool async = false);
+    const AtlasRegionPtr& getPlaceholderRegion(int animationPhase, TextureType txtType);
+    int getMipLevel(float scaleFactor, int animationPhase, TextureType txtType) const;
+    const AtlasRegionPtr& getMipRegion(int animationPhase, int level);
+    const AtlasRegionPtr& commitPhaseImage(PhaseImage& phaseImage, int animationPhase, TextureType txtType);
+    PhaseImage composePhaseImage(int animationPhase, TextureType txtType) const;
+    static bool loadCachedPhaseImage(uint64 key, int frameCount, PhaseImage& phaseImage);
+    static void storeCachedPhaseImage(uint64 key, const PhaseImage& phaseImage);
+    void setDrawSampling(TextureType txtType, bool enabled);
+
+    static TextureType getStoredTextureType(TextureType txtType);
 
     static Size getBestTextureDimension(int w, int h, int count);
-    uint getSpriteIndex(int w, int h, int l, int x, int y, int z, int a);
-    uint getTextureIndex(int l, int x, int y, int z);
+
+    static uint32 s_placeholderCount;
+
+    uint getSpriteIndex(int w, int h, int l, int x, int y, int z, int a) const;
+    uint getTextureIndex(int l, int x, int y, int z) const;
 
     ThingCategory m_category;
     uint16 m_id;
     bool m_null, m_opaque{ false };
     stdext::dynamic_storage<uint8> m_attribs;
 
+    // copies of m_attribs for the predicates called from tile and path finding loops, see updateAttrCache
+    std::bitset<ThingLastAttr> m_flags;
+    uint16 m_groundSpeed{ 0 };
+    uint16 m_minimapColor{ 0 };
+    Light m_light;
+
     Size m_size;
     Point m_displacement;
     AnimatorPtr m_animator;
@@ -257,14 +316,21 @@ private:
 
     std::vector<int> m_spritesIndex;
 
-    std::vector<TexturePtr> m_textures,
-        m_blankTextures,
-        m_smoothTextures;
+    // smooth images are m_textures sampled with bilinear filtering, blank images are only
+    // composed when the painter can't draw silhouettes, see getStoredTextureType
+    std::vector<AtlasRegionPtr> m_textures,
+        m_blankTextures;
 
     std::vector<std::vector<Rect>> m_texturesFramesRects;
     std::vector<std::vector<Rect>> m_texturesFramesOriginRects;
     std::vector<std::vector<Point>> m_texturesFramesOffsets;
 
+    std::unordered_map<uint, std::shared_future<PhaseImage>> m_pendingImages;
+
+    // downscaled phase images for zoomed out views, see getMipRegion
+    std::array<std::vector<AtlasRegionPtr>, MIP_LEVELS> m_mipTextures;
+    std::unordered_map<uint, std::shared_future<ImagePtr>> m_pendingMips;
+
     uint_fast8_t m_countPainterListeningRef;
     ScheduledEventPtr m_painterListeningEvent;
 };
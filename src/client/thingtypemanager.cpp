@@ -30,10 +30,10 @@
 #include "thingtype.h"
 
 #include <framework/core/binarytree.h>
+#include <framework/core/eventdispatcher.h>
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/otml/otml.h>
-#include <framework/xml/tinyxml.h>
 
 ThingTypeManager g_things;
 
@@ -43,11 +43,13 @@ void ThingTypeManager::init()
     m_nullItemType = ItemTypePtr(new ItemType);
     m_datSignature = 0;
     m_contentRevision = 0;
+    m_datLoadCount = 1;
     m_otbMinorVersion = 0;
     m_otbMajorVersion = 0;
     m_datLoaded = false;
     m_xmlLoaded = false;
     m_otbLoaded = false;
+    m_itemNamesDirty = true;
     for(auto& m_thingType : m_thingTypes)
         m_thingType.resize(1, m_nullThingType);
     m_itemTypes.resize(1, m_nullItemType);
@@ -55,10 +57,13 @@ void ThingTypeManager::init()
 
 void ThingTypeManager::terminate()
 {
+    cancelTexturePrewarm();
     for(auto& m_thingType : m_thingTypes)
         m_thingType.clear();
     m_itemTypes.clear();
     m_reverseItemTypes.clear();
+    m_itemNames.clear();
+    m_itemNameTrigrams.clear();
     m_nullThingType = nullptr;
     m_nullItemType = nullptr;
 }
@@ -101,6 +106,9 @@ bool ThingTypeManager::loadDat(std::string file)
     m_datLoaded = false;
     m_datSignature = 0;
     m_contentRevision = 0;
+    if(++m_datLoadCount == 0)
+        ++m_datLoadCount;
+    cancelTexturePrewarm();
     try {
         file = g_resources.guessFilePath(file, "dat");
 
@@ -109,6 +117,13 @@ bool ThingTypeManager::loadDat(std::string file)
         m_datSignature = fin->getU32();
         m_contentRevision = static_cast<uint16_t>(m_datSignature);
 
+        const uint32 datSize = fin->size();
+        if(loadDatSnapshot(datSize)) {
+            m_datLoaded = true;
+            g_lua.callGlobalField("g_things", "onLoadDat", file);
+            return true;
+        }
+
         for(auto& m_thingType : m_thingTypes) {
             const int count = fin->getU16() + 1;
             m_thingType.clear();
@@ -126,6 +141,7 @@ bool ThingTypeManager::loadDat(std::string file)
             }
         }
 
+        saveDatSnapshot(datSize);
         m_datLoaded = true;
         g_lua.callGlobalField("g_things", "onLoadDat", file);
         return true;
@@ -135,6 +151,97 @@ bool ThingTypeManager::loadDat(std::string file)
     }
 }
 
+std::string ThingTypeManager::getDatSnapshotFile()
+{
+    return stdext::format("/thingtypes_%d.snapshot", g_game.getClientVersion());
+}
+
+uint32 ThingTypeManager::getDatSnapshotFeatures()
+{
+    uint32 features = 0;
+    for(const Otc::GameFeature feature : { Otc::GameIdleAnimations, Otc::GameEnhancedAnimations, Otc::GameSpritesU32 })
+        features = (features << 1) | (g_game.getFeature(feature) ? 1 : 0);
+    return features;
+}
+
+bool ThingTypeManager::loadDatSnapshot(uint32 datSize)
+{
+    const std::string fileName = getDatSnapshotFile();
+    if(!g_resources.fileExists(fileName))
+        return false;
+
+    try {
+        FileStreamPtr fin = g_resources.openFile(fileName);
+        fin->cache();
+
+        if(fin->getU32() != THINGS_SNAPSHOT_SIGNATURE || fin->getU16() != THINGS_SNAPSHOT_VERSION ||
+           fin->getU32() != m_datSignature || fin->getU32() != datSize ||
+           fin->getU16() != g_game.getClientVersion() || fin->getU32() != getDatSnapshotFeatures())
+            return false;
+
+        for(auto& m_thingType : m_thingTypes) {
+            const int count = fin->getU16() + 1;
+            m_thingType.clear();
+            m_thingType.resize(count, m_nullThingType);
+        }
+
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            uint16 firstId = 1;
+            if(category == ThingCategoryItem)
+                firstId = 100;
+            for(uint16 id = firstId; id < m_thingTypes[category].size(); ++id) {
+                ThingTypePtr type(new ThingType);
+                type->unserializeSnapshot(id, static_cast<ThingCategory>(category), fin);
+                m_thingTypes[category][id] = type;
+            }
+        }
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.warning(stdext::format("Discarding thing types snapshot '%s': %s", fileName, e.what()));
+        for(auto& m_thingType : m_thingTypes) {
+            m_thingType.clear();
+            m_thingType.resize(1, m_nullThingType);
+        }
+        return false;
+    }
+}
+
+void ThingTypeManager::saveDatSnapshot(uint32 datSize)
+{
+    const std::string fileName = getDatSnapshotFile();
+    try {
+        FileStreamPtr fin = g_resources.createFile(fileName);
+        if(!fin)
+            stdext::throw_exception("failed to open file for write");
+
+        fin->cache();
+
+        fin->addU32(THINGS_SNAPSHOT_SIGNATURE);
+        fin->addU16(THINGS_SNAPSHOT_VERSION);
+        fin->addU32(m_datSignature);
+        fin->addU32(datSize);
+        fin->addU16(g_game.getClientVersion());
+        fin->addU32(getDatSnapshotFeatures());
+
+        for(auto& m_thingType : m_thingTypes)
+            fin->addU16(m_thingType.size() - 1);
+
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            uint16 firstId = 1;
+            if(category == ThingCategoryItem)
+                firstId = 100;
+
+            for(uint16 id = firstId; id < m_thingTypes[category].size(); ++id)
+                m_thingTypes[category][id]->serializeSnapshot(fin);
+        }
+
+        fin->flush();
+        fin->close();
+    } catch(std::exception& e) {
+        g_logger.warning(stdext::format("Failed to save thing types snapshot '%s': %s", fileName, e.what()));
+    }
+}
+
 bool ThingTypeManager::loadOtml(std::string file)
 {
     try {
@@ -174,36 +281,40 @@ void ThingTypeManager::loadOtb(const std::string& file)
 {
     try {
         FileStreamPtr fin = g_resources.openFile(file);
+        fin->cache();
 
         uint signature = fin->getU32();
         if(signature != 0)
             stdext::throw_exception("invalid otb file");
 
-        BinaryTreePtr root = fin->getBinaryTree();
-        root->skip(1); // otb first byte is always 0
+        BinaryTreeView root = BinaryTreeView::fromStream(fin);
+        root.skip(1); // otb first byte is always 0
 
-        signature = root->getU32();
+        signature = root.getU32();
         if(signature != 0)
             stdext::throw_exception("invalid otb file");
 
-        const uint8 rootAttr = root->getU8();
+        const uint8 rootAttr = root.getU8();
         if(rootAttr == 0x01) { // OTB_ROOT_ATTR_VERSION
-            const uint16 size = root->getU16();
+            const uint16 size = root.getU16();
             if(size != 4 + 4 + 4 + 128)
                 stdext::throw_exception("invalid otb root attr version size");
 
-            m_otbMajorVersion = root->getU32();
-            m_otbMinorVersion = root->getU32();
-            root->skip(4); // buildNumber
-            root->skip(128); // description
+            m_otbMajorVersion = root.getU32();
+            m_otbMinorVersion = root.getU32();
+            root.skip(4); // buildNumber
+            root.skip(128); // description
         }
 
-        BinaryTreeVec children = root->getChildren();
+        uint childCount = 0;
+        for(auto it = root.getChildren().begin(), end = root.getChildren().end(); it != end; ++it)
+            ++childCount;
+
         m_reverseItemTypes.clear();
-        m_itemTypes.resize(children.size() + 1, m_nullItemType);
-        m_reverseItemTypes.resize(children.size() + 1, m_nullItemType);
+        m_itemTypes.resize(childCount + 1, m_nullItemType);
+        m_reverseItemTypes.resize(childCount + 1, m_nullItemType);
 
-        for(const BinaryTreePtr& node : children) {
+        for(BinaryTreeView node : root.getChildren()) {
             ItemTypePtr itemType(new ItemType);
             itemType->unserialize(node);
             addItemType(itemType);
@@ -215,6 +326,7 @@ void ThingTypeManager::loadOtb(const std::string& file)
         }
 
         m_otbLoaded = true;
+        m_itemNamesDirty = true;
         g_lua.callGlobalField("g_things", "onLoadOtb", file);
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to load '%s' (OTB file): %s", file, e.what()));
@@ -227,52 +339,61 @@ void ThingTypeManager::loadXml(const std::string& file)
         if(!isOtbLoaded())
             stdext::throw_exception("OTB must be loaded before XML");
 
-        TiXmlDocument doc;
-        doc.Parse(g_resources.readFileContents(file).c_str());
-        if(doc.Error())
-            stdext::throw_exception(stdext::format("failed to parse '%s': '%s'", file, doc.ErrorDesc()));
-
-        TiXmlElement* root = doc.FirstChildElement();
-        if(!root || root->ValueTStr() != "items")
-            stdext::throw_exception("invalid root tag name");
+        XmlReader reader(g_resources.readFileContents(file), file);
+        reader.readRoot("items");
 
-        for(TiXmlElement* element = root->FirstChildElement(); element; element = element->NextSiblingElement()) {
-            if(unlikely(element->ValueTStr() != "item"))
+        // the children of an element can only be read once, so they are applied to all of its ids together
+        std::vector<ItemTypePtr> itemTypes;
+        while(reader.nextChild(1)) {
+            if(unlikely(!reader.isName("item")))
                 continue;
 
-            const uint16 id = element->readType<uint16>("id");
+            itemTypes.clear();
+            const std::string name = reader.getAttribute("name");
+            const uint16 id = reader.readAttribute<uint16>("id");
             if(id != 0) {
-                std::vector<std::string> s_ids = stdext::split(element->Attribute("id"), ";");
+                std::vector<std::string> s_ids = stdext::split(reader.getAttribute("id"), ";");
                 for(const std::string& s : s_ids) {
                     std::vector<int32> ids = stdext::split<int32>(s, "-");
                     if(ids.size() > 1) {
                         int32 i = ids[0];
                         while(i <= ids[1])
-                            parseItemType(++i, element);
+                            itemTypes.push_back(parseItemType(++i, name));
                     } else
-                        parseItemType(atoi(s.c_str()), element);
+                        itemTypes.push_back(parseItemType(atoi(s.c_str()), name));
                 }
             } else {
-                std::vector<int32> begin = stdext::split<int32>(element->Attribute("fromid"), ";");
-                std::vector<int32> end = stdext::split<int32>(element->Attribute("toid"), ";");
+                std::vector<int32> begin = stdext::split<int32>(reader.getAttribute("fromid"), ";");
+                std::vector<int32> end = stdext::split<int32>(reader.getAttribute("toid"), ";");
                 if(begin[0] && begin.size() == end.size()) {
                     const size_t size = begin.size();
                     for(size_t i = 0; i < size; ++i)
                         while(begin[i] <= end[i])
-                            parseItemType(++begin[i], element);
+                            itemTypes.push_back(parseItemType(++begin[i], name));
                 }
             }
+
+            const int depth = reader.getDepth();
+            while(reader.nextChild(depth)) {
+                std::string key = reader.getAttribute("key");
+                if(key.empty())
+                    continue;
+
+                stdext::tolower(key);
+                for(const ItemTypePtr& itemType : itemTypes)
+                    parseItemAttribute(itemType, key, reader);
+            }
         }
 
-        doc.Clear();
         m_xmlLoaded = true;
+        m_itemNamesDirty = true;
         g_logger.debug("items.xml read successfully.");
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to load '%s' (XML file): %s", file, e.what()));
     }
 }
 
-void ThingTypeManager::parseItemType(uint16 serverId, TiXmlElement* elem)
+ItemTypePtr ThingTypeManager::parseItemType(uint16 serverId, const std::string& name)
 {
     ItemTypePtr itemType = nullptr;
 
@@ -295,36 +416,34 @@ void ThingTypeManager::parseItemType(uint16 serverId, TiXmlElement* elem)
     } else
         itemType = getItemType(serverId);
 
-    itemType->setName(elem->Attribute("name"));
-    for(TiXmlElement* attrib = elem->FirstChildElement(); attrib; attrib = attrib->NextSiblingElement()) {
-        std::string key = attrib->Attribute("key");
-        if(key.empty())
-            continue;
+    itemType->setName(name);
+    return itemType;
+}
 
-        stdext::tolower(key);
-        if(key == "description")
-            itemType->setDesc(attrib->Attribute("value"));
-        else if(key == "weapontype")
-            itemType->setCategory(ItemCategoryWeapon);
-        else if(key == "ammotype")
-            itemType->setCategory(ItemCategoryAmmunition);
-        else if(key == "armor")
-            itemType->setCategory(ItemCategoryArmor);
-        else if(key == "charges")
-            itemType->setCategory(ItemCategoryCharges);
-        else if(key == "type") {
-            std::string value = attrib->Attribute("value");
-            stdext::tolower(value);
-
-            if(value == "key")
-                itemType->setCategory(ItemCategoryKey);
-            else if(value == "magicfield")
-                itemType->setCategory(ItemCategoryMagicField);
-            else if(value == "teleport")
-                itemType->setCategory(ItemCategoryTeleport);
-            else if(value == "door")
-                itemType->setCategory(ItemCategoryDoor);
-        }
+void ThingTypeManager::parseItemAttribute(const ItemTypePtr& itemType, const std::string& key, const XmlReader& reader)
+{
+    if(key == "description")
+        itemType->setDesc(reader.getAttribute("value"));
+    else if(key == "weapontype")
+        itemType->setCategory(ItemCategoryWeapon);
+    else if(key == "ammotype")
+        itemType->setCategory(ItemCategoryAmmunition);
+    else if(key == "armor")
+        itemType->setCategory(ItemCategoryArmor);
+    else if(key == "charges")
+        itemType->setCategory(ItemCategoryCharges);
+    else if(key == "type") {
+        std::string value = reader.getAttribute("value");
+        stdext::tolower(value);
+
+        if(value == "key")
+            itemType->setCategory(ItemCategoryKey);
+        else if(value == "magicfield")
+            itemType->setCategory(ItemCategoryMagicField);
+        else if(value == "teleport")
+            itemType->setCategory(ItemCategoryTeleport);
+        else if(value == "door")
+            itemType->setCategory(ItemCategoryDoor);
     }
 }
 
@@ -334,6 +453,7 @@ void ThingTypeManager::addItemType(const ItemTypePtr& itemType)
     if(unlikely(id >= m_itemTypes.size()))
         m_itemTypes.resize(id + 1, m_nullItemType);
     m_itemTypes[id] = itemType;
+    m_itemNamesDirty = true;
 }
 
 const ItemTypePtr& ThingTypeManager::findItemTypeByClientId(uint16 id)
@@ -346,29 +466,161 @@ const ItemTypePtr& ThingTypeManager::findItemTypeByClientId(uint16 id)
     return m_nullItemType;
 }
 
+namespace {
+    uint32 getTrigram(const std::string& text, size_t pos)
+    {
+        return static_cast<uint8>(text[pos]) | (static_cast<uint8>(text[pos + 1]) << 8) | (static_cast<uint8>(text[pos + 2]) << 16);
+    }
+}
+
+void ThingTypeManager::updateItemNameIndex()
+{
+    if(!m_itemNamesDirty)
+        return;
+    m_itemNamesDirty = false;
+
+    m_itemNames.clear();
+    m_itemNameTrigrams.clear();
+    for(const ItemTypePtr& itemType : m_itemTypes) {
+        std::string name = itemType->getName();
+        if(name.empty())
+            continue;
+        stdext::tolower(name);
+        m_itemNames.push_back({ std::move(name), itemType });
+    }
+
+    std::stable_sort(m_itemNames.begin(), m_itemNames.end(), [](const ItemNameEntry& a, const ItemNameEntry& b) { return a.name < b.name; });
+
+    for(uint i = 0; i < m_itemNames.size(); ++i) {
+        const std::string& name = m_itemNames[i].name;
+        for(size_t pos = 0; pos + 3 <= name.size(); ++pos) {
+            std::vector<uint>& entries = m_itemNameTrigrams[getTrigram(name, pos)];
+            if(entries.empty() || entries.back() != i)
+                entries.push_back(i);
+        }
+    }
+}
+
+std::vector<uint> ThingTypeManager::findItemNameCandidates(const std::string& lowerName)
+{
+    updateItemNameIndex();
+
+    std::vector<uint> ret;
+    if(lowerName.size() < 3) {
+        for(uint i = 0; i < m_itemNames.size(); ++i) {
+            if(m_itemNames[i].name.find(lowerName) != std::string::npos)
+                ret.push_back(i);
+        }
+        return ret;
+    }
+
+    // the rarest sequence of the query bounds the entries to look at
+    const std::vector<uint>* best = nullptr;
+    for(size_t pos = 0; pos + 3 <= lowerName.size(); ++pos) {
+        auto it = m_itemNameTrigrams.find(getTrigram(lowerName, pos));
+        if(it == m_itemNameTrigrams.end())
+            return ret;
+        if(!best || it->second.size() < best->size())
+            best = &it->second;
+    }
+
+    for(uint i : *best) {
+        if(m_itemNames[i].name.find(lowerName) != std::string::npos)
+            ret.push_back(i);
+    }
+    return ret;
+}
+
 const ItemTypePtr& ThingTypeManager::findItemTypeByName(const std::string& name)
 {
-    for(const ItemTypePtr& it : m_itemTypes)
-        if(it->getName() == name)
-            return it;
+    std::string lowerName = name;
+    stdext::tolower(lowerName);
+    updateItemNameIndex();
+
+    auto it = std::lower_bound(m_itemNames.begin(), m_itemNames.end(), lowerName, [](const ItemNameEntry& entry, const std::string& key) { return entry.name < key; });
+    for(; it != m_itemNames.end() && it->name == lowerName; ++it) {
+        if(it->itemType->getName() == name)
+            return it->itemType;
+    }
     return m_nullItemType;
 }
 
 ItemTypeList ThingTypeManager::findItemTypesByName(const std::string& name)
 {
+    std::string lowerName = name;
+    stdext::tolower(lowerName);
+    updateItemNameIndex();
+
     ItemTypeList ret;
-    for(const ItemTypePtr& it : m_itemTypes)
-        if(it->getName() == name)
-            ret.push_back(it);
+    auto it = std::lower_bound(m_itemNames.begin(), m_itemNames.end(), lowerName, [](const ItemNameEntry& entry, const std::string& key) { return entry.name < key; });
+    for(; it != m_itemNames.end() && it->name == lowerName; ++it) {
+        if(it->itemType->getName() == name)
+            ret.push_back(it->itemType);
+    }
     return ret;
 }
 
 ItemTypeList ThingTypeManager::findItemTypesByString(const std::string& name)
 {
+    std::string lowerName = name;
+    stdext::tolower(lowerName);
+
     ItemTypeList ret;
-    for(const ItemTypePtr& it : m_itemTypes)
-        if(it->getName().find(name) != std::string::npos)
-            ret.push_back(it);
+    for(uint i : findItemNameCandidates(lowerName)) {
+        const ItemTypePtr& itemType = m_itemNames[i].itemType;
+        if(itemType->getName().find(name) != std::string::npos)
+            ret.push_back(itemType);
+    }
+
+    // same order as the item types table
+    std::sort(ret.begin(), ret.end(), [](const ItemTypePtr& a, const ItemTypePtr& b) { return a->getServerId() < b->getServerId(); });
+    return ret;
+}
+
+ItemTypeList ThingTypeManager::searchItemTypes(const std::string& query, int limit)
+{
+    std::string lowerQuery = query;
+    stdext::tolower(lowerQuery);
+    stdext::trim(lowerQuery);
+
+    ItemTypeList ret;
+    if(lowerQuery.empty() || limit <= 0)
+        return ret;
+
+    struct Match {
+        int rank;
+        uint index;
+    };
+
+    std::vector<Match> matches;
+    for(uint i : findItemNameCandidates(lowerQuery)) {
+        const std::string& name = m_itemNames[i].name;
+        int rank;
+        if(name == lowerQuery)
+            rank = 0;
+        else if(stdext::starts_with(name, lowerQuery))
+            rank = 1;
+        else if(name.find(" " + lowerQuery) != std::string::npos)
+            rank = 2;
+        else
+            rank = 3;
+        matches.push_back({ rank, i });
+    }
+
+    // shorter names are closer to what was typed, ties keep the alphabetical order of the index
+    const auto better = [this](const Match& a, const Match& b) {
+        if(a.rank != b.rank)
+            return a.rank < b.rank;
+        const size_t aSize = m_itemNames[a.index].name.size(), bSize = m_itemNames[b.index].name.size();
+        if(aSize != bSize)
+            return aSize < bSize;
+        return a.index < b.index;
+    };
+
+    const size_t count = std::min<size_t>(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), better);
+    for(size_t i = 0; i < count; ++i)
+        ret.push_back(m_itemNames[matches[i].index].itemType);
     return ret;
 }
 
@@ -417,3 +669,70 @@ const ThingTypeList& ThingTypeManager::getThingTypes(ThingCategory category)
 }
 
 /* vim: set ts=4 sw=4 et: */
+
+void ThingTypeManager::prewarmTextures(const ThingTypeList& thingTypes)
+{
+    cancelTexturePrewarm();
+    if(thingTypes.empty())
+        return;
+
+    m_prewarmQueue.assign(thingTypes.begin(), thingTypes.end());
+    m_prewarmTotal = thingTypes.size();
+    m_prewarmEvent = g_dispatcher.cycleEvent(std::bind(&ThingTypeManager::pollTexturePrewarm, this), 1);
+}
+
+void ThingTypeManager::cancelTexturePrewarm()
+{
+    if(m_prewarmEvent) {
+        m_prewarmEvent->cancel();
+        m_prewarmEvent = nullptr;
+    }
+    m_prewarmQueue.clear();
+    m_prewarmPending.clear();
+    m_prewarmTotal = m_prewarmDone = 0;
+}
+
+void ThingTypeManager::pollTexturePrewarm()
+{
+    stdext::timer timer;
+
+    // without async decoding sprites can only be read here, build a bounded slice of types synchronously
+    if(!g_sprites.isAsyncDecoding()) {
+        while(!m_prewarmQueue.empty() && timer.elapsed_millis() < PREWARM_FRAME_BUDGET) {
+            const ThingTypePtr thingType = m_prewarmQueue.front();
+            m_prewarmQueue.pop_front();
+            for(int phase = 0; phase < thingType->getAnimationPhases(); ++phase)
+                thingType->getTexture(phase);
+            ++m_prewarmDone;
+        }
+    } else {
+        // a bounded number of types composes at once, so those queued first (the visible ones) finish first
+        while(m_prewarmPending.size() < PREWARM_TYPES_IN_FLIGHT && !m_prewarmQueue.empty()) {
+            const ThingTypePtr thingType = m_prewarmQueue.front();
+            m_prewarmQueue.pop_front();
+            thingType->requestPhaseImages();
+            if(thingType->hasPendingPhaseImages())
+                m_prewarmPending.push_back(thingType);
+            else
+                ++m_prewarmDone;
+        }
+
+        int uploads = PREWARM_UPLOADS_PER_FRAME;
+        for(auto it = m_prewarmPending.begin(); it != m_prewarmPending.end();) {
+            if(uploads > 0 && timer.elapsed_millis() < PREWARM_FRAME_BUDGET)
+                uploads -= (*it)->commitPhaseImages(uploads);
+
+            if(!(*it)->hasPendingPhaseImages()) {
+                it = m_prewarmPending.erase(it);
+                ++m_prewarmDone;
+            } else
+                ++it;
+        }
+    }
+
+    if(m_prewarmQueue.empty() && m_prewarmPending.empty()) {
+        m_prewarmEvent->cancel();
+        m_prewarmEvent = nullptr;
+        g_lua.callGlobalField("g_things", "onTexturesPrewarmed");
+    }
+}
@@ -25,10 +25,18 @@
 
 #include <framework/global.h>
 #include <framework/core/declarations.h>
+#include <framework/xml/xmlreader.h>
+
+#include <deque>
 
 #include "itemtype.h"
 #include "thingtype.h"
 
+enum {
+    THINGS_SNAPSHOT_SIGNATURE = 0x534E5454,
+    THINGS_SNAPSHOT_VERSION = 1
+};
+
 class ThingTypeManager
 {
 public:
@@ -39,7 +47,8 @@ public:
     bool loadOtml(std::string file);
     void loadOtb(const std::string& file);
     void loadXml(const std::string& file);
-    void parseItemType(uint16 id, TiXmlElement* elem);
+    ItemTypePtr parseItemType(uint16 id, const std::string& name);
+    void parseItemAttribute(const ItemTypePtr& itemType, const std::string& key, const XmlReader& reader);
 
     void saveDat(const std::string& fileName);
 
@@ -48,6 +57,8 @@ public:
     const ItemTypePtr& findItemTypeByName(const std::string& name);
     ItemTypeList findItemTypesByName(const std::string& name);
     ItemTypeList findItemTypesByString(const std::string& name);
+    // case insensitive, exact names first, then name prefixes, word prefixes and other substrings
+    ItemTypeList searchItemTypes(const std::string& query, int limit);
 
     const ThingTypePtr& getNullThingType() { return m_nullThingType; }
     const ItemTypePtr& getNullItemType() { return m_nullItemType; }
@@ -64,6 +75,8 @@ public:
     const ItemTypeList& getItemTypes() { return m_itemTypes; }
 
     uint32 getDatSignature() { return m_datSignature; }
+    // changes whenever the thing types are replaced, never 0 so it can mark caches as unset
+    uint16 getDatLoadCount() { return m_datLoadCount; }
     uint32 getOtbMajorVersion() { return m_otbMajorVersion; }
     uint32 getOtbMinorVersion() { return m_otbMinorVersion; }
     uint16 getContentRevision() { return m_contentRevision; }
@@ -75,7 +88,35 @@ public:
     bool isValidDatId(uint16 id, ThingCategory category) { return id >= 1 && id < m_thingTypes[category].size(); }
     bool isValidOtbId(uint16 id) { return id >= 1 && id < m_itemTypes.size(); }
 
+    // builds the textures of the given types ahead of drawing them, in order, spread over the next frames
+    void prewarmTextures(const ThingTypeList& thingTypes);
+    void cancelTexturePrewarm();
+    float getTexturePrewarmProgress() { return m_prewarmTotal > 0 ? static_cast<float>(m_prewarmDone) / m_prewarmTotal : 1.f; }
+    bool isPrewarmingTextures() { return m_prewarmEvent != nullptr; }
+
 private:
+    enum {
+        PREWARM_TYPES_IN_FLIGHT = 32,
+        PREWARM_UPLOADS_PER_FRAME = 8,
+        PREWARM_FRAME_BUDGET = 4 // milliseconds
+    };
+
+    void pollTexturePrewarm();
+
+    // the parsed dat is kept in the write dir, keyed by the dat signature and size and by what changes its parsing
+    std::string getDatSnapshotFile();
+    uint32 getDatSnapshotFeatures();
+    bool loadDatSnapshot(uint32 datSize);
+    void saveDatSnapshot(uint32 datSize);
+
+    struct ItemNameEntry {
+        std::string name; // lower cased
+        ItemTypePtr itemType;
+    };
+
+    void updateItemNameIndex();
+    std::vector<uint> findItemNameCandidates(const std::string& lowerName);
+
     ThingTypeList m_thingTypes[ThingLastCategory];
     ItemTypeList m_reverseItemTypes;
     ItemTypeList m_itemTypes;
@@ -83,6 +124,11 @@ private:
     ThingTypePtr m_nullThingType;
     ItemTypePtr m_nullItemType;
 
+    // item names sorted by name and server id, with the entries holding each three letter sequence
+    std::vector<ItemNameEntry> m_itemNames;
+    std::unordered_map<uint32, std::vector<uint>> m_itemNameTrigrams;
+    bool m_itemNamesDirty;
+
     bool m_datLoaded;
     bool m_xmlLoaded;
     bool m_otbLoaded;
@@ -91,6 +137,12 @@ private:
     uint32 m_otbMajorVersion;
     uint32 m_datSignature;
     uint16 m_contentRevision;
+    uint16 m_datLoadCount;
+
+    std::deque<ThingTypePtr> m_prewarmQueue;
+    std::vector<ThingTypePtr> m_prewarmPending;
+    uint m_prewarmTotal{ 0 }, m_prewarmDone{ 0 };
+    ScheduledEventPtr m_prewarmEvent;
 };
 
 extern ThingTypeManager g_things;
@@ -34,6 +34,89 @@
 
 const static Color STATIC_SHADOWING_COLOR(static_cast<uint8>(215), static_cast<uint8>(1), 0.65f);
 
+namespace {
+    class TileSlabAllocator
+    {
+    public:
+        enum {
+            TILES_PER_SLAB = 256
+        };
+
+        void* allocate()
+        {
+            if(!m_free) {
+                m_slabs.emplace_back(new Slot[TILES_PER_SLAB]);
+                Slot* slab = m_slabs.back().get();
+                for(int i = TILES_PER_SLAB - 1; i >= 0; --i) {
+                    slab[i].next = m_free;
+                    m_free = &slab[i];
+                }
+            }
+
+            Slot* slot = m_free;
+            m_free = slot->next;
+            ++m_liveTiles;
+            return slot;
+        }
+
+        void deallocate(void* ptr)
+        {
+            Slot* slot = static_cast<Slot*>(ptr);
+            slot->next = m_free;
+            m_free = slot;
+            --m_liveTiles;
+        }
+
+        uint getLiveTiles() { return m_liveTiles; }
+        uint getReservedBytes() { return m_slabs.size() * TILES_PER_SLAB * sizeof(Slot); }
+
+    private:
+        union Slot {
+            Slot* next;
+            alignas(Tile) uint8 storage[sizeof(Tile)];
+        };
+
+        std::vector<std::unique_ptr<Slot[]>> m_slabs;
+        Slot* m_free = nullptr;
+        uint m_liveTiles = 0;
+    };
+
+    // never destroyed, tiles may still be released while other globals are torn down
+    TileSlabAllocator& getTileAllocator()
+    {
+        static TileSlabAllocator* allocator = new TileSlabAllocator;
+        return *allocator;
+    }
+}
+
+void* Tile::operator new(size_t size)
+{
+    if(size != sizeof(Tile))
+        return ::operator new(size);
+    return getTileAllocator().allocate();
+}
+
+void Tile::operator delete(void* ptr, size_t size)
+{
+    if(!ptr)
+        return;
+    if(size != sizeof(Tile)) {
+        ::operator delete(ptr);
+        return;
+    }
+    getTileAllocator().deallocate(ptr);
+}
+
+uint Tile::getLiveTileCount()
+{
+    return getTileAllocator().getLiveTiles();
+}
+
+uint Tile::getReservedTileBytes()
+{
+    return getTileAllocator().getReservedBytes();
+}
+
 Tile::Tile(const Position& position) :
     m_position(position),
     m_drawElevation(0),
@@ -82,14 +165,17 @@ bool Tile::isCompletelyCovered(int8 firstFloor)
     return m_completelyCoveredCache[m_currentFirstVisibleFloor] == 1;
 }
 
-void Tile::drawThing(const ThingPtr& thing, const Point& dest, float scaleFactor, bool animate, int frameFlag, LightView* lightView)
+int Tile::getDrawFrameFlags(int frameFlags, LightView* lightView)
 {
-    if(isCompletelyCovered()) {
-        frameFlag = 0;
+    if(!isCompletelyCovered())
+        return frameFlags;
 
-        if(lightView && hasLight())
-            frameFlag = Otc::FUpdateLight;
-    }
+    return lightView && hasLight() ? Otc::FUpdateLight : 0;
+}
+
+void Tile::drawThing(const ThingPtr& thing, const Point& dest, float scaleFactor, bool animate, int frameFlag, LightView* lightView)
+{
+    frameFlag = getDrawFrameFlags(frameFlag, lightView);
 
     if(thing->isEffect()) {
         thing->static_self_cast<Effect>()->drawEffect(dest, scaleFactor, frameFlag, lightView);
@@ -102,6 +188,101 @@ void Tile::drawThing(const ThingPtr& thing, const Point& dest, float scaleFactor
     }
 }
 
+void Tile::drawLights(const Point& dest, float scaleFactor, LightView* lightView)
+{
+    // creatures and effects move, animate and come and go, only a stack of items can be replayed
+    if(hasDynamicThings()) {
+        drawLayerLights(dest, scaleFactor, lightView);
+        return;
+    }
+
+    if(m_lightsLoadCount != g_things.getDatLoadCount() || m_lightsScaleFactor != scaleFactor) {
+        m_lights.clear();
+        lightView->startRecording(&m_lights, dest);
+        drawLayerLights(dest, scaleFactor, lightView);
+        lightView->stopRecording();
+
+        // a thing whose texture is still being decoded adds no light yet, walk it again next time
+        if(static_cast<int>(m_lights.size()) < m_countFlag.hasLight) {
+            for(const RecordedLight& light : m_lights)
+                lightView->addLightSource(dest + light.offset, light.light, light.isStatic);
+            return;
+        }
+
+        m_lightsLoadCount = g_things.getDatLoadCount();
+        m_lightsScaleFactor = scaleFactor;
+    }
+
+    for(const RecordedLight& light : m_lights)
+        lightView->addLightSource(dest + light.offset, light.light, light.isStatic);
+}
+
+void Tile::drawLayerLights(const Point& dest, float scaleFactor, LightView* lightView)
+{
+    // the same walk the floor lists do, one tile at a time
+    if(hasGround())
+        drawGround(dest, scaleFactor, Otc::FUpdateLight, lightView);
+    if(hasGroundBorderToDraw())
+        drawGroundBorder(dest, scaleFactor, Otc::FUpdateLight, lightView);
+    if(hasBottomOrTopToDraw())
+        draw(dest, scaleFactor, Otc::FUpdateLight, lightView);
+}
+
+void Tile::drawCommands(DrawLayer layer, const Point& dest, float scaleFactor, bool elevate, int frameFlags, LightView* lightView)
+{
+    if(m_drawCommandsLoadCount != g_things.getDatLoadCount())
+        updateDrawCommands();
+
+    frameFlags = getDrawFrameFlags(frameFlags, lightView);
+    // decorations left out still cast their light
+    const int decorationFlags = frameFlags & Otc::FSkipDecoration ? frameFlags & ~Otc::FUpdateThing : frameFlags;
+    for(int i = m_drawLayerBegin[layer], end = m_drawLayerBegin[layer + 1]; i < end; ++i) {
+        const DrawCommand& command = m_drawCommands[i];
+        command.thing->draw(elevate ? dest - m_drawElevation * scaleFactor : dest, scaleFactor, true, m_highlight, TextureType::NONE, Color::white,
+                            command.decorative ? decorationFlags : frameFlags, lightView);
+        m_drawElevation = std::min<int>(m_drawElevation + command.elevation, Otc::MAX_ELEVATION);
+    }
+}
+
+void Tile::updateDrawCommands()
+{
+    m_drawCommands.clear();
+
+    const auto addCommand = [this](const ThingPtr& thing) {
+        DrawCommand command;
+        command.thing = thing.get();
+        command.elevation = std::min<int>(thing->getElevation(), Otc::MAX_ELEVATION);
+        command.corpseWidth = command.corpseHeight = 0;
+        command.decorative = thing->isCommon() && !thing->isNotWalkable() && !thing->hasElevation() && !thing->isLyingCorpse() &&
+            thing->getWidth() == 1 && thing->getHeight() == 1;
+        if(thing->isLyingCorpse()) {
+            command.corpseWidth = thing->getWidth();
+            command.corpseHeight = thing->getHeight();
+        }
+        m_drawCommands.push_back(command);
+    };
+
+    m_drawLayerBegin[DrawGroundBorder] = m_drawCommands.size();
+    for(const ThingPtr& thing : m_things)
+        if(thing->isGroundBorder()) addCommand(thing);
+
+    m_drawLayerBegin[DrawBottom] = m_drawCommands.size();
+    for(const ThingPtr& thing : m_things)
+        if(thing->isOnBottom()) addCommand(thing);
+
+    // common items are drawn from the bottom of the stack up
+    m_drawLayerBegin[DrawCommon] = m_drawCommands.size();
+    for(auto it = m_things.rbegin(); it != m_things.rend(); ++it)
+        if((*it)->isCommon()) addCommand(*it);
+
+    m_drawLayerBegin[DrawTop] = m_drawCommands.size();
+    for(const ThingPtr& thing : m_things)
+        if(thing->isOnTop()) addCommand(thing);
+
+    m_drawLayerBegin[DRAW_LAYERS] = m_drawCommands.size();
+    m_drawCommandsLoadCount = g_things.getDatLoadCount();
+}
+
 void Tile::drawGround(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView)
 {
     if(!m_ground) return;
@@ -117,10 +298,7 @@ void Tile::drawGroundBorder(const Point& dest, float scaleFactor, int frameFlags
     if(!hasGround())
         m_drawElevation = 0;
 
-    for(const auto& ground : m_things) {
-        if(!ground->isGroundBorder()) continue;
-        drawThing(ground, dest - m_drawElevation * scaleFactor, scaleFactor, true, frameFlags, lightView);
-    }
+    drawCommands(DrawGroundBorder, dest, scaleFactor, true, frameFlags, lightView);
 }
 
 void Tile::draw(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView)
@@ -147,20 +325,16 @@ void Tile::drawCreature(const Point& dest, float scaleFactor, int frameFlags, Li
         ), scaleFactor, true, frameFlags, lightView);
     }
 
-    if(hasCreature()) {
-        for(auto it = m_creatures.rbegin(); it != m_creatures.rend(); ++it) {
-            const auto& creature = *it;
-            if(creature->isWalking()) continue;
-            drawThing(creature, dest - m_drawElevation * scaleFactor, scaleFactor, true, frameFlags, lightView);
-        }
+    for(auto it = m_creatures.rbegin(); it != m_creatures.rend(); ++it) {
+        const auto& creature = *it;
+        if(creature->isWalking()) continue;
+        drawThing(creature, dest - m_drawElevation * scaleFactor, scaleFactor, true, frameFlags, lightView);
     }
 #else
-    if(hasCreature()) {
-        for(const auto& thing : m_things) {
-            if(!thing->isCreature() || thing->static_self_cast<Creature>()->isWalking()) continue;
+    for(const auto& creature : m_creatures) {
+        if(creature->isWalking()) continue;
 
-            drawThing(thing, dest - m_drawElevation * scaleFactor, scaleFactor, true, frameFlags, lightView);
-        }
+        drawThing(creature, dest - m_drawElevation * scaleFactor, scaleFactor, true, frameFlags, lightView);
     }
 
     for(const auto& creature : m_walkingCreatures) {
@@ -174,27 +348,18 @@ void Tile::drawCreature(const Point& dest, float scaleFactor, int frameFlags, Li
 
 void Tile::drawBottom(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView)
 {
-    if(m_countFlag.hasBottomItem) {
-        for(const auto& item : m_things) {
-            if(!item->isOnBottom()) continue;
-            drawThing(item, dest - m_drawElevation * scaleFactor, scaleFactor, true, frameFlags, lightView);
-        }
-    }
+    if(m_countFlag.hasBottomItem)
+        drawCommands(DrawBottom, dest, scaleFactor, true, frameFlags, lightView);
 
     uint8 redrawPreviousTopW = 0,
         redrawPreviousTopH = 0;
 
     if(m_countFlag.hasCommonItem) {
-        for(auto it = m_things.rbegin(); it != m_things.rend(); ++it) {
-            const auto& item = *it;
-            if(!item->isCommon()) continue;
-
-            drawThing(item, dest - m_drawElevation * scaleFactor, scaleFactor, true, frameFlags, lightView);
+        drawCommands(DrawCommon, dest, scaleFactor, true, frameFlags, lightView);
 
-            if(item->isLyingCorpse()) {
-                redrawPreviousTopW = std::max<int>(item->getWidth(), redrawPreviousTopW);
-                redrawPreviousTopH = std::max<int>(item->getHeight(), redrawPreviousTopH);
-            }
+        for(int i = m_drawLayerBegin[DrawCommon]; i < m_drawLayerBegin[DrawCommon + 1]; ++i) {
+            redrawPreviousTopW = std::max<uint8>(m_drawCommands[i].corpseWidth, redrawPreviousTopW);
+            redrawPreviousTopH = std::max<uint8>(m_drawCommands[i].corpseHeight, redrawPreviousTopH);
         }
     }
 
@@ -222,22 +387,20 @@ void Tile::drawBottom(const Point& dest, float scaleFactor, int frameFlags, Ligh
 
 void Tile::drawTop(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView)
 {
+    const int effectFlags = frameFlags & Otc::FSkipEffect ? frameFlags & ~Otc::FUpdateThing : frameFlags;
     for(const auto& effect : m_effects) {
-        drawThing(effect, dest - m_drawElevation * scaleFactor, scaleFactor, true, frameFlags, lightView);
+        drawThing(effect, dest - m_drawElevation * scaleFactor, scaleFactor, true, effectFlags, lightView);
     }
 
-    if(m_countFlag.hasTopItem) {
-        for(const auto& item : m_things) {
-            if(!item->isOnTop()) continue;
-            drawThing(item, dest, scaleFactor, true, frameFlags, lightView);
-        }
-    }
+    if(m_countFlag.hasTopItem)
+        drawCommands(DrawTop, dest, scaleFactor, false, frameFlags, lightView);
 }
 
 void Tile::clean()
 {
+    // the thing is copied, a reference into m_things would not survive its own removal
     while(!m_things.empty())
-        removeThing(m_things.front());
+        removeThing(ThingPtr(m_things.front()));
 }
 
 void Tile::addWalkingCreature(const CreaturePtr& creature)
@@ -325,6 +488,12 @@ void Tile::addThing(const ThingPtr& thing, int stackPos)
         stackPos = size;
 
     m_things.insert(m_things.begin() + stackPos, thing);
+    updateStackRanges();
+
+    if(thing->isCreature())
+        g_map.indexCreature(m_position);
+    else if(thing->isItem() && g_map.isItemIndexEnabled())
+        g_map.indexItem(thing->getId(), m_position);
 
     if(thing->isGround()) m_ground = thing->static_self_cast<Item>();
 
@@ -336,7 +505,7 @@ void Tile::addThing(const ThingPtr& thing, int stackPos)
     }
 
     if(m_things.size() > MAX_THINGS)
-        removeThing(m_things[MAX_THINGS]);
+        removeThing(ThingPtr(m_things[MAX_THINGS]));
 
     thing->setPosition(m_position);
     thing->onAppear();
@@ -346,7 +515,7 @@ void Tile::addThing(const ThingPtr& thing, int stackPos)
 }
 
 // TODO: Need refactoring
-bool Tile::removeThing(const ThingPtr thing)
+bool Tile::removeThing(const ThingPtr& thing)
 {
     if(!thing) return false;
 
@@ -373,6 +542,12 @@ bool Tile::removeThing(const ThingPtr thing)
     clearCompletelyCoveredCacheListIfPossible(thing);
 
     m_things.erase(it);
+    updateStackRanges();
+
+    if(thing->isCreature())
+        g_map.unindexCreature(m_position);
+    else if(thing->isItem() && g_map.isItemIndexEnabled())
+        g_map.unindexItem(thing->getId(), m_position);
 
     checkForDetachableThing();
 
@@ -392,17 +567,34 @@ ThingPtr Tile::getThing(int stackPos)
     return nullptr;
 }
 
-std::vector<CreaturePtr> Tile::getCreatures()
+void Tile::updateStackRanges()
 {
-    std::vector<CreaturePtr> creatures;
-    if(hasCreature()) {
-        for(const ThingPtr& thing : m_things) {
-            if(thing->isCreature())
-                creatures.push_back(thing->static_self_cast<Creature>());
-        }
+    m_creatures.clear();
+    m_items.clear();
+    m_stackOrdered = true;
+    invalidateDrawCommands();
+
+    int priority = 0;
+    for(uint i = 0; i < m_things.size(); ++i) {
+        const ThingPtr& thing = m_things[i];
+        if(thing->isCreature())
+            m_creatures.push_back(thing->static_self_cast<Creature>());
+        else if(thing->isItem())
+            m_items.push_back(thing->static_self_cast<Item>());
+
+        const int thingPriority = thing->getStackPriority();
+        if(thingPriority < priority)
+            m_stackOrdered = false;
+        while(priority < thingPriority && priority < STACK_PRIORITIES)
+            m_stackBegin[++priority] = i;
     }
 
-    return creatures;
+    if(!m_stackOrdered)
+        return;
+
+    m_stackBegin[0] = 0;
+    while(priority < STACK_PRIORITIES)
+        m_stackBegin[++priority] = m_things.size();
 }
 
 int Tile::getThingStackPos(const ThingPtr& thing)
@@ -424,25 +616,14 @@ ThingPtr Tile::getTopThing()
     if(isEmpty())
         return nullptr;
 
-    for(const ThingPtr& thing : m_things)
-        if(thing->isCommon())
-            return thing;
+    for(int i = getStackBegin(5), s = m_things.size(); i < s; ++i) {
+        if(m_things[i]->isCommon())
+            return m_things[i];
+    }
 
     return m_things[m_things.size() - 1];
 }
 
-std::vector<ItemPtr> Tile::getItems()
-{
-    std::vector<ItemPtr> items;
-    for(const ThingPtr& thing : m_things) {
-        if(!thing->isItem())
-            continue;
-
-        items.push_back(thing->static_self_cast<Item>());
-    }
-    return items;
-}
-
 EffectPtr Tile::getEffect(uint16 id)
 {
     for(const EffectPtr& effect : m_effects)
@@ -482,7 +663,9 @@ ThingPtr Tile::getTopLookThing()
     if(isEmpty())
         return nullptr;
 
-    for(auto thing : m_things) {
+    // ground, borders, bottom and top things are never looked at first
+    for(int i = getStackBegin(4), s = m_things.size(); i < s; ++i) {
+        const ThingPtr& thing = m_things[i];
         if(!thing->isIgnoreLook() && (!thing->isGround() && !thing->isGroundBorder() && !thing->isOnBottom() && !thing->isOnTop()))
             return thing;
     }
@@ -495,14 +678,15 @@ ThingPtr Tile::getTopUseThing()
     if(isEmpty())
         return nullptr;
 
-    for(auto thing : m_things) {
+    for(const ThingPtr& thing : m_things) {
         if(thing->isForceUse() || (!thing->isGround() && !thing->isGroundBorder() && !thing->isOnBottom() && !thing->isOnTop() && !thing->isCreature() && !thing->isSplash()))
             return thing;
     }
 
-    for(auto thing : m_things) {
-        if(!thing->isGround() && !thing->isGroundBorder() && !thing->isCreature() && !thing->isSplash())
-            return thing;
+    // creatures are never used here, the item list keeps the remaining things in stack order
+    for(const ItemPtr& item : m_items) {
+        if(!item->isGround() && !item->isGroundBorder() && !item->isSplash())
+            return item;
     }
 
     return m_things[0];
@@ -513,11 +697,11 @@ CreaturePtr Tile::getTopCreature(const bool checkAround)
     if(!hasCreature()) return nullptr;
 
     CreaturePtr creature;
-    for(auto thing : m_things) {
-        if(thing->isLocalPlayer()) // return local player if there is no other creature
-            creature = thing->static_self_cast<Creature>();
-        else if(thing->isCreature())
-            return thing->static_self_cast<Creature>();
+    for(const CreaturePtr& c : m_creatures) {
+        if(c->isLocalPlayer()) // return local player if there is no other creature
+            creature = c;
+        else
+            return c;
     }
 
     if(creature)
@@ -548,7 +732,7 @@ ThingPtr Tile::getTopMoveThing()
     if(isEmpty())
         return nullptr;
 
-    for(uint i = 0; i < m_things.size(); ++i) {
+    for(uint i = getStackBegin(5); i < m_things.size(); ++i) {
         const ThingPtr& thing = m_things[i];
         if(thing->isCommon()) {
             if(i > 0 && thing->isNotMoveable())
@@ -558,10 +742,8 @@ ThingPtr Tile::getTopMoveThing()
         }
     }
 
-    for(const ThingPtr& thing : m_things) {
-        if(thing->isCreature())
-            return thing;
-    }
+    if(!m_creatures.empty())
+        return m_creatures.front();
 
     return m_things[0];
 }
@@ -603,11 +785,8 @@ bool Tile::isWalkable(bool ignoreCreatures)
         return false;
     }
 
-    if(!ignoreCreatures && hasCreature()) {
-        for(const auto& thing : m_things) {
-            if(!thing->isCreature()) continue;
-
-            const auto& creature = thing->static_self_cast<Creature>();
+    if(!ignoreCreatures) {
+        for(const CreaturePtr& creature : m_creatures) {
             if(!creature->isPassable() && creature->canBeSeen())
                 return false;
         }
@@ -616,6 +795,19 @@ bool Tile::isWalkable(bool ignoreCreatures)
     return true;
 }
 
+bool Tile::isPredictedWalkable()
+{
+    if(m_countFlag.notWalkable > 0 || !getGround())
+        return false;
+
+    for(const CreaturePtr& creature : m_creatures) {
+        if(!creature->isPassable() && creature->canBeSeen() && !creature->isLocalPlayer())
+            return false;
+    }
+
+    return true;
+}
+
 bool Tile::isPathable()
 {
     return m_countFlag.notPathable == 0;
@@ -631,6 +823,20 @@ bool Tile::isFullyOpaque()
     return m_countFlag.opaque > 0;
 }
 
+bool Tile::isCellOccluder()
+{
+    if(!isFullyOpaque())
+        return false;
+
+    // grounds and tops are drawn at the tile origin without elevation, so an opaque one hides the whole
+    // screen cell of the tile, larger things are only known to be opaque in their bottom right sprite
+    for(const ThingPtr& thing : m_things) {
+        if((thing->isGround() || thing->isOnTop()) && thing->isOpaque() && !thing->hasDisplacement())
+            return true;
+    }
+    return false;
+}
+
 bool Tile::isSingleDimension()
 {
     return m_countFlag.notSingleDimension == 0 && m_walkingCreatures.empty();
@@ -667,6 +873,15 @@ bool Tile::isEmpty()
     return m_things.empty();
 }
 
+void Tile::setFlags(uint32 flags)
+{
+    if(flags == m_flags)
+        return;
+
+    m_flags = flags;
+    g_map.notifyZoneChange(m_position);
+}
+
 bool Tile::canErase()
 {
     return m_walkingCreatures.empty() && m_effects.empty() && isEmpty() && m_flags == 0 && m_minimapColor == 0;
@@ -729,11 +944,13 @@ void Tile::checkTranslucentLight()
     for(const ThingPtr& thing : m_things) {
         if(thing->isTranslucent() || thing->hasLensHelp()) {
             tile->m_flags |= TILESTATE_TRANSLUECENT_LIGHT;
+            tile->m_lightsLoadCount = 0;
             return;
         }
     }
 
     tile->m_flags &= ~TILESTATE_TRANSLUECENT_LIGHT;
+    tile->m_lightsLoadCount = 0;
 }
 
 bool Tile::checkForDetachableThing()
@@ -793,8 +1010,10 @@ void Tile::analyzeThing(const ThingPtr& thing, bool add)
 {
     const int value = add ? 1 : -1;
 
-    if(thing->hasLight())
+    if(thing->hasLight()) {
         m_countFlag.hasLight += value;
+        m_lightsLoadCount = 0;
+    }
 
     if(thing->hasDisplacement())
         m_countFlag.hasDisplacement += value;
@@ -822,6 +1041,13 @@ void Tile::analyzeThing(const ThingPtr& thing, bool add)
 
         if(thing->isHookEast())
             m_countFlag.hasHookEast += value;
+
+        if(thing->isHookSouth() || thing->isHookEast()) {
+            for(const ItemPtr& item : m_items) {
+                if(item->isHangable())
+                    item->invalidatePatterns();
+            }
+        }
     }
 
     // best option to have something more real, but in some cases as a custom project,
@@ -29,6 +29,7 @@
 #include "effect.h"
 #include "item.h"
 #include "mapview.h"
+#include <framework/core/stats.h>
 
 enum tileflags_t : uint32
 {
@@ -53,15 +54,23 @@ enum tileflags_t : uint32
     TILESTATE_LAST = 1 << 24
 };
 
-class Tile : public LuaObject
+class Tile : public LuaObject, private StatsCounted<Tile>
 {
 public:
     enum {
-        MAX_THINGS = 10
+        MAX_THINGS = 10,
+        // ground, ground borders, bottom, top, creatures and common items, as in Thing::getStackPriority
+        STACK_PRIORITIES = 6
     };
 
     Tile(const Position& position);
 
+    // tiles are carved from slabs that are kept for reuse, so walking the world does not fragment the heap
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
+    static uint getLiveTileCount();
+    static uint getReservedTileBytes();
+
     void onAddVisibleTileList(const MapViewPtr& mapView);
     void draw(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView = nullptr);
     void drawGround(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView = nullptr);
@@ -69,6 +78,8 @@ public:
     void drawBottom(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView = nullptr);
     void drawTop(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView = nullptr);
     void drawThing(const ThingPtr& thing, const Point& dest, float scaleFactor, bool animate, int frameFlag, LightView* lightView);
+    // adds the lights of every layer, replayed from the last walk while the stack is unchanged
+    void drawLights(const Point& dest, float scaleFactor, LightView* lightView);
 
     void clean();
 
@@ -76,7 +87,7 @@ public:
     void removeWalkingCreature(const CreaturePtr& creature);
 
     void addThing(const ThingPtr& thing, int stackPos);
-    bool removeThing(const ThingPtr thing);
+    bool removeThing(const ThingPtr& thing);
     ThingPtr getThing(int stackPos);
     EffectPtr getEffect(uint16 id);
     bool hasThing(const ThingPtr& thing);
@@ -93,17 +104,20 @@ public:
     const Position& getPosition() { return m_position; }
     const std::vector<CreaturePtr>& getWalkingCreatures() { return m_walkingCreatures; }
     const std::vector<ThingPtr>& getThings() { return m_things; }
-    std::vector<CreaturePtr> getCreatures();
+    const std::vector<CreaturePtr>& getCreatures() { return m_creatures; }
 
-    std::vector<ItemPtr> getItems();
+    const std::vector<ItemPtr>& getItems() { return m_items; }
     ItemPtr getGround() { return m_ground; }
     int getGroundSpeed();
     uint8 getMinimapColorByte();
     int getThingCount() { return m_things.size() + m_effects.size(); }
     bool isPathable();
     bool isWalkable(bool ignoreCreatures = false);
+    // walkable once the predicted steps are confirmed, the local player will not be blocking it anymore
+    bool isPredictedWalkable();
     bool isFullGround();
     bool isFullyOpaque();
+    bool isCellOccluder();
     bool isSingleDimension();
     bool isLookPossible();
     bool isClickable();
@@ -117,6 +131,8 @@ public:
     bool hasWideItems() { return m_countFlag.hasWideItems; }
     bool hasWall() { return m_countFlag.hasWall; }
     bool hasTranslucentLight() { return m_flags & TILESTATE_TRANSLUECENT_LIGHT; }
+    // creatures, effects and highlights change the drawing without updating the tile
+    bool hasDynamicThings() { return m_countFlag.hasCreature || !m_walkingCreatures.empty() || !m_effects.empty() || m_highlight.enabled; }
     bool mustHookSouth();
     bool mustHookEast();
     bool limitsFloorsView(bool isFreeView = false);
@@ -135,9 +151,9 @@ public:
 
     bool isCompletelyCovered(int8 firstFloor = -1);
 
-    void remFlag(uint32 flag) { m_flags &= ~flag; }
-    void setFlag(uint32 flag) { m_flags |= flag; }
-    void setFlags(uint32 flags) { m_flags = flags; }
+    void remFlag(uint32 flag) { setFlags(m_flags & ~flag); }
+    void setFlag(uint32 flag) { setFlags(m_flags | flag); }
+    void setFlags(uint32 flags);
     bool hasFlag(uint32 flag) { return (m_flags & flag) == flag; }
     uint32 getFlags() { return m_flags; }
 
@@ -157,8 +173,26 @@ public:
     bool isCovered() { return m_coveredCache[m_currentFirstVisibleFloor] == 1; };
 
     void analyzeThing(const ThingPtr& thing, bool add);
+    // items changed in place, their resolved draw commands must be rebuilt
+    void invalidateDrawCommands() { m_drawCommandsLoadCount = 0; m_lightsLoadCount = 0; }
 
 private:
+    enum DrawLayer : uint8 {
+        DrawGroundBorder,
+        DrawBottom,
+        DrawCommon,
+        DrawTop,
+        DRAW_LAYERS
+    };
+
+    // an item of the stack with the type properties the frame needs already resolved
+    struct DrawCommand {
+        Thing* thing; // kept alive by m_things, the list is rebuilt before use after any stack change
+        uint8 elevation;
+        uint8 corpseWidth, corpseHeight; // lying corpses make the tops around them be drawn again
+        bool decorative; // left out by far zoomed out views, nothing is stacked on it
+    };
+
     struct CountFlag {
         int fullGround = 0;
         int notWalkable = 0;
@@ -191,6 +225,12 @@ private:
     void drawCreature(const Point& dest, float scaleFactor, int frameFlags, LightView* lightView = nullptr);
     bool checkForDetachableThing();
     void checkTranslucentLight();
+    void updateStackRanges();
+    void updateDrawCommands();
+    void drawLayerLights(const Point& dest, float scaleFactor, LightView* lightView);
+    void drawCommands(DrawLayer layer, const Point& dest, float scaleFactor, bool elevate, int frameFlags, LightView* lightView);
+    int getDrawFrameFlags(int frameFlags, LightView* lightView);
+    int getStackBegin(int priority) { return m_stackOrdered ? m_stackBegin[priority] : 0; }
 
     void clearCompletelyCoveredCacheListIfPossible(const ThingPtr& thing);
     void setCompletelyCoveredCache(const uint8_t state)
@@ -211,6 +251,8 @@ private:
 
     std::vector<CreaturePtr> m_walkingCreatures;
     std::vector<ThingPtr> m_things;
+    std::vector<CreaturePtr> m_creatures;
+    std::vector<ItemPtr> m_items;
     std::vector<EffectPtr> m_effects;
     ItemPtr m_ground;
 
@@ -219,6 +261,21 @@ private:
 
     bool m_highlightWithoutFilter{ false };
 
+    // first stack position of each priority, only valid while m_things is sorted by priority,
+    // which the server may break by placing things at explicit stack positions
+    std::array<uint8, STACK_PRIORITIES + 1> m_stackBegin{};
+    bool m_stackOrdered{ true };
+
+    // items in draw order grouped by layer, valid while m_drawCommandsLoadCount matches the loaded thing types
+    std::vector<DrawCommand> m_drawCommands;
+    std::array<uint8, DRAW_LAYERS + 1> m_drawLayerBegin{};
+    uint16 m_drawCommandsLoadCount{ 0 };
+
+    // lights of the stack relative to the tile, valid while m_lightsLoadCount matches and the scale is the same
+    std::vector<RecordedLight> m_lights;
+    float m_lightsScaleFactor{ 0 };
+    uint16 m_lightsLoadCount{ 0 };
+
     std::array<uint8_t, Otc::MAX_Z + 1> m_coveredCache, m_completelyCoveredCache;
 };
 
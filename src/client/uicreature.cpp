@@ -21,9 +21,18 @@
  */
 
 #include "uicreature.h"
+#include "outfitpreview.h"
+#include <framework/core/clock.h>
+#include <framework/graphics/drawpool.h>
 #include <framework/graphics/graphics.h>
+#include <framework/graphics/textureatlas.h>
 #include <framework/otml/otml.h>
 
+UICreature::~UICreature()
+{
+    g_uiRenderCache.release(m_rendition);
+}
+
 void UICreature::drawSelf(Fw::DrawPane drawPane)
 {
     if((drawPane & Fw::ForegroundPane) == 0)
@@ -31,18 +40,82 @@ void UICreature::drawSelf(Fw::DrawPane drawPane)
 
     UIWidget::drawSelf(drawPane);
 
+    if(m_creature && m_outfitPreview) {
+        drawPreview(getPaddingRect());
+        return;
+    }
+
     if(m_creature) {
         const Rect drawRect = getPaddingRect();
-        m_creature->drawOutfit(drawRect, !m_fixedCreatureSize, m_imageColor);
+        const bool animated = m_creature->hasAnimationPhases();
+        bool cached = false;
+        if(m_renderCached && (!animated || m_renderCacheInterval > 0)) {
+            const Outfit outfit = m_creature->getOutfit();
+            size_t key = 0;
+            for(const int value : { outfit.getId(), outfit.getAuxId(), outfit.getHead(), outfit.getBody(), outfit.getLegs(), outfit.getFeet(), outfit.getAddons(), outfit.getMount() })
+                boost::hash_combine(key, value);
+            boost::hash_combine(key, static_cast<int>(outfit.getCategory()));
+            boost::hash_combine(key, static_cast<int>(m_creature->getDirection()));
+            boost::hash_combine(key, static_cast<bool>(m_fixedCreatureSize));
+            boost::hash_combine(key, m_imageColor.rgba());
+            if(animated)
+                boost::hash_combine(key, g_clock.millis() / m_renderCacheInterval);
+
+            const UICreaturePtr self = static_self_cast<UICreature>();
+            cached = g_uiRenderCache.draw(m_rendition, drawRect, key, [self](const Rect& rect) {
+                if(self->m_creature)
+                    self->m_creature->drawOutfit(rect, !self->m_fixedCreatureSize, self->m_imageColor);
+            });
+        } else
+            g_uiRenderCache.release(m_rendition);
+
+        if(!cached)
+            m_creature->drawOutfit(drawRect, !m_fixedCreatureSize, m_imageColor);
+
+        // animated outfits keep their area dirty, cached ones only when their next rendition is due
+        if(animated) {
+            if(cached)
+                g_uiRenderCache.repaintLater(static_self_cast<UIWidget>(), m_rendition, m_renderCacheInterval);
+            else
+                repaint();
+        }
     }
 }
 
+void UICreature::drawPreview(const Rect& drawRect)
+{
+    const AtlasRegionPtr region = g_outfitPreviews.getPreview(m_creature->getOutfit(), m_creature->getDirection());
+    if(region)
+        m_previewRegion = region;
+    else
+        repaint();
+
+    if(!m_previewRegion || !m_previewRegion->isValid())
+        return;
+
+    // fit the thumbnail keeping its aspect, standing on the bottom of the widget
+    const Size size = m_previewRegion->getRect().size();
+    const float scale = std::min<float>(drawRect.width() / static_cast<float>(size.width()), drawRect.height() / static_cast<float>(size.height()));
+    const Size scaledSize = size * scale;
+    const Rect dest(drawRect.left() + (drawRect.width() - scaledSize.width()) / 2, drawRect.bottom() - scaledSize.height() + 1, scaledSize);
+    g_drawPool.addTexturedRect(dest, m_previewRegion->getTexture(), m_previewRegion->getRect(), m_imageColor);
+}
+
+void UICreature::setRenderCached(bool cached)
+{
+    m_renderCached = cached;
+    if(!cached)
+        g_uiRenderCache.release(m_rendition);
+    repaint();
+}
+
 void UICreature::setOutfit(const Outfit& outfit)
 {
     if(!m_creature)
         m_creature = CreaturePtr(new Creature);
     m_creature->setDirection(Otc::South);
     m_creature->setOutfit(outfit);
+    repaint();
 }
 
 void UICreature::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode)
@@ -52,6 +125,12 @@ void UICreature::onStyleApply(const std::string& styleName, const OTMLNodePtr& s
     for(const OTMLNodePtr& node : styleNode->children()) {
         if(node->tag() == "fixed-creature-size")
             setFixedCreatureSize(node->value<bool>());
+        else if(node->tag() == "render-cache")
+            setRenderCached(node->value<bool>());
+        else if(node->tag() == "render-cache-interval")
+            setRenderCacheInterval(node->value<int>());
+        else if(node->tag() == "outfit-preview")
+            setOutfitPreview(node->value<bool>());
         else if(node->tag() == "outfit-id") {
             Outfit outfit = m_creature ? m_creature->getOutfit() : Outfit();
             outfit.setId(node->value<int>());
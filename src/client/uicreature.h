@@ -24,26 +24,42 @@
 #define UICREATURE_H
 
 #include <framework/ui/uiwidget.h>
+#include <framework/ui/uirendercache.h>
 #include "creature.h"
 #include "declarations.h"
 
 class UICreature : public UIWidget
 {
 public:
+    ~UICreature() override;
     void drawSelf(Fw::DrawPane drawPane) override;
 
-    void setCreature(const CreaturePtr& creature) { m_creature = creature; }
-    void setFixedCreatureSize(bool fixed) { m_fixedCreatureSize = fixed; }
+    void setCreature(const CreaturePtr& creature) { m_creature = creature; repaint(); }
+    void setFixedCreatureSize(bool fixed) { m_fixedCreatureSize = fixed; repaint(); }
     void setOutfit(const Outfit& outfit);
+    void setRenderCached(bool cached);
+    void setRenderCacheInterval(int interval) { m_renderCacheInterval = interval; repaint(); }
+    void setOutfitPreview(bool preview) { m_outfitPreview = preview; m_previewRegion = nullptr; repaint(); }
 
     CreaturePtr getCreature() { return m_creature; }
     bool isFixedCreatureSize() { return m_fixedCreatureSize; }
+    bool isRenderCached() { return m_renderCached; }
+    int getRenderCacheInterval() { return m_renderCacheInterval; }
+    bool isOutfitPreview() { return m_outfitPreview; }
 
 protected:
     void onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode) override;
+    void drawPreview(const Rect& drawRect);
 
     CreaturePtr m_creature;
+    UIRenderCache::Rendition m_rendition;
     stdext::boolean<false> m_fixedCreatureSize;
+    stdext::boolean<false> m_renderCached;
+    // animated outfits are drawn directly unless they may refresh their rendition every that many milliseconds
+    int m_renderCacheInterval{ 0 };
+    // previews show a still thumbnail composed on the async dispatcher, the last one stays until the next is ready
+    stdext::boolean<false> m_outfitPreview;
+    AtlasRegionPtr m_previewRegion;
 };
 
 #endif
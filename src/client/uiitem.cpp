@@ -21,6 +21,7 @@
  */
 
 #include "uiitem.h"
+#include <framework/core/clock.h>
 #include <framework/graphics/fontmanager.h>
 #include <framework/graphics/graphics.h>
 #include <framework/otml/otml.h>
@@ -30,6 +31,11 @@ UIItem::UIItem()
     m_draggable = true;
 }
 
+UIItem::~UIItem()
+{
+    g_uiRenderCache.release(m_rendition);
+}
+
 void UIItem::drawSelf(Fw::DrawPane drawPane)
 {
     if((drawPane & Fw::ForegroundPane) == 0)
@@ -45,25 +51,42 @@ void UIItem::drawSelf(Fw::DrawPane drawPane)
     drawImage(m_rect);
 
     if(m_itemVisible && m_item) {
-        const Rect drawRect = getPaddingRect();
-        Point dest = drawRect.bottomRight() + Point(1);
+        const bool animated = m_item->hasAnimationPhases();
+        bool cached = false;
+        if(m_renderCached && (!animated || m_renderCacheInterval > 0)) {
+            const Rect drawRect = getPaddingRect();
+            const Point offset = drawRect.topLeft() - m_rect.topLeft();
 
-        const int exactSize = std::max<int>(32, m_item->getExactSize());
-        if(exactSize == 0)
-            return;
+            size_t key = 0;
+            boost::hash_combine(key, m_item->getId());
+            boost::hash_combine(key, m_item->getCountOrSubType());
+            boost::hash_combine(key, m_color.rgba());
+            boost::hash_combine(key, m_font.get());
+            boost::hash_combine(key, static_cast<bool>(m_showId));
+            boost::hash_combine(key, offset.hash());
+            boost::hash_combine(key, drawRect.width());
+            boost::hash_combine(key, drawRect.height());
+            if(animated)
+                boost::hash_combine(key, g_clock.millis() / m_renderCacheInterval);
 
-        const float scaleFactor = std::min<float>(drawRect.width() / static_cast<float>(exactSize), drawRect.height() / static_cast<float>(exactSize));
-        dest += (m_item->getDisplacement() - Point(Otc::TILE_PIXELS)) * scaleFactor;
+            const UIItemPtr self = static_self_cast<UIItem>();
+            cached = g_uiRenderCache.draw(m_rendition, m_rect, key, [self, offset](const Rect& rect) {
+                if(self->m_item)
+                    self->drawItem(rect, Rect(rect.topLeft() + offset, self->getPaddingRect().size()));
+            });
+        } else
+            g_uiRenderCache.release(m_rendition);
 
-        m_item->draw(dest, scaleFactor, true, Highlight(), TextureType::SMOOTH, m_color);
+        if(!cached)
+            drawItem(m_rect, getPaddingRect());
 
-        if(m_font && (m_item->isStackable() || m_item->isChargeable()) && m_item->getCountOrSubType() > 1) {
-            const std::string count = stdext::to_string(m_item->getCountOrSubType());
-            m_font->drawText(count, Rect(m_rect.topLeft(), m_rect.bottomRight() - Point(3, 0)), Color(231, 231, 231), Fw::AlignBottomRight);
+        // animated items keep their area dirty, cached ones only when their next rendition is due
+        if(animated) {
+            if(cached)
+                g_uiRenderCache.repaintLater(static_self_cast<UIWidget>(), m_rendition, m_renderCacheInterval);
+            else
+                repaint();
         }
-
-        if(m_showId)
-            m_font->drawText(stdext::to_string(m_item->getServerId()), m_rect, Fw::AlignBottomRight);
     }
 
     drawBorder(m_rect);
@@ -71,6 +94,36 @@ void UIItem::drawSelf(Fw::DrawPane drawPane)
     drawText(m_rect);
 }
 
+void UIItem::drawItem(const Rect& rect, const Rect& drawRect)
+{
+    Point dest = drawRect.bottomRight() + Point(1);
+
+    const int exactSize = std::max<int>(32, m_item->getExactSize());
+    if(exactSize == 0)
+        return;
+
+    const float scaleFactor = std::min<float>(drawRect.width() / static_cast<float>(exactSize), drawRect.height() / static_cast<float>(exactSize));
+    dest += (m_item->getDisplacement() - Point(Otc::TILE_PIXELS)) * scaleFactor;
+
+    m_item->draw(dest, scaleFactor, true, Highlight(), TextureType::SMOOTH, m_color);
+
+    if(m_font && (m_item->isStackable() || m_item->isChargeable()) && m_item->getCountOrSubType() > 1) {
+        const std::string count = stdext::to_string(m_item->getCountOrSubType());
+        m_font->drawText(count, Rect(rect.topLeft(), rect.bottomRight() - Point(3, 0)), Color(231, 231, 231), Fw::AlignBottomRight);
+    }
+
+    if(m_showId)
+        m_font->drawText(stdext::to_string(m_item->getServerId()), rect, Fw::AlignBottomRight);
+}
+
+void UIItem::setRenderCached(bool cached)
+{
+    m_renderCached = cached;
+    if(!cached)
+        g_uiRenderCache.release(m_rendition);
+    repaint();
+}
+
 void UIItem::setItemId(int id)
 {
     if(!m_item && id != 0)
@@ -82,6 +135,8 @@ void UIItem::setItemId(int id)
         else
             m_item->setId(id);
     }
+
+    repaint();
 }
 
 void UIItem::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode)
@@ -99,5 +154,9 @@ void UIItem::onStyleApply(const std::string& styleName, const OTMLNodePtr& style
             setVirtual(node->value<bool>());
         else if(node->tag() == "show-id")
             m_showId = node->value<bool>();
+        else if(node->tag() == "render-cache")
+            setRenderCached(node->value<bool>());
+        else if(node->tag() == "render-cache-interval")
+            setRenderCacheInterval(node->value<int>());
     }
 }
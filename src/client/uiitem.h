@@ -24,6 +24,7 @@
 #define UIITEM_H
 
 #include <framework/ui/uiwidget.h>
+#include <framework/ui/uirendercache.h>
 #include "declarations.h"
 #include "item.h"
 
@@ -31,14 +32,17 @@ class UIItem : public UIWidget
 {
 public:
     UIItem();
+    ~UIItem() override;
     void drawSelf(Fw::DrawPane drawPane) override;
 
     void setItemId(int id);
-    void setItemCount(int count) { if(m_item) m_item->setCount(count); }
-    void setItemSubType(int subType) { if(m_item) m_item->setSubType(subType); }
-    void setItemVisible(bool visible) { m_itemVisible = visible; }
-    void setItem(const ItemPtr& item) { m_item = item; }
+    void setItemCount(int count) { if(m_item) m_item->setCount(count); repaint(); }
+    void setItemSubType(int subType) { if(m_item) m_item->setSubType(subType); repaint(); }
+    void setItemVisible(bool visible) { m_itemVisible = visible; repaint(); }
+    void setItem(const ItemPtr& item) { m_item = item; repaint(); }
     void setVirtual(bool virt) { m_virtual = virt; }
+    void setRenderCached(bool cached);
+    void setRenderCacheInterval(int interval) { m_renderCacheInterval = interval; repaint(); }
     void clearItem() { setItemId(0); }
 
     int getItemId() { return m_item ? m_item->getId() : 0; }
@@ -47,14 +51,22 @@ public:
     ItemPtr getItem() { return m_item; }
     bool isVirtual() { return m_virtual; }
     bool isItemVisible() { return m_itemVisible; }
+    bool isRenderCached() { return m_renderCached; }
+    int getRenderCacheInterval() { return m_renderCacheInterval; }
 
 protected:
     void onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode) override;
 
+    void drawItem(const Rect& rect, const Rect& drawRect);
+
     ItemPtr m_item;
+    UIRenderCache::Rendition m_rendition;
     stdext::boolean<false> m_virtual;
     stdext::boolean<true> m_itemVisible;
     stdext::boolean<false> m_showId;
+    stdext::boolean<false> m_renderCached;
+    // animated items are drawn directly unless they may refresh their rendition every that many milliseconds
+    int m_renderCacheInterval{ 0 };
 };
 
 #endif
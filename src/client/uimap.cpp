@@ -21,6 +21,7 @@
  */
 
 #include "uimap.h"
+#include <framework/core/graphicalapplication.h>
 #include <framework/graphics/graphics.h>
 #include <framework/graphics/drawpool.h>
 #include <framework/otml/otml.h>
@@ -40,6 +41,7 @@ UIMap::UIMap()
     m_maxZoomIn = 3;
     m_maxZoomOut = 513;
     m_mapRect.resize(1, 1);
+    m_qualityGovernor.setMaxLevel(MapView::QUALITY_LOWEST);
     g_map.addMapView(m_mapView);
 }
 
@@ -60,6 +62,12 @@ void UIMap::drawSelf(Fw::DrawPane drawPane)
     }
 
     if(drawPane & Fw::BackgroundPane) {
+        const int oldLevel = m_mapView->getQualityLevel();
+        if(m_qualityGovernor.update(g_app.getFrameWorkMicros())) {
+            m_mapView->setQualityLevel(m_qualityGovernor.getLevel());
+            callLuaField("onQualityChange", m_qualityGovernor.getLevel(), oldLevel, m_qualityGovernor.getAverageMicros());
+        }
+
         m_mapView->draw(m_mapRect);
     }
 }
@@ -161,6 +169,8 @@ void UIMap::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleN
             setDrawTexts(node->value<bool>());
         else if(node->tag() == "draw-lights")
             setDrawLights(node->value<bool>());
+        else if(node->tag() == "smooth-zoom")
+            setSmoothZoom(node->value<bool>());
     }
 }
 
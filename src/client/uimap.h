@@ -28,6 +28,7 @@
 #include "tile.h"
 
 #include "mapview.h"
+#include "qualitygovernor.h"
 
 class UIMap : public UIWidget
 {
@@ -54,6 +55,7 @@ public:
     void setDrawLights(bool enable) { m_mapView->setDrawLights(enable); }
     void setDrawViewportEdge(bool enable) { m_mapView->setDrawViewportEdge(enable); }
     void setDrawManaBar(bool enable) { m_mapView->setDrawManaBar(enable); }
+    void setStaticFloorsCache(bool enable) { m_mapView->setStaticFloorsCache(enable); }
     void setKeepAspectRatio(bool enable);
     void setMapShader(const PainterShaderProgramPtr& shader, float fadein, float fadeout) { m_mapView->setShader(shader, fadein, fadeout); }
     void setMinimumAmbientLight(float intensity) { m_mapView->setMinimumAmbientLight(intensity); }
@@ -70,6 +72,7 @@ public:
     bool isDrawingLights() { return m_mapView->isDrawingLights(); }
     bool isDrawingViewportEdge() { return m_mapView->isDrawingViewportEdge(); }
     bool isDrawingManaBar() { return m_mapView->isDrawingManaBar(); }
+    bool isStaticFloorsCacheEnabled() { return m_mapView->isStaticFloorsCacheEnabled(); }
     bool isKeepAspectRatioEnabled() { return m_keepAspectRatio; }
     bool isLimitVisibleRangeEnabled() { return m_limitVisibleRange; }
 
@@ -99,6 +102,21 @@ public:
     void setAntiAliasing(const bool enable) { m_mapView->setAntiAliasing(enable); }
     void setRenderScale(const uint8 scale) { m_mapView->setRenderScale(scale); }
 
+    void setAdaptiveQuality(bool enable) { m_qualityGovernor.setEnabled(enable); }
+    bool isAdaptiveQualityEnabled() { return m_qualityGovernor.isEnabled(); }
+    void setQualityBudget(int micros) { m_qualityGovernor.setBudget(micros); }
+    void setMaxQualityLevel(int level) { m_qualityGovernor.setMaxLevel(std::min<int>(level, MapView::QUALITY_LOWEST)); }
+    int getQualityLevel() { return m_mapView->getQualityLevel(); }
+
+    void setLodThreshold(int rule, int pixels) { m_mapView->setLodThreshold(rule, std::clamp<int>(pixels, 0, UINT8_MAX)); }
+    int getLodThreshold(int rule) { return m_mapView->getLodThreshold(rule); }
+    float getEffectiveTileSize() { return m_mapView->getEffectiveTileSize(); }
+
+    void setSmoothZoom(bool enable) { m_mapView->setSmoothZoom(enable); }
+    bool isSmoothZoomEnabled() { return m_mapView->isSmoothZoomEnabled(); }
+    void setSmoothZoomRange(int range) { m_mapView->setSmoothZoomRange(range); }
+    int getSmoothZoomRange() { return m_mapView->getSmoothZoomRange(); }
+
 protected:
     void onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode) override;
     void onGeometryChange(const Rect& oldRect, const Rect& newRect) override;
@@ -109,6 +127,7 @@ private:
     void updateMapSize();
 
     MapViewPtr m_mapView;
+    QualityGovernor m_qualityGovernor;
     Rect m_mapRect;
     float m_aspectRatio;
 
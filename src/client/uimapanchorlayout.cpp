@@ -72,6 +72,7 @@ void UIMapAnchorLayout::addPositionAnchor(const UIWidgetPtr& anchoredWidget, Fw:
         anchorGroup = UIAnchorGroupPtr(new UIAnchorGroup);
 
     anchorGroup->addAnchor(anchor);
+    m_orderDirty = true;
 
     // layout must be updated because a new anchor got in
     update();
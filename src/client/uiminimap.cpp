@@ -46,6 +46,9 @@ void UIMinimap::drawSelf(Fw::DrawPane drawPane)
         return;
 
     g_minimap.draw(getPaddingRect(), getCameraPosition(), m_scale, m_color);
+
+    // the minimap fills in as tiles are seen, it can't tell when it changed
+    repaint();
 }
 
 bool UIMinimap::setZoom(int zoom)
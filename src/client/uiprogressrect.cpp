@@ -21,6 +21,8 @@
  */
 
 #include "uiprogressrect.h"
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
 #include <framework/graphics/fontmanager.h>
 #include <framework/graphics/graphics.h>
 #include <framework/otml/otml.h>
@@ -38,39 +40,42 @@ void UIProgressRect::drawSelf(Fw::DrawPane drawPane)
     // todo: check +1 to right/bottom
     // todo: add smooth
     const Rect drawRect = getPaddingRect();
+    const float percent = getPercent();
+    if(isTimedProgress() && percent < 100)
+        scheduleRefresh();
 
     // 0% - 12.5% (12.5)
     // triangle from top center, to top right (var x)
-    if(m_percent < 12.5) {
-        const Point var = Point(std::max<int>(m_percent - 0.0, 0.0) * (drawRect.right() - drawRect.horizontalCenter()) / 12.5, 0);
+    if(percent < 12.5) {
+        const Point var = Point(std::max<int>(percent - 0.0, 0.0) * (drawRect.right() - drawRect.horizontalCenter()) / 12.5, 0);
         g_drawPool.addFilledTriangle(drawRect.center(), drawRect.topRight() + Point(1, 0), drawRect.topCenter() + var, m_backgroundColor);
     }
 
     // 12.5% - 37.5% (25)
     // triangle from top right to bottom right (var y)
-    if(m_percent < 37.5) {
-        const Point var = Point(0, std::max<int>(m_percent - 12.5, 0.0) * (drawRect.bottom() - drawRect.top()) / 25.0);
+    if(percent < 37.5) {
+        const Point var = Point(0, std::max<int>(percent - 12.5, 0.0) * (drawRect.bottom() - drawRect.top()) / 25.0);
         g_drawPool.addFilledTriangle(drawRect.center(), drawRect.bottomRight() + Point(1), drawRect.topRight() + var + Point(1, 0), m_backgroundColor);
     }
 
     // 37.5% - 62.5% (25)
     // triangle from bottom right to bottom left (var x)
-    if(m_percent < 62.5) {
-        const Point var = Point(std::max<int>(m_percent - 37.5, 0.0) * (drawRect.right() - drawRect.left()) / 25.0, 0);
+    if(percent < 62.5) {
+        const Point var = Point(std::max<int>(percent - 37.5, 0.0) * (drawRect.right() - drawRect.left()) / 25.0, 0);
         g_drawPool.addFilledTriangle(drawRect.center(), drawRect.bottomLeft() + Point(0, 1), drawRect.bottomRight() - var + Point(1), m_backgroundColor);
     }
 
     // 62.5% - 87.5% (25)
     // triangle from bottom left to top left
-    if(m_percent < 87.5) {
-        const Point var = Point(0, std::max<int>(m_percent - 62.5, 0.0) * (drawRect.bottom() - drawRect.top()) / 25.0);
+    if(percent < 87.5) {
+        const Point var = Point(0, std::max<int>(percent - 62.5, 0.0) * (drawRect.bottom() - drawRect.top()) / 25.0);
         g_drawPool.addFilledTriangle(drawRect.center(), drawRect.topLeft(), drawRect.bottomLeft() - var + Point(0, 1), m_backgroundColor);
     }
 
     // 87.5% - 100% (12.5)
     // triangle from top left to top center
-    if(m_percent < 100) {
-        const Point var = Point(std::max<int>(m_percent - 87.5, 0.0) * (drawRect.horizontalCenter() - drawRect.left()) / 12.5, 0);
+    if(percent < 100) {
+        const Point var = Point(std::max<int>(percent - 87.5, 0.0) * (drawRect.horizontalCenter() - drawRect.left()) / 12.5, 0);
         g_drawPool.addFilledTriangle(drawRect.center(), drawRect.topCenter(), drawRect.topLeft() + var, m_backgroundColor);
     }
 
@@ -82,7 +87,76 @@ void UIProgressRect::drawSelf(Fw::DrawPane drawPane)
 
 void UIProgressRect::setPercent(float percent)
 {
+    stopTimedProgress();
     m_percent = stdext::clamp<float>(static_cast<double>(percent), 0.0, 100.0);
+    repaint();
+}
+
+float UIProgressRect::getPercent()
+{
+    if(!isTimedProgress())
+        return m_percent;
+    return stdext::clamp<float>((g_clock.millis() - m_startTime) * 100.0f / m_duration, 0.0f, 100.0f);
+}
+
+void UIProgressRect::setTimedProgress(ticks_t startTime, int duration)
+{
+    stopTimedProgress();
+    if(duration <= 0) {
+        m_percent = 100;
+        repaint();
+        return;
+    }
+
+    m_startTime = startTime;
+    m_duration = duration;
+    repaint();
+
+    const auto self = static_self_cast<UIProgressRect>();
+    m_finishEvent = g_dispatcher.scheduleEvent([self] { self->onTimedProgressFinish(); },
+                                               std::max<int>(1, startTime + duration - g_clock.millis()));
+}
+
+void UIProgressRect::stopTimedProgress()
+{
+    if(!isTimedProgress())
+        return;
+
+    m_percent = getPercent();
+    m_duration = 0;
+    if(m_refreshEvent) {
+        m_refreshEvent->cancel();
+        m_refreshEvent = nullptr;
+    }
+    if(m_finishEvent) {
+        m_finishEvent->cancel();
+        m_finishEvent = nullptr;
+    }
+}
+
+void UIProgressRect::scheduleRefresh()
+{
+    if(m_refreshEvent && !m_refreshEvent->isExecuted() && !m_refreshEvent->isCanceled())
+        return;
+
+    // the sweep runs along the border, so it only has to be redrawn when it moved about a pixel
+    const Rect drawRect = getPaddingRect();
+    const int perimeter = std::max<int>(1, 2 * (drawRect.width() + drawRect.height()));
+    const int interval = std::max<int>(MIN_REFRESH_INTERVAL, m_duration / perimeter);
+
+    const auto self = static_self_cast<UIProgressRect>();
+    m_refreshEvent = g_dispatcher.scheduleEvent([self] { if(!self->isDestroyed()) self->repaint(); }, interval);
+}
+
+void UIProgressRect::onTimedProgressFinish()
+{
+    m_finishEvent = nullptr;
+    stopTimedProgress();
+    m_percent = 100;
+    repaint();
+
+    if(!isDestroyed())
+        callLuaField("onProgressFinish");
 }
 
 void UIProgressRect::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode)
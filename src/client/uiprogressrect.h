@@ -34,12 +34,32 @@ public:
     void drawSelf(Fw::DrawPane drawPane) override;
 
     void setPercent(float percent);
-    float getPercent() { return m_percent; }
+    float getPercent();
+
+    // fills from 0 to 100 percent over duration milliseconds counted from startTime, the percent is taken from the
+    // clock when drawn so lua only sets it once and gets onProgressFinish when it is full
+    void setTimedProgress(ticks_t startTime, int duration);
+    void stopTimedProgress();
+    bool isTimedProgress() { return m_duration > 0; }
 
 protected:
     void onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode) override;
 
     float m_percent;
+
+private:
+    enum {
+        // a sweep needs no more than this to look smooth
+        MIN_REFRESH_INTERVAL = 33
+    };
+
+    void scheduleRefresh();
+    void onTimedProgressFinish();
+
+    ticks_t m_startTime{ 0 };
+    int m_duration{ 0 };
+    ScheduledEventPtr m_refreshEvent;
+    ScheduledEventPtr m_finishEvent;
 };
 
 #endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "walkpredictor.h"
+
+#include <framework/core/clock.h>
+
+const WalkPredictor::Step& WalkPredictor::predict(Otc::Direction direction, const Position& from, bool animated)
+{
+    Position start = from;
+    m_steps.push_back(Step{ ++m_sequence, direction, from, start.translatedToDirection(direction), g_clock.millis(), animated });
+    return m_steps.back();
+}
+
+bool WalkPredictor::confirm(const Position& from, const Position& to)
+{
+    if(m_steps.empty())
+        return false;
+
+    const Step& step = m_steps.front();
+    if(step.from != from || step.to != to) {
+        rollback();
+        return false;
+    }
+
+    // smoothed round trip of a step, the first sample is taken as is
+    const int latency = g_clock.millis() - step.sentTime;
+    m_latency = m_confirmed == 0 ? latency : (m_latency * 7 + latency) / 8;
+    m_confirmed++;
+
+    m_steps.pop_front();
+    return true;
+}
+
+void WalkPredictor::rollback()
+{
+    if(m_steps.empty())
+        return;
+
+    m_steps.clear();
+    m_rollbacks++;
+}
+
+WalkPredictor::Step* WalkPredictor::getNextStep(const Position& position)
+{
+    for(Step& step : m_steps) {
+        if(step.animated)
+            continue;
+        return step.from == position ? &step : nullptr;
+    }
+    return nullptr;
+}
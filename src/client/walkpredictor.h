@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef WALKPREDICTOR_H
+#define WALKPREDICTOR_H
+
+#include "declarations.h"
+#include "position.h"
+
+#include <deque>
+
+// steps sent to the server ahead of its confirmation, in the order it will answer them,
+// each confirmed creature move of the local player must match the oldest one or everything predicted is dropped
+class WalkPredictor
+{
+public:
+    enum {
+        MAX_DEPTH = 4,
+        CORRECTION_DURATION = 150 // camera easing after a rollback, in milliseconds
+    };
+
+    struct Step {
+        uint32 sequence;
+        Otc::Direction direction;
+        Position from, to;
+        ticks_t sentTime;
+        bool animated;
+    };
+
+    void setDepth(int depth) { m_depth = stdext::clamp<int>(depth, 1, MAX_DEPTH); }
+    int getDepth() { return m_depth; }
+
+    bool canPredict() { return static_cast<int>(m_steps.size()) < m_depth; }
+    bool hasSteps() { return !m_steps.empty(); }
+    int getStepCount() { return m_steps.size(); }
+    ticks_t getLastStepTime() { return m_steps.empty() ? 0 : m_steps.back().sentTime; }
+
+    // where the local player will be once every step is confirmed
+    Position getPredictedPosition(const Position& serverPosition) { return m_steps.empty() ? serverPosition : m_steps.back().to; }
+
+    const Step& predict(Otc::Direction direction, const Position& from, bool animated);
+    // true when the move was the oldest predicted step, any other move rolls the prediction back
+    bool confirm(const Position& from, const Position& to);
+    void rollback();
+
+    // the oldest step not animated yet, when it starts where the local player is
+    Step* getNextStep(const Position& position);
+
+    int getLatency() { return m_latency; }
+    int getConfirmedCount() { return m_confirmed; }
+    int getRollbackCount() { return m_rollbacks; }
+
+private:
+    std::deque<Step> m_steps;
+    uint32 m_sequence{ 0 };
+    int m_depth{ 2 };
+    int m_latency{ 0 };
+    int m_confirmed{ 0 };
+    int m_rollbacks{ 0 };
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "actiontracer.h"
+
+ActionTracer g_actionTracer;
+
+namespace {
+    const char* stageNames[ActionTracer::LastStage] = { "inputToSend", "sendToFrame", "sendToConfirm", "confirmToFrame", "inputToShown" };
+}
+
+void ActionTracer::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if(!enabled)
+        m_pending.clear();
+}
+
+void ActionTracer::reset()
+{
+    m_pending.clear();
+    for(TypeStats& stats : m_types)
+        stats = TypeStats();
+}
+
+uint16 ActionTracer::registerType(const std::string& name)
+{
+    const auto it = std::find(m_typeNames.begin(), m_typeNames.end(), name);
+    if(it != m_typeNames.end())
+        return it - m_typeNames.begin();
+
+    m_typeNames.push_back(name);
+    m_types.emplace_back();
+    return m_typeNames.size() - 1;
+}
+
+uint32 ActionTracer::begin(uint16 type, bool awaitConfirm)
+{
+    if(!m_enabled || type >= m_types.size())
+        return 0;
+
+    if(m_pending.size() >= MAX_PENDING) {
+        m_types[m_pending.front().type].dropped++;
+        m_pending.pop_front();
+    }
+
+    const ticks_t now = stdext::micros();
+    m_pending.push_back({ ++m_lastId, type, awaitConfirm, m_inputTime, now, 0, 0 });
+    m_types[type].count++;
+    if(m_inputTime > 0)
+        record(type, InputToSend, m_inputTime, now);
+    return m_lastId;
+}
+
+void ActionTracer::confirm(uint32 id)
+{
+    Action* action = findAction(id);
+    if(!action || action->confirmed > 0)
+        return;
+
+    action->confirmed = stdext::micros();
+    record(action->type, SendToConfirm, action->sent, action->confirmed);
+}
+
+void ActionTracer::cancel(uint32 id)
+{
+    const auto it = std::find_if(m_pending.begin(), m_pending.end(), [id](const Action& action) { return action.id == id; });
+    if(it == m_pending.end())
+        return;
+
+    m_types[it->type].cancelled++;
+    m_pending.erase(it);
+}
+
+void ActionTracer::onFramePresented()
+{
+    if(m_pending.empty())
+        return;
+
+    const ticks_t now = stdext::micros();
+    for(auto it = m_pending.begin(); it != m_pending.end();) {
+        Action& action = *it;
+        if(action.sentFrame == 0) {
+            action.sentFrame = now;
+            record(action.type, SendToFrame, action.sent, now);
+        }
+
+        const bool shown = action.awaitConfirm ? action.confirmed > 0 : true;
+        if(shown) {
+            if(action.awaitConfirm)
+                record(action.type, ConfirmToFrame, action.confirmed, now);
+            if(action.input > 0)
+                record(action.type, InputToShown, action.input, now);
+            it = m_pending.erase(it);
+        } else if(now - action.sent > PENDING_TIMEOUT) {
+            m_types[action.type].dropped++;
+            it = m_pending.erase(it);
+        } else
+            ++it;
+    }
+}
+
+std::map<std::string, std::map<std::string, double>> ActionTracer::getSummary()
+{
+    std::map<std::string, std::map<std::string, double>> ret;
+    for(size_t type = 0; type < m_types.size(); ++type) {
+        const TypeStats& stats = m_types[type];
+        if(stats.count == 0)
+            continue;
+
+        std::map<std::string, double>& entry = ret[m_typeNames[type]];
+        entry["count"] = stats.count;
+        entry["cancelled"] = stats.cancelled;
+        entry["dropped"] = stats.dropped;
+        for(int stage = 0; stage < LastStage; ++stage) {
+            const auto& samples = stats.stages[stage];
+            if(samples.empty())
+                continue;
+
+            const std::string name = stageNames[stage];
+            entry[name + "Avg"] = samples.average();
+            entry[name + "P50"] = samples.percentile(0.5);
+            entry[name + "P95"] = samples.percentile(0.95);
+            entry[name + "P99"] = samples.percentile(0.99);
+        }
+    }
+    return ret;
+}
+
+ActionTracer::Action* ActionTracer::findAction(uint32 id)
+{
+    for(Action& action : m_pending) {
+        if(action.id == id)
+            return &action;
+    }
+    return nullptr;
+}
+
+void ActionTracer::record(uint16 type, Stage stage, ticks_t from, ticks_t to)
+{
+    m_types[type].stages[stage].push(static_cast<uint32>(stdext::clamp<ticks_t>(to - from, 0, std::numeric_limits<uint32>::max())));
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ACTIONTRACER_H
+#define ACTIONTRACER_H
+
+#include "declarations.h"
+#include <framework/stdext/rolling_window.h>
+#include <framework/stdext/time.h>
+
+// follows user actions from the input event behind them through the packet sent for them and the
+// server confirmation to the first frame presented afterwards, actions are linked by their id
+class ActionTracer
+{
+public:
+    enum {
+        MAX_PENDING = 64, // the oldest unfinished action is dropped beyond this
+        PENDING_TIMEOUT = 10000000, // microseconds an action waits for its confirmation
+        SAMPLE_WINDOW = 256 // latencies kept per stage and action type
+    };
+
+    enum Stage {
+        InputToSend = 0, // input event to the packet leaving, includes scheduled and pre walks
+        SendToFrame, // packet sent to the next frame, what prediction shows right away
+        SendToConfirm, // server round trip
+        ConfirmToFrame, // confirmation to the next frame
+        InputToShown, // input event to the frame showing the final state
+        LastStage
+    };
+
+    // actions started while the scope is alive are linked to the input event given to it
+    class InputScope
+    {
+    public:
+        InputScope(ticks_t inputTime);
+        ~InputScope();
+
+    private:
+        ticks_t m_previous;
+    };
+
+    void setEnabled(bool enabled);
+    bool isEnabled() { return m_enabled; }
+    void reset();
+
+    uint16 registerType(const std::string& name);
+    ticks_t getInputTime() { return m_inputTime; }
+
+    // the action's packet is being sent, returns its id or 0 while disabled;
+    // actions not awaiting a confirmation are done at their first frame
+    uint32 begin(uint16 type, bool awaitConfirm);
+    void confirm(uint32 id);
+    void cancel(uint32 id);
+    void onFramePresented();
+
+    // per action type table with count, cancelled, dropped and the avg, p50, p95 and p99 of every stage in microseconds
+    std::map<std::string, std::map<std::string, double>> getSummary();
+
+private:
+    struct Action {
+        uint32 id;
+        uint16 type;
+        bool awaitConfirm;
+        ticks_t input; // 0 without an input event
+        ticks_t sent;
+        ticks_t sentFrame;
+        ticks_t confirmed;
+    };
+
+    struct TypeStats {
+        uint64 count = 0;
+        uint64 cancelled = 0;
+        uint64 dropped = 0;
+        std::array<stdext::rolling_window<uint32, SAMPLE_WINDOW>, LastStage> stages;
+    };
+
+    Action* findAction(uint32 id);
+    void record(uint16 type, Stage stage, ticks_t from, ticks_t to);
+
+    bool m_enabled = false;
+    uint32 m_lastId = 0;
+    ticks_t m_inputTime = 0;
+    std::deque<Action> m_pending;
+    std::vector<std::string> m_typeNames;
+    std::vector<TypeStats> m_types;
+};
+
+extern ActionTracer g_actionTracer;
+
+inline ActionTracer::InputScope::InputScope(ticks_t inputTime) : m_previous(g_actionTracer.m_inputTime)
+{
+    g_actionTracer.m_inputTime = inputTime;
+}
+
+inline ActionTracer::InputScope::~InputScope()
+{
+    g_actionTracer.m_inputTime = m_previous;
+}
+
+#endif
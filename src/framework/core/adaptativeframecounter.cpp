@@ -30,6 +30,8 @@ AdaptativeFrameCounter::AdaptativeFrameCounter()
     m_partialFps = 0;
     m_maxPartialFps = 0;
     m_frameDelaySum = 0;
+    m_frameDelaySquareSum = 0;
+    m_frameTimeVariance = 0;
     m_mediumFrameDelay = 0;
     m_lastFps = 0;
     m_lastFrame = 0;
@@ -38,26 +40,68 @@ AdaptativeFrameCounter::AdaptativeFrameCounter()
     m_mediumFrameDelay = 0;
     m_lastFpsUpdate = g_clock.micros();
     m_lastPartialFpsUpdate = g_clock.micros();
+    m_bestFrameDelay = 0;
+    m_pacingMode = PacingDefault;
+    m_backgrounded = false;
+    m_wakeUp = false;
+    m_nextFrame = 0;
+    m_frameWorkStart = 0;
+    m_frameWork = 0;
+    m_lastSubmit = 0;
+    m_vblankInterval = 0;
 }
 
 bool AdaptativeFrameCounter::shouldProcessNextFrame()
 {
-    if(m_maxFps == 0)
+    if(m_wakeUp)
         return true;
 
     ticks_t now = g_clock.micros();
-    if(now - m_lastFrame < m_bestFrameDelay)
-        return false;
-    return true;
+    switch(m_pacingMode) {
+        case PacingLowLatency:
+            return now >= getLowLatencyStart();
+        case PacingVariableRefresh:
+            return now >= m_nextFrame;
+        default: {
+            ticks_t frameDelay = getFrameDelay();
+            return frameDelay == 0 || now - m_lastFrame >= frameDelay;
+        }
+    }
 }
 
 void AdaptativeFrameCounter::processNextFrame()
 {
     ticks_t now = g_clock.micros();
+    ticks_t delay = now - m_lastFrame;
     m_frames++;
     m_partialFrames++;
-    m_frameDelaySum += now - m_lastFrame;
+    m_frameDelaySum += delay;
+    m_frameDelaySquareSum += static_cast<double>(delay) * delay;
     m_lastFrame = now;
+    m_wakeUp = false;
+
+    // frames are scheduled from the previous deadline instead of from now, a late frame doesn't shift the ones after it
+    m_nextFrame += m_bestFrameDelay;
+    if(m_nextFrame < now - m_bestFrameDelay || m_nextFrame > now + m_bestFrameDelay)
+        m_nextFrame = now + m_bestFrameDelay;
+}
+
+void AdaptativeFrameCounter::frameRendered()
+{
+    // smoothed, so a single slow frame doesn't make the next ones start too early
+    ticks_t work = stdext::micros() - m_frameWorkStart;
+    m_frameWork = m_frameWork == 0 ? work : (m_frameWork * 7 + work) / 8;
+}
+
+void AdaptativeFrameCounter::frameSubmitted()
+{
+    // with vertical sync the buffer swap returns right after a vblank, its cadence is the refresh interval
+    ticks_t now = stdext::micros();
+    ticks_t interval = now - m_lastSubmit;
+    m_lastSubmit = now;
+    if(interval <= 0 || interval > 100000)
+        return;
+    m_vblankInterval = m_vblankInterval == 0 ? interval : (m_vblankInterval * 15 + interval) / 16;
 }
 
 bool AdaptativeFrameCounter::update()
@@ -73,13 +117,17 @@ bool AdaptativeFrameCounter::update()
     delta = now - m_lastFpsUpdate;
     if(delta >= 1000000) {
         m_lastFps = m_frames;
-        if(m_frames > 0)
+        if(m_frames > 0) {
             m_mediumFrameDelay = m_frameDelaySum / m_frames;
-        else
+            m_frameTimeVariance = std::max<double>(m_frameDelaySquareSum / m_frames - static_cast<double>(m_mediumFrameDelay) * m_mediumFrameDelay, 0);
+        } else {
             m_mediumFrameDelay = 0;
+            m_frameTimeVariance = 0;
+        }
         m_lastFpsUpdate = now;
         m_frames = 0;
         m_frameDelaySum = 0;
+        m_frameDelaySquareSum = 0;
 
         //dump << stdext::format("FPS => %d  Partial FPS => %d  Frame Delay Hit => %.2f%%", m_lastFps, (int)m_partialFps, getFrameDelayHit());
         return true;
@@ -100,11 +148,50 @@ void AdaptativeFrameCounter::setMaxFps(int maxFps)
     m_maxFps = maxFps;
 }
 
+void AdaptativeFrameCounter::setPacingMode(PacingMode mode)
+{
+    m_pacingMode = mode;
+    m_nextFrame = g_clock.micros();
+    m_wakeUp = false;
+}
+
+ticks_t AdaptativeFrameCounter::getFrameDelay()
+{
+    if(m_pacingMode == PacingPowerSave && m_backgrounded)
+        return std::max<ticks_t>(m_bestFrameDelay, POWER_SAVE_FRAME_DELAY);
+    return m_bestFrameDelay;
+}
+
+ticks_t AdaptativeFrameCounter::getLowLatencyStart()
+{
+    // the fps limit sets the cadence, without it the measured refresh interval does
+    ticks_t interval = m_bestFrameDelay != 0 ? m_bestFrameDelay : m_vblankInterval;
+    if(interval == 0)
+        return 0;
+    return m_lastSubmit + interval - m_frameWork - LOW_LATENCY_MARGIN;
+}
+
 int AdaptativeFrameCounter::getMaximumSleepMicros()
 {
-    if(m_maxFps == 0)
+    if(m_wakeUp)
         return 0;
-    return m_lastFrame + m_bestFrameDelay - g_clock.micros();
+
+    ticks_t now = g_clock.micros();
+    switch(m_pacingMode) {
+        case PacingLowLatency:
+            return getLowLatencyStart() - now;
+        case PacingVariableRefresh:
+            return m_bestFrameDelay == 0 ? 0 : m_nextFrame - now;
+        case PacingPowerSave:
+            // short sleeps so input is still polled often enough to wake up
+            if(m_backgrounded)
+                return std::min<int>(m_lastFrame + getFrameDelay() - now, POWER_SAVE_POLL_DELAY);
+            [[fallthrough]];
+        default:
+            if(m_maxFps == 0)
+                return 0;
+            return m_lastFrame + m_bestFrameDelay - now;
+    }
 }
 
 float AdaptativeFrameCounter::getFrameDelayHit()
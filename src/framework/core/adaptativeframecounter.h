@@ -36,7 +36,23 @@ class AdaptativeFrameCounter
 public:
     enum {
         // 4ms because most platforms has kernel timer of 250Hz
-        MINIMUM_MICROS_SLEEP = 4000
+        MINIMUM_MICROS_SLEEP = 4000,
+        // low latency mode starts the frame this much earlier than the estimated work requires
+        LOW_LATENCY_MARGIN = 1000,
+        // power save mode draws unfocused windows at 10 fps, polling input in between
+        POWER_SAVE_FRAME_DELAY = 100000,
+        POWER_SAVE_POLL_DELAY = 10000
+    };
+
+    enum PacingMode {
+        // render as soon as the fps limit allows, sleep the rest
+        PacingDefault = 0,
+        // sleep first, then sample input and render just in time for the next vblank
+        PacingLowLatency,
+        // like the default while focused, slows down unfocused windows until input arrives
+        PacingPowerSave,
+        // keeps an even cadence for variable refresh rate displays, every wait is precise
+        PacingVariableRefresh
     };
 
     AdaptativeFrameCounter();
@@ -47,20 +63,41 @@ public:
     void setMaxFps(int maxFps);
     bool isFpsLimitActive() { return m_maxFps != 0; }
 
+    void setPacingMode(PacingMode mode);
+    PacingMode getPacingMode() { return m_pacingMode; }
+    void setBackgrounded(bool backgrounded) { m_backgrounded = backgrounded; }
+    // input arrived, power save mode processes the next frame right away
+    void wakeUp() { m_wakeUp = true; }
+
+    // brackets of a processed frame, they feed the low latency work and vblank estimates
+    void beginFrameWork() { m_frameWorkStart = stdext::micros(); }
+    void frameRendered();
+    void frameSubmitted();
+
     int getMaximumSleepMicros();
+    int getMinimumSleepMicros() { return m_pacingMode == PacingLowLatency || m_pacingMode == PacingVariableRefresh ? 1 : MINIMUM_MICROS_SLEEP; }
     float getFrameDelayHit();
     int getLastFps() { return m_lastFps; }
     int getPartialFps() { return static_cast<int>(m_partialFps); }
     int getMaxFps() { return m_maxFps; }
     int getFrames() { return m_frames; }
     float getMediumFrameDelay() { return m_mediumFrameDelay; }
+    // variance of the frame delays of the last second, in squared microseconds
+    double getFrameTimeVariance() { return m_frameTimeVariance; }
+    // smoothed time spent between beginFrameWork and frameRendered
+    ticks_t getFrameWorkMicros() { return m_frameWork; }
 
 private:
+    ticks_t getFrameDelay();
+    ticks_t getLowLatencyStart();
+
     int m_frames;
     int m_partialFrames;
     float m_partialFps;
     float m_maxPartialFps;
     ticks_t m_frameDelaySum;
+    double m_frameDelaySquareSum;
+    double m_frameTimeVariance;
     ticks_t m_mediumFrameDelay;
     ticks_t m_lastFrame;
     int m_lastFps;
@@ -69,6 +106,15 @@ private:
     ticks_t m_lastFpsUpdate;
     ticks_t m_lastPartialFpsUpdate;
     float m_sleepMicros;
+
+    PacingMode m_pacingMode;
+    bool m_backgrounded;
+    bool m_wakeUp;
+    ticks_t m_nextFrame;
+    ticks_t m_frameWorkStart;
+    ticks_t m_frameWork;
+    ticks_t m_lastSubmit;
+    ticks_t m_vblankInterval;
 };
 
 #endif
@@ -28,7 +28,9 @@
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/configmanager.h>
 #include "asyncdispatcher.h"
+#include "stats.h"
 #include <framework/luaengine/luainterface.h>
+#include <framework/luaengine/luaeventbatch.h>
 #include <framework/platform/crashhandler.h>
 #include <framework/platform/platform.h>
 
@@ -67,6 +69,9 @@ Application::Application()
 
 void Application::init(std::vector<std::string>& args)
 {
+    m_startupBegin = stdext::micros();
+    beginStartupPhase("platform");
+
     // capture exit signals
     signal(SIGTERM, exitSignalHandler);
     signal(SIGINT, exitSignalHandler);
@@ -81,6 +86,7 @@ void Application::init(std::vector<std::string>& args)
     // process args encoding
     g_platform.processArgs(args);
 
+    g_logger.init();
     g_asyncDispatcher.init();
 
     std::string startupOptions;
@@ -95,12 +101,15 @@ void Application::init(std::vector<std::string>& args)
     m_startupOptions = startupOptions;
 
     // initialize configs
+    beginStartupPhase("configs");
     g_configs.init();
 
     // initialize resources
+    beginStartupPhase("resources");
     g_resources.init(args[0].c_str());
 
     // initialize lua
+    beginStartupPhase("lua");
     g_lua.init();
     registerLuaFunctions();
 }
@@ -112,6 +121,7 @@ void Application::deinit()
     // run modules unload events
     g_modules.unloadModules();
     g_modules.clear();
+    g_eventBatch.clear();
 
     // release remaining lua object references
     g_lua.collectGarbage();
@@ -121,6 +131,9 @@ void Application::deinit()
 
     g_asyncDispatcher.terminate();
 
+    // stop periodic snapshots
+    g_stats.terminate();
+
     // disable dispatcher events
     g_dispatcher.shutdown();
 }
@@ -141,6 +154,9 @@ void Application::terminate()
     // terminate script environment
     g_lua.terminate();
 
+    // later messages are written synchronously
+    g_logger.terminate();
+
     m_terminated = true;
 
     signal(SIGTERM, SIG_DFL);
@@ -153,12 +169,19 @@ void Application::poll()
     Connection::poll();
 #endif
 
+    // main thread continuations of finished async tasks were injected into the dispatcher by the workers
     g_dispatcher.poll();
 
+    // log messages written since the last frame reach lua at once
+    g_logger.poll();
+
     // poll connection again to flush pending write
 #ifdef FW_NET
     Connection::poll();
 #endif
+
+    // lua subscribers get everything batched this frame at once
+    g_eventBatch.flush();
 }
 
 void Application::exit()
@@ -173,6 +196,49 @@ void Application::close()
         exit();
 }
 
+void Application::beginStartupPhase(const std::string& name)
+{
+    if(m_startupFinished)
+        return;
+
+    const ticks_t now = stdext::micros();
+    if(!m_startupPhase.empty())
+        m_startupPhases.emplace_back(m_startupPhase, now - m_startupPhaseBegin);
+    m_startupPhase = name;
+    m_startupPhaseBegin = now;
+}
+
+void Application::finishStartup()
+{
+    if(m_startupFinished)
+        return;
+
+    beginStartupPhase("");
+    m_startupEnd = stdext::micros();
+    m_startupFinished = true;
+
+    std::string phases;
+    for(const auto& phase : m_startupPhases) {
+        if(!phases.empty())
+            phases += ", ";
+        phases += stdext::format("%s %.1fms", phase.first, phase.second / 1000.0);
+    }
+    g_logger.info(stdext::format("Startup took %.1fms (%s)", getStartupTime(), phases));
+}
+
+std::vector<std::tuple<std::string, double>> Application::getStartupPhases()
+{
+    std::vector<std::tuple<std::string, double>> phases;
+    for(const auto& phase : m_startupPhases)
+        phases.emplace_back(phase.first, phase.second / 1000.0);
+    return phases;
+}
+
+double Application::getStartupTime()
+{
+    return ((m_startupFinished ? m_startupEnd : stdext::micros()) - m_startupBegin) / 1000.0;
+}
+
 std::string Application::getOs()
 {
 #if defined(WIN32)
@@ -61,6 +61,16 @@ public:
     std::string getOs();
     std::string getStartupOptions() { return m_startupOptions; }
 
+    /// Closes the running startup phase and opens the next one, phases stop being recorded once startup finished
+    void beginStartupPhase(const std::string& name);
+    /// Logs the phase timings, called once the first frame reaches the screen
+    void finishStartup();
+    bool isStartupFinished() { return m_startupFinished; }
+    /// Name and milliseconds of every finished phase, in execution order
+    std::vector<std::tuple<std::string, double>> getStartupPhases();
+    /// Milliseconds since init, up to the first frame once startup finished
+    double getStartupTime();
+
 protected:
     void registerLuaFunctions();
 
@@ -71,6 +81,14 @@ protected:
     stdext::boolean<false> m_running;
     stdext::boolean<false> m_stopping;
     stdext::boolean<false> m_terminated;
+
+private:
+    std::vector<std::pair<std::string, ticks_t>> m_startupPhases;
+    std::string m_startupPhase;
+    ticks_t m_startupBegin{ 0 };
+    ticks_t m_startupPhaseBegin{ 0 };
+    ticks_t m_startupEnd{ 0 };
+    stdext::boolean<false> m_startupFinished;
 };
 
 #ifdef FW_GRAPHICS
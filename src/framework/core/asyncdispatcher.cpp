@@ -21,24 +21,32 @@
  */
 
 #include "asyncdispatcher.h"
+#include "eventdispatcher.h"
 
 AsyncDispatcher g_asyncDispatcher;
 
+namespace {
+// worker index of the current thread, -1 outside the pool
+thread_local int t_workerIndex = -1;
+}
+
 void AsyncDispatcher::init()
 {
-    spawn_thread();
+    // leave one core to the main thread, the queues are all created before any worker can steal from them
+    const int threads = std::max<int>(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    for(int i = 0; i < threads; ++i)
+        m_workers.emplace_back(new Worker);
+
+    m_running = true;
+    for(int i = 0; i < threads; ++i)
+        m_threads.emplace_back(std::bind(&AsyncDispatcher::exec_loop, this, i));
 }
 
 void AsyncDispatcher::terminate()
 {
     stop();
-    m_tasks.clear();
-}
-
-void AsyncDispatcher::spawn_thread()
-{
-    m_running = true;
-    m_threads.emplace_back(std::bind(&AsyncDispatcher::exec_loop, this));
+    m_workers.clear();
+    m_pendingTasks = 0;
 }
 
 void AsyncDispatcher::stop()
@@ -50,23 +58,84 @@ void AsyncDispatcher::stop()
     for(std::thread& thread : m_threads)
         thread.join();
     m_threads.clear();
-};
+}
 
-void AsyncDispatcher::exec_loop()
+void AsyncDispatcher::pushTask(const std::function<void()>& task, Priority priority)
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
+    if(m_workers.empty()) {
+        task();
+        return;
+    }
+
+    // workers keep what they spawn, everything else is spread round robin
+    int index = t_workerIndex;
+    if(index < 0)
+        index = m_nextWorker++ % m_workers.size();
+
+    // counted before it becomes visible so no worker can take it while the count is still zero
+    m_pendingTasks++;
+
+    Worker& worker = *m_workers[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks[priority].push_back(task);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_condition.notify_one();
+}
+
+bool AsyncDispatcher::popTask(int index, std::function<void()>& task)
+{
+    const int count = m_workers.size();
+    for(int priority = PriorityHigh; priority < PriorityLast; ++priority) {
+        // the newest own task first, it is the most likely to be warm in cache
+        Worker& own = *m_workers[index];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            auto& tasks = own.tasks[priority];
+            if(!tasks.empty()) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+                return true;
+            }
+        }
+
+        // otherwise steal the oldest task of another worker
+        for(int i = 1; i < count; ++i) {
+            Worker& victim = *m_workers[(index + i) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            auto& tasks = victim.tasks[priority];
+            if(!tasks.empty()) {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void AsyncDispatcher::exec_loop(int index)
+{
+    t_workerIndex = index;
+
+    std::function<void()> task;
     while(true) {
-        while(m_tasks.empty() && m_running)
-            m_condition.wait(lock);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_pendingTasks == 0 && m_running)
+                m_condition.wait(lock);
 
-        if(!m_running)
-            return;
+            if(!m_running)
+                return;
+        }
 
-        std::function<void()> task = m_tasks.front();
-        m_tasks.pop_front();
+        if(!popTask(index, task))
+            continue;
+        m_pendingTasks--;
 
-        lock.unlock();
         task();
-        lock.lock();
+        task = nullptr;
     }
 }
@@ -24,38 +24,124 @@
 #define ASYNCDISPATCHER_H
 
 #include "declarations.h"
+#include "eventdispatcher.h"
 #include <framework/stdext/thread.h>
 #include <future>
 
+template<class T>
+class AsyncTask;
+
 class AsyncDispatcher {
 public:
+    enum Priority {
+        PriorityHigh = 0,
+        PriorityNormal,
+        PriorityLow,
+        PriorityLast
+    };
+
     void init();
     void terminate();
-
-    void spawn_thread();
     void stop();
 
+    // tasks go to the calling worker own queue or round robin from other threads, idle workers steal from the others
     template<class F>
-    std::shared_future<typename std::invoke_result<F>::type> schedule(const F& task)
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        auto prom = std::make_shared<std::promise<typename std::invoke_result<F>::type>>();
-        m_tasks.push_back([=]() { prom->set_value(task()); });
-        m_condition.notify_all();
-        return std::shared_future<typename std::invoke_result<F>::type>(prom->get_future());
-    }
+    AsyncTask<typename std::invoke_result<F>::type> schedule(const F& task, Priority priority = PriorityNormal);
+
+    // runs on the main thread from the next dispatcher poll, used by AsyncTask::then_on_main
+    void addMainThreadCallback(const std::function<void()>& callback) { g_dispatcher.addEvent(callback); }
+
+    int getThreadCount() { return m_workers.size(); }
+    uint getPendingTaskCount() { return m_pendingTasks; }
 
 protected:
-    void exec_loop();
+    void exec_loop(int index);
 
 private:
-    std::list<std::function<void()>> m_tasks;
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks[PriorityLast];
+    };
+
+    void pushTask(const std::function<void()>& task, Priority priority);
+    bool popTask(int index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
     std::list<std::thread> m_threads;
     std::mutex m_mutex;
     std::condition_variable m_condition;
+    std::atomic<uint> m_pendingTasks{0};
+    std::atomic<uint> m_nextWorker{0};
     stdext::boolean<false> m_running;
 };
 
 extern AsyncDispatcher g_asyncDispatcher;
 
+// a shared future that can also hand its result back to the main thread once ready
+template<class T>
+class AsyncTask : public std::shared_future<T>
+{
+public:
+    typedef std::function<void(const std::shared_future<T>&)> Continuation;
+
+    AsyncTask() = default;
+
+    // the callback runs on the main thread, through g_dispatcher, after the task has finished or failed
+    void then_on_main(const Continuation& callback) {
+        if(!m_state)
+            return;
+
+        std::shared_future<T> future = *this;
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if(m_state->finished)
+            g_asyncDispatcher.addMainThreadCallback([callback, future] { callback(future); });
+        else
+            m_state->continuation = [callback, future] { callback(future); };
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::function<void()> continuation;
+        bool finished = false;
+    };
+
+    AsyncTask(const std::shared_future<T>& future, const std::shared_ptr<State>& state) :
+        std::shared_future<T>(future), m_state(state) { }
+
+    std::shared_ptr<State> m_state;
+
+    friend class AsyncDispatcher;
+};
+
+template<class F>
+AsyncTask<typename std::invoke_result<F>::type> AsyncDispatcher::schedule(const F& task, Priority priority)
+{
+    typedef typename std::invoke_result<F>::type R;
+    auto prom = std::make_shared<std::promise<R>>();
+    auto state = std::make_shared<typename AsyncTask<R>::State>();
+    AsyncTask<R> asyncTask(prom->get_future().share(), state);
+
+    pushTask([prom, state, task]() {
+        // failures reach the caller through the future instead of killing the worker
+        try {
+            if constexpr(std::is_void<R>::value) {
+                task();
+                prom->set_value();
+            } else
+                prom->set_value(task());
+        } catch(...) {
+            prom->set_exception(std::current_exception());
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->finished = true;
+        if(state->continuation) {
+            g_asyncDispatcher.addMainThreadCallback(state->continuation);
+            state->continuation = nullptr;
+        }
+    }, priority);
+    return asyncTask;
+}
+
 #endif
@@ -182,12 +182,154 @@ Point BinaryTree::getPoint()
     return ret;
 }
 
+BinaryTreeView::ChildIterator& BinaryTreeView::ChildIterator::operator++()
+{
+    m_pos = skipNode(m_data, m_size, m_pos + 1);
+    return *this;
+}
+
+BinaryTreeView::BinaryTreeView(const uint8* data, uint size, uint start) :
+    m_data(data), m_size(size), m_start(start), m_pos(start)
+{
+}
+
+BinaryTreeView BinaryTreeView::fromStream(const FileStreamPtr& fin)
+{
+    const uint8* data = fin->cachedData();
+    if(!data)
+        stdext::throw_exception("BinaryTreeView: stream is not cached");
+    if(fin->getU8() != BINARYTREE_NODE_START)
+        stdext::throw_exception("BinaryTreeView: no valid root node start");
+    return BinaryTreeView(data, fin->cachedSize(), fin->tell());
+}
+
+uint BinaryTreeView::skipNode(const uint8* data, uint size, uint pos)
+{
+    uint depth = 1;
+    while(pos < size) {
+        switch(data[pos++]) {
+        case BINARYTREE_NODE_START:
+            ++depth;
+            break;
+        case BINARYTREE_NODE_END:
+            if(--depth == 0)
+                return pos;
+            break;
+        case BINARYTREE_ESCAPE_CHAR:
+            ++pos;
+            break;
+        default:
+            break;
+        }
+    }
+    stdext::throw_exception("BinaryTreeView: unterminated node");
+    return size;
+}
+
+uint8 BinaryTreeView::readByte()
+{
+    if(m_pos >= m_size)
+        stdext::throw_exception("BinaryTreeView: read past end of buffer");
+    uint8 byte = m_data[m_pos];
+    if(byte == BINARYTREE_NODE_START || byte == BINARYTREE_NODE_END)
+        stdext::throw_exception("BinaryTreeView: read past end of node properties");
+    if(byte == BINARYTREE_ESCAPE_CHAR) {
+        if(++m_pos >= m_size)
+            stdext::throw_exception("BinaryTreeView: read past end of buffer");
+        byte = m_data[m_pos];
+    }
+    ++m_pos;
+    return byte;
+}
+
+void BinaryTreeView::skip(uint len)
+{
+    for(uint i = 0; i < len; ++i)
+        readByte();
+}
+
+uint8 BinaryTreeView::getU8()
+{
+    return readByte();
+}
+
+uint16 BinaryTreeView::getU16()
+{
+    uint8 data[2];
+    for(uint8& byte : data)
+        byte = readByte();
+    return stdext::readULE16(data);
+}
+
+uint32 BinaryTreeView::getU32()
+{
+    uint8 data[4];
+    for(uint8& byte : data)
+        byte = readByte();
+    return stdext::readULE32(data);
+}
+
+uint64 BinaryTreeView::getU64()
+{
+    uint8 data[8];
+    for(uint8& byte : data)
+        byte = readByte();
+    return stdext::readULE64(data);
+}
+
+std::string_view BinaryTreeView::getStringView(uint16 len)
+{
+    if(len == 0)
+        len = getU16();
+
+    if(m_pos + len > m_size)
+        stdext::throw_exception("BinaryTreeView: getString failed: string length exceeded buffer size.");
+
+    // most strings hold no special bytes and can be returned straight from the buffer
+    const uint8* begin = m_data + m_pos;
+    const uint8* end = begin + len;
+    if(std::find_if(begin, end, [](uint8 byte) { return byte >= BINARYTREE_ESCAPE_CHAR; }) == end) {
+        m_pos += len;
+        return std::string_view((const char*)begin, len);
+    }
+
+    m_scratch.resize(len);
+    for(uint16 i = 0; i < len; ++i)
+        m_scratch[i] = (char)readByte();
+    return m_scratch;
+}
+
+Point BinaryTreeView::getPoint()
+{
+    Point ret;
+    ret.x = getU8();
+    ret.y = getU8();
+    return ret;
+}
+
+BinaryTreeView::ChildRange BinaryTreeView::getChildren()
+{
+    uint pos = m_start;
+    while(pos < m_size && m_data[pos] != BINARYTREE_NODE_START && m_data[pos] != BINARYTREE_NODE_END)
+        pos += m_data[pos] == BINARYTREE_ESCAPE_CHAR ? 2 : 1;
+    return ChildRange(ChildIterator(m_data, m_size, pos));
+}
+
+bool BinaryTreeView::canRead()
+{
+    return m_pos < m_size && m_data[m_pos] != BINARYTREE_NODE_START && m_data[m_pos] != BINARYTREE_NODE_END;
+}
+
 OutputBinaryTree::OutputBinaryTree(const FileStreamPtr& fin)
     : m_fin(fin)
 {
     startNode(0);
 }
 
+OutputBinaryTree::OutputBinaryTree()
+{
+}
+
 void OutputBinaryTree::addU8(uint8 v)
 {
     write(&v, 1);
@@ -231,20 +373,51 @@ void OutputBinaryTree::addPoint(const Point& point)
 
 void OutputBinaryTree::startNode(uint8 node)
 {
-    m_fin->addU8(BINARYTREE_NODE_START);
+    if(m_fin)
+        m_fin->addU8(BINARYTREE_NODE_START);
+    else
+        m_record.marks.emplace_back(m_record.data.size(), BINARYTREE_NODE_START);
     write(&node, 1);
 }
 
 void OutputBinaryTree::endNode()
 {
-    m_fin->addU8(BINARYTREE_NODE_END);
+    if(m_fin)
+        m_fin->addU8(BINARYTREE_NODE_END);
+    else
+        m_record.marks.emplace_back(m_record.data.size(), BINARYTREE_NODE_END);
 }
 
 void OutputBinaryTree::write(const uint8* data, size_t size)
 {
+    if(!m_fin) {
+        m_record.data.append(reinterpret_cast<const char*>(data), size);
+        return;
+    }
+
     for(size_t i = 0; i < size; ++i) {
         if(data[i] == BINARYTREE_NODE_START || data[i] == BINARYTREE_NODE_END || data[i] == BINARYTREE_ESCAPE_CHAR)
             m_fin->addU8(BINARYTREE_ESCAPE_CHAR);
         m_fin->addU8(data[i]);
     }
 }
+
+void BinaryTreeRecord::encode(std::string& out) const
+{
+    // escaping grows the data by a few percent at most
+    out.reserve(out.size() + data.size() + data.size() / 16 + marks.size());
+
+    size_t pos = 0;
+    auto mark = marks.begin();
+    while(pos < data.size() || mark != marks.end()) {
+        const size_t end = mark != marks.end() ? mark->first : data.size();
+        for(; pos < end; ++pos) {
+            const char byte = data[pos];
+            if(byte == (char)BINARYTREE_NODE_START || byte == (char)BINARYTREE_NODE_END || byte == (char)BINARYTREE_ESCAPE_CHAR)
+                out.push_back((char)BINARYTREE_ESCAPE_CHAR);
+            out.push_back(byte);
+        }
+        if(mark != marks.end())
+            out.push_back((char)(mark++)->second);
+    }
+}
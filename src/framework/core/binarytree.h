@@ -25,6 +25,7 @@
 
 #include "declarations.h"
 #include <framework/util/databuffer.h>
+#include <string_view>
 
 enum {
     BINARYTREE_ESCAPE_CHAR = 0xFD,
@@ -63,10 +64,93 @@ private:
     uint m_startPos;
 };
 
+/// Read only cursor over a node of an escaped tree held in one contiguous buffer, such as a
+/// cached FileStream. Properties are unescaped while they are read and children are found by
+/// walking the bytes in place, so unlike BinaryTree nothing is copied or allocated per node.
+/// The buffer must outlive every view created over it.
+class BinaryTreeView
+{
+public:
+    class ChildIterator
+    {
+    public:
+        ChildIterator(const uint8* data, uint size, uint pos) : m_data(data), m_size(size), m_pos(pos) { }
+
+        BinaryTreeView operator*() const { return BinaryTreeView(m_data, m_size, m_pos + 1); }
+        ChildIterator& operator++();
+        // the end iterator is a sentinel, iteration stops at the first byte that is not a node start
+        bool operator!=(const ChildIterator&) const { return m_pos < m_size && m_data[m_pos] == BINARYTREE_NODE_START; }
+
+    private:
+        const uint8* m_data;
+        uint m_size;
+        uint m_pos;
+    };
+
+    class ChildRange
+    {
+    public:
+        ChildRange(const ChildIterator& begin) : m_begin(begin) { }
+
+        ChildIterator begin() const { return m_begin; }
+        ChildIterator end() const { return m_begin; }
+
+    private:
+        ChildIterator m_begin;
+    };
+
+    /// start is the offset right after the node start byte
+    BinaryTreeView(const uint8* data, uint size, uint start);
+
+    /// reads the node start byte at the stream position, the stream must be cached
+    static BinaryTreeView fromStream(const FileStreamPtr& fin);
+
+    void skip(uint len);
+    uint getStart() { return m_start; }
+
+    uint8 getU8();
+    uint16 getU16();
+    uint32 getU32();
+    uint64 getU64();
+    /// points into the buffer when the string holds no escaped bytes, otherwise into a copy
+    /// owned by the view that is only valid until the next call
+    std::string_view getStringView(uint16 len = 0);
+    std::string getString(uint16 len = 0) { return std::string(getStringView(len)); }
+    Point getPoint();
+
+    ChildRange getChildren();
+    bool canRead();
+
+private:
+    uint8 readByte();
+    static uint skipNode(const uint8* data, uint size, uint pos);
+
+    const uint8* m_data;
+    uint m_size;
+    uint m_start;
+    uint m_pos;
+    std::string m_scratch;
+};
+
+// node tree kept in memory without escaping, encode() produces the file bytes and may run on any thread
+struct BinaryTreeRecord
+{
+    std::string data;
+    // node start and end bytes go right before data[offset]
+    std::vector<std::pair<uint32, uint8>> marks;
+
+    void encode(std::string& out) const;
+};
+
 class OutputBinaryTree : public stdext::shared_object
 {
 public:
     OutputBinaryTree(const FileStreamPtr& finish);
+    // records the nodes instead of writing them, there is no implicit root node
+    OutputBinaryTree();
+
+    BinaryTreeRecord takeRecord() { BinaryTreeRecord record; std::swap(record, m_record); return record; }
+    size_t getRecordedSize() { return m_record.data.size(); }
 
     void addU8(uint8 v);
     void addU16(uint16 v);
@@ -80,6 +164,7 @@ public:
 
 private:
     FileStreamPtr m_fin;
+    BinaryTreeRecord m_record;
 
 protected:
     void write(const uint8* data, size_t size);
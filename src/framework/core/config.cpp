@@ -25,6 +25,23 @@
 #include "configmanager.h"
 
 #include <framework/otml/otml.h>
+#include <framework/otml/otmlbinary.h>
+#include <framework/core/eventdispatcher.h>
+
+namespace {
+    // binary configs are not compiled from a text file, they all carry this key
+    const std::string BINARY_CONFIG_KEY = "config";
+
+    bool writeConfigData(const std::string& fileName, const std::string& data)
+    {
+        // a crash in the middle of a write leaves the previous file, physfs is the fallback when there is no write dir yet
+        if(g_resources.writeFileContentsAtomic(fileName, data) || g_resources.writeFileContents(fileName, data))
+            return true;
+
+        g_logger.error(stdext::format("Unable to save configuration file '%s'", fileName));
+        return false;
+    }
+}
 
 Config::Config()
 {
@@ -34,13 +51,19 @@ Config::Config()
 
 bool Config::load(const std::string& file)
 {
+    flush();
     m_fileName = file;
 
     if(!g_resources.fileExists(file))
         return false;
 
     try {
-        OTMLDocumentPtr confsDoc = OTMLDocument::parse(file);
+        OTMLDocumentPtr confsDoc;
+        if(isBinary()) {
+            const std::string data = g_resources.readFileContents(file);
+            confsDoc = OTMLBinary::load((const uint8*)data.data(), data.size());
+        } else
+            confsDoc = OTMLDocument::parse(file);
         if(confsDoc)
             m_confsDoc = confsDoc;
         return true;
@@ -53,6 +76,7 @@ bool Config::load(const std::string& file)
 bool Config::unload()
 {
     if(isLoaded()) {
+        flush();
         m_confsDoc = nullptr;
         m_fileName = "";
         return true;
@@ -64,7 +88,65 @@ bool Config::save()
 {
     if(m_fileName.length() == 0)
         return false;
-    return m_confsDoc->save(m_fileName);
+
+    const int delay = g_configs.getWriteBehindDelay();
+    if(delay <= 0)
+        return write(false);
+
+    // window moves and hotkey edits save on every change, only the first one schedules the write
+    m_dirty = true;
+    if(!m_saveEvent) {
+        const ConfigPtr self = asConfig();
+        m_saveEvent = g_dispatcher.scheduleEvent([self] { self->write(true); }, delay);
+    }
+    return true;
+}
+
+bool Config::flush()
+{
+    bool written = true;
+    if(m_pendingWrite.valid()) {
+        // the pool drops queued tasks when it stops before the configs are terminated
+        try {
+            written = m_pendingWrite.get();
+        } catch(...) {
+            written = false;
+        }
+        m_pendingWrite = AsyncTask<bool>();
+    }
+
+    if(!written)
+        m_dirty = true;
+    if(!m_dirty)
+        return true;
+    return write(false);
+}
+
+bool Config::write(bool async)
+{
+    if(m_saveEvent) {
+        m_saveEvent->cancel();
+        m_saveEvent = nullptr;
+    }
+    m_dirty = false;
+
+    if(m_fileName.empty() || !m_confsDoc)
+        return false;
+
+    // writes share the temporary file, only one runs at a time
+    if(m_pendingWrite.valid())
+        m_pendingWrite.wait();
+
+    // the tree belongs to the main thread, it is emitted here and only the disk write is deferred
+    const std::string data = isBinary() ? OTMLBinary::compile(m_confsDoc, BINARY_CONFIG_KEY, 0, 0) : m_confsDoc->emit();
+    const std::string fileName = m_fileName;
+    if(!async) {
+        m_pendingWrite = AsyncTask<bool>();
+        return writeConfigData(fileName, data);
+    }
+
+    m_pendingWrite = g_asyncDispatcher.schedule([fileName, data] { return writeConfigData(fileName, data); }, AsyncDispatcher::PriorityLow);
+    return true;
 }
 
 void Config::clear()
@@ -152,6 +234,11 @@ bool Config::isLoaded()
     return !m_fileName.empty() && m_confsDoc;
 }
 
+bool Config::isBinary()
+{
+    return g_resources.isFileType(m_fileName, "otmb");
+}
+
 std::string Config::getFileName()
 {
     return m_fileName;
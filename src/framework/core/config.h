@@ -24,6 +24,7 @@
 #define CONFIG_H
 
 #include "declarations.h"
+#include "asyncdispatcher.h"
 
 #include <framework/luaengine/luaobject.h>
 #include <framework/otml/declarations.h>
@@ -34,9 +35,13 @@ class Config : public LuaObject
 public:
     Config();
 
+    /// Files ending in .otmb are kept compiled, for large hotkey or vip lists
     bool load(const std::string& file);
     bool unload();
+    /// Defers the write by the write-behind delay of g_configs, saves in between are coalesced
     bool save();
+    /// Writes a deferred save right away and waits for the write still running on the pool
+    bool flush();
     void clear();
 
     void setValue(const std::string& key, const std::string& value);
@@ -53,13 +58,19 @@ public:
 
     std::string getFileName();
     bool isLoaded();
+    bool isBinary();
 
     // @dontbind
     ConfigPtr asConfig() { return static_self_cast<Config>(); }
 
 private:
+    bool write(bool async);
+
     std::string m_fileName;
     OTMLDocumentPtr m_confsDoc;
+    ScheduledEventPtr m_saveEvent;
+    AsyncTask<bool> m_pendingWrite;
+    bool m_dirty{ false };
 };
 
 #endif
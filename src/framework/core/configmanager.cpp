@@ -39,6 +39,7 @@ void ConfigManager::terminate()
         m_settings = nullptr;
     }
 
+    // unloading writes what is still waiting for the write-behind delay
     for(ConfigPtr config : m_configs) {
         config->unload();
         config = nullptr;
@@ -82,6 +83,7 @@ ConfigPtr ConfigManager::create(const std::string& file)
 
         config->load(file);
         config->save();
+        config->flush();
 
         m_configs.push_back(config);
     }
@@ -28,10 +28,18 @@
  // @bindsingleton g_configs
 class ConfigManager
 {
+    enum {
+        DEFAULT_WRITE_BEHIND_DELAY = 1000
+    };
+
 public:
     void init();
     void terminate();
 
+    /// Milliseconds a save waits for more changes before it is written on the pool, 0 writes every save at once
+    void setWriteBehindDelay(int delay) { m_writeBehindDelay = std::max<int>(delay, 0); }
+    int getWriteBehindDelay() { return m_writeBehindDelay; }
+
     ConfigPtr getSettings();
     ConfigPtr get(const std::string& file);
 
@@ -47,6 +55,7 @@ protected:
 
 private:
     std::list<ConfigPtr> m_configs;
+    int m_writeBehindDelay{ DEFAULT_WRITE_BEHIND_DELAY };
 };
 
 extern ConfigManager g_configs;
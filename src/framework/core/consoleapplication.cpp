@@ -42,6 +42,7 @@ void ConsoleApplication::run()
     g_clock.update();
 
     g_lua.callGlobalField("g_app", "onRun");
+    finishStartup();
 
     while(!m_stopping) {
         poll();
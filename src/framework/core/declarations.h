@@ -34,6 +34,7 @@ class Event;
 class ScheduledEvent;
 class FileStream;
 class BinaryTree;
+class BinaryTreeView;
 class OutputBinaryTree;
 
 typedef stdext::shared_object_ptr<Module> ModulePtr;
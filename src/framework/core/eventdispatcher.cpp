@@ -23,13 +23,19 @@
 #include "eventdispatcher.h"
 
 #include <framework/core/clock.h>
+#include <framework/core/frameprofiler.h>
 #include "timer.h"
 
+#ifdef FW_GRAPHICS
+#include <framework/platform/platformwindow.h>
+#endif
+
 EventDispatcher g_dispatcher;
 
 void EventDispatcher::shutdown()
 {
-    while(!m_eventList.empty())
+    m_pollBudget = 0;
+    while(!m_criticalEventList.empty() || !m_eventList.empty() || !m_deferrableEventList.empty())
         poll();
 
     while(!m_scheduledEventList.empty()) {
@@ -37,28 +43,171 @@ void EventDispatcher::shutdown()
         scheduledEvent->cancel();
         m_scheduledEventList.pop();
     }
+
+    for(auto& slot : m_timerWheel) {
+        while(!slot.empty()) {
+            ScheduledEventPtr scheduledEvent = slot.back();
+            scheduledEvent->cancel();
+        }
+    }
     m_disabled = true;
 }
 
-void EventDispatcher::poll()
+void EventDispatcher::setTimerWheelEnabled(bool enabled)
+{
+    if(m_timerWheelEnabled == enabled)
+        return;
+
+    std::vector<ScheduledEventPtr> pending;
+    while(!m_scheduledEventList.empty()) {
+        pending.push_back(m_scheduledEventList.top());
+        m_scheduledEventList.pop();
+    }
+    for(auto& slot : m_timerWheel) {
+        while(!slot.empty()) {
+            pending.push_back(slot.back());
+            unlinkScheduledEvent(slot.back().get());
+        }
+    }
+
+    m_timerWheelEnabled = enabled;
+    for(const ScheduledEventPtr& scheduledEvent : pending) {
+        if(!scheduledEvent->isCanceled())
+            pushScheduledEvent(scheduledEvent);
+    }
+}
+
+void EventDispatcher::pushScheduledEvent(const ScheduledEventPtr& scheduledEvent)
+{
+    if(!m_timerWheelEnabled) {
+        m_scheduledEventList.push(scheduledEvent);
+        return;
+    }
+
+    if(m_timerWheel.empty()) {
+        m_timerWheel.resize(TIMER_WHEEL_SIZE);
+        m_wheelTicks = g_clock.millis();
+    }
+
+    // events already due wait in the slot polled next
+    const ticks_t ticks = std::max<ticks_t>(scheduledEvent->ticks(), m_wheelTicks);
+    const int slot = ticks & (TIMER_WHEEL_SIZE - 1);
+    scheduledEvent->m_wheelSlot = slot;
+    scheduledEvent->m_wheelIndex = m_timerWheel[slot].size();
+    scheduledEvent->m_sequence = m_eventSequence++;
+    m_timerWheel[slot].push_back(scheduledEvent);
+    m_wheelEvents++;
+}
+
+void EventDispatcher::unlinkScheduledEvent(ScheduledEvent* scheduledEvent)
+{
+    std::vector<ScheduledEventPtr>& slot = m_timerWheel[scheduledEvent->m_wheelSlot];
+    const uint index = scheduledEvent->m_wheelIndex;
+    scheduledEvent->m_wheelSlot = -1;
+
+    // the last event of the slot takes the freed place, this may release the last reference to scheduledEvent
+    if(index != slot.size() - 1) {
+        std::swap(slot[index], slot.back());
+        slot[index]->m_wheelIndex = index;
+    }
+    slot.pop_back();
+    m_wheelEvents--;
+}
+
+void EventDispatcher::pollScheduledEvents()
 {
-    int loops = 0;
     for(int count = 0, max = m_scheduledEventList.size(); count < max && !m_scheduledEventList.empty(); ++count) {
         ScheduledEventPtr scheduledEvent = m_scheduledEventList.top();
         if(scheduledEvent->remainingTicks() > 0)
             break;
         m_scheduledEventList.pop();
         scheduledEvent->execute();
+        m_executedEvents++;
 
         if(scheduledEvent->nextCycle())
             m_scheduledEventList.push(scheduledEvent);
     }
+}
+
+void EventDispatcher::pollTimerWheel()
+{
+    if(m_wheelEvents == 0) {
+        m_wheelTicks = g_clock.millis() + 1;
+        return;
+    }
+
+    // visit every slot passed since the last poll, a full turn at most
+    const ticks_t now = g_clock.millis();
+    const ticks_t slots = std::min<ticks_t>(now - m_wheelTicks + 1, TIMER_WHEEL_SIZE);
+    for(ticks_t i = 0; i < slots; ++i) {
+        std::vector<ScheduledEventPtr>& slot = m_timerWheel[(m_wheelTicks + i) & (TIMER_WHEEL_SIZE - 1)];
+        for(int j = static_cast<int>(slot.size()) - 1; j >= 0; --j) {
+            if(slot[j]->ticks() > now)
+                continue;
+            m_readyEvents.push_back(slot[j]);
+            unlinkScheduledEvent(slot[j].get());
+        }
+    }
+    m_wheelTicks = now + 1;
+
+    // same order as the priority queue, events due at the same time run in the order they were scheduled
+    std::sort(m_readyEvents.begin(), m_readyEvents.end(), [](const ScheduledEventPtr& a, const ScheduledEventPtr& b) {
+        return a->ticks() != b->ticks() ? a->ticks() < b->ticks() : a->m_sequence < b->m_sequence;
+    });
+
+    // events scheduled from these callbacks land in the wheel and run on the next poll
+    m_executedEvents += m_readyEvents.size();
+    for(const ScheduledEventPtr& scheduledEvent : m_readyEvents) {
+        scheduledEvent->execute();
+        if(scheduledEvent->nextCycle())
+            pushScheduledEvent(scheduledEvent);
+    }
+    m_readyEvents.clear();
+}
+
+void EventDispatcher::executeQueuedEvent(const QueuedEvent& queuedEvent)
+{
+    // events queued before this frame were carried over by the budget
+    const ticks_t latency = g_clock.millis() - queuedEvent.ticks;
+    if(latency > 0) {
+        m_delayedEvents++;
+        m_delayedEventsLatency += latency;
+        m_maxEventLatency = std::max<ticks_t>(m_maxEventLatency, latency);
+    }
+    queuedEvent.event->execute();
+    m_executedEvents++;
+}
+
+bool EventDispatcher::isPollBudgetExceeded()
+{
+    return m_pollDeadline > 0 && stdext::micros() >= m_pollDeadline;
+}
+
+void EventDispatcher::poll()
+{
+    PROFILE_SCOPE("events.poll");
+    const ticks_t startTime = stdext::micros();
+    m_pollDeadline = m_pollBudget > 0 ? startTime + m_pollBudget * 1000 : 0;
+
+    // events other threads added since the last poll join the queues in the order they were added
+    std::function<void()> injected;
+    while(m_injectedEvents.pop(injected)) {
+        m_injectedEventCount++;
+        injected();
+    }
+
+    int loops = 0;
+    if(m_timerWheelEnabled)
+        pollTimerWheel();
+    else
+        pollScheduledEvents();
 
     // execute events list until all events are out, this is needed because some events can schedule new events that would
     // change the UIWidgets layout, in this case we must execute these new events before we continue rendering,
     m_pollEventsSize = m_eventList.size();
     loops = 0;
-    while(m_pollEventsSize > 0) {
+    bool outOfBudget = false;
+    while(m_pollEventsSize > 0 || !m_criticalEventList.empty()) {
         if(loops > 50) {
             static Timer reportTimer;
             if(reportTimer.running() && reportTimer.ticksElapsed() > 100) {
@@ -68,51 +217,186 @@ void EventDispatcher::poll()
             break;
         }
 
+        // critical events are never held back by the budget
+        for(int i = 0, max = m_criticalEventList.size(); i < max; ++i) {
+            QueuedEvent queuedEvent = m_criticalEventList.front();
+            m_criticalEventList.pop_front();
+            executeQueuedEvent(queuedEvent);
+        }
+
         for(int i = 0; i < m_pollEventsSize; ++i) {
-            EventPtr event = m_eventList.front();
+            if(isPollBudgetExceeded()) {
+                outOfBudget = true;
+                break;
+            }
+            QueuedEvent queuedEvent = m_eventList.front();
             m_eventList.pop_front();
-            event->execute();
+            executeQueuedEvent(queuedEvent);
         }
+        if(outOfBudget)
+            break;
         m_pollEventsSize = m_eventList.size();
 
         loops++;
     }
+
+    // deferrable events only get what is left of the budget, but at least one runs per poll so they always progress
+    for(int i = 0, max = m_deferrableEventList.size(); i < max; ++i) {
+        if(i > 0 && (outOfBudget || isPollBudgetExceeded()))
+            break;
+        QueuedEvent queuedEvent = m_deferrableEventList.front();
+        m_deferrableEventList.pop_front();
+        executeQueuedEvent(queuedEvent);
+    }
+
+    if(m_pollDeadline > 0)
+        m_deferredEvents += m_eventList.size() + m_deferrableEventList.size();
+    m_pollDeadline = 0;
+    m_lastPollTime = stdext::micros() - startTime;
+}
+
+void EventDispatcher::inject(std::function<void()>&& callback)
+{
+    m_injectedEvents.push(std::move(callback));
+
+#ifdef FW_GRAPHICS
+    // the main thread may be blocked in an idle wait
+    g_window.wakeUp();
+#endif
 }
 
 ScheduledEventPtr EventDispatcher::scheduleEvent(const std::function<void()>& callback, int delay)
 {
+    if(!isMainThread()) {
+        inject([this, callback, delay] { scheduleEvent(callback, delay); });
+        return nullptr;
+    }
+
     if(m_disabled)
         return ScheduledEventPtr(new ScheduledEvent(nullptr, delay, 1));
 
     assert(delay >= 0);
     ScheduledEventPtr scheduledEvent(new ScheduledEvent(callback, delay, 1));
-    m_scheduledEventList.push(scheduledEvent);
+    pushScheduledEvent(scheduledEvent);
     return scheduledEvent;
 }
 
 ScheduledEventPtr EventDispatcher::cycleEvent(const std::function<void()>& callback, int delay)
 {
+    if(!isMainThread()) {
+        inject([this, callback, delay] { cycleEvent(callback, delay); });
+        return nullptr;
+    }
+
     if(m_disabled)
         return ScheduledEventPtr(new ScheduledEvent(nullptr, delay, 0));
 
     assert(delay > 0);
     ScheduledEventPtr scheduledEvent(new ScheduledEvent(callback, delay, 0));
-    m_scheduledEventList.push(scheduledEvent);
+    pushScheduledEvent(scheduledEvent);
     return scheduledEvent;
 }
 
 EventPtr EventDispatcher::addEvent(const std::function<void()>& callback, bool pushFront)
 {
+    if(!isMainThread()) {
+        inject([this, callback, pushFront] { addEvent(callback, pushFront); });
+        return nullptr;
+    }
+
     if(m_disabled)
         return EventPtr(new Event(nullptr));
 
     EventPtr event(new Event(callback));
     // front pushing is a way to execute an event before others
     if(pushFront) {
-        m_eventList.push_front(event);
+        m_eventList.push_front({event, g_clock.millis()});
         // the poll event list only grows when pushing into front
         m_pollEventsSize++;
     } else
-        m_eventList.push_back(event);
+        m_eventList.push_back({event, g_clock.millis()});
+    return event;
+}
+
+EventPtr EventDispatcher::addCriticalEvent(const std::function<void()>& callback)
+{
+    if(!isMainThread()) {
+        inject([this, callback] { addCriticalEvent(callback); });
+        return nullptr;
+    }
+
+    if(m_disabled)
+        return EventPtr(new Event(nullptr));
+
+    EventPtr event(new Event(callback));
+    m_criticalEventList.push_back({event, g_clock.millis()});
+    return event;
+}
+
+EventPtr EventDispatcher::addDeferrableEvent(const std::function<void()>& callback)
+{
+    if(!isMainThread()) {
+        inject([this, callback] { addDeferrableEvent(callback); });
+        return nullptr;
+    }
+
+    if(m_disabled)
+        return EventPtr(new Event(nullptr));
+
+    EventPtr event(new Event(callback));
+    m_deferrableEventList.push_back({event, g_clock.millis()});
     return event;
 }
+
+int EventDispatcher::getNextEventDelay(int maxDelay)
+{
+    if(!m_criticalEventList.empty() || !m_eventList.empty() || !m_deferrableEventList.empty() || !m_injectedEvents.empty())
+        return 0;
+
+    const ticks_t now = g_clock.millis();
+    ticks_t next = now + maxDelay;
+
+    if(!m_timerWheelEnabled) {
+        if(!m_scheduledEventList.empty())
+            next = std::min<ticks_t>(next, m_scheduledEventList.top()->ticks());
+    } else if(m_wheelEvents > 0) {
+        // the first slot holding an event of the current turn has the earliest one, later turns share slots with it
+        const ticks_t slots = std::min<ticks_t>(next - m_wheelTicks + 1, TIMER_WHEEL_SIZE);
+        for(ticks_t i = 0; i < slots; ++i) {
+            const ticks_t slotTicks = m_wheelTicks + i;
+            for(const ScheduledEventPtr& scheduledEvent : m_timerWheel[slotTicks & (TIMER_WHEEL_SIZE - 1)]) {
+                if(scheduledEvent->ticks() <= slotTicks)
+                    next = std::min<ticks_t>(next, scheduledEvent->ticks());
+            }
+            if(next <= slotTicks)
+                break;
+        }
+    }
+
+    return std::max<int>(next - now, 0);
+}
+
+std::map<std::string, uint> EventDispatcher::getEventMetrics()
+{
+    std::map<std::string, uint> metrics;
+    metrics["criticalEvents"] = m_criticalEventList.size();
+    metrics["events"] = m_eventList.size();
+    metrics["deferrableEvents"] = m_deferrableEventList.size();
+    metrics["scheduledEvents"] = getScheduledEventCount();
+    metrics["deferredEvents"] = m_deferredEvents;
+    metrics["delayedEvents"] = m_delayedEvents;
+    metrics["averageLatency"] = m_delayedEvents > 0 ? m_delayedEventsLatency / m_delayedEvents : 0;
+    metrics["maxLatency"] = m_maxEventLatency;
+    metrics["lastPollTime"] = m_lastPollTime;
+    metrics["injectedEvents"] = m_injectedEventCount;
+    return metrics;
+}
+
+void EventDispatcher::resetEventMetrics()
+{
+    m_deferredEvents = 0;
+    m_delayedEvents = 0;
+    m_delayedEventsLatency = 0;
+    m_maxEventLatency = 0;
+    m_injectedEventCount = 0;
+}
@@ -26,24 +26,94 @@
 #include "clock.h"
 #include "scheduledevent.h"
 
+#include <framework/stdext/mpsc_queue.h>
 #include <queue>
+#include <thread>
 
  // @bindsingleton g_dispatcher
 class EventDispatcher
 {
 public:
+    enum {
+        // one millisecond per slot, later events wait in their slot until their turn comes around
+        TIMER_WHEEL_SIZE = 4096
+    };
+
+    EventDispatcher() : m_mainThreadId(std::this_thread::get_id()) {}
+
     void shutdown();
     void poll();
 
+    // critical events (input, network) always run in the poll they were added for, normal events may be cut
+    // by the poll budget and deferrable events (housekeeping) only run while there is budget left;
+    // other threads may add and schedule events too, they reach the main thread at the start of the next
+    // poll and no event handle is returned to them
     EventPtr addEvent(const std::function<void()>& callback, bool pushFront = false);
+    EventPtr addCriticalEvent(const std::function<void()>& callback);
+    EventPtr addDeferrableEvent(const std::function<void()>& callback);
     ScheduledEventPtr scheduleEvent(const std::function<void()>& callback, int delay);
     ScheduledEventPtr cycleEvent(const std::function<void()>& callback, int delay);
 
+    // scheduled events go to a timer wheel with O(1) insert and cancel by default, the priority queue
+    // keeps cancelled events until they expire; pending events move over when this changes
+    void setTimerWheelEnabled(bool enabled);
+    bool isTimerWheelEnabled() { return m_timerWheelEnabled; }
+    uint getScheduledEventCount() { return m_timerWheelEnabled ? m_wheelEvents : m_scheduledEventList.size(); }
+
+    // time in milliseconds a poll may spend on normal and deferrable events, 0 disables the budget;
+    // events left over carry to the next poll in their original order
+    void setPollBudget(int budget) { m_pollBudget = std::max<int>(budget, 0); }
+    int getPollBudget() { return m_pollBudget; }
+    std::map<std::string, uint> getEventMetrics();
+    void resetEventMetrics();
+
+    // milliseconds until something is due, 0 with queued events and maxDelay when nothing is due before it
+    int getNextEventDelay(int maxDelay);
+    // grows with every executed event, idle loops compare it to tell whether a poll did anything
+    uint64 getExecutedEventCount() { return m_executedEvents; }
+
 private:
-    std::deque<EventPtr> m_eventList;
+    struct QueuedEvent {
+        EventPtr event;
+        ticks_t ticks;
+    };
+
+    void executeQueuedEvent(const QueuedEvent& queuedEvent);
+    bool isPollBudgetExceeded();
+    void pushScheduledEvent(const ScheduledEventPtr& scheduledEvent);
+    void unlinkScheduledEvent(ScheduledEvent* scheduledEvent);
+    void pollScheduledEvents();
+    void pollTimerWheel();
+    bool isMainThread() { return std::this_thread::get_id() == m_mainThreadId; }
+    void inject(std::function<void()>&& callback);
+
+    std::deque<QueuedEvent> m_criticalEventList;
+    std::deque<QueuedEvent> m_eventList;
+    std::deque<QueuedEvent> m_deferrableEventList;
     int m_pollEventsSize;
+    int m_pollBudget = 0;
+    ticks_t m_pollDeadline = 0;
+    ticks_t m_lastPollTime = 0;
+    uint m_deferredEvents = 0;
+    uint m_delayedEvents = 0;
+    ticks_t m_delayedEventsLatency = 0;
+    ticks_t m_maxEventLatency = 0;
     stdext::boolean<false> m_disabled;
     std::priority_queue<ScheduledEventPtr, std::deque<ScheduledEventPtr>, ScheduledEvent::Compare> m_scheduledEventList;
+
+    bool m_timerWheelEnabled = true;
+    std::vector<std::vector<ScheduledEventPtr>> m_timerWheel;
+    std::vector<ScheduledEventPtr> m_readyEvents;
+    ticks_t m_wheelTicks = 0;
+    uint m_wheelEvents = 0;
+    uint64 m_eventSequence = 0;
+    uint64 m_executedEvents = 0;
+
+    const std::thread::id m_mainThreadId;
+    stdext::mpsc_queue<std::function<void()>> m_injectedEvents;
+    uint m_injectedEventCount = 0;
+
+    friend class ScheduledEvent;
 };
 
 extern EventDispatcher g_dispatcher;
@@ -26,12 +26,29 @@
 
 #include <physfs.h>
 
+#ifdef WIN32
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // smaller files are cheaper to copy than to map
+    const uint MIN_MAPPED_FILE_SIZE = 64 * 1024;
+}
+
 FileStream::FileStream(const std::string& name, PHYSFS_File* fileHandle, bool writeable) :
     m_name(name),
     m_fileHandle(fileHandle),
     m_pos(0),
     m_writeable(writeable),
-    m_caching(false)
+    m_caching(false),
+    m_mappedData(nullptr),
+    m_mappedSize(0)
 {
 }
 
@@ -40,7 +57,9 @@ FileStream::FileStream(const std::string& name, const std::string& buffer) :
     m_fileHandle(nullptr),
     m_pos(0),
     m_writeable(false),
-    m_caching(true)
+    m_caching(true),
+    m_mappedData(nullptr),
+    m_mappedSize(0)
 {
     m_data.resize(buffer.length());
     memcpy(&m_data[0], &buffer[0], buffer.length());
@@ -53,6 +72,7 @@ FileStream::~FileStream()
 #endif
     if(!g_app.isTerminated())
         close();
+    unmap();
 }
 
 void FileStream::cache()
@@ -63,8 +83,16 @@ void FileStream::cache()
         if(!m_fileHandle)
             return;
 
-        // cache entire file into data buffer
         m_pos = PHYSFS_tell(m_fileHandle);
+
+        // files on the real filesystem are mapped, the page cache is shared with other clients
+        if(map()) {
+            PHYSFS_close(m_fileHandle);
+            m_fileHandle = nullptr;
+            return;
+        }
+
+        // cache entire file into data buffer
         PHYSFS_seek(m_fileHandle, 0);
         int size = PHYSFS_fileLength(m_fileHandle);
         m_data.resize(size);
@@ -83,10 +111,89 @@ void FileStream::close()
         m_fileHandle = nullptr;
     }
 
+    unmap();
     m_data.clear();
     m_pos = 0;
 }
 
+bool FileStream::map()
+{
+    const uint size = PHYSFS_fileLength(m_fileHandle);
+    if(size < MIN_MAPPED_FILE_SIZE)
+        return false;
+
+    // packaged files have an archive as real dir, opening them on the host filesystem just fails
+    const char* realDir = PHYSFS_getRealDir(m_name.c_str());
+    if(!realDir)
+        return false;
+
+    const std::string realPath = std::string(realDir) + "/" + (stdext::starts_with(m_name, "/") ? m_name.substr(1) : m_name);
+
+#ifdef WIN32
+    HANDLE file = CreateFileW(stdext::utf8_to_utf16(realPath).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart != size) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(!mapping)
+        return false;
+
+    // the view keeps the mapping alive
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(!data)
+        return false;
+#else
+    const int fd = open(realPath.c_str(), O_RDONLY);
+    if(fd == -1)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) == -1 || static_cast<uint>(st.st_size) != size) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        return false;
+#endif
+
+    m_mappedData = static_cast<uint8*>(data);
+    m_mappedSize = size;
+    return true;
+}
+
+void FileStream::unmap()
+{
+    if(!m_mappedData)
+        return;
+
+#ifdef WIN32
+    UnmapViewOfFile(m_mappedData);
+#else
+    munmap(m_mappedData, m_mappedSize);
+#endif
+    m_mappedData = nullptr;
+    m_mappedSize = 0;
+}
+
+void FileStream::detachMapping()
+{
+    // writes into a mapped file go to a private copy, just like a regular cached stream
+    m_data.resize(m_mappedSize);
+    memcpy(m_data.data(), m_mappedData, m_mappedSize);
+    unmap();
+}
+
 void FileStream::flush()
 {
     if(!m_writeable)
@@ -117,11 +224,11 @@ int FileStream::read(void* buffer, uint32 size, uint32 nmemb)
         int writePos = 0;
         uint8* outBuffer = static_cast<uint8*>(buffer);
         for(uint i = 0; i < nmemb; ++i) {
-            if(m_pos + size > m_data.size())
+            if(m_pos + size > cacheSize())
                 return i;
 
             for(uint j = 0; j < size; ++j)
-                outBuffer[writePos++] = m_data[m_pos++];
+                outBuffer[writePos++] = cacheData()[m_pos++];
         }
         return nmemb;
     }
@@ -133,6 +240,8 @@ void FileStream::write(const void* buffer, uint32 count)
         if(PHYSFS_writeBytes(m_fileHandle, buffer, count) != count)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.grow(m_pos + count);
         memcpy(&m_data[m_pos], buffer, count);
         m_pos += count;
@@ -145,7 +254,7 @@ void FileStream::seek(uint32 pos)
         if(!PHYSFS_seek(m_fileHandle, pos))
             throwError("seek failed", true);
     } else {
-        if(pos > m_data.size())
+        if(pos > cacheSize())
             throwError("seek failed");
         m_pos = pos;
     }
@@ -161,7 +270,7 @@ uint FileStream::size()
     if(!m_caching)
         return PHYSFS_fileLength(m_fileHandle);
     else
-        return m_data.size();
+        return cacheSize();
 }
 
 uint FileStream::tell()
@@ -177,7 +286,7 @@ bool FileStream::eof()
     if(!m_caching)
         return PHYSFS_eof(m_fileHandle);
     else
-        return m_pos >= m_data.size();
+        return m_pos >= cacheSize();
 }
 
 uint8 FileStream::getU8()
@@ -187,10 +296,10 @@ uint8 FileStream::getU8()
         if(PHYSFS_readBytes(m_fileHandle, &v, 1) != 1)
             throwError("read failed", true);
     } else {
-        if(m_pos + 1 > m_data.size())
+        if(m_pos + 1 > cacheSize())
             throwError("read failed");
 
-        v = m_data[m_pos];
+        v = cacheData()[m_pos];
         m_pos += 1;
     }
     return v;
@@ -203,10 +312,10 @@ uint16 FileStream::getU16()
         if(PHYSFS_readULE16(m_fileHandle, &v) == 0)
             throwError("read failed", true);
     } else {
-        if(m_pos + 2 > m_data.size())
+        if(m_pos + 2 > cacheSize())
             throwError("read failed");
 
-        v = stdext::readULE16(&m_data[m_pos]);
+        v = stdext::readULE16(&cacheData()[m_pos]);
         m_pos += 2;
     }
     return v;
@@ -219,10 +328,10 @@ uint32 FileStream::getU32()
         if(PHYSFS_readULE32(m_fileHandle, &v) == 0)
             throwError("read failed", true);
     } else {
-        if(m_pos + 4 > m_data.size())
+        if(m_pos + 4 > cacheSize())
             throwError("read failed");
 
-        v = stdext::readULE32(&m_data[m_pos]);
+        v = stdext::readULE32(&cacheData()[m_pos]);
         m_pos += 4;
     }
     return v;
@@ -235,9 +344,9 @@ uint64 FileStream::getU64()
         if(PHYSFS_readULE64(m_fileHandle, (PHYSFS_uint64*)&v) == 0)
             throwError("read failed", true);
     } else {
-        if(m_pos + 8 > m_data.size())
+        if(m_pos + 8 > cacheSize())
             throwError("read failed");
-        v = stdext::readULE64(&m_data[m_pos]);
+        v = stdext::readULE64(&cacheData()[m_pos]);
         m_pos += 8;
     }
     return v;
@@ -250,10 +359,10 @@ int8 FileStream::get8()
         if(PHYSFS_readBytes(m_fileHandle, &v, 1) != 1)
             throwError("read failed", true);
     } else {
-        if(m_pos + 1 > m_data.size())
+        if(m_pos + 1 > cacheSize())
             throwError("read failed");
 
-        v = m_data[m_pos];
+        v = cacheData()[m_pos];
         m_pos += 1;
     }
     return v;
@@ -266,10 +375,10 @@ int16 FileStream::get16()
         if(PHYSFS_readSLE16(m_fileHandle, &v) == 0)
             throwError("read failed", true);
     } else {
-        if(m_pos + 2 > m_data.size())
+        if(m_pos + 2 > cacheSize())
             throwError("read failed");
 
-        v = stdext::readSLE16(&m_data[m_pos]);
+        v = stdext::readSLE16(&cacheData()[m_pos]);
         m_pos += 2;
     }
     return v;
@@ -282,10 +391,10 @@ int32 FileStream::get32()
         if(PHYSFS_readSLE32(m_fileHandle, &v) == 0)
             throwError("read failed", true);
     } else {
-        if(m_pos + 4 > m_data.size())
+        if(m_pos + 4 > cacheSize())
             throwError("read failed");
 
-        v = stdext::readSLE32(&m_data[m_pos]);
+        v = stdext::readSLE32(&cacheData()[m_pos]);
         m_pos += 4;
     }
     return v;
@@ -298,9 +407,9 @@ int64 FileStream::get64()
         if(PHYSFS_readSLE64(m_fileHandle, (PHYSFS_sint64*)&v) == 0)
             throwError("read failed", true);
     } else {
-        if(m_pos + 8 > m_data.size())
+        if(m_pos + 8 > cacheSize())
             throwError("read failed");
-        v = stdext::readSLE64(&m_data[m_pos]);
+        v = stdext::readSLE64(&cacheData()[m_pos]);
         m_pos += 8;
     }
     return v;
@@ -318,12 +427,12 @@ std::string FileStream::getString()
             else
                 str = std::string(buffer, len);
         } else {
-            if(m_pos + len > m_data.size()) {
+            if(m_pos + len > cacheSize()) {
                 throwError("read failed");
                 return nullptr;
             }
 
-            str = std::string((char*)&m_data[m_pos], len);
+            str = std::string((char*)&cacheData()[m_pos], len);
             m_pos += len;
         }
     } else if(len != 0)
@@ -357,6 +466,8 @@ void FileStream::addU8(uint8 v)
         if(PHYSFS_writeBytes(m_fileHandle, &v, 1) != 1)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.add(v);
         m_pos++;
     }
@@ -368,6 +479,8 @@ void FileStream::addU16(uint16 v)
         if(PHYSFS_writeULE16(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.grow(m_pos + 2);
         stdext::writeULE16(&m_data[m_pos], v);
         m_pos += 2;
@@ -380,6 +493,8 @@ void FileStream::addU32(uint32 v)
         if(PHYSFS_writeULE32(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.grow(m_pos + 4);
         stdext::writeULE32(&m_data[m_pos], v);
         m_pos += 4;
@@ -392,6 +507,8 @@ void FileStream::addU64(uint64 v)
         if(PHYSFS_writeULE64(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.grow(m_pos + 8);
         stdext::writeULE64(&m_data[m_pos], v);
         m_pos += 8;
@@ -404,6 +521,8 @@ void FileStream::add8(int8 v)
         if(PHYSFS_writeBytes(m_fileHandle, &v, 1) != 1)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.add(v);
         m_pos++;
     }
@@ -415,6 +534,8 @@ void FileStream::add16(int16 v)
         if(PHYSFS_writeSLE16(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.grow(m_pos + 2);
         stdext::writeSLE16(&m_data[m_pos], v);
         m_pos += 2;
@@ -427,6 +548,8 @@ void FileStream::add32(int32 v)
         if(PHYSFS_writeSLE32(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.grow(m_pos + 4);
         stdext::writeSLE32(&m_data[m_pos], v);
         m_pos += 4;
@@ -439,6 +562,8 @@ void FileStream::add64(int64 v)
         if(PHYSFS_writeSLE64(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
+        if(m_mappedData)
+            detachMapping();
         m_data.grow(m_pos + 8);
         stdext::writeSLE64(&m_data[m_pos], v);
         m_pos += 8;
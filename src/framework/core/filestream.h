@@ -50,6 +50,11 @@ public:
     bool eof();
     std::string name() { return m_name; }
 
+    // raw view of the cached buffer, readers using it never touch the stream position
+    const uint8* cachedData() const { return m_caching ? cacheData() : nullptr; }
+    uint cachedSize() const { return m_caching ? cacheSize() : 0; }
+    bool isMapped() const { return m_mappedData != nullptr; }
+
     uint8 getU8();
     uint16 getU16();
     uint32 getU32();
@@ -81,6 +86,12 @@ private:
     void checkWrite();
     void throwError(const std::string& message, bool physfsError = false);
 
+    bool map();
+    void unmap();
+    void detachMapping();
+    const uint8* cacheData() const { return m_mappedData ? m_mappedData : m_data.data(); }
+    uint cacheSize() const { return m_mappedData ? m_mappedSize : m_data.size(); }
+
     std::string m_name;
     PHYSFS_File* m_fileHandle;
     uint m_pos;
@@ -88,6 +99,10 @@ private:
     bool m_caching;
 
     DataBuffer<uint8_t> m_data;
+
+    // read only view of files living on the real filesystem, replaces m_data while set
+    uint8* m_mappedData;
+    uint m_mappedSize;
 };
 
 #endif
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "frameprofiler.h"
+#include <framework/core/resourcemanager.h>
+
+FrameProfiler g_frameProfiler;
+
+FrameProfiler::FrameProfiler() : m_mainThreadId(std::this_thread::get_id())
+{
+    m_scopeNesting.fill(0);
+}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if(!enabled)
+        m_inFrame = false;
+}
+
+bool FrameProfiler::isAvailable()
+{
+#ifdef FRAME_PROFILER
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FrameProfiler::reset()
+{
+    for(Frame& frame : m_frames) {
+        frame.duration = 0;
+        frame.events.clear();
+    }
+    m_currentFrame = 0;
+    m_recordedFrames = 0;
+    m_dropped = 0;
+    m_inFrame = false;
+}
+
+uint16 FrameProfiler::registerScope(const std::string& name)
+{
+    auto it = std::find(m_scopeNames.begin(), m_scopeNames.end(), name);
+    if(it != m_scopeNames.end())
+        return it - m_scopeNames.begin();
+
+    // scopes past the limit are never recorded
+    if(m_scopeNames.size() >= MAX_SCOPES)
+        return MAX_SCOPES;
+
+    m_scopeNames.push_back(name);
+    return m_scopeNames.size() - 1;
+}
+
+void FrameProfiler::beginFrame()
+{
+    if(!m_enabled)
+        return;
+
+    Frame& frame = m_frames[m_currentFrame];
+    frame.events.clear();
+    frame.start = stdext::micros();
+    frame.duration = 0;
+    m_inFrame = true;
+}
+
+void FrameProfiler::endFrame()
+{
+    if(!m_inFrame)
+        return;
+
+    Frame& frame = m_frames[m_currentFrame];
+    frame.duration = stdext::micros() - frame.start;
+    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES;
+    m_recordedFrames = std::min<int>(m_recordedFrames + 1, MAX_FRAMES);
+    m_inFrame = false;
+}
+
+bool FrameProfiler::begin(uint16 scope)
+{
+    if(!m_inFrame || scope >= MAX_SCOPES || std::this_thread::get_id() != m_mainThreadId)
+        return false;
+
+    m_scopeNesting[scope]++;
+    m_depth++;
+    m_openScopes.push_back(scope);
+    return true;
+}
+
+void FrameProfiler::end(uint16 scope, ticks_t start, ticks_t end)
+{
+    m_depth--;
+    m_scopeNesting[scope]--;
+    m_openScopes.pop_back();
+
+    // the frame may have been closed by disabling the profiler from inside this scope
+    if(!m_inFrame)
+        return;
+
+    Frame& frame = m_frames[m_currentFrame];
+    if(frame.events.size() >= MAX_EVENTS_PER_FRAME) {
+        m_dropped++;
+        return;
+    }
+
+    Event event;
+    event.scope = scope;
+    event.depth = m_depth;
+    event.recursive = m_scopeNesting[scope] > 0;
+    event.start = std::max<ticks_t>(start - frame.start, 0);
+    event.duration = end - start;
+    frame.events.push_back(event);
+}
+
+std::map<std::string, std::map<std::string, double>> FrameProfiler::getSummary()
+{
+    std::map<std::string, std::map<std::string, double>> ret;
+    if(m_recordedFrames == 0)
+        return ret;
+
+    const size_t scopes = m_scopeNames.size();
+    std::vector<uint64> totalMicros(scopes, 0);
+    std::vector<uint64> maxMicros(scopes, 0);
+    std::vector<uint64> calls(scopes, 0);
+    std::vector<uint64> frameMicros(scopes);
+    uint64 totalFrameMicros = 0;
+
+    for(int i = 0; i < m_recordedFrames; ++i) {
+        const Frame& frame = m_frames[i];
+        totalFrameMicros += frame.duration;
+
+        std::fill(frameMicros.begin(), frameMicros.end(), 0);
+        for(const Event& event : frame.events) {
+            calls[event.scope]++;
+            if(!event.recursive)
+                frameMicros[event.scope] += event.duration;
+        }
+
+        for(size_t scope = 0; scope < scopes; ++scope) {
+            totalMicros[scope] += frameMicros[scope];
+            maxMicros[scope] = std::max<uint64>(maxMicros[scope], frameMicros[scope]);
+        }
+    }
+
+    for(size_t scope = 0; scope < scopes; ++scope) {
+        if(calls[scope] == 0)
+            continue;
+
+        std::map<std::string, double>& entry = ret[m_scopeNames[scope]];
+        entry["calls"] = calls[scope] / (double)m_recordedFrames;
+        entry["avgMicros"] = totalMicros[scope] / (double)m_recordedFrames;
+        entry["maxMicros"] = maxMicros[scope];
+        entry["percent"] = totalFrameMicros > 0 ? totalMicros[scope] * 100.0 / totalFrameMicros : 0;
+    }
+    return ret;
+}
+
+std::map<std::string, double> FrameProfiler::getFrameStats()
+{
+    std::map<std::string, double> ret;
+    uint64 totalMicros = 0;
+    uint64 maxMicros = 0;
+    for(int i = 0; i < m_recordedFrames; ++i) {
+        totalMicros += m_frames[i].duration;
+        maxMicros = std::max<uint64>(maxMicros, m_frames[i].duration);
+    }
+
+    ret["frames"] = m_recordedFrames;
+    ret["avgMicros"] = m_recordedFrames > 0 ? totalMicros / (double)m_recordedFrames : 0;
+    ret["maxMicros"] = maxMicros;
+    ret["lastMicros"] = m_recordedFrames > 0 ? m_frames[(m_currentFrame + MAX_FRAMES - 1) % MAX_FRAMES].duration : 0;
+    ret["droppedEvents"] = m_dropped;
+    return ret;
+}
+
+std::string FrameProfiler::getOpenScopes()
+{
+    std::string ret;
+    if(!m_inFrame)
+        return ret;
+
+    ret = "frame";
+    for(const uint16 scope : m_openScopes) {
+        ret += ';';
+        ret += m_scopeNames[scope];
+    }
+    return ret;
+}
+
+bool FrameProfiler::exportChromeTrace(const std::string& fileName)
+{
+    // oldest frame first, timestamps relative to it so the trace viewer starts at zero
+    const int first = m_recordedFrames < MAX_FRAMES ? 0 : m_currentFrame;
+    const ticks_t origin = m_recordedFrames > 0 ? m_frames[first].start : 0;
+
+    std::stringstream ss;
+    ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool separator = false;
+    auto writeEvent = [&](const std::string& name, ticks_t start, ticks_t duration) {
+        if(separator)
+            ss << ',';
+        separator = true;
+        ss << "\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << start << ",\"dur\":" << duration << '}';
+    };
+
+    for(int i = 0; i < m_recordedFrames; ++i) {
+        const Frame& frame = m_frames[(first + i) % MAX_FRAMES];
+        const ticks_t frameStart = frame.start - origin;
+        writeEvent("frame", frameStart, frame.duration);
+        for(const Event& event : frame.events)
+            writeEvent(m_scopeNames[event.scope], frameStart + event.start, event.duration);
+    }
+    ss << "\n]}\n";
+    return g_resources.writeFileContents(fileName, ss.str());
+}
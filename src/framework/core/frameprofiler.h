@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include "declarations.h"
+#include <framework/stdext/time.h>
+#include <thread>
+
+// per subsystem timings of the last frames, scopes are only compiled in with FRAME_PROFILER
+class FrameProfiler
+{
+public:
+    enum {
+        MAX_FRAMES = 300,
+        MAX_EVENTS_PER_FRAME = 4096,
+        MAX_SCOPES = 256
+    };
+
+    struct Event {
+        uint16 scope;
+        uint16 depth;
+        bool recursive; // the same scope was already open, it is not counted twice
+        uint32 start; // microseconds since the frame began
+        uint32 duration;
+    };
+
+    struct Frame {
+        ticks_t start = 0;
+        ticks_t duration = 0;
+        std::vector<Event> events;
+    };
+
+    // measures the enclosing block of the main thread, nested scopes keep their depth
+    class Scope
+    {
+    public:
+        Scope(uint16 scope);
+        ~Scope();
+
+    private:
+        bool m_active;
+        uint16 m_scope;
+        ticks_t m_start;
+    };
+
+    FrameProfiler();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() { return m_enabled; }
+    bool isAvailable();
+    void reset();
+
+    uint16 registerScope(const std::string& name);
+
+    void beginFrame();
+    void endFrame();
+
+    // per scope table with calls, avgMicros and maxMicros per frame over the recorded frames
+    std::map<std::string, std::map<std::string, double>> getSummary();
+    std::map<std::string, double> getFrameStats();
+    bool exportChromeTrace(const std::string& fileName);
+    // names of the scopes open right now, outermost first and separated by ';'
+    std::string getOpenScopes();
+
+private:
+    bool begin(uint16 scope);
+    void end(uint16 scope, ticks_t start, ticks_t end);
+
+    bool m_enabled = false;
+    bool m_inFrame = false;
+    uint16 m_depth = 0;
+    uint64 m_dropped = 0;
+    int m_currentFrame = 0;
+    int m_recordedFrames = 0;
+    std::thread::id m_mainThreadId;
+    std::vector<std::string> m_scopeNames;
+    std::vector<uint16> m_openScopes;
+    std::array<uint16, MAX_SCOPES> m_scopeNesting;
+    std::array<Frame, MAX_FRAMES> m_frames;
+};
+
+extern FrameProfiler g_frameProfiler;
+
+inline FrameProfiler::Scope::Scope(uint16 scope) : m_scope(scope), m_start(0)
+{
+    m_active = g_frameProfiler.begin(scope);
+    if(m_active)
+        m_start = stdext::micros();
+}
+
+inline FrameProfiler::Scope::~Scope()
+{
+    if(m_active)
+        g_frameProfiler.end(m_scope, m_start, stdext::micros());
+}
+
+#define FRAME_PROFILER_CONCAT_(a, b) a##b
+#define FRAME_PROFILER_CONCAT(a, b) FRAME_PROFILER_CONCAT_(a, b)
+
+#ifdef FRAME_PROFILER
+#define PROFILE_SCOPE(name) \
+    static const uint16 FRAME_PROFILER_CONCAT(profileScopeId, __LINE__) = g_frameProfiler.registerScope(name); \
+    FrameProfiler::Scope FRAME_PROFILER_CONCAT(profileScope, __LINE__)(FRAME_PROFILER_CONCAT(profileScopeId, __LINE__))
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+#endif
@@ -23,11 +23,17 @@
 #include "graphicalapplication.h"
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/frameprofiler.h>
+#include <framework/core/actiontracer.h>
+#include <framework/core/stats.h>
 #include <framework/platform/platformwindow.h>
 #include <framework/ui/uimanager.h>
+#include <framework/ui/uirendercache.h>
 #include <framework/graphics/graphics.h>
 #include <framework/graphics/particlemanager.h>
 #include <framework/graphics/texturemanager.h>
+#include <framework/graphics/textureatlas.h>
+#include <framework/graphics/screencapture.h>
 #include <framework/graphics/painter.h>
 #include <framework/input/mouse.h>
 #include <framework/graphics/framebuffermanager.h>
@@ -39,6 +45,10 @@
 #include <framework/sound/soundmanager.h>
 #endif
 
+#ifdef FW_NET
+#include <framework/net/connection.h>
+#endif
+
 GraphicalApplication g_app;
 
 void GraphicalApplication::init(std::vector<std::string>& args)
@@ -46,6 +56,7 @@ void GraphicalApplication::init(std::vector<std::string>& args)
     Application::init(args);
 
     // setup platform window
+    beginStartupPhase("window");
     g_window.init();
     g_window.hide();
     g_window.setOnResize([this](auto&& PH1) { resize(std::forward<decltype(PH1)>(PH1)); });
@@ -53,6 +64,7 @@ void GraphicalApplication::init(std::vector<std::string>& args)
     g_window.setOnClose([this] { close(); });
 
     m_foregroundFramed = g_drawPool.createPoolF(PoolType::FOREGROUND);
+    g_uiRenderCache.init();
 
     g_mouse.init();
 
@@ -60,6 +72,7 @@ void GraphicalApplication::init(std::vector<std::string>& args)
     g_ui.init();
 
     // initialize graphics
+    beginStartupPhase("graphics");
     g_graphics.init();
 
     // fire first resize event
@@ -67,6 +80,7 @@ void GraphicalApplication::init(std::vector<std::string>& args)
 
 #ifdef FW_SOUND
     // initialize sound
+    beginStartupPhase("sound");
     g_sounds.init();
 #endif
 
@@ -101,6 +115,7 @@ void GraphicalApplication::terminate()
 
     // terminate graphics
     m_foregroundFramed = nullptr;
+    g_uiRenderCache.terminate();
     g_drawPool.terminate();
     g_graphics.terminate();
     g_window.terminate();
@@ -116,6 +131,7 @@ void GraphicalApplication::run()
     g_clock.update();
 
     // run the first poll
+    beginStartupPhase("first frame");
     poll();
     g_clock.update();
 
@@ -128,36 +144,96 @@ void GraphicalApplication::run()
 
     g_lua.callGlobalField("g_app", "onRun");
 
+    // lua collects in the idle time between frames instead of whenever its allocator decides
+    g_lua.setGcPacingEnabled(true);
+
     while(!m_stopping) {
+        g_frameProfiler.beginFrame();
+        g_stats.beginFrame();
+        m_backgroundFrameCounter.beginFrameWork();
+        g_ui.nextFrame();
+
         // poll all events before rendering
         poll();
 
+        if(m_idleMode)
+            updateIdleActivity();
+
         if(!g_window.isVisible()) {
+            // scripts hiding the window before anything was drawn, headless bots for instance
+            if(!isStartupFinished())
+                finishStartup();
+
+            g_lua.stepGarbageCollector(0);
+            g_frameProfiler.endFrame();
+
             // sleeps until next poll to avoid massive cpu usage
-            stdext::millisleep(POLL_CYCLE_DELAY + 1);
+            if(m_idleMode)
+                waitIdle(IDLE_MAX_WAIT);
+            else
+                stdext::millisleep(POLL_CYCLE_DELAY + 1);
             g_clock.update();
             continue;
         }
 
+        m_backgroundFrameCounter.setBackgrounded(!g_window.hasFocus());
+
         // the screen consists of two panes
         // background pane - high updated and animated pane (where the game are stuff happens)
         // foreground pane - steady pane with few animated stuff (UI)
-        if(m_backgroundFrameCounter.shouldProcessNextFrame()) {
+        if(m_backgroundFrameCounter.shouldProcessNextFrame() && !shouldSkipIdleFrame()) {
             m_backgroundFrameCounter.processNextFrame();
+            m_idleActivity = false;
+            m_idleFrameTimer.restart();
 
             if(m_mustRepaint && foregroundCanUpdate()) {
+                // without framebuffer objects the texture is copied back from the screen, it can't be updated in parts
+                const Rect screenRect(Point(), g_window.getSize());
+                if(m_repaintAll || !g_graphics.canUseFBO())
+                    m_repaintRects.assign(1, screenRect);
+
                 g_drawPool.use(m_foregroundFramed);
-                g_ui.render(Fw::ForegroundPane);
+                for(const Rect& rect : m_repaintRects) {
+                    const Rect dirtyRect = screenRect.intersection(rect);
+                    if(!dirtyRect.isValid())
+                        continue;
+
+                    // outside the dirty rects the framebuffer keeps what it already holds
+                    g_drawPool.setClipRect(dirtyRect);
+                    g_drawPool.addAction([]() {glDisable(GL_BLEND); });
+                    g_drawPool.addFilledRect(dirtyRect, Color::alpha);
+                    g_drawPool.addAction([]() {glEnable(GL_BLEND); });
+                    g_ui.render(Fw::ForegroundPane, dirtyRect);
+                }
+
+                m_mustRepaint = false;
+                m_repaintAll = false;
+                m_repaintRects.clear();
                 m_refreshTime.restart();
             }
 
             g_ui.render(Fw::BackgroundPane);
 
-            // Draw All Pools
+            // widget renditions that changed while recording, the cache pool is drawn before the foreground samples it
+            g_uiRenderCache.flush();
+
+            // recording is done, hand the frame over and submit it
+            g_drawPool.swapFrames();
             g_drawPool.draw();
 
+            // queue screenshot reads of the finished frame
+            g_screenCapture.readFrame();
+
+            m_backgroundFrameCounter.frameRendered();
+
             // update screen pixels
             g_window.swapBuffers();
+            m_backgroundFrameCounter.frameSubmitted();
+            if(g_actionTracer.isEnabled())
+                g_actionTracer.onFramePresented();
+
+            if(!isStartupFinished())
+                finishStartup();
         }
 
         // only update the current time once per frame to gain performance
@@ -166,17 +242,35 @@ void GraphicalApplication::run()
         if(m_backgroundFrameCounter.update())
             g_lua.callGlobalField("g_app", "onFps", m_backgroundFrameCounter.getLastFps());
 
-        const int sleepMicros = m_backgroundFrameCounter.getMaximumSleepMicros();
-        if(sleepMicros >= AdaptativeFrameCounter::MINIMUM_MICROS_SLEEP)
-            stdext::microsleep(sleepMicros);
+        // half of the idle time may go to lua garbage collection, the rest is slept
+        int sleepMicros = m_backgroundFrameCounter.getMaximumSleepMicros();
+        sleepMicros -= g_lua.stepGarbageCollector(std::max<int>(sleepMicros / 2, 0));
+
+        // idle time is not part of the frame
+        g_frameProfiler.endFrame();
+
+        if(m_idleMode && !m_idleActivity)
+            waitIdle(m_idleFrameDelay > 0 ? std::max<int>(m_idleFrameDelay - m_idleFrameTimer.ticksElapsed(), 0) : IDLE_MAX_WAIT);
+        else if(sleepMicros >= m_backgroundFrameCounter.getMinimumSleepMicros())
+            stdext::precisesleep(sleepMicros);
     }
 
+    g_lua.setGcPacingEnabled(false);
+
     m_stopping = false;
     m_running = false;
 }
 
 void GraphicalApplication::poll()
 {
+    PROFILE_SCOPE("app.poll");
+
+#ifdef FW_NET
+    // hand over what the network thread received before input and ui get to it
+    if(Connection::isNetworkThreadEnabled())
+        Connection::poll();
+#endif
+
 #ifdef FW_SOUND
     g_sounds.poll();
 #endif
@@ -185,8 +279,49 @@ void GraphicalApplication::poll()
     g_window.poll();
     g_particles.poll();
     g_textures.poll();
+    g_atlas.poll();
+    g_screenCapture.poll();
 
     Application::poll();
+
+    // children added by the events above are laid out once, right before drawing
+    g_ui.updatePendingLayouts();
+}
+
+void GraphicalApplication::updateIdleActivity()
+{
+    // anything executed by the poll may have changed what is on screen
+    const uint64 eventCount = g_dispatcher.getExecutedEventCount();
+    uint64 handlerCount = 0;
+#ifdef FW_NET
+    handlerCount = Connection::getPolledHandlerCount();
+#endif
+    if(eventCount != m_idleEventCount || handlerCount != m_idleHandlerCount || m_mustRepaint)
+        m_idleActivity = true;
+    m_idleEventCount = eventCount;
+    m_idleHandlerCount = handlerCount;
+}
+
+bool GraphicalApplication::shouldSkipIdleFrame()
+{
+    if(!m_idleMode || m_idleActivity)
+        return false;
+    return m_idleFrameDelay == 0 || m_idleFrameTimer.ticksElapsed() < m_idleFrameDelay;
+}
+
+void GraphicalApplication::waitIdle(int maxDelay)
+{
+    g_clock.update();
+    int timeout = g_dispatcher.getNextEventDelay(maxDelay);
+
+#ifdef FW_NET
+    // without the network thread sockets are only read by polling them
+    if(!Connection::isNetworkThreadEnabled())
+        timeout = std::min<int>(timeout, POLL_CYCLE_DELAY);
+#endif
+
+    if(timeout > 0)
+        g_window.waitEvents(timeout);
 }
 
 void GraphicalApplication::close()
@@ -205,12 +340,43 @@ void GraphicalApplication::resize(const Size& size)
 
     m_foregroundFramed->resize(size);
 
+    repaint();
+}
+
+void GraphicalApplication::repaint(const Rect& rect)
+{
+    if(!rect.isValid())
+        return;
+
     m_mustRepaint = true;
+    if(m_repaintAll)
+        return;
+
+    // overlapping rects are merged, past the limit everything collapses into the bounding rect
+    for(Rect& dirtyRect : m_repaintRects) {
+        if(dirtyRect.intersects(rect)) {
+            dirtyRect = dirtyRect.united(rect);
+            return;
+        }
+    }
+
+    if(m_repaintRects.size() < MAX_REPAINT_RECTS) {
+        m_repaintRects.push_back(rect);
+        return;
+    }
+
+    Rect boundingRect = rect;
+    for(const Rect& dirtyRect : m_repaintRects)
+        boundingRect = boundingRect.united(dirtyRect);
+    m_repaintRects.assign(1, boundingRect);
 }
 
 void GraphicalApplication::inputEvent(const InputEvent& event)
 {
+    m_backgroundFrameCounter.wakeUp();
+    m_idleActivity = true;
     m_onInputEvent = true;
+    ActionTracer::InputScope inputScope(event.timestamp);
     g_ui.inputEvent(event);
     m_onInputEvent = false;
 }
@@ -31,7 +31,10 @@
 class GraphicalApplication : public Application
 {
     enum {
-        POLL_CYCLE_DELAY = 10
+        POLL_CYCLE_DELAY = 10,
+        MAX_REPAINT_RECTS = 8,
+        // longest idle wait without any scheduled event, input or network wake up
+        IDLE_MAX_WAIT = 1000
     };
 
 public:
@@ -42,13 +45,27 @@ public:
     void poll() override;
     void close() override;
 
-    void repaint() { m_mustRepaint = true; }
+    void repaint() { m_mustRepaint = true; m_repaintAll = true; }
+    // only the widgets intersecting the dirty rects are redrawn on the next foreground update
+    void repaint(const Rect& rect);
 
     void setBackgroundPaneMaxFps(int maxFps) { m_backgroundFrameCounter.setMaxFps(maxFps); }
 
     int getBackgroundPaneFps() { return m_backgroundFrameCounter.getLastFps(); }
     int getBackgroundPaneMaxFps() { return m_backgroundFrameCounter.getMaxFps(); }
 
+    void setFramePacingMode(int mode) { m_backgroundFrameCounter.setPacingMode(static_cast<AdaptativeFrameCounter::PacingMode>(stdext::clamp<int>(mode, 0, AdaptativeFrameCounter::PacingVariableRefresh))); }
+    int getFramePacingMode() { return m_backgroundFrameCounter.getPacingMode(); }
+    double getFrameTimeVariance() { return m_backgroundFrameCounter.getFrameTimeVariance(); }
+    ticks_t getFrameWorkMicros() { return m_backgroundFrameCounter.getFrameWorkMicros(); }
+
+    // idle mode blocks on window events, network wake ups and the next scheduled event instead of polling,
+    // frames are only drawn when something happened or, for animations, every idle frame delay milliseconds
+    void setIdleModeEnabled(bool enabled) { m_idleMode = enabled; m_idleActivity = true; }
+    bool isIdleModeEnabled() { return m_idleMode; }
+    void setIdleFrameDelay(int delay) { m_idleFrameDelay = std::max<int>(delay, 0); }
+    int getIdleFrameDelay() { return m_idleFrameDelay; }
+
     bool isOnInputEvent() { return m_onInputEvent; }
 
 protected:
@@ -57,9 +74,22 @@ protected:
 
 private:
     bool foregroundCanUpdate() { return m_mustRepaint && m_refreshTime.ticksElapsed() >= 16; }
+    void updateIdleActivity();
+    bool shouldSkipIdleFrame();
+    void waitIdle(int maxDelay);
 
     bool m_onInputEvent{ false },
-        m_mustRepaint{ false };
+        m_mustRepaint{ false },
+        m_repaintAll{ false },
+        m_idleMode{ false },
+        m_idleActivity{ true };
+
+    int m_idleFrameDelay{ 200 };
+    uint64 m_idleEventCount{ 0 },
+        m_idleHandlerCount{ 0 };
+    Timer m_idleFrameTimer;
+
+    std::vector<Rect> m_repaintRects;
 
     Timer m_refreshTime;
 
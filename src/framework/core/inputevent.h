@@ -41,6 +41,7 @@ struct InputEvent {
         keyText = "";
         autoRepeatTicks = 0;
         mouseMoved = Point();
+        timestamp = stdext::micros();
     };
 
     Fw::InputEventType type;
@@ -52,6 +53,7 @@ struct InputEvent {
     Point mousePos;
     Point mouseMoved;
     int autoRepeatTicks;
+    ticks_t timestamp; // when the platform window picked the event up
 };
 
 #endif
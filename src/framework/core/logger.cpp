@@ -21,7 +21,6 @@
  */
 
 #include "logger.h"
-#include "eventdispatcher.h"
 
  //#include <boost/regex.hpp>
 #include <framework/core/resourcemanager.h>
@@ -37,13 +36,40 @@ Logger g_logger;
 namespace
 {
     const std::string s_logPrefixes[] = { "", "", "WARNING: ", "ERROR: ", "FATAL ERROR: " };
-    bool s_ignoreLogs = false;
+    std::atomic<bool> s_ignoreLogs{false};
 }
 
-void Logger::log(Fw::LogLevel level, const std::string& message)
+Logger::~Logger()
+{
+    terminate();
+}
+
+void Logger::init()
+{
+    if(m_running)
+        return;
+    m_running = true;
+    m_writerThread = std::thread([this] { writerLoop(); });
+}
+
+void Logger::terminate()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    if(m_running) {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_running = false;
+        }
+        m_wakeCondition.notify_one();
+    }
+    if(m_writerThread.joinable())
+        m_writerThread.join();
+
+    // whatever was pushed while the writer was stopping
+    processQueue();
+}
 
+void Logger::log(Fw::LogLevel level, const std::string& message)
+{
 #ifdef NDEBUG
     if(level == Fw::LogDebug)
         return;
@@ -52,57 +78,127 @@ void Logger::log(Fw::LogLevel level, const std::string& message)
     if(s_ignoreLogs)
         return;
 
-    std::string outmsg = s_logPrefixes[level] + message;
-
-    /*
-#if !defined(NDEBUG) && !defined(WIN32)
-    // replace paths for improved debug with vim
-    std::stringstream tmp;
-    boost::smatch m;
-    boost::regex e ("/[^ :]+");
-    while(boost::regex_search(outmsg,m,e)) {
-        tmp << m.prefix().str();
-        tmp << g_resources.getRealDir(m.str()) << m.str();
-        outmsg = m.suffix().str();
-    }
-    if(!tmp.str().empty())
-        outmsg = tmp.str();
+    QueuedMessage* node = new QueuedMessage{level, s_logPrefixes[level] + message, (std::size_t)std::time(nullptr), nullptr};
+    node->next = m_queueHead.load(std::memory_order_relaxed);
+    while(!m_queueHead.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+
+    if(level == Fw::LogFatal) {
+        // nothing may be lost, stop the writer and drain everything on this thread before exiting
+        s_ignoreLogs = true;
+        terminate();
+#ifdef FW_GRAPHICS
+        g_window.displayFatalError(message);
 #endif
-    */
+        exit(-1);
+    }
 
-    std::cout << outmsg << std::endl;
+    if(!m_running)
+        processQueue();
+    else if(level >= Fw::LogError)
+        m_wakeCondition.notify_one();
+}
 
-    if(m_outFile.good()) {
-        m_outFile << outmsg << std::endl;
-        m_outFile.flush();
+void Logger::writerLoop()
+{
+    while(m_running) {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wakeCondition.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL), [this] { return !m_running; });
+        }
+        processQueue();
     }
+}
 
-    std::size_t now = std::time(nullptr);
-    m_logMessages.emplace_back(level, outmsg, now);
-    if(m_logMessages.size() > MAX_LOG_HISTORY)
-        m_logMessages.pop_front();
+void Logger::processQueue()
+{
+    std::lock_guard<std::mutex> lock(m_writerMutex);
 
-    if(m_onLog) {
-        // schedule log callback, because this callback can run lua code that may affect the current state
-        g_dispatcher.addEvent([=] {
-            if(m_onLog)
-                m_onLog(level, outmsg, now);
-        });
+    QueuedMessage* head = m_queueHead.exchange(nullptr, std::memory_order_acquire);
+
+    // the stack holds the newest message first
+    QueuedMessage* ordered = nullptr;
+    while(head) {
+        QueuedMessage* next = head->next;
+        head->next = ordered;
+        ordered = head;
+        head = next;
     }
 
-    if(level == Fw::LogFatal) {
-#ifdef FW_GRAPHICS
-        g_window.displayFatalError(message);
-#endif
-        s_ignoreLogs = true;
-        exit(-1);
+    const bool wrote = ordered || m_repeats > 0;
+    while(ordered) {
+        QueuedMessage* next = ordered->next;
+        if(ordered->level == m_lastLevel && ordered->message == m_lastMessage &&
+           stdext::millis() - m_lastWriteTime < DUPLICATE_WINDOW)
+            m_repeats++;
+        else
+            write(ordered->level, ordered->message, ordered->when);
+        delete ordered;
+        ordered = next;
+    }
+
+    if(m_repeats > 0 && stdext::millis() - m_lastWriteTime >= DUPLICATE_WINDOW)
+        flushRepeats();
+
+    // one flush per batch instead of one per message
+    if(wrote) {
+        std::cout.flush();
+        if(m_outFile.good())
+            m_outFile.flush();
     }
 }
 
-void Logger::logFunc(Fw::LogLevel level, const std::string& message, std::string prettyFunction)
+void Logger::write(Fw::LogLevel level, const std::string& message, std::size_t when)
+{
+    flushRepeats();
+
+    std::cout << message << '\n';
+    if(m_outFile.good())
+        m_outFile << message << '\n';
+
+    m_lastMessage = message;
+    m_lastLevel = level;
+    m_lastWriteTime = stdext::millis();
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pendingMessages.emplace_back(level, message, when);
+    if(m_pendingMessages.size() > MAX_LOG_HISTORY)
+        m_pendingMessages.pop_front();
+}
+
+void Logger::flushRepeats()
+{
+    if(m_repeats <= 0)
+        return;
+
+    int repeats = m_repeats;
+    m_repeats = 0;
+    // the summary line itself must not be merged with the next identical message
+    write(m_lastLevel, stdext::format("%s (repeated %d more times)", m_lastMessage, repeats), std::time(nullptr));
+    m_lastMessage.clear();
+}
+
+void Logger::poll()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::deque<LogMessage> messages;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        if(m_pendingMessages.empty())
+            return;
+        messages.swap(m_pendingMessages);
+    }
+
+    // callbacks can run lua code that logs again, those messages arrive on a later frame
+    for(const LogMessage& logMessage : messages) {
+        m_logMessages.push_back(logMessage);
+        if(m_onLog)
+            m_onLog(logMessage.level, logMessage.message, logMessage.when);
+    }
+    while(m_logMessages.size() > MAX_LOG_HISTORY)
+        m_logMessages.pop_front();
+}
 
+void Logger::logFunc(Fw::LogLevel level, const std::string& message, std::string prettyFunction)
+{
     prettyFunction = prettyFunction.substr(0, prettyFunction.find_first_of('('));
     if(prettyFunction.find_last_of(' ') != std::string::npos)
         prettyFunction = prettyFunction.substr(prettyFunction.find_last_of(' ') + 1);
@@ -121,8 +217,6 @@ void Logger::logFunc(Fw::LogLevel level, const std::string& message, std::string
 
 void Logger::fireOldMessages()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-
     if(m_onLog) {
         for(const LogMessage& logMessage : m_logMessages) {
             m_onLog(logMessage.level, logMessage.message, logMessage.when);
@@ -132,12 +226,14 @@ void Logger::fireOldMessages()
 
 void Logger::setLogFile(const std::string& file)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-
-    m_outFile.open(stdext::utf8_to_latin1(file).c_str(), std::ios::out | std::ios::app);
-    if(!m_outFile.is_open() || !m_outFile.good()) {
-        g_logger.error(stdext::format("Unable to save log to '%s'", file));
-        return;
+    bool opened;
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        m_outFile.open(stdext::utf8_to_latin1(file).c_str(), std::ios::out | std::ios::app);
+        opened = m_outFile.is_open() && m_outFile.good();
+        if(opened)
+            m_outFile.flush();
     }
-    m_outFile.flush();
+    if(!opened)
+        g_logger.error(stdext::format("Unable to save log to '%s'", file));
 }
@@ -26,6 +26,7 @@
 #include "../global.h"
 
 #include <framework/stdext/thread.h>
+#include <atomic>
 #include <fstream>
 
 struct LogMessage {
@@ -39,12 +40,30 @@ struct LogMessage {
 class Logger
 {
     enum {
-        MAX_LOG_HISTORY = 1000
+        MAX_LOG_HISTORY = 1000,
+        FLUSH_INTERVAL = 100, // ms between writer thread wakes
+        DUPLICATE_WINDOW = 1000 // ms an identical message is counted instead of written
     };
 
     typedef std::function<void(Fw::LogLevel, const std::string&, int64)> OnLogCallback;
 
+    // intrusive node of the multi producer single consumer queue
+    struct QueuedMessage {
+        Fw::LogLevel level;
+        std::string message;
+        std::size_t when;
+        QueuedMessage* next;
+    };
+
 public:
+    ~Logger();
+
+    // starts the background writer, messages logged while it is not running are written synchronously
+    void init();
+    void terminate();
+    // delivers messages written since the last frame to the onLog callback, main thread only
+    void poll();
+
     void log(Fw::LogLevel level, const std::string& message);
     void logFunc(Fw::LogLevel level, const std::string& message, std::string prettyFunction);
 
@@ -59,10 +78,34 @@ public:
     void setOnLog(const OnLogCallback& onLog) { m_onLog = onLog; }
 
 private:
+    void writerLoop();
+    void processQueue();
+    void write(Fw::LogLevel level, const std::string& message, std::size_t when);
+    void flushRepeats();
+
+    // producers push with a single compare and swap, the consumer takes the whole stack at once
+    std::atomic<QueuedMessage*> m_queueHead{nullptr};
+
+    // consumer state, only touched while holding m_writerMutex
+    std::mutex m_writerMutex;
+    std::ofstream m_outFile;
+    std::string m_lastMessage;
+    Fw::LogLevel m_lastLevel = Fw::LogDebug;
+    ticks_t m_lastWriteTime = 0;
+    int m_repeats = 0;
+
+    std::thread m_writerThread;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<bool> m_running{false};
+
+    // written messages waiting for the main thread
+    std::mutex m_pendingMutex;
+    std::deque<LogMessage> m_pendingMessages;
+
+    // main thread only
     std::deque<LogMessage> m_logMessages;
     OnLogCallback m_onLog;
-    std::ofstream m_outFile;
-    std::recursive_mutex m_mutex;
 };
 
 extern Logger g_logger;
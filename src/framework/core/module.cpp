@@ -60,6 +60,8 @@ bool Module::load()
                 stdext::throw_exception(stdext::format("dependency '%s' has failed to load", depName));
         }
 
+        int64 heapBefore = g_lua.getHeapSize();
+
         if(m_sandboxed)
             g_lua.setGlobalEnvironment(m_sandboxEnv);
 
@@ -82,6 +84,8 @@ bool Module::load()
         if(m_sandboxed)
             g_lua.resetGlobalEnvironment();
 
+        m_loadMemory = (int64)g_lua.getHeapSize() - heapBefore;
+        m_fileTimes = collectFileTimes();
         m_loaded = true;
         g_logger.debug(stdext::format("Loaded module '%s'", m_name));
     } catch(stdext::exception& e) {
@@ -103,7 +107,7 @@ bool Module::load()
         ModulePtr dep = g_modules.getModule(modName);
         if(!dep)
             g_logger.error(stdext::format("Unable to find module '%s' required by '%s'", modName, m_name));
-        else if(!dep->isLoaded())
+        else if(!dep->isLoaded() && !dep->isLazy())
             dep->load();
     }
 
@@ -155,6 +159,44 @@ bool Module::reload()
     return load();
 }
 
+int64 Module::getMemoryUsage()
+{
+    return static_cast<int64>(getBudgetStatistics()["memory"]);
+}
+
+int Module::getCpuUsage()
+{
+    return static_cast<int>(getBudgetStatistics()["cpuMicros"]);
+}
+
+std::map<std::string, double> Module::getBudgetStatistics()
+{
+    return g_lua.getModuleBudgetStatistics(m_budget);
+}
+
+bool Module::hasChangedFiles()
+{
+    return !m_directory.empty() && collectFileTimes() != m_fileTimes;
+}
+
+std::map<std::string, ticks_t> Module::collectFileTimes()
+{
+    std::map<std::string, ticks_t> fileTimes;
+    std::deque<std::string> directories = { m_directory };
+    while(!directories.empty()) {
+        const std::string directory = directories.front();
+        directories.pop_front();
+        for(const std::string& fileName : g_resources.listDirectoryFiles(directory)) {
+            const std::string path = directory + "/" + fileName;
+            if(g_resources.directoryExists(path))
+                directories.push_back(path);
+            else
+                fileTimes[path] = g_resources.getFileTime(path);
+        }
+    }
+    return fileTimes;
+}
+
 bool Module::isDependent()
 {
     for(const ModulePtr& module : g_modules.getModules()) {
@@ -197,6 +239,25 @@ void Module::discover(const OTMLNodePtr& moduleNode)
     m_reloadable = moduleNode->valueAt<bool>("reloadable", true);
     m_sandboxed = moduleNode->valueAt<bool>("sandboxed", false);
     m_autoLoadPriority = moduleNode->valueAt<int>("autoload-priority", 9999);
+    m_moduleFile = moduleNode->source();
+    m_directory = m_moduleFile.substr(0, m_moduleFile.find_last_of('/'));
+
+    // memory in kilobytes and lua time in milliseconds per second, the limits fail allocations and skip callbacks
+    m_budget = g_lua.registerModuleBudget(m_directory.substr(m_directory.find_last_of('/') + 1));
+    int64 memoryWarning = 0, memoryLimit = 0;
+    int cpuWarning = 0, cpuLimit = 0;
+    if(OTMLNodePtr node = moduleNode->get("budget")) {
+        memoryWarning = node->valueAt<int64>("memory-warning", 0) * 1024;
+        memoryLimit = node->valueAt<int64>("memory-limit", 0) * 1024;
+        cpuWarning = node->valueAt<int>("cpu-warning", 0) * 1000;
+        cpuLimit = node->valueAt<int>("cpu-limit", 0) * 1000;
+    }
+    g_lua.setModuleBudgetLimits(m_budget, memoryWarning, memoryLimit, cpuWarning, cpuLimit);
+
+    // rediscovering a changed otmod starts from its current lists
+    m_dependencies.clear();
+    m_scripts.clear();
+    m_loadLaterModules.clear();
 
     if(OTMLNodePtr node = moduleNode->get("dependencies")) {
         for(const OTMLNodePtr& tmp : node->children())
@@ -213,6 +274,25 @@ void Module::discover(const OTMLNodePtr& moduleNode)
             m_loadLaterModules.push_back(tmp->value());
     }
 
+    m_loadOnOpcodes.clear();
+    m_loadOnExtendedOpcodes.clear();
+    m_loadOnHotkeys.clear();
+    if(OTMLNodePtr node = moduleNode->get("load-on")) {
+        if(OTMLNodePtr opcodes = node->get("opcodes")) {
+            for(const OTMLNodePtr& tmp : opcodes->children())
+                m_loadOnOpcodes.push_back(tmp->value<int>());
+        }
+        if(OTMLNodePtr opcodes = node->get("extended-opcodes")) {
+            for(const OTMLNodePtr& tmp : opcodes->children())
+                m_loadOnExtendedOpcodes.push_back(tmp->value<int>());
+        }
+        if(OTMLNodePtr hotkeys = node->get("hotkeys")) {
+            for(const OTMLNodePtr& tmp : hotkeys->children())
+                m_loadOnHotkeys.push_back(tmp->value());
+        }
+    }
+    m_lazy = moduleNode->valueAt<bool>("lazy", false);
+
     if(OTMLNodePtr node = moduleNode->get("@onLoad"))
         m_onLoadFunc = std::make_tuple(node->value(), "@" + node->source() + ":[" + node->tag() + "]");
 
@@ -55,6 +55,23 @@ public:
     bool isAutoLoad() { return m_autoLoad; }
     int getAutoLoadPriority() { return m_autoLoadPriority; }
 
+    // lazy modules are skipped by autoload and load-later lists, their load-on triggers load them on first use
+    bool isLazy() { return m_lazy; }
+    std::vector<int> getLoadOnOpcodes() { return m_loadOnOpcodes; }
+    std::vector<int> getLoadOnExtendedOpcodes() { return m_loadOnExtendedOpcodes; }
+    std::vector<std::string> getLoadOnHotkeys() { return m_loadOnHotkeys; }
+    // lua heap growth while running the scripts and onLoad, dependencies excluded
+    int64 getLoadMemory() { return m_loadMemory; }
+    // lua heap held by blocks the module allocated and lua time of the last whole second, in bytes and microseconds
+    int64 getMemoryUsage();
+    int getCpuUsage();
+    // memory, allocations and lua time charged to the module with the thresholds of its otmod budget
+    std::map<std::string, double> getBudgetStatistics();
+    // directory of the otmod file, its files are watched by the incremental reload
+    std::string getDirectory() { return m_directory; }
+    // a file of the module directory was modified, added or removed since the module loaded
+    bool hasChangedFiles();
+
     // @dontbind
     ModulePtr asModule() { return static_self_cast<Module>(); }
 
@@ -63,12 +80,17 @@ protected:
     friend class ModuleManager;
 
 private:
+    std::map<std::string, ticks_t> collectFileTimes();
+
     stdext::boolean<false> m_loaded;
     stdext::boolean<false> m_autoLoad;
     stdext::boolean<false> m_reloadable;
     stdext::boolean<false> m_sandboxed;
+    stdext::boolean<false> m_lazy;
     int m_autoLoadPriority;
     int m_sandboxEnv;
+    int m_budget = 0;
+    int64 m_loadMemory = 0;
     std::tuple<std::string, std::string> m_onLoadFunc;
     std::tuple<std::string, std::string> m_onUnloadFunc;
     std::string m_name;
@@ -76,11 +98,17 @@ private:
     std::string m_author;
     std::string m_website;
     std::string m_version;
+    std::string m_directory;
+    std::string m_moduleFile;
+    std::map<std::string, ticks_t> m_fileTimes;
     std::function<void()> m_loadCallback;
     std::function<void()> m_unloadCallback;
     std::list<std::string> m_dependencies;
     std::list<std::string> m_scripts;
     std::list<std::string> m_loadLaterModules;
+    std::vector<int> m_loadOnOpcodes;
+    std::vector<int> m_loadOnExtendedOpcodes;
+    std::vector<std::string> m_loadOnHotkeys;
 };
 
 #endif
@@ -25,11 +25,14 @@
 
 #include <framework/otml/otml.h>
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/eventdispatcher.h>
 
 ModuleManager g_modules;
 
 void ModuleManager::clear()
 {
+    setAutoReloadInterval(0);
     m_modules.clear();
     m_autoLoadModules.clear();
 }
@@ -39,16 +42,33 @@ void ModuleManager::discoverModules()
     // remove modules that are not loaded
     m_autoLoadModules.clear();
 
+    // the otmod files are read and parsed on the pool
+    std::vector<std::pair<std::string, AsyncTask<OTMLDocumentPtr>>> documents;
     auto moduleDirs = g_resources.listDirectoryFiles("/");
     for(const std::string& moduleDir : moduleDirs) {
         auto moduleFiles = g_resources.listDirectoryFiles("/" + moduleDir);
         for(const std::string& moduleFile : moduleFiles) {
-            if(g_resources.isFileType(moduleFile, "otmod")) {
-                ModulePtr module = discoverModule("/" + moduleDir + "/" + moduleFile);
-                if(module && module->isAutoLoad())
-                    m_autoLoadModules.insert(std::make_pair(module->getAutoLoadPriority(), module));
-            }
+            if(!g_resources.isFileType(moduleFile, "otmod"))
+                continue;
+
+            const std::string file = "/" + moduleDir + "/" + moduleFile;
+            documents.emplace_back(file, g_asyncDispatcher.schedule([file] {
+                std::istringstream in(g_resources.readFileContents(file));
+                return OTMLDocument::parse(in, file);
+            }, AsyncDispatcher::PriorityHigh));
+        }
+    }
+
+    // modules are registered in directory order, as if they were parsed one after another
+    for(const auto& document : documents) {
+        ModulePtr module;
+        try {
+            module = registerModule(document.second.get());
+        } catch(stdext::exception& e) {
+            g_logger.error(stdext::format("Unable to discover module from file '%s': %s", document.first, e.what()));
         }
+        if(module && module->isAutoLoad())
+            m_autoLoadModules.insert(std::make_pair(module->getAutoLoadPriority(), module));
     }
 }
 
@@ -59,33 +79,38 @@ void ModuleManager::autoLoadModules(int maxPriority)
         if(priority > maxPriority)
             break;
         ModulePtr module = pair.second;
-        module->load();
+        if(!module->isLazy())
+            module->load();
     }
 }
 
 ModulePtr ModuleManager::discoverModule(const std::string& moduleFile)
 {
-    ModulePtr module;
     try {
-        OTMLDocumentPtr doc = OTMLDocument::parse(moduleFile);
-        OTMLNodePtr moduleNode = doc->at("Module");
+        return registerModule(OTMLDocument::parse(moduleFile));
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to discover module from file '%s': %s", moduleFile, e.what()));
+    }
+    return nullptr;
+}
 
-        std::string name = moduleNode->valueAt("name");
+ModulePtr ModuleManager::registerModule(const OTMLDocumentPtr& doc)
+{
+    OTMLNodePtr moduleNode = doc->at("Module");
 
-        bool push = false;
-        module = getModule(name);
-        if(!module) {
-            module = ModulePtr(new Module(name));
-            push = true;
-        }
-        module->discover(moduleNode);
+    std::string name = moduleNode->valueAt("name");
 
-        // not loaded modules are always in back
-        if(push)
-            m_modules.push_back(module);
-    } catch(stdext::exception& e) {
-        g_logger.error(stdext::format("Unable to discover module from file '%s': %s", moduleFile, e.what()));
+    bool push = false;
+    ModulePtr module = getModule(name);
+    if(!module) {
+        module = ModulePtr(new Module(name));
+        push = true;
     }
+    module->discover(moduleNode);
+
+    // not loaded modules are always in back
+    if(push)
+        m_modules.push_back(module);
     return module;
 }
 
@@ -105,6 +130,9 @@ void ModuleManager::unloadModules()
 
 void ModuleManager::reloadModules()
 {
+    // files added while the client was running become visible to the reloaded modules
+    g_resources.invalidatePathIndex();
+
     std::deque<ModulePtr> toLoadList;
 
     // unload in the reverse direction, try to unload upto 10 times (because of dependencies)
@@ -122,6 +150,73 @@ void ModuleManager::reloadModules()
         module->load();
 }
 
+int ModuleManager::reloadChangedModules()
+{
+    g_resources.invalidatePathIndex();
+
+    std::set<ModulePtr> changed;
+    for(const ModulePtr& module : m_modules) {
+        if(module->isLoaded() && module->isReloadable() && module->hasChangedFiles())
+            changed.insert(module);
+    }
+    if(changed.empty())
+        return 0;
+
+    // loaded modules are kept most recently loaded first, so every dependant comes before its
+    // dependencies, unloading in that order and loading in the reverse one keeps them valid
+    std::deque<ModulePtr> toReload;
+    for(const ModulePtr& module : m_modules) {
+        if(!module->isLoaded())
+            break;
+
+        bool reload = changed.count(module) > 0;
+        for(const ModulePtr& other : changed) {
+            if(module->hasDependency(other->getName(), true))
+                reload = true;
+        }
+        if(!reload)
+            continue;
+
+        if(!module->isReloadable()) {
+            g_logger.warning(stdext::format("Module '%s' is not reloadable, its changed dependencies stay loaded", module->getName()));
+            return 0;
+        }
+        toReload.push_back(module);
+    }
+
+    for(const ModulePtr& module : toReload)
+        module->unload();
+
+    // a changed otmod is parsed again, the other files are picked up through their caches
+    for(const ModulePtr& module : toReload) {
+        if(!changed.count(module))
+            continue;
+        try {
+            module->discover(OTMLDocument::parse(module->m_moduleFile)->at("Module"));
+        } catch(stdext::exception& e) {
+            g_logger.error(stdext::format("Unable to rediscover module '%s': %s", module->getName(), e.what()));
+        }
+    }
+
+    int reloaded = 0;
+    for(auto it = toReload.rbegin(); it != toReload.rend(); ++it) {
+        if((*it)->load())
+            reloaded++;
+    }
+    return reloaded;
+}
+
+void ModuleManager::setAutoReloadInterval(int interval)
+{
+    if(m_autoReloadEvent) {
+        m_autoReloadEvent->cancel();
+        m_autoReloadEvent = nullptr;
+    }
+
+    if(interval > 0)
+        m_autoReloadEvent = g_dispatcher.cycleEvent([this] { reloadChangedModules(); }, interval);
+}
+
 ModulePtr ModuleManager::getModule(const std::string& moduleName)
 {
     for(const ModulePtr& module : m_modules)
@@ -140,3 +235,13 @@ void ModuleManager::updateModuleLoadOrder(ModulePtr module)
     else
         m_modules.push_back(module);
 }
+
+std::map<std::string, std::map<std::string, double>> ModuleManager::getModuleBudgets()
+{
+    std::map<std::string, std::map<std::string, double>> ret;
+    for(const ModulePtr& module : m_modules) {
+        if(module->isLoaded())
+            ret[module->getName()] = module->getBudgetStatistics();
+    }
+    return ret;
+}
@@ -37,9 +37,16 @@ public:
     void ensureModuleLoaded(const std::string& moduleName);
     void unloadModules();
     void reloadModules();
+    /// Reloads only the loaded modules with changed files and the modules depending on them,
+    /// returns the number of reloaded modules
+    int reloadChangedModules();
+    /// Checks the module files every interval milliseconds and reloads the changed ones, 0 disables it
+    void setAutoReloadInterval(int interval);
 
     ModulePtr getModule(const std::string& moduleName);
     std::deque<ModulePtr> getModules() { return m_modules; }
+    /// Budget statistics of every loaded module keyed by its name, see Module::getBudgetStatistics
+    std::map<std::string, std::map<std::string, double>> getModuleBudgets();
 
 protected:
     void updateModuleLoadOrder(ModulePtr module);
@@ -47,8 +54,11 @@ protected:
     friend class Module;
 
 private:
+    ModulePtr registerModule(const OTMLDocumentPtr& doc);
+
     std::deque<ModulePtr> m_modules;
     std::multimap<int, ModulePtr> m_autoLoadModules;
+    ScheduledEventPtr m_autoReloadEvent;
 };
 
 extern ModuleManager g_modules;
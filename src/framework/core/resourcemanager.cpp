@@ -24,10 +24,12 @@
 #include "filestream.h"
 
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/luaengine/luainterface.h>
 #include <framework/platform/platform.h>
 
 #include <physfs.h>
+#include <fstream>
 
 ResourceManager g_resources;
 
@@ -39,6 +41,7 @@ void ResourceManager::init(const char* argv0)
 
 void ResourceManager::terminate()
 {
+    invalidatePathIndex();
     PHYSFS_deinit();
 }
 
@@ -64,6 +67,7 @@ bool ResourceManager::discoverWorkDir(const std::string& existentFile)
         PHYSFS_unmount(dir.c_str());
     }
 
+    invalidatePathIndex();
     return found;
 }
 
@@ -128,6 +132,7 @@ bool ResourceManager::addSearchPath(const std::string& path, bool pushFront)
         m_searchPaths.push_front(savePath);
     else
         m_searchPaths.push_back(savePath);
+    invalidatePathIndex();
     return true;
 }
 
@@ -135,6 +140,7 @@ bool ResourceManager::removeSearchPath(const std::string& path)
 {
     if(!PHYSFS_unmount(path.c_str()))
         return false;
+    invalidatePathIndex();
     auto it = std::find(m_searchPaths.begin(), m_searchPaths.end(), path);
     assert(it != m_searchPaths.end());
     m_searchPaths.erase(it);
@@ -156,17 +162,123 @@ void ResourceManager::searchAndAddPackages(const std::string& packagesDir, const
 
 bool ResourceManager::fileExists(const std::string& fileName)
 {
-    return (PHYSFS_exists(resolvePath(fileName).c_str()) && !directoryExists(fileName));
+    std::lock_guard<std::mutex> lock(m_pathIndexMutex);
+    const IndexedPath* entry = findIndexedPath(resolvePath(fileName));
+    return entry && !entry->directory;
 }
 
 bool ResourceManager::directoryExists(const std::string& directoryName)
 {
+    std::lock_guard<std::mutex> lock(m_pathIndexMutex);
+    const IndexedPath* entry = findIndexedPath(resolvePath(directoryName));
+    return entry && entry->directory;
+}
+
+void ResourceManager::invalidatePathIndex()
+{
+    std::lock_guard<std::mutex> lock(m_pathIndexMutex);
+    m_pathIndex.clear();
+    m_missingPaths.clear();
+    m_pathIndexValid = false;
+}
+
+ResourceManager::IndexedPath* ResourceManager::findIndexedPath(std::string path)
+{
+    if(path.length() > 1 && path.back() == '/')
+        path.pop_back();
+
+    // a single walk of the merged tree answers every later lookup, including the misses
+    if(!m_pathIndexValid) {
+        m_pathIndexComplete = true;
+        m_pathIndex.emplace("/", IndexedPath{ true, false, std::string() });
+        indexDirectory("/");
+        m_pathIndexValid = true;
+    }
+
+    auto it = m_pathIndex.find(path);
+    if(it != m_pathIndex.end())
+        return &it->second;
+
+    if(m_pathIndexComplete || m_missingPaths.find(path) != m_missingPaths.end())
+        return nullptr;
+
     PHYSFS_Stat stat = {};
-    if(!PHYSFS_stat(resolvePath(directoryName).c_str(), &stat)) {
-        return false;
+    if(!PHYSFS_stat(path.c_str(), &stat)) {
+        m_missingPaths.insert(path);
+        return nullptr;
     }
+    return &m_pathIndex.emplace(path, IndexedPath{ stat.filetype == PHYSFS_FILETYPE_DIRECTORY, false, std::string() }).first->second;
+}
 
-    return stat.filetype == PHYSFS_FILETYPE_DIRECTORY;
+const std::string& ResourceManager::getIndexedRealDir(IndexedPath& entry, const std::string& path)
+{
+    if(!entry.realDirKnown) {
+        const char* realDir = PHYSFS_getRealDir(path.c_str());
+        if(realDir)
+            entry.realDir = realDir;
+        entry.realDirKnown = true;
+    }
+    return entry.realDir;
+}
+
+void ResourceManager::indexDirectory(const std::string& directory)
+{
+    char** files = PHYSFS_enumerateFiles(directory.c_str());
+    if(!files)
+        return;
+
+    for(char** file = files; *file; ++file) {
+        const std::string path = (directory == "/" ? directory : directory + "/") + *file;
+        PHYSFS_Stat stat = {};
+        if(!PHYSFS_stat(path.c_str(), &stat))
+            continue;
+
+        // links may point anywhere, even to a parent, what lies below them is looked up one by one
+        if(stat.filetype == PHYSFS_FILETYPE_SYMLINK)
+            m_pathIndexComplete = false;
+
+        const bool isDirectory = stat.filetype == PHYSFS_FILETYPE_DIRECTORY;
+        m_pathIndex.emplace(path, IndexedPath{ isDirectory, false, std::string() });
+        if(isDirectory)
+            indexDirectory(path);
+    }
+    PHYSFS_freeList(files);
+}
+
+void ResourceManager::indexWrittenPath(const std::string& fileName, bool directory)
+{
+    std::lock_guard<std::mutex> lock(m_pathIndexMutex);
+    if(!m_pathIndexValid)
+        return;
+
+    std::string path = "/" + fileName;
+    stdext::replace_all(path, "//", "/");
+    if(path.length() > 1 && path.back() == '/')
+        path.pop_back();
+
+    // the write dir is only searched after the other paths, the owner of an already indexed path does not change
+    m_pathIndex.emplace(path, IndexedPath{ directory, false, std::string() });
+    m_missingPaths.erase(path);
+    for(size_t pos = path.rfind('/'); pos != std::string::npos && pos > 0; pos = path.rfind('/', pos - 1)) {
+        const std::string parent = path.substr(0, pos);
+        m_pathIndex.emplace(parent, IndexedPath{ true, false, std::string() });
+        m_missingPaths.erase(parent);
+    }
+}
+
+std::string ResourceManager::getNativePath(const std::string& fullPath)
+{
+    std::lock_guard<std::mutex> lock(m_pathIndexMutex);
+    IndexedPath* entry = findIndexedPath(fullPath);
+    if(!entry || entry->directory)
+        return std::string();
+
+    // files inside packages have to be inflated by physfs
+    const std::string& realDir = getIndexedRealDir(*entry, fullPath);
+    if(realDir.empty() || !fs::is_directory(realDir))
+        return std::string();
+
+    return stdext::ends_with(realDir, "/") ? realDir + fullPath.substr(1) : realDir + fullPath;
 }
 
 void ResourceManager::readFileStream(const std::string& fileName, std::iostream& out)
@@ -185,6 +297,18 @@ std::string ResourceManager::readFileContents(const std::string& fileName)
 {
     std::string fullPath = resolvePath(fileName);
 
+    // located files of plain directories skip physfs and its global lock, so the async loaders read in parallel
+    const std::string nativePath = getNativePath(fullPath);
+    if(!nativePath.empty()) {
+        std::ifstream fin(nativePath, std::ios::binary | std::ios::ate);
+        if(fin) {
+            std::string buffer(static_cast<size_t>(fin.tellg()), 0);
+            fin.seekg(0, std::ios::beg);
+            if(fin.read(&buffer[0], buffer.length()))
+                return buffer;
+        }
+    }
+
     PHYSFS_File* file = PHYSFS_openRead(fullPath.c_str());
     if(!file)
         stdext::throw_exception(stdext::format("unable to open file '%s': %s", fullPath, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())));
@@ -197,6 +321,24 @@ std::string ResourceManager::readFileContents(const std::string& fileName)
     return buffer;
 }
 
+void ResourceManager::readFileContentsAsync(const std::string& fileName, const std::function<void(std::string, std::string)>& callback)
+{
+    // relative paths are resolved against the calling script, which only the main thread knows
+    const std::string fullPath = resolvePath(fileName);
+    auto task = g_asyncDispatcher.schedule([fullPath] { return g_resources.readFileContents(fullPath); });
+    task.then_on_main([callback](const std::shared_future<std::string>& future) {
+        std::string contents, error;
+        try {
+            contents = future.get();
+        } catch(stdext::exception& e) {
+            error = e.what();
+        }
+
+        if(callback)
+            callback(contents, error);
+    });
+}
+
 bool ResourceManager::writeFileBuffer(const std::string& fileName, const uchar* data, uint size)
 {
     PHYSFS_file* file = PHYSFS_openWrite(fileName.c_str());
@@ -207,6 +349,7 @@ bool ResourceManager::writeFileBuffer(const std::string& fileName, const uchar*
 
     PHYSFS_writeBytes(file, (void*)data, size);
     PHYSFS_close(file);
+    indexWrittenPath(fileName, false);
     return true;
 }
 
@@ -228,6 +371,31 @@ bool ResourceManager::writeFileContents(const std::string& fileName, const std::
     return writeFileBuffer(fileName, (const uchar*)data.c_str(), data.size());
 }
 
+bool ResourceManager::writeFileContentsAtomic(const std::string& fileName, const std::string& data)
+{
+    // physfs can't rename, the write dir is always a native directory
+    if(m_writeDir.empty())
+        return false;
+
+    const fs::path target = fs::path(m_writeDir) / (stdext::starts_with(fileName, "/") ? fileName.substr(1) : fileName);
+    const fs::path temp = target.string() + ".tmp";
+    {
+        std::ofstream fout(temp.string(), std::ios::binary | std::ios::trunc);
+        if(!fout.write(data.data(), data.size()) || !fout.flush())
+            return false;
+    }
+
+    boost::system::error_code error;
+    fs::rename(temp, target, error);
+    if(error) {
+        fs::remove(temp, error);
+        return false;
+    }
+
+    indexWrittenPath(fileName, false);
+    return true;
+}
+
 FileStreamPtr ResourceManager::openFile(const std::string& fileName)
 {
     std::string fullPath = resolvePath(fileName);
@@ -243,6 +411,7 @@ FileStreamPtr ResourceManager::appendFile(const std::string& fileName)
     PHYSFS_File* file = PHYSFS_openAppend(fileName.c_str());
     if(!file)
         stdext::throw_exception(stdext::format("failed to append file '%s': %s", fileName, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())));
+    indexWrittenPath(fileName, false);
     return FileStreamPtr(new FileStream(fileName, file, true));
 }
 
@@ -251,17 +420,32 @@ FileStreamPtr ResourceManager::createFile(const std::string& fileName)
     PHYSFS_File* file = PHYSFS_openWrite(fileName.c_str());
     if(!file)
         stdext::throw_exception(stdext::format("failed to create file '%s': %s", fileName, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())));
+    indexWrittenPath(fileName, false);
     return FileStreamPtr(new FileStream(fileName, file, true));
 }
 
 bool ResourceManager::deleteFile(const std::string& fileName)
 {
-    return PHYSFS_delete(resolvePath(fileName).c_str()) != 0;
+    const std::string fullPath = resolvePath(fileName);
+    if(PHYSFS_delete(fullPath.c_str()) == 0)
+        return false;
+
+    // another search path may still provide the same file
+    std::lock_guard<std::mutex> lock(m_pathIndexMutex);
+    m_pathIndex.erase(fullPath);
+    PHYSFS_Stat stat = {};
+    if(m_pathIndexValid && PHYSFS_stat(fullPath.c_str(), &stat))
+        m_pathIndex.emplace(fullPath, IndexedPath{ stat.filetype == PHYSFS_FILETYPE_DIRECTORY, false, std::string() });
+    return true;
 }
 
 bool ResourceManager::makeDir(const std::string directory)
 {
-    return PHYSFS_mkdir(directory.c_str());
+    if(!PHYSFS_mkdir(directory.c_str()))
+        return false;
+
+    indexWrittenPath(directory, true);
+    return true;
 }
 
 std::list<std::string> ResourceManager::listDirectoryFiles(const std::string& directoryPath)
@@ -326,11 +510,13 @@ std::string ResourceManager::resolvePath(const std::string& path)
 
 std::string ResourceManager::getRealDir(const std::string& path)
 {
-    std::string dir;
-    const char* cdir = PHYSFS_getRealDir(resolvePath(path).c_str());
-    if(cdir)
-        dir = cdir;
-    return dir;
+    const std::string fullPath = resolvePath(path);
+
+    std::lock_guard<std::mutex> lock(m_pathIndexMutex);
+    IndexedPath* entry = findIndexedPath(fullPath);
+    if(!entry)
+        return std::string();
+    return getIndexedRealDir(*entry, fullPath);
 }
 
 std::string ResourceManager::getRealPath(const std::string& path)
@@ -366,3 +552,17 @@ ticks_t ResourceManager::getFileTime(const std::string& filename)
 {
     return g_platform.getFileModificationTime(getRealPath(filename));
 }
+
+bool ResourceManager::getFileStat(const std::string& filename, ticks_t& modTime, uint64& size)
+{
+    // unlike getFileTime this also works for files inside packages
+    if(!fileExists(filename))
+        return false;
+
+    PHYSFS_Stat stat = {};
+    if(!PHYSFS_stat(resolvePath(filename).c_str(), &stat) || stat.filetype != PHYSFS_FILETYPE_REGULAR)
+        return false;
+    modTime = stat.modtime;
+    size = stat.filesize;
+    return modTime >= 0 && stat.filesize >= 0;
+}
@@ -26,6 +26,7 @@
 #include "declarations.h"
 
 #include <boost/filesystem.hpp>
+#include <unordered_set>
 
 namespace fs = boost::filesystem;
 
@@ -48,13 +49,20 @@ public:
 
     bool fileExists(const std::string& fileName);
     bool directoryExists(const std::string& directoryName);
+    /// Forgets the index of the search paths, files created outside of the client are found after this
+    void invalidatePathIndex();
 
     // @dontbind
     void readFileStream(const std::string& fileName, std::iostream& out);
+    // safe to call from worker threads with absolute paths, files of plain directories are read without physfs
     std::string readFileContents(const std::string& fileName);
+    // reads on the async pool, the callback runs on the main thread with the contents or an error message
+    void readFileContentsAsync(const std::string& fileName, const std::function<void(std::string, std::string)>& callback);
     // @dontbind
     bool writeFileBuffer(const std::string& fileName, const uchar* data, uint size);
     bool writeFileContents(const std::string& fileName, const std::string& data);
+    // writes a temporary file next to the target and renames it over, safe to call from worker threads
+    bool writeFileContentsAtomic(const std::string& fileName, const std::string& data);
     // @dontbind
     bool writeFileStream(const std::string& fileName, std::iostream& in);
 
@@ -79,14 +87,38 @@ public:
     std::string guessFilePath(const std::string& filename, const std::string& type);
     bool isFileType(const std::string& filename, const std::string& type);
     ticks_t getFileTime(const std::string& filename);
+    // @dontbind
+    bool getFileStat(const std::string& filename, ticks_t& modTime, uint64& size);
 
 protected:
     std::vector<std::string> discoverPath(const fs::path& path, bool filenameOnly, bool recursive);
 
 private:
+    struct IndexedPath {
+        bool directory;
+        bool realDirKnown;
+        std::string realDir;
+    };
+
+    // these expect m_pathIndexMutex to be held
+    IndexedPath* findIndexedPath(std::string path);
+    const std::string& getIndexedRealDir(IndexedPath& entry, const std::string& path);
+    void indexDirectory(const std::string& directory);
+
+    void indexWrittenPath(const std::string& fileName, bool directory);
+    std::string getNativePath(const std::string& fullPath);
+
     std::string m_workDir;
     std::string m_writeDir;
     std::deque<std::string> m_searchPaths;
+
+    // every file and directory of the merged search paths, rebuilt lazily after mounts
+    std::unordered_map<std::string, IndexedPath> m_pathIndex;
+    // misses below symbolic links, where the index is not authoritative
+    std::unordered_set<std::string> m_missingPaths;
+    std::mutex m_pathIndexMutex;
+    bool m_pathIndexValid{ false };
+    bool m_pathIndexComplete{ false };
 };
 
 extern ResourceManager g_resources;
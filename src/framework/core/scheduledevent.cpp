@@ -21,6 +21,7 @@
  */
 
 #include "scheduledevent.h"
+#include "eventdispatcher.h"
 
 ScheduledEvent::ScheduledEvent(const std::function<void()>& callback, int delay, int maxCycles) : Event(callback)
 {
@@ -44,6 +45,15 @@ void ScheduledEvent::execute()
     m_cyclesExecuted++;
 }
 
+void ScheduledEvent::cancel()
+{
+    Event::cancel();
+
+    // the wheel lets go of cancelled events right away
+    if(m_wheelSlot >= 0)
+        g_dispatcher.unlinkScheduledEvent(this);
+}
+
 bool ScheduledEvent::nextCycle()
 {
     if(m_callback && !m_canceled && (m_maxCycles == 0 || m_cyclesExecuted < m_maxCycles)) {
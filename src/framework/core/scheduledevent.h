@@ -31,7 +31,8 @@ class ScheduledEvent : public Event
 {
 public:
     ScheduledEvent(const std::function<void()>& callback, int delay, int maxCycles);
-    void execute();
+    void execute() override;
+    void cancel() override;
     bool nextCycle();
 
     int ticks() { return m_ticks; }
@@ -52,6 +53,13 @@ private:
     int m_delay;
     int m_maxCycles;
     int m_cyclesExecuted;
+
+    // position in the dispatcher timer wheel, the slot is -1 while the event is not in the wheel
+    int m_wheelSlot = -1;
+    uint m_wheelIndex = 0;
+    uint64 m_sequence = 0;
+
+    friend class EventDispatcher;
 };
 
 #endif
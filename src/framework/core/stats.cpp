@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "stats.h"
+#include "eventdispatcher.h"
+#include "modulemanager.h"
+#include <framework/luaengine/luainterface.h>
+#include <framework/platform/platform.h>
+
+Stats g_stats;
+
+#ifdef ALLOCATION_TRACKER
+namespace {
+    thread_local int64 t_allocations = 0;
+    // set while a sample is taken, the traceback allocates too
+    thread_local bool t_sampling = false;
+    std::atomic<int> s_sampleInterval{0};
+
+    std::mutex& samplesMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::map<std::string, int64>& samples()
+    {
+        static std::map<std::string, int64> samples;
+        return samples;
+    }
+
+    void sampleAllocation(size_t size)
+    {
+        t_sampling = true;
+        const std::string stack = stdext::format("%d bytes%s", size, g_platform.traceback("", 2, 8));
+        {
+            std::lock_guard<std::mutex> lock(samplesMutex());
+            ++samples()[stack];
+        }
+        t_sampling = false;
+    }
+}
+
+// array, nothrow and sized forms fall back to these, aligned forms keep their own allocations
+void* operator new(size_t size)
+{
+    ++t_allocations;
+    const int interval = s_sampleInterval.load(std::memory_order_relaxed);
+    if(interval > 0 && !t_sampling && t_allocations % interval == 0)
+        sampleAllocation(size);
+
+    if(void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+bool Stats::isAllocationTrackerEnabled() { return true; }
+int64 Stats::getThreadAllocations() { return t_allocations; }
+void Stats::setAllocationSampling(int interval) { s_sampleInterval = std::max<int>(interval, 0); }
+
+std::map<std::string, int64> Stats::getAllocationSamples()
+{
+    std::lock_guard<std::mutex> lock(samplesMutex());
+    return samples();
+}
+
+void Stats::clearAllocationSamples()
+{
+    std::lock_guard<std::mutex> lock(samplesMutex());
+    samples().clear();
+}
+#else
+bool Stats::isAllocationTrackerEnabled() { return false; }
+int64 Stats::getThreadAllocations() { return 0; }
+void Stats::setAllocationSampling(int) {}
+std::map<std::string, int64> Stats::getAllocationSamples() { return {}; }
+void Stats::clearAllocationSamples() {}
+#endif
+
+void Stats::beginFrame()
+{
+    const int64 allocations = getThreadAllocations();
+    m_frameAllocations = allocations - m_frameStartAllocations;
+    m_frameStartAllocations = allocations;
+}
+
+void Stats::terminate()
+{
+    if(m_snapshotEvent) {
+        m_snapshotEvent->cancel();
+        m_snapshotEvent = nullptr;
+    }
+}
+
+void Stats::registerCounter(const std::string& name, Counter* counter)
+{
+    counters().emplace_back(name, counter);
+}
+
+std::vector<std::pair<std::string, Stats::Counter*>>& Stats::counters()
+{
+    static std::vector<std::pair<std::string, Counter*>> counters;
+    return counters;
+}
+
+std::map<std::string, int64> Stats::getObjectCounts()
+{
+    std::map<std::string, int64> ret;
+    for(const auto& it : counters())
+        ret[it.first] = it.second->objects.load(std::memory_order_relaxed);
+    return ret;
+}
+
+std::map<std::string, int64> Stats::getObjectBytes()
+{
+    std::map<std::string, int64> ret;
+    for(const auto& it : counters()) {
+        int64 bytes = it.second->bytes.load(std::memory_order_relaxed);
+        if(bytes != 0)
+            ret[it.first] = bytes;
+    }
+    return ret;
+}
+
+std::map<std::string, int64> Stats::getLuaMemory()
+{
+    std::map<std::string, int64> ret;
+    ret["total"] = g_lua.getHeapSize();
+    for(const ModulePtr& module : g_modules.getModules()) {
+        if(module->isLoaded())
+            ret[module->getName()] = module->getLoadMemory();
+    }
+    return ret;
+}
+
+std::string Stats::getSnapshot()
+{
+    std::stringstream ss;
+    ss << "objects:";
+    for(const auto& it : counters()) {
+        ss << " " << it.first << "=" << it.second->objects.load(std::memory_order_relaxed);
+        int64 bytes = it.second->bytes.load(std::memory_order_relaxed);
+        if(bytes != 0)
+            ss << "(" << bytes / 1024 << "KB)";
+    }
+    ss << " lua=" << g_lua.getHeapSize() / 1024 << "KB";
+    return ss.str();
+}
+
+void Stats::setSnapshotInterval(int interval)
+{
+    m_snapshotInterval = std::max<int>(interval, 0);
+    if(m_snapshotEvent) {
+        m_snapshotEvent->cancel();
+        m_snapshotEvent = nullptr;
+    }
+    if(m_snapshotInterval > 0)
+        m_snapshotEvent = g_dispatcher.cycleEvent([this] { g_logger.info(getSnapshot()); }, m_snapshotInterval);
+}
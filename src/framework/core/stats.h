@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "declarations.h"
+#include <framework/stdext/demangle.h>
+#include <atomic>
+
+// live object and memory counters per subsystem, readable from lua through g_stats
+class Stats
+{
+public:
+    // constant initialized, so objects built during static initialization are counted as well
+    struct Counter {
+        std::atomic<int64> objects{0};
+        std::atomic<int64> bytes{0};
+    };
+
+    // adds a counter to the listings under the given name
+    struct Registration {
+        Registration(const std::string& name, Counter* counter) { registerCounter(name, counter); }
+    };
+
+    void terminate();
+
+    std::map<std::string, int64> getObjectCounts();
+    std::map<std::string, int64> getObjectBytes();
+    // total lua heap plus the heap each loaded module grew while running its scripts and onLoad
+    std::map<std::string, int64> getLuaMemory();
+    std::string getSnapshot();
+
+    // logs a snapshot every interval milliseconds, 0 disables it
+    void setSnapshotInterval(int interval);
+    int getSnapshotInterval() { return m_snapshotInterval; }
+
+    // heap allocations are only counted in builds with ALLOCATION_TRACKER, which replaces the global operator new
+    bool isAllocationTrackerEnabled();
+    void beginFrame();
+    // allocations made by the main thread during the last frame
+    int64 getFrameAllocations() { return m_frameAllocations; }
+    // allocations made by the calling thread so far, the difference of two calls counts a code path
+    int64 getThreadAllocations();
+    // records the stack of one in every interval allocations, 0 disables it
+    void setAllocationSampling(int interval);
+    std::map<std::string, int64> getAllocationSamples();
+    void clearAllocationSamples();
+
+private:
+    static void registerCounter(const std::string& name, Counter* counter);
+    static std::vector<std::pair<std::string, Counter*>>& counters();
+
+    int m_snapshotInterval = 0;
+    ScheduledEventPtr m_snapshotEvent;
+    int64 m_frameAllocations = 0;
+    int64 m_frameStartAllocations = 0;
+};
+
+extern Stats g_stats;
+
+// private base of the counted classes, copies count as new objects
+template<class T>
+class StatsCounted
+{
+protected:
+    StatsCounted() { (void)&s_registration; s_counter.objects++; }
+    StatsCounted(const StatsCounted&) { (void)&s_registration; s_counter.objects++; }
+    StatsCounted& operator=(const StatsCounted&) { return *this; }
+    ~StatsCounted() { s_counter.objects--; }
+
+    static void addStatsBytes(int64 bytes) { s_counter.bytes += bytes; }
+
+private:
+    static Stats::Counter s_counter;
+    static Stats::Registration s_registration;
+};
+
+template<class T>
+Stats::Counter StatsCounted<T>::s_counter;
+
+template<class T>
+Stats::Registration StatsCounted<T>::s_registration(stdext::demangle_type<T>(), &StatsCounted<T>::s_counter);
+
+#endif
@@ -22,31 +22,93 @@
 
 #include "animatedtexture.h"
 #include "graphics.h"
+#include "image.h"
 
-#include <framework/core/eventdispatcher.h>
+#include <framework/core/clock.h>
+
+// frames are padded with a copy of their edge pixels, so filtering never samples the neighbouring frames
+static const int FRAME_PADDING = 1;
+
+// frames used to be advanced by a 16ms poll, shorter delays never showed for less
+static const int MIN_FRAME_DELAY = 16;
 
 AnimatedTexture::AnimatedTexture(const Size& size, std::vector<ImagePtr> frames, std::vector<int> framesDelay, bool buildMipmaps, bool compress)
 {
-    if(!setupSize(size, buildMipmaps))
+    m_currentFrame = 0;
+    m_startTime = g_clock.millis();
+    m_lastUpdate = m_startTime;
+
+    ticks_t end = 0;
+    for(const int delay : framesDelay) {
+        end += std::max<int>(delay, MIN_FRAME_DELAY);
+        m_framesEnd.push_back(end);
+    }
+
+    const Size cellSize = size + Size(FRAME_PADDING * 2);
+    const int columns = std::ceil(std::sqrt(static_cast<double>(frames.size())));
+    const int rows = (frames.size() + columns - 1) / columns;
+    const Size atlasSize(cellSize.width() * columns, cellSize.height() * rows);
+
+    if(std::max<int>(atlasSize.width(), atlasSize.height()) > g_graphics.getMaxTextureSize()) {
+        if(!setupSize(size, buildMipmaps))
+            return;
+
+        for(const auto& frame : frames)
+            m_frames.push_back(new Texture(frame, buildMipmaps, compress));
+
+        m_hasMipmaps = buildMipmaps;
+        m_id = m_frames[0]->getId();
         return;
+    }
+
+    const int bpp = frames[0]->getBpp();
+    const ImagePtr atlas(new Image(atlasSize, bpp));
+    bool transparent = false;
+    for(uint i = 0; i < frames.size(); ++i) {
+        const ImagePtr& frame = frames[i];
+        const Point cell(i % columns * cellSize.width(), i / columns * cellSize.height());
+        m_framesOffset.push_back(cell + Point(FRAME_PADDING));
+        transparent |= frame->hasTransparentPixel();
 
-    for(const auto& frame : frames) {
-        m_frames.push_back(new Texture(frame, buildMipmaps, compress));
+        for(int y = 0; y < cellSize.height(); ++y) {
+            const int srcY = std::clamp<int>(y - FRAME_PADDING, 0, size.height() - 1);
+            for(int x = 0; x < cellSize.width(); ++x) {
+                const int srcX = std::clamp<int>(x - FRAME_PADDING, 0, size.width() - 1);
+                memcpy(atlas->getPixel(cell.x + x, cell.y + y), frame->getPixel(srcX, srcY), bpp);
+            }
+        }
     }
+    atlas->setTransparentPixel(transparent);
 
-    m_framesDelay = framesDelay;
-    m_hasMipmaps = buildMipmaps;
-    m_id = m_frames[0]->getId();
-    m_currentFrame = 0;
-    m_animTimer.restart();
+    uploadPixels(atlas, buildMipmaps, compress);
+    // the draws address a single frame, the atlas is only seen through the transform matrix
+    m_size = size;
+    setupFrame();
 }
 
 AnimatedTexture::~AnimatedTexture()
 {
+    // the id belongs to one of the frames when they have a texture each
+    if(!m_frames.empty())
+        m_id = 0;
+}
+
+uint64 AnimatedTexture::getMemoryUsage()
+{
+    if(m_frames.empty())
+        return Texture::getMemoryUsage();
+
+    uint64 memory = 0;
+    for(const TexturePtr& frame : m_frames)
+        memory += frame->getMemoryUsage();
+    return memory;
 }
 
 bool AnimatedTexture::buildHardwareMipmaps()
 {
+    if(m_frames.empty())
+        return Texture::buildHardwareMipmaps();
+
     if(!g_graphics.canUseHardwareMipmaps())
         return false;
     for(const TexturePtr& frame : m_frames)
@@ -57,6 +119,11 @@ bool AnimatedTexture::buildHardwareMipmaps()
 
 void AnimatedTexture::setSmooth(bool smooth)
 {
+    if(m_frames.empty()) {
+        Texture::setSmooth(smooth);
+        return;
+    }
+
     for(const TexturePtr& frame : m_frames)
         frame->setSmooth(smooth);
     m_smooth = smooth;
@@ -64,19 +131,43 @@ void AnimatedTexture::setSmooth(bool smooth)
 
 void AnimatedTexture::setRepeat(bool repeat)
 {
+    if(m_frames.empty()) {
+        // the atlas would wrap around all frames, repeated draws are split into rects by the draw pool anyway
+        m_repeat = repeat;
+        return;
+    }
+
     for(const TexturePtr& frame : m_frames)
         frame->setRepeat(repeat);
     m_repeat = repeat;
 }
 
-void AnimatedTexture::updateAnimation()
+bool AnimatedTexture::updateAnimation()
+{
+    const ticks_t now = g_clock.millis();
+    if(now == m_lastUpdate || m_framesEnd.empty())
+        return false;
+    m_lastUpdate = now;
+
+    const ticks_t elapsed = (now - m_startTime) % m_framesEnd.back();
+    const uint frame = std::upper_bound(m_framesEnd.begin(), m_framesEnd.end(), elapsed) - m_framesEnd.begin();
+    if(frame == m_currentFrame)
+        return false;
+
+    m_currentFrame = frame;
+    setupFrame();
+    return true;
+}
+
+void AnimatedTexture::setupFrame()
 {
-    if(m_animTimer.ticksElapsed() < m_framesDelay[m_currentFrame])
+    if(!m_frames.empty()) {
+        m_id = m_frames[m_currentFrame]->getId();
         return;
+    }
 
-    m_animTimer.restart();
-    m_currentFrame++;
-    if(m_currentFrame >= m_frames.size())
-        m_currentFrame = 0;
-    m_id = m_frames[m_currentFrame]->getId();
+    const Point& offset = m_framesOffset[m_currentFrame];
+    m_transformMatrix = { 1.0f / m_glSize.width(),                   0.0f,                                       0.0f,
+                          0.0f,                                      1.0f / m_glSize.height(),                   0.0f,
+                          offset.x / static_cast<float>(m_glSize.width()), offset.y / static_cast<float>(m_glSize.height()), 1.0f };
 }
@@ -24,8 +24,9 @@
 #define ANIMATEDTEXTURE_H
 
 #include "texture.h"
-#include <framework/core/timer.h>
 
+// all frames share one texture laid out in a grid, the transform matrix moves the texture coordinates to the
+// current frame. Frames too large for one texture fall back to a texture each, switching then changes the id
 class AnimatedTexture : public Texture
 {
 public:
@@ -37,15 +38,24 @@ public:
     virtual void setSmooth(bool smooth);
     virtual void setRepeat(bool repeat);
 
-    void updateAnimation();
+    // picks the frame of the current time, called when the texture is drawn so hidden ones cost nothing;
+    // returns whether the frame changed since the last draw
+    bool updateAnimation();
+    uint getCurrentFrame() { updateAnimation(); return m_currentFrame; }
 
     virtual bool isAnimatedTexture() { return true; }
+    virtual uint64 getMemoryUsage();
 
 private:
+    void setupFrame();
+
     std::vector<TexturePtr> m_frames;
-    std::vector<int> m_framesDelay;
+    std::vector<Point> m_framesOffset;
+    // end of each frame in milliseconds since the start of the loop
+    std::vector<ticks_t> m_framesEnd;
     uint m_currentFrame;
-    Timer m_animTimer;
+    ticks_t m_startTime;
+    ticks_t m_lastUpdate;
 };
 
 #endif
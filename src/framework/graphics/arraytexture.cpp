@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "arraytexture.h"
+#include "framebuffer.h"
+#include "graphics.h"
+#include "image.h"
+
+ArrayTexture::ArrayTexture(const Size& size, int layers)
+{
+    if(!setupSize(size))
+        return;
+
+    createTexture();
+    setupArray(layers);
+}
+
+void ArrayTexture::uploadLayerPixels(int layer, const Point& dest, const Size& size, uchar* pixels)
+{
+#ifndef OPENGL_ES
+    if(m_id == 0 || size.isEmpty() || layer < 0 || layer >= m_layers)
+        return;
+
+    bindArray();
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, dest.x, dest.y, layer, size.width(), size.height(), 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+#endif
+}
+
+void ArrayTexture::resizeLayers(int layers)
+{
+#ifndef OPENGL_ES
+    if(m_id == 0 || layers == m_layers)
+        return;
+
+    const uint oldId = m_id;
+    const int copiedLayers = std::min<int>(m_layers, layers);
+
+    createTexture();
+    setupArray(layers);
+
+    // every old layer is attached to a read framebuffer and copied into the new array
+    uint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    for(int layer = 0; layer < copiedLayers; ++layer) {
+        glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, oldId, 0, layer);
+        glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, 0, 0, m_glSize.width(), m_glSize.height());
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, FrameBuffer::getBoundFbo());
+    glDeleteFramebuffers(1, &fbo);
+
+    glDeleteTextures(1, &oldId);
+#endif
+}
+
+ImagePtr ArrayTexture::readPixels(int layer)
+{
+#ifndef OPENGL_ES
+    if(m_id == 0 || layer < 0 || layer >= m_layers)
+        return nullptr;
+
+    uint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_id, 0, layer);
+
+    ImagePtr image;
+    if(glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+        image = ImagePtr(new Image(m_size));
+        glReadPixels(0, 0, m_size.width(), m_size.height(), GL_RGBA, GL_UNSIGNED_BYTE, image->getPixelData());
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, FrameBuffer::getBoundFbo());
+    glDeleteFramebuffers(1, &fbo);
+    return image;
+#else
+    return nullptr;
+#endif
+}
+
+void ArrayTexture::setSmooth(bool smooth)
+{
+    if(smooth && !g_graphics.canUseBilinearFiltering())
+        return;
+
+    if(smooth == m_smooth)
+        return;
+
+    m_smooth = smooth;
+    setupArray(0);
+}
+
+void ArrayTexture::setRepeat(bool repeat)
+{
+    if(m_repeat == repeat)
+        return;
+
+    m_repeat = repeat;
+    setupArray(0);
+}
+
+uint64 ArrayTexture::getMemoryUsage()
+{
+    if(m_id == 0)
+        return 0;
+
+    return static_cast<uint64>(m_glSize.area()) * 4 * m_layers;
+}
+
+void ArrayTexture::bindArray()
+{
+    // keeps the painter texture state in sync, like Texture::bind
+    g_painter->setTexture(this);
+#ifndef OPENGL_ES
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+#endif
+}
+
+void ArrayTexture::setupArray(int layers)
+{
+#ifndef OPENGL_ES
+    if(layers > 0) {
+        // a new id for the same texture object, the painter must bind it again
+        if(g_painter)
+            g_painter->setTexture(nullptr);
+        bindArray();
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_glSize.width(), m_glSize.height(), layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        m_layers = layers;
+        updateStatsBytes();
+    } else
+        bindArray();
+
+    const int wrap = m_repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST);
+#endif
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ARRAYTEXTURE_H
+#define ARRAYTEXTURE_H
+
+#include "texture.h"
+
+// layers of equal size sampled as one GL_TEXTURE_2D_ARRAY, only the packed quads draw them
+class ArrayTexture : public Texture
+{
+public:
+    ArrayTexture(const Size& size, int layers);
+
+    void uploadLayerPixels(int layer, const Point& dest, const Size& size, uchar* pixels);
+    // the layers are copied on the gpu, the texture keeps its identity but gets a new id
+    void resizeLayers(int layers);
+
+    ImagePtr readPixels(int layer = 0) override;
+
+    void setSmooth(bool smooth) override;
+    void setRepeat(bool repeat) override;
+    bool buildHardwareMipmaps() override { return false; }
+
+    int getLayers() const { return m_layers; }
+    bool isArrayTexture() override { return true; }
+    uint64 getMemoryUsage() override;
+
+private:
+    void bindArray();
+    void setupArray(int layers);
+
+    int m_layers{ 0 };
+};
+
+#endif
@@ -22,8 +22,10 @@
 
 #include "bitmapfont.h"
 #include "texturemanager.h"
+#include "textureatlas.h"
 #include "graphics.h"
 #include "image.h"
+#include "fontmanager.h"
 
 #include <framework/otml/otml.h>
 
@@ -31,6 +33,9 @@ namespace
 {
     std::vector<Point> s_glyphsPositions(1);
     std::vector<int> s_lineWidths(1);
+
+    // names, static and animated texts churn through this, start over rather than tracking usage
+    const uint MAX_LAYOUT_CACHE_SIZE = 2048;
 }
 
 void BitmapFont::load(const OTMLNodePtr& fontNode)
@@ -44,15 +49,25 @@ void BitmapFont::load(const OTMLNodePtr& fontNode)
     m_glyphSpacing = fontNode->valueAt("spacing", Size(0, 0));
     const int spaceWidth = fontNode->valueAt("space-width", glyphSize.width());
 
-    // load font texture
-    m_texture = g_textures.getTexture(textureFile);
-    const Size textureSize = m_texture->getSize();
+    // load font texture, all fonts share the atlas pages so texts of any font batch together
+    ImagePtr image = g_fonts.takePrefetchedImage(textureFile);
+    if(!image)
+        image = Image::load(textureFile);
+    m_atlasRegion = g_atlas.allocate(image);
+    if(m_atlasRegion) {
+        m_atlasRegion->setPinned(true);
+        m_texture = m_atlasRegion->getTexture();
+    } else
+        m_texture = g_textures.getTexture(textureFile);
+
+    const Size textureSize = image ? image->getSize() : m_texture->getSize();
+    const Point textureOffset = m_atlasRegion ? m_atlasRegion->getOffset() : Point();
 
     if(OTMLNodePtr node = fontNode->get("fixed-glyph-width")) {
         for(int glyph = m_firstGlyph; glyph < 256; ++glyph)
             m_glyphsSize[glyph] = Size(node->value<int>(), m_glyphHeight);
     } else {
-        calculateGlyphsWidthsAutomatically(Image::load(textureFile), glyphSize);
+        calculateGlyphsWidthsAutomatically(image, glyphSize);
     }
 
     // 32 and 160 are spaces (&nbsp;)
@@ -80,7 +95,10 @@ void BitmapFont::load(const OTMLNodePtr& fontNode)
                                              ((glyph - m_firstGlyph) / numHorizontalGlyphs) * glyphSize.height(),
                                              m_glyphsSize[glyph].width(),
                                              m_glyphHeight);
+        m_glyphsTextureCoords[glyph].translate(textureOffset);
     }
+
+    m_layoutCache.clear();
 }
 
 void BitmapFont::drawText(const std::string& text, const Point& startPos, const Color color)
@@ -104,6 +122,39 @@ std::vector<std::pair<Rect, Rect>> BitmapFont::getDrawTextCoords(const std::stri
     if(!screenCoords.isValid() || !m_texture)
         return list;
 
+    // the layout doesn't depend on where the box is, only on its size
+    const TextLayout& layout = getTextLayout(text, screenCoords.size(), align);
+    const Point& offset = screenCoords.topLeft();
+
+    list.reserve(layout.size());
+    for(const auto& glyph : layout)
+        list.emplace_back(glyph.first.translated(offset), glyph.second);
+
+    return list;
+}
+
+size_t BitmapFont::LayoutKeyHasher::operator()(const LayoutKey& key) const
+{
+    size_t hash = std::hash<std::string>()(key.text);
+    boost::hash_combine(hash, key.boxSize.width());
+    boost::hash_combine(hash, key.boxSize.height());
+    boost::hash_combine(hash, static_cast<int>(key.align));
+    return hash;
+}
+
+const BitmapFont::TextLayout& BitmapFont::getTextLayout(const std::string& text, const Size& boxSize, Fw::AlignmentFlag align)
+{
+    LayoutKey key{ text, boxSize, align };
+    const auto it = m_layoutCache.find(key);
+    if(it != m_layoutCache.end())
+        return it->second;
+
+    if(m_layoutCache.size() >= MAX_LAYOUT_CACHE_SIZE)
+        m_layoutCache.clear();
+
+    TextLayout& layout = m_layoutCache[std::move(key)];
+    const Rect screenCoords(Point(), boxSize);
+
     const int textLenght = text.length();
 
     // map glyphs positions
@@ -152,9 +203,6 @@ std::vector<std::pair<Rect, Rect>> BitmapFont::getDrawTextCoords(const std::stri
             glyphScreenCoords.setLeft(0);
         }
 
-        // translate rect to screen coords
-        glyphScreenCoords.translate(screenCoords.topLeft());
-
         // only render if glyph rect is visible on screenCoords
         if(!screenCoords.intersects(glyphScreenCoords))
             continue;
@@ -170,12 +218,13 @@ std::vector<std::pair<Rect, Rect>> BitmapFont::getDrawTextCoords(const std::stri
         }
 
         // add glyph
-        list.push_back(std::make_pair(glyphScreenCoords, glyphTextureCoords));
+        layout.push_back(std::make_pair(glyphScreenCoords, glyphTextureCoords));
     }
 
-    return list;
+    return layout;
 }
 
+
 const std::vector<Point>& BitmapFont::calculateGlyphsPositions(const std::string& text,
                                                                Fw::AlignmentFlag align,
                                                                Size* textBoxSize)
@@ -44,6 +44,7 @@ public:
     /// Advanced text render delimited by a screen region and alignment
     void drawText(const std::string& text, const Rect& screenCoords, const Color color = Color::white, Fw::AlignmentFlag align = Fw::AlignTopLeft);
 
+    /// Glyph quads of the text laid out in screenCoords, the layout itself is cached per text, box size and alignment
     std::vector<std::pair<Rect, Rect>> getDrawTextCoords(const std::string& text, const Rect& screenCoords, Fw::AlignmentFlag align = Fw::AlignTopLeft);
 
     /// Calculate glyphs positions to use on render, also calculates textBoxSize if wanted
@@ -65,6 +66,23 @@ public:
     Size getGlyphSpacing() { return m_glyphSpacing; }
 
 private:
+    using TextLayout = std::vector<std::pair<Rect, Rect>>;
+
+    struct LayoutKey {
+        std::string text;
+        Size boxSize;
+        Fw::AlignmentFlag align;
+
+        bool operator==(const LayoutKey& other) const { return align == other.align && boxSize == other.boxSize && text == other.text; }
+    };
+
+    struct LayoutKeyHasher {
+        size_t operator()(const LayoutKey& key) const;
+    };
+
+    /// Glyph quads relative to the top left of a box of boxSize
+    const TextLayout& getTextLayout(const std::string& text, const Size& boxSize, Fw::AlignmentFlag align);
+
     /// Calculates each font character by inspecting font bitmap
     void calculateGlyphsWidthsAutomatically(const ImagePtr& image, const Size& glyphSize);
 
@@ -74,8 +92,11 @@ private:
     int m_yOffset;
     Size m_glyphSpacing;
     TexturePtr m_texture;
+    AtlasRegionPtr m_atlasRegion;
     Rect m_glyphsTextureCoords[256];
     Size m_glyphsSize[256];
+
+    std::unordered_map<LayoutKey, TextLayout, LayoutKeyHasher> m_layoutCache;
 };
 
 #endif
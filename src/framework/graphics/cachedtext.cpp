@@ -37,12 +37,18 @@ void CachedText::draw(const Rect& rect, const Color color)
     if(!m_font)
         return;
 
-    if(m_textMustRecache || m_textCachedScreenCoords != rect) {
+    if(m_textMustRecache || m_textCachedScreenCoords.size() != rect.size()) {
         m_textMustRecache = false;
         m_textCachedScreenCoords = rect;
 
         m_textCoordsCache.clear();
         m_textCoordsCache = m_font->getDrawTextCoords(m_text, rect, m_align);
+    } else if(m_textCachedScreenCoords != rect) {
+        // the layout only depends on the size, moving texts (animated ones every frame) just shift it
+        const Point offset = rect.topLeft() - m_textCachedScreenCoords.topLeft();
+        m_textCachedScreenCoords = rect;
+        for(auto& fontRect : m_textCoordsCache)
+            fontRect.first.translate(offset);
     }
 
     for(const auto& fontRect : m_textCoordsCache)
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "compressedimage.h"
+
+namespace
+{
+    const uint8 KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    const uint32 KTX_ENDIANNESS = 0x04030201;
+    const uint32 DDS_MAGIC = 0x20534444; // "DDS "
+    const uint32 DDS_FOURCC = 0x4;
+
+    constexpr uint32 fourCC(const char* code) { return code[0] | code[1] << 8 | code[2] << 16 | code[3] << 24; }
+
+    uint32 readU32(const std::string& data, size_t offset)
+    {
+        if(offset + 4 > data.size())
+            stdext::throw_exception("unexpected end of file");
+
+        uint32 value;
+        memcpy(&value, data.data() + offset, 4);
+        return value;
+    }
+
+    // bytes of a level in the 4x4 block formats
+    uint32 blockLevelSize(uint format, const Size& size)
+    {
+        const bool halfBlocks = format <= CompressedImage::RGBA_S3TC_DXT1 || format == CompressedImage::RED_RGTC1;
+        return std::max<int>(1, (size.width() + 3) / 4) * std::max<int>(1, (size.height() + 3) / 4) * (halfBlocks ? 8 : 16);
+    }
+
+    uint ddsFormat(uint32 fourcc, const std::string& data)
+    {
+        switch(fourcc) {
+            case fourCC("DXT1"): return CompressedImage::RGBA_S3TC_DXT1;
+            case fourCC("DXT3"): return CompressedImage::RGBA_S3TC_DXT3;
+            case fourCC("DXT5"): return CompressedImage::RGBA_S3TC_DXT5;
+            case fourCC("ATI1"):
+            case fourCC("BC4U"): return CompressedImage::RED_RGTC1;
+            case fourCC("ATI2"):
+            case fourCC("BC5U"): return CompressedImage::RG_RGTC2;
+            case fourCC("DX10"):
+                break;
+            default:
+                return 0;
+        }
+
+        // the DXGI format follows the legacy header
+        switch(readU32(data, 128)) {
+            case 71: return CompressedImage::RGBA_S3TC_DXT1; // DXGI_FORMAT_BC1_UNORM
+            case 74: return CompressedImage::RGBA_S3TC_DXT3; // DXGI_FORMAT_BC2_UNORM
+            case 77: return CompressedImage::RGBA_S3TC_DXT5; // DXGI_FORMAT_BC3_UNORM
+            case 80: return CompressedImage::RED_RGTC1; // DXGI_FORMAT_BC4_UNORM
+            case 83: return CompressedImage::RG_RGTC2; // DXGI_FORMAT_BC5_UNORM
+            case 95: return CompressedImage::RGB_BPTC_UNSIGNED_FLOAT; // DXGI_FORMAT_BC6H_UF16
+            case 96: return CompressedImage::RGB_BPTC_SIGNED_FLOAT; // DXGI_FORMAT_BC6H_SF16
+            case 98: return CompressedImage::RGBA_BPTC_UNORM; // DXGI_FORMAT_BC7_UNORM
+            case 99: return CompressedImage::SRGB_ALPHA_BPTC_UNORM; // DXGI_FORMAT_BC7_UNORM_SRGB
+            default: return 0;
+        }
+    }
+}
+
+CompressedImagePtr CompressedImage::loadKTX(const std::string& data)
+{
+    if(data.size() < 64 || memcmp(data.data(), KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0)
+        stdext::throw_exception("not a KTX file");
+
+    if(readU32(data, 12) != KTX_ENDIANNESS)
+        stdext::throw_exception("big endian KTX files are not supported");
+
+    const uint32 glType = readU32(data, 16);
+    const uint32 glInternalFormat = readU32(data, 28);
+    const Size size(readU32(data, 36), readU32(data, 40));
+    const uint32 depth = readU32(data, 44);
+    const uint32 arrayElements = readU32(data, 48);
+    const uint32 faces = readU32(data, 52);
+    const uint32 levels = std::max<uint32>(1, readU32(data, 56));
+    const uint32 keyValueBytes = readU32(data, 60);
+
+    if(glType != 0)
+        stdext::throw_exception("KTX file is not block compressed");
+    if(depth > 1 || arrayElements > 1 || faces != 1 || size.isEmpty())
+        stdext::throw_exception("only 2D KTX textures are supported");
+
+    CompressedImagePtr image(new CompressedImage);
+    image->m_format = glInternalFormat;
+    image->m_size = size;
+
+    size_t offset = 64 + keyValueBytes;
+    for(uint32 level = 0; level < levels; ++level) {
+        const uint32 levelSize = readU32(data, offset);
+        offset += 4;
+        if(offset + levelSize > data.size())
+            stdext::throw_exception("unexpected end of file");
+
+        image->m_levels.emplace_back(data, offset, levelSize);
+        offset += (levelSize + 3) & ~3u;
+    }
+
+    return image;
+}
+
+CompressedImagePtr CompressedImage::loadDDS(const std::string& data)
+{
+    if(data.size() < 128 || readU32(data, 0) != DDS_MAGIC)
+        stdext::throw_exception("not a DDS file");
+
+    const Size size(readU32(data, 16), readU32(data, 12));
+    const uint32 levels = std::max<uint32>(1, readU32(data, 28));
+    const uint32 pixelFormatFlags = readU32(data, 80);
+    const uint32 fourcc = readU32(data, 84);
+
+    const uint format = (pixelFormatFlags & DDS_FOURCC) ? ddsFormat(fourcc, data) : 0;
+    if(format == 0)
+        stdext::throw_exception("DDS file is not block compressed");
+    if(size.isEmpty())
+        stdext::throw_exception("DDS file has no pixels");
+
+    CompressedImagePtr image(new CompressedImage);
+    image->m_format = format;
+    image->m_size = size;
+
+    Size levelSize = size;
+    size_t offset = fourcc == fourCC("DX10") ? 148 : 128;
+    for(uint32 level = 0; level < levels; ++level) {
+        const uint32 bytes = blockLevelSize(format, levelSize);
+        if(offset + bytes > data.size())
+            stdext::throw_exception("unexpected end of file");
+
+        image->m_levels.emplace_back(data, offset, bytes);
+        offset += bytes;
+        levelSize = Size(std::max<int>(1, levelSize.width() / 2), std::max<int>(1, levelSize.height() / 2));
+    }
+
+    return image;
+}
+
+uint64 CompressedImage::getDataSize()
+{
+    uint64 size = 0;
+    for(const std::string& level : m_levels)
+        size += level.size();
+    return size;
+}
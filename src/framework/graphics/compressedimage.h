@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef COMPRESSEDIMAGE_H
+#define COMPRESSEDIMAGE_H
+
+#include "declarations.h"
+
+// block compressed pixels read from a KTX or DDS container, uploaded as they are
+class CompressedImage : public stdext::shared_object
+{
+public:
+    // OpenGL internal formats, spelled out since OpenGL ES headers lack the desktop ones
+    enum Format : uint {
+        RGB_S3TC_DXT1 = 0x83F0,
+        RGBA_S3TC_DXT1 = 0x83F1,
+        RGBA_S3TC_DXT3 = 0x83F2,
+        RGBA_S3TC_DXT5 = 0x83F3,
+        RED_RGTC1 = 0x8DBB,
+        RG_RGTC2 = 0x8DBD,
+        RGBA_BPTC_UNORM = 0x8E8C,
+        SRGB_ALPHA_BPTC_UNORM = 0x8E8D,
+        RGB_BPTC_SIGNED_FLOAT = 0x8E8E,
+        RGB_BPTC_UNSIGNED_FLOAT = 0x8E8F,
+        RGB8_ETC2 = 0x9274,
+        SRGB8_ETC2 = 0x9275,
+        RGB8_PUNCHTHROUGH_ALPHA1_ETC2 = 0x9276,
+        SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 = 0x9277,
+        RGBA8_ETC2_EAC = 0x9278,
+        SRGB8_ALPHA8_ETC2_EAC = 0x9279,
+        RGBA_ASTC_4x4 = 0x93B0,
+        RGBA_ASTC_12x12 = 0x93BD
+    };
+
+    static CompressedImagePtr loadKTX(const std::string& data);
+    static CompressedImagePtr loadDDS(const std::string& data);
+
+    uint getFormat() { return m_format; }
+    const Size& getSize() { return m_size; }
+    int getLevelCount() { return m_levels.size(); }
+    const std::string& getLevel(int level) { return m_levels[level]; }
+    uint64 getDataSize();
+
+private:
+    uint m_format{ 0 };
+    Size m_size;
+    std::vector<std::string> m_levels;
+};
+
+#endif
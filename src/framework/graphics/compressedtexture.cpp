@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "compressedtexture.h"
+#include "compressedimage.h"
+#include "graphics.h"
+
+CompressedTexture::CompressedTexture(const CompressedImagePtr& image)
+{
+    // compressed blocks can't be padded to a power of two, the loader checks the size beforehand
+    if(!setupSize(image->getSize()) || m_glSize != m_size)
+        return;
+
+    createTexture();
+    bind();
+
+    Size levelSize = m_size;
+    for(int level = 0; level < image->getLevelCount(); ++level) {
+        const std::string& data = image->getLevel(level);
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, image->getFormat(), levelSize.width(), levelSize.height(), 0, data.size(), data.data());
+        levelSize = Size(std::max<int>(1, levelSize.width() / 2), std::max<int>(1, levelSize.height() / 2));
+    }
+
+#ifndef OPENGL_ES
+    // a partial chain is complete up to its last level
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image->getLevelCount() - 1);
+#endif
+
+    m_hasMipmaps = image->getLevelCount() > 1;
+    m_dataSize = image->getDataSize();
+    setupWrap();
+    setupFilters();
+    updateStatsBytes();
+}
+
+uint64 CompressedTexture::getMemoryUsage()
+{
+    if(m_id == 0)
+        return 0;
+
+    return m_dataSize;
+}
@@ -66,3 +66,68 @@ void CoordsBuffer::addRepeatedRects(const Rect& dest, const Rect& src)
         }
     }
 }
+
+void CoordsBuffer::enableHardwareCaching(HardwareBuffer::UsagePattern usagePattern)
+{
+    if(!g_graphics.canUseHardwareBuffers())
+        return;
+
+    m_hardwareCacheUsage = usagePattern;
+    m_hardwareCaching = true;
+}
+
+void CoordsBuffer::updateCaches()
+{
+    if(!m_hardwareCaching)
+        return;
+
+    if(!m_hardwareVertexArray)
+        m_hardwareVertexArray = std::make_unique<HardwareBuffer>(HardwareBuffer::VertexBuffer);
+    uploadDirtyRange(m_hardwareVertexArray.get(), m_uploadedVertexArray, m_vertexArray, m_hardwareCacheUsage);
+
+    if(m_textureCoordArray.size() > 0) {
+        if(!m_hardwareTextureCoordArray)
+            m_hardwareTextureCoordArray = std::make_unique<HardwareBuffer>(HardwareBuffer::VertexBuffer);
+        uploadDirtyRange(m_hardwareTextureCoordArray.get(), m_uploadedTextureCoordArray, m_textureCoordArray, m_hardwareCacheUsage);
+    }
+
+    HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+    m_hardwareCached = true;
+}
+
+void CoordsBuffer::uploadDirtyRange(HardwareBuffer* hardwareBuffer, DataBuffer<float>& uploaded, const VertexArray& array, HardwareBuffer::UsagePattern usagePattern)
+{
+    const uint size = array.size();
+    float* data = array.vertices();
+
+    hardwareBuffer->bind();
+
+    // the buffer storage only grows, smaller arrays are updated in place
+    if(static_cast<int>(size * sizeof(float)) > hardwareBuffer->size()) {
+        hardwareBuffer->write(data, size * sizeof(float), usagePattern);
+        uploaded.resize(size);
+        for(uint i = 0; i < size; ++i)
+            uploaded[i] = data[i];
+        return;
+    }
+
+    const uint common = std::min<uint>(size, uploaded.size());
+
+    uint first = 0;
+    while(first < common && uploaded[first] == data[first])
+        ++first;
+
+    uint last = size;
+    if(size <= uploaded.size()) {
+        while(last > first && uploaded[last - 1] == data[last - 1])
+            --last;
+    }
+
+    uploaded.resize(size);
+    if(first == last)
+        return;
+
+    hardwareBuffer->writeRange(first * sizeof(float), data + first, (last - first) * sizeof(float));
+    for(uint i = first; i < last; ++i)
+        uploaded[i] = data[i];
+}
@@ -68,14 +68,32 @@ public:
     void addBoudingRect(const Rect& dest, int innerLineWidth);
     void addRepeatedRects(const Rect& dest, const Rect& src);
 
+    // keeps a copy of the arrays in video memory, only the changed range is uploaded by updateCaches
+    void enableHardwareCaching(HardwareBuffer::UsagePattern usagePattern = HardwareBuffer::DynamicDraw);
+    void updateCaches();
+    bool isHardwareCached() const { return m_hardwareCached; }
+
     float* getVertexArray() { return m_vertexArray.vertices(); }
     float* getTextureCoordArray() { return m_textureCoordArray.vertices(); }
     int getVertexCount() const { return m_vertexArray.vertexCount(); }
     int getTextureCoordCount() const { return m_textureCoordArray.vertexCount(); }
 
+    HardwareBuffer* getHardwareVertexArray() { return m_hardwareVertexArray.get(); }
+    HardwareBuffer* getHardwareTextureCoordArray() { return m_hardwareTextureCoordArray.get(); }
+
 private:
+    static void uploadDirtyRange(HardwareBuffer* hardwareBuffer, DataBuffer<float>& uploaded, const VertexArray& array, HardwareBuffer::UsagePattern usagePattern);
+
     VertexArray m_vertexArray;
     VertexArray m_textureCoordArray;
+
+    std::unique_ptr<HardwareBuffer> m_hardwareVertexArray;
+    std::unique_ptr<HardwareBuffer> m_hardwareTextureCoordArray;
+    DataBuffer<float> m_uploadedVertexArray;
+    DataBuffer<float> m_uploadedTextureCoordArray;
+    HardwareBuffer::UsagePattern m_hardwareCacheUsage{ HardwareBuffer::DynamicDraw };
+    bool m_hardwareCaching{ false };
+    bool m_hardwareCached{ false };
 };
 
 #endif
@@ -29,7 +29,9 @@
 class Texture;
 class TextureManager;
 class Image;
+class CompressedImage;
 class AnimatedTexture;
+class ArrayTexture;
 class BitmapFont;
 class CachedText;
 class FrameBuffer;
@@ -37,27 +39,30 @@ class FrameBufferManager;
 class Shader;
 class ShaderProgram;
 class PainterShaderProgram;
-class Particle;
+struct ParticleStore;
 class ParticleType;
 class ParticleEmitter;
 class ParticleAffector;
 class ParticleSystem;
 class ParticleEffect;
 class ParticleEffectType;
+class AtlasRegion;
+class TextureAtlas;
 class Pool;
 class FramedPool;
 class DrawPool;
 
 typedef stdext::shared_object_ptr<Image> ImagePtr;
+typedef stdext::shared_object_ptr<CompressedImage> CompressedImagePtr;
 typedef stdext::shared_object_ptr<Texture> TexturePtr;
 typedef stdext::shared_object_ptr<AnimatedTexture> AnimatedTexturePtr;
+typedef stdext::shared_object_ptr<ArrayTexture> ArrayTexturePtr;
 typedef stdext::shared_object_ptr<BitmapFont> BitmapFontPtr;
 typedef stdext::shared_object_ptr<CachedText> CachedTextPtr;
 typedef stdext::shared_object_ptr<FrameBuffer> FrameBufferPtr;
 typedef stdext::shared_object_ptr<Shader> ShaderPtr;
 typedef stdext::shared_object_ptr<ShaderProgram> ShaderProgramPtr;
 typedef stdext::shared_object_ptr<PainterShaderProgram> PainterShaderProgramPtr;
-typedef stdext::shared_object_ptr<Particle> ParticlePtr;
 typedef stdext::shared_object_ptr<ParticleType> ParticleTypePtr;
 typedef stdext::shared_object_ptr<ParticleEmitter> ParticleEmitterPtr;
 typedef stdext::shared_object_ptr<ParticleAffector> ParticleAffectorPtr;
@@ -66,6 +71,7 @@ typedef stdext::shared_object_ptr<ParticleEffect> ParticleEffectPtr;
 typedef stdext::shared_object_ptr<ParticleEffectType> ParticleEffectTypePtr;
 typedef std::vector<ShaderPtr> ShaderList;
 
+typedef std::shared_ptr<AtlasRegion> AtlasRegionPtr;
 typedef std::shared_ptr<Pool> PoolPtr;
 typedef std::shared_ptr<FramedPool> PoolFramedPtr;
 
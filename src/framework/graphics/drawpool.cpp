@@ -23,10 +23,17 @@
 #include "drawpool.h"
 #include "declarations.h"
 #include <framework/core/declarations.h>
+#include <framework/core/frameprofiler.h>
+#include <framework/graphics/animatedtexture.h>
 #include <framework/graphics/framebuffermanager.h>
 #include <framework/graphics/graphics.h>
+#include <framework/graphics/image.h>
+#include <framework/graphics/texture.h>
+#include <framework/graphics/texturemanager.h>
 #include "painter.h"
 
+#include <random>
+
 const static std::hash<size_t> HASH_INT;
 const static std::hash<float> HASH_FLOAT;
 
@@ -40,6 +47,7 @@ void DrawPool::init()
 
 void DrawPool::terminate()
 {
+    m_gpuTimer.terminate();
     m_currentPool = nullptr;
     for(int8 i = -1; ++i <= PoolType::UNKNOW;)
         m_pools[i] = nullptr;
@@ -59,23 +67,61 @@ PoolFramedPtr DrawPool::createPoolF(const PoolType type)
     return pool;
 }
 
-void DrawPool::addRepeated(const Painter::PainterState& state, const Pool::DrawMethod& method, const Painter::DrawMode drawMode)
+void DrawPool::moveColorToMethod(Painter::PainterState& state, Pool::DrawMethod& method)
+{
+    // custom shaders only know u_Color, their objects keep splitting by color
+    if(state.shaderProgram || !g_painter->canDrawPackedQuads())
+        return;
+
+    method.color = Color(state.color.rF(), state.color.gF(), state.color.bF(), state.color.aF() * state.opacity);
+    state.color = Color::white;
+    state.opacity = 1.f;
+}
+
+bool DrawPool::translate(Painter::PainterState& state, Pool::DrawMethod& method)
+{
+    const Point& offset = m_currentPool->m_state.translation;
+    const Rect& bounds = m_currentPool->m_state.translationBounds;
+
+    if(method.rects.first.isValid())
+        method.rects.first.translate(offset);
+    if(method.type == Pool::DrawMethodType::DRAW_FILLED_TRIANGLE) {
+        std::get<0>(method.points) += offset;
+        std::get<1>(method.points) += offset;
+        std::get<2>(method.points) += offset;
+    }
+    if(!method.dest.isNull())
+        method.dest += offset;
+
+    // an empty clip would mean no clip at all, such draws are dropped instead
+    state.clipRect = state.clipRect.isValid() ? state.clipRect.translated(offset).intersection(bounds) : bounds;
+    return state.clipRect.isValid();
+}
+
+void DrawPool::addRepeated(Painter::PainterState& state, Pool::DrawMethod& method, const Painter::DrawMode drawMode)
 {
+    if(m_currentPool->m_state.translationBounds.isValid() && !translate(state, method))
+        return;
+
+    moveColorToMethod(state, method);
     updateHash(state, method);
 
     const uint16 startIndex = m_currentPool->m_indexToStartSearching ? m_currentPool->m_indexToStartSearching - 1 : 0;
+    const size_t stateHash = Pool::hashState(state);
 
-    const auto itFind = std::find_if(m_currentPool->m_objects.begin() + startIndex, m_currentPool->m_objects.end(), [state]
-    (const Pool::DrawObject& action) { return action.state == state; });
-
-    if(itFind != m_currentPool->m_objects.end()) {
-        (*itFind).drawMethods.push_back(method);
+    if(auto* obj = m_currentPool->findIndexedObject(state, stateHash, startIndex)) {
+        obj->drawMethods.push_back(method);
     } else
-        m_currentPool->m_objects.push_back(Pool::DrawObject{ state, drawMode, {method} });
+        m_currentPool->m_objects.push_back(Pool::DrawObject{ state, drawMode, m_currentPool->createMethodList() });
+        m_currentPool->m_objects.back().drawMethods.push_back(method);
 }
 
-void DrawPool::add(const Painter::PainterState& state, const Pool::DrawMethod& method, const Painter::DrawMode drawMode)
+void DrawPool::add(Painter::PainterState& state, Pool::DrawMethod& method, const Painter::DrawMode drawMode)
 {
+    if(m_currentPool->m_state.translationBounds.isValid() && !translate(state, method))
+        return;
+
+    moveColorToMethod(state, method);
     updateHash(state, method);
 
     auto& list = m_currentPool->m_objects;
@@ -90,7 +136,7 @@ void DrawPool::add(const Painter::PainterState& state, const Pool::DrawMethod& m
             for(auto itm = prevObj.drawMethods.begin(); itm != prevObj.drawMethods.end(); ++itm) {
                 auto& prevMtd = *itm;
                 if(prevMtd.dest == method.dest &&
-                   ((sameState && prevMtd.rects.second == method.rects.second) || (state.texture->isOpaque() && prevObj.state.texture->canSuperimposed()))) {
+                   ((sameState && prevMtd.rects.second == method.rects.second && prevMtd.color == method.color && prevMtd.maskColors == method.maskColors) || (state.texture->isOpaque() && prevObj.state.texture->canSuperimposed()))) {
                     prevObj.drawMethods.erase(itm);
                     break;
                 }
@@ -104,45 +150,208 @@ void DrawPool::add(const Painter::PainterState& state, const Pool::DrawMethod& m
         }
     }
 
-    list.push_back(Pool::DrawObject{ state, drawMode, {method} });
+    list.push_back(Pool::DrawObject{ state, drawMode, m_currentPool->createMethodList() });
+    list.back().drawMethods.push_back(method);
+}
+
+void DrawPool::swapFrames()
+{
+    for(const auto& pool : m_pools) {
+        pool->swapObjects();
+
+        if(!pool->hasFrameBuffer()) continue;
+        const auto& pf = pool->toFramedPool();
+        pf->m_submitDest = pf->m_dest;
+        pf->m_submitSrc = pf->m_src;
+        pf->m_submitRedraw = pf->hasModification();
+        if(pf->m_submitRedraw)
+            pf->updateStatus();
+    }
+}
+
+void DrawPool::discardFrame()
+{
+    for(const auto& pool : m_pools)
+        pool->clearObjects();
 }
 
 void DrawPool::draw()
 {
+    PROFILE_SCOPE("drawpool.draw");
+
+    m_statistics.fill(Painter::Statistics());
+    if(m_gpuTimersEnabled)
+        m_gpuTimer.nextFrame();
+
+    if(!m_captureFile.empty())
+        beginCapture();
+
     // Pre Draw
-    for(const auto& pool : m_pools) {
+    for(size_t type = 0; type < m_pools.size(); ++type) {
+        const auto& pool = m_pools[type];
         if(!pool->isEnabled() || !pool->hasFrameBuffer()) continue;
         const auto& pf = pool->toFramedPool();
-        if(pf->hasModification()) {
-            pf->updateStatus();
-            if(!pool->m_objects.empty()) {
+        if(pf->m_submitRedraw) {
+            auto& objects = pool->m_submitObjects;
+            if(!objects.empty()) {
+                beginMeasure(type, PHASE_PREPARE);
                 pf->m_framebuffer->bind();
-                for(auto& obj : pool->m_objects)
-                    drawObject(obj);
+                for(size_t i = 0, s = objects.size(); i < s; ++i)
+                    drawObject(objects[i], pf->getCoordsCache(i));
                 pf->m_framebuffer->release();
+                endMeasure(type);
             }
+            pf->trimCoordsCache(objects.size());
         }
     }
 
     // Draw
-    for(const auto& pool : m_pools) {
+    for(size_t type = 0; type < m_pools.size(); ++type) {
+        const auto& pool = m_pools[type];
         if(!pool->isEnabled()) continue;
         if(pool->hasFrameBuffer()) {
             const auto pf = pool->toFramedPool();
+            if(pf->isOffscreen()) {
+                pool->m_submitObjects.clear();
+                continue;
+            }
 
+            beginMeasure(type, PHASE_COMPOSE);
             g_painter->saveAndResetState();
             if(pf->m_beforeDraw) pf->m_beforeDraw();
-            pf->m_framebuffer->draw(pf->m_dest, pf->m_src);
+            pf->m_framebuffer->draw(pf->m_submitDest, pf->m_submitSrc);
             if(pf->m_afterDraw) pf->m_afterDraw();
             g_painter->restoreSavedState();
-        } else             for(auto& obj : pool->m_objects)
-            drawObject(obj);
+            endMeasure(type);
+        } else {
+            beginMeasure(type, PHASE_COMPOSE);
+            for(auto& obj : pool->m_submitObjects)
+                drawObject(obj);
+            endMeasure(type);
+        }
 
-        pool->m_objects.clear();
+        // the textures and actions held by the submitted objects are released right away, the vector keeps its capacity for the next swap
+        pool->m_submitObjects.clear();
     }
+
+    if(m_captureStream)
+        endCapture();
+
+    // uploads made while the next frame is built count against its budget
+    g_textures.nextUploadFrame();
+}
+
+void DrawPool::beginMeasure(size_t type, DrawPhase phase)
+{
+    m_measureStart = g_painter->getStatistics();
+    if(m_gpuTimersEnabled)
+        m_gpuTimer.begin(type * PHASE_COUNT + phase);
+}
+
+void DrawPool::endMeasure(size_t type)
+{
+    if(m_gpuTimersEnabled)
+        m_gpuTimer.end();
+
+    const Painter::Statistics& current = g_painter->getStatistics();
+    Painter::Statistics& stats = m_statistics[type];
+    stats.drawCalls += current.drawCalls - m_measureStart.drawCalls;
+    stats.vertices += current.vertices - m_measureStart.vertices;
+    stats.textureBinds += current.textureBinds - m_measureStart.textureBinds;
+    stats.shaderSwitches += current.shaderSwitches - m_measureStart.shaderSwitches;
+    stats.stateChanges += current.stateChanges - m_measureStart.stateChanges;
+    stats.skippedGlCalls += current.skippedGlCalls - m_measureStart.skippedGlCalls;
 }
 
-void DrawPool::drawObject(Pool::DrawObject& obj)
+void DrawPool::setGpuTimersEnabled(bool enabled)
+{
+    if(enabled && !g_graphics.canUseTimerQuery()) {
+        g_logger.warning("GPU timer queries are not supported by this driver");
+        return;
+    }
+
+    m_gpuTimersEnabled = enabled;
+    if(enabled)
+        m_gpuTimer.resize(m_pools.size() * PHASE_COUNT);
+    else
+        m_gpuTimer.terminate();
+}
+
+std::map<std::string, std::map<std::string, double>> DrawPool::getStatistics()
+{
+    static const std::array<std::string, PoolType::UNKNOW + 1> names = {
+        "staticFloors", "map", "creatureInformation", "staticLight", "light", "text", "uiCache", "foreground", "unknown"
+    };
+
+    std::map<std::string, std::map<std::string, double>> ret;
+    for(size_t type = 0; type < m_pools.size(); ++type) {
+        const Painter::Statistics& stats = m_statistics[type];
+        std::map<std::string, double>& entry = ret[names[type]];
+        entry["drawCalls"] = stats.drawCalls;
+        entry["vertices"] = stats.vertices;
+        entry["textureBinds"] = stats.textureBinds;
+        entry["shaderSwitches"] = stats.shaderSwitches;
+        entry["stateChanges"] = stats.stateChanges;
+        entry["skippedGlCalls"] = stats.skippedGlCalls;
+        entry["arenaBytes"] = m_pools[type]->m_arenas[0].getCapacity() + m_pools[type]->m_arenas[1].getCapacity();
+        entry["arenaBlockAllocations"] = m_pools[type]->m_arenas[0].getBlockAllocations() + m_pools[type]->m_arenas[1].getBlockAllocations();
+        if(m_gpuTimersEnabled)
+            entry["gpuMicros"] = m_gpuTimer.getMicros(type * PHASE_COUNT + PHASE_PREPARE) + m_gpuTimer.getMicros(type * PHASE_COUNT + PHASE_COMPOSE);
+    }
+    return ret;
+}
+
+std::tuple<double, double, double> DrawPool::benchmark(int objects, int frames)
+{
+    objects = std::max<int>(1, objects);
+    frames = std::max<int>(1, frames);
+
+    // recorded into a pool of its own, the frame the client is recording stays untouched
+    const PoolPtr pool = std::make_shared<Pool>();
+    const PoolPtr previousPool = m_currentPool;
+
+    std::vector<TexturePtr> textures;
+    for(int i = 0; i < 8; ++i)
+        textures.push_back(TexturePtr(new Texture(ImagePtr(new Image(Size(32, 32))))));
+
+    std::mt19937 gen(objects);
+    std::vector<Rect> rects(objects);
+    for(Rect& rect : rects)
+        rect = Rect(gen() % 1920, gen() % 1080, 32, 32);
+    const Rect src(0, 0, 32, 32);
+
+    ticks_t addElapsed = 0, repeatedElapsed = 0, drawElapsed = 0;
+    use(pool);
+    for(int frame = 0; frame < frames; ++frame) {
+        stdext::timer timer;
+        for(int i = 0; i < objects; ++i)
+            addTexturedRect(rects[i], textures[i % textures.size()], src);
+        addElapsed += timer.elapsed_micros();
+
+        pool->swapObjects();
+
+        timer.restart();
+        for(auto& obj : pool->m_submitObjects)
+            drawObject(obj);
+        drawElapsed += timer.elapsed_micros();
+        pool->m_submitObjects.clear();
+
+        timer.restart();
+        for(int i = 0; i < objects; ++i)
+            addRepeatedTexturedRect(rects[i], textures[i % textures.size()], src);
+        repeatedElapsed += timer.elapsed_micros();
+        pool->clearObjects();
+    }
+    m_currentPool = previousPool;
+
+    const double addMicros = static_cast<double>(addElapsed) / frames;
+    const double repeatedMicros = static_cast<double>(repeatedElapsed) / frames;
+    const double drawMicros = static_cast<double>(drawElapsed) / frames;
+    g_logger.info(stdext::format("DrawPool with %d objects: add %.1f us, addRepeated %.1f us, draw %.1f us per frame", objects, addMicros, repeatedMicros, drawMicros));
+    return std::make_tuple(addMicros, repeatedMicros, drawMicros);
+}
+
+void DrawPool::drawObject(Pool::DrawObject& obj, FramedPool::CoordsCache* cache)
 {
     if(obj.action) {
         obj.action();
@@ -158,30 +367,155 @@ void DrawPool::drawObject(Pool::DrawObject& obj)
         g_painter->setTexture(obj.state.texture.get());
     }
 
+    // sharp atlas pages are filtered for this object only, the draw calls are issued before it returns
+    struct SmoothSampling {
+        Texture* texture;
+        SmoothSampling(Texture* t) : texture(t && !t->isSmooth() ? t : nullptr) { if(texture) texture->setSmooth(true); }
+        ~SmoothSampling() { if(texture) texture->setSmooth(false); }
+    } smoothSampling(obj.state.smoothSampling ? obj.state.texture.get() : nullptr);
+
+    // array textures are only sampled by the packed quads program
+    const bool arrayTexture = obj.state.texture && obj.state.texture->isArrayTexture();
+    if(!obj.state.shaderProgram && !obj.state.silhouette && !arrayTexture && g_painter->canDrawOutfitMasks() && drawOutfitObject(obj))
+        return;
+
+    if(!obj.state.shaderProgram && g_painter->canDrawPackedQuads()) {
+        if(drawPackedObject(obj) || arrayTexture)
+            return;
+
+        // a coordinate did not fit the packed vertices, draw one run of equal colors at a time
+        drawColorRuns(obj);
+        return;
+    }
+
+    if(arrayTexture)
+        return;
+
+    auto& coordsBuffer = cache ? cache->buffer : m_coordsbuffer;
+
+    // the vertices uploaded last time are still valid, skip rebuilding them
+    if(cache && cache->buffer.isHardwareCached() && cache->drawMode == obj.drawMode &&
+       std::equal(cache->drawMethods.begin(), cache->drawMethods.end(), obj.drawMethods.begin(), obj.drawMethods.end())) {
+        g_painter->drawCoords(coordsBuffer, obj.drawMode);
+        return;
+    }
+
+    coordsBuffer.clear();
+    for(const auto& method : obj.drawMethods)
+        addCoords(coordsBuffer, method, obj.drawMode);
+
+    if(cache) {
+        cache->drawMode = obj.drawMode;
+        cache->drawMethods.assign(obj.drawMethods.begin(), obj.drawMethods.end());
+        coordsBuffer.updateCaches();
+    }
+
+    g_painter->drawCoords(coordsBuffer, obj.drawMode);
+}
+
+void DrawPool::addCoords(CoordsBuffer& coordsBuffer, const Pool::DrawMethod& method, const Painter::DrawMode drawMode)
+{
+    if(method.type == Pool::DrawMethodType::DRAW_BOUNDING_RECT) {
+        coordsBuffer.addBoudingRect(method.rects.first, method.intValue);
+    } else if(method.type == Pool::DrawMethodType::DRAW_FILLED_RECT || method.type == Pool::DrawMethodType::DRAW_REPEATED_FILLED_RECT) {
+        coordsBuffer.addRect(method.rects.first);
+    } else if(method.type == Pool::DrawMethodType::DRAW_FILLED_TRIANGLE) {
+        coordsBuffer.addTriangle(std::get<0>(method.points), std::get<1>(method.points), std::get<2>(method.points));
+    } else if(method.type == Pool::DrawMethodType::DRAW_TEXTURED_RECT || method.type == Pool::DrawMethodType::DRAW_REPEATED_TEXTURED_RECT ||
+              method.type == Pool::DrawMethodType::DRAW_OUTFIT_RECT) {
+        if(drawMode == Painter::DrawMode::Triangles)
+            coordsBuffer.addRect(method.rects.first, method.rects.second);
+        else
+            coordsBuffer.addQuad(method.rects.first, method.rects.second);
+    } else if(method.type == Pool::DrawMethodType::DRAW_UPSIDEDOWN_TEXTURED_RECT) {
+        if(drawMode == Painter::DrawMode::Triangles)
+            coordsBuffer.addUpsideDownRect(method.rects.first, method.rects.second);
+        else
+            coordsBuffer.addUpsideDownQuad(method.rects.first, method.rects.second);
+    } else if(method.type == Pool::DrawMethodType::DRAW_REPEATED_TEXTURED_REPEATED_RECT) {
+        coordsBuffer.addRepeatedRects(method.rects.first, method.rects.second);
+    }
+}
+
+void DrawPool::drawColorRuns(const Pool::DrawObject& obj)
+{
+    const Color stateColor = g_painter->getColor();
+    for(size_t first = 0; first < obj.drawMethods.size();) {
+        const Color& color = obj.drawMethods[first].color;
+
+        m_coordsbuffer.clear();
+        size_t last = first;
+        for(; last < obj.drawMethods.size() && obj.drawMethods[last].color == color; ++last)
+            addCoords(m_coordsbuffer, obj.drawMethods[last], obj.drawMode);
+
+        g_painter->setColor(Color(color.rF() * stateColor.rF(), color.gF() * stateColor.gF(), color.bF() * stateColor.bF(), color.aF() * stateColor.aF()));
+        g_painter->drawCoords(m_coordsbuffer, obj.drawMode);
+        first = last;
+    }
+    g_painter->setColor(stateColor);
+}
+
+bool DrawPool::drawPackedObject(const Pool::DrawObject& obj)
+{
+    m_packedVertices.clear();
     for(const auto& method : obj.drawMethods) {
+        // objects added before the painter could pack quads still carry the color in their state
+        Color color = method.color;
+        if(obj.state.color != Color::white)
+            color = Color(color.rF() * obj.state.color.rF(), color.gF() * obj.state.color.gF(), color.bF() * obj.state.color.bF(), color.aF() * obj.state.color.aF());
+
         if(method.type == Pool::DrawMethodType::DRAW_BOUNDING_RECT) {
-            m_coordsbuffer.addBoudingRect(method.rects.first, method.intValue);
+            m_packedVertices.addBoudingRect(method.rects.first, method.intValue, color);
         } else if(method.type == Pool::DrawMethodType::DRAW_FILLED_RECT || method.type == Pool::DrawMethodType::DRAW_REPEATED_FILLED_RECT) {
-            m_coordsbuffer.addRect(method.rects.first);
+            m_packedVertices.addRect(method.rects.first, color);
         } else if(method.type == Pool::DrawMethodType::DRAW_FILLED_TRIANGLE) {
-            m_coordsbuffer.addTriangle(std::get<0>(method.points), std::get<1>(method.points), std::get<2>(method.points));
-        } else if(method.type == Pool::DrawMethodType::DRAW_TEXTURED_RECT || method.type == Pool::DrawMethodType::DRAW_REPEATED_TEXTURED_RECT) {
-            if(obj.drawMode == Painter::DrawMode::Triangles)
-                m_coordsbuffer.addRect(method.rects.first, method.rects.second);
-            else
-                m_coordsbuffer.addQuad(method.rects.first, method.rects.second);
+            m_packedVertices.addTriangle(std::get<0>(method.points), std::get<1>(method.points), std::get<2>(method.points), color);
+        } else if(method.type == Pool::DrawMethodType::DRAW_TEXTURED_RECT || method.type == Pool::DrawMethodType::DRAW_REPEATED_TEXTURED_RECT ||
+                  method.type == Pool::DrawMethodType::DRAW_OUTFIT_RECT) {
+            m_packedVertices.addQuad(method.rects.first, method.rects.second, color, method.layer);
         } else if(method.type == Pool::DrawMethodType::DRAW_UPSIDEDOWN_TEXTURED_RECT) {
-            if(obj.drawMode == Painter::DrawMode::Triangles)
-                m_coordsbuffer.addUpsideDownRect(method.rects.first, method.rects.second);
-            else
-                m_coordsbuffer.addUpsideDownQuad(method.rects.first, method.rects.second);
+            m_packedVertices.addUpsideDownQuad(method.rects.first, method.rects.second, color, method.layer);
         } else if(method.type == Pool::DrawMethodType::DRAW_REPEATED_TEXTURED_REPEATED_RECT) {
-            m_coordsbuffer.addRepeatedRects(method.rects.first, method.rects.second);
+            m_packedVertices.addRepeatedRects(method.rects.first, method.rects.second, color, method.layer);
         }
     }
 
-    g_painter->drawCoords(m_coordsbuffer, obj.drawMode);
-    m_coordsbuffer.clear();
+    if(m_packedVertices.isOutOfRange())
+        return false;
+
+    g_painter->drawPackedQuads(m_packedVertices, obj.state.texture != nullptr);
+    return true;
+}
+
+bool DrawPool::drawOutfitObject(const Pool::DrawObject& obj)
+{
+    static const std::array<uint32, 4> noMask{ 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF };
+
+    // objects without outfits stay on the cheaper packed quads
+    if(!obj.state.texture || std::none_of(obj.drawMethods.begin(), obj.drawMethods.end(), [](const Pool::DrawMethod& method) {
+        return method.type == Pool::DrawMethodType::DRAW_OUTFIT_RECT;
+    }))
+        return false;
+
+    m_packedOutfitVertices.clear();
+    for(const auto& method : obj.drawMethods) {
+        Color color = method.color;
+        if(obj.state.color != Color::white)
+            color = Color(color.rF() * obj.state.color.rF(), color.gF() * obj.state.color.gF(), color.bF() * obj.state.color.bF(), color.aF() * obj.state.color.aF());
+
+        if(method.type == Pool::DrawMethodType::DRAW_OUTFIT_RECT)
+            m_packedOutfitVertices.addQuad(method.rects.first, method.rects.second, color, method.maskOffset, method.maskColors);
+        else if(method.type == Pool::DrawMethodType::DRAW_TEXTURED_RECT || method.type == Pool::DrawMethodType::DRAW_REPEATED_TEXTURED_RECT)
+            m_packedOutfitVertices.addQuad(method.rects.first, method.rects.second, color, Point(), noMask);
+        else
+            return false;
+    }
+
+    if(m_packedOutfitVertices.isOutOfRange())
+        return false;
+
+    g_painter->drawPackedOutfitQuads(m_packedOutfitVertices);
+    return true;
 }
 
 void DrawPool::addTexturedRect(const Rect& dest, const TexturePtr& texture, const Color color)
@@ -189,7 +523,7 @@ void DrawPool::addTexturedRect(const Rect& dest, const TexturePtr& texture, cons
     addTexturedRect(dest, texture, Rect(Point(), texture->getSize()), color);
 }
 
-void DrawPool::addTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color, const Point& originalDest)
+void DrawPool::addTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color, const Point& originalDest, int layer)
 {
     if(dest.isEmpty() || src.isEmpty())
         return;
@@ -197,6 +531,7 @@ void DrawPool::addTexturedRect(const Rect& dest, const TexturePtr& texture, cons
     Pool::DrawMethod method{ Pool::DrawMethodType::DRAW_TEXTURED_RECT };
     method.rects = std::make_pair(dest, src);
     method.dest = originalDest;
+    method.layer = layer;
 
     auto state = generateState();
     state.color = color;
@@ -225,13 +560,14 @@ void DrawPool::addRepeatedTexturedRect(const Rect& dest, const TexturePtr& textu
     addRepeatedTexturedRect(dest, texture, Rect(Point(), texture->getSize()), color);
 }
 
-void DrawPool::addRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color)
+void DrawPool::addRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color, int layer)
 {
     if(dest.isEmpty() || src.isEmpty())
         return;
 
     Pool::DrawMethod method{ Pool::DrawMethodType::DRAW_REPEATED_TEXTURED_RECT };
     method.rects = std::make_pair(dest, src);
+    method.layer = layer;
 
     auto state = generateState();
     state.color = color;
@@ -255,6 +591,24 @@ void DrawPool::addRepeatedTexturedRepeatedRect(const Rect& dest, const TexturePt
     addRepeated(state, method);
 }
 
+void DrawPool::addOutfitRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Point& maskOffset, const std::array<uint32, 4>& maskColors, const Color color, const Point& originalDest)
+{
+    if(dest.isEmpty() || src.isEmpty())
+        return;
+
+    Pool::DrawMethod method{ Pool::DrawMethodType::DRAW_OUTFIT_RECT };
+    method.rects = std::make_pair(dest, src);
+    method.dest = originalDest;
+    method.maskOffset = maskOffset;
+    method.maskColors = maskColors;
+
+    auto state = generateState();
+    state.color = color;
+    state.texture = texture;
+
+    add(state, method, Painter::DrawMode::TriangleStrip);
+}
+
 void DrawPool::addRepeatedFilledRect(const Rect& dest, const Color color)
 {
     addRepeatedFilledRect(dest, Rect(), color);
@@ -322,9 +676,18 @@ void DrawPool::addBoundingRect(const Rect& dest, const Color color, int innerLin
     add(state, method);
 }
 
-void DrawPool::addAction(std::function<void()> action)
+void DrawPool::addAction(std::function<void()> action, size_t hash)
 {
-    m_currentPool->m_objects.push_back(Pool::DrawObject{ {}, Painter::DrawMode::None, {}, action });
+    // the hash describes what the action draws, so framed pools know when to redraw
+    addHash(hash);
+
+    m_currentPool->m_objects.push_back(Pool::DrawObject{ {}, Painter::DrawMode::None, m_currentPool->createMethodList(), std::move(action) });
+}
+
+void DrawPool::addHash(size_t hash)
+{
+    if(hash && m_currentPool->hasFrameBuffer())
+        boost::hash_combine(poolFramed()->m_status.second, hash);
 }
 
 Painter::PainterState DrawPool::generateState()
@@ -335,6 +698,8 @@ Painter::PainterState DrawPool::generateState()
     state.opacity = m_currentPool->m_state.opacity;
     state.alphaWriting = m_currentPool->m_state.alphaWriting;
     state.shaderProgram = m_currentPool->m_state.shaderProgram;
+    state.silhouette = m_currentPool->m_state.silhouette;
+    state.smoothSampling = m_currentPool->m_state.smoothSampling;
 
     return state;
 }
@@ -363,8 +728,11 @@ void DrawPool::updateHash(const Painter::PainterState& state, const Pool::DrawMe
     size_t hash = 0;
 
     if(state.texture) {
-        // TODO: use uniqueID id when applying multithreading, not forgetting that in the APNG texture, the id changes every frame.
+        // TODO: use uniqueID id when applying multithreading
         boost::hash_combine(hash, HASH_INT(state.texture->getId()));
+        // the frames of an animated texture share its id
+        if(state.texture->isAnimatedTexture())
+            boost::hash_combine(hash, HASH_INT(static_cast<AnimatedTexture*>(state.texture.get())->getCurrentFrame()));
     }
 
     if(state.opacity < 1.f)
@@ -392,7 +760,13 @@ void DrawPool::updateHash(const Painter::PainterState& state, const Pool::DrawMe
     if(!c.isNull()) boost::hash_combine(hash, c.hash());
 
     if(method.intValue) boost::hash_combine(hash, HASH_INT(method.intValue));
-    if(method.hash) boost::hash_combine(hash, method.hash);
+    if(method.color != Color::white) boost::hash_combine(hash, HASH_INT(method.color.rgba()));
+    if(method.layer) boost::hash_combine(hash, HASH_INT(method.layer));
+    if(method.type == Pool::DrawMethodType::DRAW_OUTFIT_RECT) {
+        boost::hash_combine(hash, method.maskOffset.hash());
+        for(const uint32 maskColor : method.maskColors)
+            boost::hash_combine(hash, HASH_INT(maskColor));
+    }
 
     boost::hash_combine(poolFramed()->m_status.second, hash);
 }
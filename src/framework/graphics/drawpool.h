@@ -27,13 +27,17 @@
 #include <framework/graphics/graphics.h>
 #include <framework/graphics/framebuffer.h>
 #include <framework/graphics/pool.h>
+#include <framework/graphics/gputimer.h>
 #include <framework/core/graphicalapplication.h>
 
 enum  PoolType : uint8 {
+    STATIC_FLOORS, // rendered before the map pool, which samples it
     MAP,
     CREATURE_INFORMATION,
+    STATIC_LIGHT,
     LIGHT,
     TEXT,
+    UI_CACHE,
     FOREGROUND,
     UNKNOW
 };
@@ -54,18 +58,22 @@ public:
     void use(const PoolFramedPtr& pool, const Rect& dest, const Rect& src);
 
     void addTexturedRect(const Rect& dest, const TexturePtr& texture, const Color color = Color::white);
-    void addTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color = Color::white, const Point& originalDest = Point());
+    void addTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color = Color::white, const Point& originalDest = Point(), int layer = 0);
     void addUpsideDownTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color = Color::white);
     void addRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Color color = Color::white);
-    void addRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color = Color::white);
+    void addRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color = Color::white, int layer = 0);
     void addRepeatedTexturedRepeatedRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Color color = Color::white);
+    // only for painters that canDrawOutfitMasks, other painters draw the base frame untinted
+    void addOutfitRect(const Rect& dest, const TexturePtr& texture, const Rect& src, const Point& maskOffset, const std::array<uint32, 4>& maskColors, const Color color = Color::white, const Point& originalDest = Point());
     void addRepeatedFilledRect(const Rect& dest, const Color color = Color::white);
     void addRepeatedFilledRect(const Rect& dest, const Rect& src, const Color color = Color::white);
     void addFilledRect(const Rect& dest, const Color color = Color::white);
     void addFilledRect(const Rect& dest, const Rect& src, const Color color = Color::white);
     void addFilledTriangle(const Point& a, const Point& b, const Point& c, const Color color = Color::white);
     void addBoundingRect(const Rect& dest, const Color color = Color::white, int innerLineWidth = 1);
-    void addAction(std::function<void()> action);
+    void addAction(std::function<void()> action, size_t hash = 0);
+    // for framed pools sampling textures drawn elsewhere, their own draw calls don't change when that content does
+    void addHash(size_t hash);
 
     void setCompositionMode(const Painter::CompositionMode mode, const int pos = -1) { m_currentPool->setCompositionMode(mode, pos); }
     void setClipRect(const Rect& clipRect, const int pos = -1) { m_currentPool->setClipRect(clipRect, pos); }
@@ -73,33 +81,94 @@ public:
     void setShaderProgram(const PainterShaderProgramPtr& shaderProgram, const int pos = -1) { m_currentPool->setShaderProgram(shaderProgram, pos); }
 
     void resetClipRect() { m_currentPool->resetClipRect(); }
+    const Rect& getClipRect() const { return m_currentPool->m_state.clipRect; }
     void resetCompositionMode() { m_currentPool->resetCompositionMode(); }
     void resetOpacity() { m_currentPool->resetOpacity(); }
     void resetState() { m_currentPool->resetState(); }
     void resetShaderProgram() { m_currentPool->resetShaderProgram(); }
+    // next textured draws are drawn as silhouettes or bilinear filtered, without a copy of their texture
+    void setSilhouette(bool silhouette) { m_currentPool->m_state.silhouette = silhouette; }
+    void setSmoothSampling(bool smooth) { m_currentPool->m_state.smoothSampling = smooth; }
+    void resetSampling() { m_currentPool->resetSampling(); }
+    // next draws are moved by offset and clipped to bounds, to record widgets away from their place on screen
+    void setTranslation(const Point& offset, const Rect& bounds) { m_currentPool->m_state.translation = offset; m_currentPool->m_state.translationBounds = bounds; }
+    void resetTranslation() { m_currentPool->resetTranslation(); }
 
     void startPosition() { m_currentPool->startPosition(); }
 
     size_t size() { return m_currentPool->m_objects.size(); }
 
+    void setGpuTimersEnabled(bool enabled);
+    bool isGpuTimersEnabled() { return m_gpuTimersEnabled; }
+
+    // painter counters and gpu time of the last frame, keyed by pool name
+    std::map<std::string, std::map<std::string, double>> getStatistics();
+
+    // drops what every pool recorded without drawing it, for frames recorded without a window
+    void discardFrame();
+
+    // microseconds per frame recording objects with add and addRepeated, and drawing the recorded frame
+    std::tuple<double, double, double> benchmark(int objects, int frames);
+
+    // the next frame drawn is written to fileName, with its pools, draw objects and the pixels of the textures they sample
+    void captureFrame(const std::string& fileName) { m_captureFile = fileName; }
+    bool isCapturing() { return !m_captureFile.empty() || m_captureStream != nullptr; }
+    // draws a captured frame in pools of its own, microseconds per frame spent submitting it and until the gpu finished it
+    std::tuple<double, double> replayCapture(const std::string& fileName, int frames);
+
 private:
+    enum DrawPhase : uint8 {
+        PHASE_PREPARE, // objects rendered into the pool framebuffer
+        PHASE_COMPOSE, // pool framebuffer or objects drawn to the screen
+        PHASE_COUNT
+    };
+
+    struct CapturedObject;
+    struct CapturedPool;
+
+    // objects are written before draw() consumes them, textures after it so pool framebuffers hold the finished frame
+    void beginCapture();
+    void endCapture();
+
+    void beginMeasure(size_t type, DrawPhase phase);
+    void endMeasure(size_t type);
+
+    // hands the recorded objects of every pool over to draw(), recording can start over right after
+    void swapFrames();
     void draw();
     void init();
     void terminate();
-    void drawObject(Pool::DrawObject& obj);
+    void drawObject(Pool::DrawObject& obj, FramedPool::CoordsCache* cache = nullptr);
+    void addCoords(CoordsBuffer& coordsBuffer, const Pool::DrawMethod& method, const Painter::DrawMode drawMode);
+    bool drawPackedObject(const Pool::DrawObject& obj);
+    bool drawOutfitObject(const Pool::DrawObject& obj);
+    void drawColorRuns(const Pool::DrawObject& obj);
+    void moveColorToMethod(Painter::PainterState& state, Pool::DrawMethod& method);
+    bool translate(Painter::PainterState& state, Pool::DrawMethod& method);
     void updateHash(const Painter::PainterState& state, const Pool::DrawMethod& method);
-    void add(const Painter::PainterState& state, const Pool::DrawMethod& method, const Painter::DrawMode drawMode = Painter::DrawMode::Triangles);
-    void addRepeated(const Painter::PainterState& state, const Pool::DrawMethod& method, const Painter::DrawMode drawMode = Painter::DrawMode::Triangles);
+    void add(Painter::PainterState& state, Pool::DrawMethod& method, const Painter::DrawMode drawMode = Painter::DrawMode::Triangles);
+    void addRepeated(Painter::PainterState& state, Pool::DrawMethod& method, const Painter::DrawMode drawMode = Painter::DrawMode::Triangles);
 
     PoolFramedPtr poolFramed() { return std::dynamic_pointer_cast<FramedPool>(m_currentPool); }
 
     Painter::PainterState generateState();
 
     CoordsBuffer m_coordsbuffer;
+    PackedVertexArray m_packedVertices;
+    PackedOutfitVertexArray m_packedOutfitVertices;
     std::array<PoolPtr, PoolType::UNKNOW + 1> m_pools;
 
     PoolPtr m_currentPool, n_unknowPool;
 
+    std::array<Painter::Statistics, PoolType::UNKNOW + 1> m_statistics;
+    Painter::Statistics m_measureStart;
+    GpuTimer m_gpuTimer;
+    bool m_gpuTimersEnabled = false;
+
+    std::string m_captureFile;
+    FileStreamPtr m_captureStream;
+    std::vector<TexturePtr> m_captureTextures;
+
     bool m_multiThread;
     friend class GraphicalApplication;
 };
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "drawpool.h"
+#include "arraytexture.h"
+#include "framebuffermanager.h"
+#include "image.h"
+#include "texture.h"
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+namespace {
+
+const uint32 CAPTURE_SIGNATURE = 0x50445443; // "CTDP"
+const uint16 CAPTURE_VERSION = 1;
+const uint32 NO_TEXTURE = 0xFFFFFFFF;
+
+enum CapturedTextureKind : uint8 {
+    TEXTURE_IMAGE,
+    TEXTURE_ARRAY,
+    // the framebuffer of a captured pool, replayed with the framebuffer of its replay pool
+    TEXTURE_POOL,
+    // compressed or otherwise not readable, replayed blank with the same size
+    TEXTURE_UNREADABLE
+};
+
+void addFloat(const FileStreamPtr& fin, float v) { uint32 bits; memcpy(&bits, &v, 4); fin->addU32(bits); }
+float getFloat(const FileStreamPtr& fin) { const uint32 bits = fin->getU32(); float v; memcpy(&v, &bits, 4); return v; }
+
+void addPoint(const FileStreamPtr& fin, const Point& p) { fin->add32(p.x); fin->add32(p.y); }
+Point getPoint(const FileStreamPtr& fin) { const int x = fin->get32(); return Point(x, fin->get32()); }
+
+void addRect(const FileStreamPtr& fin, const Rect& r) { fin->add32(r.x()); fin->add32(r.y()); fin->add32(r.width()); fin->add32(r.height()); }
+Rect getRect(const FileStreamPtr& fin) { const int x = fin->get32(), y = fin->get32(), w = fin->get32(); return Rect(x, y, w, fin->get32()); }
+
+void addColor(const FileStreamPtr& fin, const Color& c) { addFloat(fin, c.rF()); addFloat(fin, c.gF()); addFloat(fin, c.bF()); addFloat(fin, c.aF()); }
+Color getColor(const FileStreamPtr& fin) { const float r = getFloat(fin), g = getFloat(fin), b = getFloat(fin); return Color(r, g, b, getFloat(fin)); }
+
+void addMatrix(const FileStreamPtr& fin, const Matrix3& m)
+{
+    for(int i = 0; i < 9; ++i)
+        addFloat(fin, m.data()[i]);
+}
+
+Matrix3 getMatrix(const FileStreamPtr& fin)
+{
+    Matrix3 m;
+    for(int i = 0; i < 9; ++i)
+        m.data()[i] = getFloat(fin);
+    return m;
+}
+
+}
+
+struct DrawPool::CapturedObject {
+    Painter::PainterState state;
+    uint32 texture;
+    Painter::DrawMode drawMode;
+    size_t stateHash;
+    std::vector<Pool::DrawMethod> drawMethods;
+};
+
+struct DrawPool::CapturedPool {
+    bool enabled{ false };
+    bool framed{ false };
+    bool offscreen{ false };
+    bool smooth{ false };
+    bool hardwareCache{ false };
+    Size size;
+    Rect dest, src;
+    uint32 texture{ NO_TEXTURE };
+    std::vector<CapturedObject> objects;
+};
+
+void DrawPool::beginCapture()
+{
+    const std::string fileName = m_captureFile;
+    m_captureFile.clear();
+
+    std::unordered_map<Texture*, uint32> textureIndex;
+    auto indexOf = [&](const TexturePtr& texture) -> uint32 {
+        if(!texture)
+            return NO_TEXTURE;
+        auto it = textureIndex.emplace(texture.get(), m_captureTextures.size());
+        if(it.second)
+            m_captureTextures.push_back(texture);
+        return it.first->second;
+    };
+
+    uint32 actions = 0, shaders = 0;
+    try {
+        m_captureStream = g_resources.createFile(fileName);
+        m_captureStream->addU32(CAPTURE_SIGNATURE);
+        m_captureStream->addU16(CAPTURE_VERSION);
+        m_captureStream->addU8(m_pools.size());
+
+        for(const auto& pool : m_pools) {
+            const FramedPool* pf = pool->hasFrameBuffer() ? pool->toFramedPool() : nullptr;
+            m_captureStream->addU8(pool->isEnabled());
+            m_captureStream->addU8(pf != nullptr);
+            if(pf) {
+                const Size size = pf->m_framebuffer->getSize();
+                m_captureStream->addU8(pf->isOffscreen());
+                m_captureStream->addU8(pf->m_framebuffer->isSmooth());
+                m_captureStream->addU8(pf->isHardwareCached());
+                m_captureStream->add32(size.width());
+                m_captureStream->add32(size.height());
+                addRect(m_captureStream, pf->m_submitDest);
+                addRect(m_captureStream, pf->m_submitSrc);
+                m_captureStream->addU32(indexOf(pf->m_framebuffer->getTexture()));
+            }
+
+            // actions run arbitrary code and shader programs live in the modules, neither can be stored
+            uint32 count = 0;
+            for(const auto& obj : pool->m_submitObjects) {
+                if(obj.action) ++actions;
+                else ++count;
+                if(obj.state.shaderProgram) ++shaders;
+            }
+
+            m_captureStream->addU32(count);
+            for(const auto& obj : pool->m_submitObjects) {
+                if(obj.action) continue;
+
+                const Painter::PainterState& state = obj.state;
+                m_captureStream->add32(state.resolution.width());
+                m_captureStream->add32(state.resolution.height());
+                addMatrix(m_captureStream, state.transformMatrix);
+                addMatrix(m_captureStream, state.projectionMatrix);
+                addMatrix(m_captureStream, state.textureMatrix);
+                addColor(m_captureStream, state.color);
+                addFloat(m_captureStream, state.opacity);
+                m_captureStream->addU8(state.compositionMode);
+                m_captureStream->addU8(state.blendEquation);
+                addRect(m_captureStream, state.clipRect);
+                m_captureStream->addU32(indexOf(state.texture));
+                m_captureStream->addU8(state.alphaWriting);
+                m_captureStream->addU8(state.silhouette);
+                m_captureStream->addU8(state.smoothSampling);
+                m_captureStream->addU8(static_cast<uint8>(obj.drawMode));
+                m_captureStream->addU64(obj.stateHash);
+
+                m_captureStream->addU32(obj.drawMethods.size());
+                for(const auto& method : obj.drawMethods) {
+                    m_captureStream->addU8(static_cast<uint8>(method.type));
+                    m_captureStream->addU16(method.intValue);
+                    m_captureStream->addU16(method.layer);
+                    addRect(m_captureStream, method.rects.first);
+                    addRect(m_captureStream, method.rects.second);
+                    addPoint(m_captureStream, std::get<0>(method.points));
+                    addPoint(m_captureStream, std::get<1>(method.points));
+                    addPoint(m_captureStream, std::get<2>(method.points));
+                    addPoint(m_captureStream, method.dest);
+                    addColor(m_captureStream, method.color);
+                    addPoint(m_captureStream, method.maskOffset);
+                    for(const uint32 maskColor : method.maskColors)
+                        m_captureStream->addU32(maskColor);
+                }
+            }
+        }
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to capture frame to '%s': %s", fileName, e.what()));
+        m_captureStream = nullptr;
+        m_captureTextures.clear();
+        return;
+    }
+
+    if(actions > 0 || shaders > 0)
+        g_logger.warning(stdext::format("Frame capture skips %d actions, %d objects are replayed without their shader program", actions, shaders));
+}
+
+void DrawPool::endCapture()
+{
+    std::unordered_set<Texture*> poolTextures;
+    for(const auto& pool : m_pools) {
+        if(pool->hasFrameBuffer())
+            poolTextures.insert(pool->toFramedPool()->getTexture().get());
+    }
+
+    try {
+        m_captureStream->addU32(m_captureTextures.size());
+        for(const TexturePtr& texture : m_captureTextures) {
+            std::vector<ImagePtr> layers;
+            CapturedTextureKind kind = TEXTURE_POOL;
+            if(!poolTextures.count(texture.get())) {
+                const int layerCount = texture->isArrayTexture() ? static_cast<ArrayTexture*>(texture.get())->getLayers() : 1;
+                for(int layer = 0; layer < layerCount; ++layer) {
+                    const ImagePtr image = texture->readPixels(layer);
+                    if(!image) {
+                        layers.clear();
+                        break;
+                    }
+                    layers.push_back(image);
+                }
+                kind = layers.empty() ? TEXTURE_UNREADABLE : (texture->isArrayTexture() ? TEXTURE_ARRAY : TEXTURE_IMAGE);
+            }
+
+            m_captureStream->addU8(kind);
+            m_captureStream->add32(texture->getWidth());
+            m_captureStream->add32(texture->getHeight());
+            m_captureStream->addU8(texture->isSmooth());
+            m_captureStream->addU8(texture->hasRepeat());
+            m_captureStream->addU8(texture->isUpsideDown());
+            m_captureStream->addU8(texture->hasMipmaps());
+            m_captureStream->addU32(layers.size());
+            for(const ImagePtr& image : layers)
+                m_captureStream->write(image->getPixelData(), image->getPixels().size());
+        }
+
+        m_captureStream->close();
+        g_logger.info(stdext::format("Captured frame with %d textures to '%s'", m_captureTextures.size(), m_captureStream->name()));
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to capture frame to '%s': %s", m_captureStream->name(), e.what()));
+    }
+
+    m_captureStream = nullptr;
+    m_captureTextures.clear();
+}
+
+std::tuple<double, double> DrawPool::replayCapture(const std::string& fileName, int frames)
+{
+    frames = std::max<int>(1, frames);
+
+    std::vector<CapturedPool> captured;
+    std::vector<TexturePtr> textures;
+    try {
+        const FileStreamPtr fin = g_resources.openFile(fileName);
+        fin->cache();
+        if(fin->getU32() != CAPTURE_SIGNATURE)
+            stdext::throw_exception("not a frame capture");
+        if(fin->getU16() != CAPTURE_VERSION)
+            stdext::throw_exception("unsupported capture version");
+        if(fin->getU8() != m_pools.size())
+            stdext::throw_exception("captured with other pools");
+
+        captured.resize(m_pools.size());
+        for(CapturedPool& pool : captured) {
+            pool.enabled = fin->getU8();
+            pool.framed = fin->getU8();
+            if(pool.framed) {
+                pool.offscreen = fin->getU8();
+                pool.smooth = fin->getU8();
+                pool.hardwareCache = fin->getU8();
+                const int width = fin->get32();
+                pool.size = Size(width, fin->get32());
+                pool.dest = getRect(fin);
+                pool.src = getRect(fin);
+                pool.texture = fin->getU32();
+            }
+
+            pool.objects.resize(fin->getU32());
+            for(CapturedObject& obj : pool.objects) {
+                Painter::PainterState& state = obj.state;
+                const int width = fin->get32();
+                state.resolution = Size(width, fin->get32());
+                state.transformMatrix = getMatrix(fin);
+                state.projectionMatrix = getMatrix(fin);
+                state.textureMatrix = getMatrix(fin);
+                state.color = getColor(fin);
+                state.opacity = getFloat(fin);
+                state.compositionMode = static_cast<Painter::CompositionMode>(fin->getU8());
+                state.blendEquation = static_cast<Painter::BlendEquation>(fin->getU8());
+                state.clipRect = getRect(fin);
+                state.shaderProgram = nullptr;
+                obj.texture = fin->getU32();
+                state.alphaWriting = fin->getU8();
+                state.silhouette = fin->getU8();
+                state.smoothSampling = fin->getU8();
+                obj.drawMode = static_cast<Painter::DrawMode>(fin->getU8());
+                obj.stateHash = fin->getU64();
+
+                obj.drawMethods.resize(fin->getU32());
+                for(Pool::DrawMethod& method : obj.drawMethods) {
+                    method.type = static_cast<Pool::DrawMethodType>(fin->getU8());
+                    method.intValue = fin->getU16();
+                    method.layer = fin->getU16();
+                    method.rects.first = getRect(fin);
+                    method.rects.second = getRect(fin);
+                    std::get<0>(method.points) = getPoint(fin);
+                    std::get<1>(method.points) = getPoint(fin);
+                    std::get<2>(method.points) = getPoint(fin);
+                    method.dest = getPoint(fin);
+                    method.color = getColor(fin);
+                    method.maskOffset = getPoint(fin);
+                    for(uint32& maskColor : method.maskColors)
+                        maskColor = fin->getU32();
+                }
+            }
+        }
+
+        textures.resize(fin->getU32());
+        for(TexturePtr& texture : textures) {
+            const uint8 kind = fin->getU8();
+            const int width = fin->get32();
+            const Size size(width, fin->get32());
+            const bool smooth = fin->getU8(), repeat = fin->getU8(), upsideDown = fin->getU8(), mipmaps = fin->getU8();
+
+            std::vector<ImagePtr> layers(fin->getU32());
+            for(ImagePtr& image : layers) {
+                image = ImagePtr(new Image(size));
+                const uint bytes = image->getPixels().size();
+                if(fin->tell() + bytes > fin->cachedSize())
+                    stdext::throw_exception("truncated texture pixels");
+                memcpy(image->getPixelData(), fin->cachedData() + fin->tell(), bytes);
+                fin->skip(bytes);
+            }
+
+            // pool framebuffers are bound once the replay pools exist
+            if(kind == TEXTURE_POOL)
+                continue;
+
+            if(kind == TEXTURE_ARRAY) {
+                const ArrayTexturePtr array(new ArrayTexture(size, layers.size()));
+                for(size_t layer = 0; layer < layers.size(); ++layer)
+                    array->uploadLayerPixels(layer, Point(), size, layers[layer]->getPixelData());
+                texture = array;
+            } else
+                texture = TexturePtr(new Texture(layers.empty() ? ImagePtr(new Image(size)) : layers[0], mipmaps));
+
+            texture->setSmooth(smooth);
+            texture->setRepeat(repeat);
+            texture->setUpsideDown(upsideDown);
+        }
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to load frame capture '%s': %s", fileName, e.what()));
+        return std::make_tuple(0.0, 0.0);
+    }
+
+    // the replay pools stand in for the client pools, whatever the client recorded meanwhile is drawn next frame
+    std::array<PoolPtr, PoolType::UNKNOW + 1> clientPools;
+    std::swap(clientPools, m_pools);
+    for(size_t type = 0; type < captured.size(); ++type) {
+        const CapturedPool& pool = captured[type];
+        if(!pool.framed) {
+            createPool(static_cast<PoolType>(type))->setEnable(pool.enabled);
+            continue;
+        }
+
+        const PoolFramedPtr pf = createPoolF(static_cast<PoolType>(type));
+        pf->setEnable(pool.enabled);
+        pf->resize(pool.size);
+        pf->setSmooth(pool.smooth);
+        pf->setOffscreen(pool.offscreen);
+        pf->setHardwareCache(pool.hardwareCache);
+        if(pool.texture < textures.size())
+            textures[pool.texture] = pf->getTexture();
+    }
+
+    ticks_t submitElapsed = 0, finishElapsed = 0;
+    glFinish();
+    for(int frame = 0; frame < frames; ++frame) {
+        for(size_t type = 0; type < captured.size(); ++type) {
+            const PoolPtr& pool = m_pools[type];
+            for(const CapturedObject& obj : captured[type].objects) {
+                pool->m_objects.push_back(Pool::DrawObject{ obj.state, obj.drawMode, pool->createMethodList() });
+                Pool::DrawObject& drawObject = pool->m_objects.back();
+                drawObject.state.texture = obj.texture < textures.size() ? textures[obj.texture] : nullptr;
+                drawObject.drawMethods.assign(obj.drawMethods.begin(), obj.drawMethods.end());
+                drawObject.stateHash = obj.stateHash;
+            }
+            pool->swapObjects();
+
+            // every framed pool is rendered again, as in a frame where all of them changed
+            if(!pool->hasFrameBuffer()) continue;
+            const auto& pf = pool->toFramedPool();
+            pf->m_submitDest = captured[type].dest;
+            pf->m_submitSrc = captured[type].src;
+            pf->m_submitRedraw = true;
+        }
+
+        stdext::timer timer;
+        draw();
+        submitElapsed += timer.elapsed_micros();
+        glFinish();
+        finishElapsed += timer.elapsed_micros();
+    }
+    std::swap(clientPools, m_pools);
+
+    const double submitMicros = static_cast<double>(submitElapsed) / frames;
+    const double finishMicros = static_cast<double>(finishElapsed) / frames;
+    g_logger.info(stdext::format("Replayed '%s' %d times: submit %.1f us, finished %.1f us per frame", fileName, frames, submitMicros, finishMicros));
+    return std::make_tuple(submitMicros, finishMicros);
+}
@@ -22,6 +22,7 @@
 
 #include "fontmanager.h"
 #include "texture.h"
+#include "image.h"
 
 #include <framework/core/resourcemanager.h>
 #include <framework/otml/otml.h>
@@ -35,12 +36,14 @@ FontManager::FontManager()
 
 void FontManager::terminate()
 {
+    m_pendingImages.clear();
     m_fonts.clear();
     m_defaultFont = nullptr;
 }
 
 void FontManager::clearFonts()
 {
+    m_pendingImages.clear();
     m_fonts.clear();
     m_defaultFont = BitmapFontPtr(new BitmapFont("emptyfont"));
 }
@@ -78,6 +81,52 @@ bool FontManager::importFont(std::string file)
     }
 }
 
+int FontManager::prefetchFonts(const std::string& directory)
+{
+    int count = 0;
+    for(const std::string& fileName : g_resources.listDirectoryFiles(directory)) {
+        if(!g_resources.isFileType(fileName, "otfont"))
+            continue;
+
+        std::string file = directory + "/" + fileName;
+        stdext::replace_all(file, "//", "/");
+
+        try {
+            OTMLDocumentPtr doc = OTMLDocument::parse(file);
+            OTMLNodePtr textureNode = doc->at("Font")->at("texture");
+            const std::string textureFile = g_resources.guessFilePath(stdext::resolve_path(textureNode->value(), textureNode->source()), "png");
+            if(m_pendingImages.find(textureFile) != m_pendingImages.end())
+                continue;
+
+            m_pendingImages[textureFile] = g_asyncDispatcher.schedule([textureFile] {
+                std::stringstream fin(g_resources.readFileContents(textureFile));
+                return Image::decodePNG(fin);
+            }, AsyncDispatcher::PriorityHigh);
+            count++;
+        } catch(stdext::exception&) {
+            // importFont reports the broken file
+        }
+    }
+    return count;
+}
+
+ImagePtr FontManager::takePrefetchedImage(const std::string& file)
+{
+    const auto it = m_pendingImages.find(g_resources.guessFilePath(file, "png"));
+    if(it == m_pendingImages.end())
+        return nullptr;
+
+    const AsyncTask<ImagePtr> task = it->second;
+    m_pendingImages.erase(it);
+    try {
+        // blocks when the decoding is still running
+        return task.get();
+    } catch(stdext::exception&) {
+        // loaded again by the caller, which reports the error
+        return nullptr;
+    }
+}
+
 bool FontManager::fontExists(const std::string& fontName)
 {
     for(const BitmapFontPtr& font : m_fonts) {
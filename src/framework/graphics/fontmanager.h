@@ -24,6 +24,7 @@
 #define FONTMANAGER_H
 
 #include "bitmapfont.h"
+#include <framework/core/asyncdispatcher.h>
 
  //@bindsingleton g_fonts
 class FontManager
@@ -35,6 +36,10 @@ public:
     void clearFonts();
 
     bool importFont(std::string file);
+    /// Decodes the textures of the fonts under directory on the thread pool, returns the number of scheduled images
+    int prefetchFonts(const std::string& directory);
+    // @dontbind
+    ImagePtr takePrefetchedImage(const std::string& file);
 
     bool fontExists(const std::string& fontName);
     BitmapFontPtr getFont(const std::string& fontName);
@@ -45,6 +50,7 @@ public:
 private:
     std::vector<BitmapFontPtr> m_fonts;
     BitmapFontPtr m_defaultFont;
+    std::unordered_map<std::string, AsyncTask<ImagePtr>> m_pendingImages;
 };
 
 extern FontManager g_fonts;
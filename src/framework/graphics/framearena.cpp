@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "framearena.h"
+
+void* FrameArena::allocate(size_t bytes, size_t alignment)
+{
+    for(; m_block < m_blocks.size(); ++m_block, m_offset = 0) {
+        const Block& block = m_blocks[m_block];
+        const size_t start = (reinterpret_cast<size_t>(block.data.get()) + m_offset + alignment - 1) & ~(alignment - 1);
+        const size_t offset = start - reinterpret_cast<size_t>(block.data.get());
+        if(offset + bytes <= block.size) {
+            m_offset = offset + bytes;
+            m_usedBytes += bytes;
+            return block.data.get() + offset;
+        }
+    }
+
+    // the first frames grow the arena, later ones find every block already there
+    const size_t size = std::max<size_t>(BLOCK_SIZE, bytes + alignment);
+    m_blocks.push_back({ std::make_unique<uint8[]>(size), size });
+    ++m_blockAllocations;
+
+    const Block& block = m_blocks.back();
+    const size_t offset = ((reinterpret_cast<size_t>(block.data.get()) + alignment - 1) & ~(alignment - 1)) - reinterpret_cast<size_t>(block.data.get());
+    m_block = m_blocks.size() - 1;
+    m_offset = offset + bytes;
+    m_usedBytes += bytes;
+    return block.data.get() + offset;
+}
+
+size_t FrameArena::getCapacity() const
+{
+    size_t capacity = 0;
+    for(const Block& block : m_blocks)
+        capacity += block.size;
+    return capacity;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <framework/global.h>
+
+// linear allocator for data that lives for one recorded frame, reset() forgets every allocation at once
+// and keeps the blocks, so a steady frame does not reach the system allocator at all
+class FrameArena
+{
+public:
+    enum {
+        BLOCK_SIZE = 64 * 1024
+    };
+
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reset() { m_block = 0; m_offset = 0; m_usedBytes = 0; }
+
+    size_t getUsedBytes() const { return m_usedBytes; }
+    size_t getCapacity() const;
+    // blocks requested from the system since the arena was created
+    uint getBlockAllocations() const { return m_blockAllocations; }
+
+private:
+    struct Block {
+        std::unique_ptr<uint8[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    size_t m_block{ 0 },
+        m_offset{ 0 },
+        m_usedBytes{ 0 };
+    uint m_blockAllocations{ 0 };
+};
+
+// standard allocator over a FrameArena, deallocation is a no-op until the arena is reset
+template<class T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+
+    explicit FrameAllocator(FrameArena* arena) : m_arena(arena) {}
+    template<class U>
+    FrameAllocator(const FrameAllocator<U>& other) : m_arena(other.getArena()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    FrameArena* getArena() const { return m_arena; }
+
+    template<class U>
+    bool operator==(const FrameAllocator<U>& other) const { return m_arena == other.getArena(); }
+    template<class U>
+    bool operator!=(const FrameAllocator<U>& other) const { return m_arena != other.getArena(); }
+
+private:
+    FrameArena* m_arena;
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include <framework/platform/platformwindow.h>
 #include <framework/core/application.h>
 #include <framework/graphics/drawpool.h>
+#include <framework/graphics/framebuffermanager.h>
 
 uint FrameBuffer::boundFbo = 0;
 
@@ -64,28 +65,58 @@ void FrameBuffer::resize(const Size& size)
     if(m_texture && m_texture->getSize() == size)
         return;
 
-    m_texture = TexturePtr(new Texture(size));
-    m_texture->setSmooth(m_smooth);
-    m_texture->setUpsideDown(true);
+    // the old screen backup path allocates exactly what it needs
+    if(!m_fbo) {
+        m_texture = TexturePtr(new Texture(size));
+        m_texture->setSmooth(m_smooth);
+        m_texture->setUpsideDown(true);
 
-    if(m_fbo) {
-        internalBind();
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture->getId(), 0);
-
-        const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if(status != GL_FRAMEBUFFER_COMPLETE)
-            g_logger.fatal("Unable to setup framebuffer object");
-        internalRelease();
-    } else {
         if(m_backuping) {
             m_screenBackup = TexturePtr(new Texture(size));
             m_screenBackup->setUpsideDown(true);
         }
+        return;
     }
+
+    // sizes that fit the current attachment reuse it, growing past it takes one from the pool,
+    // shrinking is left to bind() once the size stops changing
+    m_resizeTimer.restart();
+    if(m_texture && m_texture->fitSize(size))
+        return;
+
+    setTexture(g_framebuffers.acquireTexture(size, m_smooth));
+}
+
+void FrameBuffer::setSmooth(bool enabled)
+{
+    m_smooth = enabled;
+    if(m_texture)
+        m_texture->setSmooth(enabled);
+}
+
+void FrameBuffer::setTexture(const TexturePtr& texture)
+{
+    g_framebuffers.releaseTexture(m_texture);
+    m_texture = texture;
+
+    internalBind();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture->getId(), 0);
+
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if(status != GL_FRAMEBUFFER_COMPLETE)
+        g_logger.fatal("Unable to setup framebuffer object");
+    internalRelease();
 }
 
 void FrameBuffer::bind()
 {
+    if(m_fbo && m_resizeTimer.ticksElapsed() > SHRINK_DELAY) {
+        const Size& glSize = m_texture->getGlSize();
+        const Size storage = g_framebuffers.getStorageSize(m_texture->getSize());
+        if(storage.width() < glSize.width() || storage.height() < glSize.height())
+            setTexture(g_framebuffers.acquireTexture(m_texture->getSize(), m_smooth));
+    }
+
     g_painter->saveAndResetState();
     internalBind();
     g_painter->setResolution(m_texture->getSize());
@@ -29,6 +29,7 @@
 #include <framework/core/scheduledevent.h>
 #include <framework/core/timer.h>
 #include <client/const.h>
+#include <framework/core/stats.h>
 
 enum class DrawMethodType {
     DRAW_FILL_COORDS,
@@ -44,7 +45,7 @@ enum class DrawMethodType {
     GL_ENABLE
 };
 
-class FrameBuffer : public stdext::shared_object
+class FrameBuffer : public stdext::shared_object, private StatsCounted<FrameBuffer>
 {
 public:
     ~FrameBuffer() override;
@@ -54,7 +55,7 @@ public:
     void bind();
     void draw(const Rect& dest, const Rect& src);
 
-    void setSmooth(bool enabled) { m_smooth = enabled; m_texture = nullptr; }
+    void setSmooth(bool enabled);
     void setBackuping(bool enabled) { m_backuping = enabled; }
 
     TexturePtr getTexture() { return m_texture; }
@@ -63,6 +64,8 @@ public:
     bool isBackuping() { return m_backuping; }
     bool isSmooth() { return m_smooth; }
 
+    static uint getBoundFbo() { return boundFbo; }
+
     void setCompositionMode(const Painter::CompositionMode mode) { m_compositeMode = mode; }
     void disableBlend() { m_disableBlend = true; }
 
@@ -74,7 +77,13 @@ protected:
     friend class FramedPool;
 
 private:
+    enum {
+        // how long a smaller size must hold before the attachment is shrunk
+        SHRINK_DELAY = 1000
+    };
+
     void internalCreate();
+    void setTexture(const TexturePtr& texture);
     void internalBind();
     void internalRelease();
 
@@ -84,6 +93,8 @@ private:
 
     Size m_oldViewportSize;
 
+    Timer m_resizeTimer;
+
     uint32 m_fbo, m_prevBoundFbo;
 
     Painter::CompositionMode m_compositeMode{ Painter::CompositionMode_Normal };
@@ -21,6 +21,9 @@
  */
 
 #include "framebuffermanager.h"
+#include "graphics.h"
+
+#include <framework/stdext/math.h>
 
 FrameBufferManager g_framebuffers;
 
@@ -33,6 +36,7 @@ void FrameBufferManager::init()
 void FrameBufferManager::terminate()
 {
     m_framebuffers.clear();
+    m_texturePool.clear();
     m_temporaryFramebuffer = nullptr;
 }
 
@@ -42,3 +46,76 @@ FrameBufferPtr FrameBufferManager::createFrameBuffer(const bool useAlphaWriting)
     m_framebuffers.push_back(fbo);
     return fbo;
 }
+
+TexturePtr FrameBufferManager::acquireTexture(const Size& size, const bool smooth)
+{
+    const Size storage = getStorageSize(size);
+
+    TexturePtr texture;
+    for(auto it = m_texturePool.begin(); it != m_texturePool.end(); ++it) {
+        if((*it)->getGlSize() == storage) {
+            texture = *it;
+            m_texturePool.erase(it);
+            break;
+        }
+    }
+
+    if(!texture) {
+        texture = TexturePtr(new Texture(storage));
+        texture->setUpsideDown(true);
+        ++m_allocations;
+    }
+
+    // storage beyond the maximum texture size could not be padded, allocate exactly
+    if(!texture->fitSize(size)) {
+        texture = TexturePtr(new Texture(size));
+        texture->setUpsideDown(true);
+    }
+
+    texture->setSmooth(smooth);
+    return texture;
+}
+
+void FrameBufferManager::releaseTexture(const TexturePtr& texture)
+{
+    if(!texture || texture->isEmpty())
+        return;
+
+    // the oldest released attachment is the least likely to be asked for again
+    if(m_texturePool.size() >= MAX_POOLED_TEXTURES)
+        m_texturePool.erase(m_texturePool.begin());
+
+    m_texturePool.push_back(texture);
+}
+
+Size FrameBufferManager::getStorageSize(const Size& size)
+{
+    const auto roundUp = [](const int value) { return std::max<int>(1, (value + TEXTURE_BUCKET_SIZE - 1) / TEXTURE_BUCKET_SIZE) * TEXTURE_BUCKET_SIZE; };
+
+    Size storage(roundUp(size.width()), roundUp(size.height()));
+    if(!g_graphics.canUseNonPowerOfTwoTextures())
+        storage.resize(stdext::to_power_of_two(storage.width()), stdext::to_power_of_two(storage.height()));
+    return storage;
+}
+
+uint64 FrameBufferManager::getMemoryUsage()
+{
+    uint64 memory = getTextureMemory(m_temporaryFramebuffer ? m_temporaryFramebuffer->getTexture() : nullptr);
+    for(const FrameBufferPtr& framebuffer : m_framebuffers)
+        memory += getTextureMemory(framebuffer->getTexture());
+    return memory + getPooledMemory();
+}
+
+uint64 FrameBufferManager::getPooledMemory()
+{
+    uint64 memory = 0;
+    for(const TexturePtr& texture : m_texturePool)
+        memory += getTextureMemory(texture);
+    return memory;
+}
+
+uint64 FrameBufferManager::getTextureMemory(const TexturePtr& texture)
+{
+    // attachments are always rgba
+    return texture ? static_cast<uint64>(texture->getGlSize().area()) * 4 : 0;
+}
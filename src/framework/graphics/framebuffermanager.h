@@ -27,6 +27,11 @@
 
 class FrameBufferManager
 {
+    enum {
+        TEXTURE_BUCKET_SIZE = 128,
+        MAX_POOLED_TEXTURES = 8
+    };
+
 public:
     void init();
     void terminate();
@@ -34,9 +39,25 @@ public:
     FrameBufferPtr createFrameBuffer(bool useAlphaWriting = false);
     const FrameBufferPtr& getTemporaryFrameBuffer() { return m_temporaryFramebuffer; }
 
+    // framebuffer attachments are allocated in buckets and recycled between resizes
+    TexturePtr acquireTexture(const Size& size, bool smooth);
+    void releaseTexture(const TexturePtr& texture);
+    Size getStorageSize(const Size& size);
+
+    uint64 getMemoryUsage();
+    uint64 getPooledMemory();
+    int getPooledCount() { return m_texturePool.size(); }
+    int getAllocationCount() { return m_allocations; }
+
 protected:
     FrameBufferPtr m_temporaryFramebuffer;
     std::vector<FrameBufferPtr> m_framebuffers;
+
+private:
+    static uint64 getTextureMemory(const TexturePtr& texture);
+
+    std::vector<TexturePtr> m_texturePool;
+    int m_allocations{ 0 };
 };
 
 extern FrameBufferManager g_framebuffers;
@@ -25,6 +25,7 @@
 
 #if OPENGL_ES==2
 #include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
 #elif OPENGL_ES==1
 #include <GLES/gl.h>
 
@@ -101,6 +102,8 @@ inline void glVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolea
 inline void glEnableVertexAttribArray(GLuint index) {}
 inline void glDisableVertexAttribArray(GLuint index) {}
 
+#elif defined(HEADLESS)
+#include "nullgl.h"
 #else
 #ifndef _MSC_VER
 #define GLEW_STATIC
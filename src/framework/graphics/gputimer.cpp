@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "gputimer.h"
+#include "glutil.h"
+
+void GpuTimer::terminate()
+{
+#ifndef OPENGL_ES
+    for(Slot& slot : m_slots) {
+        for(Query& query : slot.queries) {
+            if(query.id != 0)
+                glDeleteQueries(1, &query.id);
+        }
+    }
+#endif
+    m_slots.clear();
+    m_activeSlot = -1;
+}
+
+bool GpuTimer::collect(Query& query, double& micros)
+{
+#ifndef OPENGL_ES
+    GLint available = 0;
+    glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+        return false;
+
+    GLuint64 nanos = 0;
+    glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanos);
+    micros = nanos / 1000.0;
+#endif
+    query.pending = false;
+    return true;
+}
+
+void GpuTimer::nextFrame()
+{
+    m_frame = (m_frame + 1) % LATENCY;
+
+    // older queries finish first, so the newest collected result wins
+    for(Slot& slot : m_slots) {
+        for(int i = 0; i < LATENCY; ++i) {
+            Query& query = slot.queries[(m_frame + i) % LATENCY];
+            if(query.pending)
+                collect(query, slot.micros);
+        }
+    }
+}
+
+void GpuTimer::begin(int slot)
+{
+    assert(m_activeSlot == -1);
+    if(slot < 0 || slot >= (int)m_slots.size())
+        return;
+
+    Query& query = m_slots[slot].queries[m_frame];
+
+    // the gpu is more than LATENCY frames behind, skip this sample instead of stalling
+    if(query.pending && !collect(query, m_slots[slot].micros))
+        return;
+
+#ifndef OPENGL_ES
+    if(query.id == 0)
+        glGenQueries(1, &query.id);
+    glBeginQuery(GL_TIME_ELAPSED, query.id);
+#endif
+    m_activeSlot = slot;
+}
+
+void GpuTimer::end()
+{
+    if(m_activeSlot == -1)
+        return;
+
+#ifndef OPENGL_ES
+    glEndQuery(GL_TIME_ELAPSED);
+#endif
+    m_slots[m_activeSlot].queries[m_frame].pending = true;
+    m_activeSlot = -1;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include "declarations.h"
+
+// GL_TIME_ELAPSED queries read back a few frames late, so the cpu never waits on the gpu
+class GpuTimer
+{
+public:
+    enum {
+        LATENCY = 4 // frames a query may stay in flight
+    };
+
+    void resize(int slots) { m_slots.resize(slots); }
+    void terminate();
+
+    // advances the query ring and collects every finished result
+    void nextFrame();
+
+    // only one slot may be open at a time, GL does not nest elapsed time queries
+    void begin(int slot);
+    void end();
+
+    double getMicros(int slot) { return slot < (int)m_slots.size() ? m_slots[slot].micros : 0; }
+
+private:
+    struct Query {
+        uint id = 0;
+        bool pending = false;
+    };
+
+    struct Slot {
+        std::array<Query, LATENCY> queries;
+        double micros = 0;
+    };
+
+    static bool collect(Query& query, double& micros);
+
+    std::vector<Slot> m_slots;
+    int m_frame = 0;
+    int m_activeSlot = -1;
+};
+
+#endif
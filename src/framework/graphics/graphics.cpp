@@ -21,6 +21,7 @@
  */
 
 #include "fontmanager.h"
+#include "screencapture.h"
 
 #if OPENGL_ES==2
 #include "ogl/painterogl2.h"
@@ -39,6 +40,8 @@
 #include <framework/graphics/texture.h>
 #include <framework/graphics/drawpool.h>
 #include "texturemanager.h"
+#include "textureatlas.h"
+#include "compressedimage.h"
 #include "framebuffermanager.h"
 #include <framework/platform/platformwindow.h>
 
@@ -63,6 +66,10 @@ void Graphics::init()
     g_painterOGL2 = new PainterOGL2;
 #elif OPENGL_ES==1
     g_painterOGL1 = new PainterOGL1;
+#elif defined(HEADLESS)
+    // there are no extensions to load, both painters run on top of the no-op calls
+    g_painterOGL1 = new PainterOGL1;
+    g_painterOGL2 = new PainterOGL2;
 #else
     // init GL extensions
     const GLenum err = glewInit();
@@ -102,17 +109,26 @@ void Graphics::init()
     m_alphaBits = 0;
     glGetIntegerv(GL_ALPHA_BITS, &m_alphaBits);
 
+    int compressedFormats = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &compressedFormats);
+    m_compressedFormats.resize(compressedFormats);
+    if(compressedFormats > 0)
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, m_compressedFormats.data());
+
     m_ok = true;
 
     selectPainterEngine(m_prefferedPainterEngine);
 
     g_textures.init();
     g_framebuffers.init();
+    g_atlas.init();
 }
 
 void Graphics::terminate()
 {
     g_fonts.terminate();
+    g_screenCapture.terminate();
+    g_atlas.terminate();
     g_framebuffers.terminate();
     g_textures.terminate();
 
@@ -151,6 +167,18 @@ bool Graphics::parseOption(const std::string& option)
         m_useNonPowerOfTwoTextures = false;
     else if(option == "-no-clamp-to-edge")
         m_useClampToEdge = false;
+    else if(option == "-no-hardware-buffers")
+        m_useHardwareBuffers = false;
+    else if(option == "-no-packed-quads")
+        m_usePackedQuads = false;
+    else if(option == "-no-texture-arrays")
+        m_useTextureArrays = false;
+    else if(option == "-no-compressed-textures")
+        m_useCompressedTextures = false;
+    else if(option == "-no-shader-cache")
+        m_useProgramBinaries = false;
+    else if(option == "-no-async-readback")
+        m_useAsyncReadback = false;
     else if(option == "-no-backbuffer-cache")
         m_cacheBackbuffer = false;
     else if(option == "-opengl1")
@@ -238,6 +266,10 @@ bool Graphics::selectPainterEngine(PainterEngine painterEngine)
                 g_painter->unbind();
             painter->bind();
             g_painter = painter;
+
+            // the new painter can't sample atlas layers, move them back to 2D pages
+            if(g_atlas.hasLayers() && !painter->canDrawTextureArrays())
+                g_atlas.releaseLayers();
         }
 
         if(painterEngine == Painter_Any)
@@ -382,6 +414,117 @@ bool Graphics::canUseBlendEquation()
 #endif
 }
 
+bool Graphics::canUseTimerQuery()
+{
+#ifdef OPENGL_ES
+    return false;
+#else
+    // GL_TIME_ELAPSED came with ARB_timer_query, core in OpenGL 3.3
+    if(!GLEW_ARB_timer_query && !GLEW_VERSION_3_3)
+        return false;
+    return true;
+#endif
+}
+
+bool Graphics::canUsePackedQuads()
+{
+#ifdef OPENGL_ES
+    return false;
+#else
+    // the quad stream needs glMapBufferRange and glDrawElementsBaseVertex
+    if(!GLEW_VERSION_3_3 || !canUseHardwareBuffers())
+        return false;
+    return m_usePackedQuads;
+#endif
+}
+
+bool Graphics::canUseTextureArrays()
+{
+#ifdef OPENGL_ES
+    return false;
+#else
+    // array layers are sampled only by the packed quads program
+    if(!canUsePackedQuads() || !GLEW_EXT_texture_array)
+        return false;
+    return m_useTextureArrays;
+#endif
+}
+
+bool Graphics::canUseProgramBinaries()
+{
+#if OPENGL_ES==1
+    return false;
+#else
+    if(!m_useProgramBinaries)
+        return false;
+
+#if OPENGL_ES==2
+    if(getExtensions().find("GL_OES_get_program_binary") == std::string::npos)
+        return false;
+#else
+    if(!GLEW_ARB_get_program_binary)
+        return false;
+#endif
+
+    // some drivers expose the extension without any format to save
+    int formats = 0;
+#if OPENGL_ES==2
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+#else
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+#endif
+    return formats > 0;
+#endif
+}
+
+bool Graphics::canUseAsyncReadback()
+{
+#ifdef OPENGL_ES
+    return false;
+#else
+    // pixel buffers to read into and fences to know when the copy is done
+    if((!GLEW_ARB_pixel_buffer_object && !GLEW_VERSION_2_1) || (!GLEW_ARB_sync && !GLEW_VERSION_3_2))
+        return false;
+    return m_useAsyncReadback;
+#endif
+}
+
+bool Graphics::canUseCompressedFormat(uint format)
+{
+    if(!m_useCompressedTextures)
+        return false;
+
+    if(std::find(m_compressedFormats.begin(), m_compressedFormats.end(), static_cast<int>(format)) != m_compressedFormats.end())
+        return true;
+
+#ifndef OPENGL_ES
+    // drivers may leave formats out of the general purpose list, the extensions still allow them
+    if(format >= CompressedImage::RGB_S3TC_DXT1 && format <= CompressedImage::RGBA_S3TC_DXT5)
+        return GLEW_EXT_texture_compression_s3tc;
+    if(format == CompressedImage::RED_RGTC1 || format == CompressedImage::RG_RGTC2)
+        return GLEW_VERSION_3_0;
+    if(format >= CompressedImage::RGBA_BPTC_UNORM && format <= CompressedImage::RGB_BPTC_UNSIGNED_FLOAT)
+        return GLEW_ARB_texture_compression_bptc;
+    if(format >= CompressedImage::RGB8_ETC2 && format <= CompressedImage::SRGB8_ALPHA8_ETC2_EAC)
+        return GLEW_ARB_ES3_compatibility;
+#endif
+    return false;
+}
+
+bool Graphics::canUseHardwareBuffers()
+{
+#if OPENGL_ES==2
+    return m_useHardwareBuffers;
+#elif OPENGL_ES==1
+    return false;
+#else
+    // vertex buffer objects are supported by OpenGL 1.5
+    if(!GLEW_VERSION_1_5)
+        return false;
+    return m_useHardwareBuffers;
+#endif
+}
+
 bool Graphics::canCacheBackbuffer()
 {
     if(!m_alphaBits)
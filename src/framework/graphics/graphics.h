@@ -74,6 +74,14 @@ public:
     bool canUseClampToEdge();
     bool canUseBlendFuncSeparate();
     bool canUseBlendEquation();
+    bool canUseHardwareBuffers();
+    bool canUseTimerQuery();
+    bool canUsePackedQuads();
+    bool canUseTextureArrays();
+    bool canUseCompressedTextures() { return m_useCompressedTextures; }
+    bool canUseCompressedFormat(uint format);
+    bool canUseProgramBinaries();
+    bool canUseAsyncReadback();
     bool canCacheBackbuffer();
     bool shouldUseShaders() { return m_shouldUseShaders; }
     bool hasScissorBug();
@@ -83,6 +91,7 @@ private:
 
     int m_maxTextureSize;
     int m_alphaBits;
+    std::vector<int> m_compressedFormats;
 
     bool m_ok{ false },
         m_useDrawArrays{ true },
@@ -92,6 +101,12 @@ private:
         m_useMipmaps{ true },
         m_useHardwareMipmaps{ true },
         m_useClampToEdge{ true },
+        m_useHardwareBuffers{ true },
+        m_usePackedQuads{ true },
+        m_useTextureArrays{ true },
+        m_useCompressedTextures{ true },
+        m_useProgramBinaries{ true },
+        m_useAsyncReadback{ true },
         m_shouldUseShaders{ true },
         m_cacheBackbuffer{ true };
 
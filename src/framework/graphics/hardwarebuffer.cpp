@@ -28,7 +28,9 @@
 
 HardwareBuffer::HardwareBuffer(Type type)
 {
+    static uint64 lastSerial = 0;
     m_type = type;
+    m_serial = ++lastSerial;
     m_id = 0;
     glGenBuffers(1, &m_id);
     if(!m_id)
@@ -30,13 +30,19 @@ class HardwareBuffer
 public:
     enum Type {
         VertexBuffer = GL_ARRAY_BUFFER,
-        IndexBuffer = GL_ELEMENT_ARRAY_BUFFER
+        IndexBuffer = GL_ELEMENT_ARRAY_BUFFER,
+#ifndef OPENGL_ES
+        PixelPackBuffer = GL_PIXEL_PACK_BUFFER
+#endif
     };
 
     enum UsagePattern {
         StreamDraw = GL_STREAM_DRAW,
         StaticDraw = GL_STATIC_DRAW,
-        DynamicDraw = GL_DYNAMIC_DRAW
+        DynamicDraw = GL_DYNAMIC_DRAW,
+#ifndef OPENGL_ES
+        StreamRead = GL_STREAM_READ
+#endif
     };
 
     HardwareBuffer(Type type);
@@ -44,11 +50,18 @@ public:
 
     void bind() { glBindBuffer(m_type, m_id); }
     static void unbind(Type type) { glBindBuffer(type, 0); }
-    void write(void* data, int count, UsagePattern usage) { glBufferData(m_type, count, data, usage); }
+    void write(void* data, int count, UsagePattern usage) { glBufferData(m_type, count, data, usage); m_size = count; }
+    void writeRange(int offset, void* data, int count) { glBufferSubData(m_type, offset, count, data); }
+
+    int size() const { return m_size; }
+    // unlike the GL id, the serial is never reused by a later buffer
+    uint64 getSerial() const { return m_serial; }
 
 private:
     Type m_type;
     uint m_id;
+    int m_size{ 0 };
+    uint64 m_serial;
 };
 
 #endif
@@ -28,6 +28,114 @@
 
 #include "framework/stdext/math.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // the color as the four bytes of a pixel read into one word
+    uint32 pixelWord(const Color& color)
+    {
+        const uint8 bytes[4] = { color.r(), color.g(), color.b(), color.a() };
+        uint32 word;
+        memcpy(&word, bytes, 4);
+        return word;
+    }
+
+    // the vector versions handle four pixels per step and return how many pixels they did,
+    // the scalar loops finish the rest
+#if defined(__SSE2__)
+    int blitPixelsSse2(uint8* dest, const uint8* src, int count)
+    {
+        const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        const __m128i zero = _mm_setzero_si128();
+
+        int p = 0;
+        for(; p + 4 <= count; p += 4) {
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + p * 4));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + p * 4));
+            const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + p * 4), _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, s)));
+        }
+        return p;
+    }
+
+    int maskPixelsSse2(uint8* pixels, int count, uint32 masked, uint32 inside, uint32 outside)
+    {
+        const __m128i maskedColor = _mm_set1_epi32(static_cast<int>(masked));
+        const __m128i insideColor = _mm_set1_epi32(static_cast<int>(inside));
+        const __m128i outsideColor = _mm_set1_epi32(static_cast<int>(outside));
+
+        int p = 0;
+        for(; p + 4 <= count; p += 4) {
+            const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + p * 4));
+            const __m128i equal = _mm_cmpeq_epi32(pixel, maskedColor);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + p * 4), _mm_or_si128(_mm_and_si128(equal, insideColor), _mm_andnot_si128(equal, outsideColor)));
+        }
+        return p;
+    }
+
+    int overwritePixelsSse2(uint8* pixels, int count, uint32 color)
+    {
+        const __m128i fillColor = _mm_set1_epi32(static_cast<int>(color));
+        const __m128i zero = _mm_setzero_si128();
+
+        int p = 0;
+        for(; p + 4 <= count; p += 4) {
+            const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + p * 4));
+            const __m128i transparent = _mm_cmpeq_epi32(pixel, zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + p * 4), _mm_andnot_si128(transparent, fillColor));
+        }
+        return p;
+    }
+#elif defined(__ARM_NEON)
+    int blitPixelsNeon(uint8* dest, const uint8* src, int count)
+    {
+        const uint32x4_t alphaMask = vdupq_n_u32(0xFF000000);
+        const uint32x4_t zero = vdupq_n_u32(0);
+
+        int p = 0;
+        for(; p + 4 <= count; p += 4) {
+            const uint32x4_t s = vld1q_u32(reinterpret_cast<const uint32_t*>(src + p * 4));
+            const uint32x4_t d = vld1q_u32(reinterpret_cast<const uint32_t*>(dest + p * 4));
+            const uint32x4_t transparent = vceqq_u32(vandq_u32(s, alphaMask), zero);
+            vst1q_u32(reinterpret_cast<uint32_t*>(dest + p * 4), vbslq_u32(transparent, d, s));
+        }
+        return p;
+    }
+
+    int maskPixelsNeon(uint8* pixels, int count, uint32 masked, uint32 inside, uint32 outside)
+    {
+        const uint32x4_t maskedColor = vdupq_n_u32(masked);
+        const uint32x4_t insideColor = vdupq_n_u32(inside);
+        const uint32x4_t outsideColor = vdupq_n_u32(outside);
+
+        int p = 0;
+        for(; p + 4 <= count; p += 4) {
+            const uint32x4_t pixel = vld1q_u32(reinterpret_cast<const uint32_t*>(pixels + p * 4));
+            vst1q_u32(reinterpret_cast<uint32_t*>(pixels + p * 4), vbslq_u32(vceqq_u32(pixel, maskedColor), insideColor, outsideColor));
+        }
+        return p;
+    }
+
+    int overwritePixelsNeon(uint8* pixels, int count, uint32 color)
+    {
+        const uint32x4_t fillColor = vdupq_n_u32(color);
+        const uint32x4_t zero = vdupq_n_u32(0);
+
+        int p = 0;
+        for(; p + 4 <= count; p += 4) {
+            const uint32x4_t pixel = vld1q_u32(reinterpret_cast<const uint32_t*>(pixels + p * 4));
+            vst1q_u32(reinterpret_cast<uint32_t*>(pixels + p * 4), vbslq_u32(vceqq_u32(pixel, zero), zero, fillColor));
+        }
+        return p;
+    }
+#endif
+}
+
 Image::Image(const Size& size, int bpp, uint8* pixels)
 {
     m_size = size;
@@ -36,6 +144,19 @@ Image::Image(const Size& size, int bpp, uint8* pixels)
     m_pixels.resize(size.area() * bpp, 0);
     if(pixels)
         memcpy(&m_pixels[0], pixels, m_pixels.size());
+    updateStatsBytes();
+}
+
+Image::~Image()
+{
+    addStatsBytes(-m_statsBytes);
+}
+
+void Image::updateStatsBytes()
+{
+    const int64 bytes = m_pixels.size();
+    addStatsBytes(bytes - m_statsBytes);
+    m_statsBytes = bytes;
 }
 
 ImagePtr Image::load(std::string file)
@@ -56,6 +177,11 @@ ImagePtr Image::loadPNG(const std::string& file)
 {
     std::stringstream fin;
     g_resources.readFileStream(file, fin);
+    return decodePNG(fin);
+}
+
+ImagePtr Image::decodePNG(std::stringstream& fin)
+{
     ImagePtr image;
     apng_data apng;
     if(load_apng(fin, &apng) == 0) {
@@ -63,6 +189,9 @@ ImagePtr Image::loadPNG(const std::string& file)
         free_apng(&apng);
     }
 
+    if(!image)
+        stdext::throw_exception("unable to decode png");
+
     int cntTransparentPixel = 0;
     for(const auto& pixel : image->getPixels()) {
         if(pixel == 0 && ++cntTransparentPixel == 4) {
@@ -91,40 +220,50 @@ void Image::savePNG(const std::string& fileName)
 void Image::overwriteMask(const Color& maskedColor, const Color& insideColor, const Color& outsideColor)
 {
     assert(m_bpp == 4);
-
-    for(int p = 0; p < getPixelCount(); ++p) {
-        uint8& r = m_pixels[p * 4 + 0];
-        uint8& g = m_pixels[p * 4 + 1];
-        uint8& b = m_pixels[p * 4 + 2];
-        uint8& a = m_pixels[p * 4 + 3];
-
-        Color pixelColor(r, g, b, a);
-        Color writeColor = (pixelColor == maskedColor) ? insideColor : outsideColor;
-
-        r = writeColor.r();
-        g = writeColor.g();
-        b = writeColor.b();
-        a = writeColor.a();
-    }
+    maskPixels(getPixelData(), getPixelCount(), maskedColor, insideColor, outsideColor);
 }
 
 void Image::overwrite(const Color& color)
 {
     assert(m_bpp == 4);
+    overwritePixels(getPixelData(), getPixelCount(), color);
+}
 
-    for(int p = 0; p < getPixelCount(); ++p) {
-        uint8& r = m_pixels[p * 4 + 0];
-        uint8& g = m_pixels[p * 4 + 1];
-        uint8& b = m_pixels[p * 4 + 2];
-        uint8& a = m_pixels[p * 4 + 3];
-
-        Color pixelColor(r, g, b, a);
-        Color writeColor = (pixelColor == Color::alpha) ? Color::alpha : color;
+void Image::maskPixels(uint8* pixels, int count, const Color& maskedColor, const Color& insideColor, const Color& outsideColor)
+{
+    const uint32 masked = pixelWord(maskedColor);
+    const uint32 inside = pixelWord(insideColor);
+    const uint32 outside = pixelWord(outsideColor);
+
+    int p = 0;
+#if defined(__SSE2__)
+    p = maskPixelsSse2(pixels, count, masked, inside, outside);
+#elif defined(__ARM_NEON)
+    p = maskPixelsNeon(pixels, count, masked, inside, outside);
+#endif
+    for(; p < count; ++p) {
+        uint32 pixel;
+        memcpy(&pixel, pixels + p * 4, 4);
+        memcpy(pixels + p * 4, pixel == masked ? &inside : &outside, 4);
+    }
+}
 
-        r = writeColor.r();
-        g = writeColor.g();
-        b = writeColor.b();
-        a = writeColor.a();
+void Image::overwritePixels(uint8* pixels, int count, const Color& color)
+{
+    // fully transparent pixels stay as they are, any other takes the color
+    const uint32 fill = pixelWord(color);
+
+    int p = 0;
+#if defined(__SSE2__)
+    p = overwritePixelsSse2(pixels, count, fill);
+#elif defined(__ARM_NEON)
+    p = overwritePixelsNeon(pixels, count, fill);
+#endif
+    for(; p < count; ++p) {
+        uint32 pixel;
+        memcpy(&pixel, pixels + p * 4, 4);
+        if(pixel != 0)
+            memcpy(pixels + p * 4, &fill, 4);
     }
 }
 
@@ -135,21 +274,26 @@ void Image::blit(const Point& dest, const ImagePtr& other)
     if(!other)
         return;
 
-    int coloredPixelSize = 0;
+    // pixels with any alpha replace the destination, fully transparent ones leave it
+    const int width = other->getWidth();
+    const uint8* otherPixels = other->getPixelData();
+    for(int y = 0; y < other->getHeight(); ++y) {
+        const int pos = ((dest.y + y) * m_size.width() + dest.x) * 4;
+        blitPixels(&m_pixels[pos], otherPixels + y * width * 4, width);
+    }
+}
 
-    uint8* otherPixels = other->getPixelData();
-    for(int p = 0; p < other->getPixelCount(); ++p) {
-        const int x = p % other->getWidth();
-        const int y = p / other->getWidth();
-        const int pos = ((dest.y + y) * m_size.width() + (dest.x + x)) * 4;
-
-        if(otherPixels[p * 4 + 3] != 0) {
-            m_pixels[pos + 0] = otherPixels[p * 4 + 0];
-            m_pixels[pos + 1] = otherPixels[p * 4 + 1];
-            m_pixels[pos + 2] = otherPixels[p * 4 + 2];
-            m_pixels[pos + 3] = otherPixels[p * 4 + 3];
-            ++coloredPixelSize;
-        }
+void Image::blitPixels(uint8* dest, const uint8* src, int count)
+{
+    int p = 0;
+#if defined(__SSE2__)
+    p = blitPixelsSse2(dest, src, count);
+#elif defined(__ARM_NEON)
+    p = blitPixelsNeon(dest, src, count);
+#endif
+    for(; p < count; ++p) {
+        if(src[p * 4 + 3] != 0)
+            memcpy(dest + p * 4, src + p * 4, 4);
     }
 }
 
@@ -230,6 +374,7 @@ bool Image::nextMipmap()
 
     m_pixels = pixels;
     m_size = Size(ow, oh);
+    updateStatsBytes();
     return true;
 }
 
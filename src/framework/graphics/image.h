@@ -25,14 +25,18 @@
 
 #include "declarations.h"
 #include <framework/util/databuffer.h>
+#include <framework/core/stats.h>
 
-class Image : public stdext::shared_object
+class Image : public stdext::shared_object, private StatsCounted<Image>
 {
 public:
     Image(const Size& size, int bpp = 4, uint8* pixels = nullptr);
+    ~Image();
 
     static ImagePtr load(std::string file);
     static ImagePtr loadPNG(const std::string& file);
+    // does not touch the resource manager, safe to call from worker threads
+    static ImagePtr decodePNG(std::stringstream& fin);
 
     void savePNG(const std::string& fileName);
 
@@ -40,7 +44,12 @@ public:
     void overwrite(const Color& color);
     void blit(const Point& dest, const ImagePtr& other);
     void paste(const ImagePtr& other);
-    void resize(const Size& size) { m_size = size; m_pixels.resize(size.area() * m_bpp, 0); }
+
+    // the same operations on rows of RGBA pixels that don't live in an Image
+    static void maskPixels(uint8* pixels, int count, const Color& maskedColor, const Color& insideColor = Color::white, const Color& outsideColor = Color::alpha);
+    static void overwritePixels(uint8* pixels, int count, const Color& color);
+    static void blitPixels(uint8* dest, const uint8* src, int count);
+    void resize(const Size& size) { m_size = size; m_pixels.resize(size.area() * m_bpp, 0); updateStatsBytes(); }
     bool nextMipmap();
 
     void setPixel(int x, int y, uint8* pixel) { memcpy(&m_pixels[(y * m_size.width() + x) * m_bpp], pixel, m_bpp); }
@@ -59,8 +68,11 @@ public:
     void setTransparentPixel(const bool value) { m_transparentPixel = value; }
 
 private:
+    void updateStatsBytes();
+
     std::vector<uint8> m_pixels;
     Size m_size;
+    int64 m_statsBytes = 0;
 
     int m_bpp;
     bool m_transparentPixel{ false };
@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef NULLGL_H
+#define NULLGL_H
+
+// OpenGL for headless builds, every call is a no-op so the painters still run all their cpu side work
+// without a context; names are handed out, status queries succeed and mapped buffers point to scratch memory
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef unsigned int GLenum;
+typedef unsigned char GLboolean;
+typedef unsigned int GLbitfield;
+typedef void GLvoid;
+typedef signed char GLbyte;
+typedef short GLshort;
+typedef int GLint;
+typedef unsigned char GLubyte;
+typedef unsigned short GLushort;
+typedef unsigned int GLuint;
+typedef int GLsizei;
+typedef float GLfloat;
+typedef float GLclampf;
+typedef double GLdouble;
+typedef double GLclampd;
+typedef char GLchar;
+typedef std::ptrdiff_t GLintptr;
+typedef std::ptrdiff_t GLsizeiptr;
+typedef int64_t GLint64;
+typedef uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
+
+#define GL_ALPHA_BITS 0x0D55
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_BLEND 0x0BE2
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_COLOR_BUFFER_BIT 0x00004000
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_COMPRESSED_RGBA 0x84EE
+#define GL_COMPRESSED_TEXTURE_FORMATS 0x86A3
+#define GL_DST_ALPHA 0x0304
+#define GL_DST_COLOR 0x0306
+#define GL_DYNAMIC_DRAW 0x88E8
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_EXTENSIONS 0x1F03
+#define GL_FALSE 0
+#define GL_FLOAT 0x1406
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_FUNC_ADD 0x8006
+#define GL_FUNC_REVERSE_SUBTRACT 0x800B
+#define GL_FUNC_SUBTRACT 0x800A
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_LINEAR 0x2601
+#define GL_LINEAR_MIPMAP_LINEAR 0x2703
+#define GL_LINK_STATUS 0x8B82
+#define GL_LUMINANCE 0x1909
+#define GL_LUMINANCE_ALPHA 0x190A
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_READ_BIT 0x0001
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAX 0x8008
+#define GL_MAX_TEXTURE_SIZE 0x0D33
+#define GL_MIN 0x8007
+#define GL_MODELVIEW 0x1700
+#define GL_NEAREST 0x2600
+#define GL_NEAREST_MIPMAP_NEAREST 0x2700
+#define GL_NONE 0
+#define GL_NO_ERROR 0
+#define GL_NUM_COMPRESSED_TEXTURE_FORMATS 0x86A2
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_ONE 1
+#define GL_ONE_MINUS_DST_ALPHA 0x0305
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+#define GL_ONE_MINUS_SRC_COLOR 0x0301
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROJECTION 0x1701
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_RENDERER 0x1F01
+#define GL_REPEAT 0x2901
+#define GL_RGB 0x1907
+#define GL_RGBA 0x1908
+#define GL_RGBA8 0x8058
+#define GL_SCISSOR_TEST 0x0C11
+#define GL_SHORT 0x1402
+#define GL_SRC_ALPHA 0x0302
+#define GL_SRC_COLOR 0x0300
+#define GL_STATIC_DRAW 0x88E4
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STREAM_READ 0x88E1
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_TEXTURE 0x1702
+#define GL_TEXTURE0 0x84C0
+#define GL_TEXTURE1 0x84C1
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#define GL_TEXTURE_COORD_ARRAY 0x8078
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_TRIANGLES 0x0004
+#define GL_TRIANGLE_STRIP 0x0005
+#define GL_TRUE 1
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_UNSIGNED_SHORT 0x1403
+#define GL_VENDOR 0x1F00
+#define GL_VERSION 0x1F02
+#define GL_VERTEX_ARRAY 0x8074
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_ZERO 0
+
+// the capabilities of a plain OpenGL 2.1 driver, optional paths that need newer versions stay off
+#define GLEW_OK 0
+#define GLEW_VERSION_1_1 true
+#define GLEW_VERSION_1_2 true
+#define GLEW_VERSION_1_4 true
+#define GLEW_VERSION_1_5 true
+#define GLEW_VERSION_2_0 true
+#define GLEW_VERSION_2_1 true
+#define GLEW_VERSION_3_0 false
+#define GLEW_VERSION_3_2 false
+#define GLEW_VERSION_3_3 false
+#define GLEW_ARB_framebuffer_object true
+#define GLEW_EXT_framebuffer_object true
+#define GLEW_ARB_vertex_program true
+#define GLEW_ARB_vertex_shader true
+#define GLEW_ARB_fragment_shader true
+#define GLEW_ARB_texture_non_power_of_two true
+#define GLEW_ARB_ES3_compatibility false
+#define GLEW_ARB_buffer_storage false
+#define GLEW_ARB_get_program_binary false
+#define GLEW_ARB_pixel_buffer_object false
+#define GLEW_ARB_sync false
+#define GLEW_ARB_texture_compression_bptc false
+#define GLEW_ARB_timer_query false
+#define GLEW_EXT_texture_array false
+#define GLEW_EXT_texture_compression_s3tc false
+
+namespace nullgl {
+    enum { MAX_TEXTURE_SIZE = 8192 };
+
+    inline GLuint nextName()
+    {
+        static GLuint lastName = 0;
+        return ++lastName;
+    }
+
+    inline void genNames(GLsizei n, GLuint* names)
+    {
+        for(GLsizei i = 0; i < n; ++i)
+            names[i] = nextName();
+    }
+
+    inline void* mapBuffer(GLsizeiptr length)
+    {
+        static std::vector<char> scratch;
+        if(scratch.size() < static_cast<std::size_t>(length))
+            scratch.resize(length);
+        return scratch.data();
+    }
+
+    inline GLsync signaledSync()
+    {
+        static char sync;
+        return reinterpret_cast<GLsync>(&sync);
+    }
+}
+
+inline void glActiveTexture(GLenum texture) {}
+inline void glAttachShader(GLuint program, GLuint shader) {}
+inline void glBegin(GLenum mode) {}
+inline void glBeginQuery(GLenum target, GLuint id) {}
+inline void glBindAttribLocation(GLuint program, GLuint index, const GLchar *name) {}
+inline void glBindBuffer(GLenum target, GLuint buffer) {}
+inline void glBindFramebuffer(GLenum target, GLuint framebuffer) {}
+inline void glBindFramebufferEXT(GLenum target, GLuint framebuffer) {}
+inline void glBindTexture(GLenum target, GLuint texture) {}
+inline void glBlendEquation(GLenum mode) {}
+inline void glBlendFunc(GLenum sfactor, GLenum dfactor) {}
+inline void glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha) {}
+inline void glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {}
+inline void glBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) {}
+inline void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {}
+inline GLenum glCheckFramebufferStatus(GLenum target) { return GL_FRAMEBUFFER_COMPLETE; }
+inline GLenum glCheckFramebufferStatusEXT(GLenum target) { return GL_FRAMEBUFFER_COMPLETE; }
+inline void glClear(GLbitfield mask) {}
+inline void glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {}
+inline GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) { return GL_ALREADY_SIGNALED; }
+inline void glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {}
+inline void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {}
+inline void glCompileShader(GLuint shader) {}
+inline void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data) {}
+inline void glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height) {}
+inline void glCopyTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLint x, GLint y, GLsizei width, GLsizei height) {}
+inline GLuint glCreateProgram() { return nullgl::nextName(); }
+inline GLuint glCreateShader(GLenum type) { return nullgl::nextName(); }
+inline void glDeleteBuffers(GLsizei n, const GLuint *buffers) {}
+inline void glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers) {}
+inline void glDeleteFramebuffersEXT(GLsizei n, const GLuint *framebuffers) {}
+inline void glDeleteProgram(GLuint program) {}
+inline void glDeleteQueries(GLsizei n, const GLuint *ids) {}
+inline void glDeleteShader(GLuint shader) {}
+inline void glDeleteSync(GLsync sync) {}
+inline void glDeleteTextures(GLsizei n, const GLuint *textures) {}
+inline void glDetachShader(GLuint program, GLuint shader) {}
+inline void glDisable(GLenum cap) {}
+inline void glDisableClientState(GLenum cap) {}
+inline void glDisableVertexAttribArray(GLuint index) {}
+inline void glDrawArrays(GLenum mode, GLint first, GLsizei count) {}
+inline void glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void *indices, GLint basevertex) {}
+inline void glEnable(GLenum cap) {}
+inline void glEnableClientState(GLenum cap) {}
+inline void glEnableVertexAttribArray(GLuint index) {}
+inline void glEnd() {}
+inline void glEndQuery(GLenum target) {}
+inline GLsync glFenceSync(GLenum condition, GLbitfield flags) { return nullgl::signaledSync(); }
+inline void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {}
+inline void glFramebufferTexture2DEXT(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {}
+inline void glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer) {}
+inline void glGenBuffers(GLsizei n, GLuint *buffers) { nullgl::genNames(n, buffers); }
+inline void glGenFramebuffers(GLsizei n, GLuint *framebuffers) { nullgl::genNames(n, framebuffers); }
+inline void glGenFramebuffersEXT(GLsizei n, GLuint *framebuffers) { nullgl::genNames(n, framebuffers); }
+inline void glGenQueries(GLsizei n, GLuint *ids) { nullgl::genNames(n, ids); }
+inline void glGenTextures(GLsizei n, GLuint *textures) { nullgl::genNames(n, textures); }
+inline void glGenerateMipmap(GLenum target) {}
+inline void glGenerateMipmapEXT(GLenum target) {}
+inline GLint glGetAttribLocation(GLuint program, const GLchar *name) { return 0; }
+inline void glGetIntegerv(GLenum pname, GLint *data) { *data = pname == GL_MAX_TEXTURE_SIZE ? nullgl::MAX_TEXTURE_SIZE : 0; }
+inline void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) {}
+inline void glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog) {}
+inline void glGetProgramiv(GLuint program, GLenum pname, GLint *params) { *params = pname == GL_LINK_STATUS ? GL_TRUE : 0; }
+inline void glGetQueryObjectiv(GLuint id, GLenum pname, GLint *params) { *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0; }
+inline void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params) { *params = 0; }
+inline void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog) {}
+inline void glGetShaderPrecisionFormat(GLenum shadertype, GLenum precisiontype, GLint *range, GLint *precision) {}
+inline void glGetShaderSource(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *source) {}
+inline void glGetShaderiv(GLuint shader, GLenum pname, GLint *params) { *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0; }
+inline const GLubyte* glGetString(GLenum name) { return reinterpret_cast<const GLubyte*>("null"); }
+inline GLint glGetUniformLocation(GLuint program, const GLchar *name) { return 0; }
+inline void glLinkProgram(GLuint program) {}
+inline void glLoadMatrixf(const GLfloat *m) {}
+inline void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) { return nullgl::mapBuffer(length); }
+inline void glMatrixMode(GLenum mode) {}
+inline void glProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {}
+inline void glProgramParameteri(GLuint program, GLenum pname, GLint value) {}
+inline void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels) {}
+inline void glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {}
+inline void glShaderSource(GLuint shader, GLsizei count, const GLchar *const*string, const GLint *length) {}
+inline void glTexCoord2f(GLfloat s, GLfloat t) {}
+inline void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *ptr) {}
+inline void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels) {}
+inline void glTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels) {}
+inline void glTexParameteri(GLenum target, GLenum pname, GLint param) {}
+inline void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels) {}
+inline void glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels) {}
+inline void glUniform1f(GLint location, GLfloat v0) {}
+inline void glUniform1fv(GLint location, GLsizei count, const GLfloat *value) {}
+inline void glUniform1i(GLint location, GLint v0) {}
+inline void glUniform1iv(GLint location, GLsizei count, const GLint *value) {}
+inline void glUniform2f(GLint location, GLfloat v0, GLfloat v1) {}
+inline void glUniform2fv(GLint location, GLsizei count, const GLfloat *value) {}
+inline void glUniform2i(GLint location, GLint v0, GLint v1) {}
+inline void glUniform2iv(GLint location, GLsizei count, const GLint *value) {}
+inline void glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {}
+inline void glUniform3fv(GLint location, GLsizei count, const GLfloat *value) {}
+inline void glUniform3i(GLint location, GLint v0, GLint v1, GLint v2) {}
+inline void glUniform3iv(GLint location, GLsizei count, const GLint *value) {}
+inline void glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {}
+inline void glUniform4fv(GLint location, GLsizei count, const GLfloat *value) {}
+inline void glUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {}
+inline void glUniform4iv(GLint location, GLsizei count, const GLint *value) {}
+inline void glUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {}
+inline void glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {}
+inline void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {}
+inline GLboolean glUnmapBuffer(GLenum target) { return GL_TRUE; }
+inline void glUseProgram(GLuint program) {}
+inline void glValidateProgram(GLuint program) {}
+inline void glVertex2f(GLfloat x, GLfloat y) {}
+inline void glVertexAttrib1f(GLuint index, GLfloat x) {}
+inline void glVertexAttrib1fv(GLuint index, const GLfloat *v) {}
+inline void glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y) {}
+inline void glVertexAttrib2fv(GLuint index, const GLfloat *v) {}
+inline void glVertexAttrib3f(GLuint index, GLfloat x, GLfloat y, GLfloat z) {}
+inline void glVertexAttrib3fv(GLuint index, const GLfloat *v) {}
+inline void glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {}
+inline void glVertexAttrib4fv(GLuint index, const GLfloat *v) {}
+inline void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer) {}
+inline void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *ptr) {}
+inline void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {}
+
+#endif
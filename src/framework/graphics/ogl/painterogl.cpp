@@ -21,6 +21,7 @@
  */
 
 #include "painterogl.h"
+#include <framework/graphics/animatedtexture.h>
 #include <framework/graphics/graphics.h>
 #include <framework/platform/platformwindow.h>
 
@@ -48,6 +49,7 @@ void PainterOGL::resetState()
     resetShaderProgram();
     resetAlphaWriting();
     resetTransformMatrix();
+    setSilhouette(false);
 }
 
 void PainterOGL::refreshState()
@@ -72,12 +74,17 @@ PainterOGL::PainterState PainterOGL::getCurrentState()
     return PainterOGL::PainterState{
         m_resolution , m_transformMatrix, m_projectionMatrix, m_textureMatrix,
         m_color, m_opacity, m_compositionMode, m_blendEquation, m_clipRect,
-        nullptr, m_shaderProgram, m_alphaWriting
+        nullptr, m_shaderProgram, m_alphaWriting, m_silhouette
     };
 }
 
 void PainterOGL::executeState(const PainterState& state)
 {
+    m_statistics.stateChanges += (m_color != state.color) + (m_opacity != state.opacity) +
+        (m_compositionMode != state.compositionMode) + (m_blendEquation != state.blendEquation) +
+        (m_clipRect != state.clipRect) + (m_shaderProgram != state.shaderProgram) +
+        (m_transformMatrix != state.transformMatrix);
+
     setColor(state.color);
     setOpacity(state.opacity);
     setCompositionMode(state.compositionMode);
@@ -85,6 +92,7 @@ void PainterOGL::executeState(const PainterState& state)
     setClipRect(state.clipRect);
     setShaderProgram(state.shaderProgram);
     setTransformMatrix(state.transformMatrix);
+    setSilhouette(state.silhouette);
 }
 
 void PainterOGL::saveAndResetState()
@@ -148,7 +156,9 @@ void PainterOGL::setClipRect(const Rect& clipRect)
 
 void PainterOGL::setTexture(Texture* texture)
 {
-    if(m_texture == texture)
+    // animated textures pick their frame as they are drawn, a new frame only moves their matrix
+    const bool frameChanged = texture && texture->isAnimatedTexture() && static_cast<AnimatedTexture*>(texture)->updateAnimation();
+    if(m_texture == texture && !frameChanged)
         return;
 
     m_texture = texture;
@@ -259,8 +269,17 @@ void PainterOGL::popTransformMatrix()
 
 void PainterOGL::updateGlTexture()
 {
-    if(m_glTextureId != 0)
+    if(m_glTextureId != 0) {
+#ifndef OPENGL_ES
+        if(m_texture && m_texture->isArrayTexture()) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_glTextureId);
+            m_statistics.textureBinds++;
+            return;
+        }
+#endif
         glBindTexture(GL_TEXTURE_2D, m_glTextureId);
+        m_statistics.textureBinds++;
+    }
 }
 
 void PainterOGL::updateGlCompositionMode()
@@ -81,6 +81,9 @@ void PainterOGL1::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
     if(g_graphics.hasScissorBug())
         updateGlClipRect();
 
+    m_statistics.drawCalls++;
+    m_statistics.vertices += vertexCount;
+
     // use vertex arrays if possible, much faster
     if(g_graphics.canUseDrawArrays()) {
         // only set texture coords arrays when needed
@@ -22,6 +22,7 @@
 
 #include "painterogl2.h"
 #include "painterogl2_shadersources.h"
+#include <framework/graphics/graphics.h>
 #include <framework/platform/platformwindow.h>
 
 PainterOGL2* g_painterOGL2 = nullptr;
@@ -31,38 +32,249 @@ PainterOGL2::PainterOGL2()
     m_drawProgram = nullptr;
     resetState();
 
+    // programs are linked by their first bind, when the shader cache can already reach the write dir
     m_drawTexturedProgram = PainterShaderProgramPtr(new PainterShaderProgram);
     assert(m_drawTexturedProgram);
     m_drawTexturedProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithTexCoordsVertexShader + glslPositionOnlyVertexShader);
     m_drawTexturedProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslTextureSrcFragmentShader);
-    m_drawTexturedProgram->link();
 
     m_drawSolidColorProgram = PainterShaderProgramPtr(new PainterShaderProgram);
     assert(m_drawSolidColorProgram);
     m_drawSolidColorProgram->addShaderFromSourceCode(Shader::Vertex, glslMainVertexShader + glslPositionOnlyVertexShader);
     m_drawSolidColorProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslSolidColorFragmentShader);
-    m_drawSolidColorProgram->link();
+
+    m_drawTexturedColoredProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+    assert(m_drawTexturedColoredProgram);
+    m_drawTexturedColoredProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithTexCoordsAndColorVertexShader + glslPositionOnlyVertexShader);
+    m_drawTexturedColoredProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslTextureColorFragmentShader);
+
+    m_drawSilhouetteProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+    m_drawSilhouetteProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithTexCoordsVertexShader + glslPositionOnlyVertexShader);
+    m_drawSilhouetteProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslSilhouetteFragmentShader);
+
+    m_drawSilhouetteColoredProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+    m_drawSilhouetteColoredProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithTexCoordsAndColorVertexShader + glslPositionOnlyVertexShader);
+    m_drawSilhouetteColoredProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslSilhouetteColorFragmentShader);
+
+    if(g_graphics.canUsePackedQuads()) {
+        m_drawPackedTexturedProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+        m_drawPackedTexturedProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithTexCoordsAndColorVertexShader + glslPositionOnlyVertexShader);
+        m_drawPackedTexturedProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslTextureColorFragmentShader);
+
+        m_drawPackedSolidProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+        m_drawPackedSolidProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithColorVertexShader + glslPositionOnlyVertexShader);
+        m_drawPackedSolidProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslVertexColorFragmentShader);
+
+        if(g_graphics.canUseTextureArrays()) {
+            m_drawPackedLayeredProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+            m_drawPackedLayeredProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithLayeredTexCoordsAndColorVertexShader + glslPositionOnlyVertexShader);
+            m_drawPackedLayeredProgram->addShaderFromSourceCode(Shader::Fragment, glslTextureArrayExtension + glslMainFragmentShader + glslTextureArrayColorFragmentShader);
+
+            m_drawPackedLayeredSilhouetteProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+            m_drawPackedLayeredSilhouetteProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithLayeredTexCoordsAndColorVertexShader + glslPositionOnlyVertexShader);
+            m_drawPackedLayeredSilhouetteProgram->addShaderFromSourceCode(Shader::Fragment, glslTextureArrayExtension + glslMainFragmentShader + glslTextureArraySilhouetteFragmentShader);
+        }
+
+        // without it creatures keep drawing their masks as separate multiplied quads
+        m_drawPackedOutfitProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+        m_drawPackedOutfitProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithOutfitMaskVertexShader + glslPositionOnlyVertexShader);
+        m_drawPackedOutfitProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslOutfitMaskFragmentShader);
+
+        // every quad is drawn as two triangles sharing the vertices 1 and 2
+        std::vector<uint16> indices(PACKED_QUADS_PER_DRAW * 6);
+        for(int quad = 0; quad < PACKED_QUADS_PER_DRAW; ++quad) {
+            const uint16 first = quad * 4;
+            uint16* index = &indices[quad * 6];
+            index[0] = first;
+            index[1] = first + 1;
+            index[2] = first + 2;
+            index[3] = first + 2;
+            index[4] = first + 1;
+            index[5] = first + 3;
+        }
+
+        m_quadIndexBuffer = std::make_unique<HardwareBuffer>(HardwareBuffer::IndexBuffer);
+        m_quadIndexBuffer->bind();
+        m_quadIndexBuffer->write(indices.data(), indices.size() * sizeof(uint16), HardwareBuffer::StaticDraw);
+        HardwareBuffer::unbind(HardwareBuffer::IndexBuffer);
+
+        m_packedQuadStream = std::make_unique<StreamBuffer>(PACKED_STREAM_VERTICES, sizeof(PackedVertex));
+        m_packedOutfitStream = std::make_unique<StreamBuffer>(PACKED_OUTFIT_STREAM_VERTICES, sizeof(PackedOutfitVertex));
+    }
 
     PainterShaderProgram::release();
 }
 
+bool PainterOGL2::linkOptionalProgram(PainterShaderProgramPtr& program)
+{
+    // drivers may reject the extensions these programs use, the features are turned off then
+    if(program && !program->link())
+        program = nullptr;
+    return program != nullptr;
+}
+
 void PainterOGL2::bind()
 {
     PainterOGL::bind();
 
-    // vertex and texture coord attributes are always enabled
+    // another context user may have changed the attributes and texture units
+    m_attributes.fill(AttributeState());
+    m_quadIndexBufferBound = false;
+    PainterShaderProgram::resetMultiTextureBindings();
+
+    // vertex and texture coord attributes are kept enabled
     // to avoid massive enable/disables, thus improving frame rate
-    PainterShaderProgram::enableAttributeArray(PainterShaderProgram::VERTEX_ATTR);
-    PainterShaderProgram::enableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
+    enableAttribute(PainterShaderProgram::VERTEX_ATTR);
+    enableAttribute(PainterShaderProgram::TEXCOORD_ATTR);
 }
 
 void PainterOGL2::unbind()
 {
-    PainterShaderProgram::disableAttributeArray(PainterShaderProgram::VERTEX_ATTR);
-    PainterShaderProgram::disableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
+    disableAttribute(PainterShaderProgram::VERTEX_ATTR);
+    disableAttribute(PainterShaderProgram::TEXCOORD_ATTR);
+    disableAttribute(PainterShaderProgram::COLOR_ATTR);
+    disableAttribute(PainterShaderProgram::LAYER_ATTR);
+    disableOutfitAttributes();
+    if(m_quadIndexBufferBound) {
+        HardwareBuffer::unbind(HardwareBuffer::IndexBuffer);
+        m_quadIndexBufferBound = false;
+    }
     PainterShaderProgram::release();
 }
 
+void PainterOGL2::enableAttribute(int location)
+{
+    AttributeState& attribute = m_attributes[location];
+    if(attribute.enabled) {
+        m_statistics.skippedGlCalls++;
+        return;
+    }
+
+    PainterShaderProgram::enableAttributeArray(location);
+    attribute.enabled = true;
+}
+
+void PainterOGL2::disableAttribute(int location)
+{
+    AttributeState& attribute = m_attributes[location];
+    if(!attribute.enabled) {
+        m_statistics.skippedGlCalls++;
+        return;
+    }
+
+    PainterShaderProgram::disableAttributeArray(location);
+    attribute.enabled = false;
+}
+
+void PainterOGL2::setAttribute(int location, const float* pointer, int size)
+{
+    // client side arrays are read at draw time, so the same pointer stays valid
+    AttributeState& attribute = m_attributes[location];
+    if(attribute.bufferSerial == 0 && attribute.pointer == pointer && attribute.size == size) {
+        m_statistics.skippedGlCalls++;
+        return;
+    }
+
+    m_drawProgram->setAttributeArray(location, pointer, size);
+    attribute.pointer = pointer;
+    attribute.bufferSerial = 0;
+    attribute.size = size;
+}
+
+void PainterOGL2::setAttribute(int location, HardwareBuffer* buffer, int size)
+{
+    AttributeState& attribute = m_attributes[location];
+    if(attribute.bufferSerial == buffer->getSerial() && attribute.size == size) {
+        m_statistics.skippedGlCalls += 3;
+        return;
+    }
+
+    buffer->bind();
+    m_drawProgram->setAttributeArray(location, nullptr, size);
+    HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+    attribute.pointer = nullptr;
+    attribute.bufferSerial = buffer->getSerial();
+    attribute.size = size;
+}
+
+void PainterOGL2::setPackedAttributes()
+{
+    const uint64 serial = m_packedQuadStream->getSerial();
+    const bool current = m_attributes[PainterShaderProgram::VERTEX_ATTR].bufferSerial == serial &&
+        m_attributes[PainterShaderProgram::TEXCOORD_ATTR].bufferSerial == serial &&
+        m_attributes[PainterShaderProgram::COLOR_ATTR].bufferSerial == serial &&
+        m_attributes[PainterShaderProgram::LAYER_ATTR].bufferSerial == serial;
+    if(current) {
+        m_statistics.skippedGlCalls += 6;
+        return;
+    }
+
+    // the offsets never change, glDrawElementsBaseVertex selects the ring range instead
+    const int stride = sizeof(PackedVertex);
+    m_packedQuadStream->bind();
+    glVertexAttribPointer(PainterShaderProgram::VERTEX_ATTR, 2, GL_SHORT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(PackedVertex, x)));
+    glVertexAttribPointer(PainterShaderProgram::TEXCOORD_ATTR, 2, GL_UNSIGNED_SHORT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(PackedVertex, u)));
+    glVertexAttribPointer(PainterShaderProgram::COLOR_ATTR, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<void*>(offsetof(PackedVertex, r)));
+    glVertexAttribPointer(PainterShaderProgram::LAYER_ATTR, 1, GL_UNSIGNED_SHORT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(PackedVertex, layer)));
+    HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+
+    for(AttributeState& attribute : m_attributes) {
+        attribute.pointer = nullptr;
+        attribute.bufferSerial = serial;
+        attribute.size = 0;
+    }
+}
+
+void PainterOGL2::setPackedOutfitAttributes()
+{
+    const uint64 serial = m_packedOutfitStream->getSerial();
+    bool current = true;
+    for(int location = PainterShaderProgram::VERTEX_ATTR; location <= PainterShaderProgram::FEET_COLOR_ATTR; ++location) {
+        if(location != PainterShaderProgram::LAYER_ATTR && m_attributes[location].bufferSerial != serial)
+            current = false;
+    }
+    if(current) {
+        m_statistics.skippedGlCalls += 9;
+        return;
+    }
+
+    const int stride = sizeof(PackedOutfitVertex);
+    m_packedOutfitStream->bind();
+    glVertexAttribPointer(PainterShaderProgram::VERTEX_ATTR, 2, GL_SHORT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(PackedOutfitVertex, x)));
+    glVertexAttribPointer(PainterShaderProgram::TEXCOORD_ATTR, 2, GL_UNSIGNED_SHORT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(PackedOutfitVertex, u)));
+    glVertexAttribPointer(PainterShaderProgram::COLOR_ATTR, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<void*>(offsetof(PackedOutfitVertex, r)));
+    glVertexAttribPointer(PainterShaderProgram::MASK_OFFSET_ATTR, 2, GL_SHORT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(PackedOutfitVertex, maskOffsetX)));
+    for(int i = 0; i < 4; ++i)
+        glVertexAttribPointer(PainterShaderProgram::HEAD_COLOR_ATTR + i, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<void*>(offsetof(PackedOutfitVertex, maskColors) + i * sizeof(uint32)));
+    HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+
+    // the layer keeps whatever the packed quads gave it, this program doesn't read it
+    for(int location = 0; location < static_cast<int>(m_attributes.size()); ++location) {
+        if(location == PainterShaderProgram::LAYER_ATTR)
+            continue;
+        m_attributes[location].pointer = nullptr;
+        m_attributes[location].bufferSerial = serial;
+        m_attributes[location].size = 0;
+    }
+}
+
+void PainterOGL2::disableOutfitAttributes()
+{
+    for(int location = PainterShaderProgram::MASK_OFFSET_ATTR; location <= PainterShaderProgram::FEET_COLOR_ATTR; ++location) {
+        if(m_attributes[location].enabled)
+            disableAttribute(location);
+    }
+}
+
+void PainterOGL2::bindQuadIndexBuffer()
+{
+    if(!m_quadIndexBufferBound) {
+        m_quadIndexBuffer->bind();
+        m_quadIndexBufferBound = true;
+    } else
+        m_statistics.skippedGlCalls++;
+}
+
 void PainterOGL2::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
 {
     const int vertexCount = coordsBuffer.getVertexCount();
@@ -70,40 +282,186 @@ void PainterOGL2::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
         return;
 
     const bool textured = coordsBuffer.getTextureCoordCount() > 0 && m_texture;
+    const bool hardwareCached = coordsBuffer.isHardwareCached();
 
     // skip drawing of empty textures
     if(textured && m_texture->isEmpty())
         return;
 
-    m_drawProgram = m_shaderProgram ? m_shaderProgram : textured ? m_drawTexturedProgram.get() : m_drawSolidColorProgram.get();
+    if(m_shaderProgram)
+        m_drawProgram = m_shaderProgram;
+    else if(textured)
+        m_drawProgram = m_silhouette ? m_drawSilhouetteProgram.get() : m_drawTexturedProgram.get();
+    else
+        m_drawProgram = m_drawSolidColorProgram.get();
+    if(ShaderProgram::getCurrentProgram() != m_drawProgram->getProgramId())
+        m_statistics.shaderSwitches++;
 
-    // update shader with the current painter state
+    // update shader with the current painter state, each program
+    // remembers its uniforms so only the changed ones are sent
     m_drawProgram->bind();
-    m_drawProgram->setTransformMatrix(m_transformMatrix);
-    m_drawProgram->setProjectionMatrix(m_projectionMatrix);
+    countUniformUpdate(m_drawProgram->setTransformMatrix(m_transformMatrix));
+    countUniformUpdate(m_drawProgram->setProjectionMatrix(m_projectionMatrix));
     if(textured) {
-        m_drawProgram->setTextureMatrix(m_textureMatrix);
-        m_drawProgram->bindMultiTextures();
+        countUniformUpdate(m_drawProgram->setTextureMatrix(m_textureMatrix));
+        m_statistics.skippedGlCalls += m_drawProgram->bindMultiTextures();
     }
-    m_drawProgram->setOpacity(m_opacity);
-    m_drawProgram->setColor(m_color);
-    m_drawProgram->setResolution(m_resolution);
-    m_drawProgram->updateTime();
+    countUniformUpdate(m_drawProgram->setOpacity(m_opacity));
+    countUniformUpdate(m_drawProgram->setColor(m_color));
+    countUniformUpdate(m_drawProgram->setResolution(m_resolution));
+    countUniformUpdate(m_drawProgram->updateTime());
 
-    // only set texture coords arrays when needed
+    // the texture coords array stays enabled until a non textured draw needs it off
+    if(m_attributes[PainterShaderProgram::COLOR_ATTR].enabled)
+        disableAttribute(PainterShaderProgram::COLOR_ATTR);
+    if(m_attributes[PainterShaderProgram::LAYER_ATTR].enabled)
+        disableAttribute(PainterShaderProgram::LAYER_ATTR);
+    disableOutfitAttributes();
     if(textured) {
-        m_drawProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, coordsBuffer.getTextureCoordArray(), 2);
+        enableAttribute(PainterShaderProgram::TEXCOORD_ATTR);
+        if(hardwareCached)
+            setAttribute(PainterShaderProgram::TEXCOORD_ATTR, coordsBuffer.getHardwareTextureCoordArray(), 2);
+        else
+            setAttribute(PainterShaderProgram::TEXCOORD_ATTR, coordsBuffer.getTextureCoordArray(), 2);
     } else
-        PainterShaderProgram::disableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
+        disableAttribute(PainterShaderProgram::TEXCOORD_ATTR);
 
     // set vertex array
-    m_drawProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, coordsBuffer.getVertexArray(), 2);
+    if(hardwareCached)
+        setAttribute(PainterShaderProgram::VERTEX_ATTR, coordsBuffer.getHardwareVertexArray(), 2);
+    else
+        setAttribute(PainterShaderProgram::VERTEX_ATTR, coordsBuffer.getVertexArray(), 2);
 
     // draw the element in coords buffers
     glDrawArrays(static_cast<GLenum>(drawMode), 0, vertexCount);
+    m_statistics.drawCalls++;
+    m_statistics.vertices += vertexCount;
+}
+
+void PainterOGL2::drawColoredCoords(CoordsBuffer& coordsBuffer, const float* colorArray, DrawMode drawMode)
+{
+    const int vertexCount = coordsBuffer.getVertexCount();
+    if(vertexCount == 0 || !m_texture || m_texture->isEmpty() || coordsBuffer.getTextureCoordCount() != vertexCount)
+        return;
+
+    // custom shaders don't know about the color attribute, the per vertex color replaces u_Color
+    m_drawProgram = m_silhouette ? m_drawSilhouetteColoredProgram.get() : m_drawTexturedColoredProgram.get();
+    if(ShaderProgram::getCurrentProgram() != m_drawProgram->getProgramId())
+        m_statistics.shaderSwitches++;
+    m_drawProgram->bind();
+    countUniformUpdate(m_drawProgram->setTransformMatrix(m_transformMatrix));
+    countUniformUpdate(m_drawProgram->setProjectionMatrix(m_projectionMatrix));
+    countUniformUpdate(m_drawProgram->setTextureMatrix(m_textureMatrix));
+    countUniformUpdate(m_drawProgram->setOpacity(m_opacity));
+
+    enableAttribute(PainterShaderProgram::TEXCOORD_ATTR);
+    setAttribute(PainterShaderProgram::TEXCOORD_ATTR, coordsBuffer.getTextureCoordArray(), 2);
+    setAttribute(PainterShaderProgram::VERTEX_ATTR, coordsBuffer.getVertexArray(), 2);
+    if(m_attributes[PainterShaderProgram::LAYER_ATTR].enabled)
+        disableAttribute(PainterShaderProgram::LAYER_ATTR);
+    disableOutfitAttributes();
+
+    // the color array is disabled again by the next drawCoords
+    enableAttribute(PainterShaderProgram::COLOR_ATTR);
+    setAttribute(PainterShaderProgram::COLOR_ATTR, colorArray, 4);
+
+    glDrawArrays(static_cast<GLenum>(drawMode), 0, vertexCount);
+    m_statistics.drawCalls++;
+    m_statistics.vertices += vertexCount;
+}
+
+void PainterOGL2::drawPackedQuads(const PackedVertexArray& vertices, bool textured)
+{
+#ifndef OPENGL_ES
+    const int quadCount = vertices.quadCount();
+    if(quadCount == 0 || !m_packedQuadStream)
+        return;
+
+    if(textured && (!m_texture || m_texture->isEmpty()))
+        return;
+
+    // atlas pages stored as array layers pick their layer per vertex
+    const bool layered = textured && m_texture->isArrayTexture();
+
+    if(layered && m_silhouette)
+        m_drawProgram = linkOptionalProgram(m_drawPackedLayeredSilhouetteProgram) ? m_drawPackedLayeredSilhouetteProgram.get() : m_drawPackedLayeredProgram.get();
+    else if(layered)
+        m_drawProgram = m_drawPackedLayeredProgram.get();
+    else if(textured)
+        m_drawProgram = m_silhouette ? m_drawSilhouetteColoredProgram.get() : m_drawPackedTexturedProgram.get();
+    else
+        m_drawProgram = m_drawPackedSolidProgram.get();
+    if(ShaderProgram::getCurrentProgram() != m_drawProgram->getProgramId())
+        m_statistics.shaderSwitches++;
+
+    m_drawProgram->bind();
+    countUniformUpdate(m_drawProgram->setTransformMatrix(m_transformMatrix));
+    countUniformUpdate(m_drawProgram->setProjectionMatrix(m_projectionMatrix));
+    if(textured)
+        countUniformUpdate(m_drawProgram->setTextureMatrix(m_textureMatrix));
+    countUniformUpdate(m_drawProgram->setOpacity(m_opacity));
+
+    // the untextured program ignores the texture coords, they are zeros in the ring
+    enableAttribute(PainterShaderProgram::TEXCOORD_ATTR);
+    enableAttribute(PainterShaderProgram::COLOR_ATTR);
+    if(layered)
+        enableAttribute(PainterShaderProgram::LAYER_ATTR);
+    else if(m_attributes[PainterShaderProgram::LAYER_ATTR].enabled)
+        disableAttribute(PainterShaderProgram::LAYER_ATTR);
+    disableOutfitAttributes();
+    setPackedAttributes();
+    bindQuadIndexBuffer();
+
+    for(int first = 0; first < quadCount; first += PACKED_QUADS_PER_DRAW) {
+        const int count = std::min<int>(quadCount - first, PACKED_QUADS_PER_DRAW);
+        const int baseVertex = m_packedQuadStream->write(vertices.vertices() + first * 4, count * 4);
+        if(baseVertex < 0)
+            break;
 
-    if(!textured)
-        PainterShaderProgram::enableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
+        glDrawElementsBaseVertex(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT, nullptr, baseVertex);
+        m_statistics.drawCalls++;
+        m_statistics.vertices += count * 4;
+    }
+#endif
+}
+
+void PainterOGL2::drawPackedOutfitQuads(const PackedOutfitVertexArray& vertices)
+{
+#ifndef OPENGL_ES
+    const int quadCount = vertices.quadCount();
+    if(quadCount == 0 || !m_packedOutfitStream || !m_texture || m_texture->isEmpty())
+        return;
+
+    m_drawProgram = m_drawPackedOutfitProgram.get();
+    if(ShaderProgram::getCurrentProgram() != m_drawProgram->getProgramId())
+        m_statistics.shaderSwitches++;
+
+    m_drawProgram->bind();
+    countUniformUpdate(m_drawProgram->setTransformMatrix(m_transformMatrix));
+    countUniformUpdate(m_drawProgram->setProjectionMatrix(m_projectionMatrix));
+    countUniformUpdate(m_drawProgram->setTextureMatrix(m_textureMatrix));
+    countUniformUpdate(m_drawProgram->setOpacity(m_opacity));
+
+    enableAttribute(PainterShaderProgram::TEXCOORD_ATTR);
+    enableAttribute(PainterShaderProgram::COLOR_ATTR);
+    if(m_attributes[PainterShaderProgram::LAYER_ATTR].enabled)
+        disableAttribute(PainterShaderProgram::LAYER_ATTR);
+    for(int location = PainterShaderProgram::MASK_OFFSET_ATTR; location <= PainterShaderProgram::FEET_COLOR_ATTR; ++location)
+        enableAttribute(location);
+    setPackedOutfitAttributes();
+    bindQuadIndexBuffer();
+
+    for(int first = 0; first < quadCount; first += PACKED_QUADS_PER_DRAW) {
+        const int count = std::min<int>(quadCount - first, PACKED_QUADS_PER_DRAW);
+        const int baseVertex = m_packedOutfitStream->write(vertices.vertices() + first * 4, count * 4);
+        if(baseVertex < 0)
+            break;
+
+        glDrawElementsBaseVertex(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT, nullptr, baseVertex);
+        m_statistics.drawCalls++;
+        m_statistics.vertices += count * 4;
+    }
+#endif
 }
 
 void PainterOGL2::drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src)
@@ -26,6 +26,7 @@
 #define PAINTER_OGL2
 
 #include "painterogl.h"
+#include <framework/graphics/streambuffer.h>
 
  /**
     * Painter using OpenGL 2.0 programmable rendering pipeline,
@@ -43,15 +44,60 @@ public:
     void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = DrawMode::Triangles) override;
     void drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src) override;
     void drawFilledRect(const Rect& dest) override;
+    void drawColoredCoords(CoordsBuffer& coordsBuffer, const float* colorArray, DrawMode drawMode = DrawMode::Triangles) override;
+    bool canDrawPackedQuads() override { return m_packedQuadStream != nullptr; }
+    bool canDrawTextureArrays() override { return linkOptionalProgram(m_drawPackedLayeredProgram); }
+    void drawPackedQuads(const PackedVertexArray& vertices, bool textured) override;
+    bool canDrawOutfitMasks() override { return m_packedOutfitStream && linkOptionalProgram(m_drawPackedOutfitProgram); }
+    void drawPackedOutfitQuads(const PackedOutfitVertexArray& vertices) override;
+    bool canDrawSilhouettes() override { return true; }
 
     void setDrawProgram(PainterShaderProgram* drawProgram) { m_drawProgram = drawProgram; }
 
     bool hasShaders() override { return true; }
 
 private:
+    enum {
+        PACKED_STREAM_VERTICES = 262144, // 3 MB ring, a few frames of map and ui quads
+        PACKED_OUTFIT_STREAM_VERTICES = 65536, // 2 MB ring, creatures only
+        PACKED_QUADS_PER_DRAW = 16384 // the last index still fits in 16 bits
+    };
+
+    // shadow of the vertex attribute state, which is shared by all programs
+    struct AttributeState {
+        bool enabled = false;
+        const float* pointer = nullptr;
+        uint64 bufferSerial = 0;
+        int size = 0;
+    };
+
+    void enableAttribute(int location);
+    void disableAttribute(int location);
+    void setAttribute(int location, const float* pointer, int size);
+    void setAttribute(int location, HardwareBuffer* buffer, int size);
+    static bool linkOptionalProgram(PainterShaderProgramPtr& program);
+    void setPackedAttributes();
+    void setPackedOutfitAttributes();
+    void disableOutfitAttributes();
+    void bindQuadIndexBuffer();
+    void countUniformUpdate(bool sent) { if(!sent) m_statistics.skippedGlCalls++; }
+
+    std::array<AttributeState, 9> m_attributes;
     PainterShaderProgram* m_drawProgram;
     PainterShaderProgramPtr m_drawTexturedProgram;
     PainterShaderProgramPtr m_drawSolidColorProgram;
+    PainterShaderProgramPtr m_drawTexturedColoredProgram;
+    PainterShaderProgramPtr m_drawSilhouetteProgram;
+    PainterShaderProgramPtr m_drawSilhouetteColoredProgram;
+    PainterShaderProgramPtr m_drawPackedTexturedProgram;
+    PainterShaderProgramPtr m_drawPackedSolidProgram;
+    PainterShaderProgramPtr m_drawPackedLayeredProgram;
+    PainterShaderProgramPtr m_drawPackedLayeredSilhouetteProgram;
+    PainterShaderProgramPtr m_drawPackedOutfitProgram;
+    std::unique_ptr<StreamBuffer> m_packedQuadStream;
+    std::unique_ptr<StreamBuffer> m_packedOutfitStream;
+    std::unique_ptr<HardwareBuffer> m_quadIndexBuffer;
+    bool m_quadIndexBufferBound = false;
 };
 
 extern PainterOGL2* g_painterOGL2;
@@ -40,6 +40,73 @@ static const std::string glslMainWithTexCoordsVertexShader = "\n\
         v_TexCoord = (u_TextureMatrix * vec3(a_TexCoord,1.0)).xy;\n\
     }\n";
 
+static const std::string glslMainWithTexCoordsAndColorVertexShader = "\n\
+    attribute highp vec2 a_TexCoord;\n\
+    attribute lowp vec4 a_Color;\n\
+    uniform highp mat3 u_TextureMatrix;\n\
+    varying highp vec2 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    highp vec4 calculatePosition();\n\
+    void main()\n\
+    {\n\
+        gl_Position = calculatePosition();\n\
+        v_TexCoord = (u_TextureMatrix * vec3(a_TexCoord,1.0)).xy;\n\
+        v_Color = a_Color;\n\
+    }\n";
+
+static const std::string glslMainWithLayeredTexCoordsAndColorVertexShader = "\n\
+    attribute highp vec2 a_TexCoord;\n\
+    attribute lowp vec4 a_Color;\n\
+    attribute highp float a_Layer;\n\
+    uniform highp mat3 u_TextureMatrix;\n\
+    varying highp vec3 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    highp vec4 calculatePosition();\n\
+    void main()\n\
+    {\n\
+        gl_Position = calculatePosition();\n\
+        v_TexCoord = vec3((u_TextureMatrix * vec3(a_TexCoord,1.0)).xy, a_Layer);\n\
+        v_Color = a_Color;\n\
+    }\n";
+
+static const std::string glslMainWithOutfitMaskVertexShader = "\n\
+    attribute highp vec2 a_TexCoord;\n\
+    attribute lowp vec4 a_Color;\n\
+    attribute highp vec2 a_MaskOffset;\n\
+    attribute lowp vec4 a_HeadColor;\n\
+    attribute lowp vec4 a_BodyColor;\n\
+    attribute lowp vec4 a_LegsColor;\n\
+    attribute lowp vec4 a_FeetColor;\n\
+    uniform highp mat3 u_TextureMatrix;\n\
+    varying highp vec4 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    varying lowp vec3 v_HeadColor;\n\
+    varying lowp vec3 v_BodyColor;\n\
+    varying lowp vec3 v_LegsColor;\n\
+    varying lowp vec3 v_FeetColor;\n\
+    highp vec4 calculatePosition();\n\
+    void main()\n\
+    {\n\
+        gl_Position = calculatePosition();\n\
+        v_TexCoord.xy = (u_TextureMatrix * vec3(a_TexCoord,1.0)).xy;\n\
+        v_TexCoord.zw = (u_TextureMatrix * vec3(a_TexCoord + a_MaskOffset,1.0)).xy;\n\
+        v_Color = a_Color;\n\
+        v_HeadColor = a_HeadColor.rgb;\n\
+        v_BodyColor = a_BodyColor.rgb;\n\
+        v_LegsColor = a_LegsColor.rgb;\n\
+        v_FeetColor = a_FeetColor.rgb;\n\
+    }\n";
+
+static const std::string glslMainWithColorVertexShader = "\n\
+    attribute lowp vec4 a_Color;\n\
+    varying lowp vec4 v_Color;\n\
+    highp vec4 calculatePosition();\n\
+    void main()\n\
+    {\n\
+        gl_Position = calculatePosition();\n\
+        v_Color = a_Color;\n\
+    }\n";
+
 static std::string glslPositionOnlyVertexShader = "\n\
     attribute highp vec2 a_Vertex;\n\
     uniform highp mat3 u_TransformMatrix;\n\
@@ -65,10 +132,82 @@ static const std::string glslTextureSrcFragmentShader = "\n\
         return texture2D(u_Tex0, v_TexCoord) * u_Color;\n\
     }\n";
 
+static const std::string glslTextureColorFragmentShader = "\n\
+    varying mediump vec2 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    uniform sampler2D u_Tex0;\n\
+    lowp vec4 calculatePixel() {\n\
+        return texture2D(u_Tex0, v_TexCoord) * v_Color;\n\
+    }\n";
+
+// must come before any other statement of the fragment source
+static const std::string glslTextureArrayExtension = "\n\
+    #extension GL_EXT_texture_array : require\n";
+
+static const std::string glslTextureArrayColorFragmentShader = "\n\
+    varying highp vec3 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    uniform sampler2DArray u_Tex0;\n\
+    lowp vec4 calculatePixel() {\n\
+        return texture2DArray(u_Tex0, v_TexCoord) * v_Color;\n\
+    }\n";
+
+// yellow marks the head, red the body, green the legs and blue the feet,
+// the multiply matches the old mask quads drawn with CompositionMode_Multiply
+static const std::string glslOutfitMaskFragmentShader = "\n\
+    varying highp vec4 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    varying lowp vec3 v_HeadColor;\n\
+    varying lowp vec3 v_BodyColor;\n\
+    varying lowp vec3 v_LegsColor;\n\
+    varying lowp vec3 v_FeetColor;\n\
+    uniform sampler2D u_Tex0;\n\
+    lowp vec4 calculatePixel() {\n\
+        lowp vec4 base = texture2D(u_Tex0, v_TexCoord.xy);\n\
+        lowp vec4 mask = texture2D(u_Tex0, v_TexCoord.zw);\n\
+        lowp float head = mask.r * mask.g * mask.a;\n\
+        lowp float body = mask.r * (1.0 - mask.g) * mask.a;\n\
+        lowp float legs = mask.g * (1.0 - mask.r) * mask.a;\n\
+        lowp float feet = mask.b * mask.a;\n\
+        lowp vec3 tint = vec3(1.0) + head * (v_HeadColor - 1.0) + body * (v_BodyColor - 1.0) + legs * (v_LegsColor - 1.0) + feet * (v_FeetColor - 1.0);\n\
+        return vec4(base.rgb * tint, base.a) * v_Color;\n\
+    }\n";
+
+// blank copies of sprites, every texel that is not fully transparent takes the color
+static const std::string glslSilhouetteFragmentShader = "\n\
+    varying mediump vec2 v_TexCoord;\n\
+    uniform lowp vec4 u_Color;\n\
+    uniform sampler2D u_Tex0;\n\
+    lowp vec4 calculatePixel() {\n\
+        return u_Color * step(0.002, texture2D(u_Tex0, v_TexCoord).a);\n\
+    }\n";
+
+static const std::string glslSilhouetteColorFragmentShader = "\n\
+    varying mediump vec2 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    uniform sampler2D u_Tex0;\n\
+    lowp vec4 calculatePixel() {\n\
+        return v_Color * step(0.002, texture2D(u_Tex0, v_TexCoord).a);\n\
+    }\n";
+
+static const std::string glslTextureArraySilhouetteFragmentShader = "\n\
+    varying highp vec3 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    uniform sampler2DArray u_Tex0;\n\
+    lowp vec4 calculatePixel() {\n\
+        return v_Color * step(0.002, texture2DArray(u_Tex0, v_TexCoord).a);\n\
+    }\n";
+
 static const std::string glslSolidColorFragmentShader = "\n\
     uniform lowp vec4 u_Color;\n\
     lowp vec4 calculatePixel() {\n\
         return u_Color;\n\
     }\n";
 
+static const std::string glslVertexColorFragmentShader = "\n\
+    varying lowp vec4 v_Color;\n\
+    lowp vec4 calculatePixel() {\n\
+        return v_Color;\n\
+    }\n";
+
 #endif
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PACKEDVERTEXARRAY_H
+#define PACKEDVERTEXARRAY_H
+
+#include "declarations.h"
+#include <framework/util/databuffer.h>
+
+// 16 bytes per vertex, texture coords are in pixels like the float arrays so the texture matrix still applies
+struct PackedVertex {
+    int16 x, y;
+    uint16 u, v;
+    uint8 r, g, b, a;
+    uint16 layer, padding; // array texture layer, ignored by 2D textures
+};
+
+// every shape is stored as quads of four vertices, drawn with the painter's static quad index buffer
+class PackedVertexArray
+{
+public:
+    void addQuad(const Rect& dest, const Rect& src, const Color& color, int layer = 0)
+    {
+        const int left = dest.left();
+        const int top = dest.top();
+        const int right = dest.right() + 1;
+        const int bottom = dest.bottom() + 1;
+
+        const int srcLeft = src.left();
+        const int srcTop = src.top();
+        const int srcRight = src.isValid() ? src.right() + 1 : 0;
+        const int srcBottom = src.isValid() ? src.bottom() + 1 : 0;
+
+        addVertex(left, top, srcLeft, srcTop, color, layer);
+        addVertex(right, top, srcRight, srcTop, color, layer);
+        addVertex(left, bottom, srcLeft, srcBottom, color, layer);
+        addVertex(right, bottom, srcRight, srcBottom, color, layer);
+    }
+
+    void addUpsideDownQuad(const Rect& dest, const Rect& src, const Color& color, int layer = 0)
+    {
+        addQuad(dest, src, color, layer);
+
+        // swap the rows, the texture is sampled bottom to top
+        PackedVertex* quad = m_buffer.data() + m_buffer.size() - 4;
+        std::swap(quad[0].y, quad[2].y);
+        std::swap(quad[1].y, quad[3].y);
+    }
+
+    void addRect(const Rect& dest, const Color& color) { addQuad(dest, Rect(), color); }
+
+    // the fourth vertex repeats the third, the second triangle of the quad is degenerate
+    void addTriangle(const Point& a, const Point& b, const Point& c, const Color& color)
+    {
+        addVertex(a.x, a.y, 0, 0, color);
+        addVertex(b.x, b.y, 0, 0, color);
+        addVertex(c.x, c.y, 0, 0, color);
+        addVertex(c.x, c.y, 0, 0, color);
+    }
+
+    void addBoudingRect(const Rect& dest, int innerLineWidth, const Color& color)
+    {
+        const int left = dest.left();
+        const int right = dest.right();
+        const int top = dest.top();
+        const int bottom = dest.bottom();
+        const int width = dest.width();
+        const int height = dest.height();
+        const int w = innerLineWidth;
+
+        addRect(Rect(left, top, width - w, w), color); // top
+        addRect(Rect(right - w + 1, top, w, height - w), color); // right
+        addRect(Rect(left + w, bottom - w + 1, width - w, w), color); // bottom
+        addRect(Rect(left, top + w, w, height - w), color); // left
+    }
+
+    void addRepeatedRects(const Rect& dest, const Rect& src, const Color& color, int layer = 0)
+    {
+        if(dest.isEmpty() || src.isEmpty())
+            return;
+
+        const Rect virtualDest(0, 0, dest.size());
+        for(int y = 0; y <= virtualDest.height(); y += src.height()) {
+            for(int x = 0; x <= virtualDest.width(); x += src.width()) {
+                Rect partialDest(x, y, src.size());
+                Rect partialSrc(src);
+
+                if(partialDest.bottom() > virtualDest.bottom()) {
+                    partialSrc.setBottom(partialSrc.bottom() + (virtualDest.bottom() - partialDest.bottom()));
+                    partialDest.setBottom(virtualDest.bottom());
+                }
+                if(partialDest.right() > virtualDest.right()) {
+                    partialSrc.setRight(partialSrc.right() + (virtualDest.right() - partialDest.right()));
+                    partialDest.setRight(virtualDest.right());
+                }
+
+                partialDest.translate(dest.topLeft());
+                addQuad(partialDest, partialSrc, color, layer);
+            }
+        }
+    }
+
+    void clear() { m_buffer.reset(); m_outOfRange = false; }
+    const PackedVertex* vertices() const { return m_buffer.data(); }
+    int vertexCount() const { return m_buffer.size(); }
+    int quadCount() const { return m_buffer.size() / 4; }
+
+    // a coordinate did not fit in 16 bits, the shapes must be drawn from float arrays instead
+    bool isOutOfRange() const { return m_outOfRange; }
+
+private:
+    void addVertex(int x, int y, int u, int v, const Color& color, int layer = 0)
+    {
+        if(x < INT16_MIN || x > INT16_MAX || y < INT16_MIN || y > INT16_MAX || u < 0 || u > UINT16_MAX || v < 0 || v > UINT16_MAX)
+            m_outOfRange = true;
+
+        m_buffer << PackedVertex{ static_cast<int16>(x), static_cast<int16>(y), static_cast<uint16>(u), static_cast<uint16>(v),
+                                  color.r(), color.g(), color.b(), color.a(), static_cast<uint16>(layer), 0 };
+    }
+
+    DataBuffer<PackedVertex> m_buffer;
+    bool m_outOfRange{ false };
+};
+
+// 32 bytes per vertex, the mask frame is read at a texel offset from the base frame in the same texture
+// and its red, green, blue and yellow areas are tinted by the four colors, in the order of Outfit
+struct PackedOutfitVertex {
+    int16 x, y;
+    uint16 u, v;
+    uint8 r, g, b, a;
+    int16 maskOffsetX, maskOffsetY;
+    uint32 maskColors[4]; // head, body, legs and feet, see packColor
+
+    // the rgba bytes in memory order, as the attribute reads them
+    static uint32 packColor(const Color& color)
+    {
+        const uint8 bytes[4] = { color.r(), color.g(), color.b(), color.a() };
+        uint32 word;
+        memcpy(&word, bytes, 4);
+        return word;
+    }
+};
+
+class PackedOutfitVertexArray
+{
+public:
+    // maskColors of a quad without mask are white, which leaves the base untouched
+    void addQuad(const Rect& dest, const Rect& src, const Color& color, const Point& maskOffset, const std::array<uint32, 4>& maskColors)
+    {
+        const int left = dest.left();
+        const int top = dest.top();
+        const int right = dest.right() + 1;
+        const int bottom = dest.bottom() + 1;
+
+        const int srcLeft = src.left();
+        const int srcTop = src.top();
+        const int srcRight = src.right() + 1;
+        const int srcBottom = src.bottom() + 1;
+
+        addVertex(left, top, srcLeft, srcTop, color, maskOffset, maskColors);
+        addVertex(right, top, srcRight, srcTop, color, maskOffset, maskColors);
+        addVertex(left, bottom, srcLeft, srcBottom, color, maskOffset, maskColors);
+        addVertex(right, bottom, srcRight, srcBottom, color, maskOffset, maskColors);
+    }
+
+    void clear() { m_buffer.reset(); m_outOfRange = false; }
+    const PackedOutfitVertex* vertices() const { return m_buffer.data(); }
+    int vertexCount() const { return m_buffer.size(); }
+    int quadCount() const { return m_buffer.size() / 4; }
+    bool isOutOfRange() const { return m_outOfRange; }
+
+private:
+    void addVertex(int x, int y, int u, int v, const Color& color, const Point& maskOffset, const std::array<uint32, 4>& maskColors)
+    {
+        if(x < INT16_MIN || x > INT16_MAX || y < INT16_MIN || y > INT16_MAX || u < 0 || u > UINT16_MAX || v < 0 || v > UINT16_MAX ||
+           maskOffset.x < INT16_MIN || maskOffset.x > INT16_MAX || maskOffset.y < INT16_MIN || maskOffset.y > INT16_MAX)
+            m_outOfRange = true;
+
+        m_buffer << PackedOutfitVertex{ static_cast<int16>(x), static_cast<int16>(y), static_cast<uint16>(u), static_cast<uint16>(v),
+                                        color.r(), color.g(), color.b(), color.a(),
+                                        static_cast<int16>(maskOffset.x), static_cast<int16>(maskOffset.y),
+                                        { maskColors[0], maskColors[1], maskColors[2], maskColors[3] } };
+    }
+
+    DataBuffer<PackedOutfitVertex> m_buffer;
+    bool m_outOfRange{ false };
+};
+
+#endif
@@ -25,6 +25,7 @@
 
 #include <framework/graphics/declarations.h>
 #include <framework/graphics/coordsbuffer.h>
+#include <framework/graphics/packedvertexarray.h>
 #include <framework/graphics/paintershaderprogram.h>
 #include <framework/graphics/texture.h>
 
@@ -66,6 +67,8 @@ public:
         TexturePtr texture;
         PainterShaderProgram* shaderProgram;
         bool alphaWriting;
+        bool silhouette{ false }; // textured draws fill every visible texel with the color
+        bool smoothSampling{ false }; // textured draws sample their texture with bilinear filtering
 
         bool operator==(const PainterState& s2) const
         {
@@ -78,10 +81,22 @@ public:
                 clipRect == s2.clipRect &&
                 texture == s2.texture &&
                 shaderProgram == s2.shaderProgram &&
-                alphaWriting == s2.alphaWriting;
+                alphaWriting == s2.alphaWriting &&
+                silhouette == s2.silhouette &&
+                smoothSampling == s2.smoothSampling;
         }
     };
 
+    // work handed to the driver since the last reset
+    struct Statistics {
+        uint64 drawCalls = 0;
+        uint64 vertices = 0;
+        uint64 textureBinds = 0;
+        uint64 shaderSwitches = 0;
+        uint64 stateChanges = 0;
+        uint64 skippedGlCalls = 0;
+    };
+
     Painter();
     virtual ~Painter() = default;
 
@@ -100,6 +115,17 @@ public:
     virtual void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = DrawMode::Triangles) = 0;
     virtual void drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src) = 0;
     virtual void drawFilledRect(const Rect& dest) = 0;
+    // colorArray holds one rgba quadruple per vertex, painters without shaders draw nothing
+    virtual void drawColoredCoords(CoordsBuffer& /*coordsBuffer*/, const float* /*colorArray*/, DrawMode /*drawMode*/ = DrawMode::Triangles) {}
+    // packed quads carry their own color, the painter color is ignored
+    virtual bool canDrawPackedQuads() { return false; }
+    virtual bool canDrawTextureArrays() { return false; }
+    virtual void drawPackedQuads(const PackedVertexArray& /*vertices*/, bool /*textured*/) {}
+    // outfit quads tint their mask frame with per vertex colors, see PackedOutfitVertex
+    virtual bool canDrawOutfitMasks() { return false; }
+    virtual void drawPackedOutfitQuads(const PackedOutfitVertexArray& /*vertices*/) {}
+    // silhouettes replace the blank copies of textures, painters without them keep drawing those copies
+    virtual bool canDrawSilhouettes() { return false; }
 
     virtual void setTexture(Texture* texture) = 0;
     virtual void setClipRect(const Rect& clipRect) = 0;
@@ -108,6 +134,7 @@ public:
     virtual void setBlendEquation(BlendEquation blendEquation) = 0;
     virtual void setShaderProgram(PainterShaderProgram* shaderProgram) { m_shaderProgram = shaderProgram; }
     void setShaderProgram(const PainterShaderProgramPtr& shaderProgram) { setShaderProgram(shaderProgram.get()); }
+    void setSilhouette(bool silhouette) { m_silhouette = silhouette; }
 
     virtual void scale(float x, float y) = 0;
     void scale(float factor) { scale(factor, factor); }
@@ -139,13 +166,18 @@ public:
 
     virtual bool hasShaders() = 0;
 
+    const Statistics& getStatistics() { return m_statistics; }
+    void resetStatistics() { m_statistics = Statistics(); }
+
 protected:
+    Statistics m_statistics;
     PainterShaderProgram* m_shaderProgram;
     CompositionMode m_compositionMode;
     Color m_color;
     Size m_resolution;
     float m_opacity;
     Rect m_clipRect;
+    bool m_silhouette{ false };
 };
 
 extern Painter* g_painter;
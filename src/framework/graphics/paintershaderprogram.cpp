@@ -28,6 +28,8 @@
 #include <framework/core/clock.h>
 #include <framework/platform/platformwindow.h>
 
+std::array<TexturePtr, 3> PainterShaderProgram::m_boundMultiTextures;
+
 PainterShaderProgram::PainterShaderProgram()
 {
     m_startTime = g_clock.seconds();
@@ -68,6 +70,13 @@ bool PainterShaderProgram::link()
     m_startTime = g_clock.seconds();
     bindAttributeLocation(VERTEX_ATTR, "a_Vertex");
     bindAttributeLocation(TEXCOORD_ATTR, "a_TexCoord");
+    bindAttributeLocation(COLOR_ATTR, "a_Color");
+    bindAttributeLocation(LAYER_ATTR, "a_Layer");
+    bindAttributeLocation(MASK_OFFSET_ATTR, "a_MaskOffset");
+    bindAttributeLocation(HEAD_COLOR_ATTR, "a_HeadColor");
+    bindAttributeLocation(BODY_COLOR_ATTR, "a_BodyColor");
+    bindAttributeLocation(LEGS_COLOR_ATTR, "a_LegsColor");
+    bindAttributeLocation(FEET_COLOR_ATTR, "a_FeetColor");
     if(ShaderProgram::link()) {
         bind();
         setupUniforms();
@@ -77,75 +86,82 @@ bool PainterShaderProgram::link()
     return false;
 }
 
-void PainterShaderProgram::setTransformMatrix(const Matrix3& transformMatrix)
+bool PainterShaderProgram::setTransformMatrix(const Matrix3& transformMatrix)
 {
     if(transformMatrix == m_transformMatrix)
-        return;
+        return false;
 
     bind();
     setUniformValue(TRANSFORM_MATRIX_UNIFORM, transformMatrix);
     m_transformMatrix = transformMatrix;
+    return true;
 }
 
-void PainterShaderProgram::setProjectionMatrix(const Matrix3& projectionMatrix)
+bool PainterShaderProgram::setProjectionMatrix(const Matrix3& projectionMatrix)
 {
     if(projectionMatrix == m_projectionMatrix)
-        return;
+        return false;
 
     bind();
     setUniformValue(PROJECTION_MATRIX_UNIFORM, projectionMatrix);
     m_projectionMatrix = projectionMatrix;
+    return true;
 }
 
-void PainterShaderProgram::setTextureMatrix(const Matrix3& textureMatrix)
+bool PainterShaderProgram::setTextureMatrix(const Matrix3& textureMatrix)
 {
     if(textureMatrix == m_textureMatrix)
-        return;
+        return false;
 
     bind();
     setUniformValue(TEXTURE_MATRIX_UNIFORM, textureMatrix);
     m_textureMatrix = textureMatrix;
+    return true;
 }
 
-void PainterShaderProgram::setColor(const Color& color)
+bool PainterShaderProgram::setColor(const Color& color)
 {
     if(color == m_color)
-        return;
+        return false;
 
     bind();
     setUniformValue(COLOR_UNIFORM, color);
     m_color = color;
+    return true;
 }
 
-void PainterShaderProgram::setOpacity(float opacity)
+bool PainterShaderProgram::setOpacity(float opacity)
 {
     if(m_opacity == opacity)
-        return;
+        return false;
 
     bind();
     setUniformValue(OPACITY_UNIFORM, opacity);
     m_opacity = opacity;
+    return true;
 }
 
-void PainterShaderProgram::setResolution(const Size& resolution)
+bool PainterShaderProgram::setResolution(const Size& resolution)
 {
     if(m_resolution == resolution)
-        return;
+        return false;
 
     bind();
     setUniformValue(RESOLUTION_UNIFORM, static_cast<float>(resolution.width()), static_cast<float>(resolution.height()));
     m_resolution = resolution;
+    return true;
 }
 
-void PainterShaderProgram::updateTime()
+bool PainterShaderProgram::updateTime()
 {
     float time = g_clock.seconds() - m_startTime;
     if(m_time == time)
-        return;
+        return false;
 
     bind();
     setUniformValue(TIME_UNIFORM, time);
     m_time = time;
+    return true;
 }
 
 void PainterShaderProgram::addMultiTexture(const std::string& file)
@@ -163,16 +179,34 @@ void PainterShaderProgram::addMultiTexture(const std::string& file)
     m_multiTextures.push_back(texture);
 }
 
-void PainterShaderProgram::bindMultiTextures()
+int PainterShaderProgram::bindMultiTextures()
 {
     if(m_multiTextures.empty())
-        return;
-
-    int i = 1;
-    for(const TexturePtr& tex : m_multiTextures) {
-        glActiveTexture(GL_TEXTURE0 + i++);
+        return 0;
+
+    int skipped = 0;
+    bool activated = false;
+    for(size_t i = 0; i < m_multiTextures.size() && i < m_boundMultiTextures.size(); ++i) {
+        const TexturePtr& tex = m_multiTextures[i];
+        if(m_boundMultiTextures[i] == tex) {
+            skipped += 2;
+            continue;
+        }
+
+        glActiveTexture(GL_TEXTURE1 + i);
         glBindTexture(GL_TEXTURE_2D, tex->getId());
+        m_boundMultiTextures[i] = tex;
+        activated = true;
     }
 
-    glActiveTexture(GL_TEXTURE0);
+    if(activated)
+        glActiveTexture(GL_TEXTURE0);
+    else
+        skipped++;
+    return skipped;
+}
+
+void PainterShaderProgram::resetMultiTextureBindings()
+{
+    m_boundMultiTextures.fill(nullptr);
 }
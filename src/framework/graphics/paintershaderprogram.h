@@ -34,6 +34,13 @@ protected:
     enum {
         VERTEX_ATTR = 0,
         TEXCOORD_ATTR = 1,
+        COLOR_ATTR = 2,
+        LAYER_ATTR = 3,
+        MASK_OFFSET_ATTR = 4,
+        HEAD_COLOR_ATTR = 5,
+        BODY_COLOR_ATTR = 6,
+        LEGS_COLOR_ATTR = 7,
+        FEET_COLOR_ATTR = 8,
         PROJECTION_MATRIX_UNIFORM = 0,
         TEXTURE_MATRIX_UNIFORM = 1,
         COLOR_UNIFORM = 2,
@@ -59,16 +66,20 @@ public:
     void setPosition(const Position& position) { m_startPos = position; };
     Position getPosition() { return m_startPos; };
 
-    void setTransformMatrix(const Matrix3& transformMatrix);
-    void setProjectionMatrix(const Matrix3& projectionMatrix);
-    void setTextureMatrix(const Matrix3& textureMatrix);
-    void setColor(const Color& color);
-    void setOpacity(float opacity);
-    void setResolution(const Size& resolution);
-    void updateTime();
+    // the setters return false when the value was already uploaded
+    bool setTransformMatrix(const Matrix3& transformMatrix);
+    bool setProjectionMatrix(const Matrix3& projectionMatrix);
+    bool setTextureMatrix(const Matrix3& textureMatrix);
+    bool setColor(const Color& color);
+    bool setOpacity(float opacity);
+    bool setResolution(const Size& resolution);
+    bool updateTime();
 
     void addMultiTexture(const std::string& file);
-    void bindMultiTextures();
+    /// Binds the multi textures to units 1-3, returns the number of binds skipped
+    int bindMultiTextures();
+    /// Forgets which multi textures are bound, to be called when the GL context is rebound
+    static void resetMultiTextureBindings();
 
 private:
     float m_startTime;
@@ -81,6 +92,8 @@ private:
     Size m_resolution;
     float m_time;
     std::vector<TexturePtr> m_multiTextures;
+    // holding the textures keeps their ids from being reused while shadowed
+    static std::array<TexturePtr, 3> m_boundMultiTextures;
 
     Position m_startPos;
 };
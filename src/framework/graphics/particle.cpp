@@ -21,94 +21,122 @@
  */
 
 #include "particle.h"
-#include "graphics.h"
-#include <framework/core/clock.h>
+#include "particletype.h"
 
-Particle::Particle(const Point& pos, const Size& startSize, const Size& finalSize, const PointF& velocity, const PointF& acceleration, float duration, float ignorePhysicsAfter, const std::vector<Color>& colors, const std::vector<float>& colorsStops, Painter::CompositionMode compositionMode, TexturePtr texture)
+void ParticleStore::add(const ParticleTypePtr& particleType, const PointF& position, const PointF& velocity, const PointF& acceleration, float particleDuration)
 {
-    m_colors = colors;
-    m_colorsStops = colorsStops;
-
-    m_position = PointF(pos.x, pos.y);
-    m_startSize = startSize;
-    m_finalSize = finalSize;
-    m_velocity = velocity;
-    m_acceleration = acceleration;
-
-    m_compositionMode = compositionMode;
-    m_texture = texture;
-    m_duration = duration;
-    m_ignorePhysicsAfter = ignorePhysicsAfter;
-    m_elapsedTime = 0;
-    m_finished = false;
-}
+    // a system only sees the types of its own emitters, a linear search is enough
+    auto it = std::find(types.begin(), types.end(), particleType);
+    if(it == types.end())
+        it = types.insert(types.end(), particleType);
 
-void Particle::render()
-{
-    if(!m_texture)
-        g_drawPool.addFilledRect(m_rect, m_color);
-    else {
-        g_drawPool.addTexturedRect(m_rect, m_texture, m_color);
-        g_drawPool.setCompositionMode(m_compositionMode, g_drawPool.size());
-    }
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    velocityX.push_back(velocity.x);
+    velocityY.push_back(velocity.y);
+    accelerationX.push_back(acceleration.x);
+    accelerationY.push_back(acceleration.y);
+    elapsedTime.push_back(0);
+    duration.push_back(particleDuration);
+    ignorePhysicsAfter.push_back(particleType->pIgnorePhysicsAfter);
+    type.push_back(static_cast<uint16>(it - types.begin()));
+    colorIndex.push_back(0);
+    rects.emplace_back();
+    colors.push_back(particleType->pColors[0]);
 }
 
-void Particle::update(float elapsedTime)
+void ParticleStore::update(float elapsed)
 {
-    // check if finished
-    if(m_duration >= 0 && m_elapsedTime >= m_duration) {
-        m_finished = true;
-        return;
-    }
+    const size_t count = size();
 
-    updateColor();
-    updateSize();
-    updatePosition(elapsedTime);
+    // size and color follow the life before this step, as the position does below
+    for(size_t i = 0; i < count; ++i) {
+        const ParticleType* particleType = types[type[i]].get();
+        const float life = elapsedTime[i] / duration[i];
 
-    m_elapsedTime += elapsedTime;
-}
+        const Size sizeDelta = particleType->pFinalSize - particleType->pStartSize;
+        rects[i].resize(particleType->pStartSize.width() + static_cast<int>(sizeDelta.width() * life),
+                        particleType->pStartSize.height() + static_cast<int>(sizeDelta.height() * life));
 
-void Particle::updatePosition(float elapsedTime)
-{
-    if(m_ignorePhysicsAfter < 0 || m_elapsedTime < m_ignorePhysicsAfter) {
-        // update position
-        PointF delta = m_velocity * elapsedTime;
-        delta.y *= -1; // painter orientate Y axis in the inverse direction
+        const auto& stops = particleType->pColorsStops;
+        const auto& typeColors = particleType->pColors;
+        uint8& index = colorIndex[i];
+        while(index + 1u < stops.size() && life >= stops[index + 1])
+            ++index;
+
+        if(index + 1u < stops.size()) {
+            const float factor = (life - stops[index]) / (stops[index + 1] - stops[index]);
+            colors[i] = typeColors[index] * (1.0f - factor) + typeColors[index + 1] * factor;
+        } else
+            colors[i] = typeColors[index];
+    }
 
-        PointF position = m_position + delta;
+    // branch free so the compiler can vectorize it, frozen particles move by a zero step
+    for(size_t i = 0; i < count; ++i) {
+        const float step = (ignorePhysicsAfter[i] < 0 || elapsedTime[i] < ignorePhysicsAfter[i]) ? elapsed : 0.f;
 
-        if(m_position != position) {
-            m_position += delta;
-        }
+        // painter orientate Y axis in the inverse direction
+        positionX[i] += velocityX[i] * step;
+        positionY[i] -= velocityY[i] * step;
 
-        // update acceleration
-        m_velocity += m_acceleration * elapsedTime;
+        velocityX[i] += accelerationX[i] * step;
+        velocityY[i] += accelerationY[i] * step;
+
+        elapsedTime[i] += elapsed;
     }
 
-    m_rect.move(static_cast<int>(m_position.x) - m_size.width() / 2, static_cast<int>(m_position.y) - m_size.height() / 2);
+    for(size_t i = 0; i < count; ++i) {
+        Rect& rect = rects[i];
+        rect.move(static_cast<int>(positionX[i]) - rect.width() / 2, static_cast<int>(positionY[i]) - rect.height() / 2);
+    }
 }
 
-void Particle::updateSize()
+void ParticleStore::removeFinished()
 {
-    m_size = m_startSize + (m_finalSize - m_startSize) / m_duration * m_elapsedTime;
-    m_rect.resize(m_size);
-}
+    // compact in place, keeping the draw order of the survivors
+    size_t n = 0;
+    for(size_t i = 0, count = size(); i < count; ++i) {
+        if(duration[i] >= 0 && elapsedTime[i] >= duration[i])
+            continue;
 
-void Particle::updateColor()
-{
-    float currentLife = m_elapsedTime / m_duration;
-    if(currentLife < m_colorsStops[1]) {
-        float range = m_colorsStops[1] - m_colorsStops[0];
-        float factor = (currentLife - m_colorsStops[0]) / range;
-        m_color = m_colors[0] * (1.0f - factor) + m_colors[1] * factor;
-    } else {
-        if(m_colors.size() > 1) {
-            m_colors.erase(m_colors.begin());
-            m_colorsStops.erase(m_colorsStops.begin());
-        } else {
-            if(m_color != m_colors[0]) {
-                m_color = m_colors[0];
-            }
+        if(n != i) {
+            positionX[n] = positionX[i];
+            positionY[n] = positionY[i];
+            velocityX[n] = velocityX[i];
+            velocityY[n] = velocityY[i];
+            accelerationX[n] = accelerationX[i];
+            accelerationY[n] = accelerationY[i];
+            elapsedTime[n] = elapsedTime[i];
+            duration[n] = duration[i];
+            ignorePhysicsAfter[n] = ignorePhysicsAfter[i];
+            type[n] = type[i];
+            colorIndex[n] = colorIndex[i];
+            rects[n] = rects[i];
+            colors[n] = colors[i];
         }
+        ++n;
     }
+
+    if(n != size())
+        resize(n);
+
+    if(empty())
+        types.clear();
+}
+
+void ParticleStore::resize(size_t n)
+{
+    positionX.resize(n);
+    positionY.resize(n);
+    velocityX.resize(n);
+    velocityY.resize(n);
+    accelerationX.resize(n);
+    accelerationY.resize(n);
+    elapsedTime.resize(n);
+    duration.resize(n);
+    ignorePhysicsAfter.resize(n);
+    type.resize(n);
+    colorIndex.resize(n);
+    rects.resize(n);
+    colors.resize(n);
 }
@@ -26,40 +26,33 @@
 #include "declarations.h"
 #include "painter.h"
 
-class Particle : public stdext::shared_object
+// every live particle of a ParticleSystem, kept as one array per attribute so
+// the affectors and the integration step walk contiguous floats
+struct ParticleStore
 {
-public:
-    Particle(const Point& pos, const Size& startSize, const Size& finalSize, const PointF& velocity, const PointF& acceleration, float duration, float ignorePhysicsAfter, const std::vector<Color>& colors, const std::vector<float>& colorsStops, Painter::CompositionMode compositionMode = Painter::CompositionMode_Normal, TexturePtr texture = nullptr);
-
-    void render();
+    void add(const ParticleTypePtr& type, const PointF& position, const PointF& velocity, const PointF& acceleration, float duration);
     void update(float elapsedTime);
+    void removeFinished();
 
-    bool hasFinished() { return m_finished; }
+    size_t size() const { return duration.size(); }
+    bool empty() const { return duration.empty(); }
 
-    PointF getPosition() { return m_position; }
-    PointF getVelocity() { return m_velocity; }
+    // the particle types in use, indexed by 'type'
+    std::vector<ParticleTypePtr> types;
 
-    void setPosition(const PointF& position) { m_position = position; }
-    void setVelocity(const PointF& velocity) { m_velocity = velocity; }
+    std::vector<float> positionX, positionY;
+    std::vector<float> velocityX, velocityY;
+    std::vector<float> accelerationX, accelerationY;
+    std::vector<float> elapsedTime, duration, ignorePhysicsAfter;
+    std::vector<uint16> type;
+    std::vector<uint8> colorIndex;
 
-private:
-    void updateColor();
-    void updatePosition(float elapsedTime);
-    void updateSize();
+    // results of the last update, read by the renderer
+    std::vector<Rect> rects;
+    std::vector<Color> colors;
 
-    Color m_color;
-    std::vector<Color> m_colors;
-    std::vector<float> m_colorsStops;
-    TexturePtr m_texture;
-    PointF m_position;
-    PointF m_velocity;
-    PointF m_acceleration;
-    Size m_size, m_startSize, m_finalSize;
-    Rect m_rect;
-    Painter::CompositionMode m_compositionMode;
-    float m_duration, m_ignorePhysicsAfter;
-    float m_elapsedTime;
-    bool m_finished;
+private:
+    void resize(size_t n);
 };
 
 #endif
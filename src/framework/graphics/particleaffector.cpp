@@ -87,14 +87,20 @@ void GravityAffector::load(const OTMLNodePtr& node)
     }
 }
 
-void GravityAffector::updateParticle(const ParticlePtr& particle, float elapsedTime)
+void GravityAffector::updateParticles(ParticleStore& particles, float elapsedTime)
 {
     if(!m_active)
         return;
 
-    PointF velocity = particle->getVelocity();
-    velocity += PointF(m_gravity * elapsedTime * std::cos(m_angle), m_gravity * elapsedTime * std::sin(m_angle));
-    particle->setVelocity(velocity);
+    const float deltaX = m_gravity * elapsedTime * std::cos(m_angle);
+    const float deltaY = m_gravity * elapsedTime * std::sin(m_angle);
+
+    float* velocityX = particles.velocityX.data();
+    float* velocityY = particles.velocityY.data();
+    for(size_t i = 0, count = particles.size(); i < count; ++i) {
+        velocityX[i] += deltaX;
+        velocityY[i] += deltaY;
+    }
 }
 
 void AttractionAffector::load(const OTMLNodePtr& node)
@@ -117,20 +123,30 @@ void AttractionAffector::load(const OTMLNodePtr& node)
     }
 }
 
-void AttractionAffector::updateParticle(const ParticlePtr& particle, float elapsedTime)
+void AttractionAffector::updateParticles(ParticleStore& particles, float elapsedTime)
 {
     if(!m_active)
         return;
 
-    PointF pPosition = particle->getPosition();
-    PointF d = PointF(m_position.x - pPosition.x, pPosition.y - m_position.y);
-    if(d.length() == 0)
-        return;
-
-    PointF direction = PointF(1, 1);
-    if(m_repelish)
-        direction = PointF(-1, -1);
-
-    PointF pVelocity = particle->getVelocity() + (d / d.length() * m_acceleration * elapsedTime) * direction;
-    particle->setVelocity(pVelocity - pVelocity * m_reduction / 100.f * elapsedTime);
+    const float direction = m_repelish ? -1.f : 1.f;
+    const float acceleration = m_acceleration * elapsedTime * direction;
+    const float reduction = m_reduction / 100.f * elapsedTime;
+    const float attractorX = m_position.x, attractorY = m_position.y;
+
+    const float* positionX = particles.positionX.data();
+    const float* positionY = particles.positionY.data();
+    float* velocityX = particles.velocityX.data();
+    float* velocityY = particles.velocityY.data();
+    for(size_t i = 0, count = particles.size(); i < count; ++i) {
+        const float dx = attractorX - positionX[i];
+        const float dy = positionY[i] - attractorY;
+        const float length = std::sqrt(dx * dx + dy * dy);
+
+        // particles sitting on the attractor are left untouched, without branching
+        const float scale = length > 0 ? acceleration / length : 0.f;
+        const float keep = length > 0 ? 1.f - reduction : 1.f;
+
+        velocityX[i] = (velocityX[i] + dx * scale) * keep;
+        velocityY[i] = (velocityY[i] + dy * scale) * keep;
+    }
 }
@@ -20,7 +20,6 @@
  * THE SOFTWARE.
  */
 
-#include "particle.h"
 #include "particleemitter.h"
 #include "particlesystem.h"
 #include <framework/core/clock.h>
@@ -100,12 +99,7 @@ void ParticleEmitter::update(float elapsedTime, const ParticleSystemPtr& system)
             float pAccelerationAngle = stdext::random_range(type->pMinAccelerationAngle, type->pMaxAccelerationAngle);
             PointF pAcceleration(pAccelerationAbs * std::cos(pAccelerationAngle), pAccelerationAbs * std::sin(pAccelerationAngle));
 
-            ParticlePtr particle(new Particle(pPosition, type->pStartSize, type->pFinalSize,
-                                              pVelocity, pAcceleration,
-                                              pDuration, type->pIgnorePhysicsAfter,
-                                              type->pColors, type->pColorsStops,
-                                              type->pCompositionMode, type->pTexture));
-            system->addParticle(particle);
+            system->addParticle(m_particleType, PointF(pPosition.x, pPosition.y), pVelocity, pAcceleration, pDuration);
         }
     }
 
@@ -20,8 +20,9 @@
  * THE SOFTWARE.
  */
 
-#include "particle.h"
 #include "particlesystem.h"
+#include "particletype.h"
+#include "drawpool.h"
 #include <framework/core/clock.h>
 
 ParticleSystem::ParticleSystem()
@@ -53,15 +54,84 @@ void ParticleSystem::load(const OTMLNodePtr& node)
     }
 }
 
-void ParticleSystem::addParticle(const ParticlePtr& particle)
+void ParticleSystem::addParticle(const ParticleTypePtr& type, const PointF& position, const PointF& velocity, const PointF& acceleration, float duration)
 {
-    m_particles.push_back(particle);
+    m_particles.add(type, position, velocity, acceleration, duration);
 }
 
 void ParticleSystem::render()
 {
-    for(auto& particle : m_particles)
-        particle->render();
+    if(m_particles.empty())
+        return;
+
+    if(g_painter->hasShaders()) {
+        renderBatched();
+        return;
+    }
+
+    for(size_t i = 0, count = m_particles.size(); i < count; ++i) {
+        const ParticleType* type = m_particles.types[m_particles.type[i]].get();
+        if(!type->pTexture)
+            g_drawPool.addFilledRect(m_particles.rects[i], m_particles.colors[i]);
+        else {
+            g_drawPool.addTexturedRect(m_particles.rects[i], type->pTexture, m_particles.colors[i]);
+            g_drawPool.setCompositionMode(type->pCompositionMode, g_drawPool.size());
+        }
+    }
+}
+
+void ParticleSystem::renderBatched()
+{
+    const auto& types = m_particles.types;
+    if(m_batches.size() < types.size())
+        m_batches.resize(types.size());
+
+    for(size_t t = 0; t < types.size(); ++t) {
+        m_batches[t].coords.clear();
+        m_batches[t].colors.clear();
+    }
+
+    std::vector<size_t> hashes(types.size(), 0);
+    for(size_t i = 0, count = m_particles.size(); i < count; ++i) {
+        const uint16 t = m_particles.type[i];
+        const TexturePtr& texture = types[t]->pTexture;
+        const Rect& rect = m_particles.rects[i];
+        const Color& color = m_particles.colors[i];
+
+        if(!texture) {
+            g_drawPool.addFilledRect(rect, color);
+            continue;
+        }
+
+        // addRect emits two triangles, every vertex carries the particle color
+        ParticleBatch& batch = m_batches[t];
+        batch.coords.addRect(rect, Rect(Point(), texture->getSize()));
+        for(int v = -1; ++v < 6;)
+            batch.colors.insert(batch.colors.end(), { color.rF(), color.gF(), color.bF(), color.aF() });
+
+        boost::hash_combine(hashes[t], rect.hash());
+        boost::hash_combine(hashes[t], color.rgba());
+    }
+
+    // the batches live in this system, which the closure keeps alive until the pool is drawn
+    const auto self = static_self_cast<ParticleSystem>();
+    const Rect clipRect = g_drawPool.getClipRect();
+    for(size_t t = 0; t < types.size(); ++t) {
+        ParticleBatch& batch = m_batches[t];
+        if(batch.colors.empty())
+            continue;
+
+        const TexturePtr texture = types[t]->pTexture;
+        const Painter::CompositionMode compositionMode = types[t]->pCompositionMode;
+        g_drawPool.addAction([self, &batch, texture, compositionMode, clipRect] {
+            texture->create();
+            g_painter->setClipRect(clipRect);
+            g_painter->setCompositionMode(compositionMode);
+            g_painter->setTexture(texture.get());
+            g_painter->drawColoredCoords(batch.coords, batch.colors.data());
+            g_painter->resetCompositionMode();
+        }, hashes[t]);
+    }
 }
 
 void ParticleSystem::update()
@@ -106,18 +176,12 @@ void ParticleSystem::update()
         }
 
         // update particles
-        for(auto it = m_particles.begin(); it != m_particles.end();) {
-            const ParticlePtr& particle = *it;
-            if(particle->hasFinished()) {
-                it = m_particles.erase(it);
-            } else {
-                // pass particles through affectors
-                for(const ParticleAffectorPtr& particleAffector : m_affectors)
-                    particleAffector->updateParticle(particle, delay);
+        m_particles.removeFinished();
 
-                particle->update(delay);
-                ++it;
-            }
-        }
+        // pass particles through affectors
+        for(const ParticleAffectorPtr& particleAffector : m_affectors)
+            particleAffector->updateParticles(m_particles, delay);
+
+        m_particles.update(delay);
     }
 }
@@ -27,6 +27,7 @@
 #include "particle.h"
 #include "particleemitter.h"
 #include "particleaffector.h"
+#include "coordsbuffer.h"
 
 class ParticleSystem : public stdext::shared_object {
 public:
@@ -34,7 +35,7 @@ public:
 
     void load(const OTMLNodePtr& node);
 
-    void addParticle(const ParticlePtr& particle);
+    void addParticle(const ParticleTypePtr& type, const PointF& position, const PointF& velocity, const PointF& acceleration, float duration);
 
     void render();
     void update();
@@ -42,9 +43,19 @@ public:
     bool hasFinished() { return m_finished; }
 
 private:
+    // textured particles of one type, drawn in a single call
+    struct ParticleBatch
+    {
+        CoordsBuffer coords;
+        std::vector<float> colors;
+    };
+
+    void renderBatched();
+
     bool m_finished;
     float m_lastUpdateTime;
-    std::list<ParticlePtr> m_particles;
+    ParticleStore m_particles;
+    std::vector<ParticleBatch> m_batches;
     std::list<ParticleEmitterPtr> m_emitters;
     std::list<ParticleAffectorPtr> m_affectors;
 };
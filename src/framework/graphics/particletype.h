@@ -67,6 +67,8 @@ protected:
     Painter::CompositionMode pCompositionMode;
 
     friend class ParticleEmitter;
+    friend class ParticleSystem;
+    friend struct ParticleStore;
 };
 
 #endif
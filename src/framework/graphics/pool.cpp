@@ -21,6 +21,7 @@
  */
 
 #include "pool.h"
+#include "graphics.h"
 
 const static std::hash<size_t> HASH_INT;
 const static std::hash<float> HASH_FLOAT;
@@ -37,6 +38,7 @@ void Pool::setCompositionMode(const Painter::CompositionMode mode, const int pos
     }
 
     m_objects[pos - 1].state.compositionMode = mode;
+    reindexObject(pos - 1);
 }
 
 void Pool::setClipRect(const Rect& clipRect, const int pos)
@@ -51,6 +53,7 @@ void Pool::setClipRect(const Rect& clipRect, const int pos)
     }
 
     m_objects[pos - 1].state.clipRect = clipRect;
+    reindexObject(pos - 1);
 }
 
 void Pool::setOpacity(const float opacity, const int pos)
@@ -65,6 +68,7 @@ void Pool::setOpacity(const float opacity, const int pos)
     }
 
     m_objects[pos - 1].state.opacity = opacity;
+    reindexObject(pos - 1);
 }
 
 void Pool::setShaderProgram(const PainterShaderProgramPtr& shaderProgram, const int pos)
@@ -81,6 +85,7 @@ void Pool::setShaderProgram(const PainterShaderProgramPtr& shaderProgram, const
     }
 
     m_objects[pos - 1].state.shaderProgram = shader;
+    reindexObject(pos - 1);
 }
 
 void Pool::resetState()
@@ -89,6 +94,8 @@ void Pool::resetState()
     resetCompositionMode();
     resetOpacity();
     resetShaderProgram();
+    resetSampling();
+    resetTranslation();
     m_indexToStartSearching = 0;
 
     if(hasFrameBuffer()) {
@@ -96,6 +103,110 @@ void Pool::resetState()
     }
 }
 
+size_t Pool::hashState(const Painter::PainterState& state)
+{
+    size_t hash = 0;
+
+    if(state.texture) boost::hash_combine(hash, HASH_INT(reinterpret_cast<size_t>(state.texture.get())));
+    if(state.shaderProgram) boost::hash_combine(hash, HASH_INT(reinterpret_cast<size_t>(state.shaderProgram)));
+
+    boost::hash_combine(hash, HASH_INT(state.color.rgba()));
+    boost::hash_combine(hash, HASH_FLOAT(state.opacity));
+    boost::hash_combine(hash, HASH_INT(state.compositionMode));
+    boost::hash_combine(hash, HASH_INT(state.blendEquation));
+    boost::hash_combine(hash, state.clipRect.hash());
+    boost::hash_combine(hash, HASH_INT(state.alphaWriting));
+    boost::hash_combine(hash, HASH_INT(state.silhouette | state.smoothSampling << 1));
+
+    return hash;
+}
+
+Pool::DrawObject* Pool::findIndexedObject(const Painter::PainterState& state, const size_t stateHash, const size_t startIndex)
+{
+    while(m_indexedObjects < m_objects.size())
+        indexObject(m_indexedObjects++);
+
+    ++m_stateIndexStats.lookups;
+
+    const auto it = m_stateIndex.find(stateHash);
+    if(it == m_stateIndex.end()) return nullptr;
+
+    // the bucket is kept sorted, so the first match is the same object a linear scan would find
+    const auto& bucket = it->second;
+    for(auto itIndex = std::lower_bound(bucket.begin(), bucket.end(), startIndex); itIndex != bucket.end(); ++itIndex) {
+        ++m_stateIndexStats.comparisons;
+
+        auto& obj = m_objects[*itIndex];
+        if(obj.state == state) {
+            ++m_stateIndexStats.hits;
+            return &obj;
+        }
+    }
+
+    return nullptr;
+}
+
+void Pool::indexObject(const size_t index)
+{
+    auto& obj = m_objects[index];
+    if(obj.action) return;
+
+    obj.stateHash = hashState(obj.state);
+
+    auto& bucket = m_stateIndex[obj.stateHash];
+    bucket.insert(std::upper_bound(bucket.begin(), bucket.end(), index), index);
+
+    ++m_stateIndexStats.inserts;
+}
+
+void Pool::reindexObject(const size_t index)
+{
+    if(index >= m_indexedObjects || m_objects[index].action) return;
+
+    const auto it = m_stateIndex.find(m_objects[index].stateHash);
+    if(it != m_stateIndex.end()) {
+        auto& bucket = it->second;
+        const auto itIndex = std::lower_bound(bucket.begin(), bucket.end(), index);
+        if(itIndex != bucket.end() && *itIndex == index)
+            bucket.erase(itIndex);
+    }
+
+    indexObject(index);
+}
+
+void Pool::clearObjects()
+{
+    m_objects.clear();
+    m_stateIndex.clear();
+    m_indexedObjects = 0;
+    m_arenas[m_recordArena].reset();
+}
+
+void Pool::swapObjects()
+{
+    m_submitObjects.clear();
+    std::swap(m_objects, m_submitObjects);
+    m_recordArena ^= 1;
+    clearObjects();
+}
+
+FramedPool::CoordsCache* FramedPool::getCoordsCache(const size_t index)
+{
+    if(!m_hardwareCache || !g_graphics.canUseHardwareBuffers())
+        return nullptr;
+
+    if(index >= m_coordsCache.size())
+        m_coordsCache.resize(index + 1);
+
+    auto& cache = m_coordsCache[index];
+    if(!cache) {
+        cache = std::make_unique<CoordsCache>();
+        cache->buffer.enableHardwareCaching();
+    }
+
+    return cache.get();
+}
+
 bool FramedPool::hasModification()
 {
     return m_status.first != m_status.second || (m_autoUpdate && m_refreshTime.ticksElapsed() > 50);
@@ -27,15 +27,26 @@
 #include "framebuffer.h"
 #include "texture.h"
 #include "framebuffermanager.h"
+#include "framearena.h"
 
 class Pool
 {
 public:
+    struct StateIndexStats {
+        uint32 lookups{ 0 };
+        uint32 hits{ 0 };
+        uint32 inserts{ 0 };
+        uint32 comparisons{ 0 };
+    };
+
     void setEnable(const bool v) { m_enabled = v; }
     bool isEnabled() const { return m_enabled; }
 
+    const StateIndexStats& getStateIndexStats() const { return m_stateIndexStats; }
+    void resetStateIndexStats() { m_stateIndexStats = {}; }
+
 protected:
-    enum class DrawMethodType {
+    enum class DrawMethodType : uint8 {
         DRAW_FILLED_RECT,
         DRAW_BOUNDING_RECT,
         DRAW_TEXTURED_RECT,
@@ -43,26 +54,43 @@ protected:
         DRAW_REPEATED_FILLED_RECT,
         DRAW_REPEATED_TEXTURED_RECT,
         DRAW_UPSIDEDOWN_TEXTURED_RECT,
-        DRAW_REPEATED_TEXTURED_REPEATED_RECT
+        DRAW_REPEATED_TEXTURED_REPEATED_RECT,
+        DRAW_OUTFIT_RECT
     };
 
     struct DrawMethod {
         DrawMethodType type;
+        uint16 intValue{ 0 };
+        uint16 layer{ 0 }; // array texture layer sampled by textured rects
         std::pair<Rect, Rect> rects{};
         std::tuple<Point, Point, Point> points{};
         Point dest{};
-        uint16 intValue{ 0 };
-        size_t hash{ 0 };
+        // with packed quads the color and opacity live in the vertices instead of the state
+        Color color{ Color::white };
+        // outfit rects tint the mask frame found at this offset from the source rect
+        Point maskOffset{};
+        std::array<uint32, 4> maskColors{};
+
+        bool operator==(const DrawMethod& other) const
+        {
+            return type == other.type && rects == other.rects && points == other.points && intValue == other.intValue && color == other.color && layer == other.layer &&
+                maskOffset == other.maskOffset && maskColors == other.maskColors;
+        }
     };
 
+    // method lists are allocated from the arena of the frame being recorded
+    typedef std::vector<DrawMethod, FrameAllocator<DrawMethod>> DrawMethodList;
+
     struct DrawObject {
         ~DrawObject() { drawMethods.clear(); state.texture = nullptr; action = nullptr; }
 
         Painter::PainterState state;
         Painter::DrawMode drawMode{ Painter::DrawMode::Triangles };
-        std::vector<DrawMethod> drawMethods;
+        DrawMethodList drawMethods;
 
         std::function<void()> action{ nullptr };
+
+        size_t stateHash{ 0 };
     };
 
 private:
@@ -71,7 +99,12 @@ private:
         Rect clipRect;
         float opacity;
         bool alphaWriting{ true };
+        bool silhouette{ false };
+        bool smoothSampling{ false };
         PainterShaderProgram* shaderProgram;
+        // content recorded away from its place on screen, moved by the offset and kept inside the bounds
+        Point translation;
+        Rect translationBounds;
     };
 
     void setCompositionMode(const Painter::CompositionMode mode, const int pos = -1);
@@ -83,19 +116,42 @@ private:
     void resetCompositionMode() { m_state.compositionMode = Painter::CompositionMode_Normal; }
     void resetOpacity() { m_state.opacity = 1.f; }
     void resetShaderProgram() { m_state.shaderProgram = nullptr; }
+    void resetSampling() { m_state.silhouette = false; m_state.smoothSampling = false; }
+    void resetTranslation() { m_state.translation = Point(); m_state.translationBounds = Rect(); }
     void resetState();
     void startPosition() { m_indexToStartSearching = m_objects.size(); }
 
+    // objects are indexed lazily, only pools that use addRepeated pay for it
+    DrawObject* findIndexedObject(const Painter::PainterState& state, size_t stateHash, size_t startIndex);
+    void indexObject(size_t index);
+    void reindexObject(size_t index);
+    void clearObjects();
+    // hands the recorded objects over to m_submitObjects, the arena of the frame submitted before is reused for recording
+    void swapObjects();
+    DrawMethodList createMethodList() { return DrawMethodList(FrameAllocator<DrawMethod>(&m_arenas[m_recordArena])); }
+
+    static size_t hashState(const Painter::PainterState& state);
+
     virtual bool hasFrameBuffer() const { return false; };
     virtual FramedPool* toFramedPool() { return nullptr; }
 
+    // declared before the objects, which still release their method lists into them when destroyed
+    std::array<FrameArena, 2> m_arenas;
+    uint8 m_recordArena{ 0 };
+
+    // the frame being recorded and the frame handed over to DrawPool::draw, swapped once per frame
     std::vector<DrawObject> m_objects;
+    std::vector<DrawObject> m_submitObjects;
 
     bool m_enabled{ true };
     State m_state;
 
     uint16_t m_indexToStartSearching{ 0 };
 
+    std::unordered_map<size_t, std::vector<size_t>> m_stateIndex;
+    size_t m_indexedObjects{ 0 };
+    StateIndexStats m_stateIndexStats;
+
     friend class DrawPool;
 };
 
@@ -105,6 +161,13 @@ public:
     void onAfterDraw(std::function<void()> f) { m_afterDraw = f; }
     void resize(const Size& size) { m_framebuffer->resize(size); }
     void setSmooth(bool enabled) { m_framebuffer->setSmooth(enabled); }
+    void setHardwareCache(bool enabled) { m_hardwareCache = enabled; if(!enabled) m_coordsCache.clear(); }
+    bool isHardwareCached() const { return m_hardwareCache; }
+
+    // offscreen pools are only rendered into their framebuffer, another pool draws the texture
+    void setOffscreen(bool enabled) { m_offscreen = enabled; }
+    bool isOffscreen() const { return m_offscreen; }
+    TexturePtr getTexture() const { return m_framebuffer->getTexture(); }
 
 protected:
     bool m_autoUpdate{ false };
@@ -113,6 +176,16 @@ protected:
     friend class Pool;
 
 private:
+    // vertices of each draw object kept in video memory while its draw methods don't change
+    struct CoordsCache {
+        CoordsBuffer buffer;
+        Painter::DrawMode drawMode{ Painter::DrawMode::None };
+        std::vector<DrawMethod> drawMethods;
+    };
+
+    CoordsCache* getCoordsCache(size_t index);
+    void trimCoordsCache(const size_t size) { if(m_coordsCache.size() > size) m_coordsCache.resize(size); }
+
     void updateStatus() { m_status.first = m_status.second; m_refreshTime.restart(); }
     void resetCurrentStatus() { m_status.second = 0; }
     bool hasModification();
@@ -122,10 +195,17 @@ private:
 
     FrameBufferPtr m_framebuffer;
     Rect m_dest, m_src;
+    // what the handed over frame is composed with, recording the next one may change m_dest and m_src
+    Rect m_submitDest, m_submitSrc;
+    bool m_submitRedraw{ false };
 
     std::function<void()> m_beforeDraw, m_afterDraw;
     std::pair<size_t, size_t> m_status{ 0,0 };
     Timer m_refreshTime;
+
+    std::vector<std::unique_ptr<CoordsCache>> m_coordsCache;
+    bool m_hardwareCache{ true },
+        m_offscreen{ false };
 };
 
 extern DrawPool g_drawPool;
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "screencapture.h"
+#include "graphics.h"
+#include "apngloader.h"
+
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/logger.h>
+#include <framework/core/resourcemanager.h>
+#include <framework/luaengine/luainterface.h>
+
+ScreenCapture g_screenCapture;
+
+static void notifySaved(const std::string& fileName, bool ok)
+{
+    g_lua.callGlobalField("g_screenCapture", "onCaptureSaved", fileName, ok);
+}
+
+bool ScreenCapture::captureRect(const std::string& fileName, const Rect& rect)
+{
+    if(fileName.empty() || !g_graphics.ok())
+        return false;
+
+    m_requests.push_back(Request{ fileName, rect });
+    return true;
+}
+
+void ScreenCapture::readFrame()
+{
+    for(PendingRead& read : m_reads)
+        read.frames++;
+
+    if(m_requests.empty())
+        return;
+
+    const bool async = g_graphics.canUseAsyncReadback();
+    const Rect viewport(Point(0, 0), g_graphics.getViewportSize());
+    while(!m_requests.empty()) {
+        if(async && m_reads.size() >= MAX_PENDING_READS)
+            break;
+
+        const Request request = m_requests.front();
+        m_requests.pop_front();
+
+        const Rect rect = request.rect.isValid() ? request.rect.intersection(viewport) : viewport;
+        if(!rect.isValid()) {
+            g_logger.error(stdext::format("Unable to capture '%s': the area is outside of the screen", request.fileName));
+            notifySaved(request.fileName, false);
+            continue;
+        }
+
+        // gl rows start at the bottom of the viewport
+        const int y = viewport.height() - rect.bottom() - 1;
+        const int dataSize = rect.width() * rect.height() * 4;
+
+#ifndef OPENGL_ES
+        if(async) {
+            PendingRead read;
+            read.fileName = request.fileName;
+            read.size = rect.size();
+            read.buffer = std::make_unique<HardwareBuffer>(HardwareBuffer::PixelPackBuffer);
+            read.buffer->bind();
+            read.buffer->write(nullptr, dataSize, HardwareBuffer::StreamRead);
+            glReadPixels(rect.left(), y, rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            read.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            HardwareBuffer::unbind(HardwareBuffer::PixelPackBuffer);
+            m_reads.push_back(std::move(read));
+            continue;
+        }
+#endif
+
+        // without pixel buffers the read waits for the whole frame to be rendered
+        std::vector<uint8> pixels(dataSize);
+        glReadPixels(rect.left(), y, rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        encode(request.fileName, rect.size(), std::move(pixels));
+    }
+}
+
+void ScreenCapture::poll()
+{
+#ifndef OPENGL_ES
+    for(auto it = m_reads.begin(); it != m_reads.end();) {
+        // a read still in flight is left for a later poll, unless it has been waiting for too many frames
+        if(it->frames < MAX_READ_LATENCY && glClientWaitSync(it->fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            ++it;
+            continue;
+        }
+
+        collectRead(*it);
+        it = m_reads.erase(it);
+    }
+#endif
+}
+
+void ScreenCapture::terminate()
+{
+#ifndef OPENGL_ES
+    for(PendingRead& read : m_reads)
+        glDeleteSync(read.fence);
+#endif
+    m_reads.clear();
+    m_requests.clear();
+}
+
+void ScreenCapture::collectRead(PendingRead& read)
+{
+#ifndef OPENGL_ES
+    const int dataSize = read.size.area() * 4;
+    std::vector<uint8> pixels;
+
+    read.buffer->bind();
+    if(const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, dataSize, GL_MAP_READ_BIT)) {
+        pixels.assign(static_cast<const uint8*>(mapped), static_cast<const uint8*>(mapped) + dataSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    HardwareBuffer::unbind(HardwareBuffer::PixelPackBuffer);
+
+    glDeleteSync(read.fence);
+    read.fence = nullptr;
+    read.buffer.reset();
+
+    if(pixels.empty()) {
+        g_logger.error(stdext::format("Unable to capture '%s': failed to map the pixel buffer", read.fileName));
+        notifySaved(read.fileName, false);
+        return;
+    }
+
+    encode(read.fileName, read.size, std::move(pixels));
+#endif
+}
+
+void ScreenCapture::encode(const std::string& fileName, const Size& size, std::vector<uint8>&& pixels)
+{
+    m_encoding++;
+
+    const auto bottomUp = std::make_shared<std::vector<uint8>>(std::move(pixels));
+    auto task = g_asyncDispatcher.schedule([size, bottomUp] {
+        const int stride = size.width() * 4;
+        std::vector<uint8> image(bottomUp->size());
+        for(int y = 0; y < size.height(); ++y)
+            memcpy(&image[y * stride], &(*bottomUp)[(size.height() - y - 1) * stride], stride);
+
+        // the back buffer alpha is whatever blending left there
+        for(size_t i = 3; i < image.size(); i += 4)
+            image[i] = 255;
+
+        std::stringstream data;
+        save_png(data, size.width(), size.height(), 4, image.data());
+        return data.str();
+    }, AsyncDispatcher::PriorityLow);
+
+    // the resource manager is bound to the main thread
+    task.then_on_main([this, fileName](const std::shared_future<std::string>& future) {
+        m_encoding--;
+
+        bool ok = false;
+        try {
+            ok = g_resources.writeFileContents(fileName, future.get());
+        } catch(std::exception& e) {
+            g_logger.error(stdext::format("Unable to encode screen capture '%s': %s", fileName, e.what()));
+        }
+
+        if(!ok)
+            g_logger.error(stdext::format("Unable to save screen capture '%s'", fileName));
+        notifySaved(fileName, ok);
+    });
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SCREENCAPTURE_H
+#define SCREENCAPTURE_H
+
+#include "declarations.h"
+#include "hardwarebuffer.h"
+
+// screenshots read back into pixel buffers and collected a few frames later, so the copy never stalls the frame,
+// the png encoding runs on the async dispatcher and only the file write is left to the main thread
+class ScreenCapture
+{
+public:
+    enum {
+        MAX_PENDING_READS = 3, // pixel buffers in flight, further captures wait for a free one
+        MAX_READ_LATENCY = 4 // frames before a read is collected even if its fence hasn't signaled
+    };
+
+    // an invalid rect captures the whole viewport, g_screenCapture.onCaptureSaved(fileName, ok) is called once saved
+    bool capture(const std::string& fileName) { return captureRect(fileName, Rect()); }
+    bool captureRect(const std::string& fileName, const Rect& rect);
+
+    // issues the queued reads, must run after the frame is drawn and before the buffers are swapped
+    void readFrame();
+    void poll();
+    void terminate();
+
+    int getPendingCount() { return m_requests.size() + m_reads.size() + m_encoding; }
+
+private:
+    struct Request {
+        std::string fileName;
+        Rect rect;
+    };
+
+    struct PendingRead {
+        std::string fileName;
+        Size size;
+        std::unique_ptr<HardwareBuffer> buffer;
+        int frames = 0;
+#ifndef OPENGL_ES
+        GLsync fence = nullptr;
+#endif
+    };
+
+    void collectRead(PendingRead& read);
+    void encode(const std::string& fileName, const Size& size, std::vector<uint8>&& pixels);
+
+    std::deque<Request> m_requests;
+    std::vector<PendingRead> m_reads;
+    int m_encoding = 0;
+};
+
+extern ScreenCapture g_screenCapture;
+
+#endif
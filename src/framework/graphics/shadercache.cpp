@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shadercache.h"
+#include "graphics.h"
+
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+#if OPENGL_ES==2
+#include <EGL/egl.h>
+
+#define GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+
+static PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary = nullptr;
+static PFNGLPROGRAMBINARYOESPROC glProgramBinary = nullptr;
+#endif
+
+ShaderCache g_shaderCache;
+
+static const char* SHADER_CACHE_DIR = "/shadercache";
+static const uint32 SHADER_CACHE_MAGIC = 0x53435447; // GTCS
+
+bool ShaderCache::isEnabled()
+{
+    // programs linked before the write dir is set are compiled as usual
+    if(!m_enabled || g_resources.getWriteDir().empty() || !g_graphics.canUseProgramBinaries())
+        return false;
+
+#if OPENGL_ES==2
+    if(!glGetProgramBinary) {
+        glGetProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(eglGetProcAddress("glGetProgramBinaryOES"));
+        glProgramBinary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(eglGetProcAddress("glProgramBinaryOES"));
+    }
+    return glGetProgramBinary && glProgramBinary;
+#else
+    return true;
+#endif
+}
+
+bool ShaderCache::load(uint programId, const std::string& key)
+{
+#if OPENGL_ES!=1
+    const std::string entryPath = getEntryPath(key);
+    if(!g_resources.fileExists(entryPath)) {
+        m_misses++;
+        return false;
+    }
+
+    try {
+        FileStreamPtr fin(new FileStream(entryPath, g_resources.readFileContents(entryPath)));
+        if(fin->getU32() != SHADER_CACHE_MAGIC || fin->getU8() != FORMAT)
+            stdext::throw_exception("unknown entry format");
+
+        // a driver update invalidates every binary, the entries are replaced as the programs get linked again
+        if(fin->getString() != getDriverVersion() || fin->getU32() != stdext::adler32((const uint8*)key.data(), key.size())) {
+            m_misses++;
+            return false;
+        }
+
+        const uint32 binaryFormat = fin->getU32();
+        const uint32 checksum = fin->getU32();
+        const uint8* binary = fin->cachedData() + fin->tell();
+        const uint binarySize = fin->size() - fin->tell();
+        if(binarySize == 0 || stdext::adler32(binary, binarySize) != checksum)
+            stdext::throw_exception("checksum mismatch");
+
+        glProgramBinary(programId, binaryFormat, binary, binarySize);
+
+        int linked = GL_FALSE;
+        glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+        if(linked == GL_FALSE)
+            stdext::throw_exception("binary refused by the driver");
+
+        m_hits++;
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.warning(stdext::format("Discarding shader cache entry '%s': %s", entryPath, e.what()));
+        g_resources.deleteFile(entryPath);
+        m_misses++;
+        return false;
+    }
+#else
+    return false;
+#endif
+}
+
+void ShaderCache::store(uint programId, const std::string& key)
+{
+#if OPENGL_ES!=1
+    int binarySize = 0;
+    glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if(binarySize <= 0)
+        return;
+
+    std::vector<uint8> binary(binarySize);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(programId, binarySize, &binarySize, &binaryFormat, binary.data());
+    if(binarySize <= 0)
+        return;
+
+    try {
+        if(!g_resources.directoryExists(SHADER_CACHE_DIR))
+            g_resources.makeDir(SHADER_CACHE_DIR);
+
+        FileStreamPtr fout = g_resources.createFile(getEntryPath(key));
+        fout->addU32(SHADER_CACHE_MAGIC);
+        fout->addU8(FORMAT);
+        fout->addString(getDriverVersion());
+        fout->addU32(stdext::adler32((const uint8*)key.data(), key.size()));
+        fout->addU32(binaryFormat);
+        fout->addU32(stdext::adler32(binary.data(), binarySize));
+        fout->write(binary.data(), binarySize);
+        fout->close();
+    } catch(stdext::exception& e) {
+        // most likely a read only write dir, don't retry for every program
+        g_logger.warning(stdext::format("Unable to write shader cache, disabling it: %s", e.what()));
+        m_enabled = false;
+    }
+#endif
+}
+
+void ShaderCache::clear()
+{
+    if(g_resources.getWriteDir().empty() || !g_resources.directoryExists(SHADER_CACHE_DIR))
+        return;
+
+    for(const std::string& fileName : g_resources.listDirectoryFiles(SHADER_CACHE_DIR))
+        g_resources.deleteFile(std::string(SHADER_CACHE_DIR) + "/" + fileName);
+}
+
+std::string ShaderCache::getDriverVersion()
+{
+    return g_graphics.getVendor() + "\n" + g_graphics.getRenderer() + "\n" + g_graphics.getVersion();
+}
+
+std::string ShaderCache::getEntryPath(const std::string& key)
+{
+    // collisions are harmless since the entry also stores a checksum of the key
+    const uint64 hash = stdext::fnv1a64((const uint8*)key.data(), key.size());
+    return stdext::format("%s/%016llx.bin", SHADER_CACHE_DIR, (unsigned long long)hash);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include "declarations.h"
+
+// linked program binaries kept in the write dir, so later launches skip compiling and linking the GLSL sources,
+// entries are keyed by the sources and attribute bindings and only reused by the same driver and renderer
+class ShaderCache
+{
+public:
+    enum {
+        FORMAT = 1 // bump whenever the entry layout changes
+    };
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled();
+
+    // loads the entry into the program, false when there is none or the driver refused it
+    bool load(uint programId, const std::string& key);
+    void store(uint programId, const std::string& key);
+    void clear();
+
+    int getHits() { return m_hits; }
+    int getMisses() { return m_misses; }
+
+private:
+    static std::string getDriverVersion();
+    static std::string getEntryPath(const std::string& key);
+
+    bool m_enabled{ true };
+    int m_hits{ 0 };
+    int m_misses{ 0 };
+};
+
+extern ShaderCache g_shaderCache;
+
+#endif
@@ -22,8 +22,10 @@
 
 #include "shaderprogram.h"
 #include "graphics.h"
+#include "shadercache.h"
 
 #include <framework/core/application.h>
+#include <framework/core/resourcemanager.h>
 
 uint ShaderProgram::m_currentProgram = 0;
 
@@ -55,6 +57,12 @@ bool ShaderProgram::addShader(const ShaderPtr& shader)
 
 bool ShaderProgram::addShaderFromSourceCode(Shader::ShaderType shaderType, const std::string& sourceCode)
 {
+    if(g_graphics.canUseProgramBinaries()) {
+        m_pendingSources.emplace_back(shaderType, sourceCode);
+        m_linked = false;
+        return true;
+    }
+
     ShaderPtr shader(new Shader(shaderType));
     if(!shader->compileSourceCode(sourceCode)) {
         g_logger.error(stdext::format("failed to compile shader: %s", shader->log()));
@@ -65,12 +73,12 @@ bool ShaderProgram::addShaderFromSourceCode(Shader::ShaderType shaderType, const
 
 bool ShaderProgram::addShaderFromSourceFile(Shader::ShaderType shaderType, const std::string& sourceFile)
 {
-    ShaderPtr shader(new Shader(shaderType));
-    if(!shader->compileSourceFile(sourceFile)) {
-        g_logger.error(stdext::format("failed to compile shader: %s", shader->log()));
-        return false;
+    try {
+        return addShaderFromSourceCode(shaderType, g_resources.readFileContents(sourceFile));
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("unable to load shader source form file '%s': %s", sourceFile, e.what()));
     }
-    return addShader(shader);
+    return false;
 }
 
 void ShaderProgram::removeShader(const ShaderPtr& shader)
@@ -95,6 +103,38 @@ bool ShaderProgram::link()
     if(m_linked)
         return true;
 
+    // the attribute locations are baked into the binary, so they are part of the key
+    std::string cacheKey;
+    const bool cacheable = !m_pendingSources.empty() && g_shaderCache.isEnabled();
+    if(cacheable) {
+        for(const auto& source : m_pendingSources)
+            cacheKey += stdext::format("%d\n%s\n", static_cast<int>(source.first), source.second);
+        cacheKey += m_attributeBindings;
+    }
+    m_attributeBindings.clear();
+
+    if(cacheable && g_shaderCache.load(m_programId, cacheKey)) {
+        m_pendingSources.clear();
+        m_linked = true;
+        return true;
+    }
+
+    const auto pendingSources = std::move(m_pendingSources);
+    m_pendingSources.clear();
+    for(const auto& source : pendingSources) {
+        ShaderPtr shader(new Shader(source.first));
+        if(!shader->compileSourceCode(source.second)) {
+            g_logger.error(stdext::format("failed to compile shader: %s", shader->log()));
+            return false;
+        }
+        addShader(shader);
+    }
+
+#ifndef OPENGL_ES
+    if(cacheable)
+        glProgramParameteri(m_programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+
     glLinkProgram(m_programId);
 
     int value = GL_FALSE;
@@ -103,6 +143,8 @@ bool ShaderProgram::link()
 
     if(!m_linked)
         g_logger.traceWarning(log());
+    else if(cacheable)
+        g_shaderCache.store(m_programId, cacheKey);
     return m_linked;
 }
 
@@ -145,6 +187,7 @@ int ShaderProgram::getAttributeLocation(const char* name)
 
 void ShaderProgram::bindAttributeLocation(int location, const char* name)
 {
+    m_attributeBindings += stdext::format("%d %s\n", location, name);
     return glBindAttribLocation(m_programId, location, name);
 }
 
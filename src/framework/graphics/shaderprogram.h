@@ -85,6 +85,7 @@ public:
 
     bool isLinked() { return m_linked; }
     uint getProgramId() { return m_programId; }
+    static uint getCurrentProgram() { return m_currentProgram; }
     ShaderList getShaders() { return m_shaders; }
 
 private:
@@ -92,6 +93,10 @@ private:
     uint m_programId;
     static uint m_currentProgram;
     ShaderList m_shaders;
+
+    // with program binaries the sources are compiled at link, only when the shader cache has no entry for them
+    std::vector<std::pair<Shader::ShaderType, std::string>> m_pendingSources;
+    std::string m_attributeBindings;
     std::array<int, MAX_UNIFORM_LOCATIONS> m_uniformLocations;
 };
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "streambuffer.h"
+#include "graphics.h"
+
+#include <framework/core/logger.h>
+
+StreamBuffer::StreamBuffer(int vertexCapacity, int vertexSize)
+{
+    m_vertexCapacity = vertexCapacity;
+    m_vertexSize = vertexSize;
+    m_buffer = std::make_unique<HardwareBuffer>(HardwareBuffer::VertexBuffer);
+    m_buffer->bind();
+
+    const int size = vertexCapacity * vertexSize;
+#ifndef OPENGL_ES
+    // with buffer storage the ring is mapped once and fences keep the cpu behind the gpu
+    if(GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        m_mapped = static_cast<uint8*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+        if(!m_mapped)
+            g_logger.warning("Unable to persistently map the vertex stream buffer");
+    }
+    if(!m_mapped)
+        m_buffer->write(nullptr, size, HardwareBuffer::StreamDraw);
+#endif
+
+    HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+#ifndef OPENGL_ES
+    if(!g_graphics.ok())
+        return;
+
+    for(GLsync& fence : m_fences) {
+        if(fence)
+            glDeleteSync(fence);
+    }
+
+    if(m_mapped) {
+        m_buffer->bind();
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+    }
+#endif
+}
+
+int StreamBuffer::write(const void* vertices, int vertexCount)
+{
+    if(vertexCount <= 0 || vertexCount > m_vertexCapacity)
+        return -1;
+
+    if(m_cursor + vertexCount > m_vertexCapacity)
+        wrap();
+
+    const int first = m_cursor;
+    const int offset = first * m_vertexSize;
+    const int size = vertexCount * m_vertexSize;
+
+#ifndef OPENGL_ES
+    if(m_mapped) {
+        const int segmentSize = m_vertexCapacity / SEGMENTS + 1;
+        const int lastSegment = (first + vertexCount - 1) / segmentSize;
+        while(m_segment < lastSegment)
+            enterSegment(m_segment + 1);
+
+        std::memcpy(m_mapped + offset, vertices, size);
+    } else {
+        // the range was never handed to the gpu since the last orphaning, no sync is needed
+        m_buffer->bind();
+        void* data = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if(!data) {
+            HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+            return -1;
+        }
+        std::memcpy(data, vertices, size);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+    }
+#endif
+
+    m_cursor += vertexCount;
+    return first;
+}
+
+void StreamBuffer::wrap()
+{
+#ifndef OPENGL_ES
+    if(m_mapped) {
+        // the segments after the current one are skipped this lap, they keep their fences
+        enterSegment(0);
+    } else {
+        // orphan the storage, the driver hands out a fresh one while the gpu reads the old
+        m_buffer->bind();
+        m_buffer->write(nullptr, m_vertexCapacity * m_vertexSize, HardwareBuffer::StreamDraw);
+        HardwareBuffer::unbind(HardwareBuffer::VertexBuffer);
+    }
+#endif
+    m_cursor = 0;
+}
+
+void StreamBuffer::enterSegment(int segment)
+{
+#ifndef OPENGL_ES
+    // the segment being left is fenced, the one entered waits until the gpu released it
+    GLsync& left = m_fences[m_segment];
+    if(left)
+        glDeleteSync(left);
+    left = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    GLsync& entered = m_fences[segment];
+    if(entered) {
+        while(glClientWaitSync(entered, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(entered);
+        entered = nullptr;
+    }
+#endif
+    m_segment = segment;
+}
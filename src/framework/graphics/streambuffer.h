@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include "declarations.h"
+#include "hardwarebuffer.h"
+
+// vertex ring rewritten every frame, the gpu keeps reading older ranges while new ones are written
+class StreamBuffer
+{
+public:
+    enum {
+        SEGMENTS = 3 // fenced parts of a persistent ring
+    };
+
+    StreamBuffer(int vertexCapacity, int vertexSize);
+    ~StreamBuffer();
+
+    // copies the vertices after the last write, returns the index of the first one or -1 when it can't fit
+    int write(const void* vertices, int vertexCount);
+
+    void bind() { m_buffer->bind(); }
+    int getVertexCapacity() const { return m_vertexCapacity; }
+    uint64 getSerial() const { return m_buffer->getSerial(); }
+    bool isPersistent() const { return m_mapped != nullptr; }
+
+private:
+    void wrap();
+    void enterSegment(int segment);
+
+    std::unique_ptr<HardwareBuffer> m_buffer;
+    int m_vertexCapacity;
+    int m_vertexSize;
+    int m_cursor = 0;
+
+    // only used when the ring is persistently mapped
+    uint8* m_mapped = nullptr;
+    int m_segment = 0;
+#ifndef OPENGL_ES
+    std::array<GLsync, SEGMENTS> m_fences{};
+#endif
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include "graphics.h"
 #include "framebuffer.h"
 #include "image.h"
+#include "texturemanager.h"
 
 #include <framework/core/application.h>
 
@@ -50,6 +51,7 @@ Texture::Texture(const Size& size) : m_uniqueId(++LAST_ID)
     setupPixels(0, m_glSize, nullptr, 4);
     setupWrap();
     setupFilters();
+    updateStatsBytes();
 }
 
 Texture::Texture(const ImagePtr& image, bool buildMipmaps, bool compress, bool canSuperimposed, bool load) : m_uniqueId(++LAST_ID)
@@ -75,6 +77,7 @@ Texture::~Texture()
     // free texture from gl memory
     if(g_graphics.ok() && m_id != 0)
         glDeleteTextures(1, &m_id);
+    addStatsBytes(-static_cast<int64>(m_statsBytes));
 }
 
 void Texture::create()
@@ -91,6 +94,11 @@ void Texture::uploadPixels(const ImagePtr& image, bool buildMipmaps, bool compre
     if(!setupSize(image->getSize(), buildMipmaps))
         return;
 
+    // textures created empty, like asynchronous load placeholders, get their id on the first upload
+    if(m_id == 0)
+        createTexture();
+
+    stdext::timer timer;
     ImagePtr glImage = image;
     if(m_size != m_glSize) {
         glImage = ImagePtr(new Image(m_glSize, image->getBpp()));
@@ -113,6 +121,17 @@ void Texture::uploadPixels(const ImagePtr& image, bool buildMipmaps, bool compre
     setupFilters();
 
     m_opaque = !image->hasTransparentPixel();
+    updateStatsBytes();
+    g_textures.countUpload(static_cast<uint64>(image->getPixelCount()) * image->getBpp(), timer.elapsed_micros());
+}
+
+void Texture::uploadSubPixels(const Point& dest, const Size& size, uchar* pixels)
+{
+    if(m_id == 0 || size.isEmpty())
+        return;
+
+    bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, dest.x, dest.y, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 }
 
 void Texture::bind()
@@ -128,6 +147,27 @@ void Texture::copyFromScreen(const Rect& screenRect)
     glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, screenRect.x(), screenRect.y(), screenRect.width(), screenRect.height());
 }
 
+ImagePtr Texture::readPixels(int)
+{
+    if(m_id == 0 || m_compress)
+        return nullptr;
+
+    uint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_id, 0);
+
+    ImagePtr image;
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+        image = ImagePtr(new Image(m_size));
+        glReadPixels(0, 0, m_size.width(), m_size.height(), GL_RGBA, GL_UNSIGNED_BYTE, image->getPixelData());
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FrameBuffer::getBoundFbo());
+    glDeleteFramebuffers(1, &fbo);
+    return image;
+}
+
 bool Texture::buildHardwareMipmaps()
 {
     if(!g_graphics.canUseHardwareMipmaps())
@@ -138,6 +178,7 @@ bool Texture::buildHardwareMipmaps()
     if(!m_hasMipmaps) {
         m_hasMipmaps = true;
         setupFilters();
+        updateStatsBytes();
     }
 
     glGenerateMipmap(GL_TEXTURE_2D);
@@ -175,6 +216,34 @@ void Texture::setUpsideDown(bool upsideDown)
     setupTranformMatrix();
 }
 
+uint64 Texture::getMemoryUsage()
+{
+    if(m_id == 0)
+        return 0;
+
+    // rgba texels, a full mipmap chain adds about a third
+    const uint64 memory = static_cast<uint64>(m_glSize.area()) * 4;
+    return m_hasMipmaps ? memory + memory / 3 : memory;
+}
+
+void Texture::updateStatsBytes()
+{
+    const uint64 bytes = getMemoryUsage();
+    addStatsBytes(static_cast<int64>(bytes) - static_cast<int64>(m_statsBytes));
+    m_statsBytes = bytes;
+}
+
+bool Texture::fitSize(const Size& size)
+{
+    // only the used area changes, the video memory stays as it was allocated
+    if(!size.isValid() || size.width() > m_glSize.width() || size.height() > m_glSize.height())
+        return false;
+
+    m_size = size;
+    setupTranformMatrix();
+    return true;
+}
+
 void Texture::createTexture()
 {
     glGenTextures(1, &m_id);
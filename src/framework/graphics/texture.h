@@ -24,8 +24,9 @@
 #define TEXTURE_H
 
 #include "declarations.h"
+#include <framework/core/stats.h>
 
-class Texture : public stdext::shared_object
+class Texture : public stdext::shared_object, private StatsCounted<Texture>
 {
 public:
     Texture();
@@ -34,14 +35,18 @@ public:
     ~Texture() override;
 
     void uploadPixels(const ImagePtr& image, bool buildMipmaps = false, bool compress = false);
+    void uploadSubPixels(const Point& dest, const Size& size, uchar* pixels);
     void bind();
     void copyFromScreen(const Rect& screenRect);
+    // pixels read back from video memory through a framebuffer, null when the texture can't be attached to one
+    virtual ImagePtr readPixels(int layer = 0);
     virtual bool buildHardwareMipmaps();
 
     virtual void setSmooth(bool smooth);
     virtual void setRepeat(bool repeat);
     void setUpsideDown(bool upsideDown);
     void setTime(ticks_t time) { m_time = time; }
+    bool fitSize(const Size& size);
 
     uint getId() { return m_id; }
     uint getUniqueId() const { return m_uniqueId; }
@@ -53,8 +58,12 @@ public:
     const Matrix3& getTransformMatrix() { return m_transformMatrix; }
     bool isEmpty() { return m_id == 0; }
     bool hasRepeat() { return m_repeat; }
+    bool isSmooth() { return m_smooth; }
+    bool isUpsideDown() { return m_upsideDown; }
     bool hasMipmaps() { return m_hasMipmaps; }
     virtual bool isAnimatedTexture() { return false; }
+    virtual bool isArrayTexture() { return false; }
+    virtual uint64 getMemoryUsage();
     bool isOpaque() const { return m_opaque; }
     bool canSuperimposed() const { return m_canSuperimposed; }
 
@@ -67,12 +76,15 @@ protected:
     void setupFilters();
     void setupTranformMatrix();
     void setupPixels(int level, const Size& size, uchar* pixels, int channels = 4, bool compress = false);
+    // reports the change of getMemoryUsage to the Texture stats
+    void updateStatsBytes();
 
     const uint m_uniqueId;
 
     uint m_id;
     ticks_t m_time;
     Size m_size, m_glSize;
+    uint64 m_statsBytes = 0;
 
     Matrix3 m_transformMatrix;
 
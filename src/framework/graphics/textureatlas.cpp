@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "textureatlas.h"
+#include "arraytexture.h"
+#include "graphics.h"
+#include "image.h"
+#include "texture.h"
+#include "texturemanager.h"
+
+#include <framework/core/clock.h>
+
+TextureAtlas g_atlas;
+
+// transparent border around every region, keeps smooth sampling from bleeding into the neighbours
+const static int REGION_PADDING = 1;
+const static int MAX_PAGE_SIZE = 2048;
+
+void TextureAtlas::init()
+{
+    const int size = std::min<int>(MAX_PAGE_SIZE, g_graphics.getMaxTextureSize());
+    m_pageSize = Size(size, size);
+}
+
+void TextureAtlas::terminate()
+{
+    for(const AtlasRegionPtr& region : m_regions)
+        region->m_texture = nullptr;
+
+    m_regions.clear();
+    m_pages.clear();
+    m_layerTextures.fill(nullptr);
+}
+
+void TextureAtlas::poll()
+{
+    // eviction doesn't need to run every frame
+    const ticks_t now = g_clock.millis();
+    if(now - m_lastEviction < 1000)
+        return;
+    m_lastEviction = now;
+
+    for(auto it = m_regions.begin(); it != m_regions.end();) {
+        const AtlasRegionPtr& region = *it;
+        // already evicted for the memory budget
+        if(!region->isValid()) {
+            it = m_regions.erase(it);
+            continue;
+        }
+
+        // the owner released the region or did not draw it for a while
+        if(region.use_count() == 1 || (!region->m_pinned && now - region->m_lastUse > m_evictionDelay)) {
+            if(region.use_count() > 1)
+                ++m_evictedCount;
+            release(region);
+            it = m_regions.erase(it);
+        } else
+            ++it;
+    }
+}
+
+AtlasRegionPtr TextureAtlas::allocate(const ImagePtr& image, bool smooth, bool layered)
+{
+    if(!image || m_pageSize.isEmpty())
+        return nullptr;
+
+    layered = layered && canUseLayers();
+
+    const Size size = image->getSize() + Size(REGION_PADDING * 2);
+    if(size.width() > m_pageSize.width() || size.height() > m_pageSize.height())
+        return nullptr;
+
+    Rect rect;
+    int pageId = -1;
+    for(uint i = 0; i < m_pages.size(); ++i) {
+        const Page& candidate = m_pages[i];
+        if(!candidate.texture || candidate.smooth != smooth || (candidate.layer >= 0) != layered)
+            continue;
+
+        if(allocateInPage(m_pages[i], size, rect)) {
+            pageId = i;
+            break;
+        }
+    }
+
+    if(pageId == -1) {
+        pageId = createPage(smooth, layered);
+        if(!allocateInPage(m_pages[pageId], size, rect))
+            return nullptr;
+    }
+
+    const Page& page = m_pages[pageId];
+    const Point dest = rect.topLeft() + Point(REGION_PADDING);
+    uploadToPage(page, dest, image->getSize(), image->getPixelData());
+
+    // clear the border left by a previous region
+    static std::vector<uint8> border;
+    border.resize(std::max<int>(size.width(), size.height()) * 4 * REGION_PADDING, 0);
+    uploadToPage(page, rect.topLeft(), Size(size.width(), REGION_PADDING), border.data());
+    uploadToPage(page, Point(rect.left(), rect.bottom() - REGION_PADDING + 1), Size(size.width(), REGION_PADDING), border.data());
+    uploadToPage(page, rect.topLeft(), Size(REGION_PADDING, size.height()), border.data());
+    uploadToPage(page, Point(rect.right() - REGION_PADDING + 1, rect.top()), Size(REGION_PADDING, size.height()), border.data());
+
+    const auto region = std::make_shared<AtlasRegion>();
+    region->m_texture = page.texture;
+    region->m_rect = Rect(dest, image->getSize());
+    region->m_page = pageId;
+    region->m_layer = std::max<int>(page.layer, 0);
+    region->m_lastUse = g_clock.millis();
+
+    m_regions.push_back(region);
+    return region;
+}
+
+bool TextureAtlas::canUseLayers()
+{
+    return g_graphics.canUseTextureArrays() && g_painter && g_painter->canDrawTextureArrays();
+}
+
+void TextureAtlas::releaseLayers()
+{
+    // the owners rebuild the released regions as 2D pages on their next draw
+    for(const AtlasRegionPtr& region : m_regions) {
+        const int page = region->m_page;
+        if(page >= 0 && page < static_cast<int>(m_pages.size()) && m_pages[page].layer >= 0) {
+            ++m_evictedCount;
+            release(region);
+        }
+    }
+
+    for(Page& page : m_pages) {
+        if(page.layer >= 0)
+            page = Page();
+    }
+    m_layerTextures.fill(nullptr);
+}
+
+AtlasRegionPtr TextureAtlas::createStandalone(const TexturePtr& texture)
+{
+    // textures that don't fit in a page take no page, but they age and get evicted like the others
+    const auto region = std::make_shared<AtlasRegion>();
+    region->m_texture = texture;
+    region->m_rect = Rect(Point(), texture->getSize());
+    region->m_lastUse = g_clock.millis();
+
+    m_regions.push_back(region);
+    return region;
+}
+
+void TextureAtlas::collectEvictable(std::vector<AtlasRegionPtr>& regions)
+{
+    for(const AtlasRegionPtr& region : m_regions) {
+        if(region->isValid() && !region->m_pinned && region.use_count() > 1)
+            regions.push_back(region);
+    }
+}
+
+uint64 TextureAtlas::evict(const AtlasRegionPtr& region)
+{
+    if(!region->isValid())
+        return 0;
+
+    // a paged region frees its share of the page, the page itself goes once it is empty
+    const uint64 memory = region->m_page < 0 ? region->m_texture->getMemoryUsage() : static_cast<uint64>(region->m_rect.size().area()) * 4;
+
+    ++m_evictedCount;
+    release(region);
+    return memory;
+}
+
+void TextureAtlas::releaseEmptyPages()
+{
+    // an empty page is kept for the next allocations until memory is short,
+    // a layer only becomes free for another page, the array keeps its size
+    for(Page& page : m_pages) {
+        if(page.texture && page.usedArea == 0)
+            page.texture = nullptr;
+    }
+}
+
+uint64 TextureAtlas::getMemoryUsage()
+{
+    uint64 memory = 0;
+    for(const Page& page : m_pages) {
+        if(page.texture && page.layer < 0)
+            memory += page.texture->getMemoryUsage();
+    }
+
+    for(const ArrayTexturePtr& texture : m_layerTextures) {
+        if(texture)
+            memory += texture->getMemoryUsage();
+    }
+
+    for(const AtlasRegionPtr& region : m_regions) {
+        if(region->m_page < 0 && region->isValid())
+            memory += region->m_texture->getMemoryUsage();
+    }
+    return memory;
+}
+
+float TextureAtlas::getPageOccupancy(int page)
+{
+    if(page < 0 || page >= static_cast<int>(m_pages.size()))
+        return 0.f;
+
+    return m_pages[page].usedArea / static_cast<float>(m_pageSize.area());
+}
+
+int TextureAtlas::createPage(bool smooth, bool layered)
+{
+    Page page;
+    page.smooth = smooth;
+
+    if(layered) {
+        ArrayTexturePtr& texture = m_layerTextures[smooth];
+        const int layers = texture ? texture->getLayers() : 0;
+
+        std::vector<bool> usedLayers(layers, false);
+        for(const Page& other : m_pages) {
+            if(other.texture && other.layer >= 0 && other.smooth == smooth)
+                usedLayers[other.layer] = true;
+        }
+
+        page.layer = std::find(usedLayers.begin(), usedLayers.end(), false) - usedLayers.begin();
+        if(!texture) {
+            texture = ArrayTexturePtr(new ArrayTexture(m_pageSize, 1));
+            texture->setSmooth(smooth);
+        } else if(page.layer >= layers)
+            texture->resizeLayers(layers * 2);
+
+        page.texture = texture;
+    } else {
+        const ImagePtr image(new Image(m_pageSize));
+        image->setTransparentPixel(true);
+
+        page.texture = TexturePtr(new Texture(image));
+        page.texture->setSmooth(smooth);
+    }
+
+    // regions keep their page index, so released pages are refilled instead of removed
+    for(uint i = 0; i < m_pages.size(); ++i) {
+        if(!m_pages[i].texture) {
+            m_pages[i] = std::move(page);
+            return i;
+        }
+    }
+
+    m_pages.push_back(std::move(page));
+    return m_pages.size() - 1;
+}
+
+void TextureAtlas::uploadToPage(const Page& page, const Point& dest, const Size& size, uchar* pixels)
+{
+    stdext::timer timer;
+    if(page.layer >= 0)
+        static_cast<ArrayTexture*>(page.texture.get())->uploadLayerPixels(page.layer, dest, size, pixels);
+    else
+        page.texture->uploadSubPixels(dest, size, pixels);
+    g_textures.countUpload(static_cast<uint64>(size.area()) * 4, timer.elapsed_micros());
+}
+
+bool TextureAtlas::allocateInPage(Page& page, const Size& size, Rect& rect)
+{
+    Shelf* bestShelf = nullptr;
+    int bestSpan = -1;
+
+    // look for the shelf that wastes less height, empty shelves take any smaller height
+    for(auto& shelf : page.shelves) {
+        if(shelf.height < size.height())
+            continue;
+
+        const bool empty = shelf.freeSpans.size() == 1 && shelf.freeSpans[0].second == m_pageSize.width();
+        if(!empty && shelf.height > size.height() + size.height() / 2)
+            continue;
+
+        if(bestShelf && bestShelf->height <= shelf.height)
+            continue;
+
+        for(uint i = 0; i < shelf.freeSpans.size(); ++i) {
+            if(shelf.freeSpans[i].second >= size.width()) {
+                bestShelf = &shelf;
+                bestSpan = i;
+                break;
+            }
+        }
+    }
+
+    if(!bestShelf) {
+        if(page.nextShelfY + size.height() > m_pageSize.height())
+            return false;
+
+        page.shelves.push_back(Shelf{ page.nextShelfY, size.height(), { std::make_pair(0, m_pageSize.width()) } });
+        page.nextShelfY += size.height();
+
+        bestShelf = &page.shelves.back();
+        bestSpan = 0;
+    }
+
+    auto& span = bestShelf->freeSpans[bestSpan];
+    rect = Rect(span.first, bestShelf->y, size);
+
+    span.first += size.width();
+    span.second -= size.width();
+    if(span.second == 0)
+        bestShelf->freeSpans.erase(bestShelf->freeSpans.begin() + bestSpan);
+
+    page.usedArea += size.area();
+    return true;
+}
+
+void TextureAtlas::freeInPage(Page& page, const Rect& rect)
+{
+    const auto it = std::find_if(page.shelves.begin(), page.shelves.end(), [&rect](const Shelf& shelf) { return shelf.y == rect.top(); });
+    if(it == page.shelves.end())
+        return;
+
+    auto& spans = it->freeSpans;
+    auto itSpan = std::lower_bound(spans.begin(), spans.end(), std::make_pair(rect.left(), 0));
+    itSpan = spans.insert(itSpan, std::make_pair(rect.left(), rect.width()));
+
+    // merge with the following and the previous spans
+    const auto itNext = itSpan + 1;
+    if(itNext != spans.end() && itSpan->first + itSpan->second == itNext->first) {
+        itSpan->second += itNext->second;
+        spans.erase(itNext);
+    }
+
+    if(itSpan != spans.begin()) {
+        const auto itPrev = itSpan - 1;
+        if(itPrev->first + itPrev->second == itSpan->first) {
+            itPrev->second += itSpan->second;
+            spans.erase(itSpan);
+        }
+    }
+
+    page.usedArea -= rect.size().area();
+
+    // give the height back when the last shelves are empty
+    while(!page.shelves.empty()) {
+        const Shelf& last = page.shelves.back();
+        if(last.freeSpans.size() != 1 || last.freeSpans[0].second != m_pageSize.width())
+            break;
+
+        page.nextShelfY = last.y;
+        page.shelves.pop_back();
+    }
+}
+
+void TextureAtlas::release(const AtlasRegionPtr& region)
+{
+    if(region->m_page < 0 || region->m_page >= static_cast<int>(m_pages.size())) {
+        region->m_texture = nullptr;
+        return;
+    }
+
+    const Rect& rect = region->m_rect;
+    freeInPage(m_pages[region->m_page], Rect(rect.topLeft() - Point(REGION_PADDING), rect.size() + Size(REGION_PADDING * 2)));
+
+    region->m_texture = nullptr;
+    region->m_page = -1;
+}
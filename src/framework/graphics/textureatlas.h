@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include "declarations.h"
+
+class AtlasRegion
+{
+public:
+    const TexturePtr& getTexture() const { return m_texture; }
+    const Rect& getRect() const { return m_rect; }
+    Point getOffset() const { return m_rect.topLeft(); }
+    int getPage() const { return m_page; }
+    // array texture layer holding the region, 0 for 2D textures
+    int getLayer() const { return m_layer; }
+    bool isValid() const { return m_texture != nullptr; }
+
+    void touch(ticks_t time) { m_lastUse = time; }
+    ticks_t getLastUse() const { return m_lastUse; }
+    // pinned regions are only released by their owner, never by the eviction delay
+    void setPinned(bool pinned) { m_pinned = pinned; }
+    bool isPinned() const { return m_pinned; }
+
+private:
+    TexturePtr m_texture;
+    Rect m_rect;
+    int m_page{ -1 };
+    int m_layer{ 0 };
+    ticks_t m_lastUse{ 0 };
+    bool m_pinned{ false };
+
+    friend class TextureAtlas;
+};
+
+ // @bindsingleton g_atlas
+class TextureAtlas
+{
+public:
+    // @dontbind
+    void init();
+    // @dontbind
+    void terminate();
+    // @dontbind
+    void poll();
+
+    // layered regions share one array texture for all pages, only use them for images drawn through the draw pool
+    AtlasRegionPtr allocate(const ImagePtr& image, bool smooth = false, bool layered = false);
+    AtlasRegionPtr createStandalone(const TexturePtr& texture);
+    bool canUseLayers();
+    bool hasLayers() { return m_layerTextures[0] || m_layerTextures[1]; }
+    // @dontbind
+    void releaseLayers();
+
+    // @dontbind
+    void collectEvictable(std::vector<AtlasRegionPtr>& regions);
+    // @dontbind
+    uint64 evict(const AtlasRegionPtr& region);
+    // @dontbind
+    void releaseEmptyPages();
+    void countRebuild() { ++m_rebuiltCount; }
+
+    void setEvictionDelay(ticks_t delay) { m_evictionDelay = delay; }
+    ticks_t getEvictionDelay() { return m_evictionDelay; }
+
+    int getPageCount() { return m_pages.size(); }
+    float getPageOccupancy(int page);
+    int getRegionCount() { return m_regions.size(); }
+    int getEvictedCount() { return m_evictedCount; }
+    int getRebuiltCount() { return m_rebuiltCount; }
+    uint64 getMemoryUsage();
+
+private:
+    struct Shelf {
+        int y, height;
+        std::vector<std::pair<int, int>> freeSpans; // x, width
+    };
+
+    struct Page {
+        TexturePtr texture;
+        std::vector<Shelf> shelves;
+        int nextShelfY{ 0 };
+        int usedArea{ 0 };
+        int layer{ -1 }; // -1 for pages with their own 2D texture
+        bool smooth{ false };
+    };
+
+    bool allocateInPage(Page& page, const Size& size, Rect& rect);
+    void freeInPage(Page& page, const Rect& rect);
+    void release(const AtlasRegionPtr& region);
+
+    int createPage(bool smooth, bool layered);
+    void uploadToPage(const Page& page, const Point& dest, const Size& size, uchar* pixels);
+
+    std::vector<Page> m_pages;
+    std::vector<AtlasRegionPtr> m_regions;
+    std::array<ArrayTexturePtr, 2> m_layerTextures; // sharp and smooth
+    Size m_pageSize;
+    ticks_t m_evictionDelay{ 60 * 1000 };
+    ticks_t m_lastEviction{ 0 };
+    int m_evictedCount{ 0 },
+        m_rebuiltCount{ 0 };
+};
+
+extern TextureAtlas g_atlas;
+
+#endif
@@ -22,10 +22,14 @@
 
 #include "texturemanager.h"
 #include "animatedtexture.h"
+#include "compressedimage.h"
+#include "compressedtexture.h"
 #include "graphics.h"
 #include "image.h"
+#include "textureatlas.h"
 
 #include <framework/core/resourcemanager.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/graphics/apngloader.h>
@@ -44,26 +48,140 @@ void TextureManager::terminate()
         m_liveReloadEvent = nullptr;
     }
     m_textures.clear();
-    m_animatedTextures.clear();
+    m_pendingTextures.clear();
+    m_evictedFiles.clear();
+    m_deferredCommits.clear();
     m_emptyTexture = nullptr;
 }
 
 void TextureManager::poll()
 {
-    // update only every 16msec, this allows upto 60 fps for animated textures
-    static ticks_t lastUpdate = 0;
-    ticks_t now = g_clock.millis();
-    if(now - lastUpdate < 16)
+    // animated textures pick their frame when drawn, see AnimatedTexture::updateAnimation
+    const ticks_t now = g_clock.millis();
+    if(now - m_lastBudgetCheck >= 1000) {
+        m_lastBudgetCheck = now;
+        enforceMemoryBudget();
+    }
+
+    // decoded files that missed the upload budget are committed in request order while it lasts
+    while(!m_deferredCommits.empty()) {
+        const auto it = m_pendingTextures.find(m_deferredCommits.front());
+        if(it != m_pendingTextures.end()) {
+            if(!canUpload(getUploadBytes(it->second.decoded), false))
+                break;
+            commitPendingTexture(m_deferredCommits.front());
+        }
+        m_deferredCommits.pop_front();
+    }
+}
+
+bool TextureManager::canUpload(uint64 bytes, bool visible)
+{
+    // the first upload of a frame always goes through, so images larger than the budget still complete
+    if(m_frameUploads == 0)
+        return true;
+
+    const uint share = visible ? 100 : BACKGROUND_UPLOAD_SHARE;
+    if(m_frameUploadBytes + bytes > m_uploadByteBudget * share / 100 || m_frameUploadTime >= m_uploadTimeBudget * share / 100) {
+        ++m_deferredUploadCount;
+        return false;
+    }
+    return true;
+}
+
+void TextureManager::countUpload(uint64 bytes, ticks_t micros)
+{
+    ++m_frameUploads;
+    m_frameUploadBytes += bytes;
+    m_frameUploadTime += micros;
+}
+
+void TextureManager::nextUploadFrame()
+{
+    m_lastFrameUploadBytes = m_frameUploadBytes;
+    m_frameUploadBytes = 0;
+    m_frameUploadTime = 0;
+    m_frameUploads = 0;
+}
+
+uint64 TextureManager::getMemoryUsage()
+{
+    uint64 memory = g_atlas.getMemoryUsage();
+    for(const auto& it : m_textures)
+        memory += it.second.texture->getMemoryUsage();
+    return memory;
+}
+
+int TextureManager::getEvictedCount()
+{
+    return m_evictedCount + g_atlas.getEvictedCount();
+}
+
+int TextureManager::getRebuiltCount()
+{
+    return m_rebuiltCount + g_atlas.getRebuiltCount();
+}
+
+void TextureManager::enforceMemoryBudget()
+{
+    const uint64 usage = getMemoryUsage();
+    if(usage <= m_memoryBudget)
         return;
-    lastUpdate = now;
 
-    for(const AnimatedTexturePtr& animatedTexture : m_animatedTextures)
-        animatedTexture->updateAnimation();
+    // file textures can only go when nothing but the cache holds them
+    struct Candidate
+    {
+        ticks_t lastUse;
+        AtlasRegionPtr region;
+        const std::string* file;
+    };
+
+    const ticks_t now = g_clock.millis();
+    std::vector<Candidate> candidates;
+
+    std::vector<AtlasRegionPtr> regions;
+    g_atlas.collectEvictable(regions);
+    for(const AtlasRegionPtr& region : regions) {
+        if(now - region->getLastUse() > EVICTION_GRACE_TIME)
+            candidates.push_back({ region->getLastUse(), region, nullptr });
+    }
+
+    for(const auto& it : m_textures) {
+        const TexturePtr& texture = it.second.texture;
+        if(texture.use_count() == 1 && texture != m_emptyTexture && now - it.second.lastUse > EVICTION_GRACE_TIME)
+            candidates.push_back({ it.second.lastUse, nullptr, &it.first });
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.lastUse < b.lastUse; });
+
+    // erasing from m_textures would leave the remaining file pointers dangling
+    std::vector<std::string> files;
+
+    const uint64 excess = usage - m_memoryBudget;
+    uint64 released = 0;
+    for(const Candidate& candidate : candidates) {
+        if(released >= excess)
+            break;
+
+        if(candidate.region) {
+            released += g_atlas.evict(candidate.region);
+        } else {
+            released += m_textures[*candidate.file].texture->getMemoryUsage();
+            files.push_back(*candidate.file);
+        }
+    }
+
+    for(const std::string& file : files) {
+        m_textures.erase(file);
+        m_evictedFiles.insert(file);
+        ++m_evictedCount;
+    }
+
+    g_atlas.releaseEmptyPages();
 }
 
 void TextureManager::clearCache()
 {
-    m_animatedTextures.clear();
     m_textures.clear();
 }
 
@@ -74,7 +192,7 @@ void TextureManager::liveReload()
     m_liveReloadEvent = g_dispatcher.cycleEvent([this] {
         for(auto& it : m_textures) {
             const std::string& path = g_resources.guessFilePath(it.first, "png");
-            const TexturePtr& tex = it.second;
+            const TexturePtr& tex = it.second.texture;
             if(tex->getTime() >= g_resources.getFileTime(path))
                 continue;
 
@@ -97,59 +215,207 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
     // check if the texture is already loaded
     auto it = m_textures.find(filePath);
     if(it != m_textures.end()) {
-        texture = it->second;
+        it->second.lastUse = g_clock.millis();
+        texture = it->second.texture;
     }
 
+    // an asynchronous request for the same file is finished here instead
+    if(!texture && m_pendingTextures.find(filePath) != m_pendingTextures.end())
+        return commitPendingTexture(filePath);
+
     // texture not found, load it
     if(!texture) {
-        try {
-            std::string filePathEx = g_resources.guessFilePath(filePath, "png");
+        texture = loadCompressedTexture(filePath);
+        if(!texture) {
+            try {
+                std::string filePathEx = g_resources.guessFilePath(filePath, "png");
 
-            // load texture file data
-            std::stringstream fin;
-            g_resources.readFileStream(filePathEx, fin);
-            texture = loadTexture(fin);
-        } catch(stdext::exception& e) {
-            g_logger.error(stdext::format("Unable to load texture '%s': %s", fileName, e.what()));
-            texture = g_textures.getEmptyTexture();
+                // load texture file data
+                std::stringstream fin;
+                g_resources.readFileStream(filePathEx, fin);
+                texture = createTexture(decodeTexture(fin));
+            } catch(stdext::exception& e) {
+                g_logger.error(stdext::format("Unable to load texture '%s': %s", fileName, e.what()));
+                texture = g_textures.getEmptyTexture();
+            }
         }
 
-        if(texture) {
-            texture->setTime(stdext::time());
-            texture->setSmooth(true);
-            m_textures[filePath] = texture;
-        }
+        cacheTexture(filePath, texture);
     }
 
     return texture;
 }
 
-TexturePtr TextureManager::loadTexture(std::stringstream& file)
+TexturePtr TextureManager::getTextureAsync(const std::string& fileName)
 {
+    const std::string filePath = g_resources.resolvePath(fileName);
+
+    auto it = m_textures.find(filePath);
+    if(it != m_textures.end()) {
+        it->second.lastUse = g_clock.millis();
+        return it->second.texture;
+    }
+
+    const auto pending = m_pendingTextures.find(filePath);
+    if(pending != m_pendingTextures.end())
+        return pending->second.placeholder;
+
+    // compressed textures upload without decoding, there is nothing to wait for
+    TexturePtr texture = loadCompressedTexture(filePath);
+    if(texture) {
+        cacheTexture(filePath, texture);
+        return texture;
+    }
+
+    const std::string pngPath = g_resources.guessFilePath(filePath, "png");
+    if(!g_resources.fileExists(pngPath)) {
+        g_logger.error(stdext::format("Unable to load texture '%s': file not found", fileName));
+        cacheTexture(filePath, g_textures.getEmptyTexture());
+        return g_textures.getEmptyTexture();
+    }
+
+    PendingTexture& request = m_pendingTextures[filePath];
+    request.placeholder = TexturePtr(new Texture);
+
+    // the file is located through the path index, reading it runs on the pool in parallel with the other decoders
+    auto task = g_asyncDispatcher.schedule([pngPath] {
+        std::stringstream fin(g_resources.readFileContents(pngPath));
+        return decodeTexture(fin);
+    }, AsyncDispatcher::PriorityNormal);
+    task.then_on_main([this, filePath](const std::shared_future<DecodedTexture>& decoded) {
+        if(m_pendingTextures.find(filePath) == m_pendingTextures.end())
+            return;
+
+        // nothing is drawn with the placeholder yet, so the upload waits behind those of the visible things
+        if(m_deferredCommits.empty() && canUpload(getUploadBytes(decoded), false))
+            commitPendingTexture(filePath);
+        else
+            m_deferredCommits.push_back(filePath);
+    });
+    request.decoded = task;
+
+    return request.placeholder;
+}
+
+void TextureManager::preloadTextures(const std::vector<std::string>& fileNames)
+{
+    for(const std::string& fileName : fileNames)
+        getTextureAsync(fileName);
+}
+
+void TextureManager::cacheTexture(const std::string& filePath, const TexturePtr& texture)
+{
+    if(!texture)
+        return;
+
+    texture->setTime(stdext::time());
+    texture->setSmooth(true);
+    m_textures[filePath] = CachedTexture{ texture, g_clock.millis() };
+
+    if(m_evictedFiles.erase(filePath))
+        ++m_rebuiltCount;
+}
+
+uint64 TextureManager::getUploadBytes(const std::shared_future<DecodedTexture>& decoded)
+{
+    try {
+        const DecodedTexture& texture = decoded.get();
+        return static_cast<uint64>(texture.size.area()) * 4 * texture.frames.size();
+    } catch(stdext::exception&) {
+        // reported by commitPendingTexture, which uploads nothing
+        return 0;
+    }
+}
+
+TexturePtr TextureManager::commitPendingTexture(const std::string& filePath)
+{
+    const auto it = m_pendingTextures.find(filePath);
+    const PendingTexture request = it->second;
+    m_pendingTextures.erase(it);
+
     TexturePtr texture;
+    try {
+        // blocks when a synchronous load asks for an image still being decoded
+        texture = createTexture(request.decoded.get(), request.placeholder);
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to load texture '%s': %s", filePath, e.what()));
+    }
+
+    if(!texture)
+        texture = request.placeholder;
+
+    cacheTexture(filePath, texture);
+    return texture;
+}
+
+TexturePtr TextureManager::loadCompressedTexture(const std::string& filePath)
+{
+    if(!g_graphics.canUseCompressedTextures())
+        return nullptr;
+
+    // converted copies sit next to the png, each platform tries its native container first
+    const std::string basePath = g_resources.isFileType(filePath, "png") ? filePath.substr(0, filePath.length() - 4) : filePath;
+#ifdef OPENGL_ES
+    static const std::array<std::string, 2> extensions = { "ktx", "dds" };
+#else
+    static const std::array<std::string, 2> extensions = { "dds", "ktx" };
+#endif
+
+    for(const std::string& extension : extensions) {
+        const std::string path = basePath + "." + extension;
+        if(!g_resources.fileExists(path))
+            continue;
+
+        try {
+            const std::string data = g_resources.readFileContents(path);
+            const CompressedImagePtr image = extension == "ktx" ? CompressedImage::loadKTX(data) : CompressedImage::loadDDS(data);
+            if(!g_graphics.canUseCompressedFormat(image->getFormat()))
+                continue;
+
+            const TexturePtr texture(new CompressedTexture(image));
+            if(!texture->isEmpty())
+                return texture;
+        } catch(stdext::exception& e) {
+            g_logger.warning(stdext::format("Unable to load compressed texture '%s': %s", path, e.what()));
+        }
+    }
+
+    // the png stays the fallback when the gpu lacks the format
+    return nullptr;
+}
+
+TextureManager::DecodedTexture TextureManager::decodeTexture(std::stringstream& file)
+{
+    DecodedTexture decoded;
 
     apng_data apng;
     if(load_apng(file, &apng) == 0) {
-        Size imageSize(apng.width, apng.height);
-        if(apng.num_frames > 1) { // animated texture
-            std::vector<ImagePtr> frames;
-            std::vector<int> framesDelay;
-            for(uint i = 0; i < apng.num_frames; ++i) {
-                uchar* frameData = apng.pdata + ((apng.first_frame + i) * imageSize.area() * apng.bpp);
-                int frameDelay = apng.frames_delay[i];
-
-                framesDelay.push_back(frameDelay);
-                frames.push_back(ImagePtr(new Image(imageSize, apng.bpp, frameData)));
-            }
-            AnimatedTexturePtr animatedTexture = new AnimatedTexture(imageSize, frames, framesDelay);
-            m_animatedTextures.push_back(animatedTexture);
-            texture = animatedTexture;
-        } else {
-            ImagePtr image = ImagePtr(new Image(imageSize, apng.bpp, apng.pdata));
-            texture = TexturePtr(new Texture(image));
+        decoded.size = Size(apng.width, apng.height);
+        for(uint i = 0; i < apng.num_frames; ++i) {
+            uchar* frameData = apng.pdata + ((apng.first_frame + i) * decoded.size.area() * apng.bpp);
+            decoded.framesDelay.push_back(apng.frames_delay[i]);
+            decoded.frames.push_back(ImagePtr(new Image(decoded.size, apng.bpp, frameData)));
         }
         free_apng(&apng);
     }
 
-    return texture;
+    return decoded;
+}
+
+TexturePtr TextureManager::createTexture(const DecodedTexture& decoded, const TexturePtr& placeholder)
+{
+    if(decoded.frames.empty())
+        return nullptr;
+
+    // a placeholder handed out by an asynchronous request shows the first frame
+    if(placeholder)
+        placeholder->uploadPixels(decoded.frames[0]);
+
+    if(decoded.frames.size() > 1) { // animated texture
+        return TexturePtr(new AnimatedTexture(decoded.size, decoded.frames, decoded.framesDelay));
+    }
+
+    if(placeholder)
+        return placeholder;
+    return TexturePtr(new Texture(decoded.frames[0]));
 }
@@ -25,9 +25,21 @@
 
 #include "texture.h"
 #include <framework/core/declarations.h>
+#include <unordered_set>
+#include <future>
 
 class TextureManager
 {
+    enum {
+        DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024,
+        // textures used more recently than this are never evicted, they are likely on screen
+        EVICTION_GRACE_TIME = 2000,
+        DEFAULT_UPLOAD_BYTES = 4 * 1024 * 1024,
+        DEFAULT_UPLOAD_TIME = 3000, // microseconds
+        // percent of the frame budget uploads not needed by this frame may take
+        BACKGROUND_UPLOAD_SHARE = 50
+    };
+
 public:
     void init();
     void terminate();
@@ -38,15 +50,77 @@ public:
 
     void preload(const std::string& fileName) { getTexture(fileName); }
     TexturePtr getTexture(const std::string& fileName);
+    // decodes on the thread pool, the returned texture stays empty until the image is uploaded from the main thread
+    TexturePtr getTextureAsync(const std::string& fileName);
+    // warms the cache with images decoded in parallel, for loading screens
+    void preloadTextures(const std::vector<std::string>& fileNames);
+    int getPendingTextureCount() { return m_pendingTextures.size(); }
     const TexturePtr& getEmptyTexture() { return m_emptyTexture; }
 
+    // the budget covers cached file textures and every thing texture in the atlas
+    void setMemoryBudget(uint64 budget) { m_memoryBudget = budget; }
+    uint64 getMemoryBudget() { return m_memoryBudget; }
+    uint64 getMemoryUsage();
+    int getEvictedCount();
+    int getRebuiltCount();
+
+    // GL uploads are spread over frames, images drawn this frame are admitted first and the
+    // uploads nothing waits for only get what is left of their share
+    void setUploadByteBudget(uint64 bytes) { m_uploadByteBudget = bytes; }
+    uint64 getUploadByteBudget() { return m_uploadByteBudget; }
+    void setUploadTimeBudget(ticks_t micros) { m_uploadTimeBudget = micros; }
+    ticks_t getUploadTimeBudget() { return m_uploadTimeBudget; }
+    bool canUpload(uint64 bytes, bool visible = true);
+    void countUpload(uint64 bytes, ticks_t micros);
+    void nextUploadFrame();
+    uint64 getLastFrameUploadBytes() { return m_lastFrameUploadBytes; }
+    int getDeferredUploadCount() { return m_deferredUploadCount; }
+
 private:
-    TexturePtr loadTexture(std::stringstream& file);
+    struct CachedTexture
+    {
+        TexturePtr texture;
+        ticks_t lastUse;
+    };
+
+    struct DecodedTexture
+    {
+        Size size;
+        std::vector<ImagePtr> frames;
+        std::vector<int> framesDelay;
+    };
+
+    struct PendingTexture
+    {
+        std::shared_future<DecodedTexture> decoded;
+        TexturePtr placeholder;
+    };
+
+    TexturePtr loadCompressedTexture(const std::string& filePath);
+    static DecodedTexture decodeTexture(std::stringstream& file);
+    TexturePtr createTexture(const DecodedTexture& decoded, const TexturePtr& placeholder = nullptr);
+    static uint64 getUploadBytes(const std::shared_future<DecodedTexture>& decoded);
+    TexturePtr commitPendingTexture(const std::string& filePath);
+    void cacheTexture(const std::string& filePath, const TexturePtr& texture);
+    void enforceMemoryBudget();
 
-    std::unordered_map<std::string, TexturePtr> m_textures;
-    std::vector<AnimatedTexturePtr> m_animatedTextures;
+    std::unordered_map<std::string, CachedTexture> m_textures;
+    std::unordered_map<std::string, PendingTexture> m_pendingTextures;
+    std::unordered_set<std::string> m_evictedFiles;
+    std::deque<std::string> m_deferredCommits;
     TexturePtr m_emptyTexture;
     ScheduledEventPtr m_liveReloadEvent;
+    uint64 m_memoryBudget{ DEFAULT_MEMORY_BUDGET };
+    ticks_t m_lastBudgetCheck{ 0 };
+    uint64 m_uploadByteBudget{ DEFAULT_UPLOAD_BYTES },
+        m_frameUploadBytes{ 0 },
+        m_lastFrameUploadBytes{ 0 };
+    ticks_t m_uploadTimeBudget{ DEFAULT_UPLOAD_TIME },
+        m_frameUploadTime{ 0 };
+    int m_frameUploads{ 0 },
+        m_deferredUploadCount{ 0 };
+    int m_evictedCount{ 0 },
+        m_rebuiltCount{ 0 };
 };
 
 extern TextureManager g_textures;
@@ -29,6 +29,7 @@
 
 #include <framework/stdext/traits.h>
 #include <tuple>
+#include <utility>
 
 /// This namespace contains some dirty metaprogamming that uses a lot of C++0x features
 /// The purpose here is to create templates that can bind any function from C++
@@ -216,6 +217,89 @@ namespace luabinder
             Tuple>(lambda);
     }
 
+    /// Runs a compile time bound call from a plain lua C function, with the same argument
+    /// adjustment and error handling as luaCppFunctionCallback
+    template<typename Ret, typename Call>
+    int call_trampoline(int numArgs, const Call& call)
+    {
+        while(g_lua.stackSize() != numArgs) {
+            if(g_lua.stackSize() < numArgs)
+                g_lua.pushNil();
+            else
+                g_lua.pop();
+        }
+
+        int numRets = 0;
+        bool failed = false;
+        g_lua.enterCppCallback();
+        try {
+            if constexpr(std::is_void<Ret>::value)
+                call();
+            else
+                numRets = g_lua.polymorphicPush(call());
+        } catch(stdext::exception& e) {
+            g_lua.pushString(stdext::format("C++ call failed: %s", g_lua.traceback(e.what())));
+            failed = true;
+        }
+        g_lua.leaveCppCallback();
+
+        // raised once the exception is gone, lua_error does not unwind the C++ frames
+        if(failed)
+            g_lua.error();
+        return numRets;
+    }
+
+    template<auto F, typename Fn = decltype(F)>
+    struct mem_fun_trampoline;
+
+    template<auto F, typename Ret, class FC, typename... Args>
+    struct mem_fun_trampoline<F, Ret(FC::*)(Args...)> {
+        static int call(lua_State*) { return callWith(std::index_sequence_for<Args...>()); }
+
+        template<size_t... I>
+        static int callWith(std::index_sequence<I...>)
+        {
+            return call_trampoline<Ret>(sizeof...(Args) + 1, []() -> typename stdext::remove_const_ref<Ret>::type {
+                const auto obj = g_lua.castValue<stdext::shared_object_ptr<FC>>(1);
+                if(!obj)
+                    throw LuaException("failed to call a member function because the passed object is nil");
+                return (obj.get()->*F)(g_lua.castValue<typename stdext::remove_const_ref<Args>::type>(I + 2)...);
+            });
+        }
+    };
+
+    template<auto F, typename Ret, class FC, typename... Args>
+    struct mem_fun_trampoline<F, Ret(FC::*)(Args...) const> {
+        static int call(lua_State*) { return callWith(std::index_sequence_for<Args...>()); }
+
+        template<size_t... I>
+        static int callWith(std::index_sequence<I...>)
+        {
+            return call_trampoline<Ret>(sizeof...(Args) + 1, []() -> typename stdext::remove_const_ref<Ret>::type {
+                const auto obj = g_lua.castValue<stdext::shared_object_ptr<FC>>(1);
+                if(!obj)
+                    throw LuaException("failed to call a member function because the passed object is nil");
+                return (obj.get()->*F)(g_lua.castValue<typename stdext::remove_const_ref<Args>::type>(I + 2)...);
+            });
+        }
+    };
+
+    template<auto F, auto Instance, typename Fn = decltype(F)>
+    struct singleton_mem_fun_trampoline;
+
+    template<auto F, auto Instance, typename Ret, class FC, typename... Args>
+    struct singleton_mem_fun_trampoline<F, Instance, Ret(FC::*)(Args...)> {
+        static int call(lua_State*) { return callWith(std::index_sequence_for<Args...>()); }
+
+        template<size_t... I>
+        static int callWith(std::index_sequence<I...>)
+        {
+            return call_trampoline<Ret>(sizeof...(Args), []() -> typename stdext::remove_const_ref<Ret>::type {
+                return (static_cast<FC*>(Instance)->*F)(g_lua.castValue<typename stdext::remove_const_ref<Args>::type>(I + 1)...);
+            });
+        }
+    };
+
     /// Bind customized member functions
     template<typename C>
     LuaCppFunction bind_mem_fun(int (C::* f)(LuaInterface*))
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "luaeventbatch.h"
+
+LuaEventBatch g_eventBatch;
+
+int LuaEventBatch::registerChannel(const std::string& name)
+{
+    for(size_t i = 0; i < m_channels.size(); ++i) {
+        if(m_channels[i].name == name)
+            return i;
+    }
+
+    Channel channel;
+    channel.name = name;
+    m_channels.push_back(std::move(channel));
+    return m_channels.size() - 1;
+}
+
+void LuaEventBatch::subscribe(const std::string& name)
+{
+    m_channels[registerChannel(name)].subscribers++;
+}
+
+void LuaEventBatch::unsubscribe(const std::string& name)
+{
+    Channel& channel = m_channels[registerChannel(name)];
+    if(channel.subscribers == 0)
+        return;
+
+    // nobody will read what is still buffered
+    if(--channel.subscribers == 0 && channel.buffer)
+        channel.buffer->clear();
+}
+
+void LuaEventBatch::flush()
+{
+    for(size_t i = 0; i < m_channels.size(); ++i) {
+        // the channel list may grow while lua handles the events, don't hold references into it
+        EventBuffer* buffer = m_channels[i].buffer.get();
+        if(buffer && !buffer->empty()) {
+            const std::string name = m_channels[i].name;
+            buffer->flush(name);
+        }
+    }
+}
+
+void LuaEventBatch::clear()
+{
+    for(Channel& channel : m_channels) {
+        if(channel.buffer)
+            channel.buffer->clear();
+    }
+}
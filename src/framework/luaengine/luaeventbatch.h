@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LUAEVENTBATCH_H
+#define LUAEVENTBATCH_H
+
+#include "luainterface.h"
+
+// opt-in channel that hands lua one array of events per name and frame instead of one call per event,
+// subscribers receive g_eventBatch.<name>(events) where each entry holds the arguments of one event
+class LuaEventBatch
+{
+public:
+    /// Returns the id used to push events of this name, registering it on first use
+    int registerChannel(const std::string& name);
+
+    void subscribe(const std::string& name);
+    void unsubscribe(const std::string& name);
+    bool isSubscribed(int channel) { return m_channels[channel].subscribers > 0; }
+
+    template<typename... T>
+    void push(int channel, const T&... args);
+
+    /// Delivers everything buffered since the last flush, called once per frame
+    void flush();
+    void clear();
+
+private:
+    class EventBuffer
+    {
+    public:
+        virtual ~EventBuffer() = default;
+        virtual bool empty() = 0;
+        virtual void flush(const std::string& name) = 0;
+        virtual void clear() = 0;
+    };
+
+    template<typename... T>
+    class TypedEventBuffer : public EventBuffer
+    {
+    public:
+        bool empty() override { return m_events.empty(); }
+        void flush(const std::string& name) override;
+        void clear() override { m_events.clear(); }
+
+        std::vector<std::tuple<T...>> m_events;
+    };
+
+    struct Channel {
+        std::string name;
+        int subscribers = 0;
+        std::unique_ptr<EventBuffer> buffer;
+    };
+
+    std::vector<Channel> m_channels;
+};
+
+extern LuaEventBatch g_eventBatch;
+
+template<typename... T>
+void LuaEventBatch::TypedEventBuffer<T...>::flush(const std::string& name)
+{
+    // handlers may raise new events of the same kind, those go to the next frame
+    std::vector<std::tuple<T...>> events;
+    events.swap(m_events);
+    g_lua.callGlobalField("g_eventBatch", name, events);
+}
+
+template<typename... T>
+void LuaEventBatch::push(int channel, const T&... args)
+{
+    Channel& c = m_channels[channel];
+    if(c.subscribers <= 0)
+        return;
+
+    // every push of a channel must use the same argument types
+    if(!c.buffer)
+        c.buffer.reset(new TypedEventBuffer<T...>);
+    assert(dynamic_cast<TypedEventBuffer<T...>*>(c.buffer.get()));
+    static_cast<TypedEventBuffer<T...>*>(c.buffer.get())->m_events.emplace_back(args...);
+}
+
+#endif
@@ -24,6 +24,8 @@
 #include "luaobject.h"
 
 #include <framework/core/resourcemanager.h>
+#include <framework/core/filestream.h>
+#include <framework/core/frameprofiler.h>
 #if __has_include("luajit/lua.hpp")
 #include <luajit/lua.hpp>
 #else
@@ -34,6 +36,35 @@
 
 LuaInterface g_lua;
 
+static const char* BYTECODE_CACHE_DIR = "/luacache";
+static const uint32 BYTECODE_CACHE_MAGIC = 0x434C544F; // OTLC
+
+// chunks of a different interpreter or pointer size can't be loaded
+static std::string getBytecodeVersion()
+{
+#if defined(LUAJIT_VERSION)
+    return stdext::format("%s %d", LUAJIT_VERSION, (int)sizeof(void*) * 8);
+#elif defined(LUA_RELEASE)
+    return stdext::format("%s %d", LUA_RELEASE, (int)sizeof(void*) * 8);
+#else
+    return stdext::format("%s %d", LUA_VERSION, (int)sizeof(void*) * 8);
+#endif
+}
+
+static std::string getBytecodeCachePath(const std::string& filePath)
+{
+    // collisions are harmless since the entry also stores the full path
+    const uint64 hash = stdext::fnv1a64((const uint8*)filePath.data(), filePath.size());
+    return stdext::format("%s/%016llx.luac", BYTECODE_CACHE_DIR, (unsigned long long)hash);
+}
+
+// states created with lua_newstate have no panic function, luaL_newstate installs an equivalent one
+static int luaPanic(lua_State* L)
+{
+    g_logger.fatal(stdext::format("unprotected error in lua: %s", lua_tostring(L, -1)));
+    return 0;
+}
+
 LuaInterface::LuaInterface()
 {
     L = nullptr;
@@ -41,6 +72,26 @@ LuaInterface::LuaInterface()
     m_weakTableRef = 0;
     m_totalObjRefs = 0;
     m_totalFuncRefs = 0;
+    m_hasFieldMethods = false;
+    m_gcPacing = false;
+    m_gcStepSize = 16;
+    m_gcMicros = 0;
+    m_gcCycles = 0;
+    m_gcTotalMicros = 0;
+    m_gcHeapAfterCycle = 0;
+    m_bytecodeCache = true;
+    m_bytecodeCacheHits = 0;
+    m_bytecodeCacheMisses = 0;
+    m_compactValueTypes = false;
+    m_lazyObjectLists = false;
+    m_profiling = false;
+    m_profilerInterval = 1000;
+    m_profilerLastSample = 0;
+    m_profiledMicros = 0;
+    m_moduleBudgets.resize(1);
+    m_currentBudget = 0;
+    m_budgetSince = 0;
+    m_budgetSecondStart = 0;
 }
 
 LuaInterface::~LuaInterface()
@@ -124,6 +175,10 @@ void LuaInterface::registerClass(const std::string& className, const std::string
     setField("methods", klass_mt);
     pushValue(klass_fieldmethods);
     setField("fieldmethods", klass_mt);
+    pushValue(klass);
+    rawSeti(METATABLE_METHODS, klass_mt);
+    pushValue(klass_fieldmethods);
+    rawSeti(METATABLE_FIELDMETHODS, klass_mt);
 
     // redirect methods and fieldmethods to the base class ones
     if(!className.empty() && className != "LuaObject") {
@@ -169,12 +224,23 @@ void LuaInterface::registerClassMemberFunction(const std::string& className,
     pop();
 }
 
+void LuaInterface::registerClassMemberCFunction(const std::string& className,
+                                                const std::string& functionName,
+                                                LuaCFunction function)
+{
+    getGlobal(className);
+    pushCFunction(function);
+    setField(functionName);
+    pop();
+}
+
 void LuaInterface::registerClassMemberField(const std::string& className,
                                             const std::string& field,
                                             const LuaCppFunction& getFunction,
                                             const LuaCppFunction& setFunction)
 {
     getGlobal(className + "_fieldmethods");
+    m_hasFieldMethods = true;
 
     if(getFunction) {
         pushCppFunction(getFunction);
@@ -199,38 +265,52 @@ int LuaInterface::luaObjectGetEvent(LuaInterface* lua)
 {
     // stack: obj, key
     LuaObjectPtr obj = lua->toObject(-2);
-    std::string key = lua->toString(-1);
     assert(obj);
 
-    lua->remove(-1); // removes key
+    // fields are stored by name, so numeric keys are looked up by their string form
+    if(lua->isNumber()) {
+        const std::string key = lua->toString();
+        lua->pop();
+        lua->pushString(key);
+    }
 
-    // if a get method for this key exists, calls it
-    lua->getMetatable(); // pushes obj metatable
-    lua->getField("fieldmethods"); // push obj fieldmethods
-    lua->remove(-2); // removes obj metatable
-    lua->getField("get_" + key); // pushes get method
-    lua->remove(-2); // remove obj fieldmethods
-    if(!lua->isNil()) { // is the get method not nil?
-        lua->insert(-2); // moves obj to the top
-        lua->signalCall(1, 1); // calls get method, arguments: obj
-        return 1;
+    // until some class binds a field getter the fieldmethods tables are all empty
+    if(lua->m_hasFieldMethods) {
+        lua->getMetatable(-2); // pushes obj metatable
+        lua->rawGeti(METATABLE_FIELDMETHODS); // pushes obj fieldmethods
+        lua->remove(-2); // removes obj metatable
+        lua->getField("get_" + lua->toString(-2)); // pushes get method
+        lua->remove(-2); // remove obj fieldmethods
+        if(!lua->isNil()) { // is the get method not nil?
+            lua->remove(-2); // removes key
+            lua->insert(-2); // moves obj to the top
+            lua->signalCall(1, 1); // calls get method, arguments: obj
+            return 1;
+        }
+        lua->pop(); // pops the nil get method
     }
-    lua->pop(); // pops the nil get method
 
-    // if the field for this key exists, returns it
-    obj->luaGetField(key);
-    if(!lua->isNil()) {
-        lua->remove(-2); // removes the obj
-        // field value is on the stack
-        return 1;
+    // objects that never had a field set have no fields table to look into
+    if(obj->hasLuaFieldsTable()) {
+        obj->luaGetFieldsTable(); // pushes obj fields table
+        lua->pushValue(-2); // pushes key
+        lua->rawGet(-2); // pushes field value, pops key
+        lua->remove(-2); // removes obj fields table
+        if(!lua->isNil()) {
+            lua->remove(-2); // removes key
+            lua->remove(-2); // removes obj
+            // field value is on the stack
+            return 1;
+        }
+        lua->pop(); // pops the nil field
     }
-    lua->pop(); // pops the nil field
 
-    // pushes the method assigned by this key
-    lua->getMetatable();  // pushes obj metatable
-    lua->getField("methods"); // push obj methods
+    // pushes the method assigned by this key, the key string lua already interned is used as is
+    lua->getMetatable(-2); // pushes obj metatable
+    lua->rawGeti(METATABLE_METHODS); // push obj methods
     lua->remove(-2); // removes obj metatable
-    lua->getField(key); // pushes obj method
+    lua->insert(-2); // moves obj methods below the key
+    lua->getTable(); // pushes obj method, following the base classes, pops key
     lua->remove(-2); // remove obj methods
     lua->remove(-2); // removes obj
 
@@ -249,18 +329,20 @@ int LuaInterface::luaObjectSetEvent(LuaInterface* lua)
     lua->insert(-2); // moves obj to the top
 
     // check if a set method for this field exists and call it
-    lua->getMetatable(); // pushes obj metatable
-    lua->getField("fieldmethods"); // push obj fieldmethods
-    lua->remove(-2); // removes obj metatable
-    lua->getField("set_" + key); // pushes set method
-    lua->remove(-2); // remove obj fieldmethods
-    if(!lua->isNil()) { // is the set method not nil?
-        lua->insert(-3); // moves func to -3
-        lua->insert(-2); // moves obj to -2, and value to -1
-        lua->signalCall(2, 0); // calls set method, arguments: obj, value
-        return 0;
+    if(lua->m_hasFieldMethods) {
+        lua->getMetatable(); // pushes obj metatable
+        lua->rawGeti(METATABLE_FIELDMETHODS); // push obj fieldmethods
+        lua->remove(-2); // removes obj metatable
+        lua->getField("set_" + key); // pushes set method
+        lua->remove(-2); // remove obj fieldmethods
+        if(!lua->isNil()) { // is the set method not nil?
+            lua->insert(-3); // moves func to -3
+            lua->insert(-2); // moves obj to -2, and value to -1
+            lua->signalCall(2, 0); // calls set method, arguments: obj, value
+            return 0;
+        }
+        lua->pop(); // pops the nil set method
     }
-    lua->pop(); // pops the nil set method
 
     // no set method exists, then treats as an field and set it
     lua->pop(); // pops the object
@@ -332,10 +414,20 @@ void LuaInterface::loadScript(const std::string& fileName)
         filePath = getCurrentSourcePath() + "/" + filePath;
 
     filePath = g_resources.guessFilePath(filePath, "lua");
+    std::string source = "@" + filePath;
+
+    // the cache lives in the write dir, scripts loaded before it is set are always compiled
+    ticks_t modTime = 0;
+    uint64 size = 0;
+    bool cacheable = m_bytecodeCache && !g_resources.getWriteDir().empty() && g_resources.getFileStat(filePath, modTime, size);
+    if(cacheable && loadCachedScript(filePath, source, modTime, size))
+        return;
 
     std::string buffer = g_resources.readFileContents(filePath);
-    std::string source = "@" + filePath;
     loadBuffer(buffer, source);
+
+    if(cacheable)
+        storeCachedScript(filePath, modTime, size);
 }
 
 void LuaInterface::loadFunction(const std::string& buffer, const std::string& source)
@@ -434,8 +526,26 @@ std::string LuaInterface::getCurrentSourcePath(int level)
 
 int LuaInterface::safeCall(int numArgs, int numRets)
 {
+    PROFILE_SCOPE("lua.call");
     assert(hasIndex(-numArgs - 1));
 
+    // the call is charged to the module holding the function, an exhausted module is not called at all
+    const uint16 previousBudget = m_currentBudget;
+    const uint16 budget = findModuleBudget(-numArgs - 1);
+    if(budget != 0) {
+        chargeModuleBudget();
+        ModuleBudget& moduleBudget = m_moduleBudgets[budget];
+        if(moduleBudget.cpuLimit > 0 && moduleBudget.cpuMicros >= moduleBudget.cpuLimit) {
+            ++moduleBudget.skippedCalls;
+            pop(numArgs + 1);
+            const int rets = std::max<int>(numRets, 0);
+            for(int i = 0; i < rets; ++i)
+                pushNil();
+            return rets;
+        }
+        m_currentBudget = budget;
+    }
+
     // saves the current stack size for calculating the number of results later
     int previousStackSize = stackSize();
 
@@ -449,6 +559,12 @@ int LuaInterface::safeCall(int numArgs, int numRets)
 
     remove(errorFuncIndex); // remove error func
 
+    if(budget != 0) {
+        chargeModuleBudget();
+        m_currentBudget = previousBudget;
+        checkModuleBudget(budget);
+    }
+
      // if there was an error throw an exception
     if(ret != 0)
         throw LuaException(popString());
@@ -665,8 +781,12 @@ int LuaInterface::luaCollectCppFunction(lua_State*)
 
 void LuaInterface::createLuaState()
 {
-    // creates lua state
-    L = luaL_newstate();
+    // creates lua state, luajit builds without 64 bit gc objects can't take another allocator and keep no memory budgets
+    L = lua_newstate(&LuaInterface::luaAllocator, this);
+    if(L)
+        lua_atpanic(L, &luaPanic);
+    else
+        L = luaL_newstate();
     if(!L)
         g_logger.fatal("Unable to create lua state");
 
@@ -706,6 +826,7 @@ void LuaInterface::createLuaState()
 
 void LuaInterface::closeLuaState()
 {
+    m_profiling = false;
     if(L) {
         // close lua, it also collects
         lua_close(L);
@@ -725,10 +846,482 @@ void LuaInterface::collectGarbage()
         for(int i = 0; i < 2; ++i)
             lua_gc(L, LUA_GCCOLLECT, 0);
 
+        // a full collection rearms the automatic collector
+        if(m_gcPacing)
+            lua_gc(L, LUA_GCSTOP, 0);
+        m_gcHeapAfterCycle = getHeapSize();
+
         collecting = false;
     }
 }
 
+void LuaInterface::setGcPacingEnabled(bool enabled)
+{
+    if(m_gcPacing == enabled)
+        return;
+
+    m_gcPacing = enabled;
+    if(!L)
+        return;
+
+    if(enabled) {
+        lua_gc(L, LUA_GCSTOP, 0);
+        m_gcHeapAfterCycle = getHeapSize();
+    } else
+        lua_gc(L, LUA_GCRESTART, 0);
+}
+
+int LuaInterface::stepGarbageCollector(int budgetMicros)
+{
+    m_gcMicros = 0;
+    if(!m_gcPacing || !L)
+        return 0;
+
+    PROFILE_SCOPE("lua.gc");
+
+    int budget = std::max<int>(budgetMicros, GC_MINIMUM_BUDGET_MICROS);
+
+    // garbage is produced faster than the idle time collects it
+    if(getHeapSize() > m_gcHeapAfterCycle * 2)
+        budget = std::max<int>(budget, GC_CATCHUP_BUDGET_MICROS);
+
+    const ticks_t start = stdext::micros();
+    ticks_t elapsed = 0;
+    ticks_t stepMicros = 0;
+    while(elapsed + stepMicros <= budget) {
+        const ticks_t stepStart = stdext::micros();
+        const bool finished = lua_gc(L, LUA_GCSTEP, m_gcStepSize) != 0;
+
+        // every step rearms the automatic threshold, keep it off
+        lua_gc(L, LUA_GCSTOP, 0);
+
+        const ticks_t now = stdext::micros();
+        stepMicros = now - stepStart;
+        elapsed = now - start;
+
+        // grow or shrink the step so one step stays around the target time
+        if(stepMicros < GC_TARGET_STEP_MICROS / 2)
+            m_gcStepSize = std::min<int>(m_gcStepSize * 2, GC_MAX_STEP_KB);
+        else if(stepMicros > GC_TARGET_STEP_MICROS * 2)
+            m_gcStepSize = std::max<int>(m_gcStepSize / 2, 1);
+
+        // don't start the next cycle right away, the following frames will
+        if(finished) {
+            m_gcCycles++;
+            m_gcHeapAfterCycle = getHeapSize();
+            break;
+        }
+    }
+
+    m_gcMicros = elapsed;
+    m_gcTotalMicros += elapsed;
+    return elapsed;
+}
+
+void LuaInterface::startProfiler(int intervalMicros)
+{
+    m_profilerInterval = std::max<int>(intervalMicros, 100);
+    m_profilerLastSample = stdext::micros();
+    m_profiling = true;
+    // the hook only checks the clock, the stack is walked once the interval elapsed
+    lua_sethook(L, &LuaInterface::luaProfilerHook, LUA_MASKCOUNT, 1000);
+}
+
+void LuaInterface::stopProfiler()
+{
+    if(L)
+        lua_sethook(L, nullptr, 0, 0);
+    m_profiling = false;
+}
+
+void LuaInterface::resetProfiler()
+{
+    m_profilerStacks.clear();
+    m_profilerModules.clear();
+    m_profiledMicros = 0;
+    m_profilerLastSample = stdext::micros();
+}
+
+std::map<std::string, double> LuaInterface::getProfilerModules()
+{
+    std::map<std::string, double> ret;
+    for(const auto& it : m_profilerModules)
+        ret[it.first] = m_profiledMicros > 0 ? it.second * 100.0 / m_profiledMicros : 0;
+    return ret;
+}
+
+bool LuaInterface::exportProfile(const std::string& fileName)
+{
+    std::stringstream ss;
+    for(const auto& it : m_profilerStacks)
+        ss << it.first << ' ' << it.second << '\n';
+    return g_resources.writeFileContents(fileName, ss.str());
+}
+
+int LuaInterface::registerModuleBudget(const std::string& directory)
+{
+    auto it = m_moduleBudgetIndex.find(directory);
+    if(it != m_moduleBudgetIndex.end())
+        return it->second;
+
+    const uint16 budget = m_moduleBudgets.size();
+    m_moduleBudgets.emplace_back();
+    m_moduleBudgets.back().directory = directory;
+    m_moduleBudgetIndex[directory] = budget;
+    return budget;
+}
+
+void LuaInterface::setModuleBudgetLimits(int budget, int64 memoryWarning, int64 memoryLimit, int cpuWarning, int cpuLimit)
+{
+    if(budget <= 0 || budget >= static_cast<int>(m_moduleBudgets.size()))
+        return;
+
+    ModuleBudget& moduleBudget = m_moduleBudgets[budget];
+    moduleBudget.memoryWarning = std::max<int64>(memoryWarning, 0);
+    moduleBudget.memoryLimit = std::max<int64>(memoryLimit, 0);
+    moduleBudget.cpuWarning = std::max<int>(cpuWarning, 0);
+    moduleBudget.cpuLimit = std::max<int>(cpuLimit, 0);
+}
+
+std::map<std::string, double> LuaInterface::getModuleBudgetStatistics(int budget)
+{
+    std::map<std::string, double> ret;
+    if(budget < 0 || budget >= static_cast<int>(m_moduleBudgets.size()))
+        return ret;
+
+    chargeModuleBudget();
+    const ModuleBudget& moduleBudget = m_moduleBudgets[budget];
+    ret["memory"] = moduleBudget.memory;
+    ret["allocated"] = moduleBudget.allocated;
+    ret["memoryWarning"] = moduleBudget.memoryWarning;
+    ret["memoryLimit"] = moduleBudget.memoryLimit;
+    ret["failedAllocations"] = moduleBudget.failedAllocations;
+    ret["cpuMicros"] = moduleBudget.lastCpuMicros;
+    ret["cpuWarning"] = moduleBudget.cpuWarning;
+    ret["cpuLimit"] = moduleBudget.cpuLimit;
+    ret["skippedCalls"] = moduleBudget.skippedCalls;
+    return ret;
+}
+
+uint16 LuaInterface::findModuleBudget(int index)
+{
+    if(m_moduleBudgets.size() <= 1 || !isFunction(index))
+        return 0;
+
+    lua_Debug ar;
+    pushValue(index);
+    lua_getinfo(L, ">S", &ar);
+    if(!ar.source || ar.source[0] != '@')
+        return 0;
+
+    for(const char* root : { "/modules/", "/mods/" }) {
+        const char* begin = strstr(ar.source, root);
+        if(!begin)
+            continue;
+
+        begin += strlen(root);
+        const char* end = strchr(begin, '/');
+        if(!end)
+            return 0;
+
+        const auto it = m_moduleBudgetIndex.find(std::string(begin, end));
+        return it != m_moduleBudgetIndex.end() ? it->second : 0;
+    }
+    return 0;
+}
+
+void LuaInterface::chargeModuleBudget()
+{
+    const ticks_t now = stdext::micros();
+    if(m_currentBudget != 0)
+        m_moduleBudgets[m_currentBudget].cpuMicros += now - m_budgetSince;
+    m_budgetSince = now;
+
+    if(now - m_budgetSecondStart < 1000000)
+        return;
+
+    m_budgetSecondStart = now;
+    for(ModuleBudget& moduleBudget : m_moduleBudgets) {
+        moduleBudget.lastCpuMicros = moduleBudget.cpuMicros;
+        moduleBudget.cpuMicros = 0;
+        moduleBudget.cpuWarned = false;
+        moduleBudget.cpuLimited = false;
+    }
+}
+
+void LuaInterface::checkModuleBudget(uint16 budget)
+{
+    ModuleBudget& moduleBudget = m_moduleBudgets[budget];
+    // logging may call back into lua, the messages are formatted before
+    std::vector<std::string> warnings;
+
+    if(moduleBudget.cpuLimit > 0 && moduleBudget.cpuMicros >= moduleBudget.cpuLimit && !moduleBudget.cpuLimited) {
+        moduleBudget.cpuLimited = moduleBudget.cpuWarned = true;
+        warnings.push_back(stdext::format("Module '%s' spent %d ms running lua within a second, its callbacks are skipped until the second is over",
+                                          moduleBudget.directory, moduleBudget.cpuMicros / 1000));
+    } else if(moduleBudget.cpuWarning > 0 && moduleBudget.cpuMicros >= moduleBudget.cpuWarning && !moduleBudget.cpuWarned) {
+        moduleBudget.cpuWarned = true;
+        warnings.push_back(stdext::format("Module '%s' spent %d ms running lua within a second", moduleBudget.directory, moduleBudget.cpuMicros / 1000));
+    }
+
+    if(moduleBudget.memoryWarning > 0 && moduleBudget.memory >= moduleBudget.memoryWarning) {
+        if(!moduleBudget.memoryWarned)
+            warnings.push_back(stdext::format("Module '%s' holds %d KB of lua memory", moduleBudget.directory, moduleBudget.memory / 1024));
+        moduleBudget.memoryWarned = true;
+    } else
+        moduleBudget.memoryWarned = false;
+
+    if(moduleBudget.failedAllocations != moduleBudget.reportedFailures) {
+        warnings.push_back(stdext::format("Module '%s' reached its lua memory limit of %d KB, %d allocations failed",
+                                          moduleBudget.directory, moduleBudget.memoryLimit / 1024, moduleBudget.failedAllocations - moduleBudget.reportedFailures));
+        moduleBudget.reportedFailures = moduleBudget.failedAllocations;
+    }
+
+    for(const std::string& warning : warnings)
+        g_logger.warning(warning);
+}
+
+void* LuaInterface::luaAllocator(void* ud, void* ptr, size_t, size_t nsize)
+{
+    struct alignas(std::max_align_t) BlockHeader {
+        size_t size;
+        uint16 budget;
+    };
+
+    auto* lua = static_cast<LuaInterface*>(ud);
+    BlockHeader* header = ptr ? static_cast<BlockHeader*>(ptr) - 1 : nullptr;
+    if(nsize == 0) {
+        if(header) {
+            lua->m_moduleBudgets[header->budget].memory -= header->size;
+            free(header);
+        }
+        return nullptr;
+    }
+
+    // a block keeps the budget it was allocated for when it grows, only the running module can be refused
+    const uint16 budget = header ? header->budget : lua->m_currentBudget;
+    const size_t oldSize = header ? header->size : 0;
+    ModuleBudget& moduleBudget = lua->m_moduleBudgets[budget];
+    if(nsize > oldSize && budget == lua->m_currentBudget && moduleBudget.memoryLimit > 0 &&
+       moduleBudget.memory + static_cast<int64>(nsize - oldSize) > moduleBudget.memoryLimit) {
+        ++moduleBudget.failedAllocations;
+        return nullptr;
+    }
+
+    header = static_cast<BlockHeader*>(realloc(header, sizeof(BlockHeader) + nsize));
+    if(!header)
+        return nullptr;
+
+    header->size = nsize;
+    header->budget = budget;
+    moduleBudget.memory += static_cast<int64>(nsize) - static_cast<int64>(oldSize);
+    if(nsize > oldSize)
+        moduleBudget.allocated += nsize - oldSize;
+    return header + 1;
+}
+
+void LuaInterface::luaProfilerHook(lua_State* L, lua_Debug*)
+{
+    const ticks_t now = stdext::micros();
+    const ticks_t elapsed = now - g_lua.m_profilerLastSample;
+    if(elapsed < g_lua.m_profilerInterval)
+        return;
+    g_lua.m_profilerLastSample = now;
+
+    // innermost first, the collapsed stack is written outermost first
+    enum { MAX_DEPTH = 32 };
+    std::array<std::string, MAX_DEPTH> frames;
+    std::string module;
+    int depth = 0;
+    lua_Debug ar;
+    while(depth < MAX_DEPTH && lua_getstack(L, depth, &ar)) {
+        lua_getinfo(L, "Sn", &ar);
+        const std::string source = ar.source ? ar.source : "?";
+        if(module.empty() && source[0] == '@') {
+            for(const char* root : { "/modules/", "/mods/" }) {
+                const size_t pos = source.find(root);
+                if(pos != std::string::npos) {
+                    const size_t begin = pos + strlen(root);
+                    module = source.substr(begin, source.find('/', begin) - begin);
+                    break;
+                }
+            }
+        }
+        frames[depth] = stdext::format("%s (%s:%d)", ar.name ? ar.name : "?", ar.short_src, ar.linedefined);
+        depth++;
+    }
+
+    if(module.empty())
+        module = "[unknown]";
+
+    std::string stack = g_frameProfiler.getOpenScopes();
+    if(stack.empty())
+        stack = "idle";
+    stack += ";[" + module + "]";
+    for(int i = depth - 1; i >= 0; --i) {
+        stack += ';';
+        stack += frames[i];
+    }
+
+    g_lua.m_profilerStacks[stack] += elapsed;
+    g_lua.m_profilerModules[module] += elapsed;
+    g_lua.m_profiledMicros += elapsed;
+}
+
+uint64 LuaInterface::getHeapSize()
+{
+    if(!L)
+        return 0;
+    return (uint64)lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+}
+
+int LuaInterface::prebuildBytecodeCache(const std::string& directory)
+{
+    if(!m_bytecodeCache || g_resources.getWriteDir().empty())
+        return 0;
+
+    // start over so entries of removed scripts go away too
+    if(directory == "/")
+        clearBytecodeCache();
+
+    int count = 0;
+    for(const std::string& fileName : g_resources.listDirectoryFiles(directory)) {
+        std::string fullPath = directory + "/" + fileName;
+        stdext::replace_all(fullPath, "//", "/");
+
+        if(fullPath == BYTECODE_CACHE_DIR)
+            continue;
+
+        if(g_resources.directoryExists(fullPath)) {
+            count += prebuildBytecodeCache(fullPath);
+            continue;
+        }
+
+        if(!g_resources.isFileType(fileName, "lua"))
+            continue;
+
+        try {
+            loadScript(fullPath);
+            pop();
+            count++;
+        } catch(stdext::exception& e) {
+            g_logger.warning(stdext::format("Unable to precompile script '%s': %s", fullPath, e.what()));
+        }
+    }
+    return count;
+}
+
+void LuaInterface::clearBytecodeCache()
+{
+    if(g_resources.getWriteDir().empty() || !g_resources.directoryExists(BYTECODE_CACHE_DIR))
+        return;
+
+    for(const std::string& fileName : g_resources.listDirectoryFiles(BYTECODE_CACHE_DIR))
+        g_resources.deleteFile(std::string(BYTECODE_CACHE_DIR) + "/" + fileName);
+}
+
+bool LuaInterface::loadCachedScript(const std::string& filePath, const std::string& source, ticks_t modTime, uint64 size)
+{
+    const std::string cachePath = getBytecodeCachePath(filePath);
+    if(!g_resources.fileExists(cachePath)) {
+        m_bytecodeCacheMisses++;
+        return false;
+    }
+
+    try {
+        FileStreamPtr fin(new FileStream(cachePath, g_resources.readFileContents(cachePath)));
+        if(fin->getU32() != BYTECODE_CACHE_MAGIC || fin->getU8() != BYTECODE_CACHE_FORMAT)
+            stdext::throw_exception("unknown entry format");
+
+        // any difference means the entry is stale, it gets replaced with the new compilation
+        if(fin->getString() != getBytecodeVersion() || fin->getString() != filePath ||
+           fin->get64() != (int64)modTime || fin->getU64() != size) {
+            m_bytecodeCacheMisses++;
+            return false;
+        }
+
+        const uint32 checksum = fin->getU32();
+        const uint8* bytecode = fin->cachedData() + fin->tell();
+        const uint bytecodeSize = fin->size() - fin->tell();
+        if(bytecodeSize == 0 || stdext::adler32(bytecode, bytecodeSize) != checksum)
+            stdext::throw_exception("checksum mismatch");
+
+        if(luaL_loadbuffer(L, (const char*)bytecode, bytecodeSize, source.c_str()) != 0)
+            stdext::throw_exception(popString());
+
+        m_bytecodeCacheHits++;
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.warning(stdext::format("Discarding bytecode cache entry of '%s': %s", filePath, e.what()));
+        g_resources.deleteFile(cachePath);
+        m_bytecodeCacheMisses++;
+        return false;
+    }
+}
+
+void LuaInterface::storeCachedScript(const std::string& filePath, ticks_t modTime, uint64 size)
+{
+    std::string bytecode;
+    if(lua_dump(L, &LuaInterface::luaBytecodeWriter, &bytecode) != 0 || bytecode.empty())
+        return;
+
+    try {
+        if(!g_resources.directoryExists(BYTECODE_CACHE_DIR))
+            g_resources.makeDir(BYTECODE_CACHE_DIR);
+
+        FileStreamPtr fout = g_resources.createFile(getBytecodeCachePath(filePath));
+        fout->addU32(BYTECODE_CACHE_MAGIC);
+        fout->addU8(BYTECODE_CACHE_FORMAT);
+        fout->addString(getBytecodeVersion());
+        fout->addString(filePath);
+        fout->add64(modTime);
+        fout->addU64(size);
+        fout->addU32(stdext::adler32((const uint8*)bytecode.data(), bytecode.size()));
+        fout->write(bytecode.data(), bytecode.size());
+        fout->close();
+    } catch(stdext::exception& e) {
+        // most likely a read only write dir, don't retry for every script
+        g_logger.warning(stdext::format("Unable to write bytecode cache, disabling it: %s", e.what()));
+        m_bytecodeCache = false;
+    }
+}
+
+int LuaInterface::luaBytecodeWriter(lua_State*, const void* data, size_t size, void* userdata)
+{
+    static_cast<std::string*>(userdata)->append(static_cast<const char*>(data), size);
+    return 0;
+}
+
+int LuaInterface::registerValueType(const std::vector<std::pair<std::string, LuaCFunction>>& metamethods)
+{
+    newTable();
+    for(const auto& it : metamethods) {
+        pushCFunction(it.second);
+        setField(it.first);
+    }
+    return ref();
+}
+
+void* LuaInterface::newValueUserdata(int typeId, int size)
+{
+    void* data = newUserdata(size);
+    getRef(typeId);
+    setMetatable();
+    return data;
+}
+
+void* LuaInterface::toValueUserdata(int typeId, int index)
+{
+    assert(hasIndex(index));
+    if(lua_type(L, index) != LUA_TUSERDATA || !lua_getmetatable(L, index))
+        return nullptr;
+
+    getRef(typeId);
+    const bool matches = lua_rawequal(L, -1, -2);
+    pop(2);
+    return matches ? lua_touserdata(L, index) : nullptr;
+}
+
 void LuaInterface::loadBuffer(const std::string& buffer, const std::string& source)
 {
     // loads lua buffer
@@ -740,6 +1333,9 @@ void LuaInterface::loadBuffer(const std::string& buffer, const std::string& sour
 int LuaInterface::pcall(int numArgs, int numRets, int errorFuncIndex)
 {
     assert(hasIndex(-numArgs - 1));
+    // time spent in C++ before entering lua must not be weighted into the first sample
+    if(m_profiling && m_cppCallbackDepth == 0)
+        m_profilerLastSample = stdext::micros();
     return lua_pcall(L, numArgs, numRets, errorFuncIndex);
 }
 
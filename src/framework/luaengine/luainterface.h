@@ -26,12 +26,27 @@
 #include "declarations.h"
 
 struct lua_State;
+struct lua_Debug;
 typedef int (*LuaCFunction) (lua_State* L);
 
 /// Class that manages LUA stuff
 class LuaInterface
 {
 public:
+    enum {
+        // class metatable array slots, read with rawGeti instead of hashing "methods" and "fieldmethods"
+        METATABLE_METHODS = 1,
+        METATABLE_FIELDMETHODS = 2
+    };
+
+    enum {
+        GC_MINIMUM_BUDGET_MICROS = 250, // spent every frame even without idle time, so the heap can't run away
+        GC_CATCHUP_BUDGET_MICROS = 2000, // used once the heap doubled since the last finished cycle
+        GC_TARGET_STEP_MICROS = 100,
+        GC_MAX_STEP_KB = 4096,
+        BYTECODE_CACHE_FORMAT = 1 // bump whenever the entry layout changes
+    };
+
     LuaInterface();
     ~LuaInterface();
 
@@ -61,6 +76,11 @@ public:
     void registerGlobalFunction(const std::string& functionName,
                                 const LuaCppFunction& function);
 
+    // plain lua C functions, used by the compile time bindings
+    void registerClassMemberCFunction(const std::string& className,
+                                      const std::string& functionName,
+                                      LuaCFunction function);
+
     // register shortcuts using templates
     template<class C, class B = LuaObject>
     void registerClass()
@@ -122,6 +142,17 @@ public:
     template<typename F>
     void bindGlobalFunction(const std::string& functionName, const F& function);
 
+    // compile time variants for member function pointers, each binding becomes its own lua C function
+    // reading the arguments from their stack indexes, without a std::function or a tuple in between
+    template<class C, auto F>
+    void bindClassMemberFunction(const std::string& functionName);
+    template<auto F, auto Instance>
+    void bindSingletonFunction(const std::string& className, const std::string& functionName);
+
+    bool isInCppCallback() { return m_cppCallbackDepth != 0; }
+    void enterCppCallback() { m_cppCallbackDepth++; }
+    void leaveCppCallback() { m_cppCallbackDepth--; }
+
 private:
     /// Metamethod that will retrieve fields values (that include functions) from the object when using '.' or ':'
     static int luaObjectGetEvent(LuaInterface* lua);
@@ -201,8 +232,6 @@ public:
     template<typename R, typename... T>
     R callGlobalField(const std::string& global, const std::string& field, const T&... args);
 
-    bool isInCppCallback() { return m_cppCallbackDepth != 0; }
-
 private:
     /// Load scripts requested by lua 'require'
     static int luaScriptLoader(lua_State* L);
@@ -218,6 +247,35 @@ private:
     static int luaCppFunctionCallback(lua_State* L);
     /// Collect bound cpp function pointers
     static int luaCollectCppFunction(lua_State* L);
+    /// Count hook of the sampling profiler
+    static void luaProfilerHook(lua_State* L, lua_Debug* ar);
+    /// Allocator of the lua state, each block records the module budget it was allocated for
+    static void* luaAllocator(void* ud, void* ptr, size_t osize, size_t nsize);
+    /// Collects the chunk written by lua_dump
+    static int luaBytecodeWriter(lua_State* L, const void* data, size_t size, void* userdata);
+
+    /// Pushes the cached main function of a script, returns false when there is no valid entry
+    bool loadCachedScript(const std::string& filePath, const std::string& source, ticks_t modTime, uint64 size);
+    /// Saves the function on the stack top as the cache entry of a script
+    void storeCachedScript(const std::string& filePath, ticks_t modTime, uint64 size);
+
+    struct ModuleBudget {
+        std::string directory;
+        int64 memory{ 0 }; // bytes of the live blocks allocated for the module
+        uint64 allocated{ 0 };
+        int64 memoryWarning{ 0 }, memoryLimit{ 0 };
+        ticks_t cpuMicros{ 0 }, lastCpuMicros{ 0 }; // lua time of the current and of the last whole second
+        int cpuWarning{ 0 }, cpuLimit{ 0 };
+        uint32 failedAllocations{ 0 }, reportedFailures{ 0 }, skippedCalls{ 0 };
+        bool memoryWarned{ false }, cpuWarned{ false }, cpuLimited{ false };
+    };
+
+    /// The budget of the module holding the function at index, 0 when it lives elsewhere
+    uint16 findModuleBudget(int index);
+    /// Charges the time since the last switch to the running module, a new second starts once one is over
+    void chargeModuleBudget();
+    /// Logs the thresholds crossed by a module, never called while lua code of it is running
+    void checkModuleBudget(uint16 budget);
 
 public:
     void createLuaState();
@@ -225,6 +283,67 @@ public:
 
     void collectGarbage();
 
+    /// Replaces lua's automatic collection by incremental steps driven by stepGarbageCollector
+    void setGcPacingEnabled(bool enabled);
+    bool isGcPacingEnabled() { return m_gcPacing; }
+    /// Runs incremental collection steps for about budgetMicros, returns the microseconds spent
+    int stepGarbageCollector(int budgetMicros);
+    int getGcMicros() { return m_gcMicros; }
+    uint64 getGcTotalMicros() { return m_gcTotalMicros; }
+    int getGcCycles() { return m_gcCycles; }
+    int getGcStepSize() { return m_gcStepSize; }
+    uint64 getHeapSize();
+
+    /// Keeps the compiled chunks of loaded scripts in the write dir,
+    /// entries are keyed by script path, modification time, size and lua version
+    void setBytecodeCacheEnabled(bool enabled) { m_bytecodeCache = enabled; }
+    bool isBytecodeCacheEnabled() { return m_bytecodeCache; }
+    /// Compiles every script found under directory into a fresh cache, returns the number of cached scripts
+    int prebuildBytecodeCache(const std::string& directory);
+    void clearBytecodeCache();
+    int getBytecodeCacheHits() { return m_bytecodeCacheHits; }
+    int getBytecodeCacheMisses() { return m_bytecodeCacheMisses; }
+
+    /// Pushes value types such as Point, Rect and Position as userdata sharing one metatable
+    /// instead of a new table per push, casts accept both forms regardless of this flag
+    void setCompactValueTypes(bool enabled) { m_compactValueTypes = enabled; }
+    bool isCompactValueTypesEnabled() { return m_compactValueTypes; }
+    /// Creates the metatable of a value type, returns the id used by newValueUserdata and toValueUserdata
+    int registerValueType(const std::vector<std::pair<std::string, LuaCFunction>>& metamethods);
+    /// Pushes a new userdata of size bytes with the metatable of typeId
+    void* newValueUserdata(int typeId, int size);
+    /// Returns the value at index if it is a userdata of typeId, otherwise nullptr
+    void* toValueUserdata(int typeId, int index = -1);
+
+    /// Pushes vectors and deques of objects as a list userdata holding a snapshot of the
+    /// pointers, elements are pushed only when indexed, iterate it with: for i, v in list() do
+    void setLazyObjectLists(bool enabled) { m_lazyObjectLists = enabled; }
+    bool isLazyObjectListsEnabled() { return m_lazyObjectLists; }
+
+    /// Samples the lua call stack at most every intervalMicros while lua code runs,
+    /// each sample is weighted by the microseconds elapsed since the previous one
+    void startProfiler(int intervalMicros = 1000);
+    void stopProfiler();
+    void resetProfiler();
+    bool isProfiling() { return m_profiling; }
+    uint64 getProfiledMicros() { return m_profiledMicros; }
+    /// Percent of the profiled time per module, the module is the directory under /modules or /mods
+    /// of the innermost lua function of each sample
+    std::map<std::string, double> getProfilerModules();
+    /// Writes the samples as collapsed stacks, "frame;<open frame profiler scopes>;[module];<lua stack> micros"
+    /// per line, the format read by flamegraph.pl and speedscope
+    bool exportProfile(const std::string& fileName);
+
+    /// Lua heap blocks and callback time are attributed to the module whose directory under /modules or /mods
+    /// holds the function called from C++, until it returns or calls into another module. Registering the same
+    /// directory again returns the same budget
+    int registerModuleBudget(const std::string& directory);
+    /// Memory in bytes and lua time in microseconds per second, 0 disables a threshold. Past a warning threshold
+    /// a warning is logged, past the memory limit allocations made by the module fail and past the time limit
+    /// its callbacks are skipped until the second is over
+    void setModuleBudgetLimits(int budget, int64 memoryWarning, int64 memoryLimit, int cpuWarning, int cpuLimit);
+    std::map<std::string, double> getModuleBudgetStatistics(int budget);
+
     void loadBuffer(const std::string& buffer, const std::string& source);
 
     int pcall(int numArgs = 0, int numRets = 0, int errorFuncIndex = 0);
@@ -349,6 +468,30 @@ private:
     int m_totalObjRefs;
     int m_totalFuncRefs;
     int m_globalEnv;
+    bool m_hasFieldMethods;
+    bool m_gcPacing;
+    int m_gcStepSize;
+    int m_gcMicros;
+    int m_gcCycles;
+    uint64 m_gcTotalMicros;
+    uint64 m_gcHeapAfterCycle;
+    bool m_bytecodeCache;
+    int m_bytecodeCacheHits;
+    int m_bytecodeCacheMisses;
+    bool m_compactValueTypes;
+    bool m_lazyObjectLists;
+    bool m_profiling;
+    int m_profilerInterval;
+    ticks_t m_profilerLastSample;
+    uint64 m_profiledMicros;
+    std::unordered_map<std::string, uint64> m_profilerStacks;
+    std::unordered_map<std::string, uint64> m_profilerModules;
+    // the first budget collects what runs outside any module
+    std::vector<ModuleBudget> m_moduleBudgets;
+    std::unordered_map<std::string, uint16> m_moduleBudgetIndex;
+    uint16 m_currentBudget;
+    ticks_t m_budgetSince;
+    ticks_t m_budgetSecondStart;
 };
 
 extern LuaInterface g_lua;
@@ -440,6 +583,18 @@ void LuaInterface::bindGlobalFunction(const std::string& functionName, const F&
     registerGlobalFunction(functionName, luabinder::bind_fun(function));
 }
 
+template<class C, auto F>
+void LuaInterface::bindClassMemberFunction(const std::string& functionName)
+{
+    registerClassMemberCFunction(stdext::demangle_class<C>(), functionName, &luabinder::mem_fun_trampoline<F>::call);
+}
+
+template<auto F, auto Instance>
+void LuaInterface::bindSingletonFunction(const std::string& className, const std::string& functionName)
+{
+    registerClassMemberCFunction(className, functionName, &luabinder::singleton_mem_fun_trampoline<F, Instance>::call);
+}
+
 template<class T>
 T LuaInterface::castValue(int index)
 {
@@ -59,6 +59,46 @@ void LuaObject::releaseLuaFieldsTable()
     }
 }
 
+// pushes a copy of the table on the top of the stack, nested tables are copied once when deep is set
+static void pushTableCopy(bool deep)
+{
+    g_lua.newTable(); // src copy
+    g_lua.pushNil();
+    while(g_lua.next(-3)) { // src copy key value
+        if(deep && g_lua.isTable()) {
+            pushTableCopy(false);
+            g_lua.remove(-2); // replace the value by its copy
+        }
+        g_lua.pushValue(-2);
+        g_lua.insert(-2); // src copy key key value
+        g_lua.rawSet(-4);
+    }
+}
+
+int LuaObject::saveLuaFields()
+{
+    if(m_fieldsTableRef == -1)
+        return -1;
+
+    g_lua.getRef(m_fieldsTableRef);
+    pushTableCopy(true);
+    const int savedRef = g_lua.ref(); // pop the copy
+    g_lua.pop(); // pop the fields table
+    return savedRef;
+}
+
+void LuaObject::restoreLuaFields(int savedRef)
+{
+    releaseLuaFieldsTable();
+    if(savedRef == -1)
+        return;
+
+    g_lua.getRef(savedRef);
+    pushTableCopy(true);
+    m_fieldsTableRef = g_lua.ref();
+    g_lua.pop();
+}
+
 void LuaObject::luaSetField(const std::string& key)
 {
     // create fields table on the fly
@@ -24,10 +24,11 @@
 #define LUAOBJECT_H
 
 #include "declarations.h"
+#include <framework/core/stats.h>
 
  /// LuaObject, all script-able classes have it as base
  // @bindclass
-class LuaObject : public stdext::shared_object
+class LuaObject : public stdext::shared_object, private StatsCounted<LuaObject>
 {
 public:
     LuaObject();
@@ -61,6 +62,13 @@ public:
     /// Release fields table reference
     void releaseLuaFieldsTable();
 
+    /// Stores a copy of the fields table and returns its reference, or -1 when there are no fields,
+    /// tables held by the fields such as connected slots are copied one level deep
+    int saveLuaFields();
+
+    /// Replaces the fields table by a copy of the one stored by saveLuaFields
+    void restoreLuaFields(int savedRef);
+
     /// Sets a field from this lua object, the value must be on the stack
     void luaSetField(const std::string& key);
 
@@ -73,6 +81,9 @@ public:
     /// Gets the table containing all stored fields of this lua object, the result is pushed onto the stack
     void luaGetFieldsTable();
 
+    /// Returns true once any field was stored in this lua object
+    bool hasLuaFieldsTable() { return m_fieldsTableRef != -1; }
+
     /// Returns the number of references of this object
     /// @note each userdata of this object on lua counts as a reference
     int getUseCount();
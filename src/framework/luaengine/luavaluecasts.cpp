@@ -132,6 +132,11 @@ bool luavalue_cast(int index, Color& color)
 // rect
 int push_luavalue(const Rect& rect)
 {
+    if(g_lua.isCompactValueTypesEnabled()) {
+        LuaValueType<Rect>::push(rect);
+        return 1;
+    }
+
     g_lua.createTable(0, 4);
     g_lua.pushInteger(rect.x());
     g_lua.setField("x");
@@ -146,7 +151,10 @@ int push_luavalue(const Rect& rect)
 
 bool luavalue_cast(int index, Rect& rect)
 {
-    if(g_lua.isTable(index)) {
+    if(const Rect* value = LuaValueType<Rect>::cast(index)) {
+        rect = *value;
+        return true;
+    } else if(g_lua.isTable(index)) {
         g_lua.getField("x", index);
         rect.setX(g_lua.popInteger());
         g_lua.getField("y", index);
@@ -168,6 +176,11 @@ bool luavalue_cast(int index, Rect& rect)
 // point
 int push_luavalue(const Point& point)
 {
+    if(g_lua.isCompactValueTypesEnabled()) {
+        LuaValueType<Point>::push(point);
+        return 1;
+    }
+
     g_lua.createTable(0, 2);
     g_lua.pushInteger(point.x);
     g_lua.setField("x");
@@ -178,7 +191,10 @@ int push_luavalue(const Point& point)
 
 bool luavalue_cast(int index, Point& point)
 {
-    if(g_lua.isTable(index)) {
+    if(const Point* value = LuaValueType<Point>::cast(index)) {
+        point = *value;
+        return true;
+    } else if(g_lua.isTable(index)) {
         g_lua.getField("x", index);
         point.x = g_lua.popInteger();
         g_lua.getField("y", index);
@@ -334,3 +350,186 @@ bool luavalue_cast(int index, LuaObjectPtr& obj)
     }
     return false;
 }
+
+// value types
+int LuaObjectList::typeId = 0;
+
+namespace {
+
+int luaRectIndex(lua_State*)
+{
+    const Rect* rect = LuaValueType<Rect>::cast(1);
+    const char* key = g_lua.toCString(2);
+    if(!rect || !key)
+        g_lua.pushNil();
+    else if(strcmp(key, "x") == 0)
+        g_lua.pushInteger(rect->x());
+    else if(strcmp(key, "y") == 0)
+        g_lua.pushInteger(rect->y());
+    else if(strcmp(key, "width") == 0)
+        g_lua.pushInteger(rect->width());
+    else if(strcmp(key, "height") == 0)
+        g_lua.pushInteger(rect->height());
+    else
+        g_lua.pushNil();
+    return 1;
+}
+
+int luaRectNewIndex(lua_State*)
+{
+    Rect* rect = LuaValueType<Rect>::cast(1);
+    const char* key = g_lua.toCString(2);
+    const int value = g_lua.toInteger(3);
+    if(rect && key && strcmp(key, "x") == 0)
+        rect->setX(value);
+    else if(rect && key && strcmp(key, "y") == 0)
+        rect->setY(value);
+    else if(rect && key && strcmp(key, "width") == 0)
+        rect->setWidth(value);
+    else if(rect && key && strcmp(key, "height") == 0)
+        rect->setHeight(value);
+    else {
+        g_lua.pushCString("attempt to set an unknown field of a rect");
+        g_lua.error();
+    }
+    return 0;
+}
+
+int luaPointIndex(lua_State*)
+{
+    const Point* point = LuaValueType<Point>::cast(1);
+    const char* key = g_lua.toCString(2);
+    if(!point || !key)
+        g_lua.pushNil();
+    else if(strcmp(key, "x") == 0)
+        g_lua.pushInteger(point->x);
+    else if(strcmp(key, "y") == 0)
+        g_lua.pushInteger(point->y);
+    else
+        g_lua.pushNil();
+    return 1;
+}
+
+int luaPointNewIndex(lua_State*)
+{
+    Point* point = LuaValueType<Point>::cast(1);
+    const char* key = g_lua.toCString(2);
+    const int value = g_lua.toInteger(3);
+    if(point && key && strcmp(key, "x") == 0)
+        point->x = value;
+    else if(point && key && strcmp(key, "y") == 0)
+        point->y = value;
+    else {
+        g_lua.pushCString("attempt to set an unknown field of a point");
+        g_lua.error();
+    }
+    return 0;
+}
+
+int luaPointAdd(lua_State*)
+{
+    Point a, b;
+    luavalue_cast(1, a);
+    luavalue_cast(2, b);
+    LuaValueType<Point>::push(a + b);
+    return 1;
+}
+
+int luaPointSub(lua_State*)
+{
+    Point a, b;
+    luavalue_cast(1, a);
+    luavalue_cast(2, b);
+    LuaValueType<Point>::push(a - b);
+    return 1;
+}
+
+int luaObjectListGc(lua_State*)
+{
+    if(LuaObjectList* list = luaobjectlist_cast(1))
+        list->~LuaObjectList();
+    return 0;
+}
+
+int luaObjectListLen(lua_State*)
+{
+    const LuaObjectList* list = luaobjectlist_cast(1);
+    g_lua.pushInteger(list ? list->objects.size() : 0);
+    return 1;
+}
+
+void pushObjectListElement(const LuaObjectList* list, int i)
+{
+    if(list && i >= 1 && i <= static_cast<int>(list->objects.size()) && list->objects[i - 1])
+        g_lua.pushObject(list->objects[i - 1]);
+    else
+        g_lua.pushNil();
+}
+
+int luaObjectListIndex(lua_State*)
+{
+    pushObjectListElement(luaobjectlist_cast(1), g_lua.isNumber(2) ? g_lua.toInteger(2) : 0);
+    return 1;
+}
+
+int luaObjectListNext(lua_State*)
+{
+    const LuaObjectList* list = luaobjectlist_cast(1);
+    const int i = g_lua.toInteger(2) + 1;
+    if(!list || i > static_cast<int>(list->objects.size()))
+        return 0;
+    g_lua.pushInteger(i);
+    pushObjectListElement(list, i);
+    return 2;
+}
+
+// list() and pairs(list) return the same iterator as ipairs does for tables
+int luaObjectListIterate(lua_State*)
+{
+    g_lua.pushCFunction(&luaObjectListNext);
+    g_lua.pushValue(1);
+    g_lua.pushInteger(0);
+    return 3;
+}
+
+}
+
+void push_luaobjectlist(std::vector<LuaObjectPtr> objects)
+{
+    new(g_lua.newValueUserdata(LuaObjectList::typeId, sizeof(LuaObjectList))) LuaObjectList{ std::move(objects) };
+}
+
+LuaObjectList* luaobjectlist_cast(int index)
+{
+    if(!LuaObjectList::typeId)
+        return nullptr;
+    return static_cast<LuaObjectList*>(g_lua.toValueUserdata(LuaObjectList::typeId, index));
+}
+
+void register_luavaluetypes()
+{
+    LuaValueType<Rect>::typeId = g_lua.registerValueType({
+        { "__index", &luaRectIndex },
+        { "__newindex", &luaRectNewIndex },
+        { "__eq", &LuaValueType<Rect>::luaEquals },
+        { "__tostring", &LuaValueType<Rect>::luaToString }
+    });
+
+    LuaValueType<Point>::typeId = g_lua.registerValueType({
+        { "__index", &luaPointIndex },
+        { "__newindex", &luaPointNewIndex },
+        { "__eq", &LuaValueType<Point>::luaEquals },
+        { "__add", &luaPointAdd },
+        { "__sub", &luaPointSub },
+        { "__tostring", &LuaValueType<Point>::luaToString }
+    });
+
+    LuaObjectList::typeId = g_lua.registerValueType({
+        { "__gc", &luaObjectListGc },
+        { "__len", &luaObjectListLen },
+        { "__index", &luaObjectListIndex },
+        { "__call", &luaObjectListIterate },
+        { "__pairs", &luaObjectListIterate },
+        { "__ipairs", &luaObjectListIterate }
+    });
+}
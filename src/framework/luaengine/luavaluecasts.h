@@ -28,6 +28,8 @@
 #include "declarations.h"
 #include <framework/otml/declarations.h>
 
+struct lua_State;
+
 template<typename T>
 int push_internal_luavalue(T v);
 
@@ -163,6 +165,40 @@ int push_luavalue(const std::tuple<Args...>& tuple);
 template<typename... Args>
 int push_internal_luavalue(const std::tuple<Args...>& tuple);
 
+// value types pushed as userdata, see LuaInterface::setCompactValueTypes
+template<typename T>
+struct LuaValueType {
+    static_assert(std::is_trivially_destructible<T>::value, "value type userdata has no __gc");
+
+    static void push(const T& v);
+    static T* cast(int index);
+    static int luaEquals(lua_State*);
+    static int luaToString(lua_State*);
+
+    // assigned when the metatable is registered, 0 means the type was not registered
+    static int typeId;
+};
+
+// object lists pushed as userdata, elements are only pushed when indexed,
+// see LuaInterface::setLazyObjectLists
+struct LuaObjectList {
+    std::vector<LuaObjectPtr> objects;
+    static int typeId;
+};
+
+template<typename T>
+struct is_luaobject_ptr : std::false_type {};
+template<typename T>
+struct is_luaobject_ptr<stdext::shared_object_ptr<T>> : std::is_base_of<LuaObject, T> {};
+
+void push_luaobjectlist(std::vector<LuaObjectPtr> objects);
+LuaObjectList* luaobjectlist_cast(int index);
+
+template<typename T, typename Container>
+bool luaobjectlist_cast(int index, Container& container);
+
+void register_luavaluetypes();
+
 // start definitions
 
 #include "luaexception.h"
@@ -324,6 +360,13 @@ bool luavalue_cast(int index, std::list<T>& list)
 template<typename T>
 int push_luavalue(const std::vector<T>& vec)
 {
+    if constexpr(is_luaobject_ptr<T>::value) {
+        if(g_lua.isLazyObjectListsEnabled()) {
+            push_luaobjectlist(std::vector<LuaObjectPtr>(vec.begin(), vec.end()));
+            return 1;
+        }
+    }
+
     g_lua.createTable(vec.size(), 0);
     int i = 1;
     for(const T& v : vec) {
@@ -337,6 +380,11 @@ int push_luavalue(const std::vector<T>& vec)
 template<typename T>
 bool luavalue_cast(int index, std::vector<T>& vec)
 {
+    if constexpr(is_luaobject_ptr<T>::value) {
+        if(luaobjectlist_cast<T>(index, vec))
+            return true;
+    }
+
     if(g_lua.isTable(index)) {
         g_lua.pushNil();
         while(g_lua.next(index < 0 ? index - 1 : index)) {
@@ -353,6 +401,13 @@ bool luavalue_cast(int index, std::vector<T>& vec)
 template<typename T>
 int push_luavalue(const std::deque<T>& vec)
 {
+    if constexpr(is_luaobject_ptr<T>::value) {
+        if(g_lua.isLazyObjectListsEnabled()) {
+            push_luaobjectlist(std::vector<LuaObjectPtr>(vec.begin(), vec.end()));
+            return 1;
+        }
+    }
+
     g_lua.createTable(vec.size(), 0);
     int i = 1;
     for(const T& v : vec) {
@@ -366,6 +421,11 @@ int push_luavalue(const std::deque<T>& vec)
 template<typename T>
 bool luavalue_cast(int index, std::deque<T>& vec)
 {
+    if constexpr(is_luaobject_ptr<T>::value) {
+        if(luaobjectlist_cast<T>(index, vec))
+            return true;
+    }
+
     if(g_lua.isTable(index)) {
         g_lua.pushNil();
         while(g_lua.next(index < 0 ? index - 1 : index)) {
@@ -456,4 +516,52 @@ int push_luavalue(const std::tuple<Args...>& tuple)
     return sizeof...(Args);
 }
 
+template<typename T, typename Container>
+bool luaobjectlist_cast(int index, Container& container)
+{
+    const LuaObjectList* list = luaobjectlist_cast(index);
+    if(!list)
+        return false;
+
+    for(const LuaObjectPtr& object : list->objects) {
+        if(const auto value = stdext::dynamic_pointer_cast<typename T::element_type>(object))
+            container.push_back(value);
+    }
+    return true;
+}
+
+template<typename T>
+int LuaValueType<T>::typeId = 0;
+
+template<typename T>
+void LuaValueType<T>::push(const T& v)
+{
+    new(g_lua.newValueUserdata(typeId, sizeof(T))) T(v);
+}
+
+template<typename T>
+T* LuaValueType<T>::cast(int index)
+{
+    if(!typeId)
+        return nullptr;
+    return static_cast<T*>(g_lua.toValueUserdata(typeId, index));
+}
+
+template<typename T>
+int LuaValueType<T>::luaEquals(lua_State*)
+{
+    const T* a = cast(1);
+    const T* b = cast(2);
+    g_lua.pushBoolean(a && b && *a == *b);
+    return 1;
+}
+
+template<typename T>
+int LuaValueType<T>::luaToString(lua_State*)
+{
+    const T* v = cast(1);
+    g_lua.pushString(v ? stdext::to_string(*v) : std::string());
+    return 1;
+}
+
 #endif
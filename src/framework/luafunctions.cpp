@@ -22,6 +22,7 @@
 
 #include <framework/core/application.h>
 #include <framework/luaengine/luainterface.h>
+#include <framework/luaengine/luaeventbatch.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/configmanager.h>
 #include <framework/core/config.h>
@@ -30,7 +31,15 @@
 #include <framework/core/module.h>
 #include <framework/util/crypt.h>
 #include <framework/core/resourcemanager.h>
+#include <framework/core/frameprofiler.h>
+#include <framework/core/actiontracer.h>
+#include <framework/core/stats.h>
 #include <framework/graphics/texturemanager.h>
+#include <framework/graphics/textureatlas.h>
+#include <framework/graphics/framebuffermanager.h>
+#include <framework/graphics/drawpool.h>
+#include <framework/graphics/shadercache.h>
+#include <framework/graphics/screencapture.h>
 #include <framework/stdext/net.h>
 #include <framework/platform/platform.h>
 
@@ -55,6 +64,8 @@
 #include <framework/net/server.h>
 #include <framework/net/protocol.h>
 #include <framework/net/protocolhttp.h>
+#include <framework/net/httpdownload.h>
+#include <framework/net/httpcache.h>
 #endif
 
 #ifdef FW_SQL
@@ -63,6 +74,9 @@
 
 void Application::registerLuaFunctions()
 {
+    // userdata value types
+    register_luavaluetypes();
+
     // conversion globals
     g_lua.bindGlobalFunction("torect", [](const std::string& v) { return stdext::from_string<Rect>(v); });
     g_lua.bindGlobalFunction("topoint", [](const std::string& v) { return stdext::from_string<Point>(v); });
@@ -76,6 +90,8 @@ void Application::registerLuaFunctions()
     g_lua.bindGlobalFunction("stringtoip", [](const std::string& v) { return stdext::string_to_ip(v); });
     g_lua.bindGlobalFunction("listSubnetAddresses", [](uint32 a, uint8 b) { return stdext::listSubnetAddresses(a, b); });
     g_lua.bindGlobalFunction("ucwords", [](std::string s) { return stdext::ucwords(s); });
+    g_lua.bindGlobalFunction("benchmarkFormat", &stdext::benchmark_format);
+    g_lua.bindGlobalFunction("benchmarkStorage", &stdext::benchmark_storage);
 
     // Platform
     g_lua.registerSingletonClass("g_platform");
@@ -110,6 +126,10 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_app", "getBuildArch", &Application::getBuildArch, static_cast<Application*>(&g_app));
     g_lua.bindSingletonFunction("g_app", "getOs", &Application::getOs, static_cast<Application*>(&g_app));
     g_lua.bindSingletonFunction("g_app", "getStartupOptions", &Application::getStartupOptions, static_cast<Application*>(&g_app));
+    g_lua.bindSingletonFunction("g_app", "beginStartupPhase", &Application::beginStartupPhase, static_cast<Application*>(&g_app));
+    g_lua.bindSingletonFunction("g_app", "isStartupFinished", &Application::isStartupFinished, static_cast<Application*>(&g_app));
+    g_lua.bindSingletonFunction("g_app", "getStartupPhases", &Application::getStartupPhases, static_cast<Application*>(&g_app));
+    g_lua.bindSingletonFunction("g_app", "getStartupTime", &Application::getStartupTime, static_cast<Application*>(&g_app));
     g_lua.bindSingletonFunction("g_app", "exit", &Application::exit, static_cast<Application*>(&g_app));
 
     // Crypt
@@ -122,6 +142,11 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_crypt", "rsaSetPublicKey", &Crypt::rsaSetPublicKey, &g_crypt);
     g_lua.bindSingletonFunction("g_crypt", "rsaSetPrivateKey", &Crypt::rsaSetPrivateKey, &g_crypt);
     g_lua.bindSingletonFunction("g_crypt", "rsaGetSize", &Crypt::rsaGetSize, &g_crypt);
+    g_lua.bindSingletonFunction("g_crypt", "base64Encode", &Crypt::base64Encode, &g_crypt);
+    g_lua.bindSingletonFunction("g_crypt", "base64Decode", &Crypt::base64Decode, &g_crypt);
+    g_lua.bindSingletonFunction("g_crypt", "sha256", &Crypt::sha256, &g_crypt);
+    g_lua.bindSingletonFunction("g_crypt", "benchmarkBase64", &Crypt::benchmarkBase64, &g_crypt);
+    g_lua.bindSingletonFunction("g_crypt", "benchmarkRsa", &Crypt::benchmarkRsa, &g_crypt);
 
     // Clock
     g_lua.registerSingletonClass("g_clock");
@@ -129,6 +154,69 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_clock", "millis", &Clock::millis, &g_clock);
     g_lua.bindSingletonFunction("g_clock", "seconds", &Clock::seconds, &g_clock);
 
+    // LuaInterface
+    g_lua.registerSingletonClass("g_lua");
+    g_lua.bindSingletonFunction("g_lua", "setGcPacingEnabled", &LuaInterface::setGcPacingEnabled, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "isGcPacingEnabled", &LuaInterface::isGcPacingEnabled, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getGcMicros", &LuaInterface::getGcMicros, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getGcTotalMicros", &LuaInterface::getGcTotalMicros, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getGcCycles", &LuaInterface::getGcCycles, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getGcStepSize", &LuaInterface::getGcStepSize, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getHeapSize", &LuaInterface::getHeapSize, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "setBytecodeCacheEnabled", &LuaInterface::setBytecodeCacheEnabled, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "isBytecodeCacheEnabled", &LuaInterface::isBytecodeCacheEnabled, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "prebuildBytecodeCache", &LuaInterface::prebuildBytecodeCache, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "clearBytecodeCache", &LuaInterface::clearBytecodeCache, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getBytecodeCacheHits", &LuaInterface::getBytecodeCacheHits, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getBytecodeCacheMisses", &LuaInterface::getBytecodeCacheMisses, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "setCompactValueTypes", &LuaInterface::setCompactValueTypes, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "isCompactValueTypesEnabled", &LuaInterface::isCompactValueTypesEnabled, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "setLazyObjectLists", &LuaInterface::setLazyObjectLists, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "isLazyObjectListsEnabled", &LuaInterface::isLazyObjectListsEnabled, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "startProfiler", &LuaInterface::startProfiler, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "stopProfiler", &LuaInterface::stopProfiler, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "resetProfiler", &LuaInterface::resetProfiler, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "isProfiling", &LuaInterface::isProfiling, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getProfiledMicros", &LuaInterface::getProfiledMicros, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getProfilerModules", &LuaInterface::getProfilerModules, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "exportProfile", &LuaInterface::exportProfile, &g_lua);
+
+    // LuaEventBatch
+    g_lua.registerSingletonClass("g_eventBatch");
+    g_lua.bindSingletonFunction("g_eventBatch", "subscribe", &LuaEventBatch::subscribe, &g_eventBatch);
+    g_lua.bindSingletonFunction("g_eventBatch", "unsubscribe", &LuaEventBatch::unsubscribe, &g_eventBatch);
+
+    // Stats
+    g_lua.registerSingletonClass("g_stats");
+    g_lua.bindSingletonFunction("g_stats", "getObjectCounts", &Stats::getObjectCounts, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "getObjectBytes", &Stats::getObjectBytes, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "getLuaMemory", &Stats::getLuaMemory, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "getSnapshot", &Stats::getSnapshot, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "setSnapshotInterval", &Stats::setSnapshotInterval, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "getSnapshotInterval", &Stats::getSnapshotInterval, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "isAllocationTrackerEnabled", &Stats::isAllocationTrackerEnabled, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "getFrameAllocations", &Stats::getFrameAllocations, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "setAllocationSampling", &Stats::setAllocationSampling, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "getAllocationSamples", &Stats::getAllocationSamples, &g_stats);
+    g_lua.bindSingletonFunction("g_stats", "clearAllocationSamples", &Stats::clearAllocationSamples, &g_stats);
+
+    // FrameProfiler
+    g_lua.registerSingletonClass("g_frameProfiler");
+    g_lua.bindSingletonFunction("g_frameProfiler", "setEnabled", &FrameProfiler::setEnabled, &g_frameProfiler);
+    g_lua.bindSingletonFunction("g_frameProfiler", "isEnabled", &FrameProfiler::isEnabled, &g_frameProfiler);
+    g_lua.bindSingletonFunction("g_frameProfiler", "isAvailable", &FrameProfiler::isAvailable, &g_frameProfiler);
+    g_lua.bindSingletonFunction("g_frameProfiler", "reset", &FrameProfiler::reset, &g_frameProfiler);
+    g_lua.bindSingletonFunction("g_frameProfiler", "getSummary", &FrameProfiler::getSummary, &g_frameProfiler);
+    g_lua.bindSingletonFunction("g_frameProfiler", "getFrameStats", &FrameProfiler::getFrameStats, &g_frameProfiler);
+    g_lua.bindSingletonFunction("g_frameProfiler", "exportChromeTrace", &FrameProfiler::exportChromeTrace, &g_frameProfiler);
+
+    // ActionTracer
+    g_lua.registerSingletonClass("g_actionTracer");
+    g_lua.bindSingletonFunction("g_actionTracer", "setEnabled", &ActionTracer::setEnabled, &g_actionTracer);
+    g_lua.bindSingletonFunction("g_actionTracer", "isEnabled", &ActionTracer::isEnabled, &g_actionTracer);
+    g_lua.bindSingletonFunction("g_actionTracer", "reset", &ActionTracer::reset, &g_actionTracer);
+    g_lua.bindSingletonFunction("g_actionTracer", "getSummary", &ActionTracer::getSummary, &g_actionTracer);
+
     // ConfigManager
     g_lua.registerSingletonClass("g_configs");
     g_lua.bindSingletonFunction("g_configs", "getSettings", &ConfigManager::getSettings, &g_configs);
@@ -137,6 +225,8 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_configs", "load", &ConfigManager::load, &g_configs);
     g_lua.bindSingletonFunction("g_configs", "unload", &ConfigManager::unload, &g_configs);
     g_lua.bindSingletonFunction("g_configs", "create", &ConfigManager::create, &g_configs);
+    g_lua.bindSingletonFunction("g_configs", "setWriteBehindDelay", &ConfigManager::setWriteBehindDelay, &g_configs);
+    g_lua.bindSingletonFunction("g_configs", "getWriteBehindDelay", &ConfigManager::getWriteBehindDelay, &g_configs);
 
     // Logger
     g_lua.registerSingletonClass("g_logger");
@@ -158,14 +248,22 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_modules", "ensureModuleLoaded", &ModuleManager::ensureModuleLoaded, &g_modules);
     g_lua.bindSingletonFunction("g_modules", "unloadModules", &ModuleManager::unloadModules, &g_modules);
     g_lua.bindSingletonFunction("g_modules", "reloadModules", &ModuleManager::reloadModules, &g_modules);
+    g_lua.bindSingletonFunction("g_modules", "reloadChangedModules", &ModuleManager::reloadChangedModules, &g_modules);
+    g_lua.bindSingletonFunction("g_modules", "setAutoReloadInterval", &ModuleManager::setAutoReloadInterval, &g_modules);
     g_lua.bindSingletonFunction("g_modules", "getModule", &ModuleManager::getModule, &g_modules);
     g_lua.bindSingletonFunction("g_modules", "getModules", &ModuleManager::getModules, &g_modules);
+    g_lua.bindSingletonFunction("g_modules", "getModuleBudgets", &ModuleManager::getModuleBudgets, &g_modules);
 
     // EventDispatcher
     g_lua.registerSingletonClass("g_dispatcher");
     g_lua.bindSingletonFunction("g_dispatcher", "addEvent", &EventDispatcher::addEvent, &g_dispatcher);
     g_lua.bindSingletonFunction("g_dispatcher", "scheduleEvent", &EventDispatcher::scheduleEvent, &g_dispatcher);
     g_lua.bindSingletonFunction("g_dispatcher", "cycleEvent", &EventDispatcher::cycleEvent, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "addDeferrableEvent", &EventDispatcher::addDeferrableEvent, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "setPollBudget", &EventDispatcher::setPollBudget, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getPollBudget", &EventDispatcher::getPollBudget, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getEventMetrics", &EventDispatcher::getEventMetrics, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "resetEventMetrics", &EventDispatcher::resetEventMetrics, &g_dispatcher);
 
     // ResourceManager
     g_lua.registerSingletonClass("g_resources");
@@ -176,6 +274,7 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_resources", "removeSearchPath", &ResourceManager::removeSearchPath, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "fileExists", &ResourceManager::fileExists, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "directoryExists", &ResourceManager::directoryExists, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "invalidatePathIndex", &ResourceManager::invalidatePathIndex, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "getRealDir", &ResourceManager::getRealDir, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "getWorkDir", &ResourceManager::getWorkDir, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "getUserDir", &ResourceManager::getUserDir, &g_resources);
@@ -185,6 +284,7 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_resources", "listDirectoryFiles", &ResourceManager::listDirectoryFiles, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "getDirectoryFiles", &ResourceManager::getDirectoryFiles, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "readFileContents", &ResourceManager::readFileContents, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "readFileContentsAsync", &ResourceManager::readFileContentsAsync, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "writeFileContents", &ResourceManager::writeFileContents, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "guessFilePath", &ResourceManager::guessFilePath, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "isFileType", &ResourceManager::isFileType, &g_resources);
@@ -196,6 +296,8 @@ void Application::registerLuaFunctions()
     // Config
     g_lua.registerClass<Config>();
     g_lua.bindClassMemberFunction<Config>("save", &Config::save);
+    g_lua.bindClassMemberFunction<Config>("flush", &Config::flush);
+    g_lua.bindClassMemberFunction<Config>("isBinary", &Config::isBinary);
     g_lua.bindClassMemberFunction<Config>("setValue", &Config::setValue);
     g_lua.bindClassMemberFunction<Config>("setList", &Config::setList);
     g_lua.bindClassMemberFunction<Config>("getValue", &Config::getValue);
@@ -225,6 +327,16 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Module>("getSandbox", &Module::getSandbox);
     g_lua.bindClassMemberFunction<Module>("isAutoLoad", &Module::isAutoLoad);
     g_lua.bindClassMemberFunction<Module>("getAutoLoadPriority", &Module::getAutoLoadPriority);
+    g_lua.bindClassMemberFunction<Module>("isLazy", &Module::isLazy);
+    g_lua.bindClassMemberFunction<Module>("getLoadOnOpcodes", &Module::getLoadOnOpcodes);
+    g_lua.bindClassMemberFunction<Module>("getLoadOnExtendedOpcodes", &Module::getLoadOnExtendedOpcodes);
+    g_lua.bindClassMemberFunction<Module>("getLoadOnHotkeys", &Module::getLoadOnHotkeys);
+    g_lua.bindClassMemberFunction<Module>("getLoadMemory", &Module::getLoadMemory);
+    g_lua.bindClassMemberFunction<Module>("getMemoryUsage", &Module::getMemoryUsage);
+    g_lua.bindClassMemberFunction<Module>("getCpuUsage", &Module::getCpuUsage);
+    g_lua.bindClassMemberFunction<Module>("getBudgetStatistics", &Module::getBudgetStatistics);
+    g_lua.bindClassMemberFunction<Module>("getDirectory", &Module::getDirectory);
+    g_lua.bindClassMemberFunction<Module>("hasChangedFiles", &Module::hasChangedFiles);
 
     // Event
     g_lua.registerClass<Event>();
@@ -248,6 +360,13 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_app", "isOnInputEvent", &GraphicalApplication::isOnInputEvent, &g_app);
     g_lua.bindSingletonFunction("g_app", "getBackgroundPaneFps", &GraphicalApplication::getBackgroundPaneFps, &g_app);
     g_lua.bindSingletonFunction("g_app", "getBackgroundPaneMaxFps", &GraphicalApplication::getBackgroundPaneMaxFps, &g_app);
+    g_lua.bindSingletonFunction("g_app", "setFramePacingMode", &GraphicalApplication::setFramePacingMode, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getFramePacingMode", &GraphicalApplication::getFramePacingMode, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getFrameTimeVariance", &GraphicalApplication::getFrameTimeVariance, &g_app);
+    g_lua.bindSingletonFunction("g_app", "setIdleModeEnabled", &GraphicalApplication::setIdleModeEnabled, &g_app);
+    g_lua.bindSingletonFunction("g_app", "isIdleModeEnabled", &GraphicalApplication::isIdleModeEnabled, &g_app);
+    g_lua.bindSingletonFunction("g_app", "setIdleFrameDelay", &GraphicalApplication::setIdleFrameDelay, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getIdleFrameDelay", &GraphicalApplication::getIdleFrameDelay, &g_app);
 
     // PlatformWindow
     g_lua.registerSingletonClass("g_window");
@@ -288,6 +407,11 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_window", "isFullscreen", &PlatformWindow::isFullscreen, &g_window);
     g_lua.bindSingletonFunction("g_window", "isMaximized", &PlatformWindow::isMaximized, &g_window);
     g_lua.bindSingletonFunction("g_window", "hasFocus", &PlatformWindow::hasFocus, &g_window);
+    g_lua.bindSingletonFunction("g_window", "setMouseMoveCoalescing", &PlatformWindow::setMouseMoveCoalescing, &g_window);
+    g_lua.bindSingletonFunction("g_window", "isMouseMoveCoalescing", &PlatformWindow::isMouseMoveCoalescing, &g_window);
+    g_lua.bindSingletonFunction("g_window", "getMouseMoveHistory", &PlatformWindow::getMouseMoveHistory, &g_window);
+    g_lua.bindSingletonFunction("g_window", "getRawMouseMoveCount", &PlatformWindow::getRawMouseMoveCount, &g_window);
+    g_lua.bindSingletonFunction("g_window", "getCoalescedMouseMoveCount", &PlatformWindow::getCoalescedMouseMoveCount, &g_window);
 
     // Input
     g_lua.registerSingletonClass("g_mouse");
@@ -311,12 +435,67 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_graphics", "getVendor", &Graphics::getVendor, &g_graphics);
     g_lua.bindSingletonFunction("g_graphics", "getRenderer", &Graphics::getRenderer, &g_graphics);
     g_lua.bindSingletonFunction("g_graphics", "getVersion", &Graphics::getVersion, &g_graphics);
+    g_lua.bindSingletonFunction("g_graphics", "canUseProgramBinaries", &Graphics::canUseProgramBinaries, &g_graphics);
+
+    // ShaderCache
+    g_lua.registerSingletonClass("g_shaderCache");
+    g_lua.bindSingletonFunction("g_shaderCache", "setEnabled", &ShaderCache::setEnabled, &g_shaderCache);
+    g_lua.bindSingletonFunction("g_shaderCache", "isEnabled", &ShaderCache::isEnabled, &g_shaderCache);
+    g_lua.bindSingletonFunction("g_shaderCache", "clear", &ShaderCache::clear, &g_shaderCache);
+    g_lua.bindSingletonFunction("g_shaderCache", "getHits", &ShaderCache::getHits, &g_shaderCache);
+    g_lua.bindSingletonFunction("g_shaderCache", "getMisses", &ShaderCache::getMisses, &g_shaderCache);
+
+    // ScreenCapture
+    g_lua.registerSingletonClass("g_screenCapture");
+    g_lua.bindSingletonFunction("g_screenCapture", "capture", &ScreenCapture::capture, &g_screenCapture);
+    g_lua.bindSingletonFunction("g_screenCapture", "captureRect", &ScreenCapture::captureRect, &g_screenCapture);
+    g_lua.bindSingletonFunction("g_screenCapture", "getPendingCount", &ScreenCapture::getPendingCount, &g_screenCapture);
 
     // Textures
     g_lua.registerSingletonClass("g_textures");
     g_lua.bindSingletonFunction("g_textures", "preload", &TextureManager::preload, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "preloadTextures", &TextureManager::preloadTextures, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getPendingTextureCount", &TextureManager::getPendingTextureCount, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "clearCache", &TextureManager::clearCache, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "liveReload", &TextureManager::liveReload, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setMemoryBudget", &TextureManager::setMemoryBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getMemoryBudget", &TextureManager::getMemoryBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getMemoryUsage", &TextureManager::getMemoryUsage, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getEvictedCount", &TextureManager::getEvictedCount, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getRebuiltCount", &TextureManager::getRebuiltCount, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setUploadByteBudget", &TextureManager::setUploadByteBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getUploadByteBudget", &TextureManager::getUploadByteBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setUploadTimeBudget", &TextureManager::setUploadTimeBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getUploadTimeBudget", &TextureManager::getUploadTimeBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getLastFrameUploadBytes", &TextureManager::getLastFrameUploadBytes, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getDeferredUploadCount", &TextureManager::getDeferredUploadCount, &g_textures);
+
+    // FrameBufferManager
+    g_lua.registerSingletonClass("g_framebuffers");
+    g_lua.bindSingletonFunction("g_framebuffers", "getMemoryUsage", &FrameBufferManager::getMemoryUsage, &g_framebuffers);
+    g_lua.bindSingletonFunction("g_framebuffers", "getPooledMemory", &FrameBufferManager::getPooledMemory, &g_framebuffers);
+    g_lua.bindSingletonFunction("g_framebuffers", "getPooledCount", &FrameBufferManager::getPooledCount, &g_framebuffers);
+    g_lua.bindSingletonFunction("g_framebuffers", "getAllocationCount", &FrameBufferManager::getAllocationCount, &g_framebuffers);
+
+    // DrawPool
+    g_lua.registerSingletonClass("g_drawPool");
+    g_lua.bindSingletonFunction("g_drawPool", "setGpuTimersEnabled", &DrawPool::setGpuTimersEnabled, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "isGpuTimersEnabled", &DrawPool::isGpuTimersEnabled, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "getStatistics", &DrawPool::getStatistics, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "captureFrame", &DrawPool::captureFrame, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "isCapturing", &DrawPool::isCapturing, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "replayCapture", &DrawPool::replayCapture, &g_drawPool);
+
+    // Texture atlas
+    g_lua.registerSingletonClass("g_atlas");
+    g_lua.bindSingletonFunction("g_atlas", "setEvictionDelay", &TextureAtlas::setEvictionDelay, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getEvictionDelay", &TextureAtlas::getEvictionDelay, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getPageCount", &TextureAtlas::getPageCount, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getPageOccupancy", &TextureAtlas::getPageOccupancy, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getRegionCount", &TextureAtlas::getRegionCount, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getEvictedCount", &TextureAtlas::getEvictedCount, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getRebuiltCount", &TextureAtlas::getRebuiltCount, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getMemoryUsage", &TextureAtlas::getMemoryUsage, &g_atlas);
 
     // UI
     g_lua.registerSingletonClass("g_ui");
@@ -328,6 +507,13 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_ui", "displayUI", &UIManager::displayUI, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "createWidget", &UIManager::createWidget, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "createWidgetFromOTML", &UIManager::createWidgetFromOTML, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "setWidgetRecycling", &UIManager::setWidgetRecycling, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "getWidgetPoolStatistics", &UIManager::getWidgetPoolStatistics, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "precompileStyles", &UIManager::precompileStyles, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "prefetchStyles", &UIManager::prefetchStyles, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "clearCompiledStyles", &UIManager::clearCompiledStyles, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "getLayoutStatistics", &UIManager::getLayoutStatistics, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "updatePendingLayouts", &UIManager::updatePendingLayouts, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "getRootWidget", &UIManager::getRootWidget, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "getDraggingWidget", &UIManager::getDraggingWidget, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "getPressedWidget", &UIManager::getPressedWidget, &g_ui);
@@ -336,10 +522,20 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_ui", "isMouseGrabbed", &UIManager::isMouseGrabbed, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "isKeyboardGrabbed", &UIManager::isKeyboardGrabbed, &g_ui);
 
+    // UIRenderCache
+    g_lua.registerSingletonClass("g_uiRenderCache");
+    g_lua.bindSingletonFunction("g_uiRenderCache", "setEnabled", &UIRenderCache::setEnabled, &g_uiRenderCache);
+    g_lua.bindSingletonFunction("g_uiRenderCache", "isEnabled", &UIRenderCache::isEnabled, &g_uiRenderCache);
+    g_lua.bindSingletonFunction("g_uiRenderCache", "getCellCount", &UIRenderCache::getCellCount, &g_uiRenderCache);
+    g_lua.bindSingletonFunction("g_uiRenderCache", "getUsedCellCount", &UIRenderCache::getUsedCellCount, &g_uiRenderCache);
+    g_lua.bindSingletonFunction("g_uiRenderCache", "getRenderCount", &UIRenderCache::getRenderCount, &g_uiRenderCache);
+    g_lua.bindSingletonFunction("g_uiRenderCache", "getCachedDrawCount", &UIRenderCache::getCachedDrawCount, &g_uiRenderCache);
+
     // FontManager
     g_lua.registerSingletonClass("g_fonts");
     g_lua.bindSingletonFunction("g_fonts", "clearFonts", &FontManager::clearFonts, &g_fonts);
     g_lua.bindSingletonFunction("g_fonts", "importFont", &FontManager::importFont, &g_fonts);
+    g_lua.bindSingletonFunction("g_fonts", "prefetchFonts", &FontManager::prefetchFonts, &g_fonts);
     g_lua.bindSingletonFunction("g_fonts", "fontExists", &FontManager::fontExists, &g_fonts);
     g_lua.bindSingletonFunction("g_fonts", "setDefaultFont", &FontManager::setDefaultFont, &g_fonts);
 
@@ -351,275 +547,278 @@ void Application::registerLuaFunctions()
     // UIWidget
     g_lua.registerClass<UIWidget>();
     g_lua.bindClassStaticFunction<UIWidget>("create", [] { return UIWidgetPtr(new UIWidget); });
-    g_lua.bindClassMemberFunction<UIWidget>("addChild", &UIWidget::addChild);
-    g_lua.bindClassMemberFunction<UIWidget>("insertChild", &UIWidget::insertChild);
-    g_lua.bindClassMemberFunction<UIWidget>("removeChild", &UIWidget::removeChild);
-    g_lua.bindClassMemberFunction<UIWidget>("focusChild", &UIWidget::focusChild);
-    g_lua.bindClassMemberFunction<UIWidget>("focusNextChild", &UIWidget::focusNextChild);
-    g_lua.bindClassMemberFunction<UIWidget>("focusPreviousChild", &UIWidget::focusPreviousChild);
-    g_lua.bindClassMemberFunction<UIWidget>("lowerChild", &UIWidget::lowerChild);
-    g_lua.bindClassMemberFunction<UIWidget>("raiseChild", &UIWidget::raiseChild);
-    g_lua.bindClassMemberFunction<UIWidget>("moveChildToIndex", &UIWidget::moveChildToIndex);
-    g_lua.bindClassMemberFunction<UIWidget>("lockChild", &UIWidget::lockChild);
-    g_lua.bindClassMemberFunction<UIWidget>("unlockChild", &UIWidget::unlockChild);
-    g_lua.bindClassMemberFunction<UIWidget>("mergeStyle", &UIWidget::mergeStyle);
-    g_lua.bindClassMemberFunction<UIWidget>("applyStyle", &UIWidget::applyStyle);
-    g_lua.bindClassMemberFunction<UIWidget>("addAnchor", &UIWidget::addAnchor);
-    g_lua.bindClassMemberFunction<UIWidget>("removeAnchor", &UIWidget::removeAnchor);
-    g_lua.bindClassMemberFunction<UIWidget>("fill", &UIWidget::fill);
-    g_lua.bindClassMemberFunction<UIWidget>("centerIn", &UIWidget::centerIn);
-    g_lua.bindClassMemberFunction<UIWidget>("breakAnchors", &UIWidget::breakAnchors);
-    g_lua.bindClassMemberFunction<UIWidget>("updateParentLayout", &UIWidget::updateParentLayout);
-    g_lua.bindClassMemberFunction<UIWidget>("updateLayout", &UIWidget::updateLayout);
-    g_lua.bindClassMemberFunction<UIWidget>("lock", &UIWidget::lock);
-    g_lua.bindClassMemberFunction<UIWidget>("unlock", &UIWidget::unlock);
-    g_lua.bindClassMemberFunction<UIWidget>("focus", &UIWidget::focus);
-    g_lua.bindClassMemberFunction<UIWidget>("lower", &UIWidget::lower);
-    g_lua.bindClassMemberFunction<UIWidget>("raise", &UIWidget::raise);
-    g_lua.bindClassMemberFunction<UIWidget>("grabMouse", &UIWidget::grabMouse);
-    g_lua.bindClassMemberFunction<UIWidget>("ungrabMouse", &UIWidget::ungrabMouse);
-    g_lua.bindClassMemberFunction<UIWidget>("grabKeyboard", &UIWidget::grabKeyboard);
-    g_lua.bindClassMemberFunction<UIWidget>("ungrabKeyboard", &UIWidget::ungrabKeyboard);
-    g_lua.bindClassMemberFunction<UIWidget>("bindRectToParent", &UIWidget::bindRectToParent);
-    g_lua.bindClassMemberFunction<UIWidget>("destroy", &UIWidget::destroy);
-    g_lua.bindClassMemberFunction<UIWidget>("destroyChildren", &UIWidget::destroyChildren);
-    g_lua.bindClassMemberFunction<UIWidget>("setId", &UIWidget::setId);
-    g_lua.bindClassMemberFunction<UIWidget>("setParent", &UIWidget::setParent);
-    g_lua.bindClassMemberFunction<UIWidget>("setLayout", &UIWidget::setLayout);
-    g_lua.bindClassMemberFunction<UIWidget>("setRect", &UIWidget::setRect);
-    g_lua.bindClassMemberFunction<UIWidget>("setStyle", &UIWidget::setStyle);
-    g_lua.bindClassMemberFunction<UIWidget>("setStyleFromNode", &UIWidget::setStyleFromNode);
-    g_lua.bindClassMemberFunction<UIWidget>("setEnabled", &UIWidget::setEnabled);
-    g_lua.bindClassMemberFunction<UIWidget>("setVisible", &UIWidget::setVisible);
-    g_lua.bindClassMemberFunction<UIWidget>("setOn", &UIWidget::setOn);
-    g_lua.bindClassMemberFunction<UIWidget>("setChecked", &UIWidget::setChecked);
-    g_lua.bindClassMemberFunction<UIWidget>("setFocusable", &UIWidget::setFocusable);
-    g_lua.bindClassMemberFunction<UIWidget>("setPhantom", &UIWidget::setPhantom);
-    g_lua.bindClassMemberFunction<UIWidget>("setDraggable", &UIWidget::setDraggable);
-    g_lua.bindClassMemberFunction<UIWidget>("setFixedSize", &UIWidget::setFixedSize);
-    g_lua.bindClassMemberFunction<UIWidget>("setClipping", &UIWidget::setClipping);
-    g_lua.bindClassMemberFunction<UIWidget>("setLastFocusReason", &UIWidget::setLastFocusReason);
-    g_lua.bindClassMemberFunction<UIWidget>("setAutoFocusPolicy", &UIWidget::setAutoFocusPolicy);
-    g_lua.bindClassMemberFunction<UIWidget>("setAutoRepeatDelay", &UIWidget::setAutoRepeatDelay);
-    g_lua.bindClassMemberFunction<UIWidget>("setVirtualOffset", &UIWidget::setVirtualOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("isVisible", &UIWidget::isVisible);
-    g_lua.bindClassMemberFunction<UIWidget>("isChildLocked", &UIWidget::isChildLocked);
-    g_lua.bindClassMemberFunction<UIWidget>("hasChild", &UIWidget::hasChild);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildIndex", &UIWidget::getChildIndex);
-    g_lua.bindClassMemberFunction<UIWidget>("getMarginRect", &UIWidget::getMarginRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getPaddingRect", &UIWidget::getPaddingRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildrenRect", &UIWidget::getChildrenRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getAnchoredLayout", &UIWidget::getAnchoredLayout);
-    g_lua.bindClassMemberFunction<UIWidget>("getRootParent", &UIWidget::getRootParent);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildAfter", &UIWidget::getChildAfter);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildBefore", &UIWidget::getChildBefore);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildById", &UIWidget::getChildById);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildByPos", &UIWidget::getChildByPos);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildByIndex", &UIWidget::getChildByIndex);
-    g_lua.bindClassMemberFunction<UIWidget>("recursiveGetChildById", &UIWidget::recursiveGetChildById);
-    g_lua.bindClassMemberFunction<UIWidget>("recursiveGetChildByPos", &UIWidget::recursiveGetChildByPos);
-    g_lua.bindClassMemberFunction<UIWidget>("recursiveGetChildren", &UIWidget::recursiveGetChildren);
-    g_lua.bindClassMemberFunction<UIWidget>("recursiveGetChildrenByPos", &UIWidget::recursiveGetChildrenByPos);
-    g_lua.bindClassMemberFunction<UIWidget>("recursiveGetChildrenByMarginPos", &UIWidget::recursiveGetChildrenByMarginPos);
-    g_lua.bindClassMemberFunction<UIWidget>("backwardsGetWidgetById", &UIWidget::backwardsGetWidgetById);
-    g_lua.bindClassMemberFunction<UIWidget>("resize", &UIWidget::resize);
-    g_lua.bindClassMemberFunction<UIWidget>("move", &UIWidget::move);
-    g_lua.bindClassMemberFunction<UIWidget>("rotate", &UIWidget::rotate);
-    g_lua.bindClassMemberFunction<UIWidget>("hide", &UIWidget::hide);
-    g_lua.bindClassMemberFunction<UIWidget>("show", &UIWidget::show);
-    g_lua.bindClassMemberFunction<UIWidget>("disable", &UIWidget::disable);
-    g_lua.bindClassMemberFunction<UIWidget>("enable", &UIWidget::enable);
-    g_lua.bindClassMemberFunction<UIWidget>("isActive", &UIWidget::isActive);
-    g_lua.bindClassMemberFunction<UIWidget>("isEnabled", &UIWidget::isEnabled);
-    g_lua.bindClassMemberFunction<UIWidget>("isDisabled", &UIWidget::isDisabled);
-    g_lua.bindClassMemberFunction<UIWidget>("isFocused", &UIWidget::isFocused);
-    g_lua.bindClassMemberFunction<UIWidget>("isHovered", &UIWidget::isHovered);
-    g_lua.bindClassMemberFunction<UIWidget>("isPressed", &UIWidget::isPressed);
-    g_lua.bindClassMemberFunction<UIWidget>("isFirst", &UIWidget::isFirst);
-    g_lua.bindClassMemberFunction<UIWidget>("isMiddle", &UIWidget::isMiddle);
-    g_lua.bindClassMemberFunction<UIWidget>("isLast", &UIWidget::isLast);
-    g_lua.bindClassMemberFunction<UIWidget>("isAlternate", &UIWidget::isAlternate);
-    g_lua.bindClassMemberFunction<UIWidget>("isChecked", &UIWidget::isChecked);
-    g_lua.bindClassMemberFunction<UIWidget>("isOn", &UIWidget::isOn);
-    g_lua.bindClassMemberFunction<UIWidget>("isDragging", &UIWidget::isDragging);
-    g_lua.bindClassMemberFunction<UIWidget>("isHidden", &UIWidget::isHidden);
-    g_lua.bindClassMemberFunction<UIWidget>("isExplicitlyEnabled", &UIWidget::isExplicitlyEnabled);
-    g_lua.bindClassMemberFunction<UIWidget>("isExplicitlyVisible", &UIWidget::isExplicitlyVisible);
-    g_lua.bindClassMemberFunction<UIWidget>("isFocusable", &UIWidget::isFocusable);
-    g_lua.bindClassMemberFunction<UIWidget>("isPhantom", &UIWidget::isPhantom);
-    g_lua.bindClassMemberFunction<UIWidget>("isDraggable", &UIWidget::isDraggable);
-    g_lua.bindClassMemberFunction<UIWidget>("isFixedSize", &UIWidget::isFixedSize);
-    g_lua.bindClassMemberFunction<UIWidget>("isClipping", &UIWidget::isClipping);
-    g_lua.bindClassMemberFunction<UIWidget>("isDestroyed", &UIWidget::isDestroyed);
-    g_lua.bindClassMemberFunction<UIWidget>("hasChildren", &UIWidget::hasChildren);
-    g_lua.bindClassMemberFunction<UIWidget>("containsMarginPoint", &UIWidget::containsMarginPoint);
-    g_lua.bindClassMemberFunction<UIWidget>("containsPaddingPoint", &UIWidget::containsPaddingPoint);
-    g_lua.bindClassMemberFunction<UIWidget>("containsPoint", &UIWidget::containsPoint);
-    g_lua.bindClassMemberFunction<UIWidget>("getId", &UIWidget::getId);
-    g_lua.bindClassMemberFunction<UIWidget>("getParent", &UIWidget::getParent);
-    g_lua.bindClassMemberFunction<UIWidget>("getFocusedChild", &UIWidget::getFocusedChild);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildren", &UIWidget::getChildren);
-    g_lua.bindClassMemberFunction<UIWidget>("getFirstChild", &UIWidget::getFirstChild);
-    g_lua.bindClassMemberFunction<UIWidget>("getLastChild", &UIWidget::getLastChild);
-    g_lua.bindClassMemberFunction<UIWidget>("getLayout", &UIWidget::getLayout);
-    g_lua.bindClassMemberFunction<UIWidget>("getStyle", &UIWidget::getStyle);
-    g_lua.bindClassMemberFunction<UIWidget>("getChildCount", &UIWidget::getChildCount);
-    g_lua.bindClassMemberFunction<UIWidget>("getLastFocusReason", &UIWidget::getLastFocusReason);
-    g_lua.bindClassMemberFunction<UIWidget>("getAutoFocusPolicy", &UIWidget::getAutoFocusPolicy);
-    g_lua.bindClassMemberFunction<UIWidget>("getAutoRepeatDelay", &UIWidget::getAutoRepeatDelay);
-    g_lua.bindClassMemberFunction<UIWidget>("getVirtualOffset", &UIWidget::getVirtualOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("getStyleName", &UIWidget::getStyleName);
-    g_lua.bindClassMemberFunction<UIWidget>("getLastClickPosition", &UIWidget::getLastClickPosition);
-    g_lua.bindClassMemberFunction<UIWidget>("setX", &UIWidget::setX);
-    g_lua.bindClassMemberFunction<UIWidget>("setY", &UIWidget::setY);
-    g_lua.bindClassMemberFunction<UIWidget>("setWidth", &UIWidget::setWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("setHeight", &UIWidget::setHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("setSize", &UIWidget::setSize);
-    g_lua.bindClassMemberFunction<UIWidget>("setPosition", &UIWidget::setPosition);
-    g_lua.bindClassMemberFunction<UIWidget>("setColor", &UIWidget::setColor);
-    g_lua.bindClassMemberFunction<UIWidget>("setBackgroundColor", &UIWidget::setBackgroundColor);
-    g_lua.bindClassMemberFunction<UIWidget>("setBackgroundOffsetX", &UIWidget::setBackgroundOffsetX);
-    g_lua.bindClassMemberFunction<UIWidget>("setBackgroundOffsetY", &UIWidget::setBackgroundOffsetY);
-    g_lua.bindClassMemberFunction<UIWidget>("setBackgroundOffset", &UIWidget::setBackgroundOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("setBackgroundWidth", &UIWidget::setBackgroundWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("setBackgroundHeight", &UIWidget::setBackgroundHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("setBackgroundSize", &UIWidget::setBackgroundSize);
-    g_lua.bindClassMemberFunction<UIWidget>("setBackgroundRect", &UIWidget::setBackgroundRect);
-    g_lua.bindClassMemberFunction<UIWidget>("setIcon", &UIWidget::setIcon);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconColor", &UIWidget::setIconColor);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconOffsetX", &UIWidget::setIconOffsetX);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconOffsetY", &UIWidget::setIconOffsetY);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconOffset", &UIWidget::setIconOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconWidth", &UIWidget::setIconWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconHeight", &UIWidget::setIconHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconSize", &UIWidget::setIconSize);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconRect", &UIWidget::setIconRect);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconClip", &UIWidget::setIconClip);
-    g_lua.bindClassMemberFunction<UIWidget>("setIconAlign", &UIWidget::setIconAlign);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderWidth", &UIWidget::setBorderWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderWidthTop", &UIWidget::setBorderWidthTop);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderWidthRight", &UIWidget::setBorderWidthRight);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderWidthBottom", &UIWidget::setBorderWidthBottom);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderWidthLeft", &UIWidget::setBorderWidthLeft);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderColor", &UIWidget::setBorderColor);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderColorTop", &UIWidget::setBorderColorTop);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderColorRight", &UIWidget::setBorderColorRight);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderColorBottom", &UIWidget::setBorderColorBottom);
-    g_lua.bindClassMemberFunction<UIWidget>("setBorderColorLeft", &UIWidget::setBorderColorLeft);
-    g_lua.bindClassMemberFunction<UIWidget>("setMargin", &UIWidget::setMargin);
-    g_lua.bindClassMemberFunction<UIWidget>("setMarginHorizontal", &UIWidget::setMarginHorizontal);
-    g_lua.bindClassMemberFunction<UIWidget>("setMarginVertical", &UIWidget::setMarginVertical);
-    g_lua.bindClassMemberFunction<UIWidget>("setMarginTop", &UIWidget::setMarginTop);
-    g_lua.bindClassMemberFunction<UIWidget>("setMarginRight", &UIWidget::setMarginRight);
-    g_lua.bindClassMemberFunction<UIWidget>("setMarginBottom", &UIWidget::setMarginBottom);
-    g_lua.bindClassMemberFunction<UIWidget>("setMarginLeft", &UIWidget::setMarginLeft);
-    g_lua.bindClassMemberFunction<UIWidget>("setPadding", &UIWidget::setPadding);
-    g_lua.bindClassMemberFunction<UIWidget>("setPaddingHorizontal", &UIWidget::setPaddingHorizontal);
-    g_lua.bindClassMemberFunction<UIWidget>("setPaddingVertical", &UIWidget::setPaddingVertical);
-    g_lua.bindClassMemberFunction<UIWidget>("setPaddingTop", &UIWidget::setPaddingTop);
-    g_lua.bindClassMemberFunction<UIWidget>("setPaddingRight", &UIWidget::setPaddingRight);
-    g_lua.bindClassMemberFunction<UIWidget>("setPaddingBottom", &UIWidget::setPaddingBottom);
-    g_lua.bindClassMemberFunction<UIWidget>("setPaddingLeft", &UIWidget::setPaddingLeft);
-    g_lua.bindClassMemberFunction<UIWidget>("setOpacity", &UIWidget::setOpacity);
-    g_lua.bindClassMemberFunction<UIWidget>("setRotation", &UIWidget::setRotation);
-    g_lua.bindClassMemberFunction<UIWidget>("getX", &UIWidget::getX);
-    g_lua.bindClassMemberFunction<UIWidget>("getY", &UIWidget::getY);
-    g_lua.bindClassMemberFunction<UIWidget>("getPosition", &UIWidget::getPosition);
-    g_lua.bindClassMemberFunction<UIWidget>("getWidth", &UIWidget::getWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getHeight", &UIWidget::getHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("getSize", &UIWidget::getSize);
-    g_lua.bindClassMemberFunction<UIWidget>("getRect", &UIWidget::getRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getColor", &UIWidget::getColor);
-    g_lua.bindClassMemberFunction<UIWidget>("getBackgroundColor", &UIWidget::getBackgroundColor);
-    g_lua.bindClassMemberFunction<UIWidget>("getBackgroundOffsetX", &UIWidget::getBackgroundOffsetX);
-    g_lua.bindClassMemberFunction<UIWidget>("getBackgroundOffsetY", &UIWidget::getBackgroundOffsetY);
-    g_lua.bindClassMemberFunction<UIWidget>("getBackgroundOffset", &UIWidget::getBackgroundOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("getBackgroundWidth", &UIWidget::getBackgroundWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getBackgroundHeight", &UIWidget::getBackgroundHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("getBackgroundSize", &UIWidget::getBackgroundSize);
-    g_lua.bindClassMemberFunction<UIWidget>("getBackgroundRect", &UIWidget::getBackgroundRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconColor", &UIWidget::getIconColor);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconOffsetX", &UIWidget::getIconOffsetX);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconOffsetY", &UIWidget::getIconOffsetY);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconOffset", &UIWidget::getIconOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconWidth", &UIWidget::getIconWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconHeight", &UIWidget::getIconHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconSize", &UIWidget::getIconSize);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconRect", &UIWidget::getIconRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconClip", &UIWidget::getIconClip);
-    g_lua.bindClassMemberFunction<UIWidget>("getIconAlign", &UIWidget::getIconAlign);
-    g_lua.bindClassMemberFunction<UIWidget>("getBorderTopColor", &UIWidget::getBorderTopColor);
-    g_lua.bindClassMemberFunction<UIWidget>("getBorderRightColor", &UIWidget::getBorderRightColor);
-    g_lua.bindClassMemberFunction<UIWidget>("getBorderBottomColor", &UIWidget::getBorderBottomColor);
-    g_lua.bindClassMemberFunction<UIWidget>("getBorderLeftColor", &UIWidget::getBorderLeftColor);
-    g_lua.bindClassMemberFunction<UIWidget>("getBorderTopWidth", &UIWidget::getBorderTopWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getBorderRightWidth", &UIWidget::getBorderRightWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getBorderBottomWidth", &UIWidget::getBorderBottomWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getBorderLeftWidth", &UIWidget::getBorderLeftWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getMarginTop", &UIWidget::getMarginTop);
-    g_lua.bindClassMemberFunction<UIWidget>("getMarginRight", &UIWidget::getMarginRight);
-    g_lua.bindClassMemberFunction<UIWidget>("getMarginBottom", &UIWidget::getMarginBottom);
-    g_lua.bindClassMemberFunction<UIWidget>("getMarginLeft", &UIWidget::getMarginLeft);
-    g_lua.bindClassMemberFunction<UIWidget>("getPaddingTop", &UIWidget::getPaddingTop);
-    g_lua.bindClassMemberFunction<UIWidget>("getPaddingRight", &UIWidget::getPaddingRight);
-    g_lua.bindClassMemberFunction<UIWidget>("getPaddingBottom", &UIWidget::getPaddingBottom);
-    g_lua.bindClassMemberFunction<UIWidget>("getPaddingLeft", &UIWidget::getPaddingLeft);
-    g_lua.bindClassMemberFunction<UIWidget>("getOpacity", &UIWidget::getOpacity);
-    g_lua.bindClassMemberFunction<UIWidget>("getRotation", &UIWidget::getRotation);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageSource", &UIWidget::setImageSource);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageClip", &UIWidget::setImageClip);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageOffsetX", &UIWidget::setImageOffsetX);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageOffsetY", &UIWidget::setImageOffsetY);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageOffset", &UIWidget::setImageOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageWidth", &UIWidget::setImageWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageHeight", &UIWidget::setImageHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageSize", &UIWidget::setImageSize);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageRect", &UIWidget::setImageRect);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageColor", &UIWidget::setImageColor);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageFixedRatio", &UIWidget::setImageFixedRatio);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageRepeated", &UIWidget::setImageRepeated);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageSmooth", &UIWidget::setImageSmooth);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageAutoResize", &UIWidget::setImageAutoResize);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageBorderTop", &UIWidget::setImageBorderTop);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageBorderRight", &UIWidget::setImageBorderRight);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageBorderBottom", &UIWidget::setImageBorderBottom);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageBorderLeft", &UIWidget::setImageBorderLeft);
-    g_lua.bindClassMemberFunction<UIWidget>("setImageBorder", &UIWidget::setImageBorder);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageClip", &UIWidget::getImageClip);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageOffsetX", &UIWidget::getImageOffsetX);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageOffsetY", &UIWidget::getImageOffsetY);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageOffset", &UIWidget::getImageOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageWidth", &UIWidget::getImageWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageHeight", &UIWidget::getImageHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageSize", &UIWidget::getImageSize);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageRect", &UIWidget::getImageRect);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageColor", &UIWidget::getImageColor);
-    g_lua.bindClassMemberFunction<UIWidget>("isImageFixedRatio", &UIWidget::isImageFixedRatio);
-    g_lua.bindClassMemberFunction<UIWidget>("isImageSmooth", &UIWidget::isImageSmooth);
-    g_lua.bindClassMemberFunction<UIWidget>("isImageAutoResize", &UIWidget::isImageAutoResize);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageBorderTop", &UIWidget::getImageBorderTop);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageBorderRight", &UIWidget::getImageBorderRight);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageBorderBottom", &UIWidget::getImageBorderBottom);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageBorderLeft", &UIWidget::getImageBorderLeft);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageTextureWidth", &UIWidget::getImageTextureWidth);
-    g_lua.bindClassMemberFunction<UIWidget>("getImageTextureHeight", &UIWidget::getImageTextureHeight);
-    g_lua.bindClassMemberFunction<UIWidget>("resizeToText", &UIWidget::resizeToText);
-    g_lua.bindClassMemberFunction<UIWidget>("clearText", &UIWidget::clearText);
-    g_lua.bindClassMemberFunction<UIWidget>("setText", &UIWidget::setText);
-    g_lua.bindClassMemberFunction<UIWidget>("setTextAlign", &UIWidget::setTextAlign);
-    g_lua.bindClassMemberFunction<UIWidget>("setTextOffset", &UIWidget::setTextOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("setTextWrap", &UIWidget::setTextWrap);
-    g_lua.bindClassMemberFunction<UIWidget>("setTextAutoResize", &UIWidget::setTextAutoResize);
-    g_lua.bindClassMemberFunction<UIWidget>("setTextVerticalAutoResize", &UIWidget::setTextVerticalAutoResize);
-    g_lua.bindClassMemberFunction<UIWidget>("setTextHorizontalAutoResize", &UIWidget::setTextHorizontalAutoResize);
-    g_lua.bindClassMemberFunction<UIWidget>("setFont", &UIWidget::setFont);
-    g_lua.bindClassMemberFunction<UIWidget>("getText", &UIWidget::getText);
-    g_lua.bindClassMemberFunction<UIWidget>("getDrawText", &UIWidget::getDrawText);
-    g_lua.bindClassMemberFunction<UIWidget>("getTextAlign", &UIWidget::getTextAlign);
-    g_lua.bindClassMemberFunction<UIWidget>("getTextOffset", &UIWidget::getTextOffset);
-    g_lua.bindClassMemberFunction<UIWidget>("getTextWrap", &UIWidget::getTextWrap);
-    g_lua.bindClassMemberFunction<UIWidget>("getFont", &UIWidget::getFont);
-    g_lua.bindClassMemberFunction<UIWidget>("getTextSize", &UIWidget::getTextSize);
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::addChild>("addChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::insertChild>("insertChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::removeChild>("removeChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::focusChild>("focusChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::focusNextChild>("focusNextChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::focusPreviousChild>("focusPreviousChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::lowerChild>("lowerChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::raiseChild>("raiseChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::moveChildToIndex>("moveChildToIndex");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::lockChild>("lockChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::unlockChild>("unlockChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::mergeStyle>("mergeStyle");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::applyStyle>("applyStyle");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::addAnchor>("addAnchor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::removeAnchor>("removeAnchor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::fill>("fill");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::centerIn>("centerIn");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::breakAnchors>("breakAnchors");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::updateParentLayout>("updateParentLayout");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::updateLayout>("updateLayout");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::repaint>("repaint");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::lock>("lock");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::unlock>("unlock");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::focus>("focus");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::lower>("lower");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::raise>("raise");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::grabMouse>("grabMouse");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::ungrabMouse>("ungrabMouse");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::grabKeyboard>("grabKeyboard");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::ungrabKeyboard>("ungrabKeyboard");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::bindRectToParent>("bindRectToParent");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::destroy>("destroy");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::destroyChildren>("destroyChildren");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setId>("setId");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setParent>("setParent");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setLayout>("setLayout");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setRect>("setRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setStyle>("setStyle");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setStyleFromNode>("setStyleFromNode");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setEnabled>("setEnabled");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setVisible>("setVisible");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setOn>("setOn");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setChecked>("setChecked");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setFocusable>("setFocusable");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPhantom>("setPhantom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setDraggable>("setDraggable");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setFixedSize>("setFixedSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setClipping>("setClipping");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setCacheRender>("setCacheRender");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setLastFocusReason>("setLastFocusReason");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setAutoFocusPolicy>("setAutoFocusPolicy");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setAutoRepeatDelay>("setAutoRepeatDelay");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setVirtualOffset>("setVirtualOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isVisible>("isVisible");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isChildLocked>("isChildLocked");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::hasChild>("hasChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildIndex>("getChildIndex");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getMarginRect>("getMarginRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getPaddingRect>("getPaddingRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildrenRect>("getChildrenRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getAnchoredLayout>("getAnchoredLayout");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getRootParent>("getRootParent");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildAfter>("getChildAfter");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildBefore>("getChildBefore");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildById>("getChildById");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildByPos>("getChildByPos");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildByIndex>("getChildByIndex");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::recursiveGetChildById>("recursiveGetChildById");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::recursiveGetChildByPos>("recursiveGetChildByPos");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::recursiveGetChildren>("recursiveGetChildren");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::recursiveGetChildrenByPos>("recursiveGetChildrenByPos");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::recursiveGetChildrenByMarginPos>("recursiveGetChildrenByMarginPos");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::backwardsGetWidgetById>("backwardsGetWidgetById");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::resize>("resize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::move>("move");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::rotate>("rotate");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::hide>("hide");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::show>("show");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::disable>("disable");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::enable>("enable");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isActive>("isActive");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isEnabled>("isEnabled");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isDisabled>("isDisabled");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isFocused>("isFocused");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isHovered>("isHovered");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isPressed>("isPressed");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isFirst>("isFirst");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isMiddle>("isMiddle");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isLast>("isLast");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isAlternate>("isAlternate");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isChecked>("isChecked");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isOn>("isOn");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isDragging>("isDragging");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isHidden>("isHidden");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isExplicitlyEnabled>("isExplicitlyEnabled");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isExplicitlyVisible>("isExplicitlyVisible");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isFocusable>("isFocusable");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isPhantom>("isPhantom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isDraggable>("isDraggable");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isFixedSize>("isFixedSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isClipping>("isClipping");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isCacheRender>("isCacheRender");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isDestroyed>("isDestroyed");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::hasChildren>("hasChildren");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::containsMarginPoint>("containsMarginPoint");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::containsPaddingPoint>("containsPaddingPoint");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::containsPoint>("containsPoint");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getId>("getId");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getParent>("getParent");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getFocusedChild>("getFocusedChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildren>("getChildren");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getFirstChild>("getFirstChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getLastChild>("getLastChild");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getLayout>("getLayout");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getStyle>("getStyle");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getChildCount>("getChildCount");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getLastFocusReason>("getLastFocusReason");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getAutoFocusPolicy>("getAutoFocusPolicy");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getAutoRepeatDelay>("getAutoRepeatDelay");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getVirtualOffset>("getVirtualOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getStyleName>("getStyleName");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getLastClickPosition>("getLastClickPosition");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setX>("setX");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setY>("setY");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setWidth>("setWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setHeight>("setHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setSize>("setSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPosition>("setPosition");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setColor>("setColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBackgroundColor>("setBackgroundColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBackgroundOffsetX>("setBackgroundOffsetX");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBackgroundOffsetY>("setBackgroundOffsetY");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBackgroundOffset>("setBackgroundOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBackgroundWidth>("setBackgroundWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBackgroundHeight>("setBackgroundHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBackgroundSize>("setBackgroundSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBackgroundRect>("setBackgroundRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIcon>("setIcon");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconColor>("setIconColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconOffsetX>("setIconOffsetX");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconOffsetY>("setIconOffsetY");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconOffset>("setIconOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconWidth>("setIconWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconHeight>("setIconHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconSize>("setIconSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconRect>("setIconRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconClip>("setIconClip");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setIconAlign>("setIconAlign");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderWidth>("setBorderWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderWidthTop>("setBorderWidthTop");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderWidthRight>("setBorderWidthRight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderWidthBottom>("setBorderWidthBottom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderWidthLeft>("setBorderWidthLeft");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderColor>("setBorderColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderColorTop>("setBorderColorTop");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderColorRight>("setBorderColorRight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderColorBottom>("setBorderColorBottom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setBorderColorLeft>("setBorderColorLeft");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setMargin>("setMargin");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setMarginHorizontal>("setMarginHorizontal");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setMarginVertical>("setMarginVertical");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setMarginTop>("setMarginTop");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setMarginRight>("setMarginRight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setMarginBottom>("setMarginBottom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setMarginLeft>("setMarginLeft");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPadding>("setPadding");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPaddingHorizontal>("setPaddingHorizontal");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPaddingVertical>("setPaddingVertical");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPaddingTop>("setPaddingTop");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPaddingRight>("setPaddingRight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPaddingBottom>("setPaddingBottom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setPaddingLeft>("setPaddingLeft");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setOpacity>("setOpacity");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setRotation>("setRotation");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getX>("getX");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getY>("getY");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getPosition>("getPosition");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getWidth>("getWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getHeight>("getHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getSize>("getSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getRect>("getRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getColor>("getColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBackgroundColor>("getBackgroundColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBackgroundOffsetX>("getBackgroundOffsetX");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBackgroundOffsetY>("getBackgroundOffsetY");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBackgroundOffset>("getBackgroundOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBackgroundWidth>("getBackgroundWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBackgroundHeight>("getBackgroundHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBackgroundSize>("getBackgroundSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBackgroundRect>("getBackgroundRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconColor>("getIconColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconOffsetX>("getIconOffsetX");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconOffsetY>("getIconOffsetY");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconOffset>("getIconOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconWidth>("getIconWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconHeight>("getIconHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconSize>("getIconSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconRect>("getIconRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconClip>("getIconClip");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getIconAlign>("getIconAlign");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBorderTopColor>("getBorderTopColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBorderRightColor>("getBorderRightColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBorderBottomColor>("getBorderBottomColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBorderLeftColor>("getBorderLeftColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBorderTopWidth>("getBorderTopWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBorderRightWidth>("getBorderRightWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBorderBottomWidth>("getBorderBottomWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getBorderLeftWidth>("getBorderLeftWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getMarginTop>("getMarginTop");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getMarginRight>("getMarginRight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getMarginBottom>("getMarginBottom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getMarginLeft>("getMarginLeft");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getPaddingTop>("getPaddingTop");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getPaddingRight>("getPaddingRight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getPaddingBottom>("getPaddingBottom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getPaddingLeft>("getPaddingLeft");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getOpacity>("getOpacity");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getRotation>("getRotation");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageSource>("setImageSource");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageClip>("setImageClip");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageOffsetX>("setImageOffsetX");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageOffsetY>("setImageOffsetY");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageOffset>("setImageOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageWidth>("setImageWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageHeight>("setImageHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageSize>("setImageSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageRect>("setImageRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageColor>("setImageColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageFixedRatio>("setImageFixedRatio");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageRepeated>("setImageRepeated");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageSmooth>("setImageSmooth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageAutoResize>("setImageAutoResize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageBorderTop>("setImageBorderTop");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageBorderRight>("setImageBorderRight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageBorderBottom>("setImageBorderBottom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageBorderLeft>("setImageBorderLeft");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setImageBorder>("setImageBorder");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageClip>("getImageClip");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageOffsetX>("getImageOffsetX");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageOffsetY>("getImageOffsetY");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageOffset>("getImageOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageWidth>("getImageWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageHeight>("getImageHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageSize>("getImageSize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageRect>("getImageRect");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageColor>("getImageColor");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isImageFixedRatio>("isImageFixedRatio");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isImageSmooth>("isImageSmooth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::isImageAutoResize>("isImageAutoResize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageBorderTop>("getImageBorderTop");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageBorderRight>("getImageBorderRight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageBorderBottom>("getImageBorderBottom");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageBorderLeft>("getImageBorderLeft");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageTextureWidth>("getImageTextureWidth");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getImageTextureHeight>("getImageTextureHeight");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::resizeToText>("resizeToText");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::clearText>("clearText");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setText>("setText");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setTextAlign>("setTextAlign");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setTextOffset>("setTextOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setTextWrap>("setTextWrap");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setTextAutoResize>("setTextAutoResize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setTextVerticalAutoResize>("setTextVerticalAutoResize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setTextHorizontalAutoResize>("setTextHorizontalAutoResize");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::setFont>("setFont");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getText>("getText");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getDrawText>("getDrawText");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getTextAlign>("getTextAlign");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getTextOffset>("getTextOffset");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getTextWrap>("getTextWrap");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getFont>("getFont");
+    g_lua.bindClassMemberFunction<UIWidget, &UIWidget::getTextSize>("getTextSize");
 
     // UILayout
     g_lua.registerClass<UILayout>();
@@ -743,6 +942,56 @@ void Application::registerLuaFunctions()
     g_lua.registerClass<UIParticles, UIWidget>();
     g_lua.bindClassStaticFunction<UIParticles>("create", [] { return UIParticlesPtr(new UIParticles); });
     g_lua.bindClassMemberFunction<UIParticles>("addEffect", &UIParticles::addEffect);
+
+    // UIVirtualList
+    g_lua.registerClass<UIVirtualList, UIWidget>();
+    g_lua.bindClassStaticFunction<UIVirtualList>("create", [] { return UIVirtualListPtr(new UIVirtualList); });
+    g_lua.bindClassMemberFunction<UIVirtualList>("setRowStyle", &UIVirtualList::setRowStyle);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setRowHeight", &UIVirtualList::setRowHeight);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setRowSpacing", &UIVirtualList::setRowSpacing);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setColumns", &UIVirtualList::setColumns);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setItemCount", &UIVirtualList::setItemCount);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setScrollOffset", &UIVirtualList::setScrollOffset);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setScrollStep", &UIVirtualList::setScrollStep);
+    g_lua.bindClassMemberFunction<UIVirtualList>("refresh", &UIVirtualList::refresh);
+    g_lua.bindClassMemberFunction<UIVirtualList>("refreshItem", &UIVirtualList::refreshItem);
+    g_lua.bindClassMemberFunction<UIVirtualList>("ensureItemVisible", &UIVirtualList::ensureItemVisible);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getRowStyle", &UIVirtualList::getRowStyle);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getRowHeight", &UIVirtualList::getRowHeight);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getRowSpacing", &UIVirtualList::getRowSpacing);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getColumns", &UIVirtualList::getColumns);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getItemCount", &UIVirtualList::getItemCount);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getScrollOffset", &UIVirtualList::getScrollOffset);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getMaxScrollOffset", &UIVirtualList::getMaxScrollOffset);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getScrollStep", &UIVirtualList::getScrollStep);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getFirstVisibleItem", &UIVirtualList::getFirstVisibleItem);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getLastVisibleItem", &UIVirtualList::getLastVisibleItem);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getItemWidget", &UIVirtualList::getItemWidget);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getItemIndex", &UIVirtualList::getItemIndex);
+
+    // UITextLog
+    g_lua.registerClass<UITextLog, UIWidget>();
+    g_lua.bindClassStaticFunction<UITextLog>("create", [] { return UITextLogPtr(new UITextLog); });
+    g_lua.bindClassMemberFunction<UITextLog>("appendMessages", &UITextLog::appendMessages);
+    g_lua.bindClassMemberFunction<UITextLog>("appendMessage", &UITextLog::appendMessage);
+    g_lua.bindClassMemberFunction<UITextLog>("clear", &UITextLog::clear);
+    g_lua.bindClassMemberFunction<UITextLog>("setCapacity", &UITextLog::setCapacity);
+    g_lua.bindClassMemberFunction<UITextLog>("setLineSpacing", &UITextLog::setLineSpacing);
+    g_lua.bindClassMemberFunction<UITextLog>("setShowTimestamps", &UITextLog::setShowTimestamps);
+    g_lua.bindClassMemberFunction<UITextLog>("setScrollOffset", &UITextLog::setScrollOffset);
+    g_lua.bindClassMemberFunction<UITextLog>("setScrollStep", &UITextLog::setScrollStep);
+    g_lua.bindClassMemberFunction<UITextLog>("getCapacity", &UITextLog::getCapacity);
+    g_lua.bindClassMemberFunction<UITextLog>("getLineSpacing", &UITextLog::getLineSpacing);
+    g_lua.bindClassMemberFunction<UITextLog>("isShowingTimestamps", &UITextLog::isShowingTimestamps);
+    g_lua.bindClassMemberFunction<UITextLog>("getScrollOffset", &UITextLog::getScrollOffset);
+    g_lua.bindClassMemberFunction<UITextLog>("getMaxScrollOffset", &UITextLog::getMaxScrollOffset);
+    g_lua.bindClassMemberFunction<UITextLog>("getScrollStep", &UITextLog::getScrollStep);
+    g_lua.bindClassMemberFunction<UITextLog>("getMessageCount", &UITextLog::getMessageCount);
+    g_lua.bindClassMemberFunction<UITextLog>("getLineCount", &UITextLog::getLineCount);
+    g_lua.bindClassMemberFunction<UITextLog>("getMessageText", &UITextLog::getMessageText);
+    g_lua.bindClassMemberFunction<UITextLog>("getMessageSpeaker", &UITextLog::getMessageSpeaker);
+    g_lua.bindClassMemberFunction<UITextLog>("getMessageMode", &UITextLog::getMessageMode);
+    g_lua.bindClassMemberFunction<UITextLog>("getMessageTime", &UITextLog::getMessageTime);
 #endif
 
 #ifdef FW_NET
@@ -752,10 +1001,34 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Server>("close", &Server::close);
     g_lua.bindClassMemberFunction<Server>("isOpen", &Server::isOpen);
     g_lua.bindClassMemberFunction<Server>("acceptNext", &Server::acceptNext);
+    g_lua.bindClassStaticFunction<Server>("createThreaded", &Server::createThreaded);
+    g_lua.bindClassMemberFunction<Server>("isThreaded", &Server::isThreaded);
+    g_lua.bindClassMemberFunction<Server>("send", &Server::send);
+    g_lua.bindClassMemberFunction<Server>("broadcast", &Server::broadcast);
+    g_lua.bindClassMemberFunction<Server>("disconnect", &Server::disconnect);
+    g_lua.bindClassMemberFunction<Server>("getSessionCount", &Server::getSessionCount);
+    g_lua.bindClassMemberFunction<Server>("getDroppedFrameCount", &Server::getDroppedFrameCount);
+
+    g_lua.registerSingletonClass("g_bufferPool");
+    g_lua.bindSingletonFunction("g_bufferPool", "getUsedBytes", &BufferPool::getUsedBytes, &g_bufferPool);
+    g_lua.bindSingletonFunction("g_bufferPool", "getHighWaterMark", &BufferPool::getHighWaterMark, &g_bufferPool);
+    g_lua.bindSingletonFunction("g_bufferPool", "getFreeBytes", &BufferPool::getFreeBytes, &g_bufferPool);
+    g_lua.bindSingletonFunction("g_bufferPool", "getAllocations", &BufferPool::getAllocations, &g_bufferPool);
 
     // Connection
     g_lua.registerClass<Connection>();
     g_lua.bindClassMemberFunction<Connection>("getIp", &Connection::getIp);
+    g_lua.bindClassStaticFunction<Connection>("setNetworkThreadEnabled", &Connection::setNetworkThreadEnabled);
+    g_lua.bindClassStaticFunction<Connection>("isNetworkThreadEnabled", &Connection::isNetworkThreadEnabled);
+    g_lua.bindClassStaticFunction<Connection>("setDnsCacheTtl", &Connection::setDnsCacheTtl);
+    g_lua.bindClassStaticFunction<Connection>("clearDnsCache", &Connection::clearDnsCache);
+    g_lua.bindClassMemberFunction<Connection>("setWriteBatchDelay", &Connection::setWriteBatchDelay);
+    g_lua.bindClassMemberFunction<Connection>("getWriteBatchDelay", &Connection::getWriteBatchDelay);
+    g_lua.bindClassMemberFunction<Connection>("getWriteCount", &Connection::getWriteCount);
+    g_lua.bindClassMemberFunction<Connection>("getWrittenBytes", &Connection::getWrittenBytes);
+    g_lua.bindClassMemberFunction<Connection>("getAverageWriteBatch", &Connection::getAverageWriteBatch);
+    g_lua.bindClassMemberFunction<Connection>("getReadBytes", &Connection::getReadBytes);
+    g_lua.bindClassMemberFunction<Connection>("getQueuedBytes", &Connection::getQueuedBytes);
 
     // Protocol
     g_lua.registerClass<Protocol>();
@@ -773,6 +1046,24 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Protocol>("generateXteaKey", &Protocol::generateXteaKey);
     g_lua.bindClassMemberFunction<Protocol>("enableXteaEncryption", &Protocol::enableXteaEncryption);
     g_lua.bindClassMemberFunction<Protocol>("enableChecksum", &Protocol::enableChecksum);
+    g_lua.bindClassMemberFunction<Protocol>("setChecksumVerification", &Protocol::setChecksumVerification);
+    g_lua.bindClassMemberFunction<Protocol>("isChecksumVerification", &Protocol::isChecksumVerification);
+    g_lua.bindClassMemberFunction<Protocol>("startRecording", &Protocol::startRecording);
+    g_lua.bindClassMemberFunction<Protocol>("stopRecording", &Protocol::stopRecording);
+    g_lua.bindClassMemberFunction<Protocol>("isRecording", &Protocol::isRecording);
+    g_lua.bindClassMemberFunction<Protocol>("setUrgentOpcode", &Protocol::setUrgentOpcode);
+    g_lua.bindClassMemberFunction<Protocol>("setWriteBatchDelay", &Protocol::setWriteBatchDelay);
+    g_lua.bindClassMemberFunction<Protocol>("enableCompression", &Protocol::enableCompression);
+    g_lua.bindClassMemberFunction<Protocol>("setCompressionDictionary", &Protocol::setCompressionDictionary);
+    g_lua.bindClassMemberFunction<Protocol>("getCompressedBytes", &Protocol::getCompressedBytes);
+    g_lua.bindClassMemberFunction<Protocol>("getInflatedBytes", &Protocol::getInflatedBytes);
+    g_lua.bindClassMemberFunction<Protocol>("getUncompressedBytes", &Protocol::getUncompressedBytes);
+    g_lua.bindClassMemberFunction<Protocol>("getArrivalStats", &Protocol::getArrivalStats);
+    g_lua.bindClassMemberFunction<Protocol>("getReadBytes", &Protocol::getReadBytes);
+    g_lua.bindClassMemberFunction<Protocol>("getWrittenBytes", &Protocol::getWrittenBytes);
+    g_lua.bindClassMemberFunction<Protocol>("getQueuedBytes", &Protocol::getQueuedBytes);
+    g_lua.bindClassStaticFunction<Protocol>("benchmarkXtea", &Protocol::benchmarkXtea);
+    g_lua.bindClassStaticFunction<Protocol>("benchmarkChecksum", &Protocol::benchmarkChecksum);
 
     // ProtocolHttp
     g_lua.registerClass<ProtocolHttp>();
@@ -782,6 +1073,28 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<ProtocolHttp>("send", &ProtocolHttp::send);
     g_lua.bindClassMemberFunction<ProtocolHttp>("recv", &ProtocolHttp::recv);
 
+    // HttpDownload
+    g_lua.registerClass<HttpDownload>();
+    g_lua.bindClassStaticFunction<HttpDownload>("create", [] { return HttpDownloadPtr(new HttpDownload); });
+    g_lua.bindClassMemberFunction<HttpDownload>("start", &HttpDownload::start);
+    g_lua.bindClassMemberFunction<HttpDownload>("cancel", &HttpDownload::cancel);
+    g_lua.bindClassMemberFunction<HttpDownload>("isFinished", &HttpDownload::isFinished);
+    g_lua.bindClassMemberFunction<HttpDownload>("getDownloadedBytes", &HttpDownload::getDownloadedBytes);
+    g_lua.bindClassMemberFunction<HttpDownload>("getTotalBytes", &HttpDownload::getTotalBytes);
+
+    // HttpCache
+    g_lua.registerClass<HttpCache>();
+    g_lua.bindClassStaticFunction<HttpCache>("create", [](const std::string& directory) { return HttpCachePtr(new HttpCache(directory)); });
+    g_lua.bindClassMemberFunction<HttpCache>("fetch", &HttpCache::fetch);
+    g_lua.bindClassMemberFunction<HttpCache>("cancel", &HttpCache::cancel);
+    g_lua.bindClassMemberFunction<HttpCache>("mount", &HttpCache::mount);
+    g_lua.bindClassMemberFunction<HttpCache>("unmount", &HttpCache::unmount);
+    g_lua.bindClassMemberFunction<HttpCache>("prune", &HttpCache::prune);
+    g_lua.bindClassMemberFunction<HttpCache>("isFetching", &HttpCache::isFetching);
+    g_lua.bindClassMemberFunction<HttpCache>("getFileHash", &HttpCache::getFileHash);
+    g_lua.bindClassMemberFunction<HttpCache>("getFilesDirectory", &HttpCache::getFilesDirectory);
+    g_lua.bindClassMemberFunction<HttpCache>("getFileCount", &HttpCache::getFileCount);
+
     // InputMessage
     g_lua.registerClass<InputMessage>();
     g_lua.bindClassStaticFunction<InputMessage>("create", [] { return InputMessagePtr(new InputMessage); });
@@ -833,8 +1146,15 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_sounds", "disableAudio", &SoundManager::disableAudio, &g_sounds);
     g_lua.bindSingletonFunction("g_sounds", "setAudioEnabled", &SoundManager::setAudioEnabled, &g_sounds);
     g_lua.bindSingletonFunction("g_sounds", "isAudioEnabled", &SoundManager::isAudioEnabled, &g_sounds);
+    g_lua.bindSingletonFunction("g_sounds", "getVoiceStats", &SoundManager::getVoiceStats, &g_sounds);
+    g_lua.bindSingletonFunction("g_sounds", "loadSoundBank", &SoundManager::loadSoundBank, &g_sounds);
+    g_lua.bindSingletonFunction("g_sounds", "unloadSoundBank", &SoundManager::unloadSoundBank, &g_sounds);
+    g_lua.bindSingletonFunction("g_sounds", "isSoundBankLoaded", &SoundManager::isSoundBankLoaded, &g_sounds);
+    g_lua.bindSingletonFunction("g_sounds", "buildSoundBank", &SoundManager::buildSoundBank, &g_sounds);
 
     g_lua.registerClass<SoundSource>();
+    g_lua.bindClassMemberFunction<SoundSource>("hasVoice", &SoundSource::hasVoice);
+    g_lua.bindClassMemberFunction<SoundSource>("getPriority", &SoundSource::getPriority);
     g_lua.registerClass<CombinedSoundSource, SoundSource>();
     g_lua.registerClass<StreamSoundSource, SoundSource>();
 
@@ -860,6 +1180,12 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Database>("getUpdateLimiter", &Database::getUpdateLimiter);
     g_lua.bindClassMemberFunction<Database>("getLastInsertedRowID", &Database::getLastInsertedRowID);
     g_lua.bindClassMemberFunction<Database>("escapeString", &Database::escapeString);
+    g_lua.bindClassMemberFunction<Database>("asyncExecuteQuery", &Database::asyncExecuteQuery);
+    g_lua.bindClassMemberFunction<Database>("asyncStoreQuery", &Database::asyncStoreQuery);
+    g_lua.bindClassMemberFunction<Database>("asyncInsert", &Database::asyncInsert);
+    g_lua.bindClassMemberFunction<Database>("flushInserts", &Database::flushInserts);
+    g_lua.bindClassMemberFunction<Database>("setInsertFlushInterval", &Database::setInsertFlushInterval);
+    g_lua.bindClassMemberFunction<Database>("getInsertFlushInterval", &Database::getInsertFlushInterval);
     //g_lua.bindClassMemberFunction<Database>("escapeBlob", &Database::escapeBlob); // need to write a cast for this type to work (if needed)
 
     // DBQuery
@@ -889,6 +1215,10 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<DatabaseMySQL>("commit", &DatabaseMySQL::commit);
     g_lua.bindClassMemberFunction<DatabaseMySQL>("executeQuery", &DatabaseMySQL::executeQuery);
     g_lua.bindClassMemberFunction<DatabaseMySQL>("storeQuery", &DatabaseMySQL::storeQuery);
+    g_lua.bindClassMemberFunction<DatabaseMySQL>("startAsync", &DatabaseMySQL::startAsync);
+    g_lua.bindClassMemberFunction<DatabaseMySQL>("stopAsync", &DatabaseMySQL::stopAsync);
+    g_lua.bindClassMemberFunction<DatabaseMySQL>("isAsync", &DatabaseMySQL::isAsync);
+    g_lua.bindClassMemberFunction<DatabaseMySQL>("getPendingAsyncQueries", &DatabaseMySQL::getPendingAsyncQueries);
 
     // MySQLResult
     g_lua.registerClass<MySQLResult>();
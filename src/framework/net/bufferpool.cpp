@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "bufferpool.h"
+
+BufferPool g_bufferPool;
+
+int BufferPool::getSizeClass(size_t size)
+{
+    size_t classSize = MIN_BUFFER_SIZE;
+    for(int i = 0; i < SIZE_CLASSES; ++i, classSize *= 4) {
+        if(size <= classSize)
+            return i;
+    }
+    return -1;
+}
+
+uint8* BufferPool::acquire(size_t size, size_t& capacity)
+{
+    const int sizeClass = getSizeClass(size);
+    capacity = sizeClass >= 0 ? (size_t)MIN_BUFFER_SIZE << (2 * sizeClass) : size;
+
+    uint8* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(sizeClass >= 0 && !m_freeBuffers[sizeClass].empty()) {
+            buffer = m_freeBuffers[sizeClass].back();
+            m_freeBuffers[sizeClass].pop_back();
+            m_freeBytes -= capacity;
+        } else
+            m_allocations++;
+
+        m_usedBytes += capacity;
+        m_highWaterMark = std::max<size_t>(m_highWaterMark, m_usedBytes);
+    }
+
+    if(!buffer)
+        buffer = new uint8[capacity];
+    return buffer;
+}
+
+void BufferPool::release(uint8* buffer, size_t capacity)
+{
+    if(!buffer)
+        return;
+
+    const int sizeClass = getSizeClass(capacity);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_usedBytes -= capacity;
+        if(sizeClass >= 0 && m_freeBuffers[sizeClass].size() < MAX_FREE_BUFFERS) {
+            m_freeBuffers[sizeClass].push_back(buffer);
+            m_freeBytes += capacity;
+            return;
+        }
+    }
+    delete[] buffer;
+}
+
+void BufferPool::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(std::vector<uint8*>& buffers : m_freeBuffers) {
+        for(uint8* buffer : buffers)
+            delete[] buffer;
+        buffers.clear();
+    }
+    m_freeBytes = 0;
+}
+
+void PooledBuffer::reserve(size_t size, size_t keep)
+{
+    if(size <= m_capacity)
+        return;
+
+    size_t capacity;
+    uint8* data = g_bufferPool.acquire(size, capacity);
+    if(m_data && keep > 0)
+        memcpy(data, m_data, std::min<size_t>(keep, m_capacity));
+
+    release();
+    m_data = data;
+    m_capacity = capacity;
+}
+
+void PooledBuffer::release()
+{
+    g_bufferPool.release(m_data, m_capacity);
+    m_data = nullptr;
+    m_capacity = 0;
+}
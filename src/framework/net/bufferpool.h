@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include "declarations.h"
+
+#include <mutex>
+
+// size classed byte buffers shared by output messages and connections, released buffers are kept
+// for reuse up to a limit per class so steady traffic stops reaching the allocator
+class BufferPool
+{
+public:
+    enum {
+        MIN_BUFFER_SIZE = 256,
+        MAX_BUFFER_SIZE = 65536,
+        SIZE_CLASSES = 5, // 256, 1k, 4k, 16k and 64k
+        MAX_FREE_BUFFERS = 32
+    };
+
+    ~BufferPool() { clear(); }
+
+    // capacity receives the real size, sizes above the largest class are allocated and freed directly
+    uint8* acquire(size_t size, size_t& capacity);
+    void release(uint8* buffer, size_t capacity);
+    void clear();
+
+    size_t getUsedBytes() { return m_usedBytes; }
+    size_t getHighWaterMark() { return m_highWaterMark; }
+    size_t getFreeBytes() { return m_freeBytes; }
+    uint64 getAllocations() { return m_allocations; }
+
+private:
+    static int getSizeClass(size_t size);
+
+    std::mutex m_mutex;
+    std::array<std::vector<uint8*>, SIZE_CLASSES> m_freeBuffers;
+    size_t m_usedBytes = 0;
+    size_t m_highWaterMark = 0;
+    size_t m_freeBytes = 0;
+    uint64 m_allocations = 0;
+};
+
+extern BufferPool g_bufferPool;
+
+// owns one buffer from g_bufferPool
+class PooledBuffer
+{
+public:
+    PooledBuffer() = default;
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer(PooledBuffer&& other) noexcept { swap(other); }
+    ~PooledBuffer() { release(); }
+
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept { swap(other); return *this; }
+
+    // grows to at least size, the first keep bytes are preserved
+    void reserve(size_t size, size_t keep = 0);
+    void release();
+    void swap(PooledBuffer& other) noexcept { std::swap(m_data, other.m_data); std::swap(m_capacity, other.m_capacity); }
+
+    uint8* data() { return m_data; }
+    size_t capacity() { return m_capacity; }
+
+private:
+    uint8* m_data = nullptr;
+    size_t m_capacity = 0;
+};
+
+#endif
@@ -21,25 +21,112 @@
  */
 
 #include "connection.h"
+#include "receivebuffer.h"
 
 #include <framework/core/application.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/frameprofiler.h>
+#include <framework/stdext/spsc_queue.h>
 
 #include <boost/asio.hpp>
 #include <memory>
+#include <thread>
+
+#ifdef FW_GRAPHICS
+#include <framework/platform/platformwindow.h>
+#endif
 
 asio::io_service g_ioService;
-std::list<std::shared_ptr<asio::streambuf>> Connection::m_outputStreams;
+int Connection::m_instances = 0;
+
+namespace {
+    // producers back off while a queue is full, the other side always drains everything it finds
+    constexpr size_t NETWORK_QUEUE_SIZE = 4096;
+
+    stdext::spsc_queue<std::function<void()>, NETWORK_QUEUE_SIZE> g_networkTasks;
+    stdext::spsc_queue<std::function<void()>, NETWORK_QUEUE_SIZE> g_mainTasks;
+    std::atomic<bool> g_networkWakeup{ false };
+    uint64 g_polledHandlers = 0;
+    std::unique_ptr<asio::io_service::work> g_networkWork;
+    std::thread g_networkThread;
+    bool g_networkThreadEnabled = false;
+
+    // connections with handlers alive on the network thread, only touched by the main thread
+    std::vector<ConnectionPtr> g_activeConnections;
+
+    // only touched by the thread running the io service
+    struct DnsCacheEntry {
+        std::vector<asio::ip::tcp::endpoint> endpoints;
+        ticks_t expiration;
+    };
+    std::unordered_map<std::string, DnsCacheEntry> g_dnsCache;
+    std::atomic<int> g_dnsCacheTtl{ 300 }; // seconds
+
+    void runNetworkTasks()
+    {
+        g_networkWakeup = false;
+
+        std::function<void()> task;
+        while(g_networkTasks.pop(task)) {
+            task();
+            task = nullptr;
+        }
+    }
+
+    void runMainTasks()
+    {
+        std::function<void()> task;
+        while(g_mainTasks.pop(task)) {
+            task();
+            task = nullptr;
+            g_polledHandlers++;
+        }
+    }
+}
+
+Connection::HandlerRef::HandlerRef(Connection* connection) : m_connection(connection)
+{
+    if(!g_networkThreadEnabled) {
+        m_ptr = connection->asConnection();
+        return;
+    }
+
+    // the network thread only copies references that already exist, so the count
+    // can only leave zero on the main thread
+    if(connection->m_handlers++ == 0 && !connection->m_active) {
+        connection->m_active = true;
+        g_activeConnections.push_back(connection->asConnection());
+    }
+}
+
+Connection::HandlerRef::HandlerRef(const HandlerRef& other) : m_ptr(other.m_ptr), m_connection(other.m_connection)
+{
+    if(g_networkThreadEnabled && m_connection)
+        ++m_connection->m_handlers;
+}
+
+Connection::HandlerRef::HandlerRef(HandlerRef&& other) noexcept : m_ptr(std::move(other.m_ptr)), m_connection(other.m_connection)
+{
+    other.m_connection = nullptr;
+}
+
+Connection::HandlerRef::~HandlerRef()
+{
+    if(g_networkThreadEnabled && m_connection)
+        --m_connection->m_handlers;
+}
 
 Connection::Connection() :
     m_readTimer(g_ioService),
     m_writeTimer(g_ioService),
     m_delayedWriteTimer(g_ioService),
     m_resolver(g_ioService),
-    m_socket(g_ioService)
+    m_socket(g_ioService),
+    m_attemptTimer(g_ioService)
 {
     m_connected = false;
     m_connecting = false;
+    ++m_instances;
 }
 
 Connection::~Connection()
@@ -47,20 +134,127 @@ Connection::~Connection()
 #ifndef NDEBUG
     assert(!g_app.isTerminated());
 #endif
+    --m_instances;
+
+    // no handler is left on the network thread once the last reference is gone
+    if(g_networkThreadEnabled) {
+        m_connecting = false;
+        m_connected = false;
+        boost::system::error_code ec;
+        m_socket.close(ec);
+        return;
+    }
+
     close();
 }
 
 void Connection::poll()
 {
+    PROFILE_SCOPE("net.poll");
+    if(g_networkThreadEnabled) {
+        runMainTasks();
+
+        // release the connections the network thread is done with
+        for(auto it = g_activeConnections.begin(); it != g_activeConnections.end();) {
+            if((*it)->m_handlers == 0) {
+                (*it)->m_active = false;
+                it = g_activeConnections.erase(it);
+            } else
+                ++it;
+        }
+        return;
+    }
+
     // reset must always be called prior to poll
     g_ioService.reset();
-    g_ioService.poll();
+    g_polledHandlers += g_ioService.poll();
+}
+
+uint64 Connection::getPolledHandlerCount()
+{
+    return g_polledHandlers;
 }
 
 void Connection::terminate()
 {
+    if(g_networkThreadEnabled) {
+        g_networkWork.reset();
+        g_ioService.stop();
+        g_networkThread.join();
+
+        // the network thread is gone, run everything left on this thread so every handler lets go
+        runNetworkTasks();
+        for(const ConnectionPtr& connection : g_activeConnections)
+            connection->internal_close(false);
+        g_ioService.reset();
+        g_ioService.poll();
+        runMainTasks();
+        g_activeConnections.clear();
+    }
+
     g_ioService.stop();
-    m_outputStreams.clear();
+    g_bufferPool.clear();
+}
+
+bool Connection::setNetworkThreadEnabled(bool enable)
+{
+    if(enable == g_networkThreadEnabled)
+        return true;
+
+    if(m_instances > 0) {
+        g_logger.error("the network thread can only be switched while there is no connection or server");
+        return false;
+    }
+
+    if(enable) {
+        g_ioService.reset();
+        g_networkWork = std::make_unique<asio::io_service::work>(g_ioService);
+        g_networkThreadEnabled = true;
+        g_networkThread = std::thread([] { g_ioService.run(); });
+    } else {
+        g_networkWork.reset();
+        g_ioService.stop();
+        g_networkThread.join();
+        g_networkThreadEnabled = false;
+        g_activeConnections.clear();
+        g_ioService.reset();
+    }
+    return true;
+}
+
+bool Connection::isNetworkThreadEnabled()
+{
+    return g_networkThreadEnabled;
+}
+
+void Connection::postToNetwork(std::function<void()>&& task)
+{
+    if(!g_networkThreadEnabled) {
+        task();
+        return;
+    }
+
+    while(!g_networkTasks.push(std::move(task)))
+        std::this_thread::yield();
+
+    if(!g_networkWakeup.exchange(true))
+        g_ioService.post(runNetworkTasks);
+}
+
+void Connection::postToMain(std::function<void()>&& task)
+{
+    if(!g_networkThreadEnabled) {
+        task();
+        return;
+    }
+
+    while(!g_mainTasks.push(std::move(task)))
+        std::this_thread::yield();
+
+#ifdef FW_GRAPHICS
+    // the main thread may be blocked in an idle wait
+    g_window.wakeUp();
+#endif
 }
 
 void Connection::close()
@@ -69,89 +263,254 @@ void Connection::close()
         return;
 
     // flush send data before disconnecting on clean connections
-    if(m_connected && !m_error && m_outputStream)
-        internal_write();
+    const bool flush = m_connected && !m_error;
 
-    m_connecting = false;
-    m_connected = false;
     m_connectCallback = nullptr;
     m_errorCallback = nullptr;
     m_recvCallback = nullptr;
+    m_frameCallback = nullptr;
+    m_readyFrames.clear();
+    m_readAheadStarted = false;
+    m_closed = true;
+
+    if(g_networkThreadEnabled)
+        postToNetwork([ref = handlerRef(), flush] { ref->internal_close(flush); });
+    else
+        internal_close(flush);
+}
+
+void Connection::internal_close(bool flush)
+{
+    if(!m_connected && !m_connecting)
+        return;
+
+    if(flush && m_connected && m_outputSize > 0) {
+        m_writeInFlight = false;
+        internal_write();
+    }
+
+    m_connecting = false;
+    m_connected = false;
 
     m_resolver.cancel();
     m_readTimer.cancel();
     m_writeTimer.cancel();
     m_delayedWriteTimer.cancel();
+    m_attemptTimer.cancel();
+
+    for(const auto& socket : m_attemptSockets) {
+        boost::system::error_code ec;
+        socket->close(ec);
+    }
+    m_attemptSockets.clear();
 
     if(m_socket.is_open()) {
         boost::system::error_code ec;
         m_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
         m_socket.close();
     }
+    m_queuedBytes = 0;
 }
 
 void Connection::connect(const std::string& host, uint16 port, const std::function<void()>& connectCallback)
 {
     m_connected = false;
     m_connecting = true;
+    m_closed = false;
     m_error.clear();
     m_connectCallback = connectCallback;
 
-    asio::ip::tcp::resolver::query query(host, stdext::unsafe_cast<std::string>(port));
-    m_resolver.async_resolve(query, std::bind(&Connection::onResolve, asConnection(), std::placeholders::_1, std::placeholders::_2));
+    if(g_networkThreadEnabled)
+        postToNetwork([ref = handlerRef(), host, port] { ref->internal_resolve(host, port); });
+    else
+        internal_resolve(host, port);
+}
 
-    m_readTimer.cancel();
-    m_readTimer.expires_from_now(boost::posix_time::seconds(static_cast<uint32>(READ_TIMEOUT)));
-    m_readTimer.async_wait(std::bind(&Connection::onTimeout, asConnection(), std::placeholders::_1));
+void Connection::setDnsCacheTtl(int seconds)
+{
+    g_dnsCacheTtl = std::max<int>(seconds, 0);
 }
 
-void Connection::internal_connect(asio::ip::basic_resolver<asio::ip::tcp>::iterator endpointIterator)
+void Connection::clearDnsCache()
 {
-    m_socket.async_connect(*endpointIterator, std::bind(&Connection::onConnect, asConnection(), std::placeholders::_1));
+    if(g_networkThreadEnabled)
+        postToNetwork([] { g_dnsCache.clear(); });
+    else
+        g_dnsCache.clear();
+}
+
+void Connection::internal_resolve(const std::string& host, uint16 port)
+{
+    const std::string service = stdext::unsafe_cast<std::string>(port);
+    m_resolveKey = host + ":" + service;
+
+    auto it = g_dnsCache.find(m_resolveKey);
+    if(it != g_dnsCache.end()) {
+        if(it->second.expiration > stdext::millis()) {
+            internal_connect(it->second.endpoints);
+            return;
+        }
+        g_dnsCache.erase(it);
+    }
+
+    asio::ip::tcp::resolver::query query(host, service);
+    m_resolver.async_resolve(query, [ref = handlerRef()](const boost::system::error_code& error, asio::ip::tcp::resolver::iterator endpointIterator) {
+        ref->onResolve(error, endpointIterator);
+    });
+
+    restartReadTimer();
+}
+
+void Connection::internal_connect(const std::vector<asio::ip::tcp::endpoint>& endpoints)
+{
+    m_endpoints = endpoints;
+    m_attemptSockets.clear();
+    m_failedAttempts = 0;
+    startNextAttempt();
+
+    restartReadTimer();
+}
+
+void Connection::startNextAttempt()
+{
+    m_attemptTimer.cancel();
+
+    const size_t index = m_attemptSockets.size();
+    if(!m_connecting || index >= m_endpoints.size())
+        return;
+
+    m_attemptSockets.emplace_back(new asio::ip::tcp::socket(g_ioService));
+    m_attemptSockets.back()->async_connect(m_endpoints[index], [ref = handlerRef(), index](const boost::system::error_code& error) {
+        ref->onAttemptConnect(error, index);
+    });
+
+    // a slow endpoint doesn't block the next one, it only gets a head start
+    if(index + 1 < m_endpoints.size()) {
+        m_attemptTimer.expires_from_now(boost::posix_time::milliseconds(static_cast<uint32>(CONNECTION_ATTEMPT_DELAY)));
+        m_attemptTimer.async_wait([ref = handlerRef()](const boost::system::error_code& error) {
+            if(!error)
+                ref->startNextAttempt();
+        });
+    }
+}
+
+void Connection::onAttemptConnect(const boost::system::error_code& error, size_t index)
+{
+    if(error == asio::error::operation_aborted || !m_connecting || index >= m_attemptSockets.size())
+        return;
+
+    if(error) {
+        boost::system::error_code ec;
+        m_attemptSockets[index]->close(ec);
+
+        // the cached endpoints may be what is dead
+        if(++m_failedAttempts == m_endpoints.size()) {
+            g_dnsCache.erase(m_resolveKey);
+            m_attemptSockets.clear();
+            onConnect(error);
+        } else
+            startNextAttempt();
+        return;
+    }
+
+    m_attemptTimer.cancel();
+    m_socket = std::move(*m_attemptSockets[index]);
+    for(const auto& socket : m_attemptSockets) {
+        boost::system::error_code ec;
+        socket->close(ec);
+    }
+    m_attemptSockets.clear();
+    onConnect(error);
+}
+
+void Connection::enableQuickAck()
+{
+#ifdef TCP_QUICKACK
+    // linux falls back to delayed acks after a while, so this is renewed before every read
+    boost::system::error_code ec;
+    m_socket.set_option(asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_QUICKACK>(true), ec);
+#endif
+}
+
+void Connection::restartReadTimer()
+{
+    enableQuickAck();
 
     m_readTimer.cancel();
     m_readTimer.expires_from_now(boost::posix_time::seconds(static_cast<uint32>(READ_TIMEOUT)));
-    m_readTimer.async_wait(std::bind(&Connection::onTimeout, asConnection(), std::placeholders::_1));
+    m_readTimer.async_wait([ref = handlerRef()](const boost::system::error_code& error) { ref->onTimeout(error); });
 }
 
-void Connection::write(uint8* buffer, size_t size)
+void Connection::write(uint8* buffer, size_t size, bool urgent)
+{
+    if(!m_connected)
+        return;
+
+    if(g_networkThreadEnabled)
+        postToNetwork([ref = handlerRef(), data = std::vector<uint8>(buffer, buffer + size), urgent] { ref->internal_append(data.data(), data.size(), urgent); });
+    else
+        internal_append(buffer, size, urgent);
+}
+
+void Connection::internal_append(const uint8* buffer, size_t size, bool urgent)
 {
     if(!m_connected)
         return;
 
     // we can't send the data right away, otherwise we could create tcp congestion
-    if(!m_outputStream) {
-        if(!m_outputStreams.empty()) {
-            m_outputStream = m_outputStreams.front();
-            m_outputStreams.pop_front();
-        } else
-            m_outputStream = std::make_shared<asio::streambuf>();
+    if(m_outputSize == 0) {
+        if(!urgent) {
+            m_delayedWriteTimer.cancel();
+            m_delayedWriteTimer.expires_from_now(boost::posix_time::microseconds(m_writeBatchDelay.load()));
+            m_delayedWriteTimer.async_wait([ref = handlerRef()](const boost::system::error_code& error) { ref->onCanWrite(error); });
+        }
+    }
+
+    m_outputBuffer.reserve(m_outputSize + size, m_outputSize);
+    memcpy(m_outputBuffer.data() + m_outputSize, buffer, size);
+    m_outputSize += size;
+    m_batchedMessages++;
+    updateQueuedBytes();
 
+    // whatever was batched so far goes out together with the urgent message
+    if(urgent) {
         m_delayedWriteTimer.cancel();
-        m_delayedWriteTimer.expires_from_now(boost::posix_time::milliseconds(0));
-        m_delayedWriteTimer.async_wait(std::bind(&Connection::onCanWrite, asConnection(), std::placeholders::_1));
+        internal_write();
     }
-
-    std::ostream os(m_outputStream.get());
-    os.write((const char*)buffer, size);
-    os.flush();
 }
 
 void Connection::internal_write()
 {
-    if(!m_connected)
+    if(!m_connected || m_outputSize == 0)
         return;
 
-    std::shared_ptr<asio::streambuf> outputStream = m_outputStream;
-    m_outputStream = nullptr;
+    // one write at a time, anything appended meanwhile goes out when it completes
+    if(m_writeInFlight) {
+        m_writePending = true;
+        return;
+    }
+
+    // both buffers stay with the connection, so steady traffic keeps reusing the same two
+    m_writeBuffer.swap(m_outputBuffer);
+    const size_t writeSize = m_outputSize;
+    m_outputSize = 0;
+    m_writeSize = writeSize;
+    m_writeInFlight = true;
+    m_writePending = false;
+    updateQueuedBytes();
+
+    m_writeCount++;
+    m_writtenBytes += writeSize;
+    m_writtenMessages += m_batchedMessages;
+    m_batchedMessages = 0;
 
     asio::async_write(m_socket,
-                      *outputStream,
-                      std::bind(&Connection::onWrite, asConnection(), std::placeholders::_1, std::placeholders::_2, outputStream));
+                      asio::buffer(m_writeBuffer.data(), writeSize),
+                      [ref = handlerRef()](const boost::system::error_code& error, size_t writeSize) { ref->onWrite(error, writeSize); });
 
     m_writeTimer.cancel();
     m_writeTimer.expires_from_now(boost::posix_time::seconds(static_cast<uint32>(WRITE_TIMEOUT)));
-    m_writeTimer.async_wait(std::bind(&Connection::onTimeout, asConnection(), std::placeholders::_1));
+    m_writeTimer.async_wait([ref = handlerRef()](const boost::system::error_code& error) { ref->onTimeout(error); });
 }
 
 void Connection::read(uint16 bytes, const RecvCallback& callback)
@@ -161,13 +520,47 @@ void Connection::read(uint16 bytes, const RecvCallback& callback)
 
     m_recvCallback = callback;
 
+    if(g_networkThreadEnabled)
+        postToNetwork([ref = handlerRef(), bytes] { ref->internal_read(bytes); });
+    else
+        internal_read(bytes);
+}
+
+void Connection::internal_read(uint16 bytes)
+{
+    if(!m_connected)
+        return;
+
     asio::async_read(m_socket,
                      asio::buffer(m_inputStream.prepare(bytes)),
-                     std::bind(&Connection::onRecv, asConnection(), std::placeholders::_1, std::placeholders::_2));
+                     [ref = handlerRef()](const boost::system::error_code& error, size_t recvSize) { ref->onRecv(error, recvSize); });
 
-    m_readTimer.cancel();
-    m_readTimer.expires_from_now(boost::posix_time::seconds(static_cast<uint32>(READ_TIMEOUT)));
-    m_readTimer.async_wait(std::bind(&Connection::onTimeout, asConnection(), std::placeholders::_1));
+    restartReadTimer();
+}
+
+void Connection::read(const ReceiveBufferPtr& buffer, uint16 offset, uint16 bytes, const RecvCallback& callback)
+{
+    if(!m_connected)
+        return;
+
+    m_recvCallback = callback;
+
+    if(g_networkThreadEnabled)
+        postToNetwork([ref = handlerRef(), buffer, offset, bytes] { ref->internal_read(buffer, offset, bytes); });
+    else
+        internal_read(buffer, offset, bytes);
+}
+
+void Connection::internal_read(const ReceiveBufferPtr& buffer, uint16 offset, uint16 bytes)
+{
+    if(!m_connected)
+        return;
+
+    asio::async_read(m_socket,
+                     asio::buffer(buffer->data() + offset, bytes),
+                     [ref = handlerRef(), buffer, offset](const boost::system::error_code& error, size_t recvSize) { ref->onRecvInto(error, buffer, offset, recvSize); });
+
+    restartReadTimer();
 }
 
 void Connection::read_until(const std::string& what, const RecvCallback& callback)
@@ -177,14 +570,23 @@ void Connection::read_until(const std::string& what, const RecvCallback& callbac
 
     m_recvCallback = callback;
 
+    if(g_networkThreadEnabled)
+        postToNetwork([ref = handlerRef(), what] { ref->internal_read_until(what); });
+    else
+        internal_read_until(what);
+}
+
+void Connection::internal_read_until(const std::string& what)
+{
+    if(!m_connected)
+        return;
+
     asio::async_read_until(m_socket,
                            m_inputStream,
                            what,
-                           std::bind(&Connection::onRecv, asConnection(), std::placeholders::_1, std::placeholders::_2));
+                           [ref = handlerRef()](const boost::system::error_code& error, size_t recvSize) { ref->onRecv(error, recvSize); });
 
-    m_readTimer.cancel();
-    m_readTimer.expires_from_now(boost::posix_time::seconds(static_cast<uint32>(READ_TIMEOUT)));
-    m_readTimer.async_wait(std::bind(&Connection::onTimeout, asConnection(), std::placeholders::_1));
+    restartReadTimer();
 }
 
 void Connection::read_some(const RecvCallback& callback)
@@ -194,12 +596,78 @@ void Connection::read_some(const RecvCallback& callback)
 
     m_recvCallback = callback;
 
+    if(g_networkThreadEnabled)
+        postToNetwork([ref = handlerRef()] { ref->internal_read_some(); });
+    else
+        internal_read_some();
+}
+
+void Connection::internal_read_some()
+{
+    if(!m_connected)
+        return;
+
+    // bytes read past a read_until delimiter are handed out before touching the socket again
+    if(m_inputStream.size() > 0) {
+        g_ioService.post([ref = handlerRef()] { ref->onRecvSome(boost::system::error_code(), 0); });
+        return;
+    }
+
     m_socket.async_read_some(asio::buffer(m_inputStream.prepare(RECV_BUFFER_SIZE)),
-                             std::bind(&Connection::onRecv, asConnection(), std::placeholders::_1, std::placeholders::_2));
+                             [ref = handlerRef()](const boost::system::error_code& error, size_t recvSize) { ref->onRecvSome(error, recvSize); });
 
-    m_readTimer.cancel();
-    m_readTimer.expires_from_now(boost::posix_time::seconds(static_cast<uint32>(READ_TIMEOUT)));
-    m_readTimer.async_wait(std::bind(&Connection::onTimeout, asConnection(), std::placeholders::_1));
+    restartReadTimer();
+}
+
+void Connection::readFrame(bool readAhead, uint16 offset, const FrameDecoder& decoder, const FrameCallback& callback)
+{
+    if(!m_connected)
+        return;
+
+    m_frameCallback = callback;
+
+    if(!m_readyFrames.empty()) {
+        if(!m_deliveringFrames)
+            g_dispatcher.addCriticalEvent([self = asConnection()] { self->deliverFrames(); });
+        return;
+    }
+
+    // once read ahead started the network thread keeps reading on its own
+    if(m_readAheadStarted)
+        return;
+    m_readAheadStarted = readAhead;
+
+    if(g_networkThreadEnabled)
+        postToNetwork([ref = handlerRef(), readAhead, offset, decoder] { ref->internal_readFrames(readAhead, offset, decoder); });
+    else
+        internal_readFrames(readAhead, offset, decoder);
+}
+
+void Connection::internal_readFrames(bool readAhead, uint16 offset, const FrameDecoder& decoder)
+{
+    m_frameDecoder = decoder;
+    m_frameOffset = offset;
+    m_readAhead = readAhead;
+    if(m_readingFrames)
+        return;
+
+    m_readingFrames = true;
+    internal_readFrameHeader();
+}
+
+void Connection::internal_readFrameHeader()
+{
+    if(!m_connected) {
+        m_readingFrames = false;
+        return;
+    }
+
+    m_frameBuffer = ReceiveBuffer::acquire();
+    asio::async_read(m_socket,
+                     asio::buffer(m_frameBuffer->data() + m_frameOffset, 2),
+                     [ref = handlerRef()](const boost::system::error_code& error, size_t) { ref->onFrameHeader(error); });
+
+    restartReadTimer();
 }
 
 void Connection::onResolve(const boost::system::error_code& error, asio::ip::basic_resolver<asio::ip::tcp>::iterator endpointIterator)
@@ -209,16 +677,44 @@ void Connection::onResolve(const boost::system::error_code& error, asio::ip::bas
     if(error == asio::error::operation_aborted)
         return;
 
-    if(!error)
-        internal_connect(endpointIterator);
-    else
+    if(error) {
         handleError(error);
+        return;
+    }
+
+    // interleave the address families, starting with whichever the resolver put first
+    std::vector<asio::ip::tcp::endpoint> primary, secondary;
+    for(asio::ip::tcp::resolver::iterator end; endpointIterator != end; ++endpointIterator) {
+        const asio::ip::tcp::endpoint endpoint = *endpointIterator;
+        if(primary.empty() || primary.front().protocol() == endpoint.protocol())
+            primary.push_back(endpoint);
+        else
+            secondary.push_back(endpoint);
+    }
+
+    std::vector<asio::ip::tcp::endpoint> endpoints;
+    for(size_t i = 0; i < std::max(primary.size(), secondary.size()); ++i) {
+        if(i < primary.size())
+            endpoints.push_back(primary[i]);
+        if(i < secondary.size())
+            endpoints.push_back(secondary[i]);
+    }
+
+    if(endpoints.empty()) {
+        handleError(asio::error::host_not_found);
+        return;
+    }
+
+    if(g_dnsCacheTtl > 0)
+        g_dnsCache[m_resolveKey] = { endpoints, stdext::millis() + g_dnsCacheTtl * 1000 };
+    internal_connect(endpoints);
 }
 
 void Connection::onConnect(const boost::system::error_code& error)
 {
     m_readTimer.cancel();
-    m_activityTimer.restart();
+    if(!g_networkThreadEnabled)
+        m_activityTimer.restart();
 
     if(error == asio::error::operation_aborted)
         return;
@@ -229,9 +725,9 @@ void Connection::onConnect(const boost::system::error_code& error)
         // disable nagle's algorithm, this make the game play smoother
         boost::asio::ip::tcp::no_delay option(true);
         m_socket.set_option(option);
+        enableQuickAck();
 
-        if(m_connectCallback)
-            m_connectCallback();
+        notifyConnect();
     } else
         handleError(error);
 
@@ -249,35 +745,38 @@ void Connection::onCanWrite(const boost::system::error_code& error)
         internal_write();
 }
 
-void Connection::onWrite(const boost::system::error_code& error, size_t, std::shared_ptr<asio::streambuf> outputStream)
+void Connection::onWrite(const boost::system::error_code& error, size_t)
 {
     m_writeTimer.cancel();
+    m_writeInFlight = false;
+    updateQueuedBytes();
 
     if(error == asio::error::operation_aborted)
         return;
 
-    // free output stream and store for using it again later
-    outputStream->consume(outputStream->size());
-    m_outputStreams.push_back(outputStream);
-
-    if(m_connected && error)
+    if(m_connected && error) {
         handleError(error);
+        return;
+    }
+
+    if(m_writePending)
+        internal_write();
 }
 
 void Connection::onRecv(const boost::system::error_code& error, size_t recvSize)
 {
     m_readTimer.cancel();
-    m_activityTimer.restart();
+    if(!g_networkThreadEnabled)
+        m_activityTimer.restart();
 
     if(error == asio::error::operation_aborted)
         return;
 
     if(m_connected) {
         if(!error) {
-            if(m_recvCallback) {
-                const char* header = boost::asio::buffer_cast<const char*>(m_inputStream.data());
-                m_recvCallback((uint8*)header, recvSize);
-            }
+            m_readBytes += recvSize;
+            const char* header = boost::asio::buffer_cast<const char*>(m_inputStream.data());
+            notifyRecv((uint8*)header, recvSize);
         } else
             handleError(error);
     }
@@ -286,6 +785,190 @@ void Connection::onRecv(const boost::system::error_code& error, size_t recvSize)
         m_inputStream.consume(recvSize);
 }
 
+void Connection::onRecvSome(const boost::system::error_code& error, size_t recvSize)
+{
+    m_readTimer.cancel();
+    if(!g_networkThreadEnabled)
+        m_activityTimer.restart();
+
+    if(error == asio::error::operation_aborted)
+        return;
+
+    if(!m_connected)
+        return;
+
+    if(error) {
+        handleError(error);
+        return;
+    }
+
+    // the callback size is 16 bits, anything beyond that waits for the next read_some
+    m_readBytes += recvSize;
+    m_inputStream.commit(recvSize);
+    const size_t size = std::min<size_t>(m_inputStream.size(), std::numeric_limits<uint16>::max());
+    notifyRecv((uint8*)boost::asio::buffer_cast<const char*>(m_inputStream.data()), size);
+    m_inputStream.consume(size);
+}
+
+void Connection::onFrameHeader(const boost::system::error_code& error)
+{
+    m_readTimer.cancel();
+
+    if(error == asio::error::operation_aborted || !m_connected) {
+        m_readingFrames = false;
+        return;
+    }
+
+    if(error) {
+        m_readingFrames = false;
+        handleError(error);
+        return;
+    }
+
+    const uint16 size = stdext::readULE16(m_frameBuffer->data() + m_frameOffset);
+    if(m_frameOffset + 2 + size > ReceiveBuffer::SIZE) {
+        m_readingFrames = false;
+        handleError(asio::error::message_size);
+        return;
+    }
+
+    m_frameSize = 2 + size;
+    asio::async_read(m_socket,
+                     asio::buffer(m_frameBuffer->data() + m_frameOffset + 2, size),
+                     [ref = handlerRef()](const boost::system::error_code& error, size_t) { ref->onFrameData(error); });
+
+    restartReadTimer();
+}
+
+void Connection::onFrameData(const boost::system::error_code& error)
+{
+    m_readTimer.cancel();
+
+    if(error == asio::error::operation_aborted || !m_connected) {
+        m_readingFrames = false;
+        return;
+    }
+
+    if(error) {
+        m_readingFrames = false;
+        handleError(error);
+        return;
+    }
+
+    ReceiveBufferPtr frame = std::move(m_frameBuffer);
+    const uint16 frameSize = m_frameSize;
+    m_readBytes += frameSize;
+    const char* decodeError = m_frameDecoder ? m_frameDecoder(frame->data() + m_frameOffset, frameSize) : nullptr;
+
+    // the next read goes out before the frame is handed over, a failed frame stops reading like recv does
+    m_readingFrames = m_readAhead && !decodeError;
+    if(m_readingFrames)
+        internal_readFrameHeader();
+
+    if(g_networkThreadEnabled)
+        postToMain([ref = handlerRef(), frame = std::move(frame), frameSize, decodeError]() mutable { ref->onFrame(frame, frameSize, decodeError); });
+    else
+        onFrame(frame, frameSize, decodeError);
+}
+
+void Connection::onFrame(ReceiveBufferPtr& buffer, uint16 size, const char* error)
+{
+    if(m_closed)
+        return;
+
+    m_activityTimer.restart();
+
+    if(error) {
+        g_logger.traceError(error);
+        m_readAheadStarted = false;
+        return;
+    }
+
+    m_readyFrames.emplace_back(std::move(buffer), size);
+    deliverFrames();
+}
+
+void Connection::deliverFrames()
+{
+    if(m_deliveringFrames)
+        return;
+
+    // callbacks usually ask for the next frame right away, keep going here instead of recursing
+    m_deliveringFrames = true;
+    while(m_frameCallback && !m_readyFrames.empty()) {
+        const FrameCallback callback = std::move(m_frameCallback);
+        m_frameCallback = nullptr;
+
+        const auto frame = std::move(m_readyFrames.front());
+        m_readyFrames.pop_front();
+        callback(frame.first, frame.second);
+    }
+    m_deliveringFrames = false;
+}
+
+void Connection::notifyConnect()
+{
+    if(!g_networkThreadEnabled) {
+        if(m_connectCallback)
+            m_connectCallback();
+        return;
+    }
+
+    postToMain([ref = handlerRef()] {
+        ref->m_activityTimer.restart();
+        if(ref->m_connectCallback)
+            ref->m_connectCallback();
+    });
+}
+
+void Connection::notifyRecv(uint8* buffer, uint16 size)
+{
+    if(!g_networkThreadEnabled) {
+        if(m_recvCallback)
+            m_recvCallback(buffer, size);
+        return;
+    }
+
+    postToMain([ref = handlerRef(), data = std::vector<uint8>(buffer, buffer + size)]() mutable {
+        ref->m_activityTimer.restart();
+        if(ref->m_recvCallback)
+            ref->m_recvCallback(data.data(), data.size());
+    });
+}
+
+void Connection::onRecvInto(const boost::system::error_code& error, const ReceiveBufferPtr& buffer, uint16 offset, size_t recvSize)
+{
+    m_readTimer.cancel();
+    if(!g_networkThreadEnabled)
+        m_activityTimer.restart();
+
+    if(error == asio::error::operation_aborted)
+        return;
+
+    if(!m_connected)
+        return;
+
+    if(error) {
+        handleError(error);
+        return;
+    }
+
+    m_readBytes += recvSize;
+
+    // the data is already where the caller wants it, only the notification crosses threads
+    if(!g_networkThreadEnabled) {
+        if(m_recvCallback)
+            m_recvCallback(buffer->data() + offset, recvSize);
+        return;
+    }
+
+    postToMain([ref = handlerRef(), buffer, offset, recvSize] {
+        ref->m_activityTimer.restart();
+        if(ref->m_recvCallback)
+            ref->m_recvCallback(buffer->data() + offset, recvSize);
+    });
+}
+
 void Connection::onTimeout(const boost::system::error_code& error)
 {
     if(error == asio::error::operation_aborted)
@@ -299,6 +982,17 @@ void Connection::handleError(const boost::system::error_code& error)
     if(error == asio::error::operation_aborted)
         return;
 
+    // in threaded mode the error and the callbacks belong to the main thread, it closes from there
+    if(g_networkThreadEnabled) {
+        postToMain([ref = handlerRef(), error] {
+            ref->m_error = error;
+            if(ref->m_errorCallback)
+                ref->m_errorCallback(error);
+            ref->close();
+        });
+        return;
+    }
+
     m_error = error;
     if(m_errorCallback)
         m_errorCallback(error);
@@ -24,18 +24,27 @@
 #define CONNECTION_H
 
 #include "declarations.h"
+#include "bufferpool.h"
 #include <framework/luaengine/luaobject.h>
 #include <framework/core/timer.h>
 #include <framework/core/declarations.h>
 
+#include <atomic>
+#include <deque>
+
 class Connection : public LuaObject
 {
     typedef std::function<void(const boost::system::error_code&)> ErrorCallback;
     typedef std::function<void(uint8*, uint16)> RecvCallback;
+    // checks and decodes a whole frame in place, returns an error message or nullptr, runs on the network thread
+    typedef std::function<const char* (uint8*, size_t)> FrameDecoder;
+    // the frame starts at the offset given to readFrame
+    typedef std::function<void(const ReceiveBufferPtr&, uint16)> FrameCallback;
 
     enum {
         READ_TIMEOUT = 30,
         WRITE_TIMEOUT = 30,
+        CONNECTION_ATTEMPT_DELAY = 250, // milliseconds before racing the next endpoint
         SEND_BUFFER_SIZE = 65536,
         RECV_BUFFER_SIZE = 65536
     };
@@ -47,15 +56,41 @@ public:
     static void poll();
     static void terminate();
 
+    // runs the io service on its own thread, can only be switched while no connection or server exists
+    static bool setNetworkThreadEnabled(bool enable);
+    static bool isNetworkThreadEnabled();
+    // grows with every network handler run on the main thread, idle loops compare it to tell whether a poll did anything
+    static uint64 getPolledHandlerCount();
+
+    // resolved endpoints are reused by every connection to the same host and port for ttl seconds
+    static void setDnsCacheTtl(int seconds);
+    static void clearDnsCache();
+
     void connect(const std::string& host, uint16 port, const std::function<void()>& connectCallback);
     void close();
 
-    void write(uint8* buffer, size_t size);
+    // urgent writes go out right away, others wait up to the write batch delay to be coalesced
+    void write(uint8* buffer, size_t size, bool urgent = false);
     void read(uint16 bytes, const RecvCallback& callback);
+    // reads straight into buffer at offset, the buffer is held until the read completes
+    void read(const ReceiveBufferPtr& buffer, uint16 offset, uint16 bytes, const RecvCallback& callback);
     void read_until(const std::string& what, const RecvCallback& callback);
     void read_some(const RecvCallback& callback);
+    // reads one size prefixed frame into a pooled buffer at offset,
+    // with readAhead the next frames are read and decoded before they are asked for
+    void readFrame(bool readAhead, uint16 offset, const FrameDecoder& decoder, const FrameCallback& callback);
 
     void setErrorCallback(const ErrorCallback& errorCallback) { m_errorCallback = errorCallback; }
+    void setWriteBatchDelay(int micros) { m_writeBatchDelay = std::max<int>(micros, 0); }
+    int getWriteBatchDelay() { return m_writeBatchDelay; }
+
+    uint64 getWriteCount() { return m_writeCount; }
+    uint64 getWrittenBytes() { return m_writtenBytes; }
+    // messages per socket write
+    double getAverageWriteBatch() { return m_writeCount > 0 ? m_writtenMessages / (double)m_writeCount : 0; }
+    uint64 getReadBytes() { return m_readBytes; }
+    // bytes appended but not yet written to the socket, the write in flight included
+    uint64 getQueuedBytes() { return m_queuedBytes; }
 
     int getIp();
     boost::system::error_code getError() { return m_error; }
@@ -66,19 +101,65 @@ public:
     ConnectionPtr asConnection() { return static_self_cast<Connection>(); }
 
 protected:
-    void internal_connect(asio::ip::basic_resolver<asio::ip::tcp>::iterator endpointIterator);
+    // keeps the connection alive while asio holds a handler, in threaded mode handlers only count
+    // themselves and the main thread holds the strong reference until the count drops to zero
+    class HandlerRef
+    {
+    public:
+        explicit HandlerRef(Connection* connection);
+        HandlerRef(const HandlerRef& other);
+        HandlerRef(HandlerRef&& other) noexcept;
+        ~HandlerRef();
+        HandlerRef& operator=(const HandlerRef&) = delete;
+        Connection* operator->() const { return m_connection; }
+
+    private:
+        ConnectionPtr m_ptr;
+        Connection* m_connection;
+    };
+
+    HandlerRef handlerRef() { return HandlerRef(this); }
+
+    static void postToNetwork(std::function<void()>&& task);
+    static void postToMain(std::function<void()>&& task);
+
+    void internal_resolve(const std::string& host, uint16 port);
+    void internal_close(bool flush);
+    void internal_append(const uint8* buffer, size_t size, bool urgent);
+    void internal_read(uint16 bytes);
+    void internal_read(const ReceiveBufferPtr& buffer, uint16 offset, uint16 bytes);
+    void internal_read_until(const std::string& what);
+    void internal_read_some();
+    void internal_readFrames(bool readAhead, uint16 offset, const FrameDecoder& decoder);
+    void internal_readFrameHeader();
+    void restartReadTimer();
+    void updateQueuedBytes() { m_queuedBytes = m_outputSize + (m_writeInFlight ? m_writeSize : 0); }
+    void enableQuickAck();
+    void notifyConnect();
+    void notifyRecv(uint8* buffer, uint16 size);
+    void onRecvInto(const boost::system::error_code& error, const ReceiveBufferPtr& buffer, uint16 offset, size_t recvSize);
+    void onFrameHeader(const boost::system::error_code& error);
+    void onFrameData(const boost::system::error_code& error);
+    void onFrame(ReceiveBufferPtr& buffer, uint16 size, const char* error);
+    void deliverFrames();
+
+    void internal_connect(const std::vector<asio::ip::tcp::endpoint>& endpoints);
+    void startNextAttempt();
+    void onAttemptConnect(const boost::system::error_code& error, size_t index);
     void internal_write();
     void onResolve(const boost::system::error_code& error, asio::ip::tcp::resolver::iterator endpointIterator);
     void onConnect(const boost::system::error_code& error);
     void onCanWrite(const boost::system::error_code& error);
-    void onWrite(const boost::system::error_code& error, size_t writeSize, std::shared_ptr<asio::streambuf> outputStream);
+    void onWrite(const boost::system::error_code& error, size_t writeSize);
     void onRecv(const boost::system::error_code& error, size_t recvSize);
+    void onRecvSome(const boost::system::error_code& error, size_t recvSize);
     void onTimeout(const boost::system::error_code& error);
     void handleError(const boost::system::error_code& error);
 
     std::function<void()> m_connectCallback;
     ErrorCallback m_errorCallback;
     RecvCallback m_recvCallback;
+    FrameCallback m_frameCallback;
 
     asio::deadline_timer m_readTimer;
     asio::deadline_timer m_writeTimer;
@@ -86,14 +167,53 @@ protected:
     asio::ip::tcp::resolver m_resolver;
     asio::ip::tcp::socket m_socket;
 
-    static std::list<std::shared_ptr<asio::streambuf>> m_outputStreams;
-    std::shared_ptr<asio::streambuf> m_outputStream;
+    // happy eyeballs, each endpoint gets its own socket and the first one to connect becomes m_socket
+    asio::deadline_timer m_attemptTimer;
+    std::string m_resolveKey;
+    std::vector<asio::ip::tcp::endpoint> m_endpoints;
+    std::vector<std::unique_ptr<asio::ip::tcp::socket>> m_attemptSockets;
+    size_t m_failedAttempts{ 0 };
+
+    // appended data waits in the output buffer, the write buffer is owned by the write in flight
+    PooledBuffer m_outputBuffer;
+    PooledBuffer m_writeBuffer;
+    size_t m_outputSize{ 0 };
+    size_t m_writeSize{ 0 };
+    uint64 m_batchedMessages{ 0 };
+    bool m_writeInFlight{ false };
+    bool m_writePending{ false };
+    std::atomic<int> m_writeBatchDelay{ 0 };
+    std::atomic<uint64> m_writeCount{ 0 };
+    std::atomic<uint64> m_writtenBytes{ 0 };
+    std::atomic<uint64> m_writtenMessages{ 0 };
+    std::atomic<uint64> m_readBytes{ 0 };
+    std::atomic<uint64> m_queuedBytes{ 0 };
     asio::streambuf m_inputStream;
-    bool m_connected;
-    bool m_connecting;
+    std::atomic<bool> m_connected;
+    std::atomic<bool> m_connecting;
     boost::system::error_code m_error;
     stdext::timer m_activityTimer;
 
+    // frames, owned by the network thread
+    FrameDecoder m_frameDecoder;
+    ReceiveBufferPtr m_frameBuffer;
+    uint16 m_frameOffset{ 0 };
+    uint16 m_frameSize{ 0 };
+    bool m_readAhead{ false };
+    bool m_readingFrames{ false };
+
+    // frames, owned by the main thread
+    std::deque<std::pair<ReceiveBufferPtr, uint16>> m_readyFrames;
+    bool m_readAheadStarted{ false };
+    bool m_deliveringFrames{ false };
+    bool m_closed{ false };
+
+    // threaded mode handler tracking
+    std::atomic<int> m_handlers{ 0 };
+    bool m_active{ false };
+
+    static int m_instances;
+
     friend class Server;
 };
 
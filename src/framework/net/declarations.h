@@ -34,13 +34,20 @@ class OutputMessage;
 class Connection;
 class Protocol;
 class ProtocolHttp;
+class HttpDownload;
+class HttpCache;
 class Server;
+class ReceiveBuffer;
 
 typedef stdext::shared_object_ptr<InputMessage> InputMessagePtr;
 typedef stdext::shared_object_ptr<OutputMessage> OutputMessagePtr;
 typedef stdext::shared_object_ptr<Connection> ConnectionPtr;
 typedef stdext::shared_object_ptr<Protocol> ProtocolPtr;
 typedef stdext::shared_object_ptr<ProtocolHttp> ProtocolHttpPtr;
+typedef stdext::shared_object_ptr<HttpDownload> HttpDownloadPtr;
+typedef stdext::shared_object_ptr<HttpCache> HttpCachePtr;
 typedef stdext::shared_object_ptr<Server> ServerPtr;
+// shared with the network thread, so it needs atomic reference counting
+typedef std::shared_ptr<ReceiveBuffer> ReceiveBufferPtr;
 
 #endif
@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "httpcache.h"
+#include <framework/core/application.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/filestream.h>
+
+HttpCache::HttpCache(const std::string& directory)
+{
+    m_directory = stdext::starts_with(directory, "/") ? directory : "/" + directory;
+    m_root = fs::path(g_resources.getWriteDir()) / m_directory.substr(1);
+    loadIndex();
+}
+
+HttpCache::~HttpCache()
+{
+#ifndef NDEBUG
+    assert(!g_app.isTerminated());
+#endif
+    cancel();
+}
+
+void HttpCache::fetch(const std::string& host, uint16 port, const std::map<std::string, std::string>& files, int connections)
+{
+    cancel();
+
+    boost::system::error_code error;
+    fs::create_directories(m_root / "blobs", error);
+    fs::create_directories(m_root / "temp", error);
+    fs::create_directories(m_root / "files", error);
+
+    m_host = host;
+    m_port = port;
+    m_requests.resize(std::max<int>(1, std::min<int>(connections, MAX_CONNECTIONS)));
+    m_downloaded = 0;
+    m_unchanged = 0;
+    m_failed = 0;
+    m_fetching = true;
+
+    for(const auto& it : files) {
+        std::string hash = it.second;
+        stdext::tolower(hash);
+        m_queue.emplace_back(it.first, hash);
+    }
+
+    // the callbacks never run before fetch returns, even when every file is already stored
+    const HttpCachePtr self = asHttpCache();
+    g_dispatcher.addEvent([self] { self->startNext(); });
+}
+
+void HttpCache::cancel()
+{
+    for(size_t slot = 0; slot < m_requests.size(); ++slot) {
+        Request& request = m_requests[slot];
+        if(!request.connection)
+            continue;
+
+        request.connection->close();
+        request.connection = nullptr;
+        if(request.file.is_open())
+            request.file.close();
+
+        boost::system::error_code error;
+        fs::remove(getTempPath(slot), error);
+    }
+
+    m_requests.clear();
+    m_queue.clear();
+    m_activeRequests = 0;
+    m_fetching = false;
+
+    if(m_indexChanged)
+        saveIndex();
+}
+
+bool HttpCache::mount(bool pushFront)
+{
+    if(m_mounted)
+        return true;
+
+    boost::system::error_code error;
+    fs::create_directories(m_root / "files", error);
+    m_mounted = g_resources.addSearchPath(getFilesDirectory(), pushFront);
+    return m_mounted;
+}
+
+bool HttpCache::unmount()
+{
+    if(!m_mounted || !g_resources.removeSearchPath(getFilesDirectory()))
+        return false;
+
+    m_mounted = false;
+    return true;
+}
+
+int HttpCache::prune()
+{
+    std::unordered_set<std::string> referenced;
+    for(const auto& it : m_entries)
+        referenced.insert(it.second.hash);
+
+    int removed = 0;
+    boost::system::error_code error;
+    for(fs::directory_iterator it(m_root / "blobs", error), end; !error && it != end; it.increment(error)) {
+        if(referenced.find(it->path().filename().string()) != referenced.end())
+            continue;
+
+        boost::system::error_code removeError;
+        if(fs::remove(it->path(), removeError))
+            ++removed;
+    }
+    return removed;
+}
+
+std::string HttpCache::getFileHash(const std::string& path)
+{
+    const auto it = m_entries.find(path);
+    return it != m_entries.end() ? it->second.hash : std::string();
+}
+
+void HttpCache::loadIndex()
+{
+    const std::string indexFile = m_directory + "/index.bin";
+    if(!g_resources.fileExists(indexFile))
+        return;
+
+    try {
+        const FileStreamPtr fin = g_resources.openFile(indexFile);
+        if(fin->getU32() != INDEX_SIGNATURE || fin->getU16() != INDEX_VERSION) {
+            fin->close();
+            return;
+        }
+
+        const uint32 count = fin->getU32();
+        for(uint32 i = 0; i < count; ++i) {
+            const std::string path = fin->getString();
+            Entry& entry = m_entries[path];
+            entry.hash = fin->getString();
+            entry.etag = fin->getString();
+            entry.lastModified = fin->getString();
+            entry.size = fin->getU64();
+        }
+        fin->close();
+    } catch(stdext::exception& e) {
+        // the files are downloaded again without validators
+        g_logger.error(stdext::format("Unable to load http cache index '%s': %s", indexFile, e.what()));
+        m_entries.clear();
+    }
+}
+
+void HttpCache::saveIndex()
+{
+    const std::string indexFile = m_directory + "/index.bin";
+    try {
+        const FileStreamPtr fout = g_resources.createFile(indexFile);
+        fout->addU32(INDEX_SIGNATURE);
+        fout->addU16(INDEX_VERSION);
+        fout->addU32(m_entries.size());
+        for(const auto& it : m_entries) {
+            fout->addString(it.first);
+            fout->addString(it.second.hash);
+            fout->addString(it.second.etag);
+            fout->addString(it.second.lastModified);
+            fout->addU64(it.second.size);
+        }
+        fout->flush();
+        fout->close();
+        m_indexChanged = false;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to save http cache index '%s': %s", indexFile, e.what()));
+    }
+}
+
+bool HttpCache::linkFile(const std::string& path, const std::string& hash)
+{
+    const fs::path relative = fs::path(stdext::starts_with(path, "/") ? path.substr(1) : path);
+    for(const fs::path& component : relative) {
+        if(component == "..")
+            return false;
+    }
+
+    const fs::path target = m_root / "files" / relative;
+    boost::system::error_code error;
+    fs::create_directories(target.parent_path(), error);
+    fs::remove(target, error);
+
+    // blobs are never written once stored, so a link can't see its contents change
+    fs::create_hard_link(getBlobPath(hash), target, error);
+    if(error) {
+        error.clear();
+        fs::copy_file(getBlobPath(hash), target, error);
+    }
+    return !error;
+}
+
+bool HttpCache::isCached(const std::string& path)
+{
+    const auto it = m_entries.find(path);
+    if(it == m_entries.end())
+        return false;
+
+    boost::system::error_code error;
+    const fs::path relative = fs::path(stdext::starts_with(path, "/") ? path.substr(1) : path);
+    return fs::exists(getBlobPath(it->second.hash), error) && fs::exists(m_root / "files" / relative, error);
+}
+
+void HttpCache::startNext()
+{
+    while(m_fetching && !m_queue.empty()) {
+        const std::pair<std::string, std::string> file = m_queue.front();
+        const std::string& path = file.first;
+        const std::string& expectedHash = file.second;
+
+        // contents the manifest names by hash are taken from any path that stored them
+        boost::system::error_code error;
+        if(!expectedHash.empty() && fs::exists(getBlobPath(expectedHash), error)) {
+            m_queue.pop_front();
+
+            Entry& entry = m_entries[path];
+            if(entry.hash != expectedHash || !isCached(path)) {
+                if(!linkFile(path, expectedHash)) {
+                    m_entries.erase(path);
+                    ++m_failed;
+                    callLuaField("onError", path, "unable to link the stored file");
+                    continue;
+                }
+                // the validators belonged to the old contents
+                entry = Entry();
+                entry.hash = expectedHash;
+                entry.size = fs::file_size(getBlobPath(expectedHash), error);
+                m_indexChanged = true;
+            }
+
+            ++m_unchanged;
+            callLuaField("onFile", path, false);
+            continue;
+        }
+
+        if(m_activeRequests >= (int)m_requests.size())
+            break;
+
+        for(size_t slot = 0; slot < m_requests.size(); ++slot) {
+            if(!m_requests[slot].connection) {
+                m_queue.pop_front();
+                startRequest(slot, path, expectedHash);
+                break;
+            }
+        }
+    }
+
+    if(m_fetching && m_queue.empty() && m_activeRequests == 0) {
+        m_fetching = false;
+        if(m_indexChanged)
+            saveIndex();
+        if(m_mounted)
+            g_resources.invalidatePathIndex();
+        callLuaField("onFinish", m_downloaded, m_unchanged, m_failed);
+    }
+}
+
+void HttpCache::startRequest(size_t slot, const std::string& path, const std::string& expectedHash)
+{
+    Request& request = m_requests[slot];
+    request.connection = ConnectionPtr(new Connection);
+    request.path = path;
+    request.expectedHash = expectedHash;
+    request.hash = Sha256();
+    request.response = HttpDownload::ResponseHeader();
+    request.received = 0;
+    ++m_activeRequests;
+
+    const HttpCachePtr self = asHttpCache();
+    Connection* connection = request.connection.get();
+    connection->setErrorCallback([self, slot, connection](const boost::system::error_code& error) { self->onRequestError(slot, connection, error); });
+    connection->connect(m_host, m_port, [self, slot, connection] {
+        if(!self->isCurrent(slot, connection))
+            return;
+
+        const Request& request = self->m_requests[slot];
+        std::string message = stdext::format("GET %s HTTP/1.1\r\nHost: %s\r\nAccept: */*\r\nConnection: close\r\n", request.path, self->m_host);
+        if(self->isCached(request.path)) {
+            const Entry& entry = self->m_entries[request.path];
+            if(!entry.etag.empty())
+                message += "If-None-Match: " + entry.etag + "\r\n";
+            if(!entry.lastModified.empty())
+                message += "If-Modified-Since: " + entry.lastModified + "\r\n";
+        }
+        message += "\r\n";
+        connection->write((uint8*)message.c_str(), message.length());
+        connection->read_until("\r\n\r\n", [self, slot, connection](uint8* buffer, uint16 size) { self->onHeader(slot, connection, buffer, size); });
+    });
+}
+
+void HttpCache::onHeader(size_t slot, Connection* connection, uint8* buffer, uint16 size)
+{
+    if(!isCurrent(slot, connection))
+        return;
+
+    Request& request = m_requests[slot];
+    try {
+        if(!HttpDownload::parseHeader(std::string((char*)buffer, size), request.response))
+            return finishRequest(slot, "invalid http response", false);
+    } catch(stdext::exception& e) {
+        return finishRequest(slot, stdext::format("invalid http response: %s", e.what()), false);
+    }
+
+    const HttpDownload::ResponseHeader& response = request.response;
+    if(response.status == 304 && isCached(request.path))
+        return finishRequest(slot, std::string(), false);
+    if(response.status != 200)
+        return finishRequest(slot, stdext::format("http status %d", response.status), false);
+    if(response.chunked)
+        return finishRequest(slot, "chunked http responses are not supported", false);
+
+    request.file.open(getTempPath(slot).string(), std::ios::binary | std::ios::trunc);
+    if(!request.file)
+        return finishRequest(slot, "unable to create the temporary file", false);
+
+    if(response.contentLength == 0)
+        return completeRequest(slot);
+    connection->read_some([self = asHttpCache(), slot, connection](uint8* buffer, uint16 size) { self->onData(slot, connection, buffer, size); });
+}
+
+void HttpCache::onData(size_t slot, Connection* connection, uint8* buffer, uint16 size)
+{
+    if(!isCurrent(slot, connection))
+        return;
+
+    Request& request = m_requests[slot];
+    const int64 length = request.response.contentLength;
+    uint16 writeSize = size;
+    if(length >= 0)
+        writeSize = std::min<uint64>(size, length - request.received);
+
+    // hashed while it arrives, the finished file is never read back
+    if(!request.file.write((const char*)buffer, writeSize))
+        return finishRequest(slot, "unable to write the temporary file", false);
+    request.hash.update(buffer, writeSize);
+    request.received += writeSize;
+
+    if(length >= 0 && request.received >= (uint64)length)
+        completeRequest(slot);
+    else
+        connection->read_some([self = asHttpCache(), slot, connection](uint8* buffer, uint16 size) { self->onData(slot, connection, buffer, size); });
+}
+
+void HttpCache::onRequestError(size_t slot, Connection* connection, const boost::system::error_code& error)
+{
+    if(!isCurrent(slot, connection))
+        return;
+
+    // without a known size the body ends with the connection
+    const Request& request = m_requests[slot];
+    if(error == asio::error::eof && request.file.is_open() && request.response.contentLength < 0)
+        completeRequest(slot);
+    else
+        finishRequest(slot, error.message(), false);
+}
+
+void HttpCache::completeRequest(size_t slot)
+{
+    Request& request = m_requests[slot];
+    request.file.close();
+    if(!request.file)
+        return finishRequest(slot, "unable to write the temporary file", false);
+
+    const std::string hash = request.hash.finish();
+    if(!request.expectedHash.empty() && hash != request.expectedHash)
+        return finishRequest(slot, stdext::format("sha-256 mismatch, expected %s and received %s", request.expectedHash, hash), false);
+
+    // another path may have stored the same contents already
+    boost::system::error_code error;
+    const fs::path blob = getBlobPath(hash);
+    if(fs::exists(blob, error))
+        fs::remove(getTempPath(slot), error);
+    else
+        fs::rename(getTempPath(slot), blob, error);
+    if(error)
+        return finishRequest(slot, error.message(), false);
+
+    if(!linkFile(request.path, hash))
+        return finishRequest(slot, "unable to link the stored file", false);
+
+    Entry& entry = m_entries[request.path];
+    entry.hash = hash;
+    entry.etag = request.response.etag;
+    entry.lastModified = request.response.lastModified;
+    entry.size = request.received;
+    m_indexChanged = true;
+    finishRequest(slot, std::string(), true);
+}
+
+void HttpCache::finishRequest(size_t slot, const std::string& error, bool downloaded)
+{
+    Request& request = m_requests[slot];
+    request.connection->close();
+    request.connection = nullptr;
+    if(request.file.is_open())
+        request.file.close();
+    if(!error.empty()) {
+        boost::system::error_code removeError;
+        fs::remove(getTempPath(slot), removeError);
+    }
+    --m_activeRequests;
+
+    // lua may cancel or start another fetch from here
+    const std::string path = request.path;
+    if(!error.empty()) {
+        ++m_failed;
+        callLuaField("onError", path, error);
+    } else if(downloaded) {
+        ++m_downloaded;
+        callLuaField("onFile", path, true);
+    } else {
+        ++m_unchanged;
+        callLuaField("onFile", path, false);
+    }
+
+    startNext();
+}
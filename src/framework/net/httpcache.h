@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef HTTPCACHE_H
+#define HTTPCACHE_H
+
+#include "declarations.h"
+#include "httpdownload.h"
+
+#include <framework/core/resourcemanager.h>
+#include <framework/luaengine/luaobject.h>
+#include <framework/util/crypt.h>
+
+// keeps http files in a directory of the write directory, stored once per sha-256 of their contents.
+// files listed with the hash the manifest expects are not requested at all when a blob with that hash is
+// stored, the others are revalidated with the ETag and Last-Modified the server sent, so unchanged files
+// cost a 304. the files are linked under their request paths in files/, which mount() adds as a search path.
+// calls onFile(path, downloaded), onError(path, message) and onFinish(downloaded, unchanged, failed) on the lua object
+// @bindclass
+class HttpCache : public LuaObject
+{
+    enum {
+        INDEX_SIGNATURE = 0x48435849,
+        INDEX_VERSION = 1,
+        MAX_CONNECTIONS = 16
+    };
+
+public:
+    HttpCache(const std::string& directory);
+    ~HttpCache();
+
+    // files maps request paths to the sha-256 the manifest lists for them, empty when it has none,
+    // paths are the keys of the cache so each server gets its own directory
+    void fetch(const std::string& host, uint16 port, const std::map<std::string, std::string>& files, int connections);
+    void cancel();
+
+    bool mount(bool pushFront);
+    bool unmount();
+    // deletes the blobs no request path refers to anymore, returns how many
+    int prune();
+
+    bool isFetching() { return !m_queue.empty() || m_activeRequests > 0; }
+    std::string getFileHash(const std::string& path);
+    std::string getFilesDirectory() { return (m_root / "files").string(); }
+    int getFileCount() { return m_entries.size(); }
+
+    HttpCachePtr asHttpCache() { return static_self_cast<HttpCache>(); }
+
+private:
+    struct Entry {
+        std::string hash;
+        std::string etag;
+        std::string lastModified;
+        uint64 size = 0;
+    };
+
+    struct Request {
+        ConnectionPtr connection;
+        std::string path;
+        std::string expectedHash;
+        std::ofstream file;
+        Sha256 hash;
+        HttpDownload::ResponseHeader response;
+        uint64 received = 0;
+    };
+
+    void loadIndex();
+    void saveIndex();
+    fs::path getBlobPath(const std::string& hash) { return m_root / "blobs" / hash; }
+    fs::path getTempPath(size_t slot) { return m_root / "temp" / stdext::format("%d", slot); }
+    // links the blob under the request path, copies it where the filesystem has no hard links
+    bool linkFile(const std::string& path, const std::string& hash);
+    bool isCached(const std::string& path);
+
+    void startNext();
+    void startRequest(size_t slot, const std::string& path, const std::string& expectedHash);
+    void onHeader(size_t slot, Connection* connection, uint8* buffer, uint16 size);
+    void onData(size_t slot, Connection* connection, uint8* buffer, uint16 size);
+    void onRequestError(size_t slot, Connection* connection, const boost::system::error_code& error);
+    void completeRequest(size_t slot);
+    void finishRequest(size_t slot, const std::string& error, bool downloaded);
+    bool isCurrent(size_t slot, Connection* connection) { return slot < m_requests.size() && m_requests[slot].connection.get() == connection && connection; }
+
+    std::string m_directory;
+    fs::path m_root;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::deque<std::pair<std::string, std::string>> m_queue;
+    std::vector<Request> m_requests;
+    std::string m_host;
+    uint16 m_port = 0;
+    int m_activeRequests = 0;
+    int m_downloaded = 0,
+        m_unchanged = 0,
+        m_failed = 0;
+    bool m_fetching = false;
+    bool m_indexChanged = false;
+    bool m_mounted = false;
+};
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "httpdownload.h"
+#include <framework/core/application.h>
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+HttpDownload::~HttpDownload()
+{
+#ifndef NDEBUG
+    assert(!g_app.isTerminated());
+#endif
+    cancel();
+}
+
+void HttpDownload::start(const std::string& host, uint16 port, const std::string& path, const std::string& fileName, int connections)
+{
+    cancel();
+
+    m_host = host;
+    m_port = port;
+    m_path = path;
+    m_fileName = fileName;
+    m_connections = std::max<int>(1, std::min<int>(connections, MAX_CONNECTIONS));
+    m_downloadedBytes = 0;
+    m_totalBytes = 0;
+    m_sizeKnown = false;
+    m_finished = false;
+
+    // the size and range support decide how the file is split
+    const HttpDownloadPtr self = asHttpDownload();
+    m_probe = ConnectionPtr(new Connection);
+    m_probe->setErrorCallback([self](const boost::system::error_code& error) { self->fail(error.message()); });
+    m_probe->connect(host, port, [self] {
+        if(!self->m_probe)
+            return;
+        self->sendRequest(self->m_probe, "HEAD", std::string());
+        self->m_probe->read_until("\r\n\r\n", std::bind(&HttpDownload::onProbeHeader, self, std::placeholders::_1, std::placeholders::_2));
+    });
+}
+
+void HttpDownload::cancel()
+{
+    if(m_probe) {
+        m_probe->close();
+        m_probe = nullptr;
+    }
+
+    // part files stay behind so the next start resumes them
+    for(Part& part : m_parts) {
+        if(part.connection) {
+            part.connection->close();
+            part.connection = nullptr;
+        }
+        if(part.file) {
+            part.file->close();
+            part.file = nullptr;
+        }
+    }
+    m_parts.clear();
+}
+
+bool HttpDownload::parseHeader(const std::string& header, ResponseHeader& response)
+{
+    std::vector<std::string> lines = stdext::split(header, "\r\n");
+    if(lines.empty())
+        return false;
+
+    std::vector<std::string> status = stdext::split(lines[0], " ");
+    if(status.size() < 2 || !stdext::starts_with(status[0], "HTTP/"))
+        return false;
+    response.status = stdext::safe_cast<int>(status[1]);
+
+    for(size_t i = 1; i < lines.size(); ++i) {
+        const size_t separator = lines[i].find(':');
+        if(separator == std::string::npos)
+            continue;
+
+        std::string name = lines[i].substr(0, separator);
+        std::string value = lines[i].substr(separator + 1);
+        stdext::tolower(name);
+        stdext::trim(value);
+
+        if(name == "content-length")
+            response.contentLength = stdext::safe_cast<int64>(value);
+        else if(name == "accept-ranges")
+            response.acceptRanges = value == "bytes";
+        else if(name == "etag")
+            response.etag = value;
+        else if(name == "last-modified")
+            response.lastModified = value;
+        else if(name == "transfer-encoding")
+            response.chunked = value.find("chunked") != std::string::npos;
+        else if(name == "content-range") {
+            const size_t slash = value.find('/');
+            if(slash != std::string::npos && value.substr(slash + 1) != "*")
+                response.rangeTotal = stdext::safe_cast<int64>(value.substr(slash + 1));
+        }
+    }
+    return true;
+}
+
+void HttpDownload::sendRequest(const ConnectionPtr& connection, const std::string& method, const std::string& range)
+{
+    std::string request = stdext::format("%s %s HTTP/1.1\r\nHost: %s\r\nAccept: */*\r\nConnection: close\r\n", method, m_path, m_host);
+    if(!range.empty())
+        request += "Range: " + range + "\r\n";
+    request += "\r\n";
+    connection->write((uint8*)request.c_str(), request.length());
+}
+
+void HttpDownload::onProbeHeader(uint8* buffer, uint16 size)
+{
+    if(m_probe) {
+        m_probe->close();
+        m_probe = nullptr;
+    }
+
+    ResponseHeader response;
+    try {
+        if(!parseHeader(std::string((char*)buffer, size), response))
+            return fail("invalid http response");
+    } catch(stdext::exception& e) {
+        return fail(stdext::format("invalid http response: %s", e.what()));
+    }
+
+    if(response.status != 200)
+        return fail(stdext::format("http status %d", response.status));
+
+    m_sizeKnown = response.contentLength >= 0 && !response.chunked;
+    m_totalBytes = m_sizeKnown ? response.contentLength : 0;
+
+    // without range support the whole body comes in one piece on one connection
+    const bool ranges = m_sizeKnown && response.acceptRanges;
+    int count = 1;
+    if(ranges)
+        count = std::max<int>(1, std::min<int64>(m_connections, m_totalBytes / MIN_PART_SIZE));
+
+    try {
+        startParts(count, ranges);
+    } catch(stdext::exception& e) {
+        return fail(e.what());
+    }
+
+    for(size_t i = 0; i < m_parts.size(); ++i) {
+        if(!m_parts[i].done)
+            startPart(i);
+    }
+
+    if(!m_parts.empty() && std::all_of(m_parts.begin(), m_parts.end(), [](const Part& part) { return part.done; }))
+        finish();
+}
+
+void HttpDownload::startParts(int count, bool resume)
+{
+    m_parts.resize(count);
+    for(int i = 0; i < count; ++i) {
+        Part& part = m_parts[i];
+        part.fileName = stdext::format("%s.part%dof%d", m_fileName, i + 1, count);
+        if(m_sizeKnown) {
+            part.start = m_totalBytes * i / count;
+            part.end = m_totalBytes * (i + 1) / count;
+        }
+
+        const uint64 length = part.end - part.start;
+        if(resume && g_resources.fileExists(part.fileName)) {
+            FileStreamPtr file = g_resources.openFile(part.fileName);
+            part.received = std::min<uint64>(file->size(), m_sizeKnown ? length : 0);
+            file->close();
+        }
+
+        m_downloadedBytes += part.received;
+        if(m_sizeKnown && part.received == length) {
+            part.done = true;
+            continue;
+        }
+
+        part.file = part.received > 0 ? g_resources.appendFile(part.fileName) : g_resources.createFile(part.fileName);
+    }
+}
+
+void HttpDownload::startPart(size_t index)
+{
+    const HttpDownloadPtr self = asHttpDownload();
+    ConnectionPtr connection(new Connection);
+    m_parts[index].connection = connection;
+
+    connection->setErrorCallback([self, index](const boost::system::error_code& error) { self->onPartError(index, error); });
+    connection->connect(m_host, m_port, [self, index] {
+        if(index >= self->m_parts.size() || !self->m_parts[index].connection)
+            return;
+
+        Part& part = self->m_parts[index];
+        std::string range;
+        if(self->isRanged(part))
+            range = stdext::format("bytes=%d-%d", part.start + part.received, part.end - 1);
+
+        self->sendRequest(part.connection, "GET", range);
+        part.connection->read_until("\r\n\r\n", [self, index](uint8* buffer, uint16 size) { self->onPartHeader(index, buffer, size); });
+    });
+}
+
+void HttpDownload::onPartHeader(size_t index, uint8* buffer, uint16 size)
+{
+    if(index >= m_parts.size() || !m_parts[index].connection)
+        return;
+
+    Part& part = m_parts[index];
+    ResponseHeader response;
+    try {
+        if(!parseHeader(std::string((char*)buffer, size), response))
+            return fail("invalid http response");
+    } catch(stdext::exception& e) {
+        return fail(stdext::format("invalid http response: %s", e.what()));
+    }
+
+    const bool ranged = isRanged(part);
+    if(response.chunked)
+        return fail("chunked http responses are not supported");
+    if(response.status != (ranged ? 206 : 200))
+        return fail(stdext::format("http status %d", response.status));
+    if(ranged && response.rangeTotal >= 0 && (uint64)response.rangeTotal != m_totalBytes)
+        return fail("remote file changed while downloading");
+
+    part.headerDone = true;
+    part.connection->read_some([self = asHttpDownload(), index](uint8* buffer, uint16 size) { self->onPartData(index, buffer, size); });
+}
+
+void HttpDownload::onPartData(size_t index, uint8* buffer, uint16 size)
+{
+    if(index >= m_parts.size() || !m_parts[index].connection)
+        return;
+
+    Part& part = m_parts[index];
+    uint16 writeSize = size;
+    if(m_sizeKnown)
+        writeSize = std::min<uint64>(size, part.end - part.start - part.received);
+
+    try {
+        part.file->write(buffer, writeSize);
+    } catch(stdext::exception& e) {
+        return fail(e.what());
+    }
+
+    part.received += writeSize;
+    m_downloadedBytes += writeSize;
+    const bool partDone = m_sizeKnown && part.received >= part.end - part.start;
+
+    // lua may cancel or restart the download from here
+    callLuaField("onProgress", m_downloadedBytes, m_totalBytes);
+    if(index >= m_parts.size() || !m_parts[index].connection)
+        return;
+
+    if(partDone)
+        finishPart(index);
+    else
+        m_parts[index].connection->read_some([self = asHttpDownload(), index](uint8* buffer, uint16 size) { self->onPartData(index, buffer, size); });
+}
+
+void HttpDownload::onPartError(size_t index, const boost::system::error_code& error)
+{
+    if(index >= m_parts.size() || !m_parts[index].connection)
+        return;
+
+    // without a known size the body ends with the connection
+    if(error == asio::error::eof && !m_sizeKnown && m_parts[index].headerDone)
+        finishPart(index);
+    else
+        fail(error.message());
+}
+
+void HttpDownload::finishPart(size_t index)
+{
+    Part& part = m_parts[index];
+    part.connection->close();
+    part.connection = nullptr;
+    part.file->close();
+    part.file = nullptr;
+    part.done = true;
+
+    if(std::all_of(m_parts.begin(), m_parts.end(), [](const Part& part) { return part.done; }))
+        finish();
+}
+
+void HttpDownload::finish()
+{
+    try {
+        // physfs can't rename, so the parts are copied into the final file
+        FileStreamPtr out = g_resources.createFile(m_fileName);
+        std::vector<uint8> buffer(COPY_BUFFER_SIZE);
+        for(const Part& part : m_parts) {
+            FileStreamPtr in = g_resources.openFile(part.fileName);
+            int read;
+            while((read = in->read(buffer.data(), 1, buffer.size())) > 0)
+                out->write(buffer.data(), read);
+            in->close();
+        }
+        out->close();
+    } catch(stdext::exception& e) {
+        return fail(e.what());
+    }
+
+    for(const Part& part : m_parts)
+        g_resources.deleteFile(part.fileName);
+    m_parts.clear();
+
+    m_finished = true;
+    callLuaField("onFinish");
+}
+
+void HttpDownload::fail(const std::string& message)
+{
+    cancel();
+    callLuaField("onError", message);
+}
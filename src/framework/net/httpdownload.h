@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HTTPDOWNLOAD_H
+#define HTTPDOWNLOAD_H
+
+#include "declarations.h"
+#include "connection.h"
+
+#include <framework/luaengine/luaobject.h>
+
+// streams a plain http download straight into a file of the write directory, the body never reaches lua.
+// each range goes to its own part file so an interrupted download resumes where every part stopped,
+// calls onProgress(downloaded, total), onFinish() and onError(message) on the lua object
+// @bindclass
+class HttpDownload : public LuaObject
+{
+    enum {
+        MAX_CONNECTIONS = 8,
+        MIN_PART_SIZE = 256 * 1024,
+        COPY_BUFFER_SIZE = 65536
+    };
+
+public:
+    ~HttpDownload();
+
+    void start(const std::string& host, uint16 port, const std::string& path, const std::string& fileName, int connections);
+    void cancel();
+
+    bool isFinished() { return m_finished; }
+    uint64 getDownloadedBytes() { return m_downloadedBytes; }
+    uint64 getTotalBytes() { return m_totalBytes; }
+
+    HttpDownloadPtr asHttpDownload() { return static_self_cast<HttpDownload>(); }
+
+    struct ResponseHeader {
+        int status = 0;
+        int64 contentLength = -1;
+        int64 rangeTotal = -1;
+        bool acceptRanges = false;
+        bool chunked = false;
+        std::string etag;
+        std::string lastModified;
+    };
+
+    // @dontbind
+    static bool parseHeader(const std::string& header, ResponseHeader& response);
+
+private:
+    struct Part {
+        ConnectionPtr connection;
+        FileStreamPtr file;
+        std::string fileName;
+        uint64 start = 0;
+        uint64 end = 0; // exclusive, unused while the size is unknown
+        uint64 received = 0;
+        bool headerDone = false;
+        bool done = false;
+    };
+
+    void sendRequest(const ConnectionPtr& connection, const std::string& method, const std::string& range);
+    void onProbeHeader(uint8* buffer, uint16 size);
+    // resuming picks up part files left by an earlier start with the same part count
+    void startParts(int count, bool resume);
+    bool isRanged(const Part& part) { return (m_sizeKnown && m_parts.size() > 1) || part.received > 0; }
+    void startPart(size_t index);
+    void onPartHeader(size_t index, uint8* buffer, uint16 size);
+    void onPartData(size_t index, uint8* buffer, uint16 size);
+    void onPartError(size_t index, const boost::system::error_code& error);
+    void finishPart(size_t index);
+    void finish();
+    void fail(const std::string& message);
+
+    std::string m_host;
+    uint16 m_port = 0;
+    std::string m_path;
+    std::string m_fileName;
+    int m_connections = 1;
+    ConnectionPtr m_probe;
+    std::vector<Part> m_parts;
+    uint64 m_downloadedBytes = 0;
+    uint64 m_totalBytes = 0;
+    bool m_sizeKnown = false;
+    bool m_finished = false;
+};
+
+#endif
@@ -21,6 +21,7 @@
  */
 
 #include "inputmessage.h"
+#include "receivebuffer.h"
 #include <framework/util/crypt.h>
 
 InputMessage::InputMessage()
@@ -33,6 +34,8 @@ void InputMessage::reset()
     m_messageSize = 0;
     m_readPos = MAX_HEADER_SIZE;
     m_headerPos = MAX_HEADER_SIZE;
+    m_data = m_buffer;
+    m_receiveBuffer = nullptr;
 }
 
 void InputMessage::setBuffer(const std::string& buffer)
@@ -40,7 +43,7 @@ void InputMessage::setBuffer(const std::string& buffer)
     int len = buffer.size();
     reset();
     checkWrite(len);
-    memcpy((char*)(m_buffer + m_readPos), buffer.c_str(), len);
+    memcpy((char*)(m_data + m_readPos), buffer.c_str(), len);
     m_readPos += len;
     m_messageSize += len;
 }
@@ -48,7 +51,7 @@ void InputMessage::setBuffer(const std::string& buffer)
 uint8 InputMessage::getU8()
 {
     checkRead(1);
-    uint8 v = m_buffer[m_readPos];
+    uint8 v = m_data[m_readPos];
     m_readPos += 1;
     return v;
 }
@@ -56,7 +59,7 @@ uint8 InputMessage::getU8()
 uint16 InputMessage::getU16()
 {
     checkRead(2);
-    uint16 v = stdext::readULE16(m_buffer + m_readPos);
+    uint16 v = stdext::readULE16(m_data + m_readPos);
     m_readPos += 2;
     return v;
 }
@@ -64,7 +67,7 @@ uint16 InputMessage::getU16()
 uint32 InputMessage::getU32()
 {
     checkRead(4);
-    uint32 v = stdext::readULE32(m_buffer + m_readPos);
+    uint32 v = stdext::readULE32(m_data + m_readPos);
     m_readPos += 4;
     return v;
 }
@@ -72,7 +75,7 @@ uint32 InputMessage::getU32()
 uint64 InputMessage::getU64()
 {
     checkRead(8);
-    uint64 v = stdext::readULE64(m_buffer + m_readPos);
+    uint64 v = stdext::readULE64(m_data + m_readPos);
     m_readPos += 8;
     return v;
 }
@@ -81,11 +84,20 @@ std::string InputMessage::getString()
 {
     uint16 stringLength = getU16();
     checkRead(stringLength);
-    char* v = (char*)(m_buffer + m_readPos);
+    char* v = (char*)(m_data + m_readPos);
     m_readPos += stringLength;
     return std::string(v, stringLength);
 }
 
+std::string_view InputMessage::getStringView()
+{
+    uint16 stringLength = getU16();
+    checkRead(stringLength);
+    const char* v = (const char*)(m_data + m_readPos);
+    m_readPos += stringLength;
+    return std::string_view(v, stringLength);
+}
+
 double InputMessage::getDouble()
 {
     uint8 precision = getU8();
@@ -96,14 +108,27 @@ double InputMessage::getDouble()
 bool InputMessage::decryptRsa(int size)
 {
     checkRead(size);
-    g_crypt.rsaDecrypt(static_cast<unsigned char*>(m_buffer) + m_readPos, size);
+    g_crypt.rsaDecrypt(static_cast<unsigned char*>(m_data) + m_readPos, size);
     return (getU8() == 0x00);
 }
 
 void InputMessage::fillBuffer(uint8* buffer, uint16 size)
 {
     checkWrite(m_readPos + size);
-    memcpy(m_buffer + m_readPos, buffer, size);
+    memcpy(m_data + m_readPos, buffer, size);
+    m_messageSize += size;
+}
+
+void InputMessage::setReceiveBuffer(const ReceiveBufferPtr& buffer)
+{
+    static_assert(ReceiveBuffer::SIZE >= BUFFER_MAXSIZE, "receive buffers must fit a whole message");
+    m_receiveBuffer = buffer;
+    m_data = buffer->data();
+}
+
+void InputMessage::commitBuffer(uint16 size)
+{
+    checkWrite(m_readPos + size);
     m_messageSize += size;
 }
 
@@ -117,7 +142,7 @@ void InputMessage::setHeaderSize(uint16 size)
 bool InputMessage::readChecksum()
 {
     uint32 receivedCheck = getU32();
-    uint32 checksum = stdext::adler32(m_buffer + m_readPos, getUnreadSize());
+    uint32 checksum = stdext::adler32(m_data + m_readPos, getUnreadSize());
     return receivedCheck == checksum;
 }
 
@@ -26,6 +26,8 @@
 #include "declarations.h"
 #include <framework/luaengine/luaobject.h>
 
+#include <string_view>
+
  // @bindclass
 class InputMessage : public LuaObject
 {
@@ -38,7 +40,7 @@ public:
     InputMessage();
 
     void setBuffer(const std::string& buffer);
-    std::string getBuffer() { return std::string((char*)m_buffer + m_headerPos, m_messageSize); }
+    std::string getBuffer() { return std::string((char*)m_data + m_headerPos, m_messageSize); }
 
     void skipBytes(uint16 bytes) { m_readPos += bytes; }
     void setReadPos(uint16 readPos) { m_readPos = readPos; }
@@ -47,6 +49,8 @@ public:
     uint32 getU32();
     uint64 getU64();
     std::string getString();
+    // points into the message, only valid until it is reset, for parsers that don't keep the text
+    std::string_view getStringView();
     double getDouble();
 
     uint8 peekU8() { uint8 v = getU8(); m_readPos -= 1; return v; }
@@ -66,13 +70,17 @@ public:
 protected:
     void reset();
     void fillBuffer(uint8* buffer, uint16 size);
+    // reads from an external buffer laid out like the internal one, until the next reset
+    void setReceiveBuffer(const ReceiveBufferPtr& buffer);
+    // same as fillBuffer for bytes that were already written at the read position
+    void commitBuffer(uint16 size);
 
     void setHeaderSize(uint16 size);
     void setMessageSize(uint16 size) { m_messageSize = size; }
 
-    uint8* getReadBuffer() { return m_buffer + m_readPos; }
-    uint8* getHeaderBuffer() { return m_buffer + m_headerPos; }
-    uint8* getDataBuffer() { return m_buffer + MAX_HEADER_SIZE; }
+    uint8* getReadBuffer() { return m_data + m_readPos; }
+    uint8* getHeaderBuffer() { return m_data + m_headerPos; }
+    uint8* getDataBuffer() { return m_data + MAX_HEADER_SIZE; }
     uint16 getHeaderSize() { return (MAX_HEADER_SIZE - m_headerPos); }
 
     uint16 readSize() { return getU16(); }
@@ -88,6 +96,8 @@ private:
     uint16 m_headerPos;
     uint16 m_readPos;
     uint16 m_messageSize;
+    uint8* m_data;
+    ReceiveBufferPtr m_receiveBuffer;
     uint8 m_buffer[BUFFER_MAXSIZE];
 };
 
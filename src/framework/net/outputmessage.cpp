@@ -25,6 +25,7 @@
 
 OutputMessage::OutputMessage()
 {
+    m_buffer.reserve(BufferPool::MIN_BUFFER_SIZE);
     reset();
 }
 
@@ -40,7 +41,7 @@ void OutputMessage::setBuffer(const std::string& buffer)
     int len = buffer.size();
     reset();
     checkWrite(len);
-    memcpy((char*)(m_buffer + m_writePos), buffer.c_str(), len);
+    memcpy((char*)(m_buffer.data() + m_writePos), buffer.c_str(), len);
     m_writePos += len;
     m_messageSize += len;
 }
@@ -48,7 +49,7 @@ void OutputMessage::setBuffer(const std::string& buffer)
 void OutputMessage::addU8(uint8 value)
 {
     checkWrite(1);
-    m_buffer[m_writePos] = value;
+    m_buffer.data()[m_writePos] = value;
     m_writePos += 1;
     m_messageSize += 1;
 }
@@ -56,7 +57,7 @@ void OutputMessage::addU8(uint8 value)
 void OutputMessage::addU16(uint16 value)
 {
     checkWrite(2);
-    stdext::writeULE16(m_buffer + m_writePos, value);
+    stdext::writeULE16(m_buffer.data() + m_writePos, value);
     m_writePos += 2;
     m_messageSize += 2;
 }
@@ -64,7 +65,7 @@ void OutputMessage::addU16(uint16 value)
 void OutputMessage::addU32(uint32 value)
 {
     checkWrite(4);
-    stdext::writeULE32(m_buffer + m_writePos, value);
+    stdext::writeULE32(m_buffer.data() + m_writePos, value);
     m_writePos += 4;
     m_messageSize += 4;
 }
@@ -72,7 +73,7 @@ void OutputMessage::addU32(uint32 value)
 void OutputMessage::addU64(uint64 value)
 {
     checkWrite(8);
-    stdext::writeULE64(m_buffer + m_writePos, value);
+    stdext::writeULE64(m_buffer.data() + m_writePos, value);
     m_writePos += 8;
     m_messageSize += 8;
 }
@@ -84,7 +85,7 @@ void OutputMessage::addString(const std::string& buffer)
         throw stdext::exception(stdext::format("string length > %d", MAX_STRING_LENGTH));
     checkWrite(len + 2);
     addU16(len);
-    memcpy((char*)(m_buffer + m_writePos), buffer.c_str(), len);
+    memcpy((char*)(m_buffer.data() + m_writePos), buffer.c_str(), len);
     m_writePos += len;
     m_messageSize += len;
 }
@@ -94,7 +95,7 @@ void OutputMessage::addPaddingBytes(int bytes, uint8 byte)
     if(bytes <= 0)
         return;
     checkWrite(bytes);
-    memset(static_cast<void*>(&m_buffer[m_writePos]), byte, bytes);
+    memset(static_cast<void*>(m_buffer.data() + m_writePos), byte, bytes);
     m_writePos += bytes;
     m_messageSize += bytes;
 }
@@ -105,16 +106,20 @@ void OutputMessage::encryptRsa()
     if(m_messageSize < size)
         throw stdext::exception("insufficient bytes in buffer to encrypt");
 
-    if(!g_crypt.rsaEncrypt(static_cast<unsigned char*>(m_buffer) + m_writePos - size, size))
+    if(!g_crypt.rsaEncrypt(m_buffer.data() + m_writePos - size, size))
         throw stdext::exception("rsa encryption failed");
 }
 
 void OutputMessage::writeChecksum()
 {
-    uint32 checksum = stdext::adler32(m_buffer + m_headerPos, m_messageSize);
+    writeChecksum(stdext::adler32(m_buffer.data() + m_headerPos, m_messageSize));
+}
+
+void OutputMessage::writeChecksum(uint32 checksum)
+{
     assert(m_headerPos - 4 >= 0);
     m_headerPos -= 4;
-    stdext::writeULE32(m_buffer + m_headerPos, checksum);
+    stdext::writeULE32(m_buffer.data() + m_headerPos, checksum);
     m_messageSize += 4;
 }
 
@@ -122,7 +127,7 @@ void OutputMessage::writeMessageSize()
 {
     assert(m_headerPos - 2 >= 0);
     m_headerPos -= 2;
-    stdext::writeULE16(m_buffer + m_headerPos, m_messageSize);
+    stdext::writeULE16(m_buffer.data() + m_headerPos, m_messageSize);
     m_messageSize += 2;
 }
 
@@ -137,4 +142,5 @@ void OutputMessage::checkWrite(int bytes)
 {
     if(!canWrite(bytes))
         throw stdext::exception("OutputMessage max buffer size reached");
+    m_buffer.reserve(m_writePos + bytes, m_writePos);
 }
@@ -24,6 +24,7 @@
 #define OUTPUTMESSAGE_H
 
 #include "declarations.h"
+#include "bufferpool.h"
 #include <framework/luaengine/luaobject.h>
 
  // @bindclass
@@ -41,7 +42,7 @@ public:
     void reset();
 
     void setBuffer(const std::string& buffer);
-    std::string getBuffer() { return std::string((char*)m_buffer + m_headerPos, m_messageSize); }
+    std::string getBuffer() { return std::string((char*)m_buffer.data() + m_headerPos, m_messageSize); }
 
     void addU8(uint8 value);
     void addU16(uint16 value);
@@ -59,11 +60,13 @@ public:
     void setMessageSize(uint16 messageSize) { m_messageSize = messageSize; }
 
 protected:
-    uint8* getWriteBuffer() { return m_buffer + m_writePos; }
-    uint8* getHeaderBuffer() { return m_buffer + m_headerPos; }
-    uint8* getDataBuffer() { return m_buffer + MAX_HEADER_SIZE; }
+    uint8* getWriteBuffer() { return m_buffer.data() + m_writePos; }
+    uint8* getHeaderBuffer() { return m_buffer.data() + m_headerPos; }
+    uint8* getDataBuffer() { return m_buffer.data() + MAX_HEADER_SIZE; }
 
     void writeChecksum();
+    // checksum of the message already computed by the caller, see Protocol::xteaEncrypt
+    void writeChecksum(uint32 checksum);
     void writeMessageSize();
 
     friend class Protocol;
@@ -75,7 +78,8 @@ private:
     uint16 m_headerPos;
     uint16 m_writePos;
     uint16 m_messageSize;
-    uint8 m_buffer[BUFFER_MAXSIZE];
+    // starts at the smallest pool class and grows with the message
+    PooledBuffer m_buffer;
 };
 
 #endif
@@ -22,13 +22,254 @@
 
 #include "protocol.h"
 #include "connection.h"
+#include "receivebuffer.h"
 #include <framework/core/application.h>
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
 #include <random>
+#include <zlib.h>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    constexpr uint32_t delta = 0x9E3779B9;
+
+    // sum plus key word of every round, the first one is mixed into the left word when encrypting
+    // and into the right word when decrypting
+    struct XteaSchedule
+    {
+        uint32_t first[32];
+        uint32_t second[32];
+    };
+
+    template<bool Encrypt>
+    XteaSchedule makeXteaSchedule(const std::array<uint32, 4>& key)
+    {
+        XteaSchedule schedule;
+        for(uint32_t i = 0; i < 32; ++i) {
+            if(Encrypt) {
+                const uint32_t sum = i * delta, next_sum = sum + delta;
+                schedule.first[i] = sum + key[sum & 3];
+                schedule.second[i] = next_sum + key[(next_sum >> 11) & 3];
+            } else {
+                const uint32_t sum = (32 - i) * delta, next_sum = sum - delta;
+                schedule.first[i] = sum + key[(sum >> 11) & 3];
+                schedule.second[i] = next_sum + key[next_sum & 3];
+            }
+        }
+        return schedule;
+    }
+
+    template<bool Encrypt>
+    inline void xteaBlock(uint8_t* data, const XteaSchedule& schedule)
+    {
+        uint32_t left = stdext::readULE32(data), right = stdext::readULE32(data + 4);
+        for(int i = 0; i < 32; ++i) {
+            if(Encrypt) {
+                left += ((right << 4 ^ right >> 5) + right) ^ schedule.first[i];
+                right += ((left << 4 ^ left >> 5) + left) ^ schedule.second[i];
+            } else {
+                right -= ((left << 4 ^ left >> 5) + left) ^ schedule.first[i];
+                left -= ((right << 4 ^ right >> 5) + right) ^ schedule.second[i];
+            }
+        }
+        stdext::writeULE32(data, left);
+        stdext::writeULE32(data + 4, right);
+    }
+
+    // the vector paths run the rounds of several blocks side by side, they return how many bytes they took
+#if defined(__AVX2__)
+    template<bool Encrypt>
+    size_t xteaBlocksAvx2(uint8_t* data, size_t length, const XteaSchedule& schedule)
+    {
+        const auto mix = [](__m256i v) { return _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v, 4), _mm256_srli_epi32(v, 5)), v); };
+
+        size_t j = 0;
+        for(; j + 64 <= length; j += 64) {
+            const __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + j)));
+            const __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + j + 32)));
+            // word order is shuffled between lanes, unpacking below undoes it
+            __m256i left = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m256i right = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+            for(int i = 0; i < 32; ++i) {
+                const __m256i first = _mm256_set1_epi32(static_cast<int>(schedule.first[i]));
+                const __m256i second = _mm256_set1_epi32(static_cast<int>(schedule.second[i]));
+                if(Encrypt) {
+                    left = _mm256_add_epi32(left, _mm256_xor_si256(mix(right), first));
+                    right = _mm256_add_epi32(right, _mm256_xor_si256(mix(left), second));
+                } else {
+                    right = _mm256_sub_epi32(right, _mm256_xor_si256(mix(left), first));
+                    left = _mm256_sub_epi32(left, _mm256_xor_si256(mix(right), second));
+                }
+            }
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + j), _mm256_unpacklo_epi32(left, right));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + j + 32), _mm256_unpackhi_epi32(left, right));
+        }
+        return j;
+    }
+#endif
+
+#if defined(__SSE2__)
+    template<bool Encrypt>
+    size_t xteaBlocksSse2(uint8_t* data, size_t length, const XteaSchedule& schedule)
+    {
+        const auto mix = [](__m128i v) { return _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v, 4), _mm_srli_epi32(v, 5)), v); };
+
+        size_t j = 0;
+        for(; j + 32 <= length; j += 32) {
+            const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + j)));
+            const __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + j + 16)));
+            __m128i left = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i right = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+            for(int i = 0; i < 32; ++i) {
+                const __m128i first = _mm_set1_epi32(static_cast<int>(schedule.first[i]));
+                const __m128i second = _mm_set1_epi32(static_cast<int>(schedule.second[i]));
+                if(Encrypt) {
+                    left = _mm_add_epi32(left, _mm_xor_si128(mix(right), first));
+                    right = _mm_add_epi32(right, _mm_xor_si128(mix(left), second));
+                } else {
+                    right = _mm_sub_epi32(right, _mm_xor_si128(mix(left), first));
+                    left = _mm_sub_epi32(left, _mm_xor_si128(mix(right), second));
+                }
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + j), _mm_unpacklo_epi32(left, right));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + j + 16), _mm_unpackhi_epi32(left, right));
+        }
+        return j;
+    }
+#elif defined(__ARM_NEON)
+    template<bool Encrypt>
+    size_t xteaBlocksNeon(uint8_t* data, size_t length, const XteaSchedule& schedule)
+    {
+        const auto mix = [](uint32x4_t v) { return vaddq_u32(veorq_u32(vshlq_n_u32(v, 4), vshrq_n_u32(v, 5)), v); };
+
+        size_t j = 0;
+        for(; j + 32 <= length; j += 32) {
+            uint32x4x2_t words = vld2q_u32(reinterpret_cast<const uint32_t*>(data + j));
+            uint32x4_t left = words.val[0], right = words.val[1];
+
+            for(int i = 0; i < 32; ++i) {
+                const uint32x4_t first = vdupq_n_u32(schedule.first[i]);
+                const uint32x4_t second = vdupq_n_u32(schedule.second[i]);
+                if(Encrypt) {
+                    left = vaddq_u32(left, veorq_u32(mix(right), first));
+                    right = vaddq_u32(right, veorq_u32(mix(left), second));
+                } else {
+                    right = vsubq_u32(right, veorq_u32(mix(left), first));
+                    left = vsubq_u32(left, veorq_u32(mix(right), second));
+                }
+            }
+
+            words.val[0] = left;
+            words.val[1] = right;
+            vst2q_u32(reinterpret_cast<uint32_t*>(data + j), words);
+        }
+        return j;
+    }
+#endif
+
+    template<bool Encrypt>
+    void xteaBlocks(uint8_t* data, size_t length, const XteaSchedule& schedule)
+    {
+        size_t j = 0;
+#if defined(__AVX2__)
+        j += xteaBlocksAvx2<Encrypt>(data, length, schedule);
+#endif
+#if defined(__SSE2__)
+        j += xteaBlocksSse2<Encrypt>(data + j, length - j, schedule);
+#elif defined(__ARM_NEON)
+        j += xteaBlocksNeon<Encrypt>(data + j, length - j, schedule);
+#endif
+        for(; j + 8 <= length; j += 8)
+            xteaBlock<Encrypt>(data + j, schedule);
+    }
+
+    template<bool Encrypt>
+    void xteaBlocks(uint8_t* data, size_t length, const std::array<uint32, 4>& key)
+    {
+        xteaBlocks<Encrypt>(data, length, makeXteaSchedule<Encrypt>(key));
+    }
+
+    // the checksum is taken chunk by chunk right before decrypting or after encrypting, so each chunk
+    // is still in cache for the second pass; returns the adler32 of the encrypted bytes
+    constexpr size_t XTEA_CHECKSUM_CHUNK = 4096;
+
+    template<bool Encrypt>
+    uint32_t xteaBlocksChecksum(uint8_t* data, size_t length, const std::array<uint32, 4>& key)
+    {
+        const XteaSchedule schedule = makeXteaSchedule<Encrypt>(key);
+
+        uint32_t checksum = 1;
+        for(size_t j = 0; j < length; j += XTEA_CHECKSUM_CHUNK) {
+            const size_t chunk = std::min<size_t>(length - j, XTEA_CHECKSUM_CHUNK);
+            if(!Encrypt)
+                checksum = stdext::adler32(data + j, chunk, checksum);
+            xteaBlocks<Encrypt>(data + j, chunk, schedule);
+            if(Encrypt)
+                checksum = stdext::adler32(data + j, chunk, checksum);
+        }
+        return checksum;
+    }
+
+    // same checks as internalRecvData, done in place on a whole frame so it can run on the network thread
+    const char* decodeFrame(uint8* frame, size_t size, bool checksumEnabled, bool verifyChecksum, bool sequenced, bool xteaEnabled, const std::array<uint32, 4>& key)
+    {
+        if(size > InputMessage::BUFFER_MAXSIZE - InputMessage::MAX_HEADER_SIZE)
+            return "network message is too large";
+
+        size_t pos = 2;
+        uint32_t checksum = 0;
+        if(sequenced) {
+            if(size < pos + 4)
+                return "invalid sequenced network message";
+            pos += 4;
+        } else if(checksumEnabled) {
+            if(size < pos + 4)
+                return "got a network message with invalid checksum";
+            checksum = stdext::readULE32(frame + pos);
+            pos += 4;
+        } else
+            verifyChecksum = false;
+
+        if(xteaEnabled) {
+            const size_t encryptedSize = size - pos;
+            if(encryptedSize == 0 || encryptedSize % 8 != 0)
+                return "invalid encrypted network message";
+
+            if(!verifyChecksum)
+                xteaBlocks<false>(frame + pos, encryptedSize, key);
+            else if(xteaBlocksChecksum<false>(frame + pos, encryptedSize, key) != checksum)
+                return "got a network message with invalid checksum";
+
+            const int decryptedSize = stdext::readULE16(frame + pos) + 2;
+            const int sizeDelta = decryptedSize - static_cast<int>(encryptedSize);
+            if(sizeDelta > 0 || -sizeDelta > static_cast<int>(encryptedSize))
+                return "invalid decrypted network message";
+        } else if(verifyChecksum && checksum != stdext::adler32(frame + pos, size - pos))
+            return "got a network message with invalid checksum";
+        return nullptr;
+    }
+}
 
 Protocol::Protocol()
 {
     m_xteaEncryptionEnabled = false;
     m_checksumEnabled = false;
+    m_compressionEnabled = false;
+    m_checksumVerification = true;
+    m_writeBatchDelay = 0;
+    m_compressedBytes = 0;
+    m_inflatedBytes = 0;
+    m_uncompressedBytes = 0;
+    m_lastArrival = 0;
     m_inputMessage = InputMessagePtr(new InputMessage);
 }
 
@@ -38,11 +279,18 @@ Protocol::~Protocol()
     assert(!g_app.isTerminated());
 #endif
     disconnect();
+    stopRecording();
+
+    if(m_inflateStream)
+        inflateEnd(m_inflateStream.get());
 }
 
 void Protocol::connect(const std::string& host, uint16 port)
 {
+    m_lastArrival = 0;
+    m_arrivalGaps.clear();
     m_connection = ConnectionPtr(new Connection);
+    m_connection->setWriteBatchDelay(m_writeBatchDelay);
     m_connection->setErrorCallback(std::bind(&Protocol::onError, asProtocol(), std::placeholders::_1));
     m_connection->connect(host, port, std::bind(&Protocol::onConnect, asProtocol()));
 }
@@ -69,14 +317,23 @@ bool Protocol::isConnecting()
     return false;
 }
 
+void Protocol::setWriteBatchDelay(int micros)
+{
+    m_writeBatchDelay = micros;
+    if(m_connection)
+        m_connection->setWriteBatchDelay(micros);
+}
+
 void Protocol::send(const OutputMessagePtr& outputMessage)
 {
-    // encrypt
-    if(m_xteaEncryptionEnabled)
-        xteaEncrypt(outputMessage);
+    const bool urgent = outputMessage->getMessageSize() > 0 && m_urgentOpcodes[outputMessage->getDataBuffer()[0]];
 
-    // write checksum
-    if(m_checksumEnabled)
+    // encrypt, the checksum of the encrypted message comes out of the same pass
+    if(m_xteaEncryptionEnabled) {
+        const uint32 checksum = xteaEncrypt(outputMessage, m_checksumEnabled);
+        if(m_checksumEnabled)
+            outputMessage->writeChecksum(checksum);
+    } else if(m_checksumEnabled)
         outputMessage->writeChecksum();
 
     // write message size
@@ -84,7 +341,7 @@ void Protocol::send(const OutputMessagePtr& outputMessage)
 
     // send
     if(m_connection)
-        m_connection->write(outputMessage->getHeaderBuffer(), outputMessage->getMessageSize());
+        m_connection->write(outputMessage->getHeaderBuffer(), outputMessage->getMessageSize(), urgent);
 
     // reset message to allow reuse
     outputMessage->reset();
@@ -92,30 +349,49 @@ void Protocol::send(const OutputMessagePtr& outputMessage)
 
 void Protocol::recv()
 {
-    m_inputMessage->reset();
+    // checksum and decryption run on the network thread, frames come back ready to parse
+    if(Connection::isNetworkThreadEnabled()) {
+        if(m_connection) {
+            const bool checksumEnabled = m_checksumEnabled;
+            const bool verifyChecksum = m_checksumVerification;
+            const bool sequenced = m_compressionEnabled;
+            const bool xteaEnabled = m_xteaEncryptionEnabled;
+            const std::array<uint32, 4> xteaKey = m_xteaKey;
+
+            // frames land where the message header starts, so the buffer can be parsed without copying
+            const uint16 frameOffset = InputMessage::MAX_HEADER_SIZE - getHeaderSize();
+
+            // framing can't change anymore once encryption is on, so frames can be read ahead from there
+            m_connection->readFrame(xteaEnabled, frameOffset,
+                                    [=](uint8* frame, size_t size) { return decodeFrame(frame, size, checksumEnabled, verifyChecksum, sequenced, xteaEnabled, xteaKey); },
+                                    std::bind(&Protocol::internalRecvFrame, asProtocol(), std::placeholders::_1, std::placeholders::_2));
+        }
+        return;
+    }
 
-    // first update message header size
-    int headerSize = 2; // 2 bytes for message size
-    if(m_checksumEnabled)
-        headerSize += 4; // 4 bytes for checksum
-    if(m_xteaEncryptionEnabled)
-        headerSize += 2; // 2 bytes for XTEA encrypted message size
-    m_inputMessage->setHeaderSize(headerSize);
+    m_inputMessage->reset();
+    m_inputMessage->setHeaderSize(getHeaderSize());
+    m_inputMessage->setReceiveBuffer(ReceiveBuffer::acquire());
 
     // read the first 2 bytes which contain the message size
     if(m_connection)
-        m_connection->read(2, std::bind(&Protocol::internalRecvHeader, asProtocol(), std::placeholders::_1, std::placeholders::_2));
+        m_connection->read(m_inputMessage->m_receiveBuffer, m_inputMessage->getReadPos(), 2, std::bind(&Protocol::internalRecvHeader, asProtocol(), std::placeholders::_1, std::placeholders::_2));
 }
 
 void Protocol::internalRecvHeader(uint8* buffer, uint16 size)
 {
-    // read message size
-    m_inputMessage->fillBuffer(buffer, size);
+    // read message size, the bytes were read in place
+    m_inputMessage->commitBuffer(size);
     uint16 remainingSize = m_inputMessage->readSize();
 
+    if(remainingSize > InputMessage::BUFFER_MAXSIZE - m_inputMessage->getReadPos()) {
+        g_logger.traceError("network message is too large");
+        return;
+    }
+
     // read remaining message data
     if(m_connection)
-        m_connection->read(remainingSize, std::bind(&Protocol::internalRecvData, asProtocol(), std::placeholders::_1, std::placeholders::_2));
+        m_connection->read(m_inputMessage->m_receiveBuffer, m_inputMessage->getReadPos(), remainingSize, std::bind(&Protocol::internalRecvData, asProtocol(), std::placeholders::_1, std::placeholders::_2));
 }
 
 void Protocol::internalRecvData(uint8* buffer, uint16 size)
@@ -126,22 +402,87 @@ void Protocol::internalRecvData(uint8* buffer, uint16 size)
         return;
     }
 
-    m_inputMessage->fillBuffer(buffer, size);
+    countArrival();
 
-    if(m_checksumEnabled && !m_inputMessage->readChecksum()) {
-        g_logger.traceError("got a network message with invalid checksum");
-        return;
+    m_inputMessage->commitBuffer(size);
+
+    bool compressed = false;
+    bool verifyChecksum = false;
+    uint32 checksum = 0;
+    if(m_compressionEnabled)
+        compressed = (m_inputMessage->getU32() & 0x80000000) != 0;
+    else if(m_checksumEnabled) {
+        checksum = m_inputMessage->getU32();
+        verifyChecksum = m_checksumVerification;
     }
 
+    // with encryption the checksum is verified while decrypting
     if(m_xteaEncryptionEnabled) {
-        if(!xteaDecrypt(m_inputMessage)) {
+        if(!xteaDecrypt(m_inputMessage, verifyChecksum ? &checksum : nullptr)) {
             g_logger.traceError("failed to decrypt message");
             return;
         }
+    } else if(verifyChecksum && checksum != stdext::adler32(m_inputMessage->getReadBuffer(), m_inputMessage->getUnreadSize())) {
+        g_logger.traceError("got a network message with invalid checksum");
+        return;
     }
+
+    countMessage(m_inputMessage, compressed);
+    if(compressed && !inflateMessage(m_inputMessage))
+        return;
+    if(m_recordFile)
+        recordMessage(m_inputMessage);
     onRecv(m_inputMessage);
 }
 
+void Protocol::internalRecvFrame(const ReceiveBufferPtr& buffer, uint16 size)
+{
+    // process data only if really connected
+    if(!isConnected()) {
+        g_logger.traceError("received data while disconnected");
+        return;
+    }
+
+    countArrival();
+
+    // the frame was already verified and decrypted, only the header is skipped here
+    m_inputMessage->reset();
+    m_inputMessage->setHeaderSize(getHeaderSize());
+    m_inputMessage->setReceiveBuffer(buffer);
+    m_inputMessage->commitBuffer(size);
+    m_inputMessage->readSize();
+
+    bool compressed = false;
+    if(m_compressionEnabled)
+        compressed = (m_inputMessage->getU32() & 0x80000000) != 0;
+    else if(m_checksumEnabled)
+        m_inputMessage->getU32();
+
+    if(m_xteaEncryptionEnabled) {
+        const int encryptedSize = m_inputMessage->getUnreadSize();
+        const int decryptedSize = m_inputMessage->getU16() + 2;
+        m_inputMessage->setMessageSize(m_inputMessage->getMessageSize() + decryptedSize - encryptedSize);
+    }
+
+    // inflating depends on every previous message, so it stays here instead of the network thread
+    countMessage(m_inputMessage, compressed);
+    if(compressed && !inflateMessage(m_inputMessage))
+        return;
+    if(m_recordFile)
+        recordMessage(m_inputMessage);
+    onRecv(m_inputMessage);
+}
+
+int Protocol::getHeaderSize()
+{
+    int headerSize = 2; // 2 bytes for message size
+    if(m_checksumEnabled || m_compressionEnabled)
+        headerSize += 4; // 4 bytes for checksum or sequence number
+    if(m_xteaEncryptionEnabled)
+        headerSize += 2; // 2 bytes for XTEA encrypted message size
+    return headerSize;
+}
+
 void Protocol::generateXteaKey()
 {
     std::random_device rd;
@@ -149,31 +490,7 @@ void Protocol::generateXteaKey()
     std::generate(m_xteaKey.begin(), m_xteaKey.end(), [&]() { return unif(rd); });
 }
 
-namespace {
-    constexpr uint32_t delta = 0x9E3779B9;
-
-    template<typename Round>
-    void apply_rounds(uint8_t* data, size_t length, Round round)
-    {
-        for(auto j = 0u; j < length; j += 8) {
-            uint32_t left = data[j + 0] | data[j + 1] << 8u | data[j + 2] << 16u | data[j + 3] << 24u,
-                right = data[j + 4] | data[j + 5] << 8u | data[j + 6] << 16u | data[j + 7] << 24u;
-
-            round(left, right);
-
-            data[j] = static_cast<uint8_t>(left);
-            data[j + 1] = static_cast<uint8_t>(left >> 8u);
-            data[j + 2] = static_cast<uint8_t>(left >> 16u);
-            data[j + 3] = static_cast<uint8_t>(left >> 24u);
-            data[j + 4] = static_cast<uint8_t>(right);
-            data[j + 5] = static_cast<uint8_t>(right >> 8u);
-            data[j + 6] = static_cast<uint8_t>(right >> 16u);
-            data[j + 7] = static_cast<uint8_t>(right >> 24u);
-        }
-    }
-}
-
-bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage)
+bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage, const uint32* checksum)
 {
     uint16 encryptedSize = inputMessage->getUnreadSize();
     if(encryptedSize % 8 != 0) {
@@ -181,12 +498,12 @@ bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage)
         return false;
     }
 
-    for(uint32_t i = 0, sum = delta << 5, next_sum = sum - delta; i < 32; ++i, sum = next_sum, next_sum -= delta) {
-        apply_rounds(inputMessage->getReadBuffer(), encryptedSize, [&](uint32_t& left, uint32_t& right) {
-            right -= ((left << 4 ^ left >> 5) + left) ^ (sum + m_xteaKey[(sum >> 11) & 3]);
-            left -= ((right << 4 ^ right >> 5) + right) ^ (next_sum + m_xteaKey[next_sum & 3]);
-        });
-    };
+    if(!checksum)
+        xteaBlocks<false>(inputMessage->getReadBuffer(), encryptedSize, m_xteaKey);
+    else if(xteaBlocksChecksum<false>(inputMessage->getReadBuffer(), encryptedSize, m_xteaKey) != *checksum) {
+        g_logger.traceError("got a network message with invalid checksum");
+        return false;
+    }
 
     uint16 decryptedSize = inputMessage->getU16() + 2;
     int sizeDelta = decryptedSize - encryptedSize;
@@ -199,7 +516,125 @@ bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage)
     return true;
 }
 
-void Protocol::xteaEncrypt(const OutputMessagePtr& outputMessage)
+bool Protocol::inflateMessage(const InputMessagePtr& inputMessage)
+{
+    // one raw deflate stream spans the whole connection, each message ends on a sync flush
+    if(!m_inflateStream) {
+        m_inflateStream.reset(new z_stream_s);
+        memset(m_inflateStream.get(), 0, sizeof(z_stream_s));
+        if(inflateInit2(m_inflateStream.get(), -MAX_WBITS) != Z_OK) {
+            m_inflateStream.reset();
+            g_logger.traceError("unable to initialize inflate stream");
+            return false;
+        }
+
+        if(!m_compressionDictionary.empty())
+            inflateSetDictionary(m_inflateStream.get(), (const Bytef*)m_compressionDictionary.data(), m_compressionDictionary.size());
+    }
+
+    const uint16 compressedSize = inputMessage->getUnreadSize();
+    const uInt maxSize = InputMessage::BUFFER_MAXSIZE - InputMessage::MAX_HEADER_SIZE;
+    ReceiveBufferPtr buffer = ReceiveBuffer::acquire();
+
+    z_stream_s* stream = m_inflateStream.get();
+    stream->next_in = inputMessage->getReadBuffer();
+    stream->avail_in = compressedSize;
+    stream->next_out = buffer->data() + InputMessage::MAX_HEADER_SIZE;
+    stream->avail_out = maxSize;
+
+    const int ret = inflate(stream, Z_SYNC_FLUSH);
+    if((ret != Z_OK && ret != Z_STREAM_END) || stream->avail_in != 0) {
+        g_logger.traceError(stdext::format("failed to inflate network message: %s", stream->msg ? stream->msg : "message is too large"));
+        return false;
+    }
+
+    // the server may finish a stream and start another one
+    if(ret == Z_STREAM_END)
+        inflateReset(stream);
+
+    const uint16 inflatedSize = maxSize - stream->avail_out;
+    m_inflatedBytes += inflatedSize;
+
+    inputMessage->reset();
+    inputMessage->setReceiveBuffer(buffer);
+    inputMessage->commitBuffer(inflatedSize);
+    return true;
+}
+
+bool Protocol::startRecording(const std::string& fileName)
+{
+    stopRecording();
+
+    try {
+        m_recordFile = g_resources.createFile(fileName);
+        m_recordFile->addU32(RECORD_SIGNATURE);
+        m_recordFile->addU16(RECORD_VERSION);
+        m_recordTimer.restart();
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to record protocol messages to '%s': %s", fileName, e.what()));
+        m_recordFile = nullptr;
+        return false;
+    }
+}
+
+void Protocol::stopRecording()
+{
+    if(!m_recordFile)
+        return;
+
+    try {
+        m_recordFile->close();
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to close protocol recording: %s", e.what()));
+    }
+    m_recordFile = nullptr;
+}
+
+void Protocol::recordMessage(const InputMessagePtr& inputMessage)
+{
+    // a record is the arrival time in milliseconds, the size and the unread message bytes
+    try {
+        const uint16 size = inputMessage->getUnreadSize();
+        m_recordFile->addU32(m_recordTimer.elapsed_millis());
+        m_recordFile->addU16(size);
+        m_recordFile->write(inputMessage->getReadBuffer(), size);
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Protocol recording stopped: %s", e.what()));
+        m_recordFile = nullptr;
+    }
+}
+
+void Protocol::countMessage(const InputMessagePtr& inputMessage, bool compressed)
+{
+    if(compressed)
+        m_compressedBytes += inputMessage->getUnreadSize();
+    else
+        m_uncompressedBytes += inputMessage->getUnreadSize();
+}
+
+void Protocol::countArrival()
+{
+    const ticks_t now = stdext::micros();
+    if(m_lastArrival > 0)
+        m_arrivalGaps.push(static_cast<uint32>(std::min<ticks_t>(now - m_lastArrival, std::numeric_limits<uint32>::max())));
+    m_lastArrival = now;
+}
+
+std::map<std::string, double> Protocol::getArrivalStats()
+{
+    std::map<std::string, double> stats;
+    stats["count"] = m_arrivalGaps.size();
+    stats["lastMicros"] = m_arrivalGaps.last();
+    stats["avgMicros"] = m_arrivalGaps.average();
+    stats["maxMicros"] = m_arrivalGaps.max();
+    stats["p50"] = m_arrivalGaps.percentile(0.5);
+    stats["p95"] = m_arrivalGaps.percentile(0.95);
+    stats["p99"] = m_arrivalGaps.percentile(0.99);
+    return stats;
+}
+
+uint32 Protocol::xteaEncrypt(const OutputMessagePtr& outputMessage, bool checksum)
 {
     outputMessage->writeMessageSize();
     uint16 encryptedSize = outputMessage->getMessageSize();
@@ -211,12 +646,89 @@ void Protocol::xteaEncrypt(const OutputMessagePtr& outputMessage)
         encryptedSize += n;
     }
 
-    for(uint32_t i = 0, sum = 0, next_sum = sum + delta; i < 32; ++i, sum = next_sum, next_sum += delta) {
-        apply_rounds(outputMessage->getDataBuffer() - 2, encryptedSize, [&](uint32_t& left, uint32_t& right) {
-            left += ((right << 4 ^ right >> 5) + right) ^ (sum + m_xteaKey[sum & 3]);
-            right += ((left << 4 ^ left >> 5) + left) ^ (next_sum + m_xteaKey[(next_sum >> 11) & 3]);
-        });
-    };
+    if(!checksum) {
+        xteaBlocks<true>(outputMessage->getDataBuffer() - 2, encryptedSize, m_xteaKey);
+        return 0;
+    }
+    return xteaBlocksChecksum<true>(outputMessage->getDataBuffer() - 2, encryptedSize, m_xteaKey);
+}
+
+std::tuple<double, double> Protocol::benchmarkXtea(uint32 messageSize)
+{
+    // whole blocks only, enough rounds to push 64 MiB through each direction
+    messageSize = std::max<uint32>(8, messageSize - messageSize % 8);
+    const uint32 iterations = std::max<uint32>(1, (64 * 1024 * 1024) / messageSize);
+
+    std::vector<uint8> buffer(messageSize);
+    std::mt19937 gen(messageSize);
+    std::generate(buffer.begin(), buffer.end(), [&]() { return static_cast<uint8>(gen()); });
+    const std::array<uint32, 4> key = { gen(), gen(), gen(), gen() };
+
+    stdext::timer timer;
+    for(uint32 i = 0; i < iterations; ++i)
+        xteaBlocks<true>(buffer.data(), buffer.size(), key);
+    const ticks_t encryptElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+    timer.restart();
+    for(uint32 i = 0; i < iterations; ++i)
+        xteaBlocks<false>(buffer.data(), buffer.size(), key);
+    const ticks_t decryptElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+    const double megabytes = static_cast<double>(messageSize) * iterations / (1024 * 1024);
+    const double encryptSpeed = megabytes * 1000000.0 / encryptElapsed;
+    const double decryptSpeed = megabytes * 1000000.0 / decryptElapsed;
+    g_logger.info(stdext::format("XTEA with %d byte messages: encrypt %.1f MB/s, decrypt %.1f MB/s", messageSize, encryptSpeed, decryptSpeed));
+    return std::make_tuple(encryptSpeed, decryptSpeed);
+}
+
+std::tuple<double, double, double> Protocol::benchmarkChecksum()
+{
+    // mostly short updates with the occasional large map description, like a real session
+    std::mt19937 gen(0x41444C52);
+    std::vector<std::vector<uint8>> messages(1024);
+    size_t totalSize = 0;
+    for(size_t i = 0; i < messages.size(); ++i) {
+        const uint32 kind = gen() % 100;
+        const uint32 size = kind < 80 ? 8 + gen() % 120 : (kind < 97 ? 128 + gen() % 1920 : 8192 + gen() % 16384);
+        messages[i].resize(size - size % 8 + 8);
+        std::generate(messages[i].begin(), messages[i].end(), [&]() { return static_cast<uint8>(gen()); });
+        totalSize += messages[i].size();
+    }
+    const std::array<uint32, 4> key = { gen(), gen(), gen(), gen() };
+    const uint32 iterations = std::max<uint32>(1, (64 * 1024 * 1024) / totalSize);
+
+    // the results are summed up so the loops can't be optimized away
+    uint32 sink = 0;
+    stdext::timer timer;
+    for(uint32 i = 0; i < iterations; ++i) {
+        for(auto& message : messages)
+            sink += stdext::adler32(message.data(), message.size());
+    }
+    const ticks_t checksumElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+    timer.restart();
+    for(uint32 i = 0; i < iterations; ++i) {
+        for(auto& message : messages) {
+            sink += stdext::adler32(message.data(), message.size());
+            xteaBlocks<false>(message.data(), message.size(), key);
+        }
+    }
+    const ticks_t separateElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+    timer.restart();
+    for(uint32 i = 0; i < iterations; ++i) {
+        for(auto& message : messages)
+            sink += xteaBlocksChecksum<false>(message.data(), message.size(), key);
+    }
+    const ticks_t fusedElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+    const double megabytes = static_cast<double>(totalSize) * iterations / (1024 * 1024);
+    const double checksumSpeed = megabytes * 1000000.0 / checksumElapsed;
+    const double separateSpeed = megabytes * 1000000.0 / separateElapsed;
+    const double fusedSpeed = megabytes * 1000000.0 / fusedElapsed;
+    g_logger.info(stdext::format("adler32 over %d mixed messages: checksum %.1f MB/s, checksum then decrypt %.1f MB/s, fused %.1f MB/s (%d)",
+                                 static_cast<int>(messages.size()), checksumSpeed, separateSpeed, fusedSpeed, static_cast<int>(sink & 1)));
+    return std::make_tuple(checksumSpeed, separateSpeed, fusedSpeed);
 }
 
 void Protocol::onConnect()
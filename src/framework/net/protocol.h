@@ -29,11 +29,20 @@
 #include "connection.h"
 
 #include <framework/luaengine/luaobject.h>
+#include <framework/stdext/rolling_window.h>
+
+struct z_stream_s;
 
  // @bindclass
 class Protocol : public LuaObject
 {
 public:
+    enum {
+        RECORD_SIGNATURE = 0x5243544F, // "OTCR"
+        RECORD_VERSION = 1,
+        ARRIVAL_WINDOW = 256 // messages kept for the inter-arrival percentiles
+    };
+
     Protocol();
     virtual ~Protocol();
 
@@ -53,10 +62,43 @@ public:
     void enableXteaEncryption() { m_xteaEncryptionEnabled = true; }
 
     void enableChecksum() { m_checksumEnabled = true; }
+    // incoming checksums are still stripped but not compared, tcp already guards the data; outgoing ones are always written
+    void setChecksumVerification(bool enabled) { m_checksumVerification = enabled; }
+    bool isChecksumVerification() { return m_checksumVerification; }
+
+    // incoming messages carry a sequence number instead of the checksum, its high bit marks a deflated body
+    void enableCompression() { m_compressionEnabled = true; }
+    // preset dictionary for the inflate stream, must be set before the first compressed message
+    void setCompressionDictionary(const std::string& dictionary) { m_compressionDictionary = dictionary; }
+    uint64 getCompressedBytes() { return m_compressedBytes; }
+    uint64 getInflatedBytes() { return m_inflatedBytes; }
+    uint64 getUncompressedBytes() { return m_uncompressedBytes; }
+
+    // time between consecutive messages reaching the main thread over the last ARRIVAL_WINDOW messages,
+    // count, last, avg, max and the 50/95/99 percentiles in microseconds
+    std::map<std::string, double> getArrivalStats();
+    uint64 getReadBytes() { return m_connection ? m_connection->getReadBytes() : 0; }
+    uint64 getWrittenBytes() { return m_connection ? m_connection->getWrittenBytes() : 0; }
+    uint64 getQueuedBytes() { return m_connection ? m_connection->getQueuedBytes() : 0; }
+
+    // messages starting with an urgent opcode are flushed at once, the rest is batched by the connection
+    void setUrgentOpcode(uint8 opcode, bool urgent) { m_urgentOpcodes[opcode] = urgent; }
+    void setWriteBatchDelay(int micros);
 
     virtual void send(const OutputMessagePtr& outputMessage);
     virtual void recv();
 
+    // writes every message handed to onRecv, already decrypted and inflated, with its arrival time
+    bool startRecording(const std::string& fileName);
+    void stopRecording();
+    bool isRecording() { return m_recordFile != nullptr; }
+
+    // encrypts and decrypts messages of the given size in a loop, returns both speeds in MB/s
+    static std::tuple<double, double> benchmarkXtea(uint32 messageSize);
+    // runs a mix of small, medium and map sized messages through the checksum alone, the checksum
+    // followed by decryption and the fused pass, returns the three speeds in MB/s
+    static std::tuple<double, double, double> benchmarkChecksum();
+
     ProtocolPtr asProtocol() { return static_self_cast<Protocol>(); }
 
 protected:
@@ -69,12 +111,33 @@ protected:
 private:
     void internalRecvHeader(uint8* buffer, uint16 size);
     void internalRecvData(uint8* buffer, uint16 size);
-
-    bool xteaDecrypt(const InputMessagePtr& inputMessage);
-    void xteaEncrypt(const OutputMessagePtr& outputMessage);
+    void internalRecvFrame(const ReceiveBufferPtr& buffer, uint16 size);
+    int getHeaderSize();
+
+    // with a checksum the encrypted bytes are verified against it in the same pass
+    bool xteaDecrypt(const InputMessagePtr& inputMessage, const uint32* checksum = nullptr);
+    // returns the checksum of the encrypted message when asked for it
+    uint32 xteaEncrypt(const OutputMessagePtr& outputMessage, bool checksum = false);
+    bool inflateMessage(const InputMessagePtr& inputMessage);
+    void countMessage(const InputMessagePtr& inputMessage, bool compressed);
+    void countArrival();
+    void recordMessage(const InputMessagePtr& inputMessage);
 
     bool m_checksumEnabled;
+    bool m_checksumVerification;
     bool m_xteaEncryptionEnabled;
+    bool m_compressionEnabled;
+    std::string m_compressionDictionary;
+    std::bitset<256> m_urgentOpcodes;
+    int m_writeBatchDelay;
+    FileStreamPtr m_recordFile;
+    stdext::timer m_recordTimer;
+    std::unique_ptr<z_stream_s> m_inflateStream;
+    uint64 m_compressedBytes;
+    uint64 m_inflatedBytes;
+    uint64 m_uncompressedBytes;
+    ticks_t m_lastArrival;
+    stdext::rolling_window<uint32, ARRIVAL_WINDOW> m_arrivalGaps;
     ConnectionPtr m_connection;
     InputMessagePtr m_inputMessage;
 };
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "receivebuffer.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace {
+    // buffers above this count are allocated on demand and freed once released
+    constexpr size_t MAX_POOLED_BUFFERS = 32;
+
+    std::mutex g_poolMutex;
+    std::vector<ReceiveBufferPtr> g_pool;
+}
+
+ReceiveBufferPtr ReceiveBuffer::acquire()
+{
+    std::lock_guard<std::mutex> lock(g_poolMutex);
+
+    // a buffer only referenced by the pool is free, new references to it can only come from here
+    for(const ReceiveBufferPtr& buffer : g_pool) {
+        if(buffer.use_count() == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return buffer;
+        }
+    }
+
+    ReceiveBufferPtr buffer = std::make_shared<ReceiveBuffer>();
+    if(g_pool.size() < MAX_POOLED_BUFFERS)
+        g_pool.push_back(buffer);
+    return buffer;
+}
@@ -22,16 +22,38 @@
 
 #include "server.h"
 #include "connection.h"
+#include "threadedserver.h"
+#include <framework/core/asyncdispatcher.h>
 
 extern asio::io_service g_ioService;
 
 Server::Server(int port)
-    : m_acceptor(g_ioService, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port))
+    : m_acceptor(new asio::ip::tcp::acceptor(g_ioService, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)))
 {
+    ++Connection::m_instances;
+}
+
+Server::Server(const std::shared_ptr<ThreadedServer>& threaded)
+    : m_threaded(threaded)
+{
+}
+
+Server::~Server()
+{
+    if(m_threaded)
+        m_threaded->stop();
+    else
+        --Connection::m_instances;
 }
 
 ServerPtr Server::create(int port)
 {
+    // accept handlers call into lua, they can't run on the network thread
+    if(Connection::isNetworkThreadEnabled()) {
+        g_logger.error("Failed to initialize server: not supported while the network thread is enabled");
+        return ServerPtr();
+    }
+
     try {
         Server* server = new Server(port);
         return ServerPtr(server);
@@ -41,19 +63,53 @@ ServerPtr Server::create(int port)
     }
 }
 
+ServerPtr Server::createThreaded(int port, int threads)
+{
+    // it never touches g_ioService, so it works with or without the network thread
+    std::shared_ptr<ThreadedServer> threaded;
+    try {
+        threaded = std::make_shared<ThreadedServer>(port);
+    } catch(const std::exception& e) {
+        g_logger.error(stdext::format("Failed to initialize threaded server: %s", e.what()));
+        return ServerPtr();
+    }
+
+    const ServerPtr server(new Server(threaded));
+
+    // io threads may not touch the server, the main thread checks it is still there before dispatching
+    Server* serverPtr = server.get();
+    const std::weak_ptr<ThreadedServer> weakThreaded = threaded;
+    threaded->setEventNotifier([serverPtr, weakThreaded] {
+        g_asyncDispatcher.addMainThreadCallback([serverPtr, weakThreaded] {
+            if(!weakThreaded.expired())
+                serverPtr->dispatchThreadedEvents();
+        });
+    });
+    threaded->start(threads);
+    return server;
+}
+
 void Server::close()
 {
     m_isOpen = false;
-    m_acceptor.cancel();
-    m_acceptor.close();
+    if(m_threaded) {
+        m_threaded->stop();
+        return;
+    }
+    m_acceptor->cancel();
+    m_acceptor->close();
 }
 
 void Server::acceptNext()
 {
+    // threaded servers accept on their own
+    if(m_threaded)
+        return;
+
     ConnectionPtr connection = ConnectionPtr(new Connection);
     connection->m_connecting = true;
     auto self = static_self_cast<Server>();
-    m_acceptor.async_accept(connection->m_socket, [=](const boost::system::error_code& error) {
+    m_acceptor->async_accept(connection->m_socket, [=](const boost::system::error_code& error) {
         if(!error) {
             connection->m_connected = true;
             connection->m_connecting = false;
@@ -61,3 +117,49 @@ void Server::acceptNext()
         self->callLuaField("onAccept", connection, error.message(), error.value());
     });
 }
+
+bool Server::send(uint32 sessionId, const std::string& data)
+{
+    return m_threaded && m_threaded->send(sessionId, data);
+}
+
+void Server::broadcast(const std::string& data)
+{
+    if(m_threaded)
+        m_threaded->broadcast(data);
+}
+
+void Server::disconnect(uint32 sessionId)
+{
+    if(m_threaded)
+        m_threaded->disconnect(sessionId);
+}
+
+int Server::getSessionCount()
+{
+    return m_threaded ? m_threaded->getSessionCount() : 0;
+}
+
+uint64 Server::getDroppedFrameCount()
+{
+    return m_threaded ? m_threaded->getDroppedFrameCount() : 0;
+}
+
+void Server::dispatchThreadedEvents()
+{
+    // a lua handler may drop the last reference
+    const ServerPtr self = static_self_cast<Server>();
+    for(ThreadedServer::Event& event : m_threaded->takeEvents()) {
+        switch(event.type) {
+            case ThreadedServer::SessionOpened:
+                callLuaField("onSessionOpen", event.sessionId, event.data);
+                break;
+            case ThreadedServer::FrameReceived:
+                callLuaField("onMessage", event.sessionId, event.data);
+                break;
+            case ThreadedServer::SessionClosed:
+                callLuaField("onSessionClose", event.sessionId, event.data);
+                break;
+        }
+    }
+}
@@ -26,19 +26,36 @@
 #include "declarations.h"
 #include <framework/luaengine/luaobject.h>
 
+class ThreadedServer;
+
 class Server : public LuaObject
 {
 public:
     Server(int port);
+    Server(const std::shared_ptr<ThreadedServer>& threaded);
+    ~Server();
     static ServerPtr create(int port);
+    // serves length prefixed frames on io threads of its own, lua gets onSessionOpen, onMessage and onSessionClose
+    static ServerPtr createThreaded(int port, int threads);
     bool isOpen() { return m_isOpen; }
+    bool isThreaded() { return m_threaded != nullptr; }
     void close();
 
     void acceptNext();
 
+    // threaded mode only
+    bool send(uint32 sessionId, const std::string& data);
+    void broadcast(const std::string& data);
+    void disconnect(uint32 sessionId);
+    int getSessionCount();
+    uint64 getDroppedFrameCount();
+
 private:
+    void dispatchThreadedEvents();
+
     stdext::boolean<true> m_isOpen;
-    asio::ip::tcp::acceptor m_acceptor;
+    std::unique_ptr<asio::ip::tcp::acceptor> m_acceptor;
+    std::shared_ptr<ThreadedServer> m_threaded;
 };
 
 #endif
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "threadedserver.h"
+
+struct ThreadedServer::Session {
+    Session(asio::io_service& ioService) : socket(ioService), strand(ioService) {}
+
+    uint32 id = 0;
+    asio::ip::tcp::socket socket;
+    asio::io_service::strand strand;
+
+    // strand only
+    uint8 header[HEADER_SIZE];
+    std::string payload;
+    std::deque<std::string> writeQueue;
+    bool readPaused = false;
+    bool closed = false;
+
+    std::atomic<size_t> queuedBytes{0}; // reserved by send on the main thread, released once written
+    std::atomic<int> pendingFrames{0}; // received frames the main thread has not taken yet
+};
+
+ThreadedServer::ThreadedServer(int port) :
+    m_acceptor(m_ioService, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port))
+{
+}
+
+void ThreadedServer::start(int threads)
+{
+    if(!m_threads.empty())
+        return;
+
+    acceptNext();
+    for(int i = 0; i < std::max<int>(threads, 1); ++i)
+        m_threads.emplace_back([this] { m_ioService.run(); });
+}
+
+void ThreadedServer::stop()
+{
+    if(m_threads.empty())
+        return;
+
+    m_ioService.stop();
+    for(std::thread& thread : m_threads)
+        thread.join();
+    m_threads.clear();
+
+    // no handler runs anymore, everything can be closed from here
+    boost::system::error_code ec;
+    m_acceptor.close(ec);
+
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    for(const auto& it : m_sessions)
+        it.second->socket.close(ec);
+    m_sessions.clear();
+}
+
+std::vector<ThreadedServer::Event> ThreadedServer::takeEvents()
+{
+    std::vector<QueuedEvent> queuedEvents;
+    {
+        std::lock_guard<std::mutex> lock(m_eventsMutex);
+        queuedEvents.swap(m_events);
+    }
+
+    std::vector<Event> events;
+    events.reserve(queuedEvents.size());
+    for(QueuedEvent& queuedEvent : queuedEvents) {
+        const SessionPtr& session = queuedEvent.session;
+
+        // the session stopped reading when it reached the limit, the first frame taken lets it go on
+        if(queuedEvent.type == FrameReceived && session->pendingFrames-- == MAX_PENDING_FRAMES) {
+            session->strand.post([this, session] {
+                if(session->readPaused && !session->closed) {
+                    session->readPaused = false;
+                    readFrame(session);
+                }
+            });
+        }
+
+        events.push_back(Event{queuedEvent.type, session->id, std::move(queuedEvent.data)});
+    }
+    return events;
+}
+
+bool ThreadedServer::send(uint32 sessionId, const std::string& payload)
+{
+    const SessionPtr session = findSession(sessionId);
+    if(!session)
+        return false;
+
+    // slow clients lose frames instead of growing the queue
+    const size_t size = HEADER_SIZE + payload.size();
+    if(payload.size() > MAX_FRAME_SIZE || session->queuedBytes + size > MAX_WRITE_QUEUE) {
+        ++m_droppedFrames;
+        return false;
+    }
+    session->queuedBytes += size;
+
+    session->strand.post([this, session, data = frame(payload)]() mutable {
+        if(session->closed)
+            return;
+        session->writeQueue.push_back(std::move(data));
+        if(session->writeQueue.size() == 1)
+            writeNext(session);
+    });
+    return true;
+}
+
+void ThreadedServer::broadcast(const std::string& payload)
+{
+    std::vector<uint32> sessionIds;
+    {
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        for(const auto& it : m_sessions)
+            sessionIds.push_back(it.first);
+    }
+
+    for(const uint32 sessionId : sessionIds)
+        send(sessionId, payload);
+}
+
+void ThreadedServer::disconnect(uint32 sessionId)
+{
+    if(const SessionPtr session = findSession(sessionId))
+        session->strand.post([this, session] { closeSession(session, asio::error::operation_aborted); });
+}
+
+int ThreadedServer::getSessionCount()
+{
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    return m_sessions.size();
+}
+
+std::string ThreadedServer::frame(const std::string& payload)
+{
+    const uint32 size = payload.size();
+    std::string data(HEADER_SIZE, '\0');
+    for(int i = 0; i < HEADER_SIZE; ++i)
+        data[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+    data += payload;
+    return data;
+}
+
+uint32 ThreadedServer::readFrameSize(const uint8* header)
+{
+    uint32 size = 0;
+    for(int i = 0; i < HEADER_SIZE; ++i)
+        size |= static_cast<uint32>(header[i]) << (8 * i);
+    return size;
+}
+
+void ThreadedServer::acceptNext()
+{
+    const auto session = std::make_shared<Session>(m_ioService);
+    m_acceptor.async_accept(session->socket, [this, session](const boost::system::error_code& error) {
+        if(error == asio::error::operation_aborted)
+            return;
+
+        if(!error) {
+            boost::system::error_code ec;
+            session->socket.set_option(asio::ip::tcp::no_delay(true), ec);
+            const std::string address = session->socket.remote_endpoint(ec).address().to_string();
+            {
+                std::lock_guard<std::mutex> lock(m_sessionsMutex);
+                session->id = ++m_lastSessionId;
+                m_sessions[session->id] = session;
+            }
+            pushEvent(QueuedEvent{SessionOpened, session, address});
+            session->strand.dispatch([this, session] { readFrame(session); });
+        }
+
+        acceptNext();
+    });
+}
+
+void ThreadedServer::readFrame(const SessionPtr& session)
+{
+    asio::async_read(session->socket, asio::buffer(session->header), session->strand.wrap([this, session](const boost::system::error_code& error, size_t) {
+        if(error) {
+            closeSession(session, error);
+            return;
+        }
+
+        const uint32 size = readFrameSize(session->header);
+        if(size > MAX_FRAME_SIZE) {
+            closeSession(session, asio::error::message_size);
+            return;
+        }
+
+        session->payload.resize(size);
+        if(size == 0) {
+            onFrame(session);
+            return;
+        }
+
+        asio::async_read(session->socket, asio::buffer(&session->payload[0], size), session->strand.wrap([this, session](const boost::system::error_code& error, size_t) {
+            if(error)
+                closeSession(session, error);
+            else
+                onFrame(session);
+        }));
+    }));
+}
+
+void ThreadedServer::onFrame(const SessionPtr& session)
+{
+    // counted before the main thread can see the frame, it releases the count when taking it
+    const bool paused = ++session->pendingFrames >= MAX_PENDING_FRAMES;
+    pushEvent(QueuedEvent{FrameReceived, session, std::move(session->payload)});
+    session->payload = std::string();
+
+    if(paused)
+        session->readPaused = true;
+    else
+        readFrame(session);
+}
+
+void ThreadedServer::writeNext(const SessionPtr& session)
+{
+    asio::async_write(session->socket, asio::buffer(session->writeQueue.front()), session->strand.wrap([this, session](const boost::system::error_code& error, size_t) {
+        session->queuedBytes -= session->writeQueue.front().size();
+        session->writeQueue.pop_front();
+
+        if(error)
+            closeSession(session, error);
+        else if(!session->writeQueue.empty())
+            writeNext(session);
+    }));
+}
+
+void ThreadedServer::closeSession(const SessionPtr& session, const boost::system::error_code& error)
+{
+    if(session->closed)
+        return;
+    session->closed = true;
+
+    boost::system::error_code ec;
+    session->socket.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+    session->socket.close(ec);
+    {
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        m_sessions.erase(session->id);
+    }
+    pushEvent(QueuedEvent{SessionClosed, session, error.message()});
+}
+
+void ThreadedServer::pushEvent(QueuedEvent&& event)
+{
+    bool notify;
+    {
+        std::lock_guard<std::mutex> lock(m_eventsMutex);
+        notify = m_events.empty();
+        m_events.push_back(std::move(event));
+    }
+
+    if(notify && m_eventNotifier)
+        m_eventNotifier();
+}
+
+ThreadedServer::SessionPtr ThreadedServer::findSession(uint32 sessionId)
+{
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    const auto it = m_sessions.find(sessionId);
+    return it != m_sessions.end() ? it->second : nullptr;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef THREADEDSERVER_H
+#define THREADEDSERVER_H
+
+#include "declarations.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// accepts clients and exchanges length prefixed frames on io threads of its own, the handlers of a session
+// run through its strand so they never overlap; the main thread only ever sees whole frames
+class ThreadedServer
+{
+public:
+    enum {
+        HEADER_SIZE = 4, // little endian payload length
+        MAX_FRAME_SIZE = 1024 * 1024, // a bigger frame closes the session
+        MAX_WRITE_QUEUE = 256 * 1024, // bytes a slow client may have queued, frames beyond are dropped
+        MAX_PENDING_FRAMES = 64 // frames of a session waiting for the main thread before its reads pause
+    };
+
+    enum EventType {
+        SessionOpened,
+        FrameReceived,
+        SessionClosed
+    };
+
+    struct Event {
+        EventType type;
+        uint32 sessionId;
+        std::string data; // remote address, payload or close reason
+    };
+
+    // throws when the port can't be bound
+    ThreadedServer(int port);
+    ~ThreadedServer() { stop(); }
+
+    void start(int threads);
+    void stop();
+
+    // called from an io thread whenever events arrive while none were waiting
+    void setEventNotifier(const std::function<void()>& notifier) { m_eventNotifier = notifier; }
+    // events since the last call, main thread only
+    std::vector<Event> takeEvents();
+
+    bool send(uint32 sessionId, const std::string& payload);
+    void broadcast(const std::string& payload);
+    void disconnect(uint32 sessionId);
+
+    int getSessionCount();
+    uint64 getDroppedFrameCount() { return m_droppedFrames; }
+
+    static std::string frame(const std::string& payload);
+    static uint32 readFrameSize(const uint8* header);
+
+private:
+    struct Session;
+    typedef std::shared_ptr<Session> SessionPtr;
+
+    struct QueuedEvent {
+        EventType type;
+        SessionPtr session;
+        std::string data;
+    };
+
+    void acceptNext();
+    void readFrame(const SessionPtr& session);
+    void onFrame(const SessionPtr& session);
+    void writeNext(const SessionPtr& session);
+    void closeSession(const SessionPtr& session, const boost::system::error_code& error);
+    void pushEvent(QueuedEvent&& event);
+    SessionPtr findSession(uint32 sessionId);
+
+    asio::io_service m_ioService;
+    asio::ip::tcp::acceptor m_acceptor;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_sessionsMutex;
+    std::unordered_map<uint32, SessionPtr> m_sessions;
+    uint32 m_lastSessionId = 0;
+
+    std::mutex m_eventsMutex;
+    std::vector<QueuedEvent> m_events;
+    std::function<void()> m_eventNotifier;
+
+    std::atomic<uint64> m_droppedFrames{0};
+};
+
+#endif
@@ -29,6 +29,7 @@ class OTMLNode;
 class OTMLDocument;
 class OTMLParser;
 class OTMLEmitter;
+class OTMLBinary;
 
 typedef stdext::shared_object_ptr<OTMLNode> OTMLNodePtr;
 typedef stdext::shared_object_ptr<OTMLDocument> OTMLDocumentPtr;
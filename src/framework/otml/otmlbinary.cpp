@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "otmlbinary.h"
+#include "otmldocument.h"
+
+namespace {
+
+enum {
+    NODE_UNIQUE = 1,
+    NODE_NULL = 2
+};
+
+struct CompiledNode
+{
+    uint32 tag;
+    uint32 value;
+    uint32 source;
+    uint32 firstChild;
+    uint32 childCount;
+    uint32 flags;
+};
+
+}
+
+std::string OTMLBinary::compile(const OTMLNodePtr& root, const std::string& key, ticks_t modTime, uint64 size)
+{
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32> index;
+    std::vector<CompiledNode> nodes;
+
+    auto intern = [&](const std::string& str) -> uint32 {
+        auto it = index.find(str);
+        if(it != index.end())
+            return it->second;
+        uint32 id = strings.size();
+        strings.push_back(str);
+        index.emplace(str, id);
+        return id;
+    };
+
+    // the children of every node are allocated as one block before descending into them
+    std::function<void(uint32, const OTMLNodePtr&)> add = [&](uint32 id, const OTMLNodePtr& node) {
+        const uint32 first = nodes.size();
+        nodes[id].tag = intern(node->m_tag);
+        nodes[id].value = intern(node->m_value);
+        nodes[id].source = intern(node->m_source);
+        nodes[id].flags = (node->m_unique ? NODE_UNIQUE : 0) | (node->m_null ? NODE_NULL : 0);
+        nodes[id].firstChild = first;
+        nodes[id].childCount = node->m_children.size();
+
+        nodes.resize(first + node->m_children.size());
+        for(uint i = 0; i < node->m_children.size(); ++i)
+            add(first + i, node->m_children[i]);
+    };
+
+    intern(key);
+    nodes.resize(1);
+    add(0, root);
+
+    uint32 blobSize = 0;
+    for(const std::string& str : strings)
+        blobSize += str.size();
+
+    const uint32 stringCount = strings.size();
+    const uint32 nodeCount = nodes.size();
+    std::string out(HEADER_SIZE + 4 * (stringCount + 1) + NODE_SIZE * nodeCount + blobSize, '\0');
+    uint8* p = (uint8*)&out[0];
+
+    stdext::writeULE32(p, MAGIC);
+    stdext::writeULE32(p + 4, FORMAT);
+    stdext::writeULE64(p + 8, modTime);
+    stdext::writeULE64(p + 16, size);
+    stdext::writeULE32(p + 24, stringCount);
+    stdext::writeULE32(p + 28, nodeCount);
+    stdext::writeULE32(p + 32, blobSize);
+    p += HEADER_SIZE;
+
+    uint32 offset = 0;
+    for(const std::string& str : strings) {
+        stdext::writeULE32(p, offset);
+        offset += str.size();
+        p += 4;
+    }
+    stdext::writeULE32(p, offset);
+    p += 4;
+
+    for(const CompiledNode& node : nodes) {
+        stdext::writeULE32(p, node.tag);
+        stdext::writeULE32(p + 4, node.value);
+        stdext::writeULE32(p + 8, node.source);
+        stdext::writeULE32(p + 12, node.firstChild);
+        stdext::writeULE32(p + 16, node.childCount);
+        stdext::writeULE32(p + 20, node.flags);
+        p += NODE_SIZE;
+    }
+
+    for(const std::string& str : strings) {
+        memcpy(p, str.data(), str.size());
+        p += str.size();
+    }
+    return out;
+}
+
+bool OTMLBinary::isValid(const uint8* data, uint size, const std::string& key, ticks_t modTime, uint64 fileSize)
+{
+    if(!data || size < HEADER_SIZE + 8 || stdext::readULE32(data) != MAGIC || stdext::readULE32(data + 4) != FORMAT)
+        return false;
+    if((ticks_t)stdext::readULE64(data + 8) != modTime || stdext::readULE64(data + 16) != fileSize)
+        return false;
+
+    const uint64 stringCount = stdext::readULE32(data + 24);
+    const uint64 nodeCount = stdext::readULE32(data + 28);
+    const uint64 blobSize = stdext::readULE32(data + 32);
+    if(stringCount == 0 || nodeCount == 0 || HEADER_SIZE + 4 * (stringCount + 1) + NODE_SIZE * nodeCount + blobSize != size)
+        return false;
+
+    // the first string is the key the data was compiled for
+    const uint8* offsets = data + HEADER_SIZE;
+    const uint8* blob = offsets + 4 * (stringCount + 1) + NODE_SIZE * nodeCount;
+    const uint32 begin = stdext::readULE32(offsets);
+    const uint32 end = stdext::readULE32(offsets + 4);
+    return begin <= end && end <= blobSize && std::string((const char*)blob + begin, end - begin) == key;
+}
+
+OTMLDocumentPtr OTMLBinary::load(const uint8* data, uint size)
+{
+    if(!data || size < HEADER_SIZE || stdext::readULE32(data) != MAGIC || stdext::readULE32(data + 4) != FORMAT)
+        stdext::throw_exception("not a compiled otml");
+
+    const uint64 stringCount = stdext::readULE32(data + 24);
+    const uint64 nodeCount = stdext::readULE32(data + 28);
+    const uint64 blobSize = stdext::readULE32(data + 32);
+    if(nodeCount == 0 || HEADER_SIZE + 4 * (stringCount + 1) + NODE_SIZE * nodeCount + blobSize != size)
+        stdext::throw_exception("compiled otml has an invalid size");
+
+    const uint8* offsets = data + HEADER_SIZE;
+    const uint8* nodes = offsets + 4 * (stringCount + 1);
+    const char* blob = (const char*)(nodes + NODE_SIZE * nodeCount);
+
+    std::vector<std::string> strings(stringCount);
+    for(uint i = 0; i < stringCount; ++i) {
+        const uint32 begin = stdext::readULE32(offsets + 4 * i);
+        const uint32 end = stdext::readULE32(offsets + 4 * (i + 1));
+        if(begin > end || end > blobSize)
+            stdext::throw_exception("compiled otml has an invalid string table");
+        strings[i].assign(blob + begin, end - begin);
+    }
+
+    auto string = [&](uint32 id) -> const std::string& {
+        if(id >= stringCount)
+            stdext::throw_exception("compiled otml has an invalid string index");
+        return strings[id];
+    };
+
+    // children always come after their parent, which also rules out cycles
+    std::function<void(uint32, const OTMLNodePtr&)> build = [&](uint32 id, const OTMLNodePtr& node) {
+        const uint8* p = nodes + NODE_SIZE * id;
+        const uint32 firstChild = stdext::readULE32(p + 12);
+        const uint32 childCount = stdext::readULE32(p + 16);
+        const uint32 flags = stdext::readULE32(p + 20);
+        if(childCount > 0 && (firstChild <= id || (uint64)firstChild + childCount > nodeCount))
+            stdext::throw_exception("compiled otml has an invalid node");
+
+        node->setTag(string(stdext::readULE32(p)));
+        node->setValue(string(stdext::readULE32(p + 4)));
+        node->setSource(string(stdext::readULE32(p + 8)));
+        node->setUnique(flags & NODE_UNIQUE);
+        node->setNull(flags & NODE_NULL);
+
+        node->m_children.reserve(childCount);
+        for(uint32 i = 0; i < childCount; ++i) {
+            OTMLNodePtr child = OTMLNode::create();
+            node->m_children.push_back(child);
+            build(firstChild + i, child);
+        }
+    };
+
+    OTMLDocumentPtr doc = OTMLDocument::create();
+    build(0, doc);
+    return doc;
+}
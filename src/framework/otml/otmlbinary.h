@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef OTMLBINARY_H
+#define OTMLBINARY_H
+
+#include "declarations.h"
+
+/// Compiled form of an OTML tree. Tags, values and sources are interned in a string table
+/// and nodes live in one arena where the children of a node are contiguous and referenced
+/// by index, so the data can be mapped from disk and turned into nodes without tokenizing.
+class OTMLBinary
+{
+public:
+    enum {
+        MAGIC = 0x424D544F, // OTMB
+        FORMAT = 1, // bump whenever the layout changes
+        HEADER_SIZE = 40,
+        NODE_SIZE = 24
+    };
+
+    /// Compiles a parsed tree, modTime and size describe the text it came from
+    static std::string compile(const OTMLNodePtr& root, const std::string& key, ticks_t modTime, uint64 size);
+
+    /// Checks that data is a compiled tree of the given text file version
+    static bool isValid(const uint8* data, uint size, const std::string& key, ticks_t modTime, uint64 fileSize);
+
+    /// Rebuilds a document from compiled data
+    /// @exception stdext::exception when the data is malformed
+    static OTMLDocumentPtr load(const uint8* data, uint size);
+};
+
+#endif
@@ -146,6 +146,7 @@ void OTMLNode::copy(const OTMLNodePtr& node)
 {
     setTag(node->tag());
     setValue(node->rawValue());
+    shareParsedValue(node.get());
     setUnique(node->isUnique());
     setNull(node->isNull());
     setSource(node->source());
@@ -181,6 +182,7 @@ OTMLNodePtr OTMLNode::clone()
     OTMLNodePtr myClone(new OTMLNode);
     myClone->setTag(m_tag);
     myClone->setValue(m_value);
+    myClone->shareParsedValue(this);
     myClone->setUnique(m_unique);
     myClone->setNull(m_null);
     myClone->setSource(m_source);
@@ -189,6 +191,16 @@ OTMLNodePtr OTMLNode::clone()
     return myClone;
 }
 
+void OTMLNode::shareParsedValue(OTMLNode* source)
+{
+    if(source->m_value.empty())
+        return;
+
+    if(!source->m_parsedValue)
+        source->m_parsedValue = std::make_shared<std::any>();
+    m_parsedValue = source->m_parsedValue;
+}
+
 std::string OTMLNode::emit()
 {
     return OTMLEmitter::emitNode(asOTMLNode(), 0);
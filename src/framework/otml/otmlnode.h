@@ -24,8 +24,10 @@
 #define OTMLNODE_H
 
 #include "declarations.h"
+#include <framework/core/stats.h>
+#include <any>
 
-class OTMLNode : public stdext::shared_object
+class OTMLNode : public stdext::shared_object, private StatsCounted<OTMLNode>
 {
 public:
     virtual ~OTMLNode() {}
@@ -48,7 +50,7 @@ public:
     bool hasChildAtIndex(int childIndex) { return !!getIndex(childIndex); }
 
     void setTag(const std::string& tag) { m_tag = tag; }
-    void setValue(const std::string& value) { m_value = value; }
+    void setValue(const std::string& value) { m_value = value; m_parsedValue = nullptr; }
     void setNull(bool null) { m_null = null; }
     void setUnique(bool unique) { m_unique = unique; }
     void setSource(const std::string& source) { m_source = source; }
@@ -94,12 +96,20 @@ public:
 protected:
     OTMLNode() : m_unique(false), m_null(false) {}
 
+    friend class OTMLBinary;
+
     OTMLNodeList m_children;
     std::string m_tag;
     std::string m_value;
     std::string m_source;
     bool m_unique;
     bool m_null;
+
+private:
+    void shareParsedValue(OTMLNode* source);
+
+    // last value<T> result, clones share it until one of them gets a new value
+    std::shared_ptr<std::any> m_parsedValue;
 };
 
 #include "otmlexception.h"
@@ -122,9 +132,16 @@ inline std::string OTMLNode::value<std::string>()
 template<typename T>
 T OTMLNode::value()
 {
+    // styles are cloned for every widget, so each value is only parsed by the first of them
+    if(!m_parsedValue)
+        m_parsedValue = std::make_shared<std::any>();
+    else if(const T* parsed = std::any_cast<T>(m_parsedValue.get()))
+        return *parsed;
+
     T ret;
     if(!stdext::cast(m_value, ret))
         throw OTMLException(asOTMLNode(), stdext::format("failed to cast node value '%s' to type '%s'", m_value, stdext::demangle_type<T>()));
+    *m_parsedValue = ret;
     return ret;
 }
 
@@ -163,6 +180,7 @@ template<typename T>
 void OTMLNode::write(const T& v)
 {
     m_value = stdext::safe_cast<std::string>(v);
+    m_parsedValue = nullptr;
 }
 
 template<typename T>
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef HEADLESS
+
+#include "nullwindow.h"
+
+void NullWindow::init()
+{
+    m_size = Size(1280, 720);
+    m_focused = true;
+}
+
+void NullWindow::terminate()
+{
+    m_visible = false;
+}
+
+void NullWindow::move(const Point& pos)
+{
+    m_position = pos;
+}
+
+void NullWindow::resize(const Size& size)
+{
+    if(size == m_size)
+        return;
+
+    m_size = size;
+    if(m_onResize)
+        m_onResize(m_size);
+}
+
+void NullWindow::show()
+{
+    m_visible = true;
+}
+
+void NullWindow::hide()
+{
+    m_visible = false;
+}
+
+void NullWindow::maximize()
+{
+    m_maximized = true;
+}
+
+void NullWindow::poll()
+{
+    // no input ever arrives, only keys held down by scripts keep repeating
+    fireKeysPress();
+}
+
+void NullWindow::waitEvents(int timeout)
+{
+    std::unique_lock<std::mutex> lock(m_wakeupMutex);
+    if(timeout < 0)
+        m_wakeupCondition.wait(lock, [this] { return m_wakeupPending; });
+    else
+        m_wakeupCondition.wait_for(lock, std::chrono::milliseconds(timeout), [this] { return m_wakeupPending; });
+    m_wakeupPending = false;
+}
+
+void NullWindow::wakeUp()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeupMutex);
+        m_wakeupPending = true;
+    }
+    m_wakeupCondition.notify_one();
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef NULLWINDOW_H
+#define NULLWINDOW_H
+
+#include "platformwindow.h"
+
+// window of headless builds, there is no display nor GL context; it reports itself visible and focused
+// once shown so the draw code paths keep running, hide() turns rendering off for load tests
+class NullWindow : public PlatformWindow
+{
+public:
+    void init();
+    void terminate();
+
+    void move(const Point& pos);
+    void resize(const Size& size);
+    void show();
+    void hide();
+    void maximize();
+    void poll();
+    void waitEvents(int timeout);
+    void wakeUp();
+    void swapBuffers() {}
+    void showMouse() {}
+    void hideMouse() {}
+
+    void setMouseCursor(int /*cursorId*/) {}
+    void restoreMouseCursor() {}
+
+    void setTitle(const std::string& /*title*/) {}
+    void setMinimumSize(const Size& minimumSize) { m_minimumSize = minimumSize; }
+    void setFullscreen(bool fullscreen) { m_fullscreen = fullscreen; }
+    void setVerticalSync(bool /*enable*/) {}
+    void setIcon(const std::string& /*iconFile*/) {}
+    void setClipboardText(const std::string& text) { m_clipboardText = text; }
+
+    Size getDisplaySize() { return m_size; }
+    std::string getClipboardText() { return m_clipboardText; }
+    std::string getPlatformType() { return "headless"; }
+
+protected:
+    int internalLoadMouseCursor(const ImagePtr& /*image*/, const Point& /*hotSpot*/) { return m_cursors++; }
+
+private:
+    std::string m_clipboardText;
+    int m_cursors{ 0 };
+
+    std::mutex m_wakeupMutex;
+    std::condition_variable m_wakeupCondition;
+    bool m_wakeupPending{ false };
+};
+
+#endif
@@ -22,7 +22,10 @@
 
 #include "platformwindow.h"
 
-#ifdef WIN32
+#if defined(HEADLESS)
+#include "nullwindow.h"
+NullWindow window;
+#elif defined(WIN32)
 #include "win32window.h"
 WIN32Window window;
 #else
@@ -166,6 +169,66 @@ void PlatformWindow::releaseAllKeys()
         mouseButtonState = false;
 }
 
+void PlatformWindow::setOnInputEvent(const OnInputEventCallback& onInputEvent)
+{
+    m_onInputEventTarget = onInputEvent;
+    // platforms keep reporting every event through m_onInputEvent, moves are held back here
+    if(onInputEvent)
+        m_onInputEvent = [this](const InputEvent& event) { handleInputEvent(event); };
+    else
+        m_onInputEvent = nullptr;
+}
+
+void PlatformWindow::setMouseMoveCoalescing(bool enable)
+{
+    if(!enable)
+        flushMouseMove();
+    m_mouseMoveCoalescing = enable;
+}
+
+void PlatformWindow::handleInputEvent(const InputEvent& event)
+{
+    if(event.type == Fw::MouseMoveInputEvent) {
+        m_rawMouseMoves++;
+        if(m_mouseMoveCoalescing) {
+            if(!m_hasPendingMouseMove) {
+                m_pendingMouseMove = event;
+                m_mouseMoveHistory.clear();
+                m_hasPendingMouseMove = true;
+            } else {
+                m_pendingMouseMove.mouseMoved += event.mouseMoved;
+                m_pendingMouseMove.mousePos = event.mousePos;
+                m_pendingMouseMove.keyboardModifiers = event.keyboardModifiers;
+            }
+            if(m_mouseMoveHistory.size() < MAX_MOUSE_MOVE_HISTORY)
+                m_mouseMoveHistory.push_back(event.mousePos);
+            else
+                m_mouseMoveHistory.back() = event.mousePos;
+            return;
+        }
+    }
+
+    // anything else must observe the pointer where it really is
+    flushMouseMove();
+
+    if(event.type == Fw::MouseMoveInputEvent) {
+        m_mouseMoveHistory.assign(1, event.mousePos);
+        m_coalescedMouseMoves++;
+    }
+    if(m_onInputEventTarget)
+        m_onInputEventTarget(event);
+}
+
+void PlatformWindow::flushMouseMove()
+{
+    if(!m_hasPendingMouseMove)
+        return;
+    m_hasPendingMouseMove = false;
+    m_coalescedMouseMoves++;
+    if(m_onInputEventTarget)
+        m_onInputEventTarget(m_pendingMouseMove);
+}
+
 void PlatformWindow::fireKeysPress()
 {
     // avoid massive checks
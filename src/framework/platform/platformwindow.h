@@ -33,6 +33,7 @@ class PlatformWindow
 {
     enum {
         KEY_PRESS_REPEAT_INTERVAL = 30,
+        MAX_MOUSE_MOVE_HISTORY = 64,
     };
 
     typedef std::function<void(const Size&)> OnResizeCallback;
@@ -48,6 +49,10 @@ public:
     virtual void hide() = 0;
     virtual void maximize() = 0;
     virtual void poll() = 0;
+    // blocks until window events arrive, wakeUp is called or timeout milliseconds pass, -1 waits without timeout
+    virtual void waitEvents(int timeout) = 0;
+    // thread safe, interrupts the current waitEvents or makes the next one return right away
+    virtual void wakeUp() = 0;
     virtual void swapBuffers() = 0;
     virtual void showMouse() = 0;
     virtual void hideMouse() = 0;
@@ -90,9 +95,17 @@ public:
     bool isFullscreen() { return m_fullscreen; }
     bool hasFocus() { return m_focused; }
 
+    // consecutive mouse moves within a poll leave as one event carrying the summed delta
+    void setMouseMoveCoalescing(bool enable);
+    bool isMouseMoveCoalescing() { return m_mouseMoveCoalescing; }
+    // raw positions merged into the mouse move being dispatched, oldest first
+    const std::vector<Point>& getMouseMoveHistory() { return m_mouseMoveHistory; }
+    uint64 getRawMouseMoveCount() { return m_rawMouseMoves; }
+    uint64 getCoalescedMouseMoveCount() { return m_coalescedMouseMoves; }
+
     void setOnClose(const std::function<void()>& onClose) { m_onClose = onClose; }
     void setOnResize(const OnResizeCallback& onResize) { m_onResize = onResize; }
-    void setOnInputEvent(const OnInputEventCallback& onInputEvent) { m_onInputEvent = onInputEvent; }
+    void setOnInputEvent(const OnInputEventCallback& onInputEvent);
 
 protected:
     virtual int internalLoadMouseCursor(const ImagePtr& image, const Point& hotSpot) = 0;
@@ -103,6 +116,7 @@ protected:
     void processKeyUp(Fw::Key keyCode);
     void releaseAllKeys();
     void fireKeysPress();
+    void flushMouseMove();
 
     std::map<int, Fw::Key> m_keyMap;
     std::map<Fw::Key, stdext::boolean<false>> m_keysState;
@@ -127,6 +141,17 @@ protected:
     std::function<void()> m_onClose;
     OnResizeCallback m_onResize;
     OnInputEventCallback m_onInputEvent;
+
+private:
+    void handleInputEvent(const InputEvent& event);
+
+    OnInputEventCallback m_onInputEventTarget;
+    InputEvent m_pendingMouseMove;
+    std::vector<Point> m_mouseMoveHistory;
+    stdext::boolean<false> m_hasPendingMouseMove;
+    stdext::boolean<true> m_mouseMoveCoalescing;
+    uint64 m_rawMouseMoves = 0;
+    uint64 m_coalescedMouseMoves = 0;
 };
 
 extern PlatformWindow& g_window;
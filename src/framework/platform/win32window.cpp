@@ -20,7 +20,7 @@
  * THE SOFTWARE.
  */
 
-#ifdef WIN32
+#if defined(WIN32) && !defined(HEADLESS)
 
 #include <client/map.h>
 #include "win32window.h"
@@ -36,6 +36,7 @@ WIN32Window::WIN32Window()
     m_instance = 0;
     m_deviceContext = 0;
     m_cursor = 0;
+    m_wakeupEvent = NULL;
     m_minimumSize = Size(600, 480);
     m_size = Size(600, 480);
     m_hidden = true;
@@ -228,6 +229,8 @@ void WIN32Window::init()
     internalCreateWindow();
     internalCreateGLContext();
     internalRestoreGLContext();
+
+    m_wakeupEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
 }
 
 void WIN32Window::terminate()
@@ -261,6 +264,11 @@ void WIN32Window::terminate()
             g_logger.error("UnregisterClassA failed");
         m_instance = NULL;
     }
+
+    if(m_wakeupEvent) {
+        CloseHandle(m_wakeupEvent);
+        m_wakeupEvent = NULL;
+    }
 }
 
 struct WindowProcProxy {
@@ -521,9 +529,23 @@ void WIN32Window::poll()
         DispatchMessage(&msg);
     }
 
+    flushMouseMove();
+
     updateUnmaximizedCoords();
 }
 
+void WIN32Window::waitEvents(int timeout)
+{
+    // input already queued but not yet seen by peek counts as available
+    MsgWaitForMultipleObjectsEx(m_wakeupEvent ? 1 : 0, &m_wakeupEvent, timeout < 0 ? INFINITE : timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+}
+
+void WIN32Window::wakeUp()
+{
+    if(m_wakeupEvent)
+        SetEvent(m_wakeupEvent);
+}
+
 Fw::Key WIN32Window::retranslateVirtualKey(WPARAM wParam, LPARAM lParam)
 {
     // ignore numpad keys when numlock is on
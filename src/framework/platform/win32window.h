@@ -65,6 +65,8 @@ public:
     void hide();
     void maximize();
     void poll();
+    void waitEvents(int timeout);
+    void wakeUp();
     void swapBuffers();
     void showMouse();
     void hideMouse();
@@ -99,6 +101,8 @@ private:
     HCURSOR m_cursor;
     HCURSOR m_defaultCursor;
     bool m_hidden;
+    // auto reset event signaled by wakeUp, waited on together with the message queue
+    HANDLE m_wakeupEvent;
 
 #ifdef DIRECTX
     LPDIRECT3D9 m_d3d;    // the pointer to our Direct3D interface
@@ -20,12 +20,14 @@
  * THE SOFTWARE.
  */
 
-#ifndef WIN32
+#if !defined(WIN32) && !defined(HEADLESS)
 
 #include "x11window.h"
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/image.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/select.h>
 
 #define LSB_BIT_SET(p, n) (p[(n)/8] |= (1 <<((n)%8)))
 
@@ -42,6 +44,7 @@ X11Window::X11Window()
     m_xic = nullptr;
     m_screen = 0;
     m_wmDelete = 0;
+    m_wakeupPipe[0] = m_wakeupPipe[1] = -1;
     m_minimumSize = Size(600,480);
     m_size = Size(600,480);
 
@@ -215,6 +218,12 @@ void X11Window::init()
     internalChooseGLVisual();
     internalCreateGLContext();
     internalCreateWindow();
+
+    if(pipe(m_wakeupPipe) == 0) {
+        fcntl(m_wakeupPipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(m_wakeupPipe[1], F_SETFL, O_NONBLOCK);
+    } else
+        m_wakeupPipe[0] = m_wakeupPipe[1] = -1;
 }
 
 void X11Window::terminate()
@@ -265,6 +274,12 @@ void X11Window::terminate()
         m_display = nullptr;
     }
 
+    if(m_wakeupPipe[0] >= 0) {
+        close(m_wakeupPipe[0]);
+        close(m_wakeupPipe[1]);
+        m_wakeupPipe[0] = m_wakeupPipe[1] = -1;
+    }
+
     m_visible = false;
 }
 
@@ -581,6 +596,43 @@ void X11Window::maximize()
     m_maximized = true;
 }
 
+void X11Window::waitEvents(int timeout)
+{
+    // requests still buffered could be what the server answers with the events waited for
+    XFlush(m_display);
+    if(XPending(m_display) > 0 || m_wakeupPending.exchange(false))
+        return;
+
+    const int displayFd = ConnectionNumber(m_display);
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(displayFd, &fds);
+    if(m_wakeupPipe[0] >= 0)
+        FD_SET(m_wakeupPipe[0], &fds);
+
+    timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    select(std::max<int>(displayFd, m_wakeupPipe[0]) + 1, &fds, nullptr, nullptr, timeout < 0 ? nullptr : &tv);
+
+    // wake ups from here on are seen by the poll that follows this wait anyway
+    m_wakeupPending = false;
+    if(m_wakeupPipe[0] >= 0 && FD_ISSET(m_wakeupPipe[0], &fds)) {
+        char buffer[64];
+        while(read(m_wakeupPipe[0], buffer, sizeof(buffer)) > 0);
+    }
+}
+
+void X11Window::wakeUp()
+{
+    // one byte in the pipe is enough no matter how many threads wake up the same wait
+    if(m_wakeupPending.exchange(true) || m_wakeupPipe[1] < 0)
+        return;
+    const char byte = 0;
+    if(write(m_wakeupPipe[1], &byte, 1) < 0)
+        return;
+}
+
 void X11Window::poll()
 {
     bool needsResizeUpdate = false;
@@ -832,6 +884,8 @@ void X11Window::poll()
         }
     }
 
+    flushMouseMove();
+
     if(needsResizeUpdate && m_onResize)
         m_onResize(m_size);
 
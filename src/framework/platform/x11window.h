@@ -62,6 +62,8 @@ public:
     void hide();
     void maximize();
     void poll();
+    void waitEvents(int timeout);
+    void wakeUp();
     void swapBuffers();
     void showMouse();
     void hideMouse();
@@ -97,6 +99,9 @@ private:
     int m_screen;
     Atom m_wmDelete;
     std::string m_clipboardText;
+    // self pipe written by wakeUp, its read end is waited on together with the display connection
+    int m_wakeupPipe[2];
+    std::atomic<bool> m_wakeupPending{false};
 
 #ifndef OPENGL_ES
     GLXContext m_glxContext;
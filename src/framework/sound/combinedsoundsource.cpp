@@ -61,6 +61,15 @@ bool CombinedSoundSource::isPlaying()
     return false;
 }
 
+bool CombinedSoundSource::hasVoice()
+{
+    for(const SoundSourcePtr& source : m_sources) {
+        if(!source->hasVoice())
+            return false;
+    }
+    return !m_sources.empty();
+}
+
 void CombinedSoundSource::setLooping(bool looping)
 {
     for(const SoundSourcePtr& source : m_sources)
@@ -38,6 +38,8 @@ public:
 
     bool isBuffering() override;
     bool isPlaying() override;
+    bool hasVoice() override;
+    bool isStreaming() override { return true; }
 
     void setLooping(bool looping) override;
     void setRelative(bool relative) override;
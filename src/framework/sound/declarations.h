@@ -43,6 +43,7 @@ class SoundChannel;
 class StreamSoundSource;
 class CombinedSoundSource;
 class OggSoundFile;
+class StreamDecoder;
 
 using SoundSourcePtr = stdext::shared_object_ptr<SoundSource>;
 using SoundFilePtr = stdext::shared_object_ptr<SoundFile>;
@@ -51,5 +52,7 @@ using SoundChannelPtr = stdext::shared_object_ptr<SoundChannel>;
 using StreamSoundSourcePtr = stdext::shared_object_ptr<StreamSoundSource>;
 using CombinedSoundSourcePtr = stdext::shared_object_ptr<CombinedSoundSource>;
 using OggSoundFilePtr = stdext::shared_object_ptr<OggSoundFile>;
+// shared with the decoding thread, so it needs an atomic reference count
+using StreamDecoderPtr = std::shared_ptr<StreamDecoder>;
 
 #endif
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "soundbank.h"
+#include "soundbuffer.h"
+#include "soundfile.h"
+
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+namespace {
+    const int adpcmSteps[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+        337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+        2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+    };
+    const int adpcmIndexShift[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+    struct AdpcmState {
+        int predictor = 0;
+        int index = 0;
+
+        int16 decode(uint8 nibble)
+        {
+            const int step = adpcmSteps[index];
+            int diff = step >> 3;
+            if(nibble & 4) diff += step;
+            if(nibble & 2) diff += step >> 1;
+            if(nibble & 1) diff += step >> 2;
+            predictor = stdext::clamp<int>((nibble & 8) ? predictor - diff : predictor + diff, -32768, 32767);
+            index = stdext::clamp<int>(index + adpcmIndexShift[nibble], 0, 88);
+            return static_cast<int16>(predictor);
+        }
+
+        // picks the nibble closest to sample and moves the state exactly like decode, so errors don't add up
+        uint8 encode(int16 sample)
+        {
+            const int step = adpcmSteps[index];
+            int diff = sample - predictor;
+            uint8 nibble = 0;
+            if(diff < 0) {
+                nibble = 8;
+                diff = -diff;
+            }
+            if(diff >= step) { nibble |= 4; diff -= step; }
+            if(diff >= step >> 1) { nibble |= 2; diff -= step >> 1; }
+            if(diff >= step >> 2) nibble |= 1;
+            decode(nibble);
+            return nibble;
+        }
+    };
+
+    int getChannels(ALenum format) { return format == AL_FORMAT_STEREO16 || format == AL_FORMAT_STEREO8 ? 2 : 1; }
+
+    // the stream starts with each channel's first sample and step index, the index matching the first
+    // differences so the start isn't smeared, then comes one nibble per sample, channels interleaved
+    // and the low nibble first
+    std::string encodeAdpcm(const int16* samples, size_t count, int channels)
+    {
+        std::string out;
+        AdpcmState states[2];
+        for(int c = 0; c < channels; ++c) {
+            int delta = 0, deltas = 0;
+            for(size_t i = c + channels; i < count && deltas < 16; i += channels, ++deltas)
+                delta += std::abs(samples[i] - samples[i - channels]);
+            const int average = deltas > 0 ? delta / deltas : 0;
+
+            AdpcmState& state = states[c];
+            state.predictor = c < (int)count ? samples[c] : 0;
+            while(state.index < 88 && adpcmSteps[state.index] < average)
+                state.index++;
+
+            uint8 header[3];
+            stdext::writeSLE16(header, static_cast<int16>(state.predictor));
+            header[2] = static_cast<uint8>(state.index);
+            out.append(reinterpret_cast<const char*>(header), 3);
+        }
+
+        uint8 byte = 0;
+        for(size_t i = 0; i < count; ++i) {
+            const uint8 nibble = states[i % channels].encode(samples[i]);
+            if(i % 2 == 0)
+                byte = nibble;
+            else
+                out.push_back(static_cast<char>(byte | nibble << 4));
+        }
+        if(count % 2 == 1)
+            out.push_back(static_cast<char>(byte));
+        return out;
+    }
+
+    void decodeAdpcm(const uint8* data, size_t count, int channels, int16* samples)
+    {
+        AdpcmState states[2];
+        for(int c = 0; c < channels; ++c) {
+            states[c].predictor = stdext::readSLE16(data);
+            states[c].index = std::min<int>(data[2], 88);
+            data += 3;
+        }
+
+        for(size_t i = 0; i < count; ++i) {
+            const uint8 nibble = i % 2 == 0 ? data[i / 2] & 0x0F : data[i / 2] >> 4;
+            samples[i] = states[i % channels].decode(nibble);
+        }
+    }
+
+    void collectSoundFiles(const std::string& directory, std::vector<std::string>& files)
+    {
+        for(const std::string& name : g_resources.listDirectoryFiles(directory)) {
+            const std::string path = directory + "/" + name;
+            if(g_resources.directoryExists(path))
+                collectSoundFiles(path, files);
+            else if(g_resources.isFileType(path, "ogg"))
+                files.push_back(path);
+        }
+    }
+}
+
+bool SoundBank::load(const std::string& fileName)
+{
+    unload();
+
+    try {
+        const FileStreamPtr file = g_resources.openFile(fileName);
+        // one mapping for the whole bank when it lives on the real filesystem
+        file->cache();
+
+        if(file->getU32() != SIGNATURE)
+            stdext::throw_exception("invalid sound bank signature");
+        if(file->getU16() != VERSION)
+            stdext::throw_exception("unsupported sound bank version");
+
+        const uint32 count = file->getU32();
+        for(uint32 i = 0; i < count; ++i) {
+            const std::string name = file->getString();
+            Entry entry;
+            entry.offset = file->getU32();
+            entry.size = file->getU32();
+            entry.pcmSize = file->getU32();
+            entry.rate = file->getU32();
+            const uint8 channels = file->getU8();
+            const uint8 bps = file->getU8();
+            if(channels == 2)
+                entry.format = bps == 16 ? AL_FORMAT_STEREO16 : AL_FORMAT_STEREO8;
+            else
+                entry.format = bps == 16 ? AL_FORMAT_MONO16 : AL_FORMAT_MONO8;
+            entry.encoding = static_cast<Encoding>(file->getU8());
+            if(entry.offset + entry.size > file->size())
+                stdext::throw_exception(stdext::format("sound '%s' lies outside the bank", name));
+            m_entries[name] = entry;
+        }
+
+        m_file = file;
+        g_logger.debug(stdext::format("loaded sound bank '%s' with %d sounds", fileName, (int)m_entries.size()));
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("unable to load sound bank '%s': %s", fileName, e.what()));
+        m_entries.clear();
+        return false;
+    }
+}
+
+void SoundBank::unload()
+{
+    m_file = nullptr;
+    m_entries.clear();
+}
+
+SoundBufferPtr SoundBank::createBuffer(const std::string& fileName, int& size)
+{
+    const auto it = m_entries.find(fileName);
+    if(it == m_entries.end() || !m_file)
+        return nullptr;
+
+    const Entry& entry = it->second;
+    const char* data = reinterpret_cast<const char*>(m_file->cachedData() + entry.offset);
+
+    SoundBufferPtr buffer(new SoundBuffer);
+    if(entry.encoding == EncodingAdpcm) {
+        std::vector<int16> samples(entry.pcmSize / 2);
+        decodeAdpcm(reinterpret_cast<const uint8*>(data), samples.size(), getChannels(entry.format), samples.data());
+        if(!buffer->fillBuffer(entry.format, reinterpret_cast<const char*>(samples.data()), entry.pcmSize, entry.rate))
+            return nullptr;
+    } else if(!buffer->fillBuffer(entry.format, data, entry.size, entry.rate))
+        return nullptr;
+
+    size = entry.pcmSize;
+    return buffer;
+}
+
+bool SoundBank::build(const std::string& directory, const std::string& fileName, int maxSize, bool adpcm)
+{
+    std::vector<std::string> files;
+    collectSoundFiles(directory, files);
+
+    struct Packed {
+        std::string name;
+        std::string data;
+        uint32 pcmSize;
+        uint32 rate;
+        uint8 channels;
+        uint8 bps;
+        Encoding encoding;
+    };
+    std::vector<Packed> packed;
+
+    for(const std::string& path : files) {
+        const SoundFilePtr soundFile = SoundFile::loadSoundFile(path);
+        // long tracks keep being streamed
+        if(!soundFile || soundFile->getSize() > maxSize || soundFile->getSampleFormat() == AL_UNDETERMINED)
+            continue;
+
+        std::string samples(soundFile->getSize(), '\0');
+        const int read = soundFile->read(&samples[0], samples.size());
+        if(read <= 0)
+            continue;
+        samples.resize(read);
+
+        Packed sound;
+        // keyed like SoundManager::resolveSoundFile resolves them
+        sound.name = g_resources.resolvePath(path);
+        sound.pcmSize = samples.size();
+        sound.rate = soundFile->getRate();
+        sound.channels = soundFile->getChannels();
+        sound.bps = soundFile->getBps();
+        if(adpcm && sound.bps == 16) {
+            sound.data = encodeAdpcm(reinterpret_cast<const int16*>(samples.data()), samples.size() / 2, sound.channels);
+            sound.encoding = EncodingAdpcm;
+        } else {
+            sound.data = std::move(samples);
+            sound.encoding = EncodingRaw;
+        }
+        packed.push_back(std::move(sound));
+    }
+
+    // data starts after the index, each sound aligned to 4 bytes
+    uint32 offset = 4 + 2 + 4;
+    for(const Packed& sound : packed)
+        offset += 2 + sound.name.size() + 4 * 4 + 3;
+
+    std::string out;
+    const auto addU8 = [&](uint8 v) { out.push_back(static_cast<char>(v)); };
+    const auto addU16 = [&](uint16 v) { uint8 b[2]; stdext::writeULE16(b, v); out.append(reinterpret_cast<char*>(b), 2); };
+    const auto addU32 = [&](uint32 v) { uint8 b[4]; stdext::writeULE32(b, v); out.append(reinterpret_cast<char*>(b), 4); };
+
+    addU32(SIGNATURE);
+    addU16(VERSION);
+    addU32(packed.size());
+    for(const Packed& sound : packed) {
+        offset = (offset + 3) & ~3u;
+        addU16(sound.name.size());
+        out.append(sound.name);
+        addU32(offset);
+        addU32(sound.data.size());
+        addU32(sound.pcmSize);
+        addU32(sound.rate);
+        addU8(sound.channels);
+        addU8(sound.bps);
+        addU8(sound.encoding);
+        offset += sound.data.size();
+    }
+    for(const Packed& sound : packed) {
+        out.resize((out.size() + 3) & ~size_t(3), '\0');
+        out.append(sound.data);
+    }
+
+    if(!g_resources.writeFileContents(fileName, out)) {
+        g_logger.error(stdext::format("unable to write sound bank '%s'", fileName));
+        return false;
+    }
+    g_logger.info(stdext::format("packed %d of %d sounds from '%s' into '%s', %d bytes", (int)packed.size(), (int)files.size(), directory, fileName, (int)out.size()));
+    return true;
+}
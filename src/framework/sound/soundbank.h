@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SOUNDBANK_H
+#define SOUNDBANK_H
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+
+// prebuilt archive of short sounds stored as ready to play pcm, the file stays mapped and buffers
+// are filled straight from it, so nothing is opened or decoded when they are played
+class SoundBank
+{
+public:
+    enum {
+        SIGNATURE = 0x42535430, // "OTSB"
+        VERSION = 1
+    };
+
+    enum Encoding : uint8 {
+        EncodingRaw = 0,
+        EncodingAdpcm = 1 // ima adpcm of 16 bit samples, 4 bits per sample and channel
+    };
+
+    bool load(const std::string& fileName);
+    void unload();
+    bool isLoaded() { return m_file != nullptr; }
+
+    bool hasSound(const std::string& fileName) { return m_entries.find(fileName) != m_entries.end(); }
+    // nullptr when the bank doesn't hold the sound
+    SoundBufferPtr createBuffer(const std::string& fileName, int& size);
+    int getSoundCount() { return m_entries.size(); }
+
+    // packs every sound file up to maxSize decoded bytes found under directory, subdirectories included
+    static bool build(const std::string& directory, const std::string& fileName, int maxSize, bool adpcm);
+
+private:
+    struct Entry {
+        uint32 offset;
+        uint32 size; // stored bytes
+        uint32 pcmSize; // bytes once decoded
+        uint32 rate;
+        ALenum format;
+        Encoding encoding;
+    };
+
+    FileStreamPtr m_file;
+    std::unordered_map<std::string, Entry> m_entries;
+};
+
+#endif
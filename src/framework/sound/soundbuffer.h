@@ -35,6 +35,7 @@ public:
 
     bool fillBuffer(const SoundFilePtr& soundFile);
     bool fillBuffer(ALenum sampleFormat, const DataBuffer<char>& data, int size, int rate);
+    bool fillBuffer(ALenum sampleFormat, const char* data, int size, int rate);
 
     uint getBufferId() { return m_bufferId; }
 
@@ -33,7 +33,7 @@ SoundSourcePtr SoundChannel::play(const std::string& filename, float fadetime, f
     if(m_currentSource)
         m_currentSource->stop();
 
-    m_currentSource = g_sounds.play(filename, fadetime, m_gain * gain);
+    m_currentSource = g_sounds.play(filename, fadetime, m_gain * gain, SoundManager::CHANNEL_PRIORITY);
     return m_currentSource;
 }
 
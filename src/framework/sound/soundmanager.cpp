@@ -37,6 +37,9 @@ SoundManager g_sounds;
 
 void SoundManager::init()
 {
+    m_decoding = true;
+    m_decodeThread = std::thread([this] { decodeLoop(); });
+
     m_device = alcOpenDevice(nullptr);
     if(!m_device) {
         g_logger.error("unable to open audio device");
@@ -64,10 +67,27 @@ void SoundManager::terminate()
     }
     m_streamFiles.clear();
 
+    {
+        std::lock_guard<std::mutex> lock(m_decodeMutex);
+        m_decoding = false;
+    }
+    m_decodeCondition.notify_all();
+    if(m_decodeThread.joinable())
+        m_decodeThread.join();
+    m_decoders.clear();
+
     m_sources.clear();
+    m_bank.unload();
     m_buffers.clear();
+    m_buffersLru.clear();
+    m_buffersSize = 0;
     m_channels.clear();
 
+    // sources still referenced from lua give their voice back with the context already gone
+    alDeleteSources(m_freeVoices.size(), m_freeVoices.data());
+    m_freeVoices.clear();
+    m_allocatedVoices = 0;
+
     m_audioEnabled = false;
 
     alcMakeContextCurrent(nullptr);
@@ -95,22 +115,6 @@ void SoundManager::poll()
 
     ensureContext();
 
-    for(auto it = m_streamFiles.begin(); it != m_streamFiles.end();) {
-        StreamSoundSourcePtr source = it->first;
-        auto& future = it->second;
-
-        if(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-            SoundFilePtr sound = future.get();
-            if(sound)
-                source->setSoundFile(sound);
-            else
-                source->stop();
-            it = m_streamFiles.erase(it);
-        } else {
-            ++it;
-        }
-    }
-
     for(auto it = m_sources.begin(); it != m_sources.end();) {
         SoundSourcePtr source = *it;
 
@@ -149,8 +153,7 @@ void SoundManager::preload(std::string filename)
 {
     filename = resolveSoundFile(filename);
 
-    const auto it = m_buffers.find(filename);
-    if(it != m_buffers.end())
+    if(getCachedBuffer(filename))
         return;
 
     ensureContext();
@@ -162,10 +165,10 @@ void SoundManager::preload(std::string filename)
 
     auto buffer = SoundBufferPtr(new SoundBuffer);
     if(buffer->fillBuffer(soundFile))
-        m_buffers[filename] = buffer;
+        cacheBuffer(filename, buffer, soundFile->getSize());
 }
 
-SoundSourcePtr SoundManager::play(std::string filename, float fadetime, float gain)
+SoundSourcePtr SoundManager::play(std::string filename, float fadetime, float gain, int priority)
 {
     if(!m_audioEnabled)
         return nullptr;
@@ -176,13 +179,33 @@ SoundSourcePtr SoundManager::play(std::string filename, float fadetime, float ga
         gain = 1.0f;
 
     filename = resolveSoundFile(filename);
+
+    // streams on linux play through a pair of sources, see createSoundSource
+#if defined __linux && !defined OPENGL_ES
+    const int voices = getCachedBuffer(filename) ? 1 : 2;
+#else
+    const int voices = 1;
+#endif
+    if(!reserveVoices(voices, priority)) {
+        m_droppedVoices++;
+        return nullptr;
+    }
+
     SoundSourcePtr soundSource = createSoundSource(filename);
     if(!soundSource) {
         g_logger.error(stdext::format("unable to play '%s'", filename));
         return nullptr;
     }
 
+    if(!soundSource->hasVoice()) {
+        m_droppedVoices++;
+        soundSource->stop();
+        return nullptr;
+    }
+
     soundSource->setName(filename);
+    soundSource->setPriority(priority);
+    soundSource->m_playTime = g_clock.millis();
     soundSource->setRelative(true);
     soundSource->setGain(gain);
 
@@ -221,10 +244,9 @@ SoundSourcePtr SoundManager::createSoundSource(const std::string& filename)
     SoundSourcePtr source;
 
     try {
-        const auto it = m_buffers.find(filename);
-        if(it != m_buffers.end()) {
+        if(const SoundBufferPtr buffer = getCachedBuffer(filename)) {
             source = SoundSourcePtr(new SoundSource);
-            source->setBuffer(it->second);
+            source->setBuffer(buffer);
         } else {
 #if defined __linux && !defined OPENGL_ES
             // due to OpenAL implementation bug, stereo buffers are always downmixed to mono on linux systems
@@ -238,41 +260,19 @@ SoundSourcePtr SoundManager::createSoundSource(const std::string& filename)
             streamSource->setRelative(true);
             streamSource->setPosition(Point(-128, 0));
             combinedSource->addSource(streamSource);
-            m_streamFiles[streamSource] = g_asyncDispatcher.schedule([=]() -> SoundFilePtr {
-                stdext::timer a;
-                try {
-                    return SoundFile::loadSoundFile(filename);
-                } catch(std::exception& e) {
-                    g_logger.error(e.what());
-                    return nullptr;
-                }
-            });
+            loadStream(streamSource, filename);
 
             streamSource = StreamSoundSourcePtr(new StreamSoundSource);
             streamSource->downMix(StreamSoundSource::DownMixRight);
             streamSource->setRelative(true);
             streamSource->setPosition(Point(128, 0));
             combinedSource->addSource(streamSource);
-            m_streamFiles[streamSource] = g_asyncDispatcher.schedule([=]() -> SoundFilePtr {
-                try {
-                    return SoundFile::loadSoundFile(filename);
-                } catch(std::exception& e) {
-                    g_logger.error(e.what());
-                    return nullptr;
-                }
-            });
+            loadStream(streamSource, filename);
 
             source = combinedSource;
 #else
             const StreamSoundSourcePtr streamSource(new StreamSoundSource);
-            m_streamFiles[streamSource] = g_asyncDispatcher.schedule([=]() -> SoundFilePtr {
-                try {
-                    return SoundFile::loadSoundFile(filename);
-                } catch(std::exception& e) {
-                    g_logger.error(e.what());
-                    return nullptr;
-                }
-            });
+            loadStream(streamSource, filename);
             source = streamSource;
 #endif
         }
@@ -284,6 +284,247 @@ SoundSourcePtr SoundManager::createSoundSource(const std::string& filename)
     return source;
 }
 
+uint SoundManager::acquireVoice()
+{
+    if(!m_freeVoices.empty()) {
+        const uint sourceId = m_freeVoices.back();
+        m_freeVoices.pop_back();
+        return sourceId;
+    }
+
+    if(!m_context || m_allocatedVoices >= m_maxVoices)
+        return 0;
+
+    uint sourceId = 0;
+    alGetError();
+    alGenSources(1, &sourceId);
+    if(alGetError() != AL_NO_ERROR || sourceId == 0) {
+        // the implementation's own limit is lower, stick to what it gave us
+        g_logger.warning(stdext::format("audio device is limited to %d sources", m_allocatedVoices));
+        m_maxVoices = m_allocatedVoices;
+        return 0;
+    }
+
+    m_allocatedVoices++;
+    alSourcef(sourceId, AL_REFERENCE_DISTANCE, 128);
+    return sourceId;
+}
+
+void SoundManager::releaseVoice(uint sourceId)
+{
+    // sources outliving the context are gone together with it
+    if(!m_context || sourceId == 0)
+        return;
+
+    alSourceStop(sourceId);
+    alSourcei(sourceId, AL_BUFFER, AL_NONE);
+    alSourcei(sourceId, AL_LOOPING, AL_FALSE);
+    alSourcei(sourceId, AL_SOURCE_RELATIVE, AL_FALSE);
+    alSourcef(sourceId, AL_REFERENCE_DISTANCE, 128);
+    alSourcef(sourceId, AL_GAIN, 1.0f);
+    alSourcef(sourceId, AL_PITCH, 1.0f);
+    alSource3f(sourceId, AL_POSITION, 0, 0, 0);
+    alSource3f(sourceId, AL_VELOCITY, 0, 0, 0);
+    m_freeVoices.push_back(sourceId);
+}
+
+bool SoundManager::reserveVoices(int count, int priority)
+{
+    int available = m_freeVoices.size() + (m_maxVoices - m_allocatedVoices);
+    while(available < count) {
+        const SoundSourcePtr victim = findStealableSource(priority);
+        if(!victim)
+            return false;
+
+        victim->releaseVoice();
+        m_stolenVoices++;
+        available++;
+    }
+    return true;
+}
+
+SoundSourcePtr SoundManager::findStealableSource(int priority)
+{
+    SoundSourcePtr victim;
+    for(const SoundSourcePtr& source : m_sources) {
+        if(source->isStreaming() || !source->hasVoice() || source->getPriority() > priority)
+            continue;
+
+        if(!victim) {
+            victim = source;
+            continue;
+        }
+
+        if(source->getPriority() != victim->getPriority()) {
+            if(source->getPriority() < victim->getPriority())
+                victim = source;
+            continue;
+        }
+
+        // relative sources are heard from the origin
+        const int distance = source->m_position.x * source->m_position.x + source->m_position.y * source->m_position.y;
+        const int victimDistance = victim->m_position.x * victim->m_position.x + victim->m_position.y * victim->m_position.y;
+        if(distance != victimDistance) {
+            if(distance > victimDistance)
+                victim = source;
+            continue;
+        }
+
+        if(source->m_playTime < victim->m_playTime)
+            victim = source;
+    }
+    return victim;
+}
+
+std::map<std::string, int> SoundManager::getVoiceStats()
+{
+    std::map<std::string, int> stats;
+    stats["active"] = m_allocatedVoices - m_freeVoices.size();
+    stats["allocated"] = m_allocatedVoices;
+    stats["max"] = m_maxVoices;
+    stats["stolen"] = m_stolenVoices;
+    stats["dropped"] = m_droppedVoices;
+    return stats;
+}
+
+void SoundManager::loadStream(const StreamSoundSourcePtr& source, const std::string& filename)
+{
+    const StreamSoundSource::DownMix downMix = source->getDownMix();
+    AsyncTask<StreamDecoderPtr> task = g_asyncDispatcher.schedule([=]() -> StreamDecoderPtr {
+        try {
+            const SoundFilePtr soundFile = SoundFile::loadSoundFile(filename);
+            if(!soundFile)
+                return nullptr;
+
+            const auto decoder = std::make_shared<StreamDecoder>(soundFile, downMix);
+
+            // short sounds are decoded once here and then cached
+            if(soundFile->getSize() <= MAX_CACHE_SIZE)
+                decoder->decodeAll();
+
+            return decoder;
+        } catch(std::exception& e) {
+            g_logger.error(e.what());
+            return nullptr;
+        }
+    }, AsyncDispatcher::PriorityHigh);
+    m_streamFiles[source] = task;
+
+    // the worker posts the continuation, so it only carries a raw key, sources are not thread safe
+    StreamSoundSource* key = source.get();
+    task.then_on_main([this, key](const std::shared_future<StreamDecoderPtr>& future) { onStreamLoaded(key, future); });
+}
+
+void SoundManager::onStreamLoaded(StreamSoundSource* key, const std::shared_future<StreamDecoderPtr>& future)
+{
+    // gone when the sounds were terminated meanwhile
+    const auto it = std::find_if(m_streamFiles.begin(), m_streamFiles.end(), [key](const auto& streamFile) { return streamFile.first.get() == key; });
+    if(it == m_streamFiles.end())
+        return;
+
+    const StreamSoundSourcePtr source = it->first;
+    m_streamFiles.erase(it);
+
+    ensureContext();
+
+    const StreamDecoderPtr decoder = future.get();
+    if(!decoder) {
+        source->stop();
+        return;
+    }
+
+    // short sounds were decoded entirely by the loader, keep them for the next time
+    const auto& samples = decoder->getSamples();
+    if(samples && !samples->empty() && m_buffers.find(decoder->getName()) == m_buffers.end()) {
+        auto buffer = SoundBufferPtr(new SoundBuffer);
+        if(buffer->fillBuffer(decoder->getSampleFormat(), samples->data(), samples->size(), decoder->getRate()))
+            cacheBuffer(decoder->getName(), buffer, samples->size());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_decodeMutex);
+        m_decoders.push_back(decoder);
+    }
+    wakeDecoder();
+
+    source->setDecoder(decoder);
+}
+
+bool SoundManager::loadSoundBank(const std::string& fileName)
+{
+    ensureContext();
+    // buffers already cached stay valid, sounds only missing from the cache come from the new bank
+    return m_bank.load(g_resources.resolvePath(fileName));
+}
+
+bool SoundManager::buildSoundBank(const std::string& directory, const std::string& fileName, bool adpcm)
+{
+    return SoundBank::build(g_resources.resolvePath(directory), fileName, MAX_CACHE_SIZE, adpcm);
+}
+
+SoundBufferPtr SoundManager::getCachedBuffer(const std::string& filename)
+{
+    const auto it = m_buffers.find(filename);
+    if(it == m_buffers.end()) {
+        // buffers evicted from the cache are cheap to fill again from the mapped bank
+        if(!m_bank.hasSound(filename))
+            return nullptr;
+
+        int size = 0;
+        const SoundBufferPtr buffer = m_bank.createBuffer(filename, size);
+        if(buffer)
+            cacheBuffer(filename, buffer, size);
+        return buffer;
+    }
+
+    CachedBuffer& cached = it->second;
+    m_buffersLru.splice(m_buffersLru.begin(), m_buffersLru, cached.lru);
+    return cached.buffer;
+}
+
+void SoundManager::cacheBuffer(const std::string& filename, const SoundBufferPtr& buffer, int size)
+{
+    if(m_buffers.find(filename) != m_buffers.end())
+        return;
+
+    // sources still playing an evicted buffer keep it alive until they finish
+    while(!m_buffersLru.empty() && m_buffersSize + size > MAX_BUFFER_CACHE_SIZE) {
+        const auto it = m_buffers.find(m_buffersLru.back());
+        m_buffersSize -= it->second.size;
+        m_buffers.erase(it);
+        m_buffersLru.pop_back();
+    }
+
+    m_buffersLru.push_front(filename);
+    m_buffers[filename] = CachedBuffer{ buffer, size, m_buffersLru.begin() };
+    m_buffersSize += size;
+}
+
+void SoundManager::decodeLoop()
+{
+    std::unique_lock<std::mutex> lock(m_decodeMutex);
+    while(m_decoding) {
+        m_decoders.erase(std::remove_if(m_decoders.begin(), m_decoders.end(),
+                                        [](const StreamDecoderPtr& decoder) { return decoder->isCancelled(); }), m_decoders.end());
+
+        // decode without holding the lock, so poll() can register new streams meanwhile
+        const std::vector<StreamDecoderPtr> decoders = m_decoders;
+        lock.unlock();
+
+        bool decoded = false;
+        for(const StreamDecoderPtr& decoder : decoders) {
+            if(!decoder->isCancelled())
+                decoded |= decoder->decode();
+        }
+
+        lock.lock();
+
+        // sources wake us up when they consume fragments, the timeout only covers missed wakeups
+        if(!decoded && m_decoding)
+            m_decodeCondition.wait_for(lock, std::chrono::milliseconds(POLL_DELAY));
+    }
+}
+
 std::string SoundManager::resolveSoundFile(std::string file)
 {
     file = g_resources.guessFilePath(file, "ogg");
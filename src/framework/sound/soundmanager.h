@@ -25,16 +25,25 @@
 
 #include "declarations.h"
 #include "soundchannel.h"
+#include "soundbank.h"
 #include <future>
+#include <condition_variable>
+#include <thread>
 
  //@bindsingleton g_sounds
 class SoundManager
 {
     enum {
         MAX_CACHE_SIZE = 100000,
-        POLL_DELAY = 100
+        MAX_BUFFER_CACHE_SIZE = 8 * 1024 * 1024,
+        POLL_DELAY = 100,
+        MAX_VOICES = 32 // openal sources kept in the pool, fewer when the implementation runs out first
     };
 public:
+    enum {
+        CHANNEL_PRIORITY = 100 // music and ambience played through channels
+    };
+
     void init();
     void terminate();
     void poll();
@@ -46,21 +55,71 @@ public:
     void stopAll();
 
     void preload(std::string filename);
-    SoundSourcePtr play(std::string filename, float fadetime = 0, float gain = 0);
+    // without a free voice the least important playing sound is stolen, lower priority first, then
+    // the farthest and the oldest; the new sound is dropped when every voice is more important
+    SoundSourcePtr play(std::string filename, float fadetime = 0, float gain = 0, int priority = 0);
     SoundChannelPtr getChannel(int channel);
 
+    // sounds found in the bank skip opening and decoding their files, see SoundBank
+    bool loadSoundBank(const std::string& fileName);
+    void unloadSoundBank() { m_bank.unload(); }
+    bool isSoundBankLoaded() { return m_bank.isLoaded(); }
+    // tool mode, packs the short sounds under directory into a bank file
+    bool buildSoundBank(const std::string& directory, const std::string& fileName, bool adpcm);
+
     std::string resolveSoundFile(std::string file);
     void ensureContext();
 
+    void wakeDecoder() { m_decodeCondition.notify_one(); }
+
+    // pooled openal sources, 0 when none is left
+    uint acquireVoice();
+    void releaseVoice(uint sourceId);
+    // active, allocated and max voices, stolen and dropped sounds
+    std::map<std::string, int> getVoiceStats();
+
 private:
+    struct CachedBuffer
+    {
+        SoundBufferPtr buffer;
+        int size;
+        std::list<std::string>::iterator lru;
+    };
+
     SoundSourcePtr createSoundSource(const std::string& filename);
+    void loadStream(const StreamSoundSourcePtr& source, const std::string& filename);
+    void onStreamLoaded(StreamSoundSource* source, const std::shared_future<StreamDecoderPtr>& future);
+    bool reserveVoices(int count, int priority);
+    SoundSourcePtr findStealableSource(int priority);
+
+    SoundBufferPtr getCachedBuffer(const std::string& filename);
+    void cacheBuffer(const std::string& filename, const SoundBufferPtr& buffer, int size);
+
+    void decodeLoop();
 
     ALCdevice* m_device;
     ALCcontext* m_context;
 
-    std::map<StreamSoundSourcePtr, std::shared_future<SoundFilePtr>> m_streamFiles;
-    std::unordered_map<std::string, SoundBufferPtr> m_buffers;
+    std::map<StreamSoundSourcePtr, std::shared_future<StreamDecoderPtr>> m_streamFiles;
+
+    // fully decoded short sounds, least recently played at the back
+    std::unordered_map<std::string, CachedBuffer> m_buffers;
+    SoundBank m_bank;
+    std::list<std::string> m_buffersLru;
+    int m_buffersSize{ 0 };
+
+    std::thread m_decodeThread;
+    std::mutex m_decodeMutex;
+    std::condition_variable m_decodeCondition;
+    std::vector<StreamDecoderPtr> m_decoders;
+    bool m_decoding{ false };
+
     std::vector<SoundSourcePtr> m_sources;
+    std::vector<uint> m_freeVoices;
+    int m_allocatedVoices{ 0 };
+    int m_maxVoices{ MAX_VOICES };
+    int m_stolenVoices{ 0 };
+    int m_droppedVoices{ 0 };
     bool m_audioEnabled{ true };
     std::unordered_map<int, SoundChannelPtr> m_channels;
 };
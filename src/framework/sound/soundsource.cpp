@@ -22,6 +22,7 @@
 
 #include "soundsource.h"
 #include "soundbuffer.h"
+#include "soundmanager.h"
 
 #include <framework/core/clock.h>
 
@@ -36,29 +37,41 @@ SoundSource::SoundSource()
     m_fadeStartTime = 0;
     m_fadeGain = 0;
     m_gain = 1.0f;
+    m_priority = 0;
+    m_playTime = 0;
 
-    alGenSources(1, &m_sourceId);
-    assert(alGetError() == AL_NO_ERROR);
-    setReferenceDistance(128);
+    // pooled sources come back with their default state
+    m_sourceId = g_sounds.acquireVoice();
 }
 
 SoundSource::~SoundSource()
+{
+    releaseVoice();
+}
+
+void SoundSource::releaseVoice()
 {
     if(m_sourceId != 0) {
         stop();
-        alDeleteSources(1, &m_sourceId);
-        assert(alGetError() == AL_NO_ERROR);
+        g_sounds.releaseVoice(m_sourceId);
+        m_sourceId = 0;
     }
 }
 
 void SoundSource::play()
 {
+    if(m_sourceId == 0)
+        return;
+
     alSourcePlay(m_sourceId);
     assert(alGetError() == AL_NO_ERROR);
 }
 
 void SoundSource::stop()
 {
+    if(m_sourceId == 0)
+        return;
+
     alSourceStop(m_sourceId);
     assert(alGetError() == AL_NO_ERROR);
     if(m_buffer) {
@@ -70,6 +83,9 @@ void SoundSource::stop()
 
 bool SoundSource::isBuffering()
 {
+    if(m_sourceId == 0)
+        return false;
+
     int state = AL_PLAYING;
     alGetSourcei(m_sourceId, AL_SOURCE_STATE, &state);
     return state != AL_STOPPED;
@@ -77,6 +93,9 @@ bool SoundSource::isBuffering()
 
 void SoundSource::setBuffer(const SoundBufferPtr& buffer)
 {
+    if(m_sourceId == 0)
+        return;
+
     alSourcei(m_sourceId, AL_BUFFER, buffer->getBufferId());
     assert(alGetError() == AL_NO_ERROR);
     m_buffer = buffer;
@@ -84,38 +103,46 @@ void SoundSource::setBuffer(const SoundBufferPtr& buffer)
 
 void SoundSource::setLooping(bool looping)
 {
-    alSourcei(m_sourceId, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+    if(m_sourceId != 0)
+        alSourcei(m_sourceId, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
 }
 
 void SoundSource::setRelative(bool relative)
 {
-    alSourcei(m_sourceId, AL_SOURCE_RELATIVE, relative ? AL_TRUE : AL_FALSE);
+    if(m_sourceId != 0)
+        alSourcei(m_sourceId, AL_SOURCE_RELATIVE, relative ? AL_TRUE : AL_FALSE);
 }
 
 void SoundSource::setReferenceDistance(float distance)
 {
-    alSourcef(m_sourceId, AL_REFERENCE_DISTANCE, distance);
+    if(m_sourceId != 0)
+        alSourcef(m_sourceId, AL_REFERENCE_DISTANCE, distance);
 }
 
 void SoundSource::setGain(float gain)
 {
-    alSourcef(m_sourceId, AL_GAIN, gain);
+    if(m_sourceId != 0)
+        alSourcef(m_sourceId, AL_GAIN, gain);
     m_gain = gain;
 }
 
 void SoundSource::setPitch(float pitch)
 {
-    alSourcef(m_sourceId, AL_PITCH, pitch);
+    if(m_sourceId != 0)
+        alSourcef(m_sourceId, AL_PITCH, pitch);
 }
 
 void SoundSource::setPosition(const Point& pos)
 {
-    alSource3f(m_sourceId, AL_POSITION, pos.x, pos.y, 0);
+    if(m_sourceId != 0)
+        alSource3f(m_sourceId, AL_POSITION, pos.x, pos.y, 0);
+    m_position = pos;
 }
 
 void SoundSource::setVelocity(const Point& velocity)
 {
-    alSource3f(m_sourceId, AL_VELOCITY, velocity.x, velocity.y, 0);
+    if(m_sourceId != 0)
+        alSource3f(m_sourceId, AL_VELOCITY, velocity.x, velocity.y, 0);
 }
 
 void SoundSource::setFading(FadeState state, float fadeTime)
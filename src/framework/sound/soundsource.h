@@ -30,7 +30,7 @@
 class SoundSource : public LuaObject
 {
 protected:
-    SoundSource(uint sourceId) : m_sourceId(sourceId) {}
+    SoundSource(uint sourceId) : m_sourceId(sourceId), m_priority(0), m_playTime(0) {}
 
 public:
     enum FadeState { NoFading, FadingOn, FadingOff };
@@ -43,6 +43,10 @@ public:
 
     virtual bool isBuffering();
     virtual bool isPlaying() { return isBuffering(); }
+    // false once the voice was taken by a more important sound, or when none was left to begin with
+    virtual bool hasVoice() { return m_sourceId != 0; }
+    // streams are never stolen, their decoders would keep running for nothing
+    virtual bool isStreaming() { return false; }
 
     void setName(const std::string& name) { m_name = name; }
     virtual void setLooping(bool looping);
@@ -57,10 +61,13 @@ public:
     std::string getName() { return m_name; }
     uchar getChannel() { return m_channel; }
     float getGain() { return m_gain; }
+    int getPriority() { return m_priority; }
 
 protected:
     void setBuffer(const SoundBufferPtr& buffer);
     void setChannel(uchar channel) { m_channel = channel; }
+    void setPriority(int priority) { m_priority = priority; }
+    virtual void releaseVoice();
 
     virtual void update();
     friend class SoundManager;
@@ -75,6 +82,9 @@ protected:
     float m_fadeTime;
     float m_fadeGain;
     float m_gain;
+    int m_priority;
+    ticks_t m_playTime;
+    Point m_position;
 };
 
 #endif
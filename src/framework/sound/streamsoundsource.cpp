@@ -23,25 +23,27 @@
 #include "streamsoundsource.h"
 #include "soundbuffer.h"
 #include "soundfile.h"
-
-#include <framework/util/databuffer.h>
-#include <boost/concept_check.hpp>
+#include "soundmanager.h"
 
 StreamSoundSource::StreamSoundSource()
 {
-    for(auto& buffer : m_buffers)
+    for(auto& buffer : m_buffers) {
         buffer = SoundBufferPtr(new SoundBuffer);
+        m_freeBuffers.push_back(buffer->getBufferId());
+    }
     m_downMix = NoDownMix;
 }
 
 StreamSoundSource::~StreamSoundSource()
 {
     stop();
+    if(m_decoder)
+        m_decoder->cancel();
 }
 
-void StreamSoundSource::setSoundFile(const SoundFilePtr& soundFile)
+void StreamSoundSource::setDecoder(const StreamDecoderPtr& decoder)
 {
-    m_soundFile = soundFile;
+    m_decoder = decoder;
     if(m_waitingFile) {
         m_waitingFile = false;
         play();
@@ -50,26 +52,37 @@ void StreamSoundSource::setSoundFile(const SoundFilePtr& soundFile)
 
 void StreamSoundSource::play()
 {
+    if(!hasVoice())
+        return;
+
     m_playing = true;
 
-    if(!m_soundFile) {
+    if(!m_decoder) {
         m_waitingFile = true;
         return;
     }
 
     if(m_eof) {
-        m_soundFile->reset();
+        m_decoder->restart();
+        g_sounds.wakeDecoder();
         m_eof = false;
     }
 
+    // the first fragments may still be decoding, update() starts the source once they arrive
     queueBuffers();
 
-    SoundSource::play();
+    int queued = 0;
+    alGetSourcei(m_sourceId, AL_BUFFERS_QUEUED, &queued);
+    if(queued > 0 && !isSourcePlaying()) {
+        m_started = true;
+        SoundSource::play();
+    }
 }
 
 void StreamSoundSource::stop()
 {
     m_playing = false;
+    m_started = false;
 
     if(m_waitingFile)
         return;
@@ -80,21 +93,53 @@ void StreamSoundSource::stop()
 
 void StreamSoundSource::queueBuffers()
 {
-    int queued;
-    alGetSourcei(m_sourceId, AL_BUFFERS_QUEUED, &queued);
-    for(int i = 0; i < STREAM_FRAGMENTS - queued; ++i) {
-        if(!fillBufferAndQueue(m_buffers[i]->getBufferId()))
-            break;
+    if(!m_decoder)
+        return;
+
+    bool consumed = false;
+    StreamDecoder::Chunk chunk;
+    while(!m_freeBuffers.empty() && m_decoder->pop(chunk)) {
+        consumed = true;
+        if(chunk.last)
+            m_eof = true;
+
+        if(chunk.data.empty())
+            continue;
+
+        const uint buffer = m_freeBuffers.back();
+        alBufferData(buffer, chunk.format, chunk.data.data(), chunk.data.size(), m_decoder->getRate());
+        ALenum err = alGetError();
+        if(err != AL_NO_ERROR) {
+            g_logger.error(stdext::format("unable to refill audio buffer for '%s': %s", m_decoder->getName(), alGetString(err)));
+            continue;
+        }
+
+        alSourceQueueBuffers(m_sourceId, 1, &buffer);
+        err = alGetError();
+        if(err != AL_NO_ERROR) {
+            g_logger.error(stdext::format("unable to queue audio buffer for '%s': %s", m_decoder->getName(), alGetString(err)));
+            continue;
+        }
+
+        m_freeBuffers.pop_back();
     }
+
+    // there is room in the queue again, let the decoder refill it
+    if(consumed)
+        g_sounds.wakeDecoder();
 }
 
 void StreamSoundSource::unqueueBuffers()
 {
-    int queued;
+    if(!hasVoice())
+        return;
+
+    int queued = 0;
     alGetSourcei(m_sourceId, AL_BUFFERS_QUEUED, &queued);
     for(int i = 0; i < queued; ++i) {
         uint buffer;
         alSourceUnqueueBuffers(m_sourceId, 1, &buffer);
+        m_freeBuffers.push_back(buffer);
     }
 }
 
@@ -110,80 +155,154 @@ void StreamSoundSource::update()
     for(int i = 0; i < processed; ++i) {
         uint buffer;
         alSourceUnqueueBuffers(m_sourceId, 1, &buffer);
-        //SoundManager::check_al_error("Couldn't unqueue audio buffer: ");
-
-        if(!fillBufferAndQueue(buffer))
-            break;
+        m_freeBuffers.push_back(buffer);
     }
 
-    if(!isBuffering() && m_playing) {
-        if(!m_looping && m_eof) {
-            stop();
-        } else if(processed == 0) {
-            g_logger.traceError("audio buffer underrun");
-            play();
-        } else if(m_looping) {
-            play();
+    queueBuffers();
+
+    if(m_playing && !isSourcePlaying()) {
+        int queued = 0;
+        alGetSourcei(m_sourceId, AL_BUFFERS_QUEUED, &queued);
+        if(queued > 0) {
+            // either the first fragments just arrived or the decoder fell behind
+            if(m_started)
+                g_logger.traceError("audio buffer underrun");
+            m_started = true;
+            SoundSource::play();
+        } else if(m_eof) {
+            if(m_looping)
+                play();
+            else
+                stop();
         }
     }
 }
 
-bool StreamSoundSource::fillBufferAndQueue(uint buffer)
+bool StreamSoundSource::isSourcePlaying()
 {
-    if(m_waitingFile)
-        return false;
+    // unlike isBuffering(), a source that was never started doesn't count
+    int state = AL_INITIAL;
+    alGetSourcei(m_sourceId, AL_SOURCE_STATE, &state);
+    return state == AL_PLAYING || state == AL_PAUSED;
+}
 
-    // fill buffer
-    static DataBuffer<char> bufferData(2 * STREAM_FRAGMENT_SIZE);
-    ALenum format = m_soundFile->getSampleFormat();
+void StreamSoundSource::downMix(DownMix downMix)
+{
+    m_downMix = downMix;
+}
 
-    int maxRead = STREAM_FRAGMENT_SIZE;
-    if(m_downMix != NoDownMix)
-        maxRead *= 2;
+StreamDecoder::StreamDecoder(const SoundFilePtr& soundFile, StreamSoundSource::DownMix downMix)
+{
+    m_soundFile = soundFile;
+    m_name = soundFile->getName();
+    m_format = soundFile->getSampleFormat();
+    m_rate = soundFile->getRate();
+    m_downMix = downMix;
+}
 
-    int bytesRead = 0;
-    do {
-        bytesRead += m_soundFile->read(&bufferData[bytesRead], maxRead - bytesRead);
+void StreamDecoder::decodeAll()
+{
+    auto samples = std::make_shared<std::vector<char>>(m_soundFile->getSize());
+    samples->resize(std::max<int>(m_soundFile->read(samples->data(), samples->size()), 0));
 
-        // end of sound file
-        if(bytesRead < maxRead) {
-            if(m_looping)
-                m_soundFile->reset();
-            else {
-                m_eof = true;
+    m_samples = samples;
+    m_samplesOffset = 0;
+    m_soundFile = nullptr;
+}
+
+bool StreamDecoder::pop(Chunk& chunk)
+{
+    // fragments decoded before the last restart are stale
+    const uint generation = m_generation.load(std::memory_order_acquire);
+    while(m_chunks.pop(chunk)) {
+        if(chunk.generation == generation)
+            return true;
+    }
+    return false;
+}
+
+bool StreamDecoder::decode()
+{
+    const uint generation = m_generation.load(std::memory_order_acquire);
+    if(generation != m_decodedGeneration) {
+        rewind();
+        m_decodedGeneration = generation;
+        m_hasPending = false;
+        m_eof = false;
+    }
+
+    bool decoded = false;
+    while(true) {
+        if(!m_hasPending) {
+            if(m_eof)
                 break;
-            }
-        }
-    } while(bytesRead < maxRead);
-
-    if(bytesRead > 0) {
-        if(m_downMix != NoDownMix) {
-            if(format == AL_FORMAT_STEREO16) {
-                assert(bytesRead % 2 == 0);
-                bytesRead /= 2;
-                auto data = (uint16_t*)bufferData.data();
-                for(int i = 0; i < bytesRead / 2; i++)
-                    data[i] = data[2 * i + (m_downMix == DownMixLeft ? 0 : 1)];
-                format = AL_FORMAT_MONO16;
-            }
+
+            decodeChunk(m_pending);
+            m_pending.generation = generation;
+            m_hasPending = true;
+            decoded = true;
         }
 
-        alBufferData(buffer, format, &bufferData[0], bytesRead, m_soundFile->getRate());
-        ALenum err = alGetError();
-        if(err != AL_NO_ERROR)
-            g_logger.error(stdext::format("unable to refill audio buffer for '%s': %s", m_soundFile->getName(), alGetString(err)));
+        // the queue holds as many fragments as the source has buffers
+        if(!m_chunks.push(std::move(m_pending)))
+            break;
 
-        alSourceQueueBuffers(m_sourceId, 1, &buffer);
-        err = alGetError();
-        if(err != AL_NO_ERROR)
-            g_logger.error(stdext::format("unable to queue audio buffer for '%s': %s", m_soundFile->getName(), alGetString(err)));
+        m_pending = Chunk();
+        m_hasPending = false;
     }
 
-    // return false if there aren't more buffers to fill
-    return (bytesRead >= STREAM_FRAGMENT_SIZE && !m_eof);
+    return decoded;
 }
 
-void StreamSoundSource::downMix(DownMix downMix)
+int StreamDecoder::read(char* buffer, int size)
 {
-    m_downMix = downMix;
+    if(m_samples) {
+        const int bytes = std::min<int>(size, m_samples->size() - m_samplesOffset);
+        memcpy(buffer, m_samples->data() + m_samplesOffset, bytes);
+        m_samplesOffset += bytes;
+        return bytes;
+    }
+
+    return m_soundFile ? m_soundFile->read(buffer, size) : 0;
+}
+
+void StreamDecoder::rewind()
+{
+    if(m_samples)
+        m_samplesOffset = 0;
+    else if(m_soundFile)
+        m_soundFile->reset();
+}
+
+void StreamDecoder::decodeChunk(Chunk& chunk)
+{
+    int maxRead = StreamSoundSource::STREAM_FRAGMENT_SIZE;
+    if(m_downMix != StreamSoundSource::NoDownMix)
+        maxRead *= 2;
+
+    chunk.data.resize(maxRead);
+
+    int bytesRead = 0;
+    while(bytesRead < maxRead) {
+        const int read = StreamDecoder::read(&chunk.data[bytesRead], maxRead - bytesRead);
+        if(read <= 0)
+            break;
+        bytesRead += read;
+    }
+
+    // end of sound file
+    m_eof = bytesRead < maxRead;
+
+    chunk.format = m_format;
+    if(m_downMix != StreamSoundSource::NoDownMix && m_format == AL_FORMAT_STEREO16) {
+        assert(bytesRead % 2 == 0);
+        bytesRead /= 2;
+        auto data = reinterpret_cast<uint16_t*>(chunk.data.data());
+        for(int i = 0; i < bytesRead / 2; i++)
+            data[i] = data[2 * i + (m_downMix == StreamSoundSource::DownMixLeft ? 0 : 1)];
+        chunk.format = AL_FORMAT_MONO16;
+    }
+
+    chunk.data.resize(bytesRead);
+    chunk.last = m_eof;
 }
@@ -24,16 +24,17 @@
 #define STREAMSOUNDSOURCE_H
 
 #include "soundsource.h"
+#include <framework/stdext/spsc_queue.h>
 
 class StreamSoundSource : public SoundSource
 {
+public:
     enum {
         STREAM_BUFFER_SIZE = 1024 * 400,
         STREAM_FRAGMENTS = 4,
         STREAM_FRAGMENT_SIZE = STREAM_BUFFER_SIZE / STREAM_FRAGMENTS
     };
 
-public:
     enum DownMix { NoDownMix, DownMixLeft, DownMixRight };
 
     StreamSoundSource();
@@ -43,25 +44,85 @@ public:
     void stop() override;
 
     bool isPlaying() override { return m_playing; }
+    bool isStreaming() override { return true; }
 
-    void setSoundFile(const SoundFilePtr& soundFile);
+    void setDecoder(const StreamDecoderPtr& decoder);
 
     void downMix(DownMix downMix);
+    DownMix getDownMix() { return m_downMix; }
 
     void update() override;
 
 private:
     void queueBuffers();
     void unqueueBuffers();
-    bool fillBufferAndQueue(uint buffer);
+    bool isSourcePlaying();
 
-    SoundFilePtr m_soundFile;
+    StreamDecoderPtr m_decoder;
     std::array<SoundBufferPtr, STREAM_FRAGMENTS> m_buffers;
+    std::vector<uint> m_freeBuffers;
     DownMix m_downMix;
     bool m_looping{ false },
         m_playing{ false },
+        m_started{ false },
         m_eof{ false },
         m_waitingFile{ false };
 };
 
+// decodes a sound file ahead of a StreamSoundSource on the audio decoding
+// thread, the source picks the finished fragments up from the main thread
+class StreamDecoder
+{
+public:
+    struct Chunk
+    {
+        std::vector<char> data;
+        ALenum format{ AL_NONE };
+        uint generation{ 0 };
+        bool last{ false };
+    };
+
+    StreamDecoder(const SoundFilePtr& soundFile, StreamSoundSource::DownMix downMix);
+
+    // decodes the whole file into memory, only before the decoder is shared
+    void decodeAll();
+
+    const std::shared_ptr<const std::vector<char>>& getSamples() { return m_samples; }
+    ALenum getSampleFormat() { return m_format; }
+    int getRate() { return m_rate; }
+    const std::string& getName() { return m_name; }
+
+    // main thread
+    bool pop(Chunk& chunk);
+    void restart() { m_generation.fetch_add(1, std::memory_order_release); }
+    void cancel() { m_cancelled.store(true, std::memory_order_release); }
+
+    // decoding thread, returns whether anything new was decoded
+    bool decode();
+    bool isCancelled() { return m_cancelled.load(std::memory_order_acquire); }
+
+private:
+    int read(char* buffer, int size);
+    void rewind();
+    void decodeChunk(Chunk& chunk);
+
+    SoundFilePtr m_soundFile;
+    std::shared_ptr<const std::vector<char>> m_samples;
+    size_t m_samplesOffset{ 0 };
+    std::string m_name;
+    ALenum m_format;
+    int m_rate;
+    StreamSoundSource::DownMix m_downMix;
+
+    stdext::spsc_queue<Chunk, StreamSoundSource::STREAM_FRAGMENTS> m_chunks;
+    std::atomic<uint> m_generation{ 0 };
+    std::atomic<bool> m_cancelled{ false };
+
+    // owned by the decoding thread
+    Chunk m_pending;
+    uint m_decodedGeneration{ 0 };
+    bool m_hasPending{ false },
+        m_eof{ false };
+};
+
 #endif
@@ -22,6 +22,9 @@
 
 #include "database.h"
 
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/logger.h>
+
 boost::recursive_mutex DBQuery::databaseLock;
 
 DBResultPtr Database::verifyResult(DBResultPtr result)
@@ -33,6 +36,109 @@ DBResultPtr Database::verifyResult(DBResultPtr result)
     return nullptr;
 }
 
+void Database::asyncExecuteQuery(const std::string& query, const std::vector<std::string>& params, const ExecuteCallback& callback)
+{
+    const QueryTemplatePtr prepared = prepareQuery(query, params);
+    bool ret = false;
+    if(prepared->size() != params.size() + 1)
+        g_logger.error(stdext::format("[Database::asyncExecuteQuery] query expects %d params, %d given: %s", prepared->size() - 1, params.size(), query));
+    else
+        ret = executeQuery(bindQuery(*prepared, params, [this](const std::string& param) { return escapeString(param); }));
+
+    if(callback)
+        callback(ret);
+}
+
+void Database::asyncStoreQuery(const std::string& query, const std::vector<std::string>& params, const StoreCallback& callback)
+{
+    const QueryTemplatePtr prepared = prepareQuery(query, params);
+    DBResultPtr result;
+    if(prepared->size() != params.size() + 1)
+        g_logger.error(stdext::format("[Database::asyncStoreQuery] query expects %d params, %d given: %s", prepared->size() - 1, params.size(), query));
+    else
+        result = storeQuery(bindQuery(*prepared, params, [this](const std::string& param) { return escapeString(param); }));
+
+    if(callback)
+        callback(result);
+}
+
+void Database::asyncInsert(const std::string& query, const std::string& row)
+{
+    std::string& buffer = m_pendingInserts[query];
+    if(!buffer.empty())
+        buffer += ",";
+    buffer += "(" + row + ")";
+
+    if(buffer.length() > MAX_INSERT_BUFFER) {
+        const std::string statement = query + buffer;
+        m_pendingInserts.erase(query);
+        asyncExecuteQuery(statement, {}, nullptr);
+    } else if(!m_insertFlushEvent) {
+        const DatabasePtr self = static_self_cast<Database>();
+        m_insertFlushEvent = g_dispatcher.scheduleEvent([self] { self->flushInserts(); }, m_insertFlushInterval);
+    }
+}
+
+void Database::flushInserts()
+{
+    if(m_insertFlushEvent) {
+        m_insertFlushEvent->cancel();
+        m_insertFlushEvent = nullptr;
+    }
+
+    std::map<std::string, std::string> pendingInserts;
+    pendingInserts.swap(m_pendingInserts);
+    for(const auto& it : pendingInserts)
+        asyncExecuteQuery(it.first + it.second, {}, nullptr);
+}
+
+Database::QueryTemplatePtr Database::prepareQuery(const std::string& query, const std::vector<std::string>& params)
+{
+    // queries without params are sent as they are, their text may hold anything, batched rows included
+    if(params.empty())
+        return std::make_shared<QueryTemplate>(1, query);
+
+    auto it = m_preparedQueries.find(query);
+    if(it != m_preparedQueries.end())
+        return it->second;
+
+    if(m_preparedQueries.size() >= MAX_PREPARED_QUERIES)
+        m_preparedQueries.clear();
+
+    const auto prepared = std::make_shared<QueryTemplate>(1);
+    char quote = 0;
+    for(std::size_t i = 0; i < query.length(); ++i) {
+        const char c = query[i];
+        if(quote) {
+            prepared->back() += c;
+            if(c == '\\' && i + 1 < query.length())
+                prepared->back() += query[++i];
+            else if(c == quote)
+                quote = 0;
+        } else if(c == '?') {
+            prepared->emplace_back();
+        } else {
+            if(c == '\'' || c == '"' || c == '`')
+                quote = c;
+            prepared->back() += c;
+        }
+    }
+
+    m_preparedQueries.emplace(query, prepared);
+    return prepared;
+}
+
+std::string Database::bindQuery(const QueryTemplate& query, const std::vector<std::string>& params,
+                                const std::function<std::string(const std::string&)>& escape)
+{
+    std::string result = query[0];
+    for(std::size_t i = 0; i < params.size() && i + 1 < query.size(); ++i) {
+        result += escape(params[i]);
+        result += query[i + 1];
+    }
+    return result;
+}
+
 void DBInsert::setQuery(const std::string& query)
 {
     m_query = query;
@@ -46,7 +152,7 @@ bool DBInsert::addRow(const std::string& row)
     if(m_buf.empty()) {
         m_buf = "(" + row + ")";
     }
-    else if(m_buf.length() > 8192)
+    else if(m_buf.length() > Database::MAX_INSERT_BUFFER)
     {
         if(!execute())
             return false;
@@ -25,6 +25,7 @@
 #include "declarations.h"
 
 #include <framework/luaengine/luaobject.h>
+#include <framework/core/scheduledevent.h>
 
 #include <boost/thread.hpp>
 
@@ -33,7 +34,15 @@ class Database : public LuaObject
 public:
     friend class DBTransaction;
 
-    Database(): m_connected(false) {}
+    enum {
+        MAX_INSERT_BUFFER = 8192, // bytes of rows joined into one INSERT before it is sent
+        MAX_PREPARED_QUERIES = 256
+    };
+
+    typedef std::function<void(bool)> ExecuteCallback;
+    typedef std::function<void(const DBResultPtr&)> StoreCallback;
+
+    Database(): m_connected(false), m_insertFlushInterval(1000) {}
     virtual ~Database() { m_connected = false; }
 
     /**
@@ -78,6 +87,32 @@ public:
     */
     virtual DBResultPtr storeQuery(const std::string& query) { return nullptr; }
 
+    /**
+    * Asynchronous queries.
+    *
+    * Every '?' outside quotes in query is replaced by the matching param, escaped. The callback runs on the
+    * main thread once the query is done, databases without a connection pool run it right away.
+    *
+    * @param std::string query with '?' placeholders
+    * @param std::vector<std::string> placeholder values
+    */
+    virtual void asyncExecuteQuery(const std::string& query, const std::vector<std::string>& params, const ExecuteCallback& callback);
+    virtual void asyncStoreQuery(const std::string& query, const std::vector<std::string>& params, const StoreCallback& callback);
+
+    /**
+    * Batched inserts.
+    *
+    * Rows added for the same INSERT prototype are joined into one asynchronous query, sent when the
+    * buffer is full or once the flush interval has passed since the first row.
+    *
+    * @param std::string INSERT prototype, up to the VALUES keyword
+    * @param std::string row data, without parentheses
+    */
+    void asyncInsert(const std::string& query, const std::string& row);
+    void flushInserts();
+    void setInsertFlushInterval(int interval) { m_insertFlushInterval = std::max<int>(interval, 0); }
+    int getInsertFlushInterval() { return m_insertFlushInterval; }
+
     /**
     * Escapes string for query.
     *
@@ -143,10 +178,21 @@ protected:
 
     DBResultPtr verifyResult(DBResultPtr result);
 
+    /// Query split at its placeholders, cached by query text
+    typedef std::vector<std::string> QueryTemplate;
+    typedef std::shared_ptr<const QueryTemplate> QueryTemplatePtr;
+    QueryTemplatePtr prepareQuery(const std::string& query, const std::vector<std::string>& params);
+    static std::string bindQuery(const QueryTemplate& query, const std::vector<std::string>& params,
+                                 const std::function<std::string(const std::string&)>& escape);
+
     ticks_t m_use;
     bool m_connected;
 
 private:
+    std::unordered_map<std::string, QueryTemplatePtr> m_preparedQueries;
+    std::map<std::string, std::string> m_pendingInserts;
+    ScheduledEventPtr m_insertFlushEvent;
+    int m_insertFlushInterval;
     static DatabasePtr m_instance;
 };
 
@@ -24,10 +24,46 @@
 
 #include <mysql/errmsg.h>
 
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/logger.h>
 
+namespace {
+    bool isConnectionError(unsigned int error)
+    {
+        return error == CR_SOCKET_CREATE_ERROR ||
+               error == CR_CONNECTION_ERROR ||
+               error == CR_CONN_HOST_ERROR ||
+               error == CR_IPSOCK_ERROR ||
+               error == CR_UNKNOWN_HOST ||
+               error == CR_SERVER_GONE_ERROR ||
+               error == CR_SERVER_LOST ||
+               error == CR_SERVER_HANDSHAKE_ERR;
+    }
+
+    std::string escapeBlob(MYSQL* handle, const char* s, uint32 length)
+    {
+        if(!s) {
+            return std::string();
+        }
+
+        char* output = new char[length * 2 + 1];
+        mysql_real_escape_string(handle, output, s, length);
+
+        std::string res = "'";
+        res += output;
+        res += "'";
+
+        delete[] output;
+        return res;
+    }
+}
+
 DatabaseMySQL::DatabaseMySQL()
 {
+    m_port = 0;
+    m_lastCallbackId = 0;
+    m_asyncCallbacks = std::make_shared<AsyncCallbackMap>();
+
     m_handle = new MYSQL();
     if(!mysql_init(m_handle)) {
         g_logger.fatal("Failed to initialize MySQL connection handle.");
@@ -39,6 +75,7 @@ DatabaseMySQL::DatabaseMySQL()
 
 DatabaseMySQL::~DatabaseMySQL()
 {
+    stopAsync();
     mysql_close(m_handle);
     delete m_handle;
 }
@@ -46,6 +83,14 @@ DatabaseMySQL::~DatabaseMySQL()
 void DatabaseMySQL::connect(const std::string& host, const std::string& user, const std::string& pass,
              const std::string& db, uint16 port, const std::string& unix_socket)
 {
+    // kept for the connections of the async pool
+    m_host = host;
+    m_user = user;
+    m_pass = pass;
+    m_database = db;
+    m_port = port;
+    m_unixSocket = unix_socket;
+
     if(!mysql_real_connect(m_handle,
                            host.c_str(),
                            user.c_str(),
@@ -65,14 +110,7 @@ bool DatabaseMySQL::handleError()
     unsigned int error = mysql_errno(m_handle);
     g_logger.error(stdext::format("MYSQL error code = %d, message: %s", error, mysql_error(m_handle)));
 
-    if(error == CR_SOCKET_CREATE_ERROR ||
-       error == CR_CONNECTION_ERROR ||
-       error == CR_CONN_HOST_ERROR ||
-       error == CR_IPSOCK_ERROR ||
-       error == CR_UNKNOWN_HOST ||
-       error == CR_SERVER_GONE_ERROR ||
-       error == CR_SERVER_LOST ||
-       error == CR_SERVER_HANDSHAKE_ERR) {
+    if(isConnectionError(error)) {
         g_logger.error("MYSQL connection lost, trying to reconnect...");
         setConnected(false);
 
@@ -180,19 +218,182 @@ std::string DatabaseMySQL::escapeString(const std::string &s)
 
 std::string DatabaseMySQL::escapeBlob(const char* s, uint32 length)
 {
-    if(!s) {
-        return std::string();
+    return ::escapeBlob(m_handle, s, length);
+}
+
+void DatabaseMySQL::startAsync(int connections)
+{
+    if(isAsync())
+        return;
+
+    if(!isConnected()) {
+        g_logger.error("[DatabaseMySQL::startAsync] the database must be connected first");
+        return;
+    }
+
+    m_asyncRunning = true;
+    for(int i = 0; i < std::max<int>(connections, 1); ++i)
+        m_asyncThreads.emplace_back([this] { asyncLoop(); });
+}
+
+void DatabaseMySQL::stopAsync()
+{
+    if(!isAsync())
+        return;
+
+    flushInserts();
+    {
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        m_asyncRunning = false;
+    }
+    m_asyncCondition.notify_all();
+    for(std::thread& thread : m_asyncThreads)
+        thread.join();
+    m_asyncThreads.clear();
+}
+
+void DatabaseMySQL::asyncExecuteQuery(const std::string& query, const std::vector<std::string>& params, const ExecuteCallback& callback)
+{
+    if(!isAsync()) {
+        Database::asyncExecuteQuery(query, params, callback);
+        return;
     }
 
-    char* output = new char[length * 2 + 1];
-    mysql_real_escape_string(m_handle, output, s, length);
+    AsyncCallback asyncCallback;
+    if(callback)
+        asyncCallback = [callback](bool ret, MYSQL_RES*) { callback(ret); };
+    pushAsyncQuery(query, params, asyncCallback, false);
+}
 
-    std::string res = "'";
-    res += output;
-    res += "'";
+void DatabaseMySQL::asyncStoreQuery(const std::string& query, const std::vector<std::string>& params, const StoreCallback& callback)
+{
+    if(!isAsync()) {
+        Database::asyncStoreQuery(query, params, callback);
+        return;
+    }
+
+    AsyncCallback asyncCallback;
+    if(callback) {
+        const DatabaseMySQLPtr self = static_self_cast<DatabaseMySQL>();
+        asyncCallback = [self, callback](bool, MYSQL_RES* res) {
+            DBResultPtr result;
+            if(res)
+                result = self->verifyResult(MySQLResultPtr(new MySQLResult(res)));
+            callback(result);
+        };
+    }
+    pushAsyncQuery(query, params, asyncCallback, true);
+}
 
-    delete[] output;
-    return res;
+void DatabaseMySQL::pushAsyncQuery(const std::string& query, const std::vector<std::string>& params, const AsyncCallback& callback, bool store)
+{
+    const QueryTemplatePtr prepared = prepareQuery(query, params);
+    if(prepared->size() != params.size() + 1) {
+        g_logger.error(stdext::format("[DatabaseMySQL::pushAsyncQuery] query expects %d params, %d given: %s", prepared->size() - 1, params.size(), query));
+        if(callback)
+            callback(false, nullptr);
+        return;
+    }
+
+    uint32 callbackId = 0;
+    if(callback) {
+        // 0 means no callback
+        if(++m_lastCallbackId == 0)
+            ++m_lastCallbackId;
+        callbackId = m_lastCallbackId;
+        (*m_asyncCallbacks)[callbackId] = callback;
+    }
+
+    ++m_pendingAsyncQueries;
+    {
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        m_asyncQueries.push_back(AsyncQuery{prepared, params, callbackId, store && callbackId != 0});
+    }
+    m_asyncCondition.notify_one();
+}
+
+void DatabaseMySQL::asyncLoop()
+{
+    mysql_thread_init();
+
+    MYSQL* handle = mysql_init(nullptr);
+    my_bool reconnect = true;
+    mysql_options(handle, MYSQL_OPT_RECONNECT, &reconnect);
+    if(!mysql_real_connect(handle, m_host.c_str(), m_user.c_str(), m_pass.c_str(), m_database.c_str(), m_port,
+                           m_unixSocket.empty() ? nullptr : m_unixSocket.c_str(), 0))
+        g_logger.error(stdext::format("Failed to open async database connection. MYSQL ERROR: %s", mysql_error(handle)));
+
+    const std::shared_ptr<AsyncCallbackMap> callbacks = m_asyncCallbacks;
+    while(true) {
+        AsyncQuery query;
+        {
+            std::unique_lock<std::mutex> lock(m_asyncMutex);
+            m_asyncCondition.wait(lock, [this] { return !m_asyncRunning || !m_asyncQueries.empty(); });
+            if(m_asyncQueries.empty())
+                break;
+            query = std::move(m_asyncQueries.front());
+            m_asyncQueries.pop_front();
+        }
+
+        const std::string text = bindQuery(*query.query, query.params, [handle](const std::string& param) {
+            return ::escapeBlob(handle, param.c_str(), param.length());
+        });
+
+        bool ret = false;
+        MYSQL_RES* res = nullptr;
+        while(true) {
+            if(mysql_real_query(handle, text.c_str(), text.length()) == 0) {
+                res = mysql_store_result(handle);
+                ret = res || mysql_errno(handle) == 0;
+                if(!ret)
+                    handleAsyncError(handle);
+                break;
+            }
+            if(!handleAsyncError(handle))
+                break;
+        }
+
+        if(res && !query.store) {
+            mysql_free_result(res);
+            res = nullptr;
+        }
+
+        --m_pendingAsyncQueries;
+        if(query.callbackId == 0)
+            continue;
+
+        const uint32 callbackId = query.callbackId;
+        g_asyncDispatcher.addMainThreadCallback([callbacks, callbackId, ret, res] {
+            auto it = callbacks->find(callbackId);
+            if(it == callbacks->end()) {
+                if(res)
+                    mysql_free_result(res);
+                return;
+            }
+            const AsyncCallback callback = std::move(it->second);
+            callbacks->erase(it);
+            callback(ret, res);
+        });
+    }
+
+    mysql_close(handle);
+    mysql_thread_end();
+}
+
+bool DatabaseMySQL::handleAsyncError(MYSQL* handle)
+{
+    const unsigned int error = mysql_errno(handle);
+    g_logger.error(stdext::format("MYSQL async error code = %d, message: %s", error, mysql_error(handle)));
+    if(!isConnectionError(error))
+        return false;
+
+    // only this connection waits, the query is retried once it is back
+    while(m_asyncRunning) {
+        if(mysql_ping(handle) == 0)
+            return true;
+        stdext::millisleep(100);
+    }
+    return false;
 }
 
 int32 MySQLResult::getDataInt(const std::string& s)
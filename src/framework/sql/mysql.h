@@ -33,6 +33,12 @@
 
 #include <mysql/mysql.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 class DatabaseMySQL : public Database
 {
 public:
@@ -49,6 +55,22 @@ public:
     virtual bool executeQuery(const std::string& query);
     virtual DBResultPtr storeQuery(const std::string& query);
 
+    /**
+    * Connection pool.
+    *
+    * Opens connections to the database given to connect(), each served by its own thread, asynchronous
+    * queries go to whichever connection is free. Queries queued when it stops still run.
+    *
+    * @param int number of connections
+    */
+    void startAsync(int connections);
+    void stopAsync();
+    bool isAsync() { return !m_asyncThreads.empty(); }
+    int getPendingAsyncQueries() { return m_pendingAsyncQueries; }
+
+    virtual void asyncExecuteQuery(const std::string& query, const std::vector<std::string>& params, const ExecuteCallback& callback);
+    virtual void asyncStoreQuery(const std::string& query, const std::vector<std::string>& params, const StoreCallback& callback);
+
     virtual std::string escapeString(const std::string &s);
     virtual std::string escapeBlob(const char* s, uint32 length);
 
@@ -60,6 +82,40 @@ protected:
     bool internalExecuteQuery(const std::string &query);
 
     MYSQL* m_handle;
+
+private:
+    typedef std::function<void(bool, MYSQL_RES*)> AsyncCallback;
+    typedef std::unordered_map<uint32, AsyncCallback> AsyncCallbackMap;
+
+    struct AsyncQuery {
+        QueryTemplatePtr query;
+        std::vector<std::string> params;
+        uint32 callbackId; // 0 when nobody waits for the result
+        bool store;
+    };
+
+    void pushAsyncQuery(const std::string& query, const std::vector<std::string>& params, const AsyncCallback& callback, bool store);
+    void asyncLoop();
+    bool handleAsyncError(MYSQL* handle);
+
+    std::string m_host;
+    std::string m_user;
+    std::string m_pass;
+    std::string m_database;
+    std::string m_unixSocket;
+    uint16 m_port;
+
+    std::vector<std::thread> m_asyncThreads;
+    std::deque<AsyncQuery> m_asyncQueries;
+    std::mutex m_asyncMutex;
+    std::condition_variable m_asyncCondition;
+    std::atomic<bool> m_asyncRunning{false};
+    std::atomic<int> m_pendingAsyncQueries{0};
+
+    // callbacks hold lua references, they are only ever touched on the main thread,
+    // finished queries reach them by id through a shared map so they can outlive this object
+    std::shared_ptr<AsyncCallbackMap> m_asyncCallbacks;
+    uint32 m_lastCallbackId;
 };
 
 class MySQLResult : public DBResult
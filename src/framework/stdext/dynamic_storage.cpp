@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "dynamic_storage.h"
+#include "any.h"
+#include "time.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace stdext {
+    namespace {
+        // shaped like the attributes things, items and creatures keep
+        struct bench_position { int x, y; short z; };
+        struct bench_light { uint8 intensity, color; };
+
+        enum bench_attr : uint8 { AttrGround, AttrStackable, AttrDisplacement, AttrName, AttrLight, AttrLast };
+
+        // the storage as it was before, one heap allocated any per set attribute
+        struct any_storage {
+            template<typename T> void set(uint8 k, const T& value)
+            {
+                if(m_data.size() <= k)
+                    m_data.resize(k + 1);
+                m_data[k] = value;
+            }
+            template<typename T> T get(uint8 k) const { return k < m_data.size() && !m_data[k].empty() ? any_cast<T>(m_data[k]) : T(); }
+            std::vector<any> m_data;
+        };
+
+        template<typename Storage>
+        size_t run(int iterations)
+        {
+            size_t checksum = 0;
+            for(int i = 0; i < iterations; ++i) {
+                Storage storage;
+                storage.set(AttrGround, static_cast<uint16>(i));
+                storage.set(AttrStackable, (i & 1) == 0);
+                storage.set(AttrDisplacement, bench_position{i, i + 1, 7});
+                storage.set(AttrName, std::string("dragon lord"));
+                storage.set(AttrLight, bench_light{static_cast<uint8>(i), 215});
+                for(int j = 0; j < 8; ++j) {
+                    checksum += storage.template get<uint16>(AttrGround);
+                    checksum += storage.template get<bool>(AttrStackable);
+                    checksum += storage.template get<bench_position>(AttrDisplacement).y;
+                    checksum += storage.template get<std::string>(AttrName).size();
+                    checksum += storage.template get<bench_light>(AttrLight).intensity;
+                }
+            }
+            return checksum;
+        }
+    }
+
+    std::tuple<double, double> benchmark_storage(int iterations)
+    {
+        iterations = std::max<int>(1, iterations);
+
+        timer timer;
+        size_t checksum = run<any_storage>(iterations);
+        const double anyMicros = timer.elapsed_micros();
+
+        timer.restart();
+        checksum += run<dynamic_storage<uint8>>(iterations);
+        const double smallMicros = timer.elapsed_micros();
+
+        // keeps the loops from being optimized away
+        if(checksum == 0)
+            std::cerr << checksum;
+
+        return std::make_tuple(anyMicros, smallMicros);
+    }
+}
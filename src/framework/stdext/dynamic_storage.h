@@ -24,45 +24,71 @@
 #define STDEXT_DYNAMICSTORAGE_H
 
 #include "types.h"
-#include "any.h"
-#include <unordered_map>
+#include "small_any.h"
+#include <cstdint>
+#include <tuple>
+#include <vector>
 
 namespace stdext {
+    // values are packed one after another, a table indexed by key holds their position,
+    // so lookups are two loads and storing scalars, positions or short strings allocates nothing
     template<typename Key>
     class dynamic_storage {
     public:
         template<typename T> void set(const Key& k, const T& value)
         {
-            if(m_data.size() <= k)
-                m_data.resize(k + 1);
-            m_data[k] = value;
+            const std::size_t key = static_cast<std::size_t>(k);
+            if(m_index.size() <= key)
+                m_index.resize(key + 1, 0);
+
+            if(m_index[key])
+                m_values[m_index[key] - 1] = value;
+            else {
+                assert(m_values.size() < UINT8_MAX);
+                m_values.emplace_back(value);
+                m_index[key] = static_cast<uint8>(m_values.size());
+            }
         }
         bool remove(const Key& k)
         {
-            if(m_data.size() < k)
-                return false;
-            if(m_data[k].empty())
+            if(!has(k))
                 return false;
-            m_data[k] = any();
+
+            const uint8 slot = m_index[static_cast<std::size_t>(k)];
+            m_values.erase(m_values.begin() + (slot - 1));
+            m_index[static_cast<std::size_t>(k)] = 0;
+            for(uint8& index : m_index) {
+                if(index > slot)
+                    --index;
+            }
             return true;
         }
-        template<typename T> T get(const Key& k) const { return has(k) ? any_cast<T>(m_data[k]) : T(); }
-        bool has(const Key& k) const { return k < m_data.size() && !m_data[k].empty(); }
-
-        std::size_t size() const
+        template<typename T> T get(const Key& k) const
         {
-            std::size_t count = 0;
-            for(std::size_t i = 0; i < m_data.size(); ++i)
-                if(!m_data[i].empty())
-                    count++;
-            return count;
+            const std::size_t key = static_cast<std::size_t>(k);
+            if(key >= m_index.size() || !m_index[key])
+                return T();
+            const small_any& value = m_values[m_index[key] - 1];
+            return value.is<T>() ? value.get<T>() : T();
         }
+        bool has(const Key& k) const
+        {
+            const std::size_t key = static_cast<std::size_t>(k);
+            return key < m_index.size() && m_index[key] != 0;
+        }
+        const std::type_info& type(const Key& k) const { return has(k) ? m_values[m_index[static_cast<std::size_t>(k)] - 1].type() : typeid(void); }
 
-        void clear() { m_data.clear(); }
+        std::size_t size() const { return m_values.size(); }
+
+        void clear() { m_index.clear(); m_values.clear(); }
 
     private:
-        std::vector<any> m_data;
+        std::vector<uint8> m_index; // position + 1 in m_values, 0 when the key is not set
+        std::vector<small_any> m_values;
     };
+
+    // microseconds spent reading and writing attributes with the former any based storage and with this one
+    std::tuple<double, double> benchmark_storage(int iterations);
 }
 
 #endif
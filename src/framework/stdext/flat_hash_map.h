@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef STDEXT_FLAT_HASH_MAP_H
+#define STDEXT_FLAT_HASH_MAP_H
+
+#include "types.h"
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace stdext {
+    // hash map with open addressing and linear probing, entries live in one flat array so a lookup usually
+    // touches a single cache line; erasing shifts the following entries back instead of leaving tombstones.
+    // Keys and values must be default constructible. Growing and erasing invalidate iterators and references.
+    template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class flat_hash_map {
+    public:
+        typedef std::pair<Key, Value> value_type;
+
+        template<typename Map, typename Entry>
+        class basic_iterator {
+        public:
+            basic_iterator(Map* map, std::size_t index) : m_map(map), m_index(index) { skip(); }
+
+            Entry& operator*() const { return m_map->m_slots[m_index]; }
+            Entry* operator->() const { return &m_map->m_slots[m_index]; }
+            basic_iterator& operator++() { ++m_index; skip(); return *this; }
+            bool operator==(const basic_iterator& other) const { return m_index == other.m_index; }
+            bool operator!=(const basic_iterator& other) const { return m_index != other.m_index; }
+
+        private:
+            void skip() { while(m_index < m_map->m_used.size() && !m_map->m_used[m_index]) ++m_index; }
+
+            Map* m_map;
+            std::size_t m_index;
+
+            friend class flat_hash_map;
+        };
+
+        typedef basic_iterator<flat_hash_map, value_type> iterator;
+        typedef basic_iterator<const flat_hash_map, const value_type> const_iterator;
+
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, m_used.size()); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, m_used.size()); }
+
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        iterator find(const Key& key) { return iterator(this, lookup(key)); }
+        const_iterator find(const Key& key) const { return const_iterator(this, lookup(key)); }
+        std::size_t count(const Key& key) const { return lookup(key) != m_used.size() ? 1 : 0; }
+
+        Value& operator[](const Key& key) { return emplace(key, Value()).first->second; }
+
+        std::pair<iterator, bool> insert(const value_type& value) { return emplace(value.first, value.second); }
+        std::pair<iterator, bool> emplace(const Key& key, const Value& value)
+        {
+            if((m_size + 1) * 4 > m_used.size() * 3)
+                rehash(m_used.empty() ? MIN_CAPACITY : m_used.size() * 2);
+
+            std::size_t index = slot(key);
+            while(m_used[index]) {
+                if(m_equal(m_slots[index].first, key))
+                    return std::make_pair(iterator(this, index), false);
+                index = (index + 1) & (m_used.size() - 1);
+            }
+
+            m_used[index] = 1;
+            m_slots[index].first = key;
+            m_slots[index].second = value;
+            ++m_size;
+            return std::make_pair(iterator(this, index), true);
+        }
+
+        std::size_t erase(const Key& key)
+        {
+            std::size_t index = lookup(key);
+            if(index == m_used.size())
+                return 0;
+
+            // move back every following entry of the run whose home slot is not between the hole and itself
+            const std::size_t mask = m_used.size() - 1;
+            for(std::size_t next = (index + 1) & mask; m_used[next]; next = (next + 1) & mask) {
+                const std::size_t home = slot(m_slots[next].first);
+                if(((next - home) & mask) >= ((next - index) & mask)) {
+                    m_slots[index] = std::move(m_slots[next]);
+                    index = next;
+                }
+            }
+
+            m_used[index] = 0;
+            m_slots[index] = value_type();
+            --m_size;
+            return 1;
+        }
+
+        // keeps the table so refilling it does not allocate again
+        void clear()
+        {
+            for(std::size_t i = 0; i < m_used.size(); ++i) {
+                if(m_used[i]) {
+                    m_used[i] = 0;
+                    m_slots[i] = value_type();
+                }
+            }
+            m_size = 0;
+        }
+
+        void reserve(std::size_t count)
+        {
+            std::size_t capacity = MIN_CAPACITY;
+            while(count * 4 > capacity * 3)
+                capacity *= 2;
+            if(capacity > m_used.size())
+                rehash(capacity);
+        }
+
+    private:
+        enum { MIN_CAPACITY = 16 };
+
+        // fibonacci hashing spreads weak hashes such as identities over the whole table
+        std::size_t slot(const Key& key) const
+        {
+            return static_cast<std::size_t>((static_cast<uint64>(m_hash(key)) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+        }
+
+        std::size_t lookup(const Key& key) const
+        {
+            if(m_size == 0)
+                return m_used.size();
+
+            for(std::size_t index = slot(key); m_used[index]; index = (index + 1) & (m_used.size() - 1)) {
+                if(m_equal(m_slots[index].first, key))
+                    return index;
+            }
+            return m_used.size();
+        }
+
+        void rehash(std::size_t capacity)
+        {
+            std::vector<value_type> slots(capacity);
+            std::vector<uint8> used(capacity, 0);
+            slots.swap(m_slots);
+            used.swap(m_used);
+
+            m_shift = 64;
+            for(std::size_t i = capacity; i > 1; i >>= 1)
+                --m_shift;
+
+            for(std::size_t i = 0; i < used.size(); ++i) {
+                if(!used[i])
+                    continue;
+                std::size_t index = slot(slots[i].first);
+                while(m_used[index])
+                    index = (index + 1) & (capacity - 1);
+                m_used[index] = 1;
+                m_slots[index] = std::move(slots[i]);
+            }
+        }
+
+        std::vector<value_type> m_slots;
+        std::vector<uint8> m_used;
+        std::size_t m_size = 0;
+        int m_shift = 64;
+        Hash m_hash;
+        KeyEqual m_equal;
+    };
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "format.h"
+#include "time.h"
+
+namespace stdext {
+    std::tuple<double, double> benchmark_format(int iterations)
+    {
+        iterations = std::max<int>(1, iterations);
+        const std::string position = "(32000, 32000, 7)";
+        size_t checksum = 0;
+
+        // messages shaped like the ones logged and drawn every frame
+        timer timer;
+        for(int i = 0; i < iterations; ++i) {
+            checksum += format("invalid effect id %d", i).size();
+            checksum += format("too many things, pos=%s, stackpos=%d", position, i & 0xff).size();
+            checksum += format("%d", i * 7).size();
+            checksum += format("%s: %.1f%%", position, i / 3.0).size();
+        }
+        const double sprintfMicros = timer.elapsed_micros();
+
+        timer.restart();
+        for(int i = 0; i < iterations; ++i) {
+            checksum += fmt("invalid effect id {}", i).size();
+            checksum += fmt("too many things, pos={}, stackpos={}", position, i & 0xff).size();
+            checksum += fmt("{}", i * 7).size();
+            checksum += fmt("{}: {:.1f}%", position, i / 3.0).size();
+        }
+        const double fmtMicros = timer.elapsed_micros();
+
+        // keeps the loops from being optimized away
+        if(checksum == 0)
+            std::cerr << checksum;
+
+        return std::make_tuple(sprintfMicros, fmtMicros);
+    }
+}
@@ -32,6 +32,10 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
 
 namespace stdext {
     template<class T> void print_ostream(std::ostringstream& stream, const T& last) { stream << last; }
@@ -101,6 +105,253 @@ namespace stdext {
         buffer.resize(n);
         return buffer;
     }
+
+    // decimal digits of an integer written backwards so they end at end, returns the first character
+    template<typename T>
+    char* format_integer(char* end, T value)
+    {
+        static_assert(std::is_integral<T>::value, "format_integer takes integers");
+        typedef typename std::make_unsigned<T>::type U;
+        bool negative = false;
+        if constexpr(std::is_signed<T>::value)
+            negative = value < 0;
+        U n = negative ? U(0) - static_cast<U>(value) : static_cast<U>(value);
+
+        static const char digits[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        while(n >= 100) {
+            const unsigned i = static_cast<unsigned>(n % 100) * 2;
+            n /= 100;
+            *--end = digits[i + 1];
+            *--end = digits[i];
+        }
+        if(n >= 10) {
+            const unsigned i = static_cast<unsigned>(n) * 2;
+            *--end = digits[i + 1];
+            *--end = digits[i];
+        } else
+            *--end = static_cast<char>('0' + n);
+
+        if(negative)
+            *--end = '-';
+        return end;
+    }
+
+    // writes the decimal representation of an integer without allocating, out needs room for 20 characters
+    template<typename T>
+    size_t to_chars(char* out, T value)
+    {
+        char buffer[24];
+        char* end = buffer + sizeof(buffer);
+        char* begin = format_integer(end, value);
+        const size_t length = end - begin;
+        std::memcpy(out, begin, length);
+        return length;
+    }
+
+    // string built in a buffer on the stack, it only moves to the heap past N characters
+    template<size_t N = 128>
+    class small_string
+    {
+    public:
+        small_string() = default;
+        small_string(const small_string&) = delete;
+        small_string& operator=(const small_string&) = delete;
+
+        void append(const char* s, size_t length)
+        {
+            if(!m_heap.empty() || m_size + length > N) {
+                if(m_heap.empty())
+                    m_heap.assign(m_buffer, m_size);
+                m_heap.append(s, length);
+            } else
+                std::memcpy(m_buffer + m_size, s, length);
+            m_size += length;
+        }
+        void append(std::string_view s) { append(s.data(), s.size()); }
+        void append(size_t count, char c) { for(size_t i = 0; i < count; ++i) push_back(c); }
+        void push_back(char c) { append(&c, 1); }
+        void clear() { m_size = 0; m_heap.clear(); }
+
+        const char* data() const { return m_heap.empty() ? m_buffer : m_heap.data(); }
+        size_t size() const { return m_size; }
+        std::string_view view() const { return std::string_view(data(), m_size); }
+        std::string str() const { return std::string(data(), m_size); }
+
+    private:
+        char m_buffer[N];
+        size_t m_size{ 0 };
+        std::string m_heap;
+    };
+
+    // what follows the colon of a {} placeholder: [fill][width][.precision][type]
+    struct format_spec {
+        char fill{ ' ' };
+        int width{ 0 };
+        int precision{ -1 };
+        char type{ 0 };
+    };
+
+    constexpr size_t count_placeholders(std::string_view format)
+    {
+        size_t count = 0;
+        for(size_t i = 0; i < format.size(); ++i) {
+            if(format[i] == '{') {
+                if(i + 1 < format.size() && format[i + 1] == '{')
+                    ++i;
+                else
+                    ++count;
+            }
+        }
+        return count;
+    }
+
+    template<size_t N>
+    void format_padded(small_string<N>& out, const format_spec& spec, const char* s, size_t length)
+    {
+        if(spec.width > static_cast<int>(length)) {
+            // zero fill goes after the sign
+            if(spec.fill == '0' && length > 0 && s[0] == '-') {
+                out.push_back('-');
+                ++s;
+                --length;
+                out.append(spec.width - length - 1, '0');
+            } else
+                out.append(spec.width - length, spec.fill);
+        }
+        out.append(s, length);
+    }
+
+    template<size_t N, typename T>
+    void format_arg(small_string<N>& out, const format_spec& spec, const T& value)
+    {
+        if constexpr(std::is_same<T, bool>::value) {
+            format_padded(out, spec, value ? "true" : "false", value ? 4 : 5);
+        } else if constexpr(std::is_same<T, char>::value) {
+            format_padded(out, spec, &value, 1);
+        } else if constexpr(std::is_enum<T>::value) {
+            format_arg(out, spec, static_cast<typename std::underlying_type<T>::type>(value));
+        } else if constexpr(std::is_integral<T>::value) {
+            // one byte integers are numbers here, unlike in streams
+            typedef typename std::conditional<(sizeof(T) < sizeof(int)), int, T>::type V;
+            const V v = static_cast<V>(value);
+            char buffer[24];
+            char* end = buffer + sizeof(buffer);
+            char* begin;
+            if(spec.type == 'x' || spec.type == 'X') {
+                typedef typename std::make_unsigned<V>::type U;
+                const char* hex = spec.type == 'x' ? "0123456789abcdef" : "0123456789ABCDEF";
+                U n = static_cast<U>(v);
+                begin = end;
+                do {
+                    *--begin = hex[n & 0xf];
+                    n >>= 4;
+                } while(n);
+            } else
+                begin = format_integer(end, v);
+            format_padded(out, spec, begin, end - begin);
+        } else if constexpr(std::is_floating_point<T>::value) {
+            char buffer[64];
+            const char conversion = spec.type == 'g' || spec.type == 'e' ? spec.type : (spec.precision >= 0 || spec.type == 'f' ? 'f' : 'g');
+            const char format[] = { '%', '.', '*', conversion, 0 };
+            const int length = std::snprintf(buffer, sizeof(buffer), format, spec.precision >= 0 ? spec.precision : 6, static_cast<double>(value));
+            format_padded(out, spec, buffer, std::min<size_t>(std::max<int>(length, 0), sizeof(buffer) - 1));
+        } else if constexpr(std::is_convertible<const T&, std::string_view>::value) {
+            const std::string_view s(value);
+            format_padded(out, spec, s.data(), spec.precision >= 0 ? std::min<size_t>(s.size(), spec.precision) : s.size());
+        } else if constexpr(std::is_pointer<T>::value) {
+            format_spec hexSpec = spec;
+            hexSpec.type = 'x';
+            out.append("0x", 2);
+            format_arg(out, hexSpec, reinterpret_cast<uintptr_t>(value));
+        } else {
+            // anything else goes through its stream operator, which does allocate
+            std::ostringstream stream;
+            stream << value;
+            const std::string s = stream.str();
+            format_padded(out, spec, s.data(), s.size());
+        }
+    }
+
+    template<size_t N>
+    void format_args(small_string<N>& out, std::string_view format, size_t pos)
+    {
+        // placeholders without arguments are left as they are
+        out.append(format.substr(pos));
+    }
+
+    template<size_t N, typename T, typename... Args>
+    void format_args(small_string<N>& out, std::string_view format, size_t pos, const T& first, const Args&... rest)
+    {
+        while(pos < format.size()) {
+            const size_t brace = format.find_first_of("{}", pos);
+            if(brace == std::string_view::npos)
+                break;
+
+            out.append(format.substr(pos, brace - pos));
+            pos = brace + 1;
+
+            // doubled braces are literal ones
+            if(pos < format.size() && format[pos] == format[brace]) {
+                out.push_back(format[brace]);
+                ++pos;
+                continue;
+            }
+            if(format[brace] == '}') {
+                out.push_back('}');
+                continue;
+            }
+
+            const size_t close = format.find('}', pos);
+            if(close == std::string_view::npos)
+                break;
+
+            format_spec spec;
+            if(format[pos] == ':') {
+                size_t i = pos + 1;
+                if(i < close && format[i] == '0')
+                    spec.fill = format[i++];
+                for(; i < close && format[i] >= '0' && format[i] <= '9'; ++i)
+                    spec.width = spec.width * 10 + (format[i] - '0');
+                if(i < close && format[i] == '.') {
+                    spec.precision = 0;
+                    for(++i; i < close && format[i] >= '0' && format[i] <= '9'; ++i)
+                        spec.precision = spec.precision * 10 + (format[i] - '0');
+                }
+                if(i < close)
+                    spec.type = format[i];
+            }
+
+            format_arg(out, spec, first);
+            format_args(out, format, close + 1, rest...);
+            return;
+        }
+
+        if(pos < format.size())
+            out.append(format.substr(pos));
+    }
+
+    // Format strings fmt style with {} placeholders, the pieces are written to the stack without
+    // temporary streams, specs like {:08.3f} or {:x} take fill, width, precision and type
+    template<size_t N, typename... Args>
+    void format_to(small_string<N>& out, std::string_view format, const Args&... args)
+    {
+        assert(count_placeholders(format) == sizeof...(Args));
+        format_args(out, format, 0, args...);
+    }
+
+    template<typename... Args>
+    std::string fmt(std::string_view format, const Args&... args)
+    {
+        small_string<> out;
+        format_to(out, format, args...);
+        return out.str();
+    }
+
+    // microseconds spent on each formatter for the same messages, old sprintf based one first
+    std::tuple<double, double> benchmark_format(int iterations);
 }
 
 #endif
@@ -23,28 +23,177 @@
 #include "math.h"
 #include <random>
 
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #ifdef _MSC_VER
 #pragma warning(disable:4267) // '?' : conversion from 'A' to 'B', possible loss of data
 #endif
 
+namespace {
+    // adler32 modulus and the most bytes that can be summed before a reduction without overflowing 32 bits
+    constexpr uint32_t ADLER_BASE = 65521;
+    constexpr size_t ADLER_NMAX = 5552;
+
+    // the vector paths take whole blocks of at most ADLER_NMAX bytes, sums of the bytes go to s1 lanes
+    // and sums weighted by their distance to the block end to s2 lanes, like zlib's simd versions
+#if defined(__AVX2__)
+    size_t adler32Avx2(const uint8_t* buffer, size_t size, uint32_t& s1, uint32_t& s2)
+    {
+        const __m256i taps = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                              16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi16(1);
+
+        size_t done = 0;
+        size_t blocks = size / 32;
+        while(blocks > 0) {
+            size_t n = std::min<size_t>(blocks, ADLER_NMAX / 32);
+            blocks -= n;
+
+            __m256i vps = _mm256_setr_epi32(s1 * n, 0, 0, 0, 0, 0, 0, 0);
+            __m256i vs2 = _mm256_setr_epi32(s2, 0, 0, 0, 0, 0, 0, 0);
+            __m256i vs1 = zero;
+            do {
+                const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + done));
+                vps = _mm256_add_epi32(vps, vs1);
+                vs1 = _mm256_add_epi32(vs1, _mm256_sad_epu8(bytes, zero));
+                vs2 = _mm256_add_epi32(vs2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, taps), ones));
+                done += 32;
+            } while(--n);
+            vs2 = _mm256_add_epi32(vs2, _mm256_slli_epi32(vps, 5));
+
+            const auto sum = [](__m256i v) {
+                __m128i r = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+                r = _mm_add_epi32(r, _mm_shuffle_epi32(r, _MM_SHUFFLE(1, 0, 3, 2)));
+                r = _mm_add_epi32(r, _mm_shuffle_epi32(r, _MM_SHUFFLE(2, 3, 0, 1)));
+                return static_cast<uint32_t>(_mm_cvtsi128_si32(r));
+            };
+            s1 = (s1 + sum(vs1)) % ADLER_BASE;
+            s2 = sum(vs2) % ADLER_BASE;
+        }
+        return done;
+    }
+#endif
+
+#if defined(__SSSE3__)
+    size_t adler32Ssse3(const uint8_t* buffer, size_t size, uint32_t& s1, uint32_t& s2)
+    {
+        const __m128i tapsHigh = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+        const __m128i tapsLow = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi16(1);
+
+        size_t done = 0;
+        size_t blocks = size / 32;
+        while(blocks > 0) {
+            size_t n = std::min<size_t>(blocks, ADLER_NMAX / 32);
+            blocks -= n;
+
+            __m128i vps = _mm_setr_epi32(s1 * n, 0, 0, 0);
+            __m128i vs2 = _mm_setr_epi32(s2, 0, 0, 0);
+            __m128i vs1 = zero;
+            do {
+                const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + done));
+                const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + done + 16));
+                vps = _mm_add_epi32(vps, vs1);
+                vs1 = _mm_add_epi32(vs1, _mm_add_epi32(_mm_sad_epu8(first, zero), _mm_sad_epu8(second, zero)));
+                vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_maddubs_epi16(first, tapsHigh), ones));
+                vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_maddubs_epi16(second, tapsLow), ones));
+                done += 32;
+            } while(--n);
+            vs2 = _mm_add_epi32(vs2, _mm_slli_epi32(vps, 5));
+
+            const auto sum = [](__m128i r) {
+                r = _mm_add_epi32(r, _mm_shuffle_epi32(r, _MM_SHUFFLE(1, 0, 3, 2)));
+                r = _mm_add_epi32(r, _mm_shuffle_epi32(r, _MM_SHUFFLE(2, 3, 0, 1)));
+                return static_cast<uint32_t>(_mm_cvtsi128_si32(r));
+            };
+            s1 = (s1 + sum(vs1)) % ADLER_BASE;
+            s2 = sum(vs2) % ADLER_BASE;
+        }
+        return done;
+    }
+#elif defined(__ARM_NEON)
+    size_t adler32Neon(const uint8_t* buffer, size_t size, uint32_t& s1, uint32_t& s2)
+    {
+        static const uint8_t tapValues[16] = { 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 };
+        const uint8x16_t taps = vld1q_u8(tapValues);
+
+        size_t done = 0;
+        size_t blocks = size / 16;
+        while(blocks > 0) {
+            size_t n = std::min<size_t>(blocks, ADLER_NMAX / 16);
+            blocks -= n;
+
+            uint32x4_t vps = vsetq_lane_u32(s1 * n, vdupq_n_u32(0), 0);
+            uint32x4_t vs2 = vsetq_lane_u32(s2, vdupq_n_u32(0), 0);
+            uint32x4_t vs1 = vdupq_n_u32(0);
+            do {
+                const uint8x16_t bytes = vld1q_u8(buffer + done);
+                vps = vaddq_u32(vps, vs1);
+                vs1 = vpadalq_u16(vs1, vpaddlq_u8(bytes));
+                vs2 = vpadalq_u16(vs2, vmull_u8(vget_low_u8(bytes), vget_low_u8(taps)));
+                vs2 = vpadalq_u16(vs2, vmull_u8(vget_high_u8(bytes), vget_high_u8(taps)));
+                done += 16;
+            } while(--n);
+            vs2 = vaddq_u32(vs2, vshlq_n_u32(vps, 4));
+
+            const auto sum = [](uint32x4_t v) {
+                const uint32x2_t r = vadd_u32(vget_low_u32(v), vget_high_u32(v));
+                return vget_lane_u32(vpadd_u32(r, r), 0);
+            };
+            s1 = (s1 + sum(vs1)) % ADLER_BASE;
+            s2 = sum(vs2) % ADLER_BASE;
+        }
+        return done;
+    }
+#endif
+}
+
 namespace stdext {
-    uint32_t adler32(const uint8_t* buffer, size_t size)
+    uint32_t adler32(const uint8_t* buffer, size_t size, uint32_t adler)
     {
-        size_t a = 1, b = 0, tlen;
+        uint32_t a = adler & 0xffff, b = adler >> 16;
+
+        size_t done = 0;
+#if defined(__AVX2__)
+        done += adler32Avx2(buffer, size, a, b);
+#endif
+#if defined(__SSSE3__)
+        done += adler32Ssse3(buffer + done, size - done, a, b);
+#elif defined(__ARM_NEON)
+        done += adler32Neon(buffer + done, size - done, a, b);
+#endif
+        buffer += done;
+        size -= done;
+
+        size_t tlen;
         while(size > 0) {
-            tlen = size > 5552 ? 5552 : size;
+            tlen = size > ADLER_NMAX ? ADLER_NMAX : size;
             size -= tlen;
             do {
                 a += *buffer++;
                 b += a;
             } while(--tlen);
 
-            a %= 65521;
-            b %= 65521;
+            a %= ADLER_BASE;
+            b %= ADLER_BASE;
         }
         return (b << 16) | a;
     }
 
+    uint64_t fnv1a64(const uint8_t* buffer, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        while(size-- > 0)
+            hash = (hash ^ *buffer++) * 1099511628211ULL;
+        return hash;
+    }
+
     long random_range(long min, long max)
     {
         static std::random_device rd;
@@ -46,7 +46,9 @@ namespace stdext {
     inline void writeSLE32(uchar* addr, int32_t value) { writeSLE16(addr + 2, value >> 16); writeSLE16(addr, static_cast<int16_t>(value)); }
     inline void writeSLE64(uchar* addr, int64_t value) { writeSLE32(addr + 4, value >> 32); writeSLE32(addr, static_cast<int32_t>(value)); }
 
-    uint32_t adler32(const uint8_t* buffer, size_t size);
+    // vectorized where the target allows it, adler continues a checksum over earlier data
+    uint32_t adler32(const uint8_t* buffer, size_t size, uint32_t adler = 1);
+    uint64_t fnv1a64(const uint8_t* buffer, size_t size);
 
     long random_range(long min, long max);
     float random_range(float min, float max);
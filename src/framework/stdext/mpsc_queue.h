@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef STDEXT_MPSC_QUEUE_H
+#define STDEXT_MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace stdext {
+    // unbounded lock free queue, any thread may push while exactly one thread pops
+    template<typename T>
+    class mpsc_queue {
+    public:
+        mpsc_queue() : m_head(&m_stub), m_tail(&m_stub) {}
+        ~mpsc_queue()
+        {
+            T value;
+            while(pop(value)) {}
+        }
+
+        mpsc_queue(const mpsc_queue&) = delete;
+        mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+        void push(T value)
+        {
+            Node* node = new Node;
+            node->value = std::move(value);
+            // producers only contend on this exchange, the link to the previous node is published right after
+            Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        // a push still linking its node reads as empty until it is done, the value shows up on the next pop
+        bool pop(T& value)
+        {
+            Node* tail = m_tail;
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if(tail == &m_stub) {
+                if(!next)
+                    return false;
+                m_tail = next;
+                tail = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+
+            if(next) {
+                m_tail = next;
+                value = std::move(tail->value);
+                delete tail;
+                return true;
+            }
+
+            // tail is the last node, the stub goes behind it so it can be handed out
+            if(tail != m_head.load(std::memory_order_acquire))
+                return false;
+            m_stub.next.store(nullptr, std::memory_order_relaxed);
+            Node* prev = m_head.exchange(&m_stub, std::memory_order_acq_rel);
+            prev->next.store(&m_stub, std::memory_order_release);
+
+            next = tail->next.load(std::memory_order_acquire);
+            if(!next)
+                return false;
+            m_tail = next;
+            value = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+
+        // only meaningful on the consumer thread
+        bool empty() const
+        {
+            const Node* tail = m_tail;
+            return tail == &m_stub && !tail->next.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct Node {
+            std::atomic<Node*> next{ nullptr };
+            T value;
+        };
+
+        Node m_stub;
+        // producers swap the head, the consumer owns the tail
+        alignas(64) std::atomic<Node*> m_head;
+        alignas(64) Node* m_tail;
+    };
+}
+
+#endif
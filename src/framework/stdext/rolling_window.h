@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef STDEXT_ROLLING_WINDOW_H
+#define STDEXT_ROLLING_WINDOW_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace stdext {
+    // keeps the last Capacity samples, older ones are overwritten
+    template<typename T, std::size_t Capacity>
+    class rolling_window {
+    public:
+        void push(T value)
+        {
+            m_items[m_next] = value;
+            m_next = (m_next + 1) % Capacity;
+            m_size = std::min(m_size + 1, Capacity);
+        }
+
+        void clear() { m_size = 0; m_next = 0; }
+        bool empty() const { return m_size == 0; }
+        std::size_t size() const { return m_size; }
+        T last() const { return m_size > 0 ? m_items[(m_next + Capacity - 1) % Capacity] : T(); }
+
+        T max() const { return m_size > 0 ? *std::max_element(m_items.begin(), m_items.begin() + m_size) : T(); }
+        double average() const
+        {
+            if(m_size == 0)
+                return 0;
+            double sum = 0;
+            for(std::size_t i = 0; i < m_size; ++i)
+                sum += m_items[i];
+            return sum / m_size;
+        }
+
+        // nearest rank percentile over the samples in the window, fraction goes from 0 to 1
+        T percentile(double fraction) const
+        {
+            if(m_size == 0)
+                return T();
+            std::array<T, Capacity> sorted;
+            std::copy(m_items.begin(), m_items.begin() + m_size, sorted.begin());
+            const std::size_t rank = std::min<std::size_t>(m_size - 1, std::max<double>(std::ceil(m_size * fraction), 1) - 1);
+            std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + m_size);
+            return sorted[rank];
+        }
+
+    private:
+        std::array<T, Capacity> m_items;
+        std::size_t m_next{ 0 };
+        std::size_t m_size{ 0 };
+    };
+}
+
+#endif
@@ -51,6 +51,8 @@ namespace stdext {
         template<typename T> stdext::shared_object_ptr<T> const_self_cast() { return stdext::shared_object_ptr<T>(const_cast<T*>(this)); }
 
     private:
+        // objects only ever touched by the main thread skip the atomic traffic, worker threads may create
+        // objects and hand them over through futures but must not share them while both sides hold references
 #ifdef THREAD_SAFE
         std::atomic<refcount_t> refs;
 #else
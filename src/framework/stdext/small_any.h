@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef STDEXT_SMALLANY_H
+#define STDEXT_SMALLANY_H
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace stdext {
+    // any that keeps values up to the size of a std::string inside itself, like scalars, positions, colors and short strings,
+    // only bigger types live on the heap
+    class small_any {
+    public:
+        enum { CAPACITY = 32 };
+
+        template<typename T>
+        struct fits_inline : std::integral_constant<bool,
+            (sizeof(T) <= CAPACITY && alignof(T) <= alignof(void*) && std::is_nothrow_move_constructible<T>::value)> {};
+
+        // one table per stored type, comparing table addresses is the type check
+        struct ops {
+            const std::type_info& (*type)();
+            void (*copy)(const small_any& from, small_any& to);
+            void (*move)(small_any& from, small_any& to);
+            void (*destroy)(small_any& value);
+        };
+
+        small_any() = default;
+        small_any(const small_any& other) { if(other.m_ops) other.m_ops->copy(other, *this); }
+        small_any(small_any&& other) noexcept { if(other.m_ops) other.m_ops->move(other, *this); }
+        template<typename T, typename = typename std::enable_if<!std::is_same<typename std::decay<T>::type, small_any>::value>::type>
+        small_any(T&& value) { emplace<typename std::decay<T>::type>(std::forward<T>(value)); }
+        ~small_any() { reset(); }
+
+        small_any& operator=(const small_any& other)
+        {
+            if(this != &other) {
+                reset();
+                if(other.m_ops)
+                    other.m_ops->copy(other, *this);
+            }
+            return *this;
+        }
+        small_any& operator=(small_any&& other) noexcept
+        {
+            if(this != &other) {
+                reset();
+                if(other.m_ops)
+                    other.m_ops->move(other, *this);
+            }
+            return *this;
+        }
+        template<typename T, typename = typename std::enable_if<!std::is_same<typename std::decay<T>::type, small_any>::value>::type>
+        small_any& operator=(T&& value)
+        {
+            typedef typename std::decay<T>::type U;
+            // same type assigned again, no need to destroy and construct
+            if(m_ops == &table<U>())
+                *ptr<U>() = std::forward<T>(value);
+            else {
+                reset();
+                emplace<U>(std::forward<T>(value));
+            }
+            return *this;
+        }
+
+        template<typename T, typename... Args>
+        void emplace(Args&&... args)
+        {
+            if constexpr(fits_inline<T>::value)
+                new (&m_storage) T(std::forward<Args>(args)...);
+            else
+                m_heap = new T(std::forward<Args>(args)...);
+            m_ops = &table<T>();
+        }
+
+        void reset()
+        {
+            if(m_ops) {
+                m_ops->destroy(*this);
+                m_ops = nullptr;
+            }
+        }
+
+        bool empty() const { return !m_ops; }
+        template<typename T> bool is() const { return m_ops == &table<T>(); }
+        const std::type_info& type() const { return m_ops ? m_ops->type() : typeid(void); }
+
+        // no checks besides the debug assert, callers test is<T>() first
+        template<typename T> const T& get() const { assert(is<T>()); return *ptr<T>(); }
+        template<typename T> T& get() { assert(is<T>()); return *ptr<T>(); }
+
+    private:
+        template<typename T> T* ptr() { return fits_inline<T>::value ? reinterpret_cast<T*>(&m_storage) : static_cast<T*>(m_heap); }
+        template<typename T> const T* ptr() const { return fits_inline<T>::value ? reinterpret_cast<const T*>(&m_storage) : static_cast<const T*>(m_heap); }
+
+        template<typename T>
+        static const ops& table()
+        {
+            static const ops instance = {
+                []() -> const std::type_info& { return typeid(T); },
+                [](const small_any& from, small_any& to) { to.emplace<T>(*from.ptr<T>()); },
+                [](small_any& from, small_any& to) {
+                    if constexpr(fits_inline<T>::value) {
+                        to.emplace<T>(std::move(*from.ptr<T>()));
+                        from.reset();
+                    } else {
+                        to.m_heap = from.m_heap;
+                        to.m_ops = from.m_ops;
+                        from.m_ops = nullptr;
+                    }
+                },
+                [](small_any& value) {
+                    if constexpr(fits_inline<T>::value)
+                        value.ptr<T>()->~T();
+                    else
+                        delete value.ptr<T>();
+                }
+            };
+            return instance;
+        }
+
+        union {
+            typename std::aligned_storage<CAPACITY, alignof(void*)>::type m_storage;
+            void* m_heap;
+        };
+        const ops* m_ops{ nullptr };
+    };
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef STDEXT_SPSC_QUEUE_H
+#define STDEXT_SPSC_QUEUE_H
+
+#include <atomic>
+#include <array>
+#include <utility>
+
+namespace stdext {
+    // lock free ring for exactly one producer thread and one consumer thread
+    template<typename T, std::size_t Capacity>
+    class spsc_queue {
+        static_assert((Capacity & (Capacity - 1)) == 0, "spsc_queue capacity must be a power of two");
+
+    public:
+        bool push(T&& value)
+        {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            if(tail - m_head.load(std::memory_order_acquire) == Capacity)
+                return false;
+
+            m_items[tail & (Capacity - 1)] = std::move(value);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T& value)
+        {
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            if(head == m_tail.load(std::memory_order_acquire))
+                return false;
+
+            value = std::move(m_items[head & (Capacity - 1)]);
+            m_items[head & (Capacity - 1)] = T();
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+    private:
+        std::array<T, Capacity> m_items;
+        // head and tail live on separate cache lines so both threads don't fight over one
+        alignas(64) std::atomic<std::size_t> m_head{ 0 };
+        alignas(64) std::atomic<std::size_t> m_tail{ 0 };
+    };
+}
+
+#endif
@@ -31,11 +31,13 @@
 #include "dumper.h"
 #include "dynamic_storage.h"
 #include "exception.h"
+#include "flat_hash_map.h"
 #include "format.h"
 #include "math.h"
 #include "packed_any.h"
 #include "packed_storage.h"
 #include "shared_object.h"
+#include "small_any.h"
 #include "string.h"
 #include "time.h"
 #include "types.h"
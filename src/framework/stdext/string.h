@@ -29,9 +29,18 @@
 
 #include "types.h"
 #include "cast.h"
+#include "format.h"
 
 namespace stdext {
-    template<typename T> std::string to_string(const T& t) { return unsafe_cast<std::string, T>(t); }
+    template<typename T> std::string to_string(const T& t)
+    {
+        // integers skip the stream, one byte ones keep printing as characters like they always did
+        if constexpr(std::is_integral<T>::value && !std::is_same<T, bool>::value && sizeof(T) > 1) {
+            char buffer[24];
+            return std::string(buffer, to_chars(buffer, t));
+        } else
+            return unsafe_cast<std::string, T>(t);
+    }
     template<typename T> T from_string(const std::string& str, T def = T()) { return unsafe_cast<T, std::string>(str, def); }
 
     /// Resolve a file path by combining sourcePath with filePath
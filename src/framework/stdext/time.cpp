@@ -26,6 +26,14 @@
 #include <ctime>
 #include <thread>
 
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
 namespace stdext {
     const static auto startup_time = std::chrono::high_resolution_clock::now();
 
@@ -52,4 +60,33 @@ namespace stdext {
     {
         std::this_thread::sleep_for(std::chrono::microseconds(us));
     };
+
+    void precisesleep(size_t us)
+    {
+        // the kernel wakes late by up to its timer granularity, the last stretch is spun instead
+        const ticks_t spinMicros = 1000;
+        const ticks_t deadline = micros() + us;
+
+#ifdef WIN32
+        // high resolution waitable timers exist since windows 10 1803, older systems get the regular ones
+        static thread_local HANDLE timer = [] {
+            HANDLE handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+            return handle ? handle : CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        }();
+
+        if(timer && (ticks_t)us > spinMicros) {
+            LARGE_INTEGER dueTime;
+            // negative values are relative, in 100ns units
+            dueTime.QuadPart = -(LONGLONG)(us - spinMicros) * 10;
+            if(SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE))
+                WaitForSingleObject(timer, INFINITE);
+        }
+#else
+        if((ticks_t)us > spinMicros)
+            std::this_thread::sleep_for(std::chrono::microseconds(us - spinMicros));
+#endif
+
+        while(micros() < deadline)
+            std::this_thread::yield();
+    }
 }
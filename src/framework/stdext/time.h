@@ -31,6 +31,8 @@ namespace stdext {
     ticks_t micros();
     void millisleep(size_t ms);
     void microsleep(size_t us);
+    // waits with a high resolution timer where available and spins the last millisecond, for frame pacing
+    void precisesleep(size_t us);
 
     struct timer {
     public:
@@ -37,9 +37,14 @@ class UIAnchor;
 class UIAnchorGroup;
 class UIAnchorLayout;
 class UIParticles;
+class UIStateStyle;
+class UIVirtualList;
+class UITextLog;
 
 using UIWidgetPtr = stdext::shared_object_ptr<UIWidget>;
 using UIParticlesPtr = stdext::shared_object_ptr<UIParticles>;
+using UIVirtualListPtr = stdext::shared_object_ptr<UIVirtualList>;
+using UITextLogPtr = stdext::shared_object_ptr<UITextLog>;
 using UITextEditPtr = stdext::shared_object_ptr<UITextEdit>;
 using UILayoutPtr = stdext::shared_object_ptr<UILayout>;
 using UIBoxLayoutPtr = stdext::shared_object_ptr<UIBoxLayout>;
@@ -49,6 +54,7 @@ using UIGridLayoutPtr = stdext::shared_object_ptr<UIGridLayout>;
 using UIAnchorPtr = stdext::shared_object_ptr<UIAnchor>;
 using UIAnchorGroupPtr = stdext::shared_object_ptr<UIAnchorGroup>;
 using UIAnchorLayoutPtr = stdext::shared_object_ptr<UIAnchorLayout>;
+using UIStateStylePtr = stdext::shared_object_ptr<UIStateStyle>;
 
 using UIWidgetList = std::deque<UIWidgetPtr>;
 using UIAnchorList = std::vector<UIAnchorPtr>;
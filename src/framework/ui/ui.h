@@ -32,5 +32,8 @@
 #include "uigridlayout.h"
 #include "uianchorlayout.h"
 #include "uiparticles.h"
+#include "uivirtuallist.h"
+#include "uitextlog.h"
+#include "uirendercache.h"
 
 #endif
@@ -22,6 +22,9 @@
 
 #include "uianchorlayout.h"
 #include "uiwidget.h"
+#include "uimanager.h"
+
+#include <framework/core/eventdispatcher.h>
 
 UIWidgetPtr UIAnchor::getHookedWidget(const UIWidgetPtr& widget, const UIWidgetPtr& parentWidget)
 {
@@ -119,6 +122,7 @@ void UIAnchorLayout::addAnchor(const UIWidgetPtr& anchoredWidget, Fw::AnchorEdge
         anchorGroup = UIAnchorGroupPtr(new UIAnchorGroup);
 
     anchorGroup->addAnchor(anchor);
+    m_orderDirty = true;
 
     // layout must be updated because a new anchor got in
     update();
@@ -127,6 +131,8 @@ void UIAnchorLayout::addAnchor(const UIWidgetPtr& anchoredWidget, Fw::AnchorEdge
 void UIAnchorLayout::removeAnchors(const UIWidgetPtr& anchoredWidget)
 {
     m_anchorsGroups.erase(anchoredWidget);
+    m_dirtyWidgets.erase(anchoredWidget);
+    m_orderDirty = true;
     update();
 }
 
@@ -151,6 +157,8 @@ void UIAnchorLayout::fill(const UIWidgetPtr& anchoredWidget, const std::string&
 
 void UIAnchorLayout::addWidget(const UIWidgetPtr&)
 {
+    // next and prev anchors of the siblings may point to the new widget now
+    m_orderDirty = true;
     update();
 }
 
@@ -251,25 +259,149 @@ bool UIAnchorLayout::updateWidget(const UIWidgetPtr& widget, const UIAnchorGroup
     return changed;
 }
 
+void UIAnchorLayout::onChildChange(const UIWidgetPtr& child)
+{
+    // rects set by the running pass are sorted out once it ends
+    if(m_updating) {
+        m_changedDuringPass.push_back(child);
+        return;
+    }
+
+    m_dirtyWidgets.insert(child);
+    scheduleIncrementalUpdate();
+}
+
+void UIAnchorLayout::scheduleIncrementalUpdate()
+{
+    if(m_updateDisabled || m_incrementalScheduled || !getParentWidget())
+        return;
+
+    auto self = static_self_cast<UIAnchorLayout>();
+    g_dispatcher.addEvent([self] {
+        self->m_incrementalScheduled = false;
+        self->m_incremental = true;
+        self->update();
+        self->m_incremental = false;
+    });
+    m_incrementalScheduled = true;
+}
+
+void UIAnchorLayout::buildOrder()
+{
+    const UIWidgetPtr parentWidget = getParentWidget();
+    m_order.clear();
+    m_order.reserve(m_anchorsGroups.size());
+
+    // depth first, a widget is added once everything it is hooked to was added,
+    // anchors closing a cycle are left for updateWidget to report
+    std::unordered_map<UIWidget*, bool> visited;
+    std::function<void(const UIWidgetPtr&, const UIAnchorGroupPtr&)> visit = [&](const UIWidgetPtr& widget, const UIAnchorGroupPtr& anchorGroup) {
+        if(!visited.emplace(widget.get(), true).second)
+            return;
+
+        OrderedWidget entry{ widget, anchorGroup, {} };
+        for(const UIAnchorPtr& anchor : anchorGroup->getAnchors()) {
+            UIWidgetPtr hookedWidget;
+            if(anchor->getHookedEdge() != Fw::AnchorNone)
+                hookedWidget = anchor->getHookedWidget(widget, parentWidget);
+            entry.hookedWidgets.push_back(hookedWidget.get());
+
+            if(!hookedWidget || hookedWidget == parentWidget)
+                continue;
+
+            auto it = m_anchorsGroups.find(hookedWidget);
+            if(it != m_anchorsGroups.end())
+                visit(it->first, it->second);
+        }
+        m_order.push_back(std::move(entry));
+    };
+
+    for(auto& it : m_anchorsGroups)
+        visit(it.first, it.second);
+
+    m_orderDirty = false;
+}
+
+bool UIAnchorLayout::isOrderValid()
+{
+    if(m_orderDirty || m_order.size() != m_anchorsGroups.size())
+        return false;
+
+    const UIWidgetPtr parentWidget = getParentWidget();
+    for(const OrderedWidget& entry : m_order) {
+        const UIAnchorList& anchors = entry.anchorGroup->getAnchors();
+        if(anchors.size() != entry.hookedWidgets.size())
+            return false;
+
+        for(uint i = 0; i < anchors.size(); ++i) {
+            UIWidgetPtr hookedWidget;
+            if(anchors[i]->getHookedEdge() != Fw::AnchorNone)
+                hookedWidget = anchors[i]->getHookedWidget(entry.widget, parentWidget);
+            if(hookedWidget.get() != entry.hookedWidgets[i])
+                return false;
+        }
+    }
+    return true;
+}
+
 bool UIAnchorLayout::internalUpdate()
 {
-    bool changed = false;
+    // a changed hook means the dependencies changed, everything is solved again
+    bool incremental = m_incremental;
+    if(!isOrderValid()) {
+        buildOrder();
+        incremental = false;
+    }
 
-    // reset all anchors groups update state
-    for(auto& it : m_anchorsGroups) {
-        const UIAnchorGroupPtr& anchorGroup = it.second;
-        anchorGroup->setUpdated(false);
+    // an incremental pass only revisits widgets changed outside of the layout and what hangs on them
+    std::unordered_set<UIWidget*> changedWidgets;
+    if(incremental) {
+        for(const UIWidgetPtr& widget : m_dirtyWidgets)
+            changedWidgets.insert(widget.get());
     }
+    m_dirtyWidgets.clear();
+    m_passRects.clear();
 
-    // update all anchors
-    for(auto& it : m_anchorsGroups) {
-        const UIWidgetPtr& widget = it.first;
-        const UIAnchorGroupPtr& anchorGroup = it.second;
-        if(!anchorGroup->isUpdated()) {
-            if(updateWidget(widget, anchorGroup))
+    // widgets come after their hooks, updateWidget only recurses when anchors form a cycle
+    for(const OrderedWidget& entry : m_order)
+        entry.anchorGroup->setUpdated(incremental);
+
+    bool changed = false;
+    int updated = 0;
+    int skipped = 0;
+    for(const OrderedWidget& entry : m_order) {
+        bool needsUpdate = !incremental || changedWidgets.count(entry.widget.get());
+        for(uint i = 0; !needsUpdate && i < entry.hookedWidgets.size(); ++i)
+            needsUpdate = entry.hookedWidgets[i] && changedWidgets.count(entry.hookedWidgets[i]);
+
+        if(!needsUpdate) {
+            skipped++;
+            continue;
+        }
+
+        if(!entry.anchorGroup->isUpdated() || incremental) {
+            if(updateWidget(entry.widget, entry.anchorGroup)) {
                 changed = true;
+                changedWidgets.insert(entry.widget.get());
+            }
         }
+        m_passRects[entry.widget.get()] = entry.widget->getRect();
+        updated++;
     }
 
+    g_ui.countLayoutWidgets(updated, skipped);
+
+    // something else moved a widget while the pass ran, its dependents need another look
+    for(const UIWidgetPtr& widget : m_changedDuringPass) {
+        auto it = m_passRects.find(widget.get());
+        if(it == m_passRects.end() || it->second != widget->getRect())
+            m_dirtyWidgets.insert(widget);
+    }
+    m_changedDuringPass.clear();
+    m_passRects.clear();
+
+    if(!m_dirtyWidgets.empty())
+        scheduleIncrementalUpdate();
+
     return changed;
 }
@@ -24,6 +24,7 @@
 #define UIANCHORLAYOUT_H
 
 #include <utility>
+#include <unordered_set>
 
 #include "uilayout.h"
 
@@ -77,6 +78,7 @@ public:
 
     void addWidget(const UIWidgetPtr& widget) override;
     void removeWidget(const UIWidgetPtr& widget) override;
+    void onChildChange(const UIWidgetPtr& child) override;
 
     bool isUIAnchorLayout() override { return true; }
 
@@ -84,6 +86,28 @@ protected:
     bool internalUpdate() override;
     virtual bool updateWidget(const UIWidgetPtr& widget, const UIAnchorGroupPtr& anchorGroup, UIWidgetPtr first = nullptr);
     std::unordered_map<UIWidgetPtr, UIAnchorGroupPtr> m_anchorsGroups;
+    bool m_orderDirty{ true };
+
+private:
+    struct OrderedWidget
+    {
+        UIWidgetPtr widget;
+        UIAnchorGroupPtr anchorGroup;
+        std::vector<UIWidget*> hookedWidgets; // one per anchor, as resolved when the order was built
+    };
+
+    /// Sorts the anchored widgets so every widget comes after the ones it is hooked to
+    void buildOrder();
+    /// Checks that ids, next and prev still resolve to the widgets the order was built with
+    bool isOrderValid();
+    void scheduleIncrementalUpdate();
+
+    std::vector<OrderedWidget> m_order;
+    std::unordered_set<UIWidgetPtr> m_dirtyWidgets;
+    std::vector<UIWidgetPtr> m_changedDuringPass;
+    std::unordered_map<UIWidget*, Rect> m_passRects;
+    bool m_incremental{ false };
+    bool m_incrementalScheduled{ false };
 };
 
 #endif
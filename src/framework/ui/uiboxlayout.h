@@ -32,8 +32,8 @@ public:
     UIBoxLayout(UIWidgetPtr parentWidget);
 
     void applyStyle(const OTMLNodePtr& styleNode) override;
-    void addWidget(const UIWidgetPtr& /*widget*/) override { update(); }
-    void removeWidget(const UIWidgetPtr& /*widget*/) override { update(); }
+    void addWidget(const UIWidgetPtr& /*widget*/) override { updateLater(); }
+    void removeWidget(const UIWidgetPtr& /*widget*/) override { updateLater(); }
 
     void setSpacing(int spacing) { m_spacing = spacing; update(); }
     void setFitChildren(bool fitParent) { m_fitChildren = fitParent; update(); }
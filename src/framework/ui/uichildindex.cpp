@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "uichildindex.h"
+#include "uiwidget.h"
+
+namespace {
+
+const int MAX_GRID_SIDE = 32;
+
+// same edges Rect::contains tests against, so inverted rects are indexed the way they are hit
+void getHitEdges(const Rect& rect, int& left, int& top, int& right, int& bottom)
+{
+    left = rect.right() < rect.left() - 1 ? rect.right() : rect.left();
+    right = rect.right() < rect.left() - 1 ? rect.left() : rect.right();
+    top = rect.bottom() < rect.top() - 1 ? rect.bottom() : rect.top();
+    bottom = rect.bottom() < rect.top() - 1 ? rect.top() : rect.bottom();
+}
+
+}
+
+void UIChildIndex::build(const UIWidgetList& children)
+{
+    m_cells.clear();
+    m_bounds = Rect();
+
+    int boundsLeft = 0, boundsTop = 0, boundsRight = -1, boundsBottom = -1;
+    for(const UIWidgetPtr& child : children) {
+        int left, top, right, bottom;
+        getHitEdges(child->getRect(), left, top, right, bottom);
+        if(right < left || bottom < top)
+            continue;
+
+        if(boundsRight < boundsLeft) {
+            boundsLeft = left;
+            boundsTop = top;
+            boundsRight = right;
+            boundsBottom = bottom;
+        } else {
+            boundsLeft = std::min<int>(boundsLeft, left);
+            boundsTop = std::min<int>(boundsTop, top);
+            boundsRight = std::max<int>(boundsRight, right);
+            boundsBottom = std::max<int>(boundsBottom, bottom);
+        }
+    }
+
+    if(boundsRight < boundsLeft)
+        return;
+
+    m_bounds = Rect(Point(boundsLeft, boundsTop), Point(boundsRight, boundsBottom));
+
+    const int side = stdext::clamp<int>(std::ceil(std::sqrt(static_cast<float>(children.size()))), 1, MAX_GRID_SIDE);
+    m_columns = std::min<int>(side, m_bounds.width());
+    m_rows = std::min<int>(side, m_bounds.height());
+    m_cellWidth = (m_bounds.width() + m_columns - 1) / m_columns;
+    m_cellHeight = (m_bounds.height() + m_rows - 1) / m_rows;
+    m_cells.resize(m_columns * m_rows);
+
+    for(uint i = 0; i < children.size(); ++i) {
+        int left, top, right, bottom;
+        getHitEdges(children[i]->getRect(), left, top, right, bottom);
+        if(right < left || bottom < top)
+            continue;
+
+        const int firstColumn = (left - boundsLeft) / m_cellWidth;
+        const int lastColumn = (right - boundsLeft) / m_cellWidth;
+        const int firstRow = (top - boundsTop) / m_cellHeight;
+        const int lastRow = (bottom - boundsTop) / m_cellHeight;
+        for(int row = firstRow; row <= lastRow; ++row) {
+            for(int column = firstColumn; column <= lastColumn; ++column)
+                m_cells[row * m_columns + column].push_back(i);
+        }
+    }
+}
+
+const std::vector<uint>& UIChildIndex::query(const Point& point) const
+{
+    static const std::vector<uint> emptyCell;
+    if(m_cells.empty() || !m_bounds.contains(point))
+        return emptyCell;
+
+    const int column = (point.x - m_bounds.left()) / m_cellWidth;
+    const int row = (point.y - m_bounds.top()) / m_cellHeight;
+    return m_cells[row * m_columns + column];
+}
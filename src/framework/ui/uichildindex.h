@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UICHILDINDEX_H
+#define UICHILDINDEX_H
+
+#include "declarations.h"
+
+/// Uniform grid over the rects of a widget's children, used to find the children
+/// under a point without testing all of them. Cells keep child indexes in drawing order.
+class UIChildIndex
+{
+public:
+    enum {
+        MIN_CHILDREN = 16
+    };
+
+    void build(const UIWidgetList& children);
+
+    /// Indexes of the children whose rect may contain the point, lowest first
+    const std::vector<uint>& query(const Point& point) const;
+
+private:
+    Rect m_bounds;
+    int m_columns{ 0 };
+    int m_rows{ 0 };
+    int m_cellWidth{ 1 };
+    int m_cellHeight{ 1 };
+    std::vector<std::vector<uint>> m_cells;
+};
+
+#endif
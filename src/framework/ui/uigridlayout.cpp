@@ -63,12 +63,12 @@ void UIGridLayout::applyStyle(const OTMLNodePtr& styleNode)
 
 void UIGridLayout::removeWidget(const UIWidgetPtr&)
 {
-    update();
+    updateLater();
 }
 
 void UIGridLayout::addWidget(const UIWidgetPtr&)
 {
-    update();
+    updateLater();
 }
 
 bool UIGridLayout::internalUpdate()
@@ -22,8 +22,7 @@
 
 #include "uilayout.h"
 #include "uiwidget.h"
-
-#include <framework/core/eventdispatcher.h>
+#include "uimanager.h"
 
 void UILayout::update()
 {
@@ -49,7 +48,10 @@ void UILayout::update()
         return;
     }
 
+    // a synchronous update also covers the one requested for later
+    m_updateScheduled = false;
     m_updating = true;
+    g_ui.countLayoutPass();
     internalUpdate();
     m_parentWidget->onLayoutUpdate();
     m_updating = false;
@@ -63,10 +65,15 @@ void UILayout::updateLater()
     if(!getParentWidget())
         return;
 
-    auto self = static_self_cast<UILayout>();
-    g_dispatcher.addEvent([self] {
-        self->m_updateScheduled = false;
-        self->update();
-    });
+    g_ui.scheduleLayoutUpdate(static_self_cast<UILayout>());
     m_updateScheduled = true;
 }
+
+void UILayout::updatePending()
+{
+    if(!m_updateScheduled)
+        return;
+
+    m_updateScheduled = false;
+    update();
+}
@@ -36,11 +36,16 @@ public:
     UILayout(UIWidgetPtr parentWidget) : m_parentWidget(std::move(parentWidget)) { m_updateDisabled = 0; }
 
     void update();
+    /// Batches the update with the others requested before the next frame is drawn
     void updateLater();
+    // @dontbind
+    void updatePending();
 
     virtual void applyStyle(const OTMLNodePtr& /*styleNode*/) {}
     virtual void addWidget(const UIWidgetPtr& /*widget*/) {}
     virtual void removeWidget(const UIWidgetPtr& /*widget*/) {}
+    /// Called when a child's own layout got updated, which may have changed its geometry
+    virtual void onChildChange(const UIWidgetPtr& /*child*/) { updateLater(); }
     void disableUpdates() { m_updateDisabled++; }
     void enableUpdates() { m_updateDisabled = std::max<int>(m_updateDisabled - 1, 0); }
 
@@ -22,16 +22,29 @@
 
 #include "uimanager.h"
 #include "ui.h"
+#include "uistatestyle.h"
 
 #include <framework/otml/otml.h>
+#include <framework/otml/otmlbinary.h>
 #include <framework/graphics/graphics.h>
 #include <framework/platform/platformwindow.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/application.h>
 #include <framework/core/resourcemanager.h>
+#include <framework/core/filestream.h>
+#include <framework/core/frameprofiler.h>
 
 UIManager g_ui;
 
+static const char* STYLE_CACHE_DIR = "/otuicache";
+
+static std::string getStyleCachePath(const std::string& file)
+{
+    // collisions are harmless since the compiled data also stores the full path
+    const uint64 hash = stdext::fnv1a64((const uint8*)file.data(), file.size());
+    return stdext::format("%s/%016llx.otmb", STYLE_CACHE_DIR, (unsigned long long)hash);
+}
+
 void UIManager::init()
 {
     // creates root widget
@@ -45,6 +58,10 @@ void UIManager::terminate()
 {
     // destroy root widget and its children
     m_rootWidget->destroy();
+    for(auto& it : m_widgetPools)
+        clearWidgetPool(it.second);
+    m_widgetPools.clear();
+    m_pendingLayouts.clear();
     m_mouseReceiver = nullptr;
     m_keyboardReceiver = nullptr;
     m_rootWidget = nullptr;
@@ -52,13 +69,20 @@ void UIManager::terminate()
     m_hoveredWidget = nullptr;
     m_pressedWidget = nullptr;
     m_styles.clear();
+    m_compiledStyles.clear();
+    m_stateStyles.clear();
+    m_emptyStateStyle = nullptr;
     m_destroyedWidgets.clear();
     m_checkEvent = nullptr;
 }
 
-void UIManager::render(Fw::DrawPane drawPane)
+void UIManager::render(Fw::DrawPane drawPane, const Rect& dirtyRect)
 {
-    m_rootWidget->draw(m_rootWidget->getRect(), drawPane);
+    PROFILE_SCOPE("ui.render");
+
+    // children outside the visible rect are skipped, so only the dirty widgets are walked
+    const Rect& rootRect = m_rootWidget->getRect();
+    m_rootWidget->draw(dirtyRect.isValid() ? rootRect.intersection(dirtyRect) : rootRect, drawPane);
 }
 
 void UIManager::resize(const Size&)
@@ -268,6 +292,33 @@ void UIManager::onWidgetDisappear(const UIWidgetPtr& widget)
         updateHoveredWidget();
 }
 
+void UIManager::onWidgetRecycle(const UIWidgetPtr& widget)
+{
+    // the pooled widget keeps its style children, so grabs held by them are released as well
+    const auto isPooled = [&widget](UIWidgetPtr other) {
+        for(; other; other = other->getParent()) {
+            if(other == widget)
+                return true;
+        }
+        return false;
+    };
+
+    if(isPooled(m_keyboardReceiver))
+        resetKeyboardReceiver();
+
+    if(isPooled(m_mouseReceiver))
+        resetMouseReceiver();
+
+    if(isPooled(m_hoveredWidget))
+        updateHoveredWidget();
+
+    if(isPooled(m_pressedWidget))
+        updatePressedWidget(nullptr);
+
+    if(isPooled(m_draggingWidget))
+        updateDraggingWidget(nullptr);
+}
+
 void UIManager::onWidgetDestroy(const UIWidgetPtr& widget)
 {
     // release input grabs
@@ -313,6 +364,11 @@ void UIManager::onWidgetDestroy(const UIWidgetPtr& widget)
 void UIManager::clearStyles()
 {
     m_styles.clear();
+    m_stateStyles.clear();
+    for(auto& it : m_widgetPools) {
+        clearWidgetPool(it.second);
+        it.second.style = nullptr;
+    }
 }
 
 bool UIManager::importStyle(std::string file)
@@ -320,7 +376,7 @@ bool UIManager::importStyle(std::string file)
     try {
         file = g_resources.guessFilePath(file, "otui");
 
-        OTMLDocumentPtr doc = OTMLDocument::parse(file);
+        OTMLDocumentPtr doc = loadStyleDocument(file);
 
         for(const OTMLNodePtr& styleNode : doc->children())
             importStyleFromOTML(styleNode);
@@ -392,6 +448,54 @@ OTMLNodePtr UIManager::getStyle(const std::string& styleName)
     return nullptr;
 }
 
+void UIManager::updatePendingLayouts()
+{
+    PROFILE_SCOPE("ui.layouts");
+
+    // updates schedule the layouts of their parents, a few rounds settle them within the same frame,
+    // what is still left after that waits for the next one
+    static constexpr int MAX_ROUNDS = 8;
+    std::vector<UILayoutPtr> layouts;
+    for(int round = 0; round < MAX_ROUNDS && !m_pendingLayouts.empty(); ++round) {
+        layouts.swap(m_pendingLayouts);
+        for(const UILayoutPtr& layout : layouts)
+            layout->updatePending();
+        layouts.clear();
+    }
+}
+
+void UIManager::nextFrame()
+{
+    m_totalLayoutPasses += m_layoutStatistics.passes;
+    m_lastFrameLayoutStatistics = m_layoutStatistics;
+    m_layoutStatistics = LayoutStatistics();
+}
+
+std::map<std::string, uint64> UIManager::getLayoutStatistics()
+{
+    return {
+        { "passes", m_lastFrameLayoutStatistics.passes },
+        { "updatedWidgets", m_lastFrameLayoutStatistics.updatedWidgets },
+        { "skippedWidgets", m_lastFrameLayoutStatistics.skippedWidgets },
+        { "totalPasses", m_totalLayoutPasses }
+    };
+}
+
+UIStateStylePtr UIManager::getStateStyle(const OTMLNodePtr& style)
+{
+    const std::string signature = UIStateStyle::signature(style);
+    if(signature.empty()) {
+        if(!m_emptyStateStyle)
+            m_emptyStateStyle = UIStateStylePtr(new UIStateStyle(style));
+        return m_emptyStateStyle;
+    }
+
+    UIStateStylePtr& stateStyle = m_stateStyles[signature];
+    if(!stateStyle)
+        stateStyle = UIStateStylePtr(new UIStateStyle(style));
+    return stateStyle;
+}
+
 std::string UIManager::getStyleClass(const std::string& styleName)
 {
     OTMLNodePtr style = getStyle(styleName);
@@ -405,7 +509,7 @@ UIWidgetPtr UIManager::loadUI(std::string file, const UIWidgetPtr& parent)
     try {
         file = g_resources.guessFilePath(file, "otui");
 
-        OTMLDocumentPtr doc = OTMLDocument::parse(file);
+        OTMLDocumentPtr doc = loadStyleDocument(file);
         UIWidgetPtr widget;
         for(const OTMLNodePtr& node : doc->children()) {
             std::string tag = node->tag();
@@ -427,17 +531,287 @@ UIWidgetPtr UIManager::loadUI(std::string file, const UIWidgetPtr& parent)
     }
 }
 
+OTMLDocumentPtr UIManager::loadStyleDocument(const std::string& file)
+{
+    const std::string path = g_resources.resolvePath(file);
+    ticks_t modTime = 0;
+    uint64 size = 0;
+    if(!g_resources.getFileStat(path, modTime, size))
+        return OTMLDocument::parse(path);
+
+    // reopened windows are rebuilt from the compiled copy of their last load
+    auto it = m_compiledStyles.find(path);
+    if(it != m_compiledStyles.end()) {
+        const FileStreamPtr& data = it->second;
+        if(OTMLBinary::isValid(data->cachedData(), data->cachedSize(), path, modTime, size))
+            return OTMLBinary::load(data->cachedData(), data->cachedSize());
+        m_compiledStyles.erase(it);
+    }
+
+    // prefetched at startup, waits when the pool is still compiling it
+    const auto pending = m_pendingStyles.find(path);
+    if(pending != m_pendingStyles.end()) {
+        const AsyncTask<std::string> task = pending->second;
+        m_pendingStyles.erase(pending);
+        try {
+            const std::string& data = task.get();
+            if(OTMLBinary::isValid((const uint8*)data.data(), data.size(), path, modTime, size)) {
+                storeCompiledStyle(path, data);
+                return OTMLBinary::load((const uint8*)data.data(), data.size());
+            }
+        } catch(stdext::exception&) {
+            // parsed again below, so the error is reported from the importing module
+        }
+    }
+
+    const bool hasWriteDir = !g_resources.getWriteDir().empty();
+    const std::string cachePath = getStyleCachePath(path);
+    if(hasWriteDir && g_resources.fileExists(cachePath)) {
+        try {
+            // large files stay mapped, their pages are shared with other running clients
+            FileStreamPtr fin = g_resources.openFile(cachePath);
+            fin->cache();
+            if(OTMLBinary::isValid(fin->cachedData(), fin->cachedSize(), path, modTime, size)) {
+                OTMLDocumentPtr doc = OTMLBinary::load(fin->cachedData(), fin->cachedSize());
+                m_compiledStyles[path] = fin;
+                return doc;
+            }
+        } catch(stdext::exception& e) {
+            g_logger.warning(stdext::format("Discarding compiled style '%s': %s", cachePath, e.what()));
+        }
+    }
+
+    OTMLDocumentPtr doc = OTMLDocument::parse(path);
+    storeCompiledStyle(path, OTMLBinary::compile(doc, path, modTime, size));
+    return doc;
+}
+
+void UIManager::storeCompiledStyle(const std::string& path, const std::string& data)
+{
+    m_compiledStyles[path] = FileStreamPtr(new FileStream(path, data));
+
+    if(g_resources.getWriteDir().empty() || m_compiledStylesReadOnly)
+        return;
+
+    if(!g_resources.directoryExists(STYLE_CACHE_DIR))
+        g_resources.makeDir(STYLE_CACHE_DIR);
+    if(!g_resources.writeFileContents(getStyleCachePath(path), data)) {
+        g_logger.warning("Unable to write compiled styles, they will only be kept in memory");
+        m_compiledStylesReadOnly = true;
+    }
+}
+
+int UIManager::precompileStyles(const std::string& directory)
+{
+    // start over so files of removed styles go away too
+    if(directory == "/")
+        clearCompiledStyles();
+
+    int count = 0;
+    for(const std::string& fileName : g_resources.listDirectoryFiles(directory)) {
+        std::string fullPath = directory + "/" + fileName;
+        stdext::replace_all(fullPath, "//", "/");
+
+        if(fullPath == STYLE_CACHE_DIR)
+            continue;
+
+        if(g_resources.directoryExists(fullPath)) {
+            count += precompileStyles(fullPath);
+            continue;
+        }
+
+        if(!g_resources.isFileType(fileName, "otui"))
+            continue;
+
+        try {
+            loadStyleDocument(fullPath);
+            count++;
+        } catch(stdext::exception& e) {
+            g_logger.warning(stdext::format("Unable to compile styles '%s': %s", fullPath, e.what()));
+        }
+    }
+    return count;
+}
+
+int UIManager::prefetchStyles(const std::string& directory)
+{
+    int count = 0;
+    for(const std::string& fileName : g_resources.listDirectoryFiles(directory)) {
+        std::string fullPath = directory + "/" + fileName;
+        stdext::replace_all(fullPath, "//", "/");
+
+        if(fullPath == STYLE_CACHE_DIR)
+            continue;
+
+        if(g_resources.directoryExists(fullPath)) {
+            count += prefetchStyles(fullPath);
+            continue;
+        }
+
+        if(!g_resources.isFileType(fileName, "otui"))
+            continue;
+
+        if(m_compiledStyles.find(fullPath) != m_compiledStyles.end() || m_pendingStyles.find(fullPath) != m_pendingStyles.end())
+            continue;
+
+        // files compiled by an earlier run are only read back, there is nothing to parse
+        if(!g_resources.getWriteDir().empty() && g_resources.fileExists(getStyleCachePath(fullPath)))
+            continue;
+
+        ticks_t modTime = 0;
+        uint64 size = 0;
+        if(!g_resources.getFileStat(fullPath, modTime, size))
+            continue;
+
+        m_pendingStyles[fullPath] = g_asyncDispatcher.schedule([fullPath, modTime, size] {
+            std::istringstream in(g_resources.readFileContents(fullPath));
+            return OTMLBinary::compile(OTMLDocument::parse(in, fullPath), fullPath, modTime, size);
+        }, AsyncDispatcher::PriorityHigh);
+        count++;
+    }
+    return count;
+}
+
+void UIManager::clearCompiledStyles()
+{
+    m_compiledStyles.clear();
+    m_pendingStyles.clear();
+    if(g_resources.getWriteDir().empty() || !g_resources.directoryExists(STYLE_CACHE_DIR))
+        return;
+
+    for(const std::string& fileName : g_resources.listDirectoryFiles(STYLE_CACHE_DIR))
+        g_resources.deleteFile(std::string(STYLE_CACHE_DIR) + "/" + fileName);
+}
+
 UIWidgetPtr UIManager::createWidget(const std::string& styleName, const UIWidgetPtr& parent)
 {
+    if(UIWidgetPtr widget = takeRecycledWidget(styleName, parent))
+        return widget;
+
     const OTMLNodePtr node = OTMLNode::create(styleName);
     try {
-        return createWidgetFromOTML(node, parent);
+        UIWidgetPtr widget = createWidgetFromOTML(node, parent);
+        if(m_widgetPools.find(styleName) != m_widgetPools.end()) {
+            widget->m_recycleStyle = styleName;
+            widget->m_recycleChildren = widget->m_children;
+            widget->m_recycleFields = widget->saveLuaFields();
+        }
+        return widget;
     } catch(stdext::exception& e) {
         g_logger.error(stdext::format("failed to create widget from style '%s': %s", styleName, e.what()));
         return nullptr;
     }
 }
 
+void UIManager::setWidgetRecycling(const std::string& styleName, int capacity)
+{
+    auto it = m_widgetPools.find(styleName);
+    if(capacity <= 0) {
+        if(it != m_widgetPools.end()) {
+            clearWidgetPool(it->second);
+            m_widgetPools.erase(it);
+        }
+        return;
+    }
+
+    if(it == m_widgetPools.end())
+        it = m_widgetPools.emplace(styleName, WidgetPool()).first;
+
+    WidgetPool& pool = it->second;
+    pool.capacity = capacity;
+    if(!pool.style)
+        pool.style = getStyle(styleName);
+    while(pool.widgets.size() > pool.capacity) {
+        const UIWidgetPtr widget = pool.widgets.back();
+        pool.widgets.pop_back();
+        widget->releaseLuaFieldsTable(); // onDestroy was already called when it was pooled
+        widget->internalDestroy();
+    }
+}
+
+std::map<std::string, uint64> UIManager::getWidgetPoolStatistics()
+{
+    uint64 pooled = 0;
+    for(const auto& it : m_widgetPools)
+        pooled += it.second.widgets.size();
+
+    return {
+        { "hits", m_widgetPoolStatistics.hits },
+        { "misses", m_widgetPoolStatistics.misses },
+        { "recycled", m_widgetPoolStatistics.recycled },
+        { "rejected", m_widgetPoolStatistics.rejected },
+        { "pooled", pooled }
+    };
+}
+
+bool UIManager::recycleWidget(const UIWidgetPtr& widget)
+{
+    const auto it = m_widgetPools.find(widget->m_recycleStyle);
+    if(it == m_widgetPools.end())
+        return false;
+
+    WidgetPool& pool = it->second;
+    bool reusable = pool.widgets.size() < pool.capacity && pool.style && pool.style == getStyle(it->first);
+
+    // a widget that lost one of the children built from its style can't be handed out again
+    for(const UIWidgetPtr& child : widget->m_recycleChildren) {
+        if(!reusable)
+            break;
+        reusable = !child->isDestroyed() && child->getParent() == widget;
+    }
+
+    if(!reusable) {
+        m_widgetPoolStatistics.rejected++;
+        return false;
+    }
+
+    widget->internalRecycle();
+    pool.widgets.push_back(widget);
+    m_widgetPoolStatistics.recycled++;
+    return true;
+}
+
+UIWidgetPtr UIManager::takeRecycledWidget(const std::string& styleName, const UIWidgetPtr& parent)
+{
+    const auto it = m_widgetPools.find(styleName);
+    if(it == m_widgetPools.end())
+        return nullptr;
+
+    WidgetPool& pool = it->second;
+    const OTMLNodePtr style = getStyle(styleName);
+    if(pool.style != style) {
+        // the style was imported again, widgets built from the old one can't be reused
+        clearWidgetPool(pool);
+        pool.style = style;
+    }
+
+    if(pool.widgets.empty()) {
+        m_widgetPoolStatistics.misses++;
+        return nullptr;
+    }
+
+    // the style is unchanged, so it is not applied again
+    const UIWidgetPtr widget = pool.widgets.back();
+    pool.widgets.pop_back();
+    widget->m_destroyed = false;
+    if(parent)
+        parent->addChild(widget);
+    else
+        widget->updateStates();
+
+    m_widgetPoolStatistics.hits++;
+    return widget;
+}
+
+void UIManager::clearWidgetPool(WidgetPool& pool)
+{
+    for(const UIWidgetPtr& widget : pool.widgets) {
+        widget->releaseLuaFieldsTable(); // onDestroy was already called when it was pooled
+        widget->internalDestroy();
+    }
+    pool.widgets.clear();
+}
+
 UIWidgetPtr UIManager::createWidgetFromOTML(const OTMLNodePtr& widgetNode, const UIWidgetPtr& parent)
 {
     OTMLNodePtr originalStyleNode = getStyle(widgetNode->tag());
@@ -26,16 +26,24 @@
 #include "declarations.h"
 #include "uiwidget.h"
 #include <framework/core/inputevent.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/otml/declarations.h>
 
  //@bindsingleton g_ui
 class UIManager
 {
 public:
+    // layout work done during one frame
+    struct LayoutStatistics {
+        uint64 passes = 0;
+        uint64 updatedWidgets = 0;
+        uint64 skippedWidgets = 0;
+    };
+
     void init();
     void terminate();
 
-    void render(Fw::DrawPane drawPane);
+    void render(Fw::DrawPane drawPane, const Rect& dirtyRect = Rect());
     void resize(const Size& size);
     void inputEvent(const InputEvent& event);
 
@@ -48,12 +56,26 @@ public:
     void importStyleFromOTML(const OTMLNodePtr& styleNode);
     OTMLNodePtr getStyle(const std::string& styleName);
     std::string getStyleClass(const std::string& styleName);
+    // @dontbind
+    UIStateStylePtr getStateStyle(const OTMLNodePtr& style);
 
     UIWidgetPtr loadUI(std::string file, const UIWidgetPtr& parent);
     UIWidgetPtr displayUI(const std::string& file) { return loadUI(file, m_rootWidget); }
     UIWidgetPtr createWidget(const std::string& styleName, const UIWidgetPtr& parent);
     UIWidgetPtr createWidgetFromOTML(const OTMLNodePtr& widgetNode, const UIWidgetPtr& parent);
 
+    /// Keeps up to capacity destroyed widgets of styleName for the next createWidget of that style, 0 disables it.
+    /// A reused widget keeps the children built from its style and the lua fields it had once created,
+    /// anything else its previous owner changed stays, so the owner must set it up again
+    void setWidgetRecycling(const std::string& styleName, int capacity);
+    std::map<std::string, uint64> getWidgetPoolStatistics();
+
+    /// Compiles every otui file under directory into the write dir, returns the number of compiled files
+    int precompileStyles(const std::string& directory);
+    /// Compiles the otui files under directory on the thread pool, later imports pick up the result, returns the number of scheduled files
+    int prefetchStyles(const std::string& directory);
+    void clearCompiledStyles();
+
     void setMouseReceiver(const UIWidgetPtr& widget) { m_mouseReceiver = widget; }
     void setKeyboardReceiver(const UIWidgetPtr& widget) { m_keyboardReceiver = widget; }
     void setDebugBoxesDrawing(bool enabled) { m_drawDebugBoxes = enabled; }
@@ -70,14 +92,48 @@ public:
 
     bool isDrawingDebugBoxes() { return m_drawDebugBoxes; }
 
+    // @dontbind
+    void countLayoutPass() { m_layoutStatistics.passes++; }
+    // @dontbind
+    void countLayoutWidgets(int updated, int skipped) { m_layoutStatistics.updatedWidgets += updated; m_layoutStatistics.skippedWidgets += skipped; }
+    // @dontbind
+    void scheduleLayoutUpdate(const UILayoutPtr& layout) { m_pendingLayouts.push_back(layout); }
+    /// Runs the layout updates requested with updateLater, once per layout, before the frame is drawn
+    void updatePendingLayouts();
+    /// Closes the statistics of the current frame
+    void nextFrame();
+    std::map<std::string, uint64> getLayoutStatistics();
+
 protected:
     void onWidgetAppear(const UIWidgetPtr& widget);
     void onWidgetDisappear(const UIWidgetPtr& widget);
     void onWidgetDestroy(const UIWidgetPtr& widget);
+    void onWidgetRecycle(const UIWidgetPtr& widget);
+    bool recycleWidget(const UIWidgetPtr& widget);
 
     friend class UIWidget;
 
 private:
+    struct WidgetPool {
+        OTMLNodePtr style;
+        size_t capacity = 0;
+        UIWidgetList widgets;
+    };
+
+    struct WidgetPoolStatistics {
+        uint64 hits = 0;
+        uint64 misses = 0;
+        uint64 recycled = 0;
+        uint64 rejected = 0;
+    };
+
+    UIWidgetPtr takeRecycledWidget(const std::string& styleName, const UIWidgetPtr& parent);
+    void clearWidgetPool(WidgetPool& pool);
+
+    /// Parses an otui file through the compiled copies kept in memory and in the write dir
+    OTMLDocumentPtr loadStyleDocument(const std::string& file);
+    void storeCompiledStyle(const std::string& path, const std::string& data);
+
     UIWidgetPtr m_rootWidget;
     UIWidgetPtr m_mouseReceiver;
     UIWidgetPtr m_keyboardReceiver;
@@ -87,6 +143,17 @@ private:
     bool m_hoverUpdateScheduled{ false },
         m_drawDebugBoxes{ false };
     std::unordered_map<std::string, OTMLNodePtr> m_styles;
+    std::unordered_map<std::string, FileStreamPtr> m_compiledStyles;
+    std::unordered_map<std::string, AsyncTask<std::string>> m_pendingStyles;
+    std::unordered_map<std::string, UIStateStylePtr> m_stateStyles;
+    UIStateStylePtr m_emptyStateStyle;
+    bool m_compiledStylesReadOnly{ false };
+    std::vector<UILayoutPtr> m_pendingLayouts;
+    LayoutStatistics m_layoutStatistics;
+    LayoutStatistics m_lastFrameLayoutStatistics;
+    uint64 m_totalLayoutPasses{ 0 };
+    std::unordered_map<std::string, WidgetPool> m_widgetPools;
+    WidgetPoolStatistics m_widgetPoolStatistics;
     UIWidgetList m_destroyedWidgets;
     ScheduledEventPtr m_checkEvent;
 };
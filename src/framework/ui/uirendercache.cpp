@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "uirendercache.h"
+#include "uiwidget.h"
+
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/graphics/drawpool.h>
+#include <framework/graphics/graphics.h>
+
+UIRenderCache g_uiRenderCache;
+
+// cells come in a few sizes, each row of the page holds cells of one size,
+// the small ones fit items and creatures, the large ones whole windows
+static const std::array<Size, 6> CELL_SIZES = { Size(48, 48), Size(96, 96), Size(256, 256), Size(256, 512), Size(512, 512), Size(512, 1024) };
+
+void UIRenderCache::init()
+{
+    m_pool = g_drawPool.createPoolF(PoolType::UI_CACHE);
+    m_pool->setOffscreen(true);
+    m_pool->setSmooth(false);
+    m_freeCells.resize(CELL_SIZES.size());
+}
+
+void UIRenderCache::terminate()
+{
+    m_pending.clear();
+    m_cells.clear();
+    m_freeCells.clear();
+    m_nextRowY = 0;
+    m_pool = nullptr;
+}
+
+bool UIRenderCache::draw(Rendition& rendition, const Rect& dest, size_t key, const Recorder& recorder)
+{
+    // without framebuffer objects the page can't keep its content between frames
+    if(!m_enabled || !m_pool || !g_graphics.canUseFBO()) {
+        release(rendition);
+        return false;
+    }
+
+    // the page can't sample itself while it is drawn
+    if(m_recording)
+        return false;
+
+    if(rendition.cell >= 0) {
+        const Rect& cellRect = m_cells[rendition.cell].rect;
+        if(cellRect.width() < dest.width() || cellRect.height() < dest.height())
+            release(rendition);
+    }
+
+    bool outdated = rendition.key != key || rendition.size != dest.size();
+    if(rendition.cell < 0) {
+        rendition.cell = allocateCell(dest.size());
+        if(rendition.cell < 0)
+            return false;
+        outdated = true;
+    }
+
+    Cell& cell = m_cells[rendition.cell];
+    if(outdated) {
+        rendition.key = key;
+        rendition.size = dest.size();
+        ++cell.version;
+
+        const int index = rendition.cell;
+        m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [index](const auto& pending) { return pending.first == index; }), m_pending.end());
+        m_pending.emplace_back(index, recorder);
+    }
+
+    g_drawPool.addTexturedRect(dest, m_pool->getTexture(), Rect(cell.rect.topLeft(), dest.size()));
+
+    // the foreground must be redrawn whenever the cell content changes, even if this quad stays the same
+    size_t hash = 0;
+    boost::hash_combine(hash, rendition.cell);
+    boost::hash_combine(hash, cell.version);
+    g_drawPool.addHash(hash);
+
+    ++m_cachedDraws;
+    return true;
+}
+
+void UIRenderCache::release(Rendition& rendition)
+{
+    if(rendition.repaintEvent) {
+        rendition.repaintEvent->cancel();
+        rendition.repaintEvent = nullptr;
+    }
+
+    // widgets outliving the cache only forget their cell
+    if(rendition.cell >= 0 && rendition.cell < static_cast<int>(m_cells.size()))
+        releaseCell(rendition.cell);
+    rendition.cell = -1;
+    rendition.key = 0;
+    rendition.size = Size();
+}
+
+void UIRenderCache::repaintLater(const UIWidgetPtr& widget, Rendition& rendition, int interval)
+{
+    if(interval <= 0 || (rendition.repaintEvent && !rendition.repaintEvent->isExecuted() && !rendition.repaintEvent->isCanceled()))
+        return;
+
+    const int delay = std::max<int>(1, interval - g_clock.millis() % interval);
+    rendition.repaintEvent = g_dispatcher.scheduleEvent([widget] { widget->repaint(); }, delay);
+}
+
+void UIRenderCache::flush()
+{
+    if(m_pending.empty())
+        return;
+
+    g_drawPool.use(m_pool);
+    m_recording = true;
+
+    // recorders can release cells, which drops them from the pending list
+    const auto pendingList = std::move(m_pending);
+    m_pending.clear();
+    for(const auto& pending : pendingList) {
+        const Rect& cellRect = m_cells[pending.first].rect;
+
+        // the rest of the page belongs to other widgets, only this cell is cleared and drawn
+        g_drawPool.setClipRect(cellRect);
+        g_drawPool.addAction([]() { glDisable(GL_BLEND); });
+        g_drawPool.addFilledRect(cellRect, Color::alpha);
+        g_drawPool.addAction([]() { glEnable(GL_BLEND); });
+        pending.second(cellRect);
+        g_drawPool.resetTranslation();
+        ++m_renders;
+    }
+    m_recording = false;
+}
+
+int UIRenderCache::getUsedCellCount()
+{
+    return std::count_if(m_cells.begin(), m_cells.end(), [](const Cell& cell) { return cell.used; });
+}
+
+int UIRenderCache::allocateCell(const Size& size)
+{
+    for(size_t sizeClass = 0; sizeClass < CELL_SIZES.size(); ++sizeClass) {
+        const Size& cellSize = CELL_SIZES[sizeClass];
+        if(cellSize.width() < size.width() || cellSize.height() < size.height())
+            continue;
+
+        auto& freeCells = m_freeCells[sizeClass];
+        if(freeCells.empty()) {
+            if(m_nextRowY + cellSize.height() > PAGE_SIZE)
+                continue;
+
+            // the page is only allocated once a widget asks for a cell
+            if(m_cells.empty())
+                m_pool->resize(Size(PAGE_SIZE, PAGE_SIZE));
+
+            for(int x = PAGE_SIZE / cellSize.width() * cellSize.width() - cellSize.width(); x >= 0; x -= cellSize.width()) {
+                freeCells.push_back(m_cells.size());
+                m_cells.push_back(Cell{ Rect(Point(x, m_nextRowY), cellSize) });
+            }
+            m_nextRowY += cellSize.height();
+        }
+
+        const int cell = freeCells.back();
+        freeCells.pop_back();
+        m_cells[cell].used = true;
+        return cell;
+    }
+    return -1;
+}
+
+void UIRenderCache::releaseCell(int cell)
+{
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [cell](const auto& pending) { return pending.first == cell; }), m_pending.end());
+
+    m_cells[cell].used = false;
+    const Size cellSize = m_cells[cell].rect.size();
+    for(size_t sizeClass = 0; sizeClass < CELL_SIZES.size(); ++sizeClass) {
+        if(CELL_SIZES[sizeClass] == cellSize)
+            m_freeCells[sizeClass].push_back(cell);
+    }
+}
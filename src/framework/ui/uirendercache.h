@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UIRENDERCACHE_H
+#define UIRENDERCACHE_H
+
+#include "declarations.h"
+#include <framework/graphics/declarations.h>
+#include <framework/core/declarations.h>
+
+ //@bindsingleton g_uiRenderCache
+class UIRenderCache
+{
+public:
+    enum {
+        PAGE_SIZE = 2048
+    };
+
+    // the cell a widget holds in the cache page and the key of what was last rendered into it
+    struct Rendition {
+        int cell{ -1 };
+        size_t key{ 0 };
+        Size size;
+        ScheduledEventPtr repaintEvent;
+    };
+
+    // records the widget content with its top left corner at the given rect
+    typedef std::function<void(const Rect&)> Recorder;
+
+    // @dontbind
+    void init();
+    // @dontbind
+    void terminate();
+    // @dontbind
+    void flush();
+
+    // draws the cached rendition at dest, recording it again first when the key changed,
+    // returns false when the widget has to draw itself because the cache can't hold it,
+    // renditions requested while another one is being recorded are never cached
+    // @dontbind
+    bool draw(Rendition& rendition, const Rect& dest, size_t key, const Recorder& recorder);
+    // @dontbind
+    void release(Rendition& rendition);
+    // repaints the widget when the next animation step of the given interval is due
+    // @dontbind
+    void repaintLater(const UIWidgetPtr& widget, Rendition& rendition, int interval);
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() { return m_enabled; }
+
+    int getCellCount() { return m_cells.size(); }
+    int getUsedCellCount();
+    int getRenderCount() { return m_renders; }
+    int getCachedDrawCount() { return m_cachedDraws; }
+
+private:
+    struct Cell {
+        Rect rect;
+        uint32 version{ 0 };
+        bool used{ false };
+    };
+
+    int allocateCell(const Size& size);
+    void releaseCell(int cell);
+
+    PoolFramedPtr m_pool;
+    std::vector<Cell> m_cells;
+    std::vector<std::vector<int>> m_freeCells; // by cell size class
+    std::vector<std::pair<int, Recorder>> m_pending;
+    int m_nextRowY{ 0 };
+    int m_renders{ 0 },
+        m_cachedDraws{ 0 };
+    bool m_enabled{ true },
+        m_recording{ false };
+};
+
+extern UIRenderCache g_uiRenderCache;
+
+#endif
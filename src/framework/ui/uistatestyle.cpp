@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "uistatestyle.h"
+#include "uitranslator.h"
+
+#include <framework/otml/otml.h>
+
+UIStateStyle::UIStateStyle(const OTMLNodePtr& style) : m_relevantStates(0)
+{
+    for(const OTMLNodePtr& node : style->children()) {
+        if(!stdext::starts_with(node->tag(), "$"))
+            continue;
+
+        Block block{ node, 0, 0, false };
+        for(std::string stateStr : stdext::split(node->tag().substr(1), " ")) {
+            if(stateStr.length() == 0)
+                continue;
+
+            const bool notstate = (stateStr[0] == '!');
+            if(notstate)
+                stateStr = stateStr.substr(1);
+
+            // an unknown state is never on
+            const Fw::WidgetState state = Fw::translateState(stateStr);
+            if(state == Fw::InvalidState) {
+                if(!notstate)
+                    block.never = true;
+                continue;
+            }
+
+            if(notstate)
+                block.excluded |= state;
+            else
+                block.required |= state;
+        }
+
+        if(block.never)
+            continue;
+
+        m_relevantStates |= block.required | block.excluded;
+        m_blocks.push_back(block);
+    }
+}
+
+const OTMLNodePtr& UIStateStyle::resolve(int states)
+{
+    // states no block looks at don't change the result
+    states &= m_relevantStates;
+
+    OTMLNodePtr& resolved = m_resolved[states];
+    if(!resolved) {
+        resolved = OTMLNode::create();
+        for(const Block& block : m_blocks) {
+            if((states & block.required) == block.required && (states & block.excluded) == 0)
+                resolved->merge(block.node);
+        }
+    }
+    return resolved;
+}
+
+std::string UIStateStyle::signature(const OTMLNodePtr& style)
+{
+    std::string signature;
+    for(const OTMLNodePtr& node : style->children()) {
+        if(stdext::starts_with(node->tag(), "$"))
+            signature += node->emit() + "\n";
+    }
+    return signature;
+}
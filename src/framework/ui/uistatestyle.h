@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UISTATESTYLE_H
+#define UISTATESTYLE_H
+
+#include "declarations.h"
+#include <framework/otml/declarations.h>
+
+/// The $state blocks of a style with their conditions parsed once. Widgets whose styles
+/// have the same blocks share one instance, together with the merged properties of every
+/// state combination seen so far.
+class UIStateStyle : public stdext::shared_object
+{
+public:
+    UIStateStyle(const OTMLNodePtr& style);
+
+    /// Merged properties of the blocks matching states, the returned node must not be modified
+    const OTMLNodePtr& resolve(int states);
+
+    bool isEmpty() { return m_blocks.empty(); }
+
+    /// Key used to share instances, empty for styles without state blocks
+    static std::string signature(const OTMLNodePtr& style);
+
+private:
+    struct Block
+    {
+        OTMLNodePtr node;
+        int required;
+        int excluded;
+        bool never;
+    };
+
+    std::vector<Block> m_blocks;
+    std::unordered_map<int, OTMLNodePtr> m_resolved;
+    int m_relevantStates;
+};
+
+#endif
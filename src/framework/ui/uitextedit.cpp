@@ -50,6 +50,8 @@ UITextEdit::UITextEdit()
     m_selectionColor = Color::white;
     m_selectionBackgroundColor = Color::black;
     m_glyphsMustRecache = true;
+    m_visibleBegin = 0;
+    m_visibleEnd = 0;
     blinkCursor();
 }
 
@@ -75,8 +77,10 @@ void UITextEdit::drawSelf(Fw::DrawPane drawPane)
     if(m_color != Color::alpha) {
         if(glyphsMustRecache) {
             m_glyphsTextRectCache.clear();
-            for(int i = 0; i < textLength; ++i)
-                m_glyphsTextRectCache.push_back(std::make_pair(m_glyphsCoords[i], m_glyphsTexCoords[i]));
+            for(int i = m_visibleBegin; i < m_visibleEnd; ++i) {
+                if(m_glyphsCoords[i].isValid())
+                    m_glyphsTextRectCache.push_back(std::make_pair(m_glyphsCoords[i], m_glyphsTexCoords[i]));
+            }
         }
         for(const auto& rect : m_glyphsTextRectCache)
             g_drawPool.addTexturedRect(rect.first, texture, rect.second, m_color);
@@ -85,8 +89,10 @@ void UITextEdit::drawSelf(Fw::DrawPane drawPane)
     if(hasSelection()) {
         if(glyphsMustRecache) {
             m_glyphsSelectRectCache.clear();
-            for(int i = m_selectionStart; i < m_selectionEnd; ++i)
-                m_glyphsSelectRectCache.push_back(std::make_pair(m_glyphsCoords[i], m_glyphsTexCoords[i]));
+            for(int i = std::max<int>(m_selectionStart, m_visibleBegin), end = std::min<int>(m_selectionEnd, m_visibleEnd); i < end; ++i) {
+                if(m_glyphsCoords[i].isValid())
+                    m_glyphsSelectRectCache.push_back(std::make_pair(m_glyphsCoords[i], m_glyphsTexCoords[i]));
+            }
         }
         for(const auto& rect : m_glyphsSelectRectCache)
             g_drawPool.addFilledRect(rect.first, rect.second, m_selectionBackgroundColor);
@@ -137,8 +143,8 @@ void UITextEdit::update(bool focusCursor)
     recacheGlyphs();
 
     // map glyphs positions
-    Size textBoxSize;
-    const auto& glyphsPositions = m_font->calculateGlyphsPositions(text, m_textAlign, &textBoxSize);
+    layoutText(text);
+    Size textBoxSize = m_textBoxSize;
     const Rect* glyphsTextureCoords = m_font->getGlyphsTextureCoords();
     const Size* glyphsSize = m_font->getGlyphsSize();
     int glyph;
@@ -154,11 +160,12 @@ void UITextEdit::update(bool focusCursor)
         setSize(size);
     }
 
-    // resize just on demand
-    if(textLength > static_cast<int>(m_glyphsCoords.size())) {
-        m_glyphsCoords.resize(textLength);
-        m_glyphsTexCoords.resize(textLength);
-    }
+    // only glyphs placed by the previous update can be set, clearing them leaves every coord clear
+    for(int i = m_visibleBegin; i < std::min<int>(m_visibleEnd, m_glyphsCoords.size()); ++i)
+        m_glyphsCoords[i].clear();
+    m_visibleBegin = m_visibleEnd = 0;
+    m_glyphsCoords.resize(textLength);
+    m_glyphsTexCoords.resize(textLength);
 
     const Point oldTextAreaOffset = m_textVirtualOffset;
 
@@ -167,6 +174,9 @@ void UITextEdit::update(bool focusCursor)
     if(textBoxSize.height() <= getPaddingRect().height())
         m_textVirtualOffset.y = 0;
 
+    const int lineHeight = std::max<int>(m_font->getGlyphHeight() + m_font->getGlyphSpacing().height(), 1);
+    const int lineCount = m_lineStarts.size();
+
     // readjust start view area based on cursor position
     m_cursorInRange = false;
     if(focusCursor && m_autoScroll) {
@@ -175,7 +185,7 @@ void UITextEdit::update(bool focusCursor)
             const Rect virtualRect(m_textVirtualOffset, m_rect.size() - Size(m_padding.left + m_padding.right, 0)); // previous rendered virtual rect
             int pos = m_cursorPos - 1; // element before cursor
             glyph = static_cast<uchar>(text[pos]); // glyph of the element before cursor
-            Rect glyphRect(glyphsPositions[pos], glyphsSize[glyph]);
+            Rect glyphRect(getGlyphPosition(pos), glyphsSize[glyph]);
 
             // if the cursor is not on the previous rendered virtual rect we need to update it
             if(!virtualRect.contains(glyphRect.topLeft()) || !virtualRect.contains(glyphRect.bottomRight())) {
@@ -184,17 +194,23 @@ void UITextEdit::update(bool focusCursor)
                 startGlyphPos.y = std::max<int>(glyphRect.bottom() - virtualRect.height(), 0);
                 startGlyphPos.x = std::max<int>(glyphRect.right() - virtualRect.width(), 0);
 
+                // lines above startGlyphPos can't hold it
+                int line = 0;
+                while(line + 1 < lineCount && std::max<int>(line * lineHeight - m_font->getGlyphSpacing().height(), 0) < startGlyphPos.y)
+                    ++line;
+
                 // find that glyph
-                for(pos = 0; pos < textLength; ++pos) {
+                for(pos = m_lineStarts[line]; pos < textLength; ++pos) {
                     glyph = static_cast<uchar>(text[pos]);
-                    glyphRect = Rect(glyphsPositions[pos], glyphsSize[glyph]);
+                    const Point glyphPos = getGlyphPosition(pos);
+                    glyphRect = Rect(glyphPos, glyphsSize[glyph]);
                     glyphRect.setTop(std::max<int>(glyphRect.top() - m_font->getYOffset() - m_font->getGlyphSpacing().height(), 0));
                     glyphRect.setLeft(std::max<int>(glyphRect.left() - m_font->getGlyphSpacing().width(), 0));
 
                     // first glyph entirely visible found
                     if(glyphRect.topLeft() >= startGlyphPos) {
-                        m_textVirtualOffset.x = glyphsPositions[pos].x;
-                        m_textVirtualOffset.y = glyphsPositions[pos].y - m_font->getYOffset();
+                        m_textVirtualOffset.x = glyphPos.x;
+                        m_textVirtualOffset.y = glyphPos.y - m_font->getYOffset();
                         break;
                     }
                 }
@@ -208,7 +224,7 @@ void UITextEdit::update(bool focusCursor)
             const Rect virtualRect(m_textVirtualOffset, m_rect.size() - Size(2 * m_padding.left + m_padding.right, 0)); // previous rendered virtual rect
             const int pos = m_cursorPos - 1; // element before cursor
             glyph = static_cast<uchar>(text[pos]); // glyph of the element before cursor
-            const Rect glyphRect(glyphsPositions[pos], glyphsSize[glyph]);
+            const Rect glyphRect(getGlyphPosition(pos), glyphsSize[glyph]);
             if(virtualRect.contains(glyphRect.topLeft()) && virtualRect.contains(glyphRect.bottomRight()))
                 m_cursorInRange = true;
         } else {
@@ -242,92 +258,175 @@ void UITextEdit::update(bool focusCursor)
         fireAreaUpdate = true;
     }
 
+    // translation of the text box inside the text area
+    Point boxOffset;
     if(m_textAlign & Fw::AlignBottom) {
-        m_drawArea.translate(0, textScreenCoords.height() - textBoxSize.height());
+        boxOffset.y = textScreenCoords.height() - textBoxSize.height();
     } else if(m_textAlign & Fw::AlignVerticalCenter) {
-        m_drawArea.translate(0, (textScreenCoords.height() - textBoxSize.height()) / 2);
+        boxOffset.y = (textScreenCoords.height() - textBoxSize.height()) / 2;
     } else { // AlignTop
     }
 
     if(m_textAlign & Fw::AlignRight) {
-        m_drawArea.translate(textScreenCoords.width() - textBoxSize.width(), 0);
+        boxOffset.x = textScreenCoords.width() - textBoxSize.width();
     } else if(m_textAlign & Fw::AlignHorizontalCenter) {
-        m_drawArea.translate((textScreenCoords.width() - textBoxSize.width()) / 2, 0);
+        boxOffset.x = (textScreenCoords.width() - textBoxSize.width()) / 2;
     } else { // AlignLeft
     }
+    m_drawArea.translate(boxOffset);
+
+    // only lines crossing the visible area are placed on screen
+    const int viewTop = m_textVirtualOffset.y - boxOffset.y - m_font->getYOffset();
+    const int firstLine = stdext::clamp<int>(viewTop / lineHeight - 1, 0, lineCount - 1);
+    const int lastLine = stdext::clamp<int>((viewTop + textScreenCoords.height()) / lineHeight + 1, 0, lineCount - 1);
+
+    for(int line = firstLine; line <= lastLine; ++line) {
+        const int lineEnd = line + 1 < lineCount ? m_lineStarts[line + 1] : textLength;
+        const int lineOffset = boxOffset.x + getLineAlignOffset(line);
+
+        // glyphs advance left to right, start from the last one beginning left of the visible area
+        const auto lineBegin = m_glyphsPositions.begin() + m_lineStarts[line];
+        auto it = std::upper_bound(lineBegin, m_glyphsPositions.begin() + lineEnd, m_textVirtualOffset.x - lineOffset,
+                                   [](int x, const Point& glyphPos) { return x < glyphPos.x; });
+        if(it != lineBegin)
+            --it;
+        while(it != lineBegin && (it - 1)->x == it->x)
+            --it;
+
+        for(int i = it - m_glyphsPositions.begin(); i < lineEnd; ++i) {
+            // every glyph from here on is right of the visible area
+            if(m_glyphsPositions[i].x + lineOffset - m_textVirtualOffset.x >= textScreenCoords.width())
+                break;
 
-    for(int i = 0; i < textLength; ++i) {
-        glyph = static_cast<uchar>(text[i]);
-        m_glyphsCoords[i].clear();
+            glyph = static_cast<uchar>(text[i]);
 
-        // skip invalid glyphs
-        if(glyph < 32 && glyph != static_cast<uchar>('\n'))
-            continue;
+            // skip invalid glyphs
+            if(glyph < 32 && glyph != static_cast<uchar>('\n'))
+                continue;
 
-        // calculate initial glyph rect and texture coords
-        Rect glyphScreenCoords(glyphsPositions[i], glyphsSize[glyph]);
-        Rect glyphTextureCoords = glyphsTextureCoords[glyph];
-
-        // first translate to align position
-        if(m_textAlign & Fw::AlignBottom) {
-            glyphScreenCoords.translate(0, textScreenCoords.height() - textBoxSize.height());
-        } else if(m_textAlign & Fw::AlignVerticalCenter) {
-            glyphScreenCoords.translate(0, (textScreenCoords.height() - textBoxSize.height()) / 2);
-        } else { // AlignTop
-         // nothing to do
-        }
+            // calculate initial glyph rect and texture coords, translated to align position
+            Rect glyphScreenCoords(m_glyphsPositions[i] + Point(lineOffset, boxOffset.y), glyphsSize[glyph]);
+            Rect glyphTextureCoords = glyphsTextureCoords[glyph];
 
-        if(m_textAlign & Fw::AlignRight) {
-            glyphScreenCoords.translate(textScreenCoords.width() - textBoxSize.width(), 0);
-        } else if(m_textAlign & Fw::AlignHorizontalCenter) {
-            glyphScreenCoords.translate((textScreenCoords.width() - textBoxSize.width()) / 2, 0);
-        } else { // AlignLeft
-         // nothing to do
-        }
+            // only render glyphs that are after startRenderPosition
+            if(glyphScreenCoords.bottom() < m_textVirtualOffset.y || glyphScreenCoords.right() < m_textVirtualOffset.x)
+                continue;
 
-        // only render glyphs that are after startRenderPosition
-        if(glyphScreenCoords.bottom() < m_textVirtualOffset.y || glyphScreenCoords.right() < m_textVirtualOffset.x)
-            continue;
+            // bound glyph topLeft to startRenderPosition
+            if(glyphScreenCoords.top() < m_textVirtualOffset.y) {
+                glyphTextureCoords.setTop(glyphTextureCoords.top() + (m_textVirtualOffset.y - glyphScreenCoords.top()));
+                glyphScreenCoords.setTop(m_textVirtualOffset.y);
+            }
+            if(glyphScreenCoords.left() < m_textVirtualOffset.x) {
+                glyphTextureCoords.setLeft(glyphTextureCoords.left() + (m_textVirtualOffset.x - glyphScreenCoords.left()));
+                glyphScreenCoords.setLeft(m_textVirtualOffset.x);
+            }
 
-        // bound glyph topLeft to startRenderPosition
-        if(glyphScreenCoords.top() < m_textVirtualOffset.y) {
-            glyphTextureCoords.setTop(glyphTextureCoords.top() + (m_textVirtualOffset.y - glyphScreenCoords.top()));
-            glyphScreenCoords.setTop(m_textVirtualOffset.y);
-        }
-        if(glyphScreenCoords.left() < m_textVirtualOffset.x) {
-            glyphTextureCoords.setLeft(glyphTextureCoords.left() + (m_textVirtualOffset.x - glyphScreenCoords.left()));
-            glyphScreenCoords.setLeft(m_textVirtualOffset.x);
-        }
+            // subtract startInternalPos
+            glyphScreenCoords.translate(-m_textVirtualOffset);
 
-        // subtract startInternalPos
-        glyphScreenCoords.translate(-m_textVirtualOffset);
+            // translate rect to screen coords
+            glyphScreenCoords.translate(textScreenCoords.topLeft());
 
-        // translate rect to screen coords
-        glyphScreenCoords.translate(textScreenCoords.topLeft());
+            // only render if glyph rect is visible on screenCoords
+            if(!textScreenCoords.intersects(glyphScreenCoords))
+                continue;
 
-        // only render if glyph rect is visible on screenCoords
-        if(!textScreenCoords.intersects(glyphScreenCoords))
-            continue;
+            // bound glyph bottomRight to screenCoords bottomRight
+            if(glyphScreenCoords.bottom() > textScreenCoords.bottom()) {
+                glyphTextureCoords.setBottom(glyphTextureCoords.bottom() + (textScreenCoords.bottom() - glyphScreenCoords.bottom()));
+                glyphScreenCoords.setBottom(textScreenCoords.bottom());
+            }
+            if(glyphScreenCoords.right() > textScreenCoords.right()) {
+                glyphTextureCoords.setRight(glyphTextureCoords.right() + (textScreenCoords.right() - glyphScreenCoords.right()));
+                glyphScreenCoords.setRight(textScreenCoords.right());
+            }
 
-        // bound glyph bottomRight to screenCoords bottomRight
-        if(glyphScreenCoords.bottom() > textScreenCoords.bottom()) {
-            glyphTextureCoords.setBottom(glyphTextureCoords.bottom() + (textScreenCoords.bottom() - glyphScreenCoords.bottom()));
-            glyphScreenCoords.setBottom(textScreenCoords.bottom());
-        }
-        if(glyphScreenCoords.right() > textScreenCoords.right()) {
-            glyphTextureCoords.setRight(glyphTextureCoords.right() + (textScreenCoords.right() - glyphScreenCoords.right()));
-            glyphScreenCoords.setRight(textScreenCoords.right());
+            // render glyph
+            if(m_visibleEnd == 0)
+                m_visibleBegin = i;
+            m_visibleEnd = i + 1;
+            m_glyphsCoords[i] = glyphScreenCoords;
+            m_glyphsTexCoords[i] = glyphTextureCoords;
         }
-
-        // render glyph
-        m_glyphsCoords[i] = glyphScreenCoords;
-        m_glyphsTexCoords[i] = glyphTextureCoords;
     }
 
     if(fireAreaUpdate)
         onTextAreaUpdate(m_textVirtualOffset, m_textVirtualSize, m_textTotalSize);
 
-    g_app.repaint();
+    repaint();
+}
+
+void UITextEdit::layoutText(const std::string& text)
+{
+    const int textLength = text.length();
+
+    // lines before the first changed character keep their glyphs
+    int line = 0;
+    if(m_layoutFont == m_font && !m_lineStarts.empty()) {
+        const int common = std::min<int>(m_layoutText.length(), textLength);
+        const int changed = std::mismatch(text.begin(), text.begin() + common, m_layoutText.begin()).first - text.begin();
+        if(changed == common && m_layoutText.length() == text.length())
+            return;
+        // the line before an edited line break changes too, its last glyph may gain or lose spacing
+        if(changed > 0)
+            line = getLineOf(changed - 1);
+    }
+
+    m_layoutText = text;
+    m_layoutFont = m_font;
+    m_glyphsPositions.resize(textLength);
+    m_lineStarts.resize(line + 1);
+    m_lineWidths.resize(line + 1);
+    m_lineWidths[line] = 0;
+
+    const Size* glyphsSize = m_font->getGlyphsSize();
+    const Size glyphSpacing = m_font->getGlyphSpacing();
+    const int lineHeight = m_font->getGlyphHeight() + glyphSpacing.height();
+
+    const int start = m_lineStarts[line];
+    Point virtualPos(0, m_font->getYOffset() + line * lineHeight);
+    for(int i = start; i < textLength; ++i) {
+        const int glyph = static_cast<uchar>(text[i]);
+
+        // the line break opening the first line laid out is already counted
+        if(glyph == static_cast<uchar>('\n') && (i != start || line == 0)) {
+            ++line;
+            m_lineStarts.push_back(i);
+            m_lineWidths.push_back(0);
+            virtualPos = Point(0, virtualPos.y + lineHeight);
+        }
+
+        m_glyphsPositions[i] = virtualPos;
+
+        if(glyph >= 32) {
+            m_lineWidths[line] += glyphsSize[glyph].width();
+            // only add space if letter is not the last or before a \n
+            if(i + 1 != textLength && text[i + 1] != '\n')
+                m_lineWidths[line] += glyphSpacing.width();
+            virtualPos.x += glyphsSize[glyph].width() + glyphSpacing.width();
+        }
+    }
+
+    if(textLength == 0)
+        m_textBoxSize.resize(0, m_font->getGlyphHeight());
+    else
+        m_textBoxSize.resize(*std::max_element(m_lineWidths.begin(), m_lineWidths.end()),
+                             m_font->getYOffset() + (static_cast<int>(m_lineStarts.size()) - 1) * lineHeight + m_font->getGlyphHeight());
+}
+
+int UITextEdit::getLineOf(int pos) const
+{
+    return std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), pos) - m_lineStarts.begin() - 1;
+}
+
+int UITextEdit::getLineAlignOffset(int line) const
+{
+    if(m_textAlign & Fw::AlignRight)
+        return m_textBoxSize.width() - m_lineWidths[line];
+    if(m_textAlign & Fw::AlignHorizontalCenter)
+        return (m_textBoxSize.width() - m_lineWidths[line]) / 2;
+    return 0;
 }
 
 void UITextEdit::setCursorPos(int pos)
@@ -450,7 +549,7 @@ void UITextEdit::removeCharacter(bool right)
 void UITextEdit::blinkCursor()
 {
     m_cursorTicks = g_clock.millis();
-    g_app.repaint();
+    repaint();
 }
 
 void UITextEdit::del(bool right)
@@ -525,7 +624,7 @@ int UITextEdit::getTextPos(const Point& pos)
     // find any glyph that is actually on the
     int candidatePos = -1;
     Rect firstGlyphRect, lastGlyphRect;
-    for(int i = 0; i < textLength; ++i) {
+    for(int i = m_visibleBegin; i < std::min<int>(m_visibleEnd, textLength); ++i) {
         Rect clickGlyphRect = m_glyphsCoords[i];
         if(!clickGlyphRect.isValid())
             continue;
@@ -109,6 +109,10 @@ private:
     void disableUpdates() { m_updatesEnabled = false; }
     void enableUpdates() { m_updatesEnabled = true; }
     void recacheGlyphs() { m_glyphsMustRecache = true; }
+    void layoutText(const std::string& text);
+    int getLineOf(int pos) const;
+    int getLineAlignOffset(int line) const;
+    Point getGlyphPosition(int pos) const { return m_glyphsPositions[pos] + Point(getLineAlignOffset(getLineOf(pos)), 0); }
 
     Rect m_drawArea;
     int m_cursorPos;
@@ -138,6 +142,17 @@ private:
 
     std::vector<Rect> m_glyphsCoords;
     std::vector<Rect> m_glyphsTexCoords;
+    int m_visibleBegin; // m_glyphsCoords is only set inside [m_visibleBegin, m_visibleEnd)
+    int m_visibleEnd;
+
+    // glyph positions of the laid out text relative to its box, left aligned in each line,
+    // an edit lays out again only from the line it touched onward
+    std::string m_layoutText;
+    BitmapFontPtr m_layoutFont;
+    std::vector<Point> m_glyphsPositions;
+    std::vector<int> m_lineStarts;
+    std::vector<int> m_lineWidths;
+    Size m_textBoxSize;
 
     std::vector<std::pair<Rect, Rect>> m_glyphsTextRectCache, m_glyphsSelectRectCache;
 
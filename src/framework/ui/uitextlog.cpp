@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "uitextlog.h"
+#include <framework/graphics/bitmapfont.h>
+#include <framework/luaengine/luainterface.h>
+#include <framework/otml/otmlnode.h>
+
+#include <ctime>
+
+UITextLog::UITextLog()
+{
+    m_capacity = 0;
+    m_head = 0;
+    m_count = 0;
+    m_lineCount = 0;
+    m_layoutWidth = -1;
+    m_lineSpacing = 0;
+    m_scrollOffset = 0;
+    m_scrollStep = 3;
+    m_notifiedScrollOffset = 0;
+    m_notifiedMaxScrollOffset = 0;
+    m_showTimestamps = false;
+    m_speakers.emplace_back();
+    setClipping(true);
+    setCapacity(1000);
+}
+
+int UITextLog::appendMessages(LuaInterface* lua)
+{
+    int added = 0;
+    if(lua->isTable(1)) {
+        const ticks_t now = stdext::time();
+        for(int i = 1;; ++i) {
+            lua->rawGeti(i, 1);
+            if(!lua->isTable()) {
+                lua->pop();
+                break;
+            }
+
+            lua->getField("text");
+            const std::string text = lua->isNil() ? std::string() : lua->toString();
+            lua->pop();
+            lua->getField("speaker");
+            const std::string speaker = lua->isNil() ? std::string() : lua->toString();
+            lua->pop();
+            lua->getField("mode");
+            const int mode = lua->isNil() ? 0 : lua->toInteger();
+            lua->pop();
+            lua->getField("time");
+            const ticks_t time = lua->isNil() ? now : lua->toInteger();
+            lua->pop();
+            lua->getField("color");
+            const Color color = lua->isNil() ? m_color : lua->castValue<Color>();
+            lua->pop();
+
+            lua->pop();
+            pushMessage(text, speaker, mode, color, time);
+            ++added;
+        }
+    }
+
+    lua->pop(lua->getTop());
+    if(added > 0) {
+        notifyScrollChange();
+        repaint();
+    }
+    lua->pushInteger(added);
+    return 1;
+}
+
+void UITextLog::appendMessage(const std::string& text, const std::string& speaker, int mode, const Color& color)
+{
+    pushMessage(text, speaker, mode, color, stdext::time());
+    notifyScrollChange();
+    repaint();
+}
+
+void UITextLog::clear()
+{
+    for(Message& message : m_messages)
+        message = Message();
+    m_head = 0;
+    m_count = 0;
+    m_lineCount = 0;
+    m_scrollOffset = 0;
+    m_speakers.resize(1);
+    m_speakerIds.clear();
+    notifyScrollChange();
+    repaint();
+}
+
+void UITextLog::setCapacity(int capacity)
+{
+    // speaker ids are 16 bits, one message can hold at most one of them
+    capacity = stdext::clamp<int>(capacity, 1, MAX_CAPACITY);
+    if(capacity == m_capacity)
+        return;
+
+    // keep the newest messages, in order, starting at the first slot
+    const int kept = std::min<int>(m_count, capacity);
+    std::vector<Message> messages(capacity);
+    for(int i = 0; i < kept; ++i)
+        messages[i] = std::move(m_messages[(m_head + m_count - kept + i) % m_capacity]);
+
+    m_messages = std::move(messages);
+    m_capacity = capacity;
+    m_head = 0;
+    m_count = kept;
+    m_lineCount = 0;
+    for(int i = 0; i < m_count; ++i)
+        m_lineCount += m_messages[i].lines.size();
+    notifyScrollChange();
+    repaint();
+}
+
+void UITextLog::setLineSpacing(int spacing)
+{
+    m_lineSpacing = std::max<int>(spacing, 0);
+    notifyScrollChange();
+    repaint();
+}
+
+void UITextLog::setShowTimestamps(bool show)
+{
+    if(m_showTimestamps == show)
+        return;
+
+    m_showTimestamps = show;
+    relayout();
+}
+
+void UITextLog::setScrollOffset(int offset)
+{
+    offset = stdext::clamp<int>(offset, 0, getMaxScrollOffset());
+    if(offset == m_scrollOffset)
+        return;
+
+    m_scrollOffset = offset;
+    notifyScrollChange();
+    repaint();
+}
+
+int UITextLog::getMaxScrollOffset()
+{
+    const int visibleLines = getPaddingRect().height() / std::max<int>(getLinePitch(), 1);
+    return std::max<int>(m_lineCount - visibleLines, 0);
+}
+
+std::string UITextLog::getMessageText(int index)
+{
+    if(Message* message = getMessage(index))
+        return message->text;
+    return std::string();
+}
+
+std::string UITextLog::getMessageSpeaker(int index)
+{
+    if(Message* message = getMessage(index))
+        return m_speakers[message->speaker];
+    return std::string();
+}
+
+int UITextLog::getMessageMode(int index)
+{
+    if(Message* message = getMessage(index))
+        return message->mode;
+    return 0;
+}
+
+ticks_t UITextLog::getMessageTime(int index)
+{
+    if(Message* message = getMessage(index))
+        return message->time;
+    return 0;
+}
+
+void UITextLog::drawSelf(Fw::DrawPane drawPane)
+{
+    UIWidget::drawSelf(drawPane);
+
+    if((drawPane & Fw::ForegroundPane) == 0 || m_count == 0)
+        return;
+
+    const Rect area = getPaddingRect();
+    const int pitch = getLinePitch();
+    const int lineHeight = m_font->getGlyphHeight();
+    if(area.height() <= 0 || pitch <= 0)
+        return;
+
+    // walk back from the newest line, skipping the scrolled lines and stopping above the top
+    int skip = m_scrollOffset;
+    int bottom = area.bottom() + 1;
+    for(int i = m_count - 1; i >= 0 && bottom > area.top(); --i) {
+        const Message& message = m_messages[(m_head + i) % m_capacity];
+        const int lines = message.lines.size();
+        if(skip >= lines) {
+            skip -= lines;
+            continue;
+        }
+
+        for(int line = lines - 1 - skip; line >= 0 && bottom > area.top(); --line) {
+            bottom -= pitch;
+            m_font->drawText(message.lines[line], Rect(area.left(), bottom, area.width(), lineHeight), message.color);
+        }
+        skip = 0;
+    }
+}
+
+void UITextLog::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode)
+{
+    UIWidget::onStyleApply(styleName, styleNode);
+
+    for(const OTMLNodePtr& node : styleNode->children()) {
+        if(node->tag() == "capacity")
+            setCapacity(node->value<int>());
+        else if(node->tag() == "line-spacing")
+            setLineSpacing(node->value<int>());
+        else if(node->tag() == "show-timestamps")
+            setShowTimestamps(node->value<bool>());
+        else if(node->tag() == "scroll-step")
+            setScrollStep(node->value<int>());
+    }
+}
+
+void UITextLog::onGeometryChange(const Rect& oldRect, const Rect& newRect)
+{
+    UIWidget::onGeometryChange(oldRect, newRect);
+
+    if(getPaddingRect().width() != m_layoutWidth)
+        relayout();
+    else
+        notifyScrollChange();
+}
+
+void UITextLog::onFontChange(const std::string& font)
+{
+    UIWidget::onFontChange(font);
+    relayout();
+}
+
+bool UITextLog::onMouseWheel(const Point& mousePos, Fw::MouseWheelDirection direction)
+{
+    if(UIWidget::onMouseWheel(mousePos, direction))
+        return true;
+
+    const int oldOffset = m_scrollOffset;
+    setScrollOffset(m_scrollOffset + (direction == Fw::MouseWheelUp ? m_scrollStep : -m_scrollStep));
+    return m_scrollOffset != oldOffset;
+}
+
+void UITextLog::pushMessage(const std::string& text, const std::string& speaker, int mode, const Color& color, ticks_t time)
+{
+    if(m_count == m_capacity) {
+        Message& oldest = m_messages[m_head];
+        m_lineCount -= oldest.lines.size();
+        oldest = Message();
+        m_head = (m_head + 1) % m_capacity;
+        --m_count;
+    }
+
+    Message& message = m_messages[(m_head + m_count) % m_capacity];
+    ++m_count;
+    message.text = text;
+    message.time = time;
+    message.color = color;
+    message.speaker = internSpeaker(speaker);
+    message.mode = static_cast<uint8>(mode);
+    layoutMessage(message);
+    m_lineCount += message.lines.size();
+
+    // a scrolled back view stays on the same lines while new ones come in
+    if(m_scrollOffset > 0)
+        m_scrollOffset += message.lines.size();
+}
+
+void UITextLog::layoutMessage(Message& message)
+{
+    std::string line;
+    if(m_showTimestamps) {
+        char buffer[16];
+        const std::time_t time = message.time;
+        if(const std::tm* tm = std::localtime(&time)) {
+            if(std::strftime(buffer, sizeof(buffer), "%H:%M ", tm) > 0)
+                line = buffer;
+        }
+    }
+
+    const std::string& speaker = m_speakers[message.speaker];
+    if(!speaker.empty())
+        line += speaker + ": ";
+    line += message.text;
+
+    m_layoutWidth = getPaddingRect().width();
+    if(m_layoutWidth > 0)
+        line = m_font->wrapText(line, m_layoutWidth);
+    message.lines = stdext::split(line, "\n");
+    if(message.lines.empty())
+        message.lines.emplace_back();
+}
+
+void UITextLog::relayout()
+{
+    m_layoutWidth = getPaddingRect().width();
+    m_lineCount = 0;
+    for(int i = 0; i < m_count; ++i) {
+        Message& message = m_messages[(m_head + i) % m_capacity];
+        layoutMessage(message);
+        m_lineCount += message.lines.size();
+    }
+    notifyScrollChange();
+    repaint();
+}
+
+void UITextLog::notifyScrollChange()
+{
+    const int maxOffset = getMaxScrollOffset();
+    m_scrollOffset = stdext::clamp<int>(m_scrollOffset, 0, maxOffset);
+    if(m_scrollOffset != m_notifiedScrollOffset || maxOffset != m_notifiedMaxScrollOffset) {
+        m_notifiedScrollOffset = m_scrollOffset;
+        m_notifiedMaxScrollOffset = maxOffset;
+        callLuaField("onScrollChange", m_scrollOffset, maxOffset);
+    }
+}
+
+uint16 UITextLog::internSpeaker(const std::string& speaker)
+{
+    if(speaker.empty())
+        return 0;
+
+    const auto it = m_speakerIds.find(speaker);
+    if(it != m_speakerIds.end())
+        return it->second;
+
+    // compacting leaves at most one name per message, twice that keeps it amortized
+    if(m_speakers.size() >= static_cast<size_t>(std::max<int>(MAX_SPEAKERS, m_count * 2)))
+        compactSpeakers();
+
+    const uint16 id = static_cast<uint16>(m_speakers.size());
+    m_speakers.push_back(speaker);
+    m_speakerIds.emplace(speaker, id);
+    return id;
+}
+
+void UITextLog::compactSpeakers()
+{
+    std::vector<std::string> speakers(1);
+    std::unordered_map<std::string, uint16> speakerIds;
+    for(int i = 0; i < m_count; ++i) {
+        Message& message = m_messages[(m_head + i) % m_capacity];
+        if(message.speaker == 0)
+            continue;
+
+        std::string& name = m_speakers[message.speaker];
+        auto it = speakerIds.find(name);
+        if(it == speakerIds.end()) {
+            it = speakerIds.emplace(name, speakers.size()).first;
+            speakers.push_back(name);
+        }
+        message.speaker = it->second;
+    }
+
+    m_speakers = std::move(speakers);
+    m_speakerIds = std::move(speakerIds);
+}
+
+UITextLog::Message* UITextLog::getMessage(int index)
+{
+    if(index < 1 || index > m_count)
+        return nullptr;
+    return &m_messages[(m_head + index - 1) % m_capacity];
+}
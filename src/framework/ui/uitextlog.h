@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UITEXTLOG_H
+#define UITEXTLOG_H
+
+#include "uiwidget.h"
+#include <framework/luaengine/declarations.h>
+
+/// Read only message log kept in a fixed size ring buffer, the oldest message is
+/// dropped once it is full. Messages are wrapped once when appended (and again only
+/// when the width or font changes) and only the lines inside the widget are drawn.
+/// The scroll offset counts lines up from the newest one.
+// @bindclass
+class UITextLog : public UIWidget
+{
+public:
+    UITextLog();
+
+    /// Appends {text=, speaker=, mode=, color=, time=} entries from a lua array, returns how many were added
+    int appendMessages(LuaInterface* lua);
+    void appendMessage(const std::string& text, const std::string& speaker, int mode, const Color& color);
+    void clear();
+
+    void setCapacity(int capacity);
+    void setLineSpacing(int spacing);
+    void setShowTimestamps(bool show);
+    void setScrollOffset(int offset);
+    void setScrollStep(int step) { m_scrollStep = std::max<int>(step, 1); }
+
+    int getCapacity() { return m_capacity; }
+    int getLineSpacing() { return m_lineSpacing; }
+    bool isShowingTimestamps() { return m_showTimestamps; }
+    int getScrollOffset() { return m_scrollOffset; }
+    int getMaxScrollOffset();
+    int getScrollStep() { return m_scrollStep; }
+    int getMessageCount() { return m_count; }
+    int getLineCount() { return m_lineCount; }
+    std::string getMessageText(int index);
+    std::string getMessageSpeaker(int index);
+    int getMessageMode(int index);
+    ticks_t getMessageTime(int index);
+
+protected:
+    void drawSelf(Fw::DrawPane drawPane) override;
+    void onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode) override;
+    void onGeometryChange(const Rect& oldRect, const Rect& newRect) override;
+    void onFontChange(const std::string& font) override;
+    bool onMouseWheel(const Point& mousePos, Fw::MouseWheelDirection direction) override;
+
+private:
+    // speaker names no longer used by any message are dropped once the table grows past this
+    static const int MAX_SPEAKERS = 1024;
+    static const int MAX_CAPACITY = 30000;
+
+    struct Message
+    {
+        std::string text;
+        std::vector<std::string> lines;
+        ticks_t time;
+        Color color;
+        uint16 speaker;
+        uint8 mode;
+    };
+
+    void pushMessage(const std::string& text, const std::string& speaker, int mode, const Color& color, ticks_t time);
+    void layoutMessage(Message& message);
+    void relayout();
+    void notifyScrollChange();
+    uint16 internSpeaker(const std::string& speaker);
+    void compactSpeakers();
+    Message* getMessage(int index);
+    int getLinePitch() { return m_font->getGlyphHeight() + m_lineSpacing; }
+
+    std::vector<Message> m_messages;
+    std::vector<std::string> m_speakers;
+    std::unordered_map<std::string, uint16> m_speakerIds;
+    int m_capacity;
+    int m_head;
+    int m_count;
+    int m_lineCount;
+    int m_layoutWidth;
+    int m_lineSpacing;
+    int m_scrollOffset;
+    int m_scrollStep;
+    int m_notifiedScrollOffset;
+    int m_notifiedMaxScrollOffset;
+    bool m_showTimestamps;
+};
+
+#endif
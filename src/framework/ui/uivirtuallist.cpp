@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "uivirtuallist.h"
+#include "uimanager.h"
+
+UIVirtualList::UIVirtualList()
+{
+    m_rowHeight = 20;
+    m_rowSpacing = 0;
+    m_columns = 1;
+    m_itemCount = 0;
+    m_scrollOffset = 0;
+    m_scrollStep = 0;
+    m_firstItem = 0;
+    m_lastItem = -1;
+    m_notifiedScrollOffset = 0;
+    m_notifiedMaxScrollOffset = 0;
+    m_updatingRows = false;
+    m_rowsDirty = false;
+    setClipping(true);
+}
+
+void UIVirtualList::setRowStyle(const std::string& rowStyle)
+{
+    if(m_rowStyle == rowStyle)
+        return;
+
+    m_rowStyle = rowStyle;
+    clearRows();
+    updateRows();
+}
+
+void UIVirtualList::setRowHeight(int height)
+{
+    m_rowHeight = std::max<int>(height, 1);
+    updateRows();
+}
+
+void UIVirtualList::setRowSpacing(int spacing)
+{
+    m_rowSpacing = std::max<int>(spacing, 0);
+    updateRows();
+}
+
+void UIVirtualList::setColumns(int columns)
+{
+    m_columns = std::max<int>(columns, 1);
+    updateRows();
+}
+
+void UIVirtualList::setItemCount(int count)
+{
+    // the items behind every row may have moved, all of them are asked again
+    m_itemCount = std::max<int>(count, 0);
+    updateRows(true);
+}
+
+void UIVirtualList::setScrollOffset(int offset)
+{
+    if(offset == m_scrollOffset)
+        return;
+
+    m_scrollOffset = offset;
+    updateRows();
+}
+
+void UIVirtualList::refresh()
+{
+    updateRows(true);
+}
+
+void UIVirtualList::refreshItem(int index)
+{
+    if(m_updatingRows)
+        return;
+
+    if(UIWidgetPtr widget = getItemWidget(index))
+        callLuaField("onItemUpdate", widget, index);
+}
+
+void UIVirtualList::ensureItemVisible(int index)
+{
+    if(index < 1 || index > m_itemCount)
+        return;
+
+    const int height = getPaddingRect().height();
+    const int top = ((index - 1) / m_columns) * getPitch();
+    const int bottom = top + m_rowHeight;
+    if(top < m_scrollOffset)
+        setScrollOffset(top);
+    else if(bottom > m_scrollOffset + height)
+        setScrollOffset(bottom - height);
+}
+
+int UIVirtualList::getMaxScrollOffset()
+{
+    const int contentHeight = getLineCount() * getPitch() - m_rowSpacing;
+    return std::max<int>(contentHeight - getPaddingRect().height(), 0);
+}
+
+UIWidgetPtr UIVirtualList::getItemWidget(int index)
+{
+    for(const Row& row : m_rows) {
+        if(row.item == index - 1)
+            return row.widget;
+    }
+    return nullptr;
+}
+
+int UIVirtualList::getItemIndex(const UIWidgetPtr& widget)
+{
+    for(const Row& row : m_rows) {
+        if(row.widget == widget)
+            return row.item + 1;
+    }
+    return 0;
+}
+
+void UIVirtualList::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode)
+{
+    UIWidget::onStyleApply(styleName, styleNode);
+
+    for(const OTMLNodePtr& node : styleNode->children()) {
+        if(node->tag() == "row-style")
+            setRowStyle(node->value());
+        else if(node->tag() == "row-height")
+            setRowHeight(node->value<int>());
+        else if(node->tag() == "row-spacing")
+            setRowSpacing(node->value<int>());
+        else if(node->tag() == "columns")
+            setColumns(node->value<int>());
+        else if(node->tag() == "scroll-step")
+            setScrollStep(node->value<int>());
+    }
+}
+
+void UIVirtualList::onGeometryChange(const Rect& oldRect, const Rect& newRect)
+{
+    // the base binds the first and last rows inside the list, placing them again undoes that
+    UIWidget::onGeometryChange(oldRect, newRect);
+    updateRows();
+}
+
+bool UIVirtualList::onMouseWheel(const Point& mousePos, Fw::MouseWheelDirection direction)
+{
+    if(UIWidget::onMouseWheel(mousePos, direction))
+        return true;
+
+    const int oldOffset = m_scrollOffset;
+    const int step = m_scrollStep > 0 ? m_scrollStep : getPitch();
+    setScrollOffset(std::max<int>(m_scrollOffset + (direction == Fw::MouseWheelUp ? -step : step), 0));
+    return m_scrollOffset != oldOffset;
+}
+
+void UIVirtualList::updateRows(bool refreshAll)
+{
+    if(m_destroyed)
+        return;
+
+    // data source callbacks may change the list again, that is handled once they return
+    if(m_updatingRows) {
+        m_rowsDirty = true;
+        return;
+    }
+
+    m_updatingRows = true;
+    do {
+        m_rowsDirty = false;
+
+        const Rect area = getPaddingRect();
+        const int pitch = getPitch();
+        const int maxOffset = getMaxScrollOffset();
+        m_scrollOffset = stdext::clamp<int>(m_scrollOffset, 0, maxOffset);
+
+        m_firstItem = 0;
+        m_lastItem = -1;
+        if(m_itemCount > 0 && !m_rowStyle.empty() && area.height() > 0) {
+            const int firstLine = m_scrollOffset / pitch;
+            const int lastLine = std::min<int>((m_scrollOffset + area.height() - 1) / pitch, getLineCount() - 1);
+            m_firstItem = firstLine * m_columns;
+            m_lastItem = std::min<int>((lastLine + 1) * m_columns, m_itemCount) - 1;
+        }
+
+        // rows keep their item while it stays visible, the others get recycled
+        const int visibleCount = m_lastItem - m_firstItem + 1;
+        std::vector<int> slots(visibleCount, -1);
+        std::vector<int> freeRows;
+        for(int i = m_rows.size() - 1; i >= 0; --i) {
+            const int item = m_rows[i].item;
+            if(item >= m_firstItem && item <= m_lastItem)
+                slots[item - m_firstItem] = i;
+            else
+                freeRows.push_back(i);
+        }
+
+        const int cellWidth = (area.width() - (m_columns - 1) * m_rowSpacing) / m_columns;
+        for(int slot = 0; slot < visibleCount && !m_destroyed; ++slot) {
+            const int item = m_firstItem + slot;
+            bool fresh = refreshAll;
+            int rowIndex = slots[slot];
+            if(rowIndex < 0) {
+                if(!freeRows.empty()) {
+                    rowIndex = freeRows.back();
+                    freeRows.pop_back();
+                } else {
+                    UIWidgetPtr widget = g_ui.createWidget(m_rowStyle, static_self_cast<UIWidget>());
+                    if(!widget)
+                        break;
+                    m_rows.push_back(Row{ widget, -1 });
+                    rowIndex = m_rows.size() - 1;
+                }
+                fresh = true;
+            }
+
+            const UIWidgetPtr widget = m_rows[rowIndex].widget;
+            m_rows[rowIndex].item = item;
+
+            const int line = item / m_columns;
+            const int column = item % m_columns;
+            widget->setVisible(true);
+            widget->setRect(Rect(area.left() + column * (cellWidth + m_rowSpacing), area.top() + line * pitch - m_scrollOffset, cellWidth, m_rowHeight));
+
+            if(fresh)
+                callLuaField("onItemUpdate", widget, item + 1);
+        }
+
+        for(int rowIndex : freeRows) {
+            m_rows[rowIndex].item = -1;
+            m_rows[rowIndex].widget->setVisible(false);
+        }
+
+        if(m_scrollOffset != m_notifiedScrollOffset || maxOffset != m_notifiedMaxScrollOffset) {
+            m_notifiedScrollOffset = m_scrollOffset;
+            m_notifiedMaxScrollOffset = maxOffset;
+            callLuaField("onScrollChange", m_scrollOffset, maxOffset);
+        }
+
+        refreshAll = false;
+    } while(m_rowsDirty && !m_destroyed);
+    m_updatingRows = false;
+}
+
+void UIVirtualList::clearRows()
+{
+    for(const Row& row : m_rows)
+        row.widget->destroy();
+    m_rows.clear();
+    m_firstItem = 0;
+    m_lastItem = -1;
+}
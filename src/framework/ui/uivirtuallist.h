@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UIVIRTUALLIST_H
+#define UIVIRTUALLIST_H
+
+#include "uiwidget.h"
+
+/// Shows a large number of items while only having widgets for the visible rows.
+/// Rows are created from row-style, recycled when scrolled out, positioned by the list
+/// (row styles must not be anchored) and filled by the lua onItemUpdate(row, index) callback.
+// @bindclass
+class UIVirtualList : public UIWidget
+{
+public:
+    UIVirtualList();
+
+    void setRowStyle(const std::string& rowStyle);
+    void setRowHeight(int height);
+    void setRowSpacing(int spacing);
+    void setColumns(int columns);
+    void setItemCount(int count);
+    void setScrollOffset(int offset);
+    void setScrollStep(int step) { m_scrollStep = step; }
+
+    /// Asks the data source again for every visible item
+    void refresh();
+    /// Asks the data source again for one item, if it is visible
+    void refreshItem(int index);
+    void ensureItemVisible(int index);
+
+    std::string getRowStyle() { return m_rowStyle; }
+    int getRowHeight() { return m_rowHeight; }
+    int getRowSpacing() { return m_rowSpacing; }
+    int getColumns() { return m_columns; }
+    int getItemCount() { return m_itemCount; }
+    int getScrollOffset() { return m_scrollOffset; }
+    int getMaxScrollOffset();
+    int getScrollStep() { return m_scrollStep; }
+    int getFirstVisibleItem() { return m_firstItem + 1; }
+    int getLastVisibleItem() { return m_lastItem + 1; }
+    UIWidgetPtr getItemWidget(int index);
+    int getItemIndex(const UIWidgetPtr& row);
+
+protected:
+    void onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode) override;
+    void onGeometryChange(const Rect& oldRect, const Rect& newRect) override;
+    bool onMouseWheel(const Point& mousePos, Fw::MouseWheelDirection direction) override;
+
+private:
+    struct Row
+    {
+        UIWidgetPtr widget;
+        int item;
+    };
+
+    void updateRows(bool refreshAll = false);
+    void clearRows();
+    int getPitch() { return m_rowHeight + m_rowSpacing; }
+    int getLineCount() { return (m_itemCount + m_columns - 1) / m_columns; }
+
+    std::string m_rowStyle;
+    std::vector<Row> m_rows;
+    int m_rowHeight;
+    int m_rowSpacing;
+    int m_columns;
+    int m_itemCount;
+    int m_scrollOffset;
+    int m_scrollStep;
+    int m_firstItem;
+    int m_lastItem;
+    int m_notifiedScrollOffset;
+    int m_notifiedMaxScrollOffset;
+    bool m_updatingRows;
+    bool m_rowsDirty;
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include "uimanager.h"
 #include "uianchorlayout.h"
 #include "uitranslator.h"
+#include "uistatestyle.h"
 
 #include <framework/core/eventdispatcher.h>
 #include <framework/otml/otmlnode.h>
@@ -57,11 +58,14 @@ UIWidget::~UIWidget()
 
 void UIWidget::draw(const Rect& visibleRect, Fw::DrawPane drawPane)
 {
+    if(m_cacheRender && drawPane == Fw::ForegroundPane && m_rotation == 0.0f && drawCached())
+        return;
+
     g_drawPool.startPosition();
 
     Rect oldClipRect;
     if(m_clipping) {
-        oldClipRect = g_painter->getClipRect();
+        oldClipRect = g_drawPool.getClipRect();
         g_drawPool.setClipRect(visibleRect);
     }
 
@@ -87,6 +91,36 @@ void UIWidget::draw(const Rect& visibleRect, Fw::DrawPane drawPane)
     }
 }
 
+void UIWidget::hashCachedGeometry(size_t& key, const Point& origin)
+{
+    // geometry relative to the cached widget, moving the whole window keeps its rendition
+    for(const UIWidgetPtr& child : m_children) {
+        if(!child->m_visible)
+            continue;
+        boost::hash_combine(key, child->m_rect.x() - origin.x);
+        boost::hash_combine(key, child->m_rect.y() - origin.y);
+        boost::hash_combine(key, child->m_rect.width());
+        boost::hash_combine(key, child->m_rect.height());
+        child->hashCachedGeometry(key, origin);
+    }
+}
+
+bool UIWidget::drawCached()
+{
+    const UIWidgetPtr self = static_self_cast<UIWidget>();
+
+    size_t key = m_cacheVersion;
+    hashCachedGeometry(key, m_rect.topLeft());
+
+    return g_uiRenderCache.draw(m_cacheRendition, m_rect, key, [self](const Rect& rect) {
+        // the subtree draws at its screen position, moved into the cell
+        const Rect& widgetRect = self->getRect();
+        g_drawPool.resetClipRect();
+        g_drawPool.setTranslation(rect.topLeft() - widgetRect.topLeft(), Rect(rect.topLeft(), widgetRect.size()));
+        self->draw(widgetRect, Fw::ForegroundPane);
+    });
+}
+
 void UIWidget::drawSelf(Fw::DrawPane drawPane)
 {
     if((drawPane & Fw::ForegroundPane) == 0)
@@ -155,6 +189,7 @@ void UIWidget::addChild(const UIWidgetPtr& child)
     UIWidgetPtr oldLastChild = getLastChild();
 
     m_children.push_back(child);
+    m_childIndexDirty = true;
     child->setParent(static_self_cast<UIWidget>());
 
     // create default layout
@@ -198,6 +233,7 @@ void UIWidget::insertChild(int index, const UIWidgetPtr& child)
     // retrieve child by index
     const auto it = m_children.begin() + index;
     m_children.insert(it, child);
+    m_childIndexDirty = true;
     child->setParent(static_self_cast<UIWidget>());
 
     // create default layout if needed
@@ -230,6 +266,7 @@ void UIWidget::removeChild(const UIWidgetPtr& child)
 
         const auto it = std::find(m_children.begin(), m_children.end(), child);
         m_children.erase(it);
+        m_childIndexDirty = true;
 
         // reset child parent
         assert(child->getParent() == static_self_cast<UIWidget>());
@@ -387,7 +424,11 @@ void UIWidget::lowerChild(const UIWidgetPtr& child)
 
     m_children.erase(it);
     m_children.push_front(child);
+    m_childIndexDirty = true;
     updateChildrenIndexStates();
+
+    // the stacking order changed
+    child->repaint();
 }
 
 void UIWidget::raiseChild(const UIWidgetPtr& child)
@@ -406,7 +447,11 @@ void UIWidget::raiseChild(const UIWidgetPtr& child)
     }
     m_children.erase(it);
     m_children.push_back(child);
+    m_childIndexDirty = true;
     updateChildrenIndexStates();
+
+    // the stacking order changed
+    child->repaint();
 }
 
 void UIWidget::moveChildToIndex(const UIWidgetPtr& child, int index)
@@ -430,7 +475,11 @@ void UIWidget::moveChildToIndex(const UIWidgetPtr& child, int index)
     }
     m_children.erase(it);
     m_children.insert(m_children.begin() + (index - 1), child);
+    m_childIndexDirty = true;
     updateChildrenIndexStates();
+
+    // the stacking order changed
+    child->repaint();
     updateLayout();
 }
 
@@ -519,6 +568,7 @@ void UIWidget::mergeStyle(const OTMLNodePtr& styleNode)
     m_style->merge(styleNode);
     m_style->setTag(name);
     m_style->setSource(source);
+    m_stateStyles = nullptr;
     updateStyle();
 }
 
@@ -638,7 +688,29 @@ void UIWidget::updateLayout()
     // children can affect the parent layout
     if(UIWidgetPtr parent = getParent())
         if(UILayoutPtr parentLayout = parent->getLayout())
-            parentLayout->updateLater();
+            parentLayout->onChildChange(static_self_cast<UIWidget>());
+}
+
+void UIWidget::repaint()
+{
+    g_app.repaint(m_rect);
+    invalidateRenderCache();
+}
+
+void UIWidget::invalidateRenderCache()
+{
+    for(UIWidget* widget = this; widget; widget = widget->m_parent.get()) {
+        if(widget->m_cacheRender)
+            ++widget->m_cacheVersion;
+    }
+}
+
+void UIWidget::setCacheRender(bool cacheRender)
+{
+    m_cacheRender = cacheRender;
+    if(!cacheRender)
+        g_uiRenderCache.release(m_cacheRendition);
+    repaint();
 }
 
 void UIWidget::lock()
@@ -759,17 +831,50 @@ void UIWidget::internalDestroy()
     m_parent = nullptr;
     m_lockedChildren.clear();
 
-    for(const UIWidgetPtr& child : m_children)
-        child->internalDestroy();
+    for(const UIWidgetPtr& child : m_children) {
+        if(child->m_recycleStyle.empty() || !g_ui.recycleWidget(child))
+            child->internalDestroy();
+    }
     m_children.clear();
+    m_childIndex = nullptr;
 
     callLuaField("onDestroy");
 
     releaseLuaFieldsTable();
+    if(m_recycleFields != -1) {
+        g_lua.unref(m_recycleFields);
+        m_recycleFields = -1;
+    }
+    m_recycleStyle.clear();
+    m_recycleChildren.clear();
+    g_uiRenderCache.release(m_cacheRendition);
 
     g_ui.onWidgetDestroy(static_self_cast<UIWidget>());
 }
 
+void UIWidget::internalRecycle()
+{
+    const UIWidgetPtr self = static_self_cast<UIWidget>();
+    m_destroyed = true;
+    m_parent = nullptr;
+
+    // children added after the creation are destroyed, the ones built from the style are kept
+    UIWidgetList addedChildren;
+    for(const UIWidgetPtr& child : m_children) {
+        if(std::find(m_recycleChildren.begin(), m_recycleChildren.end(), child) == m_recycleChildren.end())
+            addedChildren.push_back(child);
+    }
+    for(const UIWidgetPtr& child : addedChildren)
+        child->destroy();
+
+    callLuaField("onDestroy");
+
+    // back to the fields it had right after the creation
+    restoreLuaFields(m_recycleFields);
+
+    g_ui.onWidgetRecycle(self);
+}
+
 void UIWidget::destroy()
 {
     if(m_destroyed)
@@ -782,6 +887,9 @@ void UIWidget::destroy()
     // remove itself from parent
     if(UIWidgetPtr parent = getParent())
         parent->removeChild(self);
+
+    if(!m_recycleStyle.empty() && g_ui.recycleWidget(self))
+        return;
     internalDestroy();
 }
 
@@ -796,6 +904,7 @@ void UIWidget::destroyChildren()
     while(!m_children.empty()) {
         UIWidgetPtr child = m_children.front();
         m_children.pop_front();
+        m_childIndexDirty = true;
         child->setParent(nullptr);
         m_layout->removeWidget(child);
         child->destroy();
@@ -881,6 +990,10 @@ bool UIWidget::setRect(const Rect& rect)
 
     m_rect = rect;
 
+    // the parent hit test index has the old rect
+    if(m_parent)
+        m_parent->m_childIndexDirty = true;
+
     // updates own layout
     updateLayout();
 
@@ -912,6 +1025,7 @@ void UIWidget::setStyle(const std::string& styleName)
     styleNode = styleNode->clone();
     applyStyle(styleNode);
     m_style = styleNode;
+    m_stateStyles = nullptr;
     updateStyle();
 }
 
@@ -919,6 +1033,7 @@ void UIWidget::setStyleFromNode(const OTMLNodePtr& styleNode)
 {
     applyStyle(styleNode);
     m_style = styleNode;
+    m_stateStyles = nullptr;
     updateStyle();
 }
 
@@ -948,6 +1063,7 @@ void UIWidget::setVisible(bool visible)
 
         updateState(Fw::ActiveState);
         updateState(Fw::HiddenState);
+        repaint();
 
         // visibility can change the current hovered widget
         if(visible)
@@ -1015,6 +1131,8 @@ void UIWidget::setVirtualOffset(const Point& offset)
     m_virtualOffset = offset;
     if(m_layout)
         m_layout->update();
+
+    repaint();
 }
 
 bool UIWidget::isAnchored()
@@ -1138,8 +1256,10 @@ UIWidgetPtr UIWidget::getChildByPos(const Point& childPos)
     if(!containsPaddingPoint(childPos))
         return nullptr;
 
-    for(auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-        const UIWidgetPtr& child = (*it);
+    const std::vector<uint>* candidates = getChildCandidates(childPos);
+    const int count = candidates ? candidates->size() : m_children.size();
+    for(int i = count - 1; i >= 0; --i) {
+        const UIWidgetPtr& child = m_children[candidates ? (*candidates)[i] : i];
         if(child->isExplicitlyVisible() && child->containsPoint(childPos))
             return child;
     }
@@ -1173,8 +1293,10 @@ UIWidgetPtr UIWidget::recursiveGetChildByPos(const Point& childPos, bool wantsPh
     if(!containsPaddingPoint(childPos))
         return nullptr;
 
-    for(auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-        const UIWidgetPtr& child = (*it);
+    const std::vector<uint>* candidates = getChildCandidates(childPos);
+    const int count = candidates ? candidates->size() : m_children.size();
+    for(int i = count - 1; i >= 0; --i) {
+        const UIWidgetPtr& child = m_children[candidates ? (*candidates)[i] : i];
         if(child->isExplicitlyVisible() && child->containsPoint(childPos)) {
             UIWidgetPtr subChild = child->recursiveGetChildByPos(childPos, wantsPhantom);
             if(subChild)
@@ -1186,6 +1308,27 @@ UIWidgetPtr UIWidget::recursiveGetChildByPos(const Point& childPos, bool wantsPh
     return nullptr;
 }
 
+const std::vector<uint>* UIWidget::getChildCandidates(const Point& point)
+{
+    // few children are faster to test one by one
+    if(m_children.size() < UIChildIndex::MIN_CHILDREN) {
+        m_childIndex = nullptr;
+        return nullptr;
+    }
+
+    if(!m_childIndex) {
+        m_childIndex.reset(new UIChildIndex);
+        m_childIndexDirty = true;
+    }
+
+    if(m_childIndexDirty) {
+        m_childIndex->build(m_children);
+        m_childIndexDirty = false;
+    }
+
+    return &m_childIndex->query(point);
+}
+
 UIWidgetList UIWidget::recursiveGetChildren()
 {
     UIWidgetList children;
@@ -1204,8 +1347,10 @@ UIWidgetList UIWidget::recursiveGetChildrenByPos(const Point& childPos)
     if(!containsPaddingPoint(childPos))
         return children;
 
-    for(auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-        const UIWidgetPtr& child = (*it);
+    const std::vector<uint>* candidates = getChildCandidates(childPos);
+    const int count = candidates ? candidates->size() : m_children.size();
+    for(int i = count - 1; i >= 0; --i) {
+        const UIWidgetPtr& child = m_children[candidates ? (*candidates)[i] : i];
         if(child->isExplicitlyVisible() && child->containsPoint(childPos)) {
             UIWidgetList subChildren = child->recursiveGetChildrenByPos(childPos);
             if(!subChildren.empty())
@@ -1406,6 +1551,20 @@ void UIWidget::updateChildrenIndexStates()
     }
 }
 
+// ! properties are renamed when applied, the default style holds them without the prefix
+static std::string propertyTag(const OTMLNodePtr& node)
+{
+    const std::string& tag = node->tag();
+    return stdext::starts_with(tag, "!") ? tag.substr(1) : tag;
+}
+
+static bool isSameProperty(const OTMLNodePtr& a, const OTMLNodePtr& b)
+{
+    if(a == b)
+        return true;
+    return a->size() == 0 && b->size() == 0 && a->rawValue() == b->rawValue() && a->isUnique() == b->isUnique();
+}
+
 void UIWidget::updateStyle()
 {
     if(m_destroyed)
@@ -1424,46 +1583,41 @@ void UIWidget::updateStyle()
     if(!m_style)
         return;
 
-    OTMLNodePtr newStateStyle = OTMLNode::create();
+    // a new style was just applied over the previous state properties, they all need to go again
+    const bool styleChanged = !m_stateStyles;
+    if(styleChanged)
+        m_stateStyles = g_ui.getStateStyle(m_style);
+
+    const OTMLNodePtr newStateStyle = m_stateStyles->resolve(m_states);
+    if(!styleChanged && newStateStyle == m_stateStyle)
+        return;
 
-    // copy only the changed styles from default style
+    OTMLNodePtr changes = OTMLNode::create();
+
+    // properties from the previous states that are gone return to the default style
     if(m_stateStyle) {
         for(const OTMLNodePtr& node : m_stateStyle->children()) {
-            if(OTMLNodePtr otherNode = m_style->get(node->tag()))
-                newStateStyle->addChild(otherNode->clone());
+            if(newStateStyle->get(node->tag()))
+                continue;
+            if(OTMLNodePtr otherNode = m_style->get(propertyTag(node)))
+                changes->addChild(otherNode->clone());
         }
     }
 
-    // checks for states combination
-    for(const OTMLNodePtr& style : m_style->children()) {
-        if(stdext::starts_with(style->tag(), "$")) {
-            std::string statesStr = style->tag().substr(1);
-            std::vector<std::string> statesSplit = stdext::split(statesStr, " ");
-
-            bool match = true;
-            for(std::string stateStr : statesSplit) {
-                if(stateStr.length() == 0)
-                    continue;
-
-                const bool notstate = (stateStr[0] == '!');
-                if(notstate)
-                    stateStr = stateStr.substr(1);
-
-                const bool stateOn = hasState(Fw::translateState(stateStr));
-                if((!notstate && !stateOn) || (notstate && stateOn))
-                    match = false;
-            }
-
-            // merge states styles
-            if(match) {
-                newStateStyle->merge(style);
-            }
+    // only properties that differ from the ones already applied
+    for(const OTMLNodePtr& node : newStateStyle->children()) {
+        if(!styleChanged && m_stateStyle) {
+            OTMLNodePtr oldNode = m_stateStyle->get(node->tag());
+            if(oldNode && isSameProperty(oldNode, node))
+                continue;
         }
+        changes->addChild(node->clone());
     }
 
-    //TODO: prevent setting already set proprieties
-
-    applyStyle(newStateStyle);
+    // resolved nodes are shared between widgets, applyStyle only ever sees the copies
+    changes->setTag(newStateStyle->tag());
+    changes->setSource(newStateStyle->source());
+    applyStyle(changes);
     m_stateStyle = newStateStyle;
 }
 
@@ -1480,7 +1634,7 @@ void UIWidget::onStyleApply(const std::string&, const OTMLNodePtr& styleNode)
     parseImageStyle(styleNode);
     parseTextStyle(styleNode);
 
-    g_app.repaint();
+    repaint();
 }
 
 void UIWidget::onGeometryChange(const Rect& oldRect, const Rect& newRect)
@@ -1496,7 +1650,8 @@ void UIWidget::onGeometryChange(const Rect& oldRect, const Rect& newRect)
 
     callLuaField("onGeometryChange", oldRect, newRect);
 
-    g_app.repaint();
+    g_app.repaint(oldRect);
+    g_app.repaint(newRect);
 }
 
 void UIWidget::onLayoutUpdate()
@@ -1700,8 +1855,10 @@ bool UIWidget::propagateOnMouseEvent(const Point& mousePos, UIWidgetList& widget
 {
     bool ret = false;
     if(containsPaddingPoint(mousePos)) {
-        for(auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-            const UIWidgetPtr& child = *it;
+        const std::vector<uint>* candidates = getChildCandidates(mousePos);
+        const int count = candidates ? candidates->size() : m_children.size();
+        for(int i = count - 1; i >= 0; --i) {
+            const UIWidgetPtr& child = m_children[candidates ? (*candidates)[i] : i];
             if(child->isExplicitlyEnabled() && child->isExplicitlyVisible() && child->containsPoint(mousePos)) {
                 if(child->propagateOnMouseEvent(mousePos, widgetList)) {
                     ret = true;
@@ -1720,13 +1877,16 @@ bool UIWidget::propagateOnMouseEvent(const Point& mousePos, UIWidgetList& widget
 
 bool UIWidget::propagateOnMouseMove(const Point& mousePos, const Point& mouseMoved, UIWidgetList& widgetList)
 {
-    if(containsPaddingPoint(mousePos)) {
-        for(auto& child : m_children) {
+    if(containsPaddingPoint(mousePos) && !m_children.empty()) {
+        const std::vector<uint>* candidates = getChildCandidates(mousePos);
+        const int count = candidates ? candidates->size() : m_children.size();
+        for(int i = 0; i < count; ++i) {
+            const UIWidgetPtr& child = m_children[candidates ? (*candidates)[i] : i];
             if(child->isExplicitlyVisible() && child->isExplicitlyEnabled() && child->containsPoint(mousePos))
                 child->propagateOnMouseMove(mousePos, mouseMoved, widgetList);
-
-            widgetList.push_back(static_self_cast<UIWidget>());
         }
+
+        widgetList.push_back(static_self_cast<UIWidget>());
     }
 
     return true;
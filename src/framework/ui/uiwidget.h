@@ -25,6 +25,8 @@
 
 #include "declarations.h"
 #include "uilayout.h"
+#include "uichildindex.h"
+#include "uirendercache.h"
 
 #include <framework/luaengine/luaobject.h>
 #include <framework/graphics/declarations.h>
@@ -33,6 +35,7 @@
 #include <framework/core/timer.h>
 
 #include "framework/stdext/math.h"
+#include <framework/core/stats.h>
 
 template<typename T = int>
 struct EdgeGroup {
@@ -45,7 +48,7 @@ struct EdgeGroup {
 };
 
 // @bindclass
-class UIWidget : public LuaObject
+class UIWidget : public LuaObject, private StatsCounted<UIWidget>
 {
     // widget core
 public:
@@ -76,6 +79,9 @@ protected:
     UIWidgetList m_lockedChildren;
     UIWidgetPtr m_focusedChild;
     OTMLNodePtr m_style;
+    bool m_cacheRender{ false };
+    uint32 m_cacheVersion{ 0 };
+    UIRenderCache::Rendition m_cacheRendition;
     Timer m_clickTimer;
     Fw::FocusReason m_lastFocusReason;
     Fw::AutoFocusPolicy m_autoFocusPolicy;
@@ -101,6 +107,8 @@ public:
     void breakAnchors();
     void updateParentLayout();
     void updateLayout();
+    // marks the widget area as dirty in the foreground pane
+    void repaint();
     void lock();
     void unlock();
     void focus();
@@ -129,7 +137,9 @@ public:
     void setPhantom(bool phantom);
     void setDraggable(bool draggable);
     void setFixedSize(bool fixed);
-    void setClipping(bool clipping) { m_clipping = clipping; }
+    void setClipping(bool clipping) { m_clipping = clipping; repaint(); }
+    /// Records the widget and its children once into the render cache and draws them as a single quad until any of them repaints
+    void setCacheRender(bool cacheRender);
     void setLastFocusReason(Fw::FocusReason reason);
     void setAutoFocusPolicy(Fw::AutoFocusPolicy policy);
     void setAutoRepeatDelay(int delay) { m_autoRepeatDelay = delay; }
@@ -157,8 +167,17 @@ public:
     UIWidgetPtr backwardsGetWidgetById(const std::string& id);
 
 private:
+    const std::vector<uint>* getChildCandidates(const Point& point);
+
     bool m_updateEventScheduled{ false },
-        m_loadingStyle{ false };
+        m_loadingStyle{ false },
+        m_childIndexDirty{ true };
+    std::unique_ptr<UIChildIndex> m_childIndex;
+
+    // set when the widget goes back to the pool of its style once destroyed
+    std::string m_recycleStyle;
+    UIWidgetList m_recycleChildren;
+    int m_recycleFields{ -1 };
 
     // state managment
 protected:
@@ -167,6 +186,10 @@ protected:
 
 private:
     void internalDestroy();
+    void internalRecycle();
+    bool drawCached();
+    void hashCachedGeometry(size_t& key, const Point& origin);
+    void invalidateRenderCache();
     void updateState(Fw::WidgetState state);
     void updateStates();
     void updateChildrenIndexStates();
@@ -175,6 +198,7 @@ private:
     bool m_updateStyleScheduled{ false };
     bool m_firstOnStyle{ true };
     OTMLNodePtr m_stateStyle;
+    UIStateStylePtr m_stateStyles;
     int m_states;
 
     // event processing
@@ -242,6 +266,7 @@ public:
     bool isDraggable() { return m_draggable; }
     bool isFixedSize() { return m_fixedSize; }
     bool isClipping() { return m_clipping; }
+    bool isCacheRender() { return m_cacheRender; }
     bool isDestroyed() { return m_destroyed; }
 
     bool hasChildren() { return !m_children.empty(); }
@@ -299,36 +324,36 @@ public:
     void setHeight(int height) { resize(getWidth(), height); }
     void setSize(const Size& size) { resize(size.width(), size.height()); }
     void setPosition(const Point& pos) { move(pos.x, pos.y); }
-    void setColor(const Color& color) { m_color = color; }
-    void setBackgroundColor(const Color& color) { m_backgroundColor = color; }
-    void setBackgroundOffsetX(int x) { m_backgroundRect.setX(x); }
-    void setBackgroundOffsetY(int y) { m_backgroundRect.setX(y); }
-    void setBackgroundOffset(const Point& pos) { m_backgroundRect.move(pos); }
-    void setBackgroundWidth(int width) { m_backgroundRect.setWidth(width); }
-    void setBackgroundHeight(int height) { m_backgroundRect.setHeight(height); }
-    void setBackgroundSize(const Size& size) { m_backgroundRect.resize(size); }
-    void setBackgroundRect(const Rect& rect) { m_backgroundRect = rect; }
+    void setColor(const Color& color) { m_color = color; repaint(); }
+    void setBackgroundColor(const Color& color) { m_backgroundColor = color; repaint(); }
+    void setBackgroundOffsetX(int x) { m_backgroundRect.setX(x); repaint(); }
+    void setBackgroundOffsetY(int y) { m_backgroundRect.setX(y); repaint(); }
+    void setBackgroundOffset(const Point& pos) { m_backgroundRect.move(pos); repaint(); }
+    void setBackgroundWidth(int width) { m_backgroundRect.setWidth(width); repaint(); }
+    void setBackgroundHeight(int height) { m_backgroundRect.setHeight(height); repaint(); }
+    void setBackgroundSize(const Size& size) { m_backgroundRect.resize(size); repaint(); }
+    void setBackgroundRect(const Rect& rect) { m_backgroundRect = rect; repaint(); }
     void setIcon(const std::string& iconFile);
-    void setIconColor(const Color& color) { m_iconColor = color; }
-    void setIconOffsetX(int x) { m_iconOffset.x = x; }
-    void setIconOffsetY(int y) { m_iconOffset.y = y; }
-    void setIconOffset(const Point& pos) { m_iconOffset = pos; }
-    void setIconWidth(int width) { m_iconRect.setWidth(width); }
-    void setIconHeight(int height) { m_iconRect.setHeight(height); }
-    void setIconSize(const Size& size) { m_iconRect.resize(size); }
-    void setIconRect(const Rect& rect) { m_iconRect = rect; }
-    void setIconClip(const Rect& rect) { m_iconClipRect = rect; }
-    void setIconAlign(Fw::AlignmentFlag align) { m_iconAlign = align; }
-    void setBorderWidth(int width) { m_borderWidth.set(width); updateLayout(); }
-    void setBorderWidthTop(int width) { m_borderWidth.top = width; }
-    void setBorderWidthRight(int width) { m_borderWidth.right = width; }
-    void setBorderWidthBottom(int width) { m_borderWidth.bottom = width; }
-    void setBorderWidthLeft(int width) { m_borderWidth.left = width; }
-    void setBorderColor(const Color& color) { m_borderColor.set(color); updateLayout(); }
-    void setBorderColorTop(const Color& color) { m_borderColor.top = color; }
-    void setBorderColorRight(const Color& color) { m_borderColor.right = color; }
-    void setBorderColorBottom(const Color& color) { m_borderColor.bottom = color; }
-    void setBorderColorLeft(const Color& color) { m_borderColor.left = color; }
+    void setIconColor(const Color& color) { m_iconColor = color; repaint(); }
+    void setIconOffsetX(int x) { m_iconOffset.x = x; repaint(); }
+    void setIconOffsetY(int y) { m_iconOffset.y = y; repaint(); }
+    void setIconOffset(const Point& pos) { m_iconOffset = pos; repaint(); }
+    void setIconWidth(int width) { m_iconRect.setWidth(width); repaint(); }
+    void setIconHeight(int height) { m_iconRect.setHeight(height); repaint(); }
+    void setIconSize(const Size& size) { m_iconRect.resize(size); repaint(); }
+    void setIconRect(const Rect& rect) { m_iconRect = rect; repaint(); }
+    void setIconClip(const Rect& rect) { m_iconClipRect = rect; repaint(); }
+    void setIconAlign(Fw::AlignmentFlag align) { m_iconAlign = align; repaint(); }
+    void setBorderWidth(int width) { m_borderWidth.set(width); updateLayout(); repaint(); }
+    void setBorderWidthTop(int width) { m_borderWidth.top = width; repaint(); }
+    void setBorderWidthRight(int width) { m_borderWidth.right = width; repaint(); }
+    void setBorderWidthBottom(int width) { m_borderWidth.bottom = width; repaint(); }
+    void setBorderWidthLeft(int width) { m_borderWidth.left = width; repaint(); }
+    void setBorderColor(const Color& color) { m_borderColor.set(color); updateLayout(); repaint(); }
+    void setBorderColorTop(const Color& color) { m_borderColor.top = color; repaint(); }
+    void setBorderColorRight(const Color& color) { m_borderColor.right = color; repaint(); }
+    void setBorderColorBottom(const Color& color) { m_borderColor.bottom = color; repaint(); }
+    void setBorderColorLeft(const Color& color) { m_borderColor.left = color; repaint(); }
     void setMargin(int margin) { m_margin.set(margin); updateParentLayout(); }
     void setMarginHorizontal(int margin) { m_margin.right = m_margin.left = margin; updateParentLayout(); }
     void setMarginVertical(int margin) { m_margin.bottom = m_margin.top = margin; updateParentLayout(); }
@@ -343,8 +368,8 @@ public:
     void setPaddingRight(int padding) { m_padding.right = padding; updateLayout(); }
     void setPaddingBottom(int padding) { m_padding.bottom = padding; updateLayout(); }
     void setPaddingLeft(int padding) { m_padding.left = padding; updateLayout(); }
-    void setOpacity(float opacity) { m_opacity = stdext::clamp<float>(opacity, 0.0f, 1.0f); }
-    void setRotation(float degrees) { m_rotation = degrees; }
+    void setOpacity(float opacity) { m_opacity = stdext::clamp<float>(opacity, 0.0f, 1.0f); repaint(); }
+    void setRotation(float degrees) { m_rotation = degrees; repaint(); }
 
     int getX() { return m_rect.x(); }
     int getY() { return m_rect.y(); }
@@ -396,7 +421,7 @@ private:
     void initImage();
     void parseImageStyle(const OTMLNodePtr& styleNode);
 
-    void updateImageCache() { m_imageMustRecache = true; }
+    void updateImageCache() { m_imageMustRecache = true; repaint(); }
     void configureBorderImage() { m_imageBordered = true; updateImageCache(); }
 
     std::vector<std::pair<Rect, Rect>> m_imageCoordsCache;
@@ -431,7 +456,7 @@ public:
     void setImageColor(const Color& color) { m_imageColor = color; updateImageCache(); }
     void setImageFixedRatio(bool fixedRatio) { m_imageFixedRatio = fixedRatio; updateImageCache(); }
     void setImageRepeated(bool repeated) { m_imageRepeated = repeated; updateImageCache(); }
-    void setImageSmooth(bool smooth) { m_imageSmooth = smooth; }
+    void setImageSmooth(bool smooth) { m_imageSmooth = smooth; repaint(); }
     void setImageAutoResize(bool autoResize) { m_imageAutoResize = autoResize; }
     void setImageBorderTop(int border) { m_imageBorder.top = border; configureBorderImage(); }
     void setImageBorderRight(int border) { m_imageBorder.right = border; configureBorderImage(); }
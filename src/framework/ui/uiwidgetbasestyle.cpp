@@ -153,6 +153,8 @@ void UIWidget::parseBaseStyle(const OTMLNodePtr& styleNode)
             setFixedSize(node->value<bool>());
         else if(node->tag() == "clipping")
             setClipping(node->value<bool>());
+        else if(node->tag() == "cache-render")
+            setCacheRender(node->value<bool>());
         else if(node->tag() == "border") {
             auto split = stdext::split(node->value(), " ");
             if(split.size() == 2) {
@@ -384,6 +386,9 @@ void UIWidget::drawIcon(const Rect& screenCoords)
         }
         drawRect.translate(m_iconOffset);
         g_drawPool.addTexturedRect(drawRect, m_icon, m_iconClipRect, m_iconColor);
+
+        if(m_icon->isAnimatedTexture())
+            repaint();
     }
 }
 
@@ -395,4 +400,6 @@ void UIWidget::setIcon(const std::string& iconFile)
         m_icon = g_textures.getTexture(iconFile);
     if(m_icon && !m_iconClipRect.isValid())
         m_iconClipRect = Rect(0, 0, m_icon->getSize());
+
+    repaint();
 }
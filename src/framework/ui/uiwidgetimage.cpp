@@ -77,6 +77,10 @@ void UIWidget::drawImage(const Rect& screenCoords)
     if(!m_imageTexture || !screenCoords.isValid())
         return;
 
+    // animated images keep their area dirty
+    if(m_imageTexture->isAnimatedTexture())
+        repaint();
+
     // cache vertex buffers
     if(m_imageCachedScreenCoords != screenCoords || m_imageMustRecache) {
         m_imageCoordsCache.clear();
@@ -191,5 +195,5 @@ void UIWidget::setImageSource(const std::string& source)
         setSize(size);
     }
 
-    m_imageMustRecache = true;
+    updateImageCache();
 }
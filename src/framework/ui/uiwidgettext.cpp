@@ -54,6 +54,7 @@ void UIWidget::updateText()
     }
 
     m_textMustRecache = true;
+    repaint();
 }
 
 void UIWidget::parseTextStyle(const OTMLNodePtr& styleNode)
@@ -102,7 +103,7 @@ void UIWidget::drawText(const Rect& screenCoords)
 
 void UIWidget::onTextChange(const std::string& text, const std::string& oldText)
 {
-    g_app.repaint();
+    repaint();
     callLuaField("onTextChange", text, oldText);
 }
 
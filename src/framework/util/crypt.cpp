@@ -32,14 +32,138 @@
 
 #include <boost/functional/hash.hpp>
 
+#include <random>
+
 #ifndef USE_GMP
 #include <openssl/rsa.h>
 #include <openssl/bn.h>
 #include <openssl/err.h>
 #endif
 
-static const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-static inline bool is_base64(unsigned char c) { return (isalnum(c) || (c == '+') || (c == '/')); }
+static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// 12 input bits map to two output characters at once, characters map back to their 6 bits
+struct Base64Tables {
+    char encode[4096][2];
+    uint8 decode[256]; // 0xff for characters outside the alphabet
+
+    Base64Tables() {
+        for(int i = 0; i < 4096; ++i) {
+            encode[i][0] = base64_chars[i >> 6];
+            encode[i][1] = base64_chars[i & 0x3f];
+        }
+        memset(decode, 0xff, sizeof(decode));
+        for(int i = 0; i < 64; ++i)
+            decode[static_cast<uint8>(base64_chars[i])] = i;
+    }
+};
+
+static const Base64Tables& base64Tables()
+{
+    static const Base64Tables tables;
+    return tables;
+}
+
+static const uint32 sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32 sha256_rotr(uint32 x, int n) { return (x >> n) | (x << (32 - n)); }
+
+Sha256::Sha256()
+{
+    static const uint32 initial[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    memcpy(m_state, initial, sizeof(m_state));
+    m_blockSize = 0;
+    m_totalSize = 0;
+}
+
+void Sha256::transform(const uint8* block)
+{
+    uint32 w[64];
+    for(int i = 0; i < 16; ++i)
+        w[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) | (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    for(int i = 16; i < 64; ++i) {
+        const uint32 s0 = sha256_rotr(w[i - 15], 7) ^ sha256_rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32 s1 = sha256_rotr(w[i - 2], 17) ^ sha256_rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32 a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3],
+        e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+    for(int i = 0; i < 64; ++i) {
+        const uint32 t1 = h + (sha256_rotr(e, 6) ^ sha256_rotr(e, 11) ^ sha256_rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        const uint32 t2 = (sha256_rotr(a, 2) ^ sha256_rotr(a, 13) ^ sha256_rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
+    m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+}
+
+void Sha256::update(const uint8* data, size_t size)
+{
+    m_totalSize += size;
+    while(size > 0) {
+        const size_t count = std::min<size_t>(size, 64 - m_blockSize);
+        memcpy(m_block + m_blockSize, data, count);
+        m_blockSize += count;
+        data += count;
+        size -= count;
+        if(m_blockSize == 64) {
+            transform(m_block);
+            m_blockSize = 0;
+        }
+    }
+}
+
+std::string Sha256::finish()
+{
+    // a single 1 bit, zeros up to 56 bytes of the last block and the length in bits
+    const uint64 bits = m_totalSize * 8;
+    uint8 padding[72] = { 0x80 };
+    const size_t paddingSize = (m_blockSize < 56 ? 56 : 120) - m_blockSize;
+    for(int i = 0; i < 8; ++i)
+        padding[paddingSize + i] = static_cast<uint8>(bits >> (56 - i * 8));
+    update(padding, paddingSize + 8);
+
+    static const char hex[] = "0123456789abcdef";
+    std::string digest(64, '0');
+    for(int i = 0; i < 32; ++i) {
+        const uint8 byte = static_cast<uint8>(m_state[i / 4] >> (24 - (i % 4) * 8));
+        digest[i * 2] = hex[byte >> 4];
+        digest[i * 2 + 1] = hex[byte & 0xf];
+    }
+
+    *this = Sha256();
+    return digest;
+}
+
+#ifndef USE_GMP
+static void rsaGetPublicKey(RSA* rsa, const BIGNUM*& n, const BIGNUM*& e)
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100005L
+    n = rsa->n;
+    e = rsa->e;
+#else
+    RSA_get0_key(rsa, &n, &e, nullptr);
+#endif
+}
+#endif
 
 Crypt g_crypt;
 
@@ -53,6 +177,8 @@ Crypt::Crypt()
     mpz_init(m_n);
 #else
     m_rsa = RSA_new();
+    m_bnCtx = BN_CTX_new();
+    m_montN = nullptr;
 #endif
 }
 
@@ -65,48 +191,36 @@ Crypt::~Crypt()
     mpz_clear(m_d);
     mpz_clear(m_e);
 #else
+    if(m_montN)
+        BN_MONT_CTX_free(m_montN);
+    BN_CTX_free(m_bnCtx);
     RSA_free(m_rsa);
 #endif
 }
 
 std::string Crypt::base64Encode(const std::string& decoded_string)
 {
-    std::string ret;
-    int i = 0;
-    int j = 0;
-    uint8 char_array_3[3];
-    uint8 char_array_4[4];
-    int pos = 0;
-    int len = decoded_string.size();
-
-    while(len--) {
-        char_array_3[i++] = decoded_string[pos++];
-        if(i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for(i = 0; (i < 4); i++)
-                ret += base64_chars[char_array_4[i]];
-            i = 0;
-        }
+    const Base64Tables& tables = base64Tables();
+    const auto* in = reinterpret_cast<const uint8*>(decoded_string.data());
+    const size_t len = decoded_string.size();
+
+    std::string ret((len + 2) / 3 * 4, '=');
+    char* out = &ret[0];
+
+    size_t i = 0;
+    for(; i + 3 <= len; i += 3, out += 4) {
+        const uint32 bits = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        memcpy(out, tables.encode[bits >> 12], 2);
+        memcpy(out + 2, tables.encode[bits & 0xfff], 2);
     }
 
-    if(i) {
-        for(j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
-
-        for(j = 0; (j < i + 1); j++)
-            ret += base64_chars[char_array_4[j]];
-
-        while((i++ < 3))
-            ret += '=';
+    // one or two bytes left, the rest of the group stays '='
+    if(i < len) {
+        const bool twoBytes = i + 1 < len;
+        const uint32 bits = (in[i] << 16) | (twoBytes ? in[i + 1] << 8 : 0);
+        memcpy(out, tables.encode[bits >> 12], 2);
+        if(twoBytes)
+            out[2] = base64_chars[(bits >> 6) & 0x3f];
     }
 
     return ret;
@@ -114,44 +228,40 @@ std::string Crypt::base64Encode(const std::string& decoded_string)
 
 std::string Crypt::base64Decode(const std::string& encoded_string)
 {
-    int len = encoded_string.size();
-    int i = 0;
-    int j = 0;
-    int in_ = 0;
-    uint8 char_array_4[4], char_array_3[3];
-    std::string ret;
-
-    while(len-- && (encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-        char_array_4[i++] = encoded_string[in_]; in_++;
-        if(i == 4) {
-            for(i = 0; i < 4; i++)
-                char_array_4[i] = base64_chars.find(char_array_4[i]);
-
-            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-            for(i = 0; (i < 3); i++)
-                ret += char_array_3[i];
-            i = 0;
-        }
+    const Base64Tables& tables = base64Tables();
+    const auto* in = reinterpret_cast<const uint8*>(encoded_string.data());
+    const size_t len = encoded_string.size();
+
+    std::string ret(len / 4 * 3 + 3, '\0');
+    auto* out = reinterpret_cast<uint8*>(&ret[0]);
+
+    // decoding stops at the padding or at the first character outside the alphabet
+    size_t i = 0;
+    for(; i + 4 <= len; i += 4, out += 3) {
+        const uint8 a = tables.decode[in[i]], b = tables.decode[in[i + 1]], c = tables.decode[in[i + 2]], d = tables.decode[in[i + 3]];
+        if((a | b | c | d) & 0x80)
+            break;
+
+        const uint32 bits = (a << 18) | (b << 12) | (c << 6) | d;
+        out[0] = bits >> 16;
+        out[1] = bits >> 8;
+        out[2] = bits;
     }
 
-    if(i) {
-        for(j = i; j < 4; j++)
-            char_array_4[j] = 0;
-
-        for(j = 0; j < 4; j++)
-            char_array_4[j] = base64_chars.find(char_array_4[j]);
-
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-        for(j = 0; (j < i - 1); j++)
-            ret += char_array_3[j];
+    uint32 bits = 0;
+    int count = 0;
+    for(; i < len && tables.decode[in[i]] != 0xff; ++i, ++count)
+        bits = (bits << 6) | tables.decode[in[i]];
+
+    // a group of n characters holds n - 1 bytes
+    if(count > 1) {
+        bits <<= 6 * (4 - count);
+        *out++ = bits >> 16;
+        if(count > 2)
+            *out++ = bits >> 8;
     }
 
+    ret.resize(out - reinterpret_cast<uint8*>(&ret[0]));
     return ret;
 }
 
@@ -168,6 +278,13 @@ std::string Crypt::xorCrypt(const std::string& buffer, const std::string& key)
     return out;
 }
 
+std::string Crypt::sha256(const std::string& data)
+{
+    Sha256 hash;
+    hash.update(reinterpret_cast<const uint8*>(data.data()), data.size());
+    return hash.finish();
+}
+
 std::string Crypt::genUUID()
 {
     boost::uuids::random_generator gen;
@@ -256,6 +373,17 @@ void Crypt::rsaSetPublicKey(const std::string& n, const std::string& e)
     BN_dec2bn(&be, e.c_str());
     RSA_set0_key(m_rsa, bn, be, nullptr);
 #endif
+
+    // every encryption reuses the Montgomery form of n instead of rebuilding it
+    if(m_montN)
+        BN_MONT_CTX_free(m_montN);
+    const BIGNUM* rsaN = nullptr, * rsaE = nullptr;
+    rsaGetPublicKey(m_rsa, rsaN, rsaE);
+    m_montN = BN_MONT_CTX_new();
+    if(!rsaN || !BN_MONT_CTX_set(m_montN, rsaN, m_bnCtx)) {
+        BN_MONT_CTX_free(m_montN);
+        m_montN = nullptr;
+    }
 #endif
 }
 
@@ -267,7 +395,7 @@ void Crypt::rsaSetPrivateKey(const std::string& p, const std::string& q, const s
     mpz_set_str(m_d, d.c_str(), 10);
 
     // n = p * q
-    mpz_mul(n, p, q);
+    mpz_mul(m_n, m_p, m_q);
 #else
 #if OPENSSL_VERSION_NUMBER < 0x10100005L
     BN_dec2bn(&m_rsa->p, p.c_str());
@@ -304,10 +432,13 @@ bool Crypt::rsaEncrypt(unsigned char* msg, int size)
     mpz_init(m);
     mpz_import(m, size, 1, 1, 0, 0, msg);
 
-    // c = m^e mod n
-    mpz_powm(c, m, m_e, m_n);
+    // c = m^e mod n, public exponents are small and a plain square and multiply beats the windowed powm
+    if(mpz_fits_ulong_p(m_e))
+        mpz_powm_ui(c, m, mpz_get_ui(m_e), m_n);
+    else
+        mpz_powm(c, m, m_e, m_n);
 
-    size_t count = (mpz_sizeinbase(m, 2) + 7) / 8;
+    size_t count = (mpz_sizeinbase(c, 2) + 7) / 8;
     memset((char*)msg, 0, size - count);
     mpz_export((char*)msg + (size - count), nullptr, 1, 1, 0, 0, c);
 
@@ -316,7 +447,23 @@ bool Crypt::rsaEncrypt(unsigned char* msg, int size)
 
     return true;
 #else
-    return RSA_public_encrypt(size, msg, msg, m_rsa, RSA_NO_PADDING) != -1;
+    if(!m_montN)
+        return RSA_public_encrypt(size, msg, msg, m_rsa, RSA_NO_PADDING) != -1;
+
+    const BIGNUM* n = nullptr, * e = nullptr;
+    rsaGetPublicKey(m_rsa, n, e);
+
+    BN_CTX_start(m_bnCtx);
+    BIGNUM* m = BN_CTX_get(m_bnCtx);
+    BIGNUM* c = BN_CTX_get(m_bnCtx);
+    const bool ret = c && BN_bin2bn(msg, size, m) && BN_ucmp(m, n) < 0 && BN_mod_exp_mont(c, m, e, n, m_bnCtx, m_montN);
+    if(ret) {
+        const int count = BN_num_bytes(c);
+        memset(msg, 0, size - count);
+        BN_bn2bin(c, msg + (size - count));
+    }
+    BN_CTX_end(m_bnCtx);
+    return ret;
 #endif
 }
 
@@ -356,3 +503,74 @@ int Crypt::rsaGetSize()
     return RSA_size(m_rsa);
 #endif
 }
+
+std::tuple<double, double> Crypt::benchmarkBase64(int size)
+{
+    size = std::max<int>(1, size);
+    const int iterations = std::max<int>(1, (64 * 1024 * 1024) / size);
+
+    std::string blob(size, '\0');
+    std::mt19937 gen(size);
+    std::generate(blob.begin(), blob.end(), [&]() { return static_cast<char>(gen()); });
+
+    std::string encoded, decoded;
+    stdext::timer timer;
+    for(int i = 0; i < iterations; ++i)
+        encoded = base64Encode(blob);
+    const ticks_t encodeElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+    timer.restart();
+    for(int i = 0; i < iterations; ++i)
+        decoded = base64Decode(encoded);
+    const ticks_t decodeElapsed = std::max<ticks_t>(1, timer.elapsed_micros());
+
+    const double megabytes = static_cast<double>(size) * iterations / (1024 * 1024);
+    const double encodeSpeed = megabytes * 1000000.0 / encodeElapsed;
+    const double decodeSpeed = megabytes * 1000000.0 / decodeElapsed;
+    g_logger.info(stdext::format("base64 with %d byte blobs: encode %.1f MB/s, decode %.1f MB/s", size, encodeSpeed, decodeSpeed));
+    return std::make_tuple(encodeSpeed, decodeSpeed);
+}
+
+std::tuple<double, double> Crypt::benchmarkRsa(int iterations)
+{
+    const int size = rsaGetSize();
+    if(size <= 0) {
+        g_logger.error("Crypt::benchmarkRsa needs a public key, set it with rsaSetPublicKey");
+        return std::make_tuple(0.0, 0.0);
+    }
+
+    iterations = std::max<int>(1, iterations);
+    std::vector<unsigned char> msg(size);
+    std::mt19937 gen(size);
+    std::generate(msg.begin(), msg.end(), [&]() { return static_cast<unsigned char>(gen()); });
+    msg[0] = 0; // below the modulus
+
+    std::vector<unsigned char> buffer;
+    stdext::timer timer;
+    for(int i = 0; i < iterations; ++i) {
+        buffer = msg;
+#ifdef USE_GMP
+        mpz_t c, m;
+        mpz_init(c);
+        mpz_init(m);
+        mpz_import(m, size, 1, 1, 0, 0, buffer.data());
+        mpz_powm(c, m, m_e, m_n);
+        mpz_clear(c);
+        mpz_clear(m);
+#else
+        RSA_public_encrypt(size, buffer.data(), buffer.data(), m_rsa, RSA_NO_PADDING);
+#endif
+    }
+    const double libraryElapsed = timer.elapsed_micros();
+
+    timer.restart();
+    for(int i = 0; i < iterations; ++i) {
+        buffer = msg;
+        rsaEncrypt(buffer.data(), size);
+    }
+    const double cachedElapsed = timer.elapsed_micros();
+
+    g_logger.info(stdext::format("RSA %d bit public encrypt: %.1f us per call, %.1f us with the precomputed context",
+                                 size * 8, libraryElapsed / iterations, cachedElapsed / iterations));
+    return std::make_tuple(libraryElapsed, cachedElapsed);
+}
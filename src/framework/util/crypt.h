@@ -25,14 +25,36 @@
 
 #include "../stdext/types.h"
 #include <string>
+#include <tuple>
 
 #include <boost/uuid/uuid.hpp>
 #ifdef USE_GMP
 #include <gmp.h>
 #else
 using RSA = struct rsa_st;
+using BN_CTX = struct bignum_ctx;
+using BN_MONT_CTX = struct bn_mont_ctx_st;
 #endif
 
+// incremental sha-256, for contents too large to hash in one piece
+class Sha256
+{
+public:
+    Sha256();
+
+    void update(const uint8* data, size_t size);
+    // lowercase hex digest, the state is reset afterwards
+    std::string finish();
+
+private:
+    void transform(const uint8* block);
+
+    uint32 m_state[8];
+    uint8 m_block[64];
+    size_t m_blockSize;
+    uint64 m_totalSize;
+};
+
 class Crypt
 {
 public:
@@ -42,6 +64,7 @@ public:
     std::string base64Encode(const std::string& decoded_string);
     std::string base64Decode(const std::string& encoded_string);
     std::string xorCrypt(const std::string& buffer, const std::string& key);
+    std::string sha256(const std::string& data);
     std::string encrypt(const std::string& decrypted_string) { return _encrypt(decrypted_string, true); }
     std::string decrypt(const std::string& encrypted_string) { return _decrypt(encrypted_string, true); }
     std::string genUUID();
@@ -54,6 +77,11 @@ public:
     bool rsaDecrypt(unsigned char* msg, int size);
     int rsaGetSize();
 
+    // MB/s encoding and decoding a random blob of size bytes
+    std::tuple<double, double> benchmarkBase64(int size);
+    // microseconds of iterations public key encryptions through the library call and through the precomputed context
+    std::tuple<double, double> benchmarkRsa(int iterations);
+
 private:
     std::string _encrypt(const std::string& decrypted_string, bool useMachineUUID);
     std::string _decrypt(const std::string& encrypted_string, bool useMachineUUID);
@@ -63,6 +91,8 @@ private:
     mpz_t m_p, m_q, m_n, m_e, m_d;
 #else
     RSA* m_rsa;
+    BN_CTX* m_bnCtx;
+    BN_MONT_CTX* m_montN; // Montgomery context of the public modulus, set up once per key
 #endif
 };
 
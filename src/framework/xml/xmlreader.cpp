@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xmlreader.h"
+
+#include <cstring>
+
+XmlReader::XmlReader(std::string buffer, const std::string& source) :
+    m_buffer(std::move(buffer)), m_source(source)
+{
+    m_pos = m_buffer.data();
+    m_end = m_pos + m_buffer.size();
+    m_token = End;
+    m_depth = 0;
+    m_emptyElement = false;
+    m_popDepth = false;
+
+    // utf-8 byte order mark
+    if(m_buffer.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        m_pos += 3;
+}
+
+XmlReader::Token XmlReader::next()
+{
+    if(m_popDepth) {
+        m_popDepth = false;
+        m_openElements.pop_back();
+        --m_depth;
+    }
+
+    if(m_emptyElement) {
+        m_emptyElement = false;
+        m_token = EndElement;
+        m_attributes.clear();
+        m_popDepth = true;
+        return m_token;
+    }
+
+    while(true) {
+        const char *tag = static_cast<const char*>(memchr(m_pos, '<', m_end - m_pos));
+        if(!tag) {
+            if(!m_openElements.empty())
+                throwError(stdext::format("unexpected end of document inside <%s>", std::string(m_openElements.back())));
+            m_pos = m_end;
+            m_token = End;
+            return m_token;
+        }
+
+        m_pos = tag + 1;
+        if(m_pos == m_end)
+            throwError("unexpected end of document");
+
+        if(*m_pos == '/') {
+            ++m_pos;
+            parseEndTag();
+            return m_token;
+        }
+        if(*m_pos == '?' || *m_pos == '!') {
+            skipMarkup();
+            continue;
+        }
+
+        parseStartTag();
+        return m_token;
+    }
+}
+
+bool XmlReader::nextChild(int depth)
+{
+    while(true) {
+        const Token token = next();
+        if(token == End)
+            throwError("unexpected end of document");
+        if(token == StartElement && m_depth == depth + 1)
+            return true;
+        if(token == EndElement && m_depth == depth)
+            return false;
+    }
+}
+
+void XmlReader::readRoot(const std::string_view& name)
+{
+    if(next() != StartElement)
+        throwError("missing root element");
+    if(m_name != name)
+        throwError(stdext::format("invalid root tag name '%s'", std::string(m_name)));
+}
+
+void XmlReader::skipElement()
+{
+    if(m_token != StartElement)
+        return;
+
+    const int depth = m_depth;
+    while(next() != EndElement || m_depth != depth) {
+        if(m_token == End)
+            throwError("unexpected end of document");
+    }
+}
+
+std::string XmlReader::getAttribute(const std::string_view& name) const
+{
+    const Attribute *attribute = findAttribute(name);
+    if(!attribute)
+        return std::string();
+
+    std::string ret;
+    if(attribute->value.find('&') == std::string_view::npos)
+        ret.assign(attribute->value.data(), attribute->value.size());
+    else
+        decodeEntities(attribute->value, ret);
+    return ret;
+}
+
+void XmlReader::throwError(const std::string& message) const
+{
+    const int line = 1 + std::count(m_buffer.data(), m_pos, '\n');
+    if(m_source.empty())
+        stdext::throw_exception(stdext::format("%s (line %d)", message, line));
+    stdext::throw_exception(stdext::format("%s (%s, line %d)", message, m_source, line));
+}
+
+const XmlReader::Attribute *XmlReader::findAttribute(const std::string_view& name) const
+{
+    for(const Attribute& attribute : m_attributes) {
+        if(attribute.name == name)
+            return &attribute;
+    }
+    return nullptr;
+}
+
+void XmlReader::parseStartTag()
+{
+    m_name = readName();
+    if(m_name.empty())
+        throwError("invalid tag name");
+
+    m_attributes.clear();
+    while(true) {
+        skipSpaces();
+        if(m_pos == m_end)
+            throwError(stdext::format("unterminated tag <%s>", std::string(m_name)));
+
+        if(*m_pos == '>') {
+            ++m_pos;
+            break;
+        }
+        if(*m_pos == '/') {
+            if(m_pos + 1 == m_end || m_pos[1] != '>')
+                throwError(stdext::format("malformed tag <%s>", std::string(m_name)));
+            m_pos += 2;
+            m_emptyElement = true;
+            break;
+        }
+
+        Attribute attribute;
+        attribute.name = readName();
+        if(attribute.name.empty())
+            throwError(stdext::format("malformed attribute in <%s>", std::string(m_name)));
+
+        skipSpaces();
+        if(m_pos == m_end || *m_pos != '=')
+            throwError(stdext::format("attribute '%s' of <%s> has no value", std::string(attribute.name), std::string(m_name)));
+        ++m_pos;
+        skipSpaces();
+        if(m_pos == m_end)
+            throwError(stdext::format("unterminated tag <%s>", std::string(m_name)));
+
+        // unquoted values are accepted like tinyxml does
+        const char *valueEnd;
+        if(*m_pos == '"' || *m_pos == '\'') {
+            const char quote = *m_pos++;
+            valueEnd = static_cast<const char*>(memchr(m_pos, quote, m_end - m_pos));
+            if(!valueEnd)
+                throwError(stdext::format("unterminated value of attribute '%s'", std::string(attribute.name)));
+            attribute.value = std::string_view(m_pos, valueEnd - m_pos);
+            m_pos = valueEnd + 1;
+        } else {
+            valueEnd = m_pos;
+            while(valueEnd < m_end && !isSpace(*valueEnd) && *valueEnd != '>' && *valueEnd != '/')
+                ++valueEnd;
+            attribute.value = std::string_view(m_pos, valueEnd - m_pos);
+            m_pos = valueEnd;
+        }
+        m_attributes.push_back(attribute);
+    }
+
+    m_openElements.push_back(m_name);
+    ++m_depth;
+    m_token = StartElement;
+}
+
+void XmlReader::parseEndTag()
+{
+    m_name = readName();
+    skipSpaces();
+    if(m_pos == m_end || *m_pos != '>')
+        throwError(stdext::format("malformed end tag </%s>", std::string(m_name)));
+    ++m_pos;
+
+    if(m_openElements.empty() || m_openElements.back() != m_name)
+        throwError(stdext::format("unexpected end tag </%s>", std::string(m_name)));
+
+    m_attributes.clear();
+    m_popDepth = true;
+    m_token = EndElement;
+}
+
+void XmlReader::skipMarkup()
+{
+    // m_pos is at the '?' or '!' following '<'
+    if(*m_pos == '?')
+        skipPast("?>");
+    else if(m_end - m_pos >= 3 && memcmp(m_pos, "!--", 3) == 0)
+        skipPast("-->");
+    else if(m_end - m_pos >= 8 && memcmp(m_pos, "![CDATA[", 8) == 0)
+        skipPast("]]>");
+    else {
+        // <!DOCTYPE ...> and the like, an internal subset is enclosed in brackets
+        int brackets = 0;
+        for(; m_pos < m_end; ++m_pos) {
+            if(*m_pos == '[')
+                ++brackets;
+            else if(*m_pos == ']')
+                --brackets;
+            else if(*m_pos == '>' && brackets <= 0)
+                break;
+        }
+        if(m_pos == m_end)
+            throwError("unterminated declaration");
+        ++m_pos;
+    }
+}
+
+void XmlReader::skipPast(const char *terminator)
+{
+    const std::string_view rest(m_pos, m_end - m_pos);
+    const size_t pos = rest.find(terminator);
+    if(pos == std::string_view::npos)
+        throwError(stdext::format("missing '%s'", terminator));
+    m_pos += pos + strlen(terminator);
+}
+
+std::string_view XmlReader::readName()
+{
+    const char *begin = m_pos;
+    while(m_pos < m_end && !isSpace(*m_pos) && *m_pos != '>' && *m_pos != '/' && *m_pos != '=')
+        ++m_pos;
+    return std::string_view(begin, m_pos - begin);
+}
+
+void XmlReader::decodeEntities(const std::string_view& raw, std::string& out)
+{
+    static const struct { const char *name; char value; } entities[] = {
+        { "amp;", '&' }, { "lt;", '<' }, { "gt;", '>' }, { "quot;", '"' }, { "apos;", '\'' }
+    };
+
+    out.reserve(raw.size());
+    for(size_t i = 0; i < raw.size(); ++i) {
+        if(raw[i] != '&') {
+            out += raw[i];
+            continue;
+        }
+
+        const std::string_view rest = raw.substr(i + 1);
+        const size_t semicolon = rest.find(';');
+        bool decoded = false;
+        if(semicolon != std::string_view::npos && !rest.empty() && rest[0] == '#') {
+            const bool hex = rest.size() > 1 && (rest[1] == 'x' || rest[1] == 'X');
+            const char *begin = rest.data() + (hex ? 2 : 1);
+            const char *end = rest.data() + semicolon;
+            uint32 code = 0;
+            auto result = std::from_chars(begin, end, code, hex ? 16 : 10);
+            if(begin != end && result.ec == std::errc() && result.ptr == end && code > 0) {
+                // the client strings are latin1, wider characters are kept as utf-8
+                if(code < 0x100)
+                    out += static_cast<char>(code);
+                else if(code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else if(code < 0x10000) {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | ((code >> 18) & 0x07));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                i += semicolon + 1;
+                decoded = true;
+            }
+        } else {
+            for(const auto& entity : entities) {
+                if(rest.compare(0, strlen(entity.name), entity.name) == 0) {
+                    out += entity.value;
+                    i += strlen(entity.name);
+                    decoded = true;
+                    break;
+                }
+            }
+        }
+
+        // unknown references are kept verbatim
+        if(!decoded)
+            out += '&';
+    }
+}
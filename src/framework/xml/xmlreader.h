@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef XMLREADER_H
+#define XMLREADER_H
+
+#include <framework/global.h>
+
+#include <charconv>
+#include <string_view>
+
+// pull parser over a whole document kept in memory, names and attribute values are views into the buffer
+// and no tree is built; comments, text, declarations and CDATA sections are skipped
+class XmlReader
+{
+public:
+    enum Token {
+        StartElement,
+        EndElement,
+        End
+    };
+
+    XmlReader(std::string buffer, const std::string& source = std::string());
+
+    // moves to the next start or end tag, an empty element <a/> gives both tokens
+    Token next();
+    // moves to the next child of the element opened at depth, skipping whatever is left of the previous one;
+    // returns false once that element is closed
+    bool nextChild(int depth);
+    // moves to the root element, throws when it is missing or has another name
+    void readRoot(const std::string_view& name);
+    // skips the remaining content of the current start element, leaving the reader on its end tag
+    void skipElement();
+
+    Token getToken() const { return m_token; }
+    // nesting level of the current element, the root has depth 1
+    int getDepth() const { return m_depth; }
+    const std::string_view& getName() const { return m_name; }
+    bool isName(const std::string_view& name) const { return m_name == name; }
+
+    bool hasAttribute(const std::string_view& name) const { return findAttribute(name) != nullptr; }
+    // entity references are decoded on demand, a missing attribute reads as empty
+    std::string getAttribute(const std::string_view& name) const;
+    // same results as TiXmlElement::readType, a missing or malformed value reads as T()
+    template<typename T = std::string>
+    T readAttribute(const std::string_view& name) const;
+
+    void throwError(const std::string& message) const;
+
+private:
+    struct Attribute {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    const Attribute *findAttribute(const std::string_view& name) const;
+    void parseStartTag();
+    void parseEndTag();
+    void skipMarkup();
+    void skipPast(const char *terminator);
+    void skipSpaces() { while(m_pos < m_end && isSpace(*m_pos)) ++m_pos; }
+    std::string_view readName();
+
+    static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+    static void decodeEntities(const std::string_view& raw, std::string& out);
+
+    std::string m_buffer;
+    std::string m_source;
+    const char *m_pos;
+    const char *m_end;
+    Token m_token;
+    int m_depth;
+    bool m_emptyElement;
+    bool m_popDepth;
+    std::string_view m_name;
+    std::vector<Attribute> m_attributes;
+    std::vector<std::string_view> m_openElements;
+};
+
+template<typename T>
+T XmlReader::readAttribute(const std::string_view& name) const
+{
+    if constexpr(std::is_same<T, std::string>::value)
+        return getAttribute(name);
+    else {
+        const Attribute *attribute = findAttribute(name);
+        if(!attribute)
+            return T();
+
+        std::string_view value = attribute->value;
+        while(!value.empty() && isSpace(value.front()))
+            value.remove_prefix(1);
+        if constexpr(std::is_same<T, bool>::value)
+            return value == "true" || (!value.empty() && value.front() >= '1' && value.front() <= '9');
+        else if constexpr(std::is_integral<T>::value) {
+            if(!value.empty() && value.front() == '+')
+                value.remove_prefix(1);
+            T ret;
+            if(std::from_chars(value.data(), value.data() + value.size(), ret).ec != std::errc())
+                return T();
+            return ret;
+        } else {
+            std::istringstream in(value.find('&') != std::string_view::npos ? getAttribute(name) : std::string(value));
+            T ret;
+            if(!(in >> ret))
+                return T();
+            return ret;
+        }
+    }
+}
+
+#endif
@@ -35,17 +35,20 @@ int main(int argc, const char* argv[])
 
     // initialize application framework and otclient
     g_app.init(args);
+    g_app.beginStartupPhase("client");
     g_client.init(args);
 
-    // find script init.lua and run it
+    // find script init.lua and run it, it opens its own startup phases
+    g_app.beginStartupPhase("init script");
     if(!g_resources.discoverWorkDir("init.lua"))
         g_logger.fatal("Unable to find work directory, the application cannot be initialized.");
 
     if(!g_lua.safeRunScript("init.lua"))
         g_logger.fatal("Unable to run script init.lua!");
 
-    // the run application main loop
-    g_app.run();
+    // the run application main loop, init.lua may already have asked to quit
+    if(!g_app.isStopping())
+        g_app.run();
 
     // unload modules
     g_app.deinit();
@@ -0,0 +1,58 @@
+#!/bin/bash
+# converts the png images of a data tree into gpu compressed textures next to them,
+# the client loads a .dds (desktop) or .ktx (mobile) instead of the png when the gpu
+# supports its format and falls back to the png otherwise
+# needs compressonatorcli from https://github.com/GPUOpen-Tools/compressonator in the PATH
+
+format="bc7"
+clean=false
+dir="../data/images"
+for arg in "$@"; do
+    case "$arg" in
+        --bc7|--bc3|--etc2|--astc)
+            format="${arg#--}"
+            ;;
+        --clean)
+            clean=true
+            ;;
+        -*)
+            echo "usage: $0 [--bc7|--bc3|--etc2|--astc] [--clean] [directory]"
+            exit
+            ;;
+        *)
+            dir="$arg"
+            ;;
+    esac
+done
+
+case "$format" in
+    bc7) codec="BC7"; extension="dds"; options="" ;;
+    bc3) codec="BC3"; extension="dds"; options="" ;;
+    etc2) codec="ETC2_RGBA"; extension="ktx"; options="" ;;
+    astc) codec="ASTC"; extension="ktx"; options="-BlockRate 8" ;;
+esac
+
+if $clean; then
+    find "$dir" -name "*.dds" -delete
+    find "$dir" -name "*.ktx" -delete
+    exit
+fi
+
+if ! command -v compressonatorcli > /dev/null; then
+    echo "compressonatorcli not found"
+    exit 1
+fi
+
+find "$dir" -name "*.png" | while read -r png; do
+    # animated pngs keep their frames only in the png
+    if grep -q "acTL" "$png"; then
+        continue
+    fi
+
+    output="${png%.png}.$extension"
+    if [ "$output" -nt "$png" ]; then
+        continue
+    fi
+
+    compressonatorcli -fd $codec $options -nomipmap "$png" "$output" > /dev/null || echo "failed to convert $png"
+done